@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# This script creates the manifest of a firmware update file (.bin), checked by lt_fw_preflight().
+
+# The manifest layout is described in include/libtropic_fw_preflight.h. Its first 48 bytes are signed by Ed25519,
+# either by openssl with a private key in PEM, or elsewhere (e.g. by an HSM) and the signature is then attached.
+
+
+import argparse
+import hashlib
+import struct
+import subprocess
+import sys
+import tempfile
+
+MAGIC = b"LTFM"
+VERSION = 1
+
+ABAB_CHUNK_SIZE = 128
+ACAB_REQ_LEN = 0x68
+ACAB_HASH_OFFSET = 1 + 64
+
+
+def chunks_abab(data):
+    return [data[i:i + ABAB_CHUNK_SIZE] for i in range(0, len(data), ABAB_CHUNK_SIZE)]
+
+
+def chunks_acab(data):
+    if not data or data[0] != ACAB_REQ_LEN:
+        raise ValueError("update request has wrong length")
+    hashes = [data[ACAB_HASH_OFFSET:ACAB_HASH_OFFSET + 32]]
+    pieces = [data[1:1 + ACAB_REQ_LEN]]
+    offset = 1 + ACAB_REQ_LEN
+    while offset < len(data):
+        end = offset + 1 + data[offset]
+        if end > len(data):
+            raise ValueError(f"chunk at {offset} runs behind the end of the file")
+        pieces.append(data[offset + 1:end])
+        hashes.append(data[offset + 1:offset + 33])
+        offset = end
+    # Hash of each chunk is carried by the previous one, the last chunk carries zeros
+    for prev, piece in zip(hashes, pieces[1:]):
+        if hashlib.sha256(piece).digest() != prev:
+            raise ValueError("hash chain of chunks is broken")
+    if len(pieces) < 2 or hashes[-1] != bytes(32):
+        raise ValueError("last chunk is missing")
+    return pieces
+
+
+def manifest_msg(data, rev):
+    pieces = chunks_abab(data) if rev == "ABAB" else chunks_acab(data)
+    digest = hashlib.sha256(b"".join(hashlib.sha256(p).digest() for p in pieces)).digest()
+    chunks = len(pieces) if rev == "ABAB" else len(pieces) - 1
+    return MAGIC + struct.pack("<B3xII", VERSION, len(data), chunks) + digest
+
+
+def sign(msg, key):
+    # Ed25519 signs the message in one shot, openssl needs it in a file for that
+    with tempfile.NamedTemporaryFile() as f:
+        f.write(msg)
+        f.flush()
+        res = subprocess.run(["openssl", "pkeyutl", "-sign", "-rawin", "-inkey", key, "-in", f.name],
+                             capture_output=True)
+    if res.returncode:
+        raise ValueError(res.stderr.decode().strip())
+    return res.stdout
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Create manifest of TROPIC01 firmware update file.")
+    parser.add_argument("input", help="signed firmware update file (.bin)")
+    parser.add_argument("output", help="manifest file to create")
+    parser.add_argument("--silicon-rev", choices=["ABAB", "ACAB"], default="ACAB",
+                        help="silicon revision the update file is for (default ACAB)")
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument("--key", help="Ed25519 private key in PEM signing the manifest")
+    group.add_argument("--signature", help="file with 64 B Ed25519 signature of the message to attach")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    try:
+        msg = manifest_msg(data, args.silicon_rev)
+        if args.key:
+            sig = sign(msg, args.key)
+        elif args.signature:
+            with open(args.signature, "rb") as f:
+                sig = f.read()
+        else:
+            sig = b""
+        if sig and len(sig) != 64:
+            raise ValueError("signature must have 64 B")
+    except ValueError as e:
+        print(f"{args.input}: {e}")
+        sys.exit(1)
+
+    with open(args.output, "wb") as f:
+        f.write(msg + sig)
+
+    what = "manifest" if sig else "unsigned manifest message"
+    print(f"{args.input}: {what} -> {args.output}: {len(msg + sig)} B")
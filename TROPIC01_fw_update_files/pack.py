@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# This script packs a firmware update file (.bin) into a binary container read by lt_fw_image_open().
+
+# The container layout is described in docs/other/fw_image_format.md,
+# the payload is optionally compressed as LZ4 block with limited match distance.
+
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"LTFW"
+VERSION = 1
+CODEC_RAW = 0
+CODEC_LZ4 = 1
+WINDOW_LOG_MAX = 16
+
+MINMATCH = 4
+# LZ4 block rules: last 5 bytes are literals, last match starts at least 12 bytes before the end
+LASTLITERALS = 5
+MFLIMIT = 12
+
+
+def lz4_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def lz4_sequence(out, literals, dist, match_len):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if dist:
+        token |= min(match_len - MINMATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        lz4_length(out, lit_len - 15)
+    out += literals
+    if dist:
+        out += struct.pack("<H", dist)
+        if match_len - MINMATCH >= 15:
+            lz4_length(out, match_len - MINMATCH - 15)
+
+
+def lz4_compress(data, window):
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    n = len(data)
+    while i < n - MFLIMIT:
+        key = data[i:i + MINMATCH]
+        cand = table.get(key)
+        table[key] = i
+        if cand is not None and i - cand <= window:
+            match_len = MINMATCH
+            while i + match_len < n - LASTLITERALS and data[cand + match_len] == data[i + match_len]:
+                match_len += 1
+            lz4_sequence(out, data[anchor:i], i - cand, match_len)
+            i += match_len
+            anchor = i
+            continue
+        i += 1
+    lz4_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def pack(data, compress, window_log):
+    if compress:
+        payload = lz4_compress(data, 1 << window_log)
+        codec = CODEC_LZ4
+    else:
+        payload = data
+        codec = CODEC_RAW
+        window_log = 0
+    header = MAGIC + struct.pack("<BBBBII", VERSION, codec, window_log, 0, len(data), len(payload))
+    return header + hashlib.sha256(data).digest() + payload
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Pack TROPIC01 firmware update file into libtropic container.")
+    parser.add_argument("input", help="signed firmware update file (.bin)")
+    parser.add_argument("output", help="container file to create")
+    parser.add_argument("--raw", action="store_true", help="store the payload uncompressed")
+    parser.add_argument("--window-log", type=int, default=10,
+                        help="log2 of the decompression window needed by the reader (default 10, i.e. 1 KiB)")
+    args = parser.parse_args()
+
+    if not 4 <= args.window_log <= WINDOW_LOG_MAX:
+        print(f"Window log must be between 4 and {WINDOW_LOG_MAX}.")
+        sys.exit(1)
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    container = pack(data, not args.raw, args.window_log)
+    with open(args.output, "wb") as f:
+        f.write(container)
+
+    print(f"{args.input}: {len(data)} B -> {args.output}: {len(container)} B")
@@ -126,7 +126,7 @@ int lt_ex_hello_world_separate_API(lt_handle_t *h)
         return -1;
     }
     LT_LOG_INFO("Executing lt_l2_recv_encrypted_res()...");
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l2_recv_encrypted_res(&h->l2, LT_L3_RES_BUFF(&h->l3), LT_L3_RES_BUFF_LEN(&h->l3));
     if (LT_OK != ret) {
         LT_LOG_ERROR("lt_l2_recv_encrypted_res failed, ret=%s", lt_ret_verbose(ret));
         lt_session_abort(h);
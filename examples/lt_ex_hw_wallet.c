@@ -320,18 +320,12 @@ static int session_initial(lt_handle_t *h)
     }
 
     LT_LOG_INFO("Creating an example config from the read R config...");
+    struct lt_config_t current = r_config;
     create_example_r_config(&r_config);
 
-    LT_LOG_INFO("Erasing R config in case it is already written...");
-    ret = lt_r_config_erase(h);
-    if (LT_OK != ret) {
-        LT_LOG_ERROR("Failed to erase R config, ret=%s", lt_ret_verbose(ret));
-        return -1;
-    }
-    LT_LOG_INFO("\tOK");
-
-    LT_LOG_INFO("Writing the whole R config with the example config...");
-    ret = lt_write_whole_R_config(h, &r_config);
+    // R config is erased only when an already written object has to change
+    LT_LOG_INFO("Writing the changed objects of R config with the example config...");
+    ret = lt_write_R_config_diff(h, &current, &r_config);
     if (LT_OK != ret) {
         LT_LOG_ERROR("Failed to write R config, ret=%s", lt_ret_verbose(ret));
         return -1;
@@ -348,23 +342,39 @@ static int session_initial(lt_handle_t *h)
         LT_LOG_INFO("%s: 0x%08" PRIx32, cfg_desc_table[i].desc, r_config.obj[i]);
     }
 
-    // Write pairing keys into slots 1,2,3
+    // Write pairing keys into slots 1,2,3, read them back and invalidate slot 0 of this session, in one batch
+    lt_pairing_key_op_t ops[7];
+    uint8_t ops_cnt = 0;
     for (uint8_t i = PAIRING_KEY_SLOT_INDEX_1; i <= PAIRING_KEY_SLOT_INDEX_3; i++) {
-        LT_LOG_INFO("Writing to pairing key slot %" PRIu8 "...", i);
-        ret = lt_pairing_key_write(h, pub_keys[i], i);
-        if (LT_OK != ret) {
-            LT_LOG_ERROR("Failed to write pairing key, ret=%s", lt_ret_verbose(ret));
-            return -1;
-        }
-        LT_LOG_INFO("\tOK");
+        ops[ops_cnt].op = LT_PAIRING_KEY_OP_WRITE;
+        ops[ops_cnt].slot = (pkey_index_t)i;
+        memcpy(ops[ops_cnt++].key, pub_keys[i], sizeof(ops[0].key));
     }
+    for (uint8_t i = PAIRING_KEY_SLOT_INDEX_1; i <= PAIRING_KEY_SLOT_INDEX_3; i++) {
+        ops[ops_cnt].op = LT_PAIRING_KEY_OP_READ;
+        ops[ops_cnt++].slot = (pkey_index_t)i;
+    }
+    ops[ops_cnt].op = LT_PAIRING_KEY_OP_INVALIDATE;
+    ops[ops_cnt++].slot = PAIRING_KEY_SLOT_INDEX_0;
 
-    LT_LOG_INFO("Invalidating pairing key slot %d...", (int)PAIRING_KEY_SLOT_INDEX_0);
-    ret = lt_pairing_key_invalidate(h, PAIRING_KEY_SLOT_INDEX_0);
+    LT_LOG_INFO("Writing pairing keys 1-3, reading them back and invalidating pairing key slot %d...",
+                (int)PAIRING_KEY_SLOT_INDEX_0);
+    ret = lt_pairing_key_batch(h, ops, ops_cnt);
     if (LT_OK != ret) {
-        LT_LOG_ERROR("Failed to invalidate pairing key slot, ret=%s", lt_ret_verbose(ret));
+        LT_LOG_ERROR("Failed to execute pairing key commands, ret=%s", lt_ret_verbose(ret));
         return -1;
     }
+    for (uint8_t i = 0; i < ops_cnt; i++) {
+        if (LT_OK != ops[i].status) {
+            LT_LOG_ERROR("Pairing key command %" PRIu8 " on slot %d failed, ret=%s", i, (int)ops[i].slot,
+                         lt_ret_verbose(ops[i].status));
+            return -1;
+        }
+        if ((LT_PAIRING_KEY_OP_READ == ops[i].op) && memcmp(ops[i].key, pub_keys[ops[i].slot], sizeof(ops[i].key))) {
+            LT_LOG_ERROR("Pairing key in slot %d differs from the written one", (int)ops[i].slot);
+            return -1;
+        }
+    }
     LT_LOG_INFO("\tOK");
 
     LT_LOG_INFO("Aborting Secure Session");
@@ -1,6 +1,8 @@
 /**
  * @file lt_ex_macandd.c
  * @brief Example usage of TROPIC01 flagship feature - 'Mac And Destroy' PIN verification engine.
+ * @details The same scheme is provided as a library module by libtropic_macandd.h (CMake option LT_MACANDD), with
+ * pipelined commands and configurable number of attempts.
  * @author Tropic Square s.r.o.
  *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
@@ -97,6 +99,8 @@ static lt_ret_t lt_PIN_set(lt_handle_t *h, const uint8_t *PIN, const uint8_t PIN
     uint8_t s[32] = {0};
     // Variable used to initialize slot(s)
     uint8_t u[32] = {0};
+    // HMAC context keyed by s, all KDF(s, ...) below reuse its precomputed key pads
+    struct lt_hmac_sha256_ctx_t s_ctx = {0};
 
     // This organizes data which will be stored into nvm
     struct lt_macandd_nvm_t nvm = {0};
@@ -114,6 +118,7 @@ static lt_ret_t lt_PIN_set(lt_handle_t *h, const uint8_t *PIN, const uint8_t PIN
         goto exit;
     }
     LT_LOG_INFO("\tOK");
+    lt_hmac_sha256_init(&s_ctx, s, sizeof(s));
 
     // Erase a slot in R memory, which will be used as a storage for NVM data
     LT_LOG_INFO("Erasing R_Mem User slot %d...", R_MEM_DATA_SLOT_MACANDD);
@@ -128,11 +133,11 @@ static lt_ret_t lt_PIN_set(lt_handle_t *h, const uint8_t *PIN, const uint8_t PIN
     nvm.i = MACANDD_ROUNDS;
     // Compute tag t = KDF(s, "0"), save into nvm struct
     // Tag will be later used during lt_PIN_check() to verify validity of secret
-    lt_hmac_sha256(s, 32, (uint8_t *)"0", 1, nvm.t);
+    lt_hmac_sha256_compute(&s_ctx, (uint8_t *)"0", 1, nvm.t);
 
     // Compute u = KDF(s, "1")
     // This value will be sent through M&D sequence to initialize a slot
-    lt_hmac_sha256(s, 32, (uint8_t *)"1", 1, u);
+    lt_hmac_sha256_compute(&s_ctx, (uint8_t *)"1", 1, u);
 
     // Compute v = KDF(0, PIN||A) where 0 is all zeroes key
     lt_hmac_sha256((uint8_t*)"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", 32, kdf_input_buff, PIN_size+add_size, v);
@@ -191,7 +196,7 @@ static lt_ret_t lt_PIN_set(lt_handle_t *h, const uint8_t *PIN, const uint8_t PIN
     }
 
     // Final secret is released to the caller
-    lt_hmac_sha256(s, 32, (uint8_t *)"2", 1, secret);
+    lt_hmac_sha256_compute(&s_ctx, (uint8_t *)"2", 1, secret);
 
 // Cleanup all sensitive data from memory
 exit:
@@ -200,6 +205,7 @@ exit:
     memset(v, 0, 32);
     memset(w, 0, 32);
     memset(k_i, 0, 32);
+    memset(&s_ctx, 0, sizeof(s_ctx));
 
     return ret;
 }
@@ -250,6 +256,8 @@ static lt_ret_t lt_PIN_check(lt_handle_t *h, const uint8_t *PIN, const uint8_t P
     uint8_t t_[32] = {0};
     // Value used to initialize Mac And Destroy's slot after a correct PIN try
     uint8_t u[32] = {0};
+    // HMAC context keyed by s_, all KDF(s_, ...) below reuse its precomputed key pads
+    struct lt_hmac_sha256_ctx_t s_ctx = {0};
 
     // This organizes data which will be read from nvm
     struct lt_macandd_nvm_t nvm = {0};
@@ -322,7 +330,8 @@ static lt_ret_t lt_PIN_check(lt_handle_t *h, const uint8_t *PIN, const uint8_t P
     }
 
     // Compute tag t = KDF(s, "0x00")
-    lt_hmac_sha256(s_, 32, (uint8_t *)"0", 1, t_);
+    lt_hmac_sha256_init(&s_ctx, s_, sizeof(s_));
+    lt_hmac_sha256_compute(&s_ctx, (uint8_t *)"0", 1, t_);
 
     // If t’ != t: FAIL
     if (memcmp(nvm.t, t_, 32) != 0) {
@@ -332,7 +341,7 @@ static lt_ret_t lt_PIN_check(lt_handle_t *h, const uint8_t *PIN, const uint8_t P
 
     // Pin is correct, now initialize macandd slots again:
     // Compute u = KDF(s’, "0x01")
-    lt_hmac_sha256(s_, 32, (uint8_t *)"1", 1, u);
+    lt_hmac_sha256_compute(&s_ctx, (uint8_t *)"1", 1, u);
 
     for (int x = nvm.i; x < MACANDD_ROUNDS - 1; x++) {
         uint8_t garbage[32] = {0};
@@ -365,7 +374,7 @@ static lt_ret_t lt_PIN_check(lt_handle_t *h, const uint8_t *PIN, const uint8_t P
     LT_LOG_INFO("\tOK");
 
     // Calculate secret and store it into passed array
-    lt_hmac_sha256(s_, 32, (uint8_t *)"2", 1, secret);
+    lt_hmac_sha256_compute(&s_ctx, (uint8_t *)"2", 1, secret);
 
 // Cleanup all sensitive data from memory
 exit:
@@ -373,6 +382,7 @@ exit:
     memset(w_, 0, 32);
     memset(k_i, 0, 32);
     memset(v_, 0, 32);
+    memset(&s_ctx, 0, sizeof(s_ctx));
 
     return ret;
 }
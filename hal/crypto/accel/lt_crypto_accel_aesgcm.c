@@ -0,0 +1,628 @@
+/**
+ * @file lt_crypto_accel_aesgcm.c
+ * @brief AES-GCM using AES-NI and PCLMULQDQ on x86 or AESE and PMULL of ARMv8 Crypto Extensions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if defined(LT_AESGCM_ACCEL) || LT_CRYPTO_DISPATCH
+#include <stdint.h>
+#include <string.h>
+
+// Suffix of the functions linked together with other implementations, see lt_crypto_dispatch.h
+#define LT_CRYPTO_IMPL accel
+
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "lt_aesgcm.h"
+#include "lt_aesgcm_multi.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#if !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_AES)
+#error "Accelerated AES-GCM needs Crypto Extensions enabled, e.g. -march=armv8-a+crypto"
+#endif
+#else
+#error "Accelerated AES-GCM is supported only on x86 and AArch64"
+#endif
+
+/** AES block size */
+#define LT_AES_BLOCK_SIZE 16
+/** Maximal number of AES rounds (AES-256) */
+#define LT_AES_ROUNDS_MAX 14
+
+/** Context stored in the space of `lt_l3_state_t.encrypt`/`decrypt` */
+typedef struct lt_aesgcm_accel_ctx_t {
+    /** Round keys, FIPS-197 byte order */
+    uint8_t rk[(LT_AES_ROUNDS_MAX + 1) * LT_AES_BLOCK_SIZE];
+    /** Hash subkey H, byte-reversed */
+    uint8_t h[LT_AES_BLOCK_SIZE];
+    /** E(K, J0), masks the tag */
+    uint8_t ej0[LT_AES_BLOCK_SIZE];
+    /** Counter block for the next keystream block */
+    uint8_t ctr[LT_AES_BLOCK_SIZE];
+    /** GHASH accumulator, bytes of an incomplete ciphertext block are already XORed in */
+    uint8_t ghash[LT_AES_BLOCK_SIZE];
+    /** Keystream block, `ks_pos` bytes of it are already used */
+    uint8_t ks[LT_AES_BLOCK_SIZE];
+    uint32_t aad_len;
+    uint32_t msg_len;
+    uint8_t rounds;
+    uint8_t ks_pos;
+} lt_aesgcm_accel_ctx_t;
+
+// Has to fit into space reserved in lt_l3_state_t
+STATIC_ASSERT(sizeof(lt_aesgcm_accel_ctx_t) <= LT_AESGCM_CTX_SIZE)
+
+//--------------------------------------------------------------------------------------------------------------------//
+#if defined(__x86_64__) || defined(__i386__)
+
+/** Applies S-box to each of 4 bytes */
+static void lt_aes_sub_word(uint8_t *w)
+{
+    uint32_t v;
+    memcpy(&v, w, sizeof(v));
+    // AESKEYGENASSIST returns SubWord() of the second dword in the first one
+    v = (uint32_t)_mm_cvtsi128_si32(_mm_aeskeygenassist_si128(_mm_set_epi32(0, 0, (int)v, 0), 0));
+    memcpy(w, &v, sizeof(v));
+}
+
+static void lt_aes_encrypt_block(const lt_aesgcm_accel_ctx_t *c, const uint8_t *in, uint8_t *out)
+{
+    __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in), _mm_loadu_si128((const __m128i *)c->rk));
+    for (uint8_t r = 1; r < c->rounds; r++) {
+        s = _mm_aesenc_si128(s, _mm_loadu_si128((const __m128i *)(c->rk + r * LT_AES_BLOCK_SIZE)));
+    }
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128((const __m128i *)(c->rk + c->rounds * LT_AES_BLOCK_SIZE)));
+    _mm_storeu_si128((__m128i *)out, s);
+}
+
+#if LT_AESGCM_MULTI_LANES > 1
+/** Encrypts counter block of each context into its keystream block, rounds of all lanes are interleaved */
+static void lt_aes_encrypt_lanes(lt_aesgcm_accel_ctx_t *const *c, const size_t n)
+{
+    __m128i s[LT_AESGCM_MULTI_LANES];
+    const uint8_t rounds = c[0]->rounds;
+
+    for (size_t i = 0; i < n; i++) {
+        s[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)c[i]->ctr), _mm_loadu_si128((const __m128i *)c[i]->rk));
+    }
+    for (uint8_t r = 1; r < rounds; r++) {
+        for (size_t i = 0; i < n; i++) {
+            s[i] = _mm_aesenc_si128(s[i], _mm_loadu_si128((const __m128i *)(c[i]->rk + r * LT_AES_BLOCK_SIZE)));
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        s[i] = _mm_aesenclast_si128(s[i], _mm_loadu_si128((const __m128i *)(c[i]->rk + rounds * LT_AES_BLOCK_SIZE)));
+        _mm_storeu_si128((__m128i *)c[i]->ks, s[i]);
+    }
+}
+#endif
+
+static __m128i lt_bswap128(__m128i x)
+{
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/** Multiplication in GF(2^128) of byte-reversed operands, Intel's carry-less multiplication white paper */
+static __m128i lt_gfmul(__m128i a, __m128i b)
+{
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t4 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t5 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t6 = _mm_clmulepi64_si128(a, b, 0x11);
+
+    t4 = _mm_xor_si128(t4, t5);
+    t5 = _mm_slli_si128(t4, 8);
+    t4 = _mm_srli_si128(t4, 8);
+    t3 = _mm_xor_si128(t3, t5);
+    t6 = _mm_xor_si128(t6, t4);
+
+    // Shift the 256 bit product left by one, operands are bit-reflected
+    __m128i t7 = _mm_srli_epi32(t3, 31);
+    __m128i t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    __m128i t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+
+    // Reduce modulo x^128 + x^7 + x^2 + x + 1
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+    __m128i t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+
+    return _mm_xor_si128(t6, t3);
+}
+
+static void lt_bswap_block(const uint8_t *in, uint8_t *out)
+{
+    _mm_storeu_si128((__m128i *)out, lt_bswap128(_mm_loadu_si128((const __m128i *)in)));
+}
+
+/** x = x * H */
+static void lt_ghash_mul(uint8_t *x, const lt_aesgcm_accel_ctx_t *c)
+{
+    __m128i a = lt_bswap128(_mm_loadu_si128((const __m128i *)x));
+    __m128i r = lt_gfmul(a, _mm_loadu_si128((const __m128i *)c->h));
+    _mm_storeu_si128((__m128i *)x, lt_bswap128(r));
+}
+
+//--------------------------------------------------------------------------------------------------------------------//
+#elif defined(__aarch64__)
+
+static void lt_aes_sub_word(uint8_t *w)
+{
+    uint32_t v;
+    memcpy(&v, w, sizeof(v));
+    // All columns are equal, so ShiftRows done by AESE has no effect and only SubBytes remains
+    uint8x16_t s = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(v)), vdupq_n_u8(0));
+    v = vgetq_lane_u32(vreinterpretq_u32_u8(s), 0);
+    memcpy(w, &v, sizeof(v));
+}
+
+static void lt_aes_encrypt_block(const lt_aesgcm_accel_ctx_t *c, const uint8_t *in, uint8_t *out)
+{
+    uint8x16_t s = vld1q_u8(in);
+    for (uint8_t r = 0; r < c->rounds - 1; r++) {
+        s = vaesmcq_u8(vaeseq_u8(s, vld1q_u8(c->rk + r * LT_AES_BLOCK_SIZE)));
+    }
+    s = vaeseq_u8(s, vld1q_u8(c->rk + (c->rounds - 1) * LT_AES_BLOCK_SIZE));
+    s = veorq_u8(s, vld1q_u8(c->rk + c->rounds * LT_AES_BLOCK_SIZE));
+    vst1q_u8(out, s);
+}
+
+#if LT_AESGCM_MULTI_LANES > 1
+static void lt_aes_encrypt_lanes(lt_aesgcm_accel_ctx_t *const *c, const size_t n)
+{
+    uint8x16_t s[LT_AESGCM_MULTI_LANES];
+    const uint8_t rounds = c[0]->rounds;
+
+    for (size_t i = 0; i < n; i++) {
+        s[i] = vld1q_u8(c[i]->ctr);
+    }
+    for (uint8_t r = 0; r < rounds - 1; r++) {
+        for (size_t i = 0; i < n; i++) {
+            s[i] = vaesmcq_u8(vaeseq_u8(s[i], vld1q_u8(c[i]->rk + r * LT_AES_BLOCK_SIZE)));
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        s[i] = vaeseq_u8(s[i], vld1q_u8(c[i]->rk + (rounds - 1) * LT_AES_BLOCK_SIZE));
+        vst1q_u8(c[i]->ks, veorq_u8(s[i], vld1q_u8(c[i]->rk + rounds * LT_AES_BLOCK_SIZE)));
+    }
+}
+#endif
+
+static uint8x16_t lt_bswap128(uint8x16_t x)
+{
+    x = vrev64q_u8(x);
+    return vextq_u8(x, x, 8);
+}
+
+static uint8x16_t lt_clmul_lo(uint8x16_t a, uint8x16_t b)
+{
+    return vreinterpretq_u8_p128(vmull_p64((poly64_t)vgetq_lane_u64(vreinterpretq_u64_u8(a), 0),
+                                           (poly64_t)vgetq_lane_u64(vreinterpretq_u64_u8(b), 0)));
+}
+
+static uint8x16_t lt_clmul_hi(uint8x16_t a, uint8x16_t b)
+{
+    return vreinterpretq_u8_p128(vmull_high_p64(vreinterpretq_p64_u8(a), vreinterpretq_p64_u8(b)));
+}
+
+/** Same algorithm as the x86 variant, vextq_u8() with zero stands for byte shifts of a whole register */
+static uint8x16_t lt_gfmul(uint8x16_t a, uint8x16_t b)
+{
+    const uint8x16_t z = vdupq_n_u8(0);
+    uint8x16_t b_swapped = vextq_u8(b, b, 8);
+
+    uint8x16_t t3 = lt_clmul_lo(a, b);
+    uint8x16_t t4 = lt_clmul_lo(a, b_swapped);
+    uint8x16_t t5 = lt_clmul_hi(a, b_swapped);
+    uint8x16_t t6 = lt_clmul_hi(a, b);
+
+    t4 = veorq_u8(t4, t5);
+    t5 = vextq_u8(z, t4, 8);
+    t4 = vextq_u8(t4, z, 8);
+    t3 = veorq_u8(t3, t5);
+    t6 = veorq_u8(t6, t4);
+
+    uint8x16_t t7 = vreinterpretq_u8_u32(vshrq_n_u32(vreinterpretq_u32_u8(t3), 31));
+    uint8x16_t t8 = vreinterpretq_u8_u32(vshrq_n_u32(vreinterpretq_u32_u8(t6), 31));
+    t3 = vreinterpretq_u8_u32(vshlq_n_u32(vreinterpretq_u32_u8(t3), 1));
+    t6 = vreinterpretq_u8_u32(vshlq_n_u32(vreinterpretq_u32_u8(t6), 1));
+    uint8x16_t t9 = vextq_u8(t7, z, 12);
+    t8 = vextq_u8(z, t8, 12);
+    t7 = vextq_u8(z, t7, 12);
+    t3 = vorrq_u8(t3, t7);
+    t6 = vorrq_u8(t6, t8);
+    t6 = vorrq_u8(t6, t9);
+
+    t7 = vreinterpretq_u8_u32(vshlq_n_u32(vreinterpretq_u32_u8(t3), 31));
+    t8 = vreinterpretq_u8_u32(vshlq_n_u32(vreinterpretq_u32_u8(t3), 30));
+    t9 = vreinterpretq_u8_u32(vshlq_n_u32(vreinterpretq_u32_u8(t3), 25));
+    t7 = veorq_u8(t7, t8);
+    t7 = veorq_u8(t7, t9);
+    t8 = vextq_u8(t7, z, 4);
+    t7 = vextq_u8(z, t7, 4);
+    t3 = veorq_u8(t3, t7);
+    uint8x16_t t2 = vreinterpretq_u8_u32(vshrq_n_u32(vreinterpretq_u32_u8(t3), 1));
+    t4 = vreinterpretq_u8_u32(vshrq_n_u32(vreinterpretq_u32_u8(t3), 2));
+    t5 = vreinterpretq_u8_u32(vshrq_n_u32(vreinterpretq_u32_u8(t3), 7));
+    t2 = veorq_u8(t2, t4);
+    t2 = veorq_u8(t2, t5);
+    t2 = veorq_u8(t2, t8);
+    t3 = veorq_u8(t3, t2);
+
+    return veorq_u8(t6, t3);
+}
+
+static void lt_bswap_block(const uint8_t *in, uint8_t *out)
+{
+    vst1q_u8(out, lt_bswap128(vld1q_u8(in)));
+}
+
+static void lt_ghash_mul(uint8_t *x, const lt_aesgcm_accel_ctx_t *c)
+{
+    uint8x16_t r = lt_gfmul(lt_bswap128(vld1q_u8(x)), vld1q_u8(c->h));
+    vst1q_u8(x, lt_bswap128(r));
+}
+#endif
+
+//--------------------------------------------------------------------------------------------------------------------//
+
+/** FIPS-197 key expansion, SubWord() is done by the AES instructions, so no S-box table is needed */
+static int lt_aes_expand_key(lt_aesgcm_accel_ctx_t *c, const uint8_t *key, uint32_t key_len)
+{
+    static const uint8_t rcon[] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+    if ((key_len != 16) && (key_len != 24) && (key_len != 32)) {
+        return LT_FAIL;
+    }
+
+    uint32_t nk = key_len / 4;
+    c->rounds = (uint8_t)(nk + 6);
+    memcpy(c->rk, key, key_len);
+
+    for (uint32_t i = nk; i < 4u * (c->rounds + 1u); i++) {
+        uint8_t t[4];
+        memcpy(t, c->rk + 4 * (i - 1), 4);
+        if ((i % nk) == 0) {
+            uint8_t t0 = t[0];
+            t[0] = t[1];
+            t[1] = t[2];
+            t[2] = t[3];
+            t[3] = t0;
+            lt_aes_sub_word(t);
+            t[0] ^= rcon[i / nk - 1];
+        }
+        else if ((nk > 6) && ((i % nk) == 4)) {
+            lt_aes_sub_word(t);
+        }
+        for (uint32_t j = 0; j < 4; j++) {
+            c->rk[4 * i + j] = c->rk[4 * (i - nk) + j] ^ t[j];
+        }
+    }
+
+    return LT_OK;
+}
+
+static void lt_ctr_inc(uint8_t *ctr)
+{
+    for (int i = LT_AES_BLOCK_SIZE - 1; i >= LT_AES_BLOCK_SIZE - 4; i--) {
+        if (++ctr[i] != 0) {
+            break;
+        }
+    }
+}
+
+/** GHASH of data padded to whole blocks into x */
+static void lt_ghash_update(lt_aesgcm_accel_ctx_t *c, uint8_t *x, const uint8_t *data, uint32_t len)
+{
+    while (len) {
+        uint32_t n = (len < LT_AES_BLOCK_SIZE) ? len : LT_AES_BLOCK_SIZE;
+        for (uint32_t i = 0; i < n; i++) {
+            x[i] ^= data[i];
+        }
+        lt_ghash_mul(x, c);
+        data += n;
+        len -= n;
+    }
+}
+
+static void lt_ghash_lengths(lt_aesgcm_accel_ctx_t *c, uint8_t *x, uint64_t a_bits, uint64_t c_bits)
+{
+    uint8_t block[LT_AES_BLOCK_SIZE];
+    for (int i = 0; i < 8; i++) {
+        block[7 - i] = (uint8_t)(a_bits >> (8 * i));
+        block[15 - i] = (uint8_t)(c_bits >> (8 * i));
+    }
+    lt_ghash_update(c, x, block, sizeof(block));
+}
+
+static int lt_gcm_start(lt_aesgcm_accel_ctx_t *c, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad,
+                        uint32_t aad_len)
+{
+    if (!c->rounds || !iv_len) {
+        return LT_FAIL;
+    }
+
+    uint8_t j0[LT_AES_BLOCK_SIZE] = {0};
+    if (iv_len == 12) {
+        memcpy(j0, iv, 12);
+        j0[15] = 1;
+    }
+    else {
+        lt_ghash_update(c, j0, iv, iv_len);
+        lt_ghash_lengths(c, j0, 0, (uint64_t)iv_len * 8);
+    }
+
+    lt_aes_encrypt_block(c, j0, c->ej0);
+    memcpy(c->ctr, j0, sizeof(j0));
+    lt_ctr_inc(c->ctr);
+
+    memset(c->ghash, 0, sizeof(c->ghash));
+    lt_ghash_update(c, c->ghash, aad, aad_len);
+    c->aad_len = aad_len;
+    c->msg_len = 0;
+    c->ks_pos = LT_AES_BLOCK_SIZE;
+
+    return LT_OK;
+}
+
+/** Encrypts or decrypts in place, GHASH is always computed over ciphertext */
+static void lt_gcm_crypt(lt_aesgcm_accel_ctx_t *c, uint8_t *msg, uint32_t len, int encrypt)
+{
+    // Finish keystream block left from the previous call
+    while (len && (c->ks_pos < LT_AES_BLOCK_SIZE)) {
+        uint8_t in = *msg;
+        *msg ^= c->ks[c->ks_pos];
+        c->ghash[c->ks_pos++] ^= encrypt ? *msg : in;
+        if (c->ks_pos == LT_AES_BLOCK_SIZE) {
+            lt_ghash_mul(c->ghash, c);
+        }
+        msg++;
+        len--;
+        c->msg_len++;
+    }
+
+    while (len >= LT_AES_BLOCK_SIZE) {
+        lt_aes_encrypt_block(c, c->ctr, c->ks);
+        lt_ctr_inc(c->ctr);
+        for (int i = 0; i < LT_AES_BLOCK_SIZE; i++) {
+            uint8_t in = msg[i];
+            msg[i] ^= c->ks[i];
+            c->ghash[i] ^= encrypt ? msg[i] : in;
+        }
+        lt_ghash_mul(c->ghash, c);
+        msg += LT_AES_BLOCK_SIZE;
+        len -= LT_AES_BLOCK_SIZE;
+        c->msg_len += LT_AES_BLOCK_SIZE;
+    }
+
+    if (len) {
+        lt_aes_encrypt_block(c, c->ctr, c->ks);
+        lt_ctr_inc(c->ctr);
+        c->ks_pos = 0;
+        while (len--) {
+            uint8_t in = *msg;
+            *msg ^= c->ks[c->ks_pos];
+            c->ghash[c->ks_pos++] ^= encrypt ? *msg : in;
+            msg++;
+            c->msg_len++;
+        }
+    }
+}
+
+static int lt_gcm_tag(lt_aesgcm_accel_ctx_t *c, uint8_t *tag, uint32_t tag_len)
+{
+    if (tag_len > LT_AES_BLOCK_SIZE) {
+        return LT_FAIL;
+    }
+
+    // Incomplete block was already XORed into the accumulator
+    if (c->ks_pos < LT_AES_BLOCK_SIZE) {
+        lt_ghash_mul(c->ghash, c);
+        c->ks_pos = LT_AES_BLOCK_SIZE;
+    }
+    lt_ghash_lengths(c, c->ghash, (uint64_t)c->aad_len * 8, (uint64_t)c->msg_len * 8);
+
+    for (uint32_t i = 0; i < tag_len; i++) {
+        tag[i] = c->ghash[i] ^ c->ej0[i];
+    }
+
+    return LT_OK;
+}
+
+#if LT_AESGCM_MULTI_LANES > 1
+/** Encrypts messages of started contexts with the same number of rounds, block by block in all lanes at once */
+static void lt_gcm_encrypt_lanes(lt_aesgcm_accel_ctx_t *const *c, uint8_t *const *msgs, const uint32_t *msg_lens,
+                                 const size_t n)
+{
+    for (uint32_t pos = 0;; pos += LT_AES_BLOCK_SIZE) {
+        lt_aesgcm_accel_ctx_t *lane[LT_AESGCM_MULTI_LANES];
+        uint8_t *block[LT_AESGCM_MULTI_LANES];
+        uint8_t block_len[LT_AESGCM_MULTI_LANES];
+        size_t cnt = 0;
+
+        // Lanes of shorter messages drop out
+        for (size_t i = 0; i < n; i++) {
+            if (msg_lens[i] > pos) {
+                lane[cnt] = c[i];
+                block[cnt] = msgs[i] + pos;
+                block_len[cnt] = (uint8_t)(((msg_lens[i] - pos) < LT_AES_BLOCK_SIZE) ? (msg_lens[i] - pos)
+                                                                                       : LT_AES_BLOCK_SIZE);
+                cnt++;
+            }
+        }
+        if (!cnt) {
+            return;
+        }
+
+        lt_aes_encrypt_lanes(lane, cnt);
+        for (size_t j = 0; j < cnt; j++) {
+            lt_ctr_inc(lane[j]->ctr);
+            for (uint8_t i = 0; i < block_len[j]; i++) {
+                block[j][i] ^= lane[j]->ks[i];
+                lane[j]->ghash[i] ^= block[j][i];
+            }
+            lane[j]->msg_len += block_len[j];
+        }
+        // Multiplications of the lanes are independent, incomplete last block is multiplied by lt_gcm_tag()
+        for (size_t j = 0; j < cnt; j++) {
+            if (block_len[j] == LT_AES_BLOCK_SIZE) {
+                lt_ghash_mul(lane[j]->ghash, lane[j]);
+            }
+            else {
+                lane[j]->ks_pos = block_len[j];
+            }
+        }
+    }
+}
+#endif
+
+//--------------------------------------------------------------------------------------------------------------------//
+
+int lt_aesgcm_init_and_key(void *ctx, const uint8_t *key, uint32_t key_len)
+{
+    lt_aesgcm_accel_ctx_t *c = (lt_aesgcm_accel_ctx_t *)ctx;
+    memset(c, 0, sizeof(lt_aesgcm_accel_ctx_t));
+
+    if (lt_aes_expand_key(c, key, key_len) != LT_OK) {
+        memset(c, 0, sizeof(lt_aesgcm_accel_ctx_t));
+        return LT_FAIL;
+    }
+
+    uint8_t h[LT_AES_BLOCK_SIZE] = {0};
+    lt_aes_encrypt_block(c, h, h);
+    lt_bswap_block(h, c->h);
+    memset(h, 0, sizeof(h));
+
+    return LT_OK;
+}
+
+int lt_aesgcm_encrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, uint8_t *tag, uint32_t tag_len)
+{
+    lt_aesgcm_accel_ctx_t *c = (lt_aesgcm_accel_ctx_t *)ctx;
+
+    if (lt_gcm_start(c, iv, iv_len, aad, aad_len) != LT_OK) {
+        return LT_FAIL;
+    }
+    lt_gcm_crypt(c, msg, msg_len, 1);
+
+    return lt_gcm_tag(c, tag, tag_len);
+}
+
+int lt_aesgcm_decrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, const uint8_t *tag, uint32_t tag_len)
+{
+    int ret = lt_aesgcm_decrypt_start(ctx, iv, iv_len, aad, aad_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_aesgcm_decrypt_update(ctx, msg, msg_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_aesgcm_decrypt_finish(ctx, tag, tag_len);
+}
+
+int lt_aesgcm_decrypt_start(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len)
+{
+    return lt_gcm_start((lt_aesgcm_accel_ctx_t *)ctx, iv, iv_len, aad, aad_len);
+}
+
+int lt_aesgcm_decrypt_update(void *ctx, uint8_t *msg, uint32_t msg_len)
+{
+    lt_gcm_crypt((lt_aesgcm_accel_ctx_t *)ctx, msg, msg_len, 0);
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt_finish(void *ctx, const uint8_t *tag, uint32_t tag_len)
+{
+    uint8_t computed[LT_AES_BLOCK_SIZE];
+    uint8_t diff = 0;
+
+    if (lt_gcm_tag((lt_aesgcm_accel_ctx_t *)ctx, computed, tag_len) != LT_OK) {
+        return LT_FAIL;
+    }
+
+    // Compare in constant time
+    for (uint32_t i = 0; i < tag_len; i++) {
+        diff |= computed[i] ^ tag[i];
+    }
+    memset(computed, 0, sizeof(computed));
+
+    return (diff == 0) ? LT_OK : LT_FAIL;
+}
+
+int lt_aesgcm_end(void *ctx)
+{
+    memset(ctx, 0, sizeof(lt_aesgcm_accel_ctx_t));
+
+    return LT_OK;
+}
+
+#if LT_AESGCM_MULTI_LANES > 1
+void lt_aesgcm_encrypt_multi(void *const *ctxs, const uint8_t *const *ivs, const uint32_t iv_len, uint8_t *const *msgs,
+                             const uint32_t *msg_lens, uint8_t *const *tags, const uint32_t tag_len, const size_t n,
+                             int *rets)
+{
+    for (size_t first = 0; first < n; first += LT_AESGCM_MULTI_LANES) {
+        const size_t group = ((n - first) < LT_AESGCM_MULTI_LANES) ? (n - first) : LT_AESGCM_MULTI_LANES;
+        lt_aesgcm_accel_ctx_t *lane[LT_AESGCM_MULTI_LANES];
+        uint8_t *lane_msgs[LT_AESGCM_MULTI_LANES];
+        uint32_t lane_lens[LT_AESGCM_MULTI_LANES];
+        size_t lane_idx[LT_AESGCM_MULTI_LANES];
+        size_t cnt = 0;
+
+        for (size_t i = first; i < first + group; i++) {
+            lt_aesgcm_accel_ctx_t *c = (lt_aesgcm_accel_ctx_t *)ctxs[i];
+            rets[i] = lt_gcm_start(c, ivs[i], iv_len, (const uint8_t *)"", 0);
+            if (rets[i] != LT_OK) {
+                continue;
+            }
+            // Only keys of the same length are interleaved, L3 sessions all use AES-256
+            if (cnt && (c->rounds != lane[0]->rounds)) {
+                lt_gcm_crypt(c, msgs[i], msg_lens[i], 1);
+                rets[i] = lt_gcm_tag(c, tags[i], tag_len);
+                continue;
+            }
+            lane[cnt] = c;
+            lane_msgs[cnt] = msgs[i];
+            lane_lens[cnt] = msg_lens[i];
+            lane_idx[cnt] = i;
+            cnt++;
+        }
+
+        lt_gcm_encrypt_lanes(lane, lane_msgs, lane_lens, cnt);
+        for (size_t j = 0; j < cnt; j++) {
+            rets[lane_idx[j]] = lt_gcm_tag(lane[j], tags[lane_idx[j]], tag_len);
+        }
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file lt_crypto_accel_sha256.c
+ * @brief SHA256 compression using SHA extensions on x86 or SHA256 instructions of ARMv8 Crypto Extensions
+ * @author Tropic Square s.r.o.
+ *
+ * Buffering and HMAC are done by the common front end, see lt_sha256_blocks.h.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if defined(LT_SHA256_ACCEL) || LT_CRYPTO_DISPATCH
+#include <stdint.h>
+#include <string.h>
+
+// Suffix of the functions linked together with other implementations, see lt_crypto_dispatch.h
+#define LT_CRYPTO_IMPL accel
+
+#include "lt_sha256_blocks.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#if !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_SHA2)
+#error "Accelerated SHA256 needs Crypto Extensions enabled, e.g. -march=armv8-a+crypto"
+#endif
+#else
+#error "Accelerated SHA256 is supported only on x86 and AArch64"
+#endif
+
+static const uint32_t lt_sha256_k[64] __attribute__((aligned(16))) = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+//--------------------------------------------------------------------------------------------------------------------//
+#if defined(__x86_64__) || defined(__i386__)
+
+void lt_sha256_compress_blocks(uint32_t state[8], const uint8_t *blocks, size_t n)
+{
+    // Big endian words of the message
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i m[4], msg, tmp, state0, state1;
+
+    // SHA256RNDS2 works on ABEF and CDGH
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);  // CDAB
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);  // EFGH
+    state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);  // CDGH
+
+    for (; n; n--, blocks += LT_SHA256_BLOCK_LEN) {
+        __m128i abef = state0, cdgh = state1;
+
+        for (int g = 0; g < 16; g++) {
+            if (g < 4) {
+                m[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks + 16 * g)), bswap);
+            }
+            else {
+                // W[t-16] + s0(W[t-15]) + W[t-7] + s1(W[t-2]) of four words
+                tmp = _mm_sha256msg1_epu32(m[g & 3], m[(g + 1) & 3]);
+                tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(m[(g + 3) & 3], m[(g + 2) & 3], 4));
+                m[g & 3] = _mm_sha256msg2_epu32(tmp, m[(g + 3) & 3]);
+            }
+            msg = _mm_add_epi32(m[g & 3], _mm_load_si128((const __m128i *)&lt_sha256_k[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);  // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xb1);  // DCHG
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xf0));  // DCBA
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));  // HGFE
+}
+
+//--------------------------------------------------------------------------------------------------------------------//
+#elif defined(__aarch64__)
+
+void lt_sha256_compress_blocks(uint32_t state[8], const uint8_t *blocks, size_t n)
+{
+    uint32x4_t state0 = vld1q_u32(&state[0]), state1 = vld1q_u32(&state[4]);
+    uint32x4_t m[4];
+
+    for (; n; n--, blocks += LT_SHA256_BLOCK_LEN) {
+        uint32x4_t abcd = state0, efgh = state1;
+
+        for (int g = 0; g < 4; g++) {
+            m[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16 * g)));
+        }
+        for (int g = 0; g < 16; g++) {
+            uint32x4_t msg = vaddq_u32(m[g & 3], vld1q_u32(&lt_sha256_k[4 * g]));
+            // Words of group g + 4 replace these of group g
+            if (g < 12) {
+                m[g & 3] = vsha256su1q_u32(vsha256su0q_u32(m[g & 3], m[(g + 1) & 3]), m[(g + 2) & 3], m[(g + 3) & 3]);
+            }
+            uint32x4_t prev = state0;
+            state0 = vsha256hq_u32(state0, state1, msg);
+            state1 = vsha256h2q_u32(state1, prev, msg);
+        }
+
+        state0 = vaddq_u32(state0, abcd);
+        state1 = vaddq_u32(state1, efgh);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+#endif
+#endif
@@ -0,0 +1,30 @@
+/**
+ * @file lt_crypto_aesgcm_multi.c
+ * @author Tropic Square s.r.o.
+ * @brief AES-GCM encryption of several messages by any crypto backend, see lt_aesgcm_multi.h
+ *
+ * Interleaved lanes are implemented by hal/crypto/accel/lt_crypto_accel_aesgcm.c, which has access to its contexts.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "lt_aesgcm.h"
+#include "lt_aesgcm_multi.h"
+
+#if LT_AESGCM_MULTI_LANES == 1
+
+void lt_aesgcm_encrypt_multi(void *const *ctxs, const uint8_t *const *ivs, const uint32_t iv_len, uint8_t *const *msgs,
+                             const uint32_t *msg_lens, uint8_t *const *tags, const uint32_t tag_len, const size_t n,
+                             int *rets)
+{
+    for (size_t i = 0; i < n; i++) {
+        rets[i] = lt_aesgcm_encrypt(ctxs[i], ivs[i], iv_len, (const uint8_t *)"", 0, msgs[i], msg_lens[i], tags[i],
+                                    tag_len);
+    }
+}
+
+#endif
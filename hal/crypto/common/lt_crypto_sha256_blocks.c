@@ -0,0 +1,171 @@
+/**
+ * @file lt_crypto_sha256_blocks.c
+ * @author Tropic Square s.r.o.
+ * @brief SHA256 and HMAC SHA256 on top of `lt_sha256_compress_blocks()` of a backend
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_SHA256_BLOCKS
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_macros.h"
+#include "lt_hmac_sha256.h"
+#include "lt_sha256.h"
+#include "lt_sha256_blocks.h"
+#include "memzero.h"
+
+/** SHA256 state, placed into `struct lt_crypto_sha256_ctx_t` */
+typedef struct lt_sha256_state_t {
+    uint32_t h[8];
+    /** Number of hashed bytes, low and high word */
+    uint32_t len[2];
+    uint8_t buf[LT_SHA256_BLOCK_LEN];
+} lt_sha256_state_t;
+
+STATIC_ASSERT(sizeof(lt_sha256_state_t) <= sizeof(struct lt_crypto_sha256_ctx_t))
+STATIC_ASSERT(MEMBER_SIZE(struct lt_hmac_sha256_ctx_t, space) >= 2 * 8 * sizeof(uint32_t))
+
+static const uint32_t lt_sha256_iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+/** Starts hashing from the state after `len` bytes (whole blocks) */
+static void lt_sha256_state_init(lt_sha256_state_t *s, const uint32_t h[8], const uint32_t len)
+{
+    memcpy(s->h, h, sizeof(s->h));
+    s->len[0] = len;
+    s->len[1] = 0;
+}
+
+static void lt_sha256_state_update(lt_sha256_state_t *s, const uint8_t *input, size_t len)
+{
+    size_t used = s->len[0] % LT_SHA256_BLOCK_LEN;
+
+    s->len[0] += (uint32_t)len;
+    if (s->len[0] < (uint32_t)len) {
+        s->len[1]++;
+    }
+#if SIZE_MAX > UINT32_MAX
+    s->len[1] += (uint32_t)((uint64_t)len >> 32);
+#endif
+
+    if (used) {
+        size_t fill = LT_SHA256_BLOCK_LEN - used;
+        if (len < fill) {
+            memcpy(s->buf + used, input, len);
+            return;
+        }
+        memcpy(s->buf + used, input, fill);
+        lt_sha256_compress_blocks(s->h, s->buf, 1);
+        input += fill;
+        len -= fill;
+    }
+    // Whole blocks are compressed straight from the input
+    size_t n = len / LT_SHA256_BLOCK_LEN;
+    if (n) {
+        lt_sha256_compress_blocks(s->h, input, n);
+        input += n * LT_SHA256_BLOCK_LEN;
+        len -= n * LT_SHA256_BLOCK_LEN;
+    }
+    memcpy(s->buf, input, len);
+}
+
+static void lt_sha256_state_final(lt_sha256_state_t *s, uint8_t *output)
+{
+    size_t used = s->len[0] % LT_SHA256_BLOCK_LEN;
+    uint32_t bits_hi = (s->len[1] << 3) | (s->len[0] >> 29), bits_lo = s->len[0] << 3;
+
+    s->buf[used++] = 0x80;
+    if (used > LT_SHA256_BLOCK_LEN - 8) {
+        memset(s->buf + used, 0, LT_SHA256_BLOCK_LEN - used);
+        lt_sha256_compress_blocks(s->h, s->buf, 1);
+        used = 0;
+    }
+    memset(s->buf + used, 0, LT_SHA256_BLOCK_LEN - 8 - used);
+    for (int i = 0; i < 4; i++) {
+        s->buf[56 + i] = (uint8_t)(bits_hi >> (24 - 8 * i));
+        s->buf[60 + i] = (uint8_t)(bits_lo >> (24 - 8 * i));
+    }
+    lt_sha256_compress_blocks(s->h, s->buf, 1);
+
+    for (int i = 0; i < 8; i++) {
+        output[4 * i] = (uint8_t)(s->h[i] >> 24);
+        output[4 * i + 1] = (uint8_t)(s->h[i] >> 16);
+        output[4 * i + 2] = (uint8_t)(s->h[i] >> 8);
+        output[4 * i + 3] = (uint8_t)s->h[i];
+    }
+    memzero(s, sizeof(*s));
+}
+
+void lt_sha256_init(void *ctx) { memset(ctx, 0, sizeof(lt_sha256_state_t)); }
+
+void lt_sha256_start(void *ctx) { lt_sha256_state_init((lt_sha256_state_t *)ctx, lt_sha256_iv, 0); }
+
+void lt_sha256_update(void *ctx, const uint8_t *input, size_t len)
+{
+    lt_sha256_state_update((lt_sha256_state_t *)ctx, input, len);
+}
+
+void lt_sha256_finish(void *ctx, uint8_t *output) { lt_sha256_state_final((lt_sha256_state_t *)ctx, output); }
+
+void lt_hmac_sha256_init(struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t keylen)
+{
+    uint8_t pad[LT_SHA256_BLOCK_LEN] = {0};
+    uint32_t state[8];
+
+    if (keylen > LT_SHA256_BLOCK_LEN) {
+        lt_sha256_state_t s;
+        lt_sha256_state_init(&s, lt_sha256_iv, 0);
+        lt_sha256_state_update(&s, key, keylen);
+        lt_sha256_state_final(&s, pad);
+    }
+    else {
+        memcpy(pad, key, keylen);
+    }
+
+    // space[0..7] holds state after inner key pad, space[8..15] after outer key pad
+    for (int i = 0; i < LT_SHA256_BLOCK_LEN; i++) {
+        pad[i] ^= 0x36;
+    }
+    memcpy(state, lt_sha256_iv, sizeof(state));
+    lt_sha256_compress_blocks(state, pad, 1);
+    memcpy(&ctx->space[0], state, sizeof(state));
+    for (int i = 0; i < LT_SHA256_BLOCK_LEN; i++) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+    memcpy(state, lt_sha256_iv, sizeof(state));
+    lt_sha256_compress_blocks(state, pad, 1);
+    memcpy(&ctx->space[8], state, sizeof(state));
+
+    memzero(pad, sizeof(pad));
+    memzero(state, sizeof(state));
+}
+
+void lt_hmac_sha256_compute(const struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *input, size_t ilen,
+                            uint8_t *output)
+{
+    lt_sha256_state_t s;
+    uint8_t inner[SHA256_DIGEST_LENGTH];
+
+    // Both pads were already processed, that is one block of SHA256
+    lt_sha256_state_init(&s, &ctx->space[0], LT_SHA256_BLOCK_LEN);
+    lt_sha256_state_update(&s, input, ilen);
+    lt_sha256_state_final(&s, inner);
+
+    lt_sha256_state_init(&s, &ctx->space[8], LT_SHA256_BLOCK_LEN);
+    lt_sha256_state_update(&s, inner, SHA256_DIGEST_LENGTH);
+    lt_sha256_state_final(&s, output);
+
+    memzero(inner, sizeof(inner));
+}
+
+void lt_hmac_sha256(const uint8_t *key, size_t keylen, const uint8_t *input, size_t ilen, uint8_t *output)
+{
+    struct lt_hmac_sha256_ctx_t ctx;
+
+    lt_hmac_sha256_init(&ctx, key, keylen);
+    lt_hmac_sha256_compute(&ctx, input, ilen, output);
+    memzero(&ctx, sizeof(ctx));
+}
+#endif
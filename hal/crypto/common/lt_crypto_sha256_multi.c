@@ -0,0 +1,195 @@
+/**
+ * @file lt_crypto_sha256_multi.c
+ * @author Tropic Square s.r.o.
+ * @brief Multi-buffer SHA256, see lt_sha256_multi.h
+ *
+ * Working variables of LT_SHA256_MULTI_LANES messages are kept transposed in vectors of GCC vector extensions, so
+ * each round is computed for all lanes by SSE2 or NEON (4 lanes) or by AVX2 (8 lanes) instructions, according to the
+ * flags this file is compiled with.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lt_sha256.h"
+#include "lt_sha256_multi.h"
+
+#if LT_SHA256_MULTI_LANES > 1
+
+/** Block length of SHA256 */
+#define LT_SHA256_MB_BLOCK_LEN 64
+
+/** One 32-bit word of each lane */
+typedef uint32_t lt_sha256_vec_t __attribute__((vector_size(4 * LT_SHA256_MULTI_LANES)));
+
+static const uint32_t lt_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t lt_sha256_iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+/** Compressed by lanes without a message */
+static const uint8_t lt_sha256_idle_block[LT_SHA256_MB_BLOCK_LEN];
+
+#define LT_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define LT_S0(x) (LT_ROR((x), 2) ^ LT_ROR((x), 13) ^ LT_ROR((x), 22))
+#define LT_S1(x) (LT_ROR((x), 6) ^ LT_ROR((x), 11) ^ LT_ROR((x), 25))
+#define LT_s0(x) (LT_ROR((x), 7) ^ LT_ROR((x), 18) ^ ((x) >> 3))
+#define LT_s1(x) (LT_ROR((x), 17) ^ LT_ROR((x), 19) ^ ((x) >> 10))
+#define LT_CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define LT_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+static inline uint32_t lt_load_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline void lt_store_be32(uint8_t *p, const uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/** Compresses one block of each lane into the transposed state */
+static void lt_sha256_compress_lanes(lt_sha256_vec_t state[8], const uint8_t *const blocks[LT_SHA256_MULTI_LANES])
+{
+    lt_sha256_vec_t w[16];
+
+    for (int t = 0; t < 16; t++) {
+        for (int l = 0; l < LT_SHA256_MULTI_LANES; l++) {
+            w[t][l] = lt_load_be32(blocks[l] + 4 * t);
+        }
+    }
+
+    lt_sha256_vec_t a = state[0], b = state[1], c = state[2], d = state[3];
+    lt_sha256_vec_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; t++) {
+        if (t >= 16) {
+            w[t & 15] += LT_s1(w[(t - 2) & 15]) + w[(t - 7) & 15] + LT_s0(w[(t - 15) & 15]);
+        }
+        lt_sha256_vec_t t1 = h + LT_S1(e) + LT_CH(e, f, g) + lt_sha256_k[t] + w[t & 15];
+        lt_sha256_vec_t t2 = LT_S0(a) + LT_MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/** Hashes up to LT_SHA256_MULTI_LANES messages, one in each lane */
+static void lt_sha256_multi_group(const uint8_t *const *msgs, const uint32_t *msg_lens, const size_t cnt,
+                                  uint8_t *digests)
+{
+    lt_sha256_vec_t state[8];
+    // Padding of each message takes one or two blocks after its full blocks
+    uint8_t tail[LT_SHA256_MULTI_LANES][2 * LT_SHA256_MB_BLOCK_LEN];
+    uint32_t full[LT_SHA256_MULTI_LANES], total[LT_SHA256_MULTI_LANES];
+    const uint8_t *blocks[LT_SHA256_MULTI_LANES];
+    uint32_t blocks_max = 0;
+
+    for (int j = 0; j < 8; j++) {
+        state[j] = (lt_sha256_vec_t){0} + lt_sha256_iv[j];
+    }
+
+    memset(tail, 0, sizeof(tail));
+    for (size_t l = 0; l < LT_SHA256_MULTI_LANES; l++) {
+        if (l >= cnt) {
+            full[l] = 0;
+            total[l] = 0;
+            continue;
+        }
+        uint32_t rest = msg_lens[l] % LT_SHA256_MB_BLOCK_LEN;
+        full[l] = msg_lens[l] / LT_SHA256_MB_BLOCK_LEN;
+        total[l] = full[l] + ((rest + 9 > LT_SHA256_MB_BLOCK_LEN) ? 2 : 1);
+
+        memcpy(tail[l], msgs[l] + (size_t)full[l] * LT_SHA256_MB_BLOCK_LEN, rest);
+        tail[l][rest] = 0x80;
+        uint8_t *bit_len = tail[l] + (total[l] - full[l]) * LT_SHA256_MB_BLOCK_LEN - 8;
+        uint64_t bits = (uint64_t)msg_lens[l] * 8;
+        lt_store_be32(bit_len, (uint32_t)(bits >> 32));
+        lt_store_be32(bit_len + 4, (uint32_t)bits);
+
+        if (total[l] > blocks_max) {
+            blocks_max = total[l];
+        }
+    }
+
+    for (uint32_t i = 0; i < blocks_max; i++) {
+        for (size_t l = 0; l < LT_SHA256_MULTI_LANES; l++) {
+            if (i < full[l]) {
+                blocks[l] = msgs[l] + (size_t)i * LT_SHA256_MB_BLOCK_LEN;
+            }
+            else if (i < total[l]) {
+                blocks[l] = tail[l] + (i - full[l]) * LT_SHA256_MB_BLOCK_LEN;
+            }
+            else {
+                // Lane is done, its digest is already stored
+                blocks[l] = lt_sha256_idle_block;
+            }
+        }
+        lt_sha256_compress_lanes(state, blocks);
+
+        for (size_t l = 0; l < cnt; l++) {
+            if (i + 1 == total[l]) {
+                for (int j = 0; j < 8; j++) {
+                    lt_store_be32(digests + (l * SHA256_DIGEST_LENGTH) + (4 * j), state[j][l]);
+                }
+            }
+        }
+    }
+
+    // Tails hold the ends of messages
+    memset(tail, 0, sizeof(tail));
+    __asm__ __volatile__("" : : "r"(tail) : "memory");
+}
+
+void lt_sha256_multi(const uint8_t *const *msgs, const uint32_t *msg_lens, size_t n, uint8_t *digests)
+{
+    for (size_t i = 0; i < n; i += LT_SHA256_MULTI_LANES) {
+        size_t cnt = ((n - i) < LT_SHA256_MULTI_LANES) ? (n - i) : LT_SHA256_MULTI_LANES;
+        lt_sha256_multi_group(msgs + i, msg_lens + i, cnt, digests + (i * SHA256_DIGEST_LENGTH));
+    }
+}
+
+#else
+
+void lt_sha256_multi(const uint8_t *const *msgs, const uint32_t *msg_lens, size_t n, uint8_t *digests)
+{
+    struct lt_crypto_sha256_ctx_t ctx;
+
+    lt_sha256_init(&ctx);
+    for (size_t i = 0; i < n; i++) {
+        lt_sha256_start(&ctx);
+        lt_sha256_update(&ctx, msgs[i], msg_lens[i]);
+        lt_sha256_finish(&ctx, digests + (i * SHA256_DIGEST_LENGTH));
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file lt_crypto_cortex_m_sha256.c
+ * @author Tropic Square s.r.o.
+ * @brief SHA256 compression for 32-bit Cortex-M cores
+ *
+ * The compression function is fully unrolled: working variables are renamed between rounds instead of moved, so
+ * they stay in registers, and the message schedule is kept in a 16 words window. Rotations are single instructions
+ * (ROR) on Cortex-M. Buffering and HMAC are done by the common front end, see lt_sha256_blocks.h.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_CRYPTO_CORTEX_M
+#include <stdint.h>
+#include <string.h>
+
+#include "lt_sha256_blocks.h"
+#include "memzero.h"
+
+static const uint32_t lt_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define LT_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define LT_S0(x) (LT_ROR((x), 2) ^ LT_ROR((x), 13) ^ LT_ROR((x), 22))
+#define LT_S1(x) (LT_ROR((x), 6) ^ LT_ROR((x), 11) ^ LT_ROR((x), 25))
+#define LT_s0(x) (LT_ROR((x), 7) ^ LT_ROR((x), 18) ^ ((x) >> 3))
+#define LT_s1(x) (LT_ROR((x), 17) ^ LT_ROR((x), 19) ^ ((x) >> 10))
+#define LT_CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define LT_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+/** Word i of the schedule window, expanded in place from round 16 on */
+#define LT_W(i) (w[(i) & 15] += LT_s1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + LT_s0(w[((i) - 15) & 15]))
+
+/** Round i with renamed working variables, `wi` is the schedule word */
+#define LT_ROUND(a, b, c, d, e, f, g, h, i, wi)                                      \
+    do {                                                                             \
+        uint32_t t1 = (h) + LT_S1(e) + LT_CH((e), (f), (g)) + lt_sha256_k[i] + (wi); \
+        (d) += t1;                                                                   \
+        (h) = t1 + LT_S0(a) + LT_MAJ((a), (b), (c));                                 \
+    } while (0)
+
+/** Eight rounds from i, the variables return to their names after eight renames */
+#define LT_ROUNDS8(i, wi)                                       \
+    do {                                                        \
+        LT_ROUND(a, b, c, d, e, f, g, h, (i) + 0, wi((i) + 0)); \
+        LT_ROUND(h, a, b, c, d, e, f, g, (i) + 1, wi((i) + 1)); \
+        LT_ROUND(g, h, a, b, c, d, e, f, (i) + 2, wi((i) + 2)); \
+        LT_ROUND(f, g, h, a, b, c, d, e, (i) + 3, wi((i) + 3)); \
+        LT_ROUND(e, f, g, h, a, b, c, d, (i) + 4, wi((i) + 4)); \
+        LT_ROUND(d, e, f, g, h, a, b, c, (i) + 5, wi((i) + 5)); \
+        LT_ROUND(c, d, e, f, g, h, a, b, (i) + 6, wi((i) + 6)); \
+        LT_ROUND(b, c, d, e, f, g, h, a, (i) + 7, wi((i) + 7)); \
+    } while (0)
+
+#define LT_W0(i) (w[i])
+
+static void lt_sha256_compress(uint32_t state[8], const uint8_t *block)
+{
+    uint32_t w[16];
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8)
+               | (uint32_t)block[4 * i + 3];
+    }
+
+    LT_ROUNDS8(0, LT_W0);
+    LT_ROUNDS8(8, LT_W0);
+    LT_ROUNDS8(16, LT_W);
+    LT_ROUNDS8(24, LT_W);
+    LT_ROUNDS8(32, LT_W);
+    LT_ROUNDS8(40, LT_W);
+    LT_ROUNDS8(48, LT_W);
+    LT_ROUNDS8(56, LT_W);
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+
+    memzero(w, sizeof(w));
+}
+
+void lt_sha256_compress_blocks(uint32_t state[8], const uint8_t *blocks, size_t n)
+{
+    for (; n; n--, blocks += LT_SHA256_BLOCK_LEN) {
+        lt_sha256_compress(state, blocks);
+    }
+}
+#endif
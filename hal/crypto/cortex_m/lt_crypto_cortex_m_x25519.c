@@ -0,0 +1,312 @@
+/**
+ * @file lt_crypto_cortex_m_x25519.c
+ * @author Tropic Square s.r.o.
+ * @brief X25519 for 32-bit Cortex-M cores
+ *
+ * Field elements are 8 words of 32 bits, reduced modulo 2^255 - 19 only partially (to 256 bits) between operations.
+ * Products are accumulated by the multiply-accumulate-accumulate step `lt_umaal()`, which is one UMAAL instruction on
+ * cores with DSP extension (Cortex-M4, M7, M33 with DSP). All operations are constant-time.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_CRYPTO_CORTEX_M
+#include <stdint.h>
+#include <string.h>
+
+#include "ed25519-donna/ed25519.h"
+#include "lt_x25519.h"
+#include "memzero.h"
+
+/** Field element, value is lo[0] + lo[1] * 2^32 + ... < 2^256 */
+typedef uint32_t lt_fe_t[8];
+
+/** (*hi, *lo) = a * b + *lo + *hi, the result always fits into 64 bits */
+static inline void lt_umaal(uint32_t *lo, uint32_t *hi, const uint32_t a, const uint32_t b)
+{
+#if defined(__ARM_FEATURE_DSP) && !defined(__clang_analyzer__)
+    __asm__("umaal %0, %1, %2, %3" : "+r"(*lo), "+r"(*hi) : "r"(a), "r"(b));
+#else
+    uint64_t t = (uint64_t)a * b + *lo + *hi;
+    *lo = (uint32_t)t;
+    *hi = (uint32_t)(t >> 32);
+#endif
+}
+
+/** r = r + 38 * c, where r is 256 bits and c is small, as 2^256 = 38 (mod p) */
+static inline void lt_fe_fold(lt_fe_t r, uint32_t c)
+{
+    uint64_t acc = (uint64_t)c * 38;
+
+    for (int i = 0; i < 8; i++) {
+        acc += r[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    // Carry out only when r wrapped around to a small value, adding it once more cannot carry
+    r[0] += (uint32_t)acc * 38;
+}
+
+/** r = 512-bit t reduced to 256 bits */
+static inline void lt_fe_reduce(lt_fe_t r, const uint32_t t[16])
+{
+    uint32_t carry = 0;
+
+    for (int i = 0; i < 8; i++) {
+        r[i] = t[i];
+        lt_umaal(&r[i], &carry, t[i + 8], 38);
+    }
+    lt_fe_fold(r, carry);
+}
+
+static void lt_fe_add(lt_fe_t r, const lt_fe_t a, const lt_fe_t b)
+{
+    uint64_t acc = 0;
+
+    for (int i = 0; i < 8; i++) {
+        acc += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    lt_fe_fold(r, (uint32_t)acc);
+}
+
+static void lt_fe_sub(lt_fe_t r, const lt_fe_t a, const lt_fe_t b)
+{
+    int64_t acc = 0;
+
+    for (int i = 0; i < 8; i++) {
+        acc += (int64_t)a[i] - b[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    // Borrow of 2^256 is 38 less (mod p), a borrow of the subtraction can happen only when r is close to 2^256
+    uint32_t borrow = (uint32_t)-acc;
+    acc = -(int64_t)(borrow * 38);
+    for (int i = 0; i < 8; i++) {
+        acc += r[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    r[0] -= (uint32_t)-acc * 38;
+}
+
+static void lt_fe_mul(lt_fe_t r, const lt_fe_t a, const lt_fe_t b)
+{
+    uint32_t t[16] = {0};
+
+    // Operand scanning, each row is one chain of UMAALs
+    for (int i = 0; i < 8; i++) {
+        uint32_t carry = 0;
+        for (int j = 0; j < 8; j++) {
+            lt_umaal(&t[i + j], &carry, a[i], b[j]);
+        }
+        t[i + 8] = carry;
+    }
+    lt_fe_reduce(r, t);
+}
+
+static void lt_fe_sqr(lt_fe_t r, const lt_fe_t a)
+{
+    uint32_t t[16] = {0};
+
+    // Products a[i] * a[j] for i < j are computed once and doubled
+    for (int i = 0; i < 7; i++) {
+        uint32_t carry = 0;
+        for (int j = i + 1; j < 8; j++) {
+            lt_umaal(&t[i + j], &carry, a[i], a[j]);
+        }
+        t[i + 8] = carry;
+    }
+    uint32_t top = 0;
+    for (int i = 0; i < 16; i++) {
+        uint32_t w = t[i];
+        t[i] = (w << 1) | top;
+        top = w >> 31;
+    }
+    uint32_t carry = 0;
+    for (int i = 0; i < 8; i++) {
+        uint32_t hi = 0;
+        lt_umaal(&t[2 * i], &hi, a[i], a[i]);
+        // hi + carry + t[2i+1] fits into 33 bits, its carry goes into the next diagonal
+        uint64_t s = (uint64_t)t[2 * i + 1] + hi + carry;
+        t[2 * i + 1] = (uint32_t)s;
+        carry = (uint32_t)(s >> 32);
+        if (i < 7) {
+            s = (uint64_t)t[2 * i + 2] + carry;
+            t[2 * i + 2] = (uint32_t)s;
+            carry = (uint32_t)(s >> 32);
+        }
+    }
+    lt_fe_reduce(r, t);
+}
+
+/** r = a^(2^n) */
+static void lt_fe_sqr_n(lt_fe_t r, const lt_fe_t a, int n)
+{
+    lt_fe_sqr(r, a);
+    while (--n > 0) {
+        lt_fe_sqr(r, r);
+    }
+}
+
+/** r = a * 121665 */
+static void lt_fe_mul_a24(lt_fe_t r, const lt_fe_t a)
+{
+    uint32_t carry = 0;
+
+    for (int i = 0; i < 8; i++) {
+        uint32_t lo = 0;
+        lt_umaal(&lo, &carry, a[i], 121665);
+        r[i] = lo;
+    }
+    lt_fe_fold(r, carry);
+}
+
+/** r = a^(p - 2) = 1/a, by the addition chain of ref10 */
+static void lt_fe_inv(lt_fe_t r, const lt_fe_t a)
+{
+    lt_fe_t z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+    lt_fe_sqr(z2, a);
+    lt_fe_sqr_n(t, z2, 2);
+    lt_fe_mul(z9, t, a);
+    lt_fe_mul(z11, z9, z2);
+    lt_fe_sqr(t, z11);
+    lt_fe_mul(z2_5_0, t, z9);
+    lt_fe_sqr_n(t, z2_5_0, 5);
+    lt_fe_mul(z2_10_0, t, z2_5_0);
+    lt_fe_sqr_n(t, z2_10_0, 10);
+    lt_fe_mul(z2_20_0, t, z2_10_0);
+    lt_fe_sqr_n(t, z2_20_0, 20);
+    lt_fe_mul(t, t, z2_20_0);
+    lt_fe_sqr_n(t, t, 10);
+    lt_fe_mul(z2_50_0, t, z2_10_0);
+    lt_fe_sqr_n(t, z2_50_0, 50);
+    lt_fe_mul(z2_100_0, t, z2_50_0);
+    lt_fe_sqr_n(t, z2_100_0, 100);
+    lt_fe_mul(t, t, z2_100_0);
+    lt_fe_sqr_n(t, t, 50);
+    lt_fe_mul(t, t, z2_50_0);
+    lt_fe_sqr_n(t, t, 5);
+    lt_fe_mul(r, t, z11);
+}
+
+/** Reduces a fully to [0, p) */
+static void lt_fe_freeze(lt_fe_t a)
+{
+    lt_fe_t t;
+    uint64_t acc;
+
+    // a < 2^256, fold bit 255: a < 2^255 + 19
+    acc = (uint64_t)(a[7] >> 31) * 19;
+    a[7] &= 0x7fffffff;
+    for (int i = 0; i < 8; i++) {
+        acc += a[i];
+        a[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    // a >= p exactly when a + 19 >= 2^255
+    acc = 19;
+    for (int i = 0; i < 8; i++) {
+        acc += a[i];
+        t[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    uint32_t mask = 0 - (t[7] >> 31);
+    t[7] &= 0x7fffffff;
+    for (int i = 0; i < 8; i++) {
+        a[i] ^= mask & (a[i] ^ t[i]);
+    }
+}
+
+static void lt_fe_cswap(lt_fe_t a, lt_fe_t b, const uint32_t swap)
+{
+    uint32_t mask = 0 - swap;
+
+    for (int i = 0; i < 8; i++) {
+        uint32_t x = mask & (a[i] ^ b[i]);
+        a[i] ^= x;
+        b[i] ^= x;
+    }
+}
+
+static void lt_fe_load(lt_fe_t r, const uint8_t *in)
+{
+    for (int i = 0; i < 8; i++) {
+        r[i] = (uint32_t)in[4 * i] | ((uint32_t)in[4 * i + 1] << 8) | ((uint32_t)in[4 * i + 2] << 16)
+               | ((uint32_t)in[4 * i + 3] << 24);
+    }
+}
+
+static void lt_fe_store(uint8_t *out, const lt_fe_t a)
+{
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)a[i];
+        out[4 * i + 1] = (uint8_t)(a[i] >> 8);
+        out[4 * i + 2] = (uint8_t)(a[i] >> 16);
+        out[4 * i + 3] = (uint8_t)(a[i] >> 24);
+    }
+}
+
+void lt_X25519(const uint8_t *priv, const uint8_t *pub, uint8_t *secret)
+{
+    uint8_t k[32];
+    lt_fe_t x1, x2 = {1}, z2 = {0}, x3, z3 = {1}, a, aa, b, bb, e, c, d, da, cb;
+    uint32_t swap = 0;
+
+    memcpy(k, priv, sizeof(k));
+    k[0] &= 248;
+    k[31] &= 127;
+    k[31] |= 64;
+    lt_fe_load(x1, pub);
+    x1[7] &= 0x7fffffff;
+    memcpy(x3, x1, sizeof(x3));
+
+    // Montgomery ladder of RFC 7748
+    for (int t = 254; t >= 0; t--) {
+        uint32_t k_t = (k[t >> 3] >> (t & 7)) & 1;
+        swap ^= k_t;
+        lt_fe_cswap(x2, x3, swap);
+        lt_fe_cswap(z2, z3, swap);
+        swap = k_t;
+
+        lt_fe_add(a, x2, z2);
+        lt_fe_sqr(aa, a);
+        lt_fe_sub(b, x2, z2);
+        lt_fe_sqr(bb, b);
+        lt_fe_sub(e, aa, bb);
+        lt_fe_add(c, x3, z3);
+        lt_fe_sub(d, x3, z3);
+        lt_fe_mul(da, d, a);
+        lt_fe_mul(cb, c, b);
+        lt_fe_add(x3, da, cb);
+        lt_fe_sqr(x3, x3);
+        lt_fe_sub(z3, da, cb);
+        lt_fe_sqr(z3, z3);
+        lt_fe_mul(z3, z3, x1);
+        lt_fe_mul(x2, aa, bb);
+        lt_fe_mul_a24(z2, e);
+        lt_fe_add(z2, z2, aa);
+        lt_fe_mul(z2, z2, e);
+    }
+    lt_fe_cswap(x2, x3, swap);
+    lt_fe_cswap(z2, z3, swap);
+
+    lt_fe_inv(z2, z2);
+    lt_fe_mul(x2, x2, z2);
+    lt_fe_freeze(x2);
+    lt_fe_store(secret, x2);
+
+    memzero(k, sizeof(k));
+    memzero(x2, sizeof(x2));
+    memzero(z2, sizeof(z2));
+    memzero(x3, sizeof(x3));
+    memzero(z3, sizeof(z3));
+}
+
+// Fixed-base multiplication of trezor_crypto (table of Edwards base multiples) is faster than the ladder above for
+// base point, see lt_x25519.h
+void lt_X25519_scalarmult(const uint8_t *sk, uint8_t *pk) { curve25519_scalarmult_basepoint(pk, sk); }
+
+#endif
@@ -0,0 +1,278 @@
+/**
+ * @file lt_crypto_dispatch.c
+ * @author Tropic Square s.r.o.
+ * @brief AES-GCM and SHA256 compression selected at runtime by features of the CPU
+ *
+ * trezor_crypto and the accelerated implementations (hal/crypto/accel) are linked together under suffixed names, see
+ * lt_crypto_dispatch.h. Functions here keep the original names and call the implementation selected by
+ * `lt_crypto_dispatch_init()`, trezor_crypto until then.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_CRYPTO_DISPATCH
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "lt_aesgcm.h"
+#include "lt_crypto_dispatch.h"
+#include "lt_sha256_blocks.h"
+#include "memzero.h"
+#include "sha2.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LT_AESGCM_ACCEL_NAME "aes-ni+pclmul"
+#define LT_SHA256_ACCEL_NAME "sha-ni"
+#elif defined(__aarch64__)
+#define LT_AESGCM_ACCEL_NAME "armv8-ce"
+#define LT_SHA256_ACCEL_NAME "armv8-sha2"
+#else
+#error "LT_CRYPTO_DISPATCH is supported only on x86 and AArch64"
+#endif
+
+/** Name reported for primitives of trezor_crypto */
+#define LT_TREZOR_NAME "trezor_crypto"
+
+/** Declares AES-GCM functions of implementation `impl` */
+#define LT_AESGCM_DECLARE(impl)                                                                                      \
+    int lt_aesgcm_init_and_key_##impl(void *ctx, const uint8_t *key, uint32_t key_len);                              \
+    int lt_aesgcm_encrypt_##impl(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, \
+                                 uint8_t *msg, uint32_t msg_len, uint8_t *tag, uint32_t tag_len);                    \
+    int lt_aesgcm_decrypt_##impl(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, \
+                                 uint8_t *msg, uint32_t msg_len, const uint8_t *tag, uint32_t tag_len);              \
+    int lt_aesgcm_decrypt_start_##impl(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad,            \
+                                       uint32_t aad_len);                                                            \
+    int lt_aesgcm_decrypt_update_##impl(void *ctx, uint8_t *msg, uint32_t msg_len);                                  \
+    int lt_aesgcm_decrypt_finish_##impl(void *ctx, const uint8_t *tag, uint32_t tag_len);                            \
+    int lt_aesgcm_end_##impl(void *ctx);
+
+LT_AESGCM_DECLARE(trezor)
+LT_AESGCM_DECLARE(accel)
+
+void lt_sha256_compress_blocks_accel(uint32_t state[8], const uint8_t *blocks, size_t n);
+
+/** AES-GCM implementation */
+typedef struct lt_aesgcm_impl_t {
+    const char *name;
+    int (*init_and_key)(void *ctx, const uint8_t *key, uint32_t key_len);
+    int (*encrypt)(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                   uint32_t msg_len, uint8_t *tag, uint32_t tag_len);
+    int (*decrypt)(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                   uint32_t msg_len, const uint8_t *tag, uint32_t tag_len);
+    int (*decrypt_start)(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len);
+    int (*decrypt_update)(void *ctx, uint8_t *msg, uint32_t msg_len);
+    int (*decrypt_finish)(void *ctx, const uint8_t *tag, uint32_t tag_len);
+    int (*end)(void *ctx);
+} lt_aesgcm_impl_t;
+
+#define LT_AESGCM_IMPL(impl, impl_name)                                                                         \
+    {                                                                                                           \
+        .name = impl_name, .init_and_key = lt_aesgcm_init_and_key_##impl, .encrypt = lt_aesgcm_encrypt_##impl,  \
+        .decrypt = lt_aesgcm_decrypt_##impl, .decrypt_start = lt_aesgcm_decrypt_start_##impl,                   \
+        .decrypt_update = lt_aesgcm_decrypt_update_##impl, .decrypt_finish = lt_aesgcm_decrypt_finish_##impl,   \
+        .end = lt_aesgcm_end_##impl                                                                             \
+    }
+
+/** SHA256 compression implementation */
+typedef struct lt_sha256_impl_t {
+    const char *name;
+    void (*compress_blocks)(uint32_t state[8], const uint8_t *blocks, size_t n);
+} lt_sha256_impl_t;
+
+/** Index of trezor_crypto in the tables, always usable */
+#define LT_IMPL_TREZOR 0
+/** Index of the accelerated implementation in the tables */
+#define LT_IMPL_ACCEL 1
+
+static const lt_aesgcm_impl_t lt_aesgcm_impls[] = {
+    [LT_IMPL_TREZOR] = LT_AESGCM_IMPL(trezor, LT_TREZOR_NAME),
+    [LT_IMPL_ACCEL] = LT_AESGCM_IMPL(accel, LT_AESGCM_ACCEL_NAME),
+};
+
+static void lt_sha256_compress_blocks_trezor(uint32_t state[8], const uint8_t *blocks, size_t n);
+
+static const lt_sha256_impl_t lt_sha256_impls[] = {
+    [LT_IMPL_TREZOR] = {.name = LT_TREZOR_NAME, .compress_blocks = lt_sha256_compress_blocks_trezor},
+    [LT_IMPL_ACCEL] = {.name = LT_SHA256_ACCEL_NAME, .compress_blocks = lt_sha256_compress_blocks_accel},
+};
+
+/** Selected implementations, indexes into the tables. Accessed atomically, crypto may run in several threads. */
+static uint8_t lt_aesgcm_sel = LT_IMPL_TREZOR;
+static uint8_t lt_sha256_sel = LT_IMPL_TREZOR;
+static bool lt_dispatch_done = false;
+
+// The last bytes of the AES-GCM context keep the index of implementation which initialized it, a session started
+// before `lt_crypto_dispatch_init()` keeps trezor_crypto
+STATIC_ASSERT(sizeof(gcm_ctx) <= LT_AESGCM_CTX_SIZE - LT_AESGCM_CTX_TAG_SIZE)
+
+//--------------------------------------------------------------------------------------------------------------------//
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static bool lt_cpu_has_aesgcm(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ecx & bit_AES) && (ecx & bit_PCLMUL) && (ecx & bit_SSSE3);
+}
+
+static bool lt_cpu_has_sha256(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1)) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_SHA) != 0;
+}
+
+#elif defined(__aarch64__) && defined(__linux__)
+
+static bool lt_cpu_has_aesgcm(void)
+{
+    unsigned long hwcap = getauxval(AT_HWCAP);
+
+    return (hwcap & HWCAP_AES) && (hwcap & HWCAP_PMULL);
+}
+
+static bool lt_cpu_has_sha256(void) { return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0; }
+
+#elif defined(__aarch64__) && defined(__APPLE__)
+
+// All Apple Silicon cores have Crypto Extensions
+static bool lt_cpu_has_aesgcm(void) { return true; }
+
+static bool lt_cpu_has_sha256(void) { return true; }
+
+#else
+
+// No way to query the features, stay with trezor_crypto
+static bool lt_cpu_has_aesgcm(void) { return false; }
+
+static bool lt_cpu_has_sha256(void) { return false; }
+
+#endif
+
+void lt_crypto_dispatch_init(void)
+{
+    if (__atomic_load_n(&lt_dispatch_done, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    // Concurrent first calls select the same, so they do not need to be serialized
+    __atomic_store_n(&lt_aesgcm_sel, lt_cpu_has_aesgcm() ? LT_IMPL_ACCEL : LT_IMPL_TREZOR, __ATOMIC_RELAXED);
+    __atomic_store_n(&lt_sha256_sel, lt_cpu_has_sha256() ? LT_IMPL_ACCEL : LT_IMPL_TREZOR, __ATOMIC_RELAXED);
+    __atomic_store_n(&lt_dispatch_done, true, __ATOMIC_RELEASE);
+}
+
+const char *lt_crypto_impl(lt_crypto_prim_t prim)
+{
+    lt_crypto_dispatch_init();
+
+    switch (prim) {
+        case LT_CRYPTO_PRIM_AESGCM:
+            return lt_aesgcm_impls[__atomic_load_n(&lt_aesgcm_sel, __ATOMIC_RELAXED)].name;
+        case LT_CRYPTO_PRIM_SHA256:
+            return lt_sha256_impls[__atomic_load_n(&lt_sha256_sel, __ATOMIC_RELAXED)].name;
+        // Single implementation on the host
+        case LT_CRYPTO_PRIM_X25519:
+        case LT_CRYPTO_PRIM_ECDSA:
+        case LT_CRYPTO_PRIM_ED25519:
+            return LT_TREZOR_NAME;
+        default:
+            return NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------//
+
+static void lt_sha256_compress_blocks_trezor(uint32_t state[8], const uint8_t *blocks, size_t n)
+{
+    uint32_t w[16];
+
+    for (; n; n--, blocks += LT_SHA256_BLOCK_LEN) {
+        // sha256_Transform() takes words already converted from big endian
+        for (int i = 0; i < 16; i++) {
+            w[i] = ((uint32_t)blocks[4 * i] << 24) | ((uint32_t)blocks[4 * i + 1] << 16)
+                   | ((uint32_t)blocks[4 * i + 2] << 8) | (uint32_t)blocks[4 * i + 3];
+        }
+        sha256_Transform(state, w, state);
+    }
+    memzero(w, sizeof(w));
+}
+
+void lt_sha256_compress_blocks(uint32_t state[8], const uint8_t *blocks, size_t n)
+{
+    lt_sha256_impls[__atomic_load_n(&lt_sha256_sel, __ATOMIC_RELAXED)].compress_blocks(state, blocks, n);
+}
+
+//--------------------------------------------------------------------------------------------------------------------//
+
+/** Index of implementation kept in the context */
+static uint8_t *lt_aesgcm_ctx_tag(void *ctx) { return (uint8_t *)ctx + LT_AESGCM_CTX_SIZE - LT_AESGCM_CTX_TAG_SIZE; }
+
+/**
+ * Implementation which initialized the context. Contexts which were never initialized (e.g. wiped by
+ * `lt_aesgcm_end()` before the first session) can hold anything, only trezor_crypto and the selected one are valid.
+ */
+static const lt_aesgcm_impl_t *lt_aesgcm_ctx_impl(void *ctx)
+{
+    uint8_t sel = __atomic_load_n(&lt_aesgcm_sel, __ATOMIC_RELAXED);
+
+    return &lt_aesgcm_impls[(*lt_aesgcm_ctx_tag(ctx) == LT_IMPL_TREZOR) ? LT_IMPL_TREZOR : sel];
+}
+
+int lt_aesgcm_init_and_key(void *ctx, const uint8_t *key, uint32_t key_len)
+{
+    uint8_t sel = __atomic_load_n(&lt_aesgcm_sel, __ATOMIC_RELAXED);
+
+    *lt_aesgcm_ctx_tag(ctx) = sel;
+    return lt_aesgcm_impls[sel].init_and_key(ctx, key, key_len);
+}
+
+int lt_aesgcm_encrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, uint8_t *tag, uint32_t tag_len)
+{
+    return lt_aesgcm_ctx_impl(ctx)->encrypt(ctx, iv, iv_len, aad, aad_len, msg, msg_len, tag, tag_len);
+}
+
+int lt_aesgcm_decrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, const uint8_t *tag, uint32_t tag_len)
+{
+    return lt_aesgcm_ctx_impl(ctx)->decrypt(ctx, iv, iv_len, aad, aad_len, msg, msg_len, tag, tag_len);
+}
+
+int lt_aesgcm_decrypt_start(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len)
+{
+    return lt_aesgcm_ctx_impl(ctx)->decrypt_start(ctx, iv, iv_len, aad, aad_len);
+}
+
+int lt_aesgcm_decrypt_update(void *ctx, uint8_t *msg, uint32_t msg_len)
+{
+    return lt_aesgcm_ctx_impl(ctx)->decrypt_update(ctx, msg, msg_len);
+}
+
+int lt_aesgcm_decrypt_finish(void *ctx, const uint8_t *tag, uint32_t tag_len)
+{
+    return lt_aesgcm_ctx_impl(ctx)->decrypt_finish(ctx, tag, tag_len);
+}
+
+int lt_aesgcm_end(void *ctx) { return lt_aesgcm_ctx_impl(ctx)->end(ctx); }
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file lt_crypto_mbedtls_aesgcm.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#ifdef USE_MBEDTLS
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "lt_aesgcm.h"
+#include "mbedtls/gcm.h"
+
+// Has to fit into space reserved in lt_l3_state_t
+STATIC_ASSERT(sizeof(mbedtls_gcm_context) <= LT_AESGCM_CTX_SIZE)
+
+// Context is expected to be zeroed (handle is zero-initialized) or already keyed, in both cases
+// mbedtls_gcm_setkey() releases the previous key.
+int lt_aesgcm_init_and_key(void *ctx, const uint8_t *key, uint32_t key_len)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+
+    int ret = mbedtls_gcm_setkey(_ctx, MBEDTLS_CIPHER_ID_AES, key, key_len * 8);
+    if (ret != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_encrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, uint8_t *tag, uint32_t tag_len)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+
+    int ret = mbedtls_gcm_crypt_and_tag(_ctx, MBEDTLS_GCM_ENCRYPT, msg_len, iv, iv_len, aad, aad_len, msg, msg,
+                                        tag_len, tag);
+    if (ret != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, const uint8_t *tag, uint32_t tag_len)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+
+    int ret = mbedtls_gcm_auth_decrypt(_ctx, msg_len, iv, iv_len, aad, aad_len, tag, tag_len, msg, msg);
+    if (ret != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt_start(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+
+    int ret = mbedtls_gcm_starts(_ctx, MBEDTLS_GCM_DECRYPT, iv, iv_len);
+    if (ret != 0) {
+        return LT_FAIL;
+    }
+
+    ret = mbedtls_gcm_update_ad(_ctx, aad, aad_len);
+    if (ret != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt_update(void *ctx, uint8_t *msg, uint32_t msg_len)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+    size_t out_len = 0;
+
+    int ret = mbedtls_gcm_update(_ctx, msg, msg_len, msg, msg_len, &out_len);
+    // Decryption is done in place, so implementations delaying output are not supported
+    if ((ret != 0) || (out_len != msg_len)) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt_finish(void *ctx, const uint8_t *tag, uint32_t tag_len)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+    uint8_t computed[16];
+    uint8_t diff = 0;
+    size_t out_len = 0;
+
+    if (tag_len > sizeof(computed)) {
+        return LT_FAIL;
+    }
+
+    int ret = mbedtls_gcm_finish(_ctx, NULL, 0, &out_len, computed, tag_len);
+    if ((ret != 0) || (out_len != 0)) {
+        return LT_FAIL;
+    }
+
+    // Compare in constant time
+    for (uint32_t i = 0; i < tag_len; i++) {
+        diff |= computed[i] ^ tag[i];
+    }
+    memset(computed, 0, sizeof(computed));
+
+    return (diff == 0) ? LT_OK : LT_FAIL;
+}
+
+int lt_aesgcm_end(void *ctx)
+{
+    mbedtls_gcm_context *_ctx = (mbedtls_gcm_context *)ctx;
+    mbedtls_gcm_free(_ctx);
+
+    return LT_OK;
+}
+
+#endif
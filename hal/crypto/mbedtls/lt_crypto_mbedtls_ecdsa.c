@@ -0,0 +1,44 @@
+/**
+ * @file lt_crypto_mbedtls_ecdsa.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#ifdef USE_MBEDTLS
+#include <stdint.h>
+#include <string.h>
+
+#include "lt_ecdsa.h"
+#include "psa/crypto.h"
+
+int lt_ecdsa_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
+{
+    psa_status_t status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        return 1;
+    }
+
+    // Prepare pubkey with 0x04 prefix
+    uint8_t pubkey_with_prefix[65];
+    pubkey_with_prefix[0] = 0x04;
+    memcpy(&pubkey_with_prefix[1], pubkey, 64);
+
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_type(&attr, PSA_KEY_TYPE_ECC_PUBLIC_KEY(PSA_ECC_FAMILY_SECP_R1));
+    psa_set_key_bits(&attr, 256);
+    psa_set_key_usage_flags(&attr, PSA_KEY_USAGE_VERIFY_MESSAGE);
+    psa_set_key_algorithm(&attr, PSA_ALG_ECDSA(PSA_ALG_SHA_256));
+
+    psa_key_id_t key_id = PSA_KEY_ID_NULL;
+    status = psa_import_key(&attr, pubkey_with_prefix, sizeof(pubkey_with_prefix), &key_id);
+    if (status == PSA_SUCCESS) {
+        // Signature is r||s, the same as PSA uses
+        status = psa_verify_message(key_id, PSA_ALG_ECDSA(PSA_ALG_SHA_256), msg, msg_len, rs, 64);
+    }
+    psa_destroy_key(key_id);
+
+    return (status == PSA_SUCCESS) ? 0 : 1;
+}
+
+#endif
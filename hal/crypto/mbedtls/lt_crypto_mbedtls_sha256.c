@@ -0,0 +1,79 @@
+/**
+ * @file lt_crypto_mbedtls_sha256.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#ifdef USE_MBEDTLS
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_macros.h"
+#include "lt_hmac_sha256.h"
+#include "lt_sha256.h"
+#include "mbedtls/md.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/sha256.h"
+
+void lt_sha256_init(void *ctx)
+{
+    mbedtls_sha256_context *_ctx = (mbedtls_sha256_context *)ctx;
+    mbedtls_sha256_init(_ctx);
+}
+
+void lt_sha256_start(void *ctx)
+{
+    mbedtls_sha256_context *_ctx = (mbedtls_sha256_context *)ctx;
+    // Context is freed by lt_sha256_finish(), so it has to be initialized again
+    mbedtls_sha256_init(_ctx);
+    int ret_unused = mbedtls_sha256_starts(_ctx, 0);
+    UNUSED(ret_unused);  // Fails only on bad parameters
+}
+
+void lt_sha256_update(void *ctx, const uint8_t *input, size_t len)
+{
+    mbedtls_sha256_context *_ctx = (mbedtls_sha256_context *)ctx;
+    int ret_unused = mbedtls_sha256_update(_ctx, input, len);
+    UNUSED(ret_unused);
+}
+
+void lt_sha256_finish(void *ctx, uint8_t *output)
+{
+    mbedtls_sha256_context *_ctx = (mbedtls_sha256_context *)ctx;
+    int ret_unused = mbedtls_sha256_finish(_ctx, output);
+    UNUSED(ret_unused);
+    mbedtls_sha256_free(_ctx);
+}
+
+void lt_hmac_sha256(const uint8_t *key, size_t keylen, const uint8_t *input, size_t ilen, uint8_t *output)
+{
+    int ret = mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), key, keylen, input, ilen, output);
+    if (ret != 0) {
+        // Make the failure visible to whatever gets compared with the output
+        memset(output, 0, 32);
+    }
+}
+
+// mbedtls_md_context_t allocates the key pads on the heap, so the context keeps the key (hashed when longer than
+// a block, as HMAC does) and every computation processes it again.
+void lt_hmac_sha256_init(struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t keylen)
+{
+    if (keylen > sizeof(ctx->key)) {
+        int ret = mbedtls_sha256(key, keylen, ctx->key, 0);
+        UNUSED(ret);
+        ctx->key_len = 32;
+    }
+    else {
+        memcpy(ctx->key, key, keylen);
+        ctx->key_len = keylen;
+    }
+}
+
+void lt_hmac_sha256_compute(const struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *input, size_t ilen,
+                            uint8_t *output)
+{
+    lt_hmac_sha256(ctx->key, ctx->key_len, input, ilen, output);
+}
+
+#endif
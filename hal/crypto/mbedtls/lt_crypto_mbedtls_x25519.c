@@ -0,0 +1,67 @@
+/**
+ * @file lt_crypto_mbedtls_x25519.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#ifdef USE_MBEDTLS
+#include <stdint.h>
+#include <string.h>
+
+#include "lt_x25519.h"
+#include "psa/crypto.h"
+
+/** Imports X25519 private key into PSA key store */
+static psa_status_t lt_x25519_import(const uint8_t *priv, psa_key_usage_t usage, psa_key_id_t *key_id)
+{
+    psa_status_t status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_type(&attr, PSA_KEY_TYPE_ECC_KEY_PAIR(PSA_ECC_FAMILY_MONTGOMERY));
+    psa_set_key_bits(&attr, 255);
+    psa_set_key_usage_flags(&attr, usage);
+    psa_set_key_algorithm(&attr, PSA_ALG_ECDH);
+
+    return psa_import_key(&attr, priv, 32, key_id);
+}
+
+void lt_X25519(const uint8_t *priv, const uint8_t *pub, uint8_t *secret)
+{
+    psa_key_id_t key_id = PSA_KEY_ID_NULL;
+    size_t secret_len = 0;
+
+    psa_status_t status = lt_x25519_import(priv, PSA_KEY_USAGE_DERIVE, &key_id);
+    if (status == PSA_SUCCESS) {
+        status = psa_raw_key_agreement(PSA_ALG_ECDH, key_id, pub, 32, secret, 32, &secret_len);
+    }
+    psa_destroy_key(key_id);
+
+    // Session keys derived from zeroes will not authenticate the handshake, so the error is detected there
+    if ((status != PSA_SUCCESS) || (secret_len != 32)) {
+        memset(secret, 0, 32);
+    }
+}
+
+// mbedtls has no fixed-base multiplication for Curve25519, the public key is computed by the Montgomery ladder. Use
+// LT_EPHEMERAL_KEY_POOL to take it out of the session start when the host is slow.
+void lt_X25519_scalarmult(const uint8_t *sk, uint8_t *pk)
+{
+    psa_key_id_t key_id = PSA_KEY_ID_NULL;
+    size_t pk_len = 0;
+
+    psa_status_t status = lt_x25519_import(sk, 0, &key_id);
+    if (status == PSA_SUCCESS) {
+        status = psa_export_public_key(key_id, pk, 32, &pk_len);
+    }
+    psa_destroy_key(key_id);
+
+    if ((status != PSA_SUCCESS) || (pk_len != 32)) {
+        memset(pk, 0, 32);
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef LT_CRYPTO_STM32_H
+#define LT_CRYPTO_STM32_H
+
+/**
+ * @file lt_crypto_stm32.h
+ * @author Tropic Square s.r.o.
+ * @brief Common part of the backend using crypto peripherals of STM32
+ *
+ * The peripherals are programmed through their registers (CMSIS device header included by the HAL header), PKA
+ * through the HAL. Their clocks are enabled on the first use. Each call holds the peripheral for its duration and
+ * keeps the state of an unfinished computation in the context passed by libtropic, so handles of several chips
+ * may interleave their computations. Handles used from several FreeRTOS tasks need `LT_STM32_FREERTOS` defined to 1,
+ * each peripheral is then locked by its own mutex.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+/** @brief HAL header of the STM32 family, it has to define CRYP and HASH (or PKA) */
+#ifndef LT_STM32_HAL_HEADER
+#define LT_STM32_HAL_HEADER "stm32f4xx_hal.h"
+#endif
+#include LT_STM32_HAL_HEADER
+
+#ifndef LT_STM32_FREERTOS
+#define LT_STM32_FREERTOS 0
+#endif
+
+#if LT_STM32_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#endif
+
+/** @brief Number of polls of a status flag before the operation fails, a block takes a few dozens of cycles */
+#ifndef LT_CRYPTO_STM32_POLLS
+#define LT_CRYPTO_STM32_POLLS 100000
+#endif
+
+/** @brief Lock of one peripheral */
+typedef struct lt_crypto_stm32_lock_t {
+#if LT_STM32_FREERTOS
+    SemaphoreHandle_t mutex;
+    StaticSemaphore_t buf;
+#endif
+    /** Nonzero once the clock of the peripheral was enabled */
+    volatile uint8_t clock_on;
+} lt_crypto_stm32_lock_t;
+
+/** @brief Takes the peripheral, returns nonzero when the clock has to be enabled by the caller */
+static inline int lt_crypto_stm32_take(lt_crypto_stm32_lock_t *lock)
+{
+#if LT_STM32_FREERTOS
+    if (!lock->mutex) {
+        // Mutex is created on the first use, tasks may already run then
+        taskENTER_CRITICAL();
+        if (!lock->mutex) {
+            lock->mutex = xSemaphoreCreateMutexStatic(&lock->buf);
+        }
+        taskEXIT_CRITICAL();
+    }
+    xSemaphoreTake(lock->mutex, portMAX_DELAY);
+#endif
+    if (!lock->clock_on) {
+        lock->clock_on = 1;
+        return 1;
+    }
+    return 0;
+}
+
+/** @brief Releases the peripheral */
+static inline void lt_crypto_stm32_give(lt_crypto_stm32_lock_t *lock)
+{
+#if LT_STM32_FREERTOS
+    xSemaphoreGive(lock->mutex);
+#else
+    (void)lock;
+#endif
+}
+
+/** @brief Loads big endian word */
+static inline uint32_t lt_crypto_stm32_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/** @brief Stores big endian word */
+static inline void lt_crypto_stm32_put_be32(uint8_t *p, const uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+#endif
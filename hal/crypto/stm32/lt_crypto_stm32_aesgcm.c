@@ -0,0 +1,613 @@
+/**
+ * @file lt_crypto_stm32_aesgcm.c
+ * @author Tropic Square s.r.o.
+ * @brief AES-GCM using CRYP peripheral of STM32F4/F7 (e.g. STM32F439)
+ *
+ * Full blocks are processed by the GCM mode of CRYP, fed by DMA when there are at least LT_CRYPTO_STM32_DMA_MIN
+ * bytes of them. GCM of CRYP computes the tag over the input blocks, so only the decryption of a zero padded
+ * partial block is correct. A partial block is therefore encrypted by a keystream block computed in ECB mode and
+ * its ciphertext is passed through GCM in decryption direction, the output is dropped. Streamed decryption keeps
+ * the GCM state of CRYP saved by context swapping in the context between the calls, so the part of a block at the
+ * end of a chunk is decrypted by the keystream too and its ciphertext completed by the next chunk.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_CRYPTO_STM32
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "lt_aesgcm.h"
+#include "lt_crypto_stm32.h"
+#include "memzero.h"
+
+/** @brief Payloads with at least as many bytes of full blocks are moved by DMA, 0 disables DMA */
+#ifndef LT_CRYPTO_STM32_DMA_MIN
+#define LT_CRYPTO_STM32_DMA_MIN 128
+#endif
+/** @brief DMA streams and channel of CRYP (DMA2 stream 6 CRYP_IN, stream 5 CRYP_OUT, channel 2 on F4/F7) */
+#ifndef LT_CRYPTO_STM32_DMA_IN_STREAM
+#define LT_CRYPTO_STM32_DMA_IN_STREAM 6
+#endif
+#ifndef LT_CRYPTO_STM32_DMA_OUT_STREAM
+#define LT_CRYPTO_STM32_DMA_OUT_STREAM 5
+#endif
+#ifndef LT_CRYPTO_STM32_DMA_CHANNEL
+#define LT_CRYPTO_STM32_DMA_CHANNEL 2
+#endif
+
+// CRYP registers (RM0090, section 23.6)
+#define LT_CRYP_CR_ALGODIR (1u << 2)
+#define LT_CRYP_CR_ALGOMODE ((7u << 3) | (1u << 19))
+#define LT_CRYP_CR_ALGOMODE_ECB (4u << 3)
+#define LT_CRYP_CR_ALGOMODE_GCM (1u << 19)
+#define LT_CRYP_CR_DATATYPE_BYTE (2u << 6)
+#define LT_CRYP_CR_KEYSIZE_POS 8
+#define LT_CRYP_CR_FFLUSH (1u << 14)
+#define LT_CRYP_CR_CRYPEN (1u << 15)
+#define LT_CRYP_CR_PHASE (3u << 16)
+#define LT_CRYP_CR_PHASE_HEADER (1u << 16)
+#define LT_CRYP_CR_PHASE_PAYLOAD (2u << 16)
+#define LT_CRYP_CR_PHASE_FINAL (3u << 16)
+#define LT_CRYP_SR_IFEM (1u << 0)
+#define LT_CRYP_SR_IFNF (1u << 1)
+#define LT_CRYP_SR_OFNE (1u << 2)
+#define LT_CRYP_SR_BUSY (1u << 4)
+#define LT_CRYP_DMACR_DIEN (1u << 0)
+#define LT_CRYP_DMACR_DOEN (1u << 1)
+/** Data input register, its name differs among CMSIS headers */
+#define LT_CRYP_DIN (*(volatile uint32_t *)(CRYP_BASE + 0x08u))
+
+// DMA stream registers (RM0090, section 10.5)
+#define LT_DMA_CR_EN (1u << 0)
+#define LT_DMA_CR_DIR_M2P (1u << 6)
+#define LT_DMA_CR_MINC (1u << 10)
+#define LT_DMA_CR_PSIZE_WORD (2u << 11)
+#define LT_DMA_CR_CHSEL_POS 25
+#define LT_DMA_FCR_FTH_FULL (3u << 0)
+#define LT_DMA_FCR_DMDIS (1u << 2)
+/** FEIF, DMEIF, TEIF, HTIF and TCIF flags of a stream */
+#define LT_DMA_FLAGS 0x3Du
+#define LT_DMA_TEIF (1u << 3)
+
+#define LT_AES_BLOCK_SIZE 16
+/** Length of IV, which is followed by 32 bits counter in the counter block */
+#define LT_GCM_IV_SIZE 12
+/** Counter of the first block of payload, J0 has 1 */
+#define LT_GCM_CTR_FIRST 2
+
+/** Context stored in the space of `lt_l3_state_t.encrypt`/`decrypt` */
+typedef struct lt_aesgcm_stm32_ctx_t {
+    /** Key as loaded into CRYP_KxLR/RR, big endian words aligned to the end */
+    uint32_t key[8];
+    /** Key size and data type bits of CRYP_CR */
+    uint32_t cr;
+    /** Saved CRYP_CR, CRYP_IVxLR/RR, CRYP_CSGCMCCMxR and CRYP_CSGCMxR of unfinished streamed decryption */
+    uint32_t saved_cr;
+    uint32_t saved_iv[4];
+    uint32_t saved_ccm[8];
+    uint32_t saved_gcm[8];
+    uint8_t iv[LT_GCM_IV_SIZE];
+    /** Keystream and ciphertext of the partial block at the end of the last chunk */
+    uint8_t ks[LT_AES_BLOCK_SIZE];
+    uint8_t part[LT_AES_BLOCK_SIZE];
+    uint32_t aad_len;
+    uint32_t msg_len;
+    uint8_t key_words;
+    uint8_t part_len;
+} lt_aesgcm_stm32_ctx_t;
+
+// Has to fit into space reserved in lt_l3_state_t
+STATIC_ASSERT(sizeof(lt_aesgcm_stm32_ctx_t) <= LT_AESGCM_CTX_SIZE)
+
+static lt_crypto_stm32_lock_t lt_cryp_lock;
+
+static void lt_cryp_take(void)
+{
+    if (lt_crypto_stm32_take(&lt_cryp_lock)) {
+        __HAL_RCC_CRYP_CLK_ENABLE();
+#if LT_CRYPTO_STM32_DMA_MIN
+        __HAL_RCC_DMA2_CLK_ENABLE();
+#endif
+    }
+}
+
+static int lt_cryp_wait(const uint32_t mask, const uint32_t value)
+{
+    for (uint32_t i = 0; i < LT_CRYPTO_STM32_POLLS; i++) {
+        if ((CRYP->SR & mask) == value) {
+            return LT_OK;
+        }
+    }
+    return LT_FAIL;
+}
+
+/** Disables CRYP and programs the algorithm and the key */
+static void lt_cryp_setup(const lt_aesgcm_stm32_ctx_t *c, const uint32_t cr)
+{
+    CRYP->CR = 0;
+    CRYP->CR = c->cr | cr;
+    volatile uint32_t *k = &CRYP->K0LR;
+    for (uint8_t i = 8 - c->key_words; i < 8; i++) {
+        k[i] = c->key[i];
+    }
+    CRYP->CR |= LT_CRYP_CR_FFLUSH;
+}
+
+/** Changes the phase of GCM and the direction, the state of GCM is kept while CRYP is disabled */
+static void lt_cryp_phase(const uint32_t phase, const uint32_t dir)
+{
+    uint32_t cr = CRYP->CR;
+    CRYP->CR = cr & ~LT_CRYP_CR_CRYPEN;
+    CRYP->CR = (cr & ~(LT_CRYP_CR_PHASE | LT_CRYP_CR_ALGODIR)) | phase | dir | LT_CRYP_CR_CRYPEN;
+}
+
+/** Writes one block into the input FIFO of enabled CRYP */
+static int lt_cryp_write(const uint8_t *in)
+{
+    uint32_t w[4];
+
+    // Byte data type swaps the words, so they are loaded in the order of the bytes in memory
+    memcpy(w, in, sizeof(w));
+    for (int i = 0; i < 4; i++) {
+        if (lt_cryp_wait(LT_CRYP_SR_IFNF, LT_CRYP_SR_IFNF) != LT_OK) {
+            return LT_FAIL;
+        }
+        LT_CRYP_DIN = w[i];
+    }
+
+    return LT_OK;
+}
+
+/** Processes one block by enabled CRYP, `out` may be NULL */
+static int lt_cryp_block(const uint8_t *in, uint8_t *out)
+{
+    uint32_t w[4];
+
+    if (lt_cryp_write(in) != LT_OK) {
+        return LT_FAIL;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (lt_cryp_wait(LT_CRYP_SR_OFNE, LT_CRYP_SR_OFNE) != LT_OK) {
+            return LT_FAIL;
+        }
+        w[i] = CRYP->DOUT;
+    }
+    if (out) {
+        memcpy(out, w, sizeof(w));
+    }
+
+    return LT_OK;
+}
+
+#if LT_CRYPTO_STM32_DMA_MIN
+#define LT_DMA_STREAM(n) ((DMA_Stream_TypeDef *)(DMA2_BASE + 0x10u + 0x18u * (n)))
+
+/** Position of the flags of a stream in DMA_LISR/HISR (streams 0-3/4-7) */
+static const uint8_t lt_dma_flags_shift[4] = {0, 6, 16, 22};
+
+static void lt_cryp_dma_clear(const uint32_t stream)
+{
+    uint32_t flags = LT_DMA_FLAGS << lt_dma_flags_shift[stream & 3];
+
+    if (stream < 4) {
+        DMA2->LIFCR = flags;
+    }
+    else {
+        DMA2->HIFCR = flags;
+    }
+}
+
+static uint32_t lt_cryp_dma_flags(const uint32_t stream)
+{
+    uint32_t isr = (stream < 4) ? DMA2->LISR : DMA2->HISR;
+
+    return (isr >> lt_dma_flags_shift[stream & 3]) & LT_DMA_FLAGS;
+}
+
+/** Moves data of the memory (bytes, any alignment) to/from CRYP (words) */
+static void lt_cryp_dma_start(const uint32_t stream, const uint32_t dir, volatile uint32_t *reg, const uint8_t *mem,
+                              const uint32_t words)
+{
+    DMA_Stream_TypeDef *s = LT_DMA_STREAM(stream);
+
+    s->CR = 0;
+    for (uint32_t i = 0; (s->CR & LT_DMA_CR_EN) && (i < LT_CRYPTO_STM32_POLLS); i++) {
+    }
+    lt_cryp_dma_clear(stream);
+    s->PAR = (uint32_t)(uintptr_t)reg;
+    s->M0AR = (uint32_t)(uintptr_t)mem;
+    s->NDTR = words;
+    // FIFO packs bytes of the memory into words of CRYP
+    s->FCR = LT_DMA_FCR_DMDIS | LT_DMA_FCR_FTH_FULL;
+    s->CR = ((uint32_t)LT_CRYPTO_STM32_DMA_CHANNEL << LT_DMA_CR_CHSEL_POS) | LT_DMA_CR_PSIZE_WORD | LT_DMA_CR_MINC
+            | dir;
+    s->CR |= LT_DMA_CR_EN;
+}
+
+static int lt_cryp_dma(const uint8_t *in, uint8_t *out, const uint32_t len)
+{
+    DMA_Stream_TypeDef *s_out = LT_DMA_STREAM(LT_CRYPTO_STM32_DMA_OUT_STREAM);
+
+    // Output stream runs first, so no output word is missed
+    lt_cryp_dma_start(LT_CRYPTO_STM32_DMA_OUT_STREAM, 0, &CRYP->DOUT, out, len / 4);
+    lt_cryp_dma_start(LT_CRYPTO_STM32_DMA_IN_STREAM, LT_DMA_CR_DIR_M2P, &LT_CRYP_DIN, in, len / 4);
+    CRYP->DMACR = LT_CRYP_DMACR_DIEN | LT_CRYP_DMACR_DOEN;
+
+    int ret = LT_FAIL;
+    // Stream disables itself when the transfer completes, a block takes about 30 cycles of the CPU
+    for (uint32_t i = 0; i < LT_CRYPTO_STM32_POLLS * (len / LT_AES_BLOCK_SIZE); i++) {
+        if (!(s_out->CR & LT_DMA_CR_EN)) {
+            ret = LT_OK;
+            break;
+        }
+    }
+    CRYP->DMACR = 0;
+    if ((ret != LT_OK) || (lt_cryp_dma_flags(LT_CRYPTO_STM32_DMA_OUT_STREAM) & LT_DMA_TEIF)
+        || (lt_cryp_dma_flags(LT_CRYPTO_STM32_DMA_IN_STREAM) & LT_DMA_TEIF)) {
+        LT_DMA_STREAM(LT_CRYPTO_STM32_DMA_IN_STREAM)->CR = 0;
+        s_out->CR = 0;
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+#endif
+
+/** Processes full blocks of payload in place */
+static int lt_cryp_payload(uint8_t *msg, const uint32_t len)
+{
+#if LT_CRYPTO_STM32_DMA_MIN
+    if (len >= LT_CRYPTO_STM32_DMA_MIN) {
+        return lt_cryp_dma(msg, msg, len);
+    }
+#endif
+    for (uint32_t i = 0; i < len; i += LT_AES_BLOCK_SIZE) {
+        if (lt_cryp_block(msg + i, msg + i) != LT_OK) {
+            return LT_FAIL;
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Computes keystream block of the payload block `index` in ECB mode, GCM state is overwritten */
+static int lt_cryp_keystream(const lt_aesgcm_stm32_ctx_t *c, const uint32_t index, uint8_t *ks)
+{
+    uint8_t ctr[LT_AES_BLOCK_SIZE];
+
+    memcpy(ctr, c->iv, LT_GCM_IV_SIZE);
+    lt_crypto_stm32_put_be32(ctr + LT_GCM_IV_SIZE, LT_GCM_CTR_FIRST + index);
+    lt_cryp_setup(c, LT_CRYP_CR_ALGOMODE_ECB);
+    CRYP->CR |= LT_CRYP_CR_CRYPEN;
+    int ret = lt_cryp_block(ctr, ks);
+    CRYP->CR = 0;
+
+    return ret;
+}
+
+/** Runs init and header phases of GCM, CRYP is left in payload phase in direction `dir` */
+static int lt_cryp_gcm_begin(lt_aesgcm_stm32_ctx_t *c, const uint8_t *iv, const uint32_t iv_len, const uint8_t *aad,
+                             const uint32_t aad_len, const uint32_t dir)
+{
+    if ((iv_len != LT_GCM_IV_SIZE) || (aad_len && !aad)) {
+        return LT_FAIL;
+    }
+    memcpy(c->iv, iv, LT_GCM_IV_SIZE);
+    c->aad_len = aad_len;
+    c->msg_len = 0;
+    c->part_len = 0;
+
+    lt_cryp_setup(c, LT_CRYP_CR_ALGOMODE_GCM | dir);
+    CRYP->IV0LR = lt_crypto_stm32_be32(iv);
+    CRYP->IV0RR = lt_crypto_stm32_be32(iv + 4);
+    CRYP->IV1LR = lt_crypto_stm32_be32(iv + 8);
+    CRYP->IV1RR = LT_GCM_CTR_FIRST;
+    // Init phase computes the hash subkey, CRYPEN is cleared when it is done
+    CRYP->CR |= LT_CRYP_CR_CRYPEN;
+    for (uint32_t i = 0; CRYP->CR & LT_CRYP_CR_CRYPEN; i++) {
+        if (i == LT_CRYPTO_STM32_POLLS) {
+            return LT_FAIL;
+        }
+    }
+
+    if (aad_len) {
+        lt_cryp_phase(LT_CRYP_CR_PHASE_HEADER, 0);
+        for (uint32_t i = 0; i < aad_len; i += LT_AES_BLOCK_SIZE) {
+            uint8_t block[LT_AES_BLOCK_SIZE] = {0};
+            memcpy(block, aad + i, (aad_len - i < LT_AES_BLOCK_SIZE) ? aad_len - i : LT_AES_BLOCK_SIZE);
+            if (lt_cryp_write(block) != LT_OK) {
+                return LT_FAIL;
+            }
+        }
+        if (lt_cryp_wait(LT_CRYP_SR_IFEM | LT_CRYP_SR_BUSY, LT_CRYP_SR_IFEM) != LT_OK) {
+            return LT_FAIL;
+        }
+    }
+    lt_cryp_phase(LT_CRYP_CR_PHASE_PAYLOAD, dir);
+
+    return LT_OK;
+}
+
+/** Passes ciphertext of the last partial block through GCM in decryption direction, so the tag covers it */
+static int lt_cryp_gcm_part(const uint8_t *part, const uint8_t len)
+{
+    uint8_t block[LT_AES_BLOCK_SIZE] = {0};
+
+    memcpy(block, part, len);
+    lt_cryp_phase(LT_CRYP_CR_PHASE_PAYLOAD, LT_CRYP_CR_ALGODIR);
+
+    return lt_cryp_block(block, NULL);
+}
+
+/** Runs final phase of GCM and disables CRYP */
+static int lt_cryp_gcm_tag(const lt_aesgcm_stm32_ctx_t *c, uint8_t *tag)
+{
+    uint8_t lengths[LT_AES_BLOCK_SIZE] = {0};
+
+    if (lt_cryp_wait(LT_CRYP_SR_IFEM | LT_CRYP_SR_BUSY, LT_CRYP_SR_IFEM) != LT_OK) {
+        CRYP->CR = 0;
+        return LT_FAIL;
+    }
+    // Bit lengths of AAD and payload, 64 bits each
+    lt_crypto_stm32_put_be32(lengths + 4, c->aad_len * 8);
+    lt_crypto_stm32_put_be32(lengths + 12, c->msg_len * 8);
+    // ALGODIR has to be 0 in the final phase
+    lt_cryp_phase(LT_CRYP_CR_PHASE_FINAL, 0);
+    int ret = lt_cryp_block(lengths, tag);
+    CRYP->CR = 0;
+
+    return ret;
+}
+
+/** Saves GCM state of CRYP into the context and disables it */
+static int lt_cryp_save(lt_aesgcm_stm32_ctx_t *c)
+{
+    int ret = lt_cryp_wait(LT_CRYP_SR_IFEM | LT_CRYP_SR_BUSY, LT_CRYP_SR_IFEM);
+    CRYP->CR &= ~LT_CRYP_CR_CRYPEN;
+    c->saved_cr = CRYP->CR;
+
+    const volatile uint32_t *iv = &CRYP->IV0LR;
+    const volatile uint32_t *ccm = &CRYP->CSGCMCCM0R;
+    const volatile uint32_t *gcm = &CRYP->CSGCM0R;
+    for (int i = 0; i < 4; i++) {
+        c->saved_iv[i] = iv[i];
+    }
+    for (int i = 0; i < 8; i++) {
+        c->saved_ccm[i] = ccm[i];
+        c->saved_gcm[i] = gcm[i];
+    }
+    CRYP->CR = 0;
+
+    return ret;
+}
+
+/** Restores GCM state saved by `lt_cryp_save()` and enables CRYP */
+static void lt_cryp_restore(const lt_aesgcm_stm32_ctx_t *c)
+{
+    lt_cryp_setup(c, c->saved_cr & ~(LT_CRYP_CR_CRYPEN | LT_CRYP_CR_FFLUSH));
+
+    volatile uint32_t *ccm = &CRYP->CSGCMCCM0R;
+    volatile uint32_t *gcm = &CRYP->CSGCM0R;
+    volatile uint32_t *iv = &CRYP->IV0LR;
+    for (int i = 0; i < 8; i++) {
+        ccm[i] = c->saved_ccm[i];
+        gcm[i] = c->saved_gcm[i];
+    }
+    for (int i = 0; i < 4; i++) {
+        iv[i] = c->saved_iv[i];
+    }
+    CRYP->CR |= LT_CRYP_CR_CRYPEN;
+}
+
+static int lt_aesgcm_tag_check(const uint8_t *computed, const uint8_t *tag, const uint32_t tag_len)
+{
+    uint8_t diff = 0;
+
+    if ((tag_len == 0) || (tag_len > LT_AES_BLOCK_SIZE)) {
+        return LT_FAIL;
+    }
+    for (uint32_t i = 0; i < tag_len; i++) {
+        diff |= computed[i] ^ tag[i];
+    }
+
+    return diff ? LT_FAIL : LT_OK;
+}
+
+int lt_aesgcm_init_and_key(void *ctx, const uint8_t *key, uint32_t key_len)
+{
+    lt_aesgcm_stm32_ctx_t *c = (lt_aesgcm_stm32_ctx_t *)ctx;
+
+    if ((key_len != 16) && (key_len != 24) && (key_len != 32)) {
+        return LT_FAIL;
+    }
+    memset(c, 0, sizeof(*c));
+    c->key_words = (uint8_t)(key_len / 4);
+    for (uint8_t i = 0; i < c->key_words; i++) {
+        c->key[8 - c->key_words + i] = lt_crypto_stm32_be32(key + 4 * i);
+    }
+    c->cr = LT_CRYP_CR_DATATYPE_BYTE | ((key_len / 8 - 2) << LT_CRYP_CR_KEYSIZE_POS);
+
+    return LT_OK;
+}
+
+int lt_aesgcm_encrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, uint8_t *tag, uint32_t tag_len)
+{
+    lt_aesgcm_stm32_ctx_t *c = (lt_aesgcm_stm32_ctx_t *)ctx;
+    uint32_t full = msg_len & ~(uint32_t)(LT_AES_BLOCK_SIZE - 1);
+    uint8_t part_len = (uint8_t)(msg_len - full);
+    uint8_t computed[LT_AES_BLOCK_SIZE];
+
+    if ((tag_len == 0) || (tag_len > LT_AES_BLOCK_SIZE) || (iv_len != LT_GCM_IV_SIZE)) {
+        return LT_FAIL;
+    }
+
+    lt_cryp_take();
+    memcpy(c->iv, iv, LT_GCM_IV_SIZE);
+    // Keystream of the partial block is computed first, before GCM state is set up
+    int ret = part_len ? lt_cryp_keystream(c, full / LT_AES_BLOCK_SIZE, c->ks) : LT_OK;
+    if (ret == LT_OK) {
+        ret = lt_cryp_gcm_begin(c, iv, iv_len, aad, aad_len, 0);
+    }
+    if (ret == LT_OK) {
+        ret = lt_cryp_payload(msg, full);
+    }
+    if ((ret == LT_OK) && part_len) {
+        for (uint8_t i = 0; i < part_len; i++) {
+            msg[full + i] ^= c->ks[i];
+        }
+        ret = lt_cryp_gcm_part(msg + full, part_len);
+    }
+    c->msg_len = msg_len;
+    if (ret == LT_OK) {
+        ret = lt_cryp_gcm_tag(c, computed);
+    }
+    CRYP->CR = 0;
+    lt_crypto_stm32_give(&lt_cryp_lock);
+
+    if (ret == LT_OK) {
+        memcpy(tag, computed, tag_len);
+    }
+    memzero(c->ks, sizeof(c->ks));
+
+    return ret;
+}
+
+int lt_aesgcm_decrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
+                      uint32_t msg_len, const uint8_t *tag, uint32_t tag_len)
+{
+    lt_aesgcm_stm32_ctx_t *c = (lt_aesgcm_stm32_ctx_t *)ctx;
+    uint32_t full = msg_len & ~(uint32_t)(LT_AES_BLOCK_SIZE - 1);
+    uint8_t part_len = (uint8_t)(msg_len - full);
+    uint8_t computed[LT_AES_BLOCK_SIZE];
+
+    lt_cryp_take();
+    int ret = lt_cryp_gcm_begin(c, iv, iv_len, aad, aad_len, LT_CRYP_CR_ALGODIR);
+    if (ret == LT_OK) {
+        ret = lt_cryp_payload(msg, full);
+    }
+    if ((ret == LT_OK) && part_len) {
+        // Decryption of a zero padded block is correct for the valid bytes
+        uint8_t block[LT_AES_BLOCK_SIZE] = {0};
+        memcpy(block, msg + full, part_len);
+        ret = lt_cryp_block(block, block);
+        memcpy(msg + full, block, part_len);
+    }
+    c->msg_len = msg_len;
+    if (ret == LT_OK) {
+        ret = lt_cryp_gcm_tag(c, computed);
+    }
+    CRYP->CR = 0;
+    lt_crypto_stm32_give(&lt_cryp_lock);
+
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_aesgcm_tag_check(computed, tag, tag_len);
+}
+
+int lt_aesgcm_decrypt_start(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len)
+{
+    lt_aesgcm_stm32_ctx_t *c = (lt_aesgcm_stm32_ctx_t *)ctx;
+
+    lt_cryp_take();
+    int ret = lt_cryp_gcm_begin(c, iv, iv_len, aad, aad_len, LT_CRYP_CR_ALGODIR);
+    if (ret == LT_OK) {
+        ret = lt_cryp_save(c);
+    }
+    CRYP->CR = 0;
+    lt_crypto_stm32_give(&lt_cryp_lock);
+
+    return ret;
+}
+
+int lt_aesgcm_decrypt_update(void *ctx, uint8_t *msg, uint32_t msg_len)
+{
+    lt_aesgcm_stm32_ctx_t *c = (lt_aesgcm_stm32_ctx_t *)ctx;
+    uint32_t pos = 0;
+    bool restored = false;
+    int ret = LT_OK;
+
+    lt_cryp_take();
+    // Bytes completing the partial block of the last chunk use its keystream
+    if (c->part_len) {
+        while ((pos < msg_len) && (c->part_len < LT_AES_BLOCK_SIZE)) {
+            c->part[c->part_len] = msg[pos];
+            msg[pos++] ^= c->ks[c->part_len++];
+        }
+        if (c->part_len == LT_AES_BLOCK_SIZE) {
+            lt_cryp_restore(c);
+            restored = true;
+            ret = lt_cryp_block(c->part, NULL);
+            c->part_len = 0;
+        }
+    }
+
+    uint32_t full = (msg_len - pos) & ~(uint32_t)(LT_AES_BLOCK_SIZE - 1);
+    if ((ret == LT_OK) && full) {
+        if (!restored) {
+            lt_cryp_restore(c);
+            restored = true;
+        }
+        ret = lt_cryp_payload(msg + pos, full);
+        pos += full;
+    }
+    if (restored) {
+        int ret_save = lt_cryp_save(c);
+        if (ret == LT_OK) {
+            ret = ret_save;
+        }
+    }
+
+    if ((ret == LT_OK) && (pos < msg_len)) {
+        ret = lt_cryp_keystream(c, (c->msg_len + pos) / LT_AES_BLOCK_SIZE, c->ks);
+        while ((ret == LT_OK) && (pos < msg_len)) {
+            c->part[c->part_len] = msg[pos];
+            msg[pos++] ^= c->ks[c->part_len++];
+        }
+    }
+    CRYP->CR = 0;
+    lt_crypto_stm32_give(&lt_cryp_lock);
+    c->msg_len += msg_len;
+
+    return ret;
+}
+
+int lt_aesgcm_decrypt_finish(void *ctx, const uint8_t *tag, uint32_t tag_len)
+{
+    lt_aesgcm_stm32_ctx_t *c = (lt_aesgcm_stm32_ctx_t *)ctx;
+    uint8_t computed[LT_AES_BLOCK_SIZE];
+    int ret = LT_OK;
+
+    lt_cryp_take();
+    lt_cryp_restore(c);
+    if (c->part_len) {
+        ret = lt_cryp_gcm_part(c->part, c->part_len);
+        c->part_len = 0;
+    }
+    if (ret == LT_OK) {
+        ret = lt_cryp_gcm_tag(c, computed);
+    }
+    CRYP->CR = 0;
+    lt_crypto_stm32_give(&lt_cryp_lock);
+    memzero(c->ks, sizeof(c->ks));
+
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_aesgcm_tag_check(computed, tag, tag_len);
+}
+
+int lt_aesgcm_end(void *ctx)
+{
+    memzero(ctx, sizeof(lt_aesgcm_stm32_ctx_t));
+
+    return LT_OK;
+}
+#endif
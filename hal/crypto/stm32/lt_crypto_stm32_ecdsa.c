@@ -0,0 +1,184 @@
+/**
+ * @file lt_crypto_stm32_ecdsa.c
+ * @author Tropic Square s.r.o.
+ * @brief Verification of P-256 ECDSA signatures by PKA peripheral of STM32 (e.g. STM32L4+, STM32WB, STM32U5)
+ *
+ * Public key is checked to lie on the curve and r, s to be in range, as trezor_crypto does, then PKA verifies the
+ * signature of the SHA256 digest of the message. A prepared key is the public key checked once.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_CRYPTO_STM32_PKA
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "lt_crypto_stm32.h"
+#include "lt_ecdsa.h"
+#include "lt_sha256.h"
+
+/** @brief Timeout of one PKA operation in ms */
+#ifndef LT_CRYPTO_STM32_PKA_TIMEOUT_MS
+#define LT_CRYPTO_STM32_PKA_TIMEOUT_MS 1000
+#endif
+
+#define LT_P256_SIZE 32
+
+static const uint8_t lt_p256_p[LT_P256_SIZE] = {
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+/** |a|, a = -3 */
+static const uint8_t lt_p256_abs_a[] = {0x03};
+static const uint8_t lt_p256_b[LT_P256_SIZE] = {
+    0x5a, 0xc6, 0x35, 0xd8, 0xaa, 0x3a, 0x93, 0xe7, 0xb3, 0xeb, 0xbd, 0x55, 0x76, 0x98, 0x86, 0xbc,
+    0x65, 0x1d, 0x06, 0xb0, 0xcc, 0x53, 0xb0, 0xf6, 0x3b, 0xce, 0x3c, 0x3e, 0x27, 0xd2, 0x60, 0x4b};
+static const uint8_t lt_p256_gx[LT_P256_SIZE] = {
+    0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47, 0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+    0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0, 0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96};
+static const uint8_t lt_p256_gy[LT_P256_SIZE] = {
+    0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b, 0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+    0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce, 0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5};
+static const uint8_t lt_p256_n[LT_P256_SIZE] = {
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84, 0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51};
+
+static lt_crypto_stm32_lock_t lt_pka_lock;
+static PKA_HandleTypeDef lt_pka;
+/** Montgomery parameter of p for the check of points, computed on the first use */
+static uint32_t lt_pka_mont[LT_P256_SIZE / 4];
+
+static int lt_pka_take(void)
+{
+    if (lt_crypto_stm32_take(&lt_pka_lock)) {
+        __HAL_RCC_PKA_CLK_ENABLE();
+        lt_pka.Instance = PKA;
+        PKA_MontgomeryParamInTypeDef in = {.size = LT_P256_SIZE, .pOp1 = lt_p256_p};
+        if ((HAL_PKA_Init(&lt_pka) != HAL_OK)
+            || (HAL_PKA_MontgomeryParam(&lt_pka, &in, LT_CRYPTO_STM32_PKA_TIMEOUT_MS) != HAL_OK)) {
+            // Initialized again by the next call
+            lt_pka_lock.clock_on = 0;
+            lt_crypto_stm32_give(&lt_pka_lock);
+            return LT_FAIL;
+        }
+        HAL_PKA_MontgomeryParam_GetResult(&lt_pka, lt_pka_mont);
+    }
+    return LT_OK;
+}
+
+/** Returns nonzero when big endian number `x` is in range 0 < x < n */
+static int lt_p256_in_range(const uint8_t *x)
+{
+    uint8_t nonzero = 0;
+
+    for (int i = 0; i < LT_P256_SIZE; i++) {
+        nonzero |= x[i];
+    }
+
+    return nonzero && (memcmp(x, lt_p256_n, LT_P256_SIZE) < 0);
+}
+
+/** Checks that public key `x || y` lies on the curve, PKA has to be taken */
+static int lt_pka_point_check(const uint8_t *pubkey)
+{
+    PKA_PointCheckInTypeDef in = {.modulusSize = LT_P256_SIZE,
+                                  .coefSign = 1,
+                                  .coefA = lt_p256_abs_a,
+                                  .coefB = lt_p256_b,
+                                  .modulus = lt_p256_p,
+                                  .pointX = pubkey,
+                                  .pointY = pubkey + LT_P256_SIZE,
+                                  .pMontgomeryParam = lt_pka_mont};
+
+    if (HAL_PKA_PointCheck(&lt_pka, &in, LT_CRYPTO_STM32_PKA_TIMEOUT_MS) != HAL_OK) {
+        return LT_FAIL;
+    }
+
+    return HAL_PKA_PointCheck_IsOnCurve(&lt_pka) ? LT_OK : LT_FAIL;
+}
+
+/** Verifies signature `rs` of the digest, PKA has to be taken */
+static int lt_pka_verify(const uint8_t *pubkey, const uint8_t *digest, const uint8_t *rs)
+{
+    PKA_ECDSAVerifInTypeDef in = {.primeOrderSize = LT_P256_SIZE,
+                                  .modulusSize = LT_P256_SIZE,
+                                  .coefSign = 1,
+                                  .coef = lt_p256_abs_a,
+                                  .modulus = lt_p256_p,
+                                  .basePointX = lt_p256_gx,
+                                  .basePointY = lt_p256_gy,
+                                  .pPubKeyCurvePtX = pubkey,
+                                  .pPubKeyCurvePtY = pubkey + LT_P256_SIZE,
+                                  .RSign = rs,
+                                  .SSign = rs + LT_P256_SIZE,
+                                  .hash = digest,
+                                  .primeOrder = lt_p256_n};
+
+    if (HAL_PKA_ECDSAVerif(&lt_pka, &in, LT_CRYPTO_STM32_PKA_TIMEOUT_MS) != HAL_OK) {
+        return LT_FAIL;
+    }
+
+    return HAL_PKA_ECDSAVerif_IsValidSignature(&lt_pka) ? LT_OK : LT_FAIL;
+}
+
+static int lt_ecdsa_verify_checked(const uint8_t *pubkey, const bool check_point, const uint8_t *msg,
+                                   const uint32_t msg_len, const uint8_t *rs)
+{
+    struct lt_crypto_sha256_ctx_t sha;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    uint8_t nonzero = 0;
+
+    if (!lt_p256_in_range(rs) || !lt_p256_in_range(rs + LT_P256_SIZE)) {
+        return 1;
+    }
+    lt_sha256_init(&sha);
+    lt_sha256_start(&sha);
+    lt_sha256_update(&sha, msg, msg_len);
+    lt_sha256_finish(&sha, digest);
+    // All-zero digest is rejected, as by ecdsa_verify_digest() of trezor_crypto
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        nonzero |= digest[i];
+    }
+    if (!nonzero) {
+        return 1;
+    }
+
+    if (lt_pka_take() != LT_OK) {
+        return 1;
+    }
+    int ret = (check_point && (lt_pka_point_check(pubkey) != LT_OK)) ? LT_FAIL : lt_pka_verify(pubkey, digest, rs);
+    lt_crypto_stm32_give(&lt_pka_lock);
+
+    return (ret == LT_OK) ? 0 : 1;
+}
+
+int lt_ecdsa_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
+{
+    return lt_ecdsa_verify_checked(pubkey, true, msg, msg_len, rs);
+}
+
+#if LT_PREPARED_KEYS
+int lt_ecdsa_prepare(void *prepared, const uint8_t *pubkey)
+{
+    if (lt_pka_take() != LT_OK) {
+        return 1;
+    }
+    int ret = lt_pka_point_check(pubkey);
+    lt_crypto_stm32_give(&lt_pka_lock);
+    if (ret != LT_OK) {
+        return 1;
+    }
+    memcpy(prepared, pubkey, 2 * LT_P256_SIZE);
+
+    return 0;
+}
+
+int lt_ecdsa_verify_prepared(const void *prepared, const uint8_t *msg, const uint32_t msg_len, const uint8_t *rs)
+{
+    return lt_ecdsa_verify_checked(prepared, false, msg, msg_len, rs);
+}
+#endif
+
+#endif
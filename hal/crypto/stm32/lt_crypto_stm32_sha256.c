@@ -0,0 +1,249 @@
+/**
+ * @file lt_crypto_stm32_sha256.c
+ * @author Tropic Square s.r.o.
+ * @brief SHA256 and HMAC SHA256 using HASH peripheral of STM32F4/F7 (e.g. STM32F439)
+ *
+ * HASH starts processing a block when the first word of the next one is written, so the context feeds whole blocks
+ * one word ahead and buffers the rest. The state of HASH is then saved into the context by context swapping, so
+ * several hashes may be computed at once. A message shorter than that is hashed in one go by
+ * `lt_sha256_finish()`. HMAC is computed over the hashes by HASH, the context keeps the padded key.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_CRYPTO_STM32
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_macros.h"
+#include "lt_crypto_stm32.h"
+#include "lt_hmac_sha256.h"
+#include "lt_sha256.h"
+#include "memzero.h"
+
+// HASH registers (RM0090, section 25.4)
+#define LT_HASH_CR_INIT (1u << 2)
+#define LT_HASH_CR_DATATYPE_BYTE (2u << 4)
+#define LT_HASH_CR_ALGO_SHA256 ((1u << 18) | (1u << 7))
+#define LT_HASH_STR_DCAL (1u << 8)
+#define LT_HASH_SR_DINIS (1u << 0)
+#define LT_HASH_SR_DCIS (1u << 1)
+#define LT_HASH_SR_BUSY (1u << 3)
+/** Number of context swap registers of SHA256 */
+#define LT_HASH_CSR_CNT 54
+
+#define LT_SHA256_BLOCK_SIZE 64
+/** HASH needs 17 words before it processes the first block */
+#define LT_SHA256_LEAD (LT_SHA256_BLOCK_SIZE + 4)
+
+/** Context stored in the space of `struct lt_crypto_sha256_ctx_t` */
+typedef struct lt_sha256_stm32_ctx_t {
+    /** Saved HASH_IMR, HASH_STR, HASH_CR and HASH_CSRx, valid once `started` */
+    uint32_t imr;
+    uint32_t str;
+    uint32_t cr;
+    uint32_t csr[LT_HASH_CSR_CNT];
+    /** Bytes not written to HASH yet */
+    uint8_t buf[LT_SHA256_LEAD];
+    uint8_t buf_len;
+    /** Nonzero once some data were written to HASH */
+    uint8_t started;
+    /** Nonzero when HASH did not respond, the digest is returned as zeros */
+    uint8_t failed;
+} lt_sha256_stm32_ctx_t;
+
+// Has to fit into space reserved by the handle
+STATIC_ASSERT(sizeof(lt_sha256_stm32_ctx_t) <= sizeof(struct lt_crypto_sha256_ctx_t))
+// Padded HMAC key
+STATIC_ASSERT(sizeof(((struct lt_hmac_sha256_ctx_t *)0)->space) == LT_SHA256_BLOCK_SIZE)
+
+static lt_crypto_stm32_lock_t lt_hash_lock;
+
+static void lt_hash_take(void)
+{
+    if (lt_crypto_stm32_take(&lt_hash_lock)) {
+        __HAL_RCC_HASH_CLK_ENABLE();
+    }
+}
+
+static int lt_hash_wait(const uint32_t mask, const uint32_t value)
+{
+    for (uint32_t i = 0; i < LT_CRYPTO_STM32_POLLS; i++) {
+        if ((HASH->SR & mask) == value) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/** Writes bytes to HASH, the last word may be partial */
+static void lt_hash_write(const uint8_t *data, const uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i += 4) {
+        uint32_t w = 0;
+        // Byte data type swaps the words, so they are loaded in the order of the bytes in memory
+        memcpy(&w, data + i, (len - i < 4) ? len - i : 4);
+        HASH->DIN = w;
+    }
+}
+
+/** Continues the hash of the context in HASH */
+static void lt_hash_resume(lt_sha256_stm32_ctx_t *c)
+{
+    if (!c->started) {
+        HASH->CR = LT_HASH_CR_DATATYPE_BYTE | LT_HASH_CR_ALGO_SHA256;
+        HASH->CR |= LT_HASH_CR_INIT;
+        c->started = 1;
+        return;
+    }
+    HASH->IMR = c->imr;
+    HASH->STR = c->str;
+    HASH->CR = c->cr;
+    HASH->CR |= LT_HASH_CR_INIT;
+    for (int i = 0; i < LT_HASH_CSR_CNT; i++) {
+        HASH->CSR[i] = c->csr[i];
+    }
+}
+
+/** Saves the state of HASH into the context once it can take the next block */
+static void lt_hash_suspend(lt_sha256_stm32_ctx_t *c)
+{
+    if (lt_hash_wait(LT_HASH_SR_DINIS | LT_HASH_SR_BUSY, LT_HASH_SR_DINIS)) {
+        c->failed = 1;
+    }
+    c->imr = HASH->IMR;
+    c->str = HASH->STR;
+    c->cr = HASH->CR & ~LT_HASH_CR_INIT;
+    for (int i = 0; i < LT_HASH_CSR_CNT; i++) {
+        c->csr[i] = HASH->CSR[i];
+    }
+}
+
+void lt_sha256_init(void *ctx)
+{
+    memset(ctx, 0, sizeof(lt_sha256_stm32_ctx_t));
+}
+
+void lt_sha256_start(void *ctx)
+{
+    lt_sha256_stm32_ctx_t *c = (lt_sha256_stm32_ctx_t *)ctx;
+
+    c->buf_len = 0;
+    c->started = 0;
+    c->failed = 0;
+}
+
+void lt_sha256_update(void *ctx, const uint8_t *input, size_t len)
+{
+    lt_sha256_stm32_ctx_t *c = (lt_sha256_stm32_ctx_t *)ctx;
+    uint32_t need = c->started ? LT_SHA256_BLOCK_SIZE : LT_SHA256_LEAD;
+    uint8_t resumed = 0;
+
+    while (len) {
+        uint32_t n = need - c->buf_len;
+        if (n > len) {
+            n = (uint32_t)len;
+        }
+        memcpy(c->buf + c->buf_len, input, n);
+        c->buf_len = (uint8_t)(c->buf_len + n);
+        input += n;
+        len -= n;
+        if (c->buf_len < need) {
+            break;
+        }
+
+        if (!resumed) {
+            lt_hash_take();
+            lt_hash_resume(c);
+            resumed = 1;
+        }
+        lt_hash_write(c->buf, need);
+        c->buf_len = 0;
+        need = LT_SHA256_BLOCK_SIZE;
+    }
+
+    if (resumed) {
+        lt_hash_suspend(c);
+        lt_crypto_stm32_give(&lt_hash_lock);
+    }
+}
+
+void lt_sha256_finish(void *ctx, uint8_t *output)
+{
+    lt_sha256_stm32_ctx_t *c = (lt_sha256_stm32_ctx_t *)ctx;
+
+    lt_hash_take();
+    lt_hash_resume(c);
+    lt_hash_write(c->buf, c->buf_len);
+    // Number of valid bits in the last word, 0 when it is whole
+    HASH->STR = 8u * (c->buf_len % 4u);
+    HASH->STR |= LT_HASH_STR_DCAL;
+    if (lt_hash_wait(LT_HASH_SR_DCIS | LT_HASH_SR_BUSY, LT_HASH_SR_DCIS)) {
+        c->failed = 1;
+    }
+    for (int i = 0; i < 8; i++) {
+        lt_crypto_stm32_put_be32(output + 4 * i, HASH_DIGEST->HR[i]);
+    }
+    lt_crypto_stm32_give(&lt_hash_lock);
+
+    if (c->failed) {
+        // Make the failure visible to whatever gets compared with the output
+        memset(output, 0, SHA256_DIGEST_LENGTH);
+    }
+    memzero(c, sizeof(*c));
+}
+
+void lt_hmac_sha256(const uint8_t *key, size_t keylen, const uint8_t *input, size_t ilen, uint8_t *output)
+{
+    struct lt_hmac_sha256_ctx_t ctx;
+
+    lt_hmac_sha256_init(&ctx, key, keylen);
+    lt_hmac_sha256_compute(&ctx, input, ilen, output);
+    memzero(&ctx, sizeof(ctx));
+}
+
+void lt_hmac_sha256_init(struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t keylen)
+{
+    // Key longer than a block is replaced by its hash, shorter one padded by zeros, as in HMAC
+    memset(ctx->space, 0, sizeof(ctx->space));
+    if (keylen > sizeof(ctx->space)) {
+        struct lt_crypto_sha256_ctx_t sha;
+        lt_sha256_init(&sha);
+        lt_sha256_start(&sha);
+        lt_sha256_update(&sha, key, keylen);
+        lt_sha256_finish(&sha, (uint8_t *)ctx->space);
+    }
+    else {
+        memcpy(ctx->space, key, keylen);
+    }
+}
+
+void lt_hmac_sha256_compute(const struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *input, size_t ilen,
+                            uint8_t *output)
+{
+    struct lt_crypto_sha256_ctx_t sha;
+    uint8_t pad[LT_SHA256_BLOCK_SIZE];
+    uint8_t inner[SHA256_DIGEST_LENGTH];
+    const uint8_t *key = (const uint8_t *)ctx->space;
+
+    for (int i = 0; i < LT_SHA256_BLOCK_SIZE; i++) {
+        pad[i] = key[i] ^ 0x36;
+    }
+    lt_sha256_init(&sha);
+    lt_sha256_start(&sha);
+    lt_sha256_update(&sha, pad, sizeof(pad));
+    lt_sha256_update(&sha, input, ilen);
+    lt_sha256_finish(&sha, inner);
+
+    for (int i = 0; i < LT_SHA256_BLOCK_SIZE; i++) {
+        pad[i] = key[i] ^ 0x5c;
+    }
+    lt_sha256_start(&sha);
+    lt_sha256_update(&sha, pad, sizeof(pad));
+    lt_sha256_update(&sha, inner, sizeof(inner));
+    lt_sha256_finish(&sha, output);
+
+    memzero(pad, sizeof(pad));
+    memzero(inner, sizeof(inner));
+}
+#endif
@@ -6,11 +6,21 @@
  */
 
 #ifdef LT_USE_TREZOR_CRYPTO
+#include <string.h>
+
+// Suffix of the functions linked together with other implementations, see lt_crypto_dispatch.h
+#define LT_CRYPTO_IMPL trezor
+
 #include "aes/aes.h"
 #include "aes/aesgcm.h"
 #include "libtropic_common.h"
+#include "libtropic_macros.h"
 #include "lt_aesgcm.h"
 
+// Has to fit into space reserved in lt_l3_state_t, GHASH tables enabled in trezor_crypto have to be reflected by
+// LT_AESGCM_GHASH_TABLES_SIZE
+STATIC_ASSERT(sizeof(gcm_ctx) <= LT_AESGCM_CTX_SIZE)
+
 int lt_aesgcm_init_and_key(void *ctx, const uint8_t *key, uint32_t key_len)
 {
     gcm_ctx *_ctx = (gcm_ctx *)ctx;
@@ -49,6 +59,59 @@ int lt_aesgcm_decrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8
     return LT_OK;
 }
 
+int lt_aesgcm_decrypt_start(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len)
+{
+    gcm_ctx *_ctx = (gcm_ctx *)ctx;
+
+    int ret = gcm_init_message(iv, iv_len, _ctx);
+    if (ret != RETURN_GOOD) {
+        return LT_FAIL;
+    }
+
+    ret = gcm_auth_header(aad, aad_len, _ctx);
+    if (ret != RETURN_GOOD) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt_update(void *ctx, uint8_t *msg, uint32_t msg_len)
+{
+    gcm_ctx *_ctx = (gcm_ctx *)ctx;
+
+    int ret = gcm_decrypt(msg, msg_len, _ctx);
+    if (ret != RETURN_GOOD) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+int lt_aesgcm_decrypt_finish(void *ctx, const uint8_t *tag, uint32_t tag_len)
+{
+    gcm_ctx *_ctx = (gcm_ctx *)ctx;
+    uint8_t computed[16];
+    uint8_t diff = 0;
+
+    if (tag_len > sizeof(computed)) {
+        return LT_FAIL;
+    }
+
+    int ret = gcm_compute_tag(computed, tag_len, _ctx);
+    if (ret != RETURN_GOOD) {
+        return LT_FAIL;
+    }
+
+    // Compare in constant time
+    for (uint32_t i = 0; i < tag_len; i++) {
+        diff |= computed[i] ^ tag[i];
+    }
+    memset(computed, 0, sizeof(computed));
+
+    return (diff == 0) ? LT_OK : LT_FAIL;
+}
+
 int lt_aesgcm_end(void *ctx)
 {
     gcm_ctx *_ctx = (gcm_ctx *)ctx;
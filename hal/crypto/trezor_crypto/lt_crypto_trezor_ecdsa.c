@@ -6,11 +6,14 @@
  */
 
 #ifdef LT_USE_TREZOR_CRYPTO
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "ecdsa.h"
 #include "hasher.h"
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
 #include "lt_ecdsa.h"
 #include "nist256p1.h"
 
@@ -24,4 +27,78 @@ int lt_ecdsa_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *p
     return ecdsa_verify(&nist256p1, HASHER_SHA2, pubkey_with_prefix, rs, msg, msg_len);
 }
 
+#if LT_PREPARED_KEYS
+// Prepared key is a copy of nist256p1 with the key Q in place of the generator: table cp[i][j] = (2j + 1) * 16^i * Q
+// lets scalar_multiply() compute u2 * Q by 64 additions, as it does u1 * G
+STATIC_ASSERT(sizeof(ecdsa_curve) <= LT_ECDSA_PREPARED_KEY_SIZE)
+
+int lt_ecdsa_prepare(void *prepared, const uint8_t *pubkey)
+{
+    uint8_t pubkey_with_prefix[65];
+    curve_point q, q2;
+
+    pubkey_with_prefix[0] = 0x04;
+    memcpy(&pubkey_with_prefix[1], pubkey, 64);
+    if (!ecdsa_read_pubkey(&nist256p1, pubkey_with_prefix, &q)) {
+        return 1;
+    }
+
+    memcpy(prepared, &nist256p1, offsetof(ecdsa_curve, cp));
+    ecdsa_curve *curve = prepared;
+    point_copy(&q, &curve->G);
+    // The table is const in ecdsa_curve, but this one is filled here
+    curve_point(*cp)[8] = (curve_point(*)[8])((uint8_t *)prepared + offsetof(ecdsa_curve, cp));
+
+    for (int i = 0; i < 64; i++) {
+        point_copy(&q, &q2);
+        point_double(&nist256p1, &q2);
+        point_copy(&q, &cp[i][0]);
+        for (int j = 1; j < 8; j++) {
+            point_copy(&cp[i][j - 1], &cp[i][j]);
+            point_add(&nist256p1, &q2, &cp[i][j]);
+        }
+        for (int k = 0; k < 4; k++) {
+            point_double(&nist256p1, &q);
+        }
+    }
+
+    return 0;
+}
+
+int lt_ecdsa_verify_prepared(const void *prepared, const uint8_t *msg, const uint32_t msg_len, const uint8_t *rs)
+{
+    const ecdsa_curve *curve_q = prepared;
+    uint8_t digest[32];
+    curve_point res, uq;
+    bignum256 r, s, z;
+
+    hasher_Raw(HASHER_SHA2, msg, msg_len, digest);
+    bn_read_be(rs, &r);
+    bn_read_be(rs + 32, &s);
+    bn_read_be(digest, &z);
+    // Checks of ecdsa_verify_digest(), including the all-zero digest
+    if (bn_is_zero(&r) || bn_is_zero(&s) || !bn_is_less(&r, &nist256p1.order) || !bn_is_less(&s, &nist256p1.order)
+        || bn_is_zero(&z)) {
+        return 1;
+    }
+
+    bn_inverse(&s, &nist256p1.order);       // s = s^-1
+    bn_multiply(&s, &z, &nist256p1.order);  // u1 = z * s^-1
+    bn_mod(&z, &nist256p1.order);
+    bn_multiply(&r, &s, &nist256p1.order);  // u2 = r * s^-1
+    bn_mod(&s, &nist256p1.order);
+
+    if (scalar_multiply(&nist256p1, &z, &res) || scalar_multiply(curve_q, &s, &uq)) {
+        return 1;
+    }
+    point_add(&nist256p1, &uq, &res);
+    if (point_is_infinity(&res)) {
+        return 1;
+    }
+
+    bn_mod(&res.x, &nist256p1.order);
+    return bn_is_equal(&res.x, &r) ? 0 : 1;
+}
+#endif
+
 #endif
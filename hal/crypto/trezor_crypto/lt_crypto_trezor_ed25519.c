@@ -7,13 +7,166 @@
 
 #ifdef LT_USE_TREZOR_CRYPTO
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "ed25519-donna/ed25519-donna.h"
+#include "ed25519-donna/ed25519-hash-custom.h"
 #include "ed25519-donna/ed25519.h"
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
 #include "lt_ed25519.h"
+#include "memzero.h"
 
 int lt_ed25519_sign_open(const uint8_t *msg, const uint16_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
 {
     return ed25519_sign_open(msg, msg_len, pubkey, rs);
 }
 
+/** Computes hram = H(R,A,m) and S of the signature, returns 0 when S is not reduced */
+static int lt_ed25519_scalars(const uint8_t *pubkey, const uint8_t *msg, const uint16_t msg_len, const uint8_t *rs,
+                              bignum256modm hram, bignum256modm S)
+{
+    if (rs[63] & 224) {
+        return 0;
+    }
+
+    hash_512bits hash;
+    ed25519_hash_context ctx;
+    ed25519_hash_init(&ctx);
+    ed25519_hash_update(&ctx, rs, 32);
+    ed25519_hash_update(&ctx, pubkey, 32);
+    ed25519_hash_update(&ctx, msg, msg_len);
+    ed25519_hash_final(&ctx, hash);
+
+    expand256_modm(hram, hash, 64);
+    expand_raw256_modm(S, rs + 32);
+
+    return is_reduced256_modm(S);
+}
+
+/** Same as ed25519_sign_open(), only with public key A already decompressed, returns 1 for valid signature */
+static int lt_ed25519_verify_unpacked(const ge25519 *A, const uint8_t *pubkey, const uint8_t *msg,
+                                      const uint16_t msg_len, const uint8_t *rs)
+{
+    bignum256modm hram, S;
+    if (!lt_ed25519_scalars(pubkey, msg, msg_len, rs, hram, S)) {
+        return 0;
+    }
+
+    // Check that R = SB - H(R,A,m)A
+    ge25519 ALIGN(16) R;
+    uint8_t checkR[32];
+    ge25519_double_scalarmult_vartime(&R, A, hram, S);
+    ge25519_pack(checkR, &R);
+
+    return ed25519_verify(rs, checkR, 32);
+}
+
+int lt_ed25519_sign_open_batch(const uint8_t *const *msgs, const uint16_t *msg_lens, const uint8_t *pubkey,
+                               const uint8_t *rs, const uint16_t n, uint8_t *valid)
+{
+    ge25519 ALIGN(16) A;
+    int key_ok = ge25519_unpack_negative_vartime(&A, pubkey);
+    int ret = 0;
+
+    for (uint16_t i = 0; i < n; i++) {
+        int ok = key_ok && lt_ed25519_verify_unpacked(&A, pubkey, msgs[i], msg_lens[i], rs + (i * 64));
+        if (valid) {
+            valid[i] = (uint8_t)ok;
+        }
+        if (!ok) {
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+#if LT_PREPARED_KEYS
+/** Window of sliding window multiplication by the prepared key, same as of the basepoint table of trezor_crypto */
+#define LT_ED25519_PREPARED_WINDOW 7
+#define LT_ED25519_PREPARED_TABLE_SIZE (1 << (LT_ED25519_PREPARED_WINDOW - 2))
+
+/** Placed into `lt_eddsa_prepared_key_t` */
+typedef struct lt_ed25519_prepared_t {
+    /** Odd multiples A, 3A, 5A, ... of decompressed negated key */
+    ge25519_pniels pre[LT_ED25519_PREPARED_TABLE_SIZE];
+    uint8_t pubkey[32];
+} lt_ed25519_prepared_t;
+
+STATIC_ASSERT(sizeof(lt_ed25519_prepared_t) <= LT_EDDSA_PREPARED_KEY_SIZE)
+
+int lt_ed25519_prepare(void *prepared, const uint8_t *pubkey)
+{
+    lt_ed25519_prepared_t *k = prepared;
+    ge25519 ALIGN(16) A, A2;
+
+    if (!ge25519_unpack_negative_vartime(&A, pubkey)) {
+        return 1;
+    }
+    memcpy(k->pubkey, pubkey, sizeof(k->pubkey));
+    ge25519_double(&A2, &A);
+    ge25519_full_to_pniels(&k->pre[0], &A);
+    for (int i = 0; i < LT_ED25519_PREPARED_TABLE_SIZE - 1; i++) {
+        ge25519_pnielsadd(&k->pre[i + 1], &A2, &k->pre[i]);
+    }
+
+    return 0;
+}
+
+/** r = s1 * A + s2 * B, ge25519_double_scalarmult_vartime() with the table of A prepared and a wider window */
+static void lt_ed25519_double_scalarmult_prepared(ge25519 *r, const lt_ed25519_prepared_t *k, const bignum256modm s1,
+                                                  const bignum256modm s2)
+{
+    signed char slide1[256], slide2[256];
+    ge25519_p1p1 t;
+    int i;
+
+    memzero(&t, sizeof(t));
+    contract256_slidingwindow_modm(slide1, s1, LT_ED25519_PREPARED_WINDOW);
+    contract256_slidingwindow_modm(slide2, s2, 7);  // ge25519_niels_sliding_multiples has 32 entries
+    ge25519_set_neutral(r);
+
+    i = 255;
+    while ((i >= 0) && !(slide1[i] | slide2[i])) {
+        i--;
+    }
+
+    for (; i >= 0; i--) {
+        ge25519_double_p1p1(&t, r);
+        if (slide1[i]) {
+            ge25519_p1p1_to_full(r, &t);
+            ge25519_pnielsadd_p1p1(&t, r, &k->pre[abs(slide1[i]) / 2], (unsigned char)slide1[i] >> 7);
+        }
+        if (slide2[i]) {
+            ge25519_p1p1_to_full(r, &t);
+            ge25519_nielsadd2_p1p1(&t, r, &ge25519_niels_sliding_multiples[abs(slide2[i]) / 2],
+                                   (unsigned char)slide2[i] >> 7);
+        }
+        ge25519_p1p1_to_partial(r, &t);
+    }
+    curve25519_mul(r->t, t.x, t.y);
+}
+
+int lt_ed25519_sign_open_prepared(const void *prepared, const uint8_t *msg, const uint16_t msg_len,
+                                  const uint8_t *rs)
+{
+    const lt_ed25519_prepared_t *k = prepared;
+    bignum256modm hram, S;
+
+    if (!lt_ed25519_scalars(k->pubkey, msg, msg_len, rs, hram, S)) {
+        return 1;
+    }
+
+    // Check that R = SB - H(R,A,m)A
+    ge25519 ALIGN(16) R;
+    uint8_t checkR[32];
+    lt_ed25519_double_scalarmult_prepared(&R, k, hram, S);
+    ge25519_pack(checkR, &R);
+
+    return ed25519_verify(rs, checkR, 32) ? 0 : 1;
+}
+#endif
+
 #endif
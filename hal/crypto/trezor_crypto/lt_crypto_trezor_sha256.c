@@ -13,6 +13,8 @@
 #include "hmac.h"
 #include "lt_hmac_sha256.h"
 #include "lt_sha256.h"
+#include "memzero.h"
+#include "sha2.h"
 
 void lt_sha256_init(void *ctx)
 {
@@ -42,4 +44,29 @@ void lt_hmac_sha256(const uint8_t *key, size_t keylen, const uint8_t *input, siz
 {
     hmac_sha256(key, keylen, input, ilen, output);
 }
+
+void lt_hmac_sha256_init(struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t keylen)
+{
+    // space[0..7] holds state after inner key pad, space[8..15] after outer key pad
+    hmac_sha256_prepare(key, keylen, &ctx->space[8], &ctx->space[0]);
+}
+
+void lt_hmac_sha256_compute(const struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *input, size_t ilen,
+                            uint8_t *output)
+{
+    SHA256_CTX sha = {0};
+    uint8_t inner[SHA256_DIGEST_LENGTH];
+
+    // Both pads were already processed, that is one block of SHA256
+    sha256_Init_ex(&sha, &ctx->space[0], 8 * SHA256_BLOCK_LENGTH);
+    sha256_Update(&sha, input, ilen);
+    sha256_Final(&sha, inner);
+
+    sha256_Init_ex(&sha, &ctx->space[8], 8 * SHA256_BLOCK_LENGTH);
+    sha256_Update(&sha, inner, SHA256_DIGEST_LENGTH);
+    sha256_Final(&sha, output);
+
+    memzero(inner, sizeof(inner));
+    memzero(&sha, sizeof(sha));
+}
 #endif
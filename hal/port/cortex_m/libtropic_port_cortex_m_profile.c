@@ -0,0 +1,44 @@
+/**
+ * @file libtropic_port_cortex_m_profile.c
+ * @author Tropic Square s.r.o.
+ * @brief Cycle counter of Cortex-M (DWT CYCCNT) for the profile of libtropic.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_cortex_m_profile.h"
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+// Registers are at the same addresses on all ARMv7-M and ARMv8-M cores, CMSIS of the MCU is not needed
+/** Debug Exception and Monitor Control Register */
+#define LT_DEMCR (*(volatile uint32_t *)(uintptr_t)0xE000EDFCu)
+/** Enables DWT and ITM in DEMCR */
+#define LT_DEMCR_TRCENA (1u << 24)
+/** DWT Control Register */
+#define LT_DWT_CTRL (*(volatile uint32_t *)(uintptr_t)0xE0001000u)
+/** Enables CYCCNT in DWT_CTRL */
+#define LT_DWT_CTRL_CYCCNTENA 0x1u
+/** Set in DWT_CTRL when the core has no cycle counter */
+#define LT_DWT_CTRL_NOCYCCNT (1u << 25)
+/** DWT Cycle Count Register */
+#define LT_DWT_CYCCNT (*(volatile uint32_t *)(uintptr_t)0xE0001004u)
+
+lt_ret_t lt_cortex_m_cycles_init(void)
+{
+    LT_DEMCR |= LT_DEMCR_TRCENA;
+    if (LT_DWT_CTRL & LT_DWT_CTRL_NOCYCCNT) {
+        return LT_FAIL;
+    }
+    LT_DWT_CYCCNT = 0;
+    LT_DWT_CTRL |= LT_DWT_CTRL_CYCCNTENA;
+
+    return LT_OK;
+}
+
+uint32_t lt_cortex_m_cycles(void)
+{
+    return LT_DWT_CYCCNT;
+}
@@ -0,0 +1,36 @@
+#ifndef LIBTROPIC_PORT_CORTEX_M_PROFILE_H
+#define LIBTROPIC_PORT_CORTEX_M_PROFILE_H
+
+/**
+ * @file libtropic_port_cortex_m_profile.h
+ * @author Tropic Square s.r.o.
+ * @brief Cycle counter of Cortex-M (DWT CYCCNT) for the profile of libtropic compiled with `LT_PROFILE`.
+ *
+ * Enable the counter by `lt_cortex_m_cycles_init()` once after reset, then pass `lt_cortex_m_cycles` to
+ * `lt_profile_init()` and print the profile by `lt_profile_dump()`. The counter wraps in 2^32 cycles (about 25 s at
+ * 168 MHz), which is far longer than any measured call. DWT with CYCCNT is present on Cortex-M3 and higher, on
+ * Cortex-M0/M0+ use a timer of the MCU instead.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/**
+ * @brief Enables trace in the debug unit and starts DWT cycle counter from zero.
+ *
+ * @retval            LT_OK Counter runs
+ * @retval            LT_FAIL The core has no cycle counter
+ */
+lt_ret_t lt_cortex_m_cycles_init(void);
+
+/**
+ * @brief Reads DWT cycle counter, cycle source for `lt_profile_init()`.
+ *
+ * @return            Number of core clock cycles since `lt_cortex_m_cycles_init()`, modulo 2^32
+ */
+uint32_t lt_cortex_m_cycles(void);
+
+#endif  // LIBTROPIC_PORT_CORTEX_M_PROFILE_H
@@ -0,0 +1,107 @@
+/**
+ * @file libtropic_port_cortex_m_trace.c
+ * @author Tropic Square s.r.o.
+ * @brief Sink streaming trace and deferred log messages over ARM ITM or SEGGER RTT.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_cortex_m_trace.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+#if LT_CORTEX_M_TRACE_RTT
+#include "SEGGER_RTT.h"
+#endif
+
+// ITM registers are at the same addresses on all ARMv7-M and ARMv8-M cores, CMSIS of the MCU is not needed
+/** Stimulus port `n`, reads 1 when its FIFO can take a write */
+#define LT_ITM_STIM(n) ((volatile uint32_t *)(uintptr_t)(0xE0000000u + (4u * (n))))
+/** Trace Enable Register, bit per stimulus port */
+#define LT_ITM_TER (*(volatile const uint32_t *)(uintptr_t)0xE0000E00u)
+/** Trace Control Register */
+#define LT_ITM_TCR (*(volatile const uint32_t *)(uintptr_t)0xE0000E80u)
+/** ITM is enabled in ITM_TCR */
+#define LT_ITM_TCR_ITMENA 0x1u
+
+/** Writes to ITM stimulus port, 32-bit writes produce one 4-byte packet instead of four 1-byte ones */
+static void lt_itm_write(const uint8_t port, const uint8_t *data, uint16_t len)
+{
+    volatile uint32_t *stim = LT_ITM_STIM(port);
+
+    while (len >= 4) {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        while (!(*stim & 1u)) {
+        }
+        *stim = word;
+        data += 4;
+        len -= 4;
+    }
+    while (len--) {
+        while (!(*stim & 1u)) {
+        }
+        *(volatile uint8_t *)stim = *data++;
+    }
+}
+
+/** Writes to the sink, returns false when the data were dropped */
+static bool lt_cortex_m_write(lt_cortex_m_trace_sink_t *sink, const uint8_t *data, const uint16_t len)
+{
+    if (sink->transport == LT_CORTEX_M_TRACE_ITM) {
+        // Without a debugger capturing SWO the FIFO would never drain
+        if (!(LT_ITM_TCR & LT_ITM_TCR_ITMENA) || (sink->channel > 31) || !(LT_ITM_TER & (1u << sink->channel))) {
+            return true;
+        }
+        lt_itm_write(sink->channel, data, len);
+        return true;
+    }
+#if LT_CORTEX_M_TRACE_RTT
+    if (sink->transport == LT_CORTEX_M_TRACE_RTT_UP) {
+        if (SEGGER_RTT_Write(sink->channel, data, len) == len) {
+            return true;
+        }
+    }
+#endif
+    sink->dropped++;
+
+    return false;
+}
+
+lt_ret_t lt_cortex_m_trace_write(void *ctx, const uint8_t *data, const uint16_t len)
+{
+    if (!ctx || (!data && len)) {
+        return LT_PARAM_ERR;
+    }
+
+    return lt_cortex_m_write((lt_cortex_m_trace_sink_t *)ctx, data, len) ? LT_OK : LT_FAIL;
+}
+
+#if LT_LOG_DEFERRED
+void lt_cortex_m_log_sink(void *ctx, const lt_log_level_t level, const uint16_t line, const char *msg)
+{
+    static const char letters[] = "??EWID";
+    char buf[LT_LOG_MSG_SIZE + 16];
+
+    if (!ctx || !msg) {
+        return;
+    }
+
+    int len = snprintf(buf, sizeof(buf), "%c %u %s\n", ((unsigned)level < sizeof(letters) - 1) ? letters[level] : '?', line,
+                       msg);
+    if (len <= 0) {
+        return;
+    }
+    if ((size_t)len >= sizeof(buf)) {
+        // Truncated message still ends the line
+        len = sizeof(buf) - 1;
+        buf[len - 1] = '\n';
+    }
+    lt_cortex_m_write((lt_cortex_m_trace_sink_t *)ctx, (const uint8_t *)buf, (uint16_t)len);
+}
+#endif
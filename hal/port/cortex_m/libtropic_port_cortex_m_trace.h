@@ -0,0 +1,75 @@
+#ifndef LIBTROPIC_PORT_CORTEX_M_TRACE_H
+#define LIBTROPIC_PORT_CORTEX_M_TRACE_H
+
+/**
+ * @file libtropic_port_cortex_m_trace.h
+ * @author Tropic Square s.r.o.
+ * @brief Sink streaming the trace ring (`LT_TRACE`) and deferred log messages (`LT_LOG_DEFERRED`) over ARM ITM
+ * stimulus ports or SEGGER RTT, decoded on the host by `scripts/mcu_trace_decode.py`.
+ *
+ * A write takes a few stores into the ITM FIFO or a copy into the RTT buffer in RAM, unlike printing over UART, so
+ * timing of the protocol is not distorted. Trace is streamed by calling `lt_trace_dump_new()` with
+ * `lt_cortex_m_trace_write()` periodically, e.g. from the idle task, log messages by `lt_log_init()` with
+ * `lt_cortex_m_log_sink()` and `lt_log_flush()`. Give the trace and the log different channels.
+ *
+ * ITM is used only when enabled by the debugger (ITM_TCR.ITMENA and the port in ITM_TER), otherwise the data are
+ * dropped, so the same firmware runs without a probe. It needs a core with ITM (Cortex-M3 and higher).
+ * RTT is compiled in with LT_CORTEX_M_TRACE_RTT defined to 1, the application then provides SEGGER RTT (SEGGER_RTT.h)
+ * and configures its up-buffers, preferably in SEGGER_RTT_MODE_NO_BLOCK_SKIP mode.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+#ifndef LT_CORTEX_M_TRACE_RTT
+#define LT_CORTEX_M_TRACE_RTT 0
+#endif
+
+/** @brief Transport of `lt_cortex_m_trace_sink_t` */
+typedef enum lt_cortex_m_trace_transport_t {
+    /** @brief ITM stimulus port, captured from SWO */
+    LT_CORTEX_M_TRACE_ITM = 0,
+    /** @brief SEGGER RTT up-buffer */
+    LT_CORTEX_M_TRACE_RTT_UP = 1
+} lt_cortex_m_trace_transport_t;
+
+/** @brief Destination of streamed data, `ctx` of the write functions */
+typedef struct lt_cortex_m_trace_sink_t {
+    /** @public @brief `lt_cortex_m_trace_transport_t` */
+    uint8_t transport;
+    /** @public @brief ITM stimulus port (0-31) or index of RTT up-buffer */
+    uint8_t channel;
+    /** @public @brief Number of writes dropped, e.g. because the RTT buffer was full, read only */
+    uint32_t dropped;
+} lt_cortex_m_trace_sink_t;
+
+/**
+ * @brief Writes a part of trace dump, `write` function for `lt_trace_dump_new()` and `lt_trace_dump()`.
+ *
+ * @param ctx         `lt_cortex_m_trace_sink_t`
+ * @param data        Data to be written
+ * @param len         Length of data
+ *
+ * @retval            LT_OK Data were written, or dropped because ITM is not enabled
+ * @retval            LT_FAIL RTT buffer has no space for the data, the events are written again by the next
+ *                    `lt_trace_dump_new()`
+ */
+lt_ret_t lt_cortex_m_trace_write(void *ctx, const uint8_t *data, const uint16_t len);
+
+#if LT_LOG_DEFERRED
+/**
+ * @brief Writes a formatted log message as one line `<level letter> <line> <message>`, sink for `lt_log_init()`.
+ *
+ * @param ctx         `lt_cortex_m_trace_sink_t`
+ * @param level       Level of the message
+ * @param line        Source line of the message
+ * @param msg         Message without the line break
+ */
+void lt_cortex_m_log_sink(void *ctx, const lt_log_level_t level, const uint16_t line, const char *msg);
+#endif
+
+#endif  // LIBTROPIC_PORT_CORTEX_M_TRACE_H
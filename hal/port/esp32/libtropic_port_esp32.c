@@ -0,0 +1,443 @@
+/**
+ * @file libtropic_port_esp32.c
+ * @author Tropic Square s.r.o.
+ * @brief Port for ESP32 (ESP-IDF 5) using queued DMA transactions of the SPI master driver.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_esp32.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+
+/** Default SPI clock */
+#define LT_ESP32_CLOCK_HZ_DEFAULT 5000000
+/** Shorter transfers (e.g. CHIP_STATUS polls) are polled, the interrupt and context switch cost more than they take */
+#define LT_ESP32_QUEUE_MIN_LEN 16
+/** Segments of a transaction are stored word aligned, so DMA uses them in place */
+#define LT_ESP32_ALIGN(len) (((len) + 3u) & ~3u)
+/** DMA buffer for all segments of the longest transaction */
+#define LT_ESP32_DMA_BUFF_LEN (LT_ESP32_ALIGN(LT_L1_LEN_MAX) + (4 * LT_L1_SPI_SEGMENTS_MAX))
+
+/** Rounds up, so the task does not wake before `ms` elapses (apart from the tick it was called in) */
+static TickType_t lt_port_ms_to_ticks(uint32_t ms)
+{
+    return (TickType_t)((((uint64_t)ms * configTICK_RATE_HZ) + 999) / 1000);
+}
+
+static void IRAM_ATTR lt_port_esp32_pre_cb(spi_transaction_t *t)
+{
+    const lt_esp32_trans_t *tr = t->user;
+
+    if (tr && tr->cs_low) {
+        gpio_set_level(tr->cs_io, 0);
+    }
+}
+
+static void IRAM_ATTR lt_port_esp32_post_cb(spi_transaction_t *t)
+{
+    const lt_esp32_trans_t *tr = t->user;
+
+    if (tr && tr->cs_high) {
+        gpio_set_level(tr->cs_io, 1);
+    }
+}
+
+#if LT_USE_INT_PIN
+static void IRAM_ATTR lt_port_esp32_int_isr(void *arg)
+{
+    lt_dev_esp32_t *device = arg;
+    BaseType_t woken = pdFALSE;
+
+    xSemaphoreGiveFromISR(device->int_sem, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+#endif
+
+static lt_ret_t lt_port_esp32_add_device(lt_dev_esp32_t *device)
+{
+    const spi_device_interface_config_t cfg = {
+        .mode = 0,
+        .clock_speed_hz = device->clock_hz ? device->clock_hz : LT_ESP32_CLOCK_HZ_DEFAULT,
+        // Chip select is driven by the callbacks
+        .spics_io_num = -1,
+        .queue_size = LT_L1_SPI_SEGMENTS_MAX,
+        .pre_cb = lt_port_esp32_pre_cb,
+        .post_cb = lt_port_esp32_post_cb,
+    };
+
+    esp_err_t err = spi_bus_add_device(device->host, &cfg, &device->spi);
+    if (err != ESP_OK) {
+        LT_LOG_ERROR("spi_bus_add_device failed: %s", esp_err_to_name(err));
+        device->spi = NULL;
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+/** Bus is held while chip select is low, so transactions of other devices on the bus do not come in between */
+static lt_ret_t lt_port_esp32_bus_take(lt_dev_esp32_t *device)
+{
+    if (!device->bus_held) {
+        if (spi_device_acquire_bus(device->spi, portMAX_DELAY) != ESP_OK) {
+            return LT_L1_SPI_ERROR;
+        }
+        device->bus_held = 1;
+    }
+
+    return LT_OK;
+}
+
+static void lt_port_esp32_bus_give(lt_dev_esp32_t *device)
+{
+    if (device->bus_held) {
+        spi_device_release_bus(device->spi);
+        device->bus_held = 0;
+    }
+}
+
+/** Prepares `trans[i]` for `len` bytes in `slice` of the DMA buffer, received bytes are stored in place unless `tx` */
+static void lt_port_esp32_trans(lt_dev_esp32_t *device, uint8_t i, uint8_t *slice, uint16_t len, const int tx)
+{
+    lt_esp32_trans_t *tr = &device->trans[i];
+
+    memset(tr, 0, sizeof(*tr));
+    tr->t.length = (size_t)len * 8;
+    tr->t.tx_buffer = slice;
+    tr->t.rx_buffer = tx ? NULL : slice;
+    tr->t.user = tr;
+    tr->cs_io = device->cs_io;
+}
+
+/** Queues `cnt` prepared transactions at once and waits for all their results */
+static lt_ret_t lt_port_esp32_run(lt_dev_esp32_t *device, uint8_t cnt, uint32_t timeout_ms)
+{
+    TickType_t ticks = lt_port_ms_to_ticks(timeout_ms);
+    esp_err_t err = ESP_OK;
+    uint8_t queued = 0;
+
+    for (; queued < cnt; queued++) {
+        err = spi_device_queue_trans(device->spi, &device->trans[queued].t, ticks);
+        if (err != ESP_OK) {
+            break;
+        }
+    }
+    // Results of the queued ones are collected also after an error, the queue has to be empty afterwards
+    for (uint8_t i = 0; i < queued; i++) {
+        spi_transaction_t *t;
+        esp_err_t res = spi_device_get_trans_result(device->spi, &t, ticks);
+        if (res != ESP_OK) {
+            err = res;
+            break;
+        }
+    }
+    if (err != ESP_OK) {
+        LT_LOG_ERROR("SPI transaction failed: %s", esp_err_to_name(err));
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+    esp_err_t err;
+
+    device->spi = NULL;
+    device->bus_held = 0;
+    device->dma_buff = heap_caps_malloc(LT_ESP32_DMA_BUFF_LEN, MALLOC_CAP_DMA);
+    if (!device->dma_buff) {
+        LT_LOG_ERROR("Can't allocate DMA buffer");
+        return LT_FAIL;
+    }
+
+    if (device->init_bus) {
+        const spi_bus_config_t bus_cfg = {
+            .mosi_io_num = device->mosi_io,
+            .miso_io_num = device->miso_io,
+            .sclk_io_num = device->sclk_io,
+            .quadwp_io_num = -1,
+            .quadhd_io_num = -1,
+            .max_transfer_sz = LT_ESP32_DMA_BUFF_LEN,
+        };
+        err = spi_bus_initialize(device->host, &bus_cfg, SPI_DMA_CH_AUTO);
+        if (err != ESP_OK) {
+            LT_LOG_ERROR("spi_bus_initialize failed: %s", esp_err_to_name(err));
+            heap_caps_free(device->dma_buff);
+            device->dma_buff = NULL;
+            return LT_FAIL;
+        }
+    }
+
+    // Output register is set first, so chip select does not glitch low
+    const gpio_config_t cs_cfg = {.pin_bit_mask = 1ull << device->cs_io, .mode = GPIO_MODE_OUTPUT};
+    gpio_set_level(device->cs_io, 1);
+    err = gpio_config(&cs_cfg);
+    if ((err != ESP_OK) || (lt_port_esp32_add_device(device) != LT_OK)) {
+        lt_ret_t ret_unused = lt_port_deinit(s2);
+        UNUSED(ret_unused);
+        return LT_FAIL;
+    }
+
+#if LT_USE_INT_PIN
+    device->int_sem = xSemaphoreCreateBinaryStatic(&device->int_sem_buff);
+    const gpio_config_t int_cfg
+        = {.pin_bit_mask = 1ull << device->int_io, .mode = GPIO_MODE_INPUT, .intr_type = GPIO_INTR_POSEDGE};
+    err = gpio_config(&int_cfg);
+    if (err == ESP_OK) {
+        // Already installed by the application is fine
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) {
+            err = ESP_OK;
+        }
+    }
+    if (err == ESP_OK) {
+        err = gpio_isr_handler_add(device->int_io, lt_port_esp32_int_isr, device);
+    }
+    if (err != ESP_OK) {
+        LT_LOG_ERROR("Can't configure INT pin: %s", esp_err_to_name(err));
+        lt_ret_t ret_unused = lt_port_deinit(s2);
+        UNUSED(ret_unused);
+        return LT_FAIL;
+    }
+#endif
+
+#if LT_THREAD_SAFE
+    device->lock = xSemaphoreCreateRecursiveMutexStatic(&device->lock_buff);
+#endif
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+    lt_ret_t ret = LT_OK;
+
+#if LT_USE_INT_PIN
+    gpio_isr_handler_remove(device->int_io);
+#endif
+    if (device->spi) {
+        lt_port_esp32_bus_give(device);
+        if (spi_bus_remove_device(device->spi) != ESP_OK) {
+            ret = LT_FAIL;
+        }
+        device->spi = NULL;
+    }
+    gpio_set_level(device->cs_io, 1);
+    if (device->init_bus && (spi_bus_free(device->host) != ESP_OK)) {
+        ret = LT_FAIL;
+    }
+    heap_caps_free(device->dma_buff);
+    device->dma_buff = NULL;
+
+    return ret;
+}
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+
+    lt_ret_t ret = lt_port_esp32_bus_take(device);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    gpio_set_level(device->cs_io, 0);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+
+    gpio_set_level(device->cs_io, 1);
+    lt_port_esp32_bus_give(device);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        LT_LOG_ERROR("Invalid data length!");
+        return LT_L1_DATA_LEN_ERROR;
+    }
+    if (!tx_data_length) {
+        return LT_OK;
+    }
+
+    memcpy(device->dma_buff, s2->buff + offset, tx_data_length);
+    lt_port_esp32_trans(device, 0, device->dma_buff, tx_data_length, 0);
+
+    lt_ret_t ret;
+    if (tx_data_length < LT_ESP32_QUEUE_MIN_LEN) {
+        ret = (spi_device_polling_transmit(device->spi, &device->trans[0].t) == ESP_OK) ? LT_OK : LT_L1_SPI_ERROR;
+    }
+    else {
+        ret = lt_port_esp32_run(device, 1, timeout_ms);
+    }
+    if (ret == LT_OK) {
+        memcpy(s2->buff + offset, device->dma_buff, tx_data_length);
+    }
+
+    return ret;
+}
+
+#if LT_USE_SPI_TRANSACTION
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+    size_t pos = 0;
+
+    if (!seg_cnt || (seg_cnt > LT_L1_SPI_SEGMENTS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        const lt_l1_spi_segment_t *seg = &segs[i];
+        if ((seg->offset + seg->len > LT_L1_LEN_MAX) || (pos + seg->len > LT_ESP32_DMA_BUFF_LEN)) {
+            return LT_L1_DATA_LEN_ERROR;
+        }
+
+        uint8_t *slice = device->dma_buff + pos;
+        pos += LT_ESP32_ALIGN(seg->len);
+        memcpy(slice, seg->tx ? seg->tx : s2->buff + seg->offset, seg->len);
+        lt_port_esp32_trans(device, i, slice, seg->len, seg->tx != NULL);
+        // Chip select before the first segment is driven here, the other edges by the callbacks
+        device->trans[i].cs_low = (i > 0) && !segs[i - 1].cs_hold;
+        device->trans[i].cs_high = !seg->cs_hold;
+    }
+
+    lt_ret_t ret = lt_port_spi_csn_low(s2);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    ret = lt_port_esp32_run(device, seg_cnt, timeout_ms);
+
+    for (uint8_t i = 0; (ret == LT_OK) && (i < seg_cnt); i++) {
+        if (device->trans[i].t.rx_buffer) {
+            memcpy(s2->buff + segs[i].offset, device->trans[i].t.rx_buffer, segs[i].len);
+        }
+    }
+    // Chip select stays low after the last segment with cs_hold, the frame is finished by lt_port_spi_csn_high()
+    if ((ret != LT_OK) || !segs[seg_cnt - 1].cs_hold) {
+        lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+        UNUSED(ret_unused);
+    }
+
+    return ret;
+}
+#endif
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    UNUSED(s2);
+
+    vTaskDelay(lt_port_ms_to_ticks(ms));
+
+    return LT_OK;
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    UNUSED(s2);
+
+    // Whole miliseconds are waited by vTaskDelay(), the rest is busy-waited.
+    if (us >= 1000) {
+        vTaskDelay(lt_port_ms_to_ticks(us / 1000));
+        us %= 1000;
+    }
+    esp_rom_delay_us(us);
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+    int khz;
+
+    // Clock of the device is fixed when it is added, chip select is high so the bus is not held
+    if (spi_bus_remove_device(device->spi) != ESP_OK) {
+        return LT_FAIL;
+    }
+    device->spi = NULL;
+    device->clock_hz = (int)hz;
+    if ((lt_port_esp32_add_device(device) != LT_OK) || (spi_device_get_actual_freq(device->spi, &khz) != ESP_OK)) {
+        return LT_FAIL;
+    }
+    *actual_hz = (uint32_t)khz * 1000;
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+
+    // Edges signalized before belong to responses which were already read.
+    xSemaphoreTake(device->int_sem, 0);
+
+    // INT pin may be already asserted, its rising edge would be missed then.
+    if (gpio_get_level(device->int_io)) {
+        return LT_OK;
+    }
+    if (xSemaphoreTake(device->int_sem, lt_port_ms_to_ticks(ms)) != pdTRUE) {
+        return LT_L1_INT_TIMEOUT;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+
+    xSemaphoreTakeRecursive(device->lock, portMAX_DELAY);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_esp32_t *device = (lt_dev_esp32_t *)(s2->device);
+
+    xSemaphoreGiveRecursive(device->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    UNUSED(s2);
+
+    // True random numbers while RF is enabled or the bootloader entropy source is kept on
+    esp_fill_random(buff, count);
+
+    return LT_OK;
+}
@@ -0,0 +1,91 @@
+#ifndef LIBTROPIC_PORT_ESP32_H
+#define LIBTROPIC_PORT_ESP32_H
+
+/**
+ * @file libtropic_port_esp32.h
+ * @author Tropic Square s.r.o.
+ * @brief Port for ESP32 (ESP-IDF 5) using queued DMA transactions of the SPI master driver.
+ *
+ * With LT_USE_SPI_TRANSACTION all segments of an L1 transaction are queued by `spi_device_queue_trans()` at once and
+ * their results are collected afterwards, so e.g. a chunk of L3 command with its status is one sequence of the
+ * driver. Data go through a DMA capable buffer allocated by the port, each segment in its own word aligned slice,
+ * so the driver never allocates bounce buffers.
+ *
+ * Chip select is a GPIO driven from the driver's `pre_cb`/`post_cb` at the edges of queued transactions. Chip select
+ * of the SPI peripheral can not be used, because an L1 read keeps it low after polling CHIP_STATUS and has to release
+ * it without clocking another transaction.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "driver/spi_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "libtropic_port.h"
+
+/** @private @brief Queued transaction with chip select edges done by the driver's callbacks. */
+typedef struct lt_esp32_trans_t {
+    /** @brief Transaction of the driver, its `user` points to this structure. */
+    spi_transaction_t t;
+    /** @brief GPIO of chip select. */
+    int cs_io;
+    /** @brief Nonzero when chip select goes low before the transaction. */
+    uint8_t cs_low;
+    /** @brief Nonzero when chip select goes high after the transaction. */
+    uint8_t cs_high;
+} lt_esp32_trans_t;
+
+/**
+ * @brief Device structure for ESP32 port.
+ *
+ * @note Public members are meant to be configured by the developer before passing the handle to
+ *       libtropic.
+ */
+typedef struct lt_dev_esp32_t {
+    /** @public @brief SPI peripheral, e.g. SPI2_HOST. */
+    spi_host_device_t host;
+    /**
+     * @public @brief When nonzero, the bus is initialized with the pins below by `lt_port_init()` and freed by
+     * `lt_port_deinit()`. Otherwise the application initializes it (with DMA), e.g. when it is shared.
+     */
+    uint8_t init_bus;
+    /** @public @brief GPIO of MOSI, used with `init_bus`. */
+    int mosi_io;
+    /** @public @brief GPIO of MISO, used with `init_bus`. */
+    int miso_io;
+    /** @public @brief GPIO of SCLK, used with `init_bus`. */
+    int sclk_io;
+    /** @public @brief GPIO of chip select. */
+    int cs_io;
+#if LT_USE_INT_PIN
+    /** @public @brief GPIO connected to TROPIC01's INT pin, GPIO ISR service is installed when it is not yet. */
+    int int_io;
+#endif
+    /** @public @brief SPI clock in Hz, 0 uses 5 MHz. */
+    int clock_hz;
+
+    /** @private @brief Device on the bus. */
+    spi_device_handle_t spi;
+    /** @private @brief DMA capable copy of the data of queued transactions. */
+    uint8_t *dma_buff;
+    /** @private @brief Queued transactions. */
+    lt_esp32_trans_t trans[LT_L1_SPI_SEGMENTS_MAX];
+    /** @private @brief Nonzero while the bus is acquired, from chip select going low until it goes high. */
+    uint8_t bus_held;
+#if LT_USE_INT_PIN
+    /** @private @brief Given by the GPIO ISR on rising edge of INT pin. */
+    SemaphoreHandle_t int_sem;
+    /** @private @brief Storage of `int_sem`. */
+    StaticSemaphore_t int_sem_buff;
+#endif
+#if LT_THREAD_SAFE
+    /** @private @brief Recursive mutex locking the handle. */
+    SemaphoreHandle_t lock;
+    /** @private @brief Storage of `lock`. */
+    StaticSemaphore_t lock_buff;
+#endif
+} lt_dev_esp32_t;
+
+#endif  // LIBTROPIC_PORT_ESP32_H
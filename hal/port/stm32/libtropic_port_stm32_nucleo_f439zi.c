@@ -11,6 +11,7 @@
 
 #include "libtropic_port_stm32_nucleo_f439zi.h"
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -21,6 +22,46 @@
 #include "main.h"
 #include "stm32f4xx_hal.h"
 
+/** Shorter transfers (e.g. CHIP_STATUS polls) are not worth of DMA setup */
+#define LT_SPI_DMA_MIN_LEN 16
+
+#if LT_STM32_FREERTOS
+/** Rounds up, so the task does not wake before `ms` elapses (apart from the tick it was called in) */
+static TickType_t lt_port_ms_to_ticks(uint32_t ms)
+{
+    return (TickType_t)((((uint64_t)ms * configTICK_RATE_HZ) + 999) / 1000);
+}
+
+/** Sleeps the task until `flag` is set by an interrupt, returns nonzero when `timeout_ms` elapses first */
+static int lt_port_wait_flag(lt_dev_stm32_nucleo_f439zi *device, volatile uint8_t *flag, uint32_t timeout_ms)
+{
+    TickType_t ticks = lt_port_ms_to_ticks(timeout_ms);
+    TickType_t start = xTaskGetTickCount();
+
+    // Notification given before the wait is kept, stale ones only make the loop check the flag again
+    while (!*flag) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= ticks) {
+            return -1;
+        }
+        ulTaskNotifyTake(pdTRUE, ticks - elapsed);
+    }
+
+    return 0;
+}
+
+static void lt_port_notify_from_isr(lt_dev_stm32_nucleo_f439zi *device)
+{
+    TaskHandle_t task = device->task;
+    BaseType_t woken = pdFALSE;
+
+    if (task) {
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+#endif
+
 lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
 {
     lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
@@ -50,7 +91,10 @@ lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
     lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
 
     HAL_GPIO_WritePin(device->spi_cs_gpio_bank, device->spi_cs_gpio_pin, GPIO_PIN_RESET);
+    // Not read back with FreeRTOS, push-pull output follows the output register within a cycle
+#if !LT_STM32_FREERTOS
     while (HAL_GPIO_ReadPin(device->spi_cs_gpio_bank, device->spi_cs_gpio_pin));
+#endif
 
     return LT_OK;
 }
@@ -60,7 +104,9 @@ lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
     lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
 
     HAL_GPIO_WritePin(device->spi_cs_gpio_bank, device->spi_cs_gpio_pin, GPIO_PIN_SET);
+#if !LT_STM32_FREERTOS
     while (!HAL_GPIO_ReadPin(device->spi_cs_gpio_bank, device->spi_cs_gpio_pin));
+#endif
 
     return LT_OK;
 }
@@ -70,6 +116,13 @@ lt_ret_t lt_port_init(lt_l2_state_t *s2)
     lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
     int ret;
 
+#if LT_STM32_FREERTOS
+    device->task = NULL;
+#if LT_THREAD_SAFE
+    device->lock = xSemaphoreCreateRecursiveMutexStatic(&device->lock_buff);
+#endif
+#endif
+
     ret = HAL_RNG_Init(&device->rng_handle);
     if (ret != HAL_OK) {
         LT_LOG_ERROR("Failed to init RNG, ret=%d", ret);
@@ -112,14 +165,24 @@ lt_ret_t lt_port_init(lt_l2_state_t *s2)
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_MEDIUM;
     HAL_GPIO_Init(device->spi_cs_gpio_bank, &GPIO_InitStruct);
 
+#if LT_USE_DELAY_US
+    // DWT cycle counter is used for delays shorter than a milisecond.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
 #if LT_USE_INT_PIN
-    // GPIO for INT pin.
+    // GPIO for INT pin, rising edge triggers EXTI interrupt.
     LT_INT_CLK_ENABLE();
     GPIO_InitStruct.Pin = device->int_gpio_pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(device->int_gpio_bank, &GPIO_InitStruct);
+    device->int_flag = 0;
+    HAL_NVIC_SetPriority(device->int_irqn, 0, 0);
+    HAL_NVIC_EnableIRQ(device->int_irqn);
 #endif
 
     return LT_OK;
@@ -145,6 +208,55 @@ lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
     return LT_OK;
 }
 
+static lt_ret_t lt_port_spi_transfer_dma(lt_dev_stm32_nucleo_f439zi *device, uint8_t *data, uint16_t len,
+                                         uint32_t timeout_ms)
+{
+    device->spi_dma_done = 0;
+#if LT_STM32_FREERTOS
+    device->task = xTaskGetCurrentTaskHandle();
+#endif
+
+    int ret = HAL_SPI_TransmitReceive_DMA(&device->spi_handle, data, data, len);
+    if (ret != HAL_OK) {
+        LT_LOG_ERROR("HAL_SPI_TransmitReceive_DMA failed, ret=%d", ret);
+        return LT_L1_SPI_ERROR;
+    }
+
+    // CPU is free for other work (another task or an interrupt) until the transfer is finished.
+    if (device->spi_dma_wait) {
+        ret = device->spi_dma_wait(device->spi_dma_ctx, timeout_ms);
+    }
+    else {
+#if LT_STM32_FREERTOS
+        ret = lt_port_wait_flag(device, &device->spi_dma_done, timeout_ms);
+#else
+        uint32_t time_initial = HAL_GetTick();
+        ret = 0;
+        while (!device->spi_dma_done) {
+            if ((HAL_GetTick() - time_initial) > timeout_ms) {
+                ret = -1;
+                break;
+            }
+            // Sleep until the next interrupt (DMA or SysTick, which is used to check the timeout).
+            __WFI();
+        }
+#endif
+    }
+
+    if (ret != 0) {
+        LT_LOG_ERROR("SPI DMA transfer timed out");
+        HAL_SPI_Abort(&device->spi_handle);
+        return LT_L1_SPI_ERROR;
+    }
+
+    if (HAL_SPI_GetError(&device->spi_handle) != HAL_SPI_ERROR_NONE) {
+        LT_LOG_ERROR("SPI DMA transfer failed, error=%" PRIu32, HAL_SPI_GetError(&device->spi_handle));
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
 lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
 {
     lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
@@ -153,6 +265,10 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_dat
         LT_LOG_ERROR("Invalid data length!");
         return LT_L1_DATA_LEN_ERROR;
     }
+    if (device->spi_dma && (tx_data_length >= LT_SPI_DMA_MIN_LEN)) {
+        return lt_port_spi_transfer_dma(device, s2->buff + offset, tx_data_length, timeout_ms);
+    }
+
     int ret = HAL_SPI_TransmitReceive(&device->spi_handle, s2->buff + offset, s2->buff + offset, tx_data_length,
                                       timeout_ms);
     if (ret != HAL_OK) {
@@ -163,30 +279,147 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_dat
     return LT_OK;
 }
 
+void lt_port_stm32_nucleo_f439zi_spi_dma_callback(lt_dev_stm32_nucleo_f439zi *device, SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &device->spi_handle) {
+        device->spi_dma_done = 1;
+        if (device->spi_dma_notify) {
+            device->spi_dma_notify(device->spi_dma_ctx);
+        }
+#if LT_STM32_FREERTOS
+        lt_port_notify_from_isr(device);
+#endif
+    }
+}
+
 lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
 {
     UNUSED(s2);
 
+#if LT_STM32_FREERTOS
+    vTaskDelay(lt_port_ms_to_ticks(ms));
+#else
     HAL_Delay(ms);
+#endif
 
     return LT_OK;
 }
 
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    UNUSED(s2);
+
+    // Whole miliseconds are waited by HAL_Delay() (vTaskDelay()), the rest is busy-waited on DWT cycle counter.
+    if (us >= 1000) {
+#if LT_STM32_FREERTOS
+        vTaskDelay(lt_port_ms_to_ticks(us / 1000));
+#else
+        HAL_Delay(us / 1000);
+#endif
+        us %= 1000;
+    }
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = us * (SystemCoreClock / 1000000);
+    while ((DWT->CYCCNT - start) < cycles) {
+        ;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+/** Baudrate prescalers from the fastest one, SPI clock is the APB clock divided by 2 to 256 */
+static const uint16_t lt_spi_prescalers[] = {
+    SPI_BAUDRATEPRESCALER_2,  SPI_BAUDRATEPRESCALER_4,  SPI_BAUDRATEPRESCALER_8,   SPI_BAUDRATEPRESCALER_16,
+    SPI_BAUDRATEPRESCALER_32, SPI_BAUDRATEPRESCALER_64, SPI_BAUDRATEPRESCALER_128, SPI_BAUDRATEPRESCALER_256,
+};
+
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
+    const size_t cnt = sizeof(lt_spi_prescalers) / sizeof(lt_spi_prescalers[0]);
+
+    // SPI2 and SPI3 are clocked from APB1, the others from APB2
+    uint32_t pclk = ((device->spi_instance == SPI2) || (device->spi_instance == SPI3)) ? HAL_RCC_GetPCLK1Freq()
+                                                                                        : HAL_RCC_GetPCLK2Freq();
+    // The highest clock not exceeding hz, or the lowest one
+    size_t i = 0;
+    while ((i + 1 < cnt) && ((pclk >> (i + 1)) > hz)) {
+        i++;
+    }
+
+    // SPI is already initialized, HAL_SPI_Init() only rewrites its configuration
+    device->baudrate_prescaler = lt_spi_prescalers[i];
+    device->spi_handle.Init.BaudRatePrescaler = lt_spi_prescalers[i];
+    int ret = HAL_SPI_Init(&device->spi_handle);
+    if (ret != HAL_OK) {
+        LT_LOG_ERROR("Failed to set SPI prescaler, ret=%d", ret);
+        return LT_FAIL;
+    }
+    *actual_hz = pclk >> (i + 1);
+
+    return LT_OK;
+}
+#endif
+
 #if LT_USE_INT_PIN
+void lt_port_stm32_nucleo_f439zi_exti_callback(lt_dev_stm32_nucleo_f439zi *device, uint16_t gpio_pin)
+{
+    if (gpio_pin == device->int_gpio_pin) {
+        device->int_flag = 1;
+#if LT_STM32_FREERTOS
+        lt_port_notify_from_isr(device);
+#endif
+    }
+}
+
 lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
 {
     lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
+
+    // Edges signalized before belong to responses which were already read.
+    device->int_flag = 0;
+
+#if LT_STM32_FREERTOS
+    device->task = xTaskGetCurrentTaskHandle();
+    // Edge coming after the pin is read sets the flag and wakes the task.
+    if (HAL_GPIO_ReadPin(device->int_gpio_bank, device->int_gpio_pin) == GPIO_PIN_SET) {
+        return LT_OK;
+    }
+    if (lt_port_wait_flag(device, &device->int_flag, ms)) {
+        return LT_L1_INT_TIMEOUT;
+    }
+#else
     uint32_t time_initial = HAL_GetTick();
-    uint32_t time_actual;
 
-    while ((HAL_GPIO_ReadPin(device->int_gpio_bank, device->int_gpio_pin) == 0)) {
-        time_actual = HAL_GetTick();
-        if ((time_actual - time_initial) > ms) {
+    // INT pin may be already asserted, its rising edge would be missed then.
+    while (!device->int_flag && (HAL_GPIO_ReadPin(device->int_gpio_bank, device->int_gpio_pin) == GPIO_PIN_RESET)) {
+        if ((HAL_GetTick() - time_initial) > ms) {
             return LT_L1_INT_TIMEOUT;
         }
-        // HAL_Delay(ms);
+        // Sleep until the next interrupt (EXTI or SysTick, which is used to check the timeout).
+        __WFI();
     }
+#endif
 
     return LT_OK;
 }
 #endif
+
+#if LT_STM32_FREERTOS && LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
+
+    xSemaphoreTakeRecursive(device->lock, portMAX_DELAY);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_stm32_nucleo_f439zi *device = (lt_dev_stm32_nucleo_f439zi *)(s2->device);
+
+    xSemaphoreGiveRecursive(device->lock);
+}
+#endif
@@ -6,12 +6,26 @@
  * @author Tropic Square s.r.o.
  * @brief Port for STM32 F439ZI using native SPI HAL (and GPIO HAL for chip select).
  *
+ * With LT_STM32_FREERTOS defined to 1, the calling task sleeps in delays and while it waits for DMA completion or INT
+ * pin, which wake it by a task notification (index 0) from their interrupts. The task must not expect its
+ * notifications from elsewhere during libtropic calls.
+ *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
 #include "libtropic_port.h"
 #include "stm32f4xx_hal.h"
 
+#ifndef LT_STM32_FREERTOS
+#define LT_STM32_FREERTOS 0
+#endif
+
+#if LT_STM32_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#endif
+
 /**
  * @brief Device structure for STM32 F439ZI port.
  *
@@ -34,11 +48,36 @@ typedef struct lt_dev_stm32_nucleo_f439zi {
     /** @brief @public GPIO bank of the pin used for chip select. Use STM32 macro (GPIOX). */
     GPIO_TypeDef *spi_cs_gpio_bank;
 
+    /**
+     * @brief @public When nonzero, longer SPI transfers are done by DMA (`HAL_SPI_TransmitReceive_DMA()`).
+     *
+     * @note DMA streams have to be linked to the SPI handle in `HAL_SPI_MspInit()` and
+     *       `lt_port_stm32_nucleo_f439zi_spi_dma_callback()` has to be called from `HAL_SPI_TxRxCpltCallback()` and
+     *       `HAL_SPI_ErrorCallback()`.
+     */
+    uint8_t spi_dma;
+    /** @brief @public Called from DMA interrupt when transfer is finished (e.g. to give a semaphore), can be NULL. */
+    void (*spi_dma_notify)(void *ctx);
+    /**
+     * @brief @public Blocks until `spi_dma_notify` is called or `timeout_ms` elapses (e.g. takes a semaphore) and
+     * returns zero when notified. When NULL, CPU sleeps in `__WFI()` until the transfer is finished (the task waits
+     * for a notification with LT_STM32_FREERTOS).
+     */
+    int (*spi_dma_wait)(void *ctx, uint32_t timeout_ms);
+    /** @brief @public Context passed to `spi_dma_notify` and `spi_dma_wait`. */
+    void *spi_dma_ctx;
+    /** @brief @private Set from DMA interrupt when transfer is finished. */
+    volatile uint8_t spi_dma_done;
+
 #ifdef LT_USE_INT_PIN
     /** @brief @public GPIO pin used for interrupts. Use STM32 macro (GPIO_PIN_XX). */
     uint16_t int_gpio_pin;
     /** @brief @public GPIO bank of the pin used for interrupts. Use STM32 macro (GPIOX). */
     GPIO_TypeDef *int_gpio_bank;
+    /** @brief @public EXTI interrupt of the pin used for interrupts. Use STM32 macro (e.g. EXTI15_10_IRQn). */
+    IRQn_Type int_irqn;
+    /** @brief @private Set from EXTI interrupt when INT pin rises. */
+    volatile uint8_t int_flag;
 #endif
 
     /** @brief @private Random number generator handle. */
@@ -46,6 +85,36 @@ typedef struct lt_dev_stm32_nucleo_f439zi {
 
     /** @brief @private SPI handle. */
     SPI_HandleTypeDef spi_handle;
+
+#if LT_STM32_FREERTOS
+    /** @brief @private Task waiting for DMA completion or INT pin, notified from their interrupts. */
+    TaskHandle_t volatile task;
+#if LT_THREAD_SAFE
+    /** @brief @private Recursive mutex locking the handle. */
+    SemaphoreHandle_t lock;
+    /** @brief @private Storage of `lock`. */
+    StaticSemaphore_t lock_buff;
+#endif
+#endif
 } lt_dev_stm32_nucleo_f439zi;
 
+/**
+ * @brief Notifies the port about finished DMA transfer. Call it from `HAL_SPI_TxRxCpltCallback()` and
+ * `HAL_SPI_ErrorCallback()`.
+ *
+ * @param device      Device structure passed to libtropic
+ * @param hspi        SPI handle passed to the HAL callback
+ */
+void lt_port_stm32_nucleo_f439zi_spi_dma_callback(lt_dev_stm32_nucleo_f439zi *device, SPI_HandleTypeDef *hspi);
+
+#ifdef LT_USE_INT_PIN
+/**
+ * @brief Notifies the port about EXTI interrupt. Call it from `HAL_GPIO_EXTI_Callback()`.
+ *
+ * @param device      Device structure passed to libtropic
+ * @param gpio_pin    Pin passed to `HAL_GPIO_EXTI_Callback()`
+ */
+void lt_port_stm32_nucleo_f439zi_exti_callback(lt_dev_stm32_nucleo_f439zi *device, uint16_t gpio_pin);
+#endif
+
 #endif  // LIBTROPIC_PORT_STM32_NUCLEO_F439ZI_H
\ No newline at end of file
@@ -2,6 +2,9 @@
  * @file libtropic_port_stm32_nucleo_l432kc.c
  * @author Tropic Square s.r.o.
  *
+ * With LT_STM32_FREERTOS defined to 1, the calling task sleeps in delays and while it waits for DMA completion, which
+ * wakes it by a task notification (index 0) from the DMA interrupt.
+ *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
@@ -13,16 +16,134 @@
 #include "libtropic_port.h"
 #include "stm32l4xx_hal.h"
 
+#ifndef LT_STM32_FREERTOS
+#define LT_STM32_FREERTOS 0
+#endif
+
+#if LT_STM32_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
 // CS pin
 #define LT_SPI_CS_BANK GPIOA
 #define LT_SPI_CS_PIN GPIO_PIN_4
 // Spi instance
 #define LT_SPI_INSTANCE SPI1
 
+// Longer SPI transfers are done by DMA, DMA channels have to be linked to SpiHandle in HAL_SPI_MspInit()
+#ifndef LT_SPI_USE_DMA
+#define LT_SPI_USE_DMA 0
+#endif
+// Shorter transfers (e.g. CHIP_STATUS polls) are not worth of DMA setup
+#define LT_SPI_DMA_MIN_LEN 16
+
 // Random number generator's handle
 RNG_HandleTypeDef rng;
 // SPI handle declaration
 SPI_HandleTypeDef SpiHandle;
+#if LT_USE_PORT_CRC16
+// CRC unit handle, HAL_CRC_MODULE_ENABLED has to be defined in stm32l4xx_hal_conf.h
+CRC_HandleTypeDef CrcHandle;
+#endif
+
+#if LT_STM32_FREERTOS
+// Rounds up, so the task does not wake before ms elapses (apart from the tick it was called in)
+static TickType_t lt_port_ms_to_ticks(uint32_t ms)
+{
+    return (TickType_t)((((uint64_t)ms * configTICK_RATE_HZ) + 999) / 1000);
+}
+#endif
+
+#if LT_SPI_USE_DMA
+// Called from DMA interrupt when transfer is finished (e.g. to give a semaphore), can be set by the application
+void (*lt_spi_dma_notify)(void) = NULL;
+// Blocks until lt_spi_dma_notify() is called or timeout elapses (e.g. takes a semaphore) and returns zero when
+// notified, can be set by the application. When NULL, CPU sleeps in __WFI() until the transfer is finished (the task
+// waits for a notification with LT_STM32_FREERTOS).
+int (*lt_spi_dma_wait)(uint32_t timeout_ms) = NULL;
+// Set from DMA interrupt when transfer is finished
+static volatile uint8_t spi_dma_done;
+#if LT_STM32_FREERTOS
+// Task waiting for DMA completion
+static TaskHandle_t volatile spi_dma_task;
+#endif
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &SpiHandle) {
+        spi_dma_done = 1;
+        if (lt_spi_dma_notify) {
+            lt_spi_dma_notify();
+        }
+#if LT_STM32_FREERTOS
+        BaseType_t woken = pdFALSE;
+        if (spi_dma_task) {
+            vTaskNotifyGiveFromISR(spi_dma_task, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+#endif
+    }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    HAL_SPI_TxRxCpltCallback(hspi);
+}
+
+static lt_ret_t lt_port_spi_transfer_dma(uint8_t *data, uint16_t len, uint32_t timeout_ms)
+{
+    spi_dma_done = 0;
+#if LT_STM32_FREERTOS
+    spi_dma_task = xTaskGetCurrentTaskHandle();
+#endif
+
+    if (HAL_SPI_TransmitReceive_DMA(&SpiHandle, data, data, len) != HAL_OK) {
+        return LT_FAIL;
+    }
+
+    // CPU is free for other work (another task or an interrupt) until the transfer is finished.
+    int ret = 0;
+    if (lt_spi_dma_wait) {
+        ret = lt_spi_dma_wait(timeout_ms);
+    }
+    else {
+#if LT_STM32_FREERTOS
+        TickType_t ticks = lt_port_ms_to_ticks(timeout_ms);
+        TickType_t start = xTaskGetTickCount();
+        // Notification given before the wait is kept, stale ones only make the loop check the flag again
+        while (!spi_dma_done) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= ticks) {
+                ret = -1;
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, ticks - elapsed);
+        }
+#else
+        uint32_t time_initial = HAL_GetTick();
+        while (!spi_dma_done) {
+            if ((HAL_GetTick() - time_initial) > timeout_ms) {
+                ret = -1;
+                break;
+            }
+            // Sleep until the next interrupt (DMA or SysTick, which is used to check the timeout).
+            __WFI();
+        }
+#endif
+    }
+
+    if (ret != 0) {
+        HAL_SPI_Abort(&SpiHandle);
+        return LT_FAIL;
+    }
+    if (HAL_SPI_GetError(&SpiHandle) != HAL_SPI_ERROR_NONE) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+#endif
 
 lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
 {
@@ -45,9 +166,12 @@ lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *h)
     UNUSED(h);
 
     HAL_GPIO_WritePin(LT_SPI_CS_BANK, LT_SPI_CS_PIN, GPIO_PIN_RESET);
+    // Not read back with FreeRTOS, push-pull output follows the output register within a cycle
+#if !LT_STM32_FREERTOS
     while (HAL_GPIO_ReadPin(LT_SPI_CS_BANK, LT_SPI_CS_PIN)) {
         ;
     }
+#endif
 
     return LT_OK;
 }
@@ -57,9 +181,11 @@ lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *h)
     UNUSED(h);
 
     HAL_GPIO_WritePin(LT_SPI_CS_BANK, LT_SPI_CS_PIN, GPIO_PIN_SET);
+#if !LT_STM32_FREERTOS
     while (!HAL_GPIO_ReadPin(LT_SPI_CS_BANK, LT_SPI_CS_PIN)) {
         ;
     }
+#endif
 
     return LT_OK;
 }
@@ -105,6 +231,31 @@ lt_ret_t lt_port_init(lt_l2_state_t *h)
         return LT_FAIL;
     }
 
+#if LT_USE_PORT_CRC16
+    // CRC unit is programmed for CRC16 of L2 frames (polynomial 0x8005, initial value 0, no reflection).
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CrcHandle.Instance = CRC;
+    CrcHandle.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_DISABLE;
+    CrcHandle.Init.GeneratingPolynomial = 0x8005;
+    CrcHandle.Init.CRCLength = CRC_POLYLENGTH_16B;
+    CrcHandle.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_DISABLE;
+    CrcHandle.Init.InitValue = 0;
+    CrcHandle.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_NONE;
+    CrcHandle.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_DISABLE;
+    CrcHandle.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+
+    if (HAL_CRC_Init(&CrcHandle) != HAL_OK) {
+        return LT_FAIL;
+    }
+#endif
+
+#if LT_USE_DELAY_US
+    // DWT cycle counter is used for delays shorter than a milisecond.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     return LT_OK;
 }
 
@@ -118,6 +269,12 @@ lt_ret_t lt_port_deinit(lt_l2_state_t *h)
 
     HAL_SPI_MspDeInit(&SpiHandle);
 
+#if LT_USE_PORT_CRC16
+    if (HAL_CRC_DeInit(&CrcHandle) != HAL_OK) {
+        return LT_FAIL;
+    }
+#endif
+
     return LT_OK;
 }
 
@@ -126,6 +283,11 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *h, uint8_t offset, uint16_t tx_data
     if (offset + tx_data_length > LT_L1_LEN_MAX) {
         return LT_L1_DATA_LEN_ERROR;
     }
+#if LT_SPI_USE_DMA
+    if (tx_data_length >= LT_SPI_DMA_MIN_LEN) {
+        return lt_port_spi_transfer_dma(h->buff + offset, tx_data_length, timeout_ms);
+    }
+#endif
     int ret = HAL_SPI_TransmitReceive(&SpiHandle, h->buff + offset, h->buff + offset, tx_data_length, timeout_ms);
     if (ret != HAL_OK) {
         return LT_FAIL;
@@ -138,7 +300,79 @@ lt_ret_t lt_port_delay(lt_l2_state_t *h, uint32_t ms)
 {
     UNUSED(h);
 
+#if LT_STM32_FREERTOS
+    vTaskDelay(lt_port_ms_to_ticks(ms));
+#else
     HAL_Delay(ms);
+#endif
+
+    return LT_OK;
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *h, uint32_t us)
+{
+    UNUSED(h);
+
+    // Whole miliseconds are waited by HAL_Delay() (vTaskDelay()), the rest is busy-waited on DWT cycle counter.
+    if (us >= 1000) {
+#if LT_STM32_FREERTOS
+        vTaskDelay(lt_port_ms_to_ticks(us / 1000));
+#else
+        HAL_Delay(us / 1000);
+#endif
+        us %= 1000;
+    }
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = us * (SystemCoreClock / 1000000);
+    while ((DWT->CYCCNT - start) < cycles) {
+        ;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+/** Baudrate prescalers from the fastest one, SPI clock is the APB clock divided by 2 to 256 */
+static const uint32_t lt_spi_prescalers[] = {
+    SPI_BAUDRATEPRESCALER_2,  SPI_BAUDRATEPRESCALER_4,  SPI_BAUDRATEPRESCALER_8,   SPI_BAUDRATEPRESCALER_16,
+    SPI_BAUDRATEPRESCALER_32, SPI_BAUDRATEPRESCALER_64, SPI_BAUDRATEPRESCALER_128, SPI_BAUDRATEPRESCALER_256,
+};
+
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *h, uint32_t hz, uint32_t *actual_hz)
+{
+    UNUSED(h);
+    const size_t cnt = sizeof(lt_spi_prescalers) / sizeof(lt_spi_prescalers[0]);
+
+    // SPI1 is clocked from APB2
+    uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+    // The highest clock not exceeding hz, or the lowest one
+    size_t i = 0;
+    while ((i + 1 < cnt) && ((pclk >> (i + 1)) > hz)) {
+        i++;
+    }
+
+    // SPI is already initialized, HAL_SPI_Init() only rewrites its configuration
+    SpiHandle.Init.BaudRatePrescaler = lt_spi_prescalers[i];
+    if (HAL_SPI_Init(&SpiHandle) != HAL_OK) {
+        return LT_FAIL;
+    }
+    *actual_hz = pclk >> (i + 1);
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_PORT_CRC16
+lt_ret_t lt_port_crc16(lt_l2_state_t *h, const uint8_t *data, uint16_t len, uint16_t *crc)
+{
+    UNUSED(h);
+
+    // HAL reads data byte by byte (CRC_INPUTDATA_FORMAT_BYTES), the cast only satisfies its prototype.
+    uint16_t value = (uint16_t)HAL_CRC_Calculate(&CrcHandle, (uint32_t *)(uintptr_t)data, len);
+    *crc = (uint16_t)(value << 8 | value >> 8);
 
     return LT_OK;
 }
+#endif
@@ -0,0 +1,414 @@
+/**
+ * @file tropic01_spi.c
+ * @author Tropic Square s.r.o.
+ * @brief Linux SPI driver of TROPIC01 executing L1 transactions in the kernel, see tropic01_spi_uapi.h.
+ *
+ * User space driving TROPIC01 through spidev and GPIO chip select pays at least one syscall per chip select edge,
+ * transfer and poll of CHIP_STATUS. This driver takes a whole L2 request frame per write() and returns the whole
+ * response per read(), polling CHIP_STATUS (or waiting on INT) and reading the response driven by its length byte
+ * in the kernel. Polls hold the SPI bus only for the poll itself, so other devices on the bus go on in between.
+ *
+ * Device tree node:
+ *
+ *     tropic01@0 {
+ *         compatible = "tropicsquare,tropic01";
+ *         reg = <0>;
+ *         spi-max-frequency = <5000000>;
+ *         int-gpios = <&gpio 24 GPIO_ACTIVE_HIGH>;   // optional
+ *     };
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <linux/completion.h>
+#include <linux/delay.h>
+#include <linux/fs.h>
+#include <linux/gpio/consumer.h>
+#include <linux/interrupt.h>
+#include <linux/jiffies.h>
+#include <linux/miscdevice.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/sched/signal.h>
+#include <linux/slab.h>
+#include <linux/spi/spi.h>
+#include <linux/uaccess.h>
+
+#include "tropic01_spi_uapi.h"
+
+#define TROPIC01_CHIP_MODE_READY_bit 0x01
+#define TROPIC01_CHIP_MODE_ALARM_bit 0x02
+#define TROPIC01_GET_RESPONSE_REQ_ID 0xaa
+/** Timeout of read() until set by TROPIC01_IOC_TIMEOUT, LT_L1_TIMEOUT_MS_DEFAULT of libtropic */
+#define TROPIC01_TIMEOUT_MS_DEFAULT 70
+#define TROPIC01_TIMEOUT_MS_MAX 10000
+
+static unsigned int poll_us = 200;
+module_param(poll_us, uint, 0644);
+MODULE_PARM_DESC(poll_us, "Delay between polls of CHIP_STATUS in us, when INT is not wired");
+
+struct tropic01_spi {
+    struct spi_device *spi;
+    struct miscdevice misc;
+    char name[32];
+    /** Serializes operations of all openers */
+    struct mutex lock;
+    /** Optional INT pin, completes `int_done` on its rising edge */
+    struct gpio_desc *int_gpio;
+    struct completion int_done;
+    u32 timeout_ms;
+    u8 chip_status;
+    /** Opener holding chip select low and the bus by TROPIC01_IOC_CSN */
+    struct file *cs_owner;
+    /** Frame buffer, in a cache line of its own, so it can be mapped for DMA */
+    u8 buf[TROPIC01_SPI_FRAME_MAX] ____cacheline_aligned;
+};
+
+static irqreturn_t tropic01_int_irq(int irq, void *data)
+{
+    struct tropic01_spi *t = data;
+
+    complete(&t->int_done);
+
+    return IRQ_HANDLED;
+}
+
+/** Transfers `len` bytes of the buffer at `offset` on the locked bus, chip select stays low when `cs_hold` is set */
+static int tropic01_xfer_locked(struct tropic01_spi *t, unsigned int offset, unsigned int len, bool cs_hold)
+{
+    struct spi_transfer x = {
+        .tx_buf = len ? t->buf + offset : NULL,
+        .rx_buf = len ? t->buf + offset : NULL,
+        .len = len,
+        .cs_change = cs_hold,
+    };
+    struct spi_message m;
+
+    spi_message_init_with_transfers(&m, &x, 1);
+
+    return spi_sync_locked(t->spi, &m);
+}
+
+/** Releases chip select held by the previous transfer and gives up the bus */
+static void tropic01_cs_release(struct tropic01_spi *t)
+{
+    // Zero length transfer only deasserts chip select at the end of its message
+    tropic01_xfer_locked(t, 0, 0, false);
+    spi_bus_unlock(t->spi->controller);
+}
+
+/**
+ * Polls CHIP_STATUS once and reads the response when it is ready. Returns its length, 0 when the chip is not ready
+ * or a negative error.
+ */
+static int tropic01_poll(struct tropic01_spi *t, size_t max_len)
+{
+    unsigned int len;
+    int ret;
+
+    spi_bus_lock(t->spi->controller);
+    memset(t->buf, 0, 3);
+    t->buf[0] = TROPIC01_GET_RESPONSE_REQ_ID;
+    ret = tropic01_xfer_locked(t, 0, 3, true);
+    if (ret) {
+        goto release;
+    }
+    t->chip_status = t->buf[0];
+    if (t->chip_status & TROPIC01_CHIP_MODE_ALARM_bit) {
+        ret = -ENOTRECOVERABLE;
+        goto release;
+    }
+    // 0xff as STATUS means no response to send
+    if (!(t->chip_status & TROPIC01_CHIP_MODE_READY_bit) || (t->buf[1] == 0xff)) {
+        goto release;
+    }
+
+    len = 3 + t->buf[2] + 2;
+    if ((len > max_len) || (len > TROPIC01_SPI_FRAME_MAX)) {
+        ret = -EMSGSIZE;
+        goto release;
+    }
+    memset(t->buf + 3, 0, len - 3);
+    ret = tropic01_xfer_locked(t, 3, len - 3, false);
+    spi_bus_unlock(t->spi->controller);
+
+    return ret ? ret : (int)len;
+
+release:
+    tropic01_cs_release(t);
+    return ret;
+}
+
+static int tropic01_open(struct inode *inode, struct file *file)
+{
+    // misc core points private_data to the miscdevice
+    file->private_data = container_of(file->private_data, struct tropic01_spi, misc);
+
+    return nonseekable_open(inode, file);
+}
+
+static int tropic01_release(struct inode *inode, struct file *file)
+{
+    struct tropic01_spi *t = file->private_data;
+
+    // Opener which died with chip select low does not block the bus
+    mutex_lock(&t->lock);
+    if (t->cs_owner == file) {
+        tropic01_cs_release(t);
+        t->cs_owner = NULL;
+    }
+    mutex_unlock(&t->lock);
+
+    return 0;
+}
+
+static ssize_t tropic01_write(struct file *file, const char __user *ubuf, size_t count, loff_t *ppos)
+{
+    struct tropic01_spi *t = file->private_data;
+    struct spi_transfer x = {.tx_buf = t->buf, .rx_buf = t->buf, .len = count};
+    int ret;
+
+    if ((count < 1) || (count > TROPIC01_SPI_FRAME_MAX)) {
+        return -EINVAL;
+    }
+
+    mutex_lock(&t->lock);
+    if (t->cs_owner) {
+        ret = -EBUSY;
+        goto out;
+    }
+    if (copy_from_user(t->buf, ubuf, count)) {
+        ret = -EFAULT;
+        goto out;
+    }
+    if (t->int_gpio) {
+        reinit_completion(&t->int_done);
+    }
+    ret = spi_sync_transfer(t->spi, &x, 1);
+    if (!ret) {
+        t->chip_status = t->buf[0];
+    }
+
+out:
+    mutex_unlock(&t->lock);
+    return ret ? ret : (ssize_t)count;
+}
+
+static ssize_t tropic01_read(struct file *file, char __user *ubuf, size_t count, loff_t *ppos)
+{
+    struct tropic01_spi *t = file->private_data;
+    unsigned long deadline;
+    int ret;
+
+    if (count < 3 + 2) {
+        return -EINVAL;
+    }
+
+    mutex_lock(&t->lock);
+    if (t->cs_owner) {
+        ret = -EBUSY;
+        goto out;
+    }
+
+    deadline = jiffies + msecs_to_jiffies(t->timeout_ms);
+    for (;;) {
+        if (t->int_gpio) {
+            reinit_completion(&t->int_done);
+        }
+        ret = tropic01_poll(t, count);
+        if (ret) {
+            break;
+        }
+        if (time_after(jiffies, deadline)) {
+            ret = -ETIMEDOUT;
+            break;
+        }
+        if (t->int_gpio) {
+            if (wait_for_completion_interruptible_timeout(&t->int_done, deadline - jiffies + 1) < 0) {
+                ret = -ERESTARTSYS;
+                break;
+            }
+        }
+        else {
+            usleep_range(poll_us, poll_us + poll_us / 4);
+            if (signal_pending(current)) {
+                ret = -ERESTARTSYS;
+                break;
+            }
+        }
+    }
+    if ((ret > 0) && copy_to_user(ubuf, t->buf, ret)) {
+        ret = -EFAULT;
+    }
+
+out:
+    mutex_unlock(&t->lock);
+    return ret;
+}
+
+static long tropic01_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct tropic01_spi *t = file->private_data;
+    void __user *uarg = (void __user *)arg;
+    struct tropic01_spi_xfer xfer;
+    long ret = 0;
+    u32 val;
+
+    mutex_lock(&t->lock);
+    switch (cmd) {
+        case TROPIC01_IOC_TIMEOUT:
+            if (get_user(val, (u32 __user *)uarg)) {
+                ret = -EFAULT;
+            }
+            else if (!val || (val > TROPIC01_TIMEOUT_MS_MAX)) {
+                ret = -EINVAL;
+            }
+            else {
+                t->timeout_ms = val;
+            }
+            break;
+        case TROPIC01_IOC_CHIP_STATUS:
+            ret = put_user(t->chip_status, (u8 __user *)uarg);
+            break;
+        case TROPIC01_IOC_CSN:
+            if (get_user(val, (u32 __user *)uarg)) {
+                ret = -EFAULT;
+            }
+            else if (!val) {
+                if (t->cs_owner) {
+                    ret = (t->cs_owner == file) ? 0 : -EBUSY;
+                    break;
+                }
+                // Chip select goes low with the first transfer, the bus is kept until it goes high
+                spi_bus_lock(t->spi->controller);
+                t->cs_owner = file;
+            }
+            else if (t->cs_owner == file) {
+                tropic01_cs_release(t);
+                t->cs_owner = NULL;
+            }
+            break;
+        case TROPIC01_IOC_XFER:
+            if (copy_from_user(&xfer, uarg, sizeof(xfer))) {
+                ret = -EFAULT;
+                break;
+            }
+            if (t->cs_owner != file) {
+                ret = -EPERM;
+                break;
+            }
+            if (xfer.len > TROPIC01_SPI_FRAME_MAX) {
+                ret = -EINVAL;
+                break;
+            }
+            if (copy_from_user(t->buf, u64_to_user_ptr(xfer.buf), xfer.len)) {
+                ret = -EFAULT;
+                break;
+            }
+            ret = tropic01_xfer_locked(t, 0, xfer.len, true);
+            if (!ret && copy_to_user(u64_to_user_ptr(xfer.buf), t->buf, xfer.len)) {
+                ret = -EFAULT;
+            }
+            break;
+        default:
+            ret = -ENOTTY;
+    }
+    mutex_unlock(&t->lock);
+
+    return ret;
+}
+
+static const struct file_operations tropic01_fops = {
+    .owner = THIS_MODULE,
+    .open = tropic01_open,
+    .release = tropic01_release,
+    .read = tropic01_read,
+    .write = tropic01_write,
+    .unlocked_ioctl = tropic01_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
+};
+
+static int tropic01_probe(struct spi_device *spi)
+{
+    struct device *dev = &spi->dev;
+    struct tropic01_spi *t;
+    int ret;
+
+    t = devm_kzalloc(dev, sizeof(*t), GFP_KERNEL);
+    if (!t) {
+        return -ENOMEM;
+    }
+    t->spi = spi;
+    t->timeout_ms = TROPIC01_TIMEOUT_MS_DEFAULT;
+    mutex_init(&t->lock);
+    init_completion(&t->int_done);
+
+    spi->mode = SPI_MODE_0;
+    spi->bits_per_word = 8;
+    ret = spi_setup(spi);
+    if (ret) {
+        return dev_err_probe(dev, ret, "SPI setup failed\n");
+    }
+
+    t->int_gpio = devm_gpiod_get_optional(dev, "int", GPIOD_IN);
+    if (IS_ERR(t->int_gpio)) {
+        return dev_err_probe(dev, PTR_ERR(t->int_gpio), "INT pin request failed\n");
+    }
+    if (t->int_gpio) {
+        ret = devm_request_irq(dev, gpiod_to_irq(t->int_gpio), tropic01_int_irq, IRQF_TRIGGER_RISING,
+                               dev_name(dev), t);
+        if (ret) {
+            return dev_err_probe(dev, ret, "INT interrupt request failed\n");
+        }
+    }
+
+    snprintf(t->name, sizeof(t->name), "tropic01-%s", dev_name(dev));
+    t->misc.minor = MISC_DYNAMIC_MINOR;
+    t->misc.name = t->name;
+    t->misc.fops = &tropic01_fops;
+    t->misc.parent = dev;
+    ret = misc_register(&t->misc);
+    if (ret) {
+        return dev_err_probe(dev, ret, "Character device registration failed\n");
+    }
+    spi_set_drvdata(spi, t);
+    dev_info(dev, "/dev/%s, INT %s\n", t->name, t->int_gpio ? "wired" : "polled");
+
+    return 0;
+}
+
+static void tropic01_remove(struct spi_device *spi)
+{
+    struct tropic01_spi *t = spi_get_drvdata(spi);
+
+    misc_deregister(&t->misc);
+}
+
+static const struct of_device_id tropic01_of_match[] = {
+    {.compatible = "tropicsquare,tropic01"},
+    {},
+};
+MODULE_DEVICE_TABLE(of, tropic01_of_match);
+
+static const struct spi_device_id tropic01_spi_ids[] = {
+    {"tropic01", 0},
+    {},
+};
+MODULE_DEVICE_TABLE(spi, tropic01_spi_ids);
+
+static struct spi_driver tropic01_spi_driver = {
+    .driver =
+        {
+            .name = "tropic01_spi",
+            .of_match_table = tropic01_of_match,
+        },
+    .probe = tropic01_probe,
+    .remove = tropic01_remove,
+    .id_table = tropic01_spi_ids,
+};
+module_spi_driver(tropic01_spi_driver);
+
+MODULE_AUTHOR("Tropic Square s.r.o.");
+MODULE_DESCRIPTION("TROPIC01 secure element with L1 transactions in the kernel");
+MODULE_LICENSE("Dual BSD/GPL");
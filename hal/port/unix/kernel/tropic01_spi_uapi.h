@@ -0,0 +1,46 @@
+#ifndef TROPIC01_SPI_UAPI_H
+#define TROPIC01_SPI_UAPI_H
+
+/**
+ * @file tropic01_spi_uapi.h
+ * @author Tropic Square s.r.o.
+ * @brief Interface of the character device of the tropic01_spi kernel driver, shared with the libtropic port.
+ *
+ * Each TROPIC01 bound to the driver gets /dev/tropic01-<spi device>, e.g. /dev/tropic01-spi0.0:
+ *
+ * - write() sends one L2 request frame (REQ_ID, length, data and CRC) in one SPI transaction.
+ * - read() of at most `count` bytes polls CHIP_STATUS (waiting on INT when the device tree gives `int-gpios`) until
+ *   TROPIC01 has a response, reads it driven by its length byte and returns CHIP_STATUS, STATUS, length, data and
+ *   CRC. It fails with ETIMEDOUT when the chip has no response within the timeout, ENOTRECOVERABLE in alarm mode
+ *   and EMSGSIZE when the response does not fit into `count` bytes. CHIP_STATUS of the last poll is kept for
+ *   TROPIC01_IOC_CHIP_STATUS.
+ * - ioctls set the timeout of reads and give raw access to the bus, for L1 operations other than the exchange of L2
+ *   frames. The bus is locked for the device between TROPIC01_IOC_CSN low and high.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/** Maximal length of a frame, the same as LT_L1_LEN_MAX of libtropic */
+#define TROPIC01_SPI_FRAME_MAX 257
+
+/** Raw full duplex transfer of `len` bytes at `buf`, replaced by MISO bytes */
+struct tropic01_spi_xfer {
+    __u64 buf;
+    __u16 len;
+    __u16 reserved[3];
+};
+
+#define TROPIC01_IOC_MAGIC 'T'
+/** Sets the timeout of read() in ms, argument is __u32 */
+#define TROPIC01_IOC_TIMEOUT _IOW(TROPIC01_IOC_MAGIC, 1, __u32)
+/** Gets CHIP_STATUS of the last poll, argument is __u8 */
+#define TROPIC01_IOC_CHIP_STATUS _IOR(TROPIC01_IOC_MAGIC, 2, __u8)
+/** Drives chip select, argument is __u32: 0 low (takes the bus), 1 high (gives it back) */
+#define TROPIC01_IOC_CSN _IOW(TROPIC01_IOC_MAGIC, 3, __u32)
+/** Transfers bytes with chip select low, see struct tropic01_spi_xfer */
+#define TROPIC01_IOC_XFER _IOWR(TROPIC01_IOC_MAGIC, 4, struct tropic01_spi_xfer)
+
+#endif  // TROPIC01_SPI_UAPI_H
@@ -0,0 +1,86 @@
+/**
+ * @file libtropic_port_unix_delay.c
+ * @author Tropic Square s.r.o.
+ * @brief Precise delays shared by Unix ports, which sleep until absolute CLOCK_MONOTONIC deadlines.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+// clock_nanosleep() is POSIX
+#if !defined(_GNU_SOURCE) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "libtropic_port_unix_delay.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+
+#define LT_UNIX_NS_PER_S 1000000000ull
+
+static uint64_t lt_unix_now_ns(void)
+{
+    struct timespec ts;
+
+    // CLOCK_MONOTONIC is always supported on Linux
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * LT_UNIX_NS_PER_S) + (uint64_t)ts.tv_nsec;
+}
+
+/** Tells the core that this is a busy-wait loop */
+static inline void lt_unix_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+lt_ret_t lt_unix_delay(const lt_unix_delay_t *delay, lt_l2_state_t *s2, const uint64_t us)
+{
+    uint64_t start = lt_unix_now_ns();
+    uint64_t deadline = start + (us * 1000);
+    uint64_t spin_ns = delay ? (uint64_t)delay->spin_us * 1000 : 0;
+
+    if (deadline - start > spin_ns) {
+        uint64_t wake = deadline - spin_ns;
+        struct timespec ts = {.tv_sec = (time_t)(wake / LT_UNIX_NS_PER_S), .tv_nsec = (long)(wake % LT_UNIX_NS_PER_S)};
+        int ret;
+        // Interrupted sleep is simply resumed, the deadline stays the same
+        while ((ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+        }
+        if (ret) {
+            LT_LOG_ERROR("clock_nanosleep() failed: %s (%d)", strerror(ret), ret);
+            return LT_FAIL;
+        }
+    }
+
+    uint64_t now = lt_unix_now_ns();
+    while (now < deadline) {
+        lt_unix_cpu_relax();
+        now = lt_unix_now_ns();
+    }
+
+#if LT_STATS
+    if (s2->stats) {
+        uint32_t oversleep_us = (uint32_t)((now - deadline) / 1000);
+        s2->stats->delays++;
+        s2->stats->oversleep.total_us += oversleep_us;
+        if (oversleep_us > s2->stats->oversleep.max_us) {
+            s2->stats->oversleep.max_us = oversleep_us;
+        }
+    }
+#else
+    UNUSED(s2);
+#endif
+
+    return LT_OK;
+}
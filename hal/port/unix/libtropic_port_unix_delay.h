@@ -0,0 +1,44 @@
+#ifndef LIBTROPIC_PORT_UNIX_DELAY_H
+#define LIBTROPIC_PORT_UNIX_DELAY_H
+
+/**
+ * @file libtropic_port_unix_delay.h
+ * @author Tropic Square s.r.o.
+ * @brief Precise delays shared by Unix ports, which sleep until absolute CLOCK_MONOTONIC deadlines.
+ *
+ * Sleeping until an absolute deadline does not accumulate the time spent before the sleep, unlike usleep(). Wake up
+ * still comes after the scheduler granularity, so the last part of a delay can be spun instead, which is worth it
+ * for short poll retries. Oversleep of each delay (time past its deadline) is added to `lt_stats_t.oversleep` when
+ * libtropic is compiled with LT_STATS.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/**
+ * @brief Configuration of delays of one device.
+ *
+ * @note Zero initialized configuration only sleeps.
+ */
+typedef struct lt_unix_delay_t {
+    /**
+     * @public @brief Length of time in us which is spun before the deadline, e.g. 100. Shorter delays are spun
+     *                whole, longer ones sleep until this long before their deadline. 0 never spins.
+     */
+    uint32_t spin_us;
+} lt_unix_delay_t;
+
+/**
+ * @brief Waits for the given time.
+ *
+ * @param delay  Configuration of delays of the device
+ * @param s2     Structure holding l2 state, oversleep is accounted to its statistics
+ * @param us     Time to wait in microseconds
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_delay(const lt_unix_delay_t *delay, lt_l2_state_t *s2, const uint64_t us);
+
+#endif  // LIBTROPIC_PORT_UNIX_DELAY_H
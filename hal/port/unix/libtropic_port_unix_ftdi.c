@@ -0,0 +1,468 @@
+/**
+ * @file libtropic_port_unix_ftdi.c
+ * @author Tropic Square s.r.o.
+ * @brief Port for SPI driven directly by MPSSE of FTDI FT2232H through libftdi1.
+ *
+ * Port functions only queue MPSSE commands into `cmd` of the device. The queue is submitted when something has to be
+ * clocked in (end of a transfer or a transaction) or chip select goes high, so chip select going low costs no USB
+ * transfer. Bytes clocked in are read back in the order of the queued transfers, each one straight into its place.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_unix_ftdi.h"
+
+#include <ftdi.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+
+/** Default USB IDs of FT2232H */
+#define FTDI_VID_DEFAULT 0x0403
+#define FTDI_PID_DEFAULT 0x6010
+/** Default SPI clock */
+#define FTDI_SPI_SPEED_DEFAULT 5000000u
+/** Clock of MPSSE with divide by 5 disabled, SCK is half of it divided by (1 + divisor) */
+#define FTDI_MPSSE_CLK_HZ 60000000u
+/** Default pin of chip select, ADBUS3 */
+#define FTDI_CS_PIN_DEFAULT 3
+/** Gap between reads of the INT pin in us */
+#define FTDI_INT_POLL_US 100
+/** Timeout of reads not bound by a transfer timeout in ms */
+#define FTDI_TIMEOUT_MS 100
+
+/** MPSSE commands, see FTDI AN_108 */
+#define MPSSE_BYTES_OUT_IN 0x31  // MSB first, out on falling edge, in on rising edge (SPI mode 0)
+#define MPSSE_BYTES_OUT 0x11  // MSB first, out on falling edge
+#define MPSSE_SET_LOW 0x80
+#define MPSSE_GET_LOW 0x81
+#define MPSSE_LOOPBACK_OFF 0x85
+#define MPSSE_TCK_DIVISOR 0x86
+#define MPSSE_SEND_IMMEDIATE 0x87
+#define MPSSE_DIV5_OFF 0x8a
+#define MPSSE_3PHASE_OFF 0x8d
+#define MPSSE_ADAPTIVE_OFF 0x97
+/** Invalid command, MPSSE answers it by 0xfa followed by the command, which synchronizes the stream */
+#define MPSSE_BAD_CMD 0xaa
+#define MPSSE_BAD_CMD_ECHO 0xfa
+
+/** ADBUS pins of the MPSSE SPI */
+#define FTDI_PIN_SCK 0x01
+#define FTDI_PIN_MOSI 0x02
+
+static uint64_t ftdi_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
+
+static void ftdi_queue(lt_dev_unix_ftdi_t *device, const uint8_t *data, size_t len)
+{
+    memcpy(device->cmd + device->cmd_len, data, len);
+    device->cmd_len += len;
+}
+
+static void ftdi_queue_cs(lt_dev_unix_ftdi_t *device, int high)
+{
+    uint8_t cs = (uint8_t)(1u << device->cs_pin);
+    const uint8_t cmd[] = {MPSSE_SET_LOW, high ? device->pins_idle : (uint8_t)(device->pins_idle & ~cs),
+                           device->pins_dir};
+
+    ftdi_queue(device, cmd, sizeof(cmd));
+}
+
+/** Queues transfer of `len` bytes from `tx`, bytes clocked in are stored to `rx` unless it is NULL */
+static void ftdi_queue_transfer(lt_dev_unix_ftdi_t *device, const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    if (!len) {
+        return;
+    }
+    const uint8_t cmd[] = {rx ? MPSSE_BYTES_OUT_IN : MPSSE_BYTES_OUT, (uint8_t)(len - 1),
+                           (uint8_t)((len - 1) >> 8)};
+
+    ftdi_queue(device, cmd, sizeof(cmd));
+    ftdi_queue(device, tx, len);
+    if (rx) {
+        device->rx[device->rx_cnt].dst = rx;
+        device->rx[device->rx_cnt].len = len;
+        device->rx_cnt++;
+        device->rx_len += len;
+    }
+}
+
+/** Queues clock divisor of the highest SPI clock not exceeding hz, returns the clock */
+static uint32_t ftdi_queue_speed(lt_dev_unix_ftdi_t *device, uint32_t hz)
+{
+    uint32_t half = FTDI_MPSSE_CLK_HZ / 2;
+    uint32_t div = (hz >= half) ? 0 : ((half + hz - 1) / hz) - 1;
+    if (div > 0xffff) {
+        div = 0xffff;
+    }
+    const uint8_t cmd[] = {MPSSE_TCK_DIVISOR, (uint8_t)div, (uint8_t)(div >> 8)};
+
+    ftdi_queue(device, cmd, sizeof(cmd));
+
+    return half / (div + 1);
+}
+
+/** Reads exactly `len` bytes, libftdi returns whatever arrived within one bulk read */
+static lt_ret_t ftdi_read_exact(lt_l2_state_t *s2, uint8_t *dst, size_t len, uint64_t deadline_us)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    while (len) {
+        int ret = ftdi_read_data(device->ftdi, dst, (int)len);
+        if (ret < 0) {
+            LT_LOG_S2_ERROR(s2, "FTDI read failed: %s", ftdi_get_error_string(device->ftdi));
+            return LT_L1_SPI_ERROR;
+        }
+        dst += ret;
+        len -= (size_t)ret;
+        if (len && (ftdi_now_us() > deadline_us)) {
+            LT_LOG_S2_ERROR(s2, "FTDI read timed out");
+            return LT_L1_SPI_ERROR;
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Submits queued commands by one bulk write and reads bytes clocked in by one bulk read */
+static lt_ret_t ftdi_flush(lt_l2_state_t *s2, uint32_t timeout_ms)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+    lt_ret_t ret = LT_OK;
+
+    if (device->rx_len) {
+        // Otherwise the chip returns the data only after its latency timer
+        const uint8_t cmd = MPSSE_SEND_IMMEDIATE;
+        ftdi_queue(device, &cmd, 1);
+    }
+    if (device->cmd_len && (ftdi_write_data(device->ftdi, device->cmd, (int)device->cmd_len) != (int)device->cmd_len)) {
+        LT_LOG_S2_ERROR(s2, "FTDI write failed: %s", ftdi_get_error_string(device->ftdi));
+        ret = LT_L1_SPI_ERROR;
+    }
+
+    uint64_t deadline_us = ftdi_now_us() + ((uint64_t)timeout_ms * 1000u);
+    for (uint8_t i = 0; (ret == LT_OK) && (i < device->rx_cnt); i++) {
+        ret = ftdi_read_exact(s2, device->rx[i].dst, device->rx[i].len, deadline_us);
+    }
+
+    device->cmd_len = 0;
+    device->rx_cnt = 0;
+    device->rx_len = 0;
+
+    return ret;
+}
+
+/** Synchronizes with MPSSE: answer to an invalid command is the first byte clocked in after the reset */
+static lt_ret_t ftdi_sync(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+    uint8_t cmd = MPSSE_BAD_CMD;
+    uint8_t echo[2];
+
+    if (ftdi_write_data(device->ftdi, &cmd, 1) != 1) {
+        return LT_FAIL;
+    }
+    if (ftdi_read_exact(s2, echo, sizeof(echo), ftdi_now_us() + 100000u) != LT_OK) {
+        return LT_FAIL;
+    }
+    if ((echo[0] != MPSSE_BAD_CMD_ECHO) || (echo[1] != MPSSE_BAD_CMD)) {
+        LT_LOG_S2_ERROR(s2, "MPSSE is not in sync");
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+static lt_ret_t ftdi_open(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+    int vid = device->vid ? device->vid : FTDI_VID_DEFAULT;
+    int pid = device->pid ? device->pid : FTDI_PID_DEFAULT;
+    enum ftdi_interface interface = device->interface ? (enum ftdi_interface)device->interface : INTERFACE_A;
+
+    if ((ftdi_set_interface(device->ftdi, interface) < 0)
+        || (ftdi_usb_open_desc(device->ftdi, vid, pid, NULL, device->serial[0] ? device->serial : NULL) < 0)) {
+        LT_LOG_S2_ERROR(s2, "Can't open FTDI %04x:%04x: %s", vid, pid, ftdi_get_error_string(device->ftdi));
+        return LT_FAIL;
+    }
+
+    // Latency timer matters only for reads not finished by MPSSE_SEND_IMMEDIATE
+    if ((ftdi_usb_reset(device->ftdi) < 0) || (ftdi_set_latency_timer(device->ftdi, 1) < 0)
+        || (ftdi_set_bitmode(device->ftdi, 0, BITMODE_RESET) < 0)
+        || (ftdi_set_bitmode(device->ftdi, 0, BITMODE_MPSSE) < 0) || (ftdi_tcioflush(device->ftdi) < 0)) {
+        LT_LOG_S2_ERROR(s2, "Can't switch FTDI to MPSSE: %s", ftdi_get_error_string(device->ftdi));
+        ftdi_usb_close(device->ftdi);
+        return LT_FAIL;
+    }
+    if (ftdi_sync(s2) != LT_OK) {
+        ftdi_usb_close(device->ftdi);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    if (!device->cs_pin) {
+        device->cs_pin = FTDI_CS_PIN_DEFAULT;
+    }
+    if ((device->cs_pin < 3) || (device->cs_pin > 7)) {
+        LT_LOG_S2_ERROR(s2, "Chip select has to be on ADBUS3 to ADBUS7");
+        return LT_PARAM_ERR;
+    }
+#if LT_USE_INT_PIN
+    if ((device->int_pin < 3) || (device->int_pin > 7) || (device->int_pin == device->cs_pin)) {
+        LT_LOG_S2_ERROR(s2, "INT pin has to be on ADBUS3 to ADBUS7, other than chip select");
+        return LT_PARAM_ERR;
+    }
+#endif
+
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&device->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
+    srand(device->rng_seed);
+    lt_unix_rng_wipe(&device->rng);
+
+    device->cmd_len = 0;
+    device->rx_cnt = 0;
+    device->rx_len = 0;
+    device->ftdi = ftdi_new();
+    if (!device->ftdi) {
+        LT_LOG_S2_ERROR(s2, "Can't allocate libftdi context");
+        return LT_FAIL;
+    }
+    if (ftdi_open(s2) != LT_OK) {
+        ftdi_free(device->ftdi);
+        device->ftdi = NULL;
+        return LT_FAIL;
+    }
+
+    // SCK low (SPI mode 0) and chip select high, MISO and INT pin are inputs
+    device->pins_idle = (uint8_t)(1u << device->cs_pin);
+    device->pins_dir = (uint8_t)(FTDI_PIN_SCK | FTDI_PIN_MOSI | (1u << device->cs_pin));
+    const uint8_t cmd[] = {MPSSE_DIV5_OFF, MPSSE_ADAPTIVE_OFF, MPSSE_3PHASE_OFF, MPSSE_LOOPBACK_OFF};
+    ftdi_queue(device, cmd, sizeof(cmd));
+    uint32_t hz = ftdi_queue_speed(device, device->spi_speed ? device->spi_speed : FTDI_SPI_SPEED_DEFAULT);
+    ftdi_queue_cs(device, 1);
+    LT_LOG_S2_DEBUG(s2, "FTDI SPI speed: %" PRIu32, hz);
+
+    lt_ret_t ret = ftdi_flush(s2, FTDI_TIMEOUT_MS);
+    if (ret != LT_OK) {
+        ftdi_usb_close(device->ftdi);
+        ftdi_free(device->ftdi);
+        device->ftdi = NULL;
+    }
+
+    return ret;
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+    lt_ret_t ret = LT_OK;
+
+    lt_unix_rng_wipe(&device->rng);
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&device->lock);
+#endif
+
+    if (device->ftdi) {
+        if ((ftdi_set_bitmode(device->ftdi, 0, BITMODE_RESET) < 0) || (ftdi_usb_close(device->ftdi) < 0)) {
+            ret = LT_FAIL;
+        }
+        ftdi_free(device->ftdi);
+        device->ftdi = NULL;
+    }
+
+    return ret;
+}
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    // Goes to the adapter together with the first transfer
+    ftdi_queue_cs(device, 0);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    ftdi_queue_cs(device, 1);
+
+    return ftdi_flush(s2, FTDI_TIMEOUT_MS);
+}
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    ftdi_queue_transfer(device, s2->buff + offset, s2->buff + offset, tx_data_length);
+
+    return ftdi_flush(s2, timeout_ms);
+}
+
+#if LT_USE_SPI_TRANSFER_BUF
+lt_ret_t lt_port_spi_transfer_buf(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                  uint32_t timeout_ms)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    if (len > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    // Bytes read from the adapter are copied to rx by the flush
+    ftdi_queue_transfer(device, tx ? tx : rx, rx, len);
+
+    return ftdi_flush(s2, timeout_ms);
+}
+#endif
+
+#if LT_USE_SPI_TRANSACTION
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    if (seg_cnt > LT_L1_SPI_SEGMENTS_MAX) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if (segs[i].offset + segs[i].len > LT_L1_LEN_MAX) {
+            return LT_L1_DATA_LEN_ERROR;
+        }
+    }
+
+    // All frames of the transaction go in one bulk write
+    ftdi_queue_cs(device, 0);
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        const lt_l1_spi_segment_t *seg = &segs[i];
+        if (seg->tx) {
+            ftdi_queue_transfer(device, seg->tx, NULL, seg->len);
+        }
+        else {
+            ftdi_queue_transfer(device, s2->buff + seg->offset, s2->buff + seg->offset, seg->len);
+        }
+        if (!seg->cs_hold) {
+            ftdi_queue_cs(device, 1);
+            if (i + 1 < seg_cnt) {
+                ftdi_queue_cs(device, 0);
+            }
+        }
+    }
+
+    return ftdi_flush(s2, timeout_ms);
+}
+#endif
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    return lt_unix_delay(&device->delay, s2, (uint64_t)ms * 1000);
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    return lt_unix_delay(&device->delay, s2, us);
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    // Chip select is high, nothing else is queued
+    *actual_hz = ftdi_queue_speed(device, hz);
+    device->spi_speed = hz;
+
+    return ftdi_flush(s2, FTDI_TIMEOUT_MS);
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+    uint64_t deadline_us = ftdi_now_us() + ((uint64_t)ms * 1000u);
+    const uint8_t cmd = MPSSE_GET_LOW;
+
+    for (;;) {
+        uint8_t pins;
+        ftdi_queue(device, &cmd, 1);
+        device->rx[0].dst = &pins;
+        device->rx[0].len = 1;
+        device->rx_cnt = 1;
+        device->rx_len = 1;
+        lt_ret_t ret = ftdi_flush(s2, ms);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (pins & (1u << device->int_pin)) {
+            return LT_OK;
+        }
+        if (ftdi_now_us() >= deadline_us) {
+            return LT_L1_INT_TIMEOUT;
+        }
+        ret = lt_unix_delay(&device->delay, s2, FTDI_INT_POLL_US);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    lt_unix_lock_take(&device->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    lt_unix_lock_release(&device->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    lt_dev_unix_ftdi_t *device = (lt_dev_unix_ftdi_t *)(s2->device);
+
+    return lt_unix_rng_bytes(&device->rng, buff, count);
+}
@@ -0,0 +1,94 @@
+#ifndef LIBTROPIC_PORT_UNIX_FTDI_H
+#define LIBTROPIC_PORT_UNIX_FTDI_H
+
+/**
+ * @file libtropic_port_unix_ftdi.h
+ * @author Tropic Square s.r.o.
+ * @brief Port for SPI driven directly by MPSSE of FTDI FT2232H (or FT232H, FT4232H) through libftdi1.
+ *
+ * Chip select edges, transfers and reads of the INT pin are encoded as MPSSE commands into one buffer, which is
+ * submitted by a single USB bulk write, and everything clocked in is read back by a single bulk read. With
+ * LT_USE_SPI_TRANSACTION a whole L1 transaction is one such exchange, so its latency is close to one frame of USB
+ * (125 us of high speed USB, 1 ms of the latency timer at worst). Link with `libftdi1` (pkg-config module
+ * `libftdi1`).
+ *
+ * Pins of the MPSSE interface: ADBUS0 SCK, ADBUS1 MOSI, ADBUS2 MISO, chip select and INT pin on other pins of ADBUS.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_port.h"
+#include "libtropic_port_unix_delay.h"
+#include "libtropic_port_unix_lock.h"
+#include "libtropic_port_unix_rng.h"
+
+/** @brief Size of the buffer of MPSSE commands, enough for the longest L1 transaction */
+#define LT_UNIX_FTDI_CMD_SIZE (LT_L1_SPI_SEGMENTS_MAX * (LT_L1_LEN_MAX + 9) + 8)
+
+struct ftdi_context;
+
+/** @private @brief Place where bytes clocked in by one queued transfer are stored. */
+typedef struct lt_unix_ftdi_rx_t {
+    uint8_t *dst;
+    uint16_t len;
+} lt_unix_ftdi_rx_t;
+
+/**
+ * @brief Device structure for Unix FTDI MPSSE port.
+ *
+ * @note Public members are meant to be configured by the developer before passing the handle to
+ *       libtropic.
+ */
+typedef struct lt_dev_unix_ftdi_t {
+    /** @public @brief USB vendor ID, 0 uses 0x0403. */
+    uint16_t vid;
+    /** @public @brief USB product ID, 0 uses 0x6010 of FT2232H (boards with the TS11 EEPROM config use 0x6011). */
+    uint16_t pid;
+    /** @public @brief Serial number of the adapter, empty string opens the first one found. */
+    char serial[DEVICE_PATH_MAX_LEN];
+    /** @public @brief Interface of the adapter with MPSSE, 0 uses interface A. */
+    int interface;
+    /** @public @brief SPI clock in Hz, 0 uses 5 MHz. Clock is 30 MHz divided by a whole number. */
+    uint32_t spi_speed;
+    /** @public @brief ADBUS pin (3 to 7) used for chip select, 0 uses ADBUS3. */
+    uint8_t cs_pin;
+#if LT_USE_INT_PIN
+    /** @public @brief ADBUS pin (3 to 7) connected to TROPIC01's INT pin, it is polled by MPSSE reads. */
+    uint8_t int_pin;
+#endif
+    /**
+     * @public @brief Seed for rand(), which is seeded during lt_port_init(). Random bytes for libtropic are taken
+     *                from the operating system.
+     */
+    unsigned int rng_seed;
+    /** @public @brief Precision of lt_port_delay() and lt_port_delay_us(), zero initialized only sleeps. */
+    lt_unix_delay_t delay;
+
+    /** @private @brief Context of libftdi. */
+    struct ftdi_context *ftdi;
+    /** @private @brief Value of ADBUS pins driven while chip select is high. */
+    uint8_t pins_idle;
+    /** @private @brief Direction of ADBUS pins. */
+    uint8_t pins_dir;
+    /** @private @brief Queued MPSSE commands. */
+    uint8_t cmd[LT_UNIX_FTDI_CMD_SIZE];
+    /** @private @brief Number of queued bytes in `cmd`. */
+    size_t cmd_len;
+    /** @private @brief Destinations of bytes clocked in by queued transfers. */
+    lt_unix_ftdi_rx_t rx[LT_L1_SPI_SEGMENTS_MAX];
+    /** @private @brief Number of items in `rx`. */
+    uint8_t rx_cnt;
+    /** @private @brief Number of bytes clocked in by queued transfers. */
+    size_t rx_len;
+    /** @private @brief Pool of random bytes from the operating system. */
+    lt_unix_rng_t rng;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
+} lt_dev_unix_ftdi_t;
+
+#endif  // LIBTROPIC_PORT_UNIX_FTDI_H
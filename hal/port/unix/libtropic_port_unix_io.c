@@ -0,0 +1,343 @@
+/**
+ * @file libtropic_port_unix_io.c
+ * @author Tropic Square s.r.o.
+ * @brief Dedicated I/O thread of one bus, shared by Unix ports.
+ *
+ * Rings are the bounded queue of D. Vyukov: each cell has a sequence number, which equals the position of the next
+ * push into the cell when it is free and the position + 1 when it holds a request. Producers and consumers claim
+ * positions by compare-and-swap of `head`/`tail` and publish cells by release stores of `seq`.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+// pthread_attr_setaffinity_np() and CPU_SET() are GNU extensions
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "libtropic_port_unix_io.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "libtropic_common.h"
+#include "libtropic_l3.h"
+#include "libtropic_logging.h"
+
+_Static_assert((LT_UNIX_IO_RING_LEN & (LT_UNIX_IO_RING_LEN - 1)) == 0, "LT_UNIX_IO_RING_LEN must be a power of two");
+
+static void lt_unix_io_ring_init(lt_unix_io_ring_t *r)
+{
+    for (size_t i = 0; i < LT_UNIX_IO_RING_LEN; i++) {
+        atomic_init(&r->cells[i].seq, i);
+        r->cells[i].req = NULL;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+}
+
+/** Returns false when the ring is full, which cannot happen as long as `in_flight` is respected */
+static bool lt_unix_io_ring_push(lt_unix_io_ring_t *r, lt_unix_io_req_t *req)
+{
+    size_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    for (;;) {
+        lt_unix_io_cell_t *cell = &r->cells[pos & (LT_UNIX_IO_RING_LEN - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->req = req;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return true;
+            }
+            // pos was reloaded by the failed exchange
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+}
+
+/** Returns NULL when the ring is empty */
+static lt_unix_io_req_t *lt_unix_io_ring_pop(lt_unix_io_ring_t *r)
+{
+    size_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    for (;;) {
+        lt_unix_io_cell_t *cell = &r->cells[pos & (LT_UNIX_IO_RING_LEN - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->tail, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                lt_unix_io_req_t *req = cell->req;
+                atomic_store_explicit(&cell->seq, pos + LT_UNIX_IO_RING_LEN, memory_order_release);
+                return req;
+            }
+        }
+        else if (diff < 0) {
+            return NULL;
+        }
+        else {
+            pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        }
+    }
+}
+
+static bool lt_unix_io_ring_empty(lt_unix_io_ring_t *r)
+{
+    size_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    lt_unix_io_cell_t *cell = &r->cells[pos & (LT_UNIX_IO_RING_LEN - 1)];
+
+    return atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1;
+}
+
+static void lt_unix_io_signal(const int fd)
+{
+    uint64_t one = 1;
+
+    // Counter of eventfd can overflow only after 2^64 - 1 signals, short write is not possible
+    if (write(fd, &one, sizeof(one)) != sizeof(one)) {
+        LT_LOG_ERROR("eventfd write failed: %s", strerror(errno));
+    }
+}
+
+static void lt_unix_io_clear(const int fd)
+{
+    uint64_t cnt;
+
+    // Nonblocking, EAGAIN only tells that the counter was zero
+    ssize_t ret_unused = read(fd, &cnt, sizeof(cnt));
+    (void)ret_unused;
+}
+
+static void lt_unix_io_exec(lt_unix_io_t *io, lt_unix_io_req_t *req)
+{
+    req->ret = lt_l3_transfer(req->h);
+    // Never full, the number of requests in both rings is limited by in_flight
+    lt_unix_io_ring_push(&io->cq, req);
+    lt_unix_io_signal(io->done_fd);
+}
+
+static void *lt_unix_io_thread(void *arg)
+{
+    lt_unix_io_t *io = arg;
+    // Without idle callback the thread sleeps until it is kicked
+    int timeout_ms = io->idle ? io->idle_ms : -1;
+
+    for (;;) {
+        lt_unix_io_req_t *req = lt_unix_io_ring_pop(&io->sq);
+        if (req) {
+            lt_unix_io_exec(io, req);
+            continue;
+        }
+        if (atomic_load(&io->stop)) {
+            break;
+        }
+        if (io->idle) {
+            // At most one short exchange, a request submitted meanwhile waits only for its end
+            io->idle(io->idle_ctx);
+            req = lt_unix_io_ring_pop(&io->sq);
+            if (req) {
+                lt_unix_io_exec(io, req);
+                continue;
+            }
+        }
+
+        // Submitter checks the flag after its push, so either it sees the flag set or this thread sees its request
+        atomic_store(&io->sleeping, true);
+        atomic_thread_fence(memory_order_seq_cst);
+        req = lt_unix_io_ring_pop(&io->sq);
+        if (req || atomic_load(&io->stop)) {
+            atomic_store(&io->sleeping, false);
+            if (req) {
+                lt_unix_io_exec(io, req);
+            }
+            continue;
+        }
+
+        struct pollfd pfd = {.fd = io->kick_fd, .events = POLLIN};
+        if ((poll(&pfd, 1, timeout_ms) < 0) && (errno != EINTR)) {
+            LT_LOG_ERROR("poll() of I/O thread failed: %s", strerror(errno));
+        }
+        lt_unix_io_clear(io->kick_fd);
+        atomic_store(&io->sleeping, false);
+    }
+
+    return NULL;
+}
+
+/** Creates the thread, optionally pinned and with real-time priority */
+static int lt_unix_io_create(lt_unix_io_t *io, const int cpu, const int rt_prio)
+{
+    pthread_attr_t attr;
+    int ret = pthread_attr_init(&attr);
+    if (ret) {
+        return ret;
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((size_t)cpu, &set);
+        ret = pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    if (!ret && (rt_prio > 0)) {
+        struct sched_param param = {.sched_priority = rt_prio};
+        ret = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        if (!ret) {
+            ret = pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        }
+        if (!ret) {
+            ret = pthread_attr_setschedparam(&attr, &param);
+        }
+    }
+    if (!ret) {
+        ret = pthread_create(&io->thread, &attr, lt_unix_io_thread, io);
+    }
+    pthread_attr_destroy(&attr);
+
+    return ret;
+}
+
+static void lt_unix_io_close(lt_unix_io_t *io)
+{
+    if (io->kick_fd >= 0) {
+        close(io->kick_fd);
+    }
+    if (io->done_fd >= 0) {
+        close(io->done_fd);
+    }
+    io->kick_fd = -1;
+    io->done_fd = -1;
+}
+
+lt_ret_t lt_unix_io_start(lt_unix_io_t *io, const lt_unix_io_cfg_t *cfg)
+{
+    if (!io) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_unix_io_ring_init(&io->sq);
+    lt_unix_io_ring_init(&io->cq);
+    atomic_init(&io->in_flight, 0);
+    atomic_init(&io->sleeping, false);
+    atomic_init(&io->stop, false);
+    io->idle = cfg ? cfg->idle : NULL;
+    io->idle_ctx = cfg ? cfg->idle_ctx : NULL;
+    io->idle_ms = cfg ? cfg->idle_ms : -1;
+
+    io->kick_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    io->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((io->kick_fd < 0) || (io->done_fd < 0)) {
+        LT_LOG_ERROR("eventfd() failed: %s", strerror(errno));
+        lt_unix_io_close(io);
+        return LT_FAIL;
+    }
+
+    int cpu = cfg ? cfg->cpu : -1;
+    int rt_prio = cfg ? cfg->rt_prio : 0;
+    int ret = lt_unix_io_create(io, cpu, rt_prio);
+    if ((ret == EPERM) && (rt_prio > 0)) {
+        LT_LOG_WARN("Real-time priority of I/O thread is not permitted, using default scheduling");
+        ret = lt_unix_io_create(io, cpu, 0);
+    }
+    if (ret) {
+        LT_LOG_ERROR("I/O thread was not created: %s", strerror(ret));
+        lt_unix_io_close(io);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+void lt_unix_io_stop(lt_unix_io_t *io)
+{
+    atomic_store(&io->stop, true);
+    lt_unix_io_signal(io->kick_fd);
+    pthread_join(io->thread, NULL);
+    lt_unix_io_close(io);
+}
+lt_ret_t lt_unix_io_submit(lt_unix_io_t *io, lt_unix_io_req_t *req)
+{
+    if (!io || !req || !req->h) {
+        return LT_PARAM_ERR;
+    }
+
+    // Reserve place in both rings first
+    unsigned int n = atomic_load_explicit(&io->in_flight, memory_order_relaxed);
+    do {
+        if (n >= LT_UNIX_IO_RING_LEN) {
+            return LT_BUSY;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&io->in_flight, &n, n + 1, memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    lt_unix_io_ring_push(&io->sq, req);
+
+    // Pairs with the fence of the I/O thread going to sleep
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_exchange(&io->sleeping, false)) {
+        lt_unix_io_signal(io->kick_fd);
+    }
+
+    return LT_OK;
+}
+
+lt_unix_io_req_t *lt_unix_io_reap(lt_unix_io_t *io)
+{
+    if (!io) {
+        return NULL;
+    }
+
+    lt_unix_io_req_t *req = lt_unix_io_ring_pop(&io->cq);
+    if (req) {
+        atomic_fetch_sub_explicit(&io->in_flight, 1, memory_order_relaxed);
+    }
+
+    return req;
+}
+
+int lt_unix_io_fd(const lt_unix_io_t *io) { return io->done_fd; }
+
+lt_unix_io_req_t *lt_unix_io_wait(lt_unix_io_t *io, int timeout_ms)
+{
+    for (;;) {
+        lt_unix_io_req_t *req = lt_unix_io_reap(io);
+        if (req) {
+            // Signal may have been cleared by this thread, other waiters must not sleep on remaining completions
+            if (!lt_unix_io_ring_empty(&io->cq)) {
+                lt_unix_io_signal(io->done_fd);
+            }
+            return req;
+        }
+
+        struct pollfd pfd = {.fd = io->done_fd, .events = POLLIN};
+        int ret = poll(&pfd, 1, timeout_ms);
+        if (ret == 0) {
+            // Completion could come just before the timeout
+            return lt_unix_io_reap(io);
+        }
+        if ((ret < 0) && (errno != EINTR)) {
+            LT_LOG_ERROR("poll() failed: %s", strerror(errno));
+            return NULL;
+        }
+        // Signal is cleared before reaping, so a completion signalled later is not lost
+        lt_unix_io_clear(io->done_fd);
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef LIBTROPIC_PORT_UNIX_IO_H
+#define LIBTROPIC_PORT_UNIX_IO_H
+
+/**
+ * @file libtropic_port_unix_io.h
+ * @author Tropic Square s.r.o.
+ * @brief Dedicated I/O thread of one bus, shared by Unix ports.
+ *
+ * Application threads encode and encrypt L3 commands by `lt_out__*()` functions, hand the handles to the I/O thread
+ * by `lt_unix_io_submit()` and decrypt results by `lt_in__*()` functions once the requests are completed. The I/O
+ * thread only executes `lt_l3_transfer()` of submitted handles one after another, so the bus is used by one thread
+ * without any mutex and host cryptography is kept off it. The thread can be pinned to a CPU and given real-time
+ * priority, which cuts jitter of polling TROPIC01 for results.
+ *
+ * Requests are passed through bounded lock-free rings in both directions. The I/O thread sleeps on an eventfd when
+ * it has nothing to do, completions are signalled by another eventfd, which can be waited for by poll() or epoll
+ * together with other file descriptors of the application.
+ *
+ * A handle waiting in the queue or being executed must not be used by any other thread. Handles using
+ * LT_L3_BUFF_POOL must hold a buffer borrowed by `lt_l3_buff_borrow()`, LT_L3_STREAM_DECRYPT would decrypt results
+ * on the I/O thread.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Number of requests which can be submitted and not yet reaped, power of two */
+#ifndef LT_UNIX_IO_RING_LEN
+#define LT_UNIX_IO_RING_LEN 64
+#endif
+
+/** @brief Request executed by the I/O thread. */
+typedef struct lt_unix_io_req_t {
+    /** @public @brief Handle with a command encoded by one of `lt_out__*()` functions. */
+    lt_handle_t *h;
+    /** @public @brief Context of the application, not used by the I/O thread. */
+    void *ctx;
+    /** @public @brief Result of `lt_l3_transfer()`, valid when the request is returned by `lt_unix_io_reap()`. */
+    lt_ret_t ret;
+} lt_unix_io_req_t;
+
+/** @private @brief Cell of a ring, `seq` tells whether it is free or holds a request, see libtropic_port_unix_io.c */
+typedef struct lt_unix_io_cell_t {
+    atomic_size_t seq;
+    lt_unix_io_req_t *req;
+} lt_unix_io_cell_t;
+
+/** @private @brief Bounded ring of requests, any number of threads may push and pop. */
+typedef struct lt_unix_io_ring_t {
+    lt_unix_io_cell_t cells[LT_UNIX_IO_RING_LEN];
+    /** Kept on separate cache lines, so producers and consumers do not share them */
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+} lt_unix_io_ring_t;
+
+/** @brief Configuration of the I/O thread. */
+typedef struct lt_unix_io_cfg_t {
+    /** @public @brief CPU the thread is pinned to, negative value for no pinning. */
+    int cpu;
+    /**
+     * @public @brief SCHED_FIFO priority of the thread, 0 for the default scheduling. When the real-time priority
+     * is not permitted, the thread is started with the default scheduling and a warning is logged.
+     */
+    int rt_prio;
+    /**
+     * @public @brief Called by the I/O thread while no request is submitted, e.g. to drain firmware log by
+     * `lt_log_drain_poll()` with a handle which is not submitted. NULL when the thread only sleeps.
+     */
+    void (*idle)(void *ctx);
+    /** @public @brief Context passed to `idle`. */
+    void *idle_ctx;
+    /** @public @brief Time between calls of `idle` in ms, a submitted request wakes the thread earlier. */
+    int idle_ms;
+} lt_unix_io_cfg_t;
+
+/** @brief I/O thread of one bus, initialized by `lt_unix_io_start()`. */
+typedef struct lt_unix_io_t {
+    /** @private @brief Submitted requests. */
+    lt_unix_io_ring_t sq;
+    /** @private @brief Completed requests. */
+    lt_unix_io_ring_t cq;
+    /** @private @brief Number of submitted requests not yet reaped, limits both rings. */
+    atomic_uint in_flight;
+    /** @private @brief Set by the I/O thread before it sleeps on `kick_fd`. */
+    atomic_bool sleeping;
+    /** @private @brief Set by `lt_unix_io_stop()`. */
+    atomic_bool stop;
+    /** @private @brief Eventfd waking up the I/O thread. */
+    int kick_fd;
+    /** @private @brief Eventfd signalled for completed requests. */
+    int done_fd;
+    /** @private @brief The I/O thread. */
+    pthread_t thread;
+    /** @private @brief Copy of `lt_unix_io_cfg_t.idle`. */
+    void (*idle)(void *ctx);
+    /** @private @brief Copy of `lt_unix_io_cfg_t.idle_ctx`. */
+    void *idle_ctx;
+    /** @private @brief Copy of `lt_unix_io_cfg_t.idle_ms`. */
+    int idle_ms;
+} lt_unix_io_t;
+
+/**
+ * @brief Starts the I/O thread.
+ *
+ * @param io   I/O thread to be started
+ * @param cfg  Configuration of the thread, NULL for no pinning and default scheduling
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_io_start(lt_unix_io_t *io, const lt_unix_io_cfg_t *cfg);
+
+/**
+ * @brief Stops the I/O thread after all submitted requests are executed. Requests not reaped yet are lost.
+ *
+ * @param io   I/O thread started by `lt_unix_io_start()`
+ */
+void lt_unix_io_stop(lt_unix_io_t *io);
+
+/**
+ * @brief Queues a request for the I/O thread, never blocks. The request has to be valid until it is reaped.
+ *
+ * @param io   I/O thread
+ * @param req  Request with the handle
+ * @return LT_OK if success, LT_BUSY when `LT_UNIX_IO_RING_LEN` requests are submitted and not yet reaped.
+ */
+lt_ret_t lt_unix_io_submit(lt_unix_io_t *io, lt_unix_io_req_t *req);
+
+/**
+ * @brief Takes one completed request, never blocks.
+ *
+ * @param io   I/O thread
+ * @return Completed request, NULL when there is none.
+ */
+lt_unix_io_req_t *lt_unix_io_reap(lt_unix_io_t *io);
+
+/**
+ * @brief Returns eventfd, which is readable when requests were completed, e.g. for poll() or epoll.
+ * @note Reading it (8 bytes) clears it, completed requests are then reaped by `lt_unix_io_reap()` until NULL.
+ *
+ * @param io   I/O thread
+ * @return File descriptor.
+ */
+int lt_unix_io_fd(const lt_unix_io_t *io);
+
+/**
+ * @brief Waits until a request is completed and takes it.
+ *
+ * @param io          I/O thread
+ * @param timeout_ms  Maximal time to wait, negative value to wait without limit
+ * @return Completed request, NULL on timeout.
+ */
+lt_unix_io_req_t *lt_unix_io_wait(lt_unix_io_t *io, int timeout_ms);
+
+#endif  // LIBTROPIC_PORT_UNIX_IO_H
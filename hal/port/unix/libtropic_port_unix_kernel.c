@@ -0,0 +1,244 @@
+/**
+ * @file libtropic_port_unix_kernel.c
+ * @author Tropic Square s.r.o.
+ * @brief Port for communication through the character device of the tropic01_spi kernel driver.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_PORT_OPS
+// Port functions get names of their own, so the port can be linked together with other ports
+#define LT_PORT_OPS_PREFIX lt_port_unix_kernel
+#include "libtropic_port_ops.h"
+#endif
+
+#include "libtropic_port_unix_kernel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "kernel/tropic01_spi_uapi.h"
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&device->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
+    srand(device->rng_seed);
+    lt_unix_rng_wipe(&device->rng);
+
+    device->fd = open(device->dev_path, O_RDWR | O_CLOEXEC);
+    if (device->fd < 0) {
+        LT_LOG_ERROR("Can't open %s: %s", device->dev_path, strerror(errno));
+        return LT_FAIL;
+    }
+    device->timeout_ms = 0;
+#if LT_L1_OFFLOAD
+    // The driver executes whole L1 transactions
+    s2->l1_offload = 1;
+#endif
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    lt_unix_rng_wipe(&device->rng);
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&device->lock);
+#endif
+
+    if (close(device->fd)) {
+        LT_LOG_ERROR("close() failed: %s", strerror(errno));
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+static lt_ret_t kernel_csn(lt_dev_unix_kernel_t *device, uint32_t high)
+{
+    if (ioctl(device->fd, TROPIC01_IOC_CSN, &high) < 0) {
+        LT_LOG_ERROR("Can't drive chip select %s: %s", high ? "high" : "low", strerror(errno));
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
+{
+    return kernel_csn((lt_dev_unix_kernel_t *)(s2->device), 0);
+}
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
+{
+    return kernel_csn((lt_dev_unix_kernel_t *)(s2->device), 1);
+}
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    struct tropic01_spi_xfer xfer = {.buf = (uintptr_t)(s2->buff + offset), .len = tx_data_length};
+    if (ioctl(device->fd, TROPIC01_IOC_XFER, &xfer) < 0) {
+        LT_LOG_ERROR("SPI transfer failed: %s", strerror(errno));
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+#if LT_L1_OFFLOAD
+lt_ret_t lt_port_l1_write(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt, uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+    uint8_t frame[LT_L1_LEN_MAX];
+    const uint8_t *data = s2->buff;
+    size_t len = 0;
+
+    // Frame contiguous in the L2 buffer is written in place, segments sent from elsewhere are gathered
+    if ((seg_cnt == 1) && !segs[0].tx) {
+        data = s2->buff + segs[0].offset;
+        len = segs[0].len;
+    }
+    else {
+        for (uint8_t i = 0; i < seg_cnt; i++) {
+            if (len + segs[i].len > sizeof(frame)) {
+                return LT_L1_DATA_LEN_ERROR;
+            }
+            memcpy(frame + len, segs[i].tx ? segs[i].tx : s2->buff + segs[i].offset, segs[i].len);
+            len += segs[i].len;
+        }
+        data = frame;
+    }
+
+    if (write(device->fd, data, len) != (ssize_t)len) {
+        LT_LOG_ERROR("Write of L1 frame failed: %s", strerror(errno));
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_l1_read(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    // Timeout is the same for most reads, the driver keeps it
+    if ((timeout_ms != device->timeout_ms) && (ioctl(device->fd, TROPIC01_IOC_TIMEOUT, &timeout_ms) == 0)) {
+        device->timeout_ms = timeout_ms;
+    }
+
+    ssize_t len = read(device->fd, s2->buff, max_len);
+    if (len >= 3 + 2) {
+        return LT_OK;
+    }
+    if (len >= 0) {
+        LT_LOG_ERROR("Read of L1 response returned %zd bytes.", len);
+        return LT_L1_SPI_ERROR;
+    }
+
+    const int err = errno;
+    uint8_t chip_status;
+    if (ioctl(device->fd, TROPIC01_IOC_CHIP_STATUS, &chip_status) == 0) {
+        s2->buff[0] = chip_status;
+    }
+    switch (err) {
+        case ETIMEDOUT:
+            return LT_L1_CHIP_BUSY;
+        case ENOTRECOVERABLE:
+            return LT_L1_CHIP_ALARM_MODE;
+        case EMSGSIZE:
+            return LT_L1_DATA_LEN_ERROR;
+        default:
+            LT_LOG_ERROR("Read of L1 response failed: %s", strerror(err));
+            return LT_L1_SPI_ERROR;
+    }
+}
+#endif
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    return lt_unix_delay(&device->delay, s2, (uint64_t)ms * 1000);
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    return lt_unix_delay(&device->delay, s2, us);
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    lt_unix_lock_take(&device->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    lt_unix_lock_release(&device->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    lt_dev_unix_kernel_t *device = (lt_dev_unix_kernel_t *)(s2->device);
+
+    return lt_unix_rng_bytes(&device->rng, buff, count);
+}
+
+#if LT_PORT_OPS
+const lt_port_ops_t lt_port_unix_kernel_ops = {
+    .init = lt_port_init,
+    .deinit = lt_port_deinit,
+    .spi_csn_low = lt_port_spi_csn_low,
+    .spi_csn_high = lt_port_spi_csn_high,
+    .spi_transfer = lt_port_spi_transfer,
+    .delay = lt_port_delay,
+#if LT_USE_DELAY_US
+    .delay_us = lt_port_delay_us,
+#endif
+#if LT_THREAD_SAFE
+    .lock = lt_port_lock,
+    .unlock = lt_port_unlock,
+#endif
+    .random_bytes = lt_port_random_bytes,
+#if LT_L1_OFFLOAD
+    .l1_write = lt_port_l1_write,
+    .l1_read = lt_port_l1_read,
+#endif
+};
+#endif
@@ -0,0 +1,58 @@
+#ifndef LIBTROPIC_PORT_UNIX_KERNEL_H
+#define LIBTROPIC_PORT_UNIX_KERNEL_H
+
+/**
+ * @file libtropic_port_unix_kernel.h
+ * @author Tropic Square s.r.o.
+ * @brief Port for communication through the character device of the tropic01_spi kernel driver.
+ *
+ * With LT_L1_OFFLOAD, one L2 exchange costs one write() of the request frame and one read() of the response, the
+ * driver polls CHIP_STATUS (or waits on INT) in the kernel, see hal/port/unix/kernel/. Without it, libtropic drives
+ * the transactions by raw ioctls of the driver.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_port.h"
+#include "libtropic_port_ops.h"
+#include "libtropic_port_unix_delay.h"
+#include "libtropic_port_unix_lock.h"
+#include "libtropic_port_unix_rng.h"
+
+/**
+ * @brief Device structure for Unix kernel driver port.
+ *
+ * @note Public members are meant to be configured by the developer before passing the handle to
+ *       libtropic.
+ */
+typedef struct lt_dev_unix_kernel_t {
+    /** @public @brief Path to the character device of the driver, e.g. /dev/tropic01-spi0.0. */
+    char dev_path[DEVICE_PATH_MAX_LEN];
+    /**
+     * @public @brief Seed for rand(), which is seeded during lt_port_init(). Random bytes for libtropic are taken
+     *                from the operating system.
+     */
+    unsigned int rng_seed;
+    /** @public @brief Precision of lt_port_delay() and lt_port_delay_us(), zero initialized only sleeps. */
+    lt_unix_delay_t delay;
+
+    /** @private @brief Character device file descriptor. */
+    int fd;
+    /** @private @brief Timeout of reads last set in the driver, 0 when not set yet. */
+    uint32_t timeout_ms;
+    /** @private @brief Pool of random bytes from the operating system. */
+    lt_unix_rng_t rng;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
+} lt_dev_unix_kernel_t;
+
+#if LT_PORT_OPS
+/** @brief Functions of the port for `lt_l2_state_t.ops`, when the port is compiled with LT_PORT_OPS */
+extern const lt_port_ops_t lt_port_unix_kernel_ops;
+#endif
+
+#endif  // LIBTROPIC_PORT_UNIX_KERNEL_H
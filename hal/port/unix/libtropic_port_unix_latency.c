@@ -0,0 +1,493 @@
+/**
+ * @file libtropic_port_unix_latency.c
+ * @author Tropic Square s.r.o.
+ * @brief Port emulating execution and transfer times of TROPIC01 in front of another port.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+// Port functions get names of their own, the wrapped port is linked together with this one
+#define LT_PORT_OPS_PREFIX lt_port_unix_latency
+#include "libtropic_port_ops.h"
+
+#include "libtropic_port_unix_latency.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+
+/** Request ID of L1 polls of CHIP_STATUS, GET_RESPONSE_REQ_ID of lt_l1.h */
+#define LATENCY_GET_RESPONSE_REQ_ID 0xAA
+/** LT_L2_ENCRYPTED_CMD_REQ_ID of lt_l2_api_structs.h */
+#define LATENCY_ENCRYPTED_CMD_REQ_ID 0x04
+/** READY bit of CHIP_STATUS, CHIP_MODE_READY_bit of lt_l1.h */
+#define LATENCY_CHIP_READY 0x01
+
+static uint64_t latency_mono_us(void)
+{
+    struct timespec ts;
+
+    // CLOCK_MONOTONIC is always supported on Linux
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
+
+/** Current time of the chip */
+static uint64_t latency_now(lt_dev_unix_latency_t *dev)
+{
+    if (!dev->virtual_clock) {
+        dev->now_us = latency_mono_us() - dev->start_us;
+    }
+
+    return dev->now_us;
+}
+
+/** Lets the time pass, the clock of the chip only advances when it is virtual */
+static lt_ret_t latency_wait(lt_dev_unix_latency_t *dev, lt_l2_state_t *s2, const uint64_t us)
+{
+    if (dev->virtual_clock) {
+        dev->now_us += us;
+        return LT_OK;
+    }
+
+    return lt_unix_delay(&dev->delay, s2, us);
+}
+
+/** Xorshift32, the same seed gives the same jitter and CRC errors */
+static uint32_t latency_rand(lt_dev_unix_latency_t *dev)
+{
+    uint32_t x = dev->rng;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    dev->rng = x;
+
+    return x;
+}
+
+/** Entry of the ID in the table, NULL when it is missing */
+static const lt_unix_latency_entry_t *latency_entry(const lt_dev_unix_latency_t *dev, const uint16_t id)
+{
+    for (uint8_t i = 0; dev->table && (i < dev->table_cnt); i++) {
+        if (dev->table[i].id == id) {
+            return &dev->table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Starts execution of the request written under the last chip select. Chunks of an L3 command are taken right away,
+ * the command executes after the last one.
+ */
+static void latency_execute(lt_dev_unix_latency_t *dev)
+{
+    const lt_unix_latency_entry_t *entry = NULL;
+
+    if (dev->frame[0] == LATENCY_ENCRYPTED_CMD_REQ_ID) {
+        // First chunk starts with the size of the command, each chunk carries REQ_LEN bytes of the L3 packet
+        if (!dev->l3_left && (dev->frame_len >= 4)) {
+            const uint16_t cmd_size = (uint16_t)(dev->frame[2] | (dev->frame[3] << 8));
+            dev->l3_left = (uint16_t)(L3_CMD_SIZE_SIZE + cmd_size + L3_TAG_SIZE);
+        }
+        dev->l3_left = (dev->frame[1] < dev->l3_left) ? (uint16_t)(dev->l3_left - dev->frame[1]) : 0;
+        if (dev->l3_left) {
+            return;
+        }
+        if (dev->l3_id) {
+            entry = latency_entry(dev, dev->l3_id);
+            dev->l3_id = 0;
+        }
+    }
+    if (!entry) {
+        entry = latency_entry(dev, LT_UNIX_LATENCY_L2(dev->frame[0]));
+    }
+    if (!entry) {
+        entry = &dev->default_entry;
+    }
+
+    uint64_t exec_us = entry->exec_us;
+    if (entry->jitter_us) {
+        const uint64_t jitter_us = latency_rand(dev) % ((uint64_t)entry->jitter_us * 2 + 1);
+        exec_us = (exec_us + jitter_us > entry->jitter_us) ? exec_us + jitter_us - entry->jitter_us : 0;
+    }
+    dev->busy_until_us = latency_now(dev) + exec_us;
+}
+
+/** Corrupts CRC of the response read under the last chip select at the rate of `crc_error_ppm` */
+static void latency_response(lt_dev_unix_latency_t *dev, lt_l2_state_t *s2)
+{
+    // Only a whole response read when the chip was ready has a CRC
+    if (!(s2->buff[0] & LATENCY_CHIP_READY) || (s2->buff[1] == 0xFF) || (dev->frame_len < 3 + s2->buff[2] + 2)) {
+        return;
+    }
+    if (!dev->crc_error_ppm || ((latency_rand(dev) % 1000000u) >= dev->crc_error_ppm)) {
+        return;
+    }
+
+    s2->buff[3 + s2->buff[2]] ^= 0x01;
+    dev->crc_errors++;
+}
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    if (!dev->ops || !dev->ops->init || !dev->ops->deinit || !dev->ops->spi_csn_low || !dev->ops->spi_csn_high
+        || !dev->ops->spi_transfer || !dev->ops->delay || !dev->ops->random_bytes) {
+        LT_LOG_S2_ERROR(s2, "Wrapped port is not set");
+        return LT_PARAM_ERR;
+    }
+
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&dev->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
+    // Clock of the chip continues from the previous initialization
+    dev->start_us = latency_mono_us() - dev->now_us;
+    dev->rng = dev->seed ? dev->seed : 0x9E3779B9u;
+    dev->busy_until_us = 0;
+    dev->spi_hz = 0;
+    dev->csn_pending = 0;
+    dev->csn_forwarded = 0;
+    dev->busy_frame = 0;
+    dev->frame_len = 0;
+    dev->l3_left = 0;
+    dev->l3_id = 0;
+    dev->chip_status = LATENCY_CHIP_READY;
+
+    s2->device = dev->device;
+    lt_ret_t ret = dev->ops->init(s2);
+    s2->device = dev;
+#if LT_L1_OFFLOAD
+    // Each poll has to pass through the wrapper
+    s2->l1_offload = 0;
+#endif
+
+    return ret;
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    s2->device = dev->device;
+    lt_ret_t ret = dev->ops->deinit(s2);
+    s2->device = dev;
+
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&dev->lock);
+#endif
+
+    return ret;
+}
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    // The wrapped port gets chip select with the first transfer, which tells whether the frame reaches the chip
+    dev->csn_pending = 1;
+    dev->csn_forwarded = 0;
+    dev->busy_frame = 0;
+    dev->frame_len = 0;
+    memset(dev->frame, 0, sizeof(dev->frame));
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    dev->csn_pending = 0;
+    dev->busy_frame = 0;
+    if (!dev->csn_forwarded) {
+        return LT_OK;
+    }
+    dev->csn_forwarded = 0;
+
+    s2->device = dev->device;
+    lt_ret_t ret = dev->ops->spi_csn_high(s2);
+    s2->device = dev;
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    if (dev->frame[0] == LATENCY_GET_RESPONSE_REQ_ID) {
+        latency_response(dev, s2);
+    }
+    else if (dev->frame_len) {
+        latency_execute(dev);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+    lt_ret_t ret;
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    // Header of the request is kept, the transfer overwrites it by MISO bytes
+    for (uint16_t i = offset; (i < sizeof(dev->frame)) && (i < offset + tx_data_length); i++) {
+        dev->frame[i] = s2->buff[i];
+    }
+
+    if (dev->csn_pending) {
+        dev->csn_pending = 0;
+        // Poll of a busy chip does not reach the model, which would answer it right away
+        if ((offset == 0) && (dev->frame[0] == LATENCY_GET_RESPONSE_REQ_ID)
+            && (latency_now(dev) < dev->busy_until_us)) {
+            dev->busy_frame = 1;
+            dev->busy_polls++;
+        }
+        else {
+            s2->device = dev->device;
+            ret = dev->ops->spi_csn_low(s2);
+            s2->device = dev;
+            if (ret != LT_OK) {
+                return ret;
+            }
+            dev->csn_forwarded = 1;
+        }
+    }
+
+    if (dev->bus_hz) {
+        const uint32_t hz = (dev->spi_hz && (dev->spi_hz < dev->bus_hz)) ? dev->spi_hz : dev->bus_hz;
+        ret = latency_wait(dev, s2, ((uint64_t)tx_data_length * 8 * 1000000u + hz - 1) / hz);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+
+    if (dev->busy_frame) {
+        // READY with no response, as the chip answers while it executes a request
+        memset(s2->buff + offset, 0xFF, tx_data_length);
+        if (offset == 0) {
+            s2->buff[0] = dev->chip_status | LATENCY_CHIP_READY;
+        }
+        return LT_OK;
+    }
+
+    s2->device = dev->device;
+    ret = dev->ops->spi_transfer(s2, offset, tx_data_length, timeout_ms);
+    s2->device = dev;
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // 0xFF is read when nothing drives MISO, it tells nothing about the mode
+    if ((offset == 0) && (dev->frame[0] == LATENCY_GET_RESPONSE_REQ_ID) && (s2->buff[0] != 0xFF)) {
+        dev->chip_status = s2->buff[0];
+    }
+    if (offset + tx_data_length > dev->frame_len) {
+        dev->frame_len = (uint16_t)(offset + tx_data_length);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    if (dev->virtual_clock) {
+        dev->now_us += (uint64_t)ms * 1000;
+    }
+
+    s2->device = dev->device;
+    lt_ret_t ret = dev->ops->delay(s2, ms);
+    s2->device = dev;
+
+    return ret;
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+    lt_ret_t ret;
+
+    if (dev->virtual_clock) {
+        dev->now_us += us;
+    }
+
+    s2->device = dev->device;
+    if (dev->ops->delay_us) {
+        ret = dev->ops->delay_us(s2, us);
+    }
+    else {
+        ret = dev->ops->delay(s2, LT_US_TO_MS_CEIL(us));
+    }
+    s2->device = dev;
+
+    return ret;
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    // INT pin is asserted when the execution completes
+    const uint64_t now_us = latency_now(dev);
+    const uint64_t left_us = (dev->busy_until_us > now_us) ? dev->busy_until_us - now_us : 0;
+    if (left_us > (uint64_t)ms * 1000) {
+        lt_ret_t ret = latency_wait(dev, s2, (uint64_t)ms * 1000);
+        return (ret != LT_OK) ? ret : LT_L1_INT_TIMEOUT;
+    }
+
+    return latency_wait(dev, s2, left_us);
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+    lt_ret_t ret = LT_OK;
+
+    *actual_hz = hz;
+    if (dev->ops->spi_speed_set) {
+        s2->device = dev->device;
+        ret = dev->ops->spi_speed_set(s2, hz, actual_hz);
+        s2->device = dev;
+    }
+    if (ret == LT_OK) {
+        dev->spi_hz = *actual_hz;
+    }
+
+    return ret;
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    lt_unix_lock_take(&dev->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    lt_unix_lock_release(&dev->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    lt_dev_unix_latency_t *dev = (lt_dev_unix_latency_t *)(s2->device);
+
+    s2->device = dev->device;
+    lt_ret_t ret = dev->ops->random_bytes(s2, buff, count);
+    s2->device = dev;
+
+    return ret;
+}
+
+const lt_port_ops_t lt_port_unix_latency_ops = {
+    .init = lt_port_init,
+    .deinit = lt_port_deinit,
+    .spi_csn_low = lt_port_spi_csn_low,
+    .spi_csn_high = lt_port_spi_csn_high,
+    .spi_transfer = lt_port_spi_transfer,
+    .delay = lt_port_delay,
+#if LT_USE_DELAY_US
+    .delay_us = lt_port_delay_us,
+#endif
+#if LT_USE_INT_PIN
+    .delay_on_int = lt_port_delay_on_int,
+#endif
+#if LT_USE_SPI_SPEED
+    .spi_speed_set = lt_port_spi_speed_set,
+#endif
+#if LT_THREAD_SAFE
+    .lock = lt_port_lock,
+    .unlock = lt_port_unlock,
+#endif
+    .random_bytes = lt_port_random_bytes,
+};
+
+lt_ret_t lt_unix_latency_table_parse(const char *str, lt_unix_latency_entry_t *entries, const uint8_t max_cnt,
+                                     uint8_t *cnt)
+{
+    if (!str || !entries || !cnt) {
+        return LT_PARAM_ERR;
+    }
+
+    *cnt = 0;
+    const char *p = str;
+    while (*p) {
+        uint16_t layer;
+        if (!strncmp(p, "l2:", 3)) {
+            layer = LT_UNIX_LATENCY_L2(0);
+        }
+        else if (!strncmp(p, "l3:", 3)) {
+            layer = LT_UNIX_LATENCY_L3(0);
+        }
+        else {
+            return LT_PARAM_ERR;
+        }
+        p += 3;
+
+        char *end;
+        const unsigned long id = strtoul(p, &end, 0);
+        if ((end == p) || (id > 0xFF) || (*end != '=')) {
+            return LT_PARAM_ERR;
+        }
+        p = end + 1;
+        const unsigned long exec_us = strtoul(p, &end, 10);
+        if ((end == p) || (exec_us > UINT32_MAX)) {
+            return LT_PARAM_ERR;
+        }
+        unsigned long jitter_us = 0;
+        if (*end == '/') {
+            p = end + 1;
+            jitter_us = strtoul(p, &end, 10);
+            if ((end == p) || (jitter_us > UINT32_MAX)) {
+                return LT_PARAM_ERR;
+            }
+        }
+        if (((*end != ',') && (*end != '\0')) || (*cnt >= max_cnt)) {
+            return LT_PARAM_ERR;
+        }
+
+        entries[*cnt].id = (uint16_t)(layer | id);
+        entries[*cnt].exec_us = (uint32_t)exec_us;
+        entries[*cnt].jitter_us = (uint32_t)jitter_us;
+        (*cnt)++;
+        p = (*end == ',') ? end + 1 : end;
+    }
+
+    return LT_OK;
+}
+
+#if LT_HOOKS
+void lt_unix_latency_hook_pre(void *ctx, const lt_hook_event_t *ev)
+{
+    if (ev->kind == LT_HOOK_L3_CMD) {
+        ((lt_dev_unix_latency_t *)ctx)->l3_id = LT_UNIX_LATENCY_L3(ev->id);
+    }
+}
+#endif
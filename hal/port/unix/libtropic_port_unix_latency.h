@@ -0,0 +1,150 @@
+#ifndef LIBTROPIC_PORT_UNIX_LATENCY_H
+#define LIBTROPIC_PORT_UNIX_LATENCY_H
+
+/**
+ * @file libtropic_port_unix_latency.h
+ * @author Tropic Square s.r.o.
+ * @brief Port wrapping another port, which makes an instantly answering TROPIC01 model behave like the chip in time,
+ * for libtropic compiled with `LT_PORT_OPS`.
+ *
+ * After each L2 request frame, the wrapper reports the chip busy (CHIP_STATUS READY with no response) for the
+ * execution time of the request taken from `lt_dev_unix_latency_t.table`, polls in that time do not reach the wrapped
+ * port at all. Execution times vary by jitter drawn from a generator seeded by `seed`, so a run with the same seed and
+ * the same calls is reproduced exactly. Each transferred byte takes the time of 8 SPI clocks at `bus_hz`, and CRC of
+ * responses is corrupted at the rate of `crc_error_ppm`, which makes libtropic request their resending.
+ *
+ * L3 commands travel encrypted, so the wrapper knows their ID only when libtropic is compiled with `LT_HOOKS` and
+ * `lt_unix_latency_hook_pre()` is called from `pre` of the handle's hooks. Otherwise their last chunk takes the time
+ * of the Encrypted_Cmd request (`LT_UNIX_LATENCY_L2(0x04)`).
+ *
+ * Functions of the wrapped port find their device in `lt_l2_state_t.device`, which is the wrapper's device, so the
+ * wrapper points it to `lt_dev_unix_latency_t.device` for the time of each call. The wrapper takes the lock of the
+ * handle by itself, and executes L1 transactions by the SPI functions of the wrapped port even when it offloads them.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_port_ops.h"
+#include "libtropic_port_unix_delay.h"
+#include "libtropic_port_unix_lock.h"
+
+#if !LT_PORT_OPS
+#error "libtropic_port_unix_latency.h needs libtropic built with LT_PORT_OPS"
+#endif
+
+/** @brief Key of an L2 request in `lt_unix_latency_entry_t.id` */
+#define LT_UNIX_LATENCY_L2(req_id) ((uint16_t)(req_id))
+/** @brief Key of an L3 command in `lt_unix_latency_entry_t.id` */
+#define LT_UNIX_LATENCY_L3(cmd_id) ((uint16_t)(0x100u | (cmd_id)))
+
+/** @brief Execution time of one L2 request or L3 command. */
+typedef struct lt_unix_latency_entry_t {
+    /** @brief LT_UNIX_LATENCY_L2() or LT_UNIX_LATENCY_L3() of the ID */
+    uint16_t id;
+    /** @brief Mean execution time in us */
+    uint32_t exec_us;
+    /** @brief Execution time is drawn uniformly from `exec_us` +- `jitter_us` */
+    uint32_t jitter_us;
+} lt_unix_latency_entry_t;
+
+/**
+ * @brief Device structure for Unix latency port.
+ *
+ * @note Public members are meant to be configured by the developer before passing the handle to
+ *       libtropic.
+ */
+typedef struct lt_dev_unix_latency_t {
+    /** @public @brief Functions of the wrapped port, e.g. `lt_port_unix_tcp_ops`. */
+    const lt_port_ops_t *ops;
+    /** @public @brief Device of the wrapped port. */
+    void *device;
+    /** @public @brief Execution times, IDs missing in it take `default_entry`. */
+    const lt_unix_latency_entry_t *table;
+    /** @public @brief Number of entries of `table`. */
+    uint8_t table_cnt;
+    /** @public @brief Execution time of requests not found in `table`, `id` is not used. */
+    lt_unix_latency_entry_t default_entry;
+    /** @public @brief SPI clock limit in Hz, 0 transfers in no time. Lower clock set by libtropic is respected. */
+    uint32_t bus_hz;
+    /** @public @brief Responses with CRC corrupted per million of them. */
+    uint32_t crc_error_ppm;
+    /** @public @brief Seed of jitter and of CRC errors. */
+    uint32_t seed;
+    /**
+     * @public @brief When nonzero, the wrapper does not wait for execution and transfer times, their sum with the
+     *                delays of libtropic makes the clock of the chip. Otherwise the chip follows CLOCK_MONOTONIC and
+     *                transfers take their time.
+     */
+    uint8_t virtual_clock;
+    /** @public @brief Sleeping of transfer times, when not `virtual_clock`. */
+    lt_unix_delay_t delay;
+
+    /** @public @brief Time of the chip in us, read-only. */
+    uint64_t now_us;
+    /** @public @brief Number of polls answered busy, read-only. */
+    uint32_t busy_polls;
+    /** @public @brief Number of responses with injected CRC error, read-only. */
+    uint32_t crc_errors;
+
+    /** @private @brief State of the generator. */
+    uint32_t rng;
+    /** @private @brief Time of the chip, when the executed request completes. */
+    uint64_t busy_until_us;
+    /** @private @brief Start of CLOCK_MONOTONIC, when not `virtual_clock`. */
+    uint64_t start_us;
+    /** @private @brief SPI clock set by libtropic, 0 when not set. */
+    uint32_t spi_hz;
+    /** @private @brief First bytes of the frame sent under the current chip select. */
+    uint8_t frame[4];
+    /** @private @brief Set while chip select is low without wrapped port knowing yet. */
+    uint8_t csn_pending;
+    /** @private @brief Set when the frame under chip select goes to the wrapped port. */
+    uint8_t csn_forwarded;
+    /** @private @brief Set when the frame under chip select is a poll answered busy by the wrapper. */
+    uint8_t busy_frame;
+    /** @private @brief Bytes of the frame received by the wrapped port. */
+    uint16_t frame_len;
+    /** @private @brief Bytes of the L3 command left to be sent in chunks of Encrypted_Cmd requests. */
+    uint16_t l3_left;
+    /** @private @brief L3 command ID given by `lt_unix_latency_hook_pre()`, 0 when unknown. */
+    uint16_t l3_id;
+    /** @private @brief Last CHIP_STATUS of the wrapped port, answered in polls while busy. */
+    uint8_t chip_status;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
+} lt_dev_unix_latency_t;
+
+/** @brief Functions of the port for `lt_l2_state_t.ops` */
+extern const lt_port_ops_t lt_port_unix_latency_ops;
+
+/**
+ * @brief Parses execution times, e.g. "l2:0x02=15000,l3:0x50=22000/3000", where `/` precedes jitter in us.
+ *
+ * @param str        Comma separated entries
+ * @param entries    Parsed entries
+ * @param max_cnt    Size of `entries`
+ * @param cnt        Number of parsed entries
+ *
+ * @retval           LT_OK         Function executed successfully
+ * @retval           LT_PARAM_ERR  Invalid parameter, invalid entry or too many entries
+ */
+lt_ret_t lt_unix_latency_table_parse(const char *str, lt_unix_latency_entry_t *entries, const uint8_t max_cnt,
+                                     uint8_t *cnt);
+
+#if LT_HOOKS
+/**
+ * @brief Tells the wrapper the ID of the L3 command being sent, call it from `lt_hooks_t.pre` or set it as `pre`
+ * with the wrapper's device as `ctx`.
+ *
+ * @param ctx    `lt_dev_unix_latency_t` of the handle
+ * @param ev     Event passed to `pre`
+ */
+void lt_unix_latency_hook_pre(void *ctx, const lt_hook_event_t *ev);
+#endif
+
+#endif  // LIBTROPIC_PORT_UNIX_LATENCY_H
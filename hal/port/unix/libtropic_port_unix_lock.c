@@ -0,0 +1,43 @@
+/**
+ * @file libtropic_port_unix_lock.c
+ * @author Tropic Square s.r.o.
+ * @brief Recursive lock of the handle shared by Unix ports, used when libtropic is compiled with LT_THREAD_SAFE.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_unix_lock.h"
+
+#include <pthread.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+lt_ret_t lt_unix_lock_init(lt_unix_lock_t *lock)
+{
+    pthread_mutexattr_t attr;
+
+    if (pthread_mutexattr_init(&attr)) {
+        LT_LOG_ERROR("pthread_mutexattr_init() failed");
+        return LT_FAIL;
+    }
+
+    int ret = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (!ret) {
+        ret = pthread_mutex_init(&lock->mutex, &attr);
+    }
+    pthread_mutexattr_destroy(&attr);
+
+    if (ret) {
+        LT_LOG_ERROR("Recursive mutex initialization failed: %d", ret);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+void lt_unix_lock_destroy(lt_unix_lock_t *lock) { pthread_mutex_destroy(&lock->mutex); }
+
+void lt_unix_lock_take(lt_unix_lock_t *lock) { pthread_mutex_lock(&lock->mutex); }
+
+void lt_unix_lock_release(lt_unix_lock_t *lock) { pthread_mutex_unlock(&lock->mutex); }
@@ -0,0 +1,51 @@
+#ifndef LIBTROPIC_PORT_UNIX_LOCK_H
+#define LIBTROPIC_PORT_UNIX_LOCK_H
+
+/**
+ * @file libtropic_port_unix_lock.h
+ * @author Tropic Square s.r.o.
+ * @brief Recursive lock of the handle shared by Unix ports, used when libtropic is compiled with LT_THREAD_SAFE.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <pthread.h>
+
+#include "libtropic_common.h"
+
+/** @brief Recursive mutex, initialized by `lt_unix_lock_init()`. */
+typedef struct lt_unix_lock_t {
+    /** @private @brief Mutex of PTHREAD_MUTEX_RECURSIVE type. */
+    pthread_mutex_t mutex;
+} lt_unix_lock_t;
+
+/**
+ * @brief Initializes the lock, called from `lt_port_init()`.
+ *
+ * @param lock  Lock to be initialized
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_lock_init(lt_unix_lock_t *lock);
+
+/**
+ * @brief Destroys the lock, called from `lt_port_deinit()`.
+ *
+ * @param lock  Lock to be destroyed
+ */
+void lt_unix_lock_destroy(lt_unix_lock_t *lock);
+
+/**
+ * @brief Waits until the lock is taken by the calling thread, it can be taken by the same thread several times.
+ *
+ * @param lock  Lock to be taken
+ */
+void lt_unix_lock_take(lt_unix_lock_t *lock);
+
+/**
+ * @brief Releases the lock taken by `lt_unix_lock_take()`.
+ *
+ * @param lock  Lock to be released
+ */
+void lt_unix_lock_release(lt_unix_lock_t *lock);
+
+#endif  // LIBTROPIC_PORT_UNIX_LOCK_H
@@ -0,0 +1,262 @@
+/**
+ * @file libtropic_port_unix_loopback.c
+ * @author Tropic Square s.r.o.
+ * @brief Port for communication with a TROPIC01 model linked into the same process.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if LT_PORT_OPS
+// Port functions get names of their own, so the port can be linked together with other ports
+#define LT_PORT_OPS_PREFIX lt_port_unix_loopback
+#include "libtropic_port_ops.h"
+#endif
+
+#include "libtropic_port_unix_loopback.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    if (!dev->transport || !dev->transport->spi_transfer) {
+        LT_LOG_S2_ERROR(s2, "Loopback transport is not set");
+        return LT_FAIL;
+    }
+
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&dev->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
+    lt_unix_rng_wipe(&dev->rng);
+
+    if (dev->transport->init) {
+        return dev->transport->init(dev->transport_ctx);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    lt_unix_rng_wipe(&dev->rng);
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&dev->lock);
+#endif
+
+    if (dev->transport->deinit) {
+        return dev->transport->deinit(dev->transport_ctx);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    if (dev->transport->spi_csn_low) {
+        return dev->transport->spi_csn_low(dev->transport_ctx);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    if (dev->transport->spi_csn_high) {
+        return dev->transport->spi_csn_high(dev->transport_ctx);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    // No copy, the model works on the handle's buffer directly
+    if (dev->transport->spi_transfer(dev->transport_ctx, s2->buff + offset, tx_data_length) != LT_OK) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+#if LT_USE_SPI_TRANSFER_BUF
+lt_ret_t lt_port_spi_transfer_buf(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                  uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+    uint8_t discard[LT_L1_LEN_MAX];
+
+    if (len > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    // The model transfers in place, so the bytes are sent from the destination itself
+    uint8_t *buf = rx ? rx : discard;
+    if (tx && (tx != buf)) {
+        memcpy(buf, tx, len);
+    }
+    if (dev->transport->spi_transfer(dev->transport_ctx, buf, len) != LT_OK) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_SPI_TRANSACTION
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms)
+{
+    lt_ret_t ret;
+
+    if (seg_cnt > LT_L1_SPI_SEGMENTS_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    // Direct calls cost nothing, so the transaction is done operation by operation
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if ((i == 0) || !segs[i - 1].cs_hold) {
+            ret = lt_port_spi_csn_low(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+        if (segs[i].tx) {
+            if (segs[i].offset + segs[i].len > LT_L1_LEN_MAX) {
+                return LT_L1_DATA_LEN_ERROR;
+            }
+            memcpy(s2->buff + segs[i].offset, segs[i].tx, segs[i].len);
+        }
+        ret = lt_port_spi_transfer(s2, segs[i].offset, segs[i].len, timeout_ms);
+        if (ret != LT_OK) {
+            lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return the error of the transfer anyway.
+            return ret;
+        }
+        if (!segs[i].cs_hold) {
+            ret = lt_port_spi_csn_high(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return LT_OK;
+}
+#endif
+
+/** Lets the time pass for the model, the process itself never sleeps */
+static lt_ret_t loopback_wait(lt_dev_unix_loopback_t *dev, uint32_t us)
+{
+    if (dev->transport->wait) {
+        return dev->transport->wait(dev->transport_ctx, us);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    return loopback_wait(dev, ms * 1000);
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    return loopback_wait(dev, us);
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    UNUSED(ms);
+    // As with the model server, the model answers each request when it is made, so the response is ready by now.
+    UNUSED(s2);
+
+    return LT_OK;
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    lt_unix_lock_take(&dev->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    lt_unix_lock_release(&dev->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    lt_dev_unix_loopback_t *dev = (lt_dev_unix_loopback_t *)(s2->device);
+
+    if (dev->transport->random_bytes) {
+        return dev->transport->random_bytes(dev->transport_ctx, buff, count);
+    }
+
+    return lt_unix_rng_bytes(&dev->rng, buff, count);
+}
+
+#if LT_PORT_OPS
+const lt_port_ops_t lt_port_unix_loopback_ops = {
+    .init = lt_port_init,
+    .deinit = lt_port_deinit,
+    .spi_csn_low = lt_port_spi_csn_low,
+    .spi_csn_high = lt_port_spi_csn_high,
+    .spi_transfer = lt_port_spi_transfer,
+#if LT_USE_SPI_TRANSACTION
+    .spi_transaction = lt_port_spi_transaction,
+#endif
+#if LT_USE_SPI_TRANSFER_BUF
+    .spi_transfer_buf = lt_port_spi_transfer_buf,
+#endif
+    .delay = lt_port_delay,
+#if LT_USE_DELAY_US
+    .delay_us = lt_port_delay_us,
+#endif
+#if LT_USE_INT_PIN
+    .delay_on_int = lt_port_delay_on_int,
+#endif
+#if LT_THREAD_SAFE
+    .lock = lt_port_lock,
+    .unlock = lt_port_unlock,
+#endif
+    .random_bytes = lt_port_random_bytes,
+};
+#endif
@@ -0,0 +1,76 @@
+#ifndef LIBTROPIC_PORT_UNIX_LOOPBACK_H
+#define LIBTROPIC_PORT_UNIX_LOOPBACK_H
+
+/**
+ * @file libtropic_port_unix_loopback.h
+ * @author Tropic Square s.r.o.
+ * @brief Port for communication with a TROPIC01 model linked into the same process.
+ *
+ * The port does not transfer anything by itself, each port call is forwarded to a transport given by the
+ * application in `lt_dev_unix_loopback_t` at runtime. The transport is a table of functions, typically implemented
+ * by an in-process model, which then receives the same operations as the model server receives over TCP
+ * (see libtropic_port_unix_tcp.h), but by direct function calls.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_port.h"
+#include "libtropic_port_ops.h"
+#include "libtropic_port_unix_lock.h"
+#include "libtropic_port_unix_rng.h"
+
+/**
+ * @brief Table of transport functions, `ctx` is the `transport_ctx` of the device.
+ *
+ * @note Only `spi_transfer` is mandatory, other functions are not called when NULL.
+ */
+typedef struct lt_unix_transport_t {
+    /** @brief Called by lt_port_init(), e.g. to power on and reset the model. */
+    lt_ret_t (*init)(void *ctx);
+    /** @brief Called by lt_port_deinit(). */
+    lt_ret_t (*deinit)(void *ctx);
+    /** @brief Drives chip select low. */
+    lt_ret_t (*spi_csn_low)(void *ctx);
+    /** @brief Drives chip select high. */
+    lt_ret_t (*spi_csn_high)(void *ctx);
+    /** @brief Full duplex transfer of `len` bytes in place, received bytes overwrite the sent ones. */
+    lt_ret_t (*spi_transfer)(void *ctx, uint8_t *data, uint16_t len);
+    /**
+     * @brief Lets `us` microseconds pass for the model. The port does not sleep, so a model without its own notion
+     * of time can leave it NULL and processes requests right away.
+     */
+    lt_ret_t (*wait)(void *ctx, uint32_t us);
+    /** @brief Provides random bytes for libtropic instead of the operating system, e.g. to replay a session. */
+    lt_ret_t (*random_bytes)(void *ctx, void *buff, size_t count);
+} lt_unix_transport_t;
+
+/**
+ * @brief Device structure for Unix loopback port.
+ *
+ * @note Public members are meant to be configured by the developer before passing the handle to
+ *       libtropic.
+ */
+typedef struct lt_dev_unix_loopback_t {
+    /** @public @brief Transport the port calls are forwarded to. */
+    const lt_unix_transport_t *transport;
+    /** @public @brief Context passed to the transport functions, e.g. instance of the model. */
+    void *transport_ctx;
+
+    /** @private @brief Pool of random bytes from the operating system. */
+    lt_unix_rng_t rng;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
+} lt_dev_unix_loopback_t;
+
+#if LT_PORT_OPS
+/** @brief Functions of the port for `lt_l2_state_t.ops`, when the port is compiled with LT_PORT_OPS */
+extern const lt_port_ops_t lt_port_unix_loopback_ops;
+#endif
+
+#endif  // LIBTROPIC_PORT_UNIX_LOOPBACK_H
@@ -0,0 +1,325 @@
+/**
+ * @file libtropic_port_unix_metrics.c
+ * @author Tropic Square s.r.o.
+ * @brief Statistics of handles published in a POSIX shared memory segment and their export in OpenMetrics format.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_unix_metrics.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+#if !LT_STATS
+#error "libtropic_port_unix_metrics.c needs libtropic built with LT_STATS"
+#endif
+
+/** LT_L2_HANDSHAKE_REQ_ID of lt_l2_api_structs.h, each handshake starts a new secure session */
+#define LT_UNIX_METRICS_HANDSHAKE_REQ_ID 0x02
+
+/** Names of `lt_stats_phase_t` phases exported as `phase` */
+static const char *const lt_unix_metrics_phases[LT_STATS_PHASES] = {"transfer", "poll", "crypto"};
+
+static uint32_t lt_unix_metrics_time_us(void)
+{
+    struct timespec ts;
+
+    // CLOCK_MONOTONIC is always supported on Linux
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u));
+}
+
+static size_t lt_unix_metrics_size(const uint8_t slots_cnt)
+{
+    return sizeof(lt_unix_metrics_seg_t) + ((size_t)slots_cnt * sizeof(lt_unix_metrics_slot_t));
+}
+
+lt_ret_t lt_unix_metrics_create(lt_unix_metrics_t *m, const char *name, const uint8_t slots_cnt)
+{
+    if (!m || !name || !slots_cnt) {
+        return LT_PARAM_ERR;
+    }
+
+    // The segment is readable by the group, which the exporter runs in
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0640);
+    if (fd < 0) {
+        LT_LOG_ERROR("Cannot create shared memory %s", name);
+        return LT_FAIL;
+    }
+
+    size_t size = lt_unix_metrics_size(slots_cnt);
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (p == MAP_FAILED) {
+        LT_LOG_ERROR("Cannot map shared memory %s", name);
+        shm_unlink(name);
+        return LT_FAIL;
+    }
+
+    m->seg = p;
+    m->size = size;
+    // Header is completed last, so the exporter does not accept the segment before it is initialized
+    memset(m->seg, 0, size);
+    m->seg->version = LT_UNIX_METRICS_VERSION;
+    m->seg->slots_cnt = slots_cnt;
+    m->seg->stats_cnt = LT_STATS_CNT;
+    m->seg->slot_size = sizeof(lt_unix_metrics_slot_t);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(m->seg->magic, LT_UNIX_METRICS_MAGIC, sizeof(m->seg->magic));
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_metrics_open(lt_unix_metrics_t *m, const char *name)
+{
+    if (!m || !name) {
+        return LT_PARAM_ERR;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return LT_FAIL;
+    }
+
+    lt_ret_t ret = LT_FAIL;
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(lt_unix_metrics_seg_t))) {
+        goto close;
+    }
+
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        goto close;
+    }
+
+    const lt_unix_metrics_seg_t *seg = p;
+    if (memcmp(seg->magic, LT_UNIX_METRICS_MAGIC, sizeof(seg->magic)) || (seg->version != LT_UNIX_METRICS_VERSION)
+        || (seg->stats_cnt != LT_STATS_CNT) || (seg->slot_size != sizeof(lt_unix_metrics_slot_t))
+        || ((size_t)st.st_size < lt_unix_metrics_size(seg->slots_cnt))) {
+        LT_LOG_ERROR("Shared memory %s has a different layout of statistics", name);
+        munmap(p, (size_t)st.st_size);
+        goto close;
+    }
+
+    m->seg = p;
+    m->size = (size_t)st.st_size;
+    ret = LT_OK;
+
+close:
+    close(fd);
+    return ret;
+}
+
+lt_ret_t lt_unix_metrics_attach(lt_unix_metrics_t *m, const uint8_t slot, const char *label, lt_handle_t *h)
+{
+    if (!m || !m->seg || (slot >= m->seg->slots_cnt) || !label || !label[0] || !h) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_unix_metrics_slot_t *s = &m->seg->slots[slot];
+    memset(s, 0, sizeof(*s));
+    s->stats.time_us = lt_unix_metrics_time_us;
+
+    // Characters which would need escaping in OpenMetrics labels are replaced
+    char label_safe[LT_UNIX_METRICS_LABEL_SIZE];
+    size_t i;
+    for (i = 0; label[i] && (i < sizeof(label_safe) - 1); i++) {
+        label_safe[i] = ((label[i] == '"') || (label[i] == '\\') || (label[i] < ' ')) ? '_' : label[i];
+    }
+    label_safe[i] = '\0';
+
+    h->l2.stats = &s->stats;
+    // Label is set last, the exporter skips the slot until then
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(s->label, label_safe, i + 1);
+
+    return LT_OK;
+}
+
+#if LT_DEVICE_POOL
+lt_ret_t lt_unix_metrics_attach_pool(lt_unix_metrics_t *m, const uint8_t first, const char *prefix,
+                                     lt_pool_t *pool)
+{
+    if (!m || !m->seg || !prefix || !pool || !pool->handles
+        || ((size_t)first + pool->handles_cnt > m->seg->slots_cnt)) {
+        return LT_PARAM_ERR;
+    }
+
+    for (uint8_t i = 0; i < pool->handles_cnt; i++) {
+        char label[LT_UNIX_METRICS_LABEL_SIZE];
+        snprintf(label, sizeof(label), "%s%u", prefix, i);
+        lt_ret_t ret = lt_unix_metrics_attach(m, (uint8_t)(first + i), label, pool->handles[i]);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+
+    return LT_OK;
+}
+#endif
+
+/** Writes HELP, TYPE and UNIT lines of a metric family */
+static void lt_unix_metrics_family(FILE *out, const char *name, const char *type, const char *unit,
+                                   const char *help)
+{
+    fprintf(out, "# TYPE %s %s\n", name, type);
+    if (unit) {
+        fprintf(out, "# UNIT %s %s\n", name, unit);
+    }
+    fprintf(out, "# HELP %s %s\n", name, help);
+}
+
+/** Writes labels of the entry without the closing brace, so more labels can follow */
+static void lt_unix_metrics_entry_labels(FILE *out, const lt_unix_metrics_slot_t *s, const lt_stats_entry_t *e)
+{
+    fprintf(out, "{handle=\"%s\",layer=\"%s\",id=\"0x%02x\"", s->label, (e->key & 0x100u) ? "l3" : "l2",
+            e->key & 0xFFu);
+}
+
+/** Values of entries exported as counters */
+typedef enum lt_unix_metrics_field_t {
+    LT_UNIX_METRICS_CNT,
+    LT_UNIX_METRICS_BYTES,
+    LT_UNIX_METRICS_CRC_ERRORS,
+    LT_UNIX_METRICS_RESENDS
+} lt_unix_metrics_field_t;
+
+static void lt_unix_metrics_entries(FILE *out, const lt_unix_metrics_seg_t *seg, const char *name,
+                                    const lt_unix_metrics_field_t field)
+{
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        const lt_unix_metrics_slot_t *s = &seg->slots[i];
+        if (!s->label[0]) {
+            continue;
+        }
+        for (size_t j = 0; j < LT_STATS_CNT; j++) {
+            const lt_stats_entry_t *e = &s->stats.entries[j];
+            uint32_t v = (field == LT_UNIX_METRICS_CNT)          ? e->cnt
+                         : (field == LT_UNIX_METRICS_BYTES)      ? e->bytes
+                         : (field == LT_UNIX_METRICS_CRC_ERRORS) ? e->crc_errors
+                                                                 : e->resends;
+            if (!e->key) {
+                continue;
+            }
+            fprintf(out, "%s_total", name);
+            lt_unix_metrics_entry_labels(out, s, e);
+            fprintf(out, "} %u\n", v);
+        }
+    }
+}
+
+lt_ret_t lt_unix_metrics_openmetrics(const lt_unix_metrics_t *m, FILE *out)
+{
+    if (!m || !m->seg || !out) {
+        return LT_PARAM_ERR;
+    }
+
+    const lt_unix_metrics_seg_t *seg = m->seg;
+    // Label is written last by lt_unix_metrics_attach()
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    lt_unix_metrics_family(out, "lt_requests", "counter", NULL, "L2 requests and L3 commands sent.");
+    lt_unix_metrics_entries(out, seg, "lt_requests", LT_UNIX_METRICS_CNT);
+    lt_unix_metrics_family(out, "lt_transferred_bytes", "counter", "bytes", "Bytes transferred over SPI.");
+    lt_unix_metrics_entries(out, seg, "lt_transferred_bytes", LT_UNIX_METRICS_BYTES);
+    lt_unix_metrics_family(out, "lt_crc_errors", "counter", NULL, "Frames with CRC error.");
+    lt_unix_metrics_entries(out, seg, "lt_crc_errors", LT_UNIX_METRICS_CRC_ERRORS);
+    lt_unix_metrics_family(out, "lt_resends", "counter", NULL, "Resend_Req sent.");
+    lt_unix_metrics_entries(out, seg, "lt_resends", LT_UNIX_METRICS_RESENDS);
+
+    lt_unix_metrics_family(out, "lt_phase_seconds", "counter", "seconds", "Time spent in phases of requests.");
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        const lt_unix_metrics_slot_t *s = &seg->slots[i];
+        for (size_t j = 0; s->label[0] && (j < LT_STATS_CNT); j++) {
+            for (size_t k = 0; s->stats.entries[j].key && (k < LT_STATS_PHASES); k++) {
+                fprintf(out, "lt_phase_seconds_total");
+                lt_unix_metrics_entry_labels(out, s, &s->stats.entries[j]);
+                fprintf(out, ",phase=\"%s\"} %.6f\n", lt_unix_metrics_phases[k],
+                        (double)s->stats.entries[j].time[k].total_us / 1e6);
+            }
+        }
+    }
+    lt_unix_metrics_family(out, "lt_phase_max_seconds", "gauge", "seconds",
+                           "Longest single transfer, poll delay or crypto operation.");
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        const lt_unix_metrics_slot_t *s = &seg->slots[i];
+        for (size_t j = 0; s->label[0] && (j < LT_STATS_CNT); j++) {
+            for (size_t k = 0; s->stats.entries[j].key && (k < LT_STATS_PHASES); k++) {
+                fprintf(out, "lt_phase_max_seconds");
+                lt_unix_metrics_entry_labels(out, s, &s->stats.entries[j]);
+                fprintf(out, ",phase=\"%s\"} %.6f\n", lt_unix_metrics_phases[k],
+                        (double)s->stats.entries[j].time[k].max_us / 1e6);
+            }
+        }
+    }
+
+    lt_unix_metrics_family(out, "lt_sessions", "counter", NULL, "Secure sessions started, including rebuilt ones.");
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        const lt_unix_metrics_slot_t *s = &seg->slots[i];
+        uint32_t sessions = 0;
+        for (size_t j = 0; s->label[0] && (j < LT_STATS_CNT); j++) {
+            if (s->stats.entries[j].key == LT_STATS_KEY_L2(LT_UNIX_METRICS_HANDSHAKE_REQ_ID)) {
+                sessions = s->stats.entries[j].cnt;
+            }
+        }
+        if (s->label[0]) {
+            fprintf(out, "lt_sessions_total{handle=\"%s\"} %u\n", s->label, sessions);
+        }
+    }
+
+    lt_unix_metrics_family(out, "lt_dropped_requests", "counter", NULL, "Requests not accounted, all entries used.");
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        if (seg->slots[i].label[0]) {
+            fprintf(out, "lt_dropped_requests_total{handle=\"%s\"} %u\n", seg->slots[i].label,
+                    seg->slots[i].stats.dropped);
+        }
+    }
+    lt_unix_metrics_family(out, "lt_delays", "counter", NULL, "Delays measured by the port.");
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        if (seg->slots[i].label[0]) {
+            fprintf(out, "lt_delays_total{handle=\"%s\"} %u\n", seg->slots[i].label, seg->slots[i].stats.delays);
+        }
+    }
+    lt_unix_metrics_family(out, "lt_oversleep_seconds", "counter", "seconds", "Time past deadlines of delays.");
+    for (uint8_t i = 0; i < seg->slots_cnt; i++) {
+        if (seg->slots[i].label[0]) {
+            fprintf(out, "lt_oversleep_seconds_total{handle=\"%s\"} %.6f\n", seg->slots[i].label,
+                    (double)seg->slots[i].stats.oversleep.total_us / 1e6);
+        }
+    }
+
+    fprintf(out, "# EOF\n");
+
+    return ferror(out) ? LT_FAIL : LT_OK;
+}
+
+void lt_unix_metrics_close(lt_unix_metrics_t *m)
+{
+    if (m && m->seg) {
+        munmap(m->seg, m->size);
+        m->seg = NULL;
+        m->size = 0;
+    }
+}
+
+void lt_unix_metrics_unlink(const char *name)
+{
+    if (name) {
+        shm_unlink(name);
+    }
+}
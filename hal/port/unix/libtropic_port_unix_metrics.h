@@ -0,0 +1,150 @@
+#ifndef LIBTROPIC_PORT_UNIX_METRICS_H
+#define LIBTROPIC_PORT_UNIX_METRICS_H
+
+/**
+ * @file libtropic_port_unix_metrics.h
+ * @author Tropic Square s.r.o.
+ * @brief Statistics of handles published in a POSIX shared memory segment, read by an exporter of OpenMetrics, for
+ * libtropic compiled with `LT_STATS`.
+ *
+ * The application creates the segment by `lt_unix_metrics_create()` and attaches its handles (or all handles of a
+ * device pool) to slots of the segment. `lt_l2_state_t.stats` of an attached handle points into the segment, so
+ * libtropic updates the counters in place, with single stores of aligned words and no locks or copies. Another
+ * process, e.g. tools/lt_metrics_exporter, maps the segment read-only by `lt_unix_metrics_open()` and formats it
+ * by `lt_unix_metrics_openmetrics()` when scraped. Counters are read while they change, a scrape can see an entry
+ * whose request is being accounted, which the next scrape corrects.
+ *
+ * Both processes must be compiled with the same LT_STATS_CNT, the segment records the layout and is refused
+ * otherwise.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "libtropic_common.h"
+
+/** @brief Magic bytes at the start of the segment. */
+#define LT_UNIX_METRICS_MAGIC "LTMS"
+/** @brief Version of the layout of the segment. */
+#define LT_UNIX_METRICS_VERSION 1
+/** @brief Maximal length of a label of a slot, including the terminating zero. */
+#define LT_UNIX_METRICS_LABEL_SIZE 32
+
+/** @brief Statistics of one handle in the segment. */
+typedef struct lt_unix_metrics_slot_t {
+    /** @brief Label of the handle exported as `handle`, empty when the slot is not used. */
+    char label[LT_UNIX_METRICS_LABEL_SIZE];
+    /** @brief Statistics the handle updates in place. */
+    lt_stats_t stats;
+} lt_unix_metrics_slot_t;
+
+/** @brief Header of the segment, followed by its slots. */
+typedef struct lt_unix_metrics_seg_t {
+    /** @brief LT_UNIX_METRICS_MAGIC */
+    char magic[4];
+    /** @brief LT_UNIX_METRICS_VERSION */
+    uint8_t version;
+    /** @brief Number of slots. */
+    uint8_t slots_cnt;
+    /** @brief LT_STATS_CNT of the creator. */
+    uint16_t stats_cnt;
+    /** @brief Size of `lt_unix_metrics_slot_t` of the creator. */
+    uint32_t slot_size;
+    /** @brief Slots. */
+    lt_unix_metrics_slot_t slots[];
+} lt_unix_metrics_seg_t;
+
+/** @brief Mapping of the segment, zero initialized before `lt_unix_metrics_create()` or `lt_unix_metrics_open()`. */
+typedef struct lt_unix_metrics_t {
+    /** @private @brief Mapped segment. */
+    lt_unix_metrics_seg_t *seg;
+    /** @private @brief Size of the mapping. */
+    size_t size;
+} lt_unix_metrics_t;
+
+/**
+ * @brief Creates the segment with all slots free, an existing segment of the name is replaced.
+ *
+ * @param m          Mapping
+ * @param name       Name of the segment for shm_open(), e.g. "/libtropic"
+ * @param slots_cnt  Number of slots, one per handle
+ *
+ * @retval           LT_OK         Function executed successfully
+ * @retval           LT_PARAM_ERR  Invalid parameter
+ * @retval           LT_FAIL       The segment cannot be created
+ */
+lt_ret_t lt_unix_metrics_create(lt_unix_metrics_t *m, const char *name, const uint8_t slots_cnt);
+
+/**
+ * @brief Maps the segment created by another process read-only.
+ *
+ * @param m          Mapping
+ * @param name       Name of the segment passed to `lt_unix_metrics_create()`
+ *
+ * @retval           LT_OK         Function executed successfully
+ * @retval           LT_PARAM_ERR  Invalid parameter
+ * @retval           LT_FAIL       The segment does not exist or has a different layout
+ */
+lt_ret_t lt_unix_metrics_open(lt_unix_metrics_t *m, const char *name);
+
+/**
+ * @brief Points statistics of the handle into the slot of the segment and measures time by CLOCK_MONOTONIC. The
+ * slot is cleared, call before `lt_init()` to account the whole session of the handle.
+ *
+ * @param m          Mapping returned by `lt_unix_metrics_create()`
+ * @param slot       Index of the slot
+ * @param label      Label of the handle, truncated to LT_UNIX_METRICS_LABEL_SIZE - 1 characters
+ * @param h          Handle
+ *
+ * @retval           LT_OK         Function executed successfully
+ * @retval           LT_PARAM_ERR  Invalid parameter
+ */
+lt_ret_t lt_unix_metrics_attach(lt_unix_metrics_t *m, const uint8_t slot, const char *label, lt_handle_t *h);
+
+#if LT_DEVICE_POOL
+/**
+ * @brief Attaches all handles of the pool to consecutive slots, labelled by `prefix` and the index of the chip.
+ *
+ * @param m          Mapping returned by `lt_unix_metrics_create()`
+ * @param first      Index of the slot of the first chip
+ * @param prefix     Prefix of labels, e.g. "chip"
+ * @param pool       Pool initialized by `lt_pool_init()`
+ *
+ * @retval           LT_OK         Function executed successfully
+ * @retval           LT_PARAM_ERR  Invalid parameter or too few slots
+ */
+lt_ret_t lt_unix_metrics_attach_pool(lt_unix_metrics_t *m, const uint8_t first, const char *prefix,
+                                     lt_pool_t *pool);
+#endif
+
+/**
+ * @brief Writes statistics of all used slots in OpenMetrics text format, terminated by `# EOF`.
+ *
+ * @param m          Mapping
+ * @param out        Output stream
+ *
+ * @retval           LT_OK         Function executed successfully
+ * @retval           LT_PARAM_ERR  Invalid parameter
+ * @retval           LT_FAIL       Writing failed
+ */
+lt_ret_t lt_unix_metrics_openmetrics(const lt_unix_metrics_t *m, FILE *out);
+
+/**
+ * @brief Unmaps the segment, the segment itself stays until `lt_unix_metrics_unlink()`. Handles attached to it must
+ * not be used afterwards.
+ *
+ * @param m          Mapping
+ */
+void lt_unix_metrics_close(lt_unix_metrics_t *m);
+
+/**
+ * @brief Removes the segment of the name.
+ *
+ * @param name       Name of the segment
+ */
+void lt_unix_metrics_unlink(const char *name);
+
+#endif  // LIBTROPIC_PORT_UNIX_METRICS_H
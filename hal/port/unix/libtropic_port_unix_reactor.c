@@ -0,0 +1,517 @@
+/**
+ * @file libtropic_port_unix_reactor.c
+ * @author Tropic Square s.r.o.
+ * @brief Reactor driving operations of many handles from one thread, shared by Unix ports.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "libtropic_port_unix_reactor.h"
+
+#if LT_ASYNC
+#include <errno.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#endif
+// Timeout of io_uring_enter() came together with IORING_FEAT_EXT_ARG, older kernels use epoll
+#if defined(IORING_ENTER_EXT_ARG) && defined(IORING_FEAT_EXT_ARG)
+#define LT_UNIX_REACTOR_URING 1
+#else
+#define LT_UNIX_REACTOR_URING 0
+#endif
+
+/** Entries of io_uring: one poll of each handle's descriptor, of each watched one and of the kick eventfd */
+#define LT_UNIX_REACTOR_URING_LEN 256
+_Static_assert(LT_UNIX_REACTOR_SRC_MAX + LT_UNIX_REACTOR_WATCH_MAX < LT_UNIX_REACTOR_URING_LEN,
+               "io_uring must take a poll of each handle and watched descriptor");
+
+/** User data of the kick eventfd, handles use their index and watched descriptors follow them */
+#define LT_UNIX_REACTOR_KICK UINT64_MAX
+
+/** Events taken from epoll by one wait */
+#define LT_UNIX_REACTOR_EPOLL_EVENTS 64
+
+static uint64_t clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
+
+/** Consumes wake-ups of `lt_unix_reactor_wake()` */
+static void kick_drain(lt_unix_reactor_t *r)
+{
+    uint64_t v;
+    ssize_t ret = read(r->kick_fd, &v, sizeof(v));
+    UNUSED(ret);
+}
+
+/** Marks what `user_data` of a completed poll or epoll event stands for as readable */
+static void ready_mark(lt_unix_reactor_t *r, const uint64_t user_data, bool *woken)
+{
+    if (user_data == LT_UNIX_REACTOR_KICK) {
+        r->kick_armed = false;
+        kick_drain(r);
+        *woken = true;
+    }
+    else if (user_data < r->src_cnt) {
+        r->src[user_data].armed = false;
+        r->src[user_data].ready = true;
+    }
+    else if ((user_data >= LT_UNIX_REACTOR_SRC_MAX) && (user_data < (uint64_t)LT_UNIX_REACTOR_SRC_MAX + r->watch_cnt)) {
+        r->watch[user_data - LT_UNIX_REACTOR_SRC_MAX].armed = false;
+        r->watch[user_data - LT_UNIX_REACTOR_SRC_MAX].ready = true;
+    }
+}
+
+#if LT_UNIX_REACTOR_URING
+static void uring_deinit(lt_unix_reactor_uring_t *u)
+{
+    if (u->sqes && (u->sqes != MAP_FAILED)) {
+        munmap(u->sqes, u->sqes_len);
+    }
+    if (u->cq_ring && (u->cq_ring != MAP_FAILED) && (u->cq_ring != u->sq_ring)) {
+        munmap(u->cq_ring, u->cq_ring_len);
+    }
+    if (u->sq_ring && (u->sq_ring != MAP_FAILED)) {
+        munmap(u->sq_ring, u->sq_ring_len);
+    }
+    if (u->fd >= 0) {
+        close(u->fd);
+    }
+    memset(u, 0, sizeof(*u));
+    u->fd = -1;
+}
+
+static lt_ret_t uring_init(lt_unix_reactor_uring_t *u)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    u->fd = (int)syscall(__NR_io_uring_setup, LT_UNIX_REACTOR_URING_LEN, &p);
+    if (u->fd < 0) {
+        LT_LOG_INFO("io_uring is not available: %s (%d), epoll is used.", strerror(errno), errno);
+        u->fd = -1;
+        return LT_FAIL;
+    }
+    if (!(p.features & IORING_FEAT_EXT_ARG)) {
+        LT_LOG_INFO("io_uring does not take a timeout, epoll is used.");
+        uring_deinit(u);
+        return LT_FAIL;
+    }
+
+    u->sq_ring_len = p.sq_off.array + (p.sq_entries * sizeof(uint32_t));
+    u->cq_ring_len = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_ring_len > u->sq_ring_len) {
+            u->sq_ring_len = u->cq_ring_len;
+        }
+        u->cq_ring_len = u->sq_ring_len;
+    }
+    u->sq_ring
+        = mmap(NULL, u->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ring == MAP_FAILED) {
+        LT_LOG_ERROR("Could not map io_uring: %s (%d).", strerror(errno), errno);
+        uring_deinit(u);
+        return LT_FAIL;
+    }
+    u->cq_ring = (p.features & IORING_FEAT_SINGLE_MMAP)
+                     ? u->sq_ring
+                     : mmap(NULL, u->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                            IORING_OFF_CQ_RING);
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if ((u->cq_ring == MAP_FAILED) || (u->sqes == MAP_FAILED)) {
+        LT_LOG_ERROR("Could not map io_uring: %s (%d).", strerror(errno), errno);
+        uring_deinit(u);
+        return LT_FAIL;
+    }
+
+    uint8_t *sq = (uint8_t *)u->sq_ring;
+    uint8_t *cq = (uint8_t *)u->cq_ring;
+    u->sq_head = (uint32_t *)(sq + p.sq_off.head);
+    u->sq_tail = (uint32_t *)(sq + p.sq_off.tail);
+    u->sq_mask = *(uint32_t *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (uint32_t *)(sq + p.sq_off.array);
+    u->cq_head = (uint32_t *)(cq + p.cq_off.head);
+    u->cq_tail = (uint32_t *)(cq + p.cq_off.tail);
+    u->cq_mask = *(uint32_t *)(cq + p.cq_off.ring_mask);
+    u->cqes = cq + p.cq_off.cqes;
+
+    return LT_OK;
+}
+
+/** Places one-shot poll for readability of `fd` into the submission ring, it is submitted by the next wait */
+static void uring_poll_add(lt_unix_reactor_uring_t *u, const int fd, const uint64_t user_data)
+{
+    // Each handle and the kick have at most one poll in flight, so the ring never fills
+    uint32_t tail = *u->sq_tail;
+    uint32_t idx = tail & u->sq_mask;
+    struct io_uring_sqe *sqe = &((struct io_uring_sqe *)u->sqes)[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = user_data;
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/** Submits placed polls, waits for a completion at most `wait_us` and marks what became readable */
+static lt_ret_t uring_wait(lt_unix_reactor_t *r, const uint64_t wait_us, bool *woken)
+{
+    lt_unix_reactor_uring_t *u = &r->uring;
+
+    if (!r->kick_armed) {
+        uring_poll_add(u, r->kick_fd, LT_UNIX_REACTOR_KICK);
+        r->kick_armed = true;
+    }
+
+    struct __kernel_timespec ts
+        = {.tv_sec = (int64_t)(wait_us / 1000000u), .tv_nsec = (int64_t)(wait_us % 1000000u) * 1000};
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+
+    uint32_t to_submit = *u->sq_tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+    int ret = (int)syscall(__NR_io_uring_enter, u->fd, to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                           &arg, sizeof(arg));
+    if ((ret < 0) && (errno != ETIME) && (errno != EINTR) && (errno != EBUSY)) {
+        LT_LOG_ERROR("io_uring_enter() failed: %s (%d).", strerror(errno), errno);
+        return LT_FAIL;
+    }
+
+    uint32_t head = *u->cq_head;
+    const uint32_t tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        // Failed poll makes the handle due as well, its lt_poll() reports the broken descriptor
+        ready_mark(r, ((const struct io_uring_cqe *)u->cqes)[head & u->cq_mask].user_data, woken);
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+
+    return LT_OK;
+}
+#endif
+
+/** Waits in epoll at most `wait_us`, rounded up to ms, and marks what became readable */
+static lt_ret_t epoll_wait_us(lt_unix_reactor_t *r, const uint64_t wait_us, bool *woken)
+{
+    struct epoll_event events[LT_UNIX_REACTOR_EPOLL_EVENTS];
+    const uint64_t wait_ms = (wait_us + 999u) / 1000u;
+
+    int cnt = epoll_wait(r->epoll_fd, events, LT_UNIX_REACTOR_EPOLL_EVENTS, (wait_ms > INT32_MAX) ? -1 : (int)wait_ms);
+    if (cnt < 0) {
+        if (errno == EINTR) {
+            return LT_OK;
+        }
+        LT_LOG_ERROR("epoll_wait() failed: %s (%d).", strerror(errno), errno);
+        return LT_FAIL;
+    }
+
+    for (int i = 0; i < cnt; i++) {
+        ready_mark(r, events[i].data.u64, woken);
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_reactor_init(lt_unix_reactor_t *r, const lt_unix_reactor_cfg_t *cfg)
+{
+    if (!r) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->epoll_fd = -1;
+    r->uring.fd = -1;
+    r->kick_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->kick_fd < 0) {
+        LT_LOG_ERROR("Could not create eventfd: %s (%d).", strerror(errno), errno);
+        return LT_FAIL;
+    }
+
+#if LT_UNIX_REACTOR_URING
+    if ((!cfg || !cfg->epoll) && (uring_init(&r->uring) == LT_OK)) {
+        return LT_OK;
+    }
+#else
+    UNUSED(cfg);
+#endif
+
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (r->epoll_fd < 0) {
+        LT_LOG_ERROR("Could not create epoll: %s (%d).", strerror(errno), errno);
+        close(r->kick_fd);
+        return LT_FAIL;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = LT_UNIX_REACTOR_KICK};
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->kick_fd, &ev) < 0) {
+        LT_LOG_ERROR("Could not watch eventfd: %s (%d).", strerror(errno), errno);
+        close(r->epoll_fd);
+        close(r->kick_fd);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+void lt_unix_reactor_deinit(lt_unix_reactor_t *r)
+{
+    if (!r) {
+        return;
+    }
+
+#if LT_UNIX_REACTOR_URING
+    // Closing io_uring cancels polls in flight
+    if (r->uring.fd >= 0) {
+        uring_deinit(&r->uring);
+    }
+#endif
+    if (r->epoll_fd >= 0) {
+        close(r->epoll_fd);
+        r->epoll_fd = -1;
+    }
+    close(r->kick_fd);
+    r->kick_fd = -1;
+    r->src_cnt = 0;
+    r->watch_cnt = 0;
+}
+
+bool lt_unix_reactor_uring(const lt_unix_reactor_t *r)
+{
+    return r && (r->uring.fd >= 0);
+}
+
+static lt_unix_reactor_src_t *src_find(lt_unix_reactor_t *r, const lt_handle_t *h)
+{
+    for (uint16_t i = 0; i < r->src_cnt; i++) {
+        if (r->src[i].h == h) {
+            return &r->src[i];
+        }
+    }
+
+    return NULL;
+}
+
+lt_ret_t lt_unix_reactor_add(lt_unix_reactor_t *r, lt_handle_t *h, const lt_unix_reactor_port_t *port)
+{
+    if (!r || !h || !h->async || (r->src_cnt >= LT_UNIX_REACTOR_SRC_MAX) || src_find(r, h)) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_unix_reactor_src_t *s = &r->src[r->src_cnt];
+    memset(s, 0, sizeof(*s));
+    s->h = h;
+    s->port = port;
+    s->fd = (port && port->fd && port->reply_wait_ms) ? port->fd(h->l2.device) : -1;
+
+    // Edge triggered, a reply which arrived while the handle was not awaiting it only makes one early lt_poll()
+    if ((s->fd >= 0) && (r->epoll_fd >= 0)) {
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLET, .data.u64 = r->src_cnt};
+        if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, s->fd, &ev) < 0) {
+            LT_LOG_ERROR("Could not watch descriptor %d: %s (%d).", s->fd, strerror(errno), errno);
+            return LT_FAIL;
+        }
+    }
+    r->src_cnt++;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_reactor_submit(lt_unix_reactor_t *r, lt_handle_t *h, lt_async_op_t *op, lt_async_cb_t cb,
+                                void *ctx)
+{
+    if (!r) {
+        return LT_PARAM_ERR;
+    }
+    lt_unix_reactor_src_t *s = src_find(r, h);
+    if (!s) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_submit(h, op, cb, ctx);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    // Queue of an active handle continues by itself, an idle one is started by the next pass
+    if (!s->active) {
+        s->active = true;
+        s->awaits = false;
+        s->due_us = 0;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_reactor_due(lt_unix_reactor_t *r, const lt_handle_t *h)
+{
+    if (!r) {
+        return LT_PARAM_ERR;
+    }
+    lt_unix_reactor_src_t *s = src_find(r, h);
+    if (!s) {
+        return LT_PARAM_ERR;
+    }
+    // Idle handle has nothing to poll
+    s->due_us = 0;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_reactor_watch(lt_unix_reactor_t *r, int fd, lt_unix_reactor_watch_cb_t cb, void *ctx)
+{
+    if (!r || (fd < 0) || !cb || (r->watch_cnt >= LT_UNIX_REACTOR_WATCH_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_unix_reactor_watch_t *w = &r->watch[r->watch_cnt];
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->cb = cb;
+    w->ctx = ctx;
+
+    // Level triggered, the callback reads what came
+    if (r->epoll_fd >= 0) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.u64 = LT_UNIX_REACTOR_SRC_MAX + r->watch_cnt};
+        if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            LT_LOG_ERROR("Could not watch descriptor %d: %s (%d).", fd, strerror(errno), errno);
+            return LT_FAIL;
+        }
+    }
+    r->watch_cnt++;
+
+    return LT_OK;
+}
+
+/** Calls lt_poll() of a due handle and schedules its next one */
+static lt_ret_t src_poll(lt_unix_reactor_src_t *s)
+{
+    uint32_t wait_ms = 0;
+
+    s->ready = false;
+    lt_ret_t ret = lt_poll(s->h, &wait_ms);
+    if (ret != LT_PENDING) {
+        s->active = false;
+        s->awaits = false;
+        return ret;
+    }
+
+    int32_t reply_ms = (s->fd >= 0) ? s->port->reply_wait_ms(s->h->l2.device) : -1;
+    s->awaits = (reply_ms >= 0);
+    s->due_us = clock_us() + ((uint64_t)(s->awaits ? (uint32_t)reply_ms : wait_ms) * 1000u);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_reactor_run(lt_unix_reactor_t *r, int32_t timeout_ms)
+{
+    if (!r) {
+        return LT_PARAM_ERR;
+    }
+
+    const uint64_t end_us = (timeout_ms < 0) ? UINT64_MAX : clock_us() + ((uint64_t)timeout_ms * 1000u);
+
+    for (;;) {
+        for (uint8_t i = 0; i < r->watch_cnt; i++) {
+            if (r->watch[i].ready) {
+                r->watch[i].ready = false;
+                r->watch[i].cb(r, r->watch[i].ctx);
+            }
+        }
+
+        uint64_t now_us = clock_us();
+        for (uint16_t i = 0; i < r->src_cnt; i++) {
+            lt_unix_reactor_src_t *s = &r->src[i];
+            if (s->active && ((s->awaits && s->ready) || (now_us >= s->due_us))) {
+                lt_ret_t ret = src_poll(s);
+                if (ret != LT_OK) {
+                    return ret;
+                }
+                now_us = clock_us();
+            }
+        }
+
+        // Completion callbacks may have submitted to handles polled before, so deadlines are collected afterwards
+        uint64_t next_us = end_us;
+        uint16_t active = 0;
+        for (uint16_t i = 0; i < r->src_cnt; i++) {
+            lt_unix_reactor_src_t *s = &r->src[i];
+            if (!s->active) {
+                continue;
+            }
+            active++;
+#if LT_UNIX_REACTOR_URING
+            if (s->awaits && !s->armed && (r->uring.fd >= 0)) {
+                uring_poll_add(&r->uring, s->fd, i);
+                s->armed = true;
+            }
+#endif
+            if (s->due_us < next_us) {
+                next_us = s->due_us;
+            }
+        }
+        if (!active) {
+            return LT_OK;
+        }
+#if LT_UNIX_REACTOR_URING
+        for (uint8_t i = 0; (i < r->watch_cnt) && (r->uring.fd >= 0); i++) {
+            if (!r->watch[i].armed) {
+                uring_poll_add(&r->uring, r->watch[i].fd, LT_UNIX_REACTOR_SRC_MAX + i);
+                r->watch[i].armed = true;
+            }
+        }
+#endif
+
+        now_us = clock_us();
+        if (now_us >= end_us) {
+            return LT_PENDING;
+        }
+        if (next_us <= now_us) {
+            continue;
+        }
+
+        bool woken = false;
+#if LT_UNIX_REACTOR_URING
+        lt_ret_t ret = (r->uring.fd >= 0) ? uring_wait(r, next_us - now_us, &woken)
+                                          : epoll_wait_us(r, next_us - now_us, &woken);
+#else
+        lt_ret_t ret = epoll_wait_us(r, next_us - now_us, &woken);
+#endif
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (woken) {
+            return LT_PENDING;
+        }
+    }
+}
+
+void lt_unix_reactor_wake(lt_unix_reactor_t *r)
+{
+    uint64_t v = 1;
+    ssize_t ret = write(r->kick_fd, &v, sizeof(v));
+    UNUSED(ret);
+}
+#endif
@@ -0,0 +1,265 @@
+#ifndef LIBTROPIC_PORT_UNIX_REACTOR_H
+#define LIBTROPIC_PORT_UNIX_REACTOR_H
+
+/**
+ * @file libtropic_port_unix_reactor.h
+ * @author Tropic Square s.r.o.
+ * @brief Reactor driving operations of many handles from one thread, shared by Unix ports.
+ *
+ * Handles are added to the reactor and operations are submitted to them by `lt_unix_reactor_submit()`, which is
+ * `lt_submit()` of LT_ASYNC. `lt_unix_reactor_run()` then calls `lt_poll()` of each handle when it is due: right
+ * after submission, after the time requested by its previous `lt_poll()`, or when the descriptor of its port became
+ * readable. In between, the thread sleeps in one system call for all handles, so one thread serves dozens of chips
+ * without a thread per handle.
+ *
+ * A port may receive its replies asynchronously, as the TCP port does with `lt_dev_unix_tcp_t.async_reply` set and
+ * a server executing L1 transactions (tools/lt_spi_bridge): the request is sent by `lt_poll()` and its reply is
+ * collected by the next `lt_poll()` once the socket is readable, so no thread blocks in `recv()` while TROPIC01
+ * executes the command. Ports without `lt_unix_reactor_port_t` (e.g. the USB dongle) complete their short exchanges
+ * over the serial line within `lt_poll()`, only the waits for TROPIC01 are done by the reactor.
+ *
+ * The reactor sleeps in io_uring (`IORING_OP_POLL_ADD` of awaited descriptors, the timeout passed to
+ * `io_uring_enter()`, which needs Linux 5.11), or in epoll when io_uring is not available (older kernel, seccomp
+ * profile of a container) or `lt_unix_reactor_cfg_t.epoll` is set. io_uring is used through its system calls, so no
+ * library is needed.
+ *
+ * All functions except `lt_unix_reactor_wake()` are called by the thread running the reactor, also from completion
+ * callbacks. Added handles must not be used by any other function while the reactor runs.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#if LT_ASYNC
+#include "libtropic.h"
+#endif
+
+/** @brief Maximal number of handles of one reactor */
+#ifndef LT_UNIX_REACTOR_SRC_MAX
+#define LT_UNIX_REACTOR_SRC_MAX 128
+#endif
+
+/** @brief Maximal number of descriptors watched by `lt_unix_reactor_watch()` */
+#ifndef LT_UNIX_REACTOR_WATCH_MAX
+#define LT_UNIX_REACTOR_WATCH_MAX 8
+#endif
+
+/** @brief Functions telling the reactor how a port receives its replies, e.g. `lt_port_unix_tcp_reactor` */
+typedef struct lt_unix_reactor_port_t {
+    /** @brief Returns descriptor of the socket or serial device of the port's device, -1 when it has none */
+    int (*fd)(const void *device);
+    /**
+     * @brief Returns -1 when the last `lt_poll()` did not leave a reply awaited, otherwise time in ms by which the
+     * awaited reply times out. Reply is awaited on the descriptor, awaited reply which timed out is reported by the
+     * next `lt_poll()`.
+     */
+    int32_t (*reply_wait_ms)(const void *device);
+} lt_unix_reactor_port_t;
+
+#if LT_ASYNC
+/** @brief Configuration of `lt_unix_reactor_init()`. */
+typedef struct lt_unix_reactor_cfg_t {
+    /** @public @brief When true, epoll is used even when io_uring is available. */
+    bool epoll;
+} lt_unix_reactor_cfg_t;
+
+/** @brief Handle driven by the reactor. */
+typedef struct lt_unix_reactor_src_t {
+    /** @private @brief Handle, its `async` is set. */
+    lt_handle_t *h;
+    /** @private @brief Functions of the port, NULL for a port without asynchronous replies. */
+    const lt_unix_reactor_port_t *port;
+    /** @private @brief Descriptor of the port, -1 when replies are not awaited on any. */
+    int fd;
+    /** @private @brief Set while operations are submitted and not completed. */
+    bool active;
+    /** @private @brief Set while a reply is awaited on `fd`. */
+    bool awaits;
+    /** @private @brief Set while io_uring polls `fd`. */
+    bool armed;
+    /** @private @brief Set when `fd` became readable. */
+    bool ready;
+    /** @private @brief Time of CLOCK_MONOTONIC in us when `lt_poll()` is called again. */
+    uint64_t due_us;
+} lt_unix_reactor_src_t;
+
+struct lt_unix_reactor_t;
+
+/** @brief Called by `lt_unix_reactor_run()` when a watched descriptor is readable, it reads what came there */
+typedef void (*lt_unix_reactor_watch_cb_t)(struct lt_unix_reactor_t *r, void *ctx);
+
+/** @brief Descriptor watched by `lt_unix_reactor_watch()`. */
+typedef struct lt_unix_reactor_watch_t {
+    /** @private @brief Descriptor. */
+    int fd;
+    /** @private @brief Called when `fd` is readable. */
+    lt_unix_reactor_watch_cb_t cb;
+    /** @private @brief Context passed to `cb`. */
+    void *ctx;
+    /** @private @brief Set while io_uring polls `fd`. */
+    bool armed;
+    /** @private @brief Set when `fd` became readable. */
+    bool ready;
+} lt_unix_reactor_watch_t;
+
+/** @brief Mapped rings of io_uring. */
+typedef struct lt_unix_reactor_uring_t {
+    /** @private @brief io_uring descriptor, -1 when epoll is used. */
+    int fd;
+    /** @private @brief Mapping of the submission ring. */
+    void *sq_ring;
+    /** @private @brief Length of `sq_ring` mapping. */
+    size_t sq_ring_len;
+    /** @private @brief Mapping of the completion ring, same as `sq_ring` with IORING_FEAT_SINGLE_MMAP. */
+    void *cq_ring;
+    /** @private @brief Length of `cq_ring` mapping. */
+    size_t cq_ring_len;
+    /** @private @brief Mapping of submission queue entries. */
+    void *sqes;
+    /** @private @brief Length of `sqes` mapping. */
+    size_t sqes_len;
+    /** @private @brief Head of the submission ring, written by the kernel. */
+    uint32_t *sq_head;
+    /** @private @brief Tail of the submission ring. */
+    uint32_t *sq_tail;
+    /** @private @brief Mask of submission ring indexes. */
+    uint32_t sq_mask;
+    /** @private @brief Indexes of submitted entries. */
+    uint32_t *sq_array;
+    /** @private @brief Head of the completion ring. */
+    uint32_t *cq_head;
+    /** @private @brief Tail of the completion ring, written by the kernel. */
+    uint32_t *cq_tail;
+    /** @private @brief Mask of completion ring indexes. */
+    uint32_t cq_mask;
+    /** @private @brief Completion entries. */
+    void *cqes;
+} lt_unix_reactor_uring_t;
+
+/** @brief Reactor, zero initialized before `lt_unix_reactor_init()`. */
+typedef struct lt_unix_reactor_t {
+    /** @private @brief Added handles. */
+    lt_unix_reactor_src_t src[LT_UNIX_REACTOR_SRC_MAX];
+    /** @private @brief Number of added handles. */
+    uint16_t src_cnt;
+    /** @private @brief Watched descriptors. */
+    lt_unix_reactor_watch_t watch[LT_UNIX_REACTOR_WATCH_MAX];
+    /** @private @brief Number of watched descriptors. */
+    uint8_t watch_cnt;
+    /** @private @brief Eventfd of `lt_unix_reactor_wake()`. */
+    int kick_fd;
+    /** @private @brief Set while io_uring polls `kick_fd`. */
+    bool kick_armed;
+    /** @private @brief Epoll descriptor, -1 when io_uring is used. */
+    int epoll_fd;
+    /** @private @brief io_uring. */
+    lt_unix_reactor_uring_t uring;
+} lt_unix_reactor_t;
+
+/**
+ * @brief Creates the reactor, choosing io_uring or epoll.
+ *
+ * @param r           Reactor
+ * @param cfg         Configuration, NULL for defaults
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_FAIL Neither io_uring nor epoll could be created
+ */
+lt_ret_t lt_unix_reactor_init(lt_unix_reactor_t *r, const lt_unix_reactor_cfg_t *cfg);
+
+/**
+ * @brief Releases the reactor, operations not completed yet stay submitted to their handles.
+ *
+ * @param r           Reactor
+ */
+void lt_unix_reactor_deinit(lt_unix_reactor_t *r);
+
+/**
+ * @brief Returns whether the reactor sleeps in io_uring.
+ *
+ * @param r           Reactor
+ * @return            true for io_uring, false for epoll
+ */
+bool lt_unix_reactor_uring(const lt_unix_reactor_t *r);
+
+/**
+ * @brief Adds initialized handle to the reactor.
+ *
+ * @param r           Reactor
+ * @param h           Device's handle, `h->async` must be set and its queue empty
+ * @param port        Functions of the port, NULL for a port which does not receive replies asynchronously
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter, handle already added or LT_UNIX_REACTOR_SRC_MAX handles added
+ * @retval            LT_FAIL Descriptor of the port could not be watched
+ */
+lt_ret_t lt_unix_reactor_add(lt_unix_reactor_t *r, lt_handle_t *h, const lt_unix_reactor_port_t *port);
+
+/**
+ * @brief Submits operation to a handle of the reactor, `lt_submit()` which makes the handle due.
+ *
+ * @param r           Reactor
+ * @param h           Device's handle added to the reactor
+ * @param op          Operation to execute, kept valid by the caller until `cb` is called
+ * @param cb          Called from `lt_unix_reactor_run()` when the operation is completed, may be NULL
+ * @param ctx         Context passed to `cb`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Handle was not added
+ * @retval            other Error of `lt_submit()`
+ */
+lt_ret_t lt_unix_reactor_submit(lt_unix_reactor_t *r, lt_handle_t *h, lt_async_op_t *op, lt_async_cb_t cb,
+                                void *ctx);
+
+/**
+ * @brief Makes a handle of the reactor due, its `lt_poll()` is called by the next pass of `lt_unix_reactor_run()`.
+ * @details Used by callbacks of watched descriptors, e.g. for an edge of the INT pin which tells that TROPIC01 has
+ * the response ready before the time requested by the previous `lt_poll()`.
+ *
+ * @param r           Reactor
+ * @param h           Device's handle added to the reactor
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Handle was not added
+ */
+lt_ret_t lt_unix_reactor_due(lt_unix_reactor_t *r, const lt_handle_t *h);
+
+/**
+ * @brief Watches a descriptor shared by several handles, e.g. `lt_unix_spi_bus_int_fd()` with INT lines of all
+ * chips of a bus. Its callback reads what came and makes the concerned handles due by `lt_unix_reactor_due()`.
+ *
+ * @param r           Reactor
+ * @param fd          Descriptor, watched until `lt_unix_reactor_deinit()`
+ * @param cb          Called from `lt_unix_reactor_run()` when `fd` is readable
+ * @param ctx         Context passed to `cb`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter or LT_UNIX_REACTOR_WATCH_MAX descriptors watched
+ * @retval            LT_FAIL Descriptor could not be watched
+ */
+lt_ret_t lt_unix_reactor_watch(lt_unix_reactor_t *r, int fd, lt_unix_reactor_watch_cb_t cb, void *ctx);
+
+/**
+ * @brief Drives handles of the reactor until all submitted operations are completed.
+ *
+ * @param r           Reactor
+ * @param timeout_ms  Longest time to run, -1 runs until all operations are completed, 0 polls due handles once
+ *
+ * @retval            LT_OK All submitted operations are completed
+ * @retval            LT_PENDING Timeout ran out or `lt_unix_reactor_wake()` was called before that
+ * @retval            LT_FAIL Waiting failed
+ */
+lt_ret_t lt_unix_reactor_run(lt_unix_reactor_t *r, int32_t timeout_ms);
+
+/**
+ * @brief Makes `lt_unix_reactor_run()` return LT_PENDING, callable from any thread, e.g. to submit new operations.
+ *
+ * @param r           Reactor
+ */
+void lt_unix_reactor_wake(lt_unix_reactor_t *r);
+#endif
+
+#endif  // LIBTROPIC_PORT_UNIX_REACTOR_H
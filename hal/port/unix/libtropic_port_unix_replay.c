@@ -0,0 +1,184 @@
+/**
+ * @file libtropic_port_unix_replay.c
+ * @author Tropic Square s.r.o.
+ * @brief Replay of a session recorded by libtropic compiled with `LT_RECORD`.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_unix_replay.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+void lt_unix_record_fwrite(void *ctx, const uint8_t *data, const uint16_t len)
+{
+    if (fwrite(data, 1, len, (FILE *)ctx) != len) {
+        LT_LOG_ERROR("Writing of recording failed");
+    }
+}
+
+lt_ret_t lt_unix_replay_open(lt_unix_replay_t *replay, const char *path)
+{
+    if (!replay || !path) {
+        return LT_PARAM_ERR;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        LT_LOG_ERROR("Cannot open recording %s", path);
+        return LT_FAIL;
+    }
+
+    lt_ret_t ret = LT_FAIL;
+    long size;
+    if ((fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < LT_RECORD_HEADER_SIZE) || (fseek(f, 0, SEEK_SET) != 0)) {
+        goto close;
+    }
+
+    replay->data = malloc((size_t)size);
+    if (!replay->data) {
+        goto close;
+    }
+    if (fread(replay->data, 1, (size_t)size, f) != (size_t)size) {
+        goto close;
+    }
+    if (memcmp(replay->data, LT_RECORD_MAGIC, 4) || (replay->data[4] != LT_RECORD_VERSION)) {
+        LT_LOG_ERROR("%s is not a recording of version %d", path, LT_RECORD_VERSION);
+        goto close;
+    }
+
+    replay->size = (size_t)size;
+    lt_unix_replay_rewind(replay);
+    ret = LT_OK;
+
+close:
+    fclose(f);
+    if (ret != LT_OK) {
+        lt_unix_replay_close(replay);
+    }
+
+    return ret;
+}
+
+void lt_unix_replay_rewind(lt_unix_replay_t *replay)
+{
+    replay->pos = LT_RECORD_HEADER_SIZE;
+    replay->diverged = 0;
+}
+
+void lt_unix_replay_close(lt_unix_replay_t *replay)
+{
+    free(replay->data);
+    replay->data = NULL;
+    replay->size = 0;
+    replay->pos = 0;
+}
+
+/**
+ * Takes the next record, which has to be of operation `op`. Its data (`len` bytes) are returned in `data` for
+ * operations with data. Returns LT_FAIL when the record does not match, otherwise the status of the recorded call.
+ */
+static lt_ret_t replay_next(lt_unix_replay_t *replay, const lt_record_op_t op, const uint8_t **data, uint16_t *len)
+{
+    const uint8_t *r = replay->data + replay->pos;
+    size_t left = replay->size - replay->pos;
+    size_t head_len = data ? 4 : 2;
+
+    if (replay->diverged) {
+        return LT_FAIL;
+    }
+    if ((left < head_len) || (r[0] != op)) {
+        goto diverged;
+    }
+    if (data) {
+        *len = (uint16_t)(r[2] | (r[3] << 8));
+        if (left - head_len < *len) {
+            goto diverged;
+        }
+        *data = r + head_len;
+        replay->pos += *len;
+    }
+    replay->pos += head_len;
+
+    return (lt_ret_t)r[1];
+
+diverged:
+    LT_LOG_ERROR("Replay diverged at offset %zu, expected operation %d, recorded %d", replay->pos, (int)op,
+                 (left ? r[0] : 0));
+    replay->diverged = 1;
+
+    return LT_FAIL;
+}
+
+static lt_ret_t replay_op(void *ctx, const lt_record_op_t op)
+{
+    return replay_next((lt_unix_replay_t *)ctx, op, NULL, NULL);
+}
+
+static lt_ret_t replay_init(void *ctx) { return replay_op(ctx, LT_RECORD_OP_INIT); }
+
+static lt_ret_t replay_deinit(void *ctx) { return replay_op(ctx, LT_RECORD_OP_DEINIT); }
+
+static lt_ret_t replay_csn_low(void *ctx) { return replay_op(ctx, LT_RECORD_OP_CSN_LOW); }
+
+static lt_ret_t replay_csn_high(void *ctx) { return replay_op(ctx, LT_RECORD_OP_CSN_HIGH); }
+
+static lt_ret_t replay_transfer(void *ctx, uint8_t *data, uint16_t len)
+{
+    lt_unix_replay_t *replay = (lt_unix_replay_t *)ctx;
+    const uint8_t *miso;
+    uint16_t miso_len;
+
+    lt_ret_t ret = replay_next(replay, LT_RECORD_OP_TRANSFER, &miso, &miso_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (miso_len != len) {
+        LT_LOG_ERROR("Replay diverged, transfer of %u bytes, recorded %u", len, miso_len);
+        replay->diverged = 1;
+        return LT_FAIL;
+    }
+    memcpy(data, miso, len);
+
+    return LT_OK;
+}
+
+static lt_ret_t replay_random(void *ctx, void *buff, size_t count)
+{
+    lt_unix_replay_t *replay = (lt_unix_replay_t *)ctx;
+    const uint8_t *bytes;
+    uint16_t len;
+
+    // Large requests were recorded in several records
+    for (size_t done = 0; done < count; done += len) {
+        lt_ret_t ret = replay_next(replay, LT_RECORD_OP_RANDOM, &bytes, &len);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (!len || (len > count - done)) {
+            LT_LOG_ERROR("Replay diverged, %zu random bytes requested", count);
+            replay->diverged = 1;
+            return LT_FAIL;
+        }
+        memcpy((uint8_t *)buff + done, bytes, len);
+    }
+
+    return LT_OK;
+}
+
+const lt_unix_transport_t lt_unix_replay_transport = {
+    .init = replay_init,
+    .deinit = replay_deinit,
+    .spi_csn_low = replay_csn_low,
+    .spi_csn_high = replay_csn_high,
+    .spi_transfer = replay_transfer,
+    .wait = NULL,
+    .random_bytes = replay_random,
+};
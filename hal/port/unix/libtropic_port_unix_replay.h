@@ -0,0 +1,74 @@
+#ifndef LIBTROPIC_PORT_UNIX_REPLAY_H
+#define LIBTROPIC_PORT_UNIX_REPLAY_H
+
+/**
+ * @file libtropic_port_unix_replay.h
+ * @author Tropic Square s.r.o.
+ * @brief Replay of a session recorded by libtropic compiled with `LT_RECORD`, used as a transport of the loopback
+ * port.
+ *
+ * A session with real TROPIC01 is recorded by storing `lt_record_t` started by `lt_record_start()` (e.g. writing
+ * to a file by `lt_unix_record_fwrite()`) into `lt_l2_state_t.record`. The replay then serves the recorded MISO bytes
+ * and random bytes back from memory, without hardware. The host stack (L1 polling, CRC, L3 crypto, parsing)
+ * processes the same traffic, as long as the application makes the same calls as when it was recorded.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_port_unix_loopback.h"
+
+/** @brief Replay of a recording, zero initialized before `lt_unix_replay_open()`. */
+typedef struct lt_unix_replay_t {
+    /** @private @brief Whole recording. */
+    uint8_t *data;
+    /** @private @brief Size of the recording. */
+    size_t size;
+    /** @private @brief Position of the next record. */
+    size_t pos;
+    /** @public @brief Set when the calls differ from the recording, all calls fail then. */
+    uint8_t diverged;
+} lt_unix_replay_t;
+
+/** @brief Transport of the loopback port replaying `lt_unix_replay_t` given as `transport_ctx`. */
+extern const lt_unix_transport_t lt_unix_replay_transport;
+
+/**
+ * @brief Writes a part of recording to a file, `write` function for `lt_record_start()`.
+ *
+ * @param ctx    `FILE *` opened for binary writing
+ * @param data   Data to be written
+ * @param len    Length of data
+ */
+void lt_unix_record_fwrite(void *ctx, const uint8_t *data, const uint16_t len);
+
+/**
+ * @brief Loads the whole recording into memory.
+ *
+ * @param replay  Replay
+ * @param path    Path to the recording
+ *
+ * @retval        LT_OK         Function executed successfully
+ * @retval        LT_PARAM_ERR  Invalid parameter
+ * @retval        LT_FAIL       The file cannot be read or it is not a recording
+ */
+lt_ret_t lt_unix_replay_open(lt_unix_replay_t *replay, const char *path);
+
+/**
+ * @brief Starts the replay from the beginning again, e.g. to repeat it in a benchmark.
+ *
+ * @param replay  Replay
+ */
+void lt_unix_replay_rewind(lt_unix_replay_t *replay);
+
+/**
+ * @brief Frees the recording.
+ *
+ * @param replay  Replay
+ */
+void lt_unix_replay_close(lt_unix_replay_t *replay);
+
+#endif  // LIBTROPIC_PORT_UNIX_REPLAY_H
@@ -0,0 +1,77 @@
+/**
+ * @file libtropic_port_unix_rng.c
+ * @author Tropic Square s.r.o.
+ * @brief Random number generator shared by Unix ports, buffered entropy from the operating system.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_unix_rng.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/random.h>
+#include <sys/types.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+/** Fills the whole buffer by getrandom(), which may return less bytes than requested or be interrupted */
+static lt_ret_t getrandom_all(uint8_t *buff, size_t count)
+{
+    size_t filled = 0;
+
+    while (filled < count) {
+        ssize_t ret = getrandom(buff + filled, count - filled, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LT_LOG_ERROR("getrandom() failed: %s (%d)", strerror(errno), errno);
+            return LT_FAIL;
+        }
+        filled += ret;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_rng_bytes(lt_unix_rng_t *rng, void *buff, size_t count)
+{
+    uint8_t *buff_ptr = buff;
+
+    while (count > 0) {
+        if (rng->available == 0) {
+            // Requests bigger than the pool do not need to go through it
+            if (count >= LT_UNIX_RNG_POOL_SIZE) {
+                return getrandom_all(buff_ptr, count);
+            }
+            lt_ret_t ret = getrandom_all(rng->pool, LT_UNIX_RNG_POOL_SIZE);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            rng->available = LT_UNIX_RNG_POOL_SIZE;
+        }
+
+        size_t n = (count < rng->available) ? count : rng->available;
+        rng->available -= n;
+        // Bytes are taken from the end of the unused part and wiped right away, so they cannot be handed out again
+        memcpy(buff_ptr, rng->pool + rng->available, n);
+        memset(rng->pool + rng->available, 0, n);
+        buff_ptr += n;
+        count -= n;
+    }
+
+    return LT_OK;
+}
+
+void lt_unix_rng_wipe(lt_unix_rng_t *rng)
+{
+    volatile uint8_t *pool = rng->pool;
+    for (size_t i = 0; i < LT_UNIX_RNG_POOL_SIZE; i++) {
+        pool[i] = 0;
+    }
+    rng->available = 0;
+}
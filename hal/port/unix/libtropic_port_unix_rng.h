@@ -0,0 +1,49 @@
+#ifndef LIBTROPIC_PORT_UNIX_RNG_H
+#define LIBTROPIC_PORT_UNIX_RNG_H
+
+/**
+ * @file libtropic_port_unix_rng.h
+ * @author Tropic Square s.r.o.
+ * @brief Random number generator shared by Unix ports, buffered entropy from the operating system.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** Size of the entropy pool, one refill covers several session starts (32 bytes each) */
+#define LT_UNIX_RNG_POOL_SIZE 256
+
+/**
+ * @brief Pool of random bytes obtained from getrandom(). Bytes are wiped from the pool once handed out.
+ *
+ * @note Zero initialized pool is empty and valid.
+ */
+typedef struct lt_unix_rng_t {
+    /** @private @brief Random bytes, the first `available` of them were not used yet. */
+    uint8_t pool[LT_UNIX_RNG_POOL_SIZE];
+    /** @private @brief Number of unused bytes in the pool. */
+    size_t available;
+} lt_unix_rng_t;
+
+/**
+ * @brief Fills buffer with random bytes from the pool, the pool is refilled from the operating system when empty.
+ *
+ * @param rng    Pool of random bytes
+ * @param buff   Buffer to be filled
+ * @param count  Number of bytes to be filled
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_rng_bytes(lt_unix_rng_t *rng, void *buff, size_t count);
+
+/**
+ * @brief Wipes unused random bytes from the pool.
+ *
+ * @param rng  Pool of random bytes
+ */
+void lt_unix_rng_wipe(lt_unix_rng_t *rng);
+
+#endif  // LIBTROPIC_PORT_UNIX_RNG_H
@@ -4,11 +4,18 @@
  * @brief Port for communication using Generic SPI and GPIO Linux UAPI.
  *
  * @note The chip select (CS) pin is controlled separately using GPIO, as the protocol requires
- *       manual handling of the chip select.
+ *       manual handling of the chip select. With `spi_hw_cs`, native CS of the SPI controller is used
+ *       instead and kept asserted between frame phases using `cs_change`.
  *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
+#if LT_PORT_OPS
+// Port functions get names of their own, so the port can be linked together with other ports
+#define LT_PORT_OPS_PREFIX lt_port_unix_spi
+#include "libtropic_port_ops.h"
+#endif
+
 // SPI-related includes
 #include <fcntl.h>
 #include <linux/spi/spidev.h>
@@ -19,12 +26,15 @@
 // GPIO
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <linux/gpio.h>
+#include <poll.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "libtropic_common.h"
 #include "libtropic_logging.h"
@@ -32,82 +42,413 @@
 #include "libtropic_port.h"
 #include "libtropic_port_unix_spi.h"
 
+#if LT_USE_INT_PIN
+/** Requests INT lines of all chips of the bus as one request with rising edge detection */
+static lt_ret_t spi_bus_int_request(lt_unix_spi_bus_t *bus)
+{
+    if (bus->int_cnt > GPIO_V2_LINES_MAX) {
+        LT_LOG_ERROR("At most %d INT lines can be requested", GPIO_V2_LINES_MAX);
+        return LT_FAIL;
+    }
+
+    // Waits of the chips are timed by CLOCK_MONOTONIC, as libtropic's timeouts are
+    pthread_condattr_t attr;
+    if (pthread_condattr_init(&attr) || pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)
+        || pthread_cond_init(&bus->int_cond, &attr)) {
+        LT_LOG_ERROR("INT condition initialization failed");
+        pthread_condattr_destroy(&attr);
+        return LT_FAIL;
+    }
+    pthread_condattr_destroy(&attr);
+
+    memset(&bus->intreq, 0, sizeof(bus->intreq));
+    for (uint8_t i = 0; i < bus->int_cnt; i++) {
+        bus->intreq.offsets[i] = bus->int_lines[i];
+        bus->int_devs[i] = NULL;
+    }
+    bus->intreq.num_lines = bus->int_cnt;
+    bus->intreq.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+    if (ioctl(bus->gpio_fd, GPIO_V2_GET_LINE_IOCTL, &bus->intreq) < 0) {
+        LT_LOG_ERROR("GPIO_V2_GET_LINE_IOCTL error (INT lines): %s", strerror(errno));
+        pthread_cond_destroy(&bus->int_cond);
+        bus->intreq.fd = -1;
+        return LT_FAIL;
+    }
+    bus->int_pending = 0;
+    bus->int_reading = false;
+
+    return LT_OK;
+}
+#endif
+
+lt_ret_t lt_unix_spi_bus_init(lt_unix_spi_bus_t *bus)
+{
+    uint32_t mode = SPI_MODE_0;
+
+    if (!bus) {
+        return LT_PARAM_ERR;
+    }
+
+    bus->fd = open(bus->spi_dev, O_RDWR | O_CLOEXEC);
+    if (bus->fd < 0) {
+        LT_LOG_ERROR("Can't open SPI device %s: %s", bus->spi_dev, strerror(errno));
+        return LT_FAIL;
+    }
+    // Speed is set by each transfer, as it can differ between chips
+    if (ioctl(bus->fd, SPI_IOC_WR_MODE32, &mode) < 0) {
+        LT_LOG_ERROR("Can't set SPI mode: %s", strerror(errno));
+        close(bus->fd);
+        return LT_FAIL;
+    }
+
+    bus->gpio_fd = open(bus->gpio_dev, O_RDWR | O_CLOEXEC);
+    if (bus->gpio_fd < 0) {
+        LT_LOG_ERROR("Can't open GPIO device %s: %s", bus->gpio_dev, strerror(errno));
+        close(bus->fd);
+        return LT_FAIL;
+    }
+
+    if (pthread_mutex_init(&bus->mutex, NULL) || pthread_cond_init(&bus->cond, NULL)) {
+        LT_LOG_ERROR("Bus lock initialization failed");
+        close(bus->gpio_fd);
+        close(bus->fd);
+        return LT_FAIL;
+    }
+    bus->next = 0;
+    bus->serving = 0;
+
+#if LT_USE_INT_PIN
+    bus->intreq.fd = -1;
+    if (bus->int_cnt && (spi_bus_int_request(bus) != LT_OK)) {
+        pthread_cond_destroy(&bus->cond);
+        pthread_mutex_destroy(&bus->mutex);
+        close(bus->gpio_fd);
+        close(bus->fd);
+        return LT_FAIL;
+    }
+#endif
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_spi_bus_deinit(lt_unix_spi_bus_t *bus)
+{
+    if (!bus) {
+        return LT_PARAM_ERR;
+    }
+
+    int int_close_ret = 0;
+#if LT_USE_INT_PIN
+    if (bus->intreq.fd >= 0) {
+        int_close_ret = close(bus->intreq.fd);
+        bus->intreq.fd = -1;
+        pthread_cond_destroy(&bus->int_cond);
+    }
+#endif
+    pthread_cond_destroy(&bus->cond);
+    pthread_mutex_destroy(&bus->mutex);
+    int gpio_close_ret = close(bus->gpio_fd);
+    int spi_close_ret = close(bus->fd);
+
+    if (int_close_ret || gpio_close_ret || spi_close_ret) {
+        return LT_FAIL;
+    }
+    return LT_OK;
+}
+
+#if LT_USE_INT_PIN
+/** Marks lines of edge events in `int_pending`, with the bus mutex held. Returns bits of the lines. */
+static uint64_t spi_bus_int_events(lt_unix_spi_bus_t *bus, const struct gpio_v2_line_event *events, const size_t cnt)
+{
+    uint64_t bits = 0;
+
+    for (size_t i = 0; i < cnt; i++) {
+        for (uint8_t j = 0; j < bus->int_cnt; j++) {
+            if (bus->int_lines[j] == events[i].offset) {
+                bits |= (uint64_t)1 << j;
+                break;
+            }
+        }
+    }
+    bus->int_pending |= bits;
+
+    return bits;
+}
+
+/** Waits at most `ms` for edge events of the bus and reads them, without the bus mutex held */
+static lt_ret_t spi_bus_int_poll(lt_unix_spi_bus_t *bus, const int ms, struct gpio_v2_line_event *events,
+                                 size_t *cnt)
+{
+    struct pollfd pfd = {.fd = bus->intreq.fd, .events = POLLIN};
+
+    *cnt = 0;
+    int ret = poll(&pfd, 1, ms);
+    if (ret < 0) {
+        if (errno == EINTR) {
+            return LT_OK;
+        }
+        LT_LOG_ERROR("poll() failed: %s", strerror(errno));
+        return LT_FAIL;
+    }
+    if (ret == 0) {
+        return LT_OK;
+    }
+
+    // One read takes all queued events which fit into the buffer
+    ssize_t len = read(bus->intreq.fd, events, GPIO_V2_LINES_MAX * sizeof(*events));
+    if ((len < 0) || (len % sizeof(*events))) {
+        LT_LOG_ERROR("Can't read INT line events: %s", strerror(errno));
+        return LT_FAIL;
+    }
+    *cnt = (size_t)len / sizeof(*events);
+
+    return LT_OK;
+}
+
+int lt_unix_spi_bus_int_fd(const lt_unix_spi_bus_t *bus)
+{
+    return (bus && bus->int_cnt) ? bus->intreq.fd : -1;
+}
+
+lt_ret_t lt_unix_spi_bus_int_read(lt_unix_spi_bus_t *bus, void (*cb)(struct lt_dev_unix_spi_t *device, void *ctx),
+                                  void *ctx)
+{
+    struct gpio_v2_line_event events[GPIO_V2_LINES_MAX];
+    size_t cnt;
+
+    if (!bus || !bus->int_cnt) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = spi_bus_int_poll(bus, 0, events, &cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    lt_dev_unix_spi_t *devs[GPIO_V2_LINES_MAX];
+    uint8_t devs_cnt = 0;
+    pthread_mutex_lock(&bus->mutex);
+    uint64_t bits = spi_bus_int_events(bus, events, cnt);
+    for (uint8_t i = 0; i < bus->int_cnt; i++) {
+        if ((bits & ((uint64_t)1 << i)) && bus->int_devs[i]) {
+            devs[devs_cnt++] = bus->int_devs[i];
+        }
+    }
+    // Devices waiting in lt_port_delay_on_int() take their edges as well
+    if (bits) {
+        pthread_cond_broadcast(&bus->int_cond);
+    }
+    pthread_mutex_unlock(&bus->mutex);
+
+    for (uint8_t i = 0; cb && (i < devs_cnt); i++) {
+        cb(devs[i], ctx);
+    }
+
+    return LT_OK;
+}
+#endif
+
+/** Waits for the bus shared with other chips, if it is not held by the device already */
+static void spi_bus_take(lt_dev_unix_spi_t *device)
+{
+    lt_unix_spi_bus_t *bus = device->bus;
+
+    if (!bus || device->bus_held) {
+        return;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    unsigned long ticket = bus->next++;
+    while (bus->serving != ticket) {
+        pthread_cond_wait(&bus->cond, &bus->mutex);
+    }
+    pthread_mutex_unlock(&bus->mutex);
+    device->bus_held = true;
+}
+
+/** Passes the bus to the next waiting chip, unless a transaction of the device continues */
+static void spi_bus_give(lt_dev_unix_spi_t *device)
+{
+    lt_unix_spi_bus_t *bus = device->bus;
+
+    if (!device->bus_held || device->bus_txn) {
+        return;
+    }
+
+    device->bus_held = false;
+    pthread_mutex_lock(&bus->mutex);
+    bus->serving++;
+    pthread_cond_broadcast(&bus->cond);
+    pthread_mutex_unlock(&bus->mutex);
+}
+
+/** Requests CS (and INT) lines from already opened GPIO chip, only the lines are released on failure */
+static lt_ret_t spi_lines_request(lt_l2_state_t *s2)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    if (!device->spi_hw_cs) {
+        memset(&device->gpioreq, 0, sizeof(device->gpioreq));
+        device->gpioreq.offsets[0] = device->gpio_cs_num;
+        device->gpioreq.num_lines = 1;
+        device->gpioreq.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+        device->gpioreq.config.num_attrs = 1;
+        device->gpioreq.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        device->gpioreq.config.attrs[0].mask = 1;
+        device->gpioreq.config.attrs[0].attr.values = 1;  // initial value = 1
+        if (ioctl(device->gpio_fd, GPIO_V2_GET_LINE_IOCTL, &device->gpioreq) < 0) {
+            LT_LOG_S2_ERROR(s2, "GPIO_V2_GET_LINE_IOCTL error!");
+            LT_LOG_S2_ERROR(s2, "Error string: %s", strerror(errno));
+            device->gpioreq.fd = -1;
+            return LT_FAIL;
+        }
+    }
+
+#if LT_USE_INT_PIN
+    LT_LOG_S2_DEBUG(s2, "GPIO INT pin: %d", device->gpio_int_num);
+
+    device->int_idx = -1;
+    device->intreq.fd = -1;
+    if (device->bus && device->bus->int_cnt) {
+        // INT line was requested by the bus together with lines of the other chips
+        lt_unix_spi_bus_t *bus = device->bus;
+        for (uint8_t i = 0; i < bus->int_cnt; i++) {
+            if (bus->int_lines[i] == (unsigned int)device->gpio_int_num) {
+                device->int_idx = i;
+            }
+        }
+        if (device->int_idx < 0) {
+            LT_LOG_S2_ERROR(s2, "INT pin %d is not among INT lines of the bus!", device->gpio_int_num);
+            if (device->gpioreq.fd >= 0) {
+                close(device->gpioreq.fd);
+                device->gpioreq.fd = -1;
+            }
+            return LT_PARAM_ERR;
+        }
+        pthread_mutex_lock(&bus->mutex);
+        bus->int_devs[device->int_idx] = device;
+        pthread_mutex_unlock(&bus->mutex);
+
+        return LT_OK;
+    }
+
+    // INT pin is requested with rising edge detection, so the kernel queues an event when the response is ready.
+    memset(&device->intreq, 0, sizeof(device->intreq));
+    device->intreq.offsets[0] = device->gpio_int_num;
+    device->intreq.num_lines = 1;
+    device->intreq.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+    if (ioctl(device->gpio_fd, GPIO_V2_GET_LINE_IOCTL, &device->intreq) < 0) {
+        LT_LOG_S2_ERROR(s2, "GPIO_V2_GET_LINE_IOCTL error (INT pin)!");
+        LT_LOG_S2_ERROR(s2, "Error string: %s", strerror(errno));
+        if (device->gpioreq.fd >= 0) {
+            close(device->gpioreq.fd);
+            device->gpioreq.fd = -1;
+        }
+        return LT_FAIL;
+    }
+#endif
+
+    return LT_OK;
+}
+
 lt_ret_t lt_port_init(lt_l2_state_t *s2)
 {
     lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
     uint32_t request_mode;
 
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&device->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
     srand(device->rng_seed);
+    lt_unix_rng_wipe(&device->rng);
 
-    LT_LOG_DEBUG("Initializing SPI...\n");
-    LT_LOG_DEBUG("SPI speed: %d", device->spi_speed);
-    LT_LOG_DEBUG("SPI device: %s", device->spi_dev);
-    LT_LOG_DEBUG("GPIO device: %s", device->gpio_dev);
-    LT_LOG_DEBUG("GPIO CS pin: %d", device->gpio_cs_num);
+    LT_LOG_S2_DEBUG(s2, "Initializing SPI...\n");
+    LT_LOG_S2_DEBUG(s2, "SPI speed: %d", device->spi_speed);
+    LT_LOG_S2_DEBUG(s2, "SPI device: %s", device->spi_dev);
+    LT_LOG_S2_DEBUG(s2, "GPIO device: %s", device->gpio_dev);
+    LT_LOG_S2_DEBUG(s2, "GPIO CS pin: %d", device->gpio_cs_num);
+    LT_LOG_S2_DEBUG(s2, "SPI HW CS: %d", device->spi_hw_cs);
 
     device->mode = SPI_MODE_0;
+    device->gpioreq.fd = -1;
+    device->bus_held = false;
+    device->bus_txn = false;
+    if (device->bus) {
+        // Native CS of spidev belongs to a single chip
+        if (device->spi_hw_cs) {
+            LT_LOG_S2_ERROR(s2, "Native CS cannot be used on a shared bus!");
+            return LT_PARAM_ERR;
+        }
+        device->fd = device->bus->fd;
+        device->gpio_fd = device->bus->gpio_fd;
+
+        return spi_lines_request(s2);
+    }
+
     device->fd = open(device->spi_dev, O_RDWR);
     if (device->fd < 0) {
-        LT_LOG_ERROR("Can't open device!");
+        LT_LOG_S2_ERROR(s2, "Can't open device!");
         return LT_FAIL;
     }
 
     request_mode = device->mode;
     if (ioctl(device->fd, SPI_IOC_WR_MODE32, &device->mode) < 0) {
-        LT_LOG_ERROR("Can't set SPI mode!");
+        LT_LOG_S2_ERROR(s2, "Can't set SPI mode!");
         close(device->fd);
         return LT_FAIL;
     }
 
     // RD is read what mode the device actually is in.
     if (ioctl(device->fd, SPI_IOC_RD_MODE32, &device->mode) < 0) {
-        LT_LOG_ERROR("Can't get SPI mode!");
+        LT_LOG_S2_ERROR(s2, "Can't get SPI mode!");
         close(device->fd);
         return LT_FAIL;
     }
     if (request_mode != device->mode) {
-        LT_LOG_WARN("Device does not support requested mode 0x%" PRIx32, request_mode);
+        LT_LOG_S2_WARN(s2, "Device does not support requested mode 0x%" PRIx32, request_mode);
     }
 
     if (ioctl(device->fd, SPI_IOC_WR_MAX_SPEED_HZ, &device->spi_speed) < 0) {
-        LT_LOG_ERROR("Can't set max SPI speed.");
+        LT_LOG_S2_ERROR(s2, "Can't set max SPI speed.");
         close(device->fd);
         return LT_FAIL;
     }
 
+    device->gpio_fd = -1;
+    device->gpioreq.fd = -1;
+#if !LT_USE_INT_PIN
+    // GPIO chip is not needed at all when CS is driven by the SPI controller.
+    if (device->spi_hw_cs) {
+        return LT_OK;
+    }
+#endif
+
     // CS is controlled separately.
     device->gpio_fd = open(device->gpio_dev, O_RDWR | O_CLOEXEC);
     if (device->gpio_fd < 0) {
-        LT_LOG_ERROR("Can't open GPIO device!");
+        LT_LOG_S2_ERROR(s2, "Can't open GPIO device!");
         close(device->fd);
         return LT_FAIL;
     }
 
     struct gpiochip_info info;
     if (ioctl(device->gpio_fd, GPIO_GET_CHIPINFO_IOCTL, &info) < 0) {
-        LT_LOG_ERROR("GPIO_GET_CHIPINFO_IOCTL error!");
-        LT_LOG_ERROR("Error string: %s", strerror(errno));
+        LT_LOG_S2_ERROR(s2, "GPIO_GET_CHIPINFO_IOCTL error!");
+        LT_LOG_S2_ERROR(s2, "Error string: %s", strerror(errno));
         close(device->fd);
         close(device->gpio_fd);
         return LT_FAIL;
     }
 
-    LT_LOG_DEBUG("GPIO chip information:");
-    LT_LOG_DEBUG("- info.name  = \"%s\"", info.name);
-    LT_LOG_DEBUG("- info.label = \"%s\"", info.label);
-    LT_LOG_DEBUG("- info.lines = \"%u\"", info.lines);
+    LT_LOG_S2_DEBUG(s2, "GPIO chip information:");
+    LT_LOG_S2_DEBUG(s2, "- info.name  = \"%s\"", info.name);
+    LT_LOG_S2_DEBUG(s2, "- info.label = \"%s\"", info.label);
+    LT_LOG_S2_DEBUG(s2, "- info.lines = \"%u\"", info.lines);
 
-    memset(&device->gpioreq, 0, sizeof(device->gpioreq));
-    device->gpioreq.offsets[0] = device->gpio_cs_num;
-    device->gpioreq.num_lines = 1;
-    device->gpioreq.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
-    device->gpioreq.config.num_attrs = 1;
-    device->gpioreq.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
-    device->gpioreq.config.attrs[0].mask = 1;
-    device->gpioreq.config.attrs[0].attr.values = 1;  // initial value = 1
-    if (ioctl(device->gpio_fd, GPIO_V2_GET_LINE_IOCTL, &device->gpioreq) < 0) {
-        LT_LOG_ERROR("GPIO_V2_GET_LINE_IOCTL error!");
-        LT_LOG_ERROR("Error string: %s", strerror(errno));
+    if (spi_lines_request(s2) != LT_OK) {
         close(device->fd);
         close(device->gpio_fd);
         return LT_FAIL;
@@ -120,12 +461,30 @@ lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
 {
     lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
 
+    lt_unix_rng_wipe(&device->rng);
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&device->lock);
+#endif
+
     // We want to attempt to close both, even if one of them fails, hence storing the return val
     // and checking later.
-    int gpio_close_ret = close(device->gpio_fd);
-    int spi_close_ret = close(device->fd);
+    int int_close_ret = 0;
+#if LT_USE_INT_PIN
+    if (device->int_idx >= 0) {
+        pthread_mutex_lock(&device->bus->mutex);
+        device->bus->int_devs[device->int_idx] = NULL;
+        pthread_mutex_unlock(&device->bus->mutex);
+    }
+    else {
+        int_close_ret = close(device->intreq.fd);
+    }
+#endif
+    int cs_close_ret = (device->gpioreq.fd >= 0) ? close(device->gpioreq.fd) : 0;
+    // Descriptors of a shared bus are closed by lt_unix_spi_bus_deinit()
+    int gpio_close_ret = (!device->bus && (device->gpio_fd >= 0)) ? close(device->gpio_fd) : 0;
+    int spi_close_ret = device->bus ? 0 : close(device->fd);
 
-    if (gpio_close_ret || spi_close_ret) {
+    if (int_close_ret || cs_close_ret || gpio_close_ret || spi_close_ret) {
         return LT_FAIL;
     }
     return LT_OK;
@@ -136,11 +495,20 @@ lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
     lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
     struct gpio_v2_line_values values;
 
+    // Native CS is asserted by the controller together with the first transfer of the frame.
+    if (device->spi_hw_cs) {
+        return LT_OK;
+    }
+
+    // Bus is held until CS is released, so frames of other chips on the bus are not mixed with this one
+    spi_bus_take(device);
+
     values.mask = 1;
     values.bits = 0;
     if (ioctl(device->gpioreq.fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
-        LT_LOG_ERROR("GPIO_V2_LINE_SET_VALUES_IOCTL error!");
-        LT_LOG_ERROR("Error string: %s", strerror(errno));
+        LT_LOG_S2_ERROR(s2, "GPIO_V2_LINE_SET_VALUES_IOCTL error!");
+        LT_LOG_S2_ERROR(s2, "Error string: %s", strerror(errno));
+        spi_bus_give(device);
         return LT_FAIL;
     }
     return LT_OK;
@@ -151,27 +519,42 @@ lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
     lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
     struct gpio_v2_line_values values;
 
+    // Native CS is kept asserted after the last transfer, empty message without cs_change releases it.
+    if (device->spi_hw_cs) {
+        struct spi_ioc_transfer spi = {0};
+        if (ioctl(device->fd, SPI_IOC_MESSAGE(1), &spi) < 0) {
+            LT_LOG_S2_ERROR(s2, "SPI_IOC_MESSAGE error: %s", strerror(errno));
+            return LT_FAIL;
+        }
+        return LT_OK;
+    }
+
     values.mask = 1;
     values.bits = 1;
-    if (ioctl(device->gpioreq.fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
-        LT_LOG_ERROR("GPIO_V2_LINE_SET_VALUES_IOCTL error!");
-        LT_LOG_ERROR("Error string: %s", strerror(errno));
+    int ret = ioctl(device->gpioreq.fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+    // Given up even on failure, the chip would not recognize a frame of another chip anyway with its CS high
+    spi_bus_give(device);
+    if (ret < 0) {
+        LT_LOG_S2_ERROR(s2, "GPIO_V2_LINE_SET_VALUES_IOCTL error!");
+        LT_LOG_S2_ERROR(s2, "Error string: %s", strerror(errno));
         return LT_FAIL;
     }
     return LT_OK;
 }
 
-lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+/** Transfers bytes of the frame, NULL `tx_buf` or `rx_buf` is allowed by spidev */
+static lt_ret_t spi_transfer_one(lt_dev_unix_spi_t *device, const uint8_t *tx, uint8_t *rx, uint16_t len)
 {
-    UNUSED(timeout_ms);
-    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
-
     int ret = 0;
     struct spi_ioc_transfer spi = {
-        .tx_buf = (unsigned long)s2->buff + offset,
-        .rx_buf = (unsigned long)s2->buff + offset,
-        .len = tx_data_length,
+        .tx_buf = (unsigned long)tx,
+        .rx_buf = (unsigned long)rx,
+        .len = len,
+        // Set for each transfer, other chips on a shared bus may run at a different speed
+        .speed_hz = (uint32_t)device->spi_speed,
         .delay_usecs = 0,
+        // Keep native CS asserted after the transfer, frame is finished by lt_port_spi_csn_high().
+        .cs_change = device->spi_hw_cs ? 1 : 0,
     };
 
     ret = ioctl(device->fd, SPI_IOC_MESSAGE(1), &spi);
@@ -181,29 +564,358 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_dat
     return LT_FAIL;
 }
 
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    return spi_transfer_one(device, s2->buff + offset, s2->buff + offset, tx_data_length);
+}
+
+#if LT_USE_SPI_TRANSFER_BUF
+lt_ret_t lt_port_spi_transfer_buf(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                  uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    // Data go by DMA of the controller straight from and to the buffers, spidev sends zeros for NULL tx_buf
+    return spi_transfer_one(device, tx ? tx : rx, rx, len);
+}
+#endif
+
+#if LT_USE_SPI_TRANSACTION
+/** Prepares spidev transfer of one segment, segment with `tx` is only sent (received bytes are discarded) */
+static lt_ret_t spi_segment_prepare(lt_l2_state_t *s2, const lt_l1_spi_segment_t *seg, struct spi_ioc_transfer *spi)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    memset(spi, 0, sizeof(*spi));
+    spi->speed_hz = (uint32_t)device->spi_speed;
+    if (seg->tx) {
+        if (seg->len > LT_L1_LEN_MAX) {
+            return LT_L1_DATA_LEN_ERROR;
+        }
+        spi->tx_buf = (unsigned long)seg->tx;
+    }
+    else {
+        if (seg->offset + seg->len > LT_L1_LEN_MAX) {
+            return LT_L1_DATA_LEN_ERROR;
+        }
+        spi->tx_buf = (unsigned long)s2->buff + seg->offset;
+        spi->rx_buf = (unsigned long)s2->buff + seg->offset;
+    }
+    spi->len = seg->len;
+
+    return LT_OK;
+}
+
+/** Executes all frames of the transaction */
+static lt_ret_t spi_transaction_frames(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+    struct spi_ioc_transfer spi[LT_L1_SPI_SEGMENTS_MAX];
+    lt_ret_t ret;
+
+    if (seg_cnt > LT_L1_SPI_SEGMENTS_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    if (device->spi_hw_cs) {
+        // Whole transaction is a single message. On the other than last transfer, cs_change releases native CS
+        // until the next transfer. On the last transfer, cs_change keeps native CS asserted after the message.
+        for (uint8_t i = 0; i < seg_cnt; i++) {
+            ret = spi_segment_prepare(s2, &segs[i], &spi[i]);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            spi[i].cs_change = (i == seg_cnt - 1) ? !!segs[i].cs_hold : !segs[i].cs_hold;
+        }
+
+        if (ioctl(device->fd, SPI_IOC_MESSAGE(seg_cnt), spi) < 0) {
+            LT_LOG_S2_ERROR(s2, "SPI_IOC_MESSAGE error: %s", strerror(errno));
+            lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return LT_FAIL anyway.
+            return LT_FAIL;
+        }
+        return LT_OK;
+    }
+
+    uint8_t first = 0;
+    while (first < seg_cnt) {
+        // All segments up to the one which releases chip select are submitted as a single message.
+        uint8_t n = 0;
+        do {
+            ret = spi_segment_prepare(s2, &segs[first + n], &spi[n]);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            n++;
+        } while ((first + n < seg_cnt) && segs[first + n - 1].cs_hold);
+
+        ret = lt_port_spi_csn_low(s2);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        if (ioctl(device->fd, SPI_IOC_MESSAGE(n), spi) < 0) {
+            LT_LOG_S2_ERROR(s2, "SPI_IOC_MESSAGE error: %s", strerror(errno));
+            lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return LT_FAIL anyway.
+            return LT_FAIL;
+        }
+
+        if (!segs[first + n - 1].cs_hold) {
+            ret = lt_port_spi_csn_high(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+        first += n;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    // Whole transaction is done in one turn on a shared bus, CS of its frames does not pass the bus
+    spi_bus_take(device);
+    device->bus_txn = true;
+    lt_ret_t ret = spi_transaction_frames(s2, segs, seg_cnt);
+    device->bus_txn = false;
+    // Last frame may keep CS asserted, the bus is then given up by lt_port_spi_csn_high()
+    if ((ret != LT_OK) || !seg_cnt || !segs[seg_cnt - 1].cs_hold) {
+        spi_bus_give(device);
+    }
+
+    return ret;
+}
+#endif
+
 lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
 {
-    UNUSED(s2);
-    LT_LOG_DEBUG("-- Waiting for the target.");
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+    LT_LOG_S2_DEBUG(s2, "-- Waiting for the target.");
+
+    return lt_unix_delay(&device->delay, s2, (uint64_t)ms * 1000);
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    return lt_unix_delay(&device->delay, s2, us);
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
 
-    int ret = usleep(ms * 1000);
-    if (ret != 0) {
-        LT_LOG_ERROR("usleep() failed: %s (%d)", strerror(errno), ret);
+    if (hz > INT_MAX) {
         return LT_FAIL;
     }
+    // Used by the next transfer, spidev does not report the clock the controller rounds it to
+    device->spi_speed = (int)hz;
+    *actual_hz = hz;
 
     return LT_OK;
 }
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    lt_unix_lock_take(&device->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    lt_unix_lock_release(&device->lock);
+}
+#endif
 
 lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
 {
-    UNUSED(s2);
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+
+    return lt_unix_rng_bytes(&device->rng, buff, count);
+}
 
-    uint8_t *buff_ptr = buff;
-    for (size_t i = 0; i < count; i++) {
-        // Number from rand() is guaranteed to have at least 15 bits valid
-        buff_ptr[i] = (uint8_t)(rand() & 0xFF);
+#if LT_USE_INT_PIN
+static void timespec_add_ms(struct timespec *ts, const uint32_t ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/** Milliseconds from now until `deadline`, 0 when it has passed */
+static int timespec_left_ms(const struct timespec *deadline)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t left_ns = ((int64_t)(deadline->tv_sec - now.tv_sec) * 1000000000) + (deadline->tv_nsec - now.tv_nsec);
+
+    return (left_ns > 0) ? (int)((left_ns + 999999) / 1000000) : 0;
+}
+
+/**
+ * Waits for an edge on the INT line requested by the bus. One of the waiting devices reads the events of all lines
+ * and passes them to the others, which sleep on `int_cond` meanwhile.
+ */
+static lt_ret_t spi_bus_int_wait(lt_l2_state_t *s2, const uint32_t ms)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+    lt_unix_spi_bus_t *bus = device->bus;
+    const uint64_t bit = (uint64_t)1 << device->int_idx;
+    struct gpio_v2_line_values values = {.mask = bit, .bits = 0};
+    struct gpio_v2_line_event events[GPIO_V2_LINES_MAX];
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    timespec_add_ms(&deadline, ms);
+
+    // Drop edges read before, they belong to responses which were already read
+    pthread_mutex_lock(&bus->mutex);
+    bus->int_pending &= ~bit;
+    pthread_mutex_unlock(&bus->mutex);
+
+    // INT pin may be already asserted, its rising edge would be missed then.
+    if (ioctl(bus->intreq.fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+        LT_LOG_S2_ERROR(s2, "GPIO_V2_LINE_GET_VALUES_IOCTL error: %s", strerror(errno));
+        return LT_FAIL;
+    }
+    if (values.bits & bit) {
+        return LT_OK;
+    }
+
+    lt_ret_t ret = LT_L1_INT_TIMEOUT;
+    pthread_mutex_lock(&bus->mutex);
+    for (;;) {
+        if (bus->int_pending & bit) {
+            bus->int_pending &= ~bit;
+            ret = LT_OK;
+            break;
+        }
+        int left_ms = timespec_left_ms(&deadline);
+        if (!left_ms) {
+            break;
+        }
+
+        if (bus->int_reading) {
+            pthread_cond_timedwait(&bus->int_cond, &bus->mutex, &deadline);
+            continue;
+        }
+        bus->int_reading = true;
+        pthread_mutex_unlock(&bus->mutex);
+
+        size_t cnt;
+        lt_ret_t ret_poll = spi_bus_int_poll(bus, left_ms, events, &cnt);
+
+        pthread_mutex_lock(&bus->mutex);
+        spi_bus_int_events(bus, events, cnt);
+        bus->int_reading = false;
+        // Wakes devices whose edges were read, and lets another one read when this device is done
+        pthread_cond_broadcast(&bus->int_cond);
+        if (ret_poll != LT_OK) {
+            ret = ret_poll;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&bus->mutex);
+
+    return ret;
+}
+
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_spi_t *device = (lt_dev_unix_spi_t *)(s2->device);
+    if (device->int_idx >= 0) {
+        return spi_bus_int_wait(s2, ms);
+    }
+
+    struct gpio_v2_line_event event;
+    struct gpio_v2_line_values values = {.mask = 1, .bits = 0};
+    struct pollfd pfd = {.fd = device->intreq.fd, .events = POLLIN};
+
+    // Drop edge events queued before, they belong to responses which were already read.
+    while (poll(&pfd, 1, 0) > 0) {
+        if (read(device->intreq.fd, &event, sizeof(event)) != (ssize_t)sizeof(event)) {
+            LT_LOG_S2_ERROR(s2, "Can't read INT pin event: %s", strerror(errno));
+            return LT_FAIL;
+        }
+    }
+
+    // INT pin may be already asserted, its rising edge would be missed then.
+    if (ioctl(device->intreq.fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+        LT_LOG_S2_ERROR(s2, "GPIO_V2_LINE_GET_VALUES_IOCTL error: %s", strerror(errno));
+        return LT_FAIL;
+    }
+    if (values.bits & 1) {
+        return LT_OK;
+    }
+
+    int ret = poll(&pfd, 1, (int)ms);
+    if (ret < 0) {
+        LT_LOG_S2_ERROR(s2, "poll() failed: %s", strerror(errno));
+        return LT_FAIL;
+    }
+    if (ret == 0) {
+        return LT_L1_INT_TIMEOUT;
+    }
+
+    if (read(device->intreq.fd, &event, sizeof(event)) != (ssize_t)sizeof(event)) {
+        LT_LOG_S2_ERROR(s2, "Can't read INT pin event: %s", strerror(errno));
+        return LT_FAIL;
     }
 
     return LT_OK;
-}
\ No newline at end of file
+}
+#endif
+
+#if LT_PORT_OPS
+const lt_port_ops_t lt_port_unix_spi_ops = {
+    .init = lt_port_init,
+    .deinit = lt_port_deinit,
+    .spi_csn_low = lt_port_spi_csn_low,
+    .spi_csn_high = lt_port_spi_csn_high,
+    .spi_transfer = lt_port_spi_transfer,
+#if LT_USE_SPI_TRANSACTION
+    .spi_transaction = lt_port_spi_transaction,
+#endif
+#if LT_USE_SPI_TRANSFER_BUF
+    .spi_transfer_buf = lt_port_spi_transfer_buf,
+#endif
+    .delay = lt_port_delay,
+#if LT_USE_DELAY_US
+    .delay_us = lt_port_delay_us,
+#endif
+#if LT_USE_INT_PIN
+    .delay_on_int = lt_port_delay_on_int,
+#endif
+#if LT_USE_SPI_SPEED
+    .spi_speed_set = lt_port_spi_speed_set,
+#endif
+#if LT_THREAD_SAFE
+    .lock = lt_port_lock,
+    .unlock = lt_port_unlock,
+#endif
+    .random_bytes = lt_port_random_bytes,
+};
+#endif
@@ -10,8 +10,109 @@
  */
 
 #include <linux/gpio.h>
+#include <pthread.h>
+#include <stdbool.h>
 
 #include "libtropic_port.h"
+#include "libtropic_port_ops.h"
+#include "libtropic_port_unix_delay.h"
+#include "libtropic_port_unix_lock.h"
+#include "libtropic_port_unix_rng.h"
+
+struct lt_dev_unix_spi_t;
+
+/**
+ * @brief SPI bus shared by several TROPIC01 chips, each with its own GPIO chip select.
+ *
+ * Bus owns spidev and GPIO chip file descriptors, devices referencing it by `lt_dev_unix_spi_t.bus` only request
+ * their CS (and INT) lines. Bus is held by a device from asserting CS until releasing it, so frames of different
+ * chips never mix, while a chip waiting for its result (lt_port_delay(), lt_port_delay_on_int()) leaves the bus to
+ * the others. Waiting devices get the bus in the order they asked for it.
+ *
+ * @note Public members are configured before `lt_unix_spi_bus_init()`, which has to be called before `lt_init()`
+ *       of the devices. Devices on one bus have to be used from different threads (or interleaved by LT_ASYNC) to
+ *       actually overlap their waiting.
+ *
+ * With LT_USE_INT_PIN and `int_cnt` set, INT lines of all chips are requested together by one multi-line request
+ * of the bus, so edges of all chips come through one descriptor instead of one per chip. A chip waiting in
+ * `lt_port_delay_on_int()` either reads the events for all waiting chips or sleeps until the reader passes it the
+ * edge of its own line. An event loop watches `lt_unix_spi_bus_int_fd()` instead and dispatches the edges by
+ * `lt_unix_spi_bus_int_read()`, e.g. to `lt_unix_reactor_due()`.
+ */
+typedef struct lt_unix_spi_bus_t {
+    /** @public @brief Path to the SPI device. */
+    char spi_dev[DEVICE_PATH_MAX_LEN];
+    /** @public @brief Path to the GPIO device with CS (and INT) lines of all chips. */
+    char gpio_dev[DEVICE_PATH_MAX_LEN];
+#if LT_USE_INT_PIN
+    /** @public @brief INT lines (`gpio_int_num`) of all chips on the bus, requested together. */
+    unsigned int int_lines[GPIO_V2_LINES_MAX];
+    /** @public @brief Number of `int_lines`, 0 lets each chip request its own INT line. */
+    uint8_t int_cnt;
+#endif
+
+    /** @private @brief SPI file descriptor. */
+    int fd;
+    /** @private @brief GPIO file descriptor. */
+    int gpio_fd;
+    /** @private @brief Protects the tickets below. */
+    pthread_mutex_t mutex;
+    /** @private @brief Signalled when the bus is passed to the next ticket. */
+    pthread_cond_t cond;
+    /** @private @brief Ticket of the next device asking for the bus. */
+    unsigned long next;
+    /** @private @brief Ticket of the device holding the bus. */
+    unsigned long serving;
+#if LT_USE_INT_PIN
+    /** @private @brief Request of all `int_lines` (rising edge events). */
+    struct gpio_v2_line_request intreq;
+    /** @private @brief Devices of `int_lines`, NULL for a line of no initialized device. */
+    struct lt_dev_unix_spi_t *int_devs[GPIO_V2_LINES_MAX];
+    /** @private @brief Bit of each line index with an edge read and not taken by its device yet. */
+    uint64_t int_pending;
+    /** @private @brief Whether a waiting device is reading events of the request. */
+    bool int_reading;
+    /** @private @brief Signalled when the reading device has passed the events it read. */
+    pthread_cond_t int_cond;
+#endif
+} lt_unix_spi_bus_t;
+
+/**
+ * @brief Opens the SPI and GPIO devices of the bus.
+ *
+ * @param bus  Bus with public members configured
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_spi_bus_init(lt_unix_spi_bus_t *bus);
+
+/**
+ * @brief Closes the SPI and GPIO devices of the bus, after `lt_deinit()` of all devices on it.
+ *
+ * @param bus  Bus initialized by `lt_unix_spi_bus_init()`
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_spi_bus_deinit(lt_unix_spi_bus_t *bus);
+
+#if LT_USE_INT_PIN
+/**
+ * @brief Returns descriptor of the INT lines of the bus, readable when an edge came.
+ *
+ * @param bus  Bus initialized by `lt_unix_spi_bus_init()`
+ * @return Descriptor, -1 when the bus does not request INT lines
+ */
+int lt_unix_spi_bus_int_fd(const lt_unix_spi_bus_t *bus);
+
+/**
+ * @brief Reads edges which came on INT lines of the bus without waiting, `cb` is called for the device of each line.
+ *
+ * @param bus  Bus initialized by `lt_unix_spi_bus_init()` with `int_cnt` set
+ * @param cb   Called for each device with a new edge, may be NULL
+ * @param ctx  Context passed to `cb`
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_spi_bus_int_read(lt_unix_spi_bus_t *bus, void (*cb)(struct lt_dev_unix_spi_t *device, void *ctx),
+                                  void *ctx);
+#endif
 
 /**
  * @brief Device structure for Unix SPI port.
@@ -22,14 +123,33 @@
 typedef struct lt_dev_unix_spi_t {
     /** @public @brief SPI speed in Hz. */
     int spi_speed;
-    /** @public @brief Path to the SPI device. */
+    /** @public @brief Path to the SPI device, not used with `bus`. */
     char spi_dev[DEVICE_PATH_MAX_LEN];
-    /** @public @brief Path to the GPIO device. */
+    /** @public @brief Path to the GPIO device, not used with `bus`. */
     char gpio_dev[DEVICE_PATH_MAX_LEN];
+    /**
+     * @public @brief Bus shared with other chips, NULL when the device opens `spi_dev` by itself. Chip select has
+     * to be a GPIO pin then (`spi_hw_cs` is zero), SPI speed is set for each transfer.
+     */
+    lt_unix_spi_bus_t *bus;
     /** @public @brief Number of the GPIO pin to map chip select to. */
     int gpio_cs_num;
-    /** @public @brief Seed for the platform's random number generator. */
+    /**
+     * @public @brief When nonzero, chip select is driven by the SPI controller (native CS of `spi_dev`) instead of
+     * GPIO pin `gpio_cs_num`. Frame phases are then chained with `cs_change`, which saves GPIO ioctls.
+     */
+    int spi_hw_cs;
+#if LT_USE_INT_PIN
+    /** @public @brief Number of the GPIO pin connected to TROPIC01's INT pin. */
+    int gpio_int_num;
+#endif
+    /**
+     * @public @brief Seed for rand(), which is seeded during lt_port_init(). Random bytes for libtropic are taken
+     *                from the operating system.
+     */
     unsigned int rng_seed;
+    /** @public @brief Precision of lt_port_delay() and lt_port_delay_us(), zero initialized only sleeps. */
+    lt_unix_delay_t delay;
 
     /** @private @brief SPI file descriptor. */
     int fd;
@@ -37,8 +157,29 @@ typedef struct lt_dev_unix_spi_t {
     int gpio_fd;
     /** @private @brief GPIO request (for GPIO configuration). */
     struct gpio_v2_line_request gpioreq;
+#if LT_USE_INT_PIN
+    /** @private @brief GPIO request for INT pin (rising edge events), not used with INT lines of `bus`. */
+    struct gpio_v2_line_request intreq;
+    /** @private @brief Index of the INT line in `bus->int_lines`, -1 for the own request. */
+    int int_idx;
+#endif
     /** @private @brief SPI mode. */
     uint32_t mode;
+    /** @private @brief Whether the device holds `bus`. */
+    bool bus_held;
+    /** @private @brief Whether an L1 SPI transaction keeps `bus` between its frames. */
+    bool bus_txn;
+    /** @private @brief Pool of random bytes from the operating system. */
+    lt_unix_rng_t rng;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
 } lt_dev_unix_spi_t;
 
+#if LT_PORT_OPS
+/** @brief Functions of the port for `lt_l2_state_t.ops`, when the port is compiled with LT_PORT_OPS */
+extern const lt_port_ops_t lt_port_unix_spi_ops;
+#endif
+
 #endif  // LIBTROPIC_PORT_UNIX_SPI_H
\ No newline at end of file
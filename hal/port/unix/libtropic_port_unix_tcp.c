@@ -1,14 +1,21 @@
 /**
  * @file libtropic_port_unix_tcp.c
  * @author Tropic Square s.r.o.
- * @brief Port for communication with the TROPIC01 Model using TCP.
+ * @brief Port for communication with the TROPIC01 Model using TCP or a Unix domain socket.
  *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
+#if LT_PORT_OPS
+// Port functions get names of their own, so the port can be linked together with other ports
+#define LT_PORT_OPS_PREFIX lt_port_unix_tcp
+#include "libtropic_port_ops.h"
+#endif
+
 #include "libtropic_port_unix_tcp.h"
 
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <stddef.h>
@@ -16,6 +23,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -24,32 +34,113 @@
 #include "libtropic_macros.h"
 #include "libtropic_port.h"
 
+// Closed connection of the model is reported as an error instead of SIGPIPE killing the process, which may be a host
+// of libtropic loaded as a module
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/** Converts timeout in milliseconds to timeval used by socket options, zero means no timeout */
+static struct timeval ms_to_timeval(uint32_t ms)
+{
+    struct timeval tv = {.tv_sec = ms / 1000, .tv_usec = (ms % 1000) * 1000};
+    return tv;
+}
+
+static lt_ret_t set_socket_options(lt_dev_unix_tcp_t *dev)
+{
+    int one = 1;
+
+    // Every request is small and waits for its reply, do not delay them by Nagle's algorithm
+    if (!dev->unix_path && (setsockopt(dev->socket_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) < 0)) {
+        LT_LOG_ERROR("Could not set TCP_NODELAY: %s (%d).", strerror(errno), errno);
+        return LT_FAIL;
+    }
+
+    struct timeval rx_timeout = ms_to_timeval(dev->rx_timeout_ms);
+    if (setsockopt(dev->socket_fd, SOL_SOCKET, SO_RCVTIMEO, &rx_timeout, sizeof(rx_timeout)) < 0) {
+        LT_LOG_ERROR("Could not set receive timeout: %s (%d).", strerror(errno), errno);
+        return LT_FAIL;
+    }
+
+    struct timeval tx_timeout = ms_to_timeval(dev->tx_timeout_ms);
+    if (setsockopt(dev->socket_fd, SOL_SOCKET, SO_SNDTIMEO, &tx_timeout, sizeof(tx_timeout)) < 0) {
+        LT_LOG_ERROR("Could not set send timeout: %s (%d).", strerror(errno), errno);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+/** Asks for immediate ACKs, Linux clears this option again during normal operation so it is set after each recv */
+static void set_quickack(int socket)
+{
+#ifdef TCP_QUICKACK
+    int one = 1;
+    (void)setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+#else
+    UNUSED(socket);
+#endif
+}
+
 static lt_ret_t connect_to_server(lt_dev_unix_tcp_t *dev)
 {
     struct sockaddr_in server;
+    struct sockaddr_un server_un;
+    struct sockaddr *server_addr;
+    socklen_t server_addr_len;
+
+    // Server information
+    if (dev->unix_path) {
+        memset(&server_un, 0, sizeof(server_un));
+        server_un.sun_family = AF_UNIX;
+        if (strlen(dev->unix_path) >= sizeof(server_un.sun_path)) {
+            LT_LOG_ERROR("Socket path %s is too long.", dev->unix_path);
+            return LT_FAIL;
+        }
+        strcpy(server_un.sun_path, dev->unix_path);
+        server_addr = (struct sockaddr *)(&server_un);
+        server_addr_len = sizeof(server_un);
+    }
+    else {
+        memset(&server, 0, sizeof(server));
+        server.sin_family = AF_INET;
+        server.sin_addr.s_addr = dev->addr;
+        server.sin_port = htons(dev->port);
+        server_addr = (struct sockaddr *)(&server);
+        server_addr_len = sizeof(server);
+    }
 
     // Create socket
-    dev->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    dev->socket_fd = socket(server_addr->sa_family, SOCK_STREAM, 0);
     if (dev->socket_fd < 0) {
         LT_LOG_ERROR("Could not create socket: %s (%d).", strerror(errno), errno);
         return LT_FAIL;
     }
     LT_LOG_DEBUG("Socket created.");
 
-    // Server information
-    memset(&server, 0, sizeof(server));
-    server.sin_family = AF_INET;
-    server.sin_addr.s_addr = dev->addr;
-    server.sin_port = htons(dev->port);
-
     // Connect to the server
-    LT_LOG_DEBUG("Connecting to %s:%d.", inet_ntoa(server.sin_addr), dev->port);
-    if (connect(dev->socket_fd, (struct sockaddr *)(&server), sizeof(server)) < 0) {
+    if (dev->unix_path) {
+        LT_LOG_DEBUG("Connecting to %s.", dev->unix_path);
+    }
+    else {
+        LT_LOG_DEBUG("Connecting to %s:%d.", inet_ntoa(server.sin_addr), dev->port);
+    }
+    if (connect(dev->socket_fd, server_addr, server_addr_len) < 0) {
         LT_LOG_ERROR("Could not connect: %s (%d).", strerror(errno), errno);
+        close(dev->socket_fd);
         return LT_FAIL;
     }
     LT_LOG_DEBUG("Connected to the server.");
 
+    if (set_socket_options(dev) != LT_OK) {
+        close(dev->socket_fd);
+        return LT_FAIL;
+    }
+    if (!dev->unix_path) {
+        set_quickack(dev->socket_fd);
+    }
+
     return LT_OK;
 }
 
@@ -63,7 +154,7 @@ static lt_ret_t send_all(int socket, uint8_t *buffer, size_t length)
     // attempt several times to send the data
     for (int i = 0; i < TX_ATTEMPTS; i++) {
         LT_LOG_DEBUG("Attempting to send data: attempt #%d.", i);
-        nb_bytes_sent = send(socket, ptr, nb_bytes_to_send, 0);
+        nb_bytes_sent = send(socket, ptr, nb_bytes_to_send, MSG_NOSIGNAL);
         if (nb_bytes_sent <= 0) {
             LT_LOG_ERROR("Send failed: %s (%d).", strerror(errno), errno);
             return LT_FAIL;
@@ -86,13 +177,51 @@ static lt_ret_t send_all(int socket, uint8_t *buffer, size_t length)
     return LT_FAIL;
 }
 
-static lt_ret_t communicate(lt_dev_unix_tcp_t *dev, int *tx_payload_length_ptr, int *rx_payload_length_ptr)
+/** Receives exactly `length` bytes, stream may deliver one message in any number of pieces */
+static lt_ret_t recv_all(lt_dev_unix_tcp_t *dev, uint8_t *buffer, size_t length)
+{
+    const int socket = dev->socket_fd;
+    size_t nb_bytes_received_total = 0;
+
+    while (nb_bytes_received_total < length) {
+        ssize_t nb_bytes_received
+            = recv(socket, buffer + nb_bytes_received_total, length - nb_bytes_received_total, 0);
+
+        if (nb_bytes_received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // EWOULDBLOCK is the same as EAGAIN on most systems, comparing both would not compile with -Wlogical-op
+#if EWOULDBLOCK != EAGAIN
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+#else
+            if (errno == EAGAIN) {
+#endif
+                LT_LOG_ERROR("Receive timed out, %zu bytes received out of %zu expected.", nb_bytes_received_total,
+                             length);
+                return LT_FAIL;
+            }
+            LT_LOG_ERROR("Receive failed: %s (%d).", strerror(errno), errno);
+            return LT_FAIL;
+        }
+        else if (nb_bytes_received == 0) {
+            LT_LOG_ERROR("Connection closed by the server, %zu bytes received out of %zu expected.",
+                         nb_bytes_received_total, length);
+            return LT_FAIL;
+        }
+
+        nb_bytes_received_total += nb_bytes_received;
+        if (!dev->unix_path) {
+            set_quickack(socket);
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Sends the request placed in the emission buffer */
+static lt_ret_t request_send(lt_dev_unix_tcp_t *dev, int *tx_payload_length_ptr)
 {
-    lt_ret_t ret;
-    int nb_bytes_received;
-    int nb_bytes_received_total = 0;
-    int nb_bytes_to_receive = TCP_TAG_AND_LENGTH_SIZE;
-    uint8_t *rx_ptr = dev->rx_buffer.buff;
     // number of bytes to send
     int nb_bytes_to_send = TCP_TAG_AND_LENGTH_SIZE;
 
@@ -103,57 +232,34 @@ static lt_ret_t communicate(lt_dev_unix_tcp_t *dev, int *tx_payload_length_ptr,
     // update payload length field
     dev->tx_buffer.len = nb_bytes_to_send - TCP_TAG_AND_LENGTH_SIZE;
 
-    ret = send_all(dev->socket_fd, dev->tx_buffer.buff, nb_bytes_to_send);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    // receive data
-    LT_LOG_DEBUG("- Receiving data from target.");
-    nb_bytes_received = recv(dev->socket_fd, dev->rx_buffer.buff, MAX_RECV_SIZE, 0);
+    return send_all(dev->socket_fd, dev->tx_buffer.buff, nb_bytes_to_send);
+}
 
-    if (nb_bytes_received < 0) {
-        LT_LOG_ERROR("Receive failed: %s (%d).", strerror(errno), errno);
-        return LT_FAIL;
-    }
-    else if (nb_bytes_received < nb_bytes_to_receive) {
-        LT_LOG_ERROR("At least %d bytes are expected: %d.", nb_bytes_to_receive, nb_bytes_received);
+/** Checks the tag of the reply received into the reception buffer against the sent request */
+static lt_ret_t reply_check(lt_dev_unix_tcp_t *dev, int *rx_payload_length_ptr)
+{
+    LT_LOG_DEBUG("Received %d bytes in total.", (int)(TCP_TAG_AND_LENGTH_SIZE + dev->rx_buffer.len));
+
+    // older server does not support batches, caller falls back to sending operations one by one
+    if (((unix_tcp_tag_t)dev->tx_buffer.tag == TAG_E_BATCH)
+        && (((unix_tcp_tag_t)dev->rx_buffer.tag == TAG_E_INVALID)
+            || ((unix_tcp_tag_t)dev->rx_buffer.tag == TAG_E_UNSUPPORTED))) {
+        LT_LOG_WARN("Batched requests are not supported by the server.");
+        dev->batch_unsupported = 1;
         return LT_FAIL;
     }
-
-    LT_LOG_DEBUG("Length field: %" PRIu16 ".", dev->rx_buffer.len);
-    nb_bytes_to_receive += dev->rx_buffer.len;
-    nb_bytes_received_total += nb_bytes_received;
-    LT_LOG_DEBUG("Received %d bytes out of %d expected.", nb_bytes_received_total, nb_bytes_to_receive);
-
-    if (nb_bytes_received_total < nb_bytes_to_receive) {
-        rx_ptr += nb_bytes_received;
-
-        for (int i = 0; i < RX_ATTEMPTS; i++) {
-            LT_LOG_DEBUG("Attempting to receive remaining bytes: attempt #%d.", i);
-            nb_bytes_received = recv(dev->socket_fd, dev->rx_buffer.buff, MAX_RECV_SIZE, 0);
-
-            if (nb_bytes_received < 0) {
-                LT_LOG_ERROR("Receive failed: %s (%d).", strerror(errno), errno);
-                return LT_FAIL;
-            }
-
-            nb_bytes_received_total += nb_bytes_received;
-            if (nb_bytes_received_total >= nb_bytes_to_receive) {
-                LT_LOG_DEBUG("Received %d bytes in total.", nb_bytes_received_total);
-                break;
-            }
-            rx_ptr += nb_bytes_received;
-        }
-    }
-
-    if (nb_bytes_received_total != nb_bytes_to_receive) {
-        LT_LOG_ERROR("Received %d bytes in total instead of %d.", nb_bytes_received_total, nb_bytes_to_receive);
+#if LT_L1_OFFLOAD
+    // older server and the model do not execute L1 transactions, libtropic does them by itself
+    else if (((unix_tcp_tag_t)dev->tx_buffer.tag == TAG_E_L1_EXCHANGE)
+             && (((unix_tcp_tag_t)dev->rx_buffer.tag == TAG_E_INVALID)
+                 || ((unix_tcp_tag_t)dev->rx_buffer.tag == TAG_E_UNSUPPORTED))) {
+        LT_LOG_INFO("L1 transactions are not executed by the server.");
+        dev->l1_offload_unsupported = 1;
         return LT_FAIL;
     }
-
+#endif
     // server does not know the sent tag
-    if ((unix_tcp_tag_t)dev->rx_buffer.tag == TAG_E_INVALID) {
+    else if ((unix_tcp_tag_t)dev->rx_buffer.tag == TAG_E_INVALID) {
         LT_LOG_ERROR("Tag %" PRIu8 " is not known by the server.", dev->tx_buffer.tag);
         return LT_FAIL;
     }
@@ -170,16 +276,52 @@ static lt_ret_t communicate(lt_dev_unix_tcp_t *dev, int *tx_payload_length_ptr,
 
     LT_LOG_DEBUG("Rx tag and tx tag match: %" PRIu8 ".", dev->rx_buffer.tag);
     if (rx_payload_length_ptr != NULL) {
-        *rx_payload_length_ptr = nb_bytes_received_total - TCP_TAG_AND_LENGTH_SIZE;
+        *rx_payload_length_ptr = dev->rx_buffer.len;
     }
 
     return LT_OK;
 }
 
+static lt_ret_t communicate(lt_dev_unix_tcp_t *dev, int *tx_payload_length_ptr, int *rx_payload_length_ptr)
+{
+    lt_ret_t ret = request_send(dev, tx_payload_length_ptr);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // receive tag and length first, then exactly the announced payload
+    LT_LOG_DEBUG("- Receiving data from target.");
+    ret = recv_all(dev, dev->rx_buffer.buff, TCP_TAG_AND_LENGTH_SIZE);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    LT_LOG_DEBUG("Length field: %" PRIu16 ".", dev->rx_buffer.len);
+    if (dev->rx_buffer.len > MAX_PAYLOAD_LEN) {
+        LT_LOG_ERROR("Payload length %" PRIu16 " exceeds maximum of %d.", dev->rx_buffer.len, (int)MAX_PAYLOAD_LEN);
+        return LT_FAIL;
+    }
+
+    ret = recv_all(dev, dev->rx_buffer.payload, dev->rx_buffer.len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return reply_check(dev, rx_payload_length_ptr);
+}
+
 static lt_ret_t server_connect(lt_dev_unix_tcp_t *dev)
 {
     bzero(dev->tx_buffer.buff, MAX_BUFFER_LEN);
     bzero(dev->rx_buffer.buff, MAX_BUFFER_LEN);
+    dev->batch_unsupported = 0;
+#if LT_L1_OFFLOAD
+    dev->l1_offload_unsupported = 0;
+    dev->l1_frame_len = 0;
+#if LT_NONBLOCKING
+    dev->l1_reply_pending = 0;
+#endif
+#endif
 
     lt_ret_t ret = connect_to_server(dev);
     if (ret != LT_OK) {
@@ -200,16 +342,194 @@ static lt_ret_t server_disconnect(int socket_fd)
     return LT_OK;
 }
 
+#if LT_L1_OFFLOAD
+/**
+ * Sends TAG_E_L1_EXCHANGE with the pending frame, which is then no longer pending. When `max_len` is nonzero, the
+ * server also reads the response into the reply. Returns lt_ret_t of the server.
+ */
+/**
+ * Places TAG_E_L1_EXCHANGE with the pending frame into the emission buffer, the frame is then no longer pending.
+ * Returns length of the payload.
+ */
+static int l1_exchange_set(lt_dev_unix_tcp_t *dev, uint16_t max_len, uint32_t timeout_ms)
+{
+    uint8_t *payload = dev->tx_buffer.payload;
+    int tx_payload_length = 7 + dev->l1_frame_len;
+
+    payload[0] = max_len ? 0x01 : 0x00;
+    payload[1] = timeout_ms & 0x000000ff;
+    payload[2] = (timeout_ms & 0x0000ff00) >> 8;
+    payload[3] = (timeout_ms & 0x00ff0000) >> 16;
+    payload[4] = (timeout_ms & 0xff000000) >> 24;
+    payload[5] = max_len & 0x00ff;
+    payload[6] = (max_len & 0xff00) >> 8;
+    memcpy(payload + 7, dev->l1_frame, dev->l1_frame_len);
+    dev->l1_frame_len = 0;
+    dev->tx_buffer.tag = TAG_E_L1_EXCHANGE;
+
+    return tx_payload_length;
+}
+
+/** Returns lt_ret_t of the server from the received reply to TAG_E_L1_EXCHANGE */
+static lt_ret_t l1_exchange_ret(lt_dev_unix_tcp_t *dev, int rx_payload_length)
+{
+    if ((rx_payload_length < 1) || (dev->rx_buffer.payload[0] >= LT_RET_T_LAST_VALUE)) {
+        LT_LOG_ERROR("Invalid reply to L1 exchange.");
+        return LT_FAIL;
+    }
+
+    return (lt_ret_t)dev->rx_buffer.payload[0];
+}
+
+static lt_ret_t l1_exchange(lt_dev_unix_tcp_t *dev, uint16_t max_len, uint32_t timeout_ms, int *rx_payload_length)
+{
+    int tx_payload_length = l1_exchange_set(dev, max_len, timeout_ms);
+
+    LT_LOG_DEBUG("-- Sending L1 exchange.");
+    lt_ret_t ret = communicate(dev, &tx_payload_length, rx_payload_length);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return l1_exchange_ret(dev, *rx_payload_length);
+}
+
+#if LT_NONBLOCKING
+static uint64_t clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000u) + ((uint64_t)ts.tv_nsec / 1000u);
+}
+
+/** Receives what has arrived of the pending reply without waiting, LT_PENDING until the reply is whole */
+static lt_ret_t l1_reply_recv(lt_dev_unix_tcp_t *dev, int *rx_payload_length)
+{
+    for (;;) {
+        size_t length = TCP_TAG_AND_LENGTH_SIZE;
+        if (dev->l1_reply_received >= TCP_TAG_AND_LENGTH_SIZE) {
+            if (dev->rx_buffer.len > MAX_PAYLOAD_LEN) {
+                LT_LOG_ERROR("Payload length %" PRIu16 " exceeds maximum of %d.", dev->rx_buffer.len,
+                             (int)MAX_PAYLOAD_LEN);
+                return LT_FAIL;
+            }
+            length += dev->rx_buffer.len;
+        }
+        if (dev->l1_reply_received == length) {
+            break;
+        }
+
+        ssize_t nb_bytes_received = recv(dev->socket_fd, dev->rx_buffer.buff + dev->l1_reply_received,
+                                         length - dev->l1_reply_received, MSG_DONTWAIT);
+        if (nb_bytes_received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+#if EWOULDBLOCK != EAGAIN
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+#else
+            if (errno == EAGAIN) {
+#endif
+                if (dev->rx_timeout_ms && (clock_us() >= dev->l1_reply_deadline_us)) {
+                    LT_LOG_ERROR("Receive timed out, %zu bytes of the reply received.", dev->l1_reply_received);
+                    return LT_FAIL;
+                }
+                return LT_PENDING;
+            }
+            LT_LOG_ERROR("Receive failed: %s (%d).", strerror(errno), errno);
+            return LT_FAIL;
+        }
+        else if (nb_bytes_received == 0) {
+            LT_LOG_ERROR("Connection closed by the server, %zu bytes of the reply received.", dev->l1_reply_received);
+            return LT_FAIL;
+        }
+        dev->l1_reply_received += nb_bytes_received;
+    }
+    if (!dev->unix_path) {
+        set_quickack(dev->socket_fd);
+    }
+
+    return reply_check(dev, rx_payload_length);
+}
+
+/**
+ * Sends TAG_E_L1_EXCHANGE like l1_exchange() does, but returns LT_PENDING instead of waiting for the reply. Following
+ * calls only collect the reply.
+ */
+static lt_ret_t l1_exchange_async(lt_dev_unix_tcp_t *dev, uint16_t max_len, uint32_t timeout_ms,
+                                  int *rx_payload_length)
+{
+    lt_ret_t ret;
+
+    if (!dev->l1_reply_pending) {
+        int tx_payload_length = l1_exchange_set(dev, max_len, timeout_ms);
+
+        LT_LOG_DEBUG("-- Sending L1 exchange, reply is received asynchronously.");
+        ret = request_send(dev, &tx_payload_length);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        dev->l1_reply_pending = 1;
+        dev->l1_reply_received = 0;
+        dev->l1_reply_deadline_us = clock_us() + ((uint64_t)dev->rx_timeout_ms * 1000u);
+    }
+
+    ret = l1_reply_recv(dev, rx_payload_length);
+    if (ret == LT_PENDING) {
+        return LT_PENDING;
+    }
+    // Stream does not continue after a broken reply, following requests fail as well
+    dev->l1_reply_pending = 0;
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return l1_exchange_ret(dev, *rx_payload_length);
+}
+#endif
+
+/** Sends the frame written by lt_port_l1_write(), so other operations of the port are done after it */
+static lt_ret_t l1_flush(lt_dev_unix_tcp_t *dev)
+{
+    int rx_payload_length;
+
+    if (!dev->l1_frame_len) {
+        return LT_OK;
+    }
+
+    return l1_exchange(dev, 0, dev->l1_frame_timeout_ms, &rx_payload_length);
+}
+#endif
+
 lt_ret_t lt_port_init(lt_l2_state_t *s2)
 {
     lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
 
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&dev->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
     lt_ret_t ret = server_connect(dev);
     if (ret != LT_OK) {
         return ret;
     }
 
     srand(dev->rng_seed);
+    lt_unix_rng_wipe(&dev->rng);
+
+#if LT_L1_OFFLOAD
+    // Empty exchange tells whether the server executes L1 transactions (tools/lt_spi_bridge does, the model does not)
+    int rx_payload_length = 0;
+    s2->l1_offload = (l1_exchange(dev, 0, 0, &rx_payload_length) == LT_OK);
+    if (!s2->l1_offload && !dev->l1_offload_unsupported) {
+        lt_ret_t ret_unused = server_disconnect(dev->socket_fd);
+        UNUSED(ret_unused);  // We don't care about it, we return LT_FAIL anyway.
+        return LT_FAIL;
+    }
+#endif
 
     return LT_OK;
 }
@@ -217,6 +537,12 @@ lt_ret_t lt_port_init(lt_l2_state_t *s2)
 lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
 {
     lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    lt_unix_rng_wipe(&dev->rng);
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&dev->lock);
+#endif
+
     lt_ret_t ret = server_disconnect(dev->socket_fd);
     if (ret != LT_OK) {
         return ret;
@@ -228,6 +554,12 @@ lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
 lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
 {
     lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+#if LT_L1_OFFLOAD
+    lt_ret_t ret = l1_flush(dev);
+    if (ret != LT_OK) {
+        return ret;
+    }
+#endif
     LT_LOG_DEBUG("-- Driving Chip Select to Low.");
     dev->tx_buffer.tag = TAG_E_SPI_DRIVE_CSN_LOW;
     return communicate(dev, NULL, NULL);
@@ -236,20 +568,31 @@ lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
 lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
 {
     lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+#if LT_L1_OFFLOAD
+    lt_ret_t ret = l1_flush(dev);
+    if (ret != LT_OK) {
+        return ret;
+    }
+#endif
     LT_LOG_DEBUG("-- Driving Chip Select to High.");
     dev->tx_buffer.tag = TAG_E_SPI_DRIVE_CSN_HIGH;
     return communicate(dev, NULL, NULL);
 }
 
-lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+/** Sends `tx` by TAG_E_SPI_SEND, MISO data of the reply go to `rx` unless it is NULL */
+static lt_ret_t spi_send(lt_dev_unix_tcp_t *dev, const uint8_t *tx, uint8_t *rx, uint16_t tx_data_length)
 {
-    UNUSED(timeout_ms);
-    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
     lt_ret_t ret;
 
-    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+    if (tx_data_length > LT_L1_LEN_MAX) {
         return LT_L1_DATA_LEN_ERROR;
     }
+#if LT_L1_OFFLOAD
+    ret = l1_flush(dev);
+    if (ret != LT_OK) {
+        return ret;
+    }
+#endif
 
     LT_LOG_DEBUG("-- Sending data through SPI bus.");
 
@@ -260,43 +603,401 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_dat
     dev->tx_buffer.len = (uint16_t)tx_payload_length;
 
     // copy tx_data to tx payload
-    memcpy(&dev->tx_buffer.payload, s2->buff, tx_payload_length);
+    memcpy(&dev->tx_buffer.payload, tx, tx_payload_length);
 
     ret = communicate(dev, &tx_payload_length, &rx_payload_length);
     if (ret != LT_OK) {
         return LT_FAIL;
     }
 
-    memcpy(s2->buff + offset, &dev->rx_buffer.payload, rx_payload_length);
+    if (rx) {
+        memcpy(rx, &dev->rx_buffer.payload, rx_payload_length);
+    }
 
     return LT_OK;
 }
 
-lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
 {
+    UNUSED(timeout_ms);
     lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    return spi_send(dev, s2->buff + offset, s2->buff + offset, tx_data_length);
+}
+
+#if LT_USE_SPI_TRANSFER_BUF
+lt_ret_t lt_port_spi_transfer_buf(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                  uint32_t timeout_ms)
+{
+    UNUSED(timeout_ms);
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    // MISO data are copied from the reply straight to the destination
+    return spi_send(dev, tx ? tx : rx, rx, len);
+}
+#endif
+
+#if LT_USE_SPI_TRANSACTION
+/** Appends one operation (request with its tag, length and payload) to the payload of TAG_E_BATCH request */
+static int batch_add(lt_dev_unix_tcp_t *dev, int pos, unix_tcp_tag_t tag, const uint8_t *data, uint16_t len)
+{
+    if ((pos < 0) || (pos + TCP_TAG_AND_LENGTH_SIZE + len > MAX_PAYLOAD_LEN)) {
+        return -1;
+    }
+
+    uint8_t *op = dev->tx_buffer.payload + pos;
+    op[0] = tag;
+    op[1] = len & 0x00ff;
+    op[2] = (len & 0xff00) >> 8;
+    if (len) {
+        memcpy(op + TCP_TAG_AND_LENGTH_SIZE, data, len);
+    }
+
+    return pos + TCP_TAG_AND_LENGTH_SIZE + len;
+}
+
+/** Does the whole transaction in a single TAG_E_BATCH round trip */
+static lt_ret_t batch_transaction(lt_dev_unix_tcp_t *dev, lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs,
+                                  uint8_t seg_cnt)
+{
+    int tx_payload_length = 0;
+    int rx_payload_length;
+
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if ((i == 0) || !segs[i - 1].cs_hold) {
+            tx_payload_length = batch_add(dev, tx_payload_length, TAG_E_SPI_DRIVE_CSN_LOW, NULL, 0);
+        }
+        const uint8_t *tx = segs[i].tx ? segs[i].tx : s2->buff + segs[i].offset;
+        tx_payload_length = batch_add(dev, tx_payload_length, TAG_E_SPI_SEND, tx, segs[i].len);
+        if (!segs[i].cs_hold) {
+            tx_payload_length = batch_add(dev, tx_payload_length, TAG_E_SPI_DRIVE_CSN_HIGH, NULL, 0);
+        }
+    }
+    if (tx_payload_length < 0) {
+        LT_LOG_ERROR("Transaction does not fit into one batch.");
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    LT_LOG_DEBUG("-- Sending batch of operations.");
+    dev->tx_buffer.tag = TAG_E_BATCH;
+    lt_ret_t ret = communicate(dev, &tx_payload_length, &rx_payload_length);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Walk through replies in the same order as requests, MISO data of transfers are copied back to the L2 buffer.
+    int tx_pos = 0;
+    int rx_pos = 0;
+    while (tx_pos < tx_payload_length) {
+        const uint8_t *tx_op = dev->tx_buffer.payload + tx_pos;
+        const uint8_t *rx_op = dev->rx_buffer.payload + rx_pos;
+        uint16_t tx_len = tx_op[1] | (tx_op[2] << 8);
+
+        if ((rx_pos + (int)TCP_TAG_AND_LENGTH_SIZE > rx_payload_length) || (rx_op[0] != tx_op[0])) {
+            LT_LOG_ERROR("Batch reply does not match the request.");
+            return LT_FAIL;
+        }
+        uint16_t rx_len = rx_op[1] | (rx_op[2] << 8);
+        if (rx_pos + (int)TCP_TAG_AND_LENGTH_SIZE + rx_len > rx_payload_length) {
+            LT_LOG_ERROR("Batch reply is truncated.");
+            return LT_FAIL;
+        }
+        tx_pos += TCP_TAG_AND_LENGTH_SIZE + tx_len;
+        rx_pos += TCP_TAG_AND_LENGTH_SIZE + rx_len;
+    }
+
+    rx_pos = 0;
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        const uint8_t *rx_op;
+        // Skip replies to CSN edges
+        while ((rx_op = dev->rx_buffer.payload + rx_pos)[0] != TAG_E_SPI_SEND) {
+            rx_pos += TCP_TAG_AND_LENGTH_SIZE + (rx_op[1] | (rx_op[2] << 8));
+        }
+        uint16_t rx_len = rx_op[1] | (rx_op[2] << 8);
+        if (rx_len != segs[i].len) {
+            LT_LOG_ERROR("Expected %" PRIu16 " bytes of MISO data, received %" PRIu16 ".", segs[i].len, rx_len);
+            return LT_FAIL;
+        }
+        // MISO data of segments sent from elsewhere are discarded
+        if (!segs[i].tx) {
+            memcpy(s2->buff + segs[i].offset, rx_op + TCP_TAG_AND_LENGTH_SIZE, rx_len);
+        }
+        rx_pos += TCP_TAG_AND_LENGTH_SIZE + rx_len;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+    lt_ret_t ret;
+
+    if (seg_cnt > LT_L1_SPI_SEGMENTS_MAX) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+#if LT_L1_OFFLOAD
+    ret = l1_flush(dev);
+    if (ret != LT_OK) {
+        return ret;
+    }
+#endif
+
+    if (!dev->batch_unsupported) {
+        ret = batch_transaction(dev, s2, segs, seg_cnt);
+        // Server without batch support is detected on the first batch, it is sent again one by one
+        if ((ret == LT_OK) || !dev->batch_unsupported) {
+            return ret;
+        }
+    }
+
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if ((i == 0) || !segs[i - 1].cs_hold) {
+            ret = lt_port_spi_csn_low(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+        if (segs[i].tx) {
+            if (segs[i].offset + segs[i].len > LT_L1_LEN_MAX) {
+                return LT_L1_DATA_LEN_ERROR;
+            }
+            memcpy(s2->buff + segs[i].offset, segs[i].tx, segs[i].len);
+        }
+        ret = lt_port_spi_transfer(s2, segs[i].offset, segs[i].len, timeout_ms);
+        if (ret != LT_OK) {
+            lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
+            return ret;
+        }
+        if (!segs[i].cs_hold) {
+            ret = lt_port_spi_csn_high(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return LT_OK;
+}
+#endif
+
+/** Sends WAIT request, the model expects the time in microseconds */
+static lt_ret_t send_wait(lt_dev_unix_tcp_t *dev, uint32_t wait_time_usecs)
+{
+#if LT_L1_OFFLOAD
+    lt_ret_t ret = l1_flush(dev);
+    if (ret != LT_OK) {
+        return ret;
+    }
+#endif
+    dev->virtual_time_us += wait_time_usecs;
+    if (dev->virtual_time) {
+        return LT_OK;
+    }
+
     LT_LOG_DEBUG("-- Waiting for the target.");
 
     dev->tx_buffer.tag = TAG_E_WAIT;
     int payload_length = sizeof(uint32_t);
-    //*(uint32_t *)(&tx_buffer.PAYLOAD) = wait_time_usecs;
-    dev->rx_buffer.payload[0] = ms & 0x000000ff;
-    dev->rx_buffer.payload[1] = (ms & 0x0000ff00) >> 8;
-    dev->rx_buffer.payload[2] = (ms & 0x00ff0000) >> 16;
-    dev->rx_buffer.payload[3] = (ms & 0xff000000) >> 24;
+    dev->tx_buffer.payload[0] = wait_time_usecs & 0x000000ff;
+    dev->tx_buffer.payload[1] = (wait_time_usecs & 0x0000ff00) >> 8;
+    dev->tx_buffer.payload[2] = (wait_time_usecs & 0x00ff0000) >> 16;
+    dev->tx_buffer.payload[3] = (wait_time_usecs & 0xff000000) >> 24;
 
     return communicate(dev, &payload_length, NULL);
 }
 
-lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    return send_wait(dev, ms * 1000);
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    return send_wait(dev, us);
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
 {
     UNUSED(s2);
 
-    uint8_t *buff_ptr = buff;
-    for (size_t i = 0; i < count; i++) {
-        // Number from rand() is guaranteed to have at least 15 bits valid
-        buff_ptr[i] = (uint8_t)(rand() & 0xFF);
+    // Model has no SPI clock, any one is accepted
+    *actual_hz = hz;
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    UNUSED(ms);
+    // The model does not provide INT pin. It processes each request before answering it, so the response is
+    // ready by now and libtropic polls CHIP_STATUS right away to check that.
+    UNUSED(s2);
+
+    return LT_OK;
+}
+#endif
+
+#if LT_L1_OFFLOAD
+lt_ret_t lt_port_l1_write(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt, uint32_t timeout_ms)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+    uint16_t len = 0;
+
+    // Only one frame waits for the read
+    lt_ret_t ret = l1_flush(dev);
+    if (ret != LT_OK) {
+        return ret;
     }
 
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if (len + segs[i].len > LT_L1_LEN_MAX) {
+            return LT_L1_DATA_LEN_ERROR;
+        }
+        memcpy(dev->l1_frame + len, segs[i].tx ? segs[i].tx : s2->buff + segs[i].offset, segs[i].len);
+        len += segs[i].len;
+    }
+    dev->l1_frame_len = len;
+    dev->l1_frame_timeout_ms = timeout_ms;
+
     return LT_OK;
 }
+
+lt_ret_t lt_port_l1_read(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+    int rx_payload_length = 0;
+
+    if ((max_len == 0) || (max_len > LT_L1_LEN_MAX)) {
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+#if LT_NONBLOCKING
+    lt_ret_t ret = (dev->async_reply && s2->l1_nonblocking)
+                       ? l1_exchange_async(dev, (uint16_t)max_len, timeout_ms, &rx_payload_length)
+                       : l1_exchange(dev, (uint16_t)max_len, timeout_ms, &rx_payload_length);
+    if (ret == LT_PENDING) {
+        return LT_PENDING;
+    }
+#else
+    lt_ret_t ret = l1_exchange(dev, (uint16_t)max_len, timeout_ms, &rx_payload_length);
+#endif
+    if (rx_payload_length - 1 > (int)max_len) {
+        LT_LOG_ERROR("Response of %d bytes exceeds %" PRIu32 ".", rx_payload_length - 1, max_len);
+        return LT_L1_DATA_LEN_ERROR;
+    }
+    if ((ret == LT_OK) && (rx_payload_length < 1 + 3 + 2)) {
+        LT_LOG_ERROR("Response is truncated.");
+        return LT_FAIL;
+    }
+    // CHIP_STATUS comes also with a failure of the transaction
+    if (rx_payload_length > 1) {
+        memcpy(s2->buff, dev->rx_buffer.payload + 1, rx_payload_length - 1);
+    }
+
+    return ret;
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    lt_unix_lock_take(&dev->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    lt_unix_lock_release(&dev->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    lt_dev_unix_tcp_t *dev = (lt_dev_unix_tcp_t *)(s2->device);
+
+    return lt_unix_rng_bytes(&dev->rng, buff, count);
+}
+
+#if LT_PORT_OPS
+const lt_port_ops_t lt_port_unix_tcp_ops = {
+    .init = lt_port_init,
+    .deinit = lt_port_deinit,
+    .spi_csn_low = lt_port_spi_csn_low,
+    .spi_csn_high = lt_port_spi_csn_high,
+    .spi_transfer = lt_port_spi_transfer,
+#if LT_USE_SPI_TRANSACTION
+    .spi_transaction = lt_port_spi_transaction,
+#endif
+#if LT_USE_SPI_TRANSFER_BUF
+    .spi_transfer_buf = lt_port_spi_transfer_buf,
+#endif
+    .delay = lt_port_delay,
+#if LT_USE_DELAY_US
+    .delay_us = lt_port_delay_us,
+#endif
+#if LT_USE_INT_PIN
+    .delay_on_int = lt_port_delay_on_int,
+#endif
+#if LT_USE_SPI_SPEED
+    .spi_speed_set = lt_port_spi_speed_set,
+#endif
+#if LT_THREAD_SAFE
+    .lock = lt_port_lock,
+    .unlock = lt_port_unlock,
+#endif
+    .random_bytes = lt_port_random_bytes,
+#if LT_L1_OFFLOAD
+    .l1_write = lt_port_l1_write,
+    .l1_read = lt_port_l1_read,
+#endif
+};
+#endif
+
+#if LT_L1_OFFLOAD && LT_NONBLOCKING
+static int reactor_fd(const void *device)
+{
+    return ((const lt_dev_unix_tcp_t *)device)->socket_fd;
+}
+
+static int32_t reactor_reply_wait_ms(const void *device)
+{
+    const lt_dev_unix_tcp_t *dev = (const lt_dev_unix_tcp_t *)device;
+
+    if (!dev->l1_reply_pending) {
+        return -1;
+    }
+    if (!dev->rx_timeout_ms) {
+        return INT32_MAX;
+    }
+    uint64_t now_us = clock_us();
+    if (now_us >= dev->l1_reply_deadline_us) {
+        return 0;
+    }
+
+    return (int32_t)((dev->l1_reply_deadline_us - now_us + 999u) / 1000u);
+}
+
+const lt_unix_reactor_port_t lt_port_unix_tcp_reactor = {
+    .fd = reactor_fd,
+    .reply_wait_ms = reactor_reply_wait_ms,
+};
+#endif
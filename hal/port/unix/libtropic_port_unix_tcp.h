@@ -4,7 +4,7 @@
 /**
  * @file libtropic_port_unix_tcp.h
  * @author Tropic Square s.r.o.
- * @brief Port for communication with the TROPIC01 Model using TCP.
+ * @brief Port for communication with the TROPIC01 Model using TCP or a Unix domain socket.
  *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
@@ -12,14 +12,20 @@
 #include <netinet/in.h>
 
 #include "libtropic_common.h"
+#include "libtropic_port.h"
+#include "libtropic_port_ops.h"
+#include "libtropic_port_unix_lock.h"
+#include "libtropic_port_unix_reactor.h"
+#include "libtropic_port_unix_rng.h"
 
 #define TCP_TAG_AND_LENGTH_SIZE (sizeof(uint8_t) + sizeof(uint16_t))
-#define MAX_PAYLOAD_LEN L2_MAX_FRAME_SIZE
+/** Maximal number of operations in one TAG_E_BATCH request: CSN edges around each segment of a transaction */
+#define MAX_BATCH_OPS (1 + 3 * LT_L1_SPI_SEGMENTS_MAX)
+/** Payload has room also for a batch of operations transferring one whole L1 frame */
+#define MAX_PAYLOAD_LEN (LT_L1_LEN_MAX + MAX_BATCH_OPS * TCP_TAG_AND_LENGTH_SIZE)
 #define MAX_BUFFER_LEN (TCP_TAG_AND_LENGTH_SIZE + MAX_PAYLOAD_LEN)
 
 #define TX_ATTEMPTS 3
-#define RX_ATTEMPTS 3
-#define MAX_RECV_SIZE (MAX_PAYLOAD_LEN + TCP_TAG_AND_LENGTH_SIZE)
 
 /** @brief Possible values for `tag` field of `unix_tcp_buffer_t`. */
 typedef enum unix_tcp_tag_t {
@@ -29,6 +35,18 @@ typedef enum unix_tcp_tag_t {
     TAG_E_POWER_ON = 0x04,
     TAG_E_POWER_OFF = 0x05,
     TAG_E_WAIT = 0x06,
+    /**
+     * Sequence of operations in one request. Payload is a concatenation of requests (tag, length and payload). Reply
+     * payload is a concatenation of replies to these requests, in the same order.
+     */
+    TAG_E_BATCH = 0x07,
+    /**
+     * Whole L1 transaction executed by the server next to TROPIC01 (see tools/lt_spi_bridge). Payload is flags
+     * (bit 0 set for reading the response), timeout in ms (4 B), maximal length of the response (2 B) and the frame to
+     * write, which may be empty. Reply payload is lt_ret_t of the server (1 B), followed by the response (CHIP_STATUS,
+     * STATUS, length, data and CRC) when it was read.
+     */
+    TAG_E_L1_EXCHANGE = 0x08,
     TAG_E_RESET_TARGET = 0x10,
     TAG_E_INVALID = 0xfd,
     TAG_E_UNSUPPORTED = 0xfe,
@@ -57,15 +75,80 @@ typedef struct lt_dev_unix_tcp_t {
     in_addr_t addr;
     /** @public @brief Port of the model server. */
     in_port_t port;
-    /** @public @brief Seed for the platform's random number generator. */
+    /**
+     * @public @brief Path of the Unix domain socket of the model server, used instead of `addr` and `port` when not
+     *                NULL. Messages over a Unix domain socket cost less than over loopback TCP.
+     */
+    const char *unix_path;
+    /**
+     * @public @brief Seed for rand(), which is seeded during lt_port_init(). Random bytes for libtropic are taken
+     *                from the operating system.
+     */
     unsigned int rng_seed;
+    /** @public @brief Timeout for receiving a reply from the model server in milliseconds, 0 waits forever. */
+    uint32_t rx_timeout_ms;
+    /** @public @brief Timeout for sending a request to the model server in milliseconds, 0 waits forever. */
+    uint32_t tx_timeout_ms;
+    /**
+     * @public @brief When nonzero, delays are not sent to the model server and return immediately, only
+     *                `virtual_time_us` is advanced. The model answers each request when it is made, so it does not
+     *                need the time to pass, and runs finish faster and with deterministic timing.
+     */
+    uint8_t virtual_time;
+    /** @public @brief Sum of all delays in microseconds, read-only. Advanced in both modes. */
+    uint64_t virtual_time_us;
+#if LT_L1_OFFLOAD && LT_NONBLOCKING
+    /**
+     * @public @brief When nonzero and the server executes L1 transactions, `lt_l2_transfer_poll()` (and so
+     *                `lt_poll()`) does not wait for the reply of the server. It returns LT_PENDING until the reply has
+     *                arrived on the socket, `rx_timeout_ms` then limits the whole reply. Meant for driving the handle
+     *                by `lt_unix_reactor_t` through `lt_port_unix_tcp_reactor`.
+     */
+    uint8_t async_reply;
+#endif
 
     /** @private @brief Socket file descriptor. */
     int socket_fd;
+    /** @private @brief Set when the server does not know TAG_E_BATCH, operations are sent one by one then. */
+    int batch_unsupported;
+#if LT_L1_OFFLOAD
+    /** @private @brief Set when the server does not know TAG_E_L1_EXCHANGE, L1 transactions are done by libtropic. */
+    int l1_offload_unsupported;
+    /** @private @brief Length of the frame written by lt_port_l1_write(), sent together with the next read. */
+    uint16_t l1_frame_len;
+    /** @private @brief Timeout of the pending write. */
+    uint32_t l1_frame_timeout_ms;
+    /** @private @brief Frame written by lt_port_l1_write(). */
+    uint8_t l1_frame[LT_L1_LEN_MAX];
+#if LT_NONBLOCKING
+    /** @private @brief Set while the reply to TAG_E_L1_EXCHANGE sent with `async_reply` is awaited. */
+    uint8_t l1_reply_pending;
+    /** @private @brief Bytes of the awaited reply received so far. */
+    size_t l1_reply_received;
+    /** @private @brief Time of CLOCK_MONOTONIC in us by which the awaited reply times out. */
+    uint64_t l1_reply_deadline_us;
+#endif
+#endif
     /** @private @brief Reception buffer. */
     struct unix_tcp_buffer_t rx_buffer;
     /** @private @brief Emission buffer. */
     struct unix_tcp_buffer_t tx_buffer;
+    /** @private @brief Pool of random bytes from the operating system. */
+    lt_unix_rng_t rng;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
 } lt_dev_unix_tcp_t;
 
+#if LT_PORT_OPS
+/** @brief Functions of the port for `lt_l2_state_t.ops`, when the port is compiled with LT_PORT_OPS */
+extern const lt_port_ops_t lt_port_unix_tcp_ops;
+#endif
+
+#if LT_L1_OFFLOAD && LT_NONBLOCKING
+/** @brief Socket of the port for `lt_unix_reactor_add()`, replies are awaited on it with `async_reply` set */
+extern const lt_unix_reactor_port_t lt_port_unix_tcp_reactor;
+#endif
+
 #endif  // LIBTROPIC_PORT_UNIX_TCP_H
\ No newline at end of file
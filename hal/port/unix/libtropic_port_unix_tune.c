@@ -0,0 +1,107 @@
+/**
+ * @file libtropic_port_unix_tune.c
+ * @author Tropic Square s.r.o.
+ * @brief Tuning profiles of handles kept in files of a directory.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_unix_tune.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+#if !LT_TUNE_PERSIST
+#error "libtropic_port_unix_tune.c needs libtropic built with LT_TUNE_PERSIST"
+#endif
+
+/** Bytes of the serial number at the start of the key */
+#define LT_UNIX_TUNE_SER_NUM_SIZE (LT_TUNE_KEY_SIZE - LT_TUNE_PORT_ID_LEN)
+
+/** Makes path of the file of the key, characters of the port identity which are not safe in a name become '_' */
+static int lt_unix_tune_path(const uint8_t *key, const char *dir, char *path, const size_t size)
+{
+    char name[2 * LT_UNIX_TUNE_SER_NUM_SIZE + 1 + LT_TUNE_PORT_ID_LEN + 1];
+    size_t n = 0;
+
+    for (size_t i = 0; i < LT_UNIX_TUNE_SER_NUM_SIZE; i++) {
+        n += (size_t)snprintf(name + n, sizeof(name) - n, "%02x", key[i]);
+    }
+    name[n++] = '-';
+    for (size_t i = LT_UNIX_TUNE_SER_NUM_SIZE; (i < LT_TUNE_KEY_SIZE) && key[i]; i++) {
+        const char c = (char)key[i];
+        const int safe = ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))
+                         || (c == '.') || (c == '-');
+        name[n++] = safe ? c : '_';
+    }
+    name[n] = '\0';
+
+    const int len = snprintf(path, size, "%s/%s.tune", dir, name);
+    return (len < 0) || ((size_t)len >= size);
+}
+
+lt_ret_t lt_unix_tune_load(const uint8_t *key, uint8_t *buff, const uint16_t max_len, uint16_t *len, void *ctx)
+{
+    char path[PATH_MAX];
+
+    if (!key || !buff || !len || !ctx || lt_unix_tune_path(key, (const char *)ctx, path, sizeof(path))) {
+        return LT_PARAM_ERR;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        if (errno == ENOENT) {
+            return LT_NOT_FOUND;
+        }
+        LT_LOG_ERROR("Can't open %s: %s", path, strerror(errno));
+        return LT_FAIL;
+    }
+    size_t n = fread(buff, 1, max_len, f);
+    // Profile longer than the buffer is not one of this build
+    int longer = (n == max_len) && (fgetc(f) != EOF);
+    int err = ferror(f);
+    fclose(f);
+    if (err) {
+        LT_LOG_ERROR("Can't read %s", path);
+        return LT_FAIL;
+    }
+    if (longer) {
+        return LT_NOT_FOUND;
+    }
+    *len = (uint16_t)n;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_unix_tune_save(const uint8_t *key, const uint8_t *buff, const uint16_t len, void *ctx)
+{
+    char path[PATH_MAX];
+    char tmp[PATH_MAX + 4];
+
+    if (!key || !buff || !ctx || lt_unix_tune_path(key, (const char *)ctx, path, sizeof(path))) {
+        return LT_PARAM_ERR;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        LT_LOG_ERROR("Can't create %s: %s", tmp, strerror(errno));
+        return LT_FAIL;
+    }
+    int err = (fwrite(buff, 1, len, f) != len) || fflush(f) || fsync(fileno(f));
+    err |= fclose(f);
+    if (err || rename(tmp, path)) {
+        LT_LOG_ERROR("Can't write %s: %s", path, strerror(errno));
+        unlink(tmp);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
@@ -0,0 +1,43 @@
+#ifndef LIBTROPIC_PORT_UNIX_TUNE_H
+#define LIBTROPIC_PORT_UNIX_TUNE_H
+
+/**
+ * @file libtropic_port_unix_tune.h
+ * @author Tropic Square s.r.o.
+ * @brief Tuning profiles of handles kept in files of a directory, for libtropic compiled with `LT_TUNE_PERSIST`.
+ *
+ * `lt_unix_tune_load()` and `lt_unix_tune_save()` are the callbacks of `lt_tune_store_t`, its `ctx` is the path of
+ * the directory. Each chip and port has its own file named by the serial number of the chip and the port identity,
+ * e.g. `0123...cdef-dev_spidev0.0.tune`. Files are replaced by rename(), so a crash never leaves a partial profile.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/**
+ * @brief Loads the profile saved under the key from the directory `ctx`
+ *
+ * @param key      LT_TUNE_KEY_SIZE bytes of the key
+ * @param buff     Buffer for the profile
+ * @param max_len  Length of the buffer
+ * @param len      Length of the profile
+ * @param ctx      Path of the directory
+ * @return LT_OK if the profile was read, LT_NOT_FOUND when there is none, otherwise other error code.
+ */
+lt_ret_t lt_unix_tune_load(const uint8_t *key, uint8_t *buff, const uint16_t max_len, uint16_t *len, void *ctx);
+
+/**
+ * @brief Saves the profile under the key into the directory `ctx`
+ *
+ * @param key      LT_TUNE_KEY_SIZE bytes of the key
+ * @param buff     Profile
+ * @param len      Length of the profile
+ * @param ctx      Path of the directory
+ * @return LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_unix_tune_save(const uint8_t *key, const uint8_t *buff, const uint16_t len, void *ctx);
+
+#endif
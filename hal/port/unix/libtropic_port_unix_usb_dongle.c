@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -29,8 +30,63 @@
 #include "libtropic_macros.h"
 #include "libtropic_port.h"
 
-#define READ_WRITE_DELAY 10
-#define SPI_TRANSFER_BUFF_SIZE_MAX ((LT_L1_LEN_MAX * 2) + 1)
+/** Default time in milliseconds without any received byte after which the read gives up */
+#define READ_TIMEOUT_MS_DEFAULT 100
+/** Hex encoded data followed by two control characters (request) or CR LF (response) */
+#define SPI_TRANSFER_BUFF_SIZE_MAX ((LT_L1_LEN_MAX * 2) + 2)
+
+/** Uppercase hex digits, the dongle echoes MISO data in the same format */
+static const char hex_digits[16] = "0123456789ABCDEF";
+
+/**
+ * @brief Encodes bytes as pairs of hex characters.
+ *
+ * @param dst  Destination buffer, at least 2 * len bytes long.
+ * @param src  Bytes to be encoded.
+ * @param len  Number of bytes to be encoded.
+ */
+static void hex_encode(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        dst[2 * i] = hex_digits[src[i] >> 4];
+        dst[2 * i + 1] = hex_digits[src[i] & 0x0f];
+    }
+}
+
+/** Returns value of one hex character, or -1 when it is not a hex digit */
+static int hex_value(uint8_t c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;  // to lowercase
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Decodes pairs of hex characters to bytes.
+ *
+ * @param dst  Destination buffer, at least len bytes long.
+ * @param src  Hex characters, 2 * len of them.
+ * @param len  Number of bytes to be decoded.
+ *
+ * @return 0 on success, -1 when src contains a character which is not a hex digit.
+ */
+static int hex_decode(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        int hi = hex_value(src[2 * i]);
+        int lo = hex_value(src[2 * i + 1]);
+        if ((hi < 0) || (lo < 0)) {
+            return -1;
+        }
+        dst[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return 0;
+}
 
 /**
  * @brief Writes data to a serial port (specified by fd).
@@ -54,25 +110,45 @@ static int write_port(int fd, uint8_t *buffer, size_t size)
 /**
  * @brief Reads data from a serial port (specified by fd).
  *
- * @note  Returns after all the desired bytes have been read, or if there is a timeout or other error.
+ * @note  Returns as soon as all the desired bytes have been read, or if no byte arrives for `timeout_ms`, or on
+ *        other error.
  *
- * @param fd        The file descriptor to read from.
- * @param buffer    Pointer to the buffer where the read data will be stored.
- * @param size      The maximum number of bytes to read into the buffer.
+ * @param fd          The file descriptor to read from.
+ * @param buffer      Pointer to the buffer where the read data will be stored.
+ * @param size        The maximum number of bytes to read into the buffer.
+ * @param timeout_ms  Maximal time without any received byte in milliseconds.
  *
  * @return Returns the number of bytes actually read on success, or -1 on error.
  */
-static ssize_t read_port(int fd, uint8_t *buffer, size_t size)
+static ssize_t read_port(int fd, uint8_t *buffer, size_t size, uint32_t timeout_ms)
 {
     size_t received = 0;
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+
     while (received < size) {
+        int ret = poll(&pfd, 1, (int)timeout_ms);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LT_LOG_ERROR("Failed to poll port: %s (%d).", strerror(errno), errno);
+            return -1;
+        }
+        if (ret == 0) {
+            LT_LOG_ERROR("Read timed out, %zu bytes received out of %zu expected.", received, size);
+            break;
+        }
+
         ssize_t read_bytes = read(fd, buffer + received, size - received);
         if (read_bytes < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
             LT_LOG_ERROR("Failed to read from port, read_bytes=%zd.", read_bytes);
             return -1;
         }
         if (read_bytes == 0) {
-            // Timeout.
+            // Device disappeared.
             break;
         }
         received += read_bytes;
@@ -80,11 +156,23 @@ static ssize_t read_port(int fd, uint8_t *buffer, size_t size)
     return received;
 }
 
+static uint32_t read_timeout_ms(const lt_dev_unix_usb_dongle_t *device)
+{
+    return device->read_timeout_ms ? device->read_timeout_ms : READ_TIMEOUT_MS_DEFAULT;
+}
+
 lt_ret_t lt_port_init(lt_l2_state_t *s2)
 {
     lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)s2->device;
 
+#if LT_THREAD_SAFE
+    if (lt_unix_lock_init(&device->lock) != LT_OK) {
+        return LT_FAIL;
+    }
+#endif
+
     srand(device->rng_seed);
+    lt_unix_rng_wipe(&device->rng);
 
     // Initialize the serial port.
     device->fd = open(device->dev_path, O_RDWR | O_NOCTTY);
@@ -115,10 +203,10 @@ lt_ret_t lt_port_init(lt_l2_state_t *s2)
     options.c_oflag &= ~(ONLCR | OCRNL);
     options.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
 
-    // Set up timeouts: Calls to read() will return as soon as there is
-    // at least one byte available or when 100 ms has passed.
-    options.c_cc[VTIME] = 1;
-    options.c_cc[VMIN] = 0;
+    // Waiting for data is done by poll() in read_port(), read() itself does not time out. It returns
+    // whatever is available, or waits for at least `vmin` bytes when configured to reduce wakeups.
+    options.c_cc[VTIME] = 0;
+    options.c_cc[VMIN] = device->vmin;
 
     // This code only supports certain standard baud rates. Supporting
     // non-standard baud rates should be possible but takes more work.
@@ -135,9 +223,35 @@ lt_ret_t lt_port_init(lt_l2_state_t *s2)
         case 38400:
             cfsetospeed(&options, B38400);
             break;
+        case 57600:
+            cfsetospeed(&options, B57600);
+            break;
         case 115200:
             cfsetospeed(&options, B115200);
             break;
+        case 230400:
+            cfsetospeed(&options, B230400);
+            break;
+#ifdef B460800
+        case 460800:
+            cfsetospeed(&options, B460800);
+            break;
+#endif
+#ifdef B921600
+        case 921600:
+            cfsetospeed(&options, B921600);
+            break;
+#endif
+#ifdef B1000000
+        case 1000000:
+            cfsetospeed(&options, B1000000);
+            break;
+#endif
+#ifdef B2000000
+        case 2000000:
+            cfsetospeed(&options, B2000000);
+            break;
+#endif
         default:
             LT_LOG_WARN("Baud rate %" PRIu32 " is not supported, using 9600.\n", device->baud_rate);
             cfsetospeed(&options, B9600);
@@ -159,6 +273,11 @@ lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
 {
     lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)s2->device;
 
+    lt_unix_rng_wipe(&device->rng);
+#if LT_THREAD_SAFE
+    lt_unix_lock_destroy(&device->lock);
+#endif
+
     if (close(device->fd)) {
         return LT_FAIL;
     }
@@ -167,27 +286,41 @@ lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
 
 lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
 {
-    UNUSED(s2);
-    int ret = usleep(ms * 1000);
-    if (ret != 0) {
-        LT_LOG_ERROR("usleep() failed: %s (%d)", strerror(errno), ret);
-        return LT_FAIL;
-    }
+    lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)(s2->device);
 
-    return LT_OK;
+    return lt_unix_delay(&device->delay, s2, (uint64_t)ms * 1000);
 }
 
-lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
 {
-    UNUSED(s2);
+    lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)(s2->device);
 
-    uint8_t *buff_ptr = buff;
-    for (size_t i = 0; i < count; i++) {
-        // Number from rand() is guaranteed to have at least 15 bits valid
-        buff_ptr[i] = (uint8_t)(rand() & 0xFF);
-    }
+    return lt_unix_delay(&device->delay, s2, us);
+}
+#endif
 
-    return LT_OK;
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)(s2->device);
+
+    lt_unix_lock_take(&device->lock);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)(s2->device);
+
+    lt_unix_lock_release(&device->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    lt_dev_unix_usb_dongle_t *device = (lt_dev_unix_usb_dongle_t *)(s2->device);
+
+    return lt_unix_rng_bytes(&device->rng, buff, count);
 }
 
 lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
@@ -207,7 +340,7 @@ lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
     }
 
     uint8_t buff[4];
-    int read_bytes = read_port(device->fd, buff, 4);
+    int read_bytes = read_port(device->fd, buff, 4, read_timeout_ms(device));
     if (read_bytes != 4) {
         return LT_L1_SPI_ERROR;
     }
@@ -229,10 +362,8 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_dat
     }
 
     // Bytes from handle which are about to be sent are encoded as chars and stored to buffered_chars.
-    uint8_t buffered_chars[SPI_TRANSFER_BUFF_SIZE_MAX] = {0};
-    for (int i = 0; i < tx_data_length; i++) {
-        sprintf((char *)(buffered_chars + i * 2), "%02" PRIX8, s2->buff[i + offset]);
-    }
+    uint8_t buffered_chars[SPI_TRANSFER_BUFF_SIZE_MAX];
+    hex_encode(buffered_chars, s2->buff + offset, tx_data_length);
 
     // Control characters to keep CS LOW (they are expected by USB dongle, see the top of this file
     // for more information).
@@ -244,15 +375,14 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_dat
         return LT_L1_SPI_ERROR;
     }
 
-    lt_port_delay(s2, READ_WRITE_DELAY);
-
-    int read_bytes = read_port(device->fd, buffered_chars, (2 * tx_data_length) + 2);
+    int read_bytes = read_port(device->fd, buffered_chars, (2 * tx_data_length) + 2, read_timeout_ms(device));
     if (read_bytes != ((2 * tx_data_length) + 2)) {
         return LT_L1_SPI_ERROR;
     }
 
-    for (size_t count = 0; count < 2 * tx_data_length; count++) {
-        sscanf((char *)&buffered_chars[count * 2], "%02" SCNx8, &s2->buff[count + offset]);
+    if (hex_decode(s2->buff + offset, buffered_chars, tx_data_length) != 0) {
+        LT_LOG_ERROR("Dongle response is not hex encoded.");
+        return LT_L1_SPI_ERROR;
     }
 
     return LT_OK;
@@ -12,6 +12,9 @@
 #include <linux/gpio.h>
 
 #include "libtropic_port.h"
+#include "libtropic_port_unix_delay.h"
+#include "libtropic_port_unix_lock.h"
+#include "libtropic_port_unix_rng.h"
 
 /**
  * @brief Device structure for Unix USB Dongle port.
@@ -24,11 +27,29 @@ typedef struct lt_dev_unix_usb_dongle_t {
     char dev_path[DEVICE_PATH_MAX_LEN];
     /** @public @brief UART baudrate. */
     uint32_t baud_rate;
-    /** @public @brief Seed for the platform's random number generator. */
+    /**
+     * @public @brief Maximal time without any received byte in milliseconds, 0 uses 100 ms. Reads return as soon
+     *                as the whole response arrives.
+     */
+    uint32_t read_timeout_ms;
+    /** @public @brief Minimal number of bytes for one read() from the UART (termios VMIN), 0 returns any data. */
+    uint8_t vmin;
+    /**
+     * @public @brief Seed for rand(), which is seeded during lt_port_init(). Random bytes for libtropic are taken
+     *                from the operating system.
+     */
     unsigned int rng_seed;
+    /** @public @brief Precision of lt_port_delay() and lt_port_delay_us(), zero initialized only sleeps. */
+    lt_unix_delay_t delay;
 
     /** @private @brief UART device file descriptor. */
     int fd;
+    /** @private @brief Pool of random bytes from the operating system. */
+    lt_unix_rng_t rng;
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, libtropic takes it by lt_port_lock(). */
+    lt_unix_lock_t lock;
+#endif
 } lt_dev_unix_usb_dongle_t;
 
 #endif  // LIBTROPIC_PORT_UNIX_USB_DONGLE_H
\ No newline at end of file
@@ -0,0 +1,303 @@
+/**
+ * @file libtropic_port_zephyr.c
+ * @author Tropic Square s.r.o.
+ * @brief Port for Zephyr RTOS using SPI and GPIO drivers of the devicetree.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_port_zephyr.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/cache.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/random/random.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+
+/** Shorter transfers (e.g. CHIP_STATUS polls) are not worth of a context switch */
+#define LT_SPI_ASYNC_MIN_LEN 16
+
+#ifdef CONFIG_SPI_ASYNC
+static void lt_port_zephyr_spi_cb(const struct device *dev, int result, void *data)
+{
+    lt_dev_zephyr_t *device = data;
+    ARG_UNUSED(dev);
+
+    device->spi_result = result;
+    k_sem_give(&device->spi_done);
+}
+#endif
+
+#if LT_USE_INT_PIN
+static void lt_port_zephyr_int_cb(const struct device *port, struct gpio_callback *cb, gpio_port_pins_t pins)
+{
+    lt_dev_zephyr_t *device = CONTAINER_OF(cb, lt_dev_zephyr_t, int_cb);
+    ARG_UNUSED(port);
+    ARG_UNUSED(pins);
+
+    k_sem_give(&device->int_sem);
+#ifdef CONFIG_POLL
+    k_poll_signal_raise(&device->int_signal, 0);
+#endif
+}
+#endif
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    if (!spi_is_ready_dt(&device->spi) || !gpio_is_ready_dt(&device->cs)) {
+        LT_LOG_ERROR("SPI bus or chip select GPIO is not ready");
+        return LT_FAIL;
+    }
+
+    // Chip select is driven by the port, the driver must not toggle it around every transfer
+    device->spi_cfg = device->spi.config;
+    memset(&device->spi_cfg.cs, 0, sizeof(device->spi_cfg.cs));
+
+    int ret = gpio_pin_configure_dt(&device->cs, GPIO_OUTPUT_INACTIVE);
+    if (ret) {
+        LT_LOG_ERROR("Failed to configure chip select, ret=%d", ret);
+        return LT_FAIL;
+    }
+
+#ifdef CONFIG_SPI_ASYNC
+    k_sem_init(&device->spi_done, 0, 1);
+#endif
+#if LT_THREAD_SAFE
+    k_mutex_init(&device->lock);
+#endif
+
+#if LT_USE_INT_PIN
+    if (!gpio_is_ready_dt(&device->int_gpio)) {
+        LT_LOG_ERROR("INT pin GPIO is not ready");
+        return LT_FAIL;
+    }
+    k_sem_init(&device->int_sem, 0, 1);
+#ifdef CONFIG_POLL
+    k_poll_signal_init(&device->int_signal);
+#endif
+    ret = gpio_pin_configure_dt(&device->int_gpio, GPIO_INPUT);
+    if (ret) {
+        LT_LOG_ERROR("Failed to configure INT pin, ret=%d", ret);
+        return LT_FAIL;
+    }
+    gpio_init_callback(&device->int_cb, lt_port_zephyr_int_cb, BIT(device->int_gpio.pin));
+    ret = gpio_add_callback(device->int_gpio.port, &device->int_cb);
+    if (!ret) {
+        ret = gpio_pin_interrupt_configure_dt(&device->int_gpio, GPIO_INT_EDGE_TO_ACTIVE);
+    }
+    if (ret) {
+        LT_LOG_ERROR("Failed to enable interrupt of INT pin, ret=%d", ret);
+        return LT_FAIL;
+    }
+#endif
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+    lt_ret_t ret = LT_OK;
+
+#if LT_USE_INT_PIN
+    if (gpio_pin_interrupt_configure_dt(&device->int_gpio, GPIO_INT_DISABLE)
+        || gpio_remove_callback(device->int_gpio.port, &device->int_cb)) {
+        ret = LT_FAIL;
+    }
+#endif
+    if (gpio_pin_configure_dt(&device->cs, GPIO_DISCONNECTED)) {
+        ret = LT_FAIL;
+    }
+
+    return ret;
+}
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    // Logical level, the pin is active low
+    if (gpio_pin_set_dt(&device->cs, 1)) {
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    if (gpio_pin_set_dt(&device->cs, 0)) {
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_data_length, uint32_t timeout_ms)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    if (offset + tx_data_length > LT_L1_LEN_MAX) {
+        LT_LOG_ERROR("Invalid data length!");
+        return LT_L1_DATA_LEN_ERROR;
+    }
+
+    const struct spi_buf buf = {.buf = s2->buff + offset, .len = tx_data_length};
+    const struct spi_buf_set set = {.buffers = &buf, .count = 1};
+    int ret;
+
+#ifdef CONFIG_SPI_ASYNC
+    if (tx_data_length >= LT_SPI_ASYNC_MIN_LEN) {
+        k_sem_reset(&device->spi_done);
+        ret = spi_transceive_cb(device->spi.bus, &device->spi_cfg, &set, &set, lt_port_zephyr_spi_cb, device);
+        if (ret) {
+            LT_LOG_ERROR("spi_transceive_cb failed, ret=%d", ret);
+            return LT_L1_SPI_ERROR;
+        }
+        // Thread sleeps until the callback, other threads run during the transfer
+        if (k_sem_take(&device->spi_done, K_MSEC(timeout_ms))) {
+            LT_LOG_ERROR("SPI transfer timed out");
+            return LT_L1_SPI_ERROR;
+        }
+        ret = device->spi_result;
+    }
+    else {
+        ret = spi_transceive(device->spi.bus, &device->spi_cfg, &set, &set);
+    }
+#else
+    ARG_UNUSED(timeout_ms);
+    ret = spi_transceive(device->spi.bus, &device->spi_cfg, &set, &set);
+#endif
+    if (ret) {
+        LT_LOG_ERROR("SPI transfer failed, ret=%d", ret);
+        return LT_L1_SPI_ERROR;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms)
+{
+    ARG_UNUSED(s2);
+
+    k_sleep(K_MSEC(ms));
+
+    return LT_OK;
+}
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    ARG_UNUSED(s2);
+
+    // Rounded up to the next tick, finer ticks (CONFIG_SYS_CLOCK_TICKS_PER_SEC) give finer polling
+    k_sleep(K_USEC(us));
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    // Driver applies the configuration at the next transfer, the clock it derives is not reported back
+    device->spi_cfg.frequency = hz;
+    *actual_hz = hz;
+
+    return LT_OK;
+}
+#endif
+
+#if LT_USE_PORT_CACHE
+void lt_port_cache_clean(lt_l2_state_t *s2, const void *addr, size_t len)
+{
+    ARG_UNUSED(s2);
+
+    // Range of data sent in place is rounded to whole cache lines by the cache driver
+    sys_cache_data_flush_range((void *)addr, len);
+}
+
+void lt_port_cache_invalidate(lt_l2_state_t *s2, void *addr, size_t len)
+{
+    ARG_UNUSED(s2);
+
+    sys_cache_data_invd_range(addr, len);
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    // Edges signalized before belong to responses which were already read
+    k_sem_reset(&device->int_sem);
+
+    // INT pin may be already asserted, its edge would be missed then
+    if (gpio_pin_get_dt(&device->int_gpio) == 1) {
+        return LT_OK;
+    }
+    if (k_sem_take(&device->int_sem, K_MSEC(ms))) {
+        return LT_L1_INT_TIMEOUT;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_NONBLOCKING
+void lt_port_zephyr_wait(lt_dev_zephyr_t *device, uint32_t wait_ms)
+{
+#if LT_USE_INT_PIN
+    // Edge given before the wait wakes the thread at once, which is only a spurious poll
+    if (gpio_pin_get_dt(&device->int_gpio) != 1) {
+        k_sem_take(&device->int_sem, K_MSEC(wait_ms));
+    }
+#else
+    ARG_UNUSED(device);
+    k_sleep(K_MSEC(wait_ms));
+#endif
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    k_mutex_lock(&device->lock, K_FOREVER);
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    lt_dev_zephyr_t *device = (lt_dev_zephyr_t *)(s2->device);
+
+    k_mutex_unlock(&device->lock);
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    ARG_UNUSED(s2);
+
+    int ret = sys_csrand_get(buff, count);
+    if (ret) {
+        LT_LOG_ERROR("sys_csrand_get failed, ret=%d", ret);
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
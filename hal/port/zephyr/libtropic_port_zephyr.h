@@ -0,0 +1,86 @@
+#ifndef LIBTROPIC_PORT_ZEPHYR_H
+#define LIBTROPIC_PORT_ZEPHYR_H
+
+/**
+ * @file libtropic_port_zephyr.h
+ * @author Tropic Square s.r.o.
+ * @brief Port for Zephyr RTOS using SPI and GPIO drivers of the devicetree.
+ *
+ * Longer transfers are started by `spi_transceive_cb()` (with CONFIG_SPI_ASYNC) and the calling thread sleeps on a
+ * semaphore given by the completion callback. INT pin raises a GPIO interrupt, whose callback wakes the thread waiting
+ * in `lt_port_delay_on_int()`. Delays sleep by `k_sleep()`, so other threads get the CPU while TROPIC01 computes.
+ *
+ * With LT_NONBLOCKING, `lt_port_zephyr_wait()` sleeps between `lt_l2_transfer_poll()` calls (or polls of LT_ASYNC)
+ * and with CONFIG_POLL, `int_signal` can be added to `k_poll()` of an event loop serving other events too.
+ *
+ * Random bytes come from `sys_csrand_get()`, which needs CONFIG_CSPRNG_ENABLED (an entropy driver).
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+
+#include "libtropic_port.h"
+
+/**
+ * @brief Device structure for Zephyr port.
+ *
+ * @note Public members are meant to be configured by the developer before passing the handle to
+ *       libtropic.
+ */
+typedef struct lt_dev_zephyr_t {
+    /**
+     * @public @brief SPI bus and its configuration, e.g. `SPI_DT_SPEC_GET(node, SPI_WORD_SET(8) | SPI_TRANSFER_MSB, 0)`
+     * (SPI mode 0). Chip select of the spec is ignored, because one L1 frame consists of several transfers.
+     */
+    struct spi_dt_spec spi;
+    /** @public @brief GPIO used for chip select, active low in the devicetree, e.g. from `cs-gpios` of the bus. */
+    struct gpio_dt_spec cs;
+#if LT_USE_INT_PIN
+    /** @public @brief GPIO connected to TROPIC01's INT pin, active high in the devicetree. */
+    struct gpio_dt_spec int_gpio;
+#endif
+
+    /** @private @brief Configuration of the bus, `spi.config` without chip select. */
+    struct spi_config spi_cfg;
+#ifdef CONFIG_SPI_ASYNC
+    /** @private @brief Given by the callback of a finished asynchronous transfer. */
+    struct k_sem spi_done;
+    /** @private @brief Result of the finished asynchronous transfer. */
+    int spi_result;
+#endif
+#if LT_USE_INT_PIN
+    /** @private @brief Given by the GPIO callback when INT pin is asserted. */
+    struct k_sem int_sem;
+    /** @private @brief GPIO callback of INT pin. */
+    struct gpio_callback int_cb;
+#ifdef CONFIG_POLL
+    /**
+     * @public @brief Raised together with `int_sem`, to be used (read only) in `K_POLL_EVENT_INITIALIZER()` of
+     * the application. Reset it by `k_poll_signal_reset()` before waiting.
+     */
+    struct k_poll_signal int_signal;
+#endif
+#endif
+#if LT_THREAD_SAFE
+    /** @private @brief Lock of the handle, k_mutex can be taken recursively by its owner. */
+    struct k_mutex lock;
+#endif
+} lt_dev_zephyr_t;
+
+#if LT_NONBLOCKING
+/**
+ * @brief Sleeps the calling thread until the next poll of a non-blocking transfer is due.
+ * @details Returns after `wait_ms` returned by `lt_l2_transfer_begin()` or `lt_l2_transfer_poll()`, with
+ * LT_USE_INT_PIN already when INT pin is asserted.
+ *
+ * @param device      Device structure passed to libtropic
+ * @param wait_ms     Time to wait in miliseconds
+ */
+void lt_port_zephyr_wait(lt_dev_zephyr_t *device, uint32_t wait_ms);
+#endif
+
+#endif  // LIBTROPIC_PORT_ZEPHYR_H
@@ -23,9 +23,14 @@
 #define _U(x) (_AC(x, U))
 #define U(x) (_U(x))
 
+// Guarded, RTOS headers (e.g. Zephyr) define the same macros
+#ifndef BIT
 #define BIT(nr) (1U << (nr))
+#endif
 
+#ifndef BIT64
 #define BIT64(nr) (((u64)(1)) << ((u64)(nr)))
+#endif
 
 // BIT defines a bit mask for the specified bit number from 0 to whatever fits into an unsigned long
 // so BIT(10) should evaluate to decimal 1024 (which is binary 1 left shifted by 10 bits)
@@ -37,7 +42,9 @@
 // if h = 4 and l = 1, __GENMASK would return 00000000000000000000000000011110
 #define __GENMASK(h, l) (((~U(0)) - (U(1) << (l)) + 1) & (~U(0) >> (BITS_PER_LONG - 1 - (h))))
 
+#ifndef GENMASK
 #define GENMASK(h, l) (GENMASK_INPUT_CHECK(h, l) + __GENMASK(h, l))
+#endif
 
 #define __bf_shf(x) (__builtin_ffsll(x) - 1)
 
@@ -21,6 +21,14 @@
 
 #include "libtropic_common.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if LT_ASYNC
+#include "libtropic_l2.h"
+#endif
+
 /**
  * @brief Initialize handle and transport layer
  *
@@ -49,6 +57,32 @@ lt_ret_t lt_init(lt_handle_t *h);
  */
 lt_ret_t lt_deinit(lt_handle_t *h);
 
+#if LT_PORT_SHARE
+/**
+ * @brief Takes a reference of the port device shared by handles, initializing it when it is the first one
+ * @details The device stays initialized until the reference is released by `lt_port_detach()`, so `lt_init()` and
+ * `lt_deinit()` of handles using it in between only attach and detach, see `lt_port_share_t`.
+ *
+ * @param h           Device's handle with `h->l2.port_share` set
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_port_attach(lt_handle_t *h);
+
+/**
+ * @brief Releases a reference taken by `lt_port_attach()`, deinitializing the device when it is the last one
+ *
+ * @param h           Device's handle with `h->l2.port_share` set
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_port_detach(lt_handle_t *h);
+#endif
+
 /**
  * @brief Update mode variable in handle.
  * Reads one byte from SPI, checks `CHIP_MODE_STARTUP_bit` and updates this information in `lt_l2_state_t` (part of the
@@ -56,6 +90,7 @@ lt_ret_t lt_deinit(lt_handle_t *h);
  *
  * Info from this bit is updated in handle on every L1 transaction anyway.
  * This function can be used to actualize it whenever user wants.
+ * @note With LT_MODE_TRACK it returns without any transfer when `h->l2.mode_track` observed the mode recently.
  *
  * @param h           Device's handle
  *
@@ -90,529 +125,2307 @@ lt_ret_t lt_get_info_cert_store(lt_handle_t *h, struct lt_cert_store_t *store);
  */
 lt_ret_t lt_get_st_pub(const struct lt_cert_store_t *store, uint8_t *stpub, int stpub_len);
 
-//--------------------------------------------------------------------------------------------------------------------//
-/** @brief Maximal size of returned CHIP ID */
-#define LT_L2_GET_INFO_CHIP_ID_SIZE 128
-
 /**
- * @brief Read TROPIC01's CHIP ID
+ * @brief Reads STPub directly from TROPIC01's Certificate Store
+ *
+ * Only the blocks of the device certificate up to STPub are read, instead of whole store read by
+ * `lt_get_info_cert_store()`.
  *
  * @param h           Device's handle
- * @param chip_id     Structure which holds all fields of CHIP ID
+ * @param stpub       TROPIC01 STPUB to be filled, unique for each device
+ * @param stpub_len   Length of buffer for STPub
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_get_info_chip_id(lt_handle_t *h, struct lt_chip_id_t *chip_id);
+lt_ret_t lt_get_info_st_pub(lt_handle_t *h, uint8_t *stpub, int stpub_len);
 
 /**
- * @brief Read TROPIC01's RISC-V firmware version
+ * @brief Serializes certificate store together with STPub, so it can be persisted and imported later by
+ * `lt_cert_store_import()` instead of being read from TROPIC01 again
  *
- * @param h           Device's handle
- * @param ver Buffer for FW version bytes with size `LT_L2_GET_INFO_RISCV_FW_SIZE`
+ * @param chip_id     CHIP_ID of TROPIC01 the store belongs to, its serial number is the key of exported data
+ * @param store       Certificate store read by `lt_get_info_cert_store()`
+ * @param buff        Buffer for exported data, `LT_CERT_STORE_EXPORT_SIZE_MAX` bytes is always enough
+ * @param max_len     Length of buff
+ * @param len         Length of exported data
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_get_info_riscv_fw_ver(lt_handle_t *h, uint8_t *ver);
+lt_ret_t lt_cert_store_export(const struct lt_chip_id_t *chip_id, const struct lt_cert_store_t *store, uint8_t *buff,
+                              const uint16_t max_len, uint16_t *len);
 
 /**
- * @brief Read TROPIC01's SPECT firmware version
+ * @brief Restores certificate store and STPub from data produced by `lt_cert_store_export()`
  *
- * @param h           Device's handle
- * @param ver Buffer for SPECT version bytes with size `LT_L2_GET_INFO_SPECT_FW_SIZE`
+ * @param chip_id     CHIP_ID of connected TROPIC01, data exported for another chip are rejected
+ * @param buff        Exported data
+ * @param len         Length of exported data
+ * @param store       Certificate store with buffers to be filled, can be NULL when only STPub is needed
+ * @param stpub       Buffer for STPub, can be NULL
+ * @param stpub_len   Length of buffer for STPub
  *
  * @retval            LT_OK Function executed successfully
+ * @retval            LT_CERT_STORE_INVALID Data are corrupted or belong to another chip, read the store from TROPIC01
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_get_info_spect_fw_ver(lt_handle_t *h, uint8_t *ver);
+lt_ret_t lt_cert_store_import(const struct lt_chip_id_t *chip_id, const uint8_t *buff, const uint16_t len,
+                              struct lt_cert_store_t *store, uint8_t *stpub, int stpub_len);
+
+//--------------------------------------------------------------------------------------------------------------------//
+/** @brief Maximal size of returned CHIP ID */
+#define LT_L2_GET_INFO_CHIP_ID_SIZE 128
 
 /**
- * @brief Read TROPIC01's firmware bank info
+ * @brief Read TROPIC01's CHIP ID
  *
  * @param h           Device's handle
- * @param bank_id     ID of firmware bank (one from enum bank_id_t)
- * @param header      Buffer to store fw header bytes into
- * @param max_len     Length of a buffer
+ * @param chip_id     Structure which holds all fields of CHIP ID
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_get_info_fw_bank(lt_handle_t *h, const bank_id_t bank_id, uint8_t *header, const uint16_t max_len);
+lt_ret_t lt_get_info_chip_id(lt_handle_t *h, struct lt_chip_id_t *chip_id);
 
 /**
- * @brief Establishes encrypted secure session between TROPIC01 and host MCU
- *
- * @note              To successfully estabilish Secure Session, you need to know Tropic01's X25519 public key.
- *                    (STPUB). The STPUB can be obtained using lt_get_st_pub, or you can use
- *                    lt_verify_chip_and_start_secure_session helper function, which will obtain the STPUB
- *                    automatically and set up the Secure Session for you.
+ * @brief Read TROPIC01's RISC-V firmware version
  *
  * @param h           Device's handle
- * @param stpub       STPUB from device's certificate
- * @param pkey_index  Index of pairing public key
- * @param shipriv     Secure host private key
- * @param shipub      Secure host public key
+ * @param ver Buffer for FW version bytes with size `LT_L2_GET_INFO_RISCV_FW_SIZE`
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index, const uint8_t *shipriv,
-                          const uint8_t *shipub);
+lt_ret_t lt_get_info_riscv_fw_ver(lt_handle_t *h, uint8_t *ver);
 
 /**
- * @brief Aborts encrypted secure session between TROPIC01 and host MCU
- *
- * @note              Data used for the Secure Session are always invalidated regardless
- *                    of the result of the abort request (if you pass correct handle).
- *                    After calling this function, it will not be possible to send L3 commands
- *                    unless new Secure Session is started.
+ * @brief Read TROPIC01's SPECT firmware version
  *
  * @param h           Device's handle
+ * @param ver Buffer for SPECT version bytes with size `LT_L2_GET_INFO_SPECT_FW_SIZE`
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_session_abort(lt_handle_t *h);
+lt_ret_t lt_get_info_spect_fw_ver(lt_handle_t *h, uint8_t *ver);
 
+#if LT_GET_INFO_CACHE
 /**
- * @brief Puts TROPIC01 into sleep
+ * @brief Invalidates GET_INFO results cached in `h->info_cache`, so they are read from TROPIC01 again
+ * @note Called by `lt_reboot()` and by firmware update functions. Call it when the handle is about to be
+ * connected to a different chip.
  *
  * @param h           Device's handle
- * @param sleep_kind  Kind of sleep
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_sleep(lt_handle_t *h, const uint8_t sleep_kind);
+lt_ret_t lt_get_info_cache_invalidate(lt_handle_t *h);
+#endif
 
+#if LT_STATS
 /**
- * @brief Reboots TROPIC01
+ * @brief Reads statistics of one L2 request or L3 command collected in `h->l2.stats`
  *
  * @param h           Device's handle
- * @param startup_id  Startup ID
+ * @param key         LT_STATS_KEY_L2() or LT_STATS_KEY_L3() key
+ * @param entry       Copy of the statistics, zeroed when nothing was recorded for the key
  *
  * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @retval            LT_PARAM_ERR Invalid parameter or `h->l2.stats` is NULL
  */
-lt_ret_t lt_reboot(lt_handle_t *h, const uint8_t startup_id);
+lt_ret_t lt_stats_get(lt_handle_t *h, const uint16_t key, lt_stats_entry_t *entry);
 
-#ifdef ABAB
-/** @brief Maximal size of update data */
-#define LT_MUTABLE_FW_UPDATE_SIZE_MAX 25600
 /**
- * @brief Erase mutable firmware in one of banks
+ * @brief Clears all statistics collected in `h->l2.stats`, the clock is kept
  *
  * @param h           Device's handle
- * @param bank_id     enum bank_id_t
  *
  * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @retval            LT_PARAM_ERR Invalid parameter or `h->l2.stats` is NULL
  */
-lt_ret_t lt_mutable_fw_erase(lt_handle_t *h, const bank_id_t bank_id);
+lt_ret_t lt_stats_reset(lt_handle_t *h);
+#endif
+
+#if LT_TRACE
+/** @brief Writes a part of trace dump produced by `lt_trace_dump()`, returns LT_OK if successful */
+typedef lt_ret_t (*lt_trace_write_t)(void *ctx, const uint8_t *data, const uint16_t len);
 
 /**
- * @brief Update mutable firmware in one of banks
+ * @brief Initializes trace ring, which is enabled then. Store its pointer into `h->l2.trace` to trace the handle.
  *
- * @param h             Device's handle
- * @param fw_data       Array with firmware bytes
- * @param fw_data_size  Number of firmware's bytes in passed array
- * @param bank_id       enum bank_id_t
- * lt_ret_t             LT_OK            - SUCCESS
- *                      other parameters - ERROR, for verbose output pass return value to function lt_ret_verbose()
+ * @param t           Trace ring
+ * @param events      Array of events, must stay valid while the ring is used
+ * @param cnt         Number of events, power of two
+ * @param time_us     Optional monotonic clock in us for timestamps, NULL to record zero
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
  */
-lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *fw_data, const uint16_t fw_data_size, bank_id_t bank_id);
-
-#elif ACAB
-/** @brief Maximal size of update data */
-#define LT_MUTABLE_FW_UPDATE_SIZE_MAX 30720
+lt_ret_t lt_trace_init(lt_trace_t *t, lt_trace_event_t *events, const uint32_t cnt, uint32_t (*time_us)(void));
 
 /**
- * @brief Sends mutable firmware update L2 request to TROPIC01 with silicon revision ACAB
+ * @brief Writes recorded events, oldest first, in the binary format decoded by `scripts/trace_dump.py`
+ * @note Events recorded while the dump is written might be torn, disable the ring (`t->enabled = 0`) before.
  *
- * @param h               Device's handle
- * @param update_request  Array with firmware update request bytes
- * @return                LT_OK if success, otherwise returns other error code.
+ * @param t           Trace ring
+ * @param write       Called for the header and for each event
+ * @param ctx         Argument of `write`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ * @retval            other Error returned by `write`
  */
-lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *update_request);
+lt_ret_t lt_trace_dump(const lt_trace_t *t, lt_trace_write_t write, void *ctx);
 
 /**
- * @brief Sends mutable firmware update data to TROPIC01 with silicon revision ACAB. Function
- * `lt_mutable_fw_update()` must be called first to start authenticated mutable fw update.
+ * @brief Writes events recorded since the previous call as a dump of the same format, so called periodically it
+ * streams the trace, e.g. over SEGGER RTT (hal/port/cortex_m/libtropic_port_cortex_m_trace.h). Nothing is written
+ * when no event was recorded. Events overwritten before they were written are counted in the header of the dump.
+ * @note The ring stays enabled, the last events might be torn when they are recorded during the call.
  *
- * @param h                 Device's handle
- * @param update_data       Array with firmware update data bytes
- * @param update_data_size  Size of update data
- * @return                  LT_OK if success, otherwise returns other error code.
+ * @param t           Trace ring
+ * @param pos         Number of events written by previous calls, zero before the first one, updated on success
+ * @param write       Called for the header and for each event
+ * @param ctx         Argument of `write`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ * @retval            other Error returned by `write`, the events are written again by the next call
  */
-lt_ret_t lt_mutable_fw_update_data(lt_handle_t *h, const uint8_t *update_data, const uint16_t update_data_size);
-
+lt_ret_t lt_trace_dump_new(const lt_trace_t *t, uint32_t *pos, lt_trace_write_t write, void *ctx);
 #endif
+
+#if LT_PROFILE
 /**
- * @brief Gets Log message of TROPIC01's RISC-V FW (if enabled/available).
- * @note RISC-V FW logging can be disabled in the I/R-Config and for the production chips, it **will** be disabled. This
- * function is used mainly for internal debugging and not expected to be used by the user.
+ * @brief Clears the profile and starts accumulating cycles of the measured functions into it, NULL stops
+ * profiling.
  *
- * @param h            Device's handle
- * @param log_msg      Buffer for the log message (atleast 255B)
- * @param log_msg_len  Length of the log message
+ * @param p           Profile
+ * @param cycles      Free running 32-bit cycle counter, e.g. `lt_cortex_m_cycles()` of
+ *                    hal/port/cortex_m/libtropic_port_cortex_m_profile.h, a call must not take a full period of it
  *
  * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @retval            LT_PARAM_ERR Invalid parameter
  */
-lt_ret_t lt_get_log_req(lt_handle_t *h, uint8_t *log_msg, uint16_t *log_msg_len);
+lt_ret_t lt_profile_init(lt_profile_t *p, uint32_t (*cycles)(void));
 
 /**
- * @brief A dummy command to check the Secure Channel Session communication by exchanging a message with TROPIC01, whish
- * is echoed through the Secure Channel.
+ * @brief Prints calls, total, average and maximal cycles of each measured function.
  *
- * @param h           Device's handle
- * @param msg_out     Ping message going out
- * @param msg_in      Ping message going in
- * @param len         Length of both messages (msg_out and msg_in)
+ * @param p           Profile
+ * @param print_func  printf-like function to use for printing
  *
  * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @retval            LT_PARAM_ERR Invalid parameter
  */
-lt_ret_t lt_ping(lt_handle_t *h, const uint8_t *msg_out, uint8_t *msg_in, const uint16_t len);
+lt_ret_t lt_profile_dump(const lt_profile_t *p, int (*print_func)(const char *format, ...));
+#endif
 
+#if LT_RECORD
 /**
- * @brief Writes pairing public key into TROPIC01's pairing key slot 0-3
+ * @brief Starts recording by writing its header, the recording is enabled then. Store its pointer into
+ * `h->l2.record` before `lt_init()` to record the whole session of the handle.
  *
- * @param h           Device's handle
- * @param pairing_pub 32B of pubkey
- * @param slot        Pairing key lot SH0PUB - SH3PUB
+ * @param r           Recording
+ * @param write       Called for the header and for each record, e.g. `lt_unix_record_fwrite()`
+ * @param ctx         Argument of `write`
  *
  * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @retval            LT_PARAM_ERR Invalid parameter
  */
-lt_ret_t lt_pairing_key_write(lt_handle_t *h, const uint8_t *pairing_pub, const uint8_t slot);
+lt_ret_t lt_record_start(lt_record_t *r, void (*write)(void *ctx, const uint8_t *data, const uint16_t len),
+                         void *ctx);
+#endif
 
 /**
- * @brief Reads pairing public key from TROPIC01's pairing key slot 0-3
+ * @brief Read TROPIC01's firmware bank info
  *
  * @param h           Device's handle
- * @param pairing_pub 32B of pubkey
- * @param slot        Pairing key lot SH0PUB - SH3PUB
+ * @param bank_id     ID of firmware bank (one from enum bank_id_t)
+ * @param header      Buffer to store fw header bytes into
+ * @param max_len     Length of a buffer
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_pairing_key_read(lt_handle_t *h, uint8_t *pairing_pub, const uint8_t slot);
+lt_ret_t lt_get_info_fw_bank(lt_handle_t *h, const bank_id_t bank_id, uint8_t *header, const uint16_t max_len);
 
 /**
- * @brief Invalidates pairing key in slot 0-3
+ * @brief Reads versions of both firmwares and headers of all four firmware banks, headers are parsed from the layout
+ * of either bootloader version into `lt_fw_bank_info_t`. Headers can be read only in MAINTENANCE mode.
+ *
+ * @note With `h->info_cache`, the versions and headers are read from TROPIC01 only once, so checks done by
+ * `lt_fw_bank_identical()` and similar after this call do not repeat the requests.
  *
  * @param h           Device's handle
- * @param slot        Pairing key lot SH0PUB - SH3PUB
+ * @param info        Versions and bank headers
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_pairing_key_invalidate(lt_handle_t *h, const uint8_t slot);
+lt_ret_t lt_get_info_fw_all(lt_handle_t *h, lt_fw_info_t *info);
 
 /**
- * @brief Writes configuration object specified by `addr`
+ * @brief Establishes encrypted secure session between TROPIC01 and host MCU
+ *
+ * @note              To successfully estabilish Secure Session, you need to know Tropic01's X25519 public key.
+ *                    (STPUB). The STPUB can be obtained using lt_get_st_pub, or you can use
+ *                    lt_verify_chip_and_start_secure_session helper function, which will obtain the STPUB
+ *                    automatically and set up the Secure Session for you.
  *
  * @param h           Device's handle
- * @param addr        Address of a config object
- * @param obj         Content to be written
+ * @param stpub       STPUB from device's certificate
+ * @param pkey_index  Index of pairing public key
+ * @param shipriv     Secure host private key
+ * @param shipub      Secure host public key
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_r_config_write(lt_handle_t *h, enum CONFIGURATION_OBJECTS_REGS addr, const uint32_t obj);
+lt_ret_t lt_session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index, const uint8_t *shipriv,
+                          const uint8_t *shipub);
 
+#if LT_EPHEMERAL_KEY_POOL
 /**
- * @brief Reads configuration object specified by `addr`
+ * @brief Generates ephemeral key pairs into empty slots of `h->key_pool`, so `lt_session_start()` does not have to
+ * generate one on its critical path
+ * @note Meant to be called in idle time or from a worker thread. It must not run concurrently with other functions
+ * using the same handle.
  *
- * @param h           Device's handle
- * @param addr        Address of a config object
- * @param obj         Variable to read content into
+ * @param h           Device's handle, `h->key_pool` must be set
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
- *
  */
-lt_ret_t lt_r_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj);
+lt_ret_t lt_ephemeral_key_pool_refill(lt_handle_t *h);
+#endif
 
 /**
- * @brief Erases all configuration objects
+ * @brief Prepares handshake inputs which depend only on the pairing key and the chip, so they are not calculated
+ * again by each `lt_session_start_ctx()`.
  *
- * @param h           Device's handle
+ * @param ctx         Handshake context to be filled
+ * @param stpub       STPUB from device's certificate
+ * @param pkey_index  Index of pairing public key
+ * @param shipriv     Secure host private key, only its pointer is stored, so it must stay valid while ctx is used
+ * @param shipub      Secure host public key
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_r_config_erase(lt_handle_t *h);
+lt_ret_t lt_session_ctx_init(lt_session_ctx_t *ctx, const uint8_t *stpub, const pkey_index_t pkey_index,
+                             const uint8_t *shipriv, const uint8_t *shipub);
 
 /**
- * @brief Writes configuration object specified by `addr` to I-Config
+ * @brief Establishes encrypted secure session, same as `lt_session_start()`, with inputs prepared by
+ * `lt_session_ctx_init()`
  *
  * @param h           Device's handle
- * @param addr        Address of a config object
- * @param bit_index   Index of bit to write from 1 to 0
+ * @param ctx         Handshake context
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_i_config_write(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, const uint8_t bit_index);
+lt_ret_t lt_session_start_ctx(lt_handle_t *h, const lt_session_ctx_t *ctx);
 
+#if LT_SESSION_AUTO
 /**
- * @brief Reads configuration object specified by `addr` from I-Config
+ * @brief Establishes secure session with key material of `h->session_auto`, unless it is established already
+ * @note Called by `lt_init()` with `prewarm` set and by each L3 command. Applications can call it e.g. from the idle
+ * loop, so the session is ready before the first command comes. It must not run concurrently with other functions
+ * using the same handle, unless LT_THREAD_SAFE is used.
  *
- * @param h           Device's handle
- * @param addr        Address of a config object
- * @param obj         Variable to read content into
+ * @param h           Device's handle, `h->session_auto` must be set
  *
- * @retval            LT_OK Function executed successfully
+ * @retval            LT_OK Session is established
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_i_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj);
+lt_ret_t lt_session_auto_start(lt_handle_t *h);
+#endif
 
 /**
- * @brief Writes bytes into a given slot of the User Partition in the R memory
+ * @brief Aborts encrypted secure session between TROPIC01 and host MCU
+ *
+ * @note              Data used for the Secure Session are always invalidated regardless
+ *                    of the result of the abort request (if you pass correct handle).
+ *                    After calling this function, it will not be possible to send L3 commands
+ *                    unless new Secure Session is started.
  *
  * @param h           Device's handle
- * @param udata_slot  Memory's slot to be written
- * @param data        Buffer of data to be written into R MEMORY slot
- * @param size        Size of data to be written (valid range given by macros `R_MEM_DATA_SIZE_MIN` and
- * `R_MEM_DATA_SIZE_MAX`)
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size);
+lt_ret_t lt_session_abort(lt_handle_t *h);
 
+#if LT_SESSION_LIVENESS
 /**
- * @brief Reads bytes from a given slot of the User Partition in the R memory
+ * @brief Tells whether the secure session is established and nothing showed TROPIC01 lost it, see `lt_liveness_t`
+ * @details Nothing is sent to TROPIC01, unless there was no L3 result for `h->l2.liveness->probe_after_ms`, then
+ * the session is probed by `lt_ping()`. The next L3 command after a lost session fails with LT_HOST_NO_SESSION, or
+ * starts a new session with LT_SESSION_AUTO.
  *
- * @param h           Device's handle
- * @param udata_slot  Memory's slot to be read
- * @param data        Buffer to read data into
- * @param size        Number of bytes read into data
+ * @param h           Device's handle, without `h->l2.liveness` only the state of the host is returned
  *
- * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @return            true when the session is alive
  */
-lt_ret_t lt_r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size);
+bool lt_session_is_alive(lt_handle_t *h);
+#endif
 
 /**
- * @brief Erases the given slot of the User Partition in the R memory
+ * @brief Puts TROPIC01 into sleep
  *
  * @param h           Device's handle
- * @param udata_slot  Memory's slot to be erased
+ * @param sleep_kind  Kind of sleep
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot);
+lt_ret_t lt_sleep(lt_handle_t *h, const uint8_t sleep_kind);
 
+#if LT_IDLE_SLEEP
 /**
- * @brief Gets random bytes from TROPIC01's Random Number Generator.
+ * @brief Puts TROPIC01 to sleep (`LT_L2_SLEEP_KIND_SLEEP`) when there was no communication with it for
+ * `h->l2.idle->window_ms`, see `lt_idle_t`
+ * @note Meant to be called periodically, e.g. from the application's idle loop or a timer task. Nothing is sent when
+ * TROPIC01 already sleeps or the window did not elapse yet.
  *
- * @param h           Device's handle
- * @param buff        Buffer
- * @param len         Number of random bytes (255 bytes is the maximum)
+ * @param h           Device's handle with `h->l2.idle` set
  *
- * @retval            LT_OK Function executed successfully
+ * @retval            LT_OK TROPIC01 sleeps or is not idle long enough
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len);
+lt_ret_t lt_idle_poll(lt_handle_t *h);
+#endif
+
+#if LT_WAKE_BATCH
+/** @brief Max number of operations deferred in `lt_wake_batch_t` */
+#ifndef LT_WAKE_BATCH_DEPTH
+#define LT_WAKE_BATCH_DEPTH 8
+#endif
+
+/** @brief Operation deferred by `lt_wake_batch_add()` */
+typedef enum lt_wake_op_kind_t {
+    /** @brief `lt_mcounter_update()` of counter `index` */
+    LT_WAKE_OP_MCOUNTER_UPDATE,
+    /** @brief `lt_ecc_ecdsa_sign()` of `in` by slot `index`, signature into `out` */
+    LT_WAKE_OP_ECDSA_SIGN,
+    /** @brief `lt_ecc_eddsa_sign()` of `in` by slot `index`, signature into `out` */
+    LT_WAKE_OP_EDDSA_SIGN,
+    /** @brief `lt_r_mem_data_write()` of `in` into slot `index` */
+    LT_WAKE_OP_R_MEM_WRITE,
+    /** @brief `lt_r_mem_data_erase()` of slot `index` */
+    LT_WAKE_OP_R_MEM_ERASE,
+    /** @brief `lt_random_value_get()` of `out_len` bytes into `out` */
+    LT_WAKE_OP_RANDOM_GET
+} lt_wake_op_kind_t;
+
+struct lt_wake_op_t;
+
+/** @brief Called for each operation after the burst which executed it, `op->status` holds its result */
+typedef void (*lt_wake_done_cb_t)(const struct lt_wake_op_t *op, void *ctx);
+
+/** @brief Operation deferred by `lt_wake_batch_add()`, copied into the queue */
+typedef struct lt_wake_op_t {
+    /** @public @brief One of `lt_wake_op_kind_t` */
+    uint8_t kind;
+    /** @public @brief ECC slot, R-Memory slot or monotonic counter index */
+    uint16_t index;
+    /** @public @brief Message to sign or data to write, must stay valid until `done` is called */
+    const uint8_t *in;
+    /** @public @brief Length of `in` */
+    uint32_t in_len;
+    /** @public @brief Buffer for the signature (64 B) or random bytes, must stay valid until `done` is called */
+    uint8_t *out;
+    /** @public @brief Number of random bytes */
+    uint16_t out_len;
+    /** @public @brief Longest time the operation may wait in the queue */
+    uint32_t max_delay_ms;
+    /** @public @brief Called after the operation was executed, may be NULL */
+    lt_wake_done_cb_t done;
+    /** @public @brief Context passed to `done` */
+    void *ctx;
+    /** @public @brief Result of the operation, LT_FAIL when it was not executed, read only */
+    lt_ret_t status;
+    /** @private @brief Time of `time_us` by which the operation has to be executed */
+    uint32_t due_us;
+} lt_wake_op_t;
 
 /**
- * @brief Generates ECC key in the specified ECC key slot
+ * @brief Queue of operations deferred for a duty-cycled device, initialized by `lt_wake_batch_init()`
+ *
+ * Operations which are not urgent (counter updates, signatures, R-Memory writes) are collected by
+ * `lt_wake_batch_add()` instead of being executed as the application reaches them. `lt_wake_batch_flush()` then
+ * executes all of them as one pipelined burst, so TROPIC01 executes one command while the host encrypts the next one
+ * and the chip and the MCU are awake only for the burst. `lt_wake_batch_due_ms()` tells how long the MCU may sleep
+ * before the queue has to be flushed. TROPIC01 ends the secure session by sleep, so the queue is best flushed
+ * before `lt_sleep()`, see `lt_wake_batch_sleep()`.
+ */
+typedef struct lt_wake_batch_t {
+    /** @public @brief Monotonic clock in us, mandatory */
+    uint32_t (*time_us)(void);
+    /** @public @brief Number of bursts, read only */
+    uint32_t flushes;
+    /** @public @brief Number of operations executed successfully, read only */
+    uint32_t ops_ok;
+    /** @public @brief Number of operations which failed or were not executed, read only */
+    uint32_t ops_failed;
+    /** @public @brief Duration of the last burst in us, read only */
+    uint32_t burst_us_last;
+    /** @public @brief The longest burst in us, read only */
+    uint32_t burst_us_max;
+    /** @private @brief Queued operations */
+    lt_wake_op_t ops[LT_WAKE_BATCH_DEPTH];
+    /** @private @brief Number of queued operations */
+    uint8_t cnt;
+} lt_wake_batch_t;
+
+/**
+ * @brief Initializes queue of deferred operations
  *
- * @param h           Device's handle
- * @param slot        Slot number ecc_slot_t
- * @param curve       Type of ECC curve. Use L3_ECC_KEY_GENERATE_CURVE_ED25519 or L3_ECC_KEY_GENERATE_CURVE_P256
+ * @param q           Queue
+ * @param time_us     Monotonic clock in us
  *
  * @retval            LT_OK Function executed successfully
- * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
- * of returned value
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
  */
-lt_ret_t lt_ecc_key_generate(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve);
+lt_ret_t lt_wake_batch_init(lt_wake_batch_t *q, uint32_t (*time_us)(void));
+
+/**
+ * @brief Defers an operation until the next `lt_wake_batch_flush()`
+ * @details Parameters are checked as by the function executing the operation, so a queued operation fails only
+ * on TROPIC01.
+ *
+ * @param q           Queue
+ * @param op          Operation, copied into the queue
+ *
+ * @retval            LT_OK Operation was queued
+ * @retval            LT_FAIL Queue is full, it has to be flushed first
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_wake_batch_add(lt_wake_batch_t *q, const lt_wake_op_t *op);
+
+/**
+ * @brief Returns time until the queue has to be flushed, i.e. how long the MCU may sleep
+ *
+ * @param q           Queue
+ *
+ * @return            Time in ms until `max_delay_ms` of the first queued operation elapses, 0 when it already
+ * elapsed, UINT32_MAX when the queue is empty
+ */
+uint32_t lt_wake_batch_due_ms(const lt_wake_batch_t *q);
+
+/**
+ * @brief Executes all queued operations as one pipelined burst and empties the queue
+ * @details `status` of each operation is filled and its `done` is called after the burst, so the callbacks do not
+ * stretch it. When the burst breaks (e.g. by a lost session), the operations which were not executed report the
+ * error and the application may queue them again.
+ *
+ * @param h           Device's handle with a secure session
+ * @param q           Queue
+ *
+ * @retval            LT_OK The burst was executed, see `status` of each operation
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_wake_batch_flush(lt_handle_t *h, lt_wake_batch_t *q);
+
+/**
+ * @brief Flushes the queue and puts TROPIC01 to sleep, ending the wake window
+ * @details TROPIC01 is put to sleep also when the burst failed.
+ *
+ * @param h           Device's handle with a secure session
+ * @param q           Queue
+ * @param sleep_kind  Kind of sleep
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other The first error of the burst or of the sleep, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_wake_batch_sleep(lt_handle_t *h, lt_wake_batch_t *q, const uint8_t sleep_kind);
+#endif
+
+#if LT_DEADLINE
+/**
+ * @brief Sets absolute deadline of the following calls with the handle, see `lt_deadline_t`
+ * @details Calls which do not finish by the deadline return LT_DEADLINE_EXCEEDED, so the caller can give up on the
+ * chip promptly, e.g. to retry the request on another one. The deadline stays set until `lt_deadline_clear()`.
+ * @note A command interrupted after it was sent to TROPIC01 leaves its response unread, the next L3 command may then
+ * fail, so the application should re-establish the secure session after LT_DEADLINE_EXCEEDED.
+ *
+ * @param h           Device's handle with `h->l2.deadline` set
+ * @param at_us       Time of `h->l2.deadline->time_us` at which the deadline passes
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_deadline_set(lt_handle_t *h, const uint32_t at_us);
+
+/**
+ * @brief Clears deadline set by `lt_deadline_set()`, calls are limited only by the default timeouts again
+ *
+ * @param h           Device's handle with `h->l2.deadline` set
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_deadline_clear(lt_handle_t *h);
+#endif
+
+#if LT_USE_SPI_SPEED
+/**
+ * @brief Changes SPI clock by `lt_port_spi_speed_set()`
+ * @details With `h->l2.spi_tune` set, the auto-tuner continues from this clock and forgets the clock at which it
+ * saw too many CRC errors, so it can be called again e.g. after a change of wiring or temperature.
+ *
+ * @param h           Device's handle
+ * @param hz          Requested clock in Hz
+ * @param actual_hz   Clock actually used by the port, can be NULL
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_spi_speed_set(lt_handle_t *h, const uint32_t hz, uint32_t *actual_hz);
+#endif
+
+#if LT_TUNE_PERSIST
+/**
+ * @brief Exports the tuning profile of the handle, see `lt_tune_store_t`
+ * @details The profile is keyed by the serial number of the chip read by `lt_init()` and `h->tune_store->port_id`.
+ * It holds sections of the tuning features the library is compiled with, protected by CRC16.
+ *
+ * @param h           Device's handle, `h->tune_store` must be set
+ * @param buff        Buffer for the profile, LT_TUNE_EXPORT_SIZE_MAX bytes are always enough
+ * @param max_len     Length of the buffer
+ * @param len         Length of the profile
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_tune_export(lt_handle_t *h, uint8_t *buff, const uint16_t max_len, uint16_t *len);
+
+/**
+ * @brief Restores tuning of the handle from a profile made by `lt_tune_export()`
+ * @details Sections of features the library is not compiled with are skipped, features missing in the profile are
+ * left as they are. The SPI clock is set by the port right away.
+ *
+ * @param h           Device's handle, `h->tune_store` must be set
+ * @param buff        Profile
+ * @param len         Length of the profile
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_NOT_FOUND Profile is corrupted or belongs to another chip or port
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_tune_import(lt_handle_t *h, const uint8_t *buff, const uint16_t len);
+
+/**
+ * @brief Saves the tuning profile of the handle by `h->tune_store->save`, also done by `lt_deinit()`
+ *
+ * @param h           Device's handle, `h->tune_store` must be set
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_tune_save(lt_handle_t *h);
+#endif
+
+/**
+ * @brief Reboots TROPIC01
+ *
+ * Waits `LT_TROPIC01_REBOOT_DELAY_MS` for TROPIC01 to reboot. With LT_REBOOT_POLL, CHIP_STATUS is polled instead and
+ * the function returns as soon as TROPIC01 is ready in the requested mode, at most after
+ * `LT_TROPIC01_REBOOT_TIMEOUT_MS`.
+ *
+ * @param h           Device's handle
+ * @param startup_id  Startup ID
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_reboot(lt_handle_t *h, const uint8_t startup_id);
+
+#if LT_ENABLE_FW_UPDATE
+#ifdef ABAB
+/** @brief Maximal size of update data */
+#define LT_MUTABLE_FW_UPDATE_SIZE_MAX 25600
+/**
+ * @brief Erase mutable firmware in one of banks
+ *
+ * @param h           Device's handle
+ * @param bank_id     enum bank_id_t
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_mutable_fw_erase(lt_handle_t *h, const bank_id_t bank_id);
+
+/**
+ * @brief Update mutable firmware in one of banks
+ *
+ * @param h             Device's handle
+ * @param fw_data       Array with firmware bytes
+ * @param fw_data_size  Number of firmware's bytes in passed array
+ * @param bank_id       enum bank_id_t
+ * lt_ret_t             LT_OK            - SUCCESS
+ *                      other parameters - ERROR, for verbose output pass return value to function lt_ret_verbose()
+ */
+lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *fw_data, const uint16_t fw_data_size, bank_id_t bank_id);
+
+/**
+ * @brief Update mutable firmware in one of banks, reading the firmware chunk by chunk
+ * @details Each next chunk is read while TROPIC01 writes the previous one.
+ *
+ * @param h             Device's handle
+ * @param read          Callback reading firmware bytes
+ * @param ctx           Argument of `read`
+ * @param fw_data_size  Number of firmware's bytes
+ * @param bank_id       enum bank_id_t
+ * @return              LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_mutable_fw_update_stream(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx, const uint32_t fw_data_size,
+                                     bank_id_t bank_id);
+
+/**
+ * @brief Update mutable firmware in one of banks, starting from the chunk at `u->cursor`
+ * @details `u->cursor` and `u->chunks` are advanced whenever TROPIC01 acknowledges a chunk. The bank is not erased.
+ *
+ * @param h             Device's handle
+ * @param u             Update state
+ * @param bank_id       enum bank_id_t
+ * @return              LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_mutable_fw_update_resume(lt_handle_t *h, struct lt_fw_update_t *u, bank_id_t bank_id);
+
+#elif ACAB
+/** @brief Maximal size of update data */
+#define LT_MUTABLE_FW_UPDATE_SIZE_MAX 30720
+
+/**
+ * @brief Sends mutable firmware update L2 request to TROPIC01 with silicon revision ACAB
+ *
+ * @param h               Device's handle
+ * @param update_request  Array with firmware update request bytes
+ * @return                LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *update_request);
+
+/**
+ * @brief Sends mutable firmware update data to TROPIC01 with silicon revision ACAB. Function
+ * `lt_mutable_fw_update()` must be called first to start authenticated mutable fw update.
+ *
+ * @param h                 Device's handle
+ * @param update_data       Array with firmware update data bytes
+ * @param update_data_size  Size of update data
+ * @return                  LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_mutable_fw_update_data(lt_handle_t *h, const uint8_t *update_data, const uint16_t update_data_size);
+
+/**
+ * @brief Sends mutable firmware update data to TROPIC01 with silicon revision ACAB, reading them chunk by chunk
+ * @details Same as `lt_mutable_fw_update_data()`, but each next chunk is read by `read` while TROPIC01 writes the
+ * previous one.
+ *
+ * @param h                 Device's handle
+ * @param read              Callback reading bytes of the same update image as passed to `lt_mutable_fw_update_data()`
+ * @param ctx               Argument of `read`
+ * @param update_data_size  Size of update data
+ * @return                  LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_mutable_fw_update_data_stream(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx,
+                                          const uint32_t update_data_size);
+
+/**
+ * @brief Sends mutable firmware update data to TROPIC01 with silicon revision ACAB, starting from the chunk at
+ * `u->cursor`
+ * @details `u->cursor` and `u->chunks` are advanced whenever TROPIC01 acknowledges a chunk. `u->cursor` must point
+ * behind the update request, which was already sent by `lt_mutable_fw_update()`.
+ *
+ * @param h                 Device's handle
+ * @param u                 Update state
+ * @return                  LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_mutable_fw_update_data_resume(lt_handle_t *h, struct lt_fw_update_t *u);
+
+#endif
+#endif
+
+/**
+ * @brief Gets Log message of TROPIC01's RISC-V FW (if enabled/available).
+ * @note RISC-V FW logging can be disabled in the I/R-Config and for the production chips, it **will** be disabled. This
+ * function is used mainly for internal debugging and not expected to be used by the user.
+ *
+ * @param h            Device's handle
+ * @param log_msg      Buffer for the log message (atleast 255B)
+ * @param log_msg_len  Length of the log message
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_get_log_req(lt_handle_t *h, uint8_t *log_msg, uint16_t *log_msg_len);
+
+/**
+ * @brief A dummy command to check the Secure Channel Session communication by exchanging a message with TROPIC01, whish
+ * is echoed through the Secure Channel.
+ *
+ * @param h           Device's handle
+ * @param msg_out     Ping message going out
+ * @param msg_in      Ping message going in
+ * @param len         Length of both messages (msg_out and msg_in), `LT_PING_LEN_MAX` is the maximum
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ping(lt_handle_t *h, const uint8_t *msg_out, uint8_t *msg_in, const uint16_t len);
+
+/**
+ * @brief Same as lt_ping(), but the messages are in fragments, which are gathered directly into (and scattered
+ * directly from) the L3 buffer.
+ *
+ * @param h           Device's handle
+ * @param out         Fragments of the ping message going out
+ * @param out_cnt     Number of fragments in out
+ * @param in          Fragments for the ping message going in, total length has to be the same as of out
+ * @param in_cnt      Number of fragments in in
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ping_v(lt_handle_t *h, const lt_iovec_t *out, const uint8_t out_cnt, const lt_iovec_out_t *in,
+                   const uint8_t in_cnt);
+
+#if LT_L3_VIEWS
+/**
+ * @brief Same as lt_ping(), but the received message is not copied, only a view of it is returned.
+ * @details The view points into the decrypted L3 buffer of the handle, it is valid until the next command on the
+ * handle. With LT_L3_BUFF_POOL, the caller has to hold a buffer borrowed by `lt_l3_buff_borrow()` (the view is valid
+ * until it is released), otherwise LT_PARAM_ERR is returned.
+ *
+ * @param h           Device's handle
+ * @param msg_out     Ping message going out
+ * @param len         Length of both messages, `LT_PING_LEN_MAX` is the maximum
+ * @param msg_in      Set to the ping message going in, NULL on error
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ping_view(lt_handle_t *h, const uint8_t *msg_out, const uint16_t len, const uint8_t **msg_in);
+#endif
+
+#if LT_RAW_CMD
+/**
+ * @brief Executes L3 command given as plaintext bytes through the Secure Channel Session
+ * @details Meant for forwarding commands built elsewhere, e.g. by clients of a daemon which owns the session. The
+ * command is not checked by libtropic, the caller is responsible for letting through only the commands it allows.
+ *
+ * @param h           Device's handle
+ * @param cmd         Command ID followed by the command's data
+ * @param cmd_len     Length of `cmd`, at most L3_CYPHERTEXT_MAX_SIZE
+ * @param res         Buffer to receive RESULT byte followed by the result's data, filled only on LT_OK
+ * @param res_max_len Size of `res`
+ * @param res_len     Length of the received result
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value, RESULT other than OK is returned as the matching LT_L3_* value
+ */
+lt_ret_t lt_raw_cmd(lt_handle_t *h, const uint8_t *cmd, const uint16_t cmd_len, uint8_t *res,
+                    const uint16_t res_max_len, uint16_t *res_len);
+#endif
+
+/**
+ * @brief Writes pairing public key into TROPIC01's pairing key slot 0-3
+ *
+ * @param h           Device's handle
+ * @param pairing_pub 32B of pubkey
+ * @param slot        Pairing key lot SH0PUB - SH3PUB
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_pairing_key_write(lt_handle_t *h, const uint8_t *pairing_pub, const uint8_t slot);
+
+/**
+ * @brief Reads pairing public key from TROPIC01's pairing key slot 0-3
+ *
+ * @param h           Device's handle
+ * @param pairing_pub 32B of pubkey
+ * @param slot        Pairing key lot SH0PUB - SH3PUB
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_pairing_key_read(lt_handle_t *h, uint8_t *pairing_pub, const uint8_t slot);
+
+/**
+ * @brief Invalidates pairing key in slot 0-3
+ *
+ * @param h           Device's handle
+ * @param slot        Pairing key lot SH0PUB - SH3PUB
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_pairing_key_invalidate(lt_handle_t *h, const uint8_t slot);
+
+/**
+ * @brief Executes a plan of pairing key writes, reads and invalidations, commands are pipelined
+ * @details Commands are executed in the given order, e.g. keys are read back after they are written, and the slot
+ * of the current secure session is usually invalidated the last. Failure of one command (e.g. LT_L3_FAIL of a write
+ * into a written slot, LT_L3_PAIRING_KEY_EMPTY of a read) is stored into its `status` and the other commands are
+ * still executed.
+ *
+ * @param h           Device's handle
+ * @param ops         Commands, `status` of each one is filled
+ * @param cnt         Number of commands
+ *
+ * @retval            LT_OK All commands were executed, see `status` of each one
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_pairing_key_batch(lt_handle_t *h, lt_pairing_key_op_t *ops, const uint8_t cnt);
+
+/**
+ * @brief Writes configuration object specified by `addr`
+ *
+ * @param h           Device's handle
+ * @param addr        Address of a config object
+ * @param obj         Content to be written
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_config_write(lt_handle_t *h, enum CONFIGURATION_OBJECTS_REGS addr, const uint32_t obj);
+
+/**
+ * @brief Reads configuration object specified by `addr`
+ * @note With LT_CONFIG_CACHE the object is taken from `h->config_cache` when R-Config was read whole.
+ *
+ * @param h           Device's handle
+ * @param addr        Address of a config object
+ * @param obj         Variable to read content into
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ *
+ */
+lt_ret_t lt_r_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj);
+
+/**
+ * @brief Erases all configuration objects
+ *
+ * @param h           Device's handle
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_config_erase(lt_handle_t *h);
+
+/**
+ * @brief Writes configuration object specified by `addr` to I-Config
+ *
+ * @param h           Device's handle
+ * @param addr        Address of a config object
+ * @param bit_index   Index of bit to write from 1 to 0
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_i_config_write(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, const uint8_t bit_index);
+
+/**
+ * @brief Reads configuration object specified by `addr` from I-Config
+ * @note With LT_CONFIG_CACHE the object is taken from `h->config_cache` when I-Config was read whole.
+ *
+ * @param h           Device's handle
+ * @param addr        Address of a config object
+ * @param obj         Variable to read content into
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_i_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj);
+
+#if LT_ENABLE_R_MEM
+/**
+ * @brief Writes bytes into a given slot of the User Partition in the R memory
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be written
+ * @param data        Buffer of data to be written into R MEMORY slot
+ * @param size        Size of data to be written (valid range given by macros `R_MEM_DATA_SIZE_MIN` and
+ * `R_MEM_DATA_SIZE_MAX`)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size);
+
+/**
+ * @brief Same as lt_r_mem_data_write(), but the data are gathered from fragments directly into the L3 buffer.
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be written
+ * @param iov         Fragments of data, total length has to be within `R_MEM_DATA_SIZE_MIN` and `R_MEM_DATA_SIZE_MAX`
+ * @param iov_cnt     Number of fragments
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_write_v(lt_handle_t *h, const uint16_t udata_slot, const lt_iovec_t *iov,
+                               const uint8_t iov_cnt);
+
+/**
+ * @brief Reads bytes from a given slot of the User Partition in the R memory
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be read
+ * @param data        Buffer to read data into
+ * @param size        Number of bytes read into data
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size);
+
+/**
+ * @brief Same as lt_r_mem_data_read(), but the data are scattered from the L3 buffer directly into fragments.
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be read
+ * @param iov         Fragments to read data into, filled one after another
+ * @param iov_cnt     Number of fragments
+ * @param size        Number of bytes read, set also when the fragments are too short and LT_PARAM_ERR is returned
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_read_v(lt_handle_t *h, const uint16_t udata_slot, const lt_iovec_out_t *iov,
+                              const uint8_t iov_cnt, uint16_t *size);
+
+#if LT_L3_VIEWS
+/**
+ * @brief Same as lt_r_mem_data_read(), but the data are not copied, only a view of them is returned.
+ * @details The view points into the decrypted L3 buffer of the handle, it is valid until the next command on the
+ * handle. With LT_L3_BUFF_POOL, the caller has to hold a buffer borrowed by `lt_l3_buff_borrow()` (the view is valid
+ * until it is released), otherwise LT_PARAM_ERR is returned.
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be read
+ * @param data        Set to the read data, NULL on error
+ * @param size        Number of bytes read
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_read_view(lt_handle_t *h, const uint16_t udata_slot, const uint8_t **data, uint16_t *size);
+#endif
+
+/**
+ * @brief Erases the given slot of the User Partition in the R memory
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be erased
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot);
+
+/**
+ * @brief Reads consecutive slots of User Data partition in R-Memory by pipelined commands
+ * @details Empty slot or other failure reported by TROPIC01 for one slot does not stop reading of the others, it is
+ * reported in `statuses`. Each command is encrypted while TROPIC01 executes the previous one.
+ *
+ * @param h           Device's handle
+ * @param first_slot  First slot to read
+ * @param slots_cnt   Number of slots to read
+ * @param data        Buffer for `slots_cnt` * R_MEM_DATA_SIZE_MAX bytes, data of i-th slot start at
+ *                    i * R_MEM_DATA_SIZE_MAX
+ * @param sizes       Sizes of data read from slots, 0 for empty slot
+ * @param statuses    Status of each slot, e.g. LT_OK or LT_L3_R_MEM_DATA_READ_SLOT_EMPTY
+ *
+ * @retval            LT_OK All slots were processed, see `statuses`
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_read_range(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt, uint8_t *data,
+                                  uint16_t *sizes, lt_ret_t *statuses);
+
+/**
+ * @brief Writes consecutive slots of User Data partition in R-Memory by pipelined commands
+ * @details Failure reported by TROPIC01 for one slot (e.g. slot is not empty) does not stop writing of the others, it
+ * is reported in `statuses`.
+ *
+ * @param h           Device's handle
+ * @param first_slot  First slot to write
+ * @param slots_cnt   Number of slots to write
+ * @param data        Data of i-th slot start at i * R_MEM_DATA_SIZE_MAX
+ * @param sizes       Sizes of data of slots, R_MEM_DATA_SIZE_MIN to R_MEM_DATA_SIZE_MAX
+ * @param statuses    Status of each slot, e.g. LT_OK or LT_L3_R_MEM_DATA_WRITE_WRITE_FAIL
+ *
+ * @retval            LT_OK All slots were processed, see `statuses`
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_write_range(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt,
+                                   const uint8_t *data, const uint16_t *sizes, lt_ret_t *statuses);
+
+/**
+ * @brief Erases consecutive slots of User Data partition in R-Memory by pipelined commands
+ *
+ * @param h           Device's handle
+ * @param first_slot  First slot to erase
+ * @param slots_cnt   Number of slots to erase
+ * @param statuses    Status of each slot
+ *
+ * @retval            LT_OK All slots were processed, see `statuses`
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_r_mem_data_erase_range(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt,
+                                   lt_ret_t *statuses);
+
+#if LT_RMEM_CACHE
+/**
+ * @brief Reads slot of User Data partition in R-Memory through `h->rmem_cache`
+ * @details TROPIC01 is read only when the slot is not cached. Pending write of the slot is returned.
+ *
+ * @param h           Device's handle, `h->rmem_cache` must be set
+ * @param udata_slot  Memory's slot to be read
+ * @param data        Buffer for R_MEM_DATA_SIZE_MAX bytes
+ * @param size        Number of bytes read
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_L3_R_MEM_DATA_READ_SLOT_EMPTY Slot is empty
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_cache_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size);
+
+/**
+ * @brief Replaces content of slot of User Data partition in R-Memory through `h->rmem_cache`
+ * @details Content is only stored in the cache, it is written into TROPIC01 by `lt_rmem_cache_flush()` or when the
+ * slot is evicted, so several writes of one slot cost one erase and one write. Writing unchanged content costs
+ * nothing, or one read when the slot is not cached.
+ *
+ * @param h           Device's handle, `h->rmem_cache` must be set
+ * @param udata_slot  Memory's slot to be written
+ * @param data        Data to be written
+ * @param size        Size of data, R_MEM_DATA_SIZE_MIN to R_MEM_DATA_SIZE_MAX
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_cache_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size);
+
+/**
+ * @brief Writes all pending writes of `h->rmem_cache` into TROPIC01
+ *
+ * @param h           Device's handle, `h->rmem_cache` must be set
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_cache_flush(lt_handle_t *h);
+
+/**
+ * @brief Drops all slots cached in `h->rmem_cache`, pending writes are discarded
+ * @note Call it when the handle is about to be connected to a different chip.
+ *
+ * @param h           Device's handle
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_cache_invalidate(lt_handle_t *h);
+#endif
+#endif
+
+#if LT_L3_BUFF_POOL
+/**
+ * @brief Initializes pool of L3 buffers shared by handles, which reference it by `lt_handle_t.l3_pool`.
+ * @details Handles must be set up before their `lt_init()`. Set `lock` and `unlock` of the pool after this call when
+ * the handles are used by several threads.
+ *
+ * @param pool        Pool
+ * @param buffs       `cnt` buffers of `buff_size` bytes in one array
+ * @param buff_size   Size of one buffer, `LT_L3_BUFF_SIZE_MIN` to `L3_PACKET_MAX_SIZE`, typically `LT_SIZE_OF_L3_BUFF`
+ * @param cnt         Number of buffers, 1 to `LT_L3_BUFF_POOL_MAX`
+ * @param wait_ms     How long a command waits for a free buffer before it fails with LT_BUSY
+ *
+ * @retval            LT_OK Pool was initialized
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_l3_buff_pool_init(lt_l3_buff_pool_t *pool, uint8_t *buffs, const uint16_t buff_size, const uint8_t cnt,
+                              const uint32_t wait_ms);
+
+/**
+ * @brief Borrows L3 buffer from `h->l3_pool` into `h->l3.buff`.
+ * @details API functions borrow the buffer by themselves. This function is needed only with the separate API
+ * (`lt_out__*()`, `lt_in__*()`), around the command and its result.
+ *
+ * @param h           Device's handle
+ *
+ * @retval            LT_OK Buffer was borrowed, or it had been borrowed already
+ * @retval            LT_BUSY No buffer was free within `wait_ms`
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_l3_buff_borrow(lt_handle_t *h);
+
+/**
+ * @brief Wipes the buffer borrowed by `lt_l3_buff_borrow()` and returns it to the pool.
+ *
+ * @param h           Device's handle
+ *
+ * @retval            LT_OK Buffer was returned
+ * @retval            LT_PARAM_ERR No buffer is borrowed
+ */
+lt_ret_t lt_l3_buff_release(lt_handle_t *h);
+
+/**
+ * @brief Reads statistics of the pool.
+ *
+ * @param pool        Pool
+ * @param stats       Statistics
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_l3_buff_pool_stats_get(lt_l3_buff_pool_t *pool, lt_l3_buff_pool_stats_t *stats);
+#endif
+
+/**
+ * @brief Gets random bytes from TROPIC01's Random Number Generator.
+ *
+ * @param h           Device's handle
+ * @param buff        Buffer
+ * @param len         Number of random bytes (255 bytes is the maximum)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len);
+
+#if LT_L3_VIEWS
+/**
+ * @brief Same as lt_random_value_get(), but the random bytes are not copied, only a view of them is returned.
+ * @details The view points into the decrypted L3 buffer of the handle, it is valid until the next command on the
+ * handle. With LT_L3_BUFF_POOL, the caller has to hold a buffer borrowed by `lt_l3_buff_borrow()` (the view is valid
+ * until it is released), otherwise LT_PARAM_ERR is returned.
+ *
+ * @param h           Device's handle
+ * @param len         Number of random bytes (255 bytes is the maximum)
+ * @param buff        Set to the random bytes, NULL on error
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_random_value_get_view(lt_handle_t *h, const uint16_t len, const uint8_t **buff);
+#endif
+
+/**
+ * @brief Gets any number of random bytes from TROPIC01's Random Number Generator.
+ * @details Bytes are requested by as many commands as needed (255 bytes each). Each command is encrypted while
+ * TROPIC01 executes the previous one, as with `lt_ecc_ecdsa_sign_batch()`.
+ *
+ * @param h           Device's handle
+ * @param buff        Buffer
+ * @param len         Number of random bytes
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_random_value_get_large(lt_handle_t *h, uint8_t *buff, const uint32_t len);
+
+#if LT_HOST_DRBG
+/** @brief Maximal number of bytes returned by one `lt_drbg_random_get()` */
+#define LT_DRBG_REQUEST_LEN_MAX 65535
+
+/**
+ * @brief Instantiates host DRBG with entropy input and nonce from TROPIC01's Random Number Generator
+ * @note The DRBG is not protected by any lock, each thread should use its own.
+ *
+ * @param h                     Device's handle, used for every reseed of the DRBG
+ * @param drbg                  DRBG state
+ * @param reseed_interval       Number of requests after which the DRBG is reseeded, at least 1
+ * @param prediction_resistance Reseed before each request, so every output depends on fresh entropy from TROPIC01
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_drbg_init(lt_handle_t *h, lt_drbg_t *drbg, const uint32_t reseed_interval,
+                      const bool prediction_resistance);
+
+/**
+ * @brief Reseeds host DRBG with entropy input from TROPIC01's Random Number Generator
+ *
+ * @param h           Device's handle
+ * @param drbg        DRBG instantiated by `lt_drbg_init()`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_drbg_reseed(lt_handle_t *h, lt_drbg_t *drbg);
+
+/**
+ * @brief Gets random bytes from host DRBG, TROPIC01 is used only when the DRBG has to be reseeded
+ *
+ * @param h           Device's handle
+ * @param drbg        DRBG instantiated by `lt_drbg_init()`
+ * @param buff        Buffer
+ * @param len         Number of random bytes, at most LT_DRBG_REQUEST_LEN_MAX
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_drbg_random_get(lt_handle_t *h, lt_drbg_t *drbg, uint8_t *buff, const uint32_t len);
+
+/**
+ * @brief Wipes state of host DRBG
+ *
+ * @param drbg        DRBG state
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_drbg_deinit(lt_drbg_t *drbg);
+#endif
+
+/**
+ * @brief Generates ECC key in the specified ECC key slot
+ *
+ * @param h           Device's handle
+ * @param slot        Slot number ecc_slot_t
+ * @param curve       Type of ECC curve. Use L3_ECC_KEY_GENERATE_CURVE_ED25519 or L3_ECC_KEY_GENERATE_CURVE_P256
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_generate(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve);
 
 /**
  * @brief Stores ECC key to the specified ECC key slot
  *
  * @param h           Device's handle
- * @param slot        Slot number ecc_slot_t
- * @param curve       Type of ECC curve. Use L3_ECC_KEY_GENERATE_CURVE_ED25519 or L3_ECC_KEY_GENERATE_CURVE_P256
- * @param key         Key to store (only the first 32 bytes are stored)
+ * @param slot        Slot number ecc_slot_t
+ * @param curve       Type of ECC curve. Use L3_ECC_KEY_GENERATE_CURVE_ED25519 or L3_ECC_KEY_GENERATE_CURVE_P256
+ * @param key         Key to store (only the first 32 bytes are stored)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_store(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve, const uint8_t *key);
+
+/**
+ * @brief Reads ECC public key corresponding to a private key in the specified ECC key slot.
+ * @note With LT_ECC_KEY_CACHE the key is taken from `h->key_cache` when it was already read.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot number ECC_SLOT_0 - ECC_SLOT_31
+ * @param key         Buffer for retrieving a key; length depends on the type of key in the slot (32B for Ed25519, 64B
+ * for P256), according to *curve*
+ * @param curve       Will be filled by curve byte
+ * @param origin      Will be filled by origin byte
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_read(lt_handle_t *h, const ecc_slot_t ecc_slot, uint8_t *key, lt_ecc_curve_type_t *curve,
+                         ecc_key_origin_t *origin);
+
+/**
+ * @brief Reads all ECC key slots, commands are pipelined
+ * @details Empty slot is reported by LT_L3_ECC_INVALID_KEY in its `status` and the other slots are still read.
+ * With LT_ECC_KEY_CACHE, slots already cached in `h->key_cache` are not read again and the slots read are cached.
+ *
+ * @param h           Device's handle
+ * @param slots       Content of the slots, ECC_SLOT_31 + 1 items indexed by `ecc_slot_t`
+ *
+ * @retval            LT_OK All slots were read, see `status` of each slot
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_inventory(lt_handle_t *h, lt_ecc_key_info_t *slots);
+
+/**
+ * @brief Stores several ECC keys and reads their slots back, commands are pipelined
+ * @details Each slot is read back after all keys were stored. The store is confirmed when the slot holds a key of the
+ * given curve with origin CURVE_STORED, its public key is then returned in `pubkey`. Failure of one key (e.g.
+ * LT_L3_FAIL of a store into a slot holding a key) is stored into its `status` and the other keys are still stored.
+ * Private keys in `keys` are wiped when the function returns, also on failure.
+ *
+ * @param h           Device's handle
+ * @param keys        Keys to be stored into distinct slots, `pubkey` and `status` of each one are filled
+ * @param cnt         Number of keys, at most ECC_SLOT_31 + 1
+ *
+ * @retval            LT_OK All keys were processed, see `status` of each one
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_store_batch(lt_handle_t *h, lt_ecc_key_import_t *keys, const uint8_t cnt);
+
+#if LT_ECC_KEY_CACHE
+/**
+ * @brief Invalidates public keys cached in `h->key_cache`, so they are read from TROPIC01 again
+ * @note Call it when the handle is about to be connected to a different chip, or when the keys were changed
+ * through a different handle.
+ *
+ * @param h           Device's handle
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_cache_invalidate(lt_handle_t *h);
+#endif
+
+/**
+ * @brief Erases ECC key from the specified ECC key slot
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot number ECC_SLOT_0 - ECC_SLOT_31
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_erase(lt_handle_t *h, const ecc_slot_t ecc_slot);
+
+/**
+ * @brief Performs ECDSA sign of a message with a private ECC key stored in TROPIC01
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msg         Buffer containing a message
+ * @param msg_len     Length of msg's buffer
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_ecdsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint32_t msg_len,
+                           uint8_t *rs);
+
+/**
+ * @brief Same as lt_ecc_ecdsa_sign(), but the message is in fragments, which are hashed where they are.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param iov         Fragments of the message
+ * @param iov_cnt     Number of fragments
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_ecdsa_sign_v(lt_handle_t *h, const ecc_slot_t ecc_slot, const lt_iovec_t *iov, const uint8_t iov_cnt,
+                             uint8_t *rs);
+
+/**
+ * @brief Performs ECDSA sign of a message hash with a private ECC key stored in TROPIC01
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msg_hash    SHA256 hash of a message (32B)
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_ecdsa_sign_digest(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg_hash, uint8_t *rs);
+
+/**
+ * @brief Starts ECDSA sign of a message which is supplied in parts by `lt_ecdsa_sign_update()`
+ *
+ * @param ctx         Signing context
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_ecdsa_sign_init(lt_ecdsa_sign_ctx_t *ctx);
+
+/**
+ * @brief Adds part of a message to ECDSA sign started by `lt_ecdsa_sign_init()`
+ *
+ * @param ctx         Signing context
+ * @param data        Part of a message
+ * @param len         Length of data
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_ecdsa_sign_update(lt_ecdsa_sign_ctx_t *ctx, const uint8_t *data, const uint32_t len);
+
+/**
+ * @brief Signs a message supplied by `lt_ecdsa_sign_update()` with a private ECC key stored in TROPIC01
+ * @note Context is wiped and must be initialized again by `lt_ecdsa_sign_init()` before next use.
+ *
+ * @param h           Device's handle
+ * @param ctx         Signing context
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecdsa_sign_final(lt_handle_t *h, lt_ecdsa_sign_ctx_t *ctx, const ecc_slot_t ecc_slot, uint8_t *rs);
+
+/**
+ * @brief Verifies ECDSA signature. Host side only, does not require TROPIC01.
+ *
+ * @param msg         Message
+ * @param msg_len     Length of message
+ * @param pubkey      Public key related to private key which signed the message (64B)
+ * @param rs          Signature to be verified, in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ *
+ */
+lt_ret_t lt_ecc_ecdsa_sig_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs);
+
+/**
+ * @brief Verifies several ECDSA signatures made by one key. Host side only, does not require TROPIC01.
+ * @note The function does not use any shared state, so a large batch can be split between threads.
+ *
+ * @param msgs        Messages
+ * @param msg_lens    Lengths of messages
+ * @param pubkey      Public key related to private key which signed the messages (64B)
+ * @param sigs        Signatures to be verified, in a form of R and S bytes, n * 64B
+ * @param n           Number of signatures
+ * @param valid       Set to 1 for each valid signature and to 0 for invalid one, can be NULL
+ *
+ * @retval            LT_OK All signatures are valid
+ * @retval            LT_FAIL Some signature is not valid, see `valid`
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_ecc_ecdsa_sig_verify_batch(const uint8_t *const *msgs, const uint32_t *msg_lens, const uint8_t *pubkey,
+                                       const uint8_t *sigs, const uint16_t n, uint8_t *valid);
+
+#if LT_PREPARED_KEYS
+/**
+ * @brief Prepares public key for `lt_ecc_ecdsa_sig_verify_prepared()`. Host side only, does not require TROPIC01.
+ * @details The key is decoded and validated once and a table of its multiples is computed (tens of ms), each
+ * verification then multiplies the key by the same fixed-base method as the generator.
+ *
+ * @param key         Prepared key
+ * @param pubkey      Public key (64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_FAIL Public key is not valid
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_ecc_ecdsa_key_prepare(lt_ecdsa_prepared_key_t *key, const uint8_t *pubkey);
+
+/**
+ * @brief Same as `lt_ecc_ecdsa_sig_verify()`, with the key prepared by `lt_ecc_ecdsa_key_prepare()`
+ * @note Prepared key is only read, so it can be shared by threads.
+ *
+ * @param key         Prepared key
+ * @param msg         Message
+ * @param msg_len     Length of message
+ * @param rs          Signature to be verified, in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Signature is valid
+ * @retval            LT_FAIL Signature is not valid
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_ecc_ecdsa_sig_verify_prepared(const lt_ecdsa_prepared_key_t *key, const uint8_t *msg,
+                                          const uint32_t msg_len, const uint8_t *rs);
+#endif
+
+/**
+ * @brief Performs EdDSA sign of a message with a private ECC key stored in TROPIC01
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msg         Buffer containing a message to sign, max length is `LT_EDDSA_MSG_LEN_MAX` (4096B by default)
+ * @param msg_len     Length of a message
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint16_t msg_len,
+                           uint8_t *rs);
+
+/**
+ * @brief Same as lt_ecc_eddsa_sign(), but the message is gathered from fragments directly into the L3 buffer.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param iov         Fragments of the message, total length is at most `LT_EDDSA_MSG_LEN_MAX`
+ * @param iov_cnt     Number of fragments
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_eddsa_sign_v(lt_handle_t *h, const ecc_slot_t ecc_slot, const lt_iovec_t *iov, const uint8_t iov_cnt,
+                             uint8_t *rs);
+
+/**
+ * @brief Performs ECDSA sign of several message hashes with one private ECC key stored in TROPIC01
+ *
+ * Each next command is encrypted while TROPIC01 executes the previous one, when it fits into L3 buffer together
+ * with the result. Signing stops at the first failure, signatures of the previous hashes are valid.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param digests     SHA256 hashes of messages, n * 32B
+ * @param n           Number of hashes
+ * @param sigs        Buffer for storing signatures in a form of R and S bytes, n * 64B
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_ecdsa_sign_batch(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *digests, const uint16_t n,
+                                 uint8_t *sigs);
+
+/**
+ * @brief Performs ECDSA sign of several messages with one private ECC key stored in TROPIC01
+ *
+ * Same as `lt_ecc_ecdsa_sign_batch()`, the messages are hashed on the host by groups of LT_SHA256_MULTI_LANES in
+ * parallel (multi-buffer SHA256, see LT_SHA256_MULTI CMake option) just before their commands are encrypted.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msgs        Messages to sign
+ * @param msg_lens    Lengths of messages
+ * @param n           Number of messages
+ * @param sigs        Buffer for storing signatures in a form of R and S bytes, n * 64B
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_ecdsa_sign_msg_batch(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *const *msgs,
+                                     const uint32_t *msg_lens, const uint16_t n, uint8_t *sigs);
+
+/**
+ * @brief Performs EdDSA sign of several messages with one private ECC key stored in TROPIC01
+ *
+ * Each next command is encrypted while TROPIC01 executes the previous one, when it fits into L3 buffer together
+ * with the result. Signing stops at the first failure, signatures of the previous messages are valid.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msgs        Messages to sign
+ * @param msg_lens    Lengths of messages
+ * @param n           Number of messages
+ * @param sigs        Buffer for storing signatures in a form of R and S bytes, n * 64B
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_eddsa_sign_batch(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *const *msgs,
+                                 const uint16_t *msg_lens, const uint16_t n, uint8_t *sigs);
+
+/**
+ * @brief Verifies EdDSA signature. Host side only, does not require TROPIC01.
+ *
+ * @param msg         Message
+ * @param msg_len     Length of message. Max length is 4095
+ * @param pubkey      Public key related to private key which signed the message (32B)
+ * @param rs          Signature to be verified, in a form of R and S bytes (should always have length 64B)
+ * lt_ret_t           LT_OK          - success
+ *                    LT_PARAM_ERROR - wrong parameters were passed
+ *                    LT_FAIL        - signature verify failed
+ */
+lt_ret_t lt_ecc_eddsa_sig_verify(const uint8_t *msg, const uint16_t msg_len, const uint8_t *pubkey, const uint8_t *rs);
+
+/**
+ * @brief Verifies several EdDSA signatures made by one key, which is decompressed only once. Host side only, does
+ * not require TROPIC01.
+ * @note The function does not use any shared state, so a large batch can be split between threads.
+ *
+ * @param msgs        Messages
+ * @param msg_lens    Lengths of messages. Max length is 4095
+ * @param pubkey      Public key related to private key which signed the messages (32B)
+ * @param sigs        Signatures to be verified, in a form of R and S bytes, n * 64B
+ * @param n           Number of signatures
+ * @param valid       Set to 1 for each valid signature and to 0 for invalid one, can be NULL
+ *
+ * @retval            LT_OK All signatures are valid
+ * @retval            LT_FAIL Some signature is not valid, see `valid`
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_ecc_eddsa_sig_verify_batch(const uint8_t *const *msgs, const uint16_t *msg_lens, const uint8_t *pubkey,
+                                       const uint8_t *sigs, const uint16_t n, uint8_t *valid);
+
+#if LT_PREPARED_KEYS
+/**
+ * @brief Prepares public key for `lt_ecc_eddsa_sig_verify_prepared()`. Host side only, does not require TROPIC01.
+ * @details The key is decompressed once and a table of its multiples is computed.
+ *
+ * @param key         Prepared key
+ * @param pubkey      Public key (32B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_FAIL Public key is not valid
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_ecc_eddsa_key_prepare(lt_eddsa_prepared_key_t *key, const uint8_t *pubkey);
+
+/**
+ * @brief Same as `lt_ecc_eddsa_sig_verify()`, with the key prepared by `lt_ecc_eddsa_key_prepare()`
+ * @note Prepared key is only read, so it can be shared by threads.
+ *
+ * @param key         Prepared key
+ * @param msg         Message
+ * @param msg_len     Length of message
+ * @param rs          Signature to be verified, in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Signature is valid
+ * @retval            LT_FAIL Signature is not valid
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_ecc_eddsa_sig_verify_prepared(const lt_eddsa_prepared_key_t *key, const uint8_t *msg,
+                                          const uint16_t msg_len, const uint8_t *rs);
+#endif
+
+#if LT_SIG_CHECK
+/** @brief Number of signatures waiting for verification in `lt_sig_check_t` */
+#ifndef LT_SIG_CHECK_DEPTH
+#define LT_SIG_CHECK_DEPTH 4
+#endif
+
+struct lt_sig_check_t;
+
+/**
+ * @brief Called when a signature made by `lt_ecc_ecdsa_sign_checked()` or `lt_ecc_eddsa_sign_checked()` was checked
+ * @details Only then the signature may be released. `ret` is LT_OK for a valid signature and LT_FAIL for an invalid
+ * one, which must be discarded. A signature skipped by sampling has `checked` false and `ret` LT_OK.
+ */
+typedef void (*lt_sig_check_cb_t)(struct lt_sig_check_t *chk, const uint8_t *msg, const uint8_t *rs,
+                                  const bool checked, const lt_ret_t ret, void *ctx);
+
+/** @private @brief Signature waiting for verification */
+typedef struct lt_sig_check_entry_t {
+    const void *key;
+    const uint8_t *msg;
+    const uint8_t *rs;
+    uint32_t msg_len;
+    bool eddsa;
+    bool checked;
+} lt_sig_check_entry_t;
+
+/**
+ * @brief Queue of signatures made by TROPIC01 and verified on the host by a worker thread, initialized by
+ * `lt_sig_check_init()`
+ *
+ * One thread signs by `lt_ecc_ecdsa_sign_checked()` or `lt_ecc_eddsa_sign_checked()`, which queue the signatures.
+ * One worker thread verifies them by `lt_sig_check_work()` while TROPIC01 computes the next ones, so the check
+ * adds almost no latency. When the queue is full, the signing thread verifies the signature itself.
+ */
+typedef struct lt_sig_check_t {
+    /** @public @brief Each signature is verified with probability 1/`sample`, 0 or 1 verifies all of them */
+    uint16_t sample;
+    /** @public @brief Called after each checked signature, by the thread which checked it */
+    lt_sig_check_cb_t cb;
+    /** @public @brief Context passed to `cb` */
+    void *ctx;
+    /** @public @brief Number of valid signatures, read only */
+    uint32_t valid;
+    /** @public @brief Number of invalid signatures, read only */
+    uint32_t invalid;
+    /** @public @brief Number of signatures skipped by sampling, read only */
+    uint32_t skipped;
+    /** @public @brief Number of signatures verified by the signing thread because the queue was full, read only */
+    uint32_t full;
+    /** @private @brief Queued signatures */
+    lt_sig_check_entry_t entries[LT_SIG_CHECK_DEPTH];
+    /** @private @brief Number of signatures queued, written by the signing thread */
+    uint32_t head;
+    /** @private @brief Number of signatures checked by the worker, written by the worker */
+    uint32_t tail;
+} lt_sig_check_t;
+
+/**
+ * @brief Initializes queue of signatures checked by a worker thread
+ *
+ * @param chk         Queue
+ * @param sample      Each signature is verified with probability 1/`sample`, 0 or 1 verifies all of them
+ * @param cb          Called after each checked signature
+ * @param ctx         Context passed to `cb`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_sig_check_init(lt_sig_check_t *chk, const uint16_t sample, lt_sig_check_cb_t cb, void *ctx);
+
+/**
+ * @brief Same as `lt_ecc_ecdsa_sign()`, the signature is then queued for verification by `key`
+ * @details Whether the signature is verified is chosen randomly by `lt_port_random_bytes()` when `chk->sample` is
+ * greater than 1, so a fault cannot be timed to a signature which is not checked.
+ * @note `msg` and `rs` must stay valid until `chk->cb` is called for them. The signature must not be released
+ * before, nor when the function fails.
+ *
+ * @param h           Device's handle
+ * @param chk         Queue, the function must not be called by several threads for one queue
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param key         Public key of the slot prepared by `lt_ecc_ecdsa_key_prepare()`
+ * @param msg         Buffer containing a message
+ * @param msg_len     Length of msg's buffer
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_ecdsa_sign_checked(lt_handle_t *h, lt_sig_check_t *chk, const ecc_slot_t ecc_slot,
+                                   const lt_ecdsa_prepared_key_t *key, const uint8_t *msg, const uint32_t msg_len,
+                                   uint8_t *rs);
+
+/**
+ * @brief Same as `lt_ecc_eddsa_sign()`, the signature is then queued for verification by `key`
+ * @details See `lt_ecc_ecdsa_sign_checked()`.
+ *
+ * @param h           Device's handle
+ * @param chk         Queue, the function must not be called by several threads for one queue
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param key         Public key of the slot prepared by `lt_ecc_eddsa_key_prepare()`
+ * @param msg         Buffer containing a message to sign, max length is 4096B
+ * @param msg_len     Length of a message to sign
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_eddsa_sign_checked(lt_handle_t *h, lt_sig_check_t *chk, const ecc_slot_t ecc_slot,
+                                   const lt_eddsa_prepared_key_t *key, const uint8_t *msg, const uint16_t msg_len,
+                                   uint8_t *rs);
+
+/**
+ * @brief Verifies all queued signatures and calls `chk->cb` for each of them, in the order they were made
+ * @note Called repeatedly by the worker thread, which may wait a while when it returns. Only one thread may call it
+ * for one queue.
+ *
+ * @param chk         Queue
+ *
+ * @retval            LT_OK The queue is empty
+ * @retval            LT_PARAM_ERR Wrong parameters were passed
+ */
+lt_ret_t lt_sig_check_work(lt_sig_check_t *chk);
+
+/**
+ * @brief Returns number of signatures not checked yet, e.g. to wait for all of them before shutdown
+ *
+ * @param chk         Queue
+ *
+ * @return            Number of queued signatures
+ */
+uint32_t lt_sig_check_pending(lt_sig_check_t *chk);
+#endif
+
+#if LT_ENABLE_MCOUNTER
+/**
+ * @brief Initializes monotonic counter of a given index
+ *
+ * @param h               Device's handle
+ * @param mcounter_index  Index of monotonic counter
+ * @param mcounter_value  Value to set as an initial value (allowed range is 0-MCOUNTER_VALUE_MAX)
+ *
+ * @retval                LT_OK Function executed successfully
+ * @retval                other Function did not execute successully, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_mcounter_init(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, const uint32_t mcounter_value);
+
+/**
+ * @brief Updates monotonic counter of a given index
+ *
+ * @param h               Device's handle
+ * @param mcounter_index  Index of monotonic counter
+ *
+ * @retval                LT_OK Function executed successfully
+ * @retval                other Function did not execute successully, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_mcounter_update(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index);
+
+/**
+ * @brief Gets a value of a monotonic counter of a given index
+ *
+ * @param h               Device's handle
+ * @param mcounter_index  Index of monotonic counter
+ * @param mcounter_value  Value of monotonic counter (from range 0-MCOUNTER_VALUE_MAX)
+ *
+ * @retval                LT_OK Function executed successfully
+ * @retval                other Function did not execute successully, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_mcounter_get(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, uint32_t *mcounter_value);
+
+/**
+ * @brief Gets values of all 16 monotonic counters, commands are pipelined
+ * @details Failure of one counter (e.g. LT_L3_COUNTER_INVALID) is stored into `statuses` and the other counters are
+ * still read.
+ *
+ * @param h                Device's handle
+ * @param mcounter_values  Values of counters, MCOUNTER_INDEX_15 + 1 items, valid where status is LT_OK
+ * @param statuses         Status of each counter, MCOUNTER_INDEX_15 + 1 items
+ *
+ * @retval                 LT_OK All commands were executed, see `statuses`
+ * @retval                 other Function did not execute successully, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_mcounter_get_all(lt_handle_t *h, uint32_t *mcounter_values, lt_ret_t *statuses);
+
+/**
+ * @brief Decrements several monotonic counters, commands are pipelined
+ * @details Counters are updated in the given order, one index may repeat. Failure of one update (e.g.
+ * LT_L3_MCOUNTER_UPDATE_UPDATE_ERR) is stored into `statuses` and the other updates are still executed.
+ *
+ * @param h                 Device's handle
+ * @param mcounter_indexes  Indexes of counters
+ * @param cnt               Number of updates
+ * @param statuses          Status of each update, `cnt` items
+ *
+ * @retval                  LT_OK All commands were executed, see `statuses`
+ * @retval                  other Function did not execute successully, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_mcounter_update_multi(lt_handle_t *h, const enum lt_mcounter_index_t *mcounter_indexes, const uint8_t cnt,
+                                  lt_ret_t *statuses);
+#endif
+
+/**
+ * @brief Executes the MAC-and-Destroy sequence.
+ * @details This command is just a part of MAC And Destroy sequence, which takes place between the host and TROPIC01.
+ *          Example code can be found in examples/lt_ex_macandd.c, for more info about Mac And Destroy functionality,
+ * read the Application note.
+ *
+ * @param h           Device's handle
+ * @param slot        Mac-and-Destroy slot index, valid values are 0-127
+ * @param data_out    Data to be sent from host to TROPIC01
+ * @param data_in     Data returned from TROPIC01 to host
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, const uint8_t *data_out, uint8_t *data_in);
+
+/**
+ * @brief Executes several MAC-and-Destroy sequences in the given order
+ *
+ * Each next command is encrypted while TROPIC01 executes the previous one, when it fits into L3 buffer together
+ * with the result. Execution stops at the first failure, data returned by the previous commands are valid.
+ *
+ * @param h           Device's handle
+ * @param slots       Mac-and-Destroy slot index of each command, valid values are 0-127, slots may repeat
+ * @param data_out    Data to be sent from host to TROPIC01, n * MAC_AND_DESTROY_DATA_SIZE bytes
+ * @param n           Number of commands
+ * @param data_in     Data returned from TROPIC01 to host, n * MAC_AND_DESTROY_DATA_SIZE bytes
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_mac_and_destroy_batch(lt_handle_t *h, const mac_and_destroy_slot_t *slots, const uint8_t *data_out,
+                                  const uint16_t n, uint8_t *data_in);
+
+#if LT_DEVICE_POOL
+/**
+ * @brief Initializes pool of chips
+ * @note Every handle must be initialized by `lt_init()` with its own port device and must have an established
+ * secure session. Handles must not be used outside of the pool while its workers run.
+ *
+ * @param pool        Pool to initialize
+ * @param handles     Handles of the chips, must stay valid while the pool is used
+ * @param handles_cnt Number of handles
+ * @param complete    Called by the worker after each completed job, may be NULL. Runs in the worker's thread.
+ * @param ctx         Context passed to `complete`
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_ecc_key_store(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve, const uint8_t *key);
+lt_ret_t lt_pool_init(lt_pool_t *pool, lt_handle_t *const *handles, const uint8_t handles_cnt,
+                      void (*complete)(lt_pool_job_t *job, void *ctx), void *ctx);
 
 /**
- * @brief Reads ECC public key corresponding to a private key in the specified ECC key slot.
+ * @brief Submits batch of jobs to the pool
+ * @note Must not be called while any worker of the pool runs `lt_pool_work()`. The jobs must stay valid until
+ * `lt_pool_poll()` returns LT_OK.
  *
- * @param h           Device's handle
- * @param ecc_slot    Slot number ECC_SLOT_0 - ECC_SLOT_31
- * @param key         Buffer for retrieving a key; length depends on the type of key in the slot (32B for Ed25519, 64B
- * for P256), according to *curve*
- * @param curve       Will be filled by curve byte
- * @param origin      Will be filled by origin byte
+ * @param pool        Pool initialized by `lt_pool_init()`
+ * @param jobs        Jobs to execute, `ret` and `chip` are filled on completion
+ * @param jobs_cnt    Number of jobs
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_ecc_key_read(lt_handle_t *h, const ecc_slot_t ecc_slot, uint8_t *key, lt_ecc_curve_type_t *curve,
-                         ecc_key_origin_t *origin);
+lt_ret_t lt_pool_submit(lt_pool_t *pool, lt_pool_job_t *jobs, const uint32_t jobs_cnt);
 
 /**
- * @brief Erases ECC key from the specified ECC key slot
+ * @brief Executes pending jobs of the submitted batch on one chip, until no job is left
+ * @details Meant to be called by one thread per chip. Each job is taken only once, so a chip which becomes idle
+ * continues with the next pending job regardless of which worker would be the fastest. Failure of a job is reported
+ * in its `ret`, the worker continues with the next one. With failover enabled by `lt_pool_failover_init()`, the
+ * application calls it again while `lt_pool_poll()` returns LT_PENDING, so standby chips and chips which
+ * re-established their session can take requeued jobs.
  *
- * @param h           Device's handle
- * @param ecc_slot    Slot number ECC_SLOT_0 - ECC_SLOT_31
+ * @param pool        Pool with submitted batch
+ * @param chip        Index of the chip in handles passed to `lt_pool_init()`
  *
  * @retval            LT_OK Function executed successfully
+ * @retval            LT_BUSY Chip is a standby and no active chip failed
+ * @retval            LT_L1_CHIP_ALARM_MODE Chip is in ALARM mode, its jobs were left to the other chips
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_ecc_key_erase(lt_handle_t *h, const ecc_slot_t ecc_slot);
+lt_ret_t lt_pool_work(lt_pool_t *pool, const uint8_t chip);
 
 /**
- * @brief Performs ECDSA sign of a message with a private ECC key stored in TROPIC01
+ * @brief Checks whether all jobs of the submitted batch are completed
  *
- * @param h           Device's handle
- * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
- * @param msg         Buffer containing a message
- * @param msg_len     Length of msg's buffer
- * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ * @param pool        Pool with submitted batch
  *
- * @retval            LT_OK Function executed successfully
+ * @retval            LT_OK All jobs are completed
+ * @retval            LT_PENDING Some jobs are not completed yet
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_ecc_ecdsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint32_t msg_len,
-                           uint8_t *rs);
+lt_ret_t lt_pool_poll(lt_pool_t *pool);
 
 /**
- * @brief Verifies ECDSA signature. Host side only, does not require TROPIC01.
+ * @brief Reorders jobs into groups executed in the session of one pairing key, so sessions are switched least often
+ * @details Sessions allowed to execute each job are looked up by `lt_uap_sessions()` in R-Config. Jobs of the
+ * session of `current` come first, then the session which may execute the most of the remaining jobs, and so on.
+ * The order of jobs within a group is kept. Jobs which no session may execute are left behind the last group with
+ * `ret` set to LT_L3_UNAUTHORIZED. The application then starts the session of each group and submits its jobs by
+ * `lt_pool_submit()`.
+ * @note Moving of jobs takes quadratic time of their count, plan batches of a reasonable size.
+ *
+ * @param r_config    R-Config of the chips, e.g. cached by `lt_config_snapshot_read()`
+ * @param jobs        Jobs to reorder
+ * @param jobs_cnt    Number of jobs
+ * @param current     Pairing key slot of the session established now
+ * @param groups      Groups of jobs, LT_POOL_SESSION_GROUPS_MAX items
+ * @param groups_cnt  Number of groups
  *
- * @param msg         Message
- * @param msg_len     Length of message
- * @param pubkey      Public key related to private key which signed the message (64B)
- * @param rs          Signature to be verified, in a form of R and S bytes (should always have length 64B)
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_pool_session_plan(const struct lt_config_t *r_config, lt_pool_job_t *jobs, const uint32_t jobs_cnt,
+                              const pkey_index_t current, lt_pool_session_group_t *groups, uint8_t *groups_cnt);
+
+/**
+ * @brief Enables failover of the pool to hot standby chips
+ * @details The first `handles_cnt - standby_cnt` chips take jobs, the others only keep their sessions established.
+ * When a job fails because its chip lost the secure session (e.g. after reboot, authentication failure or nonce
+ * overflow) or entered ALARM mode, the job is requeued at the front of the batch for another chip, and a standby
+ * chip takes the place of the failed one. The worker of a chip which lost its session establishes a new one with
+ * `chips[chip].ctx` and the chip becomes a standby. A chip in ALARM mode takes no jobs until this function is
+ * called again.
+ * @note Must not be called while any worker of the pool runs `lt_pool_work()`.
+ *
+ * @param pool        Pool initialized by `lt_pool_init()`
+ * @param chips       Failover state of each chip of the pool with its `ctx` prepared, must stay valid while the
+ *                    pool is used
+ * @param standby_cnt Number of standby chips, must be smaller than the number of chips
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
+ */
+lt_ret_t lt_pool_failover_init(lt_pool_t *pool, lt_pool_chip_t *chips, const uint8_t standby_cnt);
+
+/**
+ * @brief Enables failover of the pool with warm-up of all chips by their workers, see `lt_pool_warmup_t`
+ * @details Same as `lt_pool_failover_init()`, but the handles need not be initialized and `ctx` of the chips is
+ * prepared by the warm-up. The first call of `lt_pool_work()` for each chip calls `lt_init()`, reads CHIP_ID,
+ * takes STPub from the cache or from the certificate store of the chip and establishes the session. Each chip
+ * takes jobs as soon as its own warm-up finishes, so jobs submitted by `lt_pool_submit_prio()` are executed
+ * while slower chips still warm up. A worker whose warm-up failed returns the error, the next call of
+ * `lt_pool_work()` retries the warm-up. When `cache_save` is set, a worker which reads the whole certificate
+ * store needs about 8 kB of stack.
+ * @warning STPub from the cache is trusted without verification of the certificate chain, the application keeps
+ * the cache where it cannot be modified by an attacker.
+ * @note Must not be called while any worker of the pool runs `lt_pool_work()`.
+ *
+ * @param pool        Pool initialized by `lt_pool_init()`
+ * @param chips       Failover state of each chip of the pool, must stay valid while the pool is used
+ * @param standby_cnt Number of standby chips, must be smaller than the number of chips
+ * @param warmup      Warm-up parameters, must stay valid while the pool is used
  *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
  */
-lt_ret_t lt_ecc_ecdsa_sig_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs);
+lt_ret_t lt_pool_warmup_init(lt_pool_t *pool, lt_pool_chip_t *chips, const uint8_t standby_cnt,
+                             const lt_pool_warmup_t *warmup);
 
 /**
- * @brief Performs EdDSA sign of a message with a private ECC key stored in TROPIC01
+ * @brief Enables priority scheduling of jobs of the pool, see `lt_pool_prio_t`
+ * @details Workers take jobs requeued after a failure of a chip first, then jobs of the priority classes, and jobs
+ * of the batch submitted by `lt_pool_submit()` only when no class has a waiting job.
+ * @note Must not be called while any worker of the pool runs `lt_pool_work()`.
  *
- * @param h           Device's handle
- * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
- * @param msg         Buffer containing a message to sign, max length is 4096B
- * @param msg_len     Length of a message
- * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ * @param pool        Pool initialized by `lt_pool_init()`
+ * @param prio        Scheduling state with its public members set, must stay valid while the pool is used
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint16_t msg_len,
-                           uint8_t *rs);
+lt_ret_t lt_pool_prio_init(lt_pool_t *pool, lt_pool_prio_t *prio);
 
 /**
- * @brief Verifies EdDSA signature. Host side only, does not require TROPIC01.
+ * @brief Appends jobs to the queue of a priority class
+ * @details Can be called at any time, also while workers run `lt_pool_work()`. Completion of each job is reported
+ * by its `ret` and by the `complete` callback of the pool.
  *
- * @param msg         Message
- * @param msg_len     Length of message. Max length is 4095
- * @param pubkey      Public key related to private key which signed the message (32B)
- * @param rs          Signature to be verified, in a form of R and S bytes (should always have length 64B)
- * lt_ret_t           LT_OK          - success
- *                    LT_PARAM_ERROR - wrong parameters were passed
- *                    LT_FAIL        - signature verify failed
+ * @param pool        Pool with priority scheduling enabled by `lt_pool_prio_init()`
+ * @param prio        Priority class, one of LT_POOL_PRIO_* values
+ * @param jobs        Jobs to execute, must stay valid until they are completed
+ * @param jobs_cnt    Number of jobs
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_OVERLOAD No job was submitted, the last one would wait longer than `deadline_us` of the class
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
  */
-lt_ret_t lt_ecc_eddsa_sig_verify(const uint8_t *msg, const uint16_t msg_len, const uint8_t *pubkey, const uint8_t *rs);
+lt_ret_t lt_pool_submit_prio(lt_pool_t *pool, const uint8_t prio, lt_pool_job_t *jobs, const uint32_t jobs_cnt);
 
 /**
- * @brief Initializes monotonic counter of a given index
+ * @brief Reads statistics of a priority class
  *
- * @param h               Device's handle
- * @param mcounter_index  Index of monotonic counter
- * @param mcounter_value  Value to set as an initial value (allowed range is 0-MCOUNTER_VALUE_MAX)
+ * @param pool        Pool with priority scheduling enabled by `lt_pool_prio_init()`
+ * @param prio        Priority class, one of LT_POOL_PRIO_* values
+ * @param stats       Statistics of the class
  *
- * @retval                LT_OK Function executed successfully
- * @retval                other Function did not execute successully, you might use lt_ret_verbose() to get verbose
- * encoding of returned value
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
  */
-lt_ret_t lt_mcounter_init(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, const uint32_t mcounter_value);
+lt_ret_t lt_pool_prio_stats_get(lt_pool_t *pool, const uint8_t prio, lt_pool_prio_stats_t *stats);
 
 /**
- * @brief Updates monotonic counter of a given index
+ * @brief Enables single-flight and hedging of read operations of the pool, see `lt_pool_reads_t`
+ * @details The application fills the public members of `reads`. Hedging starts once LT_POOL_READS_SAMPLES / 4
+ * latencies of the operation were recorded. A worker with no job left keeps checking for reads to hedge in 1 ms
+ * steps while reads of other chips execute.
+ * @note Must not be called while any worker of the pool runs `lt_pool_work()`.
  *
- * @param h               Device's handle
- * @param mcounter_index  Index of monotonic counter
+ * @param pool        Pool initialized by `lt_pool_init()`
+ * @param reads       State of the reads, must stay valid while the pool is used
  *
- * @retval                LT_OK Function executed successfully
- * @retval                other Function did not execute successully, you might use lt_ret_verbose() to get verbose
- * encoding of returned value
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
  */
-lt_ret_t lt_mcounter_update(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index);
+lt_ret_t lt_pool_reads_init(lt_pool_t *pool, lt_pool_reads_t *reads);
 
 /**
- * @brief Gets a value of a monotonic counter of a given index
+ * @brief Reads statistics of single-flight and hedging of reads
  *
- * @param h               Device's handle
- * @param mcounter_index  Index of monotonic counter
- * @param mcounter_value  Value of monotonic counter (from range 0-MCOUNTER_VALUE_MAX)
+ * @param pool        Pool with reads enabled by `lt_pool_reads_init()`
+ * @param stats       Statistics
  *
- * @retval                LT_OK Function executed successfully
- * @retval                other Function did not execute successully, you might use lt_ret_verbose() to get verbose
- * encoding of returned value
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
  */
-lt_ret_t lt_mcounter_get(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, uint32_t *mcounter_value);
+lt_ret_t lt_pool_reads_stats_get(lt_pool_t *pool, lt_pool_reads_stats_t *stats);
+#endif
+
+#if LT_ASYNC
+/** @brief L3 commands which can be submitted by `lt_submit()` */
+typedef enum lt_async_cmd_t {
+    /** `lt_ping()`, `in`/`in_len` is the message, echoed message is stored into `out` */
+    LT_ASYNC_PING = 1,
+    /** `lt_random_value_get()`, `in_len` random bytes are stored into `out` */
+    LT_ASYNC_RANDOM_VALUE_GET,
+    /** `lt_ecc_ecdsa_sign_digest()`, `in` is 32B digest, 64B signature is stored into `out` */
+    LT_ASYNC_ECDSA_SIGN_DIGEST,
+    /** `lt_ecc_eddsa_sign()`, `in`/`in_len` is the message, 64B signature is stored into `out` */
+    LT_ASYNC_EDDSA_SIGN,
+    /** `lt_mac_and_destroy()`, `in` is 32B data sent to TROPIC01, 32B data returned from it are stored into `out` */
+    LT_ASYNC_MAC_AND_DESTROY
+} lt_async_cmd_t;
+
+struct lt_async_op_t;
+
+/** @brief Called when an operation submitted by `lt_submit()` is completed, its result is in `op->ret` */
+typedef void (*lt_async_cb_t)(lt_handle_t *h, struct lt_async_op_t *op, void *ctx);
 
 /**
- * @brief Executes the MAC-and-Destroy sequence.
- * @details This command is just a part of MAC And Destroy sequence, which takes place between the host and TROPIC01.
- *          Example code can be found in examples/lt_ex_macandd.c, for more info about Mac And Destroy functionality,
- * read the Application note.
+ * @brief Operation submitted by `lt_submit()`. The caller fills the command and its arguments and keeps the
+ * structure valid until its callback is called.
+ */
+typedef struct lt_async_op_t {
+    /** @brief L3 command */
+    lt_async_cmd_t cmd;
+    /** @brief ECC slot or MAC-and-Destroy slot, ignored by the other commands */
+    uint16_t slot;
+    /** @brief Length of `in`, or number of requested bytes for `LT_ASYNC_RANDOM_VALUE_GET` */
+    uint16_t in_len;
+    /** @brief Input data of the command */
+    const uint8_t *in;
+    /** @brief Output buffer of the command */
+    uint8_t *out;
+    /** @brief Result of the command, valid in the callback */
+    lt_ret_t ret;
+    /** @private @brief Completion callback */
+    lt_async_cb_t cb;
+    /** @private @brief Context passed to `cb` */
+    void *ctx;
+    /** @private @brief Next operation in the queue */
+    struct lt_async_op_t *next;
+} lt_async_op_t;
+
+/**
+ * @brief Queue of submitted operations of one handle, supplied (zeroed) by the application in `lt_handle_t.async`.
  *
- * @param h           Device's handle
- * @param slot        Mac-and-Destroy slot index, valid values are 0-127
- * @param data_out    Data to be sent from host to TROPIC01
- * @param data_in     Data returned from TROPIC01 to host
+ * TROPIC01 executes one L3 command at a time, so the operations are executed one by one in submission order.
+ * Operations of several chips are multiplexed by calling `lt_poll()` for each handle in one event loop.
+ */
+typedef struct lt_async_t {
+    /** @private @brief Operation being executed, NULL when the queue is empty */
+    lt_async_op_t *head;
+    /** @private @brief Last submitted operation */
+    lt_async_op_t *tail;
+    /** @private @brief Whether command of `head` was already sent */
+    bool started;
+    /** @private @brief L2 transfer of `head` */
+    lt_l2_transfer_t t;
+} lt_async_t;
+
+/**
+ * @brief Appends operation to the queue of the handle, without any communication with TROPIC01
+ * @note The operation is started by the next `lt_poll()`. While the queue is not empty, the handle must not be used
+ * by other functions than `lt_submit()` and `lt_poll()`.
+ *
+ * @param h           Device's handle, `h->async` must be set
+ * @param op          Operation to execute, kept valid by the caller until `cb` is called
+ * @param cb          Called from `lt_poll()` when the operation is completed, may be NULL
+ * @param ctx         Context passed to `cb`
  *
  * @retval            LT_OK Function executed successfully
  * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
  * of returned value
  */
-lt_ret_t lt_mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, const uint8_t *data_out, uint8_t *data_in);
+lt_ret_t lt_submit(lt_handle_t *h, lt_async_op_t *op, lt_async_cb_t cb, void *ctx);
+
+/**
+ * @brief Makes progress on operations submitted to the handle, never waits
+ * @details Sends the command of the first pending operation, or checks whether TROPIC01 already has its result.
+ * Completed operation is removed from the queue before its callback is called, so the callback can submit another
+ * one. Secure session re-establishment by `LT_SESSION_REKEY` is the only part which blocks.
+ *
+ * @param h           Device's handle, `h->async` must be set
+ * @param wait_ms     Time to wait before the next `lt_poll()`, valid for LT_PENDING
+ *
+ * @retval            LT_OK All submitted operations are completed
+ * @retval            LT_PENDING Some operations are not completed yet, call `lt_poll()` again after `wait_ms`
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_poll(lt_handle_t *h, uint32_t *wait_ms);
+
+/**
+ * @brief Makes progress on operations submitted to several handles, never waits
+ * @details Same as `lt_poll()` called for each handle, but commands of all handles whose next operation is to be
+ * started are prepared first and then encrypted together. With LT_AESGCM_MULTI, AES-GCM of up to 8 sessions is
+ * interleaved, so an event loop driving a pool of chips spends less time in encryption.
+ *
+ * @param handles     Device's handles, `async` of each of them must be set
+ * @param handles_cnt Number of handles
+ * @param wait_ms     Time to wait before the next `lt_poll_multi()`, the shortest of all handles, valid for LT_PENDING
+ *
+ * @retval            LT_OK All operations submitted to all handles are completed
+ * @retval            LT_PENDING Some operations are not completed yet, call `lt_poll_multi()` again after `wait_ms`
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_poll_multi(lt_handle_t *const *handles, const uint8_t handles_cnt, uint32_t *wait_ms);
+#endif
+
+#if LT_CRYPTO_DISPATCH
+/**
+ * @brief Returns name of the host implementation used for a primitive, e.g. "trezor_crypto", "aes-ni+pclmul" or
+ * "sha-ni". Implementations of AES-GCM and SHA256 are selected by features of the CPU in the first `lt_init()`.
+ *
+ * @param prim        Primitive
+ *
+ * @return            Static string, NULL for invalid `prim`
+ */
+const char *lt_crypto_impl(lt_crypto_prim_t prim);
+#endif
 
 /** @} */  // end of libtropic_API group
 
@@ -655,6 +2468,7 @@ lt_ret_t lt_write_whole_R_config(lt_handle_t *h, const struct lt_config_t *confi
 
 /**
  * @brief Reads all of the R-Config objects into `config`.
+ * @details Commands are pipelined.
  *
  * @param h           Device's handle
  * @param config      Struct into which objects are readed
@@ -667,6 +2481,7 @@ lt_ret_t lt_read_whole_R_config(lt_handle_t *h, struct lt_config_t *config);
 
 /**
  * @brief Reads all of the I-Config objects into `config`.
+ * @details Commands are pipelined.
  *
  * @param h           Device's handle
  * @param config      Struct into which objects are readed
@@ -677,6 +2492,103 @@ lt_ret_t lt_read_whole_R_config(lt_handle_t *h, struct lt_config_t *config);
  */
 lt_ret_t lt_read_whole_I_config(lt_handle_t *h, struct lt_config_t *config);
 
+#if LT_CONFIG_CACHE
+/**
+ * @brief Invalidates R-Config and I-Config cached in `h->config_cache`, so they are read from TROPIC01 again
+ * @note Call it when the handle is about to be connected to a different chip, or when the configuration was changed
+ * through a different handle.
+ *
+ * @param h           Device's handle
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_config_cache_invalidate(lt_handle_t *h);
+#endif
+
+/**
+ * @brief Reads all objects of R-Config or I-Config into a snapshot, which can be cached and compared later.
+ *
+ * @param h           Device's handle
+ * @param space       LT_CONFIG_SPACE_R or LT_CONFIG_SPACE_I
+ * @param snap        Snapshot into which objects are read
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_config_snapshot_read(lt_handle_t *h, const lt_config_space_t space, struct lt_config_snapshot_t *snap);
+
+/**
+ * @brief Checks that a cached snapshot has the current layout version and was not corrupted.
+ *
+ * @param snap        Snapshot from `lt_config_snapshot_read()`
+ *
+ * @retval            LT_OK Snapshot is valid
+ * @retval            LT_FAIL Snapshot has other version or wrong CRC
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_config_snapshot_check(const struct lt_config_snapshot_t *snap);
+
+/**
+ * @brief Compares two snapshots of the same configuration space.
+ *
+ * @param a           First snapshot
+ * @param b           Second snapshot
+ * @param changed     Bit i is set when i-th object (as in `cfg_desc_table`) differs
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter or snapshots of different spaces
+ */
+lt_ret_t lt_config_snapshot_diff(const struct lt_config_snapshot_t *a, const struct lt_config_snapshot_t *b,
+                                 uint32_t *changed);
+
+/**
+ * @brief Reads R-Config, I-Config and the pairing key slots selected by `state->pkeys_mask`.
+ * @details Commands are pipelined. A slot which cannot be read does not fail the function, its error is stored into
+ * `state->pkeys_status`.
+ *
+ * @param h           Device's handle
+ * @param state       State with `pkeys_mask` set, the rest is filled
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_config_state_read(lt_handle_t *h, struct lt_config_state_t *state);
+
+/**
+ * @brief Computes canonical fingerprint of a provisioned state.
+ * @details SHA256 over R-Config and I-Config objects as little endian words and, for each slot in `pkeys_mask`, its
+ * index, whether it holds a key, is empty, invalidated or unreadable, and the key. The fingerprint does not depend on
+ * the host, so a target computed from a provisioning package once can be compared with fingerprints of many chips.
+ *
+ * @param state       State read by `lt_config_state_read()`, or filled from a package with LT_OK key statuses
+ * @param fp          Buffer for LT_CONFIG_FINGERPRINT_SIZE bytes of fingerprint
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_config_fingerprint(const struct lt_config_state_t *state, uint8_t *fp);
+
+/**
+ * @brief Reads the state of the chip and compares its fingerprint with `target`, in one pipelined read pass.
+ * @details An already provisioned chip is recognized without any write. Otherwise `state` holds what was read, so
+ * the differences can be written, e.g. by `lt_write_R_config_diff()` and `lt_write_I_config_diff()`.
+ *
+ * @param h           Device's handle
+ * @param target      Fingerprint of the required state, e.g. computed by `lt_config_fingerprint()` from a package
+ * @param state       State with `pkeys_mask` set, the rest is filled
+ * @param match       Set to true when the chip is in the required state
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_config_fingerprint_match(lt_handle_t *h, const uint8_t *target, struct lt_config_state_t *state,
+                                     bool *match);
+
 /**
  * @brief Writes the whole I-Config with the passed `config`.
  * @details Only the zero bits in `config` are written.
@@ -690,6 +2602,51 @@ lt_ret_t lt_read_whole_I_config(lt_handle_t *h, struct lt_config_t *config);
  */
 lt_ret_t lt_write_whole_I_config(lt_handle_t *h, const struct lt_config_t *config);
 
+/**
+ * @brief Changes R-Config to `config`, writing only the objects which differ from `current`.
+ * @details Commands are pipelined. When a written object differs from its erased value in `current`, R-Config is
+ * erased and all objects of `config` which are not erased are written.
+ *
+ * @param h           Device's handle
+ * @param current     Current R-Config, e.g. cached from `lt_read_whole_R_config()`, or NULL to read it
+ * @param config      Required R-Config
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_write_R_config_diff(lt_handle_t *h, const struct lt_config_t *current, const struct lt_config_t *config);
+
+/**
+ * @brief Changes I-Config to `config`, writing only the bits which are 1 in `current` and 0 in `config`.
+ * @details Commands are pipelined. Bits which are 0 in `current` cannot be set back to 1 and are ignored.
+ *
+ * @param h           Device's handle
+ * @param current     Current I-Config, e.g. cached from `lt_read_whole_I_config()`, or NULL to read it
+ * @param config      Required I-Config
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_write_I_config_diff(lt_handle_t *h, const struct lt_config_t *current, const struct lt_config_t *config);
+
+/**
+ * @brief Returns sessions allowed to execute a command by its User Access Policy object
+ * @details UAP objects give access to groups of slots, e.g. 8 ECC slots or 32 MAC-and-Destroy slots share one field.
+ * For R_CONFIG_READ and I_CONFIG_* objects, `index` 0 selects the access to configuration and 1 to functionality
+ * objects. Objects with a single field (e.g. Ping) ignore `index`.
+ *
+ * @param config      R-Config, e.g. cached by `lt_config_snapshot_read()`
+ * @param obj         UAP object, one of CONFIGURATION_OBJECTS_CFG_UAP_*_IDX
+ * @param index       Slot, counter or pairing key slot targeted by the command
+ *
+ * @return            SESSION_SHx_HAS_ACCESS bits of pairing key slots whose sessions may execute the command, 0 for
+ * invalid parameters
+ */
+uint8_t lt_uap_sessions(const struct lt_config_t *config, const CONFIGURATION_OBJECTS_REGS_IDX obj,
+                        const uint16_t index);
+
 /**
  * @brief Establishes a secure channel between host MCU and TROPIC01
  *
@@ -710,6 +2667,26 @@ lt_ret_t lt_write_whole_I_config(lt_handle_t *h, const struct lt_config_t *confi
  */
 lt_ret_t lt_verify_chip_and_start_secure_session(lt_handle_t *h, uint8_t *shipriv, uint8_t *shipub, uint8_t pkey_index);
 
+/**
+ * @brief Same as `lt_verify_chip_and_start_secure_session()`, but keeps its large variables in `scratch`, so a few
+ * hundred bytes of stack are used on top of the crypto backend's own (X25519, HKDF).
+ *
+ * STPub is parsed from the blocks of the device's certificate as they are received, no certificate buffer is needed.
+ * Chip ID and firmware versions are not read.
+ *
+ * @param h           Device's handle
+ * @param shipriv     Host's private pairing key for the slot `pkey_index`
+ * @param shipub      Host's public pairing key for the slot `pkey_index`
+ * @param pkey_index  Pairing key index
+ * @param scratch     Scratch memory, wiped before return
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_verify_chip_and_start_secure_session_scratch(lt_handle_t *h, uint8_t *shipriv, uint8_t *shipub,
+                                                         uint8_t pkey_index, lt_session_scratch_t *scratch);
+
 /**
  * @brief Prints bytes in hex format to the given output buffer.
  *
@@ -736,6 +2713,7 @@ lt_ret_t lt_print_bytes(const uint8_t *bytes, const uint16_t length, char *out_b
  */
 lt_ret_t lt_print_chip_id(const struct lt_chip_id_t *chip_id, int (*print_func)(const char *format, ...));
 
+#if LT_ENABLE_FW_UPDATE
 /**
  * @brief Performs mutable firmware update on ABAB and ACAB silicon revisions.
  *
@@ -750,7 +2728,95 @@ lt_ret_t lt_print_chip_id(const struct lt_chip_id_t *chip_id, int (*print_func)(
 lt_ret_t lt_do_mutable_fw_update(lt_handle_t *h, const uint8_t *update_data, const uint16_t update_data_size,
                                  bank_id_t bank_id);
 
+/**
+ * @brief Performs mutable firmware update on ABAB and ACAB silicon revisions, reading the update image by `read`
+ * @details The image is read one chunk at a time (e.g. from a file), so it does not have to be held in memory. Each
+ * next chunk is read while TROPIC01 writes the previous one.
+ *
+ * @param h                 Device's handle
+ * @param read              Callback reading bytes of the update image
+ * @param ctx               Argument of `read`
+ * @param update_data_size  Size of the update image
+ * @param bank_id           Bank ID where the update should be applied, see `lt_do_mutable_fw_update()`
+ * @return                  LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_do_mutable_fw_update_stream(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx,
+                                        const uint32_t update_data_size, bank_id_t bank_id);
+
+/**
+ * @brief Performs or continues mutable firmware update on ABAB and ACAB silicon revisions
+ * @details With `u->cursor` 0 the whole update is done (ABAB bank is erased, ACAB update request is sent). Otherwise
+ * the update continues from the last chunk acknowledged by TROPIC01, which requires TROPIC01 still in MAINTENANCE
+ * mode. On ACAB the bootloader accepts the remaining chunks only when it was not reset since the interrupted update,
+ * otherwise the update has to be started again with `u->cursor` 0. `u->progress` is called after each acknowledged
+ * chunk.
+ *
+ * @param h                 Device's handle
+ * @param u                 Update state, `u->cursor` and `u->chunks` are updated
+ * @param bank_id           Bank ID where the update should be applied, see `lt_do_mutable_fw_update()`
+ * @retval                  LT_OK Function executed successfully
+ * @retval                  LT_FAIL Update cannot be continued, TROPIC01 is not in MAINTENANCE mode
+ * @retval                  other Function did not execute successully, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_do_mutable_fw_update_resume(lt_handle_t *h, struct lt_fw_update_t *u, bank_id_t bank_id);
+
+/**
+ * @brief Checks whether a firmware bank already holds the update image
+ * @details Only the firmware header is compared, which costs one GET_INFO request. On ABAB the whole header
+ * (type, version, size, git hash and hash) is compared. On ACAB the update image carries only type, header version
+ * and firmware version, so banks holding the same firmware version are considered identical. TROPIC01 must be in
+ * MAINTENANCE mode.
+ *
+ * @param h                 Device's handle
+ * @param read              Callback reading bytes of the update image
+ * @param ctx               Argument of `read`
+ * @param update_data_size  Size of the update image
+ * @param bank_id           Bank to compare with, one of FW_BANK_FW1, FW_BANK_FW2, FW_BANK_SPECT1, FW_BANK_SPECT2
+ * @param identical         Set to true when the bank holds the update image, false also for an empty bank
+ * @return                  LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_fw_bank_identical(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx, const uint32_t update_data_size,
+                              bank_id_t bank_id, bool *identical);
+
+/**
+ * @brief Performs mutable firmware update only when the bank does not hold the update image yet
+ * @details See `lt_fw_bank_identical()` for the comparison. On ACAB `bank_id` selects the bank compared with the
+ * image (e.g. the active one), the update itself is placed by the chip.
+ *
+ * @param h                 Device's handle
+ * @param update_data       Pointer to the data to be written
+ * @param update_data_size  Size of the data to be written
+ * @param bank_id           Bank ID where the update should be applied, see `lt_do_mutable_fw_update()`
+ * @param updated           Set to true when the bank was erased and written, false when the update was skipped
+ * @return                  LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_do_mutable_fw_update_if_changed(lt_handle_t *h, const uint8_t *update_data,
+                                            const uint16_t update_data_size, bank_id_t bank_id, bool *updated);
+
+/**
+ * @brief Performs mutable firmware update of several devices with one update image
+ * @details Every device is rebooted into MAINTENANCE mode, its bank is erased (ABAB) or the update request is sent
+ * (ACAB). Each chunk of the image is read once and sent to all devices before their responses are collected, so the
+ * devices write it at the same time and the update takes about as long as on the slowest device. Updated devices
+ * are rebooted into APP mode and, with `f->verify`, their firmware version is compared with the image.
+ *
+ * Result of each device is stored into `f->devs[i].ret`, the failed ones can be updated again separately, e.g. by
+ * `lt_do_mutable_fw_update_resume()`. The handles must not be used by other threads during the update.
+ *
+ * @param f                 Fleet update
+ * @retval                  LT_OK All devices were updated
+ * @retval                  other Error of the first failed device, you might use lt_ret_verbose() to get verbose
+ * encoding of returned value
+ */
+lt_ret_t lt_do_mutable_fw_update_fleet(lt_fw_fleet_t *f);
+#endif
+
 /** @} */  // end of libtropic_API_helpers group
 #endif
 
-#endif
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,566 @@
+#ifndef LT_LIBTROPIC_HPP
+#define LT_LIBTROPIC_HPP
+
+/**
+ * @file libtropic.hpp
+ * @brief Header-only C++20 API over libtropic.h.
+ * @author Tropic Square s.r.o.
+ *
+ * `tropic::Handle` owns an initialized `lt_handle_t` and `tropic::Session` the secure session of it, both are move-only
+ * and release what they own in their destructors. Buffers are `std::span`s passed straight to the C functions, fixed
+ * sizes (digests, signatures, keys) are part of the span types. Errors are returned as `tropic::Result`, which holds
+ * either the value or the `lt_ret_t` of the failed call, like `std::expected` of C++23.
+ *
+ * With `LT_ASYNC`, `tropic::Async` returns awaitables of operations submitted by `lt_submit()`, the awaiting coroutine
+ * is resumed from `lt_poll()` when its operation is completed.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#if __cplusplus < 202002L
+#error "libtropic.hpp needs C++20"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#if LT_ASYNC
+#include <coroutine>
+#include <exception>
+#endif
+
+#include "libtropic.h"
+
+namespace tropic {
+
+/** @brief Error of a libtropic function */
+class Error {
+   public:
+    constexpr explicit Error(const lt_ret_t ret) noexcept : ret_(ret) {}
+
+    /** @brief Return value of the failed function */
+    constexpr lt_ret_t code() const noexcept { return ret_; }
+
+#ifdef LT_HELPERS
+    /** @brief Name of the return value, see `lt_ret_verbose()` */
+    const char *what() const noexcept { return lt_ret_verbose(ret_); }
+#endif
+
+    friend constexpr bool operator==(const Error &a, const Error &b) noexcept { return a.ret_ == b.ret_; }
+
+   private:
+    lt_ret_t ret_;
+};
+
+/** @brief Value of a successful call, or its `Error` */
+template <typename T>
+class [[nodiscard]] Result {
+   public:
+    Result(T value) noexcept(std::is_nothrow_move_constructible_v<T>) : ok_(true)
+    {
+        new (&value_) T(std::move(value));
+    }
+    Result(const Error err) noexcept : ok_(false), ret_(err.code()) {}
+
+    Result(Result &&other) noexcept(std::is_nothrow_move_constructible_v<T>) : ok_(other.ok_)
+    {
+        if (ok_) {
+            new (&value_) T(std::move(other.value_));
+        }
+        else {
+            ret_ = other.ret_;
+        }
+    }
+    Result(const Result &other)
+        requires std::is_copy_constructible_v<T>
+        : ok_(other.ok_)
+    {
+        if (ok_) {
+            new (&value_) T(other.value_);
+        }
+        else {
+            ret_ = other.ret_;
+        }
+    }
+    Result &operator=(Result other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        this->~Result();
+        new (this) Result(std::move(other));
+        return *this;
+    }
+    ~Result()
+    {
+        if (ok_) {
+            value_.~T();
+        }
+    }
+
+    bool has_value() const noexcept { return ok_; }
+    explicit operator bool() const noexcept { return ok_; }
+
+    /** @brief Value of the result, `has_value()` must be true */
+    T &value() & noexcept { return value_; }
+    const T &value() const & noexcept { return value_; }
+    T &&value() && noexcept { return std::move(value_); }
+    T &operator*() & noexcept { return value_; }
+    const T &operator*() const & noexcept { return value_; }
+    T &&operator*() && noexcept { return std::move(value_); }
+    T *operator->() noexcept { return &value_; }
+    const T *operator->() const noexcept { return &value_; }
+
+    template <typename U>
+    T value_or(U &&other) const &
+    {
+        return ok_ ? value_ : static_cast<T>(std::forward<U>(other));
+    }
+
+    /** @brief Error of the result, `has_value()` must be false */
+    Error error() const noexcept { return Error(ret_); }
+
+   private:
+    bool ok_;
+    union {
+        T value_;
+        lt_ret_t ret_;
+    };
+};
+
+/** @brief Success of a call without a value, or its `Error` */
+template <>
+class [[nodiscard]] Result<void> {
+   public:
+    Result() noexcept : ret_(LT_OK) {}
+    Result(const Error err) noexcept : ret_(err.code()) {}
+
+    bool has_value() const noexcept { return ret_ == LT_OK; }
+    explicit operator bool() const noexcept { return ret_ == LT_OK; }
+    void value() const noexcept {}
+    Error error() const noexcept { return Error(ret_); }
+
+   private:
+    lt_ret_t ret_;
+};
+
+namespace detail {
+
+inline Result<void> check(const lt_ret_t ret) noexcept
+{
+    if (ret != LT_OK) {
+        return Error(ret);
+    }
+    return {};
+}
+
+/** @brief Length of a buffer for uint16_t parameters, lengths above are rejected by the C functions */
+inline uint16_t len16(const std::size_t len) noexcept
+{
+    return (len > UINT16_MAX) ? UINT16_MAX : static_cast<uint16_t>(len);
+}
+
+}  // namespace detail
+
+/** @brief Initialized device's handle, `lt_deinit()` is called by the destructor */
+class Handle {
+   public:
+    /**
+     * @brief Initializes handle of the port device by `lt_init()`
+     *
+     * @param device      Port device, e.g. `lt_dev_unix_spi_t`, kept valid by the caller for the life of the handle
+     * @param setup       Called with the zeroed handle before `lt_init()`, to set further fields (caches, async queue)
+     */
+    template <typename Setup>
+    static Result<Handle> open(void *device, Setup &&setup)
+    {
+        // Handle is kept on heap, so moving the wrapper does not move lt_handle_t referenced by the port and caches
+        std::unique_ptr<lt_handle_t> h(new (std::nothrow) lt_handle_t{});
+        if (!h) {
+            return Error(LT_FAIL);
+        }
+        h->l2.device = device;
+        std::forward<Setup>(setup)(*h);
+        lt_ret_t ret = lt_init(h.get());
+        if (ret != LT_OK) {
+            return Error(ret);
+        }
+        return Handle(std::move(h));
+    }
+
+    /** @brief Same as `open(device, setup)` without setup */
+    static Result<Handle> open(void *device)
+    {
+        return open(device, [](lt_handle_t &) {});
+    }
+
+    Handle(Handle &&) noexcept = default;
+    Handle &operator=(Handle &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            h_ = std::move(other.h_);
+        }
+        return *this;
+    }
+    ~Handle() { reset(); }
+
+    /** @brief The C handle, for functions without a wrapper */
+    lt_handle_t *get() const noexcept { return h_.get(); }
+
+    /** @brief Same as `lt_get_info_chip_id()` */
+    Result<void> get_info_chip_id(struct lt_chip_id_t &chip_id) noexcept
+    {
+        return detail::check(lt_get_info_chip_id(h_.get(), &chip_id));
+    }
+
+    /** @brief Same as `lt_get_info_riscv_fw_ver()` */
+    Result<void> get_info_riscv_fw_ver(std::span<uint8_t, LT_L2_GET_INFO_RISCV_FW_SIZE> ver) noexcept
+    {
+        return detail::check(lt_get_info_riscv_fw_ver(h_.get(), ver.data()));
+    }
+
+   private:
+    explicit Handle(std::unique_ptr<lt_handle_t> h) noexcept : h_(std::move(h)) {}
+
+    void reset() noexcept
+    {
+        if (h_) {
+            lt_deinit(h_.get());
+            h_.reset();
+        }
+    }
+
+    std::unique_ptr<lt_handle_t> h_;
+};
+
+/** @brief Public key read by `Session::ecc_key_read()` */
+struct EccKey {
+    /** @brief Key in the buffer given to `ecc_key_read()`, 32B for Ed25519 and 64B for P256 */
+    std::span<uint8_t> key;
+    lt_ecc_curve_type_t curve;
+    ecc_key_origin_t origin;
+};
+
+/**
+ * @brief Secure session of a handle, `lt_session_abort()` is called by the destructor.
+ *
+ * L3 commands are members of the session, so they cannot be called without one. The handle must outlive the session.
+ */
+class Session {
+   public:
+    /** @brief Establishes secure session by `lt_session_start()` */
+    static Result<Session> start(Handle &h, std::span<const uint8_t, 32> stpub, const pkey_index_t pkey_index,
+                                 std::span<const uint8_t, 32> shipriv, std::span<const uint8_t, 32> shipub) noexcept
+    {
+        lt_ret_t ret = lt_session_start(h.get(), stpub.data(), pkey_index, shipriv.data(), shipub.data());
+        if (ret != LT_OK) {
+            return Error(ret);
+        }
+        return Session(h.get());
+    }
+
+#ifdef LT_HELPERS
+    /** @brief Establishes secure session by `lt_verify_chip_and_start_secure_session()` */
+    static Result<Session> verify_and_start(Handle &h, std::span<const uint8_t, 32> shipriv,
+                                            std::span<const uint8_t, 32> shipub, const uint8_t pkey_index) noexcept
+    {
+        // Keys are only read by the C function
+        lt_ret_t ret = lt_verify_chip_and_start_secure_session(h.get(), const_cast<uint8_t *>(shipriv.data()),
+                                                               const_cast<uint8_t *>(shipub.data()), pkey_index);
+        if (ret != LT_OK) {
+            return Error(ret);
+        }
+        return Session(h.get());
+    }
+#endif
+
+    Session(Session &&other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+    Session &operator=(Session &&other) noexcept
+    {
+        if (this != &other) {
+            (void)abort();
+            h_ = std::exchange(other.h_, nullptr);
+        }
+        return *this;
+    }
+    ~Session() { (void)abort(); }
+
+    /** @brief Ends the session by `lt_session_abort()`, for callers interested in its result */
+    Result<void> abort() noexcept
+    {
+        if (!h_) {
+            return {};
+        }
+        return detail::check(lt_session_abort(std::exchange(h_, nullptr)));
+    }
+
+    /** @brief The C handle of the session, for functions without a wrapper */
+    lt_handle_t *get() const noexcept { return h_; }
+
+    /** @brief Same as `lt_ping()`, `msg_in` receives `msg_out.size()` bytes */
+    Result<void> ping(std::span<const uint8_t> msg_out, std::span<uint8_t> msg_in) noexcept
+    {
+        if (msg_in.size() < msg_out.size()) {
+            return Error(LT_PARAM_ERR);
+        }
+        return detail::check(lt_ping(h_, msg_out.data(), msg_in.data(), detail::len16(msg_out.size())));
+    }
+
+    /** @brief Same as `lt_random_value_get()`, fills the whole buffer */
+    Result<void> random_value_get(std::span<uint8_t> buff) noexcept
+    {
+        return detail::check(lt_random_value_get(h_, buff.data(), detail::len16(buff.size())));
+    }
+
+    /** @brief Same as `lt_ecc_key_generate()` */
+    Result<void> ecc_key_generate(const ecc_slot_t slot, const lt_ecc_curve_type_t curve) noexcept
+    {
+        return detail::check(lt_ecc_key_generate(h_, slot, curve));
+    }
+
+    /** @brief Same as `lt_ecc_key_store()`, `key` is the 32B private key */
+    Result<void> ecc_key_store(const ecc_slot_t slot, const lt_ecc_curve_type_t curve,
+                               std::span<const uint8_t, 32> key) noexcept
+    {
+        return detail::check(lt_ecc_key_store(h_, slot, curve, key.data()));
+    }
+
+    /** @brief Same as `lt_ecc_key_read()`, the key is read into `key` and returned as its subspan */
+    Result<EccKey> ecc_key_read(const ecc_slot_t slot, std::span<uint8_t, 64> key) noexcept
+    {
+        EccKey k{{}, CURVE_P256, CURVE_GENERATED};
+        lt_ret_t ret = lt_ecc_key_read(h_, slot, key.data(), &k.curve, &k.origin);
+        if (ret != LT_OK) {
+            return Error(ret);
+        }
+        k.key = std::span<uint8_t>(key).first((k.curve == CURVE_P256) ? 64 : 32);
+        return k;
+    }
+
+    /** @brief Same as `lt_ecc_key_erase()` */
+    Result<void> ecc_key_erase(const ecc_slot_t slot) noexcept { return detail::check(lt_ecc_key_erase(h_, slot)); }
+
+    /** @brief Same as `lt_ecc_ecdsa_sign_digest()` */
+    Result<void> ecdsa_sign_digest(const ecc_slot_t slot, std::span<const uint8_t, 32> digest,
+                                   std::span<uint8_t, 64> rs) noexcept
+    {
+        return detail::check(lt_ecc_ecdsa_sign_digest(h_, slot, digest.data(), rs.data()));
+    }
+
+    /** @brief Same as `lt_ecc_eddsa_sign()` */
+    Result<void> eddsa_sign(const ecc_slot_t slot, std::span<const uint8_t> msg, std::span<uint8_t, 64> rs) noexcept
+    {
+        return detail::check(lt_ecc_eddsa_sign(h_, slot, msg.data(), detail::len16(msg.size()), rs.data()));
+    }
+
+    /** @brief Same as `lt_mac_and_destroy()` */
+    Result<void> mac_and_destroy(const mac_and_destroy_slot_t slot, std::span<const uint8_t, 32> data_out,
+                                 std::span<uint8_t, 32> data_in) noexcept
+    {
+        return detail::check(lt_mac_and_destroy(h_, slot, data_out.data(), data_in.data()));
+    }
+
+#if LT_ENABLE_R_MEM
+    /** @brief Same as `lt_r_mem_data_read()`, the data are read into `data` and returned as its subspan */
+    Result<std::span<uint8_t>> r_mem_data_read(const uint16_t slot, std::span<uint8_t, R_MEM_DATA_SIZE_MAX> data) noexcept
+    {
+        uint16_t size = 0;
+        lt_ret_t ret = lt_r_mem_data_read(h_, slot, data.data(), &size);
+        if (ret != LT_OK) {
+            return Error(ret);
+        }
+        return std::span<uint8_t>(data).first(size);
+    }
+
+    /** @brief Same as `lt_r_mem_data_write()` */
+    Result<void> r_mem_data_write(const uint16_t slot, std::span<const uint8_t> data) noexcept
+    {
+        return detail::check(lt_r_mem_data_write(h_, slot, data.data(), detail::len16(data.size())));
+    }
+
+    /** @brief Same as `lt_r_mem_data_erase()` */
+    Result<void> r_mem_data_erase(const uint16_t slot) noexcept { return detail::check(lt_r_mem_data_erase(h_, slot)); }
+#endif
+
+#if LT_ENABLE_MCOUNTER
+    /** @brief Same as `lt_mcounter_init()` */
+    Result<void> mcounter_init(const lt_mcounter_index_t index, const uint32_t value) noexcept
+    {
+        return detail::check(lt_mcounter_init(h_, index, value));
+    }
+
+    /** @brief Same as `lt_mcounter_update()` */
+    Result<void> mcounter_update(const lt_mcounter_index_t index) noexcept
+    {
+        return detail::check(lt_mcounter_update(h_, index));
+    }
+
+    /** @brief Same as `lt_mcounter_get()` */
+    Result<uint32_t> mcounter_get(const lt_mcounter_index_t index) noexcept
+    {
+        uint32_t value = 0;
+        lt_ret_t ret = lt_mcounter_get(h_, index, &value);
+        if (ret != LT_OK) {
+            return Error(ret);
+        }
+        return value;
+    }
+#endif
+
+   private:
+    explicit Session(lt_handle_t *h) noexcept : h_(h) {}
+
+    lt_handle_t *h_;
+};
+
+#if LT_ASYNC
+/**
+ * @brief Coroutine type for coroutines awaiting `Async` operations. It starts right away, runs until it completes and
+ * its frame is freed when it completes, nothing waits for it.
+ */
+class Task {
+   public:
+    struct promise_type {
+        Task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Awaitable operation of `Async`. It is submitted by `lt_submit()` when awaited, the awaiting coroutine is
+ * resumed from `lt_poll()` with the result of the operation.
+ *
+ * The buffers of the operation are used in place, they must outlive the `co_await`.
+ */
+class [[nodiscard]] AsyncOp {
+   public:
+    AsyncOp(const AsyncOp &) = delete;
+    AsyncOp &operator=(const AsyncOp &) = delete;
+
+    bool await_ready() const noexcept { return false; }
+
+    /** Returns false, so the coroutine is not suspended, when the operation was not submitted */
+    bool await_suspend(std::coroutine_handle<> coro) noexcept
+    {
+        if (ret_ != LT_OK) {
+            return false;
+        }
+        coro_ = coro;
+        ret_ = lt_submit(h_, &op_, &AsyncOp::done, this);
+        return ret_ == LT_OK;
+    }
+
+    Result<void> await_resume() const noexcept { return detail::check((ret_ != LT_OK) ? ret_ : op_.ret); }
+
+   private:
+    friend class Async;
+
+    AsyncOp(lt_handle_t *h, const lt_async_cmd_t cmd, const uint16_t slot, std::span<const uint8_t> in,
+            uint8_t *out) noexcept
+        : h_(h)
+    {
+        op_.cmd = cmd;
+        op_.slot = slot;
+        op_.in = in.data();
+        op_.in_len = detail::len16(in.size());
+        op_.out = out;
+    }
+
+    /** @brief Operation failing with `ret` without being submitted */
+    AsyncOp(lt_handle_t *h, const lt_ret_t ret) noexcept : h_(h), ret_(ret) {}
+
+    static void done(lt_handle_t *, lt_async_op_t *, void *ctx) noexcept
+    {
+        static_cast<AsyncOp *>(ctx)->coro_.resume();
+    }
+
+    lt_handle_t *h_;
+    lt_async_op_t op_{};
+    lt_ret_t ret_ = LT_OK;
+    std::coroutine_handle<> coro_;
+};
+
+/**
+ * @brief Queue of asynchronous operations of a session, placed into `lt_handle_t.async` for its lifetime.
+ *
+ * While operations are queued, the session must not be used by its blocking members. An event loop drives the queue
+ * by `poll()`:
+ *
+ * @code
+ * tropic::Task sign(tropic::Async &async, std::span<const uint8_t, 32> digest, std::span<uint8_t, 64> rs)
+ * {
+ *     auto res = co_await async.ecdsa_sign_digest(ECC_SLOT_0, digest, rs);
+ *     ...
+ * }
+ *
+ * sign(async, digest, rs);
+ * uint32_t wait_ms;
+ * while (async.poll(wait_ms) == LT_PENDING) {
+ *     // wait_ms or other work
+ * }
+ * @endcode
+ */
+class Async {
+   public:
+    explicit Async(Session &session) noexcept : h_(session.get()) { h_->async = &queue_; }
+    Async(const Async &) = delete;
+    Async &operator=(const Async &) = delete;
+    /** The queue must be empty */
+    ~Async() { h_->async = nullptr; }
+
+    /** @brief Same as `lt_poll()`, resumes coroutines of completed operations */
+    lt_ret_t poll(uint32_t &wait_ms) noexcept { return lt_poll(h_, &wait_ms); }
+
+    /** @brief True when no operation is queued */
+    bool empty() const noexcept { return queue_.head == nullptr; }
+
+    /** @brief Awaitable `lt_ping()`, `msg_in` receives `msg_out.size()` bytes */
+    AsyncOp ping(std::span<const uint8_t> msg_out, std::span<uint8_t> msg_in) noexcept
+    {
+        if (msg_in.size() < msg_out.size()) {
+            return AsyncOp(h_, LT_PARAM_ERR);
+        }
+        return AsyncOp(h_, LT_ASYNC_PING, 0, msg_out, msg_in.data());
+    }
+
+    /** @brief Awaitable `lt_random_value_get()`, fills the whole buffer */
+    AsyncOp random_value_get(std::span<uint8_t> buff) noexcept
+    {
+        return AsyncOp(h_, LT_ASYNC_RANDOM_VALUE_GET, 0, std::span<const uint8_t>(buff.data(), buff.size()),
+                       buff.data());
+    }
+
+    /** @brief Awaitable `lt_ecc_ecdsa_sign_digest()` */
+    AsyncOp ecdsa_sign_digest(const ecc_slot_t slot, std::span<const uint8_t, 32> digest,
+                              std::span<uint8_t, 64> rs) noexcept
+    {
+        return AsyncOp(h_, LT_ASYNC_ECDSA_SIGN_DIGEST, static_cast<uint16_t>(slot), digest, rs.data());
+    }
+
+    /** @brief Awaitable `lt_ecc_eddsa_sign()` */
+    AsyncOp eddsa_sign(const ecc_slot_t slot, std::span<const uint8_t> msg, std::span<uint8_t, 64> rs) noexcept
+    {
+        return AsyncOp(h_, LT_ASYNC_EDDSA_SIGN, static_cast<uint16_t>(slot), msg, rs.data());
+    }
+
+    /** @brief Awaitable `lt_mac_and_destroy()` */
+    AsyncOp mac_and_destroy(const mac_and_destroy_slot_t slot, std::span<const uint8_t, 32> data_out,
+                            std::span<uint8_t, 32> data_in) noexcept
+    {
+        return AsyncOp(h_, LT_ASYNC_MAC_AND_DESTROY, static_cast<uint16_t>(slot), data_out, data_in.data());
+    }
+
+   private:
+    lt_handle_t *h_;
+    lt_async_t queue_{};
+};
+#endif
+
+}  // namespace tropic
+
+#endif  // LT_LIBTROPIC_HPP
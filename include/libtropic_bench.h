@@ -0,0 +1,201 @@
+#ifndef LT_LIBTROPIC_BENCH_H
+#define LT_LIBTROPIC_BENCH_H
+
+/**
+ * @defgroup libtropic_bench libtropic benchmarks
+ * @brief Measure latency and throughput of main API functions end to end.
+ * @details Built with `-DLT_BUILD_BENCH=1`. Each scenario is executed `LT_BENCH_ITERATIONS` times and its result
+ * is logged and printed to stdout as one line of JSON, see docs/other/benchmarks.md. `lt_soak()` generates
+ * sustained load for hours instead.
+ * @{
+ */
+
+/**
+ * @file libtropic_bench.h
+ * @brief Functions with benchmarks of TROPIC01 chip
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Number of measured executions of each scenario */
+#ifndef LT_BENCH_ITERATIONS
+#define LT_BENCH_ITERATIONS 50
+#endif
+
+/** @brief ECC slot used for the ECDSA benchmark, its key is generated and erased by the benchmark */
+#ifndef LT_BENCH_ECDSA_SLOT
+#define LT_BENCH_ECDSA_SLOT ECC_SLOT_30
+#endif
+
+/** @brief ECC slot used for the EdDSA benchmark, its key is generated and erased by the benchmark */
+#ifndef LT_BENCH_EDDSA_SLOT
+#define LT_BENCH_EDDSA_SLOT ECC_SLOT_31
+#endif
+
+/** @brief R-memory slot used for the R-memory benchmarks, it is erased by the benchmark */
+#ifndef LT_BENCH_R_MEM_SLOT
+#define LT_BENCH_R_MEM_SLOT R_MEM_DATA_SLOT_MAX
+#endif
+
+/** @brief Monotonic counter used for the update benchmark, it is reinitialized by the benchmark */
+#ifndef LT_BENCH_MCOUNTER
+#define LT_BENCH_MCOUNTER MCOUNTER_INDEX_15
+#endif
+
+#ifndef LT_EXAMPLE_TEST_KEYS_DECLARED
+#define LT_EXAMPLE_TEST_KEYS_DECLARED
+extern uint8_t sh0priv[];
+extern uint8_t sh0pub[];
+
+extern uint8_t sh1priv[];
+extern uint8_t sh1pub[];
+
+extern uint8_t sh2priv[];
+extern uint8_t sh2pub[];
+
+extern uint8_t sh3priv[];
+extern uint8_t sh3pub[];
+#endif  // LT_EXAMPLE_TEST_KEYS_DECLARED
+
+/**
+ * @brief Returns microseconds of a monotonic clock, used to measure latency.
+ * @details The default implementation returns 0, so latencies are reported as 0. Platforms override it.
+ *
+ * @return       Microseconds since an arbitrary point.
+ */
+uint64_t lt_bench_time_us(void);
+
+/**
+ * @brief Returns microseconds of CPU time consumed by the host process.
+ * @details The default implementation returns 0. Platforms with such a clock override it.
+ *
+ * @return       Microseconds of CPU time since an arbitrary point.
+ */
+uint64_t lt_bench_cpu_us(void);
+
+/**
+ * @brief Runs all benchmark scenarios.
+ *
+ * Scenarios:
+ *  - session_start: Secure Session establishment with pairing key slot 0.
+ *  - ping: Ping L3 command with 1 B up to LT_PING_LEN_MAX of data.
+ *  - ecdsa_sign, eddsa_sign: signing of a 32 B message by a key generated in advance.
+ *  - random_value_get: RANDOM_VALUE_GET_LEN_MAX bytes.
+ *  - r_mem_write (erase and write, TROPIC01 does not overwrite a slot), r_mem_read: 32 B and R_MEM_DATA_SIZE_MAX.
+ *  - r_config_read: one R-Config object.
+ *  - mcounter_update: update of one monotonic counter.
+ *
+ * The keys, the R-memory slot and the monotonic counter used are left erased or reinitialized.
+ *
+ * @param h     Device's handle
+ *
+ * @retval       0  All scenarios executed successfully
+ * @retval      -1  Setup failed or some operation of a scenario failed
+ */
+int lt_bench(lt_handle_t *h);
+
+/** @brief Number of handles `lt_soak()` can drive */
+#ifndef LT_SOAK_HANDLES_MAX
+#define LT_SOAK_HANDLES_MAX 8
+#endif
+
+/**
+ * @brief Sub-buckets per power of two in latency histograms of `lt_soak()` as a power of two, 4 gives latencies
+ * within 6.25 %
+ */
+#ifndef LT_SOAK_HIST_SUB_BITS
+#define LT_SOAK_HIST_SUB_BITS 4
+#endif
+
+/** @brief Operations of the `lt_soak()` mix */
+typedef enum lt_soak_op_t {
+    /** `lt_ping()` of LT_SOAK_PING_SIZE bytes */
+    LT_SOAK_PING,
+    /** `lt_random_value_get()` of RANDOM_VALUE_GET_LEN_MAX bytes */
+    LT_SOAK_RANDOM,
+    /** `lt_ecc_ecdsa_sign()` of a 32 B message by the key in LT_BENCH_ECDSA_SLOT */
+    LT_SOAK_ECDSA_SIGN,
+    /** `lt_ecc_eddsa_sign()` of a 32 B message by the key in LT_BENCH_EDDSA_SLOT */
+    LT_SOAK_EDDSA_SIGN,
+    /** `lt_r_mem_data_read()` of LT_BENCH_R_MEM_SLOT */
+    LT_SOAK_R_MEM_READ,
+    /** `lt_r_mem_data_erase()` and `lt_r_mem_data_write()` of LT_BENCH_R_MEM_SLOT, wears the slot out */
+    LT_SOAK_R_MEM_WRITE,
+    /** `lt_mcounter_update()` of LT_BENCH_MCOUNTER, reinitialized when it reaches 0 */
+    LT_SOAK_MCOUNTER_UPDATE,
+    LT_SOAK_OPS
+} lt_soak_op_t;
+
+/** @brief Bytes sent by LT_SOAK_PING */
+#ifndef LT_SOAK_PING_SIZE
+#define LT_SOAK_PING_SIZE 64
+#endif
+
+/** @brief Bytes written and read by LT_SOAK_R_MEM_WRITE and LT_SOAK_R_MEM_READ */
+#ifndef LT_SOAK_R_MEM_SIZE
+#define LT_SOAK_R_MEM_SIZE 32
+#endif
+
+/** @brief Load generated by `lt_soak()` */
+typedef struct lt_soak_config_t {
+    /** @brief Run time in seconds, 0 runs until `ops` operations are executed */
+    uint32_t duration_s;
+    /** @brief Number of operations, 0 runs for `duration_s` */
+    uint32_t ops;
+    /** @brief Target rate of all handles together in operations per second, 0 runs flat out */
+    uint32_t rate;
+    /** @brief Seconds between snapshots, 0 prints only the final result */
+    uint32_t snapshot_s;
+    /** @brief Relative weight of each operation in the mix, indexed by `lt_soak_op_t`, 0 leaves it out */
+    uint8_t weights[LT_SOAK_OPS];
+} lt_soak_config_t;
+
+/**
+ * @brief Sets the default load: 60 s flat out with snapshots every 10 s, mix of ping, random, ECDSA and EdDSA
+ * signing (2 each) and R-memory read (1). Writes of R-memory and monotonic counter updates wear the chip out and are
+ * left out.
+ *
+ * @param cfg    Configuration to set
+ */
+void lt_soak_config_default(lt_soak_config_t *cfg);
+
+/**
+ * @brief Sets weights of the mix from a string like "ecdsa_sign=4,ping=1", operations not listed get weight 0
+ * @details Names are ping, random, ecdsa_sign, eddsa_sign, r_mem_read, r_mem_write and mcounter_update.
+ *
+ * @param cfg    Configuration whose weights are set
+ * @param mix    Comma separated name=weight pairs
+ *
+ * @retval       0  Mix was set
+ * @retval      -1  Unknown operation, invalid weight or all weights are 0, weights are left unchanged
+ */
+int lt_soak_mix_parse(lt_soak_config_t *cfg, const char *mix);
+
+/**
+ * @brief Runs the mix of operations on the handles for hours, at a target rate or flat out.
+ * @details Operations are spread over the handles round robin, each handle is initialized and its secure session
+ * started by the soak. Latency of each operation is recorded in a log-linear (HDR-style) histogram, with a target
+ * rate it is measured from the time the operation was due, so a chip falling behind shows up in the latencies. A
+ * failed operation is counted and the secure session of its handle restarted.
+ *
+ * Every `snapshot_s` one line of JSON with latencies of the interval, retries and nonces is printed, at the end one
+ * line with the totals and the histograms, see docs/other/benchmarks.md. The platform has to override
+ * `lt_bench_time_us()`, with its default clock only `ops` ends the run.
+ *
+ * @param hs     Handles, each of a different chip
+ * @param cnt    Number of handles, at most LT_SOAK_HANDLES_MAX
+ * @param cfg    Load to generate
+ *
+ * @retval       0  All operations executed successfully
+ * @retval      -1  Setup failed or some operations failed
+ */
+int lt_soak(lt_handle_t *const *hs, const uint8_t cnt, const lt_soak_config_t *cfg);
+
+/** @} */  // end of libtropic_bench group
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef LIBTROPIC_BUDGET_H
+#define LIBTROPIC_BUDGET_H
+
+/**
+ * @defgroup libtropic_budget libtropic time budget
+ * @brief Expected and worst-case duration of an L3 command, so schedulers can place chip operations before deadlines
+ * @details `lt_budget_l3()` computes how long one call executing an L3 command in the secure session takes, from the
+ * lengths of the command and its result, without communicating with TROPIC01. It follows what the call does: each
+ * chunk of the encrypted command is written and its acknowledgment polled, then each chunk of the result is polled
+ * and read. Polls follow the polling profiles of the handle with LT_ADAPTIVE_POLLING (the learned first delay
+ * included), otherwise they come every LT_L1_READ_RETRY_DELAY ms, and they wait for INT pin with LT_USE_INT_PIN in
+ * application mode. A chunk damaged on its way is transferred again at most `lt_l2_chunk_retries()` times.
+ *
+ * `lt_budget_t` holds three figures:
+ *  - `expected_us`: without retries, responses are ready after the times learned by polling statistics (or the
+ *    expected execution time of the command), SPI runs at its current clock.
+ *  - `ready_worst_us`: responses are ready after the longest times learned (at least the expected execution time),
+ *    each of them found by the last poll the profile allows, every chunk transferred again as often as allowed, SPI
+ *    runs at the lowest clock of its tuner and every delay is overrun by the longest oversleep. This is the budget
+ *    of a call on a healthy chip.
+ *  - `worst_us`: bound by which the call returns in any case. Each read is given up after its poll limit
+ *    (LT_L1_READ_MAX_TRIES), plus one SPI transfer running into its timeout.
+ *
+ * Port is described by `lt_budget_port_t`. Its values left zero are taken from the handle: the clock from
+ * `h->l2.spi_tune` (LT_USE_SPI_SPEED) and oversleep of delays from `h->l2.stats` (LT_STATS). Time of host encryption
+ * and decryption is taken from `h->l2.stats` once the command was measured there, otherwise it is not included.
+ * @{
+ */
+
+/**
+ * @file libtropic_budget.h
+ * @brief Time budget declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Characteristics of the port, e.g. measured by `lt_link_probe()` or by the port itself */
+typedef struct lt_budget_port_t {
+    /** @brief SPI clock in Hz, 0 takes the clock of `h->l2.spi_tune` */
+    uint32_t spi_hz;
+    /** @brief Time of one SPI transfer besides its bytes in us, e.g. chip select and the driver call */
+    uint32_t transfer_us;
+    /** @brief Longest time of one SPI transfer besides its bytes in us, 0 takes `transfer_us` */
+    uint32_t transfer_max_us;
+    /** @brief Longest time by which a delay overruns its length in us, 0 takes the one measured in `h->l2.stats` */
+    uint32_t oversleep_max_us;
+} lt_budget_port_t;
+
+/** @brief Budget of one call, see `lt_budget_l3()` */
+typedef struct lt_budget_t {
+    /** @brief Expected duration in us */
+    uint32_t expected_us;
+    /** @brief Longest duration when TROPIC01 answers within the longest times learned, in us */
+    uint32_t ready_worst_us;
+    /** @brief Bound by which the call returns in any case, in us */
+    uint32_t worst_us;
+    /** @brief L2 frames exchanged without retries: chunks of the command, their acknowledgments, chunks of the result */
+    uint16_t frames;
+    /** @brief L2 frames exchanged with all retries */
+    uint16_t frames_max;
+} lt_budget_t;
+
+/**
+ * @brief Computes budget of one call executing the L3 command, e.g. `lt_ecc_ecdsa_sign()` for ECDSA_Sign
+ *
+ * @param h           Device's handle
+ * @param port        Characteristics of the port, NULL takes all of them from the handle
+ * @param cmd_id      ID of the L3 command
+ * @param cmd_len     Length of the command from CMD_ID, within the sizes of the command
+ * @param res_len     Length of the result from RESULT, 0 for the longest successful result of the command
+ * @param budget      Budget
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter, a command unknown to libtropic, lengths out of its sizes or no SPI
+ * clock known
+ */
+lt_ret_t lt_budget_l3(lt_handle_t *h, const lt_budget_port_t *port, const uint8_t cmd_id, const uint16_t cmd_len,
+                      const uint16_t res_len, lt_budget_t *budget);
+
+/** @} */  // end of libtropic_budget group
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef LIBTROPIC_CERT_CHAIN_H
+#define LIBTROPIC_CERT_CHAIN_H
+
+/**
+ * @defgroup libtropic_cert_chain libtropic certificate chain verification
+ * @brief Host-side verification of the certificate chain read by `lt_get_info_cert_store()`
+ * @details The root certificate of the store must match the pinned fingerprint (SHA-256 of its DER encoding). Each
+ * other certificate must name the next one as its issuer and must be signed by its key. Fingerprints of verified
+ * intermediate certificates are cached in `lt_cert_chain_t`, so for each next chip of the same batch only the
+ * signature of its device certificate is checked.
+ *
+ * Signatures are checked by a callback. `lt_cert_chain_verify_builtin()` supports ecdsa-with-SHA256 on P-256 and
+ * Ed25519 with the crypto backend of libtropic. Certificates of TROPIC01 are signed by P-384 and P-521 keys, which
+ * need a callback based on a library supporting these curves (e.g. `mbedtls_pk_verify()`).
+ *
+ * Validity period and extensions are not checked, the host usually has no trusted time.
+ * @{
+ */
+
+/**
+ * @file libtropic_cert_chain.h
+ * @brief Certificate chain verification declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Size of certificate fingerprint (SHA-256) */
+#define LT_CERT_FP_SIZE 32
+
+/** @brief Number of intermediate certificates whose fingerprints are cached */
+#ifndef LT_CERT_CHAIN_CACHE_SIZE
+#define LT_CERT_CHAIN_CACHE_SIZE 4
+#endif
+
+/** @brief Signature algorithm of certificate */
+typedef enum lt_cert_sig_alg_t {
+    LT_CERT_SIG_ECDSA_SHA256 = 0,
+    LT_CERT_SIG_ECDSA_SHA384 = 1,
+    LT_CERT_SIG_ECDSA_SHA512 = 2,
+    LT_CERT_SIG_ED25519 = 3
+} lt_cert_sig_alg_t;
+
+/**
+ * @brief Checks signature of a certificate
+ *
+ * @param ctx       Argument given to `lt_cert_chain_init()`
+ * @param alg       Signature algorithm
+ * @param tbs       Signed part of the certificate (DER of TBSCertificate)
+ * @param tbs_len   Length of `tbs`
+ * @param spki      Issuer's key (DER of SubjectPublicKeyInfo)
+ * @param spki_len  Length of `spki`
+ * @param sig       Signature, content of the signatureValue BIT STRING (DER of ECDSA-Sig-Value for ECDSA)
+ * @param sig_len   Length of `sig`
+ *
+ * @retval          LT_OK Signature is valid
+ * @retval          LT_CRYPTO_ERR Signature is not valid
+ * @retval          LT_CERT_UNSUPPORTED Algorithm or key is not supported
+ */
+typedef lt_ret_t (*lt_cert_sig_verify_t)(void *ctx, const lt_cert_sig_alg_t alg, const uint8_t *tbs,
+                                         const uint16_t tbs_len, const uint8_t *spki, const uint16_t spki_len,
+                                         const uint8_t *sig, const uint16_t sig_len);
+
+/**
+ * @brief Chain verifier initialized by `lt_cert_chain_init()`
+ */
+typedef struct lt_cert_chain_t {
+    /** @private @brief Fingerprint of the trusted root certificate */
+    uint8_t root_fp[LT_CERT_FP_SIZE];
+    /** @private @brief Callback checking signatures */
+    lt_cert_sig_verify_t verify;
+    /** @private @brief Argument of `verify` */
+    void *verify_ctx;
+    /** @private @brief Fingerprints of verified intermediate certificates */
+    uint8_t cache[LT_CERT_CHAIN_CACHE_SIZE][LT_CERT_FP_SIZE];
+    /** @private @brief Number of valid entries of `cache` */
+    uint8_t cache_cnt;
+    /** @private @brief Entry of `cache` replaced next */
+    uint8_t cache_next;
+    /** @brief Number of signatures checked by the last `lt_cert_chain_verify()` */
+    uint8_t sig_checks;
+} lt_cert_chain_t;
+
+/**
+ * @brief Initializes chain verifier with empty cache
+ *
+ * @param c           Chain verifier
+ * @param root_fp     Fingerprint of the trusted root certificate, LT_CERT_FP_SIZE bytes
+ * @param verify      Callback checking signatures, e.g. `lt_cert_chain_verify_builtin`
+ * @param verify_ctx  Argument of `verify`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_cert_chain_init(lt_cert_chain_t *c, const uint8_t *root_fp, lt_cert_sig_verify_t verify,
+                            void *verify_ctx);
+
+/**
+ * @brief Verifies certificate chain of the store, verified intermediate certificates are added to the cache
+ *
+ * @param c           Chain verifier
+ * @param store       Certificate store read by `lt_get_info_cert_store()`
+ *
+ * @retval            LT_OK Chain is valid
+ * @retval            LT_FAIL Root certificate is not trusted, or issuer of a certificate does not match
+ * @retval            LT_CRYPTO_ERR Signature of a certificate is not valid
+ * @retval            other Certificate cannot be parsed or its algorithm is not supported
+ */
+lt_ret_t lt_cert_chain_verify(lt_cert_chain_t *c, const struct lt_cert_store_t *store);
+
+/**
+ * @brief Drops all cached certificates, e.g. when a certificate was revoked
+ *
+ * @param c           Chain verifier
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_cert_chain_cache_flush(lt_cert_chain_t *c);
+
+/**
+ * @brief `lt_cert_sig_verify_t` using crypto backend of libtropic, supports LT_CERT_SIG_ECDSA_SHA256 with P-256
+ * key and LT_CERT_SIG_ED25519
+ */
+lt_ret_t lt_cert_chain_verify_builtin(void *ctx, const lt_cert_sig_alg_t alg, const uint8_t *tbs,
+                                      const uint16_t tbs_len, const uint8_t *spki, const uint16_t spki_len,
+                                      const uint8_t *sig, const uint16_t sig_len);
+
+/** @} */  // end of libtropic_cert_chain group
+
+#endif
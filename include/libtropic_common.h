@@ -9,10 +9,16 @@
  */
 
 #include "libtropic_macros.h"
+#include "stddef.h"
 #include "stdint.h"
 #include "tropic01_application_co.h"
 #include "tropic01_bootloader_co.h"
 
+#if USE_MBEDTLS
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha256.h"
+#endif
+
 // This macro is used to change static functions into exported one, when compiling unit tests.
 // It allows to unit test static functions.
 #ifndef TEST
@@ -21,6 +27,17 @@
 #define LT_STATIC
 #endif
 
+// Groups of L3 commands, which can be compiled out by defining the macro to 0 (see LT_ENABLE_* options in CMake)
+#ifndef LT_ENABLE_FW_UPDATE
+#define LT_ENABLE_FW_UPDATE 1
+#endif
+#ifndef LT_ENABLE_R_MEM
+#define LT_ENABLE_R_MEM 1
+#endif
+#ifndef LT_ENABLE_MCOUNTER
+#define LT_ENABLE_MCOUNTER 1
+#endif
+
 /** @brief This particular value means that secure session was successfully established and it is currently ON */
 #define SESSION_ON 0xA5A55A5A
 /** @brief This particular value means that secure session is currently OFF */
@@ -51,6 +68,14 @@
 /** @brief Maximal number of data bytes in one L1 transfer */
 #define LT_L1_LEN_MAX (1 + 1 + 1 + L2_CHUNK_MAX_DATA_SIZE + 2)
 
+#ifndef LT_L2_BUFF_ALIGN
+/** @brief Alignment of `lt_l2_state_t.buff`, e.g. size of a cache line for ports transferring it by DMA in place */
+#define LT_L2_BUFF_ALIGN 1
+#endif
+/** @brief Size of `lt_l2_state_t.buff`, padded to whole LT_L2_BUFF_ALIGN units, so no other data share its lines */
+#define LT_L2_BUFF_SIZE \
+    ((((1 + L2_MAX_FRAME_SIZE) + LT_L2_BUFF_ALIGN - 1) / LT_L2_BUFF_ALIGN) * LT_L2_BUFF_ALIGN)
+
 /** @brief Maximum size of l3 ciphertext (or decrypted l3 packet) */
 #define L3_CYPHERTEXT_MAX_SIZE (L3_CMD_ID_SIZE + L3_CMD_DATA_SIZE_MAX)
 /**
@@ -86,31 +111,487 @@ STATIC_ASSERT(
 
 //--------------------------------------------------------------------------------------------------------------------//
 
+#if LT_ADAPTIVE_POLLING
+/** @brief Polling key of a plain L2 request, used in `lt_l1_poll_profile_t` and `lt_l1_poll_stats_t` */
+#define LT_L1_POLL_CMD_L2(req_id) ((uint16_t)(req_id))
+/** @brief Polling key of an L3 command, used in `lt_l1_poll_profile_t` and `lt_l1_poll_stats_t` */
+#define LT_L1_POLL_CMD_L3(cmd_id) ((uint16_t)(0x100u | (cmd_id)))
+/** @brief Polling key of acknowledgment of each chunk of an encrypted L3 command */
+#define LT_L1_POLL_CMD_L3_CHUNK ((uint16_t)0x200u)
+/** @brief Number of commands for which polling statistics are kept in the handle */
+#define LT_L1_POLL_STATS_CNT 16
+
+/**
+ * @brief Polling schedule of one command, used by `lt_l1_read()` while waiting for the response.
+ *
+ * The first poll is done after `first_delay_us`. Each unsuccessful poll is followed by a gap, which starts at
+ * `retry_delay_us` and doubles after each poll, up to `max_delay_us`. Gaps shorter than a milisecond need
+ * LT_USE_DELAY_US, otherwise they are rounded up to whole miliseconds.
+ */
+typedef struct lt_l1_poll_profile_t {
+    /** @brief LT_L1_POLL_CMD_L2(), LT_L1_POLL_CMD_L3() or LT_L1_POLL_CMD_L3_CHUNK key of the command */
+    uint16_t cmd;
+    /** @brief Expected execution time in us, delay before the first poll */
+    uint32_t first_delay_us;
+    /** @brief Gap after the first unsuccessful poll in us */
+    uint32_t retry_delay_us;
+    /** @brief Maximal gap between two polls in us */
+    uint32_t max_delay_us;
+} lt_l1_poll_profile_t;
+
+/** @brief Polling statistics of one command, learned by `lt_l1_read()` */
+typedef struct lt_l1_poll_stats_t {
+    /** @brief LT_L1_POLL_CMD_L2() or LT_L1_POLL_CMD_L3() key of the command, zero when the slot is free */
+    uint16_t cmd;
+    /** @brief Number of received responses */
+    uint32_t cnt;
+    /** @brief Total number of polls done (including the successful ones) */
+    uint32_t polls;
+    /** @brief Time waited for the last response in us */
+    uint32_t last_us;
+    /** @brief Shortest time waited for a response in us */
+    uint32_t min_us;
+    /** @brief Longest time waited for a response in us */
+    uint32_t max_us;
+    /** @brief Moving average (1/8 weight of new sample) of time waited for a response in us */
+    uint32_t avg_us;
+    /** @brief Longest response (data and CRC) in bytes */
+    uint16_t len_max;
+} lt_l1_poll_stats_t;
+
+/** @brief Polling configuration and statistics kept in the handle */
+typedef struct lt_l1_poll_t {
+    /** @public @brief Array of profiles, when NULL, libtropic's default profiles are used */
+    const lt_l1_poll_profile_t *profiles;
+    /** @public @brief Number of items in `profiles` */
+    uint8_t profiles_cnt;
+    /** @public @brief When nonzero, the first poll is done after the shortest learned time if it is shorter */
+    uint8_t learn;
+    /** @private @brief Key of the command whose response is awaited */
+    uint16_t cmd;
+    /** @private @brief ID of the last encrypted L3 command */
+    uint8_t l3_cmd_id;
+    /** @public @brief Learned statistics, read only */
+    lt_l1_poll_stats_t stats[LT_L1_POLL_STATS_CNT];
+} lt_l1_poll_t;
+#endif
+
+#if LT_SPECULATIVE_READ
+/**
+ * @brief Value of `lt_l2_state_t.spec_len`, which selects the longest response of the awaited command seen so far
+ * (needs LT_ADAPTIVE_POLLING). Without knowledge of the command, whole frame is read speculatively.
+ */
+#define LT_L1_SPEC_LEN_AUTO 0xffff
+#endif
+
+/** @brief State of polling for one response, used by `lt_l1_read_start()` and `lt_l1_read_step()` */
+typedef struct lt_l1_poll_sched_t {
+    /** @private @brief Time spent waiting so far in us */
+    uint32_t waited_us;
+    /** @private @brief Number of polls done so far */
+    uint32_t polls;
+    /** @private @brief Time to wait before the next poll in us */
+    uint32_t next_us;
+#if LT_ADAPTIVE_POLLING
+    /** @private @brief Gap after the next unsuccessful poll in us */
+    uint32_t delay_us;
+    /** @private @brief Maximal gap between two polls in us */
+    uint32_t max_delay_us;
+    /** @private @brief Statistics of the awaited command, NULL when there is no free slot */
+    lt_l1_poll_stats_t *stats;
+#endif
+#if LT_SPECULATIVE_READ
+    /** @private @brief Number of response bytes read together with CHIP_STATUS */
+    uint16_t spec_len;
+#endif
+#if LT_USE_SPI_TRANSFER_BUF
+    /** @private @brief Destination of response data, NULL when they are read into L2 buffer */
+    uint8_t *rx;
+    /** @private @brief Size of `rx` */
+    uint16_t rx_max;
+#endif
+} lt_l1_poll_sched_t;
+
+#if LT_L2_RETRY_POLICY
+/** @brief Policy of `lt_l2_receive()` for responses which were not received correctly */
+typedef struct lt_l2_retry_policy_t {
+    /** @brief Maximal number of Resend_Req sent after a response with CRC or GEN error, also the maximal number of
+     * times a single chunk of encrypted L3 packet is transferred again */
+    uint8_t max_resends;
+    /** @brief Delay before the first Resend_Req in ms, doubled before each next one, zero for no delay */
+    uint32_t backoff_ms;
+    /** @brief Number of times the response is polled again after LT_L1_CHIP_BUSY, zero for no retry */
+    uint8_t busy_retries;
+} lt_l2_retry_policy_t;
+
+/** @brief Statistics of errors handled by `lt_l2_receive()` and by transfers of encrypted L3 packets */
+typedef struct lt_l2_retry_stats_t {
+    /** @brief Number of received responses with CRC or GEN error, including resent ones */
+    uint32_t crc_errors;
+    /** @brief Number of Resend_Req sent */
+    uint32_t resends;
+    /** @brief Number of times TROPIC01 did not become ready (LT_L1_CHIP_BUSY) */
+    uint32_t busy_timeouts;
+    /** @brief Number of chunks of encrypted L3 commands sent again after TROPIC01 reported CRC error */
+    uint32_t cmd_chunk_resends;
+    /** @brief Number of chunks of encrypted L3 results requested again after CRC error detected by host */
+    uint32_t res_chunk_resends;
+    /** @brief Number of responses and chunks given up after all retries */
+    uint32_t failures;
+} lt_l2_retry_stats_t;
+
+/** @brief Retry policy and statistics kept in the handle */
+typedef struct lt_l2_retry_t {
+    /** @public @brief Policy, when NULL, libtropic's default policy (3 resends without delay) is used */
+    const lt_l2_retry_policy_t *policy;
+    /** @public @brief Statistics, read only (can be cleared by the application) */
+    lt_l2_retry_stats_t stats;
+} lt_l2_retry_t;
+#endif
+
+#if LT_STATS
+/** @brief Key of statistics of a plain L2 request, see `lt_stats_entry_t` */
+#define LT_STATS_KEY_L2(req_id) ((uint16_t)(req_id))
+/** @brief Key of statistics of an L3 command, see `lt_stats_entry_t` */
+#define LT_STATS_KEY_L3(cmd_id) ((uint16_t)(0x100u | (cmd_id)))
+/** @brief Number of L2 requests and L3 commands for which statistics are kept */
+#ifndef LT_STATS_CNT
+#define LT_STATS_CNT 24
+#endif
+
+/** @brief Phases of a request whose time is measured, index of `lt_stats_entry_t.time` */
+typedef enum lt_stats_phase_t {
+    /** @brief SPI transfers done by the port, including chip select */
+    LT_STATS_TRANSFER = 0,
+    /** @brief Delays while polling for a response */
+    LT_STATS_POLL = 1,
+    /** @brief Encryption and decryption of L3 packets and derivation of session keys on host */
+    LT_STATS_CRYPTO = 2,
+    LT_STATS_PHASES
+} lt_stats_phase_t;
+
+/** @brief Time spent in one phase */
+typedef struct lt_stats_time_t {
+    /** @brief Cumulative time in us */
+    uint64_t total_us;
+    /** @brief Longest single transfer, delay or crypto operation in us */
+    uint32_t max_us;
+} lt_stats_time_t;
+
+/** @brief Statistics of one L2 request or L3 command */
+typedef struct lt_stats_entry_t {
+    /** @brief LT_STATS_KEY_L2() or LT_STATS_KEY_L3() key, zero when the entry is free */
+    uint16_t key;
+    /** @brief Number of requests sent */
+    uint32_t cnt;
+    /** @brief Number of bytes transferred over SPI */
+    uint32_t bytes;
+    /** @brief Time spent in each phase, indexed by `lt_stats_phase_t` */
+    lt_stats_time_t time[LT_STATS_PHASES];
+    /** @brief Number of frames with CRC error, detected by host or reported by TROPIC01 */
+    uint32_t crc_errors;
+    /** @brief Number of Resend_Req sent */
+    uint32_t resends;
+} lt_stats_entry_t;
+
+/**
+ * @brief Statistics supplied by the application in `lt_l2_state_t.stats`, read by `lt_stats_get()`
+ * @details Resend_Req is accounted to the request whose response is resent. Chunks of an encrypted L3 command and
+ * its result are accounted to the L3 command, not to the L2 request carrying them.
+ */
+typedef struct lt_stats_t {
+    /** @public @brief Monotonic clock in us, when NULL only counts and bytes are collected */
+    uint32_t (*time_us)(void);
+    /** @public @brief Number of requests not accounted because all entries were used */
+    uint32_t dropped;
+    /** @private @brief Entry of the request being processed, NULL when it is not accounted */
+    lt_stats_entry_t *cur;
+    /** @public @brief Number of delays measured by the port, read only */
+    uint32_t delays;
+    /** @public @brief Time past the deadlines of the measured delays, read only */
+    lt_stats_time_t oversleep;
+    /** @public @brief Statistics of requests, read only */
+    lt_stats_entry_t entries[LT_STATS_CNT];
+} lt_stats_t;
+#endif
+
+#if LT_TRACE
+/** @brief Number of bytes of frame data kept in each trace event */
+#ifndef LT_TRACE_PAYLOAD_SIZE
+#define LT_TRACE_PAYLOAD_SIZE 8
+#endif
+
+/** @brief Direction of traced frame, `lt_trace_event_t.dir` */
+typedef enum lt_trace_dir_t {
+    /** @brief L2 request sent to TROPIC01 */
+    LT_TRACE_TX = 0,
+    /** @brief L2 response received from TROPIC01 */
+    LT_TRACE_RX = 1
+} lt_trace_dir_t;
+
+/** @brief One traced L2 frame */
+typedef struct lt_trace_event_t {
+    /** @brief Time of `lt_trace_t.time_us` when the frame was sent or received, zero without clock */
+    uint32_t time_us;
+    /** @brief Length of the whole frame */
+    uint16_t len;
+    /** @brief `lt_trace_dir_t` */
+    uint8_t dir;
+    /** @brief REQ_ID of request, STATUS of response */
+    uint8_t id;
+    /** @brief First bytes of REQ_DATA or RSP_DATA, `lt_trace_t.payload_len` at most */
+    uint8_t payload[LT_TRACE_PAYLOAD_SIZE];
+} lt_trace_event_t;
+
+/**
+ * @brief Ring of traced frames supplied by the application in `lt_l2_state_t.trace`, initialized by
+ * `lt_trace_init()`
+ * @details Recording takes a slot by an atomic increment, so one ring can be shared by handles used from several
+ * threads. When the ring is full, the oldest event is overwritten.
+ */
+typedef struct lt_trace_t {
+    /** @public @brief Recording is enabled when nonzero */
+    uint8_t enabled;
+    /** @public @brief Number of data bytes kept in each event, LT_TRACE_PAYLOAD_SIZE at most */
+    uint8_t payload_len;
+    /** @public @brief Monotonic clock in us, when NULL the timestamps are zero */
+    uint32_t (*time_us)(void);
+    /** @private @brief Events, the number of them is a power of two */
+    lt_trace_event_t *events;
+    /** @private @brief Number of events minus one */
+    uint32_t mask;
+    /** @private @brief Number of events recorded since initialization */
+    uint32_t head;
+} lt_trace_t;
+#endif
+
+#if LT_PROFILE
+/** @brief Function measured by the profile, index of `lt_profile_t.entries` */
+typedef enum lt_profile_fn_t {
+    LT_PROFILE_L1_READ = 0,
+    LT_PROFILE_L1_WRITE,
+    LT_PROFILE_CRC16,
+    LT_PROFILE_L3_ENCRYPT,
+    LT_PROFILE_L3_DECRYPT,
+    LT_PROFILE_SESSION_START,
+    LT_PROFILE_HKDF,
+    LT_PROFILE_ASN1DER_FIND,
+    /** @brief Number of measured functions */
+    LT_PROFILE_FNS
+} lt_profile_fn_t;
+
+/** @brief Cycles spent in one function, including functions it calls */
+typedef struct lt_profile_entry_t {
+    /** @brief Number of calls */
+    uint32_t calls;
+    /** @brief Longest call */
+    uint32_t max;
+    /** @brief Sum of all calls */
+    uint64_t cycles;
+} lt_profile_entry_t;
+
+/**
+ * @brief Profile of host side CPU cycles, activated by `lt_profile_init()`
+ * @details Accumulators are updated without locks, so calls made concurrently from several threads can be lost.
+ */
+typedef struct lt_profile_t {
+    /** @private @brief Free running cycle counter, e.g. `lt_cortex_m_cycles()` */
+    uint32_t (*cycles)(void);
+    /** @public @brief Accumulators indexed by `lt_profile_fn_t`, read only */
+    lt_profile_entry_t entries[LT_PROFILE_FNS];
+} lt_profile_t;
+#endif
+
+/** @brief Magic at the start of a recording made by `lt_record_t` */
+#define LT_RECORD_MAGIC "LTRC"
+/** @brief Version of recording format */
+#define LT_RECORD_VERSION 1
+/** @brief Size of recording header: magic, version and three reserved bytes */
+#define LT_RECORD_HEADER_SIZE 8
+
+/** @brief Port operations in a recording, see `lt_record_t`. Also known to replays built without LT_RECORD. */
+typedef enum lt_record_op_t {
+    LT_RECORD_OP_INIT = 1,
+    LT_RECORD_OP_DEINIT = 2,
+    LT_RECORD_OP_CSN_LOW = 3,
+    LT_RECORD_OP_CSN_HIGH = 4,
+    /** Followed by length and MISO bytes of the transfer */
+    LT_RECORD_OP_TRANSFER = 5,
+    /** Followed by length and random bytes returned by the port */
+    LT_RECORD_OP_RANDOM = 6
+} lt_record_op_t;
+
+#if LT_RECORD
+/**
+ * @brief Recording of port calls supplied by the application in `lt_l2_state_t.record`, started by
+ * `lt_record_start()`
+ * @details Each call of the port (except delays) is written as one record: operation, status and, for transfers and
+ * random bytes, 16-bit little endian length and the bytes. Random bytes are recorded too, so a replay gets the same
+ * ephemeral keys and session keys as the recorded session. See hal/port/unix/libtropic_port_unix_replay.h.
+ */
+typedef struct lt_record_t {
+    /** @public @brief Recording is enabled when nonzero */
+    uint8_t enabled;
+    /** @private @brief Writes a part of the recording */
+    void (*write)(void *ctx, const uint8_t *data, const uint16_t len);
+    /** @private @brief Argument of `write` */
+    void *ctx;
+    /** @private @brief Number of bytes written since the start */
+    uint32_t size;
+} lt_record_t;
+#endif
+
 typedef struct lt_l2_state_t {
     void *device;
     uint8_t mode;
-    uint8_t buff[1 + L2_MAX_FRAME_SIZE];
+    uint8_t buff[LT_L2_BUFF_SIZE] __attribute__((aligned(LT_L2_BUFF_ALIGN)));
+#if LT_SPECULATIVE_READ
+    /**
+     * Number of response bytes (data and CRC) read speculatively in the same transfer as CHIP_STATUS, STATUS and
+     * length bytes. Second transfer is done only when the response is longer. Zero disables speculative reading,
+     * LT_L1_SPEC_LEN_AUTO sets the length per command.
+     */
+    uint16_t spec_len;
+#endif
+#if LT_ADAPTIVE_POLLING
+    /** Polling configuration and statistics, see `lt_l1_poll_t` */
+    lt_l1_poll_t poll;
+#endif
+#if LT_L2_RETRY_POLICY
+    /** Retry policy and statistics of `lt_l2_receive()`, see `lt_l2_retry_t` */
+    lt_l2_retry_t retry;
+#endif
+#if LT_STATS
+    /** Statistics supplied by the application, NULL disables them, see `lt_stats_t` */
+    struct lt_stats_t *stats;
+#endif
+#if LT_HOOKS
+    /** Instrumentation callbacks supplied by the application, NULL disables them, see `lt_hooks_t` */
+    struct lt_hooks_t *hooks;
+#endif
+#if LT_TRACE
+    /** Trace of frames supplied by the application, NULL disables tracing, see `lt_trace_t` */
+    struct lt_trace_t *trace;
+#endif
+#if LT_RECORD
+    /** Recording of port calls supplied by the application, NULL disables it, see `lt_record_t` */
+    struct lt_record_t *record;
+#endif
+#if LT_LOG_DEFERRED
+    /** Threshold of messages logged for this handle (`lt_log_level_t`), 0 uses the global threshold */
+    uint8_t log_level;
+#endif
+#if LT_IDLE_SLEEP
+    /** Idle manager supplied by the application, NULL disables it, see `lt_idle_t` */
+    struct lt_idle_t *idle;
+#endif
+#if LT_DEADLINE
+    /** Deadline of communication supplied by the application, NULL disables it, see `lt_deadline_t` */
+    struct lt_deadline_t *deadline;
+#endif
+#if LT_MODE_TRACK
+    /** Tracking of the mode supplied by the application, NULL disables it, see `lt_mode_track_t` */
+    struct lt_mode_track_t *mode_track;
+#endif
+#if LT_SESSION_LIVENESS
+    /** Liveness of the secure session supplied by the application, NULL disables it, see `lt_liveness_t` */
+    struct lt_liveness_t *liveness;
+#endif
+#if LT_USE_SPI_SPEED
+    /** Auto-tuner of SPI clock supplied by the application, NULL disables it, see `lt_spi_tune_t` */
+    struct lt_spi_tune_t *spi_tune;
+#endif
+#if LT_PORT_OPS
+    /** Functions of the port used by the handle, supplied by the application, see `lt_port_ops_t` */
+    const struct lt_port_ops_t *ops;
+#endif
+#if LT_PORT_SHARE
+    /** Port device shared with other handles, NULL initializes the device by each `lt_init()`, see `lt_port_share_t` */
+    struct lt_port_share_t *port_share;
+#endif
+#if LT_L1_OFFLOAD
+    /**
+     * Set by `lt_port_init()` of a port which executes whole L1 transactions, see `lt_port_l1_write()`. Otherwise L1
+     * polls CHIP_STATUS through the SPI functions of the port.
+     */
+    uint8_t l1_offload;
+#if LT_NONBLOCKING
+    /**
+     * Set by `lt_l2_transfer_poll()` while it reads a response, `lt_port_l1_read()` may then return LT_PENDING
+     * instead of waiting for the response.
+     */
+    uint8_t l1_nonblocking;
+#endif
+#endif
 } lt_l2_state_t;
 
-// #define LT_SIZE_OF_L3_BUFF (1000)
+/** @brief Longest message of Ping supported by the build, lower values shrink the L3 buffer */
+#ifndef LT_PING_LEN_MAX
+#define LT_PING_LEN_MAX 4096
+#endif
+/** @brief Longest message signed by EdDSA supported by the build, lower values shrink the L3 buffer */
+#ifndef LT_EDDSA_MSG_LEN_MAX
+#define LT_EDDSA_MSG_LEN_MAX 4096
+#endif
+
+/** @brief Size of L3 packet carrying `size` bytes of command (from CMD_ID) or result (from RESULT) */
+#define LT_L3_PACKET_SIZE(size) (L3_RES_SIZE_SIZE + (size) + L3_TAG_SIZE)
+/** @brief Largest packet of the other commands: Random_Value_Get result with 3 B padding and 255 random bytes */
+#define LT_L3_BUFF_SIZE_BASE LT_L3_PACKET_SIZE(1 + 3 + 255)
+/** @brief Ping command and result */
+#define LT_L3_BUFF_SIZE_PING LT_L3_PACKET_SIZE(1 + LT_PING_LEN_MAX)
+/** @brief EDDSA_Sign command with slot and 13 B padding */
+#define LT_L3_BUFF_SIZE_EDDSA LT_L3_PACKET_SIZE(1 + 2 + 13 + LT_EDDSA_MSG_LEN_MAX)
+#if LT_ENABLE_R_MEM
+/** @brief R_Mem_Data_Write command and R_Mem_Data_Read result with 444 B of data */
+#define LT_L3_BUFF_SIZE_R_MEM LT_L3_PACKET_SIZE(1 + 3 + 444)
+#else
+#define LT_L3_BUFF_SIZE_R_MEM 0
+#endif
+
+/** @brief Larger of two sizes, usable in constant expressions */
+#define LT_L3_BUFF_SIZE_MAX2(a, b) ((a) > (b) ? (a) : (b))
+/** @brief Size of L3 buffer needed by the largest command and result enabled in the build */
+#define LT_L3_BUFF_SIZE_MIN                                                                 \
+    LT_L3_BUFF_SIZE_MAX2(LT_L3_BUFF_SIZE_MAX2(LT_L3_BUFF_SIZE_BASE, LT_L3_BUFF_SIZE_R_MEM), \
+                         LT_L3_BUFF_SIZE_MAX2(LT_L3_BUFF_SIZE_PING, LT_L3_BUFF_SIZE_EDDSA))
+
+// Can be overridden (e.g. to get room for more commands of lt_ecc_ecdsa_sign_batch()), but not below the minimum
 #ifndef LT_SIZE_OF_L3_BUFF
-#define LT_SIZE_OF_L3_BUFF L3_PACKET_MAX_SIZE
+#define LT_SIZE_OF_L3_BUFF LT_L3_BUFF_SIZE_MIN
+#endif
+STATIC_ASSERT(LT_SIZE_OF_L3_BUFF >= LT_L3_BUFF_SIZE_MIN)
+STATIC_ASSERT(LT_SIZE_OF_L3_BUFF <= L3_PACKET_MAX_SIZE)
+
+/**
+ * @brief Size of AES-GCM context of the selected crypto backend, each backend checks it by a static assert
+ */
+#ifndef LT_AESGCM_GHASH_TABLES_SIZE
+/** @brief Size of GHASH tables in trezor_crypto's gcm_ctx, set by LT_AESGCM_GHASH_TABLES CMake option */
+#define LT_AESGCM_GHASH_TABLES_SIZE 0
+#endif
+#if LT_CRYPTO_DISPATCH
+/** @brief Bytes at the end of AES-GCM context keeping the implementation selected at runtime, keeps alignment */
+#define LT_AESGCM_CTX_TAG_SIZE 16
+/** sizeof(gcm_ctx) of trezor_crypto, larger of both implementations, and the tag */
+#define LT_AESGCM_CTX_SIZE (352 + LT_AESGCM_GHASH_TABLES_SIZE + LT_AESGCM_CTX_TAG_SIZE)
+#elif LT_AESGCM_ACCEL
+#define LT_AESGCM_CTX_SIZE 336
+#elif LT_CRYPTO_STM32
+#define LT_AESGCM_CTX_SIZE 176
+#elif USE_MBEDTLS
+#define LT_AESGCM_CTX_SIZE sizeof(mbedtls_gcm_context)
+#else
+/** sizeof(gcm_ctx) of trezor_crypto */
+#define LT_AESGCM_CTX_SIZE (352 + LT_AESGCM_GHASH_TABLES_SIZE)
 #endif
 
 typedef struct lt_l3_state_t {
     uint32_t session;
     uint8_t encryption_IV[12];
     uint8_t decryption_IV[12];
-#if LT_USE_TREZOR_CRYPTO
-    uint8_t encrypt[352] __attribute__((aligned(16)));  // Because sizeof(lt_aes_gcm_ctx_t) == 352;
-    uint8_t decrypt[352] __attribute__((aligned(16)));
-#elif USE_MBEDTLS
-#warning "Warning: MBED Tls is not implemented yet";
-#else
-    // Default size of gcm context structures are set to reflect sizes used in trezor_crypto library
-    uint8_t encrypt[352] __attribute__((aligned(16)));
-    uint8_t decrypt[352] __attribute__((aligned(16)));
-#endif
+    uint8_t encrypt[LT_AESGCM_CTX_SIZE] __attribute__((aligned(16)));
+    uint8_t decrypt[LT_AESGCM_CTX_SIZE] __attribute__((aligned(16)));
 #if LT_SEPARATE_L3_BUFF
     /** User shall define buffer's array and store its pointer into handle */
     uint8_t *buff __attribute__((aligned(16)));
@@ -119,8 +600,46 @@ typedef struct lt_l3_state_t {
     uint8_t buff[LT_SIZE_OF_L3_BUFF] __attribute__((aligned(16)));
 #endif
     uint16_t buff_len; /**< Length of the buffer */
+    /** @private @brief High-water mark of bytes written to the buffer since it was wiped last */
+    uint16_t buff_used;
+    /** @private @brief ID of the last encrypted command, its result is the one awaited */
+    uint8_t cmd_id;
+#if LT_L3_SPLIT_BUFF
+#if LT_SEPARATE_L3_BUFF
+    /** User shall define array for results and store its pointer into handle */
+    uint8_t *res_buff __attribute__((aligned(16)));
+#else
+    /** Buffer for L3 results, `buff` then holds only commands */
+    uint8_t res_buff[LT_SIZE_OF_L3_BUFF] __attribute__((aligned(16)));
+#endif
+    uint16_t res_buff_len; /**< Length of the result buffer */
+    /** @private @brief High-water mark of bytes written to the result buffer since it was wiped last */
+    uint16_t res_buff_used;
+#endif
+#if LT_L3_STREAM_DECRYPT
+    /** @private @brief Result in buffer was already decrypted and authenticated by `lt_l3_recv_decrypt()` */
+    uint8_t res_decrypted;
+#endif
+#if LT_ASYNC
+    /** @private @brief Command is left in plaintext for `lt_l3_encrypt_multi()`, set by `lt_poll_multi()` */
+    uint8_t encrypt_deferred;
+#endif
 } lt_l3_state_t;
 
+/**
+ * @brief Buffer L3 results are received into and parsed from, so results do not overwrite a command prepared in
+ * `buff` when compiled with LT_L3_SPLIT_BUFF.
+ */
+#if LT_L3_SPLIT_BUFF
+#define LT_L3_RES_BUFF(s3) ((s3)->res_buff)
+#define LT_L3_RES_BUFF_LEN(s3) ((s3)->res_buff_len)
+#define LT_L3_RES_BUFF_USED(s3) ((s3)->res_buff_used)
+#else
+#define LT_L3_RES_BUFF(s3) ((s3)->buff)
+#define LT_L3_RES_BUFF_LEN(s3) ((s3)->buff_len)
+#define LT_L3_RES_BUFF_USED(s3) ((s3)->buff_used)
+#endif
+
 /**
  * @details This structure holds data related to one physical chip.
  * Contains AESGCM contexts for encrypting and decrypting L3 commands, nonce and device void pointer, which can be used
@@ -129,6 +648,46 @@ typedef struct lt_l3_state_t {
 typedef struct lt_handle_t {
     lt_l2_state_t l2;
     lt_l3_state_t l3;
+#if LT_GET_INFO_CACHE
+    /** Cache of GET_INFO results supplied by the application, NULL disables caching, see `lt_get_info_cache_t` */
+    struct lt_get_info_cache_t *info_cache;
+#endif
+#if LT_EPHEMERAL_KEY_POOL
+    /** Pool of ephemeral keys supplied by the application, NULL disables it, see `lt_ephemeral_key_pool_t` */
+    struct lt_ephemeral_key_pool_t *key_pool;
+#endif
+#if LT_ECC_KEY_CACHE
+    /** Cache of ECC public keys supplied by the application, NULL disables caching, see `lt_ecc_key_cache_t` */
+    struct lt_ecc_key_cache_t *key_cache;
+#endif
+#if LT_SESSION_REKEY
+    /** Policy of session re-establishment supplied by the application, NULL disables it, see `lt_session_rekey_t` */
+    struct lt_session_rekey_t *rekey;
+#endif
+#if LT_SESSION_AUTO
+    /** Key material of automatic session establishment, NULL disables it, see `lt_session_auto_t` */
+    struct lt_session_auto_t *session_auto;
+#endif
+#if LT_RMEM_CACHE
+    /** Cache of R-memory slots supplied by the application, NULL disables caching, see `lt_rmem_cache_t` */
+    struct lt_rmem_cache_t *rmem_cache;
+#endif
+#if LT_CONFIG_CACHE
+    /** Cache of R-Config and I-Config supplied by the application, NULL disables caching, see `lt_config_cache_t` */
+    struct lt_config_cache_t *config_cache;
+#endif
+#if LT_ASYNC
+    /** Queue of operations submitted by `lt_submit()` supplied by the application, see `lt_async_t` */
+    struct lt_async_t *async;
+#endif
+#if LT_L3_BUFF_POOL
+    /** Pool of L3 buffers shared with other handles, NULL uses `l3.buff` of the handle, see `lt_l3_buff_pool_t` */
+    struct lt_l3_buff_pool_t *l3_pool;
+#endif
+#if LT_TUNE_PERSIST
+    /** Store of the tuning profile supplied by the application, NULL disables it, see `lt_tune_store_t` */
+    struct lt_tune_store_t *tune_store;
+#endif
 } lt_handle_t;
 
 /**
@@ -231,11 +790,103 @@ typedef enum lt_ret_t {
     /** @brief The nonce has reached its maximum value. */
     LT_NONCE_OVERFLOW = 40,
 
+    // Non-blocking transfer related
+    /** @brief Transfer is not finished yet, poll it again after the returned time */
+    LT_PENDING = 41,
+
+    // Host side storage related
+    /** @brief Requested object does not exist */
+    LT_NOT_FOUND = 42,
+    /** @brief Shared resource is used by other handles, e.g. no L3 buffer of `lt_l3_buff_pool_t` is free */
+    LT_BUSY = 43,
+    /** @brief Deadline set by `lt_deadline_set()` passed before the operation finished */
+    LT_DEADLINE_EXCEEDED = 44,
+    /** @brief Request was refused, because it would wait in the queue longer than its deadline allows */
+    LT_OVERLOAD = 45,
+
     /** @brief Special helper value used to signalize the last enum value, used in lt_ret_verbose. */
-    LT_RET_T_LAST_VALUE = 41
+    LT_RET_T_LAST_VALUE = 46
 } lt_ret_t;
 
+#if LT_HOOKS
+/** @brief Kinds of operations reported to `lt_hooks_t` */
+typedef enum lt_hook_kind_t {
+    /** @brief Public API function taking the handle, reported only for the outermost one when they nest */
+    LT_HOOK_API = 0,
+    /** @brief L3 command, from its encryption to decryption of its result */
+    LT_HOOK_L3_CMD = 1,
+    /** @brief L2 frame exchange, from writing the request frame to reading the response frame */
+    LT_HOOK_L2_FRAME = 2,
+    /** @brief Delay while waiting for TROPIC01, e.g. between polls of CHIP_STATUS */
+    LT_HOOK_DELAY = 3,
+    LT_HOOK_KINDS
+} lt_hook_kind_t;
+
+/** @brief Operation reported to `lt_hooks_t.pre` and `lt_hooks_t.post`, fields not listed for the kind are zero */
+typedef struct lt_hook_event_t {
+    /** @brief Kind of the operation */
+    lt_hook_kind_t kind;
+    /** @brief Name of the function, LT_HOOK_API */
+    const char *api;
+    /** @brief L3 command ID (LT_HOOK_L3_CMD) or L2 request ID (LT_HOOK_L2_FRAME) */
+    uint8_t id;
+    /** @brief Status of the L2 response, in `post` of LT_HOOK_L2_FRAME */
+    uint8_t status;
+    /** @brief Size of the L3 command in plaintext or of the L2 request frame */
+    uint16_t tx_len;
+    /** @brief Size of the L3 result in plaintext or of data of the L2 response, in `post` */
+    uint16_t rx_len;
+    /** @brief Requested time of LT_HOOK_DELAY in us */
+    uint32_t delay_us;
+    /** @brief Time since `pre` in us, in `post`, zero without `lt_hooks_t.time_us` */
+    uint32_t duration_us;
+    /** @brief Result of the operation, in `post`. LT_OK for LT_HOOK_API, its result is returned to its caller. */
+    lt_ret_t ret;
+} lt_hook_event_t;
+
+/**
+ * @brief Callbacks supplied by the application in `lt_l2_state_t.hooks`, called before and after operations of the
+ * handle, e.g. to open and close tracing spans. Set or clear the pointer only between calls of the API.
+ *
+ * @details `post` of LT_HOOK_L3_CMD comes when the result of the command is decrypted. When the command fails
+ * earlier, the failing L2 frame exchange is reported with its error, and the command only by its `pre`. Callbacks
+ * must not call the API with the same handle.
+ */
+typedef struct lt_hooks_t {
+    /** @public @brief Called before the operation, may be NULL */
+    void (*pre)(void *ctx, const lt_hook_event_t *ev);
+    /** @public @brief Called after the operation, may be NULL */
+    void (*post)(void *ctx, const lt_hook_event_t *ev);
+    /** @public @brief Context of `pre` and `post` */
+    void *ctx;
+    /** @public @brief Monotonic clock in us measuring `duration_us`, may be NULL */
+    uint32_t (*time_us)(void);
+    /** @private @brief Operations whose `pre` was called, indexed by `lt_hook_kind_t` */
+    lt_hook_event_t ev[LT_HOOK_KINDS];
+    /** @private @brief Time of `pre` of each kind */
+    uint32_t start_us[LT_HOOK_KINDS];
+    /** @private @brief Bit of each kind whose `pre` was called without `post` yet */
+    uint8_t open;
+    /** @private @brief Depth of nested API functions */
+    uint8_t api_depth;
+} lt_hooks_t;
+#endif
+
 #define LT_TROPIC01_REBOOT_DELAY_MS 250
+#if LT_REBOOT_POLL
+#ifndef LT_TROPIC01_REBOOT_DELAY_MIN_MS
+/** @brief Time after Startup_Req before CHIP_STATUS is polled, so TROPIC01 has surely started to reboot */
+#define LT_TROPIC01_REBOOT_DELAY_MIN_MS 10
+#endif
+#ifndef LT_TROPIC01_REBOOT_POLL_MS
+/** @brief Interval of CHIP_STATUS polls while TROPIC01 reboots */
+#define LT_TROPIC01_REBOOT_POLL_MS 5
+#endif
+#ifndef LT_TROPIC01_REBOOT_TIMEOUT_MS
+/** @brief Longest wait for TROPIC01 to be ready after Startup_Req */
+#define LT_TROPIC01_REBOOT_TIMEOUT_MS 1000
+#endif
+#endif
 
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Maximal size of TROPIC01's certificate */
@@ -261,6 +912,16 @@ typedef struct lt_cert_store_t {
     uint16_t cert_len[LT_NUM_CERTIFICATES]; /** Lenght of certificates (from Cert store header) */
 } lt_cert_store_t;
 
+/** @brief Version of format produced by `lt_cert_store_export()` */
+#define LT_CERT_STORE_EXPORT_VERSION 1
+/**
+ * @brief Size of header of exported certificate store: magic "LTCS", version, serial number of the chip, STPub
+ * and lengths of certificates. Header is followed by the certificates and SHA256 of all preceding bytes.
+ */
+#define LT_CERT_STORE_EXPORT_HEADER_SIZE (4 + 1 + 16 + 32 + 2 * LT_NUM_CERTIFICATES)
+/** @brief Maximal size of certificate store exported by `lt_cert_store_export()` */
+#define LT_CERT_STORE_EXPORT_SIZE_MAX (LT_CERT_STORE_EXPORT_HEADER_SIZE + LT_L2_GET_INFO_REQ_CERT_SIZE_TOTAL + 32)
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Maximal size of returned CHIP ID */
 #define LT_L2_GET_INFO_CHIP_ID_SIZE 128
@@ -458,6 +1119,38 @@ STATIC_ASSERT(
 #define LT_L2_GET_INFO_FW_HEADER_SIZE_BOOT_V2_EMPTY_BANK 0
 /** @brief Maximal size of returned fw header */
 #define LT_L2_GET_INFO_FW_HEADER_SIZE LT_L2_GET_INFO_FW_HEADER_SIZE_BOOT_V2
+/** @brief Number of firmware banks, FW_BANK_FW1, FW_BANK_FW2, FW_BANK_SPECT1 and FW_BANK_SPECT2 */
+#define LT_FW_BANK_CNT 4
+
+#if LT_GET_INFO_CACHE
+//--------------------------------------------------------------------------------------------------------------------//
+/**
+ * @brief Results of GET_INFO requests, which do not change until TROPIC01 is rebooted or its firmware is updated.
+ *
+ * The application places it (zeroed) into `lt_handle_t.info_cache`, then `lt_get_info_chip_id()`,
+ * `lt_get_info_riscv_fw_ver()`, `lt_get_info_spect_fw_ver()`, `lt_get_info_cert_store()` and `lt_get_info_fw_bank()`
+ * read each object from TROPIC01 only once. The cache is invalidated by `lt_reboot()` and by firmware update functions,
+ * or by `lt_get_info_cache_invalidate()` when a different chip might be connected.
+ */
+typedef struct lt_get_info_cache_t {
+    /** @private @brief Bit mask of valid objects */
+    uint8_t valid;
+    /** @private @brief Number of valid blocks in `cert_store` */
+    uint8_t cert_blocks;
+    /** @private @brief CHIP_ID object */
+    struct lt_chip_id_t chip_id;
+    /** @private @brief RISC-V firmware version */
+    uint8_t riscv_fw_ver[LT_L2_GET_INFO_RISCV_FW_SIZE];
+    /** @private @brief SPECT firmware version */
+    uint8_t spect_fw_ver[LT_L2_GET_INFO_SPECT_FW_SIZE];
+    /** @private @brief Blocks of certificate store as read from TROPIC01 */
+    uint8_t cert_store[LT_L2_GET_INFO_REQ_CERT_SIZE_TOTAL];
+    /** @private @brief Lengths of firmware bank headers, in order of `lt_fw_info_t.banks` */
+    uint8_t fw_bank_len[LT_FW_BANK_CNT];
+    /** @private @brief Firmware bank headers as read from TROPIC01 */
+    uint8_t fw_bank[LT_FW_BANK_CNT][LT_L2_GET_INFO_FW_HEADER_SIZE];
+} lt_get_info_cache_t;
+#endif
 
 /** @brief BANK ID */
 typedef enum bank_id_t {
@@ -467,6 +1160,79 @@ typedef enum bank_id_t {
     FW_BANK_SPECT2 = 18,  // SPECT bank 2
 } bank_id_t;
 
+/**
+ * @brief Reads `len` bytes of firmware update image starting at `offset` into `buff`
+ * @details Used by streaming firmware update, so the image does not have to be held in memory. Any value other than
+ * LT_OK stops the update and is returned.
+ */
+typedef lt_ret_t (*lt_fw_read_cb_t)(void *ctx, const uint32_t offset, uint8_t *buff, const uint16_t len);
+
+/**
+ * @brief State of resumable firmware update, see `lt_do_mutable_fw_update_resume()`
+ * @details The application fills the image source and optional progress callback, and keeps `cursor` and `chunks`
+ * (e.g. in non-volatile memory from `progress`) to continue an interrupted update.
+ */
+typedef struct lt_fw_update_t {
+    /** @brief Callback reading the update image */
+    lt_fw_read_cb_t read;
+    /** @brief Argument of `read` */
+    void *read_ctx;
+    /** @brief Size of the update image */
+    uint32_t size;
+    /** @brief Optional callback called whenever TROPIC01 acknowledges a chunk, NULL to disable */
+    void (*progress)(void *ctx, const struct lt_fw_update_t *u);
+    /** @brief Argument of `progress` */
+    void *progress_ctx;
+    /** @brief Offset in the image of the first chunk not acknowledged yet, 0 when the update was not started */
+    uint32_t cursor;
+    /** @brief Number of acknowledged chunks, i.e. index of the next chunk */
+    uint32_t chunks;
+} lt_fw_update_t;
+
+/** @brief Failure policy of `lt_do_mutable_fw_update_fleet()` */
+typedef enum lt_fw_fleet_policy_t {
+    /** @brief Failed device is dropped, the remaining devices continue */
+    LT_FW_FLEET_CONTINUE = 0,
+    /** @brief First failure stops the update of all devices */
+    LT_FW_FLEET_ABORT = 1
+} lt_fw_fleet_policy_t;
+
+/** @brief One device updated by `lt_do_mutable_fw_update_fleet()` */
+typedef struct lt_fw_fleet_dev_t {
+    /** @brief Device's handle, each device must have its own handle */
+    lt_handle_t *h;
+    /** @brief Result of the update of this device, LT_FAIL also when it was stopped by LT_FW_FLEET_ABORT */
+    lt_ret_t ret;
+    /** @brief Offset in the image of the first chunk not acknowledged yet */
+    uint32_t cursor;
+    /** @brief Number of acknowledged chunks */
+    uint32_t chunks;
+} lt_fw_fleet_dev_t;
+
+/** @brief Update of several devices with one image, see `lt_do_mutable_fw_update_fleet()` */
+typedef struct lt_fw_fleet_t {
+    /** @brief Devices to update */
+    lt_fw_fleet_dev_t *devs;
+    /** @brief Number of devices */
+    uint8_t cnt;
+    /** @brief Callback reading the update image, each chunk is read only once for all devices */
+    lt_fw_read_cb_t read;
+    /** @brief Argument of `read` */
+    void *read_ctx;
+    /** @brief Size of the update image */
+    uint32_t size;
+    /** @brief Bank ID where the update should be applied, see `lt_do_mutable_fw_update()` */
+    bank_id_t bank_id;
+    /** @brief What happens to the other devices when one of them fails */
+    lt_fw_fleet_policy_t policy;
+    /** @brief When nonzero, firmware version reported after reboot must match the version of the image */
+    uint8_t verify;
+    /** @brief Optional callback called whenever a device acknowledges a chunk, NULL to disable */
+    void (*progress)(void *ctx, const struct lt_fw_fleet_dev_t *dev);
+    /** @brief Argument of `progress` */
+    void *progress_ctx;
+} lt_fw_fleet_t;
+
 /**
  * @brief When in MAINTENANCE mode, it is possible to read firmware header from a firmware bank. Returned data differs
  * based on bootloader version. This header layout is returned by bootloader version v1.0.1
@@ -541,6 +1307,39 @@ STATIC_ASSERT(
 /** \endcond */
 // clang-format on
 
+/**
+ * @brief Firmware bank header in a layout independent of the bootloader version, filled by `lt_get_info_fw_all()`.
+ * Fields missing in the header returned by the bootloader are zero.
+ */
+typedef struct lt_fw_bank_info_t {
+    /** @brief Layout of the returned header, 0 == empty bank, 1 == `header_boot_v1_t`, 2 == `header_boot_v2_t` */
+    uint8_t layout;
+    /** @brief Header version, only in `header_boot_v2_t` */
+    uint8_t header_version;
+    /** @brief 1 == FW for RISCV coprocessor, 2 == FW for SPECT coprocessor */
+    uint16_t type;
+    /** @brief FW version */
+    uint32_t version;
+    /** @brief FW size in bytes */
+    uint32_t size;
+    /** @brief GIT hash of the underlying FW repository */
+    uint32_t git_hash;
+    /** @brief Hash for data integrity, `header_boot_v1_t` carries only its first 4 bytes */
+    uint8_t hash[32];
+    /** @brief Other FW version compatibility, only in `header_boot_v2_t`. Zero means any version. */
+    uint32_t pair_version;
+} lt_fw_bank_info_t;
+
+/** @brief Firmware versions and headers of all firmware banks, filled by `lt_get_info_fw_all()` */
+typedef struct lt_fw_info_t {
+    /** @brief RISC-V firmware version, as returned by `lt_get_info_riscv_fw_ver()` */
+    uint8_t riscv_fw_ver[LT_L2_GET_INFO_RISCV_FW_SIZE];
+    /** @brief SPECT firmware version, as returned by `lt_get_info_spect_fw_ver()` */
+    uint8_t spect_fw_ver[LT_L2_GET_INFO_SPECT_FW_SIZE];
+    /** @brief Headers of banks FW_BANK_FW1, FW_BANK_FW2, FW_BANK_SPECT1 and FW_BANK_SPECT2, in this order */
+    lt_fw_bank_info_t banks[LT_FW_BANK_CNT];
+} lt_fw_info_t;
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Pairing key indexes corresponds to S_HiPub */
 typedef enum pkey_index_t {
@@ -550,19 +1349,400 @@ typedef enum pkey_index_t {
     PAIRING_KEY_SLOT_INDEX_3,
 } pkey_index_t;
 
+/** @brief Command of one step of `lt_pairing_key_batch()` */
+typedef enum lt_pairing_key_op_kind_t {
+    LT_PAIRING_KEY_OP_WRITE,
+    LT_PAIRING_KEY_OP_READ,
+    LT_PAIRING_KEY_OP_INVALIDATE
+} lt_pairing_key_op_kind_t;
+
+/** @brief One step of pairing key provisioning executed by `lt_pairing_key_batch()` */
+typedef struct lt_pairing_key_op_t {
+    /** @brief Command, one of lt_pairing_key_op_kind_t values */
+    uint8_t op;
+    /** @brief Pairing key slot */
+    pkey_index_t slot;
+    /** @brief Key written by LT_PAIRING_KEY_OP_WRITE, or read by LT_PAIRING_KEY_OP_READ */
+    uint8_t key[32];
+    /** @brief Result of the command, LT_FAIL when it was not executed */
+    lt_ret_t status;
+} lt_pairing_key_op_t;
+
 /** @brief Structure used to store variables used during establishment of a secure session */
 typedef struct session_state_t {
     uint8_t ehpriv[32];
     uint8_t ehpub[32];
     // pkey_index_t pkey_index;
+    /** Handshake hash up to PKEY_INDEX, valid when `precomputed` is set */
+    uint8_t hash[32];
+    /** X25519(EHPRIV, STPUB), valid when `precomputed` is set */
+    uint8_t ss_stpub[32];
+    /** Set by `lt_session_start_precompute()` */
+    uint8_t precomputed;
 } session_state_t;
 
+#if LT_EPHEMERAL_KEY_POOL
+#ifndef LT_EPHEMERAL_KEY_POOL_SIZE
+/** @brief Number of ephemeral key pairs held by `lt_ephemeral_key_pool_t` */
+#define LT_EPHEMERAL_KEY_POOL_SIZE 2
+#endif
+/**
+ * @brief Ephemeral key pairs generated in advance by `lt_ephemeral_key_pool_refill()`.
+ *
+ * When `h->key_pool` points to this structure, `lt_out__session_start()` takes a key pair from it instead of
+ * generating one, and wipes it from the pool. When the pool is empty, the key pair is generated as usual.
+ */
+typedef struct lt_ephemeral_key_pool_t {
+    /** @private @brief Number of valid key pairs in `keys` */
+    uint8_t cnt;
+    /** @private @brief Key pairs, valid are `keys[0]` to `keys[cnt - 1]` */
+    session_state_t keys[LT_EPHEMERAL_KEY_POOL_SIZE];
+} lt_ephemeral_key_pool_t;
+#endif
+
+/**
+ * @brief Handshake inputs which depend only on the pairing key and the chip, prepared once by
+ * `lt_session_ctx_init()` and used by `lt_session_start_ctx()` on each session establishment.
+ */
+typedef struct lt_session_ctx_t {
+    /** @private @brief Handshake hash after processing SHiPUB and STPUB */
+    uint8_t hash[32];
+    /** @private @brief STPUB from device's certificate */
+    uint8_t stpub[32];
+    /** @private @brief Secure host private key, must stay valid while the context is used */
+    const uint8_t *shipriv;
+    /** @private @brief Index of pairing key */
+    pkey_index_t pkey_index;
+} lt_session_ctx_t;
+
+/**
+ * @brief Size of SHA256 context of the selected crypto backend
+ */
+#if USE_MBEDTLS
+#define LT_SHA256_CTX_SIZE sizeof(mbedtls_sha256_context)
+#else
+/** sizeof(struct lt_crypto_sha256_ctx_t) with trezor_crypto */
+#define LT_SHA256_CTX_SIZE 1024
+#endif
+
+/**
+ * @brief State of ECDSA signing of a message supplied in parts, see `lt_ecdsa_sign_init()`.
+ */
+typedef struct lt_ecdsa_sign_ctx_t {
+    /** @private @brief SHA256 context of the message */
+    uint8_t sha256[LT_SHA256_CTX_SIZE] __attribute__((aligned(8)));
+} lt_ecdsa_sign_ctx_t;
+
+/**
+ * @brief Scratch memory of `lt_verify_chip_and_start_secure_session_scratch()`, supplied by the caller instead of the
+ * stack. Nothing is kept in it after the function returns, so it can be shared by threads which do not establish
+ * sessions at the same time, or reused for anything else in between.
+ */
+typedef struct lt_session_scratch_t {
+    /** @private @brief SHA256 context of the handshake hash */
+    uint8_t sha256[LT_SHA256_CTX_SIZE] __attribute__((aligned(8)));
+    /** @private @brief Handshake inputs */
+    lt_session_ctx_t ctx;
+    /** @private @brief Ephemeral keys and precomputed parts of the handshake */
+    session_state_t state;
+} lt_session_scratch_t;
+
+#if LT_HOST_DRBG
+/**
+ * @brief State of host HMAC_DRBG (NIST SP 800-90A, SHA256) seeded by `lt_drbg_init()` from TROPIC01's RNG.
+ *
+ * Small random values are generated by `lt_drbg_random_get()` on the host, the DRBG is reseeded from TROPIC01 after
+ * `reseed_interval` requests, or before each request in prediction resistance mode.
+ */
+typedef struct lt_drbg_t {
+    /** @private @brief Key K of HMAC_DRBG */
+    uint8_t key[32];
+    /** @private @brief Value V of HMAC_DRBG */
+    uint8_t v[32];
+    /** @private @brief Number of requests since the last reseed, 0 when not instantiated */
+    uint32_t reseed_cnt;
+    /** @private @brief Number of requests after which the DRBG is reseeded */
+    uint32_t reseed_interval;
+    /** @private @brief Nonzero to reseed before each request */
+    uint8_t prediction_resistance;
+} lt_drbg_t;
+#endif
+
+#if LT_SESSION_REKEY
+/**
+ * @brief Policy of transparent session re-establishment.
+ *
+ * When `h->rekey` points to this structure, each L3 command first checks number of commands already sent in the
+ * session (the encryption nonce). When it reaches `max_cmds` or the nonce would overflow, the session is
+ * re-established with `ctx` before the command is sent, so the caller does not see `LT_NONCE_OVERFLOW`.
+ */
+typedef struct lt_session_rekey_t {
+    /** @brief Handshake context prepared by `lt_session_ctx_init()`, its SHiPRIV must stay valid */
+    lt_session_ctx_t ctx;
+    /** @brief Number of L3 commands after which session is re-established, 0 means only before nonce overflow */
+    uint32_t max_cmds;
+} lt_session_rekey_t;
+#endif
+
+#if LT_SESSION_AUTO
+/**
+ * @brief Pairing key material for automatic session establishment, supplied in `h->session_auto` before `lt_init()`.
+ *
+ * When no secure session is established, it is established by `lt_session_auto_start()` called by the first L3
+ * command, or already by `lt_init()` when `prewarm` is set. STPUB is read from the device's certificate once, later
+ * sessions reuse the handshake context prepared with it.
+ */
+typedef struct lt_session_auto_t {
+    /** @public @brief Secure host private key, must stay valid while the handle is used */
+    const uint8_t *shipriv;
+    /** @public @brief Secure host public key */
+    const uint8_t *shipub;
+    /** @public @brief Index of pairing key */
+    pkey_index_t pkey_index;
+    /** @public @brief Nonzero to establish the session by `lt_init()`, otherwise by the first L3 command */
+    uint8_t prewarm;
+    /** @private @brief Handshake context, valid when `ctx_valid` is set */
+    lt_session_ctx_t ctx;
+    /** @private @brief `ctx` was prepared with STPUB of the chip */
+    uint8_t ctx_valid;
+} lt_session_auto_t;
+#endif
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Basic sleep mode */
 #define LT_L2_SLEEP_KIND_SLEEP 0x05
 /** @brief Deep sleep mode */
 #define LT_L2_SLEEP_KIND_DEEP_SLEEP 0x0a
 
+#if LT_IDLE_SLEEP
+/** @brief Statistics of `lt_idle_t`, latencies are measured by `lt_idle_t.time_us` */
+typedef struct lt_idle_stats_t {
+    /** @brief Number of times TROPIC01 was put to sleep, by `lt_idle_poll()` or `lt_sleep()` */
+    uint32_t sleeps;
+    /** @brief Number of requests which woke TROPIC01 up */
+    uint32_t wakes;
+    /** @brief Time from sending the waking request to receiving its response, for the last wake */
+    uint32_t wake_us_last;
+    /** @brief The longest wake */
+    uint32_t wake_us_max;
+    /** @brief Sum of all wakes, divided by `wakes` it gives the average */
+    uint32_t wake_us_total;
+} lt_idle_stats_t;
+
+/**
+ * @brief Idle manager supplied by the application in `lt_l2_state_t.idle`.
+ * @details `lt_idle_poll()` called by the application from time to time puts TROPIC01 to sleep when there was no
+ * communication with it for `window_ms`. The next request wakes it up, there is nothing to be called before. Secure
+ * session ends by sleep, with LT_SESSION_REKEY and `lt_handle_t.rekey` it is re-established before the next L3
+ * command, otherwise L3 commands fail with LT_HOST_NO_SESSION until the application starts a new one.
+ */
+typedef struct lt_idle_t {
+    /** @public @brief Monotonic clock in us, mandatory */
+    uint32_t (*time_us)(void);
+    /** @public @brief Time without communication after which TROPIC01 is put to sleep, 0 disables it */
+    uint32_t window_ms;
+    /** @public @brief Statistics, read only */
+    lt_idle_stats_t stats;
+    /** @private @brief Time of the last communication */
+    uint32_t last_us;
+    /** @private @brief Time when the waking request was sent */
+    uint32_t wake_start_us;
+    /** @private @brief TROPIC01 sleeps */
+    uint8_t asleep;
+    /** @private @brief Response to the waking request is awaited */
+    uint8_t waking;
+    /** @private @brief Secure session was established before the sleep, so it is re-established after it */
+    uint8_t resume;
+} lt_idle_t;
+#endif
+
+#if LT_DEADLINE
+/**
+ * @brief Deadline of communication, supplied in `h->l2.deadline` before `lt_init()`.
+ *
+ * While a deadline is set by `lt_deadline_set()`, every SPI transfer gets at most the time left as its timeout, and
+ * waits for TROPIC01 (polling of CHIP_STATUS, INT pin, retries) are cut at the deadline. Once it passes, no other
+ * transfer is started and the call returns LT_DEADLINE_EXCEEDED.
+ */
+typedef struct lt_deadline_t {
+    /** @public @brief Monotonic clock in us, mandatory */
+    uint32_t (*time_us)(void);
+    /** @private @brief Time of `time_us` when the deadline passes */
+    uint32_t at_us;
+    /** @private @brief Deadline is set */
+    uint8_t armed;
+} lt_deadline_t;
+#endif
+
+#if LT_MODE_TRACK
+/**
+ * @brief Freshness of `lt_l2_state_t.mode`, supplied in `h->l2.mode_track`.
+ *
+ * Each poll of CHIP_STATUS refreshes the mode from its STARTUP bit anyway. The tracker notes when that happened, so
+ * `lt_update_mode()` within `max_age_us` of the last observation returns without reading CHIP_STATUS again.
+ * Observations are forgotten by `lt_init()` and once `lt_reboot()` is acknowledged, readiness after reboot found by
+ * LT_REBOOT_POLL counts as an observation.
+ */
+typedef struct lt_mode_track_t {
+    /** @public @brief Monotonic clock in us, mandatory */
+    uint32_t (*time_us)(void);
+    /** @public @brief Time in us for which an observed mode is trusted */
+    uint32_t max_age_us;
+    /** @public @brief Number of calls of `lt_update_mode()` answered without reading CHIP_STATUS, read only */
+    uint32_t skipped;
+    /** @private @brief Time of `time_us` when CHIP_STATUS was observed last */
+    uint32_t seen_us;
+    /** @private @brief `seen_us` holds an observation */
+    uint8_t valid;
+} lt_mode_track_t;
+#endif
+
+#if LT_SESSION_LIVENESS
+/** @brief Evidence of the end of the secure session, passed to `lt_liveness_t.lost` */
+typedef enum lt_liveness_reason_t {
+    /** @brief CHIP_STATUS had STARTUP bit set, TROPIC01 was reset into the bootloader */
+    LT_LIVENESS_STARTUP = 1,
+    /** @brief TROPIC01 has no session (NO_SESSION status, e.g. after a reset), or the host ended it */
+    LT_LIVENESS_NO_SESSION,
+    /** @brief Encrypted command or result failed authentication (TAG_ERR status or by the host) */
+    LT_LIVENESS_AUTH
+} lt_liveness_reason_t;
+
+/**
+ * @brief Passive tracking of the secure session, supplied in `h->l2.liveness` before the session is started.
+ *
+ * Communication which happens anyway tells whether the session still holds, so `lt_session_is_alive()` answers
+ * without sending anything. The session is lost after STARTUP bit in CHIP_STATUS, NO_SESSION or TAG_ERR status of
+ * a response and a result failing authentication on the host. Each authenticated result refreshes it. Only after
+ * `probe_after_ms` without any result `lt_session_is_alive()` probes it by `lt_ping()`.
+ */
+typedef struct lt_liveness_t {
+    /** @public @brief Monotonic clock in us, mandatory when `probe_after_ms` is set */
+    uint32_t (*time_us)(void);
+    /** @public @brief Time without an L3 result after which the session is probed, 0 never probes */
+    uint32_t probe_after_ms;
+    /** @public @brief Called once when the session is found lost, may be NULL. Runs in the middle of the call. */
+    void (*lost)(void *ctx, const lt_liveness_reason_t reason);
+    /** @public @brief Context passed to `lost` */
+    void *ctx;
+    /** @public @brief Number of lost sessions, read only */
+    uint32_t losses;
+    /** @public @brief Number of pings sent by `lt_session_is_alive()`, read only */
+    uint32_t probes;
+    /** @private @brief Time of `time_us` of the last authenticated result */
+    uint32_t seen_us;
+    /** @private @brief Session was established and nothing showed it was lost since */
+    uint8_t alive;
+} lt_liveness_t;
+#endif
+
+#if LT_USE_SPI_SPEED
+/** @brief Statistics of `lt_spi_tune_t` */
+typedef struct lt_spi_tune_stats_t {
+    /** @brief Number of times the clock was raised after a window without errors */
+    uint32_t raises;
+    /** @brief Number of times the clock was lowered because of CRC errors */
+    uint32_t backoffs;
+    /** @brief CRC errors of received frames and of requests reported by TROPIC01 */
+    uint32_t crc_errors;
+} lt_spi_tune_stats_t;
+
+/**
+ * @brief Auto-tuner of SPI clock supplied by the application in `lt_l2_state_t.spi_tune`.
+ * @details The tuner starts at `min_hz` with the first frame and raises the clock by `step_hz` after each `window`
+ * frames with at most `max_errors` CRC errors, up to `max_hz`. Once there are more of them within a window, the
+ * clock is lowered by `step_hz` and the failing one becomes a ceiling, which is not reached again until the clock is
+ * set by `lt_spi_speed_set()`. Frames of the failing window are recovered by resends of `lt_l2_receive()`.
+ */
+typedef struct lt_spi_tune_t {
+    /** @public @brief Lowest clock in Hz, the tuner starts at it */
+    uint32_t min_hz;
+    /** @public @brief Highest clock in Hz */
+    uint32_t max_hz;
+    /** @public @brief Change of the clock in Hz */
+    uint32_t step_hz;
+    /** @public @brief Number of frames after which the clock is raised, 0 disables the tuner */
+    uint16_t window;
+    /** @public @brief CRC errors tolerated within a window */
+    uint16_t max_errors;
+    /** @public @brief Statistics, read only (can be cleared by the application) */
+    lt_spi_tune_stats_t stats;
+    /** @public @brief Clock used by the port, read only, 0 until the tuner starts */
+    uint32_t hz;
+    /** @private @brief Clock requested from the port, which may round it down */
+    uint32_t target_hz;
+    /** @private @brief The lowest requested clock with too many errors, 0 when there was none */
+    uint32_t ceiling_hz;
+    /** @private @brief Frames of the current window */
+    uint16_t frames;
+    /** @private @brief CRC errors of the current window */
+    uint16_t errors;
+} lt_spi_tune_t;
+#endif
+
+#if LT_TUNE_PERSIST
+/** @brief Characters of `lt_tune_store_t.port_id` kept in the key of a tuning profile, longer identities are cut */
+#define LT_TUNE_PORT_ID_LEN 32
+/** @brief Size of the key of a tuning profile: serial number of the chip and identity of the port, zero padded */
+#define LT_TUNE_KEY_SIZE (16 + LT_TUNE_PORT_ID_LEN)
+/** @brief Magic at the start of a tuning profile */
+#define LT_TUNE_MAGIC "LTTU"
+/** @brief Version of the format of tuning profiles */
+#define LT_TUNE_VERSION 1
+/** @brief Size of the header of a tuning profile: magic, version, key and sections */
+#define LT_TUNE_HEADER_SIZE (4 + 1 + LT_TUNE_KEY_SIZE + 1)
+/** @brief Size of the polling section with `n` statistics: their number and each of them */
+#define LT_TUNE_POLL_SIZE(n) (1 + (n) * 28)
+/** @brief Size of the SPI clock section */
+#define LT_TUNE_SPI_SIZE 20
+/** @brief Size of the retry statistics section */
+#define LT_TUNE_RETRY_SIZE 24
+/** @brief Longest tuning profile made by `lt_tune_export()` of any build, including the CRC */
+#define LT_TUNE_EXPORT_SIZE_MAX (LT_TUNE_HEADER_SIZE + LT_TUNE_POLL_SIZE(16) + LT_TUNE_SPI_SIZE + LT_TUNE_RETRY_SIZE + 2)
+
+/**
+ * @brief Persistent store of the tuning profile of the handle, supplied by the application in
+ * `lt_handle_t.tune_store`.
+ * @details The profile holds what the handle learned about the chip and the bus: polling statistics of
+ * LT_ADAPTIVE_POLLING, the SPI clock and its ceiling found by `lt_spi_tune_t` and error counts of
+ * LT_L2_RETRY_POLICY. `lt_init()` reads CHIP_ID and loads the profile saved under the serial number of the chip and
+ * `port_id`, so the handle continues with them from its first command. `lt_deinit()` saves the profile again. Files
+ * on Unix are provided by hal/port/unix/libtropic_port_unix_tune.h, an MCU keeps the profile in its flash.
+ */
+typedef struct lt_tune_store_t {
+    /** @public @brief Identity of the port the chip is connected by, e.g. the device path, NUL terminated */
+    const char *port_id;
+    /** @public @brief Loads profile saved under `key` (LT_TUNE_KEY_SIZE bytes) into `buff`. Returns LT_OK when it was
+     * found, LT_NOT_FOUND otherwise. */
+    lt_ret_t (*load)(const uint8_t *key, uint8_t *buff, const uint16_t max_len, uint16_t *len, void *ctx);
+    /** @public @brief Saves profile under `key`, NULL when profiles are only loaded */
+    lt_ret_t (*save)(const uint8_t *key, const uint8_t *buff, const uint16_t len, void *ctx);
+    /** @public @brief Context passed to the callbacks */
+    void *ctx;
+    /** @private @brief Key of the chip, valid when `key_valid` is set */
+    uint8_t key[LT_TUNE_KEY_SIZE];
+    /** @private @brief Key was made from CHIP_ID read by `lt_init()` */
+    uint8_t key_valid;
+} lt_tune_store_t;
+#endif
+
+#if LT_PORT_SHARE
+/**
+ * @brief Port device shared by handles, supplied (zeroed) by the application in `lt_l2_state_t.port_share` of all
+ * handles with the same `device`.
+ * @details The first `lt_init()` or `lt_port_attach()` initializes the device by `lt_port_init()`, the next ones only
+ * take a reference, and the last `lt_deinit()` or `lt_port_detach()` deinitializes it. The reference of
+ * `lt_port_attach()` keeps the device open for handles created and destroyed in between.
+ *
+ * Handles talk to the same chip, so only one of them can have a secure session. The first reference must not be
+ * taken concurrently with others, the later ones are serialized by `lt_port_lock()` with LT_THREAD_SAFE.
+ */
+typedef struct lt_port_share_t {
+    /** @public @brief Number of references, read only, zero while the device is not initialized */
+    uint16_t refs;
+} lt_port_share_t;
+#endif
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Reboot TROPIC01 chip */
 #define LT_MODE_APP 0x01
@@ -661,6 +1841,88 @@ typedef enum CONFIGURATION_OBJECTS_REGS_IDX {
 /** @brief Index of last data slot. TROPIC01 contains 512 slots indexed 0-511. */
 #define R_MEM_DATA_SLOT_MAX (511)
 
+#if LT_RMEM_CACHE
+#ifndef LT_RMEM_CACHE_SLOTS
+/** @brief Number of R-memory slots held by `lt_rmem_cache_t` */
+#define LT_RMEM_CACHE_SLOTS 4
+#endif
+/**
+ * @brief Write-back cache of R-memory slots used by `lt_rmem_cache_read()` and `lt_rmem_cache_write()`.
+ *
+ * The application places it (zeroed) into `lt_handle_t.rmem_cache`. The least recently used slot is evicted when
+ * another one is needed, its pending write is flushed then. `lt_r_mem_data_write()`, `lt_r_mem_data_erase()` and
+ * their range variants drop the slots they change, including pending writes.
+ */
+typedef struct lt_rmem_cache_t {
+    /** @private @brief Counter of accesses, orders entries by their last use */
+    uint32_t tick;
+    /** @private @brief Cached slots */
+    struct {
+        /** Last use, 0 for unused entry */
+        uint32_t used;
+        uint16_t slot;
+        /** Size of data, 0 for empty slot */
+        uint16_t size;
+        /** Nonzero when data were not written to TROPIC01 yet */
+        uint8_t dirty;
+        /** Nonzero when the slot in TROPIC01 is known to be empty */
+        uint8_t chip_empty;
+        uint8_t data[R_MEM_DATA_SIZE_MAX];
+    } entries[LT_RMEM_CACHE_SLOTS];
+} lt_rmem_cache_t;
+#endif
+
+#if LT_L3_BUFF_POOL
+/** @brief Maximal number of buffers in `lt_l3_buff_pool_t` */
+#define LT_L3_BUFF_POOL_MAX 32
+
+/** @brief Statistics of `lt_l3_buff_pool_t`, see `lt_l3_buff_pool_stats_get()` */
+typedef struct lt_l3_buff_pool_stats_t {
+    /** @brief Number of borrowed buffers */
+    uint32_t borrows;
+    /** @brief Number of borrows which found no free buffer and had to wait */
+    uint32_t contended;
+    /** @brief Number of borrows which failed with LT_BUSY after `wait_ms` */
+    uint32_t timeouts;
+    /** @brief Buffers borrowed now */
+    uint8_t in_use;
+    /** @brief Most buffers borrowed at once */
+    uint8_t in_use_max;
+} lt_l3_buff_pool_stats_t;
+
+/**
+ * @brief L3 buffers shared by several handles, initialized by `lt_l3_buff_pool_init()`.
+ *
+ * A handle with `lt_handle_t.l3_pool` set borrows a buffer when an API function executes its first L3 command and
+ * returns it, wiped, when the function returns. So N handles executing commands mostly one at a time need fewer
+ * than N buffers.
+ */
+typedef struct lt_l3_buff_pool_t {
+    /**
+     * @public @brief Called around changes of the pool when handles are used by several threads, NULL when they
+     * are not
+     */
+    void (*lock)(void *ctx);
+    /** @public @brief Counterpart of `lock` */
+    void (*unlock)(void *ctx);
+    /** @public @brief Context of `lock` and `unlock` */
+    void *lock_ctx;
+
+    /** @private @brief Buffers, `cnt` arrays of `buff_size` bytes */
+    uint8_t *buffs;
+    /** @private @brief Size of one buffer */
+    uint16_t buff_size;
+    /** @private @brief Number of buffers */
+    uint8_t cnt;
+    /** @private @brief Time to wait for a free buffer */
+    uint32_t wait_ms;
+    /** @private @brief Bit i is set when i-th buffer is free */
+    uint32_t free_mask;
+    /** @private @brief Statistics */
+    lt_l3_buff_pool_stats_t stats;
+} lt_l3_buff_pool_t;
+#endif
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Maximum number of random bytes requested at once */
 #define RANDOM_VALUE_GET_LEN_MAX 255
@@ -708,6 +1970,53 @@ typedef enum lt_ecc_curve_type_t { CURVE_P256 = 1, CURVE_ED25519 } lt_ecc_curve_
 /** @brief ECC key origin */
 typedef enum ecc_key_origin_t { CURVE_GENERATED = 1, CURVE_STORED } ecc_key_origin_t;
 
+/** @brief Content of one ECC key slot, filled by `lt_ecc_key_inventory()` */
+typedef struct lt_ecc_key_info_t {
+    /** @brief LT_OK when the slot holds a key, LT_L3_ECC_INVALID_KEY when it is empty */
+    lt_ret_t status;
+    /** @brief Curve of the key, valid with LT_OK */
+    lt_ecc_curve_type_t curve;
+    /** @brief Origin of the key, valid with LT_OK */
+    ecc_key_origin_t origin;
+    /** @brief Public key, 32B for Ed25519 and 64B for P256, valid with LT_OK */
+    uint8_t key[64];
+} lt_ecc_key_info_t;
+
+/** @brief Key imported by `lt_ecc_key_store_batch()` */
+typedef struct lt_ecc_key_import_t {
+    /** @brief Slot the key is stored to */
+    ecc_slot_t slot;
+    /** @brief Curve of the key, CURVE_P256 or CURVE_ED25519 */
+    lt_ecc_curve_type_t curve;
+    /** @brief Private key, wiped by `lt_ecc_key_store_batch()` */
+    uint8_t key[32];
+    /** @brief Public key read back from the slot, 32B for Ed25519 and 64B for P256, valid with LT_OK */
+    uint8_t pubkey[64];
+    /** @brief LT_OK when the key was stored and read back, LT_FAIL when it was not executed or read back differs */
+    lt_ret_t status;
+} lt_ecc_key_import_t;
+
+#if LT_ECC_KEY_CACHE
+/**
+ * @brief Public keys read by `lt_ecc_key_read()`, indexed by `ecc_slot_t`.
+ *
+ * The application places it (zeroed) into `lt_handle_t.key_cache`, then `lt_ecc_key_read()` reads each slot from
+ * TROPIC01 only once. A slot is invalidated by `lt_ecc_key_generate()`, `lt_ecc_key_store()` and
+ * `lt_ecc_key_erase()`, whole cache by `lt_reboot()`, by session establishment or by `lt_ecc_key_cache_invalidate()`.
+ */
+typedef struct lt_ecc_key_cache_t {
+    /** @private @brief Bit mask of valid slots */
+    uint32_t valid;
+    /** @private @brief Cached slots */
+    struct {
+        /** Public key, 32B for Ed25519 and 64B for P256 */
+        uint8_t key[64];
+        lt_ecc_curve_type_t curve;
+        ecc_key_origin_t origin;
+    } slots[ECC_SLOT_31 + 1];
+} lt_ecc_key_cache_t;
+#endif
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Maximal allowed value of the monotonic counter. */
 #define MCOUNTER_VALUE_MAX 0xFFFFFFFE
@@ -870,6 +2179,361 @@ typedef enum mac_and_destroy_slot_t {
     MAC_AND_DESTROY_SLOT_127
 } mac_and_destroy_slot_t;
 
+#if LT_DEVICE_POOL
+//--------------------------------------------------------------------------------------------------------------------//
+/** @brief Operations which can be dispatched to chips of `lt_pool_t` */
+typedef enum lt_pool_op_t {
+    /** `lt_ping()`, `in`/`in_len` is the message, echoed message is stored into `out` */
+    LT_POOL_OP_PING = 1,
+    /** `lt_random_value_get()`, `in_len` random bytes are stored into `out` */
+    LT_POOL_OP_RANDOM_VALUE_GET,
+    /** `lt_ecc_ecdsa_sign_digest()`, `in` is 32B digest, 64B signature is stored into `out` */
+    LT_POOL_OP_ECDSA_SIGN_DIGEST,
+    /** `lt_ecc_eddsa_sign()`, `in`/`in_len` is the message, 64B signature is stored into `out` */
+    LT_POOL_OP_EDDSA_SIGN,
+    /** `lt_mac_and_destroy()`, `in` is 32B data sent to TROPIC01, 32B data returned from it are stored into `out` */
+    LT_POOL_OP_MAC_AND_DESTROY,
+    /** `lt_ecc_key_read()`, the key (64B for P-256, 32B for Ed25519) is stored into `out`, followed by the curve
+     * and origin bytes at `out[64]` and `out[65]` */
+    LT_POOL_OP_ECC_KEY_READ,
+#if LT_ENABLE_R_MEM
+    /** `lt_r_mem_data_read()`, `slot` is the R-Memory slot, up to R_MEM_DATA_SIZE_MAX bytes are stored into `out` */
+    LT_POOL_OP_R_MEM_DATA_READ,
+#endif
+    /** `lt_r_config_read()`, `slot` is the address of the object, its `uint32_t` value is stored into `out` */
+    LT_POOL_OP_R_CONFIG_READ,
+    /** `lt_i_config_read()`, `slot` is the address of the object, its `uint32_t` value is stored into `out` */
+    LT_POOL_OP_I_CONFIG_READ,
+#if LT_ENABLE_MCOUNTER
+    /** `lt_mcounter_get()`, `slot` is the counter index, its `uint32_t` value is stored into `out` */
+    LT_POOL_OP_MCOUNTER_GET,
+#endif
+
+    /** @brief Special helper value used to signalize the last enum value, read operations are the last ones */
+    LT_POOL_OP_T_LAST_VALUE
+} lt_pool_op_t;
+
+/** @brief First of the read operations, which are idempotent and may be collapsed and hedged, see
+ * `lt_pool_reads_t` */
+#define LT_POOL_OP_READ_FIRST LT_POOL_OP_ECC_KEY_READ
+/** @brief Number of the read operations */
+#define LT_POOL_OP_READS_CNT (LT_POOL_OP_T_LAST_VALUE - LT_POOL_OP_READ_FIRST)
+/** @brief Number of the operations */
+#define LT_POOL_OPS_CNT (LT_POOL_OP_T_LAST_VALUE - 1)
+/** @brief Largest output of a read operation, workers keep one buffer of this size on their stack */
+#define LT_POOL_READ_LEN_MAX R_MEM_DATA_SIZE_MAX
+
+/**
+ * @brief One job submitted to `lt_pool_t`. The caller fills the operation and its arguments, the pool fills the
+ * result.
+ */
+typedef struct lt_pool_job_t {
+    /** @brief Operation */
+    lt_pool_op_t op;
+    /** @brief ECC slot or MAC-and-Destroy slot, ignored by the other operations */
+    uint16_t slot;
+    /** @brief Length of `in`, or number of requested bytes for `LT_POOL_OP_RANDOM_VALUE_GET` */
+    uint16_t in_len;
+    /** @brief Input data of the operation */
+    const uint8_t *in;
+    /** @brief Output buffer of the operation */
+    uint8_t *out;
+    /** @brief Result of the operation, valid after completion */
+    lt_ret_t ret;
+    /** @brief Number of bytes stored into `out`, valid after completion */
+    uint16_t out_len;
+    /** @brief Index of the chip which executed the job, valid after completion */
+    uint8_t chip;
+    /** @private @brief Job waits for another chip after its chip failed, accessed atomically */
+    uint8_t requeued;
+    /** @private @brief Number of chips which failed to execute the job */
+    uint8_t attempts;
+    /** @private @brief Priority class, LT_POOL_PRIO_CNT for jobs of the batch submitted by `lt_pool_submit()` */
+    uint8_t prio;
+    /** @private @brief Time of submission, see `lt_pool_prio_t.time_us` */
+    uint32_t submit_us;
+    /** @private @brief Time when a worker took the job, see `lt_pool_prio_t.time_us` */
+    uint32_t start_us;
+    /** @private @brief Predicted service time counted in the backlog of its class, see `lt_pool_prio_t` */
+    uint32_t service_us;
+    /** @private @brief Next job in the queue of the priority class */
+    struct lt_pool_job_t *queue_next;
+    /** @private @brief Next job waiting for the result of the same read, see `lt_pool_reads_t` */
+    struct lt_pool_job_t *flight_next;
+} lt_pool_job_t;
+
+/** @brief Maximal number of groups of `lt_pool_session_plan()`, one per pairing key slot */
+#define LT_POOL_SESSION_GROUPS_MAX (PAIRING_KEY_SLOT_INDEX_3 + 1)
+
+/** @brief Consecutive jobs executed in the secure session of one pairing key, see `lt_pool_session_plan()` */
+typedef struct lt_pool_session_group_t {
+    /** @brief Pairing key slot of the session */
+    pkey_index_t pkey;
+    /** @brief Index of the first job of the group */
+    uint32_t first;
+    /** @brief Number of jobs of the group */
+    uint32_t cnt;
+} lt_pool_session_group_t;
+
+/** @brief Priority class of latency-critical jobs, e.g. signing */
+#define LT_POOL_PRIO_HIGH 0
+/** @brief Priority class of regular jobs */
+#define LT_POOL_PRIO_NORMAL 1
+/** @brief Priority class of bulk jobs, e.g. pulls of random values or backups */
+#define LT_POOL_PRIO_LOW 2
+/** @brief Number of priority classes */
+#define LT_POOL_PRIO_CNT 3
+
+/** @brief Number of jobs of higher classes after which a waiting job of a lower class is taken, if not set */
+#ifndef LT_POOL_PRIO_BURST
+#define LT_POOL_PRIO_BURST 8
+#endif
+
+/** @brief Number of recent jobs of an operation over which its service time is averaged, if not set */
+#ifndef LT_POOL_SERVICE_EWMA
+#define LT_POOL_SERVICE_EWMA 8
+#endif
+
+/** @brief Statistics of one priority class of `lt_pool_prio_t`, latencies are measured by its `time_us` */
+typedef struct lt_pool_prio_stats_t {
+    /** @brief Number of jobs waiting in the queue */
+    uint32_t depth;
+    /** @brief Most jobs waiting in the queue at once */
+    uint32_t depth_max;
+    /** @brief Number of submitted jobs */
+    uint32_t submitted;
+    /** @brief Number of completed jobs */
+    uint32_t done;
+    /** @brief Time from submission to completion of the last completed job */
+    uint32_t latency_us_last;
+    /** @brief Longest time from submission to completion */
+    uint32_t latency_us_max;
+    /** @brief Sum of times from submission to completion, divided by `done` gives the average */
+    uint64_t latency_us_total;
+    /** @brief Number of jobs refused with LT_OVERLOAD */
+    uint32_t overloaded;
+    /** @brief Predicted wait in the queue of a job submitted now, compared with `lt_pool_prio_t.deadline_us` */
+    uint32_t wait_us_predicted;
+} lt_pool_prio_stats_t;
+
+/**
+ * @brief Priority scheduling of jobs of the pool, see `lt_pool_prio_init()`.
+ *
+ * Jobs are submitted by `lt_pool_submit_prio()` into the queue of their class at any time, also while the workers
+ * run. A worker takes the next job after each completed one, so a job of a higher class waits at most for the
+ * commands which are being executed, never for the queued ones. A class with waiting jobs is passed over at most
+ * `burst` times by higher classes, then its oldest job is taken, so bulk work always progresses.
+ *
+ * Admission control keeps the queues short under overload. Service time of each operation is predicted from the
+ * execution time of its L3 command and, with `time_us` set, refined by the average of completed jobs, measured from
+ * the moment a worker takes the job. A job waits for the predicted service times of the jobs queued in its class and
+ * in the higher ones, divided among the chips which take jobs. A batch whose last job would wait longer than
+ * `deadline_us` of its class is refused as a whole with LT_OVERLOAD, so the caller can shed the load or send it to
+ * another pool right away.
+ */
+typedef struct lt_pool_prio_t {
+    /** @public @brief Called around changes of the queues when several workers run, NULL when they do not */
+    void (*lock)(void *ctx);
+    /** @public @brief Counterpart of `lock` */
+    void (*unlock)(void *ctx);
+    /** @public @brief Context of `lock` and `unlock` */
+    void *lock_ctx;
+    /** @public @brief Monotonic clock in us for latency statistics, NULL to not measure latency */
+    uint32_t (*time_us)(void);
+    /** @public @brief Number of jobs of higher classes after which a lower class is served, 0 for
+     * LT_POOL_PRIO_BURST */
+    uint32_t burst;
+    /** @public @brief Longest predicted wait of a job of each class in us, 0 admits all jobs of the class */
+    uint32_t deadline_us[LT_POOL_PRIO_CNT];
+
+    /** @private @brief First waiting job of each class */
+    lt_pool_job_t *head[LT_POOL_PRIO_CNT];
+    /** @private @brief Last waiting job of each class */
+    lt_pool_job_t *tail[LT_POOL_PRIO_CNT];
+    /** @private @brief Number of jobs taken from higher classes while the class had waiting jobs */
+    uint32_t skipped[LT_POOL_PRIO_CNT];
+    /** @private @brief Statistics of each class */
+    lt_pool_prio_stats_t stats[LT_POOL_PRIO_CNT];
+    /** @private @brief Average service time of each operation in us, 0 until a job of it is completed */
+    uint32_t service_us[LT_POOL_OPS_CNT];
+    /** @private @brief Sum of predicted service times of the jobs waiting in each class */
+    uint64_t backlog_us[LT_POOL_PRIO_CNT];
+} lt_pool_prio_t;
+
+/** @brief Chip of the pool is a hot standby, it takes jobs only in place of a failed chip */
+#define LT_POOL_CHIP_STANDBY 0
+/** @brief Chip of the pool takes jobs */
+#define LT_POOL_CHIP_ACTIVE 1
+/** @brief Chip of the pool lost its secure session, its worker establishes a new one before taking jobs */
+#define LT_POOL_CHIP_LOST 2
+/** @brief Chip of the pool is in ALARM mode, no job is dispatched to it */
+#define LT_POOL_CHIP_ALARM 3
+/** @brief Chip of the pool was not warmed up yet, its worker initializes the handle and establishes the session */
+#define LT_POOL_CHIP_INIT 4
+
+/**
+ * @brief Failover state of one chip of the pool, see `lt_pool_failover_init()`.
+ */
+typedef struct lt_pool_chip_t {
+    /** @public @brief Handshake context of the chip prepared by `lt_session_ctx_init()`, used to re-establish
+     * the session */
+    lt_session_ctx_t ctx;
+    /** @private @brief One of LT_POOL_CHIP_* values, changed only by the worker of the chip */
+    uint8_t state;
+    /** @private @brief Number of times the chip lost its session */
+    uint32_t failures;
+} lt_pool_chip_t;
+
+/**
+ * @brief Warm-up of the chips of the pool at startup, see `lt_pool_warmup_init()`.
+ *
+ * The worker of each chip initializes its handle, reads CHIP_ID and STPub and establishes the session, so the bus
+ * transfers of all chips and the X25519 and HKDF computations of their handshakes run in parallel on the threads
+ * of the workers. STPub is taken from the persistent cache when `cache_load` provides a valid export of the
+ * certificate store of the chip, which saves reading and parsing the certificate store over the bus.
+ */
+typedef struct lt_pool_warmup_t {
+    /** @public @brief Private key of the pairing key in `pkey_index`, must stay valid while the pool is used */
+    const uint8_t *shipriv;
+    /** @public @brief Public key of the pairing key in `pkey_index`, must stay valid while the pool is used */
+    const uint8_t *shipub;
+    /** @public @brief Pairing key slot of the sessions */
+    pkey_index_t pkey_index;
+    /** @public @brief Loads export of the certificate store of the chip with `chip_id`, made by
+     * `lt_cert_store_export()`, into `buff`. Returns LT_OK when it was found. NULL when there is no cache. */
+    lt_ret_t (*cache_load)(const struct lt_chip_id_t *chip_id, uint8_t *buff, const uint16_t max_len, uint16_t *len,
+                           void *ctx);
+    /** @public @brief Stores export of the certificate store read from the chip after `cache_load` did not
+     * provide a valid one, may be NULL */
+    void (*cache_save)(const struct lt_chip_id_t *chip_id, const uint8_t *buff, const uint16_t len, void *ctx);
+    /** @public @brief Called by the worker when warm-up of its chip finished with `ret`, may be NULL. The chip
+     * takes jobs from now on when `ret` is LT_OK. */
+    void (*ready)(const uint8_t chip, const lt_ret_t ret, void *ctx);
+    /** @public @brief Context passed to the callbacks */
+    void *ctx;
+} lt_pool_warmup_t;
+
+/** @brief Maximal number of distinct reads executed at once by `lt_pool_reads_t`, more are not collapsed */
+#ifndef LT_POOL_READS_FLIGHTS
+#define LT_POOL_READS_FLIGHTS 8
+#endif
+
+/** @brief Number of recent latencies of each read operation the hedging delay is computed from */
+#ifndef LT_POOL_READS_SAMPLES
+#define LT_POOL_READS_SAMPLES 32
+#endif
+
+/** @brief Statistics of `lt_pool_reads_t` */
+typedef struct lt_pool_reads_stats_t {
+    /** @brief Number of reads executed by the chips, hedges included */
+    uint32_t executed;
+    /** @brief Number of read jobs completed by the result of an identical read which was already executing */
+    uint32_t collapsed;
+    /** @brief Number of reads issued again to a second chip */
+    uint32_t hedged;
+    /** @brief Number of hedges which completed before the original read */
+    uint32_t hedge_wins;
+} lt_pool_reads_stats_t;
+
+/** @private @brief Read executed by one or two chips with the jobs waiting for its result */
+typedef struct lt_pool_flight_t {
+    /** @brief Job which started the read, NULL when the flight is free */
+    lt_pool_job_t *job;
+    /** @brief Jobs of the same read submitted while it executes, linked by `flight_next` */
+    lt_pool_job_t *followers;
+    /** @brief Operation and slot of the read, compared without touching completed jobs */
+    lt_pool_op_t op;
+    uint16_t slot;
+    /** @brief Chip which executes the original read */
+    uint8_t chip;
+    /** @brief Number of chips executing the read */
+    uint8_t runners;
+    /** @brief Nonzero when the read was hedged */
+    uint8_t hedged;
+    /** @brief Nonzero when the result was delivered to the jobs */
+    uint8_t done;
+    /** @brief Time the original read started */
+    uint32_t start_us;
+} lt_pool_flight_t;
+
+/**
+ * @brief Single-flight and hedging of read operations of the pool, see `lt_pool_reads_init()`.
+ *
+ * Reads (LT_POOL_OP_ECC_KEY_READ and the following operations) are idempotent. A read job taken while an identical
+ * read (same operation and slot) executes on some chip does not execute: it waits and completes with the result of
+ * the executing one (single-flight). A read executing longer than `hedge_pct` percentile of recent latencies of its
+ * operation is issued again by an idle worker of another chip, and the first result completes the jobs (hedging).
+ * Both assume the chips hold the same data, as the pool already does for signing by any chip.
+ */
+typedef struct lt_pool_reads_t {
+    /** @public @brief Called around changes of the flights when several workers run, NULL when they do not */
+    void (*lock)(void *ctx);
+    /** @public @brief Counterpart of `lock` */
+    void (*unlock)(void *ctx);
+    /** @public @brief Context of `lock` and `unlock` */
+    void *lock_ctx;
+    /** @public @brief Monotonic clock in us, NULL disables hedging */
+    uint32_t (*time_us)(void);
+    /** @public @brief Percentile of recent latencies after which a read is hedged, e.g. 95, 0 disables hedging */
+    uint8_t hedge_pct;
+    /** @public @brief Reads are not hedged before they execute this long */
+    uint32_t hedge_min_us;
+
+    /** @private @brief Reads which are executing */
+    lt_pool_flight_t flights[LT_POOL_READS_FLIGHTS];
+    /** @private @brief Recent latencies of each read operation, a ring */
+    uint32_t samples[LT_POOL_OP_READS_CNT][LT_POOL_READS_SAMPLES];
+    /** @private @brief Number of latencies in the ring of each read operation, at most LT_POOL_READS_SAMPLES */
+    uint32_t samples_cnt[LT_POOL_OP_READS_CNT];
+    /** @private @brief Position of the next latency in the ring of each read operation */
+    uint32_t samples_next[LT_POOL_OP_READS_CNT];
+    /** @private @brief Statistics */
+    lt_pool_reads_stats_t stats;
+} lt_pool_reads_t;
+
+/**
+ * @brief Several TROPIC01 chips, each with its own handle, executing jobs of one shared batch.
+ *
+ * Each handle has its own port device and an established secure session. The application runs one worker thread
+ * per chip calling `lt_pool_work()`. Workers take jobs from the batch one by one in submission order, so a chip
+ * which finishes its job takes the next pending one, and slower chips never hold jobs other chips could execute.
+ * With `lt_pool_failover_init()`, jobs of a chip which lost its session or entered ALARM mode are taken over by
+ * the other chips, and spare chips with established sessions replace the failed ones.
+ */
+typedef struct lt_pool_t {
+    /** @private @brief Handles of the chips */
+    lt_handle_t *const *handles;
+    /** @private @brief Number of handles */
+    uint8_t handles_cnt;
+    /** @private @brief Submitted batch of jobs */
+    lt_pool_job_t *jobs;
+    /** @private @brief Number of jobs in the batch */
+    uint32_t jobs_cnt;
+    /** @private @brief Index of the next job to be taken, accessed atomically */
+    uint32_t next;
+    /** @private @brief Number of completed jobs, accessed atomically */
+    uint32_t done;
+    /** @private @brief Called by the worker after each completed job, may be NULL */
+    void (*complete)(lt_pool_job_t *job, void *ctx);
+    /** @private @brief Context passed to `complete` */
+    void *ctx;
+    /** @private @brief Failover state of the chips, NULL when failover is not enabled */
+    lt_pool_chip_t *chips;
+    /** @private @brief Number of chips which take jobs, the others are hot standby */
+    uint8_t active_max;
+    /** @private @brief Number of chips in LT_POOL_CHIP_ACTIVE state, accessed atomically */
+    uint8_t active;
+    /** @private @brief Number of requeued jobs, accessed atomically */
+    uint32_t requeued;
+    /** @private @brief Priority scheduling, NULL when it is not enabled */
+    lt_pool_prio_t *prio;
+    /** @private @brief Single-flight and hedging of reads, NULL when they are not enabled */
+    lt_pool_reads_t *reads;
+    /** @private @brief Warm-up of the chips, NULL when it is not enabled */
+    const lt_pool_warmup_t *warmup;
+} lt_pool_t;
+#endif
+
 //--------------------------------------------------------------------------------------------------------------------//
 /** @brief Maximal size of returned serial code */
 #define SERIAL_CODE_SIZE 32u
@@ -935,4 +2599,107 @@ typedef struct lt_config_t {
     uint32_t obj[LT_CONFIG_OBJ_CNT];
 } lt_config_t;
 
+#if LT_CONFIG_CACHE
+/**
+ * @brief R-Config and I-Config read by `lt_read_whole_R_config()` and `lt_read_whole_I_config()`.
+ *
+ * The application places it (zeroed) into `lt_handle_t.config_cache`, then `lt_r_config_read()` and
+ * `lt_i_config_read()` take objects from it once the whole space was read. R-Config is invalidated by
+ * `lt_r_config_write()`, `lt_r_config_erase()` and `lt_write_whole_R_config()`, I-Config by `lt_i_config_write()` and
+ * `lt_write_whole_I_config()`, both by `lt_reboot()`, by session establishment or by `lt_config_cache_invalidate()`.
+ */
+typedef struct lt_config_cache_t {
+    /** @private @brief Nonzero when `r` holds R-Config */
+    uint8_t r_valid;
+    /** @private @brief Nonzero when `i` holds I-Config */
+    uint8_t i_valid;
+    /** @private @brief R-Config, indexed as `cfg_desc_table` */
+    lt_config_t r;
+    /** @private @brief I-Config, indexed as `cfg_desc_table` */
+    lt_config_t i;
+} lt_config_cache_t;
+#endif
+
+/** @brief Layout version of `lt_config_snapshot_t`, snapshots of other versions are rejected */
+#define LT_CONFIG_SNAPSHOT_VERSION 1
+
+/** @brief Configuration space held by `lt_config_snapshot_t` */
+typedef enum lt_config_space_t { LT_CONFIG_SPACE_R = 1, LT_CONFIG_SPACE_I = 2 } lt_config_space_t;
+
+/**
+ * @brief Configuration read by `lt_config_snapshot_read()`, which can be cached by the application and compared
+ * with `lt_config_snapshot_diff()`.
+ */
+typedef struct lt_config_snapshot_t {
+    /** @brief LT_CONFIG_SNAPSHOT_VERSION */
+    uint8_t version;
+    /** @brief One of `lt_config_space_t` */
+    uint8_t space;
+    /** @brief CRC16 of the fields above and of `config`, detects a corrupted cached copy */
+    uint16_t crc;
+    /** @brief Configuration objects */
+    lt_config_t config;
+} lt_config_snapshot_t;
+
+/** @brief Size of the fingerprint computed by `lt_config_fingerprint()` */
+#define LT_CONFIG_FINGERPRINT_SIZE 32
+
+/**
+ * @brief Provisioned state of a chip: R-Config, I-Config and the selected pairing key slots, read by
+ * `lt_config_state_read()` or filled from a provisioning package.
+ */
+typedef struct lt_config_state_t {
+    /** @brief R-Config objects */
+    lt_config_t r_config;
+    /** @brief I-Config objects */
+    lt_config_t i_config;
+    /** @brief Bit i is set when pairing key slot i is part of the state, set by the caller */
+    uint8_t pkeys_mask;
+    /** @brief LT_OK when the slot holds `pkeys`, LT_L3_PAIRING_KEY_EMPTY, LT_L3_PAIRING_KEY_INVALID or other error */
+    lt_ret_t pkeys_status[PAIRING_KEY_SLOT_INDEX_3 + 1];
+    /** @brief Pairing keys, valid when their status is LT_OK */
+    uint8_t pkeys[PAIRING_KEY_SLOT_INDEX_3 + 1][32];
+} lt_config_state_t;
+
+/** @brief Fragment of data gathered into a command, e.g. by `lt_ping_v()` */
+typedef struct lt_iovec_t {
+    const uint8_t *base;
+    size_t len;
+} lt_iovec_t;
+
+/** @brief Fragment of buffer which data of a result are scattered into, e.g. by `lt_ping_v()` */
+typedef struct lt_iovec_out_t {
+    uint8_t *base;
+    size_t len;
+} lt_iovec_out_t;
+
+/** @brief Host primitives which can be queried by `lt_crypto_impl()` */
+typedef enum lt_crypto_prim_t {
+    LT_CRYPTO_PRIM_AESGCM = 0,
+    LT_CRYPTO_PRIM_SHA256 = 1,
+    LT_CRYPTO_PRIM_X25519 = 2,
+    LT_CRYPTO_PRIM_ECDSA = 3,
+    LT_CRYPTO_PRIM_ED25519 = 4,
+} lt_crypto_prim_t;
+
+#if LT_PREPARED_KEYS
+/** @brief Size of `lt_ecdsa_prepared_key_t`, sizeof(ecdsa_curve) of trezor_crypto holding the table of the key */
+#define LT_ECDSA_PREPARED_KEY_SIZE 37088
+/** @brief Size of `lt_eddsa_prepared_key_t` */
+#define LT_EDDSA_PREPARED_KEY_SIZE 5152
+
+/**
+ * @brief P-256 public key decoded and validated by `lt_ecc_ecdsa_key_prepare()`, with a table of its multiples
+ * @note Large (37 kB), keep it out of the stack of small threads
+ */
+typedef struct lt_ecdsa_prepared_key_t {
+    uint8_t space[LT_ECDSA_PREPARED_KEY_SIZE] __attribute__((aligned(16)));
+} lt_ecdsa_prepared_key_t;
+
+/** @brief Ed25519 public key decompressed by `lt_ecc_eddsa_key_prepare()`, with a table of its multiples */
+typedef struct lt_eddsa_prepared_key_t {
+    uint8_t space[LT_EDDSA_PREPARED_KEY_SIZE] __attribute__((aligned(16)));
+} lt_eddsa_prepared_key_t;
+#endif
+
 #endif
@@ -0,0 +1,115 @@
+#ifndef LIBTROPIC_ECC_KEY_POOL_H
+#define LIBTROPIC_ECC_KEY_POOL_H
+
+/**
+ * @defgroup libtropic_ecc_key_pool libtropic ECC key pool
+ * @brief ECC key slots with keys generated in advance, so enrollment does not wait for key generation
+ * @details The pool owns a set of ECC slots. `lt_ecc_key_pool_init()` learns their content by
+ * `lt_ecc_key_inventory()`: slots with a generated key of the pool's curve are ready, empty slots wait for a key.
+ * Slots holding any other key are left alone. `lt_ecc_key_pool_refill()`, called in idle time, generates one key per
+ * call until `target` slots are ready. `lt_ecc_key_pool_take()` hands out a ready slot and its public key, which is
+ * only bookkeeping and a lookup in `h->key_cache` with LT_ECC_KEY_CACHE. When no slot is ready, it generates a key
+ * on demand.
+ *
+ * TROPIC01 does not tell ready slots from the taken ones, so the application keeps track of the slots it took and
+ * leaves them out of `slots` of the next `lt_ecc_key_pool_init()`, e.g. after reboot of the host.
+ *
+ * The pool uses only the public libtropic API, it is not protected by any lock.
+ * @{
+ */
+
+/**
+ * @file libtropic_ecc_key_pool.h
+ * @brief ECC key pool declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Statistics of `lt_ecc_key_pool_t` */
+typedef struct lt_ecc_key_pool_stats_t {
+    /** @brief Keys generated by `lt_ecc_key_pool_refill()` */
+    uint32_t refills;
+    /** @brief Slots taken by `lt_ecc_key_pool_take()` */
+    uint32_t takes;
+    /** @brief Takes which found no ready slot and generated the key on demand */
+    uint32_t misses;
+} lt_ecc_key_pool_stats_t;
+
+/** @brief Pool of ECC key slots initialized by `lt_ecc_key_pool_init()` */
+typedef struct lt_ecc_key_pool_t {
+    /** @public @brief Statistics, read only */
+    lt_ecc_key_pool_stats_t stats;
+    /** @private @brief Device's handle */
+    lt_handle_t *h;
+    /** @private @brief Curve of generated keys */
+    lt_ecc_curve_type_t curve;
+    /** @private @brief Number of ready slots kept by refills */
+    uint8_t target;
+    /** @private @brief Bit mask of slots with a generated key, indexed by `ecc_slot_t` */
+    uint32_t ready;
+    /** @private @brief Bit mask of empty slots */
+    uint32_t empty;
+} lt_ecc_key_pool_t;
+
+/**
+ * @brief Initializes the pool, reading content of all ECC slots
+ *
+ * @param pool        Pool
+ * @param h           Device's handle with established secure session
+ * @param slots       Bit mask of slots owned by the pool, indexed by `ecc_slot_t`
+ * @param curve       Curve of keys of the pool
+ * @param target      Number of ready slots kept by `lt_ecc_key_pool_refill()`, 0 fills all slots
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_pool_init(lt_ecc_key_pool_t *pool, lt_handle_t *h, const uint32_t slots,
+                              const lt_ecc_curve_type_t curve, const uint8_t target);
+
+/**
+ * @brief Generates a key in one empty slot, when fewer than `target` slots are ready
+ *
+ * @param pool        Pool initialized by `lt_ecc_key_pool_init()`
+ *
+ * @retval            LT_OK Key was generated
+ * @retval            LT_BUSY Nothing to do, enough slots are ready or no slot is empty
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_pool_refill(lt_ecc_key_pool_t *pool);
+
+/**
+ * @brief Takes a slot with a generated key out of the pool
+ *
+ * @param pool        Pool initialized by `lt_ecc_key_pool_init()`
+ * @param slot        Taken slot, it is no longer owned by the pool
+ * @param key         Public key, 32B for Ed25519 and 64B for P256
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_NOT_FOUND No slot of the pool is ready or empty
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_pool_take(lt_ecc_key_pool_t *pool, ecc_slot_t *slot, uint8_t *key);
+
+/**
+ * @brief Erases a slot taken before and returns it to the pool, e.g. when its user is deleted
+ *
+ * @param pool        Pool initialized by `lt_ecc_key_pool_init()`
+ * @param slot        Slot to be returned
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_ecc_key_pool_release(lt_ecc_key_pool_t *pool, const ecc_slot_t slot);
+
+/** @} */  // end of libtropic_ecc_key_pool group
+
+#endif
@@ -107,6 +107,29 @@ void hexdump_8byte(const uint8_t *data, uint16_t size);
  */
 int chip_id_printf_wrapper(const char *format, ...);
 
+/**
+ * @brief Non-test function returning milliseconds of a monotonic clock, used by benchmarks.
+ * @details The default implementation returns 0, so benchmarks report no time. Platforms with a clock override it.
+ *
+ * @return       Milliseconds since an arbitrary point.
+ */
+uint32_t lt_test_time_ms(void);
+
+/**
+ * @brief Non-test function running one test from the test registry and reporting its duration.
+ * @details Prints `LT_TEST_TIMING name=<test> ms=<elapsed> budget_ms=<budget> transactions=<cnt> result=<ok|overrun>`.
+ * Transactions are L2 requests counted in `h->l2.stats`, "-" without LT_STATS or statistics in the handle. A test
+ * exceeding its budget is reported as a warning, or fails when libtropic is built with LT_TEST_BUDGET_STRICT.
+ *
+ * @param h           Device's handle
+ * @param name        Name of the test
+ * @param test        Test function
+ * @param budget_ms   Time budget of the test in ms, 0 when the test has none
+ *
+ * @return       0 when the test finished within its budget or overruns are only warned about, 1 otherwise.
+ */
+int lt_test_run(lt_handle_t *h, const char *name, void (*test)(lt_handle_t *h), const uint32_t budget_ms);
+
 /**
  * @brief Tests EDDSA_Sign command.
  *
@@ -164,7 +187,7 @@ void lt_test_rev_ecdsa_sign(lt_handle_t *h);
 void lt_test_ire_pairing_key_slots(lt_handle_t *h);
 
 /**
- * @brief Test Ping L3 command with random data of random length <= PING_LEN_MAX.
+ * @brief Test Ping L3 command with random data of random length <= LT_PING_LEN_MAX.
  *
  * Test steps:
  *  1. Start Secure Session with pairing key slot 0.
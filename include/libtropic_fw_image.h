@@ -0,0 +1,135 @@
+#ifndef LIBTROPIC_FW_IMAGE_H
+#define LIBTROPIC_FW_IMAGE_H
+
+/**
+ * @defgroup libtropic_fw_image libtropic firmware image container
+ * @brief Reader of binary firmware update images, optionally compressed
+ * @details The container describes one update image as consumed by the firmware update functions (the signed
+ * bank image on ABAB, the update request followed by length-prefixed data chunks on ACAB), see
+ * `docs/other/fw_image_format.md`. It is created by `TROPIC01_fw_update_files/pack.py`.
+ *
+ * `lt_fw_image_read()` is a `lt_fw_read_cb_t`, so an opened container is passed directly to
+ * `lt_do_mutable_fw_update_stream()` and the other streaming update functions. Compressed payload is decompressed
+ * on the fly, only a window of the last decompressed bytes is kept in RAM. The digest of the image is checked when
+ * its last byte is read, so a corrupted image fails before its last chunk is sent to TROPIC01. Use
+ * `lt_fw_image_verify()` to check the whole image before the update is started.
+ * @{
+ */
+
+/**
+ * @file libtropic_fw_image.h
+ * @brief Firmware image container declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "lt_sha256.h"
+
+/** @brief Size of the container header */
+#define LT_FW_IMAGE_HEADER_SIZE 48u
+
+/** @brief Payload is the image itself */
+#define LT_FW_IMAGE_CODEC_RAW 0u
+/** @brief Payload is LZ4 block with match distance limited by the window of the header */
+#define LT_FW_IMAGE_CODEC_LZ4 1u
+
+/** @brief Largest supported window, as log2 of its size */
+#define LT_FW_IMAGE_WINDOW_LOG_MAX 16u
+
+/**
+ * @brief Firmware image opened by `lt_fw_image_open()`, its content is private.
+ */
+typedef struct lt_fw_image_t {
+    /** @brief Size of the decompressed image, to be passed to the update functions */
+    uint32_t size;
+    /** @private @brief Callback reading the container */
+    lt_fw_read_cb_t src_read;
+    /** @private @brief Argument of `src_read` */
+    void *src_ctx;
+    /** @private @brief Size of the container */
+    uint32_t src_size;
+    /** @private @brief Codec of the payload */
+    uint8_t codec;
+    /** @private @brief Digest of the image from the header */
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    /** @private @brief Window of the last decompressed bytes, power of two bytes */
+    uint8_t *window;
+    /** @private @brief Size of `window` minus one */
+    uint32_t window_mask;
+    /** @private @brief Offset of the next container byte to be read */
+    uint32_t src_pos;
+    /** @private @brief Buffered container bytes */
+    uint8_t in[32];
+    /** @private @brief Number of valid bytes in `in` */
+    uint8_t in_len;
+    /** @private @brief Index of the next byte in `in` */
+    uint8_t in_idx;
+    /** @private @brief Number of image bytes produced (compressed) or hashed (raw) so far */
+    uint32_t pos;
+    /** @private @brief Literals left in the current LZ4 sequence */
+    uint32_t lit_left;
+    /** @private @brief Match bytes left in the current LZ4 sequence */
+    uint32_t match_left;
+    /** @private @brief Distance of the current match */
+    uint16_t match_dist;
+    /** @private @brief Match length code of the current LZ4 sequence */
+    uint8_t match_code;
+    /** @private @brief Nonzero when the current sequence continues by a match */
+    uint8_t match_pending;
+    /** @private @brief Hash of bytes produced so far */
+    struct lt_crypto_sha256_ctx_t sha;
+} lt_fw_image_t;
+
+/**
+ * @brief Opens firmware image container, only its header is read
+ *
+ * @param img          Firmware image
+ * @param read         Callback reading the container (e.g. from a file or external flash)
+ * @param ctx          Argument of `read`
+ * @param src_size     Size of the container
+ * @param window       Buffer for the decompression window, at least the window size of the container, it must stay
+ *                     valid while the image is read. May be NULL for an uncompressed container.
+ * @param window_size  Size of `window`, power of two
+ *
+ * @retval             LT_OK Function executed successfully
+ * @retval             LT_PARAM_ERR Invalid parameter, or the window is smaller than the container needs
+ * @retval             LT_FAIL Data are not a supported container
+ * @retval             other Error returned by `read`
+ */
+lt_ret_t lt_fw_image_open(lt_fw_image_t *img, lt_fw_read_cb_t read, void *ctx, const uint32_t src_size,
+                          uint8_t *window, const uint32_t window_size);
+
+/**
+ * @brief Reads bytes of the decompressed image, `lt_fw_read_cb_t` for the update functions
+ * @details Bytes are expected to be read in increasing order, as the update functions do. Reading an earlier offset
+ * of a compressed image decompresses it again from its beginning.
+ *
+ * @param ctx          Firmware image opened by `lt_fw_image_open()`
+ * @param offset       Offset in the image
+ * @param buff         Buffer for the bytes
+ * @param len          Number of bytes
+ *
+ * @retval             LT_OK Function executed successfully
+ * @retval             LT_PARAM_ERR Bytes are out of the image
+ * @retval             LT_FAIL Payload is corrupted, or the digest of the image does not match
+ * @retval             other Error returned by the container `read` callback
+ */
+lt_ret_t lt_fw_image_read(void *ctx, const uint32_t offset, uint8_t *buff, const uint16_t len);
+
+/**
+ * @brief Decompresses the whole image and checks its digest, no data are sent to TROPIC01
+ *
+ * @param img          Firmware image opened by `lt_fw_image_open()`
+ *
+ * @retval             LT_OK Image is valid
+ * @retval             other See `lt_fw_image_read()`
+ */
+lt_ret_t lt_fw_image_verify(lt_fw_image_t *img);
+
+/** @} */  // end of libtropic_fw_image group
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef LIBTROPIC_FW_PREFLIGHT_H
+#define LIBTROPIC_FW_PREFLIGHT_H
+
+/**
+ * @defgroup libtropic_fw_preflight libtropic firmware update pre-flight check
+ * @brief Check of a firmware update image on the host, before any bank is erased
+ * @details `lt_fw_preflight()` reads the update image chunk by chunk exactly as the update functions send it and
+ * checks it without communicating with TROPIC01, so a corrupted, truncated or wrong image fails before
+ * `lt_do_mutable_fw_update()` erases the bank instead of after a part of it was written:
+ *  - **ABAB**: the image is at most LT_MUTABLE_FW_UPDATE_SIZE_MAX bytes, sent in chunks of 128 B.
+ *  - **ACAB**: the update request has its length, each chunk behind it (length byte, SHA256 of the next chunk,
+ *    offset in the bank, data) has data of at most 220 B in multiples of 4 B and ends within the image. The hash in
+ *    the request and in each chunk must be SHA256 of the next chunk (its bytes behind the length byte), the hash in
+ *    the last chunk is zero. This is the chain checked by TROPIC01 while the chunks are written.
+ *
+ * Chunks are hashed by `lt_sha256_multi()`, in parallel lanes when libtropic is built with LT_SHA256_MULTI. The
+ * digest of the image is SHA256 over SHA256 of each chunk (on ACAB the update request first, each of them without its
+ * length byte), so it is computed from the same hashes.
+ *
+ * A manifest of LT_FW_MANIFEST_SIZE bytes, created for the image by `TROPIC01_fw_update_files/manifest.py`, holds the
+ * size, number of chunks and the digest of the image signed by an Ed25519 key of the application's vendor. When
+ * passed to `lt_fw_preflight()`, the image must match it. All numbers of the manifest are little endian:
+ *
+ * | Offset | Size | Field                                             |
+ * |--------|------|---------------------------------------------------|
+ * | 0      | 4    | `LTFM`                                            |
+ * | 4      | 1    | Version of the manifest, currently 1              |
+ * | 5      | 3    | Zero                                              |
+ * | 8      | 4    | Size of the image                                 |
+ * | 12     | 4    | Number of chunks, on ACAB without update request  |
+ * | 16     | 32   | Digest of the image                               |
+ * | 48     | 64   | Ed25519 signature of the previous 48 bytes        |
+ *
+ * Offsets of the chunks collected by the check let `lt_fw_preflight_resume()` prepare `lt_fw_update_t` of
+ * `lt_do_mutable_fw_update_resume()` for any chunk, without reading the image again.
+ * @{
+ */
+
+/**
+ * @file libtropic_fw_preflight.h
+ * @brief Firmware update pre-flight check declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Size of the signed part of the manifest */
+#define LT_FW_MANIFEST_MSG_SIZE 48u
+/** @brief Size of the manifest */
+#define LT_FW_MANIFEST_SIZE (LT_FW_MANIFEST_MSG_SIZE + 64u)
+
+/** @brief Result of `lt_fw_preflight()` */
+typedef struct lt_fw_preflight_t {
+    /** @public @brief Buffer for offsets of chunks in the image, NULL when they are not needed */
+    uint32_t *offsets;
+    /** @public @brief Number of entries of `offsets`, at least the number of chunks */
+    uint32_t offsets_max;
+    /** @public @brief Size of the image, read-only */
+    uint32_t size;
+    /** @public @brief Number of chunks sent by the update functions, on ACAB without update request, read-only */
+    uint32_t chunks;
+    /** @public @brief Digest of the image, read-only */
+    uint8_t digest[32];
+} lt_fw_preflight_t;
+
+/**
+ * @brief Reads the whole update image and checks it, no data are sent to TROPIC01
+ *
+ * @param pf           Result, `offsets` and `offsets_max` are set by the caller
+ * @param read         Callback reading the update image, e.g. `lt_fw_image_read()`
+ * @param ctx          Argument of `read`
+ * @param size         Size of the update image
+ * @param manifest     Manifest of the image, LT_FW_MANIFEST_SIZE bytes, NULL to check only the image itself
+ * @param pubkey       Ed25519 public key of the manifest's signer (32 B), NULL when `manifest` is NULL
+ *
+ * @retval             LT_OK Image is valid and matches the manifest
+ * @retval             LT_PARAM_ERR Invalid parameter, or `offsets` has fewer entries than the image has chunks
+ * @retval             LT_FAIL Image is malformed, or the manifest is not valid or does not match the image
+ * @retval             other Error returned by `read`
+ */
+lt_ret_t lt_fw_preflight(lt_fw_preflight_t *pf, lt_fw_read_cb_t read, void *ctx, const uint32_t size,
+                         const uint8_t *manifest, const uint8_t *pubkey);
+
+/**
+ * @brief Prepares state of resumable update starting from the chunk `chunk` of the checked image
+ *
+ * @param pf           Result of `lt_fw_preflight()` with offsets of the chunks
+ * @param chunk        Index of the first chunk to be sent, `pf->chunks` when all chunks were acknowledged
+ * @param u            Update state, its `cursor` and `chunks` are set, the other members are left to the caller
+ *
+ * @retval             LT_OK Function executed successfully
+ * @retval             LT_PARAM_ERR Invalid parameter, offsets were not collected or `chunk` is out of the image
+ */
+lt_ret_t lt_fw_preflight_resume(const lt_fw_preflight_t *pf, const uint32_t chunk, lt_fw_update_t *u);
+
+/** @} */  // end of libtropic_fw_preflight group
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef LIBTROPIC_JOB_ARENA_H
+#define LIBTROPIC_JOB_ARENA_H
+
+/**
+ * @defgroup libtropic_job_arena libtropic job arena
+ * @brief Fixed number of job descriptors shared by submission paths, taken and returned without locks or malloc
+ * @details The application gives the arena an array of `lt_job_slot_t`, e.g. a static one, so its size is fixed
+ * at `lt_job_arena_init()`. `lt_job_alloc()` takes a zeroed job from the free list and `lt_job_free()` returns it,
+ * both in constant time by a compare-and-swap, so they may be called from several threads and from interrupts at
+ * once. One job serves as `lt_async_op_t` of `lt_submit()`, as `lt_pool_job_t` of `lt_pool_submit_prio()` or as
+ * a request of the application, and it is returned from the completion callback. When all jobs are taken,
+ * `lt_job_alloc()` returns NULL at once, so the submission path never waits and never allocates.
+ *
+ * Each slot takes whole cache lines of `LT_JOB_ARENA_ALIGN` bytes, so jobs completed by one thread and submitted by
+ * another do not share cache lines. The free list needs 32-bit atomic compare-and-swap, on cores without it the
+ * compiler calls libatomic.
+ * @{
+ */
+
+/**
+ * @file libtropic_job_arena.h
+ * @brief Job arena declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+/** @brief Size of cache line, to which slots of the arena are aligned, if not set */
+#ifndef LT_JOB_ARENA_ALIGN
+#define LT_JOB_ARENA_ALIGN 64
+#endif
+
+/** @brief Size of `lt_job_t.user`, job descriptors of the application, if not set */
+#ifndef LT_JOB_USER_SIZE
+#define LT_JOB_USER_SIZE 64
+#endif
+
+/** @brief Maximal number of slots of one arena */
+#define LT_JOB_ARENA_MAX 0xfffe
+
+/** @brief Job of any submission path, taken by `lt_job_alloc()` */
+typedef union lt_job_t {
+#if LT_ASYNC
+    /** @brief Operation for `lt_submit()` */
+    lt_async_op_t async;
+#endif
+#if LT_DEVICE_POOL
+    /** @brief Job for `lt_pool_submit_prio()` */
+    lt_pool_job_t pool;
+#endif
+    /** @brief Descriptor of the application, e.g. a request of a daemon with its buffers and result */
+    uint8_t user[LT_JOB_USER_SIZE];
+} lt_job_t;
+
+/** @brief Slot of the arena, the application supplies an array of them to `lt_job_arena_init()` */
+typedef struct lt_job_slot_t {
+    /** @public @brief Job, the slot's address is the job's one */
+    lt_job_t job;
+    /** @private @brief Index of the next free slot plus one, 0 at the end of the free list */
+    uint16_t next;
+} __attribute__((aligned(LT_JOB_ARENA_ALIGN))) lt_job_slot_t;
+
+/** @brief Statistics of `lt_job_arena_t`, see `lt_job_arena_stats_get()` */
+typedef struct lt_job_arena_stats_t {
+    /** @brief Number of jobs taken by `lt_job_alloc()` */
+    uint32_t allocs;
+    /** @brief Number of `lt_job_alloc()` calls which found no free job */
+    uint32_t exhausted;
+    /** @brief Jobs taken now */
+    uint16_t in_use;
+    /** @brief Most jobs taken at once */
+    uint16_t in_use_max;
+} lt_job_arena_stats_t;
+
+/** @brief Arena of jobs initialized by `lt_job_arena_init()` */
+typedef struct lt_job_arena_t {
+    /** @private @brief Slots of the arena */
+    lt_job_slot_t *slots;
+    /** @private @brief Number of slots */
+    uint16_t cnt;
+    /**
+     * @private @brief First free slot plus one in the lower half, number of changes of the free list in the upper
+     * half, so a slot taken and returned meanwhile does not fool the compare-and-swap. On its own cache line.
+     */
+    uint32_t head __attribute__((aligned(LT_JOB_ARENA_ALIGN)));
+    /** @private @brief Statistics, updated atomically, on their own cache line */
+    lt_job_arena_stats_t stats __attribute__((aligned(LT_JOB_ARENA_ALIGN)));
+} lt_job_arena_t;
+
+/**
+ * @brief Initializes the arena with all jobs free
+ * @note Must not be called while the arena is used.
+ *
+ * @param arena       Arena
+ * @param slots       Slots, must stay valid while the arena is used
+ * @param cnt         Number of slots, 1 to `LT_JOB_ARENA_MAX`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_job_arena_init(lt_job_arena_t *arena, lt_job_slot_t *slots, const uint32_t cnt);
+
+/**
+ * @brief Takes a free job from the arena, never waits
+ *
+ * @param arena       Arena initialized by `lt_job_arena_init()`
+ *
+ * @return            Zeroed job, NULL when all jobs are taken or `arena` is NULL
+ */
+lt_job_t *lt_job_alloc(lt_job_arena_t *arena);
+
+/**
+ * @brief Returns a job taken by `lt_job_alloc()` to the arena, e.g. from the completion callback of the job
+ *
+ * @param arena       Arena the job was taken from
+ * @param job         Job, `lt_async_op_t` or `lt_pool_job_t` of it may be passed cast to `lt_job_t`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter, e.g. the job is not a slot of the arena
+ */
+lt_ret_t lt_job_free(lt_job_arena_t *arena, lt_job_t *job);
+
+/**
+ * @brief Reads statistics of the arena
+ *
+ * @param arena       Arena
+ * @param stats       Statistics
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_job_arena_stats_get(lt_job_arena_t *arena, lt_job_arena_stats_t *stats);
+
+/** @} */  // end of libtropic_job_arena group
+
+#endif
@@ -45,7 +45,8 @@ lt_ret_t lt_l2_resend_response(lt_l2_state_t *s2);
 /**
  * @brief Receives L2 response.
  *
- * After successful execution, handle's `l2_buff` will contain response.
+ * After successful execution, handle's `l2_buff` will contain response. Response with CRC or GEN error is
+ * requested again up to 3 times, with LT_L2_RETRY_POLICY according to the policy in `s2->retry`.
  * @note Structures defined in lt_l2_api_structs.h migh help with decoding.
  *
  * @param s2          Structure holding l2 state
@@ -55,6 +56,21 @@ lt_ret_t lt_l2_resend_response(lt_l2_state_t *s2);
  */
 lt_ret_t lt_l2_receive(lt_l2_state_t *s2);
 
+/**
+ * @brief Receives L2 response like `lt_l2_receive()`, its data end up in `rx` instead of handle's `l2_buff`.
+ *
+ * With LT_USE_SPI_TRANSFER_BUF the data are received straight into `rx`, otherwise they are copied there. Response
+ * with more than `rx_max` bytes of data is left whole in `l2_buff`, STATUS and length bytes are there always.
+ *
+ * @param s2          Structure holding l2 state
+ * @param rx          Buffer for data of the response, NULL for `l2_buff`
+ * @param rx_max      Size of `rx`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_l2_receive_to(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max);
+
 /**
  * @brief Sends content of encrypted L3 command's buffer over Layer 2.
  *
@@ -70,6 +86,14 @@ lt_ret_t lt_l2_receive(lt_l2_state_t *s2);
  */
 lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len);
 
+/**
+ * @brief Returns number of times a single chunk of encrypted L3 packet is transferred again, before the packet fails
+ *
+ * @param s2          Structure holding l2 state
+ * @return            `max_resends` of the retry policy with LT_L2_RETRY_POLICY, 3 otherwise
+ */
+uint8_t lt_l2_chunk_retries(const lt_l2_state_t *s2);
+
 /**
  * @brief Receives encrypted L3 response over Layer 2.
  *
@@ -85,6 +109,149 @@ lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max
  */
 lt_ret_t lt_l2_recv_encrypted_res(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len);
 
+/**
+ * @brief Receives encrypted L3 response over Layer 2, same as `lt_l2_recv_encrypted_res()`, and tells how many bytes
+ * were written into the buffer.
+ *
+ * @param s2          Structure holding l2 state
+ * @param buff        Buffer where encrypted l3 result will be stored
+ * @param max_len     Maximal length of buff. Whole buffer might be used, or just its part.
+ * @param len         Number of bytes written into buff, set also when the function fails
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_l2_recv_encrypted_res_len(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len, uint16_t *len);
+
+/**
+ * @brief Called for each chunk of encrypted L3 result received by `lt_l2_recv_encrypted_res_cb()`
+ *
+ * @param ctx         Context passed to `lt_l2_recv_encrypted_res_cb()`
+ * @param chunk       Chunk of L3 result placed in L2 buffer, valid only until the callback returns
+ * @param len         Length of the chunk
+ *
+ * @retval            LT_OK Chunk was processed and receiving continues
+ * @retval            other Receiving is stopped and this value is returned
+ */
+typedef lt_ret_t (*lt_l2_chunk_cb_t)(void *ctx, uint8_t *chunk, uint16_t len);
+
+/**
+ * @brief Receives encrypted L3 response over Layer 2 and passes it chunk by chunk to a callback.
+ *
+ * Unlike `lt_l2_recv_encrypted_res()` the response is not assembled in any buffer, so the callback can
+ * process each chunk (e.g. decrypt it) while the next one is not yet available.
+ * @note Use only after secure session was established with `lt_session_start()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param cb          Callback processing the chunks
+ * @param ctx         Context passed to the callback
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_l2_recv_encrypted_res_cb(lt_l2_state_t *s2, lt_l2_chunk_cb_t cb, void *ctx);
+
+#if LT_NONBLOCKING
+/** @brief State of non-blocking L2 transfer */
+typedef enum lt_l2_transfer_state_t {
+    /** @brief No transfer in progress */
+    LT_L2_TRANSFER_IDLE = 0,
+    /** @brief Waiting for a response on plain L2 request */
+    LT_L2_TRANSFER_RSP,
+    /** @brief Waiting for a response on Resend_Req */
+    LT_L2_TRANSFER_RESEND,
+    /** @brief Waiting for a response on a chunk of encrypted L3 command */
+    LT_L2_TRANSFER_CMD,
+    /** @brief Waiting for a chunk of encrypted L3 result */
+    LT_L2_TRANSFER_RES
+} lt_l2_transfer_state_t;
+
+/** @brief Non-blocking L2 transfer, its content is private and is kept by the caller between polls */
+typedef struct lt_l2_transfer_t {
+    /** @private @brief Current state */
+    lt_l2_transfer_state_t state;
+    /** @private @brief L3 buffer, NULL for plain L2 request */
+    uint8_t *buff;
+    /** @private @brief Maximal length of L3 buffer */
+    uint16_t max_len;
+    /** @private @brief Buffer L3 result is received into */
+    uint8_t *res_buff;
+    /** @private @brief Maximal length of result buffer */
+    uint16_t res_max_len;
+    /** @private @brief Length of encrypted L3 command */
+    uint16_t packet_size;
+    /** @private @brief Position in L3 buffer */
+    uint16_t offset;
+    /** @private @brief Number of received chunks of L3 result */
+    uint16_t loops;
+    /** @private @brief Number of sent Resend_Req */
+    uint8_t resends;
+    /** @private @brief Polling of the awaited response */
+    lt_l1_poll_sched_t sched;
+} lt_l2_transfer_t;
+
+/**
+ * @brief Starts non-blocking L2 transfer, either of plain L2 request or of encrypted L3 command.
+ *
+ * The request is sent and the function returns without waiting for a response. Then `lt_l2_transfer_poll()`
+ * is called after `wait_ms` again and again until it returns other value than LT_PENDING. Handle must not be
+ * used for anything else during the transfer.
+ *
+ * When `buff` is NULL, plain L2 request placed in handle's L2 buffer is sent (as with `lt_l2_send()`) and the
+ * response is received into L2 buffer (as with `lt_l2_receive()`). Otherwise `buff` contains encrypted L3
+ * command which is sent (as with `lt_l2_send_encrypted_cmd()`) and its result is received into the same
+ * buffer (as with `lt_l2_recv_encrypted_res()`).
+ *
+ * @note Time to wait is relative to the return of the function, libtropic does not read any clock. When
+ * LT_USE_INT_PIN is used, the transfer can be polled also earlier, when INT pin is asserted.
+ *
+ * @param s2          Structure holding l2 state
+ * @param t           Transfer state, kept by the caller until the transfer is finished
+ * @param buff        Buffer containing encrypted l3 command, or NULL for plain L2 request
+ * @param max_len     Maximal length of buff. Whole buffer might be used, or just its part.
+ * @param wait_ms     Time to wait before the first `lt_l2_transfer_poll()`
+ *
+ * @retval            LT_PENDING Request was sent, poll the transfer after `wait_ms`
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_l2_transfer_begin(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint8_t *buff, uint16_t max_len,
+                              uint32_t *wait_ms);
+
+/**
+ * @brief Starts non-blocking L2 transfer of encrypted L3 command, as `lt_l2_transfer_begin()` does, but the result is
+ * received into `res_buff`.
+ *
+ * `buff` is not touched after the command is sent, so the next command can be prepared in it while the transfer is
+ * polled.
+ *
+ * @param s2          Structure holding l2 state
+ * @param t           Transfer state, kept by the caller until the transfer is finished
+ * @param buff        Buffer containing encrypted l3 command
+ * @param max_len     Maximal length of buff
+ * @param res_buff    Buffer for encrypted l3 result
+ * @param res_max_len Maximal length of res_buff
+ * @param wait_ms     Time to wait before the first `lt_l2_transfer_poll()`
+ *
+ * @retval            LT_PENDING Command was sent, poll the transfer after `wait_ms`
+ * @retval            other Function did not execute successully
+ */
+lt_ret_t lt_l2_transfer_begin_split(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint8_t *buff, uint16_t max_len,
+                                    uint8_t *res_buff, uint16_t res_max_len, uint32_t *wait_ms);
+
+/**
+ * @brief Makes one step of non-blocking L2 transfer started by `lt_l2_transfer_begin()`, never waits.
+ *
+ * @param s2          Structure holding l2 state
+ * @param t           Transfer state
+ * @param wait_ms     Time to wait before the next `lt_l2_transfer_poll()`, valid for LT_PENDING
+ *
+ * @retval            LT_OK Transfer is finished, response is in L2 buffer or result in L3 buffer
+ * @retval            LT_PENDING Transfer is not finished, poll it again after `wait_ms`
+ * @retval            other Transfer failed and is finished
+ */
+lt_ret_t lt_l2_transfer_poll(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint32_t *wait_ms);
+#endif
+
 /** @} */  // end of group_l2_functions
 
 #endif  // LIBTROPIC_L2_H
@@ -61,6 +61,50 @@ lt_ret_t lt_out__session_start(lt_handle_t *h, const pkey_index_t pkey_index, se
 lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index,
                               const uint8_t *shipriv, const uint8_t *shipub, session_state_t *state);
 
+/**
+ * @brief Calculates the part of handshake hash which does not depend on ephemeral keys.
+ *
+ * @param shipub      Secure host public key
+ * @param stpub       STPUB from device's certificate
+ * @param hash        Buffer for the hash (32B)
+ */
+void lt_session_hash_prefix(const uint8_t *shipub, const uint8_t *stpub, uint8_t *hash);
+
+/**
+ * @brief Same as `lt_in__session_start()`, but uses handshake inputs prepared by `lt_session_ctx_init()`.
+ *
+ * @param h           Device's handle
+ * @param ctx         Handshake context
+ * @param state       Content must be filled with lt_out__session_start and is used to finish secure session
+ * establishment.
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__session_start_ctx(lt_handle_t *h, const lt_session_ctx_t *ctx, session_state_t *state);
+
+/**
+ * @brief Computes parts of the handshake which do not depend on TROPIC01's response: the handshake hash up to
+ * PKEY_INDEX and X25519(EHPRIV, STPUB).
+ *
+ * Meant to be called between `lt_l2_send()` and `lt_l2_receive()`, so it runs while TROPIC01 processes the handshake
+ * request. `lt_in__session_start_ctx()` then uses the results stored in state.
+ *
+ * @param ctx         Handshake context, the same one as passed to `lt_in__session_start_ctx()`
+ * @param state       Content must be filled with lt_out__session_start
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_session_start_precompute(const lt_session_ctx_t *ctx, session_state_t *state);
+
+/**
+ * @brief Sends L3 command encoded by one of `lt_out__*()` functions and receives its result for `lt_in__*()`.
+ * @note No host cryptography is done here (except with LT_L3_STREAM_DECRYPT, where the result is decrypted while
+ * being received), so it can be executed by another thread than the encoding and decoding, see
+ * libtropic_port_unix_io.h.
+ *
+ * @param h           Device's handle
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l3_transfer(lt_handle_t *h);
+
 /**
  * @brief Encodes Ping command payload.
  * @note Used for separate L3 communication, for more information read info at the top
@@ -73,6 +117,18 @@ lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_i
  */
 lt_ret_t lt_out__ping(lt_handle_t *h, const uint8_t *msg_out, const uint16_t len);
 
+/**
+ * @brief Encodes Ping command payload gathered from fragments, see lt_out__ping().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param iov         Fragments of the ping message, copied one after another into the L3 buffer
+ * @param iov_cnt     Number of fragments
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_out__ping_v(lt_handle_t *h, const lt_iovec_t *iov, const uint8_t iov_cnt);
+
 /**
  * @brief Decodes Ping result payload.
  * @note Used for separate L3 communication, for more information read info at the top
@@ -85,6 +141,33 @@ lt_ret_t lt_out__ping(lt_handle_t *h, const uint8_t *msg_out, const uint16_t len
  */
 lt_ret_t lt_in__ping(lt_handle_t *h, uint8_t *msg_in, const uint16_t len);
 
+/**
+ * @brief Decodes Ping result payload scattered into fragments, see lt_in__ping().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param iov         Fragments to receive the ping message, their total length is the expected length
+ * @param iov_cnt     Number of fragments
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__ping_v(lt_handle_t *h, const lt_iovec_out_t *iov, const uint8_t iov_cnt);
+
+#if LT_L3_VIEWS
+/**
+ * @brief Decodes Ping result payload without copying the message out of the L3 buffer, see lt_in__ping().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file. The view points into the decrypted L3 buffer of the handle and is valid only until the
+ * next command is encoded on the handle (or the buffer is released, see `lt_l3_buff_release()`).
+ *
+ * @param h           Device's handle
+ * @param msg_in      Set to the received ping message, NULL on error
+ * @param len         Expected length of received message, the same as sent in lt_out__ping()
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__ping_view(lt_handle_t *h, const uint8_t **msg_in, const uint16_t len);
+#endif
+
 /**
  * @brief Encodes Pairing_Key_Write command payload.
  * @note Used for separate L3 communication, for more information read
@@ -257,6 +340,7 @@ lt_ret_t lt_out__i_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_
  */
 lt_ret_t lt_in__i_config_read(lt_handle_t *h, uint32_t *obj);
 
+#if LT_ENABLE_R_MEM
 /**
  * @brief Encodes R_Mem_Data_Write command payload.
  * @note Used for separate L3 communication, for more information read info
@@ -271,6 +355,20 @@ lt_ret_t lt_in__i_config_read(lt_handle_t *h, uint32_t *obj);
  */
 lt_ret_t lt_out__r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size);
 
+/**
+ * @brief Encodes R_Mem_Data_Write command payload gathered from fragments, see lt_out__r_mem_data_write().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param udata_slot  Memory's slot to be written
+ * @param iov         Fragments of data to be written, their total length is the size of the data
+ * @param iov_cnt     Number of fragments
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_out__r_mem_data_write_v(lt_handle_t *h, const uint16_t udata_slot, const lt_iovec_t *iov,
+                                    const uint8_t iov_cnt);
+
 /**
  * @brief Decodes R_Mem_Data_Write result payload.
  * @note Used for separate L3 communication, for more information read info
@@ -304,6 +402,35 @@ lt_ret_t lt_out__r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot);
  */
 lt_ret_t lt_in__r_mem_data_read(lt_handle_t *h, uint8_t *data, uint16_t *size);
 
+/**
+ * @brief Decodes R_Mem_Data_Read result payload scattered into fragments, see lt_in__r_mem_data_read().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param iov         Fragments to receive data, filled one after another
+ * @param iov_cnt     Number of fragments
+ * @param size        Number of bytes read, set also when fragments are too short (then LT_PARAM_ERR is returned)
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__r_mem_data_read_v(lt_handle_t *h, const lt_iovec_out_t *iov, const uint8_t iov_cnt, uint16_t *size);
+
+#if LT_L3_VIEWS
+/**
+ * @brief Decodes R_Mem_Data_Read result payload without copying data out of the L3 buffer, see
+ * lt_in__r_mem_data_read().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file. The view points into the decrypted L3 buffer of the handle and is valid only until the
+ * next command is encoded on the handle (or the buffer is released, see `lt_l3_buff_release()`).
+ *
+ * @param h           Device's handle
+ * @param data        Set to the read data, NULL on error
+ * @param size        Number of bytes read
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__r_mem_data_read_view(lt_handle_t *h, const uint8_t **data, uint16_t *size);
+#endif
+
 /**
  * @brief Encodes R_Mem_Data_Erase command payload.
  * @note Used for separate L3 communication, for more information read info
@@ -324,6 +451,7 @@ lt_ret_t lt_out__r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot);
  * @return            LT_OK if success, otherwise returns other error code.
  */
 lt_ret_t lt_in__r_mem_data_erase(lt_handle_t *h);
+#endif
 
 /**
  * @brief Encodes Random_Value_Get command payload.
@@ -348,6 +476,22 @@ lt_ret_t lt_out__random_value_get(lt_handle_t *h, const uint16_t len);
  */
 lt_ret_t lt_in__random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len);
 
+#if LT_L3_VIEWS
+/**
+ * @brief Decodes Random_Value_Get result payload without copying random bytes out of the L3 buffer, see
+ * lt_in__random_value_get().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file. The view points into the decrypted L3 buffer of the handle and is valid only until the
+ * next command is encoded on the handle (or the buffer is released, see `lt_l3_buff_release()`).
+ *
+ * @param h           Device's handle
+ * @param buff        Set to the random bytes, NULL on error
+ * @param len         Number of random bytes, the same as sent in lt_out__random_value_get()
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__random_value_get_view(lt_handle_t *h, const uint8_t **buff, const uint16_t len);
+#endif
+
 /**
  * @brief Encodes ECC_Key_Generate command payload.
  * @note Used for separate L3 communication, for more information read
@@ -453,6 +597,31 @@ lt_ret_t lt_in__ecc_key_erase(lt_handle_t *h);
  */
 lt_ret_t lt_out__ecc_ecdsa_sign(lt_handle_t *h, const ecc_slot_t slot, const uint8_t *msg, const uint32_t msg_len);
 
+/**
+ * @brief Encodes ECDSA_Sign command payload of a message in fragments, see lt_out__ecc_ecdsa_sign().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param slot        ECC key slot to use for signing
+ * @param iov         Fragments of the message, hashed one after another
+ * @param iov_cnt     Number of fragments
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_out__ecc_ecdsa_sign_v(lt_handle_t *h, const ecc_slot_t slot, const lt_iovec_t *iov, const uint8_t iov_cnt);
+
+/**
+ * @brief Encodes ECDSA_Sign command payload with a message hash computed by the caller.
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param slot        ECC key slot to use for signing
+ * @param msg_hash    SHA256 hash of the message to sign (32B)
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_out__ecc_ecdsa_sign_digest(lt_handle_t *h, const ecc_slot_t slot, const uint8_t *msg_hash);
+
 /**
  * @brief Decodes ECDSA_Sign result payload.
  * @note Used for separate L3 communication, for more information read info at
@@ -477,6 +646,20 @@ lt_ret_t lt_in__ecc_ecdsa_sign(lt_handle_t *h, uint8_t *rs);
  */
 lt_ret_t lt_out__ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint16_t msg_len);
 
+/**
+ * @brief Encodes EDDSA_Sign command payload gathered from fragments, see lt_out__ecc_eddsa_sign().
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    ECC key slot to use for signing
+ * @param iov         Fragments of the message, copied one after another into the L3 buffer
+ * @param iov_cnt     Number of fragments
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_out__ecc_eddsa_sign_v(lt_handle_t *h, const ecc_slot_t ecc_slot, const lt_iovec_t *iov,
+                                  const uint8_t iov_cnt);
+
 /**
  * @brief Decodes EDDSA_Sign result payload.
  * @note Used for separate L3 communication, for more information read info at
@@ -488,6 +671,7 @@ lt_ret_t lt_out__ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const
  */
 lt_ret_t lt_in__ecc_eddsa_sign(lt_handle_t *h, uint8_t *rs);
 
+#if LT_ENABLE_MCOUNTER
 /**
  * @brief Encodes MCounter_Init command payload.
  * @note Used for separate L3 communication, for more information read info at
@@ -556,6 +740,7 @@ lt_ret_t lt_out__mcounter_get(lt_handle_t *h, const enum lt_mcounter_index_t mco
  * @return            LT_OK if success, otherwise returns other error code.
  */
 lt_ret_t lt_in__mcounter_get(lt_handle_t *h, uint32_t *mcounter_value);
+#endif
 
 /**
  * @brief Encodes MAC_And_Destroy command payload.
@@ -580,6 +765,33 @@ lt_ret_t lt_out__mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, co
  */
 lt_ret_t lt_in__mac_and_destroy(lt_handle_t *h, uint8_t *data_in);
 
+#if LT_RAW_CMD
+/**
+ * @brief Encodes L3 command given as plaintext bytes.
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param cmd         Command ID followed by the command's data
+ * @param cmd_len     Length of `cmd`, at most L3_CYPHERTEXT_MAX_SIZE
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_out__raw_cmd(lt_handle_t *h, const uint8_t *cmd, const uint16_t cmd_len);
+
+/**
+ * @brief Decodes L3 result into plaintext bytes.
+ * @note Used for separate L3 communication, for more information read info
+ * at the top of this file.
+ *
+ * @param h           Device's handle
+ * @param res         Buffer to receive RESULT byte followed by the result's data, filled only on LT_OK
+ * @param res_max_len Size of `res`
+ * @param res_len     Length of the received result
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_in__raw_cmd(lt_handle_t *h, uint8_t *res, const uint16_t res_max_len, uint16_t *res_len);
+#endif
+
 /** @} */  // end of group_libtropic_l3
 
 #endif  // LIBTROPIC_L3_H
\ No newline at end of file
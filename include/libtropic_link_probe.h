@@ -0,0 +1,124 @@
+#ifndef LIBTROPIC_LINK_PROBE_H
+#define LIBTROPIC_LINK_PROBE_H
+
+/**
+ * @defgroup libtropic_link_probe libtropic link probe
+ * @brief Measurement of latency and throughput of the link to TROPIC01, e.g. when a new board is brought up
+ * @details `lt_link_probe()` measures round trips of plain L2 GET_INFO requests (chip ID), which need no secure
+ * session, and Ping commands of several sizes in the secure session, which carry data in both directions. CRC errors
+ * are counted with LT_L2_RETRY_POLICY or with `h->l2.stats` (LT_STATS), otherwise they stay zero.
+ *
+ * With LT_ADAPTIVE_POLLING, CHIP_STATUS is polled every LT_LINK_PROBE_POLL_US during the probe (rounded up to whole
+ * miliseconds without LT_USE_DELAY_US), so the time waited for the responses is known precisely. Polling profiles
+ * derived from it are returned in `lt_link_probe_result_t.profiles`, which can be given to `h->l2.poll.profiles`.
+ * Polling configuration and statistics of the handle are restored afterwards.
+ *
+ * The probe uses only the public libtropic API, the handle is locked for its whole duration with LT_THREAD_SAFE.
+ * @{
+ */
+
+/**
+ * @file libtropic_link_probe.h
+ * @brief Link probe declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Maximal number of GET_INFO round trips whose latency distribution is evaluated */
+#ifndef LT_LINK_PROBE_SAMPLES_MAX
+#define LT_LINK_PROBE_SAMPLES_MAX 64
+#endif
+/** @brief Number of Ping sizes, 16 B multiplied by 4 for each next one, the last one is clipped to the buffer */
+#define LT_LINK_PROBE_SIZES 5
+/** @brief Gap between polls of CHIP_STATUS during the probe in us, with LT_ADAPTIVE_POLLING */
+#ifndef LT_LINK_PROBE_POLL_US
+#define LT_LINK_PROBE_POLL_US 20
+#endif
+#if LT_ADAPTIVE_POLLING
+/** @brief Number of profiles in `lt_link_probe_result_t.profiles`: GET_INFO, Ping and chunk of L3 command */
+#define LT_LINK_PROBE_PROFILES 3
+#endif
+
+/** @brief Configuration of `lt_link_probe()` */
+typedef struct lt_link_probe_cfg_t {
+    /** @brief Monotonic clock in us, mandatory */
+    uint32_t (*time_us)(void);
+    /** @brief Number of GET_INFO round trips, at most LT_LINK_PROBE_SAMPLES_MAX, 0 skips latency */
+    uint16_t rounds;
+    /** @brief Number of Pings of each size, 0 skips throughput */
+    uint16_t ping_rounds;
+    /** @brief Buffer for Ping messages, it is sent and received in place, not needed without `ping_rounds` */
+    uint8_t *buff;
+    /** @brief Size of `buff`, it limits the longest Ping (at most LT_PING_LEN_MAX) */
+    uint16_t buff_len;
+} lt_link_probe_cfg_t;
+
+/** @brief Distribution of latency of GET_INFO round trips in us */
+typedef struct lt_link_probe_latency_t {
+    /** @brief Number of successful round trips */
+    uint16_t cnt;
+    /** @brief Shortest round trip */
+    uint32_t min_us;
+    /** @brief Median */
+    uint32_t median_us;
+    /** @brief 90th percentile */
+    uint32_t p90_us;
+    /** @brief Longest round trip */
+    uint32_t max_us;
+    /** @brief Average */
+    uint32_t avg_us;
+} lt_link_probe_latency_t;
+
+/** @brief Throughput of Pings of one size */
+typedef struct lt_link_probe_tput_t {
+    /** @brief Length of Ping message, 0 when the size was not measured */
+    uint16_t len;
+    /** @brief Average duration of one Ping, including host encryption and decryption */
+    uint32_t avg_us;
+    /** @brief Message bytes sent and received per second */
+    uint32_t bytes_per_s;
+} lt_link_probe_tput_t;
+
+/** @brief Result of `lt_link_probe()` */
+typedef struct lt_link_probe_result_t {
+    /** @brief Latency of plain L2 requests */
+    lt_link_probe_latency_t latency;
+    /** @brief Throughput of encrypted Pings, from the shortest one */
+    lt_link_probe_tput_t tput[LT_LINK_PROBE_SIZES];
+    /** @brief Number of L2 frames exchanged (requests and responses), without resends */
+    uint32_t frames;
+    /** @brief Frames with CRC error, detected by host or reported by TROPIC01 */
+    uint32_t crc_errors;
+    /** @brief Number of Resend_Req sent */
+    uint32_t resends;
+    /** @brief CRC errors per million of frames */
+    uint32_t crc_error_ppm;
+#if LT_ADAPTIVE_POLLING
+    /** @brief Derived polling profiles, first delay is the shortest wait and gaps follow its spread */
+    lt_l1_poll_profile_t profiles[LT_LINK_PROBE_PROFILES];
+#endif
+} lt_link_probe_result_t;
+
+/**
+ * @brief Measures latency and throughput of the link
+ * @details Ping needs established secure session, latency is measured also without it.
+ *
+ * @param h           Device's handle
+ * @param cfg         Configuration of the probe
+ * @param res         Result, zeroed at the start
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_link_probe(lt_handle_t *h, const lt_link_probe_cfg_t *cfg, lt_link_probe_result_t *res);
+
+/** @} */  // end of libtropic_link_probe group
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef LIBTROPIC_LOG_DRAIN_H
+#define LIBTROPIC_LOG_DRAIN_H
+
+/**
+ * @defgroup libtropic_log_drain libtropic log drain
+ * @brief Collection of firmware log messages of TROPIC01 in idle time of the bus
+ * @details `lt_log_drain_poll()` is called from the idle loop of the application, e.g. from `idle` callback of the
+ * Unix I/O thread, which calls it only while no request is submitted. At most one GET_LOG request is sent per call
+ * and only when `period_us` passed since the previous one, so a latency sensitive command waits at most for one
+ * short L2 round trip. Messages are stored with their time into a ring buffer supplied by the application, the oldest
+ * ones are dropped when it is full. Empty responses (no message pending) are not stored.
+ *
+ * With LT_IDLE_SLEEP, nothing is sent while TROPIC01 sleeps and GET_LOG requests do not count as communication, so
+ * they do not postpone `lt_idle_poll()` putting TROPIC01 to sleep.
+ *
+ * Firmware sends log messages only when logging is enabled in its configuration. With LT_THREAD_SAFE, the ring
+ * is accessed under the lock of the handle, so `lt_log_drain_read()` can be called from any thread.
+ * @{
+ */
+
+/**
+ * @file libtropic_log_drain.h
+ * @brief Log drain declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Size of header of a record in `lt_log_drain_t.buff`: time (4 B) and length of message (1 B) */
+#define LT_LOG_DRAIN_HDR_LEN 5
+
+/** @brief Statistics of `lt_log_drain_t` */
+typedef struct lt_log_drain_stats_t {
+    /** @brief Number of GET_LOG requests sent */
+    uint32_t requests;
+    /** @brief Number of stored messages */
+    uint32_t msgs;
+    /** @brief Number of stored bytes of messages */
+    uint32_t bytes;
+    /** @brief Number of messages dropped, because the ring was full or the message did not fit into it at all */
+    uint32_t dropped;
+} lt_log_drain_stats_t;
+
+/** @brief Drain of firmware log, initialized by `lt_log_drain_init()` */
+typedef struct lt_log_drain_t {
+    /** @public @brief Monotonic clock in us, mandatory */
+    uint32_t (*time_us)(void);
+    /** @public @brief Ring buffer of records, must stay valid while the drain is used */
+    uint8_t *buff;
+    /** @public @brief Size of `buff`, at least LT_LOG_DRAIN_HDR_LEN + GET_LOG_MAX_MSG_LEN keeps every message */
+    uint16_t buff_len;
+    /** @public @brief Minimal time between two GET_LOG requests in us */
+    uint32_t period_us;
+    /** @public @brief Statistics, read only */
+    lt_log_drain_stats_t stats;
+    /** @private @brief Position of the oldest record */
+    uint16_t tail;
+    /** @private @brief Number of occupied bytes */
+    uint16_t used;
+    /** @private @brief Time of the last GET_LOG request */
+    uint32_t last_us;
+} lt_log_drain_t;
+
+/**
+ * @brief Initializes the drain, its public members must be set before
+ *
+ * @param d           Drain
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_log_drain_init(lt_log_drain_t *d);
+
+/**
+ * @brief Sends one GET_LOG request when `period_us` passed since the previous one and stores its message
+ *
+ * @param h           Device's handle
+ * @param d           Drain initialized by `lt_log_drain_init()`
+ *
+ * @retval            LT_OK Request was sent and its message (if any) stored
+ * @retval            LT_BUSY Nothing was sent, the period did not pass yet or TROPIC01 sleeps
+ * @retval            LT_PARAM_ERR Invalid parameter
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_log_drain_poll(lt_handle_t *h, lt_log_drain_t *d);
+
+/**
+ * @brief Takes the oldest stored message
+ *
+ * @param h           Device's handle passed to `lt_log_drain_poll()`
+ * @param d           Drain
+ * @param time_us     Time of `time_us` when the message was received
+ * @param msg         Message, GET_LOG_MAX_MSG_LEN bytes
+ * @param msg_len     Length of the message
+ *
+ * @retval            LT_OK Message was taken
+ * @retval            LT_PENDING No message is stored
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_log_drain_read(lt_handle_t *h, lt_log_drain_t *d, uint32_t *time_us, uint8_t *msg, uint16_t *msg_len);
+
+/** @} */  // end of libtropic_log_drain group
+
+#endif
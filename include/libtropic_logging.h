@@ -11,6 +11,12 @@
 
 #include <assert.h>
 #include <stdio.h>
+#if LT_LOG_DEFERRED
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#endif
 
 // Only info-level loggers and decorators.
 // This has no effect, test runner just simply copies these lines to the log.
@@ -35,30 +41,247 @@
         }                                                        \
     } while (0)
 
+#if LT_LOG_DEFERRED
+/**
+ * @brief Level of log message, also threshold of `lt_log_t.level` and `lt_l2_state_t.log_level`, messages with
+ * level up to the threshold are logged
+ */
+typedef enum lt_log_level_t {
+    /** @brief Threshold of handle, which uses `lt_log_t.level` */
+    LT_LOG_LEVEL_DEFAULT = 0,
+    /** @brief Threshold disabling all messages */
+    LT_LOG_LEVEL_OFF = 1,
+    LT_LOG_LEVEL_ERROR = 2,
+    LT_LOG_LEVEL_WARN = 3,
+    LT_LOG_LEVEL_INFO = 4,
+    LT_LOG_LEVEL_DEBUG = 5
+} lt_log_level_t;
+
+/** @brief Max number of arguments of deferred log message */
+#define LT_LOG_ARGS_MAX 8
+/** @brief Size of buffer for strings (`%s` arguments) copied into each deferred log message */
+#ifndef LT_LOG_STR_SIZE
+#define LT_LOG_STR_SIZE 48
+#endif
+/** @brief Max length of formatted log message, longer ones are truncated */
+#ifndef LT_LOG_MSG_SIZE
+#define LT_LOG_MSG_SIZE 160
+#endif
+
+/** @brief Argument of deferred log message, kept in its type after default argument promotions */
+typedef union lt_log_arg_t {
+    uint64_t u;
+    double d;
+    const void *p;
+} lt_log_arg_t;
+
+/** @brief Deferred log message, formatted by `lt_log_flush()` */
+typedef struct lt_log_entry_t {
+    /** @private @brief Sequence number of the slot in the ring */
+    uint32_t seq;
+    /** @private @brief `lt_log_level_t` of the message */
+    uint8_t level;
+    /** @private @brief Number of arguments */
+    uint8_t nargs;
+    /** @private @brief Source line */
+    uint16_t line;
+    /** @private @brief Format string, it must stay valid, which holds for string literals */
+    const char *fmt;
+    /** @private @brief Arguments, `%s` ones hold offset into `str` */
+    lt_log_arg_t args[LT_LOG_ARGS_MAX];
+    /** @private @brief Copies of `%s` arguments, longer strings are truncated */
+    char str[LT_LOG_STR_SIZE];
+} lt_log_entry_t;
+
+/**
+ * @brief Receives formatted log message
+ *
+ * @param ctx         Argument given to `lt_log_init()`
+ * @param level       Level of the message
+ * @param line        Source line of the message
+ * @param msg         Message without the line break, NUL terminated
+ */
+typedef void (*lt_log_sink_t)(void *ctx, const lt_log_level_t level, const uint16_t line, const char *msg);
+
+/**
+ * @brief Ring of deferred log messages initialized by `lt_log_init()`
+ * @details Messages are stored without formatting by any thread and formatted by `lt_log_flush()`, called
+ * periodically from one background task.
+ */
+typedef struct lt_log_t {
+    /** @public @brief Threshold of messages logged, `lt_log_level_t` */
+    uint8_t level;
+    /** @private @brief Sink of formatted messages, NULL prints them to stdout */
+    lt_log_sink_t sink;
+    /** @private @brief Argument of `sink` */
+    void *sink_ctx;
+    /** @private @brief Slots of messages, the number of them is a power of two */
+    lt_log_entry_t *entries;
+    /** @private @brief Number of slots minus one */
+    uint32_t mask;
+    /** @private @brief Number of messages stored */
+    uint32_t head;
+    /** @private @brief Number of messages formatted */
+    uint32_t tail;
+    /** @public @brief Number of messages lost because the ring was full */
+    uint32_t dropped;
+} lt_log_t;
+
+/**
+ * @brief Initializes ring of deferred log messages and makes it the destination of all LT_LOG_* macros
+ * @note Until it is called, messages are formatted and printed immediately.
+ *
+ * @param log         Ring of messages, must stay valid
+ * @param entries     Slots of messages, must stay valid
+ * @param cnt         Number of slots, power of two
+ * @param sink        Sink of formatted messages, NULL prints them to stdout
+ * @param sink_ctx    Argument of `sink`
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_log_init(lt_log_t *log, lt_log_entry_t *entries, const uint32_t cnt, lt_log_sink_t sink, void *sink_ctx);
+
+/**
+ * @brief Formats stored messages and passes them to the sink, called from one task only
+ *
+ * @param log         Ring of messages
+ * @param max         Max number of messages to format
+ * @return            Number of formatted messages
+ */
+uint32_t lt_log_flush(lt_log_t *log, const uint32_t max);
+
+/**
+ * @brief Tells whether a message passes the threshold, used by LT_LOG_* macros
+ *
+ * @param level       Level of the message
+ * @param filter      Threshold of handle, LT_LOG_LEVEL_DEFAULT to use `lt_log_t.level`
+ * @return            Nonzero when the message is logged
+ */
+int lt_log_enabled(const lt_log_level_t level, const uint8_t filter);
+
+/**
+ * @brief Stores a message into the ring given to `lt_log_init()`, used by LT_LOG_* macros
+ *
+ * @param level       Level of the message
+ * @param line        Source line of the message
+ * @param fmt         Format string, must stay valid
+ * @param nargs       Number of arguments
+ * @param args        Arguments created by LT_LOG_ARG()
+ */
+void lt_log_defer(const lt_log_level_t level, const uint16_t line, const char *fmt, const uint8_t nargs,
+                  const lt_log_arg_t *args);
+
+/** \cond */
+#define LT_LOG_CAT_(a, b) a##b
+#define LT_LOG_CAT(a, b) LT_LOG_CAT_(a, b)
+#define LT_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LT_LOG_NARGS(...) LT_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+// Type of argument after default argument promotions, arrays decay to pointers
+#define LT_LOG_PROMOTED(x)                                                                                        \
+    _Generic((x), _Bool: 0, char: 0, signed char: 0, unsigned char: 0, short: 0, unsigned short: 0, float: 0.0, \
+             default: (1 ? (x) : (x)))
+#define LT_LOG_ARG(x)                                                                                     \
+    __extension__({                                                                                       \
+        __typeof__(LT_LOG_PROMOTED(x)) lt_log_v_ = (x);                                                   \
+        lt_log_arg_t lt_log_a_ = {0};                                                                     \
+        memcpy(&lt_log_a_, &lt_log_v_,                                                                   \
+               (sizeof(lt_log_v_) < sizeof(lt_log_a_)) ? sizeof(lt_log_v_) : sizeof(lt_log_a_));          \
+        lt_log_a_;                                                                                        \
+    })
+#define LT_LOG_MAP_0(...)
+#define LT_LOG_MAP_1(a) , LT_LOG_ARG(a)
+#define LT_LOG_MAP_2(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_1(__VA_ARGS__)
+#define LT_LOG_MAP_3(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_2(__VA_ARGS__)
+#define LT_LOG_MAP_4(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_3(__VA_ARGS__)
+#define LT_LOG_MAP_5(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_4(__VA_ARGS__)
+#define LT_LOG_MAP_6(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_5(__VA_ARGS__)
+#define LT_LOG_MAP_7(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_6(__VA_ARGS__)
+#define LT_LOG_MAP_8(a, ...) , LT_LOG_ARG(a) LT_LOG_MAP_7(__VA_ARGS__)
+#define LT_LOG_MAP(...) LT_LOG_CAT(LT_LOG_MAP_, LT_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+/** \endcond */
+
+/**
+ * @brief Stores message for deferred formatting when it passes the threshold, arguments are evaluated only then.
+ * Format string is checked by the compiler as for printf.
+ */
+#define LT_LOG_DEFER(level_, filter_, f_, ...)                                                                \
+    do {                                                                                                      \
+        if (0) {                                                                                              \
+            printf(" " f_, ##__VA_ARGS__);                                                                    \
+        }                                                                                                     \
+        if (lt_log_enabled(level_, filter_)) {                                                                \
+            const lt_log_arg_t lt_log_args_[] = {{0} LT_LOG_MAP(__VA_ARGS__)};                                \
+            lt_log_defer(level_, __LINE__, f_, LT_LOG_NARGS(__VA_ARGS__), lt_log_args_ + 1);                  \
+        }                                                                                                     \
+    } while (0)
+#endif
+
 #if LT_LOG_ENABLE_INFO
+#if LT_LOG_DEFERRED
+#define LT_LOG_INFO(f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_INFO, LT_LOG_LEVEL_DEFAULT, f_, ##__VA_ARGS__)
+#else
 #define LT_LOG_INFO(f_, ...) printf("INFO    [%4d] " f_ "\r\n", __LINE__, ##__VA_ARGS__)
+#endif
 #else
 #define LT_LOG_INFO(f_, ...) LT_LOG_DISABLED(f_, ##__VA_ARGS__)
 #endif
 
 #if LT_LOG_ENABLE_WARN
+#if LT_LOG_DEFERRED
+#define LT_LOG_WARN(f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_WARN, LT_LOG_LEVEL_DEFAULT, f_, ##__VA_ARGS__)
+#else
 #define LT_LOG_WARN(f_, ...) printf("WARNING [%4d] " f_ "\r\n", __LINE__, ##__VA_ARGS__)
+#endif
 #else
 #define LT_LOG_WARN(f_, ...) LT_LOG_DISABLED(f_, ##__VA_ARGS__)
 #endif
 
 #if LT_LOG_ENABLE_ERROR
+#if LT_LOG_DEFERRED
+#define LT_LOG_ERROR(f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_ERROR, LT_LOG_LEVEL_DEFAULT, f_, ##__VA_ARGS__)
+#else
 #define LT_LOG_ERROR(f_, ...) printf("ERROR   [%4d] " f_ "\r\n", __LINE__, ##__VA_ARGS__)
+#endif
 #else
 #define LT_LOG_ERROR(f_, ...) LT_LOG_DISABLED(f_, ##__VA_ARGS__)
 #endif
 
 #if LT_LOG_ENABLE_DEBUG
+#if LT_LOG_DEFERRED
+#define LT_LOG_DEBUG(f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_DEBUG, LT_LOG_LEVEL_DEFAULT, f_, ##__VA_ARGS__)
+#else
 #define LT_LOG_DEBUG(f_, ...) printf("DEBUG   [%4d] " f_ "\r\n", __LINE__, ##__VA_ARGS__)
+#endif
 #else
 #define LT_LOG_DEBUG(f_, ...) LT_LOG_DISABLED(f_, ##__VA_ARGS__)
 #endif
 
+// Loggers of a handle, with LT_LOG_DEFERRED filtered also by `lt_l2_state_t.log_level` of the handle.
+#if LT_LOG_ENABLE_INFO && LT_LOG_DEFERRED
+#define LT_LOG_S2_INFO(s2, f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_INFO, (s2)->log_level, f_, ##__VA_ARGS__)
+#else
+#define LT_LOG_S2_INFO(s2, f_, ...) LT_LOG_INFO(f_, ##__VA_ARGS__)
+#endif
+
+#if LT_LOG_ENABLE_WARN && LT_LOG_DEFERRED
+#define LT_LOG_S2_WARN(s2, f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_WARN, (s2)->log_level, f_, ##__VA_ARGS__)
+#else
+#define LT_LOG_S2_WARN(s2, f_, ...) LT_LOG_WARN(f_, ##__VA_ARGS__)
+#endif
+
+#if LT_LOG_ENABLE_ERROR && LT_LOG_DEFERRED
+#define LT_LOG_S2_ERROR(s2, f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_ERROR, (s2)->log_level, f_, ##__VA_ARGS__)
+#else
+#define LT_LOG_S2_ERROR(s2, f_, ...) LT_LOG_ERROR(f_, ##__VA_ARGS__)
+#endif
+
+#if LT_LOG_ENABLE_DEBUG && LT_LOG_DEFERRED
+#define LT_LOG_S2_DEBUG(s2, f_, ...) LT_LOG_DEFER(LT_LOG_LEVEL_DEBUG, (s2)->log_level, f_, ##__VA_ARGS__)
+#else
+#define LT_LOG_S2_DEBUG(s2, f_, ...) LT_LOG_DEBUG(f_, ##__VA_ARGS__)
+#endif
+
 // Assertions. Will log as a system message and call native assert function.
 // Note that parameters are stored to _val_ and _exp_ for a case when there
 // are function calls passed to the macros. Without the helper variables
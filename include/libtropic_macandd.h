@@ -0,0 +1,142 @@
+#ifndef LIBTROPIC_MACANDD_H
+#define LIBTROPIC_MACANDD_H
+
+/**
+ * @defgroup libtropic_macandd libtropic MAC-and-Destroy PIN engine
+ * @brief PIN verification with a limited number of attempts, based on MAC-and-Destroy slots of TROPIC01
+ * @details The scheme is the one shown by `examples/lt_ex_macandd.c`, see the Application note for its description.
+ * `rounds` MAC-and-Destroy slots starting from MAC_AND_DESTROY_SLOT_0 are used, so the PIN can be entered wrongly
+ * `rounds` times. Data needed between power cycles are kept in a range of R-memory User Data slots: the first slot
+ * holds a header with the number of remaining attempts, the next slots hold one ciphertext of the secret per round.
+ *
+ * MAC-and-Destroy commands of one phase are pipelined with `lt_mac_and_destroy_batch()`. Only the header slot is
+ * rewritten by `lt_macandd_pin_check()`.
+ *
+ * The engine uses only the public libtropic API, it is not protected by any lock.
+ * @{
+ */
+
+/**
+ * @file libtropic_macandd.h
+ * @brief MAC-and-Destroy PIN engine declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Minimal size of PIN */
+#define LT_MACANDD_PIN_SIZE_MIN 4u
+/** @brief Maximal size of PIN */
+#define LT_MACANDD_PIN_SIZE_MAX 8u
+/** @brief Maximal size of additional data mixed with PIN (e.g. HW ID) */
+#define LT_MACANDD_ADD_SIZE_MAX 128u
+/** @brief Size of the secret released by a correct PIN */
+#define LT_MACANDD_SECRET_SIZE 32u
+
+/** @brief Number of ciphertexts of the secret held by one R-memory slot */
+#define LT_MACANDD_CI_PER_SLOT (R_MEM_DATA_SIZE_MAX / 32)
+
+/** @brief Number of R-memory slots used for `rounds` attempts */
+#define LT_MACANDD_NVM_SLOTS(rounds) (1 + (((rounds) + LT_MACANDD_CI_PER_SLOT - 1) / LT_MACANDD_CI_PER_SLOT))
+
+/** @brief Time spent in each phase of the last PIN operation, in milliseconds of `lt_macandd_t.time_ms` */
+typedef struct lt_macandd_timing_t {
+    /** @brief Reading and writing R-memory slots */
+    uint32_t nvm_ms;
+    /** @brief MAC-and-Destroy commands */
+    uint32_t macandd_ms;
+    /** @brief Key derivations on host */
+    uint32_t kdf_ms;
+} lt_macandd_timing_t;
+
+/**
+ * @brief PIN engine initialized by `lt_macandd_init()`
+ */
+typedef struct lt_macandd_t {
+    /** @private @brief Device's handle */
+    lt_handle_t *h;
+    /** @private @brief First R-memory slot of the range */
+    uint16_t nvm_slot;
+    /** @private @brief Number of MAC-and-Destroy slots, i.e. of attempts */
+    uint8_t rounds;
+    /** @brief Optional clock, when set the phases of the last operation are measured into `timing` */
+    uint32_t (*time_ms)(void);
+    /** @brief Time of phases of the last `lt_macandd_pin_set()` or `lt_macandd_pin_check()` */
+    lt_macandd_timing_t timing;
+    /** @private @brief HMAC key pads of the all-zero key, precomputed by `lt_macandd_init()` */
+    uint64_t kdf_zero[12];
+} lt_macandd_t;
+
+/**
+ * @brief Initializes PIN engine, no command is sent to TROPIC01
+ *
+ * @param m           PIN engine
+ * @param h           Device's handle, must stay valid while the engine is used
+ * @param rounds      Number of attempts, 1 to MACANDD_ROUNDS_MAX, must be the same for set and check
+ * @param nvm_slot    First slot of LT_MACANDD_NVM_SLOTS(rounds) R-memory slots used by the engine
+ * @param time_ms     Optional clock for `lt_macandd_t.timing`, NULL to disable measurement
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_macandd_init(lt_macandd_t *m, lt_handle_t *h, const uint8_t rounds, const uint16_t nvm_slot,
+                         uint32_t (*time_ms)(void));
+
+/**
+ * @brief Sets a new PIN and releases a new secret bound to it
+ * @details Secure session must be established. All R-memory slots of the engine are erased and written.
+ *
+ * @param m           PIN engine
+ * @param pin         PIN, LT_MACANDD_PIN_SIZE_MIN to LT_MACANDD_PIN_SIZE_MAX bytes
+ * @param pin_size    Size of PIN
+ * @param add         Additional data, may be NULL when `add_size` is 0
+ * @param add_size    Size of additional data, at most LT_MACANDD_ADD_SIZE_MAX
+ * @param secret      Buffer for LT_MACANDD_SECRET_SIZE bytes of secret, zeroed on failure
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_macandd_pin_set(lt_macandd_t *m, const uint8_t *pin, const uint8_t pin_size, const uint8_t *add,
+                            const uint8_t add_size, uint8_t *secret);
+
+/**
+ * @brief Checks PIN and releases the secret when it is correct
+ * @details Secure session must be established. One attempt is consumed before the PIN is verified, a correct PIN
+ * restores all attempts.
+ *
+ * @param m           PIN engine
+ * @param pin         PIN, LT_MACANDD_PIN_SIZE_MIN to LT_MACANDD_PIN_SIZE_MAX bytes
+ * @param pin_size    Size of PIN
+ * @param add         Additional data given to `lt_macandd_pin_set()`, may be NULL when `add_size` is 0
+ * @param add_size    Size of additional data, at most LT_MACANDD_ADD_SIZE_MAX
+ * @param secret      Buffer for LT_MACANDD_SECRET_SIZE bytes of secret, zeroed on failure
+ *
+ * @retval            LT_OK PIN is correct
+ * @retval            LT_FAIL PIN is wrong, no attempt is left or R-memory slots do not hold data of the engine
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_macandd_pin_check(lt_macandd_t *m, const uint8_t *pin, const uint8_t pin_size, const uint8_t *add,
+                              const uint8_t add_size, uint8_t *secret);
+
+/**
+ * @brief Reads number of remaining attempts
+ *
+ * @param m           PIN engine
+ * @param attempts    Number of remaining attempts
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_FAIL R-memory slots do not hold data of the engine
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_macandd_attempts_get(lt_macandd_t *m, uint8_t *attempts);
+
+/** @} */  // end of libtropic_macandd group
+
+#endif
@@ -10,11 +10,18 @@
  */
 
 /** @brief Wrapper for static assertion. */
+#ifdef __cplusplus
+#define STATIC_ASSERT(x) static_assert((x), "Static assertion failed");
+#else
 #define STATIC_ASSERT(x) _Static_assert((x), "Static assertion failed");
+#endif
 
 /** @brief Get struct member size at compile-time. */
 #define MEMBER_SIZE(type, member) (sizeof(((type *)0)->member))
 
+/** @brief Convert microseconds to miliseconds, rounded up. */
+#define LT_US_TO_MS_CEIL(us) (((us) + 999) / 1000)
+
 /** @brief Mark variable as unused to sanitize compiler warnings. */
 #ifndef UNUSED
 #define UNUSED(x) (void)(x)
@@ -0,0 +1,149 @@
+#ifndef LIBTROPIC_MERKLE_H
+#define LIBTROPIC_MERKLE_H
+
+/**
+ * @defgroup libtropic_merkle libtropic Merkle batch signing
+ * @brief Many messages signed by one signature of TROPIC01 over the root of their Merkle tree
+ * @details `lt_merkle_ecdsa_sign()` and `lt_merkle_eddsa_sign()` hash the messages of a batch into a Merkle tree on
+ * the host and sign only its root, so the number of signatures per second is bound by hashing on the host instead of
+ * signing on the chip. `lt_merkle_proof_get()` then gives each message its inclusion proof, which together with the
+ * signature of the root is checked by `lt_merkle_ecdsa_verify()` or `lt_merkle_eddsa_verify()`.
+ *
+ * Leaves are SHA256(0x00 || SHA256(message)) and inner nodes SHA256(0x01 || left || right), so no leaf is taken
+ * for an inner node. A node without a sibling at the end of its level is carried one level up unchanged. The signed
+ * message is 0x02 || number of messages (32-bit little endian) || root, `LT_MERKLE_ROOT_MSG_SIZE` bytes, so a proof
+ * is valid only for its position in a batch of its size. Nodes of one level are hashed by `lt_sha256_multi()`, in
+ * parallel lanes when libtropic is built with LT_SHA256_MULTI.
+ * @{
+ */
+
+/**
+ * @file libtropic_merkle.h
+ * @brief Merkle batch signing declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+/** @brief Maximal depth of the tree, batches have at most 2^LT_MERKLE_DEPTH_MAX messages, if not set */
+#ifndef LT_MERKLE_DEPTH_MAX
+#define LT_MERKLE_DEPTH_MAX 16
+#endif
+
+/** @brief Size of one node of the tree */
+#define LT_MERKLE_NODE_SIZE 32
+/** @brief Size of the message signed by TROPIC01 */
+#define LT_MERKLE_ROOT_MSG_SIZE (1 + 4 + LT_MERKLE_NODE_SIZE)
+/** @brief Number of nodes of the tree of `cnt` messages, bound for the size of `lt_merkle_tree_t.nodes` */
+#define LT_MERKLE_NODES_MAX(cnt) (2 * (cnt) + LT_MERKLE_DEPTH_MAX)
+
+/** @brief Tree of a signed batch, filled by `lt_merkle_ecdsa_sign()` or `lt_merkle_eddsa_sign()` */
+typedef struct lt_merkle_tree_t {
+    /** @public @brief Space of LT_MERKLE_NODES_MAX(cnt) * LT_MERKLE_NODE_SIZE bytes, levels from the leaves up */
+    uint8_t *nodes;
+    /** @public @brief Number of messages of the batch, read-only */
+    uint32_t cnt;
+    /** @public @brief Message signed by TROPIC01, read-only */
+    uint8_t root_msg[LT_MERKLE_ROOT_MSG_SIZE];
+} lt_merkle_tree_t;
+
+/** @brief Inclusion proof of one message, filled by `lt_merkle_proof_get()` */
+typedef struct lt_merkle_proof_t {
+    /** @brief Position of the message in its batch */
+    uint32_t index;
+    /** @brief Number of messages of the batch */
+    uint32_t cnt;
+    /** @brief Number of nodes of `path` */
+    uint8_t path_len;
+    /** @brief Siblings on the way from the leaf to the root, nodes carried up have none */
+    uint8_t path[LT_MERKLE_DEPTH_MAX][LT_MERKLE_NODE_SIZE];
+} lt_merkle_proof_t;
+
+/**
+ * @brief Hashes the messages into the tree and signs its root by ECDSA key in the slot
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot with P256 key
+ * @param tree        Tree with `nodes` set
+ * @param msgs        Messages
+ * @param msg_lens    Lengths of the messages
+ * @param cnt         Number of messages, 1 to 2^LT_MERKLE_DEPTH_MAX
+ * @param rs          Signature of `tree->root_msg`, 64B
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_merkle_ecdsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, lt_merkle_tree_t *tree,
+                              const uint8_t *const *msgs, const uint32_t *msg_lens, const uint32_t cnt, uint8_t *rs);
+
+/**
+ * @brief Hashes the messages into the tree and signs its root by EdDSA key in the slot
+ *
+ * @param h           Device's handle
+ * @param ecc_slot    Slot with Ed25519 key
+ * @param tree        Tree with `nodes` set
+ * @param msgs        Messages
+ * @param msg_lens    Lengths of the messages
+ * @param cnt         Number of messages, 1 to 2^LT_MERKLE_DEPTH_MAX
+ * @param rs          Signature of `tree->root_msg`, 64B
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_merkle_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, lt_merkle_tree_t *tree,
+                              const uint8_t *const *msgs, const uint32_t *msg_lens, const uint32_t cnt, uint8_t *rs);
+
+/**
+ * @brief Reads inclusion proof of a message from the tree of its batch
+ *
+ * @param tree        Tree of the signed batch
+ * @param index       Position of the message in the batch
+ * @param proof       Proof
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_PARAM_ERR Invalid parameter, e.g. `index` out of the batch
+ */
+lt_ret_t lt_merkle_proof_get(const lt_merkle_tree_t *tree, const uint32_t index, lt_merkle_proof_t *proof);
+
+/**
+ * @brief Checks that the message is in a batch whose root is signed by the ECDSA key
+ *
+ * @param msg         Message
+ * @param msg_len     Length of the message
+ * @param proof       Inclusion proof of the message
+ * @param pubkey      Signer's public key, 64B
+ * @param rs          Signature of the root, 64B
+ *
+ * @retval            LT_OK Message is in the signed batch
+ * @retval            LT_FAIL Proof or signature is not valid
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_merkle_ecdsa_verify(const uint8_t *msg, const uint32_t msg_len, const lt_merkle_proof_t *proof,
+                                const uint8_t *pubkey, const uint8_t *rs);
+
+/**
+ * @brief Checks that the message is in a batch whose root is signed by the EdDSA key
+ *
+ * @param msg         Message
+ * @param msg_len     Length of the message
+ * @param proof       Inclusion proof of the message
+ * @param pubkey      Signer's public key, 32B
+ * @param rs          Signature of the root, 64B
+ *
+ * @retval            LT_OK Message is in the signed batch
+ * @retval            LT_FAIL Proof or signature is not valid
+ * @retval            LT_PARAM_ERR Invalid parameter
+ */
+lt_ret_t lt_merkle_eddsa_verify(const uint8_t *msg, const uint32_t msg_len, const lt_merkle_proof_t *proof,
+                                const uint8_t *pubkey, const uint8_t *rs);
+
+/** @} */  // end of libtropic_merkle group
+
+#endif
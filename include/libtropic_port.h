@@ -80,6 +80,78 @@ lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2);
  */
 lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len, uint32_t timeout_ms);
 
+#if LT_USE_SPI_TRANSFER_BUF
+/**
+ * @brief Transfers bytes of the frame like `lt_port_spi_transfer()`, but from and to any buffers, platform defined
+ * function.
+ *
+ * `len` bytes are sent from `tx` and received into `rx`. When `tx` is NULL, bytes of `rx` are sent (the transfer is
+ * in place), when `rx` is NULL, received bytes are discarded. Chip select is not changed. Used to receive data of
+ * responses straight into their destination, e.g. L3 buffer, with only the header and CRC in handle's buffer.
+ *
+ * Needed only when libtropic is compiled with `LT_USE_SPI_TRANSFER_BUF`, ports registering `lt_port_ops_t` may leave
+ * it NULL and libtropic then transfers through its buffer by `lt_port_spi_transfer()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param tx          Bytes to be sent, NULL to send bytes of `rx`
+ * @param rx          Buffer for received bytes, NULL to discard them
+ * @param len         Number of bytes to be transferred
+ * @param timeout_ms  Timeout
+ *
+ * @retval            LT_OK   Function executed successfully
+ * @retval            LT_FAIL Function did not execute successully
+ */
+lt_ret_t lt_port_spi_transfer_buf(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                  uint32_t timeout_ms);
+#endif
+
+/**
+ * @brief Max number of segments in one SPI transaction, see `lt_port_spi_transaction()`.
+ */
+#define LT_L1_SPI_SEGMENTS_MAX 4
+
+/**
+ * @brief One segment of a vectored SPI transaction, see `lt_port_spi_transaction()`.
+ */
+typedef struct lt_l1_spi_segment_t {
+    /** @brief Offset in handle's internal buffer where the segment's data starts */
+    uint8_t offset;
+    /** @brief Number of bytes to be transferred (in place) */
+    uint16_t len;
+    /** @brief When nonzero, chip select stays low after this segment */
+    uint8_t cs_hold;
+    /**
+     * @brief When not NULL, `len` bytes are sent from here instead of the handle's buffer and received bytes are
+     * discarded. Emulated transactions copy them to the handle's buffer at `offset` first.
+     */
+    const uint8_t *tx;
+} lt_l1_spi_segment_t;
+
+#if LT_USE_SPI_TRANSACTION
+/**
+ * @brief Does several L1 transfers as one transaction, platform defined function.
+ *
+ * Chip select is driven low before the first segment. After each segment with `cs_hold` equal to zero, chip select
+ * is driven high (and low again before the next segment, if there is any). When the last segment has `cs_hold` set,
+ * chip select stays low after the transaction and the frame can be continued with `lt_port_spi_transfer()` and
+ * finished with `lt_port_spi_csn_high()`. Segments with `tx` set are only sent, their data stay in place.
+ *
+ * Implementing this function is optional, it is used only when libtropic is compiled with `LT_USE_SPI_TRANSACTION`.
+ * Otherwise the transaction is emulated by calls to `lt_port_spi_csn_low()`, `lt_port_spi_transfer()` and
+ * `lt_port_spi_csn_high()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param segs        Array of segments
+ * @param seg_cnt     Number of segments in `segs`, at most `LT_L1_SPI_SEGMENTS_MAX`
+ * @param timeout_ms  Timeout
+ *
+ * @retval            LT_OK   Function executed successfully
+ * @retval            LT_FAIL Function did not execute successully
+ */
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms);
+#endif
+
 /**
  * @brief Platform defined function for delay, specifies what host platform should do when libtropic's functions need
  * some delay.
@@ -92,19 +164,133 @@ lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len
  */
 lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms);
 
+#if LT_USE_DELAY_US
+/**
+ * @brief Platform defined function for delay with microsecond resolution, used for gaps between polls of
+ * CHIP_STATUS, which can be shorter than a milisecond.
+ *
+ * Implementing this function is optional, it is used only when libtropic is compiled with `LT_USE_DELAY_US`.
+ * Otherwise `lt_port_delay()` is used with the time rounded up to whole miliseconds.
+ *
+ * @param s2          Structure holding l2 state
+ * @param us          Time to wait in microseconds
+ *
+ * @retval            LT_OK   Function executed successfully
+ * @retval            LT_FAIL Function did not execute successully
+ */
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us);
+#endif
+
 #if LT_USE_INT_PIN
 /**
  * @brief Platform defined function used to specify reading of an interrupt pin, used as a signal that chip has a
  * response.
  *
+ * The function shall block until INT pin is asserted (high) or `ms` elapses. It should return as soon as INT pin is
+ * asserted, ideally by waiting for an edge event instead of polling the pin. Returning LT_OK spuriously is allowed,
+ * libtropic always checks CHIP_STATUS afterwards.
+ *
  * @param s2          Structure holding l2 state
  * @param ms          Max time to wait in miliseconds
  *
+ * @retval            LT_OK             INT pin is asserted
+ * @retval            LT_L1_INT_TIMEOUT INT pin was not asserted in time
+ * @retval            LT_FAIL           Function did not execute successully
+ */
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms);
+#endif
+#if LT_USE_PORT_CRC16
+/**
+ * @brief Calculates CRC16 of L2 frame data by a hardware CRC unit, platform defined function.
+ *
+ * CRC16 uses polynomial 0x8005 and initial value 0x0000, neither input nor output is reflected and no final XOR is
+ * applied. The two bytes of the result are swapped, so it equals the value returned by `crc16()`.
+ *
+ * Implementing this function is optional, it is used only when libtropic is compiled with `LT_USE_PORT_CRC16`.
+ * When it does not return LT_OK, the checksum is calculated in software.
+ *
+ * @param s2          Structure holding l2 state
+ * @param data        Data to calculate the checksum of
+ * @param len         Length of data
+ * @param crc         Calculated checksum
+ *
  * @retval            LT_OK   Function executed successfully
  * @retval            LT_FAIL Function did not execute successully
  */
-lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms);
+lt_ret_t lt_port_crc16(lt_l2_state_t *s2, const uint8_t *data, uint16_t len, uint16_t *crc);
+#endif
+
+#if LT_USE_PORT_CACHE
+/**
+ * @brief Platform defined function writing data cache lines of a range back to memory, called before SPI transfer
+ * (or transaction), so DMA sends current data.
+ *
+ * For the L2 buffer, libtropic passes whole LT_L2_BUFF_ALIGN units. Data sent in place by a transaction
+ * (`lt_l1_spi_segment_t.tx`) are passed as they are, the port rounds their range to whole cache lines itself. So are
+ * the buffers of `lt_port_spi_transfer_buf()`, the one receiving is cleaned before and invalidated after it.
+ *
+ * Implementing this function is required only when libtropic is compiled with `LT_USE_PORT_CACHE`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param addr        Start of the range
+ * @param len         Length of the range
+ */
+void lt_port_cache_clean(lt_l2_state_t *s2, const void *addr, size_t len);
+
+/**
+ * @brief Platform defined function discarding data cache lines of a range of the L2 buffer, called after SPI transfer
+ * (or transaction), so CPU reads data received by DMA. The range consists of whole LT_L2_BUFF_ALIGN units, except
+ * for `rx` of `lt_port_spi_transfer_buf()`, whose range the port rounds itself.
+ *
+ * Implementing this function is required only when libtropic is compiled with `LT_USE_PORT_CACHE`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param addr        Start of the range
+ * @param len         Length of the range
+ */
+void lt_port_cache_invalidate(lt_l2_state_t *s2, void *addr, size_t len);
+#endif
+
+#if LT_USE_SPI_SPEED
+/**
+ * @brief Platform defined function changing SPI clock, used by `lt_spi_speed_set()` and by the auto-tuner of the
+ * clock (`lt_spi_tune_t`). It is called only while chip select is deasserted.
+ *
+ * Implementing this function is optional, it is used only when libtropic is compiled with `LT_USE_SPI_SPEED`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param hz          Requested clock in Hz
+ * @param actual_hz   Clock actually used, the highest one supported by the platform not exceeding `hz` (or the
+ *                    lowest supported one), it may equal `hz` when the platform does not report it
+ *
+ * @retval            LT_OK   Function executed successfully
+ * @retval            LT_FAIL Function did not execute successully
+ */
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz);
+#endif
+
+#if LT_THREAD_SAFE
+/**
+ * @brief Locks the handle for the calling thread, platform defined function.
+ *
+ * Each libtropic function taking a handle (except `lt_init()` and `lt_deinit()`) holds the lock while it uses the
+ * handle, so several threads can share one handle. The lock has to be recursive, because some libtropic functions
+ * call other ones. The port typically keeps a mutex in its device structure and initializes it in `lt_port_init()`.
+ *
+ * Implementing this function is required only when libtropic is compiled with `LT_THREAD_SAFE`.
+ *
+ * @param s2          Structure holding l2 state
+ */
+void lt_port_lock(lt_l2_state_t *s2);
+
+/**
+ * @brief Unlocks the handle locked by `lt_port_lock()`, platform defined function.
+ *
+ * @param s2          Structure holding l2 state
+ */
+void lt_port_unlock(lt_l2_state_t *s2);
 #endif
+
 /**
  * @brief Fill buffer with random bytes, platform defined function.
  *
@@ -117,6 +303,47 @@ lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms);
  */
 lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count);
 
+#if LT_L1_OFFLOAD
+/**
+ * @brief Sends a whole L1 frame made of segments, platform defined function.
+ *
+ * Used instead of the SPI functions by a port which sets `lt_l2_state_t.l1_offload` in `lt_port_init()`, e.g. one
+ * reaching TROPIC01 through a bridge. The port may keep the frame and send it together with the next
+ * `lt_port_l1_read()`, its failure is then returned by that read.
+ *
+ * Implementing this function is optional, it is used only when libtropic is compiled with `LT_L1_OFFLOAD`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param segs        Segments of the frame, as for `lt_port_spi_transaction()`
+ * @param seg_cnt     Number of segments in `segs`, at most `LT_L1_SPI_SEGMENTS_MAX`
+ * @param timeout_ms  Timeout
+ *
+ * @retval            LT_OK   Function executed successfully
+ * @retval            other   Error of the transfer, e.g. LT_L1_SPI_ERROR
+ */
+lt_ret_t lt_port_l1_write(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt, uint32_t timeout_ms);
+
+/**
+ * @brief Reads a response as `lt_l1_read()` does, polling CHIP_STATUS next to TROPIC01, platform defined function.
+ *
+ * On return `s2->buff` holds CHIP_STATUS followed by the response frame (STATUS, length, data and CRC), at least
+ * CHIP_STATUS also on failure. Implementing this function is optional, see `lt_port_l1_write()`.
+ *
+ * With LT_NONBLOCKING, `s2->l1_nonblocking` is set when the read is called by `lt_l2_transfer_poll()`. The port may
+ * then only send the request and return LT_PENDING, the next reads collect the response without sending anything
+ * until it has arrived. A port doing so tells its caller how to wait for the response, e.g. by a file descriptor.
+ *
+ * @param s2          Structure holding l2 state
+ * @param max_len     Max length of the response
+ * @param timeout_ms  Timeout of each SPI transfer
+ *
+ * @retval            LT_OK   Response was read
+ * @retval            LT_PENDING Response has not arrived yet, only when `s2->l1_nonblocking` is set
+ * @retval            other   Result of the polling, e.g. LT_L1_CHIP_BUSY, LT_L1_CHIP_ALARM_MODE or LT_L1_SPI_ERROR
+ */
+lt_ret_t lt_port_l1_read(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms);
+#endif
+
 /** @} */  // end of group_port_functions
 
 #endif
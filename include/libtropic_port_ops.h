@@ -0,0 +1,113 @@
+#if LT_PORT_OPS && defined(LT_PORT_OPS_PREFIX) && !defined(LT_PORT_OPS_RENAMED)
+// Port functions of the including port (and their declarations in libtropic_port.h) get LT_PORT_OPS_PREFIX
+// instead of `lt_port`, so they must be renamed before libtropic_port.h is included
+#define LT_PORT_OPS_RENAMED
+#define LT_PORT_OPS_CAT_(prefix, name) prefix##_##name
+#define LT_PORT_OPS_CAT(prefix, name) LT_PORT_OPS_CAT_(prefix, name)
+#define lt_port_init LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, init)
+#define lt_port_deinit LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, deinit)
+#define lt_port_spi_csn_low LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, spi_csn_low)
+#define lt_port_spi_csn_high LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, spi_csn_high)
+#define lt_port_spi_transfer LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, spi_transfer)
+#define lt_port_spi_transaction LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, spi_transaction)
+#define lt_port_spi_transfer_buf LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, spi_transfer_buf)
+#define lt_port_delay LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, delay)
+#define lt_port_delay_us LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, delay_us)
+#define lt_port_delay_on_int LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, delay_on_int)
+#define lt_port_crc16 LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, crc16)
+#define lt_port_spi_speed_set LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, spi_speed_set)
+#define lt_port_cache_clean LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, cache_clean)
+#define lt_port_cache_invalidate LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, cache_invalidate)
+#define lt_port_lock LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, lock)
+#define lt_port_unlock LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, unlock)
+#define lt_port_random_bytes LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, random_bytes)
+#define lt_port_l1_write LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, l1_write)
+#define lt_port_l1_read LT_PORT_OPS_CAT(LT_PORT_OPS_PREFIX, l1_read)
+#endif
+
+#ifndef LT_LIBTROPIC_PORT_OPS_H
+#define LT_LIBTROPIC_PORT_OPS_H
+
+/**
+ * @defgroup group_port_ops Port operations bound at runtime
+ * @brief Table of port functions referenced by each handle, so one binary can use several ports.
+ * @details Without LT_PORT_OPS, the port is bound at link time: exactly one port defines the `lt_port_*()`
+ * functions of libtropic_port.h and libtropic calls them directly. With LT_PORT_OPS, libtropic itself defines
+ * `lt_port_*()`, which only call the functions of `lt_l2_state_t.ops`, so each handle can use another port.
+ *
+ * A port supporting LT_PORT_OPS defines LT_PORT_OPS_PREFIX and includes this header before any other one. Its
+ * `lt_port_*()` functions are then compiled under names with the prefix (e.g. `lt_port_unix_tcp_init()`), which
+ * do not collide with other ports, and the port exports a table of them, e.g. `lt_port_unix_tcp_ops`.
+ *
+ * The application sets `h->l2.ops` together with `h->l2.device` before `lt_init()`.
+ * @{
+ */
+
+/**
+ * @file libtropic_port_ops.h
+ * @brief Port operations bound at runtime
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_port.h"
+
+/**
+ * @brief Port functions, each one has the meaning of the `lt_port_()` function of the same name.
+ *
+ * @note Functions used only with an option (e.g. `delay_us` with LT_USE_DELAY_US) can be NULL. Then missing
+ * `spi_transaction` and `spi_transfer_buf` are emulated by the other functions, missing `delay_us` and `delay_on_int`
+ * fall back to `delay`, missing `crc16` to the software CRC16, missing `lock`, `unlock` and cache maintenance do
+ * nothing and missing `spi_speed_set` fails.
+ */
+typedef struct lt_port_ops_t {
+    /** @brief See `lt_port_init()`, mandatory */
+    lt_ret_t (*init)(lt_l2_state_t *s2);
+    /** @brief See `lt_port_deinit()`, mandatory */
+    lt_ret_t (*deinit)(lt_l2_state_t *s2);
+    /** @brief See `lt_port_spi_csn_low()`, mandatory */
+    lt_ret_t (*spi_csn_low)(lt_l2_state_t *s2);
+    /** @brief See `lt_port_spi_csn_high()`, mandatory */
+    lt_ret_t (*spi_csn_high)(lt_l2_state_t *s2);
+    /** @brief See `lt_port_spi_transfer()`, mandatory */
+    lt_ret_t (*spi_transfer)(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len, uint32_t timeout_ms);
+    /** @brief See `lt_port_spi_transaction()` */
+    lt_ret_t (*spi_transaction)(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                uint32_t timeout_ms);
+    /** @brief See `lt_port_spi_transfer_buf()` */
+    lt_ret_t (*spi_transfer_buf)(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                 uint32_t timeout_ms);
+    /** @brief See `lt_port_delay()`, mandatory */
+    lt_ret_t (*delay)(lt_l2_state_t *s2, uint32_t ms);
+    /** @brief See `lt_port_delay_us()` */
+    lt_ret_t (*delay_us)(lt_l2_state_t *s2, uint32_t us);
+    /** @brief See `lt_port_delay_on_int()` */
+    lt_ret_t (*delay_on_int)(lt_l2_state_t *s2, uint32_t ms);
+    /** @brief See `lt_port_crc16()` */
+    lt_ret_t (*crc16)(lt_l2_state_t *s2, const uint8_t *data, uint16_t len, uint16_t *crc);
+    /** @brief See `lt_port_spi_speed_set()` */
+    lt_ret_t (*spi_speed_set)(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz);
+    /** @brief See `lt_port_cache_clean()` */
+    void (*cache_clean)(lt_l2_state_t *s2, const void *addr, size_t len);
+    /** @brief See `lt_port_cache_invalidate()` */
+    void (*cache_invalidate)(lt_l2_state_t *s2, void *addr, size_t len);
+    /** @brief See `lt_port_lock()` */
+    void (*lock)(lt_l2_state_t *s2);
+    /** @brief See `lt_port_unlock()` */
+    void (*unlock)(lt_l2_state_t *s2);
+    /** @brief See `lt_port_random_bytes()`, mandatory */
+    lt_ret_t (*random_bytes)(lt_l2_state_t *s2, void *buff, size_t count);
+    /** @brief See `lt_port_l1_write()`, mandatory for a port setting `lt_l2_state_t.l1_offload` */
+    lt_ret_t (*l1_write)(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt, uint32_t timeout_ms);
+    /** @brief See `lt_port_l1_read()`, mandatory for a port setting `lt_l2_state_t.l1_offload` */
+    lt_ret_t (*l1_read)(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms);
+} lt_port_ops_t;
+
+/** @} */  // end of group_port_ops
+
+#endif
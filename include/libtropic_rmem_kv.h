@@ -0,0 +1,155 @@
+#ifndef LIBTROPIC_RMEM_KV_H
+#define LIBTROPIC_RMEM_KV_H
+
+/**
+ * @defgroup libtropic_rmem_kv libtropic R-memory key-value store
+ * @brief Named objects of any size stored in a range of User Data slots of R-memory
+ * @details Each object occupies consecutive slots. Its first slot starts with a header holding the object's name,
+ * size and sequence number, the rest of the object follows. One slot of the range holds an index of all objects, so
+ * the store is mounted by reading a single slot. Objects are then located by an index kept in RAM, reading an object
+ * costs only reads of its own slots.
+ *
+ * The index slot is not rewritten on each update. The first update after mount or after `lt_rmem_kv_sync()`
+ * only erases it, and it is written again by `lt_rmem_kv_sync()`. When the store is mounted without a valid index
+ * slot (e.g. after a reset before the sync), the index is rebuilt by reading all slots of the range.
+ *
+ * The store uses only the public libtropic API, it is not protected by any lock.
+ * @{
+ */
+
+/**
+ * @file libtropic_rmem_kv.h
+ * @brief R-memory key-value store declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Maximal length of object's name */
+#define LT_RMEM_KV_NAME_LEN_MAX 32
+
+/** @brief Maximal number of objects in one store, limited by size of the index slot */
+#define LT_RMEM_KV_ENTRIES_MAX 47
+
+/**
+ * @brief Key-value store mounted by `lt_rmem_kv_mount()`, its content is private.
+ */
+typedef struct lt_rmem_kv_t {
+    /** @private @brief Device's handle */
+    lt_handle_t *h;
+    /** @private @brief First slot of the range, holds the index */
+    uint16_t first_slot;
+    /** @private @brief Number of slots of the range */
+    uint16_t slots_cnt;
+    /** @private @brief Sequence number of the next written object */
+    uint32_t next_seq;
+    /** @private @brief Nonzero when index slot matches the index in RAM */
+    uint8_t index_synced;
+    /** @private @brief Number of valid entries */
+    uint8_t entries_cnt;
+    /** @private @brief Bit mask of used slots, relative to `first_slot` */
+    uint32_t used[(R_MEM_DATA_SLOT_MAX + 1) / 32];
+    /** @private @brief Index of objects */
+    struct {
+        /** Hash of the name */
+        uint32_t name_hash;
+        /** First slot of the object */
+        uint16_t first_slot;
+        /** Size of object's data */
+        uint16_t data_len;
+        /** Number of slots of the object */
+        uint8_t obj_slots;
+    } entries[LT_RMEM_KV_ENTRIES_MAX];
+} lt_rmem_kv_t;
+
+/**
+ * @brief Erases all slots of the range, so an empty store can be mounted there
+ *
+ * @param h           Device's handle
+ * @param first_slot  First slot of the range
+ * @param slots_cnt   Number of slots of the range, at least 2
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_kv_format(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt);
+
+/**
+ * @brief Mounts store in the range of slots, reading its index slot or, when it is not valid, all slots of the range
+ *
+ * @param kv          Store
+ * @param h           Device's handle with established secure session, must stay valid while the store is used
+ * @param first_slot  First slot of the range
+ * @param slots_cnt   Number of slots of the range, at least 2
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_kv_mount(lt_rmem_kv_t *kv, lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt);
+
+/**
+ * @brief Reads object
+ *
+ * @param kv          Mounted store
+ * @param name        NUL terminated name of the object
+ * @param buff        Buffer for object's data
+ * @param max_len     Size of the buffer
+ * @param len         Size of object's data
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_NOT_FOUND Object does not exist
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_kv_get(lt_rmem_kv_t *kv, const char *name, uint8_t *buff, const uint16_t max_len, uint16_t *len);
+
+/**
+ * @brief Creates or replaces object
+ * @details New content is written into free slots before the old content is erased, its first slot with the header
+ * last. A reset in between leaves either the old content only or both complete contents, which are resolved by the
+ * sequence number when the index is rebuilt.
+ *
+ * @param kv          Mounted store
+ * @param name        NUL terminated name of the object, at most LT_RMEM_KV_NAME_LEN_MAX characters
+ * @param data        Object's data
+ * @param len         Size of object's data
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_kv_put(lt_rmem_kv_t *kv, const char *name, const uint8_t *data, const uint16_t len);
+
+/**
+ * @brief Deletes object
+ *
+ * @param kv          Mounted store
+ * @param name        NUL terminated name of the object
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_NOT_FOUND Object does not exist
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_kv_delete(lt_rmem_kv_t *kv, const char *name);
+
+/**
+ * @brief Writes index into the index slot, when it was changed since mount or since the last sync
+ *
+ * @param kv          Mounted store
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t lt_rmem_kv_sync(lt_rmem_kv_t *kv);
+
+/** @} */  // end of libtropic_rmem_kv group
+
+#endif
@@ -0,0 +1,328 @@
+import argparse
+import json
+import math
+import pathlib
+import random
+import statistics
+import sys
+
+# Metrics compared by default for each kind of result (docs/other/benchmarks.md), --metrics overrides them.
+DEFAULT_METRICS = {
+    "bench": ["p50_us", "p90_us", "p99_us", "ops_per_sec"],
+    "microbench": ["cycles", "min_cycles"],
+    "scale": ["p50_us", "p99_us", "ops_per_sec", "cpu_per_op_us"],
+    "soak": ["p50_us", "p99_us", "p999_us"],
+}
+
+# Metrics where a higher value is better, for all the others a lower value is better.
+HIGHER_IS_BETTER = {"ops_per_sec", "achieved_rate"}
+
+# Exact distribution of Mann-Whitney U is computed up to this size of both samples, normal approximation above it.
+MWU_EXACT_MAX = 20
+
+def scenario_records(result: dict) -> list:
+    """Returns (kind, key, result) of the scenarios in one JSON object printed by a benchmark."""
+    if "bench" in result:
+        return [("bench", f"{result['bench']}/{result['size']}", result)]
+    if "microbench" in result:
+        return [("microbench", f"microbench:{result['microbench']}/{result['size']}", result)]
+    if "scale" in result:
+        return [("scale", f"scale:{result['scale']}/{result['chips']}", result)]
+    if "soak" in result:
+        return [("soak", f"soak:{op}", stats) for op, stats in result["soak"].get("ops", {}).items()]
+    return []
+
+def parse_run(path: pathlib.Path) -> list:
+    """
+    Returns results of one run: a log with JSON lines of lt_bench, lt_microbench, lt_scale_bench or lt_soak, a run
+    stored by lt_test_runner --bench-results, or model_scale_bench.json.
+    """
+    text = path.read_text(errors="replace")
+    try:
+        document = json.loads(text)
+    except json.JSONDecodeError:
+        document = None
+
+    objects = []
+    if isinstance(document, dict) and "tolerances" in document:
+        # Baselines hold only the metrics checked against tolerances, of one run
+        print(f"Skipping {path}: baseline of tolerance checks, not a run.")
+    elif isinstance(document, dict) and "scenarios" in document:
+        objects = list(document["scenarios"].values())
+    elif isinstance(document, dict) and "results" in document:
+        objects = document["results"]
+    else:
+        for line in text.splitlines():
+            # Lines of serial output may have a prefix
+            start = line.find("{")
+            if start < 0:
+                continue
+            try:
+                objects.append(json.loads(line[start:]))
+            except json.JSONDecodeError:
+                continue
+
+    records = []
+    for obj in objects:
+        if isinstance(obj, dict):
+            records += scenario_records(obj)
+    return records
+
+def load_result_set(paths: list, metrics: list) -> dict:
+    """
+    Returns samples of the result set keyed by scenario: its kind, values of each metric (one per run of the
+    scenario) and the number of failed iterations. Directories are searched for *.json and *.log files.
+    """
+    files = []
+    for path in paths:
+        if path.is_dir():
+            files += sorted(p for p in path.rglob("*") if p.suffix in (".json", ".log") and p.is_file())
+        else:
+            files.append(path)
+
+    scenarios = {}
+    for path in files:
+        for kind, key, result in parse_run(path):
+            scenario = scenarios.setdefault(key, {"kind": kind, "samples": {}, "errors": 0})
+            scenario["errors"] += result.get("errors", 0)
+            for metric in (metrics or DEFAULT_METRICS[kind]):
+                if metric in result:
+                    scenario["samples"].setdefault(metric, []).append(float(result[metric]))
+    return scenarios
+
+def slowdown(base: float, cand: float, metric: str) -> float:
+    """Returns relative slowdown of the candidate, positive when it is worse, negative when it is better."""
+    if metric in HIGHER_IS_BETTER:
+        return base / cand - 1.0 if cand else math.inf
+    return cand / base - 1.0 if base else math.inf
+
+def bootstrap_ci(base: list, cand: list, metric: str, confidence: float, resamples: int, rng) -> tuple:
+    """Returns percentile bootstrap interval of the slowdown of medians."""
+    values = []
+    for _ in range(resamples):
+        b = statistics.median(rng.choices(base, k=len(base)))
+        c = statistics.median(rng.choices(cand, k=len(cand)))
+        values.append(slowdown(b, c, metric))
+    values.sort()
+    alpha = 1.0 - confidence
+    low = values[int(math.floor(alpha / 2 * (resamples - 1)))]
+    high = values[int(math.ceil((1 - alpha / 2) * (resamples - 1)))]
+    return low, high
+
+def mann_whitney_p(a: list, b: list) -> float:
+    """Returns two-sided p-value of Mann-Whitney U test of the two samples."""
+    n1, n2 = len(a), len(b)
+    combined = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    # Average ranks of ties
+    ranks = [0.0] * len(combined)
+    ties = []
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        ties.append(j - i + 1)
+        i = j + 1
+    u1 = sum(r for r, (_, group) in zip(ranks, combined) if group == 0) - n1 * (n1 + 1) / 2
+    u = min(u1, n1 * n2 - u1)
+
+    if max(ties) == 1 and n1 <= MWU_EXACT_MAX and n2 <= MWU_EXACT_MAX:
+        # counts[i][j][u]: orderings of i values of a and j values of b with statistic u
+        counts = [[[1] if i == 0 or j == 0 else None for j in range(n2 + 1)] for i in range(n1 + 1)]
+        for i in range(1, n1 + 1):
+            for j in range(1, n2 + 1):
+                # The largest value is either from a (greater than all j values of b) or from b
+                from_a, from_b = counts[i - 1][j], counts[i][j - 1]
+                dist = [0] * (i * j + 1)
+                for k, c in enumerate(from_a):
+                    dist[k + j] += c
+                for k, c in enumerate(from_b):
+                    dist[k] += c
+                counts[i][j] = dist
+        dist = counts[n1][n2]
+        return min(1.0, 2 * sum(dist[:int(u) + 1]) / sum(dist))
+
+    n = n1 + n2
+    sigma = math.sqrt(n1 * n2 / 12 * ((n + 1) - sum(t ** 3 - t for t in ties) / (n * (n - 1))))
+    if sigma == 0:
+        return 1.0
+    z = max(0.0, abs(u1 - n1 * n2 / 2) - 0.5) / sigma
+    return math.erfc(z / math.sqrt(2))
+
+def compare(base: dict, cand: dict, args, rng) -> list:
+    """Returns one row for each metric of each scenario of both sets."""
+    rows = []
+    for key in sorted(base.keys() | cand.keys()):
+        if key not in cand:
+            rows.append({"scenario": key, "metric": "", "verdict": "MISSING"})
+            continue
+        if key not in base:
+            rows.append({"scenario": key, "metric": "", "verdict": "NEW"})
+            continue
+        if cand[key]["errors"]:
+            rows.append({"scenario": key, "metric": "errors", "cand": cand[key]["errors"], "verdict": "ERRORS"})
+        for metric, b in base[key]["samples"].items():
+            c = cand[key]["samples"].get(metric)
+            if not c:
+                continue
+            row = {"scenario": key, "metric": metric, "base": statistics.median(b), "cand": statistics.median(c),
+                   "n_base": len(b), "n_cand": len(c)}
+            # Metrics left at 0 (e.g. latencies without platform clocks, requests without LT_STATS) are not compared
+            if row["base"] == 0 and row["cand"] == 0:
+                continue
+            row["delta"] = slowdown(row["base"], row["cand"], metric)
+            if math.isinf(row["delta"]):
+                # Relative change from 0 is not defined
+                del row["delta"]
+            if len(b) < args.min_runs or len(c) < args.min_runs or "delta" not in row:
+                row["verdict"] = "?"
+                rows.append(row)
+                continue
+            row["ci_low"], row["ci_high"] = bootstrap_ci(b, c, metric, args.confidence, args.resamples, rng)
+            row["p"] = mann_whitney_p(b, c)
+            # Change is reported when both tests agree on it and it is larger than the threshold
+            significant = row["p"] < 1.0 - args.confidence and (row["ci_low"] > 0 or row["ci_high"] < 0)
+            if significant and row["delta"] > args.threshold:
+                row["verdict"] = "SLOWER"
+            elif significant and row["delta"] < -args.threshold:
+                row["verdict"] = "FASTER"
+            else:
+                row["verdict"] = "~"
+            rows.append(row)
+    return rows
+
+def format_row(row: dict) -> list:
+    """Returns cells of the summary table for one row."""
+    def number(v):
+        return "" if v is None else f"{v:.6g}" if isinstance(v, float) else str(v)
+    delta = f"{row['delta']:+.1%}" if "delta" in row else ""
+    ci = f"[{row['ci_low']:+.1%}, {row['ci_high']:+.1%}]" if "ci_low" in row else ""
+    p = f"{row['p']:.3f}" if "p" in row else ""
+    runs = f"{row['n_base']}/{row['n_cand']}" if "n_base" in row else ""
+    return [row["scenario"], row["metric"], number(row.get("base")), number(row.get("cand")), delta, ci, p, runs,
+            row["verdict"]]
+
+def print_table(rows: list, markdown: bool, only_changes: bool) -> None:
+    header = ["scenario", "metric", "base", "cand", "slowdown", "CI", "p", "runs", "verdict"]
+    cells = [format_row(row) for row in rows if not only_changes or row["verdict"] not in ("~", "?")]
+    if markdown:
+        print("| " + " | ".join(header) + " |")
+        print("|" + "|".join("---" for _ in header) + "|")
+        for line in cells:
+            print("| " + " | ".join(line) + " |")
+        return
+    widths = [max(len(line[i]) for line in cells + [header]) for i in range(len(header))]
+    for line in [header] + cells:
+        print("  ".join(cell.ljust(width) if i < 2 else cell.rjust(width)
+                        for i, (cell, width) in enumerate(zip(line, widths))))
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        prog = "bench_compare.py",
+        description = "Compares results of lt_bench, lt_microbench, lt_scale_bench or lt_soak of repeated runs, "
+                      "tells significant slowdowns from noise."
+    )
+
+    parser.add_argument(
+        "-b", "--baseline",
+        help="Logs or stored runs of the baseline, directories are searched for *.json and *.log files.",
+        type=pathlib.Path,
+        nargs="+",
+        required=True
+    )
+
+    parser.add_argument(
+        "-c", "--candidate",
+        help="Logs or stored runs of the candidate, the same as for --baseline.",
+        type=pathlib.Path,
+        nargs="+",
+        required=True
+    )
+
+    parser.add_argument(
+        "--metrics",
+        help="Comma separated metrics compared in all scenarios, default are latency percentiles and throughput "
+             "of each kind of result.",
+        type=str
+    )
+
+    parser.add_argument(
+        "--threshold",
+        help="Smallest relative change flagged as a slowdown or improvement, e.g. 0.05 for 5 %%.",
+        type=float,
+        default=0.05
+    )
+
+    parser.add_argument(
+        "--confidence",
+        help="Confidence level of the bootstrap interval, 1 - confidence is the significance level of the test.",
+        type=float,
+        default=0.95
+    )
+
+    parser.add_argument(
+        "--resamples",
+        help="Number of bootstrap resamples.",
+        type=int,
+        default=2000
+    )
+
+    parser.add_argument(
+        "--min-runs",
+        help="Fewest runs of a scenario in each set to test its change, with fewer runs only the change is shown.",
+        type=int,
+        default=4
+    )
+
+    parser.add_argument(
+        "--seed",
+        help="Seed of bootstrap resampling, the same seed gives the same intervals.",
+        type=int,
+        default=0
+    )
+
+    parser.add_argument(
+        "--markdown",
+        help="Print the summary table in Markdown, e.g. for release reviews.",
+        action="store_true"
+    )
+
+    parser.add_argument(
+        "--only-changes",
+        help="Print only rows with a significant change, missing scenarios or errors.",
+        action="store_true"
+    )
+
+    parser.add_argument(
+        "-o", "--output",
+        help="Path of a JSON file the rows of the comparison are saved to.",
+        type=pathlib.Path
+    )
+
+    args = parser.parse_args()
+
+    if not 0 < args.confidence < 1 or args.resamples < 1 or args.min_runs < 2:
+        print("Confidence must be between 0 and 1, at least 1 resample and 2 runs are needed.")
+        sys.exit(1)
+
+    metrics = args.metrics.split(",") if args.metrics else None
+    base = load_result_set(args.baseline, metrics)
+    cand = load_result_set(args.candidate, metrics)
+    if not base or not cand:
+        print("No benchmark results found in " + ("baseline." if not base else "candidate."))
+        sys.exit(1)
+
+    rows = compare(base, cand, args, random.Random(args.seed))
+    print_table(rows, args.markdown, args.only_changes)
+
+    if args.output is not None:
+        with args.output.open("w") as f:
+            json.dump({"confidence": args.confidence, "threshold": args.threshold, "rows": rows}, f, indent=4)
+            f.write("\n")
+
+    regressions = [row for row in rows if row["verdict"] in ("SLOWER", "MISSING", "ERRORS")]
+    print(f"{len(regressions)} regressed and {sum(row['verdict'] == 'FASTER' for row in rows)} improved metrics in "
+          f"{len(base.keys() | cand.keys())} scenarios.")
+    sys.exit(1 if regressions else 0)
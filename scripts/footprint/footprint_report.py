@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# This script reports the static footprint of libtropic built with -DLT_FOOTPRINT=ON (target lt_footprint).
+#
+# Sizes of structures are read by nm from lt_footprint_sizes.c.o, where each one is the size of an array
+# lt_footprint_size__<name>. Stack usage of functions is read from the .su files written by GCC (-fstack-usage)
+# next to the object files of libtropic. The report is printed and optionally written as JSON, so it can be
+# compared across releases.
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+SIZE_PREFIX = "lt_footprint_size__"
+
+
+def read_sizes(nm, obj):
+    out = subprocess.run([nm, "--print-size", obj], check=True, capture_output=True, text=True).stdout
+    sizes = {}
+    for line in out.splitlines():
+        fields = line.split()
+        # Defined symbols have address, size, type and name
+        if len(fields) == 4 and fields[3].startswith(SIZE_PREFIX):
+            sizes[fields[3][len(SIZE_PREFIX) :]] = int(fields[1], 16)
+    return sizes
+
+
+def read_stack(su_dir):
+    stack = {}
+    for root, _, files in os.walk(su_dir):
+        for name in sorted(files):
+            if not name.endswith(".su"):
+                continue
+            with open(os.path.join(root, name)) as f:
+                for line in f:
+                    # <file>:<line>:<column>:<function>\t<bytes>\t<qualifiers>
+                    fields = line.rstrip("\n").split("\t")
+                    if len(fields) != 3:
+                        continue
+                    location, used, kind = fields
+                    src, func = location.split(":")[0], location.split(":")[-1]
+                    funcs = stack.setdefault(os.path.basename(src), {})
+                    funcs[func] = {"bytes": int(used), "kind": kind}
+    return stack
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report sizes of structures and stack usage of libtropic")
+    parser.add_argument("--nm", default="nm", help="nm of the toolchain")
+    parser.add_argument("--sizes", required=True, help="object file compiled from lt_footprint_sizes.c")
+    parser.add_argument("--su-dir", required=True, help="directory with .su files of libtropic")
+    parser.add_argument("--json", help="JSON report to write")
+    parser.add_argument("--top", type=int, default=10, help="number of functions with the largest stack to print")
+    parser.add_argument("--config", action="append", default=[], help="build option as NAME=VALUE")
+    args = parser.parse_args()
+
+    config = dict(c.split("=", 1) for c in args.config)
+    sizes = read_sizes(args.nm, args.sizes)
+    stack = read_stack(args.su_dir)
+    if not stack:
+        print(f"No .su files in {args.su_dir}, is the compiler GCC?", file=sys.stderr)
+
+    print("Options:")
+    for name, value in config.items():
+        print(f"  {name:<24} {value}")
+    print("Sizes (B):")
+    for name, size in sizes.items():
+        print(f"  {name:<24} {size:>8}")
+    print("Largest stack frame per source file (B):")
+    for src, funcs in sorted(stack.items()):
+        func, info = max(funcs.items(), key=lambda f: f[1]["bytes"])
+        print(f"  {src:<32} {info['bytes']:>6}  {func} ({info['kind']})")
+    print("Largest stack frames (B):")
+    frames = [(info["bytes"], src, func, info["kind"]) for src, funcs in stack.items() for func, info in funcs.items()]
+    for used, src, func, kind in sorted(frames, reverse=True)[: args.top]:
+        print(f"  {used:>6}  {func} ({src}, {kind})")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"config": config, "sizes": sizes, "stack": stack}, f, indent=2, sort_keys=True)
+        print(f"Report written to {args.json}")
+
+
+if __name__ == "__main__":
+    main()
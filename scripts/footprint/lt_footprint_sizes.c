@@ -0,0 +1,22 @@
+/**
+ * @file lt_footprint_sizes.c
+ * @brief Sizes of libtropic structures under the selected options, read by footprint_report.py
+ * @author Tropic Square s.r.o.
+ *
+ * Each size is the size of an array symbol, so it is read from the object file by `nm --print-size` also when
+ * libtropic is cross-compiled and the object can not be executed.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_common.h"
+
+#define LT_FOOTPRINT_SIZE(name, size) const char lt_footprint_size__##name[size] = {0};
+
+LT_FOOTPRINT_SIZE(lt_handle_t, sizeof(lt_handle_t))
+LT_FOOTPRINT_SIZE(lt_l2_state_t, sizeof(lt_l2_state_t))
+LT_FOOTPRINT_SIZE(lt_l3_state_t, sizeof(lt_l3_state_t))
+LT_FOOTPRINT_SIZE(session_state_t, sizeof(session_state_t))
+LT_FOOTPRINT_SIZE(lt_cert_store_t, sizeof(lt_cert_store_t))
+LT_FOOTPRINT_SIZE(LT_SIZE_OF_L3_BUFF, LT_SIZE_OF_L3_BUFF)
+LT_FOOTPRINT_SIZE(L2_MAX_FRAME_SIZE, L2_MAX_FRAME_SIZE)
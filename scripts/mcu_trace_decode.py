@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# This script decodes trace and log messages streamed from an MCU by hal/port/cortex_m/libtropic_port_cortex_m_trace.c.
+#
+# Input is either a raw ITM stream captured from SWO (e.g. by OpenOCD `tpiu config internal <file> uart off ...`),
+# from which trace and log are split by their stimulus ports, or data of RTT up-buffers saved to files
+# (e.g. by `JLinkRTTLogger`).
+# Trace is a sequence of dumps written by lt_trace_dump_new(), each decoded by trace_dump.py, log is text.
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from trace_dump import EVENT, HEADER, MAGIC, decode, format_events  # noqa: E402
+
+
+def itm_split(data):
+    """Returns payload of software stimulus packets of the raw ITM stream by the port."""
+    ports = {}
+    i = 0
+    while i < len(data):
+        b = data[i]
+        if b == 0x00:
+            # Synchronization packet is a run of zeros terminated by 0x80
+            i += 1
+            while i < len(data) and data[i] == 0x00:
+                i += 1
+            i += 1
+        elif b == 0x70:
+            # Overflow, data written meanwhile are lost
+            i += 1
+        elif (b & 0x03) == 0:
+            # Timestamp or extension packet, continued while bit 7 is set
+            i += 1
+            if b & 0x80:
+                while i < len(data) and data[i] & 0x80:
+                    i += 1
+                i += 1
+        else:
+            size = {1: 1, 2: 2, 3: 4}[b & 0x03]
+            payload = data[i + 1:i + 1 + size]
+            # Bit 2 marks hardware source packets (DWT), which carry no data of the application
+            if not b & 0x04:
+                ports.setdefault(b >> 3, bytearray()).extend(payload)
+            i += 1 + size
+    return ports
+
+
+def trace_dumps(data):
+    """Yields (lost, events) of dumps in the stream, resynchronized on the magic after lost data."""
+    pos = 0
+    while True:
+        pos = data.find(MAGIC, pos)
+        if pos < 0 or len(data) - pos < HEADER.size:
+            return
+        _, _, payload_size, _, cnt, _ = HEADER.unpack_from(data, pos)
+        size = HEADER.size + cnt * (EVENT.size + payload_size)
+        try:
+            yield decode(data[pos:pos + size])
+            pos += size
+        except ValueError:
+            pos += len(MAGIC)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Decode libtropic trace and log streamed over ITM or RTT.")
+    parser.add_argument("input", nargs="?", help="raw ITM stream captured from SWO")
+    parser.add_argument("--trace-port", type=int, default=0, help="stimulus port of the trace (default 0)")
+    parser.add_argument("--log-port", type=int, default=1, help="stimulus port of the log (default 1)")
+    parser.add_argument("--rtt-trace", help="data of RTT up-buffer with the trace")
+    parser.add_argument("--rtt-log", help="data of RTT up-buffer with the log")
+    args = parser.parse_args()
+
+    trace = bytearray()
+    log = bytearray()
+    if args.input:
+        with open(args.input, "rb") as f:
+            ports = itm_split(f.read())
+        trace += ports.get(args.trace_port, b"")
+        log += ports.get(args.log_port, b"")
+    if args.rtt_trace:
+        with open(args.rtt_trace, "rb") as f:
+            trace += f.read()
+    if args.rtt_log:
+        with open(args.rtt_log, "rb") as f:
+            log += f.read()
+    if not (args.input or args.rtt_trace or args.rtt_log):
+        parser.error("no input given")
+
+    for lost, events in trace_dumps(bytes(trace)):
+        if lost or events:
+            print("\n".join(format_events(lost, events)))
+    if log:
+        print("--- log ---")
+        sys.stdout.write(log.decode("utf-8", errors="replace"))
@@ -0,0 +1,153 @@
+import argparse
+import json
+import pathlib
+import subprocess
+import sys
+
+from model_test_runner import model_ports_env, start_model_servers, stop_model_server
+
+def parse_scale_results(log_path: pathlib.Path) -> list:
+    """Returns results of lt_scale_bench policies from its log."""
+    results = []
+    with log_path.open("r") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            try:
+                result = json.loads(line)
+            except json.JSONDecodeError:
+                continue
+            if "scale" in result:
+                results.append(result)
+    return results
+
+def print_table(results: list) -> None:
+    """Prints results with speedup and efficiency against the run of the policy with the fewest chips."""
+    reference = {}
+    for result in sorted(results, key=lambda r: r["chips"]):
+        reference.setdefault(result["scale"], result)
+
+    print(f"{'policy':<8}{'chips':>6}{'ops/s':>9}{'speedup':>9}{'effic.':>8}{'p50 us':>10}{'p99 us':>10}"
+          f"{'cpu %':>7}{'cpu/op us':>11}{'contended':>11}{'errors':>8}")
+    for result in sorted(results, key=lambda r: (r["scale"], r["chips"])):
+        ref = reference[result["scale"]]
+        speedup = result["ops_per_sec"] / ref["ops_per_sec"] if ref["ops_per_sec"] else 0.0
+        # Efficiency 1.0 is linear scaling, it drops when the host (CPU, locks) and not the chips limits throughput
+        efficiency = speedup * ref["chips"] / result["chips"]
+        cpu_load = 100 * result["cpu_us"] / result["wall_us"] if result["wall_us"] else 0
+        print(f"{result['scale']:<8}{result['chips']:>6}{result['ops_per_sec']:>9}{speedup:>9.2f}{efficiency:>8.2f}"
+              f"{result['p50_us']:>10}{result['p99_us']:>10}{cpu_load:>7.0f}{result['cpu_per_op_us']:>11}"
+              f"{result['lock_contended']:>11}{result['errors']:>8}")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        prog = "model_scale_bench.py",
+        description = "Runs lt_scale_bench against growing number of TROPIC01 model servers and compares how "
+                      "scheduling policies of lt_pool_t scale."
+    )
+
+    parser.add_argument(
+        "-t", "--test",
+        help="Path to the lt_scale_bench executable.",
+        type=pathlib.Path,
+        required=True
+    )
+
+    parser.add_argument(
+        "-c", "--model-cfg",
+        help="Path to the model configuration YAML file.",
+        type=pathlib.Path,
+        required=True
+    )
+
+    parser.add_argument(
+        "-o", "--output-dir",
+        help="Path to the directory where logs and model_scale_bench.json are saved.",
+        type=pathlib.Path,
+        required=True
+    )
+
+    parser.add_argument(
+        "-p", "--port",
+        help="TCP port of the first model server, the others use consecutive ports.",
+        type=int,
+        default=28992
+    )
+
+    parser.add_argument(
+        "-u", "--unix-socket",
+        help="Path of a Unix domain socket the model servers listen on instead of TCP ports, a suffix .<index> is "
+             "appended for each of them.",
+        type=str
+    )
+
+    parser.add_argument(
+        "--chips",
+        help="Comma separated numbers of model servers to run against.",
+        default="1,2,4,8"
+    )
+
+    parser.add_argument(
+        "--jobs",
+        help="Jobs executed by each chip, passed in LT_SCALE_JOBS.",
+        type=int,
+        default=100
+    )
+
+    parser.add_argument(
+        "--op",
+        help="Operation of the jobs, passed in LT_SCALE_OP.",
+        choices=["ecdsa", "ping", "random"],
+        default="ecdsa"
+    )
+
+    parser.add_argument(
+        "--policies",
+        help="Comma separated scheduling policies, passed in LT_SCALE_POLICIES. Default are all policies built "
+             "into lt_scale_bench."
+    )
+
+    args = parser.parse_args()
+
+    output_path: pathlib.Path = args.output_dir
+    output_path.mkdir(parents=True, exist_ok=True)
+
+    results = []
+    ret = 0
+    for chips in [int(n) for n in args.chips.split(",")]:
+        name = f"lt_scale_bench_{chips}"
+        model_processes = start_model_servers(chips, args.port, args.model_cfg, output_path, name,
+                                              args.unix_socket)
+        if model_processes is None:
+            sys.exit(1)
+
+        test_env = model_ports_env(chips, args.port, args.unix_socket)
+        test_env["LT_SCALE_JOBS"] = str(args.jobs)
+        test_env["LT_SCALE_OP"] = args.op
+        if args.policies is not None:
+            test_env["LT_SCALE_POLICIES"] = args.policies
+        test_log_path = output_path.joinpath(name).with_suffix(".log")
+        with test_log_path.open("w") as f:
+            run = subprocess.run(args=[str(args.test)], stdout=f, stderr=f, env=test_env)
+
+        for model_process in model_processes:
+            stop_model_server(model_process)
+
+        if run.returncode != 0:
+            print(f"lt_scale_bench against {chips} chips failed, see {str(test_log_path)}.")
+            ret = 1
+        results += parse_scale_results(test_log_path)
+
+    if not results:
+        print("No results of lt_scale_bench found.")
+        sys.exit(1)
+
+    print_table(results)
+    summary_path = output_path.joinpath("model_scale_bench.json")
+    with summary_path.open("w") as f:
+        json.dump({"op": args.op, "jobs_per_chip": args.jobs, "results": results}, f, indent=4)
+        f.write("\n")
+    print(f"Results saved to {str(summary_path)}.")
+
+    sys.exit(ret)
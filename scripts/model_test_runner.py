@@ -6,19 +6,177 @@ import time
 import sys
 import socket
 import os
+import json
 
-def wait_for_server_start(host="127.0.0.1", port=28992, retry_interval=0.2, max_attempts=10) -> bool:
+# Metrics of lt_bench compared against the baseline and their default tolerances (relative increase).
+# Requests and bytes on the bus are deterministic with the model, so no increase is tolerated.
+BENCH_METRICS = {
+    "requests": 0.0,
+    "bytes": 0.0,
+    "cpu_us": 0.25,
+}
+
+def wait_for_server_start(host="127.0.0.1", port=28992, retry_interval=0.2, max_attempts=10, unix_path=None) -> bool:
     for i in range(max_attempts):
-        with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+        with socket.socket(socket.AF_UNIX if unix_path else socket.AF_INET, socket.SOCK_STREAM) as sock:
             sock.settimeout(1.0)
             try:
-                sock.connect((host, port))
+                sock.connect(unix_path if unix_path else (host, port))
                 return True
-            except (ConnectionRefusedError, socket.timeout):
+            except (ConnectionRefusedError, FileNotFoundError, socket.timeout):
                 time.sleep(retry_interval)
                 print(f"Waiting on server, attempt #{i}")
     return False
 
+def parse_bench_results(log_path: pathlib.Path) -> dict:
+    """Returns results of lt_bench scenarios from its log, keyed by "<bench>/<size>"."""
+    results = {}
+    with log_path.open("r") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            try:
+                result = json.loads(line)
+            except json.JSONDecodeError:
+                continue
+            if "bench" not in result:
+                continue
+            results[f"{result['bench']}/{result['size']}"] = result
+    return results
+
+def save_bench_baseline(baseline_path: pathlib.Path, results: dict, tolerances: dict) -> None:
+    baseline = {
+        "tolerances": tolerances,
+        "scenarios": {
+            key: {metric: result.get(metric, 0) for metric in BENCH_METRICS}
+            for key, result in sorted(results.items())
+        }
+    }
+    with baseline_path.open("w") as f:
+        json.dump(baseline, f, indent=4)
+        f.write("\n")
+
+def compare_bench_baseline(baseline_path: pathlib.Path, results: dict, tolerances: dict) -> bool:
+    """Compares results against the baseline, returns False if some metric regressed."""
+    with baseline_path.open("r") as f:
+        baseline = json.load(f)
+    # Tolerances given on the command line take precedence over the ones stored in the baseline
+    tolerances = {**BENCH_METRICS, **baseline.get("tolerances", {}), **tolerances}
+
+    ok = True
+    for key, expected in baseline["scenarios"].items():
+        if key not in results:
+            print(f"REGRESSION {key}: scenario missing in results")
+            ok = False
+            continue
+        if results[key].get("errors", 0) != 0:
+            print(f"REGRESSION {key}: {results[key]['errors']} failed iterations")
+            ok = False
+        for metric, reference in expected.items():
+            value = results[key].get(metric, 0)
+            limit = reference * (1.0 + tolerances[metric])
+            if value > limit:
+                print(f"REGRESSION {key}: {metric} {value} > {reference} (tolerance {tolerances[metric]:.0%})")
+                ok = False
+            elif value < reference:
+                print(f"IMPROVEMENT {key}: {metric} {value} < {reference}, consider updating the baseline")
+    for key in results.keys() - baseline["scenarios"].keys():
+        print(f"NEW {key}: scenario not in baseline")
+
+    return ok
+
+def start_model_server(port: int, model_cfg_path: pathlib.Path, output_path: pathlib.Path, name: str,
+                       unix_path: str = None):
+    """Starts model server on the port (or the Unix domain socket unix_path) with logs in output_path, returns its
+    process or None if it did not start."""
+    # Get the logging configuration from the model so we can modify it
+    dump_logging_cfg_res = subprocess.run(
+        ["model_server", "dump-logging-cfg"],
+        capture_output=True,
+        text=True,
+        check=True
+    )
+    # Transform the YAML output to a dictionary
+    model_log_cfg = yaml.safe_load(dump_logging_cfg_res.stdout)
+    # Change the default handler to a file
+    model_log_cfg["handlers"]["default"]["class"] = "logging.FileHandler"
+    model_log_cfg["handlers"]["default"]["filename"] = str(output_path.joinpath(f"{name}_model_response").with_suffix(".log"))
+    model_log_cfg["handlers"]["default"]["mode"] = "w"
+    model_log_cfg["handlers"]["default"]["encoding"] = "utf8"
+    # Change logging level to DEBUG
+    model_log_cfg["loggers"]["model"]["level"] = "DEBUG"
+    model_log_cfg["loggers"]["server"]["level"] = "DEBUG"
+    # Disable colors to prevent weird symbols in the .log file
+    model_log_cfg["formatters"]["default"]["use_colors"] = False
+
+    # Each server has its own logging configuration, so tests can run in parallel
+    model_log_cfg_path = output_path.joinpath(f"{name}_model_log_cfg").with_suffix(".yml")
+    with model_log_cfg_path.open("w") as f:
+        yaml.dump(model_log_cfg, f, default_flow_style=False)
+
+    # Start the model server, a Unix domain socket needs a model server providing the unix command
+    if unix_path:
+        if os.path.exists(unix_path):
+            os.unlink(unix_path)
+        transport = ["unix", "-s", unix_path]
+    else:
+        transport = ["tcp", "-p", f"{port}"]
+    model_process = subprocess.Popen(
+        ["model_server"] + transport + [
+            "-c", f"{str(model_cfg_path)}",
+            "-l", f"{str(model_log_cfg_path)}"
+        ],
+        env=os.environ
+    )
+
+    # Wait for model server to start
+    if wait_for_server_start(port=port, unix_path=unix_path) == False:
+        stop_model_server(model_process)
+        return None
+    return model_process
+
+def stop_model_server(model_process) -> None:
+    model_process.terminate()
+    try:
+        model_process.wait(timeout=10)
+    except subprocess.TimeoutExpired:
+        model_process.kill()
+
+def model_socket_paths(count: int, unix_socket: str) -> list:
+    """Returns paths of the Unix domain sockets of count servers, a single server listens on unix_socket itself."""
+    if not unix_socket:
+        return [None] * count
+    return [unix_socket] if count == 1 else [f"{unix_socket}.{i}" for i in range(count)]
+
+def start_model_servers(count: int, port: int, model_cfg_path: pathlib.Path, output_path: pathlib.Path, name: str,
+                        unix_socket: str = None):
+    """Starts count model servers on consecutive ports from port (or on Unix domain sockets derived from unix_socket),
+    returns their processes or None on a failure."""
+    model_processes = []
+    unix_paths = model_socket_paths(count, unix_socket)
+    for i in range(count):
+        # Logs of a single server keep their names from before multiple servers were supported
+        model_process = start_model_server(port + i, model_cfg_path, output_path, name if count == 1 else f"{name}_{i}",
+                                           unix_paths[i])
+        if model_process is None:
+            print(f"Server on {unix_paths[i] or f'port {port + i}'} did not start.")
+            for started in model_processes:
+                stop_model_server(started)
+            return None
+        model_processes.append(model_process)
+    return model_processes
+
+def model_ports_env(count: int, port: int, unix_socket: str = None) -> dict:
+    """Returns environment of a test run against count servers started by start_model_servers()."""
+    env = dict(os.environ, LT_MODEL_PORT=str(port),
+               LT_MODEL_PORTS=",".join(str(port + i) for i in range(count)))
+    if unix_socket:
+        unix_paths = model_socket_paths(count, unix_socket)
+        env["LT_MODEL_SOCKET"] = unix_paths[0]
+        env["LT_MODEL_SOCKETS"] = ",".join(unix_paths)
+    return env
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(
         prog = "test_runner.py",
@@ -39,6 +197,30 @@ if __name__ == "__main__":
         required=True
     )
 
+    parser.add_argument(
+        "-p", "--port",
+        help="TCP port of the model server, passed to the test in LT_MODEL_PORT environment variable. Tests with "
+             "distinct ports can run in parallel.",
+        type=int,
+        default=28992
+    )
+
+    parser.add_argument(
+        "-n", "--models",
+        help="Number of model servers, started on consecutive ports from --port. All their ports are passed to the "
+             "test in LT_MODEL_PORTS environment variable.",
+        type=int,
+        default=1
+    )
+
+    parser.add_argument(
+        "-u", "--unix-socket",
+        help="Path of a Unix domain socket the model server listens on instead of the TCP port, passed to the test in "
+             "LT_MODEL_SOCKET environment variable. Messages cost less than over loopback TCP. With several model "
+             "servers, a suffix .<index> is appended for each of them.",
+        type=str
+    )
+
     parser.add_argument(
         "--use-valgrind",
         help="Runs the test with Valgrind.",
@@ -52,6 +234,26 @@ if __name__ == "__main__":
         required=True
     )
 
+    parser.add_argument(
+        "-b", "--bench-baseline",
+        help="Path to the baseline JSON of lt_bench. When given, results of the benchmark are compared against it "
+             "and the run fails on a regression.",
+        type=pathlib.Path
+    )
+
+    parser.add_argument(
+        "--update-baseline",
+        help="Writes results of the benchmark to the baseline instead of comparing against it.",
+        action="store_true"
+    )
+
+    for metric in BENCH_METRICS:
+        parser.add_argument(
+            f"--tolerance-{metric.replace('_', '-')}",
+            help=f"Tolerated relative increase of {metric} against the baseline, e.g. 0.1 for 10%%.",
+            type=float
+        )
+
     args = parser.parse_args()
 
     # Save args
@@ -59,53 +261,31 @@ if __name__ == "__main__":
     model_cfg_path: pathlib.Path = args.model_cfg
     use_valgrind: bool = args.use_valgrind
     output_path: pathlib.Path = args.output_dir
+    port: int = args.port
+    models: int = args.models
+    unix_socket: str = args.unix_socket
+    bench_baseline_path: pathlib.Path = args.bench_baseline
+    update_baseline: bool = args.update_baseline
+    bench_tolerances = {
+        metric: getattr(args, f"tolerance_{metric}")
+        for metric in BENCH_METRICS
+        if getattr(args, f"tolerance_{metric}") is not None
+    }
     test_name = test_path.stem
 
     # Create destination directory if it doesn't exist yet
     output_path.mkdir(parents=True, exist_ok=True)
 
-    # Get the logging configuration from the model so we can modify it
-    dump_logging_cfg_res = subprocess.run(
-        ["model_server", "dump-logging-cfg"],
-        capture_output=True,
-        text=True,
-        check=True
-    )
-    # Transform the YAML output to a dictionary
-    model_log_cfg = yaml.safe_load(dump_logging_cfg_res.stdout)
-    # Change the default handler to a file
-    model_log_cfg["handlers"]["default"]["class"] = "logging.FileHandler"
-    model_log_cfg["handlers"]["default"]["filename"] = str(output_path.joinpath(f"{test_name}_model_response").with_suffix(".log"))
-    model_log_cfg["handlers"]["default"]["mode"] = "w"
-    model_log_cfg["handlers"]["default"]["encoding"] = "utf8"
-    # Change logging level to DEBUG
-    model_log_cfg["loggers"]["model"]["level"] = "DEBUG"
-    model_log_cfg["loggers"]["server"]["level"] = "DEBUG"
-    # Disable colors to prevent weird symbols in the .log file
-    model_log_cfg["formatters"]["default"]["use_colors"] = False
-
-    model_log_cfg_path = pathlib.Path("model_log_cfg_path.yml")
-    with model_log_cfg_path.open("w") as f:
-        yaml.dump(model_log_cfg, f, default_flow_style=False)
-    
-    # Start the model server
-    model_process = subprocess.Popen(
-        [
-            "model_server", "tcp",
-            "-c", f"{str(model_cfg_path)}",
-            "-l", f"{str(model_log_cfg_path)}"
-        ],
-        env=os.environ
-    )
-
-    # Wait for model server to start
-    if wait_for_server_start() == False:
-        print("Server did not start.")
+    # Start the model servers
+    model_processes = start_model_servers(models, port, model_cfg_path, output_path, test_name, unix_socket)
+    if model_processes is None:
         sys.exit(1)
 
     # Execute the test
+    test_env = model_ports_env(models, port, unix_socket)
     ret = 0
-    with output_path.joinpath(test_name).with_suffix(".log").open("w") as f:
+    test_log_path = output_path.joinpath(test_name).with_suffix(".log")
+    with test_log_path.open("w") as f:
         try: 
             test_cmd = []
             if use_valgrind:
@@ -123,16 +303,26 @@ if __name__ == "__main__":
             subprocess.run(
                 args=test_cmd,
                 stdout=f, stderr=f,
-                env=os.environ,
+                env=test_env,
                 check=True
             )
         except subprocess.CalledProcessError as e:
             ret = e.returncode
 
     # Clean up
-    model_process.terminate()
-    try:
-        model_process.wait(timeout=10)
-    except subprocess.TimeoutExpired:
-        model_process.kill()
+    for model_process in model_processes:
+        stop_model_server(model_process)
+
+    # Compare results of the benchmark against the baseline
+    if bench_baseline_path is not None and ret == 0:
+        bench_results = parse_bench_results(test_log_path)
+        if not bench_results:
+            print("No benchmark results found in the log.")
+            ret = 1
+        elif update_baseline:
+            save_bench_baseline(bench_baseline_path, bench_results, bench_tolerances)
+            print(f"Baseline {str(bench_baseline_path)} updated.")
+        elif not compare_bench_baseline(bench_baseline_path, bench_results, bench_tolerances):
+            ret = 1
+
     sys.exit(ret)
\ No newline at end of file
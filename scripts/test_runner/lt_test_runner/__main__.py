@@ -16,6 +16,7 @@ from argparse import ArgumentParser
 from .lt_test_runner import lt_test_runner
 from .lt_platform_factory import lt_platform_factory
 from .lt_lock_device import lt_lock_device
+from .lt_bench_results import lt_bench_results, BENCH_METRICS
 
 logger = logging.getLogger(__name__)
 
@@ -83,11 +84,56 @@ async def main() -> lt_test_runner.lt_test_result:
         default = 0
     )
 
+    parser.add_argument(
+        "--rtt-channel",
+        help    = "Read the platform output from this SEGGER RTT up-buffer (via OpenOCD) instead of the serial port.",
+        type    = int
+    )
+
+    parser.add_argument(
+        "--rtt-port",
+        help    = "TCP port on which OpenOCD serves the RTT channel. Default 9090.",
+        type    = int,
+        default = 9090
+    )
+
+    parser.add_argument(
+        "--bench-results",
+        help    = "Collect results of lt_bench from the output and store them into this directory, per platform and firmware of the chip. The results are compared against baseline.json of the platform and firmware when it exists.",
+        type    = Path
+    )
+
+    parser.add_argument(
+        "--bench-baseline",
+        help    = "Baseline JSON to compare the benchmark results against instead of the one in --bench-results.",
+        type    = Path
+    )
+
+    parser.add_argument(
+        "--update-baseline",
+        help    = "Write the benchmark results to the baseline instead of comparing against it.",
+        action  = "store_true"
+    )
+
+    for metric in BENCH_METRICS:
+        parser.add_argument(
+            f"--tolerance-{metric.replace('_', '-')}",
+            help    = f"Tolerated relative increase of {metric} against the baseline, e.g. 0.1 for 10%%.",
+            type    = float
+        )
+
     args = parser.parse_args()
     if args.message_timeout < 0:
         parser.error("Message timeout has to be >= 0.")
     if args.total_timeout < 0:
         parser.error("Total timeout has to be >= 0.")
+    if (args.bench_baseline or args.update_baseline) and not args.bench_results:
+        parser.error("Benchmark baseline requires --bench-results.")
+    bench_tolerances = {
+        metric: getattr(args, f"tolerance_{metric}")
+        for metric in BENCH_METRICS
+        if getattr(args, f"tolerance_{metric}") is not None
+    }
 
     if not args.firmware.is_file():
         logger.error("Please provide correct path to firmware.")
@@ -115,15 +161,18 @@ async def main() -> lt_test_runner.lt_test_result:
             return lt_test_runner.lt_test_result.TEST_FAILED
         
         try:
-            tr = lt_test_runner(args.work_dir, args.platform_id, args.mapping_config, args.adapter_config)
+            tr = lt_test_runner(args.work_dir, args.platform_id, args.mapping_config, args.adapter_config,
+                                args.rtt_channel, args.rtt_port)
         except (ValueError):
             logger.error("Failed to initialize test runner.")
             return lt_test_runner.lt_test_result.TEST_FAILED
 
         test_result = lt_test_runner.lt_test_result.TEST_FAILED # The default is failure in case an exception is thrown.
 
+        bench = lt_bench_results() if args.bench_results else None
+
         try:
-            test_result = await tr.run(args.firmware, args.message_timeout, args.total_timeout)
+            test_result = await tr.run(args.firmware, args.message_timeout, args.total_timeout, bench)
         except serial.SerialException as e:
             logger.error(f"Platform serial interface communication error: {str(e)}")
             return lt_test_runner.lt_test_result.TEST_FAILED
@@ -134,6 +183,10 @@ async def main() -> lt_test_runner.lt_test_result:
             logger.info("Received unexpected exception or termination request. Shutting down.")
             raise
         else:
+            if bench is not None and test_result == lt_test_runner.lt_test_result.TEST_PASSED:
+                if not bench.evaluate(args.bench_results, args.platform_id, args.firmware, args.bench_baseline,
+                                      args.update_baseline, bench_tolerances):
+                    return lt_test_runner.lt_test_result.TEST_FAILED
             return test_result
 
 if __name__ == "__main__":
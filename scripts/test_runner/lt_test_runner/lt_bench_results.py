@@ -0,0 +1,139 @@
+import json
+import logging
+import time
+from pathlib import Path
+from typing import Optional
+
+logger = logging.getLogger(__name__)
+
+# Metrics of lt_bench compared against the baseline and their default tolerances (relative increase).
+# Unlike with the model, latencies on real silicon vary a bit between runs, so some increase is tolerated.
+BENCH_METRICS = {
+    "p50_us": 0.10,
+    "p99_us": 0.25,
+    "cpu_us": 0.25,
+}
+
+class lt_bench_results:
+    """Collects results of lt_bench (docs/other/benchmarks.md) from the output of the platform."""
+
+    def __init__(self):
+        # Results of scenarios keyed by "<bench>/<size>"
+        self.results = {}
+        # Firmware versions of the chip, printed by lt_bench before the scenarios
+        self.firmware = None
+
+    def parse_line(self, line: str) -> bool:
+        """Parses one line of the platform output, returns True if it was a JSON line of lt_bench."""
+        start = line.find("{")
+        if start < 0:
+            return False
+        try:
+            result = json.loads(line[start:])
+        except json.JSONDecodeError:
+            return False
+        if "bench_firmware" in result:
+            self.firmware = result["bench_firmware"]
+        elif "bench" in result:
+            self.results[f"{result['bench']}/{result['size']}"] = result
+        else:
+            return False
+        return True
+
+    def firmware_id(self) -> str:
+        """Returns directory name for the firmware of the chip, e.g. "riscv_2.0.0__spect_1.0.0"."""
+        if self.firmware is None:
+            return "unknown_firmware"
+        return f"riscv_{self.firmware.get('riscv', 'unknown')}__spect_{self.firmware.get('spect', 'unknown')}"
+
+    def results_dir(self, root: Path, platform_id: str) -> Path:
+        """Returns directory where results of the board and firmware are stored."""
+        return root / platform_id / self.firmware_id()
+
+    def save(self, root: Path, platform_id: str, firmware_path: Path) -> Path:
+        """Stores results of the run as a new file in results_dir(), returns its path."""
+        out_dir = self.results_dir(root, platform_id)
+        out_dir.mkdir(parents = True, exist_ok = True)
+        timestamp = time.strftime("%Y%m%dT%H%M%SZ", time.gmtime())
+        out_path = out_dir / f"{timestamp}.json"
+        with out_path.open("w") as f:
+            json.dump({
+                "platform": platform_id,
+                "firmware": self.firmware,
+                "elf": str(firmware_path),
+                "timestamp": timestamp,
+                "scenarios": dict(sorted(self.results.items()))
+            }, f, indent = 4)
+            f.write("\n")
+        return out_path
+
+    def save_baseline(self, baseline_path: Path, tolerances: dict) -> None:
+        """Writes the results as the baseline, the same format as baselines of scripts/model_test_runner.py."""
+        baseline_path.parent.mkdir(parents = True, exist_ok = True)
+        baseline = {
+            "firmware": self.firmware,
+            "tolerances": tolerances,
+            "scenarios": {
+                key: {metric: result.get(metric, 0) for metric in BENCH_METRICS}
+                for key, result in sorted(self.results.items())
+            }
+        }
+        with baseline_path.open("w") as f:
+            json.dump(baseline, f, indent = 4)
+            f.write("\n")
+
+    def compare_baseline(self, baseline_path: Path, tolerances: dict) -> bool:
+        """Compares the results against the baseline, returns False if some metric regressed."""
+        with baseline_path.open("r") as f:
+            baseline = json.load(f)
+        if baseline.get("firmware") not in (None, self.firmware):
+            logger.warning(f"Baseline was recorded with firmware {baseline['firmware']}, the chip has {self.firmware}.")
+        # Tolerances given on the command line take precedence over the ones stored in the baseline
+        tolerances = {**BENCH_METRICS, **baseline.get("tolerances", {}), **tolerances}
+
+        ok = True
+        for key, expected in baseline["scenarios"].items():
+            if key not in self.results:
+                logger.error(f"REGRESSION {key}: scenario missing in results")
+                ok = False
+                continue
+            if self.results[key].get("errors", 0) != 0:
+                logger.error(f"REGRESSION {key}: {self.results[key]['errors']} failed iterations")
+                ok = False
+            for metric, reference in expected.items():
+                value = self.results[key].get(metric, 0)
+                limit = reference * (1.0 + tolerances.get(metric, 0.0))
+                if value > limit:
+                    logger.error(f"REGRESSION {key}: {metric} {value} > {reference} "
+                                 f"(tolerance {tolerances.get(metric, 0.0):.0%})")
+                    ok = False
+                elif value < reference:
+                    logger.info(f"IMPROVEMENT {key}: {metric} {value} < {reference}, consider updating the baseline")
+        for key in self.results.keys() - baseline["scenarios"].keys():
+            logger.info(f"NEW {key}: scenario not in baseline")
+
+        return ok
+
+    def evaluate(self, root: Path, platform_id: str, firmware_path: Path, baseline_path: Optional[Path],
+                 update_baseline: bool, tolerances: dict) -> bool:
+        """Stores the results and compares them against the baseline, returns False on a regression.
+
+        Without explicit baseline_path, baseline.json of results_dir() is used, so each board and firmware
+        has its own baseline.
+        """
+        if not self.results:
+            logger.error("No benchmark results found in the platform output.")
+            return False
+
+        logger.info(f"Benchmark results stored to {self.save(root, platform_id, firmware_path)}.")
+        if baseline_path is None:
+            baseline_path = self.results_dir(root, platform_id) / "baseline.json"
+
+        if update_baseline:
+            self.save_baseline(baseline_path, tolerances)
+            logger.info(f"Baseline {baseline_path} updated.")
+            return True
+        if not baseline_path.is_file():
+            logger.warning(f"No baseline {baseline_path}, results are not compared. Create it by --update-baseline.")
+            return True
+        return self.compare_baseline(baseline_path, tolerances)
@@ -87,6 +87,35 @@ class lt_platform(ABC):
 
     async def set_platform_power(self, state: bool):
         await self.openocd_send(f"ftdi set_signal PLTF_PWR_EN {int(state)}\n")
+
+    async def rtt_start(self, channel: int, tcp_port: int, timeout: float = 10) -> bool:
+        """Finds RTT control block of the running firmware and serves its up-buffer on the TCP port."""
+        address, size = self.get_rtt_search_range()
+        await self.openocd_send(f"rtt setup {address:#x} {size:#x} \"SEGGER RTT\"\n")
+        deadline = asyncio.get_running_loop().time() + timeout
+        # The control block exists only after the firmware initialized RTT, so the search is repeated
+        while True:
+            await self.openocd_send("rtt start\n")
+            try:
+                # OpenOCD reports "rtt: Control block found at 0x..." or "rtt: No control block found"
+                ocd_line = ""
+                while not ("found at" in ocd_line or "No control block" in ocd_line):
+                    ocd_line = await self.openocd_recv(max(0.1, deadline - asyncio.get_running_loop().time()))
+            except asyncio.TimeoutError:
+                return False
+            if "found at" in ocd_line:
+                break
+            if asyncio.get_running_loop().time() > deadline:
+                return False
+            await self.openocd_send("rtt stop\n")
+            await asyncio.sleep(0.2)
+        await self.openocd_send(f"rtt server start {tcp_port} {channel}\n")
+        logger.info(f"RTT channel {channel} served on port {tcp_port}.")
+        return True
+
+    async def rtt_stop(self, tcp_port: int):
+        await self.openocd_send(f"rtt server stop {tcp_port}\n")
+        await self.openocd_send("rtt stop\n")
     ####################################################
     # Platform-specific OpenOCD functions
     # 
@@ -105,6 +134,11 @@ class lt_platform(ABC):
     def reset(self):
         pass
 
+    @abstractmethod
+    def get_rtt_search_range(self):
+        """Returns (address, size) of RAM searched for RTT control block."""
+        pass
+
     # @abstractmethod
     # def reset(self):
     #     pass
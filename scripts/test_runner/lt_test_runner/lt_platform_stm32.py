@@ -22,7 +22,15 @@ class lt_platform_stm32(lt_platform):
 class lt_platform_stm32_f4(lt_platform_stm32):
     def get_openocd_launch_params(self):
         return ["-f", "target/stm32f4x.cfg"]
+
+    def get_rtt_search_range(self):
+        # SRAM1, SRAM2 and SRAM3
+        return (0x20000000, 0x30000)
     
 class lt_platform_stm32_l4(lt_platform_stm32):
     def get_openocd_launch_params(self):
-        return ["-f", "target/stm32l4x.cfg", "-c", "transport select swd"]
\ No newline at end of file
+        return ["-f", "target/stm32l4x.cfg", "-c", "transport select swd"]
+
+    def get_rtt_search_range(self):
+        # SRAM1 followed by SRAM2
+        return (0x20000000, 0x10000)
\ No newline at end of file
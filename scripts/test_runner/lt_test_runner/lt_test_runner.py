@@ -2,12 +2,15 @@ import logging
 from enum import Enum
 from pathlib import Path
 import serial
+import socket
 import time
+from typing import Optional
 
 from .lt_platform_factory import lt_platform_factory
 from .lt_platform import lt_platform
 from .lt_environment_tools import lt_environment_tools
 from .lt_openocd_launcher import lt_openocd_launcher
+from .lt_bench_results import lt_bench_results
 
 # Generic logger. Used for all logging outside serial communication.
 logger = logging.getLogger(__name__)
@@ -33,13 +36,50 @@ if not logger_platform.hasHandlers():
     logger_platform.addHandler(logger_platform_console_handler)
 
 
+class lt_rtt_reader:
+    """Reads output of the platform from RTT channel served by OpenOCD over TCP, like a serial port."""
+
+    def __init__(self, port: int, timeout: Optional[float]):
+        self.sock = socket.create_connection(("localhost", port), timeout = 5)
+        self.sock.settimeout(timeout)
+        self.buffer = b""
+        self.is_open = True
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.sock.close()
+        self.is_open = False
+
+    def read_until(self, expected: bytes) -> bytes:
+        """Returns data up to and including expected, or what was received before the timeout."""
+        while expected not in self.buffer:
+            try:
+                data = self.sock.recv(4096)
+            except socket.timeout:
+                break
+            if not data:
+                self.is_open = False
+                break
+            self.buffer += data
+        end = self.buffer.find(expected)
+        end = len(self.buffer) if end < 0 else end + len(expected)
+        line, self.buffer = self.buffer[:end], self.buffer[end:]
+        return line
+
+
 class lt_test_runner:
     class lt_test_result(Enum):
         TEST_FAILED = -1
         TEST_PASSED = 0
 
-    def __init__(self, working_dir: Path, platform_id: str, mapping_config_path: Path, adapter_config_path: Path):
+    def __init__(self, working_dir: Path, platform_id: str, mapping_config_path: Path, adapter_config_path: Path,
+                 rtt_channel: Optional[int] = None, rtt_port: int = 9090):
         self.working_dir = working_dir
+        # Output is read from RTT channel instead of the serial port when given
+        self.rtt_channel = rtt_channel
+        self.rtt_port = rtt_port
         logger.info("Preparing environment...")
         self.working_dir.mkdir(exist_ok = True, parents = True)
 
@@ -55,13 +95,26 @@ class lt_test_runner:
     
         logger.info("Finding serial interface...")
         self.serial_port  = lt_environment_tools.get_serial_device_from_vidpid(adapter_id.vid, adapter_id.pid, 1) # TS11 adapter uses second interface for serial port.
-        if self.serial_port is None:
+        if self.serial_port is None and self.rtt_channel is None:
             logger.error("Serial adapter not found. Check if adapter is correctly connected to the computer and correct interface is selected.")
             raise ValueError
         
         self.openocd_launch_params = ["-f", adapter_config_path] + ["-c", f"ftdi vid_pid {adapter_id.vid:#x} {adapter_id.pid:#x}"] + self.platform.get_openocd_launch_params() 
 
-    async def __parse_output(self, message_timeout: int, total_timeout: int) -> lt_test_result:
+    async def __open_output(self, message_timeout: int):
+        """Resets the platform and returns the source of its output."""
+        if self.rtt_channel is None:
+            s = serial.Serial(self.serial_port, baudrate = 115200, timeout=message_timeout, inter_byte_timeout=None, exclusive=True)
+            await self.platform.reset()
+            return s
+
+        await self.platform.reset()
+        if not await self.platform.rtt_start(self.rtt_channel, self.rtt_port):
+            logger.error("RTT control block not found! Check if the firmware initializes SEGGER RTT.")
+            return None
+        return lt_rtt_reader(self.rtt_port, message_timeout)
+
+    async def __parse_output(self, message_timeout: int, total_timeout: int, bench: Optional[lt_bench_results]) -> lt_test_result:
         err_count = 0
         warn_count = 0
         assert_fail_count = 0
@@ -73,9 +126,13 @@ class lt_test_runner:
 
         start_time = time.time()
         
-        with serial.Serial(self.serial_port, baudrate = 115200, timeout=message_timeout, inter_byte_timeout=None, exclusive=True) as s:
-            await self.platform.reset()
-        
+        output = await self.__open_output(message_timeout)
+        if output is None:
+            await self.platform.set_platform_power(False)
+            self.platform.openocd_disconnect()
+            return self.lt_test_result.TEST_FAILED
+
+        with output as s:
             ########################################################################################
             # BEGINNING OF TEST OUTPUT
             # In this section, use dedicated logger_runner and logger_platform to distinguish
@@ -95,7 +152,8 @@ class lt_test_runner:
                         comm_error_count += 1
                         break
 
-                    line = s.read_until(expected=b"\r\n").decode('ascii', errors="backslashreplace")
+                    # Lines printed by printf() (e.g. benchmark results) may end by "\n" only.
+                    line = s.read_until(expected=b"\n").decode('ascii', errors="backslashreplace")
 
                     if (len(line) == 0):
                         logger_runner.error("Did not receive message in time (message_timeout exceeded).")
@@ -106,7 +164,9 @@ class lt_test_runner:
                     line = line.rstrip("\r\n\t ")                   
                    
                     # Passing through output.
-                    if "INFO" in line:
+                    if bench is not None and bench.parse_line(line):
+                        logger_platform.info(f"{line}")
+                    elif "INFO" in line:
                         logger_platform.info(f"{line}")
                     elif "WARNING" in line:
                         logger_platform.warning(f"{line}")
@@ -133,6 +193,9 @@ class lt_test_runner:
                     logger_runner.error(f"Serial timeout! Did not receive any message in time. Check if the test output is correct and if TEST_FINISH is issued at the end of the test.")
                     comm_error_count += 1
 
+        if self.rtt_channel is not None:
+            await self.platform.rtt_stop(self.rtt_port)
+
         if not reached_assert_flag:
             logger_runner.info("FYI: There was no assert. If this is a test, check whether asserts are defined correctly. (No assert = useless test!)")
 
@@ -160,7 +223,9 @@ class lt_test_runner:
         self.platform.openocd_disconnect()
         return self.lt_test_result.TEST_PASSED
 
-    async def run(self, elf_path: Path, message_timeout: int, total_timeout: int) -> lt_test_result:
+    async def run(self, elf_path: Path, message_timeout: int, total_timeout: int,
+                  bench: Optional[lt_bench_results] = None) -> lt_test_result:
+        """Flashes and runs the firmware, results of lt_bench in its output are collected into bench if given."""
         
         if message_timeout == 0:
             # pyserial expects None for no timeout, 0 sets non-blocking mode
@@ -198,4 +263,4 @@ class lt_test_runner:
                 self.platform.openocd_disconnect()
                 return self.lt_test_result.TEST_FAILED
 
-            return await self.__parse_output(message_timeout, total_timeout)
\ No newline at end of file
+            return await self.__parse_output(message_timeout, total_timeout, bench)
\ No newline at end of file
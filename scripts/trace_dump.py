@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# This script decodes a binary trace written by lt_trace_dump() (libtropic built with -DLT_TRACE=1).
+#
+# Dump starts with 16 B header: magic "LTTR", version, LT_TRACE_PAYLOAD_SIZE, payload length used by the ring,
+# reserved byte, number of events and number of events overwritten before the dump (both uint32).
+# Each event has 8 B (timestamp in us as uint32, frame length as uint16, direction, REQ_ID or STATUS)
+# followed by LT_TRACE_PAYLOAD_SIZE bytes of frame data. All numbers are little endian.
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"LTTR"
+VERSION = 1
+HEADER = struct.Struct("<4sBBBxII")
+EVENT = struct.Struct("<IHBB")
+
+REQ_NAMES = {
+    0x01: "GET_INFO",
+    0x02: "HANDSHAKE",
+    0x04: "ENCRYPTED_CMD",
+    0x08: "ENCRYPTED_SESSION_ABT",
+    0x10: "RESEND",
+    0x20: "SLEEP",
+    0xA2: "GET_LOG",
+    0xB0: "MUTABLE_FW_UPDATE",
+    0xB1: "MUTABLE_FW_UPDATE",
+    0xB2: "MUTABLE_FW_ERASE",
+    0xB3: "STARTUP",
+}
+
+STATUS_NAMES = {
+    0x01: "REQUEST_OK",
+    0x02: "RESULT_OK",
+    0x03: "REQUEST_CONT",
+    0x04: "RESULT_CONT",
+    0x78: "RESP_DISABLED",
+    0x79: "HSK_ERR",
+    0x7A: "NO_SESSION",
+    0x7B: "TAG_ERR",
+    0x7C: "CRC_ERR",
+    0x7E: "UNKNOWN_REQ",
+    0x7F: "GEN_ERR",
+    0xFF: "NO_RESP",
+}
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        raise ValueError("Dump is shorter than its header.")
+    magic, version, payload_size, payload_len, cnt, lost = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("Not a libtropic trace dump.")
+    event_size = EVENT.size + payload_size
+    if len(data) < HEADER.size + cnt * event_size:
+        raise ValueError("Dump is truncated.")
+
+    events = []
+    for i in range(cnt):
+        offset = HEADER.size + i * event_size
+        time_us, length, direction, ident = EVENT.unpack_from(data, offset)
+        # Frame data shorter than the kept prefix is followed by stale bytes
+        data_len = length - 4 if direction == 0 else length - 5
+        shown = max(0, min(payload_len, data_len))
+        payload = data[offset + EVENT.size:offset + EVENT.size + shown]
+        events.append((time_us, direction, ident, length, payload))
+    return lost, events
+
+
+def format_events(lost, events):
+    lines = []
+    if lost:
+        lines.append(f"({lost} older events were overwritten)")
+    prev = None
+    for time_us, direction, ident, length, payload in events:
+        delta = "" if prev is None else f"+{(time_us - prev) & 0xFFFFFFFF}"
+        prev = time_us
+        if direction == 0:
+            name = REQ_NAMES.get(ident, f"0x{ident:02x}")
+            arrow = ">>"
+        else:
+            name = STATUS_NAMES.get(ident, f"0x{ident:02x}")
+            arrow = "<<"
+        lines.append(f"{time_us:>10} {delta:>9} {arrow} {name:<21} len {length:>3}  {payload.hex(' ')}")
+    return lines
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Decode libtropic binary trace written by lt_trace_dump().")
+    parser.add_argument("input", help="trace dump file")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        dump = f.read()
+
+    try:
+        lost, events = decode(dump)
+    except ValueError as e:
+        print(e)
+        sys.exit(1)
+
+    print("\n".join(format_events(lost, events)))
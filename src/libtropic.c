@@ -21,21 +21,370 @@
 #include "libtropic_macros.h"
 #include "libtropic_port.h"
 #include "lt_aesgcm.h"
+#include "lt_aesgcm_multi.h"
 #include "lt_asn1_der.h"
+#include "lt_crc16.h"
+#include "lt_crypto_dispatch.h"
 #include "lt_ecdsa.h"
 #include "lt_ed25519.h"
 #include "lt_hkdf.h"
+#if LT_HOST_DRBG
+#include "lt_hmac_drbg.h"
+#endif
+#include "lt_hooks.h"
 #include "lt_l1.h"
 #include "lt_l1_port_wrap.h"
 #include "lt_l2_api_structs.h"
 #include "lt_l3_api_structs.h"
+#include "lt_l3_cmd_desc.h"
 #include "lt_l3_process.h"
 #include "lt_random.h"
 #include "lt_sha256.h"
+#include "lt_sha256_multi.h"
+#include "lt_spi_tune.h"
+#include "lt_tune.h"
+#include "lt_wire.h"
 #include "lt_x25519.h"
 
 #define TS_GET_INFO_BLOCK_LEN 128
 
+#if LT_THREAD_SAFE || LT_L3_BUFF_POOL || LT_HOOKS
+/**
+ * Locks the handle for the rest of the scope, the lock is released by `lt_handle_unlock()` at any return. With
+ * LT_L3_BUFF_POOL, L3 buffer borrowed in the scope is returned to the pool there as well. With LT_HOOKS, the scope
+ * is reported as a call of the function.
+ */
+#define LT_HANDLE_LOCK(h)                                                                  \
+    lt_handle_guard_t lt_handle_locked __attribute__((cleanup(lt_handle_unlock), unused)) \
+        = lt_handle_lock(h, __func__)
+
+typedef struct lt_handle_guard_t {
+    lt_handle_t *h;
+#if LT_L3_BUFF_POOL
+    /** L3 buffer was borrowed already by the caller, e.g. a helper calling other API functions */
+    bool buff_held;
+#endif
+} lt_handle_guard_t;
+
+static lt_handle_guard_t lt_handle_lock(lt_handle_t *h, const char *func)
+{
+#if LT_THREAD_SAFE
+    lt_port_lock(&h->l2);
+#endif
+    lt_handle_guard_t guard = {.h = h};
+#if LT_L3_BUFF_POOL
+    guard.buff_held = (h->l3.buff != NULL);
+#endif
+#if LT_HOOKS
+    lt_hook_pre(&h->l2, LT_HOOK_API, func, 0, 0, 0);
+#else
+    UNUSED(func);
+#endif
+
+    return guard;
+}
+
+static void lt_handle_unlock(lt_handle_guard_t *guard)
+{
+#if LT_HOOKS
+    lt_hook_post(&guard->h->l2, LT_HOOK_API, 0, 0, LT_OK);
+#endif
+#if LT_L3_BUFF_POOL
+    if (guard->h->l3_pool && !guard->buff_held) {
+        lt_ret_t ret_unused = lt_l3_buff_release(guard->h);
+        UNUSED(ret_unused);  // Fails only when no buffer was borrowed in the scope
+    }
+#endif
+#if LT_THREAD_SAFE
+    lt_port_unlock(&guard->h->l2);
+#endif
+}
+#else
+#define LT_HANDLE_LOCK(h)
+#endif
+
+#if LT_SESSION_REKEY
+/** Returns true when session has to be re-established before next L3 command according to `h->rekey` policy */
+static bool lt_session_rekey_needed(const lt_handle_t *h)
+{
+    const uint8_t *nonce = h->l3.encryption_IV;
+    // Nonce is incremented by each L3 command, so it is also the number of commands sent in the session
+    uint32_t cmd_cnt = ((uint32_t)nonce[3] << 24) | ((uint32_t)nonce[2] << 16) | ((uint32_t)nonce[1] << 8) | nonce[0];
+
+    if (cmd_cnt == UINT32_MAX) {
+        // Next command would overflow the nonce and end the session
+        return true;
+    }
+
+    return h->rekey->max_cmds && (cmd_cnt >= h->rekey->max_cmds);
+}
+#endif
+
+/** Checks that secure session is established, with LT_SESSION_REKEY it is re-established here when needed */
+static lt_ret_t lt_l3_session_check(lt_handle_t *h)
+{
+#if LT_SESSION_LIVENESS
+    if (h->l2.liveness && !h->l2.liveness->alive && (h->l3.session == SESSION_ON)) {
+        // TROPIC01 lost the session, commands would fail anyway
+        lt_l3_invalidate_host_session_data(&h->l3);
+    }
+#endif
+#if LT_IDLE_SLEEP && LT_SESSION_REKEY
+    if (h->l2.idle && h->l2.idle->resume) {
+        h->l2.idle->resume = 0;
+        // Session ended by sleep of TROPIC01 is re-established, unless the application did it already
+        if ((h->l3.session != SESSION_ON) && h->rekey) {
+            lt_ret_t ret = lt_session_start_ctx(h, &h->rekey->ctx);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+    }
+#endif
+#if LT_SESSION_AUTO
+    if ((h->l3.session != SESSION_ON) && h->session_auto) {
+        lt_ret_t ret = lt_session_auto_start(h);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+#endif
+    if (h->l3.session != SESSION_ON) {
+#if LT_SESSION_LIVENESS
+        // Session ended by the host, e.g. after a failed batch
+        lt_l1_session_lost(&h->l2, LT_LIVENESS_NO_SESSION);
+#endif
+        return LT_HOST_NO_SESSION;
+    }
+
+#if LT_SESSION_REKEY
+    if (h->rekey && lt_session_rekey_needed(h)) {
+        // Release contexts of the old session, the handshake replaces it on TROPIC01 as well
+        lt_l3_invalidate_host_session_data(&h->l3);
+        lt_ret_t ret = lt_session_start_ctx(h, &h->rekey->ctx);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+#endif
+
+#if LT_L3_BUFF_POOL
+    // Kept until the end of the calling API function, see LT_HANDLE_LOCK
+    if (h->l3_pool && !h->l3.buff) {
+        return lt_l3_buff_borrow(h);
+    }
+#endif
+
+    return LT_OK;
+}
+
+/** Receives L3 result into L3 buffer, with LT_L3_STREAM_DECRYPT it is decrypted already while being received */
+static lt_ret_t lt_l3_result_recv(lt_handle_t *h)
+{
+#if LT_L3_STREAM_DECRYPT
+    return lt_l3_recv_decrypt(&h->l2, &h->l3, NULL, NULL);
+#else
+    uint16_t len = 0;
+    lt_ret_t ret = lt_l2_recv_encrypted_res_len(&h->l2, LT_L3_RES_BUFF(&h->l3), LT_L3_RES_BUFF_LEN(&h->l3), &len);
+    // Only the received part is wiped when the session ends
+    lt_l3_res_buff_used(&h->l3, len);
+
+    return ret;
+#endif
+}
+
+lt_ret_t lt_l3_transfer(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_l3_result_recv(h);
+}
+
+/** Commands of one pipelined batch, see `lt_l3_batch()` */
+struct lt_l3_batch_t {
+    /** Number of commands */
+    uint32_t n;
+    /** Returns size of i-th encrypted command frame */
+    uint16_t (*cmd_len)(const void *ctx, uint32_t i);
+    /** Encodes and encrypts i-th command into L3 buffer */
+    lt_ret_t (*out)(lt_handle_t *h, const void *ctx, uint32_t i);
+    /** Decrypts and decodes result of i-th command, other value than LT_OK stops the batch */
+    lt_ret_t (*in)(lt_handle_t *h, const void *ctx, uint32_t i);
+    /** Arguments of the commands, passed to the functions above */
+    const void *ctx;
+};
+
+/** Returns true when i-th command can be prepared while TROPIC01 executes the previous one */
+static bool lt_l3_batch_pipelined(const lt_handle_t *h, const struct lt_l3_batch_t *b, uint32_t i)
+{
+#if LT_SESSION_REKEY
+    if (h->rekey && lt_session_rekey_needed(h)) {
+        // Session is re-established before the command, which cannot be done while the previous one runs
+        return false;
+    }
+#endif
+
+#if LT_L3_SPLIT_BUFF
+    // Result is received into its own buffer, so it never overwrites the prepared command
+    UNUSED(h);
+    UNUSED(b);
+    UNUSED(i);
+    return true;
+#else
+    // Space for the result of the executing command, which is the last one encrypted
+    const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(h->l3.cmd_id);
+    return desc && ((b->cmd_len(b->ctx, i) + LT_L3_PACKET_SIZE(desc->res_size_max)) <= h->l3.buff_len);
+#endif
+}
+
+/**
+ * Executes all commands of the batch. While TROPIC01 executes one command, the next one is encrypted and kept at the
+ * end of L3 buffer, where it is not overwritten by the result. With LT_L3_SPLIT_BUFF it is simply kept in the command
+ * buffer.
+ */
+static lt_ret_t lt_l3_batch(lt_handle_t *h, const struct lt_l3_batch_t *b)
+{
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = b->out(h, b->ctx, 0);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    for (uint32_t i = 0; i < b->n; i++) {
+        ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        uint16_t staged_len = 0;
+        if ((i + 1 < b->n) && lt_l3_batch_pipelined(h, b, i + 1)) {
+            ret = b->out(h, b->ctx, i + 1);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            staged_len = b->cmd_len(b->ctx, i + 1);
+#if !LT_L3_SPLIT_BUFF
+            memmove(h->l3.buff + h->l3.buff_len - staged_len, h->l3.buff, staged_len);
+#endif
+        }
+
+#if LT_L3_SPLIT_BUFF
+        ret = lt_l3_result_recv(h);
+#else
+        // Result is not allowed to overwrite the staged command
+        uint16_t buff_len = h->l3.buff_len;
+        h->l3.buff_len -= staged_len;
+        ret = lt_l3_result_recv(h);
+        h->l3.buff_len = buff_len;
+#endif
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        lt_ret_t ret_in = b->in(h, b->ctx, i);
+
+        if (staged_len) {
+#if !LT_L3_SPLIT_BUFF
+            memmove(h->l3.buff, h->l3.buff + h->l3.buff_len - staged_len, staged_len);
+#endif
+            if (ret_in != LT_OK) {
+                // Staged command already used the next nonce. Idempotent one is executed anyway to keep nonces of
+                // both sides in sync, only the first failure is returned. Other commands must not be executed after
+                // the failure, so the session is ended instead.
+                const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(h->l3.cmd_id);
+                if (!desc || !(desc->flags & LT_L3_CMD_IDEMPOTENT)) {
+                    lt_l3_invalidate_host_session_data(&h->l3);
+                    return ret_in;
+                }
+                ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+                if (ret == LT_OK) {
+                    ret = lt_l3_result_recv(h);
+                }
+                if (ret == LT_OK) {
+                    int ret_unused = b->in(h, b->ctx, i + 1);
+                    UNUSED(ret_unused);
+                }
+                return ret_in;
+            }
+        }
+        else {
+            if (ret_in != LT_OK) {
+                return ret_in;
+            }
+            if (i + 1 < b->n) {
+                ret = lt_l3_session_check(h);
+                if (ret != LT_OK) {
+                    return ret;
+                }
+                ret = b->out(h, b->ctx, i + 1);
+                if (ret != LT_OK) {
+                    return ret;
+                }
+            }
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Returns true when a decrypted result reports failure of the command itself, which does not break the session */
+static bool lt_l3_batch_cmd_failed(const lt_ret_t ret)
+{
+    return (ret == LT_FAIL) || ((ret >= LT_L3_R_MEM_DATA_READ_SLOT_EMPTY) && (ret <= LT_L3_DATA_LEN_ERROR));
+}
+
+#if LT_TUNE_PERSIST
+/** Makes the key of tuning profiles from CHIP_ID, unless it was already made since `lt_init()` */
+static lt_ret_t lt_tune_key_read(lt_handle_t *h)
+{
+    if (h->tune_store->key_valid) {
+        return LT_OK;
+    }
+
+    struct lt_chip_id_t chip_id;
+    lt_ret_t ret = lt_get_info_chip_id(h, &chip_id);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    lt_tune_key_set(h->tune_store, &chip_id);
+
+    return LT_OK;
+}
+
+/** Restores tuning from the profile saved for the chip and port */
+static lt_ret_t lt_tune_load(lt_handle_t *h)
+{
+    lt_tune_store_t *store = h->tune_store;
+
+    // Chip might be a different one than before
+    store->key_valid = 0;
+    lt_ret_t ret = lt_tune_key_read(h);
+    if ((ret != LT_OK) || !store->load) {
+        return ret;
+    }
+
+    uint8_t buff[LT_TUNE_EXPORT_SIZE_MAX];
+    uint16_t len = 0;
+    ret = store->load(store->key, buff, sizeof(buff), &len, store->ctx);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_tune_read(h, buff, len);
+}
+#endif
+
 lt_ret_t lt_init(lt_handle_t *h)
 {
     if (!h) {
@@ -46,13 +395,64 @@ lt_ret_t lt_init(lt_handle_t *h)
     // define buffer's length here (later used to prevent overflow during communication).
 #if !LT_SEPARATE_L3_BUFF
     h->l3.buff_len = LT_SIZE_OF_L3_BUFF;  // Size of l3 buffer is defined in libtropic_common.h
+#if LT_L3_SPLIT_BUFF
+    h->l3.res_buff_len = LT_SIZE_OF_L3_BUFF;
+#endif
+#endif
+    // Content left in buffers before initialization is not known, so they are wiped whole the first time
+    h->l3.buff_used = h->l3.buff_len;
+#if LT_L3_SPLIT_BUFF
+    h->l3.res_buff_used = h->l3.res_buff_len;
+#endif
+#if LT_L3_BUFF_POOL
+    if (h->l3_pool) {
+        // Buffer is borrowed from the pool by each L3 command
+        h->l3.buff = NULL;
+        h->l3.buff_len = 0;
+        h->l3.buff_used = 0;
+    }
+#endif
+#if LT_CRYPTO_DISPATCH
+    lt_crypto_dispatch_init();
 #endif
     h->l3.session = SESSION_OFF;
+#if LT_MODE_TRACK
+    // Chip might be a different one than before
+    lt_l1_mode_forget(&h->l2);
+#endif
+#if LT_SESSION_LIVENESS
+    if (h->l2.liveness) {
+        h->l2.liveness->alive = 0;
+    }
+#endif
     lt_ret_t ret = lt_l1_init(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
 
+#if LT_TUNE_PERSIST
+    if (h->tune_store) {
+        // Not fatal for the handle, it learns the tuning again
+        ret = lt_tune_load(h);
+        if ((ret != LT_OK) && (ret != LT_NOT_FOUND)) {
+            LT_LOG_S2_WARN(&h->l2, "Tuning profile was not loaded, ret=%d", (int)ret);
+        }
+    }
+#endif
+#if LT_SESSION_AUTO
+    if (h->session_auto) {
+        // Chip might be a different one than before, STPUB is read again
+        h->session_auto->ctx_valid = 0;
+        if (h->session_auto->prewarm) {
+            ret = lt_session_auto_start(h);
+            if (ret != LT_OK) {
+                // Not fatal for the handle, the first L3 command tries it again and returns the error
+                LT_LOG_S2_WARN(&h->l2, "Session was not established in advance, ret=%d", (int)ret);
+            }
+        }
+    }
+#endif
+
     return LT_OK;
 }
 
@@ -63,6 +463,19 @@ lt_ret_t lt_deinit(lt_handle_t *h)
     }
 
     lt_l3_invalidate_host_session_data(&h->l3);
+#if LT_SESSION_LIVENESS
+    if (h->l2.liveness) {
+        h->l2.liveness->alive = 0;
+    }
+#endif
+#if LT_TUNE_PERSIST
+    if (h->tune_store && h->tune_store->save && h->tune_store->key_valid) {
+        lt_ret_t ret_save = lt_tune_save(h);
+        if (ret_save != LT_OK) {
+            LT_LOG_S2_WARN(&h->l2, "Tuning profile was not saved, ret=%d", (int)ret_save);
+        }
+    }
+#endif
 
     lt_ret_t ret = lt_l1_deinit(&h->l2);
     if (ret != LT_OK) {
@@ -72,12 +485,29 @@ lt_ret_t lt_deinit(lt_handle_t *h)
     return LT_OK;
 }
 
-lt_ret_t lt_update_mode(lt_handle_t *h)
+#if LT_PORT_SHARE
+lt_ret_t lt_port_attach(lt_handle_t *h)
 {
-    if (!h) {
+    if (!h || !h->l2.port_share) {
+        return LT_PARAM_ERR;
+    }
+
+    return lt_l1_init(&h->l2);
+}
+
+lt_ret_t lt_port_detach(lt_handle_t *h)
+{
+    if (!h || !h->l2.port_share) {
         return LT_PARAM_ERR;
     }
 
+    return lt_l1_deinit(&h->l2);
+}
+#endif
+
+/** Reads CHIP_STATUS byte alone into `h->l2.buff[0]` */
+static lt_ret_t lt_chip_status_read(lt_handle_t *h)
+{
     lt_ret_t ret;
 
     // The byte used here must not be ID byte of some request, otherwise chip would be confused
@@ -98,72 +528,272 @@ lt_ret_t lt_update_mode(lt_handle_t *h)
         return ret;
     }
 
-    ret = lt_l1_spi_csn_high(&h->l2);
+    return lt_l1_spi_csn_high(&h->l2);
+}
+
+lt_ret_t lt_update_mode(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+#if LT_MODE_TRACK
+    if (lt_l1_mode_fresh(&h->l2)) {
+        h->l2.mode_track->skipped++;
+        return LT_OK;
+    }
+#endif
+
+    lt_ret_t ret = lt_chip_status_read(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Buffer in handle now contains CHIP_STATUS byte,
     // Save info about chip mode into 'mode' variable in handle
-    if (h->l2.buff[0] & CHIP_MODE_STARTUP_bit) {
-        h->l2.mode = LT_MODE_MAINTENANCE;
+    lt_l1_mode_observe(&h->l2, h->l2.buff[0]);
+
+    return LT_OK;
+}
+
+#if LT_GET_INFO_CACHE
+/** Bits of `lt_get_info_cache_t.valid` */
+#define LT_GET_INFO_CACHE_CHIP_ID 0x01u
+#define LT_GET_INFO_CACHE_RISCV_FW_VER 0x02u
+#define LT_GET_INFO_CACHE_SPECT_FW_VER 0x04u
+#define LT_GET_INFO_CACHE_CERT_STORE 0x08u
+/** Bit of header of the bank with index `i` of `lt_fw_bank_index()` */
+#define LT_GET_INFO_CACHE_FW_BANK(i) (0x10u << (i))
+
+lt_ret_t lt_get_info_cache_invalidate(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
     }
-    else {
-        h->l2.mode = LT_MODE_APP;
+    LT_HANDLE_LOCK(h);
+
+    if (h->info_cache) {
+        h->info_cache->valid = 0;
+        h->info_cache->cert_blocks = 0;
     }
 
     return LT_OK;
 }
+#endif
 
-lt_ret_t lt_get_info_cert_store(lt_handle_t *h, struct lt_cert_store_t *store)
+#if LT_STATS
+lt_ret_t lt_stats_get(lt_handle_t *h, const uint16_t key, lt_stats_entry_t *entry)
 {
-    if (!h || !store) {
+    if (!h || !h->l2.stats || (key == 0) || !entry) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    // Setup a request pointer to l2 buffer with request data
-    struct lt_l2_get_info_req_t *p_l2_req = (struct lt_l2_get_info_req_t *)h->l2.buff;
+    memset(entry, 0, sizeof(*entry));
+    for (size_t i = 0; i < LT_STATS_CNT; i++) {
+        if (h->l2.stats->entries[i].key == key) {
+            memcpy(entry, &h->l2.stats->entries[i], sizeof(*entry));
+            break;
+        }
+    }
 
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_get_info_rsp_t *p_l2_resp = (struct lt_l2_get_info_rsp_t *)h->l2.buff;
+    return LT_OK;
+}
 
-    // Max cert-store length not read out -> Optimized as being read to read out only needed part!
-    int curr_cert = LT_CERT_KIND_DEVICE;
-    uint8_t *cert_head = store->certs[curr_cert];
+lt_ret_t lt_stats_reset(lt_handle_t *h)
+{
+    if (!h || !h->l2.stats) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
 
-    // Worst case full ceert-store is read out
-    for (int i = 0; i < (LT_L2_GET_INFO_REQ_CERT_SIZE_TOTAL / TS_GET_INFO_BLOCK_LEN); i++) {
-        p_l2_req->req_id = LT_L2_GET_INFO_REQ_ID;
-        p_l2_req->req_len = LT_L2_GET_INFO_REQ_LEN;
-        p_l2_req->object_id = LT_L2_GET_INFO_REQ_OBJECT_ID_X509_CERTIFICATE;
-        p_l2_req->block_index = i;
+    lt_stats_t *stats = h->l2.stats;
+    stats->dropped = 0;
+    stats->cur = NULL;
+    stats->delays = 0;
+    memset(&stats->oversleep, 0, sizeof(stats->oversleep));
+    memset(stats->entries, 0, sizeof(stats->entries));
 
-        lt_ret_t ret = lt_l2_send(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
+    return LT_OK;
+}
+#endif
 
-        ret = lt_l2_receive(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
+#if LT_ECC_KEY_CACHE
+lt_ret_t lt_ecc_key_cache_invalidate(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
 
-        if (TS_GET_INFO_BLOCK_LEN != (p_l2_resp->rsp_len)) {
-            return LT_FAIL;
-        }
+    if (h->key_cache) {
+        h->key_cache->valid = 0;
+    }
 
-        uint8_t *head = ((struct lt_l2_get_info_rsp_t *)h->l2.buff)->object;
-        uint8_t *tail = head + TS_GET_INFO_BLOCK_LEN;
+    return LT_OK;
+}
 
-        // Parse the header - Gets lengths and checks buffers are large enough
-        if (i == 0) {
-            if (*head != LT_CERT_STORE_VERSION) {
-                return LT_CERT_STORE_INVALID;
-            }
-            head++;
-            if (*head != LT_NUM_CERTIFICATES) {
-                return LT_CERT_STORE_INVALID;
-            }
+/** Invalidates cached public key of one slot, its key is about to change */
+static void lt_ecc_key_cache_drop(lt_handle_t *h, const ecc_slot_t slot)
+{
+    if (h->key_cache) {
+        h->key_cache->valid &= ~(1UL << slot);
+    }
+}
+#endif
+
+#if LT_ENABLE_R_MEM && LT_RMEM_CACHE
+/** Drops cached slots in the range, pending writes of them are discarded */
+static void lt_rmem_cache_drop(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt)
+{
+    if (!h->rmem_cache) {
+        return;
+    }
+    for (int i = 0; i < LT_RMEM_CACHE_SLOTS; i++) {
+        if (h->rmem_cache->entries[i].used && (h->rmem_cache->entries[i].slot >= first_slot)
+            && (h->rmem_cache->entries[i].slot - first_slot < slots_cnt)) {
+            h->rmem_cache->entries[i].used = 0;
+        }
+    }
+}
+#endif
+
+#if LT_CONFIG_CACHE
+lt_ret_t lt_config_cache_invalidate(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    if (h->config_cache) {
+        h->config_cache->r_valid = 0;
+        h->config_cache->i_valid = 0;
+    }
+
+    return LT_OK;
+}
+
+/** Invalidates cached R-Config or I-Config, it is about to change */
+static void lt_config_cache_drop(lt_handle_t *h, const lt_config_space_t space)
+{
+    if (h->config_cache) {
+        if (space == LT_CONFIG_SPACE_R) {
+            h->config_cache->r_valid = 0;
+        }
+        else {
+            h->config_cache->i_valid = 0;
+        }
+    }
+}
+
+/** Takes object at `addr` from cached R-Config or I-Config, returns false when it is not cached */
+static bool lt_config_cache_get(const lt_handle_t *h, const lt_config_space_t space,
+                                const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj)
+{
+    const lt_config_cache_t *c = h->config_cache;
+    if (!c || !((space == LT_CONFIG_SPACE_R) ? c->r_valid : c->i_valid)) {
+        return false;
+    }
+
+    const lt_config_t *config = (space == LT_CONFIG_SPACE_R) ? &c->r : &c->i;
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        if (cfg_desc_table[i].addr == addr) {
+            *obj = config->obj[i];
+            return true;
+        }
+    }
+
+    // Invalid address is left to TROPIC01
+    return false;
+}
+#endif
+
+/** Gets block of certificate store (TS_GET_INFO_BLOCK_LEN bytes) from TROPIC01, or from the cache */
+static lt_ret_t lt_get_info_cert_block(lt_handle_t *h, int i, const uint8_t **block)
+{
+#if LT_GET_INFO_CACHE
+    lt_get_info_cache_t *cache = h->info_cache;
+    if (cache && (cache->valid & LT_GET_INFO_CACHE_CERT_STORE) && (i < cache->cert_blocks)) {
+        *block = cache->cert_store + i * TS_GET_INFO_BLOCK_LEN;
+        return LT_OK;
+    }
+#endif
+
+    // Setup a request pointer to l2 buffer with request data
+    struct lt_l2_get_info_req_t *p_l2_req = (struct lt_l2_get_info_req_t *)h->l2.buff;
+
+    // Setup a request pointer to l2 buffer with response data
+    struct lt_l2_get_info_rsp_t *p_l2_resp = (struct lt_l2_get_info_rsp_t *)h->l2.buff;
+
+    p_l2_req->req_id = LT_L2_GET_INFO_REQ_ID;
+    p_l2_req->req_len = LT_L2_GET_INFO_REQ_LEN;
+    p_l2_req->object_id = LT_L2_GET_INFO_REQ_OBJECT_ID_X509_CERTIFICATE;
+    p_l2_req->block_index = i;
+
+    lt_ret_t ret = lt_l2_send(&h->l2);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_receive(&h->l2);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    if (TS_GET_INFO_BLOCK_LEN != (p_l2_resp->rsp_len)) {
+        return LT_FAIL;
+    }
+
+    *block = p_l2_resp->object;
+
+#if LT_GET_INFO_CACHE
+    // Blocks are read in order, cache holds them from the first one (reading might have been interrupted before)
+    if (cache && !(cache->valid & LT_GET_INFO_CACHE_CERT_STORE)) {
+        if (i == 0) {
+            cache->cert_blocks = 0;
+        }
+        if (i == cache->cert_blocks) {
+            memcpy(cache->cert_store + i * TS_GET_INFO_BLOCK_LEN, p_l2_resp->object, TS_GET_INFO_BLOCK_LEN);
+            cache->cert_blocks++;
+        }
+    }
+#endif
+
+    return LT_OK;
+}
+
+lt_ret_t lt_get_info_cert_store(lt_handle_t *h, struct lt_cert_store_t *store)
+{
+    if (!h || !store) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    // Max cert-store length not read out -> Optimized as being read to read out only needed part!
+    int curr_cert = LT_CERT_KIND_DEVICE;
+    uint8_t *cert_head = store->certs[curr_cert];
+
+    // Worst case full ceert-store is read out
+    for (int i = 0; i < (LT_L2_GET_INFO_REQ_CERT_SIZE_TOTAL / TS_GET_INFO_BLOCK_LEN); i++) {
+        const uint8_t *head;
+        lt_ret_t ret = lt_get_info_cert_block(h, i, &head);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        const uint8_t *tail = head + TS_GET_INFO_BLOCK_LEN;
+
+        // Parse the header - Gets lengths and checks buffers are large enough
+        if (i == 0) {
+            if (*head != LT_CERT_STORE_VERSION) {
+                return LT_CERT_STORE_INVALID;
+            }
+            head++;
+            if (*head != LT_NUM_CERTIFICATES) {
+                return LT_CERT_STORE_INVALID;
+            }
             head++;
 
             for (int j = 0; j < LT_NUM_CERTIFICATES; j++) {
@@ -198,6 +828,11 @@ lt_ret_t lt_get_info_cert_store(lt_handle_t *h, struct lt_cert_store_t *store)
         // Move to the next certificate or finish upon last chunk of last certificate
         if ((cert_head - store->certs[curr_cert]) >= store->cert_len[curr_cert]) {
             if (curr_cert >= LT_NUM_CERTIFICATES - 1) {
+#if LT_GET_INFO_CACHE
+                if (h->info_cache) {
+                    h->info_cache->valid |= LT_GET_INFO_CACHE_CERT_STORE;
+                }
+#endif
                 break;
             }
             else {
@@ -229,11 +864,203 @@ lt_ret_t lt_get_st_pub(const struct lt_cert_store_t *store, uint8_t *stpub, int
     return asn1der_find_object(head, len, OBJ_ID_CURVEX25519, stpub, stpub_len, ASN1DER_CROP_PREFIX);
 }
 
+lt_ret_t lt_get_info_st_pub(lt_handle_t *h, uint8_t *stpub, int stpub_len)
+{
+    if (!h || !stpub) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    // Only the device certificate (the first one in the store) is read, each block is parsed as it is received
+    struct asn1der_request_t req = {
+        .obj_id = OBJ_ID_CURVEX25519, .buf = stpub, .buf_len = stpub_len, .crop_kind = ASN1DER_CROP_PREFIX};
+    struct asn1der_stream_t parser;
+    lt_ret_t ret = asn1der_stream_init(&parser, &req, 1);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    uint16_t cert_len = 0;
+    uint16_t received = 0;
+
+    for (int i = 0; i < (LT_L2_GET_INFO_REQ_CERT_SIZE_TOTAL / TS_GET_INFO_BLOCK_LEN); i++) {
+        const uint8_t *head;
+        ret = lt_get_info_cert_block(h, i, &head);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        const uint8_t *tail = head + TS_GET_INFO_BLOCK_LEN;
+
+        // Parse the header, same as lt_get_info_cert_store()
+        if (i == 0) {
+            if ((head[0] != LT_CERT_STORE_VERSION) || (head[1] != LT_NUM_CERTIFICATES)) {
+                return LT_CERT_STORE_INVALID;
+            }
+            cert_len = (head[2] << 8) | head[3];
+            if ((cert_len == 0) || (cert_len > LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE)) {
+                return LT_CERT_STORE_INVALID;
+            }
+            head += 2 + 2 * LT_NUM_CERTIFICATES;
+        }
+
+        uint16_t to_parse = ((tail - head) < (cert_len - received)) ? (tail - head) : (cert_len - received);
+        ret = asn1der_stream_feed(&parser, head, to_parse);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        received += to_parse;
+
+        // The rest of the certificate is not needed after the key was found
+        if (asn1der_stream_all_found(&parser)) {
+            return LT_OK;
+        }
+        if (received == cert_len) {
+            return asn1der_stream_complete(&parser) ? LT_CERT_ITEM_NOT_FOUND : LT_CERT_STORE_INVALID;
+        }
+    }
+
+    return LT_CERT_STORE_INVALID;
+}
+
+/** Magic bytes at the beginning of exported certificate store */
+static const uint8_t lt_cert_store_export_magic[4] = {'L', 'T', 'C', 'S'};
+
+STATIC_ASSERT(LT_CERT_STORE_EXPORT_HEADER_SIZE
+              == (sizeof(lt_cert_store_export_magic) + 1 + sizeof(struct lt_ser_num_t) + 32 + 2 * LT_NUM_CERTIFICATES))
+
+/** Calculates digest which protects exported certificate store against corruption */
+static void lt_cert_store_export_digest(const uint8_t *data, uint16_t len, uint8_t *digest)
+{
+    struct lt_crypto_sha256_ctx_t hctx = {0};
+
+    lt_sha256_init(&hctx);
+    lt_sha256_start(&hctx);
+    lt_sha256_update(&hctx, data, len);
+    lt_sha256_finish(&hctx, digest);
+}
+
+lt_ret_t lt_cert_store_export(const struct lt_chip_id_t *chip_id, const struct lt_cert_store_t *store, uint8_t *buff,
+                              const uint16_t max_len, uint16_t *len)
+{
+    if (!chip_id || !store || !buff || !len) {
+        return LT_PARAM_ERR;
+    }
+
+    uint32_t total = LT_CERT_STORE_EXPORT_HEADER_SIZE + SHA256_DIGEST_LENGTH;
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        if (!store->certs[i] || (store->cert_len[i] > store->buf_len[i])) {
+            return LT_PARAM_ERR;
+        }
+        total += store->cert_len[i];
+    }
+    if (total > max_len) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t *p = buff;
+    memcpy(p, lt_cert_store_export_magic, sizeof(lt_cert_store_export_magic));
+    p += sizeof(lt_cert_store_export_magic);
+    *p++ = LT_CERT_STORE_EXPORT_VERSION;
+    memcpy(p, &chip_id->ser_num, sizeof(chip_id->ser_num));
+    p += sizeof(chip_id->ser_num);
+
+    // STPub is stored too, so the certificate does not have to be parsed again after import
+    lt_ret_t ret = lt_get_st_pub(store, p, 32);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    p += 32;
+
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        *p++ = store->cert_len[i] & 0xff;
+        *p++ = store->cert_len[i] >> 8;
+    }
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        memcpy(p, store->certs[i], store->cert_len[i]);
+        p += store->cert_len[i];
+    }
+
+    lt_cert_store_export_digest(buff, p - buff, p);
+    p += SHA256_DIGEST_LENGTH;
+
+    *len = p - buff;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_cert_store_import(const struct lt_chip_id_t *chip_id, const uint8_t *buff, const uint16_t len,
+                              struct lt_cert_store_t *store, uint8_t *stpub, int stpub_len)
+{
+    if (!chip_id || !buff || (stpub && (stpub_len < 32))) {
+        return LT_PARAM_ERR;
+    }
+
+    if (len < LT_CERT_STORE_EXPORT_HEADER_SIZE + SHA256_DIGEST_LENGTH) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    lt_cert_store_export_digest(buff, len - SHA256_DIGEST_LENGTH, digest);
+    if (memcmp(digest, buff + len - SHA256_DIGEST_LENGTH, SHA256_DIGEST_LENGTH)) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    const uint8_t *p = buff;
+    if (memcmp(p, lt_cert_store_export_magic, sizeof(lt_cert_store_export_magic))) {
+        return LT_CERT_STORE_INVALID;
+    }
+    p += sizeof(lt_cert_store_export_magic);
+    if (*p++ != LT_CERT_STORE_EXPORT_VERSION) {
+        return LT_CERT_STORE_INVALID;
+    }
+    // Exported data must belong to the same chip
+    if (memcmp(p, &chip_id->ser_num, sizeof(chip_id->ser_num))) {
+        return LT_CERT_STORE_INVALID;
+    }
+    p += sizeof(chip_id->ser_num);
+    const uint8_t *exported_stpub = p;
+    p += 32;
+
+    uint16_t cert_len[LT_NUM_CERTIFICATES];
+    uint32_t total = LT_CERT_STORE_EXPORT_HEADER_SIZE + SHA256_DIGEST_LENGTH;
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        cert_len[i] = p[0] | (p[1] << 8);
+        p += 2;
+        total += cert_len[i];
+        if (store && (!store->certs[i] || (cert_len[i] > store->buf_len[i]))) {
+            return LT_PARAM_ERR;
+        }
+    }
+    if (total != len) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    if (store) {
+        for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+            memcpy(store->certs[i], p, cert_len[i]);
+            store->cert_len[i] = cert_len[i];
+            p += cert_len[i];
+        }
+    }
+    if (stpub) {
+        memcpy(stpub, exported_stpub, 32);
+    }
+
+    return LT_OK;
+}
+
 lt_ret_t lt_get_info_chip_id(lt_handle_t *h, struct lt_chip_id_t *chip_id)
 {
     if (!h || !chip_id) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache && (h->info_cache->valid & LT_GET_INFO_CACHE_CHIP_ID)) {
+        memcpy(chip_id, &h->info_cache->chip_id, LT_L2_GET_INFO_CHIP_ID_SIZE);
+        return LT_OK;
+    }
+#endif
 
     // Setup a request pointer to l2 buffer, which is placed in handle
     struct lt_l2_get_info_req_t *p_l2_req = (struct lt_l2_get_info_req_t *)h->l2.buff;
@@ -260,6 +1087,12 @@ lt_ret_t lt_get_info_chip_id(lt_handle_t *h, struct lt_chip_id_t *chip_id)
     }
 
     memcpy(chip_id, ((struct lt_l2_get_info_rsp_t *)h->l2.buff)->object, LT_L2_GET_INFO_CHIP_ID_SIZE);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache) {
+        memcpy(&h->info_cache->chip_id, chip_id, LT_L2_GET_INFO_CHIP_ID_SIZE);
+        h->info_cache->valid |= LT_GET_INFO_CACHE_CHIP_ID;
+    }
+#endif
 
     return LT_OK;
 }
@@ -269,6 +1102,13 @@ lt_ret_t lt_get_info_riscv_fw_ver(lt_handle_t *h, uint8_t *ver)
     if (!h || !ver) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache && (h->info_cache->valid & LT_GET_INFO_CACHE_RISCV_FW_VER)) {
+        memcpy(ver, h->info_cache->riscv_fw_ver, LT_L2_GET_INFO_RISCV_FW_SIZE);
+        return LT_OK;
+    }
+#endif
 
     // Setup a request pointer to l2 buffer, which is placed in handle
     struct lt_l2_get_info_req_t *p_l2_req = (struct lt_l2_get_info_req_t *)h->l2.buff;
@@ -295,6 +1135,12 @@ lt_ret_t lt_get_info_riscv_fw_ver(lt_handle_t *h, uint8_t *ver)
     }
 
     memcpy(ver, ((struct lt_l2_get_info_rsp_t *)h->l2.buff)->object, LT_L2_GET_INFO_RISCV_FW_SIZE);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache) {
+        memcpy(h->info_cache->riscv_fw_ver, ver, LT_L2_GET_INFO_RISCV_FW_SIZE);
+        h->info_cache->valid |= LT_GET_INFO_CACHE_RISCV_FW_VER;
+    }
+#endif
 
     return LT_OK;
 }
@@ -304,6 +1150,13 @@ lt_ret_t lt_get_info_spect_fw_ver(lt_handle_t *h, uint8_t *ver)
     if (!h || !ver) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache && (h->info_cache->valid & LT_GET_INFO_CACHE_SPECT_FW_VER)) {
+        memcpy(ver, h->info_cache->spect_fw_ver, LT_L2_GET_INFO_SPECT_FW_SIZE);
+        return LT_OK;
+    }
+#endif
 
     // Setup a request pointer to l2 buffer, which is placed in handle
     struct lt_l2_get_info_req_t *p_l2_req = (struct lt_l2_get_info_req_t *)h->l2.buff;
@@ -330,17 +1183,35 @@ lt_ret_t lt_get_info_spect_fw_ver(lt_handle_t *h, uint8_t *ver)
     }
 
     memcpy(ver, ((struct lt_l2_get_info_rsp_t *)h->l2.buff)->object, LT_L2_GET_INFO_SPECT_FW_SIZE);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache) {
+        memcpy(h->info_cache->spect_fw_ver, ver, LT_L2_GET_INFO_SPECT_FW_SIZE);
+        h->info_cache->valid |= LT_GET_INFO_CACHE_SPECT_FW_VER;
+    }
+#endif
 
     return LT_OK;
 }
 
-lt_ret_t lt_get_info_fw_bank(lt_handle_t *h, const bank_id_t bank_id, uint8_t *header, const uint16_t max_len)
+#if LT_GET_INFO_CACHE
+/** Index of bank in `lt_fw_info_t.banks`, FW_BANK_FW1 and FW_BANK_FW2 are 1 and 2, SPECT banks 17 and 18 */
+static uint8_t lt_fw_bank_index(const bank_id_t bank_id)
 {
-    if (!h || !header || max_len < LT_L2_GET_INFO_FW_HEADER_SIZE
-        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
-            && (bank_id != FW_BANK_SPECT2))) {
-        return LT_PARAM_ERR;
+    return (uint8_t)(((bank_id & 0x10u) ? 2u : 0u) + (bank_id & 0x0Fu) - 1u);
+}
+#endif
+
+/** Reads header of the bank into `header` of at least LT_L2_GET_INFO_FW_HEADER_SIZE bytes and its length into `len` */
+static lt_ret_t lt_get_info_fw_bank_read(lt_handle_t *h, const bank_id_t bank_id, uint8_t *header, uint8_t *len)
+{
+#if LT_GET_INFO_CACHE
+    const uint8_t i = lt_fw_bank_index(bank_id);
+    if (h->info_cache && (h->info_cache->valid & LT_GET_INFO_CACHE_FW_BANK(i))) {
+        *len = h->info_cache->fw_bank_len[i];
+        memcpy(header, h->info_cache->fw_bank[i], *len);
+        return LT_OK;
     }
+#endif
 
     // Setup a request pointer to l2 buffer, which is placed in handle
     struct lt_l2_get_info_req_t *p_l2_req = (struct lt_l2_get_info_req_t *)h->l2.buff;
@@ -368,169 +1239,253 @@ lt_ret_t lt_get_info_fw_bank(lt_handle_t *h, const bank_id_t bank_id, uint8_t *h
         return LT_FAIL;
     }
 
-    memcpy(header, ((struct lt_l2_get_info_rsp_t *)h->l2.buff)->object, p_l2_resp->rsp_len);
+    *len = p_l2_resp->rsp_len;
+    memcpy(header, ((struct lt_l2_get_info_rsp_t *)h->l2.buff)->object, *len);
+#if LT_GET_INFO_CACHE
+    if (h->info_cache) {
+        h->info_cache->fw_bank_len[i] = *len;
+        memcpy(h->info_cache->fw_bank[i], header, *len);
+        h->info_cache->valid |= LT_GET_INFO_CACHE_FW_BANK(i);
+    }
+#endif
 
     return LT_OK;
 }
 
-lt_ret_t lt_session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index, const uint8_t *shipriv,
-                          const uint8_t *shipub)
+lt_ret_t lt_get_info_fw_bank(lt_handle_t *h, const bank_id_t bank_id, uint8_t *header, const uint16_t max_len)
 {
-    if (!h || !stpub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !shipriv || !shipub) {
+    if (!h || !header || max_len < LT_L2_GET_INFO_FW_HEADER_SIZE
+        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
+            && (bank_id != FW_BANK_SPECT2))) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    session_state_t state = {0};
-
-    lt_ret_t ret = lt_out__session_start(h, pkey_index, &state);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    struct lt_l2_handshake_req_t *p_req = (struct lt_l2_handshake_req_t *)h->l2.buff;
-    uint8_t dbg[32];
-    memcpy(dbg, p_req->e_hpub, 32);
+    uint8_t len;
+    return lt_get_info_fw_bank_read(h, bank_id, header, &len);
+}
 
-    ret = lt_l2_send(&h->l2);
-    if (ret != LT_OK) {
-        return ret;
-    }
-    ret = lt_l2_receive(&h->l2);
-    if (ret != LT_OK) {
-        return ret;
+/** Fills `info` from header of `len` bytes in either layout */
+static void lt_fw_bank_info_parse(const uint8_t *header, const uint8_t len, lt_fw_bank_info_t *info)
+{
+    memset(info, 0, sizeof(lt_fw_bank_info_t));
+
+    if (len == LT_L2_GET_INFO_FW_HEADER_SIZE_BOOT_V1) {
+        const struct header_boot_v1_t *v1 = (const struct header_boot_v1_t *)header;
+        info->layout = 1;
+        info->type = (uint16_t)lt_wire_ld32(v1->type);
+        info->version = lt_wire_ld32(v1->version);
+        info->size = lt_wire_ld32(v1->size);
+        info->git_hash = lt_wire_ld32(v1->git_hash);
+        memcpy(info->hash, v1->hash, sizeof(v1->hash));
+    }
+    else if (len == LT_L2_GET_INFO_FW_HEADER_SIZE_BOOT_V2) {
+        const struct header_boot_v2_t *v2 = (const struct header_boot_v2_t *)header;
+        info->layout = 2;
+        info->header_version = v2->header_version;
+        info->type = lt_wire_ld16(&v2->type);
+        info->version = lt_wire_ld32(&v2->ver);
+        info->size = lt_wire_ld32(&v2->size);
+        info->git_hash = lt_wire_ld32(&v2->git_hash);
+        memcpy(info->hash, v2->hash, sizeof(v2->hash));
+        info->pair_version = lt_wire_ld32(&v2->pair_version);
     }
-
-    ret = lt_in__session_start(h, stpub, pkey_index, shipriv, shipub, &state);
-    memset(&state, 0, sizeof(session_state_t));
-
-    return ret;
 }
 
-lt_ret_t lt_session_abort(lt_handle_t *h)
+lt_ret_t lt_get_info_fw_all(lt_handle_t *h, lt_fw_info_t *info)
 {
-    if (!h) {
+    if (!h || !info) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    lt_l3_invalidate_host_session_data(&h->l3);
-
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_encrypted_session_abt_req_t *p_l2_req = (struct lt_l2_encrypted_session_abt_req_t *)h->l2.buff;
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_encrypted_session_abt_rsp_t *p_l2_resp = (struct lt_l2_encrypted_session_abt_rsp_t *)h->l2.buff;
-
-    p_l2_req->req_id = LT_L2_ENCRYPTED_SESSION_ABT_ID;
-    p_l2_req->req_len = LT_L2_ENCRYPTED_SESSION_ABT_LEN;
+    static const bank_id_t banks[LT_FW_BANK_CNT] = {FW_BANK_FW1, FW_BANK_FW2, FW_BANK_SPECT1, FW_BANK_SPECT2};
+    uint8_t header[LT_L2_GET_INFO_FW_HEADER_SIZE];
 
-    lt_ret_t ret = lt_l2_send(&h->l2);
+    lt_ret_t ret = lt_get_info_riscv_fw_ver(h, info->riscv_fw_ver);
     if (ret != LT_OK) {
         return ret;
     }
-    ret = lt_l2_receive(&h->l2);
+    ret = lt_get_info_spect_fw_ver(h, info->spect_fw_ver);
     if (ret != LT_OK) {
         return ret;
     }
 
-    // Check incomming l3 length
-    if (LT_L2_ENCRYPTED_SESSION_ABT_RSP_LEN != (p_l2_resp->rsp_len)) {
-        return LT_FAIL;
+    for (uint8_t i = 0; i < LT_FW_BANK_CNT; i++) {
+        uint8_t len;
+        ret = lt_get_info_fw_bank_read(h, banks[i], header, &len);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        lt_fw_bank_info_parse(header, len, &info->banks[i]);
     }
 
     return LT_OK;
 }
 
-lt_ret_t lt_sleep(lt_handle_t *h, const uint8_t sleep_kind)
+#if LT_EPHEMERAL_KEY_POOL
+lt_ret_t lt_ephemeral_key_pool_refill(lt_handle_t *h)
 {
-    if (!h || ((sleep_kind != LT_L2_SLEEP_KIND_SLEEP) && (sleep_kind != LT_L2_SLEEP_KIND_DEEP_SLEEP))) {
+    if (!h || !h->key_pool || (h->key_pool->cnt > LT_EPHEMERAL_KEY_POOL_SIZE)) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_startup_req_t *p_l2_req = (struct lt_l2_startup_req_t *)h->l2.buff;
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_startup_rsp_t *p_l2_resp = (struct lt_l2_startup_rsp_t *)h->l2.buff;
+    while (h->key_pool->cnt < LT_EPHEMERAL_KEY_POOL_SIZE) {
+        session_state_t *key = &h->key_pool->keys[h->key_pool->cnt];
+        lt_ret_t ret = lt_random_bytes(&h->l2, key->ehpriv, sizeof(key->ehpriv));
+        if (ret != LT_OK) {
+            memset(key, 0, sizeof(session_state_t));
+            return ret;
+        }
+        lt_X25519_scalarmult(key->ehpriv, key->ehpub);
+        h->key_pool->cnt++;
+    }
 
-    p_l2_req->req_id = LT_L2_SLEEP_REQ_ID;
-    p_l2_req->req_len = LT_L2_SLEEP_REQ_LEN;
-    p_l2_req->startup_id = sleep_kind;
+    return LT_OK;
+}
+#endif
 
-    lt_ret_t ret = lt_l2_send(&h->l2);
-    if (ret != LT_OK) {
-        return ret;
-    }
-    ret = lt_l2_receive(&h->l2);
-    if (ret != LT_OK) {
-        return ret;
+lt_ret_t lt_session_ctx_init(lt_session_ctx_t *ctx, const uint8_t *stpub, const pkey_index_t pkey_index,
+                             const uint8_t *shipriv, const uint8_t *shipub)
+{
+    if (!ctx || !stpub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !shipriv || !shipub) {
+        return LT_PARAM_ERR;
     }
 
-    // Check incomming l3 length
-    if (LT_L2_SLEEP_RSP_LEN != (p_l2_resp->rsp_len)) {
-        return LT_FAIL;
-    }
+    lt_session_hash_prefix(shipub, stpub, ctx->hash);
+    memcpy(ctx->stpub, stpub, sizeof(ctx->stpub));
+    ctx->shipriv = shipriv;
+    ctx->pkey_index = pkey_index;
 
     return LT_OK;
 }
 
-lt_ret_t lt_reboot(lt_handle_t *h, const uint8_t startup_id)
+#if LT_SESSION_AUTO
+lt_ret_t lt_session_auto_start(lt_handle_t *h)
 {
-    if (!h || ((startup_id != LT_MODE_APP) && (startup_id != LT_MODE_MAINTENANCE))) {
+    if (!h || !h->session_auto || !h->session_auto->shipriv || !h->session_auto->shipub) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_startup_req_t *p_l2_req = (struct lt_l2_startup_req_t *)h->l2.buff;
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_startup_rsp_t *p_l2_resp = (struct lt_l2_startup_rsp_t *)h->l2.buff;
+    if (h->l3.session == SESSION_ON) {
+        return LT_OK;
+    }
 
-    p_l2_req->req_id = LT_L2_STARTUP_REQ_ID;
-    p_l2_req->req_len = LT_L2_STARTUP_REQ_LEN;
-    p_l2_req->startup_id = startup_id;
+    lt_session_auto_t *sa = h->session_auto;
+    if (!sa->ctx_valid) {
+        uint8_t stpub[32];
+        lt_ret_t ret = lt_get_info_st_pub(h, stpub, sizeof(stpub));
+        if (ret != LT_OK) {
+            return ret;
+        }
+        ret = lt_session_ctx_init(&sa->ctx, stpub, sa->pkey_index, sa->shipriv, sa->shipub);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        sa->ctx_valid = 1;
+    }
 
-    lt_ret_t ret = lt_l2_send(&h->l2);
+    return lt_session_start_ctx(h, &sa->ctx);
+}
+#endif
+
+/** Body of lt_session_start_ctx(), state and SHA256 context hctx are supplied by the caller, who wipes state */
+static lt_ret_t lt_session_handshake(lt_handle_t *h, const lt_session_ctx_t *ctx, session_state_t *state, void *hctx)
+{
+#if LT_ECC_KEY_CACHE
+    // Keys might have been changed by a different host since the previous session
+    lt_ret_t ret_unused = lt_ecc_key_cache_invalidate(h);
+    UNUSED(ret_unused);  // Handle was already checked
+#endif
+#if LT_CONFIG_CACHE
+    // So might the configuration
+    lt_ret_t ret_unused_config = lt_config_cache_invalidate(h);
+    UNUSED(ret_unused_config);  // Handle was already checked
+#endif
+
+    lt_ret_t ret = lt_out__session_start(h, ctx->pkey_index, state);
     if (ret != LT_OK) {
         return ret;
     }
-    ret = lt_l2_receive(&h->l2);
+
+    ret = lt_l2_send(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
 
-    // Check incomming l3 length
-    if (LT_L2_STARTUP_RSP_LEN != (p_l2_resp->rsp_len)) {
-        return LT_FAIL;
+    // TROPIC01 is processing the handshake now, do the part of host's computation which does not need its response
+    ret = lt_session_start_precompute_hctx(hctx, ctx, state);
+    if (ret != LT_OK) {
+        return ret;
     }
 
-    ret = lt_l1_delay(&h->l2, LT_TROPIC01_REBOOT_DELAY_MS);
+    ret = lt_l2_receive(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
 
-    // Update mode variable in handle after reboot
-    ret = lt_update_mode(h);
+    return lt_in__session_start_ctx_hctx(h, hctx, ctx, state);
+}
+
+lt_ret_t lt_session_start_ctx(lt_handle_t *h, const lt_session_ctx_t *ctx)
+{
+    if (!h || !ctx || !ctx->shipriv) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    session_state_t state = {0};
+    struct lt_crypto_sha256_ctx_t hctx;
+
+    lt_ret_t ret = lt_session_handshake(h, ctx, &state, &hctx);
+    memset(&state, 0, sizeof(session_state_t));
+
+    return ret;
+}
+
+lt_ret_t lt_session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index, const uint8_t *shipriv,
+                          const uint8_t *shipub)
+{
+    if (!h || !stpub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !shipriv || !shipub) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    lt_session_ctx_t ctx;
+    lt_ret_t ret = lt_session_ctx_init(&ctx, stpub, pkey_index, shipriv, shipub);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return LT_OK;
+    ret = lt_session_start_ctx(h, &ctx);
+    memset(&ctx, 0, sizeof(ctx));
+
+    return ret;
 }
 
-#ifdef ABAB
-lt_ret_t lt_mutable_fw_erase(lt_handle_t *h, const bank_id_t bank_id)
+lt_ret_t lt_session_abort(lt_handle_t *h)
 {
-    if (!h
-        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
-            && (bank_id != FW_BANK_SPECT2))) {
+    if (!h) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
+
+    lt_l3_invalidate_host_session_data(&h->l3);
+#if LT_SESSION_LIVENESS
+    if (h->l2.liveness) {
+        h->l2.liveness->alive = 0;
+    }
+#endif
 
     // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_mutable_fw_erase_req_t *p_l2_req = (struct lt_l2_mutable_fw_erase_req_t *)h->l2.buff;
+    struct lt_l2_encrypted_session_abt_req_t *p_l2_req = (struct lt_l2_encrypted_session_abt_req_t *)h->l2.buff;
     // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_mutable_fw_erase_rsp_t *p_l2_resp = (struct lt_l2_mutable_fw_erase_rsp_t *)h->l2.buff;
+    struct lt_l2_encrypted_session_abt_rsp_t *p_l2_resp = (struct lt_l2_encrypted_session_abt_rsp_t *)h->l2.buff;
 
-    p_l2_req->req_id = LT_L2_MUTABLE_FW_ERASE_REQ_ID;
-    p_l2_req->req_len = LT_L2_MUTABLE_FW_ERASE_REQ_LEN;
-    p_l2_req->bank_id = bank_id;
+    p_l2_req->req_id = LT_L2_ENCRYPTED_SESSION_ABT_ID;
+    p_l2_req->req_len = LT_L2_ENCRYPTED_SESSION_ABT_LEN;
 
     lt_ret_t ret = lt_l2_send(&h->l2);
     if (ret != LT_OK) {
@@ -541,107 +1496,57 @@ lt_ret_t lt_mutable_fw_erase(lt_handle_t *h, const bank_id_t bank_id)
         return ret;
     }
 
-    if (LT_L2_MUTABLE_FW_ERASE_RSP_LEN != (p_l2_resp->rsp_len)) {
+    // Check incomming l3 length
+    if (LT_L2_ENCRYPTED_SESSION_ABT_RSP_LEN != (p_l2_resp->rsp_len)) {
         return LT_FAIL;
     }
 
     return LT_OK;
 }
 
-lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *fw_data, const uint16_t fw_data_size, bank_id_t bank_id)
+#if LT_SESSION_LIVENESS
+bool lt_session_is_alive(lt_handle_t *h)
 {
-    if (!h || !fw_data || fw_data_size > LT_MUTABLE_FW_UPDATE_SIZE_MAX
-        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
-            && (bank_id != FW_BANK_SPECT2))) {
-        return LT_PARAM_ERR;
+    if (!h) {
+        return false;
     }
+    LT_HANDLE_LOCK(h);
 
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_mutable_fw_update_req_t *p_l2_req = (struct lt_l2_mutable_fw_update_req_t *)h->l2.buff;
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_mutable_fw_update_rsp_t *p_l2_resp = (struct lt_l2_mutable_fw_update_rsp_t *)h->l2.buff;
-
-    uint16_t loops = fw_data_size / 128;
-    uint16_t rest = fw_data_size % 128;
-
-    for (int16_t i = 0; i < loops; i++) {
-        p_l2_req->req_id = LT_L2_MUTABLE_FW_UPDATE_REQ_ID;
-        p_l2_req->req_len = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN_MIN + 128;
-        p_l2_req->bank_id = bank_id;
-        p_l2_req->offset = i * 128;
-        memcpy(p_l2_req->data, fw_data + (i * 128), 128);
-
-        lt_ret_t ret = lt_l2_send(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
-        ret = lt_l2_receive(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
-
-        if (LT_L2_MUTABLE_FW_UPDATE_RSP_LEN != (p_l2_resp->rsp_len)) {
-            return LT_FAIL;
-        }
+    lt_liveness_t *l = h->l2.liveness;
+    if (h->l3.session != SESSION_ON) {
+        return false;
     }
-
-    if (rest != 0) {
-        p_l2_req->req_id = LT_L2_MUTABLE_FW_UPDATE_REQ_ID;
-        p_l2_req->req_len = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN_MIN + rest;
-        p_l2_req->bank_id = bank_id;
-        p_l2_req->offset = loops * 128;
-        memcpy(p_l2_req->data, fw_data + (loops * 128), rest);
-
-        lt_ret_t ret = lt_l2_send(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
-        ret = lt_l2_receive(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
-
-        if (LT_L2_MUTABLE_FW_UPDATE_RSP_LEN != (p_l2_resp->rsp_len)) {
-            return LT_FAIL;
+    if (!l) {
+        return true;
+    }
+    if (l->alive && l->probe_after_ms && ((uint32_t)(l->time_us() - l->seen_us) / 1000 >= l->probe_after_ms)) {
+        // Nothing was heard of the session for long, a lost one fails the ping and is noted by the observers
+        uint8_t msg = 0, echo;
+        l->probes++;
+        if (lt_ping(h, &msg, &echo, sizeof(msg)) != LT_OK) {
+            return false;
         }
     }
 
-    return LT_OK;
+    return l->alive;
 }
-#elif ACAB
-lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *update_request)
+#endif
+
+lt_ret_t lt_sleep(lt_handle_t *h, const uint8_t sleep_kind)
 {
-    if (!h || !update_request) {
+    if (!h || ((sleep_kind != LT_L2_SLEEP_KIND_SLEEP) && (sleep_kind != LT_L2_SLEEP_KIND_DEEP_SLEEP))) {
         return LT_PARAM_ERR;
     }
-
-    // This structure reflects incomming data and is used for passing those data into l2 frame
-    struct data_format_t {
-        uint8_t req_len;        /**< Length byte */
-        uint8_t signature[64];  /**< Signature of SHA256 hash of all following data in this packet */
-        uint8_t hash[32];       /**< SHA256 HASH of first FW chunk of data sent using Mutable_FW_Update_Data */
-        uint16_t type;          /**< FW type which is going to be updated */
-        uint8_t padding;        /**< Padding, zero value */
-        uint8_t header_version; /**< Version of used header */
-        uint32_t version;       /**< Version of FW */
-    } __attribute__((__packed__));
+    LT_HANDLE_LOCK(h);
 
     // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_mutable_fw_update_req_t *p_l2_req = (struct lt_l2_mutable_fw_update_req_t *)h->l2.buff;
+    struct lt_l2_startup_req_t *p_l2_req = (struct lt_l2_startup_req_t *)h->l2.buff;
     // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_mutable_fw_update_rsp_t *p_l2_resp = (struct lt_l2_mutable_fw_update_rsp_t *)h->l2.buff;
-
-    // Setup a pointer to incomming data
-    struct data_format_t *data_p = (struct data_format_t *)(update_request);
+    struct lt_l2_startup_rsp_t *p_l2_resp = (struct lt_l2_startup_rsp_t *)h->l2.buff;
 
-    p_l2_req->req_id = LT_L2_MUTABLE_FW_UPDATE_REQ_ID;
-    p_l2_req->req_len = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN;
-    memcpy(p_l2_req->signature, data_p->signature, 64);
-    memcpy(p_l2_req->hash, data_p->hash, 32);
-    p_l2_req->type = data_p->type;
-    p_l2_req->padding = data_p->padding;
-    p_l2_req->header_version = data_p->header_version;
-    p_l2_req->version = data_p->version;
+    p_l2_req->req_id = LT_L2_SLEEP_REQ_ID;
+    p_l2_req->req_len = LT_L2_SLEEP_REQ_LEN;
+    p_l2_req->startup_id = sleep_kind;
 
     lt_ret_t ret = lt_l2_send(&h->l2);
     if (ret != LT_OK) {
@@ -652,391 +1557,664 @@ lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *update_request)
         return ret;
     }
 
-    if (LT_L2_MUTABLE_FW_UPDATE_RSP_LEN != (p_l2_resp->rsp_len)) {
+    // Check incomming l3 length
+    if (LT_L2_SLEEP_RSP_LEN != (p_l2_resp->rsp_len)) {
         return LT_FAIL;
     }
 
+#if LT_IDLE_SLEEP
+    if (h->l2.idle) {
+        // TROPIC01 ends secure session when it goes to sleep, the host forgets it as well
+        h->l2.idle->resume = (h->l3.session == SESSION_ON);
+        lt_l3_invalidate_host_session_data(&h->l3);
+        h->l2.idle->asleep = 1;
+        h->l2.idle->stats.sleeps++;
+    }
+#endif
+
     return LT_OK;
 }
 
-lt_ret_t lt_mutable_fw_update_data(lt_handle_t *h, const uint8_t *update_data, const uint16_t update_data_size)
+#if LT_IDLE_SLEEP
+lt_ret_t lt_idle_poll(lt_handle_t *h)
 {
-    if (!h || !update_data || update_data_size > LT_MUTABLE_FW_UPDATE_SIZE_MAX) {
+    if (!h || !h->l2.idle || !h->l2.idle->time_us) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_mutable_fw_update_data_req_t *p2_l2_req = (struct lt_l2_mutable_fw_update_data_req_t *)h->l2.buff;
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_mutable_fw_update_rsp_t *p_l2_resp = (struct lt_l2_mutable_fw_update_rsp_t *)h->l2.buff;
-
-    // Data consist of "request" and "data" parts,
-    // 'data' byte chunks are taken from following index:
-    int chunk_index = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1;
-
-    do {
-        uint8_t len = update_data[chunk_index];
-        p2_l2_req->req_id = TS_L2_MUTABLE_FW_UPDATE_DATA_REQ;
-        memcpy((uint8_t *)&p2_l2_req->req_len, update_data + chunk_index, len + 1);
+    lt_idle_t *idle = h->l2.idle;
+    if (idle->asleep || !idle->window_ms) {
+        return LT_OK;
+    }
+    // Unsigned difference is correct also when the clock wrapped around
+    if ((uint64_t)(idle->time_us() - idle->last_us) < (uint64_t)idle->window_ms * 1000) {
+        return LT_OK;
+    }
 
-        lt_ret_t ret = lt_l2_send(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
-        ret = lt_l2_receive(&h->l2);
-        if (ret != LT_OK) {
-            return ret;
-        }
+    return lt_sleep(h, LT_L2_SLEEP_KIND_SLEEP);
+}
+#endif
 
-        if (LT_L2_MUTABLE_FW_UPDATE_RSP_LEN != (p_l2_resp->rsp_len)) {
-            return LT_FAIL;
-        }
+#if LT_DEADLINE
+lt_ret_t lt_deadline_set(lt_handle_t *h, const uint32_t at_us)
+{
+    if (!h || !h->l2.deadline || !h->l2.deadline->time_us) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
 
-        chunk_index += len + 1;
-    } while ((chunk_index) < update_data_size);
+    h->l2.deadline->at_us = at_us;
+    h->l2.deadline->armed = 1;
 
     return LT_OK;
 }
-#else
-#error "Undefined silicon revision. Please define either ABAB or ACAB."
-#endif
 
-lt_ret_t lt_get_log_req(lt_handle_t *h, uint8_t *log_msg, uint16_t *log_msg_len)
+lt_ret_t lt_deadline_clear(lt_handle_t *h)
 {
-    if (!h || !log_msg || !log_msg_len) {
+    if (!h || !h->l2.deadline) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_get_log_req_t *p_l2_req = (struct lt_l2_get_log_req_t *)h->l2.buff;
-    // Setup a request pointer to l2 buffer with response data
-    struct lt_l2_get_log_rsp_t *p_l2_resp = (struct lt_l2_get_log_rsp_t *)h->l2.buff;
+    h->l2.deadline->armed = 0;
 
-    p_l2_req->req_id = LT_L2_GET_LOG_REQ_ID;
-    p_l2_req->req_len = LT_L2_GET_LOG_REQ_LEN;
+    return LT_OK;
+}
+#endif
 
-    lt_ret_t ret = lt_l2_send(&h->l2);
-    if (ret != LT_OK) {
-        return ret;
-    }
-    ret = lt_l2_receive(&h->l2);
-    if (ret != LT_OK) {
-        return ret;
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_spi_speed_set(lt_handle_t *h, const uint32_t hz, uint32_t *actual_hz)
+{
+    if (!h || !hz) {
+        return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    *log_msg_len = p_l2_resp->rsp_len;
-    memcpy(log_msg, p_l2_resp->log_msg, p_l2_resp->rsp_len);
+    uint32_t actual;
+    lt_ret_t ret = lt_spi_tune_set(&h->l2, hz, &actual);
+    if ((ret == LT_OK) && actual_hz) {
+        *actual_hz = actual;
+    }
 
-    return LT_OK;
+    return ret;
 }
+#endif
 
-lt_ret_t lt_ping(lt_handle_t *h, const uint8_t *msg_out, uint8_t *msg_in, const uint16_t len)
+#if LT_TUNE_PERSIST
+lt_ret_t lt_tune_export(lt_handle_t *h, uint8_t *buff, const uint16_t max_len, uint16_t *len)
 {
-    if (!h || !msg_out || !msg_in || (len > PING_LEN_MAX)) {
+    if (!h || !h->tune_store || !buff || !len) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret = lt_out__ping(h, msg_out, len);
+    lt_ret_t ret = lt_tune_key_read(h);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    return lt_tune_write(h, buff, max_len, len);
+}
+
+lt_ret_t lt_tune_import(lt_handle_t *h, const uint8_t *buff, const uint16_t len)
+{
+    if (!h || !h->tune_store || !buff) {
+        return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    lt_ret_t ret = lt_tune_key_read(h);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__ping(h, msg_in, len);
+    return lt_tune_read(h, buff, len);
 }
 
-lt_ret_t lt_pairing_key_write(lt_handle_t *h, const uint8_t *pairing_pub, const uint8_t slot)
+lt_ret_t lt_tune_save(lt_handle_t *h)
 {
-    if (!h || !pairing_pub || (slot > 3)) {
+    if (!h || !h->tune_store || !h->tune_store->save) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
 
-    lt_ret_t ret = lt_out__pairing_key_write(h, pairing_pub, slot);
+    uint8_t buff[LT_TUNE_EXPORT_SIZE_MAX];
+    uint16_t len;
+    lt_ret_t ret = lt_tune_export(h, buff, sizeof(buff), &len);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    return h->tune_store->save(h->tune_store->key, buff, len, h->tune_store->ctx);
+}
+#endif
+
+#if LT_REBOOT_POLL
+/**
+ * Polls CHIP_STATUS until TROPIC01 is ready in the mode given by `startup_id`. When it is not ready in
+ * LT_TROPIC01_REBOOT_TIMEOUT_MS, LT_OK is returned anyway, same as after the fixed delay, and `lt_update_mode()`
+ * tells the mode it is in.
+ */
+static lt_ret_t lt_reboot_wait(lt_handle_t *h, const uint8_t startup_id)
+{
+    uint8_t startup_bit = (startup_id == LT_MODE_MAINTENANCE) ? CHIP_MODE_STARTUP_bit : 0;
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    // Status read right after the response could still come from the chip before the reboot
+    lt_ret_t ret = lt_l1_delay(&h->l2, LT_TROPIC01_REBOOT_DELAY_MIN_MS);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__pairing_key_write(h);
+    for (uint32_t waited_ms = LT_TROPIC01_REBOOT_DELAY_MIN_MS;; waited_ms += LT_TROPIC01_REBOOT_POLL_MS) {
+        ret = lt_chip_status_read(h);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        uint8_t chip_status = h->l2.buff[0];
+        // 0xFF is read when nothing drives MISO, e.g. while TROPIC01 boots
+        if ((chip_status != 0xFF) && (chip_status & CHIP_MODE_ALARM_bit)) {
+            return LT_L1_CHIP_ALARM_MODE;
+        }
+        if ((chip_status != 0xFF) && (chip_status & CHIP_MODE_READY_bit)
+            && ((chip_status & CHIP_MODE_STARTUP_bit) == startup_bit)) {
+            // Mode is known now, lt_update_mode() does not need to read it again with LT_MODE_TRACK
+            lt_l1_mode_observe(&h->l2, chip_status);
+            return LT_OK;
+        }
+        if (waited_ms >= LT_TROPIC01_REBOOT_TIMEOUT_MS) {
+            LT_LOG_S2_WARN(&h->l2, "TROPIC01 not ready after reboot in %" PRIu32 " ms", waited_ms);
+            return LT_OK;
+        }
+
+        ret = lt_l1_delay(&h->l2, LT_TROPIC01_REBOOT_POLL_MS);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
 }
+#endif
 
-lt_ret_t lt_pairing_key_read(lt_handle_t *h, uint8_t *pairing_pub, const uint8_t slot)
+lt_ret_t lt_reboot(lt_handle_t *h, const uint8_t startup_id)
 {
-    if (!h || !pairing_pub || (slot > 3)) {
+    if (!h || ((startup_id != LT_MODE_APP) && (startup_id != LT_MODE_MAINTENANCE))) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret = lt_out__pairing_key_read(h, slot);
-    if (ret != LT_OK) {
-        return ret;
-    }
+#if LT_GET_INFO_CACHE
+    // Firmware and mode of TROPIC01 can change, cached GET_INFO results are not valid anymore
+    lt_ret_t ret_unused = lt_get_info_cache_invalidate(h);
+    UNUSED(ret_unused);  // Handle was already checked
+#endif
+#if LT_ECC_KEY_CACHE
+    // Keys might be changed while the chip is in maintenance mode or by a different host
+    lt_ret_t ret_unused_keys = lt_ecc_key_cache_invalidate(h);
+    UNUSED(ret_unused_keys);  // Handle was already checked
+#endif
+#if LT_CONFIG_CACHE
+    // Configuration might be changed while the chip is in maintenance mode or by a different host
+    lt_ret_t ret_unused_config = lt_config_cache_invalidate(h);
+    UNUSED(ret_unused_config);  // Handle was already checked
+#endif
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_startup_req_t *p_l2_req = (struct lt_l2_startup_req_t *)h->l2.buff;
+    // Setup a request pointer to l2 buffer with response data
+    struct lt_l2_startup_rsp_t *p_l2_resp = (struct lt_l2_startup_rsp_t *)h->l2.buff;
+
+    p_l2_req->req_id = LT_L2_STARTUP_REQ_ID;
+    p_l2_req->req_len = LT_L2_STARTUP_REQ_LEN;
+    p_l2_req->startup_id = startup_id;
+
+    lt_ret_t ret = lt_l2_send(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l2_receive(&h->l2);
+#if LT_MODE_TRACK
+    // CHIP_STATUS observed so far was read before the reboot
+    lt_l1_mode_forget(&h->l2);
+#endif
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__pairing_key_read(h, pairing_pub);
-}
-
-lt_ret_t lt_pairing_key_invalidate(lt_handle_t *h, const uint8_t slot)
-{
-    if (!h || (slot > 3)) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
-
-    lt_ret_t ret = lt_out__pairing_key_invalidate(h, slot);
-    if (ret != LT_OK) {
-        return ret;
+    // Check incomming l3 length
+    if (LT_L2_STARTUP_RSP_LEN != (p_l2_resp->rsp_len)) {
+        return LT_FAIL;
     }
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+#if LT_REBOOT_POLL
+    ret = lt_reboot_wait(h, startup_id);
+#else
+    ret = lt_l1_delay(&h->l2, LT_TROPIC01_REBOOT_DELAY_MS);
+#endif
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    // Update mode variable in handle after reboot
+    ret = lt_update_mode(h);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__pairing_key_invalidate(h);
+    return LT_OK;
 }
 
-lt_ret_t lt_r_config_write(lt_handle_t *h, enum CONFIGURATION_OBJECTS_REGS addr, const uint32_t obj)
+#if LT_ENABLE_FW_UPDATE
+/** Reads update image held in memory, `ctx` points to the image */
+static lt_ret_t lt_fw_mem_read(void *ctx, const uint32_t offset, uint8_t *buff, const uint16_t len)
 {
-    if (!h) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    memcpy(buff, (const uint8_t *)ctx + offset, len);
 
-    lt_ret_t ret = lt_out__r_config_write(h, addr, obj);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    return LT_OK;
+}
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+/** Receives the response to a firmware update chunk sent by `lt_fw_chunk_send()` */
+static lt_ret_t lt_fw_chunk_ack(lt_handle_t *h)
+{
+    lt_ret_t ret = lt_l2_receive(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    if (LT_L2_MUTABLE_FW_UPDATE_RSP_LEN != ((struct lt_l2_mutable_fw_update_rsp_t *)h->l2.buff)->rsp_len) {
+        return LT_FAIL;
     }
 
-    return lt_in__r_config_write(h);
+    return LT_OK;
 }
 
-lt_ret_t lt_r_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj)
+#ifdef ABAB
+lt_ret_t lt_mutable_fw_erase(lt_handle_t *h, const bank_id_t bank_id)
 {
-    if (!h || !obj) {
+    if (!h
+        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
+            && (bank_id != FW_BANK_SPECT2))) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
+
+#if LT_GET_INFO_CACHE
+    // Firmware and mode of TROPIC01 can change, cached GET_INFO results are not valid anymore
+    lt_ret_t ret_unused = lt_get_info_cache_invalidate(h);
+    UNUSED(ret_unused);  // Handle was already checked
+#endif
+
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_mutable_fw_erase_req_t *p_l2_req = (struct lt_l2_mutable_fw_erase_req_t *)h->l2.buff;
+    // Setup a request pointer to l2 buffer with response data
+    struct lt_l2_mutable_fw_erase_rsp_t *p_l2_resp = (struct lt_l2_mutable_fw_erase_rsp_t *)h->l2.buff;
+
+    p_l2_req->req_id = LT_L2_MUTABLE_FW_ERASE_REQ_ID;
+    p_l2_req->req_len = LT_L2_MUTABLE_FW_ERASE_REQ_LEN;
+    p_l2_req->bank_id = bank_id;
 
-    lt_ret_t ret = lt_out__r_config_read(h, addr);
+    lt_ret_t ret = lt_l2_send(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l2_receive(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    if (LT_L2_MUTABLE_FW_ERASE_RSP_LEN != (p_l2_resp->rsp_len)) {
+        return LT_FAIL;
     }
 
-    return lt_in__r_config_read(h, obj);
+    return LT_OK;
 }
 
-lt_ret_t lt_r_config_erase(lt_handle_t *h)
+/** Size of update image chunk written by one request */
+#define LT_FW_CHUNK_SIZE_MAX 128u
+
+/** Reads the chunk of update image at `offset`, `len` is set to its size, 0 behind the end of the image */
+static lt_ret_t lt_fw_chunk_next(lt_fw_read_cb_t read, void *ctx, const uint32_t offset, const uint32_t size,
+                                 uint8_t *chunk, uint16_t *len)
 {
-    if (!h) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    *len = ((size - offset) < LT_FW_CHUNK_SIZE_MAX) ? (size - offset) : LT_FW_CHUNK_SIZE_MAX;
 
-    lt_ret_t ret = lt_out__r_config_erase(h);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    return *len ? read(ctx, offset, chunk, *len) : LT_OK;
+}
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
+/** Sends the chunk of update image at `offset` to be written into `bank_id`, response is left in L2 layer */
+static lt_ret_t lt_fw_chunk_send(lt_handle_t *h, const uint8_t *chunk, const uint16_t len, const uint32_t offset,
+                                 bank_id_t bank_id)
+{
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_mutable_fw_update_req_t *p_l2_req = (struct lt_l2_mutable_fw_update_req_t *)h->l2.buff;
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    p_l2_req->req_id = LT_L2_MUTABLE_FW_UPDATE_REQ_ID;
+    p_l2_req->req_len = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN_MIN + len;
+    p_l2_req->bank_id = bank_id;
+    LT_L2_SET16(p_l2_req, offset, offset);
+    memcpy(p_l2_req->data, chunk, len);
 
-    return lt_in__r_config_erase(h);
+    return lt_l2_send(&h->l2);
 }
 
-lt_ret_t lt_i_config_write(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, const uint8_t bit_index)
+lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *fw_data, const uint16_t fw_data_size, bank_id_t bank_id)
 {
-    if (!h || (bit_index > 31)) {
+    if (!fw_data) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
-
-    lt_ret_t ret = lt_out__i_config_write(h, addr, bit_index);
-    if (ret != LT_OK) {
-        return ret;
-    }
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    return lt_mutable_fw_update_stream(h, lt_fw_mem_read, (void *)(uintptr_t)fw_data, fw_data_size, bank_id);
+}
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
+lt_ret_t lt_mutable_fw_update_stream(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx, const uint32_t fw_data_size,
+                                     bank_id_t bank_id)
+{
+    struct lt_fw_update_t u = {.read = read, .read_ctx = ctx, .size = fw_data_size};
 
-    return lt_in__i_config_write(h);
+    return lt_mutable_fw_update_resume(h, &u, bank_id);
 }
 
-lt_ret_t lt_i_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj)
+lt_ret_t lt_mutable_fw_update_resume(lt_handle_t *h, struct lt_fw_update_t *u, bank_id_t bank_id)
 {
-    if (!h || !obj) {
+    if (!h || !u || !u->read || u->size > LT_MUTABLE_FW_UPDATE_SIZE_MAX || (u->cursor > u->size)
+        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
+            && (bank_id != FW_BANK_SPECT2))) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret = lt_out__i_config_read(h, addr);
-    if (ret != LT_OK) {
-        return ret;
-    }
+#if LT_GET_INFO_CACHE
+    // Firmware and mode of TROPIC01 can change, cached GET_INFO results are not valid anymore
+    lt_ret_t ret_unused = lt_get_info_cache_invalidate(h);
+    UNUSED(ret_unused);  // Handle was already checked
+#endif
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    // Next chunk is read while TROPIC01 writes the current one, L2 buffer then holds the response
+    uint8_t next[LT_FW_CHUNK_SIZE_MAX];
+    uint32_t offset = u->cursor;
+    uint16_t len;
+    lt_ret_t ret = lt_fw_chunk_next(u->read, u->read_ctx, offset, u->size, next, &len);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    while (len) {
+        ret = lt_fw_chunk_send(h, next, len, offset, bank_id);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        offset += len;
+        lt_ret_t ret_read = lt_fw_chunk_next(u->read, u->read_ctx, offset, u->size, next, &len);
+
+        ret = lt_fw_chunk_ack(h);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        u->cursor = offset;
+        u->chunks++;
+        if (u->progress) {
+            u->progress(u->progress_ctx, u);
+        }
+        if (ret_read != LT_OK) {
+            return ret_read;
+        }
     }
 
-    return lt_in__i_config_read(h, obj);
+    return LT_OK;
 }
-
-lt_ret_t lt_r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size)
+#elif ACAB
+lt_ret_t lt_mutable_fw_update(lt_handle_t *h, const uint8_t *update_request)
 {
-    if (!h || !data || size < R_MEM_DATA_SIZE_MIN || size > R_MEM_DATA_SIZE_MAX || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+    if (!h || !update_request) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
+
+#if LT_GET_INFO_CACHE
+    // Firmware and mode of TROPIC01 can change, cached GET_INFO results are not valid anymore
+    lt_ret_t ret_unused = lt_get_info_cache_invalidate(h);
+    UNUSED(ret_unused);  // Handle was already checked
+#endif
+
+    // This structure reflects incomming data and is used for passing those data into l2 frame
+    struct data_format_t {
+        uint8_t req_len;        /**< Length byte */
+        uint8_t signature[64];  /**< Signature of SHA256 hash of all following data in this packet */
+        uint8_t hash[32];       /**< SHA256 HASH of first FW chunk of data sent using Mutable_FW_Update_Data */
+        uint16_t type;          /**< FW type which is going to be updated */
+        uint8_t padding;        /**< Padding, zero value */
+        uint8_t header_version; /**< Version of used header */
+        uint32_t version;       /**< Version of FW */
+    } __attribute__((__packed__));
+
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_mutable_fw_update_req_t *p_l2_req = (struct lt_l2_mutable_fw_update_req_t *)h->l2.buff;
+    // Setup a request pointer to l2 buffer with response data
+    struct lt_l2_mutable_fw_update_rsp_t *p_l2_resp = (struct lt_l2_mutable_fw_update_rsp_t *)h->l2.buff;
+
+    // Setup a pointer to incomming data
+    struct data_format_t *data_p = (struct data_format_t *)(update_request);
+
+    p_l2_req->req_id = LT_L2_MUTABLE_FW_UPDATE_REQ_ID;
+    p_l2_req->req_len = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN;
+    memcpy(p_l2_req->signature, data_p->signature, 64);
+    memcpy(p_l2_req->hash, data_p->hash, 32);
+    LT_L2_SET16(p_l2_req, type, data_p->type);
+    p_l2_req->padding = data_p->padding;
+    p_l2_req->header_version = data_p->header_version;
+    LT_L2_SET32(p_l2_req, version, data_p->version);
 
-    lt_ret_t ret = lt_out__r_mem_data_write(h, udata_slot, data, size);
+    lt_ret_t ret = lt_l2_send(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l2_receive(&h->l2);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    if (LT_L2_MUTABLE_FW_UPDATE_RSP_LEN != (p_l2_resp->rsp_len)) {
+        return LT_FAIL;
     }
 
-    return lt_in__r_mem_data_write(h);
+    return LT_OK;
 }
 
-lt_ret_t lt_r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size)
+lt_ret_t lt_mutable_fw_update_data(lt_handle_t *h, const uint8_t *update_data, const uint16_t update_data_size)
 {
-    if (!h || !data || !size || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+    if (!update_data) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+
+    return lt_mutable_fw_update_data_stream(h, lt_fw_mem_read, (void *)(uintptr_t)update_data, update_data_size);
+}
+
+/** Size of the largest update data chunk, its length byte included */
+#define LT_FW_CHUNK_SIZE_MAX (1u + UINT8_MAX)
+
+/**
+ * Reads length byte and data of the update data chunk at `offset`, `len` is set to the number of bytes read, 0 behind
+ * the end of the image
+ */
+static lt_ret_t lt_fw_chunk_next(lt_fw_read_cb_t read, void *ctx, const uint32_t offset, const uint32_t size,
+                                 uint8_t *chunk, uint16_t *len)
+{
+    *len = 0;
+    if (offset >= size) {
+        return LT_OK;
     }
 
-    lt_ret_t ret = lt_out__r_mem_data_read(h, udata_slot);
+    lt_ret_t ret = read(ctx, offset, chunk, 1);
     if (ret != LT_OK) {
         return ret;
     }
-
+    if (offset + 1 + chunk[0] > size) {
+        return LT_FAIL;
+    }
+    *len = 1 + chunk[0];
+
+    return read(ctx, offset + 1, chunk + 1, chunk[0]);
+}
+
+/** Sends the update data chunk (length byte and data), response is left in L2 layer */
+static lt_ret_t lt_fw_chunk_send(lt_handle_t *h, const uint8_t *chunk, const uint16_t len, const uint32_t offset,
+                                 bank_id_t bank_id)
+{
+    UNUSED(offset);   // Chunks are chained by their hashes
+    UNUSED(bank_id);  // Chip handles banks on its own
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_mutable_fw_update_data_req_t *p2_l2_req = (struct lt_l2_mutable_fw_update_data_req_t *)h->l2.buff;
+
+    p2_l2_req->req_id = TS_L2_MUTABLE_FW_UPDATE_DATA_REQ;
+    memcpy((uint8_t *)&p2_l2_req->req_len, chunk, len);
+
+    return lt_l2_send(&h->l2);
+}
+
+lt_ret_t lt_mutable_fw_update_data_stream(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx,
+                                          const uint32_t update_data_size)
+{
+    // Data consist of "request" and "data" parts,
+    // 'data' byte chunks are taken from following index:
+    struct lt_fw_update_t u
+        = {.read = read, .read_ctx = ctx, .size = update_data_size, .cursor = LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1};
+
+    if (update_data_size <= u.cursor) {
+        return LT_PARAM_ERR;
+    }
+
+    return lt_mutable_fw_update_data_resume(h, &u);
+}
+
+lt_ret_t lt_mutable_fw_update_data_resume(lt_handle_t *h, struct lt_fw_update_t *u)
+{
+    if (!h || !u || !u->read || (u->cursor < LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1) || (u->cursor > u->size)
+        || u->size > LT_MUTABLE_FW_UPDATE_SIZE_MAX) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    // Next chunk (length byte and data) is read while TROPIC01 writes the current one
+    uint8_t next[LT_FW_CHUNK_SIZE_MAX];
+    uint32_t chunk_index = u->cursor;
+    uint16_t len;
+    lt_ret_t ret = lt_fw_chunk_next(u->read, u->read_ctx, chunk_index, u->size, next, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    while (len) {
+        ret = lt_fw_chunk_send(h, next, len, chunk_index, FW_BANK_FW1);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        chunk_index += len;
+        lt_ret_t ret_read = lt_fw_chunk_next(u->read, u->read_ctx, chunk_index, u->size, next, &len);
+
+        ret = lt_fw_chunk_ack(h);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        u->cursor = chunk_index;
+        u->chunks++;
+        if (u->progress) {
+            u->progress(u->progress_ctx, u);
+        }
+        if (ret_read != LT_OK) {
+            return ret_read;
+        }
+    }
+
+    return LT_OK;
+}
+#else
+#error "Undefined silicon revision. Please define either ABAB or ACAB."
+#endif
+#endif
+
+lt_ret_t lt_get_log_req(lt_handle_t *h, uint8_t *log_msg, uint16_t *log_msg_len)
+{
+    if (!h || !log_msg || !log_msg_len) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_get_log_req_t *p_l2_req = (struct lt_l2_get_log_req_t *)h->l2.buff;
+    // Setup a request pointer to l2 buffer with response data
+    struct lt_l2_get_log_rsp_t *p_l2_resp = (struct lt_l2_get_log_rsp_t *)h->l2.buff;
+
+    p_l2_req->req_id = LT_L2_GET_LOG_REQ_ID;
+    p_l2_req->req_len = LT_L2_GET_LOG_REQ_LEN;
+
+    lt_ret_t ret = lt_l2_send(&h->l2);
+    if (ret != LT_OK) {
+        return ret;
+    }
+#if LT_USE_SPI_TRANSFER_BUF
+    // Message is received straight into the caller's buffer
+    ret = lt_l2_receive_to(&h->l2, log_msg, GET_LOG_MAX_MSG_LEN);
+#else
+    ret = lt_l2_receive(&h->l2);
+#endif
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    *log_msg_len = p_l2_resp->rsp_len;
+#if !LT_USE_SPI_TRANSFER_BUF
+    memcpy(log_msg, p_l2_resp->log_msg, p_l2_resp->rsp_len);
+#endif
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ping(lt_handle_t *h, const uint8_t *msg_out, uint8_t *msg_in, const uint16_t len)
+{
+    if (!h || !msg_out || !msg_in || (len > LT_PING_LEN_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ping(h, msg_out, len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
     ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l3_result_recv(h);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__r_mem_data_read(h, data, size);
+    return lt_in__ping(h, msg_in, len);
 }
 
-lt_ret_t lt_r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot)
+lt_ret_t lt_ping_v(lt_handle_t *h, const lt_iovec_t *out, const uint8_t out_cnt, const lt_iovec_out_t *in,
+                   const uint8_t in_cnt)
 {
-    if (!h || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+    size_t out_len, in_len;
+    if (!h || (lt_iov_len(out, out_cnt, &out_len) != LT_OK) || (lt_iov_out_len(in, in_cnt, &in_len) != LT_OK)
+        || (out_len != in_len) || (out_len > LT_PING_LEN_MAX)) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
     }
 
-    lt_ret_t ret = lt_out__r_mem_data_erase(h, udata_slot);
+    ret = lt_out__ping_v(h, out, out_cnt);
     if (ret != LT_OK) {
         return ret;
     }
@@ -1046,24 +2224,176 @@ lt_ret_t lt_r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot)
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l3_result_recv(h);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__r_mem_data_erase(h);
+    return lt_in__ping_v(h, in, in_cnt);
 }
 
-lt_ret_t lt_random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len)
+#if LT_L3_VIEWS
+lt_ret_t lt_ping_view(lt_handle_t *h, const uint8_t *msg_out, const uint16_t len, const uint8_t **msg_in)
 {
-    if ((len > RANDOM_VALUE_GET_LEN_MAX) || !h || !buff) {
+    if (!h || !msg_out || !msg_in || (len > LT_PING_LEN_MAX)) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+#if LT_L3_BUFF_POOL
+    // Buffer borrowed only for this call would be wiped and returned before the caller looks at the view
+    if (h->l3_pool && !h->l3.buff) {
+        return LT_PARAM_ERR;
+    }
+#endif
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ping(h, msg_out, len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ping_view(h, msg_in, len);
+}
+#endif
+
+#if LT_RAW_CMD
+lt_ret_t lt_raw_cmd(lt_handle_t *h, const uint8_t *cmd, const uint16_t cmd_len, uint8_t *res,
+                    const uint16_t res_max_len, uint16_t *res_len)
+{
+    if (!h || !cmd || !res || !res_len) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__raw_cmd(h, cmd, cmd_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+#if LT_CONFIG_CACHE
+    const lt_l3_cmd_desc_t *desc_config = lt_l3_cmd_desc_get(cmd[0]);
+    if (desc_config && (desc_config->flags & LT_L3_CMD_CONFIG)) {
+        lt_config_cache_drop(h, LT_CONFIG_SPACE_R);
+        lt_config_cache_drop(h, LT_CONFIG_SPACE_I);
+    }
+#endif
+#if LT_ECC_KEY_CACHE || (LT_ENABLE_R_MEM && LT_RMEM_CACHE)
+    // Cached slot the command changes is dropped, the slot follows command ID in all such commands
+    const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(cmd[0]);
+    uint16_t slot = (cmd_len >= 3) ? (uint16_t)(cmd[1] | (cmd[2] << 8)) : 0;
+#if LT_ECC_KEY_CACHE
+    if (desc && (desc->flags & LT_L3_CMD_ECC_KEYS) && (slot <= ECC_SLOT_31)) {
+        lt_ecc_key_cache_drop(h, (ecc_slot_t)slot);
+    }
+#endif
+#if LT_ENABLE_R_MEM && LT_RMEM_CACHE
+    if (desc && (desc->flags & LT_L3_CMD_R_MEM)) {
+        lt_rmem_cache_drop(h, slot, 1);
+    }
+#endif
+#endif
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__raw_cmd(h, res, res_max_len, res_len);
+}
+#endif
+
+lt_ret_t lt_pairing_key_write(lt_handle_t *h, const uint8_t *pairing_pub, const uint8_t slot)
+{
+    if (!h || !pairing_pub || (slot > 3)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__pairing_key_write(h, pairing_pub, slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__pairing_key_write(h);
+}
+
+lt_ret_t lt_pairing_key_read(lt_handle_t *h, uint8_t *pairing_pub, const uint8_t slot)
+{
+    if (!h || !pairing_pub || (slot > 3)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__pairing_key_read(h, slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__pairing_key_read(h, pairing_pub);
+}
+
+lt_ret_t lt_pairing_key_invalidate(lt_handle_t *h, const uint8_t slot)
+{
+    if (!h || (slot > 3)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
     }
 
-    lt_ret_t ret = lt_out__random_value_get(h, len);
+    ret = lt_out__pairing_key_invalidate(h, slot);
     if (ret != LT_OK) {
         return ret;
     }
@@ -1073,472 +2403,4357 @@ lt_ret_t lt_random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len)
         return ret;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_l3_result_recv(h);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__random_value_get(h, buff, len);
+    return lt_in__pairing_key_invalidate(h);
+}
+
+/** Arguments of pipelined batch of pairing key commands */
+struct lt_pairing_key_batch_t {
+    /** Commands, their statuses and read keys are filled */
+    lt_pairing_key_op_t *ops;
+};
+
+static uint16_t lt_pairing_key_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const struct lt_pairing_key_batch_t *p = ctx;
+    switch (p->ops[i].op) {
+        case LT_PAIRING_KEY_OP_WRITE:
+            return sizeof(struct lt_l3_pairing_key_write_cmd_t);
+        case LT_PAIRING_KEY_OP_READ:
+            return sizeof(struct lt_l3_pairing_key_read_cmd_t);
+        default:
+            return sizeof(struct lt_l3_pairing_key_invalidate_cmd_t);
+    }
+}
+
+static lt_ret_t lt_pairing_key_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const lt_pairing_key_op_t *op = &((const struct lt_pairing_key_batch_t *)ctx)->ops[i];
+    switch (op->op) {
+        case LT_PAIRING_KEY_OP_WRITE:
+            return lt_out__pairing_key_write(h, op->key, op->slot);
+        case LT_PAIRING_KEY_OP_READ:
+            return lt_out__pairing_key_read(h, op->slot);
+        default:
+            return lt_out__pairing_key_invalidate(h, op->slot);
+    }
+}
+
+static lt_ret_t lt_pairing_key_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    lt_pairing_key_op_t *op = &((const struct lt_pairing_key_batch_t *)ctx)->ops[i];
+    lt_ret_t ret;
+    switch (op->op) {
+        case LT_PAIRING_KEY_OP_WRITE:
+            ret = lt_in__pairing_key_write(h);
+            break;
+        case LT_PAIRING_KEY_OP_READ:
+            ret = lt_in__pairing_key_read(h, op->key);
+            break;
+        default:
+            ret = lt_in__pairing_key_invalidate(h);
+            break;
+    }
+    op->status = ret;
+
+    // Result was decrypted, so a failure concerns only this slot and the batch continues
+    return lt_l3_batch_cmd_failed(ret) ? LT_OK : ret;
+}
+
+lt_ret_t lt_pairing_key_batch(lt_handle_t *h, lt_pairing_key_op_t *ops, const uint8_t cnt)
+{
+    if (!h || !ops || !cnt) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        if ((ops[i].slot > PAIRING_KEY_SLOT_INDEX_3) || (ops[i].op > LT_PAIRING_KEY_OP_INVALIDATE)) {
+            return LT_PARAM_ERR;
+        }
+    }
+    LT_HANDLE_LOCK(h);
+
+    for (uint8_t i = 0; i < cnt; i++) {
+        ops[i].status = LT_FAIL;
+    }
+
+    struct lt_pairing_key_batch_t p = {.ops = ops};
+    struct lt_l3_batch_t b = {.n = cnt,
+                              .cmd_len = lt_pairing_key_batch_cmd_len,
+                              .out = lt_pairing_key_batch_out,
+                              .in = lt_pairing_key_batch_in,
+                              .ctx = &p};
+
+    return lt_l3_batch(h, &b);
+}
+
+lt_ret_t lt_r_config_write(lt_handle_t *h, enum CONFIGURATION_OBJECTS_REGS addr, const uint32_t obj)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_CONFIG_CACHE
+    lt_config_cache_drop(h, LT_CONFIG_SPACE_R);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_config_write(h, addr, obj);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_config_write(h);
+}
+
+lt_ret_t lt_r_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj)
+{
+    if (!h || !obj) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_CONFIG_CACHE
+    if (lt_config_cache_get(h, LT_CONFIG_SPACE_R, addr, obj)) {
+        return LT_OK;
+    }
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_config_read(h, addr);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_config_read(h, obj);
+}
+
+lt_ret_t lt_r_config_erase(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_CONFIG_CACHE
+    lt_config_cache_drop(h, LT_CONFIG_SPACE_R);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_config_erase(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_config_erase(h);
+}
+
+lt_ret_t lt_i_config_write(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, const uint8_t bit_index)
+{
+    if (!h || (bit_index > 31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_CONFIG_CACHE
+    lt_config_cache_drop(h, LT_CONFIG_SPACE_I);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__i_config_write(h, addr, bit_index);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__i_config_write(h);
+}
+
+lt_ret_t lt_i_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_REGS addr, uint32_t *obj)
+{
+    if (!h || !obj) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_CONFIG_CACHE
+    if (lt_config_cache_get(h, LT_CONFIG_SPACE_I, addr, obj)) {
+        return LT_OK;
+    }
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__i_config_read(h, addr);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__i_config_read(h, obj);
+}
+
+#if LT_ENABLE_R_MEM
+/** Executes R_Mem_Data_Write command, cached slot is not dropped */
+static lt_ret_t lt_r_mem_data_write_cmd(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data,
+                                        const uint16_t size)
+{
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_mem_data_write(h, udata_slot, data, size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_mem_data_write(h);
+}
+
+lt_ret_t lt_r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size)
+{
+    if (!h || !data || size < R_MEM_DATA_SIZE_MIN || size > R_MEM_DATA_SIZE_MAX || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_RMEM_CACHE
+    lt_rmem_cache_drop(h, udata_slot, 1);
+#endif
+
+    return lt_r_mem_data_write_cmd(h, udata_slot, data, size);
+}
+
+lt_ret_t lt_r_mem_data_write_v(lt_handle_t *h, const uint16_t udata_slot, const lt_iovec_t *iov,
+                               const uint8_t iov_cnt)
+{
+    size_t size;
+    if (!h || (lt_iov_len(iov, iov_cnt, &size) != LT_OK) || size < R_MEM_DATA_SIZE_MIN || size > R_MEM_DATA_SIZE_MAX
+        || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_RMEM_CACHE
+    lt_rmem_cache_drop(h, udata_slot, 1);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_mem_data_write_v(h, udata_slot, iov, iov_cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_mem_data_write(h);
+}
+
+lt_ret_t lt_r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size)
+{
+    if (!h || !data || !size || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_mem_data_read(h, udata_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_mem_data_read(h, data, size);
+}
+
+lt_ret_t lt_r_mem_data_read_v(lt_handle_t *h, const uint16_t udata_slot, const lt_iovec_out_t *iov,
+                              const uint8_t iov_cnt, uint16_t *size)
+{
+    size_t capacity;
+    if (!h || (lt_iov_out_len(iov, iov_cnt, &capacity) != LT_OK) || !size || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_mem_data_read(h, udata_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_mem_data_read_v(h, iov, iov_cnt, size);
+}
+
+#if LT_L3_VIEWS
+lt_ret_t lt_r_mem_data_read_view(lt_handle_t *h, const uint16_t udata_slot, const uint8_t **data, uint16_t *size)
+{
+    if (!h || !data || !size || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+#if LT_L3_BUFF_POOL
+    // Buffer borrowed only for this call would be wiped and returned before the caller looks at the view
+    if (h->l3_pool && !h->l3.buff) {
+        return LT_PARAM_ERR;
+    }
+#endif
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_mem_data_read(h, udata_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_mem_data_read_view(h, data, size);
+}
+#endif
+
+/** Executes R_Mem_Data_Erase command, cached slot is not dropped */
+static lt_ret_t lt_r_mem_data_erase_cmd(lt_handle_t *h, const uint16_t udata_slot)
+{
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__r_mem_data_erase(h, udata_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__r_mem_data_erase(h);
+}
+
+lt_ret_t lt_r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot)
+{
+    if (!h || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_RMEM_CACHE
+    lt_rmem_cache_drop(h, udata_slot, 1);
+#endif
+
+    return lt_r_mem_data_erase_cmd(h, udata_slot);
+}
+
+/** Commands of R-memory batch */
+enum lt_r_mem_batch_op_t { LT_R_MEM_BATCH_READ, LT_R_MEM_BATCH_WRITE, LT_R_MEM_BATCH_ERASE };
+
+/** Arguments of one pipelined batch over consecutive R-memory slots */
+struct lt_r_mem_batch_t {
+    enum lt_r_mem_batch_op_t op;
+    uint16_t first_slot;
+    /** Data of slots, R_MEM_DATA_SIZE_MAX bytes each, read into or written from */
+    uint8_t *rdata;
+    const uint8_t *wdata;
+    /** Sizes of data of slots */
+    uint16_t *rsizes;
+    const uint16_t *wsizes;
+    /** Status of each slot */
+    lt_ret_t *statuses;
+};
+
+static uint16_t lt_r_mem_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const struct lt_r_mem_batch_t *r = ctx;
+    switch (r->op) {
+        case LT_R_MEM_BATCH_READ:
+            return sizeof(struct lt_l3_r_mem_data_read_cmd_t);
+        case LT_R_MEM_BATCH_WRITE:
+            return sizeof(struct lt_l3_r_mem_data_write_cmd_t) - R_MEM_DATA_SIZE_MAX + r->wsizes[i];
+        default:
+            return sizeof(struct lt_l3_r_mem_data_erase_cmd_t);
+    }
+}
+
+// Operation is resolved when the batch is set up, so data of writes are not touched by other operations
+static lt_ret_t lt_r_mem_batch_out_read(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_r_mem_batch_t *r = ctx;
+
+    return lt_out__r_mem_data_read(h, r->first_slot + i);
+}
+
+static lt_ret_t lt_r_mem_batch_out_write(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_r_mem_batch_t *r = ctx;
+
+    return lt_out__r_mem_data_write(h, r->first_slot + i, r->wdata + (i * R_MEM_DATA_SIZE_MAX), r->wsizes[i]);
+}
+
+static lt_ret_t lt_r_mem_batch_out_erase(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_r_mem_batch_t *r = ctx;
+
+    return lt_out__r_mem_data_erase(h, r->first_slot + i);
+}
+
+static lt_ret_t lt_r_mem_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_r_mem_batch_t *r = ctx;
+    lt_ret_t ret;
+    switch (r->op) {
+        case LT_R_MEM_BATCH_READ:
+            r->rsizes[i] = 0;
+            ret = lt_in__r_mem_data_read(h, r->rdata + (i * R_MEM_DATA_SIZE_MAX), &r->rsizes[i]);
+            break;
+        case LT_R_MEM_BATCH_WRITE:
+            ret = lt_in__r_mem_data_write(h);
+            break;
+        default:
+            ret = lt_in__r_mem_data_erase(h);
+            break;
+    }
+    r->statuses[i] = ret;
+
+    // Result was decrypted, so a failure concerns only this slot and the batch continues
+    return lt_l3_batch_cmd_failed(ret) ? LT_OK : ret;
+}
+
+static lt_ret_t lt_r_mem_batch(lt_handle_t *h, const struct lt_r_mem_batch_t *r, const uint16_t slots_cnt)
+{
+    for (uint16_t i = 0; i < slots_cnt; i++) {
+        r->statuses[i] = LT_FAIL;
+    }
+
+    struct lt_l3_batch_t b = {.n = slots_cnt,
+                              .cmd_len = lt_r_mem_batch_cmd_len,
+                              .out = (r->op == LT_R_MEM_BATCH_READ)    ? lt_r_mem_batch_out_read
+                                     : (r->op == LT_R_MEM_BATCH_WRITE) ? lt_r_mem_batch_out_write
+                                                                       : lt_r_mem_batch_out_erase,
+                              .in = lt_r_mem_batch_in,
+                              .ctx = r};
+
+    return lt_l3_batch(h, &b);
+}
+
+lt_ret_t lt_r_mem_data_read_range(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt, uint8_t *data,
+                                  uint16_t *sizes, lt_ret_t *statuses)
+{
+    if (!h || !slots_cnt || (first_slot > R_MEM_DATA_SLOT_MAX) || (slots_cnt > R_MEM_DATA_SLOT_MAX + 1 - first_slot)
+        || !data || !sizes || !statuses) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_r_mem_batch_t r
+        = {.op = LT_R_MEM_BATCH_READ, .first_slot = first_slot, .rdata = data, .rsizes = sizes, .statuses = statuses};
+
+    return lt_r_mem_batch(h, &r, slots_cnt);
+}
+
+lt_ret_t lt_r_mem_data_write_range(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt,
+                                   const uint8_t *data, const uint16_t *sizes, lt_ret_t *statuses)
+{
+    if (!h || !slots_cnt || (first_slot > R_MEM_DATA_SLOT_MAX) || (slots_cnt > R_MEM_DATA_SLOT_MAX + 1 - first_slot)
+        || !data || !sizes || !statuses) {
+        return LT_PARAM_ERR;
+    }
+    for (uint16_t i = 0; i < slots_cnt; i++) {
+        if ((sizes[i] < R_MEM_DATA_SIZE_MIN) || (sizes[i] > R_MEM_DATA_SIZE_MAX)) {
+            return LT_PARAM_ERR;
+        }
+    }
+    LT_HANDLE_LOCK(h);
+
+#if LT_RMEM_CACHE
+    lt_rmem_cache_drop(h, first_slot, slots_cnt);
+#endif
+
+    struct lt_r_mem_batch_t r
+        = {.op = LT_R_MEM_BATCH_WRITE, .first_slot = first_slot, .wdata = data, .wsizes = sizes, .statuses = statuses};
+
+    return lt_r_mem_batch(h, &r, slots_cnt);
+}
+
+lt_ret_t lt_r_mem_data_erase_range(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt,
+                                   lt_ret_t *statuses)
+{
+    if (!h || !slots_cnt || (first_slot > R_MEM_DATA_SLOT_MAX) || (slots_cnt > R_MEM_DATA_SLOT_MAX + 1 - first_slot)
+        || !statuses) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+#if LT_RMEM_CACHE
+    lt_rmem_cache_drop(h, first_slot, slots_cnt);
+#endif
+
+    struct lt_r_mem_batch_t r = {.op = LT_R_MEM_BATCH_ERASE, .first_slot = first_slot, .statuses = statuses};
+
+    return lt_r_mem_batch(h, &r, slots_cnt);
+}
+
+#if LT_RMEM_CACHE
+/** Returns index of entry holding the slot, or -1 */
+static int lt_rmem_cache_find(const lt_rmem_cache_t *c, const uint16_t slot)
+{
+    for (int i = 0; i < LT_RMEM_CACHE_SLOTS; i++) {
+        if (c->entries[i].used && (c->entries[i].slot == slot)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/** Writes pending data of the entry into TROPIC01, erasing the slot first unless it is known to be empty */
+static lt_ret_t lt_rmem_cache_entry_flush(lt_handle_t *h, const int i)
+{
+    lt_rmem_cache_t *c = h->rmem_cache;
+    if (!c->entries[i].dirty) {
+        return LT_OK;
+    }
+
+    if (!c->entries[i].chip_empty) {
+        lt_ret_t ret = lt_r_mem_data_erase_cmd(h, c->entries[i].slot);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        c->entries[i].chip_empty = 1;
+    }
+
+    lt_ret_t ret = lt_r_mem_data_write_cmd(h, c->entries[i].slot, c->entries[i].data, c->entries[i].size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    c->entries[i].chip_empty = 0;
+    c->entries[i].dirty = 0;
+
+    return LT_OK;
+}
+
+/** Returns unused entry or flushes and frees the least recently used one */
+static lt_ret_t lt_rmem_cache_evict(lt_handle_t *h, int *idx)
+{
+    lt_rmem_cache_t *c = h->rmem_cache;
+    int lru = 0;
+    for (int i = 0; i < LT_RMEM_CACHE_SLOTS; i++) {
+        if (!c->entries[i].used) {
+            *idx = i;
+            return LT_OK;
+        }
+        if (c->entries[i].used < c->entries[lru].used) {
+            lru = i;
+        }
+    }
+
+    lt_ret_t ret = lt_rmem_cache_entry_flush(h, lru);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    c->entries[lru].used = 0;
+    *idx = lru;
+
+    return LT_OK;
+}
+
+/** Reads the slot from TROPIC01 into a free entry */
+static lt_ret_t lt_rmem_cache_fill(lt_handle_t *h, const uint16_t slot, int *idx)
+{
+    lt_rmem_cache_t *c = h->rmem_cache;
+    lt_ret_t ret = lt_rmem_cache_evict(h, idx);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    uint16_t size = 0;
+    ret = lt_r_mem_data_read(h, slot, c->entries[*idx].data, &size);
+    if ((ret != LT_OK) && (ret != LT_L3_R_MEM_DATA_READ_SLOT_EMPTY)) {
+        return ret;
+    }
+    c->entries[*idx].slot = slot;
+    c->entries[*idx].size = (ret == LT_OK) ? size : 0;
+    c->entries[*idx].chip_empty = (ret != LT_OK);
+    c->entries[*idx].dirty = 0;
+    c->entries[*idx].used = ++c->tick;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_cache_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size)
+{
+    if (!h || !h->rmem_cache || !data || !size || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    lt_rmem_cache_t *c = h->rmem_cache;
+    int i = lt_rmem_cache_find(c, udata_slot);
+    if (i < 0) {
+        lt_ret_t ret = lt_rmem_cache_fill(h, udata_slot, &i);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+    c->entries[i].used = ++c->tick;
+
+    *size = c->entries[i].size;
+    if (!*size) {
+        return LT_L3_R_MEM_DATA_READ_SLOT_EMPTY;
+    }
+    memcpy(data, c->entries[i].data, *size);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_cache_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size)
+{
+    if (!h || !h->rmem_cache || !data || size < R_MEM_DATA_SIZE_MIN || size > R_MEM_DATA_SIZE_MAX
+        || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    lt_rmem_cache_t *c = h->rmem_cache;
+    int i = lt_rmem_cache_find(c, udata_slot);
+    if (i < 0) {
+        // Current content is read, so writing unchanged data costs neither erase nor write
+        lt_ret_t ret = lt_rmem_cache_fill(h, udata_slot, &i);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+    c->entries[i].used = ++c->tick;
+
+    if ((c->entries[i].size == size) && !memcmp(c->entries[i].data, data, size)) {
+        return LT_OK;
+    }
+    memcpy(c->entries[i].data, data, size);
+    c->entries[i].size = size;
+    c->entries[i].dirty = 1;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_cache_flush(lt_handle_t *h)
+{
+    if (!h || !h->rmem_cache) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    for (int i = 0; i < LT_RMEM_CACHE_SLOTS; i++) {
+        if (h->rmem_cache->entries[i].used) {
+            lt_ret_t ret = lt_rmem_cache_entry_flush(h, i);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_cache_invalidate(lt_handle_t *h)
+{
+    if (!h) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    if (h->rmem_cache) {
+        memset(h->rmem_cache, 0, sizeof(*h->rmem_cache));
+    }
+
+    return LT_OK;
+}
+#endif
+#endif
+
+#if LT_L3_BUFF_POOL
+lt_ret_t lt_l3_buff_pool_init(lt_l3_buff_pool_t *pool, uint8_t *buffs, const uint16_t buff_size, const uint8_t cnt,
+                              const uint32_t wait_ms)
+{
+    if (!pool || !buffs || (buff_size < LT_L3_BUFF_SIZE_MIN) || (buff_size > L3_PACKET_MAX_SIZE) || !cnt
+        || (cnt > LT_L3_BUFF_POOL_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->buffs = buffs;
+    pool->buff_size = buff_size;
+    pool->cnt = cnt;
+    pool->wait_ms = wait_ms;
+    pool->free_mask = (cnt == 32) ? UINT32_MAX : ((1u << cnt) - 1);
+    memset(buffs, 0, (size_t)buff_size * cnt);
+
+    return LT_OK;
+}
+
+static void lt_l3_buff_pool_lock(lt_l3_buff_pool_t *pool)
+{
+    if (pool->lock) {
+        pool->lock(pool->lock_ctx);
+    }
+}
+
+static void lt_l3_buff_pool_unlock(lt_l3_buff_pool_t *pool)
+{
+    if (pool->unlock) {
+        pool->unlock(pool->lock_ctx);
+    }
+}
+
+/**
+ * Takes a free buffer of the pool, returns -1 when all of them are borrowed. Statistics count the `first` and the
+ * `last` failed attempt of one borrower.
+ */
+static int lt_l3_buff_take(lt_l3_buff_pool_t *pool, const bool first, const bool last)
+{
+    int i = -1;
+
+    lt_l3_buff_pool_lock(pool);
+    if (pool->free_mask) {
+        i = __builtin_ctz(pool->free_mask);
+        pool->free_mask &= ~(1u << i);
+        pool->stats.borrows++;
+        pool->stats.in_use++;
+        if (pool->stats.in_use > pool->stats.in_use_max) {
+            pool->stats.in_use_max = pool->stats.in_use;
+        }
+    }
+    else {
+        if (first) {
+            pool->stats.contended++;
+        }
+        if (last) {
+            pool->stats.timeouts++;
+        }
+    }
+    lt_l3_buff_pool_unlock(pool);
+
+    return i;
+}
+
+lt_ret_t lt_l3_buff_borrow(lt_handle_t *h)
+{
+    if (!h || !h->l3_pool) {
+        return LT_PARAM_ERR;
+    }
+    if (h->l3.buff) {
+        // Already borrowed
+        return LT_OK;
+    }
+
+    lt_l3_buff_pool_t *pool = h->l3_pool;
+    int i = lt_l3_buff_take(pool, true, pool->wait_ms == 0);
+    for (uint32_t waited_ms = 0; (i < 0) && (waited_ms < pool->wait_ms); waited_ms++) {
+        lt_ret_t ret = lt_l1_delay(&h->l2, 1);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        i = lt_l3_buff_take(pool, false, waited_ms + 1 == pool->wait_ms);
+    }
+    if (i < 0) {
+        LT_LOG_S2_WARN(&h->l2, "No free L3 buffer in the pool after %" PRIu32 " ms", pool->wait_ms);
+        return LT_BUSY;
+    }
+
+    h->l3.buff = pool->buffs + (size_t)i * pool->buff_size;
+    h->l3.buff_len = pool->buff_size;
+    // Buffers in the pool are wiped when returned
+    h->l3.buff_used = 0;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_l3_buff_release(lt_handle_t *h)
+{
+    if (!h || !h->l3_pool || !h->l3.buff) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_l3_buff_pool_t *pool = h->l3_pool;
+    int i = (int)((size_t)(h->l3.buff - pool->buffs) / pool->buff_size);
+
+    // Plaintext of the last command and result must not be seen by the next borrower
+    lt_l3_buff_wipe(&h->l3);
+    h->l3.buff = NULL;
+    h->l3.buff_len = 0;
+
+    lt_l3_buff_pool_lock(pool);
+    pool->free_mask |= (1u << i);
+    pool->stats.in_use--;
+    lt_l3_buff_pool_unlock(pool);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_l3_buff_pool_stats_get(lt_l3_buff_pool_t *pool, lt_l3_buff_pool_stats_t *stats)
+{
+    if (!pool || !stats) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_l3_buff_pool_lock(pool);
+    *stats = pool->stats;
+    lt_l3_buff_pool_unlock(pool);
+
+    return LT_OK;
+}
+#endif
+
+lt_ret_t lt_random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len)
+{
+    if ((len > RANDOM_VALUE_GET_LEN_MAX) || !h || !buff) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__random_value_get(h, len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__random_value_get(h, buff, len);
+}
+
+#if LT_L3_VIEWS
+lt_ret_t lt_random_value_get_view(lt_handle_t *h, const uint16_t len, const uint8_t **buff)
+{
+    if ((len > RANDOM_VALUE_GET_LEN_MAX) || !h || !buff) {
+        return LT_PARAM_ERR;
+    }
+#if LT_L3_BUFF_POOL
+    // Buffer borrowed only for this call would be wiped and returned before the caller looks at the view
+    if (h->l3_pool && !h->l3.buff) {
+        return LT_PARAM_ERR;
+    }
+#endif
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__random_value_get(h, len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__random_value_get_view(h, buff, len);
+}
+#endif
+
+/** Destination of random bytes requested by one pipelined batch */
+struct lt_random_batch_t {
+    uint8_t *buff;
+    uint32_t len;
+};
+
+/** Number of random bytes requested by i-th command of the batch */
+static uint16_t lt_random_batch_chunk(const struct lt_random_batch_t *r, uint32_t i)
+{
+    uint32_t rest = r->len - (i * RANDOM_VALUE_GET_LEN_MAX);
+
+    return (rest < RANDOM_VALUE_GET_LEN_MAX) ? (uint16_t)rest : RANDOM_VALUE_GET_LEN_MAX;
+}
+
+static uint16_t lt_random_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    UNUSED(ctx);
+    UNUSED(i);
+
+    return sizeof(struct lt_l3_random_value_get_cmd_t);
+}
+
+static lt_ret_t lt_random_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    return lt_out__random_value_get(h, lt_random_batch_chunk(ctx, i));
+}
+
+static lt_ret_t lt_random_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_random_batch_t *r = ctx;
+
+    return lt_in__random_value_get(h, r->buff + (i * RANDOM_VALUE_GET_LEN_MAX), lt_random_batch_chunk(r, i));
+}
+
+lt_ret_t lt_random_value_get_large(lt_handle_t *h, uint8_t *buff, const uint32_t len)
+{
+    if (!h || !buff || !len) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_random_batch_t r = {.buff = buff, .len = len};
+    struct lt_l3_batch_t b = {.n = (len + RANDOM_VALUE_GET_LEN_MAX - 1) / RANDOM_VALUE_GET_LEN_MAX,
+                              .cmd_len = lt_random_batch_cmd_len,
+                              .out = lt_random_batch_out,
+                              .in = lt_random_batch_in,
+                              .ctx = &r};
+
+    return lt_l3_batch(h, &b);
+}
+
+#if LT_HOST_DRBG
+/** Entropy input of each (re)seed, security strength of HMAC_DRBG with SHA256 */
+#define LT_DRBG_ENTROPY_LEN 32
+/** Nonce of instantiation, half of security strength */
+#define LT_DRBG_NONCE_LEN 16
+
+lt_ret_t lt_drbg_init(lt_handle_t *h, lt_drbg_t *drbg, const uint32_t reseed_interval, const bool prediction_resistance)
+{
+    if (!h || !drbg || !reseed_interval) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t seed[LT_DRBG_ENTROPY_LEN + LT_DRBG_NONCE_LEN];
+    lt_ret_t ret = lt_random_value_get(h, seed, sizeof(seed));
+    if (ret != LT_OK) {
+        memset(seed, 0, sizeof(seed));
+        return ret;
+    }
+
+    lt_hmac_drbg_instantiate(drbg, seed, sizeof(seed));
+    memset(seed, 0, sizeof(seed));
+    drbg->reseed_cnt = 1;
+    drbg->reseed_interval = reseed_interval;
+    drbg->prediction_resistance = prediction_resistance;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_drbg_reseed(lt_handle_t *h, lt_drbg_t *drbg)
+{
+    if (!h || !drbg || !drbg->reseed_cnt) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t entropy[LT_DRBG_ENTROPY_LEN];
+    lt_ret_t ret = lt_random_value_get(h, entropy, sizeof(entropy));
+    if (ret != LT_OK) {
+        memset(entropy, 0, sizeof(entropy));
+        return ret;
+    }
+
+    lt_hmac_drbg_reseed(drbg, entropy, sizeof(entropy));
+    memset(entropy, 0, sizeof(entropy));
+    drbg->reseed_cnt = 1;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_drbg_random_get(lt_handle_t *h, lt_drbg_t *drbg, uint8_t *buff, const uint32_t len)
+{
+    if (!h || !drbg || !drbg->reseed_cnt || !buff || (len > LT_DRBG_REQUEST_LEN_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    // Counter is also kept from overflowing to 0, which means not instantiated
+    if (drbg->prediction_resistance || (drbg->reseed_cnt > drbg->reseed_interval) || (drbg->reseed_cnt == UINT32_MAX)) {
+        lt_ret_t ret = lt_drbg_reseed(h, drbg);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+
+    lt_hmac_drbg_generate(drbg, buff, len);
+    drbg->reseed_cnt++;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_drbg_deinit(lt_drbg_t *drbg)
+{
+    if (!drbg) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(drbg, 0, sizeof(*drbg));
+
+    return LT_OK;
+}
+#endif
+
+lt_ret_t lt_ecc_key_generate(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve)
+{
+    if (!h || (slot > ECC_SLOT_31) || ((curve != CURVE_P256) && (curve != CURVE_ED25519))) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_ECC_KEY_CACHE
+    lt_ecc_key_cache_drop(h, slot);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_key_generate(h, slot, curve);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_key_generate(h);
+}
+
+lt_ret_t lt_ecc_key_store(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve, const uint8_t *key)
+{
+    if (!h || (slot > ECC_SLOT_31) || ((curve != CURVE_P256) && (curve != CURVE_ED25519)) || !key) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_ECC_KEY_CACHE
+    lt_ecc_key_cache_drop(h, slot);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    ret = lt_out__ecc_key_store(h, slot, curve, key);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_key_store(h);
+}
+
+lt_ret_t lt_ecc_key_read(lt_handle_t *h, const ecc_slot_t ecc_slot, uint8_t *key, lt_ecc_curve_type_t *curve,
+                         ecc_key_origin_t *origin)
+{
+    if (!h || (ecc_slot > ECC_SLOT_31) || !key || !curve || !origin) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_ECC_KEY_CACHE
+    lt_ecc_key_cache_t *cache = h->key_cache;
+    if (cache && (cache->valid & (1UL << ecc_slot))) {
+        *curve = cache->slots[ecc_slot].curve;
+        *origin = cache->slots[ecc_slot].origin;
+        memcpy(key, cache->slots[ecc_slot].key, (*curve == CURVE_ED25519) ? 32 : 64);
+        return LT_OK;
+    }
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_key_read(h, ecc_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+#if LT_ECC_KEY_CACHE
+    ret = lt_in__ecc_key_read(h, key, curve, origin);
+    if ((ret == LT_OK) && cache) {
+        memcpy(cache->slots[ecc_slot].key, key, (*curve == CURVE_ED25519) ? 32 : 64);
+        cache->slots[ecc_slot].curve = *curve;
+        cache->slots[ecc_slot].origin = *origin;
+        cache->valid |= (1UL << ecc_slot);
+    }
+
+    return ret;
+#else
+    return lt_in__ecc_key_read(h, key, curve, origin);
+#endif
+}
+
+/** Arguments of pipelined batch of ECC_Key_Read commands */
+struct lt_ecc_key_inventory_t {
+    /** Slots to be read, the others were taken from the cache */
+    ecc_slot_t slots[ECC_SLOT_31 + 1];
+    /** Content of all slots */
+    lt_ecc_key_info_t *info;
+};
+
+static uint16_t lt_ecc_key_inventory_cmd_len(const void *ctx, uint32_t i)
+{
+    UNUSED(ctx);
+    UNUSED(i);
+
+    return sizeof(struct lt_l3_ecc_key_read_cmd_t);
+}
+
+static lt_ret_t lt_ecc_key_inventory_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_ecc_key_inventory_t *k = ctx;
+
+    return lt_out__ecc_key_read(h, k->slots[i]);
+}
+
+static lt_ret_t lt_ecc_key_inventory_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_ecc_key_inventory_t *k = ctx;
+    lt_ecc_key_info_t *info = &k->info[k->slots[i]];
+
+    lt_ret_t ret = lt_in__ecc_key_read(h, info->key, &info->curve, &info->origin);
+    info->status = ret;
+#if LT_ECC_KEY_CACHE
+    lt_ecc_key_cache_t *cache = h->key_cache;
+    if ((ret == LT_OK) && cache) {
+        memcpy(cache->slots[k->slots[i]].key, info->key, (info->curve == CURVE_ED25519) ? 32 : 64);
+        cache->slots[k->slots[i]].curve = info->curve;
+        cache->slots[k->slots[i]].origin = info->origin;
+        cache->valid |= (1UL << k->slots[i]);
+    }
+#endif
+
+    // Result was decrypted, so an empty slot does not stop the batch
+    return lt_l3_batch_cmd_failed(ret) ? LT_OK : ret;
+}
+
+lt_ret_t lt_ecc_key_inventory(lt_handle_t *h, lt_ecc_key_info_t *slots)
+{
+    if (!h || !slots) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_ecc_key_inventory_t k = {.info = slots};
+    uint32_t n = 0;
+    for (uint8_t slot = ECC_SLOT_0; slot <= ECC_SLOT_31; slot++) {
+#if LT_ECC_KEY_CACHE
+        lt_ecc_key_cache_t *cache = h->key_cache;
+        if (cache && (cache->valid & (1UL << slot))) {
+            slots[slot].status = LT_OK;
+            slots[slot].curve = cache->slots[slot].curve;
+            slots[slot].origin = cache->slots[slot].origin;
+            memcpy(slots[slot].key, cache->slots[slot].key, sizeof(slots[slot].key));
+            continue;
+        }
+#endif
+        slots[slot].status = LT_FAIL;
+        k.slots[n++] = (ecc_slot_t)slot;
+    }
+    if (!n) {
+        return LT_OK;
+    }
+
+    struct lt_l3_batch_t b = {.n = n,
+                              .cmd_len = lt_ecc_key_inventory_cmd_len,
+                              .out = lt_ecc_key_inventory_out,
+                              .in = lt_ecc_key_inventory_in,
+                              .ctx = &k};
+
+    return lt_l3_batch(h, &b);
+}
+
+/** Arguments of pipelined batch of ECC_Key_Store commands followed by ECC_Key_Read of the same slots */
+struct lt_ecc_key_store_batch_t {
+    /** Keys, their public keys and statuses are filled */
+    lt_ecc_key_import_t *keys;
+    /** Number of keys, commands from `cnt` on read the slots back */
+    uint32_t cnt;
+};
+
+static uint16_t lt_ecc_key_store_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const struct lt_ecc_key_store_batch_t *p = ctx;
+
+    return (i < p->cnt) ? sizeof(struct lt_l3_ecc_key_store_cmd_t) : sizeof(struct lt_l3_ecc_key_read_cmd_t);
+}
+
+static lt_ret_t lt_ecc_key_store_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_ecc_key_store_batch_t *p = ctx;
+
+    if (i < p->cnt) {
+        return lt_out__ecc_key_store(h, p->keys[i].slot, p->keys[i].curve, p->keys[i].key);
+    }
+
+    return lt_out__ecc_key_read(h, p->keys[i - p->cnt].slot);
+}
+
+static lt_ret_t lt_ecc_key_store_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_ecc_key_store_batch_t *p = ctx;
+    lt_ret_t ret;
+
+    if (i < p->cnt) {
+        ret = lt_in__ecc_key_store(h);
+        p->keys[i].status = ret;
+    }
+    else {
+        lt_ecc_key_import_t *key = &p->keys[i - p->cnt];
+        lt_ecc_curve_type_t curve;
+        ecc_key_origin_t origin;
+        ret = lt_in__ecc_key_read(h, key->pubkey, &curve, &origin);
+        // Slot of a failed store holds some other key, or none
+        if ((key->status == LT_OK) && (ret == LT_OK)) {
+            key->status = ((curve == key->curve) && (origin == CURVE_STORED)) ? LT_OK : LT_FAIL;
+        }
+        else if (key->status == LT_OK) {
+            key->status = ret;
+        }
+#if LT_ECC_KEY_CACHE
+        lt_ecc_key_cache_t *cache = h->key_cache;
+        if ((ret == LT_OK) && cache) {
+            memcpy(cache->slots[key->slot].key, key->pubkey, (curve == CURVE_ED25519) ? 32 : 64);
+            cache->slots[key->slot].curve = curve;
+            cache->slots[key->slot].origin = origin;
+            cache->valid |= (1UL << key->slot);
+        }
+#endif
+    }
+
+    // Result was decrypted, so a failure concerns only this key and the batch continues
+    return lt_l3_batch_cmd_failed(ret) ? LT_OK : ret;
+}
+
+/** Body of lt_ecc_key_store_batch(), which wipes the keys whatever it returns */
+static lt_ret_t lt_ecc_key_store_batch_exec(lt_handle_t *h, lt_ecc_key_import_t *keys, const uint8_t cnt)
+{
+    uint32_t slots = 0;
+    for (uint8_t i = 0; i < cnt; i++) {
+        if ((keys[i].slot > ECC_SLOT_31) || ((keys[i].curve != CURVE_P256) && (keys[i].curve != CURVE_ED25519))
+            || (slots & (1UL << keys[i].slot))) {
+            return LT_PARAM_ERR;
+        }
+        slots |= (1UL << keys[i].slot);
+    }
+
+    for (uint8_t i = 0; i < cnt; i++) {
+        keys[i].status = LT_FAIL;
+#if LT_ECC_KEY_CACHE
+        lt_ecc_key_cache_drop(h, keys[i].slot);
+#endif
+    }
+
+    struct lt_ecc_key_store_batch_t p = {.keys = keys, .cnt = cnt};
+    struct lt_l3_batch_t b = {.n = 2 * (uint32_t)cnt,
+                              .cmd_len = lt_ecc_key_store_batch_cmd_len,
+                              .out = lt_ecc_key_store_batch_out,
+                              .in = lt_ecc_key_store_batch_in,
+                              .ctx = &p};
+
+    return lt_l3_batch(h, &b);
+}
+
+lt_ret_t lt_ecc_key_store_batch(lt_handle_t *h, lt_ecc_key_import_t *keys, const uint8_t cnt)
+{
+    if (!keys) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = LT_PARAM_ERR;
+    if (h && cnt && (cnt <= ECC_SLOT_31 + 1)) {
+        LT_HANDLE_LOCK(h);
+        ret = lt_ecc_key_store_batch_exec(h, keys, cnt);
+        // Plaintext of the commands is wiped from L3 buffer once for all of them
+        lt_l3_buff_wipe(&h->l3);
+    }
+
+    // Keys are wiped once all of them were sent, the compiler must not drop it as stores never read again
+    for (uint8_t i = 0; i < cnt; i++) {
+        memset(keys[i].key, 0, sizeof(keys[i].key));
+    }
+    __asm__ __volatile__("" : : "r"(keys) : "memory");
+
+    return ret;
+}
+
+lt_ret_t lt_ecc_key_erase(lt_handle_t *h, const ecc_slot_t ecc_slot)
+{
+    if (!h || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+#if LT_ECC_KEY_CACHE
+    lt_ecc_key_cache_drop(h, ecc_slot);
+#endif
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_key_erase(h, ecc_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_key_erase(h);
+}
+
+lt_ret_t lt_ecc_ecdsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint32_t msg_len,
+                           uint8_t *rs)
+{
+    if (!h || !msg || !rs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_ecdsa_sign(h, ecc_slot, msg, msg_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_ecdsa_sign(h, rs);
+}
+
+lt_ret_t lt_ecc_ecdsa_sign_v(lt_handle_t *h, const ecc_slot_t ecc_slot, const lt_iovec_t *iov, const uint8_t iov_cnt,
+                             uint8_t *rs)
+{
+    size_t msg_len;
+    if (!h || (lt_iov_len(iov, iov_cnt, &msg_len) != LT_OK) || !rs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_ecdsa_sign_v(h, ecc_slot, iov, iov_cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_ecdsa_sign(h, rs);
+}
+
+lt_ret_t lt_ecc_ecdsa_sign_digest(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg_hash, uint8_t *rs)
+{
+    if (!h || !msg_hash || !rs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_ecdsa_sign_digest(h, ecc_slot, msg_hash);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_ecdsa_sign(h, rs);
+}
+
+// SHA256 context of the crypto backend has to fit into the signing context
+STATIC_ASSERT(sizeof(struct lt_crypto_sha256_ctx_t) <= MEMBER_SIZE(lt_ecdsa_sign_ctx_t, sha256))
+
+lt_ret_t lt_ecdsa_sign_init(lt_ecdsa_sign_ctx_t *ctx)
+{
+    if (!ctx) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_sha256_init(ctx->sha256);
+    lt_sha256_start(ctx->sha256);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecdsa_sign_update(lt_ecdsa_sign_ctx_t *ctx, const uint8_t *data, const uint32_t len)
+{
+    if (!ctx || (!data && len)) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_sha256_update(ctx->sha256, data, len);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecdsa_sign_final(lt_handle_t *h, lt_ecdsa_sign_ctx_t *ctx, const ecc_slot_t ecc_slot, uint8_t *rs)
+{
+    if (!h || !ctx || !rs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    uint8_t msg_hash[32];
+    lt_sha256_finish(ctx->sha256, msg_hash);
+    memset(ctx, 0, sizeof(lt_ecdsa_sign_ctx_t));
+
+    return lt_ecc_ecdsa_sign_digest(h, ecc_slot, msg_hash, rs);
+}
+
+lt_ret_t lt_ecc_ecdsa_sig_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
+{
+    if (!msg || !pubkey || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    if (lt_ecdsa_verify(msg, msg_len, pubkey, rs) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_ecdsa_sig_verify_batch(const uint8_t *const *msgs, const uint32_t *msg_lens, const uint8_t *pubkey,
+                                       const uint8_t *sigs, const uint16_t n, uint8_t *valid)
+{
+    if (!msgs || !msg_lens || !pubkey || !sigs) {
+        return LT_PARAM_ERR;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (!msgs[i]) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    lt_ret_t ret = LT_OK;
+    for (uint16_t i = 0; i < n; i++) {
+        int ok = (lt_ecdsa_verify(msgs[i], msg_lens[i], pubkey, sigs + (i * 64)) == 0);
+        if (valid) {
+            valid[i] = (uint8_t)ok;
+        }
+        if (!ok) {
+            ret = LT_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+#if LT_PREPARED_KEYS
+lt_ret_t lt_ecc_ecdsa_key_prepare(lt_ecdsa_prepared_key_t *key, const uint8_t *pubkey)
+{
+    if (!key || !pubkey) {
+        return LT_PARAM_ERR;
+    }
+
+    if (lt_ecdsa_prepare(key->space, pubkey) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_ecdsa_sig_verify_prepared(const lt_ecdsa_prepared_key_t *key, const uint8_t *msg,
+                                          const uint32_t msg_len, const uint8_t *rs)
+{
+    if (!key || !msg || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    if (lt_ecdsa_verify_prepared(key->space, msg, msg_len, rs) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+#endif
+
+lt_ret_t lt_ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint16_t msg_len,
+                           uint8_t *rs)
+{
+    if (!h || !msg || !rs || (msg_len > LT_EDDSA_MSG_LEN_MAX) || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_eddsa_sign(h, ecc_slot, msg, msg_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_eddsa_sign(h, rs);
+}
+
+lt_ret_t lt_ecc_eddsa_sign_v(lt_handle_t *h, const ecc_slot_t ecc_slot, const lt_iovec_t *iov, const uint8_t iov_cnt,
+                             uint8_t *rs)
+{
+    size_t msg_len;
+    if (!h || (lt_iov_len(iov, iov_cnt, &msg_len) != LT_OK) || !rs || (msg_len > LT_EDDSA_MSG_LEN_MAX)
+        || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__ecc_eddsa_sign_v(h, ecc_slot, iov, iov_cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__ecc_eddsa_sign(h, rs);
+}
+
+/** Digests of messages of an ECDSA batch, computed by groups of LT_SHA256_MULTI_LANES ahead of their commands */
+struct lt_sign_batch_prehash_t {
+    const uint8_t *const *msgs;
+    const uint32_t *msg_lens;
+    uint16_t n;
+    /** Index of the message whose digest is first in `digests` */
+    uint16_t first;
+    /** Number of digests in `digests` */
+    uint16_t cnt;
+    uint8_t digests[LT_SHA256_MULTI_LANES * SHA256_DIGEST_LENGTH];
+};
+
+struct lt_sign_batch_t {
+    ecc_slot_t slot;
+    /** n * 32B of digests for ECDSA, NULL for EdDSA */
+    const uint8_t *digests;
+    /** Messages to be hashed for ECDSA instead of `digests` */
+    struct lt_sign_batch_prehash_t *prehash;
+    /** Messages and their lengths for EdDSA */
+    const uint8_t *const *msgs;
+    const uint16_t *msg_lens;
+    /** n * 64B of signatures */
+    uint8_t *sigs;
+};
+
+/** Returns digest of i-th message of ECDSA batch */
+static const uint8_t *lt_sign_batch_digest(const struct lt_sign_batch_t *b, uint32_t i)
+{
+    struct lt_sign_batch_prehash_t *p = b->prehash;
+    if (!p) {
+        return b->digests + (i * SHA256_DIGEST_LENGTH);
+    }
+
+    if ((i < p->first) || (i >= (uint32_t)p->first + p->cnt)) {
+        p->first = (uint16_t)i;
+        p->cnt = (uint16_t)(((p->n - i) < LT_SHA256_MULTI_LANES) ? (p->n - i) : LT_SHA256_MULTI_LANES);
+        lt_sha256_multi(p->msgs + i, p->msg_lens + i, p->cnt, p->digests);
+    }
+
+    return p->digests + ((i - p->first) * SHA256_DIGEST_LENGTH);
+}
+
+/** Size of i-th encrypted command frame of the batch */
+static uint16_t lt_sign_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const struct lt_sign_batch_t *b = ctx;
+    if (b->digests || b->prehash) {
+        return sizeof(struct lt_l3_ecdsa_sign_cmd_t);
+    }
+
+    return sizeof(struct lt_l3_eddsa_sign_cmd_t) - LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX + b->msg_lens[i];
+}
+
+/** Encodes and encrypts i-th command of the batch into L3 buffer */
+static lt_ret_t lt_sign_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_sign_batch_t *b = ctx;
+    if (b->digests || b->prehash) {
+        return lt_out__ecc_ecdsa_sign_digest(h, b->slot, lt_sign_batch_digest(b, i));
+    }
+
+    return lt_out__ecc_eddsa_sign(h, b->slot, b->msgs[i], b->msg_lens[i]);
+}
+
+/** Decrypts and decodes result of i-th command of the batch */
+static lt_ret_t lt_sign_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_sign_batch_t *b = ctx;
+    if (b->digests || b->prehash) {
+        return lt_in__ecc_ecdsa_sign(h, b->sigs + (i * 64));
+    }
+
+    return lt_in__ecc_eddsa_sign(h, b->sigs + (i * 64));
+}
+
+// Results of both signatures have the same size
+STATIC_ASSERT(sizeof(struct lt_l3_ecdsa_sign_res_t) == sizeof(struct lt_l3_eddsa_sign_res_t))
+
+static lt_ret_t lt_sign_batch(lt_handle_t *h, const struct lt_sign_batch_t *s, const uint16_t n)
+{
+    struct lt_l3_batch_t b = {.n = n,
+                              .cmd_len = lt_sign_batch_cmd_len,
+                              .out = lt_sign_batch_out,
+                              .in = lt_sign_batch_in,
+                              .ctx = s};
+
+    return lt_l3_batch(h, &b);
+}
+
+lt_ret_t lt_ecc_ecdsa_sign_batch(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *digests, const uint16_t n,
+                                 uint8_t *sigs)
+{
+    if (!h || !digests || !n || !sigs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_sign_batch_t b = {.slot = ecc_slot, .digests = digests, .sigs = sigs};
+
+    return lt_sign_batch(h, &b, n);
+}
+
+lt_ret_t lt_ecc_ecdsa_sign_msg_batch(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *const *msgs,
+                                     const uint32_t *msg_lens, const uint16_t n, uint8_t *sigs)
+{
+    if (!h || !msgs || !msg_lens || !n || !sigs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    for (uint16_t i = 0; i < n; i++) {
+        if (!msgs[i]) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    struct lt_sign_batch_prehash_t p = {.msgs = msgs, .msg_lens = msg_lens, .n = n, .first = 0, .cnt = 0};
+    struct lt_sign_batch_t b = {.slot = ecc_slot, .prehash = &p, .sigs = sigs};
+
+    return lt_sign_batch(h, &b, n);
+}
+
+lt_ret_t lt_ecc_eddsa_sign_batch(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *const *msgs,
+                                 const uint16_t *msg_lens, const uint16_t n, uint8_t *sigs)
+{
+    if (!h || !msgs || !msg_lens || !n || !sigs || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    for (uint16_t i = 0; i < n; i++) {
+        if (!msgs[i] || (msg_lens[i] > LT_EDDSA_MSG_LEN_MAX)) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    struct lt_sign_batch_t b = {.slot = ecc_slot, .msgs = msgs, .msg_lens = msg_lens, .sigs = sigs};
+
+    return lt_sign_batch(h, &b, n);
+}
+
+lt_ret_t lt_ecc_eddsa_sig_verify(const uint8_t *msg, const uint16_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
+{
+    if (!msg || (msg_len > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX) || !pubkey || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    if (lt_ed25519_sign_open(msg, msg_len, pubkey, rs) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_eddsa_sig_verify_batch(const uint8_t *const *msgs, const uint16_t *msg_lens, const uint8_t *pubkey,
+                                       const uint8_t *sigs, const uint16_t n, uint8_t *valid)
+{
+    if (!msgs || !msg_lens || !pubkey || !sigs) {
+        return LT_PARAM_ERR;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (!msgs[i] || (msg_lens[i] > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX)) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    if (lt_ed25519_sign_open_batch(msgs, msg_lens, pubkey, sigs, n, valid) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+#if LT_PREPARED_KEYS
+lt_ret_t lt_ecc_eddsa_key_prepare(lt_eddsa_prepared_key_t *key, const uint8_t *pubkey)
+{
+    if (!key || !pubkey) {
+        return LT_PARAM_ERR;
+    }
+
+    if (lt_ed25519_prepare(key->space, pubkey) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_eddsa_sig_verify_prepared(const lt_eddsa_prepared_key_t *key, const uint8_t *msg,
+                                          const uint16_t msg_len, const uint8_t *rs)
+{
+    if (!key || !msg || (msg_len > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX) || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    if (lt_ed25519_sign_open_prepared(key->space, msg, msg_len, rs) != 0) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_SIG_CHECK
+lt_ret_t lt_sig_check_init(lt_sig_check_t *chk, const uint16_t sample, lt_sig_check_cb_t cb, void *ctx)
+{
+    if (!chk || !cb) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(chk, 0, sizeof(*chk));
+    chk->sample = sample;
+    chk->cb = cb;
+    chk->ctx = ctx;
+
+    return LT_OK;
+}
+
+static void lt_sig_check_run(lt_sig_check_t *chk, const lt_sig_check_entry_t *e)
+{
+    lt_ret_t ret = LT_OK;
+
+    if (e->checked) {
+        if (e->eddsa) {
+            ret = lt_ecc_eddsa_sig_verify_prepared(e->key, e->msg, (uint16_t)e->msg_len, e->rs);
+        }
+        else {
+            ret = lt_ecc_ecdsa_sig_verify_prepared(e->key, e->msg, e->msg_len, e->rs);
+        }
+        __atomic_fetch_add((ret == LT_OK) ? &chk->valid : &chk->invalid, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        __atomic_fetch_add(&chk->skipped, 1, __ATOMIC_RELAXED);
+    }
+
+    chk->cb(chk, e->msg, e->rs, e->checked, ret, chk->ctx);
+}
+
+/** Queues signature made by TROPIC01 for the worker, or verifies it right away when the queue is full */
+static lt_ret_t lt_sig_check_queue(lt_handle_t *h, lt_sig_check_t *chk, const void *key, const bool eddsa,
+                                   const uint8_t *msg, const uint32_t msg_len, const uint8_t *rs)
+{
+    lt_sig_check_entry_t e = {.key = key, .msg = msg, .rs = rs, .msg_len = msg_len, .eddsa = eddsa, .checked = true};
+
+    if (chk->sample > 1) {
+        uint32_t r;
+        lt_ret_t ret = lt_random_bytes(&h->l2, &r, sizeof(r));
+        if (ret != LT_OK) {
+            return ret;
+        }
+        e.checked = ((r % chk->sample) == 0);
+    }
+
+    uint32_t head = __atomic_load_n(&chk->head, __ATOMIC_RELAXED);
+    if ((head - __atomic_load_n(&chk->tail, __ATOMIC_ACQUIRE)) >= LT_SIG_CHECK_DEPTH) {
+        // Worker does not keep up with TROPIC01, so nothing would be saved by waiting for it
+        __atomic_fetch_add(&chk->full, 1, __ATOMIC_RELAXED);
+        lt_sig_check_run(chk, &e);
+        return LT_OK;
+    }
+    chk->entries[head % LT_SIG_CHECK_DEPTH] = e;
+    __atomic_store_n(&chk->head, head + 1, __ATOMIC_RELEASE);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_ecdsa_sign_checked(lt_handle_t *h, lt_sig_check_t *chk, const ecc_slot_t ecc_slot,
+                                   const lt_ecdsa_prepared_key_t *key, const uint8_t *msg, const uint32_t msg_len,
+                                   uint8_t *rs)
+{
+    if (!chk || !key) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_ecc_ecdsa_sign(h, ecc_slot, msg, msg_len, rs);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_sig_check_queue(h, chk, key, false, msg, msg_len, rs);
+}
+
+lt_ret_t lt_ecc_eddsa_sign_checked(lt_handle_t *h, lt_sig_check_t *chk, const ecc_slot_t ecc_slot,
+                                   const lt_eddsa_prepared_key_t *key, const uint8_t *msg, const uint16_t msg_len,
+                                   uint8_t *rs)
+{
+    if (!chk || !key) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_ecc_eddsa_sign(h, ecc_slot, msg, msg_len, rs);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_sig_check_queue(h, chk, key, true, msg, msg_len, rs);
+}
+
+lt_ret_t lt_sig_check_work(lt_sig_check_t *chk)
+{
+    if (!chk) {
+        return LT_PARAM_ERR;
+    }
+
+    uint32_t tail = __atomic_load_n(&chk->tail, __ATOMIC_RELAXED);
+    while (tail != __atomic_load_n(&chk->head, __ATOMIC_ACQUIRE)) {
+        lt_sig_check_run(chk, &chk->entries[tail % LT_SIG_CHECK_DEPTH]);
+        tail++;
+        // Entry may be reused by the signing thread from now on
+        __atomic_store_n(&chk->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return LT_OK;
+}
+
+uint32_t lt_sig_check_pending(lt_sig_check_t *chk)
+{
+    if (!chk) {
+        return 0;
+    }
+
+    return __atomic_load_n(&chk->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&chk->tail, __ATOMIC_ACQUIRE);
+}
+#endif
+
+#if LT_WAKE_BATCH
+lt_ret_t lt_wake_batch_init(lt_wake_batch_t *q, uint32_t (*time_us)(void))
+{
+    if (!q || !time_us) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(q, 0, sizeof(*q));
+    q->time_us = time_us;
+
+    return LT_OK;
+}
+
+/** Returns true when the operation would be accepted by the function executing it */
+static bool lt_wake_op_valid(const lt_wake_op_t *op)
+{
+    switch (op->kind) {
+#if LT_ENABLE_MCOUNTER
+        case LT_WAKE_OP_MCOUNTER_UPDATE:
+            return op->index <= MCOUNTER_INDEX_15;
+#endif
+        case LT_WAKE_OP_ECDSA_SIGN:
+            return op->in && op->out && (op->index <= ECC_SLOT_31);
+        case LT_WAKE_OP_EDDSA_SIGN:
+            return op->in && op->out && (op->index <= ECC_SLOT_31) && (op->in_len <= LT_EDDSA_MSG_LEN_MAX);
+#if LT_ENABLE_R_MEM
+        case LT_WAKE_OP_R_MEM_WRITE:
+            return op->in && (op->in_len >= R_MEM_DATA_SIZE_MIN) && (op->in_len <= R_MEM_DATA_SIZE_MAX)
+                   && (op->index <= R_MEM_DATA_SLOT_MAX);
+        case LT_WAKE_OP_R_MEM_ERASE:
+            return op->index <= R_MEM_DATA_SLOT_MAX;
+#endif
+        case LT_WAKE_OP_RANDOM_GET:
+            return op->out && (op->out_len <= RANDOM_VALUE_GET_LEN_MAX);
+        default:
+            return false;
+    }
+}
+
+lt_ret_t lt_wake_batch_add(lt_wake_batch_t *q, const lt_wake_op_t *op)
+{
+    if (!q || !q->time_us || !op || !lt_wake_op_valid(op)) {
+        return LT_PARAM_ERR;
+    }
+    if (q->cnt >= LT_WAKE_BATCH_DEPTH) {
+        return LT_FAIL;
+    }
+
+    lt_wake_op_t *queued = &q->ops[q->cnt++];
+    *queued = *op;
+    queued->status = LT_FAIL;
+    // Delays up to the wrap of the clock are kept, longer ones are clamped
+    const uint64_t delay_us = (uint64_t)op->max_delay_ms * 1000;
+    queued->due_us = q->time_us() + (uint32_t)((delay_us < (UINT32_MAX >> 1)) ? delay_us : (UINT32_MAX >> 1));
+
+    return LT_OK;
+}
+
+uint32_t lt_wake_batch_due_ms(const lt_wake_batch_t *q)
+{
+    if (!q || !q->time_us || !q->cnt) {
+        return UINT32_MAX;
+    }
+
+    const uint32_t now = q->time_us();
+    uint32_t left_us = UINT32_MAX;
+    for (uint8_t i = 0; i < q->cnt; i++) {
+        // Signed difference is correct also when the clock wrapped around
+        const int32_t d = (int32_t)(q->ops[i].due_us - now);
+        if (d <= 0) {
+            return 0;
+        }
+        if ((uint32_t)d < left_us) {
+            left_us = (uint32_t)d;
+        }
+    }
+
+    return left_us / 1000;
+}
+
+static uint16_t lt_wake_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const lt_wake_op_t *op = &((const lt_wake_batch_t *)ctx)->ops[i];
+    switch (op->kind) {
+#if LT_ENABLE_MCOUNTER
+        case LT_WAKE_OP_MCOUNTER_UPDATE:
+            return sizeof(struct lt_l3_mcounter_update_cmd_t);
+#endif
+        case LT_WAKE_OP_ECDSA_SIGN:
+            return sizeof(struct lt_l3_ecdsa_sign_cmd_t);
+        case LT_WAKE_OP_EDDSA_SIGN:
+            return (uint16_t)(sizeof(struct lt_l3_eddsa_sign_cmd_t) - LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX + op->in_len);
+#if LT_ENABLE_R_MEM
+        case LT_WAKE_OP_R_MEM_WRITE:
+            return (uint16_t)(sizeof(struct lt_l3_r_mem_data_write_cmd_t) - R_MEM_DATA_SIZE_MAX + op->in_len);
+        case LT_WAKE_OP_R_MEM_ERASE:
+            return sizeof(struct lt_l3_r_mem_data_erase_cmd_t);
+#endif
+        default:
+            return sizeof(struct lt_l3_random_value_get_cmd_t);
+    }
+}
+
+static lt_ret_t lt_wake_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const lt_wake_op_t *op = &((const lt_wake_batch_t *)ctx)->ops[i];
+    switch (op->kind) {
+#if LT_ENABLE_MCOUNTER
+        case LT_WAKE_OP_MCOUNTER_UPDATE:
+            return lt_out__mcounter_update(h, (enum lt_mcounter_index_t)op->index);
+#endif
+        case LT_WAKE_OP_ECDSA_SIGN:
+            return lt_out__ecc_ecdsa_sign(h, (ecc_slot_t)op->index, op->in, op->in_len);
+        case LT_WAKE_OP_EDDSA_SIGN:
+            return lt_out__ecc_eddsa_sign(h, (ecc_slot_t)op->index, op->in, (uint16_t)op->in_len);
+#if LT_ENABLE_R_MEM
+        case LT_WAKE_OP_R_MEM_WRITE:
+            return lt_out__r_mem_data_write(h, op->index, op->in, (uint16_t)op->in_len);
+        case LT_WAKE_OP_R_MEM_ERASE:
+            return lt_out__r_mem_data_erase(h, op->index);
+#endif
+        default:
+            return lt_out__random_value_get(h, op->out_len);
+    }
+}
+
+static lt_ret_t lt_wake_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    lt_wake_op_t *op = &((lt_wake_batch_t *)ctx)->ops[i];
+    lt_ret_t ret;
+    switch (op->kind) {
+#if LT_ENABLE_MCOUNTER
+        case LT_WAKE_OP_MCOUNTER_UPDATE:
+            ret = lt_in__mcounter_update(h);
+            break;
+#endif
+        case LT_WAKE_OP_ECDSA_SIGN:
+            ret = lt_in__ecc_ecdsa_sign(h, op->out);
+            break;
+        case LT_WAKE_OP_EDDSA_SIGN:
+            ret = lt_in__ecc_eddsa_sign(h, op->out);
+            break;
+#if LT_ENABLE_R_MEM
+        case LT_WAKE_OP_R_MEM_WRITE:
+            ret = lt_in__r_mem_data_write(h);
+            break;
+        case LT_WAKE_OP_R_MEM_ERASE:
+            ret = lt_in__r_mem_data_erase(h);
+            break;
+#endif
+        default:
+            ret = lt_in__random_value_get(h, op->out, op->out_len);
+            break;
+    }
+    op->status = ret;
+
+    // Result was decrypted, so a failure concerns only this operation and the burst continues
+    return lt_l3_batch_cmd_failed(ret) ? LT_OK : ret;
+}
+
+lt_ret_t lt_wake_batch_flush(lt_handle_t *h, lt_wake_batch_t *q)
+{
+    if (!h || !q || !q->time_us) {
+        return LT_PARAM_ERR;
+    }
+    if (!q->cnt) {
+        return LT_OK;
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_l3_batch_t b = {.n = q->cnt,
+                              .cmd_len = lt_wake_batch_cmd_len,
+                              .out = lt_wake_batch_out,
+                              .in = lt_wake_batch_in,
+                              .ctx = q};
+    const uint32_t start_us = q->time_us();
+    lt_ret_t ret = lt_l3_batch(h, &b);
+    const uint32_t burst_us = q->time_us() - start_us;
+
+    q->flushes++;
+    q->burst_us_last = burst_us;
+    if (burst_us > q->burst_us_max) {
+        q->burst_us_max = burst_us;
+    }
+
+    // Queue is emptied before the callbacks, so they may queue operations for the next burst
+    lt_wake_op_t ops[LT_WAKE_BATCH_DEPTH];
+    const uint8_t cnt = q->cnt;
+    memcpy(ops, q->ops, cnt * sizeof(ops[0]));
+    q->cnt = 0;
+    for (uint8_t i = 0; i < cnt; i++) {
+        if ((ret != LT_OK) && (ops[i].status == LT_FAIL)) {
+            // Not executed, or its result was lost with the burst
+            ops[i].status = ret;
+        }
+        if (ops[i].status == LT_OK) {
+            q->ops_ok++;
+        }
+        else {
+            q->ops_failed++;
+        }
+        if (ops[i].done) {
+            ops[i].done(&ops[i], ops[i].ctx);
+        }
+    }
+
+    return ret;
+}
+
+lt_ret_t lt_wake_batch_sleep(lt_handle_t *h, lt_wake_batch_t *q, const uint8_t sleep_kind)
+{
+    if (!h || !q || ((sleep_kind != LT_L2_SLEEP_KIND_SLEEP) && (sleep_kind != LT_L2_SLEEP_KIND_DEEP_SLEEP))) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    lt_ret_t ret = lt_wake_batch_flush(h, q);
+    lt_ret_t ret_sleep = lt_sleep(h, sleep_kind);
+
+    return (ret != LT_OK) ? ret : ret_sleep;
+}
+#endif
+
+#if LT_ENABLE_MCOUNTER
+lt_ret_t lt_mcounter_init(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, const uint32_t mcounter_value)
+{
+    if (!h || (mcounter_index > MCOUNTER_INDEX_15) || mcounter_value > MCOUNTER_VALUE_MAX) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__mcounter_init(h, mcounter_index, mcounter_value);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__mcounter_init(h);
+}
+
+lt_ret_t lt_mcounter_update(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index)
+{
+    if (!h || (mcounter_index > MCOUNTER_INDEX_15)) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__mcounter_update(h, mcounter_index);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__mcounter_update(h);
+}
+
+lt_ret_t lt_mcounter_get(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, uint32_t *mcounter_value)
+{
+    if (!h || (mcounter_index > MCOUNTER_INDEX_15) || !mcounter_value) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__mcounter_get(h, mcounter_index);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__mcounter_get(h, mcounter_value);
+}
+
+/** Arguments of one pipelined batch of monotonic counter commands */
+struct lt_mcounter_batch_t {
+    /** Counters of the commands, NULL for all counters in order */
+    const enum lt_mcounter_index_t *indexes;
+    /** Values read by Mcounter_Get, NULL for Mcounter_Update */
+    uint32_t *values;
+    /** Status of each command */
+    lt_ret_t *statuses;
+};
+
+static enum lt_mcounter_index_t lt_mcounter_batch_index(const struct lt_mcounter_batch_t *m, uint32_t i)
+{
+    return m->indexes ? m->indexes[i] : (enum lt_mcounter_index_t)i;
+}
+
+static uint16_t lt_mcounter_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const struct lt_mcounter_batch_t *m = ctx;
+    UNUSED(i);
+
+    return m->values ? sizeof(struct lt_l3_mcounter_get_cmd_t) : sizeof(struct lt_l3_mcounter_update_cmd_t);
+}
+
+static lt_ret_t lt_mcounter_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_mcounter_batch_t *m = ctx;
+
+    return m->values ? lt_out__mcounter_get(h, lt_mcounter_batch_index(m, i))
+                     : lt_out__mcounter_update(h, lt_mcounter_batch_index(m, i));
+}
+
+static lt_ret_t lt_mcounter_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_mcounter_batch_t *m = ctx;
+    lt_ret_t ret = m->values ? lt_in__mcounter_get(h, &m->values[i]) : lt_in__mcounter_update(h);
+    m->statuses[i] = ret;
+
+    // Result was decrypted, so a failure concerns only this counter and the batch continues
+    return lt_l3_batch_cmd_failed(ret) ? LT_OK : ret;
+}
+
+static lt_ret_t lt_mcounter_batch(lt_handle_t *h, const struct lt_mcounter_batch_t *m, const uint8_t cnt)
+{
+    for (uint8_t i = 0; i < cnt; i++) {
+        m->statuses[i] = LT_FAIL;
+    }
+
+    struct lt_l3_batch_t b = {.n = cnt,
+                              .cmd_len = lt_mcounter_batch_cmd_len,
+                              .out = lt_mcounter_batch_out,
+                              .in = lt_mcounter_batch_in,
+                              .ctx = m};
+
+    return lt_l3_batch(h, &b);
+}
+
+lt_ret_t lt_mcounter_get_all(lt_handle_t *h, uint32_t *mcounter_values, lt_ret_t *statuses)
+{
+    if (!h || !mcounter_values || !statuses) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_mcounter_batch_t m = {.values = mcounter_values, .statuses = statuses};
+
+    return lt_mcounter_batch(h, &m, MCOUNTER_INDEX_15 + 1);
+}
+
+lt_ret_t lt_mcounter_update_multi(lt_handle_t *h, const enum lt_mcounter_index_t *mcounter_indexes, const uint8_t cnt,
+                                  lt_ret_t *statuses)
+{
+    if (!h || !mcounter_indexes || !cnt || !statuses) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        if (mcounter_indexes[i] > MCOUNTER_INDEX_15) {
+            return LT_PARAM_ERR;
+        }
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_mcounter_batch_t m = {.indexes = mcounter_indexes, .statuses = statuses};
+
+    return lt_mcounter_batch(h, &m, cnt);
+}
+#endif
+
+lt_ret_t lt_mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, const uint8_t *data_out, uint8_t *data_in)
+{
+    if (!h || !data_out || !data_in || slot > MAC_AND_DESTROY_SLOT_127) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_out__mac_and_destroy(h, slot, data_out);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_l3_result_recv(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_in__mac_and_destroy(h, data_in);
+}
+
+/** Arguments of one pipelined batch of MAC-and-Destroy commands */
+struct lt_macandd_batch_t {
+    const mac_and_destroy_slot_t *slots;
+    /** Data sent to TROPIC01, MAC_AND_DESTROY_DATA_SIZE bytes per command */
+    const uint8_t *data_out;
+    /** Data returned from TROPIC01, MAC_AND_DESTROY_DATA_SIZE bytes per command */
+    uint8_t *data_in;
+};
+
+static uint16_t lt_macandd_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    UNUSED(ctx);
+    UNUSED(i);
+
+    return sizeof(struct lt_l3_mac_and_destroy_cmd_t);
+}
+
+static lt_ret_t lt_macandd_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_macandd_batch_t *m = ctx;
+
+    return lt_out__mac_and_destroy(h, m->slots[i], m->data_out + (i * MAC_AND_DESTROY_DATA_SIZE));
+}
+
+static lt_ret_t lt_macandd_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_macandd_batch_t *m = ctx;
+
+    return lt_in__mac_and_destroy(h, m->data_in + (i * MAC_AND_DESTROY_DATA_SIZE));
+}
+
+lt_ret_t lt_mac_and_destroy_batch(lt_handle_t *h, const mac_and_destroy_slot_t *slots, const uint8_t *data_out,
+                                  const uint16_t n, uint8_t *data_in)
+{
+    if (!h || !slots || !data_out || !n || !data_in) {
+        return LT_PARAM_ERR;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        if (slots[i] > MAC_AND_DESTROY_SLOT_127) {
+            return LT_PARAM_ERR;
+        }
+    }
+    LT_HANDLE_LOCK(h);
+
+    struct lt_macandd_batch_t m = {.slots = slots, .data_out = data_out, .data_in = data_in};
+    struct lt_l3_batch_t b = {.n = n,
+                              .cmd_len = lt_macandd_batch_cmd_len,
+                              .out = lt_macandd_batch_out,
+                              .in = lt_macandd_batch_in,
+                              .ctx = &m};
+
+    return lt_l3_batch(h, &b);
+}
+
+#if LT_DEVICE_POOL
+lt_ret_t lt_pool_init(lt_pool_t *pool, lt_handle_t *const *handles, const uint8_t handles_cnt,
+                      void (*complete)(lt_pool_job_t *job, void *ctx), void *ctx)
+{
+    if (!pool || !handles || handles_cnt == 0) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < handles_cnt; i++) {
+        if (!handles[i]) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    pool->handles = handles;
+    pool->handles_cnt = handles_cnt;
+    pool->jobs = NULL;
+    pool->jobs_cnt = 0;
+    pool->next = 0;
+    pool->done = 0;
+    pool->complete = complete;
+    pool->ctx = ctx;
+    pool->chips = NULL;
+    pool->active_max = handles_cnt;
+    pool->active = handles_cnt;
+    pool->requeued = 0;
+    pool->prio = NULL;
+    pool->reads = NULL;
+    pool->warmup = NULL;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_pool_failover_init(lt_pool_t *pool, lt_pool_chip_t *chips, const uint8_t standby_cnt)
+{
+    if (!pool || !pool->handles || !chips || standby_cnt >= pool->handles_cnt) {
+        return LT_PARAM_ERR;
+    }
+
+    pool->active_max = pool->handles_cnt - standby_cnt;
+    for (uint8_t i = 0; i < pool->handles_cnt; i++) {
+        chips[i].state = (i < pool->active_max) ? LT_POOL_CHIP_ACTIVE : LT_POOL_CHIP_STANDBY;
+        chips[i].failures = 0;
+    }
+    pool->active = pool->active_max;
+    pool->chips = chips;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_pool_warmup_init(lt_pool_t *pool, lt_pool_chip_t *chips, const uint8_t standby_cnt,
+                             const lt_pool_warmup_t *warmup)
+{
+    if (!warmup || !warmup->shipriv || !warmup->shipub || (warmup->pkey_index > PAIRING_KEY_SLOT_INDEX_3)) {
+        return LT_PARAM_ERR;
+    }
+    lt_ret_t ret = lt_pool_failover_init(pool, chips, standby_cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Chips become active one by one as their workers finish the warm-up
+    for (uint8_t i = 0; i < pool->handles_cnt; i++) {
+        chips[i].state = LT_POOL_CHIP_INIT;
+    }
+    pool->active = 0;
+    pool->warmup = warmup;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_pool_submit(lt_pool_t *pool, lt_pool_job_t *jobs, const uint32_t jobs_cnt)
+{
+    if (!pool || !jobs || jobs_cnt == 0) {
+        return LT_PARAM_ERR;
+    }
+
+    for (uint32_t i = 0; i < jobs_cnt; i++) {
+        jobs[i].requeued = 0;
+        jobs[i].attempts = 0;
+        jobs[i].prio = LT_POOL_PRIO_CNT;
+    }
+    pool->jobs = jobs;
+    pool->jobs_cnt = jobs_cnt;
+    __atomic_store_n(&pool->requeued, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&pool->done, 0, __ATOMIC_RELAXED);
+    // Release the batch to workers which load `next` with acquire ordering
+    __atomic_store_n(&pool->next, 0, __ATOMIC_RELEASE);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_pool_prio_init(lt_pool_t *pool, lt_pool_prio_t *prio)
+{
+    if (!pool || !pool->handles || !prio || (!prio->lock != !prio->unlock)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(prio->head, 0, sizeof(prio->head));
+    memset(prio->tail, 0, sizeof(prio->tail));
+    memset(prio->skipped, 0, sizeof(prio->skipped));
+    memset(prio->stats, 0, sizeof(prio->stats));
+    memset(prio->service_us, 0, sizeof(prio->service_us));
+    memset(prio->backlog_us, 0, sizeof(prio->backlog_us));
+    pool->prio = prio;
+
+    return LT_OK;
+}
+
+static void lt_pool_prio_lock(lt_pool_prio_t *p)
+{
+    if (p->lock) {
+        p->lock(p->lock_ctx);
+    }
+}
+
+static void lt_pool_prio_unlock(lt_pool_prio_t *p)
+{
+    if (p->unlock) {
+        p->unlock(p->lock_ctx);
+    }
+}
+
+/** Expected execution time of the L3 command of the operation, until a job of it is completed */
+static uint32_t lt_pool_op_exec_us(const uint8_t op)
+{
+    static const uint8_t cmd_ids[LT_POOL_OPS_CNT] = {
+        [LT_POOL_OP_PING - 1] = LT_L3_PING_CMD_ID,
+        [LT_POOL_OP_RANDOM_VALUE_GET - 1] = LT_L3_RANDOM_VALUE_GET_CMD_ID,
+        [LT_POOL_OP_ECDSA_SIGN_DIGEST - 1] = LT_L3_ECDSA_SIGN_CMD_ID,
+        [LT_POOL_OP_EDDSA_SIGN - 1] = LT_L3_EDDSA_SIGN_CMD_ID,
+        [LT_POOL_OP_MAC_AND_DESTROY - 1] = LT_L3_MAC_AND_DESTROY_CMD_ID,
+        [LT_POOL_OP_ECC_KEY_READ - 1] = LT_L3_ECC_KEY_READ_CMD_ID,
+#if LT_ENABLE_R_MEM
+        [LT_POOL_OP_R_MEM_DATA_READ - 1] = LT_L3_R_MEM_DATA_READ_CMD_ID,
+#endif
+        [LT_POOL_OP_R_CONFIG_READ - 1] = LT_L3_R_CONFIG_READ_CMD_ID,
+        [LT_POOL_OP_I_CONFIG_READ - 1] = LT_L3_I_CONFIG_READ_CMD_ID,
+#if LT_ENABLE_MCOUNTER
+        [LT_POOL_OP_MCOUNTER_GET - 1] = LT_L3_MCOUNTER_GET_CMD_ID,
+#endif
+    };
+    const lt_l3_cmd_desc_t *desc = ((op >= 1) && (op <= LT_POOL_OPS_CNT)) ? lt_l3_cmd_desc_get(cmd_ids[op - 1]) : NULL;
+
+    return desc ? desc->exec_us : 0;
+}
+
+/** Predicted service time of the job, called with the lock held */
+static uint32_t lt_pool_prio_service_us(const lt_pool_prio_t *p, const lt_pool_job_t *job)
+{
+    if ((job->op < 1) || (job->op > LT_POOL_OPS_CNT)) {
+        return 0;
+    }
+
+    return p->service_us[job->op - 1] ? p->service_us[job->op - 1] : lt_pool_op_exec_us(job->op);
+}
+
+/** Predicted wait of a job of the class submitted after `extra_us` of work, called with the lock held */
+static uint64_t lt_pool_prio_wait_us(const lt_pool_t *pool, const lt_pool_prio_t *p, const uint8_t prio,
+                                     const uint64_t extra_us)
+{
+    uint64_t backlog_us = extra_us;
+    for (uint8_t i = 0; i <= prio; i++) {
+        backlog_us += p->backlog_us[i];
+    }
+    // While chips warm up none is active yet, all of them are expected to take jobs then
+    uint8_t active = __atomic_load_n(&pool->active, __ATOMIC_RELAXED);
+    if (!active) {
+        active = pool->active_max ? pool->active_max : 1;
+    }
+
+    return backlog_us / active;
+}
+
+lt_ret_t lt_pool_submit_prio(lt_pool_t *pool, const uint8_t prio, lt_pool_job_t *jobs, const uint32_t jobs_cnt)
+{
+    if (!pool || !pool->prio || (prio >= LT_POOL_PRIO_CNT) || !jobs || jobs_cnt == 0) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_pool_prio_t *p = pool->prio;
+    uint32_t now_us = p->time_us ? p->time_us() : 0;
+    for (uint32_t i = 0; i < jobs_cnt; i++) {
+        jobs[i].requeued = 0;
+        jobs[i].attempts = 0;
+        jobs[i].prio = prio;
+        jobs[i].submit_us = now_us;
+        jobs[i].queue_next = (i + 1 < jobs_cnt) ? &jobs[i + 1] : NULL;
+    }
+
+    lt_pool_prio_lock(p);
+    lt_pool_prio_stats_t *stats = &p->stats[prio];
+    uint64_t batch_us = 0;
+    for (uint32_t i = 0; i < jobs_cnt; i++) {
+        jobs[i].service_us = lt_pool_prio_service_us(p, &jobs[i]);
+        batch_us += jobs[i].service_us;
+    }
+    // The last job of the batch waits also for the ones before it
+    if (p->deadline_us[prio]
+        && (lt_pool_prio_wait_us(pool, p, prio, batch_us - jobs[jobs_cnt - 1].service_us) > p->deadline_us[prio])) {
+        stats->overloaded += jobs_cnt;
+        lt_pool_prio_unlock(p);
+        return LT_OVERLOAD;
+    }
+    p->backlog_us[prio] += batch_us;
+
+    if (p->tail[prio]) {
+        p->tail[prio]->queue_next = jobs;
+    }
+    else {
+        p->head[prio] = jobs;
+    }
+    p->tail[prio] = &jobs[jobs_cnt - 1];
+
+    stats->submitted += jobs_cnt;
+    stats->depth += jobs_cnt;
+    if (stats->depth > stats->depth_max) {
+        stats->depth_max = stats->depth;
+    }
+    lt_pool_prio_unlock(p);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_pool_prio_stats_get(lt_pool_t *pool, const uint8_t prio, lt_pool_prio_stats_t *stats)
+{
+    if (!pool || !pool->prio || (prio >= LT_POOL_PRIO_CNT) || !stats) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_pool_prio_lock(pool->prio);
+    *stats = pool->prio->stats[prio];
+    uint64_t wait_us = lt_pool_prio_wait_us(pool, pool->prio, prio, 0);
+    stats->wait_us_predicted = (wait_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)wait_us;
+    lt_pool_prio_unlock(pool->prio);
+
+    return LT_OK;
+}
+
+static void lt_pool_reads_lock(lt_pool_reads_t *r)
+{
+    if (r->lock) {
+        r->lock(r->lock_ctx);
+    }
+}
+
+static void lt_pool_reads_unlock(lt_pool_reads_t *r)
+{
+    if (r->unlock) {
+        r->unlock(r->lock_ctx);
+    }
+}
+
+lt_ret_t lt_pool_reads_init(lt_pool_t *pool, lt_pool_reads_t *reads)
+{
+    if (!pool || !pool->handles || !reads || (!reads->lock != !reads->unlock) || (reads->hedge_pct > 100)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(reads->flights, 0, sizeof(reads->flights));
+    memset(reads->samples_cnt, 0, sizeof(reads->samples_cnt));
+    memset(reads->samples_next, 0, sizeof(reads->samples_next));
+    memset(&reads->stats, 0, sizeof(reads->stats));
+    pool->reads = reads;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_pool_reads_stats_get(lt_pool_t *pool, lt_pool_reads_stats_t *stats)
+{
+    if (!pool || !pool->reads || !stats) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_pool_reads_lock(pool->reads);
+    *stats = pool->reads->stats;
+    lt_pool_reads_unlock(pool->reads);
+
+    return LT_OK;
+}
+
+/** Takes job of the highest class, unless a lower class was passed over `burst` times */
+static lt_pool_job_t *lt_pool_prio_take(lt_pool_prio_t *p)
+{
+    uint32_t burst = p->burst ? p->burst : LT_POOL_PRIO_BURST;
+    uint32_t now_us = p->time_us ? p->time_us() : 0;
+    int8_t c = -1;
+
+    lt_pool_prio_lock(p);
+    // Lowest class which was passed over too many times goes first
+    for (int8_t i = LT_POOL_PRIO_CNT - 1; (c < 0) && (i >= 0); i--) {
+        if (p->head[i] && (p->skipped[i] >= burst)) {
+            c = i;
+        }
+    }
+    for (int8_t i = 0; (c < 0) && (i < LT_POOL_PRIO_CNT); i++) {
+        if (p->head[i]) {
+            c = i;
+        }
+    }
+    if (c < 0) {
+        lt_pool_prio_unlock(p);
+        return NULL;
+    }
+
+    lt_pool_job_t *job = p->head[c];
+    p->head[c] = job->queue_next;
+    if (!p->head[c]) {
+        p->tail[c] = NULL;
+    }
+    p->skipped[c] = 0;
+    p->stats[c].depth--;
+    p->backlog_us[c] -= job->service_us;
+    job->start_us = now_us;
+    for (int8_t i = c + 1; i < LT_POOL_PRIO_CNT; i++) {
+        if (p->head[i]) {
+            p->skipped[i]++;
+        }
+    }
+    lt_pool_prio_unlock(p);
+
+    return job;
+}
+
+/** Returns job of a failed chip to the front of its class */
+static void lt_pool_prio_requeue(lt_pool_prio_t *p, lt_pool_job_t *job)
+{
+    lt_pool_prio_lock(p);
+    job->queue_next = p->head[job->prio];
+    p->head[job->prio] = job;
+    if (!p->tail[job->prio]) {
+        p->tail[job->prio] = job;
+    }
+    p->stats[job->prio].depth++;
+    p->backlog_us[job->prio] += job->service_us;
+    lt_pool_prio_unlock(p);
+}
+
+static void lt_pool_prio_done(lt_pool_prio_t *p, const lt_pool_job_t *job)
+{
+    // Unsigned difference is correct also when the clock wrapped around
+    uint32_t now_us = p->time_us ? p->time_us() : 0;
+    uint32_t latency_us = now_us - job->submit_us;
+
+    lt_pool_prio_lock(p);
+    if (p->time_us && (job->op >= 1) && (job->op <= LT_POOL_OPS_CNT)) {
+        // Average over about the last LT_POOL_SERVICE_EWMA jobs, which follows chips slowed down by load
+        uint32_t *service_us = &p->service_us[job->op - 1];
+        uint32_t sample_us = now_us - job->start_us;
+        *service_us = *service_us ? (uint32_t)(*service_us - *service_us / LT_POOL_SERVICE_EWMA
+                                               + sample_us / LT_POOL_SERVICE_EWMA)
+                                  : (sample_us ? sample_us : 1);
+    }
+    lt_pool_prio_stats_t *stats = &p->stats[job->prio];
+    stats->done++;
+    stats->latency_us_last = latency_us;
+    stats->latency_us_total += latency_us;
+    if (latency_us > stats->latency_us_max) {
+        stats->latency_us_max = latency_us;
+    }
+    lt_pool_prio_unlock(p);
+}
+
+/** Executes the job with its output stored into `out`, which is `job->out` unless the job is a hedged read */
+static lt_ret_t lt_pool_job_execute(lt_handle_t *h, const lt_pool_job_t *job, uint8_t *out, uint16_t *out_len)
+{
+    lt_ret_t ret;
+    uint16_t len = 0;
+    uint32_t value = 0;
+    lt_ecc_curve_type_t curve;
+    ecc_key_origin_t origin;
+
+    switch (job->op) {
+        case LT_POOL_OP_PING:
+            len = job->in_len;
+            ret = lt_ping(h, job->in, out, job->in_len);
+            break;
+        case LT_POOL_OP_RANDOM_VALUE_GET:
+            len = job->in_len;
+            ret = lt_random_value_get(h, out, job->in_len);
+            break;
+        case LT_POOL_OP_ECDSA_SIGN_DIGEST:
+            len = 64;
+            ret = lt_ecc_ecdsa_sign_digest(h, (ecc_slot_t)job->slot, job->in, out);
+            break;
+        case LT_POOL_OP_EDDSA_SIGN:
+            len = 64;
+            ret = lt_ecc_eddsa_sign(h, (ecc_slot_t)job->slot, job->in, job->in_len, out);
+            break;
+        case LT_POOL_OP_MAC_AND_DESTROY:
+            len = MAC_AND_DESTROY_DATA_SIZE;
+            ret = lt_mac_and_destroy(h, (mac_and_destroy_slot_t)job->slot, job->in, out);
+            break;
+        case LT_POOL_OP_ECC_KEY_READ:
+            len = 66;
+            ret = lt_ecc_key_read(h, (ecc_slot_t)job->slot, out, &curve, &origin);
+            if (ret == LT_OK) {
+                out[64] = (uint8_t)curve;
+                out[65] = (uint8_t)origin;
+            }
+            break;
+#if LT_ENABLE_R_MEM
+        case LT_POOL_OP_R_MEM_DATA_READ:
+            ret = lt_r_mem_data_read(h, job->slot, out, &len);
+            break;
+#endif
+        case LT_POOL_OP_R_CONFIG_READ:
+            len = sizeof(value);
+            ret = lt_r_config_read(h, (enum CONFIGURATION_OBJECTS_REGS)job->slot, &value);
+            memcpy(out, &value, sizeof(value));
+            break;
+        case LT_POOL_OP_I_CONFIG_READ:
+            len = sizeof(value);
+            ret = lt_i_config_read(h, (enum CONFIGURATION_OBJECTS_REGS)job->slot, &value);
+            memcpy(out, &value, sizeof(value));
+            break;
+#if LT_ENABLE_MCOUNTER
+        case LT_POOL_OP_MCOUNTER_GET:
+            len = sizeof(value);
+            ret = lt_mcounter_get(h, (enum lt_mcounter_index_t)job->slot, &value);
+            memcpy(out, &value, sizeof(value));
+            break;
+#endif
+        default:
+            ret = LT_PARAM_ERR;
+            break;
+    }
+    *out_len = (ret == LT_OK) ? len : 0;
+
+    return ret;
+}
+
+/** Errors after which the chip has to establish a new session before it executes another job */
+static bool lt_pool_session_lost(const lt_ret_t ret)
+{
+    switch (ret) {
+        case LT_HOST_NO_SESSION:
+        case LT_L1_CHIP_STARTUP_MODE:
+        case LT_L2_HSK_ERR:
+        case LT_L2_NO_SESSION:
+        case LT_L2_TAG_ERR:
+        case LT_NONCE_OVERFLOW:
+        // Response of the interrupted command was not read
+        case LT_DEADLINE_EXCEEDED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Takes the chip out of service, a standby chip takes its place */
+static void lt_pool_chip_fail(lt_pool_t *pool, const uint8_t chip, const lt_ret_t ret)
+{
+    lt_pool_chip_t *c = &pool->chips[chip];
+
+    if (c->state == LT_POOL_CHIP_ACTIVE) {
+        __atomic_fetch_sub(&pool->active, 1, __ATOMIC_RELAXED);
+    }
+    c->state = (ret == LT_L1_CHIP_ALARM_MODE) ? LT_POOL_CHIP_ALARM : LT_POOL_CHIP_LOST;
+    c->failures++;
+    LT_LOG_S2_WARN(&pool->handles[chip]->l2, "Chip %u of the pool failed, ret=%d", (unsigned)chip, (int)ret);
+}
+
+/** Reads STPub from the certificate store of the chip and passes its export to the cache */
+static lt_ret_t lt_pool_warmup_store(lt_handle_t *h, const lt_pool_warmup_t *w, const struct lt_chip_id_t *chip_id,
+                                     uint8_t *stpub, uint8_t *buff)
+{
+    if (!w->cache_save) {
+        return lt_get_info_st_pub(h, stpub, 32);
+    }
+
+    uint8_t certs[LT_NUM_CERTIFICATES][LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE];
+    struct lt_cert_store_t store;
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        store.certs[i] = certs[i];
+        store.buf_len[i] = sizeof(certs[i]);
+    }
+    lt_ret_t ret = lt_get_info_cert_store(h, &store);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    uint16_t len;
+    ret = lt_cert_store_export(chip_id, &store, buff, LT_CERT_STORE_EXPORT_SIZE_MAX, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    w->cache_save(chip_id, buff, len, w->ctx);
+
+    return lt_get_st_pub(&store, stpub, 32);
+}
+
+/** Initializes the handle of the chip and establishes its first session */
+static lt_ret_t lt_pool_warmup_chip(lt_pool_t *pool, const uint8_t chip)
+{
+    const lt_pool_warmup_t *w = pool->warmup;
+    lt_pool_chip_t *c = &pool->chips[chip];
+    lt_handle_t *h = pool->handles[chip];
+
+    lt_ret_t ret = lt_init(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    struct lt_chip_id_t chip_id;
+    ret = lt_get_info_chip_id(h, &chip_id);
+    if (ret == LT_OK) {
+        uint8_t stpub[32];
+        uint8_t buff[LT_CERT_STORE_EXPORT_SIZE_MAX];
+        uint16_t len = 0;
+        // Missing or stale cache entry (e.g. the chip was replaced) is not an error, the store is read instead
+        if (!w->cache_load || (w->cache_load(&chip_id, buff, sizeof(buff), &len, w->ctx) != LT_OK)
+            || (lt_cert_store_import(&chip_id, buff, len, NULL, stpub, sizeof(stpub)) != LT_OK)) {
+            ret = lt_pool_warmup_store(h, w, &chip_id, stpub, buff);
+        }
+        if (ret == LT_OK) {
+            ret = lt_session_ctx_init(&c->ctx, stpub, w->pkey_index, w->shipriv, w->shipub);
+        }
+        if (ret == LT_OK) {
+            ret = lt_session_start_ctx(h, &c->ctx);
+        }
+    }
+    if (ret != LT_OK) {
+        // The next call of lt_pool_work() starts the warm-up again
+        lt_deinit(h);
+    }
+
+    return ret;
+}
+
+/** Brings the chip into ACTIVE state, re-establishing its session when it was lost */
+static lt_ret_t lt_pool_chip_ready(lt_pool_t *pool, const uint8_t chip)
+{
+    lt_pool_chip_t *c = &pool->chips[chip];
+    lt_handle_t *h = pool->handles[chip];
+
+    if (c->state == LT_POOL_CHIP_ALARM) {
+        return LT_L1_CHIP_ALARM_MODE;
+    }
+    if (c->state == LT_POOL_CHIP_INIT) {
+        lt_ret_t ret = lt_pool_warmup_chip(pool, chip);
+        if (ret == LT_L1_CHIP_ALARM_MODE) {
+            c->state = LT_POOL_CHIP_ALARM;
+        }
+        else if (ret == LT_OK) {
+            c->state = LT_POOL_CHIP_STANDBY;
+        }
+        if (pool->warmup->ready) {
+            pool->warmup->ready(chip, ret, pool->warmup->ctx);
+        }
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+    // E.g. the handle's session was aborted or invalidated by sleep
+    if ((c->state != LT_POOL_CHIP_LOST) && (h->l3.session != SESSION_ON)) {
+        lt_pool_chip_fail(pool, chip, LT_HOST_NO_SESSION);
+    }
+    if (c->state == LT_POOL_CHIP_LOST) {
+        lt_ret_t ret = lt_session_start_ctx(h, &c->ctx);
+        if (ret != LT_OK) {
+            if (ret == LT_L1_CHIP_ALARM_MODE) {
+                c->state = LT_POOL_CHIP_ALARM;
+            }
+            return ret;
+        }
+        c->state = LT_POOL_CHIP_STANDBY;
+    }
+    if (c->state == LT_POOL_CHIP_STANDBY) {
+        uint8_t active = __atomic_load_n(&pool->active, __ATOMIC_RELAXED);
+        do {
+            if (active >= pool->active_max) {
+                return LT_BUSY;
+            }
+        } while (!__atomic_compare_exchange_n(&pool->active, &active, active + 1, false, __ATOMIC_RELAXED,
+                                              __ATOMIC_RELAXED));
+        c->state = LT_POOL_CHIP_ACTIVE;
+    }
+
+    return LT_OK;
+}
+
+/**
+ * Takes a requeued job first, so a job of a failed chip does not wait behind the rest of the batch, then a job of
+ * the priority classes
+ */
+static lt_pool_job_t *lt_pool_take(lt_pool_t *pool)
+{
+    if (__atomic_load_n(&pool->requeued, __ATOMIC_RELAXED)) {
+        for (uint32_t i = 0; i < pool->jobs_cnt; i++) {
+            uint8_t expected = 1;
+            if (__atomic_compare_exchange_n(&pool->jobs[i].requeued, &expected, 0, false, __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED)) {
+                __atomic_fetch_sub(&pool->requeued, 1, __ATOMIC_RELAXED);
+                return &pool->jobs[i];
+            }
+        }
+    }
+
+    if (pool->prio) {
+        lt_pool_job_t *job = lt_pool_prio_take(pool->prio);
+        if (job) {
+            return job;
+        }
+        // Workers poll the pool repeatedly, `next` is not increased after the batch is taken, so it never wraps
+        if (__atomic_load_n(&pool->next, __ATOMIC_RELAXED) >= pool->jobs_cnt) {
+            return NULL;
+        }
+    }
+
+    uint32_t i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_ACQUIRE);
+
+    return (i < pool->jobs_cnt) ? &pool->jobs[i] : NULL;
+}
+
+/** Takes the chip out of service after an error which needs it, returns true when the job may be requeued */
+static bool lt_pool_job_failed(lt_pool_t *pool, const uint8_t chip, const lt_ret_t ret)
+{
+    if (pool->chips && ((ret == LT_L1_CHIP_ALARM_MODE) || lt_pool_session_lost(ret))) {
+        lt_pool_chip_fail(pool, chip, ret);
+        return true;
+    }
+
+    return false;
+}
+
+/** Returns the job of a failed chip to the pool, returns false when it is given up */
+static bool lt_pool_job_requeue(lt_pool_t *pool, lt_pool_job_t *job)
+{
+    // The job is given up after as many failures as there are chips, its error is reported then
+    if (++job->attempts >= pool->handles_cnt) {
+        return false;
+    }
+    if (job->prio < LT_POOL_PRIO_CNT) {
+        lt_pool_prio_requeue(pool->prio, job);
+        return true;
+    }
+    // Counter first, so a worker which takes the job never decrements it below zero
+    __atomic_fetch_add(&pool->requeued, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&job->requeued, 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static void lt_pool_job_complete(lt_pool_t *pool, lt_pool_job_t *job)
+{
+    if (job->prio < LT_POOL_PRIO_CNT) {
+        lt_pool_prio_done(pool->prio, job);
+    }
+    if (pool->complete) {
+        pool->complete(job, pool->ctx);
+    }
+    if (job->prio == LT_POOL_PRIO_CNT) {
+        __atomic_fetch_add(&pool->done, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void lt_pool_job_run(lt_pool_t *pool, const uint8_t chip, lt_pool_job_t *job)
+{
+    job->chip = chip;
+    job->ret = lt_pool_job_execute(pool->handles[chip], job, job->out, &job->out_len);
+    if (lt_pool_job_failed(pool, chip, job->ret) && lt_pool_job_requeue(pool, job)) {
+        return;
+    }
+    lt_pool_job_complete(pool, job);
+}
+
+static bool lt_pool_op_read(const lt_pool_op_t op)
+{
+    return (op >= LT_POOL_OP_READ_FIRST) && (op < LT_POOL_OP_READ_FIRST + LT_POOL_OP_READS_CNT);
+}
+
+/** Returns how long a read of the operation executes before it is hedged, UINT32_MAX when it is not hedged */
+static uint32_t lt_pool_hedge_delay(const lt_pool_reads_t *r, const lt_pool_op_t op)
+{
+    uint32_t i = (uint32_t)(op - LT_POOL_OP_READ_FIRST);
+    uint32_t cnt = r->samples_cnt[i];
+    uint32_t sorted[LT_POOL_READS_SAMPLES];
+
+    if (!r->time_us || !r->hedge_pct || !cnt || (cnt < LT_POOL_READS_SAMPLES / 4)) {
+        return UINT32_MAX;
+    }
+
+    memcpy(sorted, r->samples[i], cnt * sizeof(sorted[0]));
+    for (uint32_t j = 1; j < cnt; j++) {
+        uint32_t v = sorted[j], k = j;
+        for (; (k > 0) && (sorted[k - 1] > v); k--) {
+            sorted[k] = sorted[k - 1];
+        }
+        sorted[k] = v;
+    }
+    uint32_t rank = ((r->hedge_pct * cnt) + 99) / 100;
+    uint32_t delay = sorted[(rank > 0) ? rank - 1 : 0];
+
+    return (delay > r->hedge_min_us) ? delay : r->hedge_min_us;
+}
+
+/** Executes the read of the flight on the chip, the first chip to finish delivers its result to the jobs */
+static void lt_pool_flight_run(lt_pool_t *pool, const uint8_t chip, lt_pool_flight_t *f, const bool hedge)
+{
+    lt_pool_reads_t *r = pool->reads;
+    // Chips of a hedged read execute it at once, so each has its own buffer and only the first one writes the jobs
+    uint8_t out[LT_POOL_READ_LEN_MAX];
+    uint16_t out_len = 0;
+    lt_pool_job_t read = {.op = f->op, .slot = f->slot};
+
+    lt_ret_t ret = lt_pool_job_execute(pool->handles[chip], &read, out, &out_len);
+    bool failed = lt_pool_job_failed(pool, chip, ret);
+    uint32_t now_us = r->time_us ? r->time_us() : 0;
+
+    lt_pool_job_t *jobs = NULL;
+    lt_pool_reads_lock(r);
+    f->runners--;
+    // A failed chip leaves the read to the other one, if any is still executing it
+    if (!f->done && ((ret == LT_OK) || !f->runners)) {
+        f->done = 1;
+        jobs = f->job;
+        jobs->flight_next = f->followers;
+        if (ret == LT_OK) {
+            uint32_t i = (uint32_t)(f->op - LT_POOL_OP_READ_FIRST);
+            // Unsigned difference is correct also when the clock wrapped around
+            r->samples[i][r->samples_next[i]] = now_us - f->start_us;
+            r->samples_next[i] = (r->samples_next[i] + 1) % LT_POOL_READS_SAMPLES;
+            if (r->samples_cnt[i] < LT_POOL_READS_SAMPLES) {
+                r->samples_cnt[i]++;
+            }
+            r->stats.hedge_wins += hedge;
+        }
+    }
+    if (f->done && !f->runners) {
+        f->job = NULL;
+    }
+    lt_pool_reads_unlock(r);
+
+    while (jobs) {
+        lt_pool_job_t *job = jobs;
+        // The application may reuse a completed job
+        jobs = job->flight_next;
+        job->chip = chip;
+        job->ret = ret;
+        job->out_len = out_len;
+        memcpy(job->out, out, out_len);
+        if (failed && lt_pool_job_requeue(pool, job)) {
+            continue;
+        }
+        lt_pool_job_complete(pool, job);
+    }
+}
+
+/** Executes the read job, or attaches it to an identical read which is executing */
+static void lt_pool_read(lt_pool_t *pool, const uint8_t chip, lt_pool_job_t *job)
+{
+    lt_pool_reads_t *r = pool->reads;
+    lt_pool_flight_t *f = NULL, *free_f = NULL;
+    uint32_t now_us = r->time_us ? r->time_us() : 0;
+
+    lt_pool_reads_lock(r);
+    for (uint8_t i = 0; !f && (i < LT_POOL_READS_FLIGHTS); i++) {
+        lt_pool_flight_t *fl = &r->flights[i];
+        if (!fl->job) {
+            free_f = free_f ? free_f : fl;
+        }
+        else if (!fl->done && (fl->op == job->op) && (fl->slot == job->slot)) {
+            f = fl;
+        }
+    }
+    if (f) {
+        job->flight_next = f->followers;
+        f->followers = job;
+        r->stats.collapsed++;
+        lt_pool_reads_unlock(r);
+        return;
+    }
+    r->stats.executed++;
+    if (free_f) {
+        *free_f = (lt_pool_flight_t){
+            .job = job, .op = job->op, .slot = job->slot, .chip = chip, .runners = 1, .start_us = now_us};
+    }
+    lt_pool_reads_unlock(r);
+
+    if (free_f) {
+        lt_pool_flight_run(pool, chip, free_f, false);
+    }
+    else {
+        // All flights are used, the read is executed on its own
+        lt_pool_job_run(pool, chip, job);
+    }
+}
+
+/**
+ * Executes again on the chip a read which executes on another chip longer than its hedging delay. Returns true when
+ * it did, `pending` is set when some read may need a hedge later.
+ */
+static bool lt_pool_hedge(lt_pool_t *pool, const uint8_t chip, bool *pending)
+{
+    lt_pool_reads_t *r = pool->reads;
+    lt_pool_flight_t *f = NULL;
+
+    *pending = false;
+    if (!r->time_us || !r->hedge_pct) {
+        return false;
+    }
+
+    uint32_t now_us = r->time_us();
+    lt_pool_reads_lock(r);
+    for (uint8_t i = 0; !f && (i < LT_POOL_READS_FLIGHTS); i++) {
+        lt_pool_flight_t *fl = &r->flights[i];
+        if (!fl->job || fl->done || fl->hedged || (fl->chip == chip)) {
+            continue;
+        }
+        uint32_t delay = lt_pool_hedge_delay(r, fl->op);
+        if (now_us - fl->start_us >= delay) {
+            f = fl;
+        }
+        else if (delay != UINT32_MAX) {
+            *pending = true;
+        }
+    }
+    if (f) {
+        f->hedged = 1;
+        f->runners++;
+        r->stats.hedged++;
+        r->stats.executed++;
+    }
+    lt_pool_reads_unlock(r);
+
+    if (!f) {
+        return false;
+    }
+    lt_pool_flight_run(pool, chip, f, true);
+
+    return true;
+}
+
+lt_ret_t lt_pool_work(lt_pool_t *pool, const uint8_t chip)
+{
+    if (!pool || chip >= pool->handles_cnt) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_handle_t *h = pool->handles[chip];
+    while (1) {
+        if (pool->chips) {
+            lt_ret_t ret = lt_pool_chip_ready(pool, chip);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+
+        lt_pool_job_t *job = lt_pool_take(pool);
+        if (job) {
+            if (pool->reads && lt_pool_op_read(job->op)) {
+                lt_pool_read(pool, chip, job);
+            }
+            else {
+                lt_pool_job_run(pool, chip, job);
+            }
+            continue;
+        }
+
+        // Only an idle chip hedges, so hedges never delay submitted jobs
+        bool pending = false;
+        if (pool->reads && lt_pool_hedge(pool, chip, &pending)) {
+            continue;
+        }
+        if (!pending) {
+            return LT_OK;
+        }
+        lt_ret_t ret = lt_l1_delay(&h->l2, 1);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+}
+
+lt_ret_t lt_pool_poll(lt_pool_t *pool)
+{
+    if (!pool || !pool->jobs) {
+        return LT_PARAM_ERR;
+    }
+
+    return (__atomic_load_n(&pool->done, __ATOMIC_ACQUIRE) == pool->jobs_cnt) ? LT_OK : LT_PENDING;
+}
+
+/** Returns pairing key slots whose sessions may execute the job, as SESSION_SHx_HAS_ACCESS bits */
+static uint8_t lt_pool_job_sessions(const struct lt_config_t *r_config, const lt_pool_job_t *job)
+{
+    switch (job->op) {
+        case LT_POOL_OP_PING:
+            return lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_PING_IDX, 0);
+        case LT_POOL_OP_RANDOM_VALUE_GET:
+            return lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_RANDOM_VALUE_GET_IDX, 0);
+        case LT_POOL_OP_ECDSA_SIGN_DIGEST:
+            return (job->slot > ECC_SLOT_31)
+                       ? 0
+                       : lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_ECDSA_SIGN_IDX, job->slot);
+        case LT_POOL_OP_EDDSA_SIGN:
+            return (job->slot > ECC_SLOT_31)
+                       ? 0
+                       : lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_EDDSA_SIGN_IDX, job->slot);
+        case LT_POOL_OP_MAC_AND_DESTROY:
+            return (job->slot > MAC_AND_DESTROY_SLOT_127)
+                       ? 0
+                       : lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY_IDX, job->slot);
+        case LT_POOL_OP_ECC_KEY_READ:
+            return (job->slot > ECC_SLOT_31)
+                       ? 0
+                       : lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_READ_IDX, job->slot);
+#if LT_ENABLE_R_MEM
+        case LT_POOL_OP_R_MEM_DATA_READ:
+            return (job->slot > R_MEM_DATA_SLOT_MAX)
+                       ? 0
+                       : lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_READ_IDX, job->slot);
+#endif
+        // Index 1 selects access to functionality objects (UAP), 0 to configuration objects
+        case LT_POOL_OP_R_CONFIG_READ:
+            return lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_READ_IDX,
+                                   job->slot >= CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE_ADDR);
+        case LT_POOL_OP_I_CONFIG_READ:
+            return lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_READ_IDX,
+                                   job->slot >= CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE_ADDR);
+#if LT_ENABLE_MCOUNTER
+        case LT_POOL_OP_MCOUNTER_GET:
+            return (job->slot > MCOUNTER_INDEX_15)
+                       ? 0
+                       : lt_uap_sessions(r_config, CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_GET_IDX, job->slot);
+#endif
+        default:
+            return 0;
+    }
+}
+
+/** Moves jobs from `first` on, which the session of `pkey` may execute, in front of the others, keeping their order */
+static uint32_t lt_pool_session_take(const struct lt_config_t *r_config, lt_pool_job_t *jobs, const uint32_t first,
+                                     const uint32_t jobs_cnt, const uint8_t pkey)
+{
+    uint32_t pos = first;
+
+    for (uint32_t i = first; i < jobs_cnt; i++) {
+        if (!(lt_pool_job_sessions(r_config, &jobs[i]) & (1U << pkey))) {
+            continue;
+        }
+        if (i != pos) {
+            lt_pool_job_t job = jobs[i];
+            memmove(&jobs[pos + 1], &jobs[pos], (i - pos) * sizeof(*jobs));
+            jobs[pos] = job;
+        }
+        pos++;
+    }
+
+    return pos - first;
+}
+
+lt_ret_t lt_pool_session_plan(const struct lt_config_t *r_config, lt_pool_job_t *jobs, const uint32_t jobs_cnt,
+                              const pkey_index_t current, lt_pool_session_group_t *groups, uint8_t *groups_cnt)
+{
+    if (!r_config || !jobs || !groups || !groups_cnt || (current > PAIRING_KEY_SLOT_INDEX_3)) {
+        return LT_PARAM_ERR;
+    }
+
+    // The current session is kept as long as it has jobs, then the session serving the most of the rest follows.
+    // Each session takes all jobs it may execute, so it forms one group at most.
+    *groups_cnt = 0;
+    uint32_t first = lt_pool_session_take(r_config, jobs, 0, jobs_cnt, (uint8_t)current);
+    if (first) {
+        groups[0].pkey = current;
+        groups[0].first = 0;
+        groups[0].cnt = first;
+        *groups_cnt = 1;
+    }
+    while (first < jobs_cnt) {
+        uint32_t best = 0;
+        uint8_t pkey = PAIRING_KEY_SLOT_INDEX_0;
+        for (uint8_t k = PAIRING_KEY_SLOT_INDEX_0; k <= PAIRING_KEY_SLOT_INDEX_3; k++) {
+            uint32_t cnt = 0;
+            for (uint32_t i = first; i < jobs_cnt; i++) {
+                cnt += (lt_pool_job_sessions(r_config, &jobs[i]) >> k) & 1U;
+            }
+            if (cnt > best) {
+                best = cnt;
+                pkey = k;
+            }
+        }
+        if (!best) {
+            break;
+        }
+
+        lt_pool_session_take(r_config, jobs, first, jobs_cnt, pkey);
+        groups[*groups_cnt].pkey = (pkey_index_t)pkey;
+        groups[*groups_cnt].first = first;
+        groups[*groups_cnt].cnt = best;
+        (*groups_cnt)++;
+        first += best;
+    }
+
+    // Jobs which no session may execute are left at the end
+    for (uint32_t i = first; i < jobs_cnt; i++) {
+        jobs[i].ret = LT_L3_UNAUTHORIZED;
+    }
+
+    return LT_OK;
+}
+#endif
+
+#if LT_ASYNC
+lt_ret_t lt_submit(lt_handle_t *h, lt_async_op_t *op, lt_async_cb_t cb, void *ctx)
+{
+    // Output buffer is checked here, because lt_in__*() would fail only after the command was executed
+    if (!h || !h->async || !op || !op->out || (!op->in && op->cmd != LT_ASYNC_RANDOM_VALUE_GET)
+        || op->cmd < LT_ASYNC_PING || op->cmd > LT_ASYNC_MAC_AND_DESTROY) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    op->cb = cb;
+    op->ctx = ctx;
+    op->next = NULL;
+    if (h->async->head) {
+        h->async->tail->next = op;
+    }
+    else {
+        h->async->head = op;
+        h->async->started = false;
+    }
+    h->async->tail = op;
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_async_out(lt_handle_t *h, const lt_async_op_t *op)
+{
+    switch (op->cmd) {
+        case LT_ASYNC_PING:
+            return lt_out__ping(h, op->in, op->in_len);
+        case LT_ASYNC_RANDOM_VALUE_GET:
+            return lt_out__random_value_get(h, op->in_len);
+        case LT_ASYNC_ECDSA_SIGN_DIGEST:
+            return lt_out__ecc_ecdsa_sign_digest(h, (ecc_slot_t)op->slot, op->in);
+        case LT_ASYNC_EDDSA_SIGN:
+            return lt_out__ecc_eddsa_sign(h, (ecc_slot_t)op->slot, op->in, op->in_len);
+        case LT_ASYNC_MAC_AND_DESTROY:
+            return lt_out__mac_and_destroy(h, (mac_and_destroy_slot_t)op->slot, op->in);
+        default:
+            return LT_PARAM_ERR;
+    }
+}
+
+static lt_ret_t lt_async_in(lt_handle_t *h, const lt_async_op_t *op)
+{
+    switch (op->cmd) {
+        case LT_ASYNC_PING:
+            return lt_in__ping(h, op->out, op->in_len);
+        case LT_ASYNC_RANDOM_VALUE_GET:
+            return lt_in__random_value_get(h, op->out, op->in_len);
+        case LT_ASYNC_ECDSA_SIGN_DIGEST:
+            return lt_in__ecc_ecdsa_sign(h, op->out);
+        case LT_ASYNC_EDDSA_SIGN:
+            return lt_in__ecc_eddsa_sign(h, op->out);
+        case LT_ASYNC_MAC_AND_DESTROY:
+            return lt_in__mac_and_destroy(h, op->out);
+        default:
+            return LT_PARAM_ERR;
+    }
+}
+
+/** Starts transfer of the encrypted command of the first operation, returns LT_PENDING when it was sent */
+static lt_ret_t lt_async_begin(lt_handle_t *h, uint32_t *wait_ms)
+{
+    lt_async_t *a = h->async;
+
+    a->started = true;
+#if LT_L3_SPLIT_BUFF
+    return lt_l2_transfer_begin_split(&h->l2, &a->t, h->l3.buff, h->l3.buff_len, h->l3.res_buff, h->l3.res_buff_len,
+                                      wait_ms);
+#else
+    return lt_l2_transfer_begin(&h->l2, &a->t, h->l3.buff, h->l3.buff_len, wait_ms);
+#endif
+}
+
+/** Removes the first operation from the queue and reports its result by the callback */
+static void lt_async_complete(lt_handle_t *h, const lt_ret_t ret)
+{
+    lt_async_t *a = h->async;
+    lt_async_op_t *op = a->head;
+
+    a->head = op->next;
+    a->started = false;
+    op->ret = ret;
+    if (op->cb) {
+        op->cb(h, op, op->ctx);
+    }
+}
+
+/** Sends command of the first operation, returns LT_PENDING when it was sent */
+static lt_ret_t lt_async_start(lt_handle_t *h, uint32_t *wait_ms)
+{
+    lt_async_t *a = h->async;
+
+    lt_ret_t ret = lt_l3_session_check(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_async_out(h, a->head);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_async_begin(h, wait_ms);
+}
+
+lt_ret_t lt_poll(lt_handle_t *h, uint32_t *wait_ms)
+{
+    if (!h || !h->async || !wait_ms) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    lt_async_t *a = h->async;
+    while (a->head) {
+        lt_ret_t ret;
+        if (!a->started) {
+            ret = lt_async_start(h, wait_ms);
+        }
+        else {
+            ret = lt_l2_transfer_poll(&h->l2, &a->t, wait_ms);
+            if (ret != LT_PENDING) {
+                // Offset of the finished transfer is the length of received result, or less for a failure
+                lt_l3_res_buff_used(&h->l3, a->t.offset);
+            }
+            if (ret == LT_OK) {
+                ret = lt_async_in(h, a->head);
+            }
+        }
+        if (ret == LT_PENDING) {
+            return LT_PENDING;
+        }
+
+        lt_async_complete(h, ret);
+    }
+
+    return LT_OK;
+}
+
+/**
+ * Starts the first operations of queues which did not send their command yet. Commands are prepared with encryption
+ * deferred, so those of up to LT_AESGCM_MULTI_LANES sessions are then encrypted by one `lt_l3_encrypt_multi()`.
+ */
+static void lt_async_start_multi(lt_handle_t *const *handles, const uint8_t handles_cnt)
+{
+    lt_handle_t *staged[LT_AESGCM_MULTI_LANES];
+    lt_l3_state_t *s3[LT_AESGCM_MULTI_LANES];
+    lt_ret_t rets[LT_AESGCM_MULTI_LANES];
+    size_t cnt = 0;
+
+    for (uint8_t i = 0; i < handles_cnt; i++) {
+        {
+            lt_handle_t *h = handles[i];
+            LT_HANDLE_LOCK(h);
+
+            lt_async_t *a = h->async;
+            while (a->head && !a->started) {
+                lt_ret_t ret = lt_l3_session_check(h);
+                if (ret == LT_OK) {
+                    h->l3.encrypt_deferred = 1;
+                    ret = lt_async_out(h, a->head);
+                    h->l3.encrypt_deferred = 0;
+                }
+                if (ret == LT_OK) {
+                    staged[cnt] = h;
+                    s3[cnt] = &h->l3;
+                    cnt++;
+                    break;
+                }
+                lt_async_complete(h, ret);
+            }
+        }
+
+        if ((cnt == LT_AESGCM_MULTI_LANES) || (cnt && (i + 1 == handles_cnt))) {
+            lt_l3_encrypt_multi(s3, cnt, rets);
+            for (size_t j = 0; j < cnt; j++) {
+                LT_HANDLE_LOCK(staged[j]);
+                // Result is polled by lt_async_poll_started() right after all commands are sent
+                uint32_t wait_unused;
+                lt_ret_t ret = (rets[j] == LT_OK) ? lt_async_begin(staged[j], &wait_unused) : rets[j];
+                if (ret != LT_PENDING) {
+                    lt_async_complete(staged[j], ret);
+                }
+            }
+            cnt = 0;
+        }
+    }
+}
+
+/** Polls transfer of the started first operation, `unstarted` is set when an operation is left to be started */
+static lt_ret_t lt_async_poll_started(lt_handle_t *h, uint32_t *wait_ms, bool *unstarted)
+{
+    LT_HANDLE_LOCK(h);
+
+    lt_async_t *a = h->async;
+    if (a->head && a->started) {
+        lt_ret_t ret = lt_l2_transfer_poll(&h->l2, &a->t, wait_ms);
+        if (ret == LT_PENDING) {
+            return LT_PENDING;
+        }
+        lt_l3_res_buff_used(&h->l3, a->t.offset);
+        if (ret == LT_OK) {
+            ret = lt_async_in(h, a->head);
+        }
+        lt_async_complete(h, ret);
+    }
+    if (a->head) {
+        *unstarted = true;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_poll_multi(lt_handle_t *const *handles, const uint8_t handles_cnt, uint32_t *wait_ms)
+{
+    if (!handles || !wait_ms) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < handles_cnt; i++) {
+        if (!handles[i] || !handles[i]->async) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    while (1) {
+        lt_async_start_multi(handles, handles_cnt);
+
+        lt_ret_t ret = LT_OK;
+        bool unstarted = false;
+        for (uint8_t i = 0; i < handles_cnt; i++) {
+            uint32_t wait = 0;
+            if (lt_async_poll_started(handles[i], &wait, &unstarted) == LT_PENDING) {
+                if ((ret != LT_PENDING) || (wait < *wait_ms)) {
+                    *wait_ms = wait;
+                }
+                ret = LT_PENDING;
+            }
+        }
+        // Operations following the completed ones are started together in the next round
+        if (!unstarted) {
+            return ret;
+        }
+    }
+}
+#endif
+
+static const char *lt_ret_strs[] = {"LT_OK",
+                                    "LT_FAIL",
+                                    "LT_HOST_NO_SESSION",
+                                    "LT_PARAM_ERR",
+                                    "LT_CRYPTO_ERR",
+                                    "LT_L1_SPI_ERROR",
+                                    "LT_L1_DATA_LEN_ERROR",
+                                    "LT_L1_CHIP_STARTUP_MODE",
+                                    "LT_L1_CHIP_ALARM_MODE",
+                                    "LT_L1_CHIP_BUSY",
+                                    "LT_L1_INT_TIMEOUT",
+                                    "LT_L3_R_MEM_DATA_READ_SLOT_EMPTY",
+                                    "LT_L3_R_MEM_DATA_WRITE_WRITE_FAIL",
+                                    "LT_L3_R_MEM_DATA_WRITE_SLOT_EXPIRED",
+                                    "LT_L3_ECC_INVALID_KEY",
+                                    "LT_L3_MCOUNTER_UPDATE_UPDATE_ERR",
+                                    "LT_L3_COUNTER_INVALID",
+                                    "LT_L3_PAIRING_KEY_EMPTY",
+                                    "LT_L3_PAIRING_KEY_INVALID",
+                                    "LT_L3_OK",
+                                    "LT_L3_FAIL",
+                                    "LT_L3_UNAUTHORIZED",
+                                    "LT_L3_INVALID_CMD",
+                                    "LT_L3_DATA_LEN_ERROR",
+                                    "LT_L2_IN_CRC_ERR",
+                                    "LT_L2_REQ_CONT",
+                                    "LT_L2_RES_CONT",
+                                    "LT_L2_RESP_DISABLED",
+                                    "LT_L2_HSK_ERR",
+                                    "LT_L2_NO_SESSION",
+                                    "LT_L2_TAG_ERR",
+                                    "LT_L2_CRC_ERR",
+                                    "LT_L2_GEN_ERR",
+                                    "LT_L2_NO_RESP",
+                                    "LT_L2_UNKNOWN_REQ",
+                                    "LT_L2_STATUS_NOT_RECOGNIZED",
+                                    "LT_L2_DATA_LEN_ERROR",
+                                    "LT_CERT_STORE_INVALID",
+                                    "LT_CERT_UNSUPPORTED",
+                                    "LT_CERT_ITEM_NOT_FOUND",
+                                    "LT_NONCE_OVERFLOW",
+                                    "LT_PENDING",
+                                    "LT_NOT_FOUND",
+                                    "LT_BUSY",
+                                    "LT_DEADLINE_EXCEEDED",
+                                    "LT_OVERLOAD"};
+
+const char *lt_ret_verbose(lt_ret_t ret)
+{
+    if (ret < LT_RET_T_LAST_VALUE) return lt_ret_strs[ret];
+
+    return "FATAL ERROR, unknown return value";
+}
+
+//--------------------------------------------------------------------------------------------------------//
+#ifdef LT_HELPERS
+
+struct lt_config_obj_desc_t cfg_desc_table[LT_CONFIG_OBJ_CNT] = {
+    {"CONFIGURATION_OBJECTS_CFG_START_UP                   ", CONFIGURATION_OBJECTS_CFG_START_UP_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_SENSORS                    ", CONFIGURATION_OBJECTS_CFG_SENSORS_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_DEBUG                      ", CONFIGURATION_OBJECTS_CFG_DEBUG_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_GPO_ADDR                   ", CONFIGURATION_OBJECTS_CFG_GPO_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_SLEEP_MODE                 ", CONFIGURATION_OBJECTS_CFG_SLEEP_MODE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE      ", CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_READ       ", CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_READ_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_INVALIDATE ",
+     CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_INVALIDATE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_WRITE_ERASE   ", CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_WRITE_ERASE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_READ          ", CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_READ_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_WRITE         ", CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_WRITE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_READ          ", CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_READ_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_PING                   ", CONFIGURATION_OBJECTS_CFG_UAP_PING_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_WRITE       ", CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_WRITE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_READ        ", CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_READ_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_ERASE       ", CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_ERASE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_RANDOM_VALUE_GET       ", CONFIGURATION_OBJECTS_CFG_UAP_RANDOM_VALUE_GET_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_GENERATE       ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_GENERATE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_STORE          ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_STORE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_READ           ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_READ_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_ERASE          ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_ERASE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_ECDSA_SIGN             ", CONFIGURATION_OBJECTS_CFG_UAP_ECDSA_SIGN_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_EDDSA_SIGN             ", CONFIGURATION_OBJECTS_CFG_UAP_EDDSA_SIGN_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_INIT          ", CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_INIT_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_GET           ", CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_GET_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_UPDATE        ", CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_UPDATE_ADDR},
+    {"CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY        ", CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY_ADDR}};
+
+/** Commands of configuration batch */
+enum lt_config_batch_op_t {
+    LT_CONFIG_BATCH_R_READ,
+    LT_CONFIG_BATCH_I_READ,
+    LT_CONFIG_BATCH_R_WRITE,
+    LT_CONFIG_BATCH_I_WRITE
+};
+
+/** Arguments of one pipelined batch over configuration objects */
+struct lt_config_batch_t {
+    enum lt_config_batch_op_t op;
+    /** Objects read into or written from, indexed as `cfg_desc_table` */
+    struct lt_config_t *rconfig;
+    const struct lt_config_t *wconfig;
+    /**
+     * One command is executed per set bit, in order of objects and bits. Bit index is the bit cleared by
+     * I_Config_Write, other commands use only bit 0.
+     */
+    uint32_t masks[LT_CONFIG_OBJ_CNT];
+};
+
+/** Returns number of commands of the batch */
+static uint32_t lt_config_batch_cnt(const struct lt_config_batch_t *c)
+{
+    uint32_t cnt = 0;
+    for (int k = 0; k < LT_CONFIG_OBJ_CNT; k++) {
+        for (uint32_t m = c->masks[k]; m; m &= m - 1) {
+            cnt++;
+        }
+    }
+
+    return cnt;
 }
 
-lt_ret_t lt_ecc_key_generate(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve)
+/** Finds object and bit index of i-th command of the batch */
+static void lt_config_batch_locate(const struct lt_config_batch_t *c, uint32_t i, uint8_t *obj, uint8_t *bit)
 {
-    if (!h || (slot > ECC_SLOT_31) || ((curve != CURVE_P256) && (curve != CURVE_ED25519))) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+    for (uint8_t k = 0; k < LT_CONFIG_OBJ_CNT; k++) {
+        for (uint8_t j = 0; j <= 31; j++) {
+            if (FIELD_GET(BIT(j), c->masks[k]) && !i--) {
+                *obj = k;
+                *bit = j;
+                return;
+            }
+        }
     }
+}
 
-    lt_ret_t ret = lt_out__ecc_key_generate(h, slot, curve);
-    if (ret != LT_OK) {
-        return ret;
+static uint16_t lt_config_batch_cmd_len(const void *ctx, uint32_t i)
+{
+    const struct lt_config_batch_t *c = ctx;
+    UNUSED(i);
+    switch (c->op) {
+        case LT_CONFIG_BATCH_R_READ:
+            return sizeof(struct lt_l3_r_config_read_cmd_t);
+        case LT_CONFIG_BATCH_I_READ:
+            return sizeof(struct lt_l3_i_config_read_cmd_t);
+        case LT_CONFIG_BATCH_R_WRITE:
+            return sizeof(struct lt_l3_r_config_write_cmd_t);
+        default:
+            return sizeof(struct lt_l3_i_config_write_cmd_t);
     }
+}
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+static lt_ret_t lt_config_batch_out(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_config_batch_t *c = ctx;
+    uint8_t obj = 0, bit = 0;
+    lt_config_batch_locate(c, i, &obj, &bit);
+    switch (c->op) {
+        case LT_CONFIG_BATCH_R_READ:
+            return lt_out__r_config_read(h, cfg_desc_table[obj].addr);
+        case LT_CONFIG_BATCH_I_READ:
+            return lt_out__i_config_read(h, cfg_desc_table[obj].addr);
+        case LT_CONFIG_BATCH_R_WRITE:
+            return lt_out__r_config_write(h, cfg_desc_table[obj].addr, c->wconfig->obj[obj]);
+        default:
+            return lt_out__i_config_write(h, cfg_desc_table[obj].addr, bit);
     }
+}
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+static lt_ret_t lt_config_batch_in(lt_handle_t *h, const void *ctx, uint32_t i)
+{
+    const struct lt_config_batch_t *c = ctx;
+    uint8_t obj = 0, bit = 0;
+    lt_config_batch_locate(c, i, &obj, &bit);
+    switch (c->op) {
+        case LT_CONFIG_BATCH_R_READ:
+            return lt_in__r_config_read(h, &c->rconfig->obj[obj]);
+        case LT_CONFIG_BATCH_I_READ:
+            return lt_in__i_config_read(h, &c->rconfig->obj[obj]);
+        case LT_CONFIG_BATCH_R_WRITE:
+            return lt_in__r_config_write(h);
+        default:
+            return lt_in__i_config_write(h);
     }
-
-    return lt_in__ecc_key_generate(h);
 }
 
-lt_ret_t lt_ecc_key_store(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve, const uint8_t *key)
+static lt_ret_t lt_config_batch(lt_handle_t *h, const struct lt_config_batch_t *c)
 {
-    if (!h || (slot > ECC_SLOT_31) || ((curve != CURVE_P256) && (curve != CURVE_ED25519)) || !key) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+    struct lt_l3_batch_t b = {.n = lt_config_batch_cnt(c),
+                              .cmd_len = lt_config_batch_cmd_len,
+                              .out = lt_config_batch_out,
+                              .in = lt_config_batch_in,
+                              .ctx = c};
+    if (!b.n) {
+        return LT_OK;
     }
-    lt_ret_t ret = lt_out__ecc_key_store(h, slot, curve, key);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+#if LT_CONFIG_CACHE
+    if (c->op == LT_CONFIG_BATCH_R_WRITE) {
+        lt_config_cache_drop(h, LT_CONFIG_SPACE_R);
     }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    else if (c->op == LT_CONFIG_BATCH_I_WRITE) {
+        lt_config_cache_drop(h, LT_CONFIG_SPACE_I);
     }
+#endif
 
-    return lt_in__ecc_key_store(h);
+    return lt_l3_batch(h, &b);
 }
 
-lt_ret_t lt_ecc_key_read(lt_handle_t *h, const ecc_slot_t ecc_slot, uint8_t *key, lt_ecc_curve_type_t *curve,
-                         ecc_key_origin_t *origin)
+lt_ret_t lt_read_whole_R_config(lt_handle_t *h, struct lt_config_t *config)
 {
-    if (!h || (ecc_slot > ECC_SLOT_31) || !key || !curve || !origin) {
+    if (!h || !config) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret = lt_out__ecc_key_read(h, ecc_slot);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    struct lt_config_batch_t c = {.op = LT_CONFIG_BATCH_R_READ, .rconfig = config};
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        c.masks[i] = 1;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+#if LT_CONFIG_CACHE
+    lt_ret_t ret = lt_config_batch(h, &c);
+    if ((ret == LT_OK) && h->config_cache) {
+        h->config_cache->r = *config;
+        h->config_cache->r_valid = 1;
     }
 
-    return lt_in__ecc_key_read(h, key, curve, origin);
+    return ret;
+#else
+    return lt_config_batch(h, &c);
+#endif
 }
 
-lt_ret_t lt_ecc_key_erase(lt_handle_t *h, const ecc_slot_t ecc_slot)
+lt_ret_t lt_write_whole_R_config(lt_handle_t *h, const struct lt_config_t *config)
 {
-    if (!h || (ecc_slot > ECC_SLOT_31)) {
+    if (!h || !config) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
-
-    lt_ret_t ret = lt_out__ecc_key_erase(h, ecc_slot);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    LT_HANDLE_LOCK(h);
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    struct lt_config_batch_t c = {.op = LT_CONFIG_BATCH_R_WRITE, .wconfig = config};
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        c.masks[i] = 1;
     }
 
-    return lt_in__ecc_key_erase(h);
+    return lt_config_batch(h, &c);
 }
 
-lt_ret_t lt_ecc_ecdsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint32_t msg_len,
-                           uint8_t *rs)
+lt_ret_t lt_read_whole_I_config(lt_handle_t *h, struct lt_config_t *config)
 {
-    if (!h || !msg || !rs || (ecc_slot > ECC_SLOT_31)) {
+    if (!h || !config) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret = lt_out__ecc_ecdsa_sign(h, ecc_slot, msg, msg_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    struct lt_config_batch_t c = {.op = LT_CONFIG_BATCH_I_READ, .rconfig = config};
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        c.masks[i] = 1;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+#if LT_CONFIG_CACHE
+    lt_ret_t ret = lt_config_batch(h, &c);
+    if ((ret == LT_OK) && h->config_cache) {
+        h->config_cache->i = *config;
+        h->config_cache->i_valid = 1;
     }
 
-    return lt_in__ecc_ecdsa_sign(h, rs);
+    return ret;
+#else
+    return lt_config_batch(h, &c);
+#endif
 }
 
-lt_ret_t lt_ecc_ecdsa_sig_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
+lt_ret_t lt_write_whole_I_config(lt_handle_t *h, const struct lt_config_t *config)
 {
-    if (!msg || !pubkey || !rs) {
+    if (!h || !config) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    if (lt_ecdsa_verify(msg, msg_len, pubkey, rs) != 0) {
-        return LT_FAIL;
+    struct lt_config_batch_t c = {.op = LT_CONFIG_BATCH_I_WRITE};
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        c.masks[i] = ~config->obj[i];
     }
 
-    return LT_OK;
+    return lt_config_batch(h, &c);
 }
 
-lt_ret_t lt_ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint16_t msg_len,
-                           uint8_t *rs)
+/** CRC16 of the snapshot without the crc field */
+static uint16_t lt_config_snapshot_crc(const struct lt_config_snapshot_t *snap)
 {
-    if (!h || !msg || !rs || (msg_len > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX) || (ecc_slot > ECC_SLOT_31)) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
+    uint16_t crc = crc16_init();
+    crc = crc16_update(crc, &snap->version, sizeof(snap->version));
+    crc = crc16_update(crc, &snap->space, sizeof(snap->space));
+    crc = crc16_update(crc, (const uint8_t *)snap->config.obj, sizeof(snap->config.obj));
 
-    lt_ret_t ret = lt_out__ecc_eddsa_sign(h, ecc_slot, msg, msg_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
+    return crc16_final(crc);
+}
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+lt_ret_t lt_config_snapshot_read(lt_handle_t *h, const lt_config_space_t space, struct lt_config_snapshot_t *snap)
+{
+    if (!h || !snap || ((space != LT_CONFIG_SPACE_R) && (space != LT_CONFIG_SPACE_I))) {
+        return LT_PARAM_ERR;
     }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
+    lt_ret_t ret = (space == LT_CONFIG_SPACE_R) ? lt_read_whole_R_config(h, &snap->config)
+                                                : lt_read_whole_I_config(h, &snap->config);
     if (ret != LT_OK) {
         return ret;
     }
+    snap->version = LT_CONFIG_SNAPSHOT_VERSION;
+    snap->space = (uint8_t)space;
+    snap->crc = lt_config_snapshot_crc(snap);
 
-    return lt_in__ecc_eddsa_sign(h, rs);
+    return LT_OK;
 }
 
-lt_ret_t lt_ecc_eddsa_sig_verify(const uint8_t *msg, const uint16_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
+lt_ret_t lt_config_snapshot_check(const struct lt_config_snapshot_t *snap)
 {
-    if (!msg || (msg_len > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX) || !pubkey || !rs) {
+    if (!snap) {
         return LT_PARAM_ERR;
     }
 
-    if (lt_ed25519_sign_open(msg, msg_len, pubkey, rs) != 0) {
+    if ((snap->version != LT_CONFIG_SNAPSHOT_VERSION) || (snap->crc != lt_config_snapshot_crc(snap))) {
         return LT_FAIL;
     }
 
     return LT_OK;
 }
 
-lt_ret_t lt_mcounter_init(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, const uint32_t mcounter_value)
-{
-    if (!h || (mcounter_index > MCOUNTER_INDEX_15) || mcounter_value > MCOUNTER_VALUE_MAX) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
-
-    lt_ret_t ret = lt_out__mcounter_init(h, mcounter_index, mcounter_value);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    return lt_in__mcounter_init(h);
-}
+// Changed objects are returned as a bit mask
+STATIC_ASSERT(LT_CONFIG_OBJ_CNT <= 32)
 
-lt_ret_t lt_mcounter_update(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index)
+lt_ret_t lt_config_snapshot_diff(const struct lt_config_snapshot_t *a, const struct lt_config_snapshot_t *b,
+                                 uint32_t *changed)
 {
-    if (!h || (mcounter_index > MCOUNTER_INDEX_15)) {
+    if (!a || !b || !changed || (a->space != b->space)) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
-
-    lt_ret_t ret = lt_out__mcounter_update(h, mcounter_index);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
-    }
 
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    *changed = 0;
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        if (a->config.obj[i] != b->config.obj[i]) {
+            *changed |= BIT(i);
+        }
     }
 
-    return lt_in__mcounter_update(h);
+    return LT_OK;
 }
 
-lt_ret_t lt_mcounter_get(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index, uint32_t *mcounter_value)
+lt_ret_t lt_config_state_read(lt_handle_t *h, struct lt_config_state_t *state)
 {
-    if (!h || (mcounter_index > MCOUNTER_INDEX_15) || !mcounter_value) {
+    if (!h || !state || (state->pkeys_mask >> (PAIRING_KEY_SLOT_INDEX_3 + 1))) {
         return LT_PARAM_ERR;
     }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
-    }
-
-    lt_ret_t ret = lt_out__mcounter_get(h, mcounter_index);
-    if (ret != LT_OK) {
-        return ret;
-    }
 
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    lt_ret_t ret = lt_read_whole_R_config(h, &state->r_config);
+    if (ret == LT_OK) {
+        ret = lt_read_whole_I_config(h, &state->i_config);
     }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_in__mcounter_get(h, mcounter_value);
-}
-
-lt_ret_t lt_mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, const uint8_t *data_out, uint8_t *data_in)
-{
-    if (!h || !data_out || !data_in || slot > MAC_AND_DESTROY_SLOT_127) {
-        return LT_PARAM_ERR;
-    }
-    if (h->l3.session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+    lt_pairing_key_op_t ops[PAIRING_KEY_SLOT_INDEX_3 + 1];
+    uint8_t cnt = 0;
+    for (uint8_t slot = 0; slot <= PAIRING_KEY_SLOT_INDEX_3; slot++) {
+        memset(state->pkeys[slot], 0, sizeof(state->pkeys[slot]));
+        state->pkeys_status[slot] = LT_FAIL;
+        if (state->pkeys_mask & BIT(slot)) {
+            ops[cnt++] = (lt_pairing_key_op_t){.op = LT_PAIRING_KEY_OP_READ, .slot = (pkey_index_t)slot};
+        }
     }
-
-    lt_ret_t ret = lt_out__mac_and_destroy(h, slot, data_out);
-    if (ret != LT_OK) {
-        return ret;
+    if (!cnt) {
+        return LT_OK;
     }
-
-    ret = lt_l2_send_encrypted_cmd(&h->l2, h->l3.buff, h->l3.buff_len);
+    ret = lt_pairing_key_batch(h, ops, cnt);
     if (ret != LT_OK) {
         return ret;
     }
-
-    ret = lt_l2_recv_encrypted_res(&h->l2, h->l3.buff, h->l3.buff_len);
-    if (ret != LT_OK) {
-        return ret;
+    for (uint8_t i = 0; i < cnt; i++) {
+        state->pkeys_status[ops[i].slot] = ops[i].status;
+        if (ops[i].status == LT_OK) {
+            memcpy(state->pkeys[ops[i].slot], ops[i].key, sizeof(ops[i].key));
+        }
     }
 
-    return lt_in__mac_and_destroy(h, data_in);
-}
-
-static const char *lt_ret_strs[] = {"LT_OK",
-                                    "LT_FAIL",
-                                    "LT_HOST_NO_SESSION",
-                                    "LT_PARAM_ERR",
-                                    "LT_CRYPTO_ERR",
-                                    "LT_L1_SPI_ERROR",
-                                    "LT_L1_DATA_LEN_ERROR",
-                                    "LT_L1_CHIP_STARTUP_MODE",
-                                    "LT_L1_CHIP_ALARM_MODE",
-                                    "LT_L1_CHIP_BUSY",
-                                    "LT_L1_INT_TIMEOUT",
-                                    "LT_L3_R_MEM_DATA_READ_SLOT_EMPTY",
-                                    "LT_L3_R_MEM_DATA_WRITE_WRITE_FAIL",
-                                    "LT_L3_R_MEM_DATA_WRITE_SLOT_EXPIRED",
-                                    "LT_L3_ECC_INVALID_KEY",
-                                    "LT_L3_MCOUNTER_UPDATE_UPDATE_ERR",
-                                    "LT_L3_COUNTER_INVALID",
-                                    "LT_L3_PAIRING_KEY_EMPTY",
-                                    "LT_L3_PAIRING_KEY_INVALID",
-                                    "LT_L3_OK",
-                                    "LT_L3_FAIL",
-                                    "LT_L3_UNAUTHORIZED",
-                                    "LT_L3_INVALID_CMD",
-                                    "LT_L3_DATA_LEN_ERROR",
-                                    "LT_L2_IN_CRC_ERR",
-                                    "LT_L2_REQ_CONT",
-                                    "LT_L2_RES_CONT",
-                                    "LT_L2_RESP_DISABLED",
-                                    "LT_L2_HSK_ERR",
-                                    "LT_L2_NO_SESSION",
-                                    "LT_L2_TAG_ERR",
-                                    "LT_L2_CRC_ERR",
-                                    "LT_L2_GEN_ERR",
-                                    "LT_L2_NO_RESP",
-                                    "LT_L2_UNKNOWN_REQ",
-                                    "LT_L2_STATUS_NOT_RECOGNIZED",
-                                    "LT_L2_DATA_LEN_ERROR",
-                                    "LT_CERT_STORE_INVALID",
-                                    "LT_CERT_UNSUPPORTED",
-                                    "LT_CERT_ITEM_NOT_FOUND",
-                                    "LT_NONCE_OVERFLOW"};
+    return LT_OK;
+}
 
-const char *lt_ret_verbose(lt_ret_t ret)
+/** Domain of the fingerprint, changed when its encoding changes */
+static const uint8_t lt_config_fingerprint_magic[5] = {'L', 'T', 'C', 'F', 1};
+
+/** Feeds configuration objects as little endian words */
+static void lt_config_fingerprint_objs(struct lt_crypto_sha256_ctx_t *hctx, const struct lt_config_t *config)
 {
-    if (ret < LT_RET_T_LAST_VALUE) return lt_ret_strs[ret];
+    uint8_t buf[4 * LT_CONFIG_OBJ_CNT];
 
-    return "FATAL ERROR, unknown return value";
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        buf[4 * i] = (uint8_t)config->obj[i];
+        buf[4 * i + 1] = (uint8_t)(config->obj[i] >> 8);
+        buf[4 * i + 2] = (uint8_t)(config->obj[i] >> 16);
+        buf[4 * i + 3] = (uint8_t)(config->obj[i] >> 24);
+    }
+    lt_sha256_update(hctx, buf, sizeof(buf));
 }
 
-//--------------------------------------------------------------------------------------------------------//
-#ifdef LT_HELPERS
-
-struct lt_config_obj_desc_t cfg_desc_table[LT_CONFIG_OBJ_CNT] = {
-    {"CONFIGURATION_OBJECTS_CFG_START_UP                   ", CONFIGURATION_OBJECTS_CFG_START_UP_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_SENSORS                    ", CONFIGURATION_OBJECTS_CFG_SENSORS_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_DEBUG                      ", CONFIGURATION_OBJECTS_CFG_DEBUG_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_GPO_ADDR                   ", CONFIGURATION_OBJECTS_CFG_GPO_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_SLEEP_MODE                 ", CONFIGURATION_OBJECTS_CFG_SLEEP_MODE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE      ", CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_READ       ", CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_READ_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_INVALIDATE ",
-     CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_INVALIDATE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_WRITE_ERASE   ", CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_WRITE_ERASE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_READ          ", CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_READ_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_WRITE         ", CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_WRITE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_READ          ", CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_READ_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_PING                   ", CONFIGURATION_OBJECTS_CFG_UAP_PING_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_WRITE       ", CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_WRITE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_READ        ", CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_READ_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_ERASE       ", CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_ERASE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_RANDOM_VALUE_GET       ", CONFIGURATION_OBJECTS_CFG_UAP_RANDOM_VALUE_GET_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_GENERATE       ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_GENERATE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_STORE          ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_STORE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_READ           ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_READ_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_ERASE          ", CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_ERASE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_ECDSA_SIGN             ", CONFIGURATION_OBJECTS_CFG_UAP_ECDSA_SIGN_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_EDDSA_SIGN             ", CONFIGURATION_OBJECTS_CFG_UAP_EDDSA_SIGN_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_INIT          ", CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_INIT_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_GET           ", CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_GET_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_UPDATE        ", CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_UPDATE_ADDR},
-    {"CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY        ", CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY_ADDR}};
+/** Kind of pairing key slot hashed before its key, errors other than empty and invalid slot are alike */
+static uint8_t lt_config_fingerprint_pkey(const lt_ret_t status)
+{
+    switch (status) {
+        case LT_OK:
+            return 0;
+        case LT_L3_PAIRING_KEY_EMPTY:
+            return 1;
+        case LT_L3_PAIRING_KEY_INVALID:
+            return 2;
+        default:
+            return 3;
+    }
+}
 
-lt_ret_t lt_read_whole_R_config(lt_handle_t *h, struct lt_config_t *config)
+lt_ret_t lt_config_fingerprint(const struct lt_config_state_t *state, uint8_t *fp)
 {
-    if (!h || !config) {
+    if (!state || !fp || (state->pkeys_mask >> (PAIRING_KEY_SLOT_INDEX_3 + 1))) {
         return LT_PARAM_ERR;
     }
 
-    lt_ret_t ret;
-
-    for (uint8_t i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
-        ret = lt_r_config_read(h, cfg_desc_table[i].addr, &config->obj[i]);
-        if (ret != LT_OK) {
-            return ret;
+    struct lt_crypto_sha256_ctx_t hctx = {0};
+    lt_sha256_init(&hctx);
+    lt_sha256_start(&hctx);
+    lt_sha256_update(&hctx, lt_config_fingerprint_magic, sizeof(lt_config_fingerprint_magic));
+    lt_config_fingerprint_objs(&hctx, &state->r_config);
+    lt_config_fingerprint_objs(&hctx, &state->i_config);
+    lt_sha256_update(&hctx, &state->pkeys_mask, 1);
+    for (uint8_t slot = 0; slot <= PAIRING_KEY_SLOT_INDEX_3; slot++) {
+        if (!(state->pkeys_mask & BIT(slot))) {
+            continue;
+        }
+        const uint8_t item[2] = {slot, lt_config_fingerprint_pkey(state->pkeys_status[slot])};
+        lt_sha256_update(&hctx, item, sizeof(item));
+        if (state->pkeys_status[slot] == LT_OK) {
+            lt_sha256_update(&hctx, state->pkeys[slot], sizeof(state->pkeys[slot]));
         }
     }
+    lt_sha256_finish(&hctx, fp);
 
     return LT_OK;
 }
 
-lt_ret_t lt_write_whole_R_config(lt_handle_t *h, const struct lt_config_t *config)
+lt_ret_t lt_config_fingerprint_match(lt_handle_t *h, const uint8_t *target, struct lt_config_state_t *state,
+                                     bool *match)
 {
-    if (!h || !config) {
+    if (!h || !target || !state || !match) {
         return LT_PARAM_ERR;
     }
+    *match = false;
 
-    lt_ret_t ret;
-
-    for (uint8_t i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
-        ret = lt_r_config_write(h, cfg_desc_table[i].addr, config->obj[i]);
-        if (ret != LT_OK) {
-            return ret;
-        }
+    lt_ret_t ret = lt_config_state_read(h, state);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    uint8_t fp[LT_CONFIG_FINGERPRINT_SIZE];
+    ret = lt_config_fingerprint(state, fp);
+    if (ret != LT_OK) {
+        return ret;
     }
+    *match = !memcmp(fp, target, sizeof(fp));
 
     return LT_OK;
 }
 
-lt_ret_t lt_read_whole_I_config(lt_handle_t *h, struct lt_config_t *config)
+/** Erased value of R-Config object, only an erased object can be written */
+#define LT_R_CONFIG_OBJ_ERASED 0xFFFFFFFFu
+
+lt_ret_t lt_write_R_config_diff(lt_handle_t *h, const struct lt_config_t *current, const struct lt_config_t *config)
 {
     if (!h || !config) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret;
+    struct lt_config_t read;
+    if (!current) {
+        lt_ret_t ret = lt_read_whole_R_config(h, &read);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        current = &read;
+    }
+
+    struct lt_config_batch_t c = {.op = LT_CONFIG_BATCH_R_WRITE, .wconfig = config};
+    bool erase = false;
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        if (current->obj[i] != config->obj[i]) {
+            c.masks[i] = 1;
+            erase |= (current->obj[i] != LT_R_CONFIG_OBJ_ERASED);
+        }
+    }
 
-    for (uint8_t i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
-        ret = lt_i_config_read(h, cfg_desc_table[i].addr, &config->obj[i]);
+    if (erase) {
+        // Changed object cannot be written without erasing the whole R-Config, then all objects but erased ones are
+        // written again
+        lt_ret_t ret = lt_r_config_erase(h);
         if (ret != LT_OK) {
             return ret;
         }
+        for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+            c.masks[i] = (config->obj[i] != LT_R_CONFIG_OBJ_ERASED);
+        }
     }
 
-    return LT_OK;
+    return lt_config_batch(h, &c);
 }
 
-lt_ret_t lt_write_whole_I_config(lt_handle_t *h, const struct lt_config_t *config)
+lt_ret_t lt_write_I_config_diff(lt_handle_t *h, const struct lt_config_t *current, const struct lt_config_t *config)
 {
     if (!h || !config) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
-    lt_ret_t ret;
-    uint32_t cfg_obj;
-    enum CONFIGURATION_OBJECTS_REGS addr;
-
-    for (uint8_t i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
-        cfg_obj = config->obj[i];
-        addr = cfg_desc_table[i].addr;
-        for (uint8_t j = 0; j <= 31; j++) {
-            if (!FIELD_GET(BIT(j), cfg_obj)) {
-                ret = lt_i_config_write(h, addr, j);
-                if (ret != LT_OK) {
-                    return ret;
-                }
-            }
+    struct lt_config_t read;
+    if (!current) {
+        lt_ret_t ret = lt_read_whole_I_config(h, &read);
+        if (ret != LT_OK) {
+            return ret;
         }
+        current = &read;
     }
 
-    return LT_OK;
+    // Only bits which are still 1 are written, setting a bit back to 1 is not possible
+    struct lt_config_batch_t c = {.op = LT_CONFIG_BATCH_I_WRITE};
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        c.masks[i] = current->obj[i] & ~config->obj[i];
+    }
+
+    return lt_config_batch(h, &c);
+}
+
+/**
+ * Number of slots (or counters) sharing one 8-bit field of each UAP object, 0 for objects with a single field.
+ * Objects with fields of configuration and functionality (R_CONFIG_READ, I_CONFIG_*) use field index directly.
+ */
+static const uint8_t lt_uap_field_slots[LT_CONFIG_OBJ_CNT] = {
+    [CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE_IDX] = 1,
+    [CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_READ_IDX] = 1,
+    [CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_INVALIDATE_IDX] = 1,
+    [CONFIGURATION_OBJECTS_CFG_UAP_R_CONFIG_READ_IDX] = 1,
+    [CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_WRITE_IDX] = 1,
+    [CONFIGURATION_OBJECTS_CFG_UAP_I_CONFIG_READ_IDX] = 1,
+    [CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_WRITE_IDX] = 128,
+    [CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_READ_IDX] = 128,
+    [CONFIGURATION_OBJECTS_CFG_UAP_R_MEM_DATA_ERASE_IDX] = 128,
+    [CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_GENERATE_IDX] = 8,
+    [CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_STORE_IDX] = 8,
+    [CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_READ_IDX] = 8,
+    [CONFIGURATION_OBJECTS_CFG_UAP_ECC_KEY_ERASE_IDX] = 8,
+    [CONFIGURATION_OBJECTS_CFG_UAP_ECDSA_SIGN_IDX] = 8,
+    [CONFIGURATION_OBJECTS_CFG_UAP_EDDSA_SIGN_IDX] = 8,
+    [CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_INIT_IDX] = 4,
+    [CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_GET_IDX] = 4,
+    [CONFIGURATION_OBJECTS_CFG_UAP_MCOUNTER_UPDATE_IDX] = 4,
+    [CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY_IDX] = 32,
+};
+
+uint8_t lt_uap_sessions(const struct lt_config_t *config, const CONFIGURATION_OBJECTS_REGS_IDX obj,
+                        const uint16_t index)
+{
+    if (!config || (obj < CONFIGURATION_OBJECTS_CFG_UAP_PAIRING_KEY_WRITE_IDX)
+        || (obj > CONFIGURATION_OBJECTS_CFG_UAP_MAC_AND_DESTROY_IDX)) {
+        return 0;
+    }
+
+    uint16_t field = lt_uap_field_slots[obj] ? (uint16_t)(index / lt_uap_field_slots[obj]) : 0;
+    if (field > 3) {
+        return 0;
+    }
+
+    return (uint8_t)((config->obj[obj] >> (8 * field))
+                     & (SESSION_SH0_HAS_ACCESS | SESSION_SH1_HAS_ACCESS | SESSION_SH2_HAS_ACCESS
+                        | SESSION_SH3_HAS_ACCESS));
 }
 
 lt_ret_t lt_verify_chip_and_start_secure_session(lt_handle_t *h, uint8_t *shipriv, uint8_t *shipub, uint8_t pkey_index)
@@ -1546,6 +6761,7 @@ lt_ret_t lt_verify_chip_and_start_secure_session(lt_handle_t *h, uint8_t *shipri
     if (!h || !shipriv || !shipub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3)) {
         return LT_PARAM_ERR;
     }
+    LT_HANDLE_LOCK(h);
 
     lt_ret_t ret = LT_FAIL;
 
@@ -1570,26 +6786,9 @@ lt_ret_t lt_verify_chip_and_start_secure_session(lt_handle_t *h, uint8_t *shipri
         return ret;
     }
 
-    // Read certificate store
-    uint8_t cert_ese[LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE] = {0};
-    uint8_t cert_xxxx[LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE] = {0};
-    uint8_t cert_tr01[LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE] = {0};
-    uint8_t cert_root[LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE] = {0};
-
-    struct lt_cert_store_t cert_store
-        = {.cert_len = {0, 0, 0, 0},
-           .buf_len = {LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE, LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE,
-                       LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE, LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE},
-           .certs = {cert_ese, cert_xxxx, cert_tr01, cert_root}};
-
-    ret = lt_get_info_cert_store(h, &cert_store);
-    if (ret != LT_OK) {
-        return ret;
-    }
-
-    // Extract STPub
+    // Read only as much of the device certificate as is needed to extract STPub
     uint8_t stpub[32] = {0};
-    ret = lt_get_st_pub(&cert_store, stpub, 32);
+    ret = lt_get_info_st_pub(h, stpub, 32);
     if (ret != LT_OK) {
         return ret;
     }
@@ -1602,6 +6801,29 @@ lt_ret_t lt_verify_chip_and_start_secure_session(lt_handle_t *h, uint8_t *shipri
     return LT_OK;
 }
 
+lt_ret_t lt_verify_chip_and_start_secure_session_scratch(lt_handle_t *h, uint8_t *shipriv, uint8_t *shipub,
+                                                         uint8_t pkey_index, lt_session_scratch_t *scratch)
+{
+    if (!h || !shipriv || !shipub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !scratch) {
+        return LT_PARAM_ERR;
+    }
+    LT_HANDLE_LOCK(h);
+
+    // Everything bigger than a few words lives in scratch, STPub is parsed from the certificate blocks as they come
+    lt_session_ctx_t *ctx = &scratch->ctx;
+    memset(scratch, 0, sizeof(*scratch));
+    lt_ret_t ret = lt_get_info_st_pub(h, ctx->stpub, sizeof(ctx->stpub));
+    if (ret == LT_OK) {
+        lt_session_hash_prefix_hctx(scratch->sha256, shipub, ctx->stpub, ctx->hash);
+        ctx->shipriv = shipriv;
+        ctx->pkey_index = (pkey_index_t)pkey_index;
+        ret = lt_session_handshake(h, ctx, &scratch->state, scratch->sha256);
+    }
+    memset(scratch, 0, sizeof(*scratch));
+
+    return ret;
+}
+
 lt_ret_t lt_print_bytes(const uint8_t *bytes, const uint16_t length, char *out_buf, uint16_t out_buf_size)
 {
     if (!bytes || !out_buf || out_buf_size < (length * 2 + 1)) {
@@ -1793,47 +7015,324 @@ lt_ret_t lt_print_chip_id(const struct lt_chip_id_t *chip_id, int (*print_func)(
     return LT_OK;
 }
 
+#if LT_ENABLE_FW_UPDATE
 lt_ret_t lt_do_mutable_fw_update(lt_handle_t *h, const uint8_t *update_data, const uint16_t update_data_size,
                                  bank_id_t bank_id)
 {
+    if (!update_data) {
+        return LT_PARAM_ERR;
+    }
+
+    return lt_do_mutable_fw_update_stream(h, lt_fw_mem_read, (void *)(uintptr_t)update_data, update_data_size,
+                                          bank_id);
+}
+
+lt_ret_t lt_do_mutable_fw_update_stream(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx,
+                                        const uint32_t update_data_size, bank_id_t bank_id)
+{
+    struct lt_fw_update_t u = {.read = read, .read_ctx = ctx, .size = update_data_size};
+
+    return lt_do_mutable_fw_update_resume(h, &u, bank_id);
+}
+
+lt_ret_t lt_do_mutable_fw_update_resume(lt_handle_t *h, struct lt_fw_update_t *u, bank_id_t bank_id)
+{
+#ifdef ABAB
+    if (!h || !u || !u->read || u->size > LT_MUTABLE_FW_UPDATE_SIZE_MAX || (u->cursor > u->size)
+        || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
+            && (bank_id != FW_BANK_SPECT2))) {
+        return LT_PARAM_ERR;
+    }
+#elif ACAB
+    UNUSED(bank_id);  // bank_id is not used with ACAB, chip handles banks on its own
+    if (!h || !u || !u->read || (u->size <= LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1) || (u->cursor > u->size)
+        || ((u->cursor > 0) && (u->cursor < LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1))
+        || u->size > LT_MUTABLE_FW_UPDATE_SIZE_MAX) {
+        return LT_PARAM_ERR;
+    }
+#else
+#error "Undefined silicon revision. Please define either ABAB or ACAB."
+#endif
+    LT_HANDLE_LOCK(h);
+
+    lt_ret_t ret;
+    if (u->cursor) {
+        // Chunks already acknowledged are kept only while bootloader is running
+        ret = lt_update_mode(h);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (h->l2.mode != LT_MODE_MAINTENANCE) {
+            return LT_FAIL;
+        }
+    }
+    else {
+        u->chunks = 0;
+#ifdef ABAB
+        ret = lt_mutable_fw_erase(h, bank_id);
+        if (ret != LT_OK) {
+            return ret;
+        }
+#elif ACAB
+        // send the update 'request'
+        uint8_t update_request[LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1];
+        ret = u->read(u->read_ctx, 0, update_request, sizeof(update_request));
+        if (ret != LT_OK) {
+            return ret;
+        }
+        ret = lt_mutable_fw_update(h, update_request);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        u->cursor = sizeof(update_request);
+        u->chunks = 1;
+        if (u->progress) {
+            u->progress(u->progress_ctx, u);
+        }
+#endif
+    }
+
+#ifdef ABAB
+    return lt_mutable_fw_update_resume(h, u, bank_id);
+#elif ACAB
+    // send the rest - update 'data'
+    return lt_mutable_fw_update_data_resume(h, u);
+#endif
+}
+
 #ifdef ABAB
-    if (!h || !update_data || update_data_size > LT_MUTABLE_FW_UPDATE_SIZE_MAX
+/** @brief Offset of the firmware header (same layout as header_boot_v1_t) in ABAB update image */
+#define LT_FW_IMAGE_HEADER_OFFSET 0x200u
+/** @brief Number of header bytes compared with the bank header */
+#define LT_FW_IMAGE_HEADER_LEN LT_L2_GET_INFO_FW_HEADER_SIZE_BOOT_V1
+#elif ACAB
+/** @brief Offset of the type, header version and FW version in ACAB update image (within the update request) */
+#define LT_FW_IMAGE_HEADER_OFFSET (1 + MEMBER_SIZE(struct lt_l2_mutable_fw_update_req_t, signature) \
+                                   + MEMBER_SIZE(struct lt_l2_mutable_fw_update_req_t, hash))
+/** @brief Number of header bytes compared with the bank header, type to ver of header_boot_v2_t */
+#define LT_FW_IMAGE_HEADER_LEN offsetof(struct header_boot_v2_t, size)
+#endif
+
+lt_ret_t lt_fw_bank_identical(lt_handle_t *h, lt_fw_read_cb_t read, void *ctx, const uint32_t update_data_size,
+                              bank_id_t bank_id, bool *identical)
+{
+    if (!h || !read || !identical || (update_data_size < LT_FW_IMAGE_HEADER_OFFSET + LT_FW_IMAGE_HEADER_LEN)
+        || update_data_size > LT_MUTABLE_FW_UPDATE_SIZE_MAX
         || ((bank_id != FW_BANK_FW1) && (bank_id != FW_BANK_FW2) && (bank_id != FW_BANK_SPECT1)
             && (bank_id != FW_BANK_SPECT2))) {
         return LT_PARAM_ERR;
     }
-    lt_ret_t ret = lt_mutable_fw_erase(h, bank_id);
+    *identical = false;
+
+    uint8_t image_header[LT_FW_IMAGE_HEADER_LEN];
+    lt_ret_t ret = read(ctx, LT_FW_IMAGE_HEADER_OFFSET, image_header, sizeof(image_header));
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_mutable_fw_update(h, update_data, update_data_size, bank_id);
+    // Empty bank returns no header, zeroes never match the image header
+    uint8_t bank_header[LT_L2_GET_INFO_FW_HEADER_SIZE] = {0};
+    ret = lt_get_info_fw_bank(h, bank_id, bank_header, sizeof(bank_header));
     if (ret != LT_OK) {
         return ret;
     }
 
-#elif ACAB
-    UNUSED(bank_id);  // bank_id is not used with ACAB, chip handles banks on its own
-    if (!h || !update_data || update_data_size > LT_MUTABLE_FW_UPDATE_SIZE_MAX) {
+    *identical = (0 == memcmp(image_header, bank_header, sizeof(image_header)));
+
+    return LT_OK;
+}
+
+lt_ret_t lt_do_mutable_fw_update_if_changed(lt_handle_t *h, const uint8_t *update_data,
+                                            const uint16_t update_data_size, bank_id_t bank_id, bool *updated)
+{
+    if (!update_data || !updated) {
         return LT_PARAM_ERR;
     }
+    *updated = false;
+
+    bool identical;
+    lt_ret_t ret = lt_fw_bank_identical(h, lt_fw_mem_read, (void *)(uintptr_t)update_data, update_data_size,
+                                        bank_id, &identical);
+    if (ret != LT_OK || identical) {
+        return ret;
+    }
 
-    // send the update 'request'
-    lt_ret_t ret = lt_mutable_fw_update(h, update_data);
+    ret = lt_do_mutable_fw_update(h, update_data, update_data_size, bank_id);
     if (ret != LT_OK) {
         return ret;
     }
+    *updated = true;
 
-    // send the rest - update 'data'
-    ret = lt_mutable_fw_update_data(h, update_data, update_data_size);
+    return LT_OK;
+}
+
+/** Records failure of `dev`, with LT_FW_FLEET_ABORT all devices still being updated are stopped */
+static void lt_fw_fleet_fail(lt_fw_fleet_t *f, lt_fw_fleet_dev_t *dev, const lt_ret_t ret)
+{
+    dev->ret = ret;
+    if (f->policy == LT_FW_FLEET_ABORT) {
+        for (uint8_t i = 0; i < f->cnt; i++) {
+            if (f->devs[i].ret == LT_OK) {
+                f->devs[i].ret = LT_FAIL;
+            }
+        }
+    }
+}
+
+/** Reboots device into MAINTENANCE mode and prepares it for update data starting at `start` */
+static lt_ret_t lt_fw_fleet_start(lt_fw_fleet_t *f, lt_fw_fleet_dev_t *dev, const uint8_t *update_request,
+                                  const uint32_t start)
+{
+    LT_HANDLE_LOCK(dev->h);
+
+    lt_ret_t ret = lt_reboot(dev->h, LT_MODE_MAINTENANCE);
     if (ret != LT_OK) {
         return ret;
     }
+    if (dev->h->l2.mode != LT_MODE_MAINTENANCE) {
+        return LT_FAIL;
+    }
 
-#else
-#error "Undefined silicon revision. Please define either ABAB or ACAB."
+#ifdef ABAB
+    UNUSED(update_request);
+    ret = lt_mutable_fw_erase(dev->h, f->bank_id);
+#elif ACAB
+    UNUSED(f);  // bank_id is not used with ACAB, chip handles banks on its own
+    ret = lt_mutable_fw_update(dev->h, update_request);
 #endif
+    if (ret != LT_OK) {
+        return ret;
+    }
+    dev->cursor = start;
+    dev->chunks = start ? 1 : 0;
 
     return LT_OK;
 }
+
+/** Reboots updated device into APP mode and checks it reports version of the image */
+static lt_ret_t lt_fw_fleet_finish(lt_fw_fleet_t *f, lt_fw_fleet_dev_t *dev, const uint8_t *image_header)
+{
+    LT_HANDLE_LOCK(dev->h);
+
+    lt_ret_t ret = lt_reboot(dev->h, LT_MODE_APP);
+    if ((ret != LT_OK) || !f->verify) {
+        return ret;
+    }
+
+    // Both image headers start with type (1 == RISCV FW, 2 == SPECT FW) followed by 4 bytes of version at offset 4
+    uint8_t ver[LT_L2_GET_INFO_RISCV_FW_SIZE];
+    STATIC_ASSERT(LT_L2_GET_INFO_RISCV_FW_SIZE == LT_L2_GET_INFO_SPECT_FW_SIZE)
+    if (image_header[0] == 1) {
+        ret = lt_get_info_riscv_fw_ver(dev->h, ver);
+    }
+    else {
+        ret = lt_get_info_spect_fw_ver(dev->h, ver);
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return (0 == memcmp(ver, image_header + 4, sizeof(ver))) ? LT_OK : LT_FAIL;
+}
+
+lt_ret_t lt_do_mutable_fw_update_fleet(lt_fw_fleet_t *f)
+{
+    if (!f || !f->devs || !f->cnt || !f->read || (f->size < LT_FW_IMAGE_HEADER_OFFSET + LT_FW_IMAGE_HEADER_LEN)
+        || f->size > LT_MUTABLE_FW_UPDATE_SIZE_MAX
+        || ((f->bank_id != FW_BANK_FW1) && (f->bank_id != FW_BANK_FW2) && (f->bank_id != FW_BANK_SPECT1)
+            && (f->bank_id != FW_BANK_SPECT2))) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < f->cnt; i++) {
+        if (!f->devs[i].h) {
+            return LT_PARAM_ERR;
+        }
+        f->devs[i].ret = LT_OK;
+    }
+
+    uint8_t image_header[LT_FW_IMAGE_HEADER_LEN];
+    lt_ret_t ret = f->read(f->read_ctx, LT_FW_IMAGE_HEADER_OFFSET, image_header, sizeof(image_header));
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+#ifdef ABAB
+    const uint8_t *update_request = NULL;
+    uint32_t offset = 0;
+#elif ACAB
+    uint8_t update_request[LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1];
+    ret = f->read(f->read_ctx, 0, update_request, sizeof(update_request));
+    if (ret != LT_OK) {
+        return ret;
+    }
+    uint32_t offset = sizeof(update_request);
+#endif
+
+    for (uint8_t i = 0; i < f->cnt; i++) {
+        if (f->devs[i].ret == LT_OK) {
+            ret = lt_fw_fleet_start(f, &f->devs[i], update_request, offset);
+            if (ret != LT_OK) {
+                lt_fw_fleet_fail(f, &f->devs[i], ret);
+            }
+        }
+    }
+
+    // Chunk is sent to all devices before the responses are collected, so the devices write it at the same time
+    uint8_t chunk[LT_FW_CHUNK_SIZE_MAX];
+    uint16_t len;
+    ret = lt_fw_chunk_next(f->read, f->read_ctx, offset, f->size, chunk, &len);
+    while ((ret == LT_OK) && len) {
+        for (uint8_t i = 0; i < f->cnt; i++) {
+            if (f->devs[i].ret == LT_OK) {
+                LT_HANDLE_LOCK(f->devs[i].h);
+                lt_ret_t ret_dev = lt_fw_chunk_send(f->devs[i].h, chunk, len, offset, f->bank_id);
+                if (ret_dev != LT_OK) {
+                    lt_fw_fleet_fail(f, &f->devs[i], ret_dev);
+                }
+            }
+        }
+
+        offset += len;
+        // Chunk buffer is not needed anymore, devices hold the chunk in their L2 buffers
+        ret = lt_fw_chunk_next(f->read, f->read_ctx, offset, f->size, chunk, &len);
+
+        for (uint8_t i = 0; i < f->cnt; i++) {
+            if (f->devs[i].ret == LT_OK) {
+                LT_HANDLE_LOCK(f->devs[i].h);
+                lt_ret_t ret_dev = lt_fw_chunk_ack(f->devs[i].h);
+                if (ret_dev != LT_OK) {
+                    lt_fw_fleet_fail(f, &f->devs[i], ret_dev);
+                    continue;
+                }
+                f->devs[i].cursor = offset;
+                f->devs[i].chunks++;
+                if (f->progress) {
+                    f->progress(f->progress_ctx, &f->devs[i]);
+                }
+            }
+        }
+    }
+    if (ret != LT_OK) {
+        // Image cannot be read, none of the devices can be finished
+        for (uint8_t i = 0; i < f->cnt; i++) {
+            if (f->devs[i].ret == LT_OK) {
+                f->devs[i].ret = ret;
+            }
+        }
+        return ret;
+    }
+
+    lt_ret_t ret_first = LT_OK;
+    for (uint8_t i = 0; i < f->cnt; i++) {
+        if (f->devs[i].ret == LT_OK) {
+            f->devs[i].ret = lt_fw_fleet_finish(f, &f->devs[i], image_header);
+        }
+        if ((ret_first == LT_OK) && (f->devs[i].ret != LT_OK)) {
+            ret_first = f->devs[i].ret;
+        }
+    }
+
+    return ret_first;
+}
+#endif
 #endif
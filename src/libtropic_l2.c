@@ -3,10 +3,14 @@
 #include <string.h>
 
 #include "libtropic_common.h"
+#include "libtropic_macros.h"
 #include "lt_crc16.h"
 #include "lt_l1.h"
+#include "lt_l1_port_wrap.h"
 #include "lt_l2_api_structs.h"
 #include "lt_l2_frame_check.h"
+#include "lt_stats.h"
+#include "lt_wire.h"
 
 /**
  * @file libtropic_l2.c
@@ -29,52 +33,169 @@ lt_ret_t lt_l2_send(lt_l2_state_t *s2)
         return LT_PARAM_ERR;
     }
 
-    add_crc(s2->buff);
+    add_crc(s2, s2->buff);
 
     uint8_t len = s2->buff[1];
+#if LT_ADAPTIVE_POLLING
+    s2->poll.cmd = LT_L1_POLL_CMD_L2(s2->buff[0]);
+#endif
+#if LT_STATS
+    // Resend_Req is accounted to the request whose response is resent
+    if (s2->buff[0] != LT_L2_RESEND_REQ_ID) {
+        lt_stats_begin(s2, LT_STATS_KEY_L2(s2->buff[0]));
+    }
+#endif
 
     return lt_l1_write(s2, len + 4, LT_L1_TIMEOUT_MS_DEFAULT);
 }
 
-lt_ret_t lt_l2_resend_response(lt_l2_state_t *s2)
+/**
+ * Reads a response, with LT_USE_SPI_TRANSFER_BUF its data are received straight into `rx` (when they fit there),
+ * see `lt_l1_read_to()`
+ */
+static lt_ret_t lt_l2_read(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
+{
+#if LT_USE_SPI_TRANSFER_BUF
+    return lt_l1_read_to(s2, rx, rx_max, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+#else
+    (void)rx;
+    (void)rx_max;
+
+    return lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+#endif
+}
+
+/** Sends Resend_Req and reads the resent response by lt_l2_read(), without checking it */
+static lt_ret_t lt_l2_resend_read(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
 {
     // Setup a request pointer to l2 buffer, which is placed in handle
     struct lt_l2_resend_req_t *p_l2_req = (struct lt_l2_resend_req_t *)s2->buff;
     p_l2_req->req_id = LT_L2_RESEND_REQ_ID;
     p_l2_req->req_len = LT_L2_RESEND_REQ_LEN;
+#if LT_STATS
+    lt_stats_resend(s2);
+#endif
 
     lt_ret_t ret = lt_l2_send(s2);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+    return lt_l2_read(s2, rx, rx_max);
+}
+
+/** Checks the response read by lt_l2_read(), its data are moved to `rx` when they fit there */
+static lt_ret_t lt_l2_rx_check(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
+{
+    const uint8_t *data = lt_l1_rx_data(s2, rx, rx_max);
+    lt_ret_t ret = lt_l2_frame_check_data(s2, s2->buff, data);
+
+    if (rx && (data != rx) && (s2->buff[2] <= rx_max)) {
+        memcpy(rx, data, s2->buff[2]);
+    }
+
+    return ret;
+}
+
+/** Sends Resend_Req and checks the resent response, see lt_l2_rx_check() */
+static lt_ret_t lt_l2_resend_response_to(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
+{
+    lt_ret_t ret = lt_l2_resend_read(s2, rx, rx_max);
     if (ret != LT_OK) {
         return ret;
     }
 
-    return lt_l2_frame_check(s2->buff);
+    return lt_l2_rx_check(s2, rx, rx_max);
 }
 
-lt_ret_t lt_l2_receive(lt_l2_state_t *s2)
+lt_ret_t lt_l2_resend_response(lt_l2_state_t *s2)
+{
+    return lt_l2_resend_response_to(s2, NULL, 0);
+}
+
+#if LT_L2_RETRY_POLICY
+/** Policy used when the handle does not provide its own, it equals to lt_l2_receive() without LT_L2_RETRY_POLICY */
+static const lt_l2_retry_policy_t lt_l2_retry_policy_default = {.max_resends = 3, .backoff_ms = 0, .busy_retries = 0};
+
+lt_ret_t lt_l2_receive_to(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
+{
+    if (!s2) {
+        return LT_PARAM_ERR;
+    }
+
+    const lt_l2_retry_policy_t *policy = s2->retry.policy ? s2->retry.policy : &lt_l2_retry_policy_default;
+    lt_l2_retry_stats_t *stats = &s2->retry.stats;
+
+    lt_ret_t ret = lt_l2_read(s2, rx, rx_max);
+    for (uint8_t i = 0; (ret == LT_L1_CHIP_BUSY) && (i < policy->busy_retries); i++) {
+        // TROPIC01 is still processing the request, its response is polled again
+        stats->busy_timeouts++;
+        ret = lt_l2_read(s2, rx, rx_max);
+    }
+    if (ret != LT_OK) {
+        if (ret == LT_L1_CHIP_BUSY) {
+            stats->busy_timeouts++;
+            stats->failures++;
+        }
+        return ret;
+    }
+
+    ret = lt_l2_rx_check(s2, rx, rx_max);
+
+    if ((ret == LT_L2_CRC_ERR) || (ret == LT_L2_GEN_ERR)) {
+        // There was an error when checking received data.
+        // Let's consider that length byte is correct, but CRC is not.
+        // Last response is requested again as many times as the policy allows, with growing delay.
+        uint32_t delay_ms = policy->backoff_ms;
+        stats->crc_errors++;
+
+        for (uint8_t i = 0; i < policy->max_resends; i++) {
+            if (delay_ms) {
+                lt_ret_t ret_delay = lt_l1_delay(s2, delay_ms);
+                if (ret_delay != LT_OK) {
+                    return ret_delay;
+                }
+                delay_ms *= 2;
+            }
+
+            stats->resends++;
+            ret = lt_l2_resend_response_to(s2, rx, rx_max);
+            if (ret == LT_OK) {
+                return LT_OK;
+            }
+            if ((ret == LT_L2_CRC_ERR) || (ret == LT_L2_GEN_ERR)) {
+                stats->crc_errors++;
+            }
+            else if (ret == LT_L1_CHIP_BUSY) {
+                stats->busy_timeouts++;
+            }
+        }
+        stats->failures++;
+    }
+
+    // Rest of errors are reported directly to upper layers, without trying to resend response.
+    return ret;
+}
+#else
+lt_ret_t lt_l2_receive_to(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
 {
     if (!s2) {
         return LT_PARAM_ERR;
     }
 
-    lt_ret_t ret = lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+    lt_ret_t ret = lt_l2_read(s2, rx, rx_max);
     if (ret != LT_OK) {
         return ret;
     }
 
-    ret = lt_l2_frame_check(s2->buff);
+    ret = lt_l2_rx_check(s2, rx, rx_max);
 
     if ((ret == LT_L2_CRC_ERR) || (ret == LT_L2_GEN_ERR)) {
         // There was an error when checking received data.
         // Let's consider that length byte is correct, but CRC is not.
         // We try three times to resend the last response.
         for (int i = 0; i < 3; i++) {
-            ret = lt_l2_resend_response(s2);
+            ret = lt_l2_resend_response_to(s2, rx, rx_max);
             if (ret == LT_OK) {
                 break;
             }
@@ -84,6 +205,110 @@ lt_ret_t lt_l2_receive(lt_l2_state_t *s2)
     // Rest of errors are reported directly to upper layers, without trying to resend response.
     return ret;
 }
+#endif
+
+lt_ret_t lt_l2_receive(lt_l2_state_t *s2)
+{
+    return lt_l2_receive_to(s2, NULL, 0);
+}
+
+#if LT_L2_RETRY_POLICY
+/** Counts a chunk recovered (or given up) by the transfer of an encrypted L3 packet */
+#define LT_L2_CHUNK_STAT(s2, field) ((s2)->retry.stats.field++)
+#else
+#define LT_L2_CHUNK_STAT(s2, field) (void)(s2)
+#endif
+
+uint8_t lt_l2_chunk_retries(const lt_l2_state_t *s2)
+{
+#if LT_L2_RETRY_POLICY
+    const lt_l2_retry_policy_t *policy = s2->retry.policy ? s2->retry.policy : &lt_l2_retry_policy_default;
+
+    return policy->max_resends;
+#else
+    (void)s2;
+
+    return 3;
+#endif
+}
+
+#if LT_USE_SPI_TRANSACTION
+/**
+ * Calculates CRC of L2 request carrying a chunk of encrypted L3 command, without the need of L2 buffer
+ * @note This is the only CRC of outgoing frames not calculated by `lt_l2_crc16()`, so LT_USE_PORT_CRC16 does not apply
+ * to it: the chunk is sent in place from L3 buffer and the frame is not contiguous in any buffer.
+ */
+static uint16_t lt_l2_encrypted_chunk_crc(const uint8_t *chunk, uint16_t len)
+{
+    const uint8_t header[2] = {LT_L2_ENCRYPTED_CMD_REQ_ID, (uint8_t)len};
+
+    uint16_t crc = crc16_init();
+    crc = crc16_update(crc, header, sizeof(header));
+    crc = crc16_update(crc, chunk, len);
+
+    return crc16_final(crc);
+}
+
+/** CRC of the next chunk is prepared while TROPIC01 processes the current one */
+#define LT_L2_CHUNK_CRC(chunk, len) lt_l2_encrypted_chunk_crc((chunk), (len))
+#else
+/** CRC is added by `add_crc()` once the chunk is copied into L2 buffer */
+#define LT_L2_CHUNK_CRC(chunk, len) 0
+#endif
+
+/** Sends one chunk of encrypted L3 command in L2 request, crc is from LT_L2_CHUNK_CRC() */
+static lt_ret_t lt_l2_encrypted_chunk_send(lt_l2_state_t *s2, const uint8_t *chunk, uint16_t len, uint16_t crc)
+{
+    // Setup a request pointer to l2 buffer, which is placed in handle
+    struct lt_l2_encrypted_cmd_req_t *req = (struct lt_l2_encrypted_cmd_req_t *)s2->buff;
+
+    req->req_id = LT_L2_ENCRYPTED_CMD_REQ_ID;
+    req->req_len = len;
+
+#if LT_ADAPTIVE_POLLING
+    // Acknowledgment of a chunk has its own polling profile, separate from the L3 result
+    s2->poll.cmd = LT_L1_POLL_CMD_L3_CHUNK;
+#endif
+#if LT_USE_SPI_TRANSACTION
+    // Chunk is sent in place from l3 buff, only header and CRC are in l2 buff.
+    s2->buff[2 + len] = crc >> 8;
+    s2->buff[2 + len + 1] = crc & 0x00FF;
+    const lt_l1_spi_segment_t segs[] = {
+        {.offset = 0, .len = 2, .cs_hold = 1},
+        {.offset = 2, .len = len, .cs_hold = 1, .tx = chunk},
+        {.offset = 2 + len, .len = 2, .cs_hold = 0},
+    };
+
+    return lt_l1_write_segments(s2, segs, sizeof(segs) / sizeof(segs[0]), LT_L1_TIMEOUT_MS_DEFAULT);
+#else
+    UNUSED(crc);
+    memcpy(req->l3_chunk, chunk, len);
+    add_crc(s2, s2->buff);
+
+    // Send l2 request cointaining a chunk from l3 buff
+    return lt_l1_write(s2, 2 + req->req_len + 2, LT_L1_TIMEOUT_MS_DEFAULT);
+#endif
+}
+
+/** Checks received chunk of encrypted L3 result and copies it into buff at offset, which is then moved */
+static lt_ret_t lt_l2_encrypted_chunk_recv(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len, uint16_t *offset)
+{
+    // Setup a response pointer to l2 buffer, which is placed in handle
+    struct lt_l2_encrypted_cmd_rsp_t *resp = (struct lt_l2_encrypted_cmd_rsp_t *)s2->buff;
+
+    // Prevent receiving more data then is compiled size of l3 buffer
+    if (*offset + resp->rsp_len > max_len) {
+        return LT_L3_DATA_LEN_ERROR;
+    }
+
+    // Check status byte of this frame, data are received in place or copied there from l2 buffer
+    lt_ret_t ret = lt_l2_rx_check(s2, buff + *offset, max_len - *offset);
+    if ((ret == LT_L2_RES_CONT) || (ret == LT_OK)) {
+        *offset += resp->rsp_len;
+    }
+
+    return ret;
+}
 
 lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len)
 {
@@ -99,15 +324,12 @@ lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max
     // First check how much data are to be send and if it actually fits into that buffer,
     // there must be a space for 2B of size value, ?B of command (ID + data) and 16B of TAG.
     struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)buff;
-    uint16_t packet_size = (L3_CMD_SIZE_SIZE + p_frame->cmd_size + L3_TAG_SIZE);
+    uint16_t packet_size = (L3_CMD_SIZE_SIZE + lt_wire_ld16(&p_frame->cmd_size) + L3_TAG_SIZE);
     // Prevent sending more data then is the size of compiled l3 buffer
     if (packet_size > max_len) {
         return LT_L3_DATA_LEN_ERROR;
     }
 
-    // Setup a request pointer to l2 buffer, which is placed in handle
-    struct lt_l2_encrypted_cmd_req_t *req = (struct lt_l2_encrypted_cmd_req_t *)s2->buff;
-
     // Calculate number of chunks to send.
     // First, get the number of full chunks.
     uint16_t full_chunk_num = (packet_size / L2_CHUNK_MAX_DATA_SIZE);
@@ -117,26 +339,28 @@ lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max
     // Calculate the length of the last chunk
     uint16_t last_chunk_len = packet_size - ((chunk_num - 1) * L2_CHUNK_MAX_DATA_SIZE);
 
+    // If the currently processed chunk is the last one, get its length (may be shorter than L2_CHUNK_MAX_DATA_SIZE)
+    uint16_t chunk_len = (chunk_num == 1) ? last_chunk_len : L2_CHUNK_MAX_DATA_SIZE;
+    uint16_t crc = LT_L2_CHUNK_CRC(buff, chunk_len);
+    uint8_t retries = lt_l2_chunk_retries(s2);
+
     // Split encrypted buffer into chunks and proceed them into l2 transfers:
     for (int i = 0; i < chunk_num; i++) {
-        req->req_id = LT_L2_ENCRYPTED_CMD_REQ_ID;
-        // If the currently processed chunk is the last one, get its length (may be shorter than L2_CHUNK_MAX_DATA_SIZE)
-        if (i == (chunk_num - 1)) {
-            req->req_len = last_chunk_len;
-        }
-        else {
-            req->req_len = L2_CHUNK_MAX_DATA_SIZE;
-        }
-        memcpy(req->l3_chunk, buff + i * L2_CHUNK_MAX_DATA_SIZE, req->req_len);
+        const uint8_t *chunk = buff + i * L2_CHUNK_MAX_DATA_SIZE;
+        uint16_t sent_len = chunk_len;
+        uint16_t sent_crc = crc;
 
-        add_crc(req);
-
-        // Send l2 request cointaining a chunk from l3 buff
-        ret = lt_l1_write(s2, 2 + req->req_len + 2, LT_L1_TIMEOUT_MS_DEFAULT);
+        ret = lt_l2_encrypted_chunk_send(s2, chunk, sent_len, sent_crc);
         if (ret != LT_OK) {
             return ret;
         }
 
+        // Next chunk is prepared while TROPIC01 processes this one, before its acknowledgment is polled
+        if (i + 1 < chunk_num) {
+            chunk_len = (i + 1 == (chunk_num - 1)) ? last_chunk_len : L2_CHUNK_MAX_DATA_SIZE;
+            crc = LT_L2_CHUNK_CRC(buff + (i + 1) * L2_CHUNK_MAX_DATA_SIZE, chunk_len);
+        }
+
         // Read a response on this l2 request
         ret = lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
         if (ret != LT_OK) {
@@ -144,8 +368,33 @@ lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max
         }
 
         // Check status byte of this frame
-        ret = lt_l2_frame_check(s2->buff);
+        ret = lt_l2_frame_check(s2, s2->buff);
+
+        // A chunk damaged on its way to TROPIC01 is sent again, a damaged acknowledgment is requested again,
+        // so the L3 command does not have to be encrypted and sent from its beginning.
+        for (uint8_t r = 0; (r < retries) && ((ret == LT_L2_CRC_ERR) || (ret == LT_L2_IN_CRC_ERR)); r++) {
+            if (ret == LT_L2_CRC_ERR) {
+                LT_L2_CHUNK_STAT(s2, cmd_chunk_resends);
+                ret = lt_l2_encrypted_chunk_send(s2, chunk, sent_len, sent_crc);
+                if (ret != LT_OK) {
+                    return ret;
+                }
+                ret = lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+            }
+            else {
+                LT_L2_CHUNK_STAT(s2, resends);
+                ret = lt_l2_resend_read(s2, NULL, 0);
+            }
+            if (ret != LT_OK) {
+                return ret;
+            }
+            ret = lt_l2_frame_check(s2, s2->buff);
+        }
+
         if (ret != LT_OK && ret != LT_L2_REQ_CONT) {
+            if ((ret == LT_L2_CRC_ERR) || (ret == LT_L2_IN_CRC_ERR)) {
+                LT_L2_CHUNK_STAT(s2, failures);
+            }
             return ret;
         }
     }
@@ -154,46 +403,61 @@ lt_ret_t lt_l2_send_encrypted_cmd(lt_l2_state_t *s2, uint8_t *buff, uint16_t max
 }
 
 lt_ret_t lt_l2_recv_encrypted_res(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len)
+{
+    uint16_t len;
+
+    return lt_l2_recv_encrypted_res_len(s2, buff, max_len, &len);
+}
+
+lt_ret_t lt_l2_recv_encrypted_res_len(lt_l2_state_t *s2, uint8_t *buff, uint16_t max_len, uint16_t *len)
 {
     if (!s2
         // Max len must be definitively smaller than size of l3 buffer
-        || max_len > L3_PACKET_MAX_SIZE || !buff) {
+        || max_len > L3_PACKET_MAX_SIZE || !buff || !len) {
         return LT_PARAM_ERR;
     }
 
     int ret = LT_FAIL;
-    // Setup a response pointer to l2 buffer, which is placed in handle
-    struct lt_l2_encrypted_cmd_rsp_t *resp = (struct lt_l2_encrypted_cmd_rsp_t *)s2->buff;
 
     // Position into l3 buffer where processed l2 chunk will be copied into
     uint16_t offset = 0;
+    *len = 0;
     // Tropic can respond with various lengths of chunks, this loop should be limited
     uint16_t loops = 0;
+    uint8_t retries = lt_l2_chunk_retries(s2);
 
     do {
-        /* Get one l2 frame of a device's response */
-        ret = lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+#if LT_ADAPTIVE_POLLING
+        // Only the first chunk of the result is delayed by execution of the L3 command
+        s2->poll.cmd = (offset == 0) ? LT_L1_POLL_CMD_L3(s2->poll.l3_cmd_id)
+                                     : LT_L1_POLL_CMD_L2(LT_L2_ENCRYPTED_CMD_REQ_ID);
+#endif
+        /* Get one l2 frame of a device's response, its data go straight to their place in buff */
+        ret = lt_l2_read(s2, buff + offset, max_len - offset);
         if (ret != LT_OK) {
             return ret;
         }
 
-        // Prevent receiving more data then is compiled size of l3 buffer
-        if (offset + resp->rsp_len > max_len) {
-            return LT_L3_DATA_LEN_ERROR;
+        ret = lt_l2_encrypted_chunk_recv(s2, buff, max_len, &offset);
+        // Only a chunk damaged on its way to host is requested again, the chunks received before are kept
+        for (uint8_t r = 0; (r < retries) && (ret == LT_L2_IN_CRC_ERR); r++) {
+            LT_L2_CHUNK_STAT(s2, res_chunk_resends);
+            ret = lt_l2_resend_read(s2, buff + offset, max_len - offset);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            ret = lt_l2_encrypted_chunk_recv(s2, buff, max_len, &offset);
         }
-
-        // Check status byte of this frame
-        ret = lt_l2_frame_check(s2->buff);
+        if (ret == LT_L2_IN_CRC_ERR) {
+            LT_L2_CHUNK_STAT(s2, failures);
+        }
+        *len = offset;
         switch (ret) {
             case LT_L2_RES_CONT:
-                // Copy content of l2 into certain offset of l3 buffer
-                memcpy(buff + offset, (struct l2_encrypted_rsp_t *)resp->l3_chunk, resp->rsp_len);
-                offset += resp->rsp_len;
                 loops++;
                 break;
             case LT_OK:
-                // This was last l2 frame of l3 packet, copy it and return
-                memcpy(buff + offset, (struct l2_encrypted_rsp_t *)resp->l3_chunk, resp->rsp_len);
+                // This was last l2 frame of l3 packet
                 return LT_OK;
             default:
                 // Any other L2 packet's status is not expected
@@ -203,3 +467,241 @@ lt_ret_t lt_l2_recv_encrypted_res(lt_l2_state_t *s2, uint8_t *buff, uint16_t max
 
     return LT_FAIL;
 }
+
+lt_ret_t lt_l2_recv_encrypted_res_cb(lt_l2_state_t *s2, lt_l2_chunk_cb_t cb, void *ctx)
+{
+    if (!s2 || !cb) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_l2_encrypted_cmd_rsp_t *resp = (struct lt_l2_encrypted_cmd_rsp_t *)s2->buff;
+    lt_ret_t ret = LT_FAIL;
+    // Tropic can respond with various lengths of chunks, this loop should be limited
+    uint16_t loops = 0;
+    uint8_t retries = lt_l2_chunk_retries(s2);
+
+    do {
+#if LT_ADAPTIVE_POLLING
+        // Only the first chunk of the result is delayed by execution of the L3 command
+        s2->poll.cmd = (loops == 0) ? LT_L1_POLL_CMD_L3(s2->poll.l3_cmd_id)
+                                    : LT_L1_POLL_CMD_L2(LT_L2_ENCRYPTED_CMD_REQ_ID);
+#endif
+        /* Get one l2 frame of a device's response */
+        ret = lt_l1_read(s2, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        // Check status byte of this frame, a chunk damaged on its way to host is requested again
+        ret = lt_l2_frame_check(s2, s2->buff);
+        for (uint8_t r = 0; (r < retries) && (ret == LT_L2_IN_CRC_ERR); r++) {
+            LT_L2_CHUNK_STAT(s2, res_chunk_resends);
+            ret = lt_l2_resend_response(s2);
+        }
+        if ((ret != LT_L2_RES_CONT) && (ret != LT_OK)) {
+            if (ret == LT_L2_IN_CRC_ERR) {
+                LT_L2_CHUNK_STAT(s2, failures);
+            }
+            // Any other L2 packet's status is not expected
+            return ret;
+        }
+
+        lt_ret_t ret_cb = cb(ctx, resp->l3_chunk, resp->rsp_len);
+        if (ret_cb != LT_OK) {
+            return ret_cb;
+        }
+
+        if (ret == LT_OK) {
+            // This was last l2 frame of l3 packet
+            return LT_OK;
+        }
+        loops++;
+    } while (loops < MAX_LOOPS);
+
+    return LT_FAIL;
+}
+
+#if LT_NONBLOCKING
+/** Starts polling for the next response of the transfer */
+static lt_ret_t lt_l2_transfer_wait(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint32_t *wait_ms)
+{
+    lt_l1_read_start(s2, &t->sched);
+    *wait_ms = LT_US_TO_MS_CEIL(t->sched.next_us);
+
+    return LT_PENDING;
+}
+
+/** Sends Resend_Req and starts polling for its response */
+static lt_ret_t lt_l2_transfer_resend(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint32_t *wait_ms)
+{
+    struct lt_l2_resend_req_t *p_l2_req = (struct lt_l2_resend_req_t *)s2->buff;
+    p_l2_req->req_id = LT_L2_RESEND_REQ_ID;
+    p_l2_req->req_len = LT_L2_RESEND_REQ_LEN;
+
+    lt_ret_t ret = lt_l2_send(s2);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    t->resends++;
+    t->state = LT_L2_TRANSFER_RESEND;
+
+    return lt_l2_transfer_wait(s2, t, wait_ms);
+}
+
+/** Sends the next chunk of encrypted command and starts polling for its response */
+static lt_ret_t lt_l2_transfer_chunk_send(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint32_t *wait_ms)
+{
+    uint16_t chunk_len = t->packet_size - t->offset;
+    if (chunk_len > L2_CHUNK_MAX_DATA_SIZE) {
+        chunk_len = L2_CHUNK_MAX_DATA_SIZE;
+    }
+
+    lt_ret_t ret = lt_l2_encrypted_chunk_send(s2, t->buff + t->offset, chunk_len,
+                                              LT_L2_CHUNK_CRC(t->buff + t->offset, chunk_len));
+    if (ret != LT_OK) {
+        return ret;
+    }
+    t->offset += chunk_len;
+
+    return lt_l2_transfer_wait(s2, t, wait_ms);
+}
+
+/** Processes a response received into L2 buffer and moves the transfer to its next state */
+static lt_ret_t lt_l2_transfer_process(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint32_t *wait_ms)
+{
+    lt_ret_t ret;
+
+    switch (t->state) {
+        case LT_L2_TRANSFER_RSP:
+            ret = lt_l2_frame_check(s2, s2->buff);
+            // Let's consider that length byte is correct, but CRC is not, the last response is requested again
+            if ((ret == LT_L2_CRC_ERR) || (ret == LT_L2_GEN_ERR)) {
+                return lt_l2_transfer_resend(s2, t, wait_ms);
+            }
+            return ret;
+        case LT_L2_TRANSFER_RESEND:
+            ret = lt_l2_frame_check(s2, s2->buff);
+            // We try three times to resend the last response, same as lt_l2_receive()
+            if ((ret != LT_OK) && (t->resends < 3)) {
+                return lt_l2_transfer_resend(s2, t, wait_ms);
+            }
+            return ret;
+        case LT_L2_TRANSFER_CMD:
+            ret = lt_l2_frame_check(s2, s2->buff);
+            if (ret != LT_OK && ret != LT_L2_REQ_CONT) {
+                return ret;
+            }
+            if (t->offset < t->packet_size) {
+                return lt_l2_transfer_chunk_send(s2, t, wait_ms);
+            }
+            // Whole command was sent, result is received into the result buffer
+            t->offset = 0;
+            t->state = LT_L2_TRANSFER_RES;
+#if LT_ADAPTIVE_POLLING
+            // Only the first chunk of the result is delayed by execution of the L3 command
+            s2->poll.cmd = LT_L1_POLL_CMD_L3(s2->poll.l3_cmd_id);
+#endif
+            return lt_l2_transfer_wait(s2, t, wait_ms);
+        case LT_L2_TRANSFER_RES:
+            ret = lt_l2_encrypted_chunk_recv(s2, t->res_buff, t->res_max_len, &t->offset);
+            if (ret != LT_L2_RES_CONT) {
+                return ret;
+            }
+            // Tropic can respond with various lengths of chunks, number of chunks is limited
+            if (++t->loops >= MAX_LOOPS) {
+                return LT_FAIL;
+            }
+#if LT_ADAPTIVE_POLLING
+            s2->poll.cmd = LT_L1_POLL_CMD_L2(LT_L2_ENCRYPTED_CMD_REQ_ID);
+#endif
+            return lt_l2_transfer_wait(s2, t, wait_ms);
+        default:
+            return LT_FAIL;
+    }
+}
+
+lt_ret_t lt_l2_transfer_begin(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint8_t *buff, uint16_t max_len,
+                              uint32_t *wait_ms)
+{
+    return lt_l2_transfer_begin_split(s2, t, buff, max_len, buff, max_len, wait_ms);
+}
+
+lt_ret_t lt_l2_transfer_begin_split(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint8_t *buff, uint16_t max_len,
+                                    uint8_t *res_buff, uint16_t res_max_len, uint32_t *wait_ms)
+{
+    if (!s2 || !t || !wait_ms
+        // Max len must be definitively smaller than size of l3 buffer
+        || (buff && ((max_len > L3_PACKET_MAX_SIZE) || !res_buff || (res_max_len > L3_PACKET_MAX_SIZE)))) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret;
+
+    t->state = LT_L2_TRANSFER_IDLE;
+    t->buff = buff;
+    t->max_len = max_len;
+    t->res_buff = res_buff;
+    t->res_max_len = res_max_len;
+    t->packet_size = 0;
+    t->offset = 0;
+    t->loops = 0;
+    t->resends = 0;
+
+    if (!buff) {
+        // Plain L2 request is already placed in L2 buffer
+        ret = lt_l2_send(s2);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        t->state = LT_L2_TRANSFER_RSP;
+
+        return lt_l2_transfer_wait(s2, t, wait_ms);
+    }
+
+    // There must be a space for 2B of size value, ?B of command (ID + data) and 16B of TAG.
+    struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)buff;
+    t->packet_size = (L3_CMD_SIZE_SIZE + lt_wire_ld16(&p_frame->cmd_size) + L3_TAG_SIZE);
+    // Prevent sending more data then is the size of compiled l3 buffer
+    if (t->packet_size > max_len) {
+        return LT_L3_DATA_LEN_ERROR;
+    }
+
+    t->state = LT_L2_TRANSFER_CMD;
+    ret = lt_l2_transfer_chunk_send(s2, t, wait_ms);
+    if (ret != LT_PENDING) {
+        t->state = LT_L2_TRANSFER_IDLE;
+    }
+
+    return ret;
+}
+
+lt_ret_t lt_l2_transfer_poll(lt_l2_state_t *s2, lt_l2_transfer_t *t, uint32_t *wait_ms)
+{
+    if (!s2 || !t || !wait_ms || (t->state == LT_L2_TRANSFER_IDLE)) {
+        return LT_PARAM_ERR;
+    }
+
+#if LT_L1_OFFLOAD
+    s2->l1_nonblocking = 1;
+    lt_ret_t ret = lt_l1_read_step(s2, &t->sched, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+    s2->l1_nonblocking = 0;
+#else
+    lt_ret_t ret = lt_l1_read_step(s2, &t->sched, LT_L1_LEN_MAX, LT_L1_TIMEOUT_MS_DEFAULT);
+#endif
+    if (ret == LT_PENDING) {
+        *wait_ms = LT_US_TO_MS_CEIL(t->sched.next_us);
+        return LT_PENDING;
+    }
+
+    if (ret == LT_OK) {
+        ret = lt_l2_transfer_process(s2, t, wait_ms);
+    }
+
+    // Transfer is finished, either successfully or by an error
+    if (ret != LT_PENDING) {
+        t->state = LT_L2_TRANSFER_IDLE;
+    }
+
+    return ret;
+}
+#endif
@@ -12,15 +12,98 @@
 #include "lt_aesgcm.h"
 #include "lt_ed25519.h"
 #include "lt_hkdf.h"
+#include "lt_hooks.h"
 #include "lt_l1.h"
 #include "lt_l1_port_wrap.h"
 #include "lt_l2_api_structs.h"
 #include "lt_l3_api_structs.h"
+#include "lt_l3_cmd_desc.h"
 #include "lt_l3_process.h"
+#include "lt_profile.h"
 #include "lt_random.h"
 #include "lt_sha256.h"
+#include "lt_stats.h"
+#include "lt_wire.h"
 #include "lt_x25519.h"
 
+/**
+ * @brief Encrypts L3 command placed in handle's L3 buffer.
+ *
+ * @param h           Device's handle
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+static lt_ret_t lt_l3_encrypt_cmd(lt_handle_t *h)
+{
+    // Result of this command is the one awaited next, batches and result checks take its properties by the ID
+    h->l3.cmd_id = ((struct lt_l3_gen_frame_t *)h->l3.buff)->data[0];
+#ifdef LIBT_DEBUG
+    const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(h->l3.cmd_id);
+    uint16_t cmd_size = LT_L3_GET16((struct lt_l3_gen_frame_t *)h->l3.buff, cmd_size);
+    if (desc && ((cmd_size < desc->cmd_size_min) || (cmd_size > desc->cmd_size_max))) {
+        return LT_PARAM_ERR;
+    }
+#endif
+#if LT_HOOKS
+    lt_hook_pre(&h->l2, LT_HOOK_L3_CMD, NULL, h->l3.cmd_id,
+                LT_L3_GET16((struct lt_l3_gen_frame_t *)h->l3.buff, cmd_size), 0);
+#endif
+#if LT_ADAPTIVE_POLLING
+    // Remember the command ID, L1 uses polling profile of this command when waiting for the result
+    h->l2.poll.l3_cmd_id = ((struct lt_l3_gen_frame_t *)h->l3.buff)->data[0];
+#endif
+#if LT_STATS
+    // L2 requests carrying the command and its result are accounted to the command
+    lt_stats_begin(&h->l2, LT_STATS_KEY_L3(((struct lt_l3_gen_frame_t *)h->l3.buff)->data[0]));
+    uint32_t start_us = lt_stats_clock(&h->l2);
+    lt_ret_t ret = lt_l3_encrypt_request(&h->l3);
+    lt_stats_time(&h->l2, LT_STATS_CRYPTO, start_us);
+
+    return ret;
+#else
+    return lt_l3_encrypt_request(&h->l3);
+#endif
+}
+
+/**
+ * @brief Decrypts L3 result placed in handle's L3 buffer.
+ *
+ * @param h           Device's handle
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+static lt_ret_t lt_l3_decrypt_res(lt_handle_t *h)
+{
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(&h->l2);
+    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_stats_time(&h->l2, LT_STATS_CRYPTO, start_us);
+#else
+    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+#endif
+    // Parsers of results rely on a successful result not being longer than the command defines
+    const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(h->l3.cmd_id);
+    if ((ret == LT_OK) && desc
+        && (LT_L3_GET16((struct lt_l3_gen_frame_t *)LT_L3_RES_BUFF(&h->l3), cmd_size) > desc->res_size_max)) {
+        ret = LT_FAIL;
+    }
+#if LT_SESSION_LIVENESS
+    if (h->l2.liveness) {
+        if (h->l3.session != SESSION_ON) {
+            // Result failed authentication, which ended the session
+            lt_l1_session_lost(&h->l2, LT_LIVENESS_AUTH);
+        }
+        else if (h->l2.liveness->time_us) {
+            h->l2.liveness->seen_us = h->l2.liveness->time_us();
+        }
+    }
+#endif
+#if LT_HOOKS
+    lt_hook_post(&h->l2, LT_HOOK_L3_CMD, 0,
+                 (ret == LT_OK) ? LT_L3_GET16((struct lt_l3_gen_frame_t *)LT_L3_RES_BUFF(&h->l3), cmd_size) : 0, ret);
+#endif
+
+    return ret;
+}
+
 lt_ret_t lt_out__session_start(lt_handle_t *h, const pkey_index_t pkey_index, session_state_t *state)
 {
     if (!h || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !state) {
@@ -32,12 +115,24 @@ lt_ret_t lt_out__session_start(lt_handle_t *h, const pkey_index_t pkey_index, se
     memset(h->l3.encryption_IV, 0, sizeof(h->l3.encryption_IV));
     memset(h->l3.decryption_IV, 0, sizeof(h->l3.decryption_IV));
 
-    // Create ephemeral host keys
-    lt_ret_t ret = lt_random_bytes(&h->l2, state->ehpriv, sizeof(state->ehpriv));
-    if (ret != LT_OK) {
-        return ret;
+#if LT_EPHEMERAL_KEY_POOL
+    if (h->key_pool && h->key_pool->cnt) {
+        // Take key pair generated in advance, each one is used only once
+        session_state_t *key = &h->key_pool->keys[--h->key_pool->cnt];
+        memcpy(state, key, sizeof(session_state_t));
+        memset(key, 0, sizeof(session_state_t));
+    }
+    else
+#endif
+    {
+        // Create ephemeral host keys
+        lt_ret_t ret = lt_random_bytes(&h->l2, state->ehpriv, sizeof(state->ehpriv));
+        if (ret != LT_OK) {
+            return ret;
+        }
+        lt_X25519_scalarmult(state->ehpriv, state->ehpub);
     }
-    lt_X25519_scalarmult(state->ehpriv, state->ehpub);
+    state->precomputed = 0;
 
     // Setup a request pointer to l2 buffer, which is placed in handle
     struct lt_l2_handshake_req_t *p_req = (struct lt_l2_handshake_req_t *)h->l2.buff;
@@ -50,13 +145,77 @@ lt_ret_t lt_out__session_start(lt_handle_t *h, const pkey_index_t pkey_index, se
     return LT_OK;
 }
 
-lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index,
-                              const uint8_t *shipriv, const uint8_t *shipub, session_state_t *state)
+/** h = SHA_256(protocol_name), protocol_name is constant, so is its hash */
+static const uint8_t lt_session_protocol_name_hash[SHA256_DIGEST_LENGTH]
+    = {0xdc, 0x3c, 0xec, 0x09, 0x55, 0x41, 0xd8, 0x08, 0x3c, 0x2d, 0x1a, 0xf6, 0xb2, 0xf4, 0x03, 0x0f,
+       0xa3, 0xd6, 0x3e, 0x4d, 0x78, 0x70, 0xd6, 0x76, 0x6c, 0x80, 0x60, 0x60, 0x10, 0x5a, 0xe8, 0xdc};
+
+void lt_session_hash_prefix_hctx(void *hctx, const uint8_t *shipub, const uint8_t *stpub, uint8_t *hash)
 {
-    if (!h || !stpub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !shipriv || !shipub || !state) {
+    lt_sha256_init(hctx);
+
+    // h = SHA256(h||SHiPUB)
+    lt_sha256_start(hctx);
+    lt_sha256_update(hctx, lt_session_protocol_name_hash, SHA256_DIGEST_LENGTH);
+    lt_sha256_update(hctx, shipub, 32);
+    lt_sha256_finish(hctx, hash);
+
+    // h = SHA256(h||STPUB)
+    lt_sha256_start(hctx);
+    lt_sha256_update(hctx, hash, 32);
+    lt_sha256_update(hctx, stpub, 32);
+    lt_sha256_finish(hctx, hash);
+}
+
+void lt_session_hash_prefix(const uint8_t *shipub, const uint8_t *stpub, uint8_t *hash)
+{
+    struct lt_crypto_sha256_ctx_t hctx;
+    lt_session_hash_prefix_hctx(&hctx, shipub, stpub, hash);
+}
+
+/** Continues handshake hash from prefix with EHPUB and PKEY_INDEX, none of which depends on the response */
+static void lt_session_hash_ephemeral(void *hctx, const uint8_t *prefix, const pkey_index_t pkey_index,
+                                      const session_state_t *state, uint8_t *hash)
+{
+    lt_sha256_init(hctx);
+
+    // h = SHA256(h||EHPUB)
+    lt_sha256_start(hctx);
+    lt_sha256_update(hctx, prefix, 32);
+    lt_sha256_update(hctx, state->ehpub, 32);
+    lt_sha256_finish(hctx, hash);
+
+    // h = SHA256(h||PKEY_INDEX)
+    lt_sha256_start(hctx);
+    lt_sha256_update(hctx, hash, 32);
+    lt_sha256_update(hctx, (uint8_t *)&pkey_index, 1);
+    lt_sha256_finish(hctx, hash);
+}
+
+lt_ret_t lt_session_start_precompute_hctx(void *hctx, const lt_session_ctx_t *ctx, session_state_t *state)
+{
+    if (!ctx || !state) {
         return LT_PARAM_ERR;
     }
 
+    lt_session_hash_ephemeral(hctx, ctx->hash, ctx->pkey_index, state, state->hash);
+    lt_X25519(state->ehpriv, ctx->stpub, state->ss_stpub);
+    state->precomputed = 1;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_session_start_precompute(const lt_session_ctx_t *ctx, session_state_t *state)
+{
+    struct lt_crypto_sha256_ctx_t hctx;
+
+    return lt_session_start_precompute_hctx(&hctx, ctx, state);
+}
+
+/** Finishes the handshake, prefix is the hash from lt_session_hash_prefix() */
+static lt_ret_t lt_in__session_keys(lt_handle_t *h, void *hctx, const uint8_t *prefix, const uint8_t *stpub,
+                                    const pkey_index_t pkey_index, const uint8_t *shipriv, session_state_t *state)
+{
     // Setup a response pointer to l2 buffer, which is placed in handle
     struct lt_l2_handshake_rsp_t *p_rsp = (struct lt_l2_handshake_rsp_t *)h->l2.buff;
 
@@ -64,42 +223,19 @@ lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_i
     uint8_t protocol_name[32] = {'N', 'o', 'i', 's', 'e', '_', 'K', 'K', '1', '_', '2', '5', '5', '1',  '9',  '_',
                                  'A', 'E', 'S', 'G', 'C', 'M', '_', 'S', 'H', 'A', '2', '5', '6', 0x00, 0x00, 0x00};
     uint8_t hash[SHA256_DIGEST_LENGTH] = {0};
-    // h = SHA_256(protocol_name)
-    struct lt_crypto_sha256_ctx_t hctx = {0};
-    lt_sha256_init(&hctx);
-    lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, protocol_name, 32);
-    lt_sha256_finish(&hctx, hash);
-
-    // h = SHA256(h||SHiPUB)
-    lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, hash, 32);
-    lt_sha256_update(&hctx, shipub, 32);
-    lt_sha256_finish(&hctx, hash);
-
-    // h = SHA256(h||STPUB)
-    lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, hash, 32);
-    lt_sha256_update(&hctx, stpub, 32);
-    lt_sha256_finish(&hctx, hash);
-
-    // h = SHA256(h||EHPUB)
-    lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, hash, 32);
-    lt_sha256_update(&hctx, state->ehpub, 32);
-    lt_sha256_finish(&hctx, hash);
-
-    // h = SHA256(h||PKEY_INDEX)
-    lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, hash, 32);
-    lt_sha256_update(&hctx, (uint8_t *)&pkey_index, 1);
-    lt_sha256_finish(&hctx, hash);
+    if (state->precomputed) {
+        memcpy(hash, state->hash, SHA256_DIGEST_LENGTH);
+    }
+    else {
+        lt_session_hash_ephemeral(hctx, prefix, pkey_index, state, hash);
+    }
 
     // h = SHA256(h||ETPUB)
-    lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, hash, 32);
-    lt_sha256_update(&hctx, p_rsp->e_tpub, 32);
-    lt_sha256_finish(&hctx, hash);
+    lt_sha256_init(hctx);
+    lt_sha256_start(hctx);
+    lt_sha256_update(hctx, hash, 32);
+    lt_sha256_update(hctx, p_rsp->e_tpub, 32);
+    lt_sha256_finish(hctx, hash);
 
     // ck = protocol_name
     uint8_t output_1[33] = {0};
@@ -112,7 +248,12 @@ lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_i
     lt_X25519(shipriv, p_rsp->e_tpub, shared_secret);
     lt_hkdf(output_1, 32, shared_secret, 32, 1, output_1, output_2);
     // ck, kAUTH = HKDF (ck, X25519(EHPRIV, STPUB), 2)
-    lt_X25519(state->ehpriv, stpub, shared_secret);
+    if (state->precomputed) {
+        memcpy(shared_secret, state->ss_stpub, sizeof(shared_secret));
+    }
+    else {
+        lt_X25519(state->ehpriv, stpub, shared_secret);
+    }
     uint8_t kauth[32] = {0};
     lt_hkdf(output_1, 32, shared_secret, 32, 2, output_1, kauth);
     // kCMD, kRES = HKDF (ck, emptystring, 2)
@@ -141,20 +282,87 @@ lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_i
     }
 
     h->l3.session = SESSION_ON;
+#if LT_SESSION_LIVENESS
+    if (h->l2.liveness) {
+        h->l2.liveness->alive = 1;
+        if (h->l2.liveness->time_us) {
+            h->l2.liveness->seen_us = h->l2.liveness->time_us();
+        }
+    }
+#endif
 
     return LT_OK;
 
 // If something went wrong during session keys establishment, better clean up AES GCM contexts
 exit:
-    memset(h->l3.encrypt, 0, 352);
-    memset(h->l3.decrypt, 0, 352);
+    lt_l3_invalidate_host_session_data(&h->l3);
 
     return ret;
 }
 
+/** Derives session keys and checks the handshake response, time is accounted to the handshake request */
+static lt_ret_t lt_in__session_finish(lt_handle_t *h, void *hctx, const uint8_t *prefix, const uint8_t *stpub,
+                                      const pkey_index_t pkey_index, const uint8_t *shipriv, session_state_t *state)
+{
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(&h->l2);
+    lt_ret_t ret = lt_in__session_keys(h, hctx, prefix, stpub, pkey_index, shipriv, state);
+    lt_stats_time(&h->l2, LT_STATS_CRYPTO, start_us);
+
+    return ret;
+#else
+    return lt_in__session_keys(h, hctx, prefix, stpub, pkey_index, shipriv, state);
+#endif
+}
+
+lt_ret_t lt_in__session_start(lt_handle_t *h, const uint8_t *stpub, const pkey_index_t pkey_index,
+                              const uint8_t *shipriv, const uint8_t *shipub, session_state_t *state)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_SESSION_START);
+
+    if (!h || !stpub || (pkey_index > PAIRING_KEY_SLOT_INDEX_3) || !shipriv || !shipub || !state) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_crypto_sha256_ctx_t hctx;
+    uint8_t prefix[SHA256_DIGEST_LENGTH];
+    lt_session_hash_prefix_hctx(&hctx, shipub, stpub, prefix);
+
+    return lt_in__session_finish(h, &hctx, prefix, stpub, pkey_index, shipriv, state);
+}
+
+lt_ret_t lt_in__session_start_ctx_hctx(lt_handle_t *h, void *hctx, const lt_session_ctx_t *ctx,
+                                       session_state_t *state)
+{
+    if (!h || !ctx || !ctx->shipriv || !state) {
+        return LT_PARAM_ERR;
+    }
+
+    return lt_in__session_finish(h, hctx, ctx->hash, ctx->stpub, ctx->pkey_index, ctx->shipriv, state);
+}
+
+lt_ret_t lt_in__session_start_ctx(lt_handle_t *h, const lt_session_ctx_t *ctx, session_state_t *state)
+{
+    struct lt_crypto_sha256_ctx_t hctx;
+
+    return lt_in__session_start_ctx_hctx(h, &hctx, ctx, state);
+}
+
 lt_ret_t lt_out__ping(lt_handle_t *h, const uint8_t *msg_out, const uint16_t len)
 {
-    if (!h || !msg_out || (len > PING_LEN_MAX)) {
+    if (!msg_out) {
+        return LT_PARAM_ERR;
+    }
+    const lt_iovec_t iov = {.base = msg_out, .len = len};
+
+    return lt_out__ping_v(h, &iov, 1);
+}
+
+lt_ret_t lt_out__ping_v(lt_handle_t *h, const lt_iovec_t *iov, const uint8_t iov_cnt)
+{
+    size_t len;
+    if (!h || (lt_iov_len(iov, iov_cnt, &len) != LT_OK) || (len > LT_PING_LEN_MAX)
+        || (LT_L3_PACKET_SIZE(LT_L3_PING_CMD_SIZE_MIN + len) > h->l3.buff_len)) {
         return LT_PARAM_ERR;
     }
     if (h->l3.session != SESSION_ON) {
@@ -165,40 +373,81 @@ lt_ret_t lt_out__ping(lt_handle_t *h, const uint8_t *msg_out, const uint16_t len
     struct lt_l3_ping_cmd_t *p_l3_cmd = (struct lt_l3_ping_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = len + LT_L3_PING_CMD_SIZE_MIN;
+    LT_L3_SET16(p_l3_cmd, cmd_size, (uint16_t)len + LT_L3_PING_CMD_SIZE_MIN);
     p_l3_cmd->cmd_id = LT_L3_PING_CMD_ID;
-    memcpy(p_l3_cmd->data_in, msg_out, len);
+    lt_iov_gather(p_l3_cmd->data_in, iov, iov_cnt);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ping(lt_handle_t *h, uint8_t *msg_in, const uint16_t len)
 {
-    if (!h || !msg_in || (len > PING_LEN_MAX)) {
+    if (!msg_in) {
+        return LT_PARAM_ERR;
+    }
+    const lt_iovec_out_t iov = {.base = msg_in, .len = len};
+
+    return lt_in__ping_v(h, &iov, 1);
+}
+
+lt_ret_t lt_in__ping_v(lt_handle_t *h, const lt_iovec_out_t *iov, const uint8_t iov_cnt)
+{
+    size_t len;
+    if (!h || (lt_iov_out_len(iov, iov_cnt, &len) != LT_OK) || (len > LT_PING_LEN_MAX)) {
         return LT_PARAM_ERR;
     }
     if (h->l3.session != SESSION_ON) {
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_ping_res_t *p_l3_res = (struct lt_l3_ping_res_t *)h->l3.buff;
+    struct lt_l3_ping_res_t *p_l3_res = (struct lt_l3_ping_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if ((LT_L3_PING_CMD_SIZE_MIN + len) != (p_l3_res->res_size)) {
+    if ((LT_L3_PING_CMD_SIZE_MIN + len) != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
-    memcpy(msg_in, p_l3_res->data_out, len);
+    lt_iov_scatter(p_l3_res->data_out, len, iov, iov_cnt);
 
     return LT_OK;
 }
 
+#if LT_L3_VIEWS
+lt_ret_t lt_in__ping_view(lt_handle_t *h, const uint8_t **msg_in, const uint16_t len)
+{
+    if (!h || !msg_in || (len > LT_PING_LEN_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    *msg_in = NULL;
+    if (h->l3.session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+    lt_ret_t ret = lt_l3_decrypt_res(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Pointer to access l3 buffer with result's data
+    struct lt_l3_ping_res_t *p_l3_res = (struct lt_l3_ping_res_t *)LT_L3_RES_BUFF(&h->l3);
+
+    // Check incomming l3 length
+    if ((LT_L3_PING_CMD_SIZE_MIN + len) != LT_L3_GET16(p_l3_res, res_size)) {
+        return LT_FAIL;
+    }
+
+    *msg_in = p_l3_res->data_out;
+
+    return LT_OK;
+}
+#endif
+
 lt_ret_t lt_out__pairing_key_write(lt_handle_t *h, const uint8_t *pairing_pub, const uint8_t slot)
 {
     if (!h || !pairing_pub || (slot > 3)) {
@@ -212,12 +461,12 @@ lt_ret_t lt_out__pairing_key_write(lt_handle_t *h, const uint8_t *pairing_pub, c
     struct lt_l3_pairing_key_write_cmd_t *p_l3_cmd = (struct lt_l3_pairing_key_write_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_PAIRING_KEY_WRITE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_PAIRING_KEY_WRITE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_PAIRING_KEY_WRITE_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
     memcpy(p_l3_cmd->s_hipub, pairing_pub, 32);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__pairing_key_write(lt_handle_t *h)
@@ -229,16 +478,16 @@ lt_ret_t lt_in__pairing_key_write(lt_handle_t *h)
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_pairing_key_write_res_t *p_l3_res = (struct lt_l3_pairing_key_write_res_t *)h->l3.buff;
+    struct lt_l3_pairing_key_write_res_t *p_l3_res = (struct lt_l3_pairing_key_write_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if (LT_L3_PAIRING_KEY_WRITE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_PAIRING_KEY_WRITE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -258,11 +507,11 @@ lt_ret_t lt_out__pairing_key_read(lt_handle_t *h, const uint8_t slot)
     struct lt_l3_pairing_key_read_cmd_t *p_l3_cmd = (struct lt_l3_pairing_key_read_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_PAIRING_KEY_READ_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_PAIRING_KEY_READ_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_PAIRING_KEY_READ_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__pairing_key_read(lt_handle_t *h, uint8_t *pubkey)
@@ -274,16 +523,16 @@ lt_ret_t lt_in__pairing_key_read(lt_handle_t *h, uint8_t *pubkey)
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_pairing_key_read_res_t *p_l3_res = (struct lt_l3_pairing_key_read_res_t *)h->l3.buff;
+    struct lt_l3_pairing_key_read_res_t *p_l3_res = (struct lt_l3_pairing_key_read_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if (LT_L3_PAIRING_KEY_READ_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_PAIRING_KEY_READ_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -305,12 +554,12 @@ lt_ret_t lt_out__pairing_key_invalidate(lt_handle_t *h, const uint8_t slot)
     struct lt_l3_pairing_key_invalidate_cmd_t *p_l3_cmd = (struct lt_l3_pairing_key_invalidate_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_PAIRING_KEY_INVALIDATE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_PAIRING_KEY_INVALIDATE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_PAIRING_KEY_INVALIDATE_CMD_ID;
     // cmd data
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__pairing_key_invalidate(lt_handle_t *h)
@@ -322,16 +571,16 @@ lt_ret_t lt_in__pairing_key_invalidate(lt_handle_t *h)
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_pairing_key_invalidate_res_t *p_l3_res = (struct lt_l3_pairing_key_invalidate_res_t *)h->l3.buff;
+    struct lt_l3_pairing_key_invalidate_res_t *p_l3_res = (struct lt_l3_pairing_key_invalidate_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if (LT_L3_PAIRING_KEY_INVALIDATE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_PAIRING_KEY_INVALIDATE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -388,12 +637,12 @@ lt_ret_t lt_out__r_config_write(lt_handle_t *h, enum CONFIGURATION_OBJECTS_REGS
     struct lt_l3_r_config_write_cmd_t *p_l3_cmd = (struct lt_l3_r_config_write_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_R_CONFIG_WRITE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_R_CONFIG_WRITE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_R_CONFIG_WRITE_CMD_ID;
-    p_l3_cmd->address = (uint16_t)addr;
-    p_l3_cmd->value = obj;
+    LT_L3_SET16(p_l3_cmd, address, (uint16_t)addr);
+    LT_L3_SET32(p_l3_cmd, value, obj);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__r_config_write(lt_handle_t *h)
@@ -406,15 +655,15 @@ lt_ret_t lt_in__r_config_write(lt_handle_t *h)
     }
 
     // Setup a pointer to l3 buffer, which is placed in handle
-    struct lt_l3_r_config_write_res_t *p_l3_res = (struct lt_l3_r_config_write_res_t *)h->l3.buff;
+    struct lt_l3_r_config_write_res_t *p_l3_res = (struct lt_l3_r_config_write_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_R_CONFIG_WRITE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_R_CONFIG_WRITE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -434,11 +683,11 @@ lt_ret_t lt_out__r_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_
     struct lt_l3_r_config_read_cmd_t *p_l3_cmd = (struct lt_l3_r_config_read_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_R_CONFIG_READ_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_R_CONFIG_READ_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_R_CONFIG_READ_CMD_ID;
-    p_l3_cmd->address = (uint16_t)addr;
+    LT_L3_SET16(p_l3_cmd, address, (uint16_t)addr);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__r_config_read(lt_handle_t *h, uint32_t *obj)
@@ -451,19 +700,19 @@ lt_ret_t lt_in__r_config_read(lt_handle_t *h, uint32_t *obj)
     }
 
     // Setup a pointer to l3 buffer, which is placed in handle
-    struct lt_l3_r_config_read_res_t *p_l3_res = (struct lt_l3_r_config_read_res_t *)h->l3.buff;
+    struct lt_l3_r_config_read_res_t *p_l3_res = (struct lt_l3_r_config_read_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_R_CONFIG_READ_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_R_CONFIG_READ_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
-    *obj = p_l3_res->value;
+    *obj = LT_L3_GET32(p_l3_res, value);
 
     return LT_OK;
 }
@@ -481,10 +730,10 @@ lt_ret_t lt_out__r_config_erase(lt_handle_t *h)
     struct lt_l3_r_config_erase_cmd_t *p_l3_cmd = (struct lt_l3_r_config_erase_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_R_CONFIG_ERASE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_R_CONFIG_ERASE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_R_CONFIG_ERASE_CMD_ID;
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__r_config_erase(lt_handle_t *h)
@@ -497,15 +746,15 @@ lt_ret_t lt_in__r_config_erase(lt_handle_t *h)
     }
 
     // Setup a pointer to l3 buffer, which is placed in handle
-    struct lt_l3_r_config_erase_res_t *p_l3_res = (struct lt_l3_r_config_erase_res_t *)h->l3.buff;
+    struct lt_l3_r_config_erase_res_t *p_l3_res = (struct lt_l3_r_config_erase_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_R_CONFIG_ERASE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_R_CONFIG_ERASE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -525,12 +774,12 @@ lt_ret_t lt_out__i_config_write(lt_handle_t *h, const enum CONFIGURATION_OBJECTS
     struct lt_l3_i_config_write_cmd_t *p_l3_cmd = (struct lt_l3_i_config_write_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_I_CONFIG_WRITE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_I_CONFIG_WRITE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_I_CONFIG_WRITE_CMD_ID;
-    p_l3_cmd->address = (uint16_t)addr;
+    LT_L3_SET16(p_l3_cmd, address, (uint16_t)addr);
     p_l3_cmd->bit_index = bit_index;
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__i_config_write(lt_handle_t *h)
@@ -543,15 +792,15 @@ lt_ret_t lt_in__i_config_write(lt_handle_t *h)
     }
 
     // Setup a pointer to l3 buffer, which is placed in handle
-    struct lt_l3_i_config_write_res_t *p_l3_res = (struct lt_l3_i_config_write_res_t *)h->l3.buff;
+    struct lt_l3_i_config_write_res_t *p_l3_res = (struct lt_l3_i_config_write_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_I_CONFIG_WRITE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_I_CONFIG_WRITE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -571,11 +820,11 @@ lt_ret_t lt_out__i_config_read(lt_handle_t *h, const enum CONFIGURATION_OBJECTS_
     struct lt_l3_i_config_read_cmd_t *p_l3_cmd = (struct lt_l3_i_config_read_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_I_CONFIG_READ_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_I_CONFIG_READ_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_I_CONFIG_READ_CMD_ID;
-    p_l3_cmd->address = (uint16_t)addr;
+    LT_L3_SET16(p_l3_cmd, address, (uint16_t)addr);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__i_config_read(lt_handle_t *h, uint32_t *obj)
@@ -588,26 +837,40 @@ lt_ret_t lt_in__i_config_read(lt_handle_t *h, uint32_t *obj)
     }
 
     // Setup a pointer to l3 buffer, which is placed in handle
-    struct lt_l3_i_config_read_res_t *p_l3_res = (struct lt_l3_i_config_read_res_t *)h->l3.buff;
+    struct lt_l3_i_config_read_res_t *p_l3_res = (struct lt_l3_i_config_read_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_I_CONFIG_READ_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_I_CONFIG_READ_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
-    *obj = p_l3_res->value;
+    *obj = LT_L3_GET32(p_l3_res, value);
 
     return LT_OK;
 }
 
+#if LT_ENABLE_R_MEM
 lt_ret_t lt_out__r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data, const uint16_t size)
 {
-    if (!h || !data || size < R_MEM_DATA_SIZE_MIN || size > R_MEM_DATA_SIZE_MAX || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
+    if (!data) {
+        return LT_PARAM_ERR;
+    }
+    const lt_iovec_t iov = {.base = data, .len = size};
+
+    return lt_out__r_mem_data_write_v(h, udata_slot, &iov, 1);
+}
+
+lt_ret_t lt_out__r_mem_data_write_v(lt_handle_t *h, const uint16_t udata_slot, const lt_iovec_t *iov,
+                                    const uint8_t iov_cnt)
+{
+    size_t size;
+    if (!h || (lt_iov_len(iov, iov_cnt, &size) != LT_OK) || size < R_MEM_DATA_SIZE_MIN || size > R_MEM_DATA_SIZE_MAX
+        || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
         return LT_PARAM_ERR;
     }
     if (h->l3.session != SESSION_ON) {
@@ -618,12 +881,12 @@ lt_ret_t lt_out__r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, con
     struct lt_l3_r_mem_data_write_cmd_t *p_l3_cmd = (struct lt_l3_r_mem_data_write_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = size + 4;
+    LT_L3_SET16(p_l3_cmd, cmd_size, (uint16_t)size + 4);
     p_l3_cmd->cmd_id = LT_L3_R_MEM_DATA_WRITE_CMD_ID;
-    p_l3_cmd->udata_slot = udata_slot;
-    memcpy(p_l3_cmd->data, data, size);
+    LT_L3_SET16(p_l3_cmd, udata_slot, udata_slot);
+    lt_iov_gather(p_l3_cmd->data, iov, iov_cnt);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__r_mem_data_write(lt_handle_t *h)
@@ -636,15 +899,15 @@ lt_ret_t lt_in__r_mem_data_write(lt_handle_t *h)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_r_mem_data_write_res_t *p_l3_res = (struct lt_l3_r_mem_data_write_res_t *)h->l3.buff;
+    struct lt_l3_r_mem_data_write_res_t *p_l3_res = (struct lt_l3_r_mem_data_write_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_R_MEM_DATA_WRITE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_R_MEM_DATA_WRITE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -664,16 +927,27 @@ lt_ret_t lt_out__r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot)
     struct lt_l3_r_mem_data_read_cmd_t *p_l3_cmd = (struct lt_l3_r_mem_data_read_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_R_MEM_DATA_READ_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_R_MEM_DATA_READ_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_R_MEM_DATA_READ_CMD_ID;
-    p_l3_cmd->udata_slot = udata_slot;
+    LT_L3_SET16(p_l3_cmd, udata_slot, udata_slot);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__r_mem_data_read(lt_handle_t *h, uint8_t *data, uint16_t *size)
 {
-    if (!h || !data || !size) {
+    if (!data) {
+        return LT_PARAM_ERR;
+    }
+    const lt_iovec_out_t iov = {.base = data, .len = R_MEM_DATA_SIZE_MAX};
+
+    return lt_in__r_mem_data_read_v(h, &iov, 1, size);
+}
+
+lt_ret_t lt_in__r_mem_data_read_v(lt_handle_t *h, const lt_iovec_out_t *iov, const uint8_t iov_cnt, uint16_t *size)
+{
+    size_t capacity;
+    if (!h || (lt_iov_out_len(iov, iov_cnt, &capacity) != LT_OK) || !size) {
         return LT_PARAM_ERR;
     }
     if (h->l3.session != SESSION_ON) {
@@ -681,33 +955,76 @@ lt_ret_t lt_in__r_mem_data_read(lt_handle_t *h, uint8_t *data, uint16_t *size)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_r_mem_data_read_res_t *p_l3_res = (struct lt_l3_r_mem_data_read_res_t *)h->l3.buff;
+    struct lt_l3_r_mem_data_read_res_t *p_l3_res = (struct lt_l3_r_mem_data_read_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if ((p_l3_res->res_size < LT_L3_R_MEM_DATA_READ_RES_SIZE_MIN)
-        || p_l3_res->res_size > LT_L3_R_MEM_DATA_READ_RES_SIZE_MAX) {
+    if ((LT_L3_GET16(p_l3_res, res_size) < LT_L3_R_MEM_DATA_READ_RES_SIZE_MIN)
+        || LT_L3_GET16(p_l3_res, res_size) > LT_L3_R_MEM_DATA_READ_RES_SIZE_MAX) {
         return LT_FAIL;
     }
 
     // Get read data size
     // TODO: If FW implements fail error code on R_Mem_Data_Read from empty slot, this can be removed.
-    *size = p_l3_res->res_size - sizeof(p_l3_res->result) - sizeof(p_l3_res->padding);
+    *size = LT_L3_GET16(p_l3_res, res_size) - sizeof(p_l3_res->result) - sizeof(p_l3_res->padding);
 
     // Check if slot is not empty
     if (*size == 0) {
         return LT_L3_R_MEM_DATA_READ_SLOT_EMPTY;
     }
+    // Size is kept, so the caller knows how much space is needed
+    if (*size > capacity) {
+        return LT_PARAM_ERR;
+    }
 
-    memcpy(data, p_l3_res->data, *size);
+    lt_iov_scatter(p_l3_res->data, *size, iov, iov_cnt);
 
     return LT_OK;
 }
 
+#if LT_L3_VIEWS
+lt_ret_t lt_in__r_mem_data_read_view(lt_handle_t *h, const uint8_t **data, uint16_t *size)
+{
+    if (!h || !data || !size) {
+        return LT_PARAM_ERR;
+    }
+    *data = NULL;
+    if (h->l3.session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+    // Pointer to access l3 buffer with result's data
+    struct lt_l3_r_mem_data_read_res_t *p_l3_res = (struct lt_l3_r_mem_data_read_res_t *)LT_L3_RES_BUFF(&h->l3);
+
+    lt_ret_t ret = lt_l3_decrypt_res(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Check incomming l3 length
+    if ((LT_L3_GET16(p_l3_res, res_size) < LT_L3_R_MEM_DATA_READ_RES_SIZE_MIN)
+        || LT_L3_GET16(p_l3_res, res_size) > LT_L3_R_MEM_DATA_READ_RES_SIZE_MAX) {
+        return LT_FAIL;
+    }
+
+    // Get read data size
+    *size = LT_L3_GET16(p_l3_res, res_size) - sizeof(p_l3_res->result) - sizeof(p_l3_res->padding);
+
+    // Check if slot is not empty
+    if (*size == 0) {
+        return LT_L3_R_MEM_DATA_READ_SLOT_EMPTY;
+    }
+
+    *data = p_l3_res->data;
+
+    return LT_OK;
+}
+#endif
+
 lt_ret_t lt_out__r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot)
 {
     if (!h || (udata_slot > R_MEM_DATA_SLOT_MAX)) {
@@ -721,11 +1038,11 @@ lt_ret_t lt_out__r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot)
     struct lt_l3_r_mem_data_erase_cmd_t *p_l3_cmd = (struct lt_l3_r_mem_data_erase_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_R_MEM_DATA_ERASE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_R_MEM_DATA_ERASE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_R_MEM_DATA_ERASE_CMD_ID;
-    p_l3_cmd->udata_slot = udata_slot;
+    LT_L3_SET16(p_l3_cmd, udata_slot, udata_slot);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__r_mem_data_erase(lt_handle_t *h)
@@ -738,20 +1055,21 @@ lt_ret_t lt_in__r_mem_data_erase(lt_handle_t *h)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_r_mem_data_erase_res_t *p_l3_res = (struct lt_l3_r_mem_data_erase_res_t *)h->l3.buff;
+    struct lt_l3_r_mem_data_erase_res_t *p_l3_res = (struct lt_l3_r_mem_data_erase_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_R_MEM_DATA_ERASE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_R_MEM_DATA_ERASE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
     return LT_OK;
 }
+#endif
 
 lt_ret_t lt_out__random_value_get(lt_handle_t *h, const uint16_t len)
 {
@@ -766,11 +1084,11 @@ lt_ret_t lt_out__random_value_get(lt_handle_t *h, const uint16_t len)
     struct lt_l3_random_value_get_cmd_t *p_l3_cmd = (struct lt_l3_random_value_get_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_RANDOM_VALUE_GET_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_RANDOM_VALUE_GET_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_RANDOM_VALUE_GET_CMD_ID;
     p_l3_cmd->n_bytes = len;
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t len)
@@ -783,16 +1101,16 @@ lt_ret_t lt_in__random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t l
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_random_value_get_res_t *p_l3_res = (struct lt_l3_random_value_get_res_t *)h->l3.buff;
+    struct lt_l3_random_value_get_res_t *p_l3_res = (struct lt_l3_random_value_get_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incoming L3 length. The size is always equal to the number of requested random bytes + 4,
     // where '4' is padding (3 bytes) + result status (1 byte).
-    if (LT_L3_RANDOM_VALUE_GET_RES_SIZE_MIN + len != (p_l3_res->res_size)) {
+    if (LT_L3_RANDOM_VALUE_GET_RES_SIZE_MIN + len != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -803,6 +1121,36 @@ lt_ret_t lt_in__random_value_get(lt_handle_t *h, uint8_t *buff, const uint16_t l
     return LT_OK;
 }
 
+#if LT_L3_VIEWS
+lt_ret_t lt_in__random_value_get_view(lt_handle_t *h, const uint8_t **buff, const uint16_t len)
+{
+    if ((len > RANDOM_VALUE_GET_LEN_MAX) || !h || !buff) {
+        return LT_PARAM_ERR;
+    }
+    *buff = NULL;
+    if (h->l3.session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+    // Pointer to access l3 buffer with result's data
+    struct lt_l3_random_value_get_res_t *p_l3_res = (struct lt_l3_random_value_get_res_t *)LT_L3_RES_BUFF(&h->l3);
+
+    lt_ret_t ret = lt_l3_decrypt_res(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Check incoming L3 length, see lt_in__random_value_get()
+    if (LT_L3_RANDOM_VALUE_GET_RES_SIZE_MIN + len != LT_L3_GET16(p_l3_res, res_size)) {
+        return LT_FAIL;
+    }
+
+    *buff = p_l3_res->random_data;
+
+    return LT_OK;
+}
+#endif
+
 lt_ret_t lt_out__ecc_key_generate(lt_handle_t *h, const ecc_slot_t slot, const lt_ecc_curve_type_t curve)
 {
     if (!h || (slot > ECC_SLOT_31) || ((curve != CURVE_P256) && (curve != CURVE_ED25519))) {
@@ -816,12 +1164,12 @@ lt_ret_t lt_out__ecc_key_generate(lt_handle_t *h, const ecc_slot_t slot, const l
     struct lt_l3_ecc_key_generate_cmd_t *p_l3_cmd = (struct lt_l3_ecc_key_generate_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_ECC_KEY_GENERATE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_ECC_KEY_GENERATE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_ECC_KEY_GENERATE_CMD_ID;
-    p_l3_cmd->slot = (uint8_t)slot;
+    LT_L3_SET16(p_l3_cmd, slot, (uint8_t)slot);
     p_l3_cmd->curve = (uint8_t)curve;
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ecc_key_generate(lt_handle_t *h)
@@ -830,16 +1178,16 @@ lt_ret_t lt_in__ecc_key_generate(lt_handle_t *h)
         return LT_PARAM_ERR;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_ecc_key_generate_res_t *p_l3_res = (struct lt_l3_ecc_key_generate_res_t *)h->l3.buff;
+    struct lt_l3_ecc_key_generate_res_t *p_l3_res = (struct lt_l3_ecc_key_generate_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if (LT_L3_ECC_KEY_GENERATE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_ECC_KEY_GENERATE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -861,13 +1209,13 @@ lt_ret_t lt_out__ecc_key_store(lt_handle_t *h, const ecc_slot_t slot, const lt_e
     struct lt_l3_ecc_key_store_cmd_t *p_l3_cmd = (struct lt_l3_ecc_key_store_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_ECC_KEY_STORE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_ECC_KEY_STORE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_ECC_KEY_STORE_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
     p_l3_cmd->curve = curve;
     memcpy(p_l3_cmd->k, key, 32);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ecc_key_store(lt_handle_t *h)
@@ -879,16 +1227,16 @@ lt_ret_t lt_in__ecc_key_store(lt_handle_t *h)
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_ecc_key_store_res_t *p_l3_res = (struct lt_l3_ecc_key_store_res_t *)h->l3.buff;
+    struct lt_l3_ecc_key_store_res_t *p_l3_res = (struct lt_l3_ecc_key_store_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if (LT_L3_ECC_KEY_STORE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_ECC_KEY_STORE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -910,11 +1258,11 @@ lt_ret_t lt_out__ecc_key_read(lt_handle_t *h, const ecc_slot_t slot)
     struct lt_l3_ecc_key_read_cmd_t *p_l3_cmd = (struct lt_l3_ecc_key_read_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_ECC_KEY_READ_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_ECC_KEY_READ_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_ECC_KEY_READ_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ecc_key_read(lt_handle_t *h, uint8_t *key, lt_ecc_curve_type_t *curve, ecc_key_origin_t *origin)
@@ -926,27 +1274,27 @@ lt_ret_t lt_in__ecc_key_read(lt_handle_t *h, uint8_t *key, lt_ecc_curve_type_t *
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_ecc_key_read_res_t *p_l3_res = (struct lt_l3_ecc_key_read_res_t *)h->l3.buff;
+    struct lt_l3_ecc_key_read_res_t *p_l3_res = (struct lt_l3_ecc_key_read_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     *curve = p_l3_res->curve;
     *origin = p_l3_res->origin;
 
     if (p_l3_res->curve == (uint8_t)CURVE_ED25519) {
         // Check incomming l3 length
-        if ((p_l3_res->res_size - 1 - 1 - 1 - 13) != 32) {
+        if ((LT_L3_GET16(p_l3_res, res_size) - 1 - 1 - 1 - 13) != 32) {
             return LT_FAIL;
         }
         memcpy(key, p_l3_res->pub_key, 32);
     }
     else if (p_l3_res->curve == (uint8_t)CURVE_P256) {
         // Check incomming l3 length
-        if (((p_l3_res->res_size - 1 - 1 - 1 - 13) != 64)) {
+        if (((LT_L3_GET16(p_l3_res, res_size) - 1 - 1 - 1 - 13) != 64)) {
             return LT_FAIL;
         }
         memcpy(key, p_l3_res->pub_key, 64);
@@ -974,11 +1322,11 @@ lt_ret_t lt_out__ecc_key_erase(lt_handle_t *h, const ecc_slot_t slot)
     struct lt_l3_ecc_key_erase_cmd_t *p_l3_cmd = (struct lt_l3_ecc_key_erase_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_ECC_KEY_ERASE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_ECC_KEY_ERASE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_ECC_KEY_ERASE_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ecc_key_erase(lt_handle_t *h)
@@ -990,16 +1338,16 @@ lt_ret_t lt_in__ecc_key_erase(lt_handle_t *h)
         return LT_HOST_NO_SESSION;
     }
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_ecc_key_erase_res_t *p_l3_res = (struct lt_l3_ecc_key_erase_res_t *)h->l3.buff;
+    struct lt_l3_ecc_key_erase_res_t *p_l3_res = (struct lt_l3_ecc_key_erase_res_t *)LT_L3_RES_BUFF(&h->l3);
 
     // Check incomming l3 length
-    if (LT_L3_ECC_KEY_ERASE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_ECC_KEY_ERASE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -1008,31 +1356,56 @@ lt_ret_t lt_in__ecc_key_erase(lt_handle_t *h)
 
 lt_ret_t lt_out__ecc_ecdsa_sign(lt_handle_t *h, const ecc_slot_t slot, const uint8_t *msg, const uint32_t msg_len)
 {
-    if (!h || (slot > ECC_SLOT_31) || !msg) {
+    if (!msg) {
+        return LT_PARAM_ERR;
+    }
+    const lt_iovec_t iov = {.base = msg, .len = msg_len};
+
+    return lt_out__ecc_ecdsa_sign_v(h, slot, &iov, 1);
+}
+
+lt_ret_t lt_out__ecc_ecdsa_sign_v(lt_handle_t *h, const ecc_slot_t slot, const lt_iovec_t *iov, const uint8_t iov_cnt)
+{
+    size_t msg_len;
+    if (!h || (slot > ECC_SLOT_31) || (lt_iov_len(iov, iov_cnt, &msg_len) != LT_OK)) {
         return LT_PARAM_ERR;
     }
     if (h->l3.session != SESSION_ON) {
         return LT_HOST_NO_SESSION;
     }
 
-    // Prepare hash of a message
+    // Prepare hash of a message, fragments are hashed where they are
     uint8_t msg_hash[32] = {0};
     struct lt_crypto_sha256_ctx_t hctx = {0};
     lt_sha256_init(&hctx);
     lt_sha256_start(&hctx);
-    lt_sha256_update(&hctx, (uint8_t *)msg, msg_len);
+    for (uint8_t i = 0; i < iov_cnt; i++) {
+        lt_sha256_update(&hctx, iov[i].base, iov[i].len);
+    }
     lt_sha256_finish(&hctx, msg_hash);
 
+    return lt_out__ecc_ecdsa_sign_digest(h, slot, msg_hash);
+}
+
+lt_ret_t lt_out__ecc_ecdsa_sign_digest(lt_handle_t *h, const ecc_slot_t slot, const uint8_t *msg_hash)
+{
+    if (!h || (slot > ECC_SLOT_31) || !msg_hash) {
+        return LT_PARAM_ERR;
+    }
+    if (h->l3.session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
     // Pointer to access l3 buffer when it contains command data
     struct lt_l3_ecdsa_sign_cmd_t *p_l3_cmd = (struct lt_l3_ecdsa_sign_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_ECDSA_SIGN_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_ECDSA_SIGN_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_ECDSA_SIGN_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
     memcpy(p_l3_cmd->msg_hash, msg_hash, 32);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ecc_ecdsa_sign(lt_handle_t *h, uint8_t *rs)
@@ -1045,15 +1418,15 @@ lt_ret_t lt_in__ecc_ecdsa_sign(lt_handle_t *h, uint8_t *rs)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_ecdsa_sign_res_t *p_l3_res = (struct lt_l3_ecdsa_sign_res_t *)h->l3.buff;
+    struct lt_l3_ecdsa_sign_res_t *p_l3_res = (struct lt_l3_ecdsa_sign_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_ECDSA_SIGN_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_ECDSA_SIGN_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -1065,7 +1438,21 @@ lt_ret_t lt_in__ecc_ecdsa_sign(lt_handle_t *h, uint8_t *rs)
 
 lt_ret_t lt_out__ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const uint8_t *msg, const uint16_t msg_len)
 {
-    if (!h || !msg || (msg_len > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX) || (ecc_slot > ECC_SLOT_31)) {
+    if (!msg) {
+        return LT_PARAM_ERR;
+    }
+    const lt_iovec_t iov = {.base = msg, .len = msg_len};
+
+    return lt_out__ecc_eddsa_sign_v(h, ecc_slot, &iov, 1);
+}
+
+lt_ret_t lt_out__ecc_eddsa_sign_v(lt_handle_t *h, const ecc_slot_t ecc_slot, const lt_iovec_t *iov,
+                                  const uint8_t iov_cnt)
+{
+    size_t msg_len;
+    if (!h || (lt_iov_len(iov, iov_cnt, &msg_len) != LT_OK) || (msg_len > LT_EDDSA_MSG_LEN_MAX)
+        || (ecc_slot > ECC_SLOT_31)
+        || (LT_L3_PACKET_SIZE(LT_L3_EDDSA_SIGN_CMD_SIZE_MIN - 1 + msg_len) > h->l3.buff_len)) {
         return LT_PARAM_ERR;
     }
     if (h->l3.session != SESSION_ON) {
@@ -1076,13 +1463,13 @@ lt_ret_t lt_out__ecc_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, const
     struct lt_l3_eddsa_sign_cmd_t *p_l3_cmd = (struct lt_l3_eddsa_sign_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_EDDSA_SIGN_CMD_SIZE_MIN + msg_len
-                         - 1;  // -1 Because the LT_L3_EDDSA_SIGN_CMD_SIZE_MIN already includes minimal message size 1B
+    // -1 Because the LT_L3_EDDSA_SIGN_CMD_SIZE_MIN already includes minimal message size 1B
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_EDDSA_SIGN_CMD_SIZE_MIN + (uint16_t)msg_len - 1);
     p_l3_cmd->cmd_id = LT_L3_EDDSA_SIGN_CMD_ID;
-    p_l3_cmd->slot = ecc_slot;
-    memcpy(p_l3_cmd->msg, msg, msg_len);
+    LT_L3_SET16(p_l3_cmd, slot, ecc_slot);
+    lt_iov_gather(p_l3_cmd->msg, iov, iov_cnt);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__ecc_eddsa_sign(lt_handle_t *h, uint8_t *rs)
@@ -1095,15 +1482,15 @@ lt_ret_t lt_in__ecc_eddsa_sign(lt_handle_t *h, uint8_t *rs)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_eddsa_sign_res_t *p_l3_res = (struct lt_l3_eddsa_sign_res_t *)h->l3.buff;
+    struct lt_l3_eddsa_sign_res_t *p_l3_res = (struct lt_l3_eddsa_sign_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_EDDSA_SIGN_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_EDDSA_SIGN_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -1113,6 +1500,7 @@ lt_ret_t lt_in__ecc_eddsa_sign(lt_handle_t *h, uint8_t *rs)
     return LT_OK;
 }
 
+#if LT_ENABLE_MCOUNTER
 lt_ret_t lt_out__mcounter_init(lt_handle_t *h, const enum lt_mcounter_index_t mcounter_index,
                                const uint32_t mcounter_value)
 {
@@ -1127,12 +1515,12 @@ lt_ret_t lt_out__mcounter_init(lt_handle_t *h, const enum lt_mcounter_index_t mc
     struct lt_l3_mcounter_init_cmd_t *p_l3_cmd = (struct lt_l3_mcounter_init_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_MCOUNTER_INIT_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_MCOUNTER_INIT_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_MCOUNTER_INIT_CMD_ID;
-    p_l3_cmd->mcounter_index = mcounter_index;
-    p_l3_cmd->mcounter_val = mcounter_value;
+    LT_L3_SET16(p_l3_cmd, mcounter_index, mcounter_index);
+    LT_L3_SET32(p_l3_cmd, mcounter_val, mcounter_value);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__mcounter_init(lt_handle_t *h)
@@ -1145,15 +1533,15 @@ lt_ret_t lt_in__mcounter_init(lt_handle_t *h)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_mcounter_init_res_t *p_l3_res = (struct lt_l3_mcounter_init_res_t *)h->l3.buff;
+    struct lt_l3_mcounter_init_res_t *p_l3_res = (struct lt_l3_mcounter_init_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_MCOUNTER_INIT_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_MCOUNTER_INIT_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -1173,11 +1561,11 @@ lt_ret_t lt_out__mcounter_update(lt_handle_t *h, const enum lt_mcounter_index_t
     struct lt_l3_mcounter_update_cmd_t *p_l3_cmd = (struct lt_l3_mcounter_update_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_MCOUNTER_UPDATE_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_MCOUNTER_UPDATE_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_MCOUNTER_UPDATE_CMD_ID;
-    p_l3_cmd->mcounter_index = mcounter_index;
+    LT_L3_SET16(p_l3_cmd, mcounter_index, mcounter_index);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__mcounter_update(lt_handle_t *h)
@@ -1190,15 +1578,15 @@ lt_ret_t lt_in__mcounter_update(lt_handle_t *h)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_mcounter_update_res_t *p_l3_res = (struct lt_l3_mcounter_update_res_t *)h->l3.buff;
+    struct lt_l3_mcounter_update_res_t *p_l3_res = (struct lt_l3_mcounter_update_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_MCOUNTER_UPDATE_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_MCOUNTER_UPDATE_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -1218,11 +1606,11 @@ lt_ret_t lt_out__mcounter_get(lt_handle_t *h, const enum lt_mcounter_index_t mco
     struct lt_l3_mcounter_get_cmd_t *p_l3_cmd = (struct lt_l3_mcounter_get_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_MCOUNTER_GET_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_MCOUNTER_GET_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_MCOUNTER_GET_CMD_ID;
-    p_l3_cmd->mcounter_index = mcounter_index;
+    LT_L3_SET16(p_l3_cmd, mcounter_index, mcounter_index);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__mcounter_get(lt_handle_t *h, uint32_t *mcounter_value)
@@ -1235,22 +1623,23 @@ lt_ret_t lt_in__mcounter_get(lt_handle_t *h, uint32_t *mcounter_value)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_mcounter_get_res_t *p_l3_res = (struct lt_l3_mcounter_get_res_t *)h->l3.buff;
+    struct lt_l3_mcounter_get_res_t *p_l3_res = (struct lt_l3_mcounter_get_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_MCOUNTER_GET_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_MCOUNTER_GET_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
-    *mcounter_value = p_l3_res->mcounter_val;
+    *mcounter_value = LT_L3_GET32(p_l3_res, mcounter_val);
 
     return LT_OK;
 }
+#endif
 
 lt_ret_t lt_out__mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, const uint8_t *data_out)
 {
@@ -1265,12 +1654,12 @@ lt_ret_t lt_out__mac_and_destroy(lt_handle_t *h, mac_and_destroy_slot_t slot, co
     struct lt_l3_mac_and_destroy_cmd_t *p_l3_cmd = (struct lt_l3_mac_and_destroy_cmd_t *)h->l3.buff;
 
     // Fill l3 buffer
-    p_l3_cmd->cmd_size = LT_L3_MAC_AND_DESTROY_CMD_SIZE;
+    LT_L3_SET16(p_l3_cmd, cmd_size, LT_L3_MAC_AND_DESTROY_CMD_SIZE);
     p_l3_cmd->cmd_id = LT_L3_MAC_AND_DESTROY_CMD_ID;
-    p_l3_cmd->slot = slot;
+    LT_L3_SET16(p_l3_cmd, slot, slot);
     memcpy(p_l3_cmd->data_in, data_out, MAC_AND_DESTROY_DATA_SIZE);
 
-    return lt_l3_encrypt_request(&h->l3);
+    return lt_l3_encrypt_cmd(h);
 }
 
 lt_ret_t lt_in__mac_and_destroy(lt_handle_t *h, uint8_t *data_in)
@@ -1283,15 +1672,15 @@ lt_ret_t lt_in__mac_and_destroy(lt_handle_t *h, uint8_t *data_in)
     }
 
     // Pointer to access l3 buffer with result's data
-    struct lt_l3_mac_and_destroy_res_t *p_l3_res = (struct lt_l3_mac_and_destroy_res_t *)h->l3.buff;
+    struct lt_l3_mac_and_destroy_res_t *p_l3_res = (struct lt_l3_mac_and_destroy_res_t *)LT_L3_RES_BUFF(&h->l3);
 
-    lt_ret_t ret = lt_l3_decrypt_response(&h->l3);
+    lt_ret_t ret = lt_l3_decrypt_res(h);
     if (ret != LT_OK) {
         return ret;
     }
 
     // Check incomming l3 length
-    if (LT_L3_MAC_AND_DESTROY_RES_SIZE != (p_l3_res->res_size)) {
+    if (LT_L3_MAC_AND_DESTROY_RES_SIZE != LT_L3_GET16(p_l3_res, res_size)) {
         return LT_FAIL;
     }
 
@@ -1299,3 +1688,54 @@ lt_ret_t lt_in__mac_and_destroy(lt_handle_t *h, uint8_t *data_in)
 
     return LT_OK;
 }
+
+#if LT_RAW_CMD
+lt_ret_t lt_out__raw_cmd(lt_handle_t *h, const uint8_t *cmd, const uint16_t cmd_len)
+{
+    if (!h || !cmd || (cmd_len < L3_CMD_ID_SIZE) || (cmd_len > L3_CYPHERTEXT_MAX_SIZE)
+        || (LT_L3_PACKET_SIZE(cmd_len) > h->l3.buff_len)) {
+        return LT_PARAM_ERR;
+    }
+    if (h->l3.session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+    // Pointer to access l3 buffer when it contains command data
+    struct lt_l3_gen_frame_t *p_l3_cmd = (struct lt_l3_gen_frame_t *)h->l3.buff;
+
+    // Fill l3 buffer
+    LT_L3_SET16(p_l3_cmd, cmd_size, cmd_len);
+    memcpy(p_l3_cmd->data, cmd, cmd_len);
+
+    return lt_l3_encrypt_cmd(h);
+}
+
+lt_ret_t lt_in__raw_cmd(lt_handle_t *h, uint8_t *res, const uint16_t res_max_len, uint16_t *res_len)
+{
+    if (!h || !res || !res_len) {
+        return LT_PARAM_ERR;
+    }
+    if (h->l3.session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+    lt_ret_t ret = lt_l3_decrypt_res(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Pointer to access l3 buffer with result's data
+    struct lt_l3_gen_frame_t *p_l3_res = (struct lt_l3_gen_frame_t *)LT_L3_RES_BUFF(&h->l3);
+
+    // Check incomming l3 length
+    uint16_t size = LT_L3_GET16(p_l3_res, cmd_size);
+    if (size > res_max_len) {
+        return LT_L3_DATA_LEN_ERROR;
+    }
+
+    memcpy(res, p_l3_res->data, size);
+    *res_len = size;
+
+    return LT_OK;
+}
+#endif
@@ -12,14 +12,17 @@
 #if LT_USE_TREZOR_CRYPTO
 #include "aes/aes.h"
 #include "aes/aesgcm.h"
+#elif USE_MBEDTLS
+#include "mbedtls/gcm.h"
 #endif
+#include "lt_crypto_dispatch.h"
 
 /** AES-GCM context structure */
 struct lt_crypto_aes_gcm_ctx_t {
 #if LT_USE_TREZOR_CRYPTO
     gcm_ctx ctx;
 #elif USE_MBEDTLS
-
+    mbedtls_gcm_context ctx;
 #endif
 };
 
@@ -67,6 +70,41 @@ int lt_aesgcm_encrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8
 int lt_aesgcm_decrypt(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len, uint8_t *msg,
                       uint32_t msg_len, const uint8_t *tag, uint32_t tag_len) __attribute__((warn_unused_result));
 
+/**
+ * @details This function starts decryption of a message which is then passed in parts to
+ * `lt_aesgcm_decrypt_update()`. It expect initialized context with valid keys.
+ *
+ * @param ctx         AESGCM context structure
+ * @param iv          The initialisation vector
+ * @param iv_len      Length of initialization vector in bytes
+ * @param aad         The header buffer
+ * @param aad_len     Length of header buffer in bytes
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+int lt_aesgcm_decrypt_start(void *ctx, const uint8_t *iv, uint32_t iv_len, const uint8_t *aad, uint32_t aad_len)
+    __attribute__((warn_unused_result));
+
+/**
+ * @details This function authenticates and decrypts next part of a message in place. Decrypted data are not
+ * authenticated until `lt_aesgcm_decrypt_finish()` succeeds.
+ *
+ * @param ctx         AESGCM context structure
+ * @param msg         Message buffer
+ * @param msg_len     Length of message in bytes
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+int lt_aesgcm_decrypt_update(void *ctx, uint8_t *msg, uint32_t msg_len) __attribute__((warn_unused_result));
+
+/**
+ * @details This function finishes decryption of a message and verifies its tag.
+ *
+ * @param ctx         AESGCM context structure
+ * @param tag         The tag buffer
+ * @param tag_len     Length of tag buffer in bytes
+ * @return            LT_OK if tag is valid, otherwise returns other error code.
+ */
+int lt_aesgcm_decrypt_finish(void *ctx, const uint8_t *tag, uint32_t tag_len) __attribute__((warn_unused_result));
+
 /**
  * @details This function clears AES GCM context
  *
@@ -0,0 +1,44 @@
+#ifndef LT_AESGCM_MULTI_H
+#define LT_AESGCM_MULTI_H
+
+/**
+ * @file   lt_aesgcm_multi.h
+ * @brief  AES-GCM encryption of several independent messages at once
+ * @author Tropic Square s.r.o.
+ *
+ * hal/crypto/accel/lt_crypto_accel_aesgcm.c encrypts LT_AESGCM_MULTI_LANES messages of different contexts together,
+ * AES rounds and GHASH multiplications of all lanes are interleaved, so latencies of AES and carry-less
+ * multiplication instructions overlap (set by LT_AESGCM_MULTI CMake option). With one lane
+ * hal/crypto/common/lt_crypto_aesgcm_multi.c encrypts the messages one by one by `lt_aesgcm_encrypt()` of the crypto
+ * backend.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LT_AESGCM_MULTI_LANES
+/** Number of messages encrypted in parallel */
+#define LT_AESGCM_MULTI_LANES 1
+#endif
+
+/**
+ * @brief Encrypts each message in place by its own context without AAD, as `lt_aesgcm_encrypt()` does
+ * @note Lanes run for as many blocks as the longest message of their group, batches of similar lengths are the fastest
+ *
+ * @param ctxs        AESGCM contexts initialized with keys, one for each message
+ * @param ivs         Initialisation vectors
+ * @param iv_len      Length of each initialization vector in bytes
+ * @param msgs        Message buffers
+ * @param msg_lens    Lengths of messages in bytes
+ * @param tags        Tag buffers
+ * @param tag_len     Length of each tag buffer in bytes
+ * @param n           Number of messages
+ * @param rets        Result of each message, LT_OK if success, otherwise other error code
+ */
+void lt_aesgcm_encrypt_multi(void *const *ctxs, const uint8_t *const *ivs, const uint32_t iv_len, uint8_t *const *msgs,
+                             const uint32_t *msg_lens, uint8_t *const *tags, const uint32_t tag_len, const size_t n,
+                             int *rets);
+
+#endif
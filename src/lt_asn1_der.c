@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "lt_profile.h"
+
 // Uncomment to enable parser logging
 // #define ASNDER_LOG_EN
 
@@ -27,20 +29,20 @@
  * @details Holds state of the parser and parsing results
  */
 struct parse_ctx_t {
-    uint8_t *head;                      /** Next byte to be parse */
-    uint16_t len;                       /** Length of the byte stream */
-    uint16_t past;                      /** Index of last processed byte */
-    uint32_t obj_id;                    /** Target OBJECT_IDENTIFIER (3-byte) to be searched */
-    uint8_t *sbuf;                      /** Buffer (and its length) where to copy data after
-                                            OBJECT_IDENTIFIER match */
-    int sbuf_len;                       /** Length of Buffer pointed to by sbuf. */
-    enum asn1der_crop_kind_t crop_kind; /** How to treat objects larger than provided buffer */
-    bool sample_next;                   /** Internal context ->
-                                            Next ASN1 object is the one to be sampled */
-    bool found;                         /** Searched OBJECT_IDENTIFIER was found */
-    bool cropped;                       /** Searched object was cropped */
+    uint8_t *head;                  /** Next byte to be parse */
+    uint16_t len;                   /** Length of the byte stream */
+    uint16_t past;                  /** Index of last processed byte */
+    struct asn1der_request_t *reqs; /** Searched objects */
+    uint8_t cnt;                    /** Number of searched objects */
+    uint32_t sample_next;           /** Internal context ->
+                                        Bit per request, next ASN1 object is the one to be sampled */
+    uint32_t found;                 /** Bit per request, searched OBJECT_IDENTIFIER was found */
+    bool stop_found;                /** Stop parsing when all searched objects are found */
 };
 
+/** Bits of all requests of the context */
+#define ALL_FOUND(ctx) ((ctx)->found == (UINT32_MAX >> (32 - (ctx)->cnt)))
+
 #ifdef ASNDER_LOG_EN
 #define PARSE_ERR(ctx, msg, ...)                                       \
     do {                                                               \
@@ -171,6 +173,8 @@ static lt_ret_t parse_object(struct parse_ctx_t *ctx)
             while (ctx->past < start + len - 1) {
                 rv = parse_object(ctx);
                 if (rv != LT_OK) return rv;
+                // Rest of the sequence does not have to be available
+                if (ALL_FOUND(ctx) && ctx->stop_found) return LT_OK;
             }
 
             if (start + len != ctx->past) {
@@ -202,11 +206,13 @@ static lt_ret_t parse_object(struct parse_ctx_t *ctx)
             // We skip this step if the len is shorter than 3, so this is OK.
             uint32_t obj_id = (((uint32_t)buf[0]) << 16) | (((uint32_t)buf[1]) << 8) | (((uint32_t)buf[2]));
 
-            if (ctx->obj_id == obj_id) {
+            for (uint8_t i = 0; i < ctx->cnt; i++) {
+                if (ctx->reqs[i].obj_id == (int32_t)obj_id) {
 #ifdef ASNDER_LOG_EN
-                LT_LOG("Found searched object: 0x%" PRIx32 ". Next object will be sampled!", ctx->obj_id);
+                    LT_LOG("Found searched object: 0x%" PRIx32 ". Next object will be sampled!", obj_id);
 #endif
-                ctx->sample_next = true;
+                    ctx->sample_next |= 1u << i;
+                }
             }
             break;
         }
@@ -220,44 +226,42 @@ static lt_ret_t parse_object(struct parse_ctx_t *ctx)
         case ASN1DER_STRING_UTF8:
         case ASN1DER_STRING_PRINTABLE:
         case ASN1DER_UTC_TIME: {
-            if (ctx->sample_next & !ctx->found) {
+            uint32_t sample = ctx->sample_next & ~ctx->found;
+            const uint8_t *value = ctx->head;
+            uint16_t offset = ctx->past;
+            DROP_BYTES(ctx, len);
+
+            for (uint8_t i = 0; sample && (i < ctx->cnt); i++) {
+                if (!(sample & (1u << i))) {
+                    continue;
+                }
 #ifdef ASNDER_LOG_EN
-                LT_LOG("Sampling this object!", ctx->obj_id);
+                LT_LOG("Sampling this object for 0x%" PRIx32 "!", ctx->reqs[i].obj_id);
 #endif
-                uint8_t sample_len = len;
-
-                if (ctx->sbuf_len < sample_len) {
-                    uint16_t n_crop_bytes = sample_len - ctx->sbuf_len;
-                    bool crop_prefix = ctx->crop_kind == ASN1DER_CROP_PREFIX;
-                    ctx->cropped = true;
-
+                struct asn1der_request_t *req = &ctx->reqs[i];
+                req->offset = offset;
+                req->len = len;
+
+                if (req->buf) {
+                    uint16_t sample_len = len;
+                    uint16_t n_crop_bytes = 0;
+                    if (req->buf_len < sample_len) {
+                        sample_len = req->buf_len;
+                        if (req->crop_kind == ASN1DER_CROP_PREFIX) {
+                            n_crop_bytes = len - sample_len;
+                        }
 #ifdef ASNDER_LOG_EN
-                    LT_LOG("Sample buffer (%d) is smaller than size of the object to be sampled (%" PRIu8
-                           "). "
-                           "Cropping %" PRIu16 " bytes from %s of the searched object",
-                           ctx->sbuf_len, sample_len, n_crop_bytes, crop_prefix ? "prefix" : "suffix");
+                        LT_LOG("Sample buffer (%d) is smaller than size of the object to be sampled (%" PRIu16
+                               "). Cropping %" PRIu16 " bytes from %s of the searched object",
+                               req->buf_len, len, len - sample_len,
+                               (req->crop_kind == ASN1DER_CROP_PREFIX) ? "prefix" : "suffix");
 #endif
-
-                    if (crop_prefix) {
-                        DROP_BYTES(ctx, n_crop_bytes)
-                    }
-
-                    sample_len = ctx->sbuf_len;
-                    GET_BYTES(ctx, ctx->sbuf, sample_len);
-
-                    if (!crop_prefix) {
-                        DROP_BYTES(ctx, n_crop_bytes)
                     }
-                }
-                else {
-                    GET_BYTES(ctx, ctx->sbuf, sample_len);
+                    memcpy(req->buf, value + n_crop_bytes, sample_len);
                 }
 
-                ctx->sample_next = false;
-                ctx->found = true;
-            }
-            else {
-                DROP_BYTES(ctx, len);
+                ctx->sample_next &= ~(1u << i);
+                ctx->found |= 1u << i;
             }
             break;
         }
@@ -273,26 +277,295 @@ static lt_ret_t parse_object(struct parse_ctx_t *ctx)
  * Public API
  *******************************************************************************/
 
-lt_ret_t asn1der_find_object(const uint8_t *stream, uint16_t len, int32_t obj_id, uint8_t *buf, int buf_len,
-                             enum asn1der_crop_kind_t crop_kind)
+/** Runs the parser over the stream */
+static lt_ret_t find_objects(const uint8_t *stream, uint16_t len, struct asn1der_request_t *reqs, uint8_t cnt,
+                             bool stop_found)
 {
     struct parse_ctx_t ctx = {.head = (uint8_t *)stream,
                               .len = len,
                               .past = 0,
-                              .obj_id = obj_id,
-                              .sbuf = buf,
-                              .sbuf_len = buf_len,
-                              .crop_kind = crop_kind,
-                              .sample_next = false,
-                              .found = false,
-                              .cropped = false};
+                              .reqs = reqs,
+                              .cnt = cnt,
+                              .sample_next = 0,
+                              .found = 0,
+                              .stop_found = stop_found};
 
     while (ctx.past < ctx.len - 1) {
         lt_ret_t rv = parse_object(&ctx);
         if (rv != LT_OK) return rv;
+        if (ALL_FOUND(&ctx) && ctx.stop_found) return LT_OK;
     };
 
-    if (!ctx.found) return LT_CERT_ITEM_NOT_FOUND;
+    if (!ALL_FOUND(&ctx)) return LT_CERT_ITEM_NOT_FOUND;
+
+    return LT_OK;
+}
+
+/** Searches single object copied into `buf` */
+static lt_ret_t find_object(const uint8_t *stream, uint16_t len, int32_t obj_id, uint8_t *buf, int buf_len,
+                            enum asn1der_crop_kind_t crop_kind, bool stop_found)
+{
+    if (!buf) {
+        return LT_PARAM_ERR;
+    }
+    struct asn1der_request_t req = {.obj_id = obj_id, .buf = buf, .buf_len = buf_len, .crop_kind = crop_kind};
+
+    return find_objects(stream, len, &req, 1, stop_found);
+}
+
+lt_ret_t asn1der_find_object(const uint8_t *stream, uint16_t len, int32_t obj_id, uint8_t *buf, int buf_len,
+                             enum asn1der_crop_kind_t crop_kind)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_ASN1DER_FIND);
+
+    return find_object(stream, len, obj_id, buf, buf_len, crop_kind, false);
+}
+
+lt_ret_t asn1der_find_object_prefix(const uint8_t *stream, uint16_t len, int32_t obj_id, uint8_t *buf, int buf_len,
+                                    enum asn1der_crop_kind_t crop_kind)
+{
+    return find_object(stream, len, obj_id, buf, buf_len, crop_kind, true);
+}
+
+lt_ret_t asn1der_find_objects(const uint8_t *stream, uint16_t len, struct asn1der_request_t *reqs, uint8_t cnt)
+{
+    if (!stream || !reqs || !cnt || (cnt > ASN1DER_REQUESTS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        if ((reqs[i].buf_len < 0) || (!reqs[i].buf && reqs[i].buf_len)) {
+            return LT_PARAM_ERR;
+        }
+        reqs[i].offset = 0;
+        reqs[i].len = 0;
+    }
+
+    return find_objects(stream, len, reqs, cnt, false);
+}
+
+/*******************************************************************************
+ * Push-style parser
+ *******************************************************************************/
+
+/** Parts of ASN1 object expected by the push-style parser */
+enum asn1der_stream_state_t { ASN1DER_STREAM_TAG, ASN1DER_STREAM_LEN, ASN1DER_STREAM_LEN_EXT, ASN1DER_STREAM_VALUE };
+
+/** Tells whether value of object of type "tag" can be sampled, same types as in `parse_object()` */
+static bool stream_tag_sampled(uint8_t tag)
+{
+    switch (tag) {
+        case ASN1DER_BOOLEAN:
+        case ASN1DER_INTEGER:
+        case ASN1DER_STRING_BIT:
+        case ASN1DER_STRING_OCTET:
+        case ASN1DER_STRING_NULL:
+        case ASN1DER_STRING_UTF8:
+        case ASN1DER_STRING_PRINTABLE:
+        case ASN1DER_UTC_TIME:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Closes SEQUENCEs ending at current position */
+static void stream_close(struct asn1der_stream_t *s, uint16_t end)
+{
+    s->state = ASN1DER_STREAM_TAG;
+    while (s->depth && (s->ends[s->depth - 1] == end)) {
+        s->depth--;
+    }
+}
+
+/** Finishes value of the current object, which ends at "end" */
+static void stream_value_end(struct asn1der_stream_t *s, uint16_t end)
+{
+    if ((s->tag == ASN1DER_OBJECT_IDENTIFIER) && (s->len >= 3)) {
+        for (uint8_t i = 0; i < s->cnt; i++) {
+            if (s->reqs[i].obj_id == (int32_t)s->obj_id) {
+                s->sample_next |= 1u << i;
+            }
+        }
+    }
+    s->found |= s->sampling;
+    s->sample_next &= ~s->sampling;
+    s->sampling = 0;
+
+    stream_close(s, end);
+}
+
+/** Starts value of the current object, its length was just received and the value starts at "start" */
+static lt_ret_t stream_value_start(struct asn1der_stream_t *s, uint16_t start)
+{
+    uint32_t end = (uint32_t)start + s->len;
+    if ((end > UINT16_MAX) || (s->depth && (end > s->ends[s->depth - 1]))) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    if (s->tag == ASN1DER_SEQUENCE) {
+        if (s->depth == ASN1DER_STREAM_DEPTH_MAX) {
+            return LT_CERT_UNSUPPORTED;
+        }
+        s->ends[s->depth++] = end;
+        s->state = ASN1DER_STREAM_TAG;
+        if (s->len == 0) {
+            stream_close(s, end);
+        }
+        return LT_OK;
+    }
+
+    s->obj_id = 0;
+    s->value_pos = 0;
+    s->sampling = stream_tag_sampled(s->tag) ? (s->sample_next & ~s->found) : 0;
+    for (uint8_t i = 0; i < s->cnt; i++) {
+        if (s->sampling & (1u << i)) {
+            s->reqs[i].offset = start;
+            s->reqs[i].len = s->len;
+        }
+    }
+
+    if (s->len == 0) {
+        stream_value_end(s, end);
+    }
+    else {
+        s->state = ASN1DER_STREAM_VALUE;
+    }
+
+    return LT_OK;
+}
+
+/** Processes next byte of the current value */
+static void stream_value_byte(struct asn1der_stream_t *s, uint8_t b)
+{
+    if ((s->tag == ASN1DER_OBJECT_IDENTIFIER) && (s->value_pos < 3)) {
+        s->obj_id = (s->obj_id << 8) | b;
+    }
+
+    for (uint8_t i = 0; s->sampling && (i < s->cnt); i++) {
+        struct asn1der_request_t *req = &s->reqs[i];
+        if (!(s->sampling & (1u << i)) || !req->buf) {
+            continue;
+        }
+        uint16_t skip = 0;
+        if ((req->buf_len < s->len) && (req->crop_kind == ASN1DER_CROP_PREFIX)) {
+            skip = s->len - req->buf_len;
+        }
+        if ((s->value_pos >= skip) && (s->value_pos - skip < req->buf_len)) {
+            req->buf[s->value_pos - skip] = b;
+        }
+    }
+
+    if (++s->value_pos == s->len) {
+        stream_value_end(s, s->past + 1);
+    }
+}
+
+lt_ret_t asn1der_stream_init(struct asn1der_stream_t *s, struct asn1der_request_t *reqs, uint8_t cnt)
+{
+    if (!s || !reqs || !cnt || (cnt > ASN1DER_REQUESTS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        if ((reqs[i].buf_len < 0) || (!reqs[i].buf && reqs[i].buf_len)) {
+            return LT_PARAM_ERR;
+        }
+        reqs[i].offset = 0;
+        reqs[i].len = 0;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->reqs = reqs;
+    s->cnt = cnt;
+    s->state = ASN1DER_STREAM_TAG;
+
+    return LT_OK;
+}
+
+lt_ret_t asn1der_stream_feed(struct asn1der_stream_t *s, const uint8_t *data, uint16_t len)
+{
+    if (!s || (!data && len) || ((uint32_t)s->past + len > UINT16_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    for (uint16_t i = 0; i < len; i++, s->past++) {
+        uint8_t b = data[i];
+        lt_ret_t rv = LT_OK;
+
+        switch (s->state) {
+            case ASN1DER_STREAM_TAG:
+                s->tag = b;
+                s->state = ASN1DER_STREAM_LEN;
+                break;
+
+            case ASN1DER_STREAM_LEN:
+                if (b < 0x80) {
+                    s->len = b;
+                    rv = stream_value_start(s, s->past + 1);
+                }
+                else {
+                    s->len_bytes = b & 0x7f;
+                    if ((s->len_bytes == 0) || (s->len_bytes > 2)) {
+                        return LT_CERT_UNSUPPORTED;
+                    }
+                    s->len = 0;
+                    s->state = ASN1DER_STREAM_LEN_EXT;
+                }
+                break;
+
+            case ASN1DER_STREAM_LEN_EXT:
+                s->len = (s->len << 8) | b;
+                if (--s->len_bytes == 0) {
+                    rv = stream_value_start(s, s->past + 1);
+                }
+                break;
+
+            default:
+                stream_value_byte(s, b);
+                break;
+        }
+
+        if (rv != LT_OK) {
+            return rv;
+        }
+    }
+
+    return LT_OK;
+}
+
+bool asn1der_stream_all_found(const struct asn1der_stream_t *s) { return ALL_FOUND(s); }
+
+bool asn1der_stream_complete(const struct asn1der_stream_t *s)
+{
+    return (s->state == ASN1DER_STREAM_TAG) && (s->depth == 0);
+}
+
+lt_ret_t asn1der_tlv(const uint8_t *stream, uint16_t len, uint8_t *tag, uint16_t *hdr_len, uint16_t *value_len)
+{
+    if (len < 2) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    *tag = stream[0];
+    *hdr_len = 2;
+    *value_len = stream[1];
+    if (stream[1] >= 0x80) {
+        uint8_t n_bytes = stream[1] & 0x7f;
+        if ((n_bytes == 0) || (n_bytes > 2)) {
+            return LT_CERT_UNSUPPORTED;
+        }
+        if (len < 2 + n_bytes) {
+            return LT_CERT_STORE_INVALID;
+        }
+        *value_len = 0;
+        for (uint8_t i = 0; i < n_bytes; i++) {
+            *value_len = (*value_len << 8) | stream[2 + i];
+        }
+        *hdr_len += n_bytes;
+    }
+
+    if ((uint32_t)*hdr_len + *value_len > len) {
+        return LT_CERT_STORE_INVALID;
+    }
 
     return LT_OK;
 }
@@ -9,6 +9,8 @@
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
+#include <stdbool.h>
+
 #include "libtropic_common.h"
 
 enum asn1der_obj_kind_t {
@@ -28,6 +30,44 @@ enum asn1der_crop_kind_t { ASN1DER_CROP_SUFFIX, ASN1DER_CROP_PREFIX };
 
 #define OBJ_ID_CURVEX25519 0x2B656E
 
+/** Maximal number of requests of `asn1der_find_objects()` */
+#define ASN1DER_REQUESTS_MAX 32
+
+/**
+ * @brief One object searched by `asn1der_find_objects()`
+ */
+struct asn1der_request_t {
+    int32_t obj_id;                     /** 3-byte OBJECT_IDENTIFIER to be searched for */
+    uint8_t *buf;                       /** Buffer where to copy the found object value, NULL to only locate it */
+    int buf_len;                        /** Size of the buffer pointed to by "buf" */
+    enum asn1der_crop_kind_t crop_kind; /** Same as in `asn1der_find_object()` */
+    uint16_t offset;                    /** Output: offset of the (uncropped) value in the stream */
+    uint16_t len;                       /** Output: length of the (uncropped) value, 0 if not found */
+};
+
+/** Maximal depth of nested SEQUENCEs supported by `struct asn1der_stream_t` */
+#define ASN1DER_STREAM_DEPTH_MAX 8
+
+/**
+ * @brief Context of push-style parser fed by parts of the stream, see `asn1der_stream_feed()`
+ */
+struct asn1der_stream_t {
+    struct asn1der_request_t *reqs;            /** Searched objects */
+    uint8_t cnt;                               /** Number of searched objects */
+    uint8_t state;                             /** Part of the object expected in the next byte */
+    uint8_t tag;                               /** Type of the current object */
+    uint8_t len_bytes;                         /** Bytes of long form length still to be received */
+    uint16_t len;                              /** Length of the current object */
+    uint16_t value_pos;                        /** Bytes of the current value received so far */
+    uint16_t past;                             /** Number of bytes received so far */
+    uint16_t ends[ASN1DER_STREAM_DEPTH_MAX];   /** End offsets of the open SEQUENCEs */
+    uint8_t depth;                             /** Number of open SEQUENCEs */
+    uint32_t obj_id;                           /** First 3 bytes of the current OBJECT_IDENTIFIER */
+    uint32_t sample_next;                      /** Bit per request, next primitive object is to be sampled */
+    uint32_t sampling;                         /** Bit per request, the current object is being sampled */
+    uint32_t found;                            /** Bit per request, object was found */
+};
+
 /**
  * @brief Parse ASN1 DER encoded stream and find certain OBJECT. Return data from primitve type
  *        right after the OBJECT_IDENTIFIER. If multiple objects of the searched OBJECT_KIND are
@@ -51,4 +91,94 @@ enum asn1der_crop_kind_t { ASN1DER_CROP_SUFFIX, ASN1DER_CROP_PREFIX };
 lt_ret_t asn1der_find_object(const uint8_t *stream, uint16_t len, int32_t obj_id, uint8_t *buf, int buf_len,
                              enum asn1der_crop_kind_t crop_kind) __attribute__((warn_unused_result));
 
-#endif
\ No newline at end of file
+/**
+ * @brief Same as `asn1der_find_object()`, but parsing stops as soon as the object is found, so the stream can be
+ *        only the beginning of the certificate (e.g. the part received so far).
+ *
+ * @param stream        Byte stream with (beginning of) X509 certificate to be parsed
+ * @param len           Length of the byte-stream
+ * @param obj_id        3-byte OBJECT_IDENTIFIER to be searched for
+ * @param buf           Buffer where to copy the found object value
+ * @param buf_len       Size of the buffer pointed to by "buf"
+ * @param crop_kind     Same as in `asn1der_find_object()`
+ * @return lt_ret_t     LT_OK if the object was found, otherwise the same error as `asn1der_find_object()` returns
+ *                      for the stream; LT_CERT_STORE_INVALID is also returned when the object might be found
+ *                      in the rest of the certificate
+ */
+lt_ret_t asn1der_find_object_prefix(const uint8_t *stream, uint16_t len, int32_t obj_id, uint8_t *buf, int buf_len,
+                                    enum asn1der_crop_kind_t crop_kind);
+
+/**
+ * @brief Same as `asn1der_find_object()` for several objects at once, the stream is parsed only once.
+ *        Each request is filled by its value (if "buf" is not NULL) and by its position in the stream, so with
+ *        NULL "buf" the value can be used in place without copying.
+ *
+ * @param stream        Byte stream with X509 certificate to be parsed
+ * @param len           Length of the certificate in the byte-stream
+ * @param reqs          Searched objects, several requests may search for the same OBJECT_IDENTIFIER
+ * @param cnt           Number of requests, at most ASN1DER_REQUESTS_MAX
+ * @return lt_ret_t     LT_OK if all objects were found
+ *                      LT_PARAM_ERR if the parameters are invalid
+ *                      LT_CERT_ITEM_NOT_FOUND if some object was not found, the found ones are filled anyway
+ *                      other errors as `asn1der_find_object()`
+ */
+lt_ret_t asn1der_find_objects(const uint8_t *stream, uint16_t len, struct asn1der_request_t *reqs, uint8_t cnt)
+    __attribute__((warn_unused_result));
+
+/**
+ * @brief Initializes push-style parser searching for the same objects as `asn1der_find_objects()`
+ *
+ * @param s             Parser context
+ * @param reqs          Searched objects, they are filled as soon as their values are received
+ * @param cnt           Number of requests, at most ASN1DER_REQUESTS_MAX
+ * @return lt_ret_t     LT_OK if successful, LT_PARAM_ERR if the parameters are invalid
+ */
+lt_ret_t asn1der_stream_init(struct asn1der_stream_t *s, struct asn1der_request_t *reqs, uint8_t cnt)
+    __attribute__((warn_unused_result));
+
+/**
+ * @brief Parses next part of the stream, e.g. a block of certificate received from TROPIC01. Parts do not have to
+ *        be kept, the values are copied into the buffers of the requests while they are received.
+ *
+ * @param s             Parser context
+ * @param data          Next part of the stream
+ * @param len           Length of the part
+ * @return lt_ret_t     LT_OK if the part was parsed, check `asn1der_stream_all_found()` to stop feeding
+ *                      LT_CERT_STORE_INVALID if the stream does not contain valid ASN1 syntax
+ *                      LT_CERT_UNSUPPORTED if the ASN1 stream contains features unsupported by this parser
+ */
+lt_ret_t asn1der_stream_feed(struct asn1der_stream_t *s, const uint8_t *data, uint16_t len)
+    __attribute__((warn_unused_result));
+
+/**
+ * @brief Tells whether all searched objects were found
+ *
+ * @param s             Parser context
+ * @return bool         true if all requests were filled
+ */
+bool asn1der_stream_all_found(const struct asn1der_stream_t *s);
+
+/**
+ * @brief Tells whether the bytes fed so far form complete objects (no SEQUENCE or value is unfinished)
+ *
+ * @param s             Parser context
+ * @return bool         true if the stream can end here
+ */
+bool asn1der_stream_complete(const struct asn1der_stream_t *s);
+
+/**
+ * @brief Reads type and length of the ASN1 DER object at the beginning of the stream
+ *
+ * @param stream        Byte stream
+ * @param len           Length of the byte-stream
+ * @param tag           Type of the object
+ * @param hdr_len       Length of the type and length bytes, the value follows them
+ * @param value_len     Length of the value, the whole value is within the stream
+ * @return lt_ret_t     LT_OK if successful
+ *                      LT_CERT_STORE_INVALID if the object is not complete
+ *                      LT_CERT_UNSUPPORTED if the length is encoded in more than 2 bytes
+ */
+lt_ret_t asn1der_tlv(const uint8_t *stream, uint16_t len, uint8_t *tag, uint16_t *hdr_len, uint16_t *value_len)
+    __attribute__((warn_unused_result));
+
+#endif
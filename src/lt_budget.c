@@ -0,0 +1,371 @@
+/**
+ * @file lt_budget.c
+ * @brief Time budget definitions
+ * @author Tropic Square s.r.o.
+ *
+ * Each read of a response is simulated poll by poll with the schedule `lt_l1_read()` would use, so the budget follows
+ * the profiles, their rounding to whole miliseconds and the poll limits without a closed formula for each of them.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_budget.h"
+#include "libtropic_common.h"
+#include "libtropic_l2.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+#include "lt_l1.h"
+#include "lt_l2_api_structs.h"
+#include "lt_l3_cmd_desc.h"
+
+/** Response which is never ready, its read ends by the poll limit */
+#define LT_BUDGET_NEVER UINT32_MAX
+/** Bytes of a written frame besides its data: REQ_ID, REQ_LEN and CRC */
+#define LT_BUDGET_REQ_OVERHEAD 4u
+/** Bytes read by the poll of CHIP_STATUS: CHIP_STATUS, STATUS and RSP_LEN */
+#define LT_BUDGET_POLL_SIZE 3u
+/** Bytes of CRC read after data of a response */
+#define LT_BUDGET_CRC_SIZE 2u
+
+/** Figures of `lt_budget_t`, computed by `lt_budget_cmd()` */
+#define LT_BUDGET_EXPECTED 0
+#define LT_BUDGET_READY_WORST 1
+#define LT_BUDGET_BOUND 2
+
+/** Number of L2 frames carrying `size` bytes of L3 packet */
+#define LT_BUDGET_CHUNKS(size) (((size) + L2_CHUNK_MAX_DATA_SIZE - 1) / L2_CHUNK_MAX_DATA_SIZE)
+
+/** Conditions under which one figure of the budget is computed */
+typedef struct lt_budget_case_t {
+    /** SPI clock in Hz */
+    uint32_t hz;
+    /** Time of one SPI transfer besides its bytes */
+    uint32_t transfer_us;
+    /** Time by which each delay overruns its length */
+    uint32_t oversleep_us;
+    /** A poll at the same time as the response gets ready does not find it yet */
+    uint8_t late;
+} lt_budget_case_t;
+
+/** Times after which a response is ready, from the start of its read */
+typedef struct lt_budget_ready_t {
+    uint32_t expected_us;
+    uint32_t worst_us;
+} lt_budget_ready_t;
+
+static uint64_t lt_budget_transfer(const lt_budget_case_t *c, const uint32_t bytes)
+{
+    return c->transfer_us + ((((uint64_t)bytes * 8u * 1000000u) + c->hz - 1) / c->hz);
+}
+
+/** Duration of a delay requested from the port */
+static uint64_t lt_budget_delay(const lt_budget_case_t *c, const uint32_t us)
+{
+    if (!us) {
+        return 0;
+    }
+#if LT_USE_DELAY_US
+    return (uint64_t)us + c->oversleep_us;
+#else
+    return ((uint64_t)LT_US_TO_MS_CEIL(us) * 1000u) + c->oversleep_us;
+#endif
+}
+
+/** Number of response bytes read together with CHIP_STATUS, see `lt_l1_spec_len_get()` */
+static uint16_t lt_budget_spec_len(const lt_handle_t *h, const uint16_t poll_cmd)
+{
+#if LT_SPECULATIVE_READ
+    uint16_t spec_len = h->l2.spec_len;
+    if (spec_len == LT_L1_SPEC_LEN_AUTO) {
+#if LT_ADAPTIVE_POLLING
+        for (size_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+            if ((h->l2.poll.stats[i].cmd == poll_cmd) && h->l2.poll.stats[i].cnt) {
+                spec_len = h->l2.poll.stats[i].len_max;
+                break;
+            }
+        }
+#endif
+    }
+    return (spec_len > (LT_L1_LEN_MAX - LT_BUDGET_POLL_SIZE)) ? (LT_L1_LEN_MAX - LT_BUDGET_POLL_SIZE) : spec_len;
+#else
+    UNUSED(h);
+    UNUSED(poll_cmd);
+    return 0;
+#endif
+}
+
+#if LT_ADAPTIVE_POLLING
+static const lt_l1_poll_stats_t *lt_budget_poll_stats(const lt_handle_t *h, const uint16_t poll_cmd)
+{
+    for (size_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+        if ((h->l2.poll.stats[i].cmd == poll_cmd) && h->l2.poll.stats[i].cnt) {
+            return &h->l2.poll.stats[i];
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+/** Times after which TROPIC01 has the response ready, learned ones when there are any, otherwise `default_us` */
+static void lt_budget_ready_get(const lt_handle_t *h, const uint16_t poll_cmd, const uint32_t default_us,
+                                lt_budget_ready_t *ready)
+{
+    ready->expected_us = default_us;
+    ready->worst_us = default_us;
+#if LT_ADAPTIVE_POLLING
+    // Waits learned by polling include the gap after readiness, so they do not underestimate it
+    const lt_l1_poll_stats_t *stats = lt_budget_poll_stats(h, poll_cmd);
+    if (stats) {
+        ready->expected_us = stats->avg_us;
+        if (stats->max_us > ready->worst_us) {
+            ready->worst_us = stats->max_us;
+        }
+    }
+#else
+    UNUSED(h);
+    UNUSED(poll_cmd);
+#endif
+}
+
+/**
+ * Duration of a read of response with `len` bytes of data, which is ready after `ready_us`, see `lt_l1_read()`.
+ * Response that is never ready is waited for until the poll limit, then it is taken as read by the last poll.
+ */
+static uint64_t lt_budget_read(const lt_handle_t *h, const lt_budget_case_t *c, const uint16_t poll_cmd,
+                               uint32_t ready_us, const uint16_t len)
+{
+    const uint16_t spec_len = lt_budget_spec_len(h, poll_cmd);
+    const uint64_t poll_us = lt_budget_transfer(c, LT_BUDGET_POLL_SIZE + spec_len);
+    const uint32_t rest = ((len + LT_BUDGET_CRC_SIZE) > spec_len) ? (len + LT_BUDGET_CRC_SIZE - spec_len) : 0;
+    const uint64_t rest_us = rest ? lt_budget_transfer(c, rest) : 0;
+    uint64_t t = 0;
+    uint32_t polls = 0;
+#if LT_ADAPTIVE_POLLING
+    uint32_t waited_us = 0;
+    lt_l1_poll_profile_t profile;
+    lt_l1_poll_profile_get(&h->l2, poll_cmd, &profile);
+    const lt_l1_poll_stats_t *stats = lt_budget_poll_stats(h, poll_cmd);
+    uint32_t first_us = profile.first_delay_us;
+    if (h->l2.poll.learn && stats && (stats->min_us > first_us)) {
+        first_us = stats->min_us;
+    }
+    uint32_t delay_us = profile.retry_delay_us;
+    t = lt_budget_delay(c, first_us);
+    waited_us = first_us;
+#endif
+#if LT_USE_INT_PIN
+    const bool int_pin = (h->l2.mode == LT_MODE_APP);
+#endif
+
+    for (;;) {
+#if LT_ADAPTIVE_POLLING
+        if ((waited_us >= (LT_L1_READ_MAX_TRIES * LT_L1_READ_RETRY_DELAY * 1000))
+            || (polls >= (LT_L1_READ_MAX_TRIES * LT_L1_READ_RETRY_DELAY))) {
+            // The last poll given up would have read the response
+            return t + rest_us;
+        }
+#else
+        if (polls >= LT_L1_READ_MAX_TRIES) {
+            return t + rest_us;
+        }
+#endif
+        polls++;
+        bool found = (ready_us != LT_BUDGET_NEVER) && (c->late ? (t > ready_us) : (t >= ready_us));
+        t += poll_us;
+        if (found) {
+            return t + rest_us;
+        }
+
+#if LT_USE_INT_PIN
+        if (int_pin) {
+            // INT pin comes when the response is ready, waiting for it is not counted in the poll limit
+            t = (ready_us == LT_BUDGET_NEVER) ? (t + (LT_L1_TIMEOUT_MS_MAX * 1000u))
+                                              : (((t > ready_us) ? t : ready_us) + c->oversleep_us);
+            ready_us = 0;
+            continue;
+        }
+#endif
+#if LT_ADAPTIVE_POLLING
+        // Exponential backoff, see `lt_l1_poll_next()`
+        uint32_t gap_us = delay_us ? delay_us : LT_L1_READ_RETRY_DELAY_US_MIN;
+        delay_us = ((gap_us * 2) > profile.max_delay_us) ? profile.max_delay_us : (gap_us * 2);
+        waited_us += gap_us;
+#else
+        uint32_t gap_us = LT_L1_READ_RETRY_DELAY * 1000;
+#endif
+        t += lt_budget_delay(c, gap_us);
+    }
+}
+
+/** Duration of the call under conditions `c`, one of LT_BUDGET_* figures, each chunk sent `retries` times again */
+static uint64_t lt_budget_cmd(const lt_handle_t *h, const lt_budget_case_t *c, const uint8_t figure,
+                              const uint8_t cmd_id, const uint16_t cmd_len, const uint16_t res_len,
+                              const uint8_t retries, const lt_budget_ready_t *exec)
+{
+#if LT_ADAPTIVE_POLLING
+    const uint16_t chunk_cmd = LT_L1_POLL_CMD_L3_CHUNK;
+    const uint16_t first_cmd = LT_L1_POLL_CMD_L3(cmd_id);
+    const uint16_t next_cmd = LT_L1_POLL_CMD_L2(LT_L2_ENCRYPTED_CMD_REQ_ID);
+#else
+    const uint16_t chunk_cmd = 0, first_cmd = 0, next_cmd = 0;
+    UNUSED(cmd_id);
+#endif
+    lt_budget_ready_t ack, next;
+    lt_budget_ready_get(h, chunk_cmd, 0, &ack);
+    lt_budget_ready_get(h, next_cmd, 0, &next);
+    uint32_t ack_us = (figure == LT_BUDGET_EXPECTED) ? ack.expected_us : ack.worst_us;
+    uint32_t exec_us = (figure == LT_BUDGET_EXPECTED) ? exec->expected_us : exec->worst_us;
+    uint32_t next_us = (figure == LT_BUDGET_EXPECTED) ? next.expected_us : next.worst_us;
+    // Responses sent again are ready at once
+    uint32_t resent_us = 0;
+    if (figure == LT_BUDGET_BOUND) {
+        ack_us = exec_us = next_us = resent_us = LT_BUDGET_NEVER;
+    }
+    uint64_t t = 0;
+
+    const uint32_t cmd_size = LT_L3_PACKET_SIZE((uint32_t)cmd_len);
+    for (uint32_t off = 0; off < cmd_size; off += L2_CHUNK_MAX_DATA_SIZE) {
+        const uint32_t len = ((cmd_size - off) < L2_CHUNK_MAX_DATA_SIZE) ? (cmd_size - off) : L2_CHUNK_MAX_DATA_SIZE;
+        // The chunk itself is sent again, which takes longer than Resend_Req of its acknowledgment
+        const uint64_t chunk_us
+            = lt_budget_transfer(c, len + LT_BUDGET_REQ_OVERHEAD) + lt_budget_read(h, c, chunk_cmd, ack_us, 0);
+        t += (1u + retries) * chunk_us;
+    }
+
+    const uint32_t res_size = LT_L3_PACKET_SIZE((uint32_t)res_len);
+    const uint64_t resend_us = lt_budget_transfer(c, LT_L2_RESEND_REQ_LEN + LT_BUDGET_REQ_OVERHEAD);
+    for (uint32_t off = 0; off < res_size; off += L2_CHUNK_MAX_DATA_SIZE) {
+        const uint16_t len
+            = (uint16_t)(((res_size - off) < L2_CHUNK_MAX_DATA_SIZE) ? (res_size - off) : L2_CHUNK_MAX_DATA_SIZE);
+        // Only the first chunk is delayed by the execution, a chunk requested again is polled with the same profile
+        const uint16_t poll_cmd = off ? next_cmd : first_cmd;
+        t += lt_budget_read(h, c, poll_cmd, off ? next_us : exec_us, len);
+        t += retries * (resend_us + lt_budget_read(h, c, poll_cmd, resent_us, len));
+    }
+
+    return t;
+}
+
+/** Times of host encryption and decryption of the command measured in `h->l2.stats` */
+static void lt_budget_crypto(const lt_handle_t *h, const uint8_t cmd_id, uint64_t *expected_us, uint64_t *worst_us)
+{
+    *expected_us = 0;
+    *worst_us = 0;
+#if LT_STATS
+    if (!h->l2.stats) {
+        return;
+    }
+    for (size_t i = 0; i < LT_STATS_CNT; i++) {
+        const lt_stats_entry_t *e = &h->l2.stats->entries[i];
+        if ((e->key == LT_STATS_KEY_L3(cmd_id)) && e->cnt) {
+            *expected_us = e->time[LT_STATS_CRYPTO].total_us / e->cnt;
+            // The command is encrypted and its result decrypted
+            *worst_us = 2ull * e->time[LT_STATS_CRYPTO].max_us;
+            return;
+        }
+    }
+#else
+    UNUSED(h);
+    UNUSED(cmd_id);
+#endif
+}
+
+static uint32_t lt_budget_sat(const uint64_t us)
+{
+    return (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+}
+
+static lt_ret_t lt_budget_compute(lt_handle_t *h, const lt_budget_port_t *port, const lt_l3_cmd_desc_t *desc,
+                                  const uint16_t cmd_len, const uint16_t res_len, lt_budget_t *budget)
+{
+    lt_budget_case_t expected = {.hz = port->spi_hz, .transfer_us = port->transfer_us, .late = 0};
+    lt_budget_case_t worst = {.hz = port->spi_hz,
+                              .transfer_us = port->transfer_max_us ? port->transfer_max_us : port->transfer_us,
+                              .oversleep_us = port->oversleep_max_us,
+                              .late = 1};
+#if LT_USE_SPI_SPEED
+    if (!port->spi_hz && h->l2.spi_tune) {
+        // The tuner may lower the clock down to its minimum on errors
+        expected.hz = h->l2.spi_tune->hz;
+        worst.hz = h->l2.spi_tune->min_hz ? h->l2.spi_tune->min_hz : h->l2.spi_tune->hz;
+    }
+#endif
+    if (!expected.hz || !worst.hz) {
+        return LT_PARAM_ERR;
+    }
+#if LT_STATS
+    if (h->l2.stats && h->l2.stats->delays) {
+        expected.oversleep_us = (uint32_t)(h->l2.stats->oversleep.total_us / h->l2.stats->delays);
+        if (!port->oversleep_max_us) {
+            worst.oversleep_us = h->l2.stats->oversleep.max_us;
+        }
+    }
+#endif
+
+    lt_budget_ready_t exec;
+#if LT_ADAPTIVE_POLLING
+    lt_budget_ready_get(h, LT_L1_POLL_CMD_L3(desc->cmd_id), desc->exec_us, &exec);
+#else
+    lt_budget_ready_get(h, 0, desc->exec_us, &exec);
+#endif
+    if (exec.expected_us > exec.worst_us) {
+        exec.worst_us = exec.expected_us;
+    }
+    if (desc->exec_us > exec.worst_us) {
+        exec.worst_us = desc->exec_us;
+    }
+
+    const uint8_t retries = lt_l2_chunk_retries(&h->l2);
+    uint64_t crypto_us, crypto_max_us;
+    lt_budget_crypto(h, desc->cmd_id, &crypto_us, &crypto_max_us);
+
+    budget->expected_us = lt_budget_sat(
+        lt_budget_cmd(h, &expected, LT_BUDGET_EXPECTED, desc->cmd_id, cmd_len, res_len, 0, &exec) + crypto_us);
+    budget->ready_worst_us = lt_budget_sat(
+        lt_budget_cmd(h, &worst, LT_BUDGET_READY_WORST, desc->cmd_id, cmd_len, res_len, retries, &exec)
+        + crypto_max_us);
+    // One transfer may take its whole timeout before it fails and the call returns
+    budget->worst_us
+        = lt_budget_sat(lt_budget_cmd(h, &worst, LT_BUDGET_BOUND, desc->cmd_id, cmd_len, res_len, retries, &exec)
+                        + crypto_max_us + (LT_L1_TIMEOUT_MS_DEFAULT * 1000u));
+
+    const uint32_t cmd_chunks = LT_BUDGET_CHUNKS(LT_L3_PACKET_SIZE((uint32_t)cmd_len));
+    const uint32_t res_chunks = LT_BUDGET_CHUNKS(LT_L3_PACKET_SIZE((uint32_t)res_len));
+    const uint32_t frames = (2 * cmd_chunks) + res_chunks;
+    const uint32_t frames_max = frames + (2u * retries * (cmd_chunks + res_chunks));
+    budget->frames = (uint16_t)frames;
+    budget->frames_max = (frames_max > UINT16_MAX) ? UINT16_MAX : (uint16_t)frames_max;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_budget_l3(lt_handle_t *h, const lt_budget_port_t *port, const uint8_t cmd_id, const uint16_t cmd_len,
+                      const uint16_t res_len, lt_budget_t *budget)
+{
+    static const lt_budget_port_t port_none = {0};
+    const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(cmd_id);
+
+    if (!h || !budget || !desc || (cmd_len < desc->cmd_size_min) || (cmd_len > desc->cmd_size_max)
+        || (res_len > desc->res_size_max)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(budget, 0, sizeof(*budget));
+#if LT_THREAD_SAFE
+    // Profiles and statistics of the handle are read consistently
+    lt_port_lock(&h->l2);
+#endif
+    lt_ret_t ret = lt_budget_compute(h, port ? port : &port_none, desc, cmd_len, res_len ? res_len : desc->res_size_max,
+                                     budget);
+#if LT_THREAD_SAFE
+    lt_port_unlock(&h->l2);
+#endif
+
+    return ret;
+}
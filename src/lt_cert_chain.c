@@ -0,0 +1,379 @@
+/**
+ * @file lt_cert_chain.c
+ * @brief Certificate chain verification definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_cert_chain.h"
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "lt_asn1_der.h"
+#include "lt_ecdsa.h"
+#include "lt_ed25519.h"
+#include "lt_sha256.h"
+
+/** Parts of certificate needed for the chain verification, pointing into the certificate */
+struct lt_cert_view_t {
+    const uint8_t *tbs;
+    uint16_t tbs_len;
+    const uint8_t *issuer;
+    uint16_t issuer_len;
+    const uint8_t *subject;
+    uint16_t subject_len;
+    const uint8_t *spki;
+    uint16_t spki_len;
+    lt_cert_sig_alg_t alg;
+    const uint8_t *sig;
+    uint16_t sig_len;
+};
+
+/** Signature algorithm OIDs, indexed by lt_cert_sig_alg_t */
+static const struct {
+    uint8_t len;
+    uint8_t oid[8];
+} lt_cert_sig_oids[] = {
+    [LT_CERT_SIG_ECDSA_SHA256] = {8, {0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02}},
+    [LT_CERT_SIG_ECDSA_SHA384] = {8, {0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x03}},
+    [LT_CERT_SIG_ECDSA_SHA512] = {8, {0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x04}},
+    [LT_CERT_SIG_ED25519] = {3, {0x2b, 0x65, 0x70}},
+};
+
+/** OID of id-ecPublicKey followed by OID of prime256v1, content of AlgorithmIdentifier of P-256 key */
+static const uint8_t lt_cert_p256_alg[] = {0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01, 0x06, 0x08,
+                                           0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07};
+/** OID of Ed25519, content of AlgorithmIdentifier of Ed25519 key */
+static const uint8_t lt_cert_ed25519_alg[] = {0x06, 0x03, 0x2b, 0x65, 0x70};
+
+/**
+ * Takes next object of type `tag` from `*p` (up to `end`), `obj` spans the whole object, `val` its value.
+ * Both outputs can be NULL.
+ */
+static lt_ret_t lt_cert_next(const uint8_t **p, const uint8_t *end, const uint8_t tag, const uint8_t **obj,
+                             uint16_t *obj_len, const uint8_t **val, uint16_t *val_len)
+{
+    uint8_t t;
+    uint16_t hdr_len, len;
+    lt_ret_t ret = asn1der_tlv(*p, end - *p, &t, &hdr_len, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (t != tag) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    if (obj) {
+        *obj = *p;
+        *obj_len = hdr_len + len;
+    }
+    if (val) {
+        *val = *p + hdr_len;
+        *val_len = len;
+    }
+    *p += hdr_len + len;
+
+    return LT_OK;
+}
+
+/** Locates parts of X.509 certificate */
+static lt_ret_t lt_cert_parse(const uint8_t *cert, const uint16_t cert_len, struct lt_cert_view_t *v)
+{
+    const uint8_t *p = cert;
+    const uint8_t *val;
+    uint16_t len;
+
+    // Certificate ::= SEQUENCE { tbsCertificate, signatureAlgorithm, signatureValue }
+    lt_ret_t ret = lt_cert_next(&p, cert + cert_len, ASN1DER_SEQUENCE, NULL, NULL, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    const uint8_t *end = val + len;
+    p = val;
+
+    ret = lt_cert_next(&p, end, ASN1DER_SEQUENCE, &v->tbs, &v->tbs_len, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // TBSCertificate ::= SEQUENCE { [0] version, serialNumber, signature, issuer, validity, subject, spki, ... }
+    const uint8_t *q = val;
+    const uint8_t *tbs_end = val + len;
+    if ((q < tbs_end) && (*q == 0xa0)) {
+        ret = lt_cert_next(&q, tbs_end, 0xa0, NULL, NULL, NULL, NULL);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+    ret = lt_cert_next(&q, tbs_end, ASN1DER_INTEGER, NULL, NULL, NULL, NULL);
+    if (ret == LT_OK) ret = lt_cert_next(&q, tbs_end, ASN1DER_SEQUENCE, NULL, NULL, NULL, NULL);
+    if (ret == LT_OK) ret = lt_cert_next(&q, tbs_end, ASN1DER_SEQUENCE, &v->issuer, &v->issuer_len, NULL, NULL);
+    if (ret == LT_OK) ret = lt_cert_next(&q, tbs_end, ASN1DER_SEQUENCE, NULL, NULL, NULL, NULL);
+    if (ret == LT_OK) ret = lt_cert_next(&q, tbs_end, ASN1DER_SEQUENCE, &v->subject, &v->subject_len, NULL, NULL);
+    if (ret == LT_OK) ret = lt_cert_next(&q, tbs_end, ASN1DER_SEQUENCE, &v->spki, &v->spki_len, NULL, NULL);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // AlgorithmIdentifier ::= SEQUENCE { algorithm OBJECT IDENTIFIER, parameters OPTIONAL }
+    const uint8_t *alg;
+    uint16_t alg_len;
+    ret = lt_cert_next(&p, end, ASN1DER_SEQUENCE, NULL, NULL, &alg, &alg_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    ret = lt_cert_next(&alg, alg + alg_len, ASN1DER_OBJECT_IDENTIFIER, NULL, NULL, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    ret = LT_CERT_UNSUPPORTED;
+    for (uint8_t i = 0; i < sizeof(lt_cert_sig_oids) / sizeof(lt_cert_sig_oids[0]); i++) {
+        if ((len == lt_cert_sig_oids[i].len) && (0 == memcmp(val, lt_cert_sig_oids[i].oid, len))) {
+            v->alg = (lt_cert_sig_alg_t)i;
+            ret = LT_OK;
+        }
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // signatureValue BIT STRING, no unused bits
+    ret = lt_cert_next(&p, end, ASN1DER_STRING_BIT, NULL, NULL, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if ((len < 1) || (val[0] != 0) || (p != end)) {
+        return LT_CERT_STORE_INVALID;
+    }
+    v->sig = val + 1;
+    v->sig_len = len - 1;
+
+    return LT_OK;
+}
+
+/** Calculates fingerprint of certificate */
+static void lt_cert_fp(const uint8_t *cert, const uint16_t cert_len, uint8_t *fp)
+{
+    struct lt_crypto_sha256_ctx_t hctx = {0};
+
+    lt_sha256_init(&hctx);
+    lt_sha256_start(&hctx);
+    lt_sha256_update(&hctx, cert, cert_len);
+    lt_sha256_finish(&hctx, fp);
+}
+
+/** Tells whether fingerprint is cached */
+static bool lt_cert_chain_cached(const lt_cert_chain_t *c, const uint8_t *fp)
+{
+    for (uint8_t i = 0; i < c->cache_cnt; i++) {
+        if (0 == memcmp(c->cache[i], fp, LT_CERT_FP_SIZE)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** Adds fingerprint to the cache, the oldest one is replaced when the cache is full */
+static void lt_cert_chain_cache_add(lt_cert_chain_t *c, const uint8_t *fp)
+{
+    memcpy(c->cache[c->cache_next], fp, LT_CERT_FP_SIZE);
+    c->cache_next = (c->cache_next + 1) % LT_CERT_CHAIN_CACHE_SIZE;
+    if (c->cache_cnt < LT_CERT_CHAIN_CACHE_SIZE) {
+        c->cache_cnt++;
+    }
+}
+
+lt_ret_t lt_cert_chain_init(lt_cert_chain_t *c, const uint8_t *root_fp, lt_cert_sig_verify_t verify,
+                            void *verify_ctx)
+{
+    if (!c || !root_fp || !verify) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(c, 0, sizeof(*c));
+    memcpy(c->root_fp, root_fp, LT_CERT_FP_SIZE);
+    c->verify = verify;
+    c->verify_ctx = verify_ctx;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_cert_chain_verify(lt_cert_chain_t *c, const struct lt_cert_store_t *store)
+{
+    if (!c || !store) {
+        return LT_PARAM_ERR;
+    }
+    c->sig_checks = 0;
+
+    struct lt_cert_view_t views[LT_NUM_CERTIFICATES];
+    uint8_t fps[LT_NUM_CERTIFICATES][LT_CERT_FP_SIZE];
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        if (!store->certs[i] || (store->cert_len[i] > store->buf_len[i])) {
+            return LT_PARAM_ERR;
+        }
+        lt_ret_t ret = lt_cert_parse(store->certs[i], store->cert_len[i], &views[i]);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        lt_cert_fp(store->certs[i], store->cert_len[i], fps[i]);
+    }
+
+    // Root is trusted by its fingerprint, its self-signature adds nothing
+    if (0 != memcmp(fps[LT_CERT_KIND_TROPIC_ROOT], c->root_fp, LT_CERT_FP_SIZE)) {
+        return LT_FAIL;
+    }
+
+    for (int i = LT_CERT_KIND_TROPIC_ROOT - 1; i >= LT_CERT_KIND_DEVICE; i--) {
+        // Cached certificate was already verified up to the same root, its issuer did not change
+        if ((i != LT_CERT_KIND_DEVICE) && lt_cert_chain_cached(c, fps[i])) {
+            continue;
+        }
+
+        const struct lt_cert_view_t *v = &views[i];
+        const struct lt_cert_view_t *issuer = &views[i + 1];
+        if ((v->issuer_len != issuer->subject_len) || (0 != memcmp(v->issuer, issuer->subject, v->issuer_len))) {
+            return LT_FAIL;
+        }
+
+        lt_ret_t ret = c->verify(c->verify_ctx, v->alg, v->tbs, v->tbs_len, issuer->spki, issuer->spki_len, v->sig,
+                                 v->sig_len);
+        c->sig_checks++;
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        if (i != LT_CERT_KIND_DEVICE) {
+            lt_cert_chain_cache_add(c, fps[i]);
+        }
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_cert_chain_cache_flush(lt_cert_chain_t *c)
+{
+    if (!c) {
+        return LT_PARAM_ERR;
+    }
+
+    c->cache_cnt = 0;
+    c->cache_next = 0;
+
+    return LT_OK;
+}
+
+/** Copies DER INTEGER into `len` bytes big endian number */
+static lt_ret_t lt_cert_int(const uint8_t **p, const uint8_t *end, uint8_t *out, const uint16_t len)
+{
+    const uint8_t *val;
+    uint16_t val_len;
+    lt_ret_t ret = lt_cert_next(p, end, ASN1DER_INTEGER, NULL, NULL, &val, &val_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    // Leading zero keeps the number positive
+    while (val_len > len && val[0] == 0) {
+        val++;
+        val_len--;
+    }
+    if (val_len > len) {
+        return LT_CERT_STORE_INVALID;
+    }
+
+    memset(out, 0, len - val_len);
+    memcpy(out + len - val_len, val, val_len);
+
+    return LT_OK;
+}
+
+/** Takes key of SubjectPublicKeyInfo with algorithm `alg`, the key must have `key_len` bytes */
+static lt_ret_t lt_cert_spki_key(const uint8_t *spki, const uint16_t spki_len, const uint8_t *alg,
+                                 const uint16_t alg_len, const uint8_t **key, const uint16_t key_len)
+{
+    const uint8_t *p = spki;
+    const uint8_t *val;
+    uint16_t len;
+
+    // SubjectPublicKeyInfo ::= SEQUENCE { algorithm AlgorithmIdentifier, subjectPublicKey BIT STRING }
+    lt_ret_t ret = lt_cert_next(&p, spki + spki_len, ASN1DER_SEQUENCE, NULL, NULL, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    const uint8_t *end = val + len;
+    p = val;
+
+    ret = lt_cert_next(&p, end, ASN1DER_SEQUENCE, NULL, NULL, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if ((len != alg_len) || (0 != memcmp(val, alg, alg_len))) {
+        return LT_CERT_UNSUPPORTED;
+    }
+
+    ret = lt_cert_next(&p, end, ASN1DER_STRING_BIT, NULL, NULL, &val, &len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if ((len != key_len + 1) || (val[0] != 0)) {
+        return LT_CERT_UNSUPPORTED;
+    }
+    *key = val + 1;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_cert_chain_verify_builtin(void *ctx, const lt_cert_sig_alg_t alg, const uint8_t *tbs,
+                                      const uint16_t tbs_len, const uint8_t *spki, const uint16_t spki_len,
+                                      const uint8_t *sig, const uint16_t sig_len)
+{
+    UNUSED(ctx);
+    const uint8_t *key;
+    lt_ret_t ret;
+
+    if (alg == LT_CERT_SIG_ECDSA_SHA256) {
+        // Uncompressed point 0x04 || X || Y
+        ret = lt_cert_spki_key(spki, spki_len, lt_cert_p256_alg, sizeof(lt_cert_p256_alg), &key, 65);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (key[0] != 0x04) {
+            return LT_CERT_UNSUPPORTED;
+        }
+
+        // ECDSA-Sig-Value ::= SEQUENCE { r INTEGER, s INTEGER }
+        uint8_t rs[64];
+        const uint8_t *p = sig;
+        const uint8_t *val;
+        uint16_t len;
+        ret = lt_cert_next(&p, sig + sig_len, ASN1DER_SEQUENCE, NULL, NULL, &val, &len);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        p = val;
+        ret = lt_cert_int(&p, val + len, rs, 32);
+        if (ret == LT_OK) ret = lt_cert_int(&p, val + len, rs + 32, 32);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        return (0 == lt_ecdsa_verify(tbs, tbs_len, key + 1, rs)) ? LT_OK : LT_CRYPTO_ERR;
+    }
+    if (alg == LT_CERT_SIG_ED25519) {
+        ret = lt_cert_spki_key(spki, spki_len, lt_cert_ed25519_alg, sizeof(lt_cert_ed25519_alg), &key, 32);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (sig_len != 64) {
+            return LT_CRYPTO_ERR;
+        }
+
+        return (0 == lt_ed25519_sign_open(tbs, tbs_len, key, sig)) ? LT_OK : LT_CRYPTO_ERR;
+    }
+
+    return LT_CERT_UNSUPPORTED;
+}
@@ -9,8 +9,11 @@
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "libtropic_common.h"
+
 /**
  * @brief Calculates CRC16 checksum on a buffer
  *
@@ -20,13 +23,53 @@
  */
 uint16_t crc16(const uint8_t *buf, int16_t size) __attribute__((warn_unused_result));
 
+/**
+ * @brief Returns initial value of CRC16 calculated incrementally by crc16_update()
+ *
+ * @return          Initial CRC16 value
+ */
+uint16_t crc16_init(void) __attribute__((warn_unused_result));
+
+/**
+ * @brief Updates CRC16 with next part of data, so the CRC can be calculated while data are being copied
+ *
+ * @note crc16(buf, size) equals crc16_final(crc16_update(crc16_init(), buf, size))
+ *
+ * @param crc       CRC16 of the previous parts (from crc16_init() or crc16_update())
+ * @param buf       Buffer with next part of data
+ * @param size      Length of data in buffer
+ * @return          Updated CRC16 value
+ */
+uint16_t crc16_update(uint16_t crc, const uint8_t *buf, size_t size) __attribute__((warn_unused_result));
+
+/**
+ * @brief Finishes incremental calculation of CRC16
+ *
+ * @param crc       CRC16 value returned from crc16_update()
+ * @return          CRC16 checksum in the same format as returned by crc16()
+ */
+uint16_t crc16_final(uint16_t crc) __attribute__((warn_unused_result));
+
+/**
+ * @brief Calculates CRC16 of L2 frame data, by lt_port_crc16() when libtropic is compiled with LT_USE_PORT_CRC16
+ *
+ * @note Software crc16() is used when the port fails to calculate the checksum.
+ *
+ * @param s2        Structure holding l2 state
+ * @param buf       Buffer with data
+ * @param size      Length of data in buffer
+ * @return          CRC16 checksum in the same format as returned by crc16()
+ */
+uint16_t lt_l2_crc16(lt_l2_state_t *s2, const uint8_t *buf, uint16_t size) __attribute__((warn_unused_result));
+
 /**
  * @brief Takes pointer to filled l2 buffer and adds checksum
  *
  * @note Current implementation rely on that passed data come from l2 functions which always prepare data correctly
  *
+ * @param s2        Structure holding l2 state
  * @param req
  */
-void add_crc(void *req);
+void add_crc(lt_l2_state_t *s2, void *req);
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef LT_CRYPTO_DISPATCH_H
+#define LT_CRYPTO_DISPATCH_H
+
+/**
+ * @file   lt_crypto_dispatch.h
+ * @brief  Runtime selection of crypto backends
+ * @author Tropic Square s.r.o.
+ *
+ * With LT_CRYPTO_DISPATCH, trezor_crypto and accelerated implementations of AES-GCM and SHA256 compression are
+ * linked together. A backend file defines LT_CRYPTO_IMPL to its name before including this header and the crypto
+ * headers, which renames its functions, e.g. `lt_aesgcm_encrypt` to `lt_aesgcm_encrypt_accel`.
+ * hal/crypto/dispatch/lt_crypto_dispatch.c implements the original names by calling the implementation selected by
+ * `lt_crypto_dispatch_init()`. Without LT_CRYPTO_DISPATCH nothing is renamed.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+/**
+ * @brief Detects features of the CPU and selects the fastest implementations, only the first call does the work.
+ * Until it is called, trezor_crypto is used. Called by `lt_init()`.
+ */
+void lt_crypto_dispatch_init(void);
+
+#if LT_CRYPTO_DISPATCH && defined(LT_CRYPTO_IMPL)
+#define LT_CRYPTO_CAT_(a, b) a##b
+#define LT_CRYPTO_CAT(a, b) LT_CRYPTO_CAT_(a, b)
+
+#define lt_aesgcm_init_and_key LT_CRYPTO_CAT(lt_aesgcm_init_and_key_, LT_CRYPTO_IMPL)
+#define lt_aesgcm_encrypt LT_CRYPTO_CAT(lt_aesgcm_encrypt_, LT_CRYPTO_IMPL)
+#define lt_aesgcm_decrypt LT_CRYPTO_CAT(lt_aesgcm_decrypt_, LT_CRYPTO_IMPL)
+#define lt_aesgcm_decrypt_start LT_CRYPTO_CAT(lt_aesgcm_decrypt_start_, LT_CRYPTO_IMPL)
+#define lt_aesgcm_decrypt_update LT_CRYPTO_CAT(lt_aesgcm_decrypt_update_, LT_CRYPTO_IMPL)
+#define lt_aesgcm_decrypt_finish LT_CRYPTO_CAT(lt_aesgcm_decrypt_finish_, LT_CRYPTO_IMPL)
+#define lt_aesgcm_end LT_CRYPTO_CAT(lt_aesgcm_end_, LT_CRYPTO_IMPL)
+#define lt_sha256_compress_blocks LT_CRYPTO_CAT(lt_sha256_compress_blocks_, LT_CRYPTO_IMPL)
+#endif
+
+#endif
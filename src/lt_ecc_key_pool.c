@@ -0,0 +1,141 @@
+/**
+ * @file lt_ecc_key_pool.c
+ * @brief ECC key pool definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_ecc_key_pool.h"
+
+/** Generates a key in the lowest empty slot and moves it among the ready ones */
+static lt_ret_t lt_ecc_key_pool_generate(lt_ecc_key_pool_t *pool, ecc_slot_t *slot)
+{
+    ecc_slot_t s = (ecc_slot_t)__builtin_ctz(pool->empty);
+
+    lt_ret_t ret = lt_ecc_key_generate(pool->h, s, pool->curve);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    pool->empty &= ~(1UL << s);
+    pool->ready |= (1UL << s);
+    *slot = s;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_key_pool_init(lt_ecc_key_pool_t *pool, lt_handle_t *h, const uint32_t slots,
+                              const lt_ecc_curve_type_t curve, const uint8_t target)
+{
+    if (!pool || !h || ((curve != CURVE_P256) && (curve != CURVE_ED25519))) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->h = h;
+    pool->curve = curve;
+    pool->target = target;
+
+    lt_ecc_key_info_t info[ECC_SLOT_31 + 1];
+    lt_ret_t ret = lt_ecc_key_inventory(h, info);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    for (uint8_t i = ECC_SLOT_0; i <= ECC_SLOT_31; i++) {
+        if (!(slots & (1UL << i))) {
+            continue;
+        }
+        if ((info[i].status == LT_OK) && (info[i].curve == curve) && (info[i].origin == CURVE_GENERATED)) {
+            pool->ready |= (1UL << i);
+        }
+        else if (info[i].status == LT_L3_ECC_INVALID_KEY) {
+            pool->empty |= (1UL << i);
+        }
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_key_pool_refill(lt_ecc_key_pool_t *pool)
+{
+    if (!pool || !pool->h) {
+        return LT_PARAM_ERR;
+    }
+
+    if (!pool->empty || (pool->target && (__builtin_popcount(pool->ready) >= pool->target))) {
+        return LT_BUSY;
+    }
+
+    ecc_slot_t slot;
+    lt_ret_t ret = lt_ecc_key_pool_generate(pool, &slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    pool->stats.refills++;
+
+#if LT_ECC_KEY_CACHE
+    // Public key is read now, so the take finds it in the cache
+    uint8_t key[64];
+    lt_ecc_curve_type_t curve;
+    ecc_key_origin_t origin;
+    return lt_ecc_key_read(pool->h, slot, key, &curve, &origin);
+#else
+    return LT_OK;
+#endif
+}
+
+lt_ret_t lt_ecc_key_pool_take(lt_ecc_key_pool_t *pool, ecc_slot_t *slot, uint8_t *key)
+{
+    if (!pool || !pool->h || !slot || !key) {
+        return LT_PARAM_ERR;
+    }
+
+    ecc_slot_t s;
+    if (pool->ready) {
+        s = (ecc_slot_t)__builtin_ctz(pool->ready);
+    }
+    else if (pool->empty) {
+        lt_ret_t ret = lt_ecc_key_pool_generate(pool, &s);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        pool->stats.misses++;
+    }
+    else {
+        return LT_NOT_FOUND;
+    }
+
+    lt_ecc_curve_type_t curve;
+    ecc_key_origin_t origin;
+    lt_ret_t ret = lt_ecc_key_read(pool->h, s, key, &curve, &origin);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    pool->ready &= ~(1UL << s);
+    pool->stats.takes++;
+    *slot = s;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_ecc_key_pool_release(lt_ecc_key_pool_t *pool, const ecc_slot_t slot)
+{
+    if (!pool || !pool->h || (slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_ecc_key_erase(pool->h, slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    pool->ready &= ~(1UL << slot);
+    pool->empty |= (1UL << slot);
+
+    return LT_OK;
+}
@@ -23,4 +23,27 @@
 int lt_ecdsa_verify(const uint8_t *msg, const uint32_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
     __attribute__((warn_unused_result));
 
+#if LT_PREPARED_KEYS
+/**
+ * @brief  Decodes and validates public key and precomputes its multiples for `lt_ecdsa_verify_prepared()`
+ *
+ * @param prepared   Space of `lt_ecdsa_prepared_key_t`
+ * @param pubkey     Signer's public key (64B)
+ * @return int       0 if the key is valid, otherwise 1
+ */
+int lt_ecdsa_prepare(void *prepared, const uint8_t *pubkey) __attribute__((warn_unused_result));
+
+/**
+ * @brief  Checks if ECDSA signature made by a prepared key is correct
+ *
+ * @param prepared   Key prepared by `lt_ecdsa_prepare()`
+ * @param msg        Message to be checked
+ * @param msg_len    Length of the message
+ * @param rs         R and S part of the message's signature (64B)
+ * @return int       0 if signature is valid, otherwise 1
+ */
+int lt_ecdsa_verify_prepared(const void *prepared, const uint8_t *msg, const uint32_t msg_len, const uint8_t *rs)
+    __attribute__((warn_unused_result));
+#endif
+
 #endif
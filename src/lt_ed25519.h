@@ -23,4 +23,41 @@
 int lt_ed25519_sign_open(const uint8_t *msg, const uint16_t msg_len, const uint8_t *pubkey, const uint8_t *rs)
     __attribute__((warn_unused_result));
 
+/**
+ * @brief  Checks several ed25519 signatures made by one key, the key is decompressed only once
+ *
+ * @param msgs       Messages to be checked
+ * @param msg_lens   Lengths of the messages
+ * @param pubkey     Signer's public key
+ * @param rs         R and S parts of the messages' signatures, n * 64B
+ * @param n          Number of signatures
+ * @param valid      Set to 1 for each valid signature and to 0 for invalid one, can be NULL
+ * @return int       0 if all signatures are valid, otherwise 1
+ */
+int lt_ed25519_sign_open_batch(const uint8_t *const *msgs, const uint16_t *msg_lens, const uint8_t *pubkey,
+                               const uint8_t *rs, const uint16_t n, uint8_t *valid) __attribute__((warn_unused_result));
+
+#if LT_PREPARED_KEYS
+/**
+ * @brief  Decompresses public key and precomputes its multiples for `lt_ed25519_sign_open_prepared()`
+ *
+ * @param prepared   Space of `lt_eddsa_prepared_key_t`
+ * @param pubkey     Signer's public key (32B)
+ * @return int       0 if the key is valid, otherwise 1
+ */
+int lt_ed25519_prepare(void *prepared, const uint8_t *pubkey) __attribute__((warn_unused_result));
+
+/**
+ * @brief  Checks if ed25519 signature made by a prepared key is correct
+ *
+ * @param prepared   Key prepared by `lt_ed25519_prepare()`
+ * @param msg        Message to be checked
+ * @param msg_len    Length of the message
+ * @param rs         R and S part of the message's signature
+ * @return int       0 if signature is valid, otherwise 1
+ */
+int lt_ed25519_sign_open_prepared(const void *prepared, const uint8_t *msg, const uint16_t msg_len,
+                                  const uint8_t *rs) __attribute__((warn_unused_result));
+#endif
+
 #endif
@@ -0,0 +1,312 @@
+/**
+ * @file lt_fw_image.c
+ * @brief Firmware image container definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_fw_image.h"
+#include "libtropic_macros.h"
+#include "lt_sha256.h"
+
+/** Magic of the container, "LTFW" */
+#define LT_FW_IMAGE_MAGIC 0x5746544cu
+/** Version of the container format */
+#define LT_FW_IMAGE_VERSION 1
+
+/** Minimal length of LZ4 match */
+#define LT_FW_IMAGE_LZ4_MINMATCH 4u
+
+/** Container header, all numbers are little endian */
+struct lt_fw_image_hdr_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t codec;
+    uint8_t window_log;
+    uint8_t reserved;
+    uint32_t image_size;
+    uint32_t payload_size;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+} __attribute__((packed));
+
+STATIC_ASSERT(sizeof(struct lt_fw_image_hdr_t) == LT_FW_IMAGE_HEADER_SIZE)
+
+/** Starts reading of the image from its beginning */
+static void lt_fw_image_rewind(lt_fw_image_t *img)
+{
+    img->src_pos = LT_FW_IMAGE_HEADER_SIZE;
+    img->in_len = 0;
+    img->in_idx = 0;
+    img->pos = 0;
+    img->lit_left = 0;
+    img->match_left = 0;
+    img->match_pending = 0;
+    lt_sha256_init(&img->sha);
+    lt_sha256_start(&img->sha);
+}
+
+/** Reads next byte of the payload */
+static lt_ret_t lt_fw_image_src_byte(lt_fw_image_t *img, uint8_t *b)
+{
+    if (img->in_idx == img->in_len) {
+        if (img->src_pos == img->src_size) {
+            return LT_FAIL;
+        }
+        uint32_t len = img->src_size - img->src_pos;
+        img->in_len = (len < sizeof(img->in)) ? len : sizeof(img->in);
+        img->in_idx = 0;
+        lt_ret_t ret = img->src_read(img->src_ctx, img->src_pos, img->in, img->in_len);
+        if (ret != LT_OK) {
+            img->in_len = 0;
+            return ret;
+        }
+        img->src_pos += img->in_len;
+    }
+    *b = img->in[img->in_idx++];
+
+    return LT_OK;
+}
+
+/** Reads LZ4 length continued by bytes of value 255 */
+static lt_ret_t lt_fw_image_src_len(lt_fw_image_t *img, uint32_t *len)
+{
+    uint8_t b;
+    do {
+        lt_ret_t ret = lt_fw_image_src_byte(img, &b);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        *len += b;
+        if (*len > img->size) {
+            return LT_FAIL;
+        }
+    } while (b == UINT8_MAX);
+
+    return LT_OK;
+}
+
+/** Starts next LZ4 sequence, or the match of the current one when its literals were produced */
+static lt_ret_t lt_fw_image_sequence(lt_fw_image_t *img)
+{
+    lt_ret_t ret;
+    uint8_t b;
+
+    if (img->match_pending) {
+        img->match_pending = 0;
+        uint8_t dist[2];
+        ret = lt_fw_image_src_byte(img, &dist[0]);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        ret = lt_fw_image_src_byte(img, &dist[1]);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        img->match_dist = dist[0] | (dist[1] << 8);
+        if (!img->match_dist || (img->match_dist > img->pos) || (img->match_dist > img->window_mask + 1)) {
+            return LT_FAIL;
+        }
+
+        img->match_left = img->match_code;
+        if (img->match_code == 0x0f) {
+            ret = lt_fw_image_src_len(img, &img->match_left);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+        img->match_left += LT_FW_IMAGE_LZ4_MINMATCH;
+
+        return LT_OK;
+    }
+
+    ret = lt_fw_image_src_byte(img, &b);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    img->lit_left = b >> 4;
+    if (img->lit_left == 0x0f) {
+        ret = lt_fw_image_src_len(img, &img->lit_left);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+    img->match_code = b & 0x0f;
+    img->match_pending = 1;
+
+    return LT_OK;
+}
+
+/** Produces next `len` bytes of compressed image into `buff` */
+static lt_ret_t lt_fw_image_inflate(lt_fw_image_t *img, uint8_t *buff, const uint16_t len)
+{
+    for (uint16_t i = 0; i < len;) {
+        uint8_t b;
+        if (img->lit_left) {
+            lt_ret_t ret = lt_fw_image_src_byte(img, &b);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            img->lit_left--;
+        }
+        else if (img->match_left) {
+            b = img->window[(img->pos - img->match_dist) & img->window_mask];
+            img->match_left--;
+        }
+        else {
+            // Last sequence has only literals, payload ends by them
+            if (img->match_pending && (img->in_idx == img->in_len) && (img->src_pos == img->src_size)) {
+                return LT_FAIL;
+            }
+            lt_ret_t ret = lt_fw_image_sequence(img);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            continue;
+        }
+
+        img->window[img->pos & img->window_mask] = b;
+        img->pos++;
+        buff[i++] = b;
+    }
+
+    lt_sha256_update(&img->sha, buff, len);
+
+    return LT_OK;
+}
+
+/** Checks digest of the image when all its bytes were produced */
+static lt_ret_t lt_fw_image_finish(lt_fw_image_t *img)
+{
+    if (img->pos != img->size) {
+        return LT_OK;
+    }
+    // Compressed payload must not continue behind the image
+    if ((img->codec == LT_FW_IMAGE_CODEC_LZ4)
+        && (img->lit_left || img->match_left || (img->in_idx != img->in_len) || (img->src_pos != img->src_size))) {
+        return LT_FAIL;
+    }
+
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    lt_sha256_finish(&img->sha, digest);
+    // Hash is started again, so that the image can be read once more
+    lt_fw_image_rewind(img);
+
+    return (0 == memcmp(digest, img->digest, sizeof(digest))) ? LT_OK : LT_FAIL;
+}
+
+lt_ret_t lt_fw_image_open(lt_fw_image_t *img, lt_fw_read_cb_t read, void *ctx, const uint32_t src_size,
+                          uint8_t *window, const uint32_t window_size)
+{
+    if (!img || !read || (src_size < LT_FW_IMAGE_HEADER_SIZE)) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_fw_image_hdr_t hdr;
+    lt_ret_t ret = read(ctx, 0, (uint8_t *)&hdr, sizeof(hdr));
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if ((hdr.magic != LT_FW_IMAGE_MAGIC) || (hdr.version != LT_FW_IMAGE_VERSION)
+        || (hdr.payload_size != src_size - LT_FW_IMAGE_HEADER_SIZE) || !hdr.image_size
+        || (hdr.image_size > LT_MUTABLE_FW_UPDATE_SIZE_MAX)) {
+        return LT_FAIL;
+    }
+    if (hdr.codec == LT_FW_IMAGE_CODEC_RAW) {
+        if (hdr.payload_size != hdr.image_size) {
+            return LT_FAIL;
+        }
+    }
+    else if (hdr.codec == LT_FW_IMAGE_CODEC_LZ4) {
+        if (hdr.window_log > LT_FW_IMAGE_WINDOW_LOG_MAX) {
+            return LT_FAIL;
+        }
+        if (!window || (window_size < (1u << hdr.window_log)) || (window_size & (window_size - 1))) {
+            return LT_PARAM_ERR;
+        }
+    }
+    else {
+        return LT_FAIL;
+    }
+
+    img->size = hdr.image_size;
+    img->src_read = read;
+    img->src_ctx = ctx;
+    img->src_size = src_size;
+    img->codec = hdr.codec;
+    memcpy(img->digest, hdr.digest, sizeof(img->digest));
+    img->window = window;
+    img->window_mask = window_size - 1;
+    lt_fw_image_rewind(img);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_fw_image_read(void *ctx, const uint32_t offset, uint8_t *buff, const uint16_t len)
+{
+    lt_fw_image_t *img = ctx;
+    if (!img || !buff || (offset > img->size) || (len > img->size - offset)) {
+        return LT_PARAM_ERR;
+    }
+    lt_ret_t ret;
+
+    if (img->codec == LT_FW_IMAGE_CODEC_RAW) {
+        ret = img->src_read(img->src_ctx, LT_FW_IMAGE_HEADER_SIZE + offset, buff, len);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        // Bytes are hashed only while the image is read in order
+        if ((offset <= img->pos) && (offset + len > img->pos)) {
+            lt_sha256_update(&img->sha, buff + (img->pos - offset), offset + len - img->pos);
+            img->pos = offset + len;
+        }
+
+        return lt_fw_image_finish(img);
+    }
+
+    if (offset < img->pos) {
+        lt_fw_image_rewind(img);
+    }
+    // Skip to the requested offset
+    uint8_t scratch[32];
+    while (img->pos < offset) {
+        uint32_t skip = offset - img->pos;
+        ret = lt_fw_image_inflate(img, scratch, (skip < sizeof(scratch)) ? skip : sizeof(scratch));
+        if (ret != LT_OK) {
+            lt_fw_image_rewind(img);
+            return ret;
+        }
+    }
+
+    ret = lt_fw_image_inflate(img, buff, len);
+    if (ret != LT_OK) {
+        lt_fw_image_rewind(img);
+        return ret;
+    }
+
+    return lt_fw_image_finish(img);
+}
+
+lt_ret_t lt_fw_image_verify(lt_fw_image_t *img)
+{
+    if (!img) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t buff[32];
+    lt_fw_image_rewind(img);
+    for (uint32_t offset = 0; offset < img->size; offset += sizeof(buff)) {
+        uint32_t len = img->size - offset;
+        lt_ret_t ret = lt_fw_image_read(img, offset, buff, (len < sizeof(buff)) ? len : sizeof(buff));
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+
+    return LT_OK;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file lt_fw_preflight.c
+ * @brief Firmware update pre-flight check definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_fw_preflight.h"
+#include "libtropic_macros.h"
+#include "lt_l2_api_structs.h"
+#include "lt_sha256.h"
+#include "lt_sha256_multi.h"
+#include "lt_wire.h"
+
+/** Magic of the manifest */
+#define LT_FW_MANIFEST_MAGIC "LTFM"
+/** Version of the manifest format */
+#define LT_FW_MANIFEST_VERSION 1
+
+/** Size of SHA256 digest */
+#define LT_FW_PF_HASH_SIZE 32u
+
+#ifdef ABAB
+/** Size of image chunk written by one request, as sent by `lt_mutable_fw_update()` */
+#define LT_FW_PF_CHUNK_MAX 128u
+/** Chunks are hashed whole */
+#define LT_FW_PF_HASH_SKIP 0u
+#elif ACAB
+/** Size of the largest update data chunk, its length byte included */
+#define LT_FW_PF_CHUNK_MAX (1u + UINT8_MAX)
+/** Length byte of chunks is not hashed */
+#define LT_FW_PF_HASH_SKIP 1u
+/** Length byte, hash of the next chunk and offset in the bank in front of the data of a chunk */
+#define LT_FW_PF_DATA_OFFSET (1u + LT_FW_PF_HASH_SIZE + 2u)
+/** Largest data of a chunk */
+#define LT_FW_PF_DATA_MAX MEMBER_SIZE(struct lt_l2_mutable_fw_update_data_req_t, data)
+/** Offset of the hash of the first chunk in the update request, behind its length byte and signature */
+#define LT_FW_PF_REQ_HASH_OFFSET (1u + 64u)
+
+STATIC_ASSERT(LT_L2_MUTABLE_FW_UPDATE_REQ_LEN + 1u <= LT_FW_PF_CHUNK_MAX)
+#endif
+
+/** Chunks read and then hashed at once, one in each lane of `lt_sha256_multi()` */
+#define LT_FW_PF_BATCH LT_SHA256_MULTI_LANES
+
+/** Reads the chunk at `offset`, `len` is set to its size, 0 behind the end of the image */
+static lt_ret_t lt_fw_pf_chunk(lt_fw_read_cb_t read, void *ctx, const uint32_t offset, const uint32_t size,
+                               uint8_t *chunk, uint16_t *len)
+{
+    *len = 0;
+    if (offset == size) {
+        return LT_OK;
+    }
+#ifdef ABAB
+    *len = ((size - offset) < LT_FW_PF_CHUNK_MAX) ? (uint16_t)(size - offset) : (uint16_t)LT_FW_PF_CHUNK_MAX;
+
+    return read(ctx, offset, chunk, *len);
+#elif ACAB
+    // Length byte first, the same way `lt_mutable_fw_update_data()` reads the chunk
+    lt_ret_t ret = read(ctx, offset, chunk, 1);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (offset + 1u + chunk[0] > size) {
+        return LT_FAIL;
+    }
+    if (offset == 0) {
+        if (chunk[0] != LT_L2_MUTABLE_FW_UPDATE_REQ_LEN) {
+            return LT_FAIL;
+        }
+    }
+    else {
+        uint16_t data_len = (uint16_t)(1u + chunk[0]) - (uint16_t)LT_FW_PF_DATA_OFFSET;
+        if ((1u + chunk[0] < LT_FW_PF_DATA_OFFSET) || !data_len || (data_len > LT_FW_PF_DATA_MAX)
+            || (data_len % 4u)) {
+            return LT_FAIL;
+        }
+    }
+    *len = (uint16_t)(1u + chunk[0]);
+
+    return read(ctx, offset + 1u, chunk + 1, chunk[0]);
+#endif
+}
+
+/** Checks magic, version and signature of the manifest */
+static lt_ret_t lt_fw_pf_manifest_check(const uint8_t *manifest, const uint8_t *pubkey)
+{
+    if (memcmp(manifest, LT_FW_MANIFEST_MAGIC, 4) || (manifest[4] != LT_FW_MANIFEST_VERSION) || manifest[5]
+        || manifest[6] || manifest[7]) {
+        return LT_FAIL;
+    }
+    if (lt_ecc_eddsa_sig_verify(manifest, LT_FW_MANIFEST_MSG_SIZE, pubkey, manifest + LT_FW_MANIFEST_MSG_SIZE)
+        != LT_OK) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_fw_preflight(lt_fw_preflight_t *pf, lt_fw_read_cb_t read, void *ctx, const uint32_t size,
+                         const uint8_t *manifest, const uint8_t *pubkey)
+{
+    if (!pf || !read || !size || (size > LT_MUTABLE_FW_UPDATE_SIZE_MAX) || (manifest && !pubkey)
+        || (pf->offsets_max && !pf->offsets)) {
+        return LT_PARAM_ERR;
+    }
+    pf->size = size;
+    pf->chunks = 0;
+
+    lt_ret_t ret;
+    // Signature of the manifest is checked before the image is read, so a wrong image fails right away
+    if (manifest) {
+        ret = lt_fw_pf_manifest_check(manifest, pubkey);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        if (lt_wire_ld32(manifest + 8) != size) {
+            return LT_FAIL;
+        }
+    }
+
+    uint8_t chunks[LT_FW_PF_BATCH][LT_FW_PF_CHUNK_MAX];
+    const uint8_t *msgs[LT_FW_PF_BATCH];
+    uint32_t msg_lens[LT_FW_PF_BATCH];
+    uint8_t digests[LT_FW_PF_BATCH * LT_FW_PF_HASH_SIZE];
+    struct lt_crypto_sha256_ctx_t sha;
+#ifdef ACAB
+    // Hash of the next chunk carried by the previous one, the update request has none
+    uint8_t expected[LT_FW_PF_HASH_SIZE];
+    uint8_t request = 1;
+#endif
+
+    lt_sha256_init(&sha);
+    lt_sha256_start(&sha);
+
+    uint32_t offset = 0;
+    uint16_t len = 1;
+    while (len) {
+        // Chunks of a batch are read one after another, as the update functions read them
+        size_t n = 0;
+        while (n < LT_FW_PF_BATCH) {
+            ret = lt_fw_pf_chunk(read, ctx, offset, size, chunks[n], &len);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            if (!len) {
+                break;
+            }
+#ifdef ACAB
+            if (offset != 0)
+#endif
+            {
+                if (pf->offsets && (pf->chunks < pf->offsets_max)) {
+                    pf->offsets[pf->chunks] = offset;
+                }
+                pf->chunks++;
+            }
+            msgs[n] = chunks[n] + LT_FW_PF_HASH_SKIP;
+            msg_lens[n] = len - LT_FW_PF_HASH_SKIP;
+            offset += len;
+            n++;
+        }
+        if (!n) {
+            break;
+        }
+
+        lt_sha256_multi(msgs, msg_lens, n, digests);
+        lt_sha256_update(&sha, digests, n * LT_FW_PF_HASH_SIZE);
+
+#ifdef ACAB
+        for (size_t i = 0; i < n; i++) {
+            if (request) {
+                memcpy(expected, chunks[i] + LT_FW_PF_REQ_HASH_OFFSET, sizeof(expected));
+                request = 0;
+                continue;
+            }
+            if (memcmp(expected, digests + (i * LT_FW_PF_HASH_SIZE), sizeof(expected))) {
+                return LT_FAIL;
+            }
+            memcpy(expected, chunks[i] + 1, sizeof(expected));
+        }
+#endif
+    }
+    lt_sha256_finish(&sha, pf->digest);
+
+#ifdef ACAB
+    // The last chunk points to no next chunk, otherwise the image was cut at a chunk boundary
+    static const uint8_t none[LT_FW_PF_HASH_SIZE] = {0};
+    if (!pf->chunks || memcmp(expected, none, sizeof(expected))) {
+        return LT_FAIL;
+    }
+#endif
+    if (pf->offsets && (pf->chunks > pf->offsets_max)) {
+        return LT_PARAM_ERR;
+    }
+    if (manifest
+        && ((lt_wire_ld32(manifest + 12) != pf->chunks)
+            || memcmp(manifest + 16, pf->digest, sizeof(pf->digest)))) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_fw_preflight_resume(const lt_fw_preflight_t *pf, const uint32_t chunk, lt_fw_update_t *u)
+{
+    if (!pf || !u || !pf->offsets || (pf->chunks > pf->offsets_max) || (chunk > pf->chunks)) {
+        return LT_PARAM_ERR;
+    }
+
+    u->cursor = (chunk < pf->chunks) ? pf->offsets[chunk] : pf->size;
+    u->chunks = chunk;
+
+    return LT_OK;
+}
@@ -9,38 +9,34 @@
 #include <stdint.h>
 #include <string.h>
 
-#if LT_USE_TREZOR_CRYPTO
-#include "blake256.h"
-#include "blake2b.h"
-#include "groestl.h"
-#include "hasher.h"
-#include "hmac.h"
-#include "lt_hmac_sha256.h"
-#include "memzero.h"
-#include "ripemd160.h"
-#include "sha2.h"
-#include "sha3.h"
-#elif USE_MBEDTLS
-// TBD
-#endif
-
 #include "libtropic_macros.h"
 #include "lt_hkdf.h"
+#include "lt_hmac_sha256.h"
+#include "lt_profile.h"
 
 void lt_hkdf(uint8_t *ck, uint32_t ck_size, uint8_t *input, uint32_t input_size, uint8_t nouts, uint8_t *output_1,
              uint8_t *output_2)
 {
+    LT_PROFILE_SCOPE(LT_PROFILE_HKDF);
+
     UNUSED(nouts);
 
     uint8_t tmp[32] = {0};
     uint8_t one = 0x01;
 
     lt_hmac_sha256(ck, ck_size, input, input_size, tmp);
-    lt_hmac_sha256(tmp, 32, &one, 1, output_1);
+
+    // Both outputs are keyed by tmp, so its key pads are processed only once
+    struct lt_hmac_sha256_ctx_t hmac_ctx;
+    lt_hmac_sha256_init(&hmac_ctx, tmp, 32);
+    lt_hmac_sha256_compute(&hmac_ctx, &one, 1, output_1);
 
     uint8_t helper[33] = {0};
     memcpy(helper, output_1, 32);
     helper[32] = 2;
 
-    lt_hmac_sha256(tmp, 32, helper, 33, output_2);
+    lt_hmac_sha256_compute(&hmac_ctx, helper, 33, output_2);
+
+    memset(tmp, 0, sizeof(tmp));
+    memset(&hmac_ctx, 0, sizeof(hmac_ctx));
 }
@@ -0,0 +1,62 @@
+/**
+ * @file   lt_hmac_drbg.c
+ * @brief  HMAC_DRBG (NIST SP 800-90A) with SHA256 functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_hmac_drbg.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lt_hmac_sha256.h"
+
+/** HMAC_DRBG_Update: K = HMAC(K, V || round || data), V = HMAC(K, V), second round only with data */
+static void lt_hmac_drbg_update(lt_drbg_t *drbg, const uint8_t *data, size_t len)
+{
+    uint8_t buff[sizeof(drbg->v) + 1 + LT_HMAC_DRBG_SEED_LEN_MAX];
+
+    for (uint8_t round = 0; round < 2; round++) {
+        memcpy(buff, drbg->v, sizeof(drbg->v));
+        buff[sizeof(drbg->v)] = round;
+        if (len) {
+            memcpy(buff + sizeof(drbg->v) + 1, data, len);
+        }
+        lt_hmac_sha256(drbg->key, sizeof(drbg->key), buff, sizeof(drbg->v) + 1 + len, drbg->key);
+        lt_hmac_sha256(drbg->key, sizeof(drbg->key), drbg->v, sizeof(drbg->v), drbg->v);
+        if (!len) {
+            break;
+        }
+    }
+
+    memset(buff, 0, sizeof(buff));
+}
+
+void lt_hmac_drbg_instantiate(lt_drbg_t *drbg, const uint8_t *seed, size_t len)
+{
+    memset(drbg->key, 0x00, sizeof(drbg->key));
+    memset(drbg->v, 0x01, sizeof(drbg->v));
+    lt_hmac_drbg_update(drbg, seed, len);
+}
+
+void lt_hmac_drbg_reseed(lt_drbg_t *drbg, const uint8_t *seed, size_t len) { lt_hmac_drbg_update(drbg, seed, len); }
+
+void lt_hmac_drbg_generate(lt_drbg_t *drbg, uint8_t *output, size_t len)
+{
+    // All blocks are keyed by the same K, so its key pads are processed only once
+    struct lt_hmac_sha256_ctx_t hmac_ctx;
+    lt_hmac_sha256_init(&hmac_ctx, drbg->key, sizeof(drbg->key));
+
+    while (len) {
+        lt_hmac_sha256_compute(&hmac_ctx, drbg->v, sizeof(drbg->v), drbg->v);
+        size_t n = (len < sizeof(drbg->v)) ? len : sizeof(drbg->v);
+        memcpy(output, drbg->v, n);
+        output += n;
+        len -= n;
+    }
+
+    memset(&hmac_ctx, 0, sizeof(hmac_ctx));
+    lt_hmac_drbg_update(drbg, NULL, 0);
+}
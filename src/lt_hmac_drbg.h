@@ -0,0 +1,47 @@
+#ifndef LT_HMAC_DRBG_H
+#define LT_HMAC_DRBG_H
+
+/**
+ * @file   lt_hmac_drbg.h
+ * @brief  HMAC_DRBG (NIST SP 800-90A) with SHA256 functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Maximal length of seed material passed to `lt_hmac_drbg_instantiate()` and `lt_hmac_drbg_reseed()` */
+#define LT_HMAC_DRBG_SEED_LEN_MAX 48
+
+/**
+ * @details Instantiates the DRBG state from seed material (entropy input and nonce)
+ *
+ * @param drbg    DRBG state
+ * @param seed    Seed material
+ * @param len     Length of seed material, at most LT_HMAC_DRBG_SEED_LEN_MAX
+ */
+void lt_hmac_drbg_instantiate(lt_drbg_t *drbg, const uint8_t *seed, size_t len);
+
+/**
+ * @details Mixes fresh entropy input into the DRBG state
+ *
+ * @param drbg    DRBG state
+ * @param seed    Entropy input
+ * @param len     Length of entropy input, at most LT_HMAC_DRBG_SEED_LEN_MAX
+ */
+void lt_hmac_drbg_reseed(lt_drbg_t *drbg, const uint8_t *seed, size_t len);
+
+/**
+ * @details Generates pseudorandom bytes and updates the DRBG state
+ *
+ * @param drbg    DRBG state
+ * @param output  Output buffer
+ * @param len     Number of bytes to generate
+ */
+void lt_hmac_drbg_generate(lt_drbg_t *drbg, uint8_t *output, size_t len);
+
+#endif
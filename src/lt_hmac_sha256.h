@@ -23,4 +23,35 @@
  */
 void lt_hmac_sha256(const uint8_t *key, size_t keylen, const uint8_t *input, size_t ilen, uint8_t *output);
 
+/** HMAC SHA256 context, holds states of SHA256 after processing of inner and outer key pad */
+struct lt_hmac_sha256_ctx_t {
+#ifdef USE_MBEDTLS
+    uint8_t key[64];
+    size_t key_len;
+#else
+    uint32_t space[16];
+#endif
+};
+
+/**
+ * @details This function precomputes inner and outer key pads, so more HMACs under the same key can be computed
+ * with `lt_hmac_sha256_compute()` without processing the key again
+ *
+ * @param ctx     HMAC SHA256 context
+ * @param key     Key data buffer
+ * @param keylen  Length of data in key data buffer
+ */
+void lt_hmac_sha256_init(struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t keylen);
+
+/**
+ * @details This function computes HMAC SHA256 under the key given to `lt_hmac_sha256_init()`
+ *
+ * @param ctx     HMAC SHA256 context
+ * @param input   Input data buffer
+ * @param ilen    Length of data in input data buffer
+ * @param output  Output buffer
+ */
+void lt_hmac_sha256_compute(const struct lt_hmac_sha256_ctx_t *ctx, const uint8_t *input, size_t ilen,
+                            uint8_t *output);
+
 #endif
@@ -0,0 +1,69 @@
+/**
+ * @file lt_hooks.c
+ * @brief Instrumentation hooks functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_hooks.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+
+void lt_hooks_pre(lt_l2_state_t *s2, const lt_hook_kind_t kind, const char *api, const uint8_t id,
+                  const uint16_t tx_len, const uint32_t delay_us)
+{
+    lt_hooks_t *hooks = s2->hooks;
+
+    if (kind == LT_HOOK_API) {
+        // Only the outermost function is reported, helpers call other API functions with the handle locked
+        if (hooks->api_depth++) {
+            return;
+        }
+    }
+
+    lt_hook_event_t *ev = &hooks->ev[kind];
+    memset(ev, 0, sizeof(*ev));
+    ev->kind = kind;
+    ev->api = api;
+    ev->id = id;
+    ev->tx_len = tx_len;
+    ev->delay_us = delay_us;
+    hooks->open |= (uint8_t)(1u << kind);
+
+    if (hooks->pre) {
+        hooks->pre(hooks->ctx, ev);
+    }
+    // Time taken by `pre` is not accounted to the operation
+    hooks->start_us[kind] = hooks->time_us ? hooks->time_us() : 0;
+}
+
+void lt_hooks_post(lt_l2_state_t *s2, const lt_hook_kind_t kind, const uint8_t status, const uint16_t rx_len,
+                   const lt_ret_t ret)
+{
+    lt_hooks_t *hooks = s2->hooks;
+
+    if ((kind == LT_HOOK_API) && hooks->api_depth && --hooks->api_depth) {
+        return;
+    }
+    // E.g. reads of CHIP_STATUS not preceded by a request frame are not exchanges
+    if (!(hooks->open & (1u << kind))) {
+        return;
+    }
+    hooks->open &= (uint8_t)~(1u << kind);
+
+    lt_hook_event_t *ev = &hooks->ev[kind];
+    // Unsigned difference is correct also when the clock wrapped around
+    ev->duration_us = hooks->time_us ? (hooks->time_us() - hooks->start_us[kind]) : 0;
+    ev->status = status;
+    ev->rx_len = rx_len;
+    ev->ret = ret;
+
+    if (hooks->post) {
+        hooks->post(hooks->ctx, ev);
+    }
+}
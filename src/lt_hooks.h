@@ -0,0 +1,72 @@
+#ifndef LT_HOOKS_H
+#define LT_HOOKS_H
+
+/**
+ * @defgroup group_hooks_functions Instrumentation hooks functions
+ * @brief Used internally
+ * @details Functions calling `lt_l2_state_t.hooks` before and after operations. The inline wrappers only test the
+ * pointer, so without hooks each reported operation costs one branch, the rest is out of line.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_hooks.h
+ * @brief Instrumentation hooks functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_HOOKS
+/**
+ * @brief Starts the operation and calls `pre`, use `lt_hook_pre()`
+ *
+ * @param s2          Structure holding l2 state, `s2->hooks` is not NULL
+ * @param kind        Kind of the operation
+ * @param api         Name of the function for LT_HOOK_API, NULL otherwise
+ * @param id          L3 command ID or L2 request ID
+ * @param tx_len      Size of the command or request frame
+ * @param delay_us    Requested time of LT_HOOK_DELAY
+ */
+void lt_hooks_pre(lt_l2_state_t *s2, const lt_hook_kind_t kind, const char *api, const uint8_t id,
+                  const uint16_t tx_len, const uint32_t delay_us);
+
+/**
+ * @brief Completes the operation started by `lt_hooks_pre()` and calls `post`, use `lt_hook_post()`
+ *
+ * @param s2          Structure holding l2 state, `s2->hooks` is not NULL
+ * @param kind        Kind of the operation
+ * @param status      Status of L2 response
+ * @param rx_len      Size of the result or of data of the response
+ * @param ret         Result of the operation
+ */
+void lt_hooks_post(lt_l2_state_t *s2, const lt_hook_kind_t kind, const uint8_t status, const uint16_t rx_len,
+                   const lt_ret_t ret);
+
+/** @brief Reports start of the operation when the handle has hooks */
+static inline void lt_hook_pre(lt_l2_state_t *s2, const lt_hook_kind_t kind, const char *api, const uint8_t id,
+                               const uint16_t tx_len, const uint32_t delay_us)
+{
+    if (s2->hooks) {
+        lt_hooks_pre(s2, kind, api, id, tx_len, delay_us);
+    }
+}
+
+/** @brief Reports end of the operation when the handle has hooks */
+static inline void lt_hook_post(lt_l2_state_t *s2, const lt_hook_kind_t kind, const uint8_t status,
+                                const uint16_t rx_len, const lt_ret_t ret)
+{
+    if (s2->hooks) {
+        lt_hooks_post(s2, kind, status, rx_len, ret);
+    }
+}
+#endif
+
+/** @} */  // end of group_hooks_functions
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * @file lt_job_arena.c
+ * @brief Job arena definitions
+ * @author Tropic Square s.r.o.
+ *
+ * Free slots make a stack linked by `lt_job_slot_t.next`, its top is in `lt_job_arena_t.head` with a tag changed
+ * by every push and pop.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_job_arena.h"
+
+/** Index of the top of the free list plus one */
+#define LT_JOB_HEAD_TOP(head) ((uint16_t)((head) & 0xffffu))
+/** Head of the free list with `top` on its top, tagged as the next change of `head` */
+#define LT_JOB_HEAD_NEXT(head, top) ((((head) + 0x10000u) & 0xffff0000u) | (top))
+
+lt_ret_t lt_job_arena_init(lt_job_arena_t *arena, lt_job_slot_t *slots, const uint32_t cnt)
+{
+    if (!arena || !slots || !cnt || (cnt > LT_JOB_ARENA_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(arena, 0, sizeof(*arena));
+    memset(slots, 0, sizeof(*slots) * cnt);
+    arena->slots = slots;
+    arena->cnt = (uint16_t)cnt;
+    for (uint32_t i = 0; i + 1 < cnt; i++) {
+        slots[i].next = (uint16_t)(i + 2);
+    }
+    arena->head = 1;
+
+    return LT_OK;
+}
+
+lt_job_t *lt_job_alloc(lt_job_arena_t *arena)
+{
+    if (!arena) {
+        return NULL;
+    }
+
+    lt_job_slot_t *slot;
+    uint32_t head = __atomic_load_n(&arena->head, __ATOMIC_ACQUIRE);
+    uint32_t next;
+    do {
+        if (!LT_JOB_HEAD_TOP(head)) {
+            __atomic_fetch_add(&arena->stats.exhausted, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+        slot = &arena->slots[LT_JOB_HEAD_TOP(head) - 1];
+        // The slot may be taken meanwhile, then the tag of head has changed and the value read here is not used
+        next = LT_JOB_HEAD_NEXT(head, __atomic_load_n(&slot->next, __ATOMIC_RELAXED));
+    } while (!__atomic_compare_exchange_n(&arena->head, &head, next, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    __atomic_fetch_add(&arena->stats.allocs, 1, __ATOMIC_RELAXED);
+    uint16_t in_use = __atomic_add_fetch(&arena->stats.in_use, 1, __ATOMIC_RELAXED);
+    uint16_t in_use_max = __atomic_load_n(&arena->stats.in_use_max, __ATOMIC_RELAXED);
+    while ((in_use > in_use_max)
+           && !__atomic_compare_exchange_n(&arena->stats.in_use_max, &in_use_max, in_use, 1, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED)) {
+    }
+
+    memset(&slot->job, 0, sizeof(slot->job));
+
+    return &slot->job;
+}
+
+lt_ret_t lt_job_free(lt_job_arena_t *arena, lt_job_t *job)
+{
+    if (!arena || !job) {
+        return LT_PARAM_ERR;
+    }
+    // Job is the first member of its slot
+    const uintptr_t offset = (uintptr_t)job - (uintptr_t)arena->slots;
+    if ((offset >= sizeof(lt_job_slot_t) * arena->cnt) || (offset % sizeof(lt_job_slot_t))) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_job_slot_t *slot = (lt_job_slot_t *)job;
+    const uint16_t top = (uint16_t)(offset / sizeof(lt_job_slot_t) + 1);
+    uint32_t head = __atomic_load_n(&arena->head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&slot->next, LT_JOB_HEAD_TOP(head), __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&arena->head, &head, LT_JOB_HEAD_NEXT(head, top), 1, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+    __atomic_sub_fetch(&arena->stats.in_use, 1, __ATOMIC_RELAXED);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_job_arena_stats_get(lt_job_arena_t *arena, lt_job_arena_stats_t *stats)
+{
+    if (!arena || !stats) {
+        return LT_PARAM_ERR;
+    }
+
+    stats->allocs = __atomic_load_n(&arena->stats.allocs, __ATOMIC_RELAXED);
+    stats->exhausted = __atomic_load_n(&arena->stats.exhausted, __ATOMIC_RELAXED);
+    stats->in_use = __atomic_load_n(&arena->stats.in_use, __ATOMIC_RELAXED);
+    stats->in_use_max = __atomic_load_n(&arena->stats.in_use_max, __ATOMIC_RELAXED);
+
+    return LT_OK;
+}
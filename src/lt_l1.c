@@ -11,35 +11,485 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "libtropic_common.h"
 #include "libtropic_macros.h"
+#include "lt_hooks.h"
 #include "lt_l1_port_wrap.h"
+#include "lt_profile.h"
+#include "lt_trace.h"
+#if LT_ADAPTIVE_POLLING
+#include "lt_l2_api_structs.h"
+#include "lt_l3_cmd_desc.h"
+#endif
 
-#ifdef LT_PRINT_SPI_DATA
-#include "stdio.h"
-#define SPI_DIR_MISO 0
-#define SPI_DIR_MOSI 1
-void print_hex_chunks(const uint8_t *data, uint8_t len, uint8_t dir)
+#if LT_IDLE_SLEEP
+/** Notes communication for `lt_idle_t`, the first request sent to sleeping TROPIC01 starts accounting of its wake */
+static void lt_l1_idle_request(lt_l2_state_t *s2)
 {
-    if ((!data) || (len == 0)) {
+    lt_idle_t *idle = s2->idle;
+    if (!idle || !idle->time_us) {
         return;
     }
-    printf("%s", dir ? "  >>  TX: " : "  <<  RX: ");
-    for (size_t i = 0; i < len; i++) {
-        printf("%02" PRIX8 " ", data[i]);
-        if ((i + 1) % 32 == 0) {
-            printf("\n          ");
+
+    idle->last_us = idle->time_us();
+    if (idle->asleep) {
+        idle->asleep = 0;
+        idle->waking = 1;
+        idle->wake_start_us = idle->last_us;
+    }
+}
+
+/** Notes communication for `lt_idle_t`, the first response after a wake ends its accounting */
+static void lt_l1_idle_response(lt_l2_state_t *s2)
+{
+    lt_idle_t *idle = s2->idle;
+    if (!idle || !idle->time_us) {
+        return;
+    }
+
+    idle->last_us = idle->time_us();
+    if (idle->waking) {
+        // Unsigned difference is correct also when the clock wrapped around
+        uint32_t us = idle->last_us - idle->wake_start_us;
+        idle->waking = 0;
+        idle->stats.wakes++;
+        idle->stats.wake_us_last = us;
+        idle->stats.wake_us_total += us;
+        if (us > idle->stats.wake_us_max) {
+            idle->stats.wake_us_max = us;
+        }
+    }
+}
+#endif
+
+#if LT_TRACE
+/** Records L2 request sent in segments, REQ_DATA starts at offset 2 of the frame */
+static void lt_l1_trace_segments(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, const uint8_t seg_cnt)
+{
+    uint16_t len = 0;
+    const uint8_t *data = NULL;
+    uint16_t data_len = 0;
+
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if (!data && (len + segs[i].len > 2)) {
+            uint16_t skip = (len < 2) ? (2 - len) : 0;
+            data = (segs[i].tx ? segs[i].tx : s2->buff + segs[i].offset) + skip;
+            data_len = segs[i].len - skip;
         }
+        len += segs[i].len;
     }
-    printf("\n");
+
+    // REQ_ID is in the first segment, which is always sent from the handle's buffer
+    lt_trace_record(s2, LT_TRACE_TX, segs[0].tx ? segs[0].tx[0] : s2->buff[segs[0].offset], len, data, data_len);
 }
 #endif
 
-lt_ret_t lt_l1_read(lt_l2_state_t *s2, const uint32_t max_len, const uint32_t timeout_ms)
+#if LT_ADAPTIVE_POLLING
+/** Profile used for commands without own profile, it equals to polling done without LT_ADAPTIVE_POLLING */
+static const lt_l1_poll_profile_t lt_l1_poll_profile_fallback
+    = {.cmd = 0, .first_delay_us = 0,
+       .retry_delay_us = LT_L1_READ_RETRY_DELAY * 1000,
+       .max_delay_us = LT_L1_READ_RETRY_DELAY * 1000};
+
+/**
+ * Default profiles of L2 requests, used when the handle does not provide its own. Default profiles of L3 commands are
+ * derived from `lt_l3_cmd_desc_t`.
+ */
+static const lt_l1_poll_profile_t lt_l1_poll_profiles_default[] = {
+    // L2 requests are answered by TROPIC01 without any lengthy processing
+    {LT_L1_POLL_CMD_L2(LT_L2_GET_INFO_REQ_ID), 0, 250, 8000},
+    {LT_L1_POLL_CMD_L2(LT_L2_HANDSHAKE_REQ_ID), 2000, 250, 8000},
+    {LT_L1_POLL_CMD_L2(LT_L2_ENCRYPTED_CMD_REQ_ID), 0, 250, 8000},
+    {LT_L1_POLL_CMD_L2(LT_L2_RESEND_REQ_ID), 0, 250, 8000},
+    {LT_L1_POLL_CMD_L2(LT_L2_GET_LOG_REQ_ID), 0, 250, 8000},
+    // Chunk of L3 command is only stored by TROPIC01, so it is acknowledged quickly
+    {LT_L1_POLL_CMD_L3_CHUNK, 0, 100, 1000},
+};
+#endif
+
+#if LT_ADAPTIVE_POLLING
+void lt_l1_poll_profile_get(const lt_l2_state_t *s2, const uint16_t cmd, lt_l1_poll_profile_t *profile)
+{
+    const lt_l1_poll_profile_t *profiles = s2->poll.profiles;
+    size_t profiles_cnt = s2->poll.profiles_cnt;
+
+    if (!profiles) {
+        // Default profiles of L3 commands are derived from their expected execution times
+        const lt_l3_cmd_desc_t *desc
+            = ((cmd & 0xff00u) == LT_L1_POLL_CMD_L3(0)) ? lt_l3_cmd_desc_get((uint8_t)cmd) : NULL;
+        if (desc) {
+            // Polls of commands TROPIC01 executes for miliseconds are spread more, they do not keep it busy
+            bool slow = desc->exec_us || (desc->flags & LT_L3_CMD_WRITES_FLASH);
+            profile->cmd = cmd;
+            profile->first_delay_us = desc->exec_us;
+            profile->retry_delay_us = slow ? 2000 : 250;
+            profile->max_delay_us = slow ? 16000 : 8000;
+            return;
+        }
+        profiles = lt_l1_poll_profiles_default;
+        profiles_cnt = sizeof(lt_l1_poll_profiles_default) / sizeof(lt_l1_poll_profiles_default[0]);
+    }
+
+    for (size_t i = 0; i < profiles_cnt; i++) {
+        if (profiles[i].cmd == cmd) {
+            *profile = profiles[i];
+            return;
+        }
+    }
+
+    *profile = lt_l1_poll_profile_fallback;
+}
+
+static lt_l1_poll_stats_t *lt_l1_poll_stats_get(lt_l2_state_t *s2)
+{
+    lt_l1_poll_stats_t *free_slot = NULL;
+
+    if (s2->poll.cmd == 0) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+        if (s2->poll.stats[i].cmd == s2->poll.cmd) {
+            return &s2->poll.stats[i];
+        }
+        if (!free_slot && (s2->poll.stats[i].cmd == 0)) {
+            free_slot = &s2->poll.stats[i];
+        }
+    }
+
+    if (free_slot) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->cmd = s2->poll.cmd;
+    }
+
+    return free_slot;
+}
+
+static void lt_l1_poll_stats_update(lt_l1_poll_sched_t *sched, uint16_t len)
+{
+    lt_l1_poll_stats_t *stats = sched->stats;
+
+    if (!stats) {
+        return;
+    }
+
+    if (len > stats->len_max) {
+        stats->len_max = len;
+    }
+
+    if ((stats->cnt == 0) || (sched->waited_us < stats->min_us)) {
+        stats->min_us = sched->waited_us;
+    }
+    if (sched->waited_us > stats->max_us) {
+        stats->max_us = sched->waited_us;
+    }
+    if (stats->cnt == 0) {
+        stats->avg_us = sched->waited_us;
+    }
+    else {
+        stats->avg_us = stats->avg_us - (stats->avg_us / 8) + (sched->waited_us / 8);
+    }
+    stats->last_us = sched->waited_us;
+    stats->polls += sched->polls;
+    stats->cnt++;
+}
+#endif
+
+/** Returns true while another poll of CHIP_STATUS is allowed */
+static bool lt_l1_poll_continue(const lt_l1_poll_sched_t *sched)
+{
+#if LT_ADAPTIVE_POLLING
+    // Time spent by waiting is limited instead of number of polls. Number of polls is limited only to not poll
+    // forever when waiting is done on INT pin.
+    return (sched->waited_us < (LT_L1_READ_MAX_TRIES * LT_L1_READ_RETRY_DELAY * 1000))
+           && (sched->polls < (LT_L1_READ_MAX_TRIES * LT_L1_READ_RETRY_DELAY));
+#else
+    return sched->polls < LT_L1_READ_MAX_TRIES;
+#endif
+}
+
+/** Sets the time to wait after an unsuccessful poll of CHIP_STATUS */
+static void lt_l1_poll_next(lt_l1_poll_sched_t *sched)
+{
+#if LT_ADAPTIVE_POLLING
+    uint32_t delay_us = sched->delay_us ? sched->delay_us : LT_L1_READ_RETRY_DELAY_US_MIN;
+
+    // Exponential backoff
+    sched->delay_us = (delay_us * 2 > sched->max_delay_us) ? sched->max_delay_us : delay_us * 2;
+#else
+    uint32_t delay_us = LT_L1_READ_RETRY_DELAY * 1000;
+#endif
+    sched->next_us = delay_us;
+}
+
+/** Waits before the next poll of CHIP_STATUS */
+static lt_ret_t lt_l1_poll_wait(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched)
+{
+#if LT_USE_INT_PIN
+    // In application, wait for INT pin which signalizes that response is ready. INT pin is not implemented
+    // in bootloader (maintenance) mode, so the chip is polled periodically there.
+    if (s2->mode == LT_MODE_APP) {
+        // Time is not accounted, waiting is limited by number of polls
+        sched->next_us = 0;
+        lt_ret_t ret = lt_l1_delay_on_int(s2, LT_L1_TIMEOUT_MS_MAX);
+        // When INT pin times out, CHIP_STATUS is polled again anyway, the chip may be just busy for longer.
+        if ((ret == LT_OK) || (ret == LT_L1_INT_TIMEOUT)) {
+            return LT_OK;
+        }
+        return ret;
+    }
+#endif
+    return lt_l1_delay_us(s2, sched->next_us);
+}
+
+#if LT_SPECULATIVE_READ
+/** Returns number of response bytes which are read speculatively together with CHIP_STATUS */
+static uint16_t lt_l1_spec_len_get(const lt_l2_state_t *s2, const lt_l1_poll_sched_t *sched)
+{
+    uint16_t spec_len = s2->spec_len;
+
+    if (spec_len == LT_L1_SPEC_LEN_AUTO) {
+#if LT_ADAPTIVE_POLLING
+        // Use the longest response of the awaited command seen so far
+        if (sched->stats && sched->stats->cnt) {
+            spec_len = sched->stats->len_max;
+        }
+#else
+        UNUSED(sched);
+#endif
+    }
+
+    // Buffer has room for CHIP_STATUS, STATUS and length bytes, the rest can be used for the response
+    if (spec_len > (LT_L1_LEN_MAX - 3)) {
+        spec_len = LT_L1_LEN_MAX - 3;
+    }
+
+    return spec_len;
+}
+#endif
+
+void lt_l1_read_start(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched)
+{
+    sched->waited_us = 0;
+    sched->polls = 0;
+    sched->next_us = 0;
+#if LT_ADAPTIVE_POLLING
+    lt_l1_poll_profile_t profile;
+    lt_l1_poll_profile_get(s2, s2->poll.cmd, &profile);
+    uint32_t first_delay_us = profile.first_delay_us;
+
+    sched->delay_us = profile.retry_delay_us;
+    sched->max_delay_us = profile.max_delay_us;
+    sched->stats = lt_l1_poll_stats_get(s2);
+
+    if (s2->poll.learn && sched->stats && sched->stats->cnt && (sched->stats->min_us > first_delay_us)) {
+        first_delay_us = sched->stats->min_us;
+    }
+
+    // Expected execution time of the awaited command
+    sched->next_us = first_delay_us;
+#endif
+#if LT_SPECULATIVE_READ
+    sched->spec_len = lt_l1_spec_len_get(s2, sched);
+#endif
+#if LT_USE_SPI_TRANSFER_BUF
+    sched->rx = NULL;
+    sched->rx_max = 0;
+#endif
+#if !LT_ADAPTIVE_POLLING && !LT_SPECULATIVE_READ
+    UNUSED(s2);
+#endif
+}
+
+uint8_t *lt_l1_rx_data(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max)
+{
+#if LT_USE_SPI_TRANSFER_BUF
+    // Longer (invalid) data would not leave room for CRC in L2 buffer, they are read there and refused later
+    if (rx && (s2->buff[2] <= rx_max) && (s2->buff[2] <= L2_CHUNK_MAX_DATA_SIZE)) {
+        return rx;
+    }
+#else
+    UNUSED(rx);
+    UNUSED(rx_max);
+#endif
+    return s2->buff + 3;
+}
+
+#if LT_USE_SPI_TRANSFER_BUF
+/** Returns where data of the response polled by `sched` are received */
+#define LT_L1_RX_DATA(s2, sched) lt_l1_rx_data((s2), (sched)->rx, (sched)->rx_max)
+#else
+#define LT_L1_RX_DATA(s2, sched) ((void)(sched), (s2)->buff + 3)
+#endif
+
+/** Receives the rest of the response after bytes read together with CHIP_STATUS, chip select stays low */
+static lt_ret_t lt_l1_read_rest(lt_l2_state_t *s2, const lt_l1_poll_sched_t *sched, const uint16_t spec_len,
+                                const uint32_t timeout_ms)
+{
+    // Take length information and add 2B for crc bytes
+    const uint16_t length = s2->buff[2] + 2;
+#if LT_USE_SPI_TRANSFER_BUF
+    uint8_t *rx = LT_L1_RX_DATA(s2, sched);
+    const uint16_t data_len = s2->buff[2];
+    if ((rx != s2->buff + 3) && (spec_len < data_len)) {
+        // Data read speculatively are moved to the destination, the rest of them is received straight there.
+        // The same bytes as without it are sent meanwhile, those of L2 buffer.
+        memcpy(rx, s2->buff + 3, spec_len);
+        lt_ret_t ret = lt_l1_spi_transfer_buf(s2, (uint8_t)(3 + spec_len), s2->buff + 3 + spec_len, rx + spec_len,
+                                              data_len - spec_len, timeout_ms);
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        // CRC goes to L2 buffer right behind the place of data
+        return lt_l1_spi_transfer(s2, (uint8_t)(3 + data_len), 2, timeout_ms);
+    }
+    if (rx != s2->buff + 3) {
+        // All data were read speculatively
+        memcpy(rx, s2->buff + 3, data_len);
+    }
+#else
+    UNUSED(sched);
+#endif
+    // Bytes which were not read already speculatively are received
+    if (length > spec_len) {
+        return lt_l1_spi_transfer(s2, 3 + spec_len, length - spec_len, timeout_ms);
+    }
+
+    return LT_OK;
+}
+
+/** Polls CHIP_STATUS once and reads the response when it is ready, see `lt_l1_read_step()` */
+static lt_ret_t lt_l1_read_poll(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched, const uint32_t timeout_ms)
+{
+    lt_ret_t ret;
+
+    // Caller has waited for the time requested after the previous poll
+    sched->waited_us += sched->next_us;
+    sched->next_us = 0;
+
+    if (!lt_l1_poll_continue(sched)) {
+        return LT_L1_CHIP_BUSY;
+    }
+    sched->polls++;
+
+#if LT_SPECULATIVE_READ
+    const uint16_t spec_len = sched->spec_len;
+#else
+    const uint16_t spec_len = 0;
+#endif
+
+    s2->buff[0] = GET_RESPONSE_REQ_ID;
+
+    // Read CHIP_STATUS byte together with STATUS and length bytes (and speculatively also with first spec_len
+    // bytes of response data), chip select is kept low after that.
+    // STATUS and length bytes are meaningful only when CHIP_STATUS contains READY bit.
+    const lt_l1_spi_segment_t poll_segs[] = {{.offset = 0, .len = 1, .cs_hold = 1},
+                                             {.offset = 1, .len = 2 + spec_len, .cs_hold = 1}};
+    ret = lt_l1_spi_transaction(s2, poll_segs, sizeof(poll_segs) / sizeof(poll_segs[0]), timeout_ms);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Check ALARM bit of CHIP_STATUS byte
+    if (s2->buff[0] & CHIP_MODE_ALARM_bit) {
+        lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
+        UNUSED(ret_unused);  // We don't care about it, we return LT_L1_CHIP_ALARM_MODE anyway.
+        return LT_L1_CHIP_ALARM_MODE;
+    }
+
+    // Check and save STARTUP bit of CHIP_STATUS to signalize whether device operates in bootloader or in
+    // application
+    lt_l1_mode_observe(s2, s2->buff[0]);
+
+    // Proceed further in case CHIP_STATUS contains READY bit and chip has a response to send. 0xFF received in
+    // second byte means that chip has no response to send.
+    if ((s2->buff[0] & CHIP_MODE_READY_bit) && (s2->buff[1] != 0xff)) {
+        // Take length information and add 2B for crc bytes
+        uint16_t length = s2->buff[2] + 2;
+        if (length > (LT_L1_LEN_MAX - 2)) {
+            lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return LT_L1_DATA_LEN_ERROR anyway.
+            return LT_L1_DATA_LEN_ERROR;
+        }
+        // Receive the rest of incomming bytes, including crc
+        ret = lt_l1_read_rest(s2, sched, spec_len, timeout_ms);
+        if (ret != LT_OK) {
+            lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
+            return ret;
+        }
+        ret = lt_l1_spi_csn_high(s2);
+        if (ret != LT_OK) {
+            return ret;
+        }
+#if LT_TRACE
+        lt_trace_record(s2, LT_TRACE_RX, s2->buff[1], s2->buff[2] + 5, LT_L1_RX_DATA(s2, sched), s2->buff[2]);
+#endif
+#if LT_ADAPTIVE_POLLING
+        lt_l1_poll_stats_update(sched, length);
+#endif
+#if LT_IDLE_SLEEP
+        lt_l1_idle_response(s2);
+#endif
+        return LT_OK;
+    }
+
+    // Chip is not ready or has no response yet, try it again (until max_tries runs out)
+    ret = lt_l1_spi_csn_high(s2);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    lt_l1_poll_next(sched);
+
+    return LT_PENDING;
+}
+
+#if LT_L1_OFFLOAD
+/** Reads the response polled by the port, see `lt_port_l1_read()` */
+static lt_ret_t lt_l1_read_offload(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched, const uint32_t max_len,
+                                   const uint32_t timeout_ms)
+{
+    lt_ret_t ret = lt_l1_offload_read(s2, max_len, timeout_ms);
+#if LT_NONBLOCKING
+    // Request is out and the port collects the response later, e.g. when its socket is readable. A caller which
+    // does not wait for the socket checks again after the shortest poll period.
+    if (ret == LT_PENDING) {
+        sched->next_us = LT_L1_READ_RETRY_DELAY_US_MIN;
+        return LT_PENDING;
+    }
+#endif
+
+    // CHIP_STATUS is meaningful also when the chip did not respond in time
+    if ((ret == LT_OK) || (ret == LT_L1_CHIP_BUSY)) {
+        lt_l1_mode_observe(s2, s2->buff[0]);
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+    // Port reads the whole frame into L2 buffer, its data are copied to the destination
+    uint8_t *rx = LT_L1_RX_DATA(s2, sched);
+    if (rx != s2->buff + 3) {
+        memcpy(rx, s2->buff + 3, s2->buff[2]);
+    }
+#if LT_TRACE
+    lt_trace_record(s2, LT_TRACE_RX, s2->buff[1], s2->buff[2] + 5, rx, s2->buff[2]);
+#endif
+#if LT_IDLE_SLEEP
+    lt_l1_idle_response(s2);
+#endif
+
+    return LT_OK;
+}
+#endif
+
+lt_ret_t lt_l1_read_step(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched, const uint32_t max_len,
+                         const uint32_t timeout_ms)
 {
 #ifdef LIBT_DEBUG
-    if (!s2) {
+    if (!s2 || !sched) {
         return LT_PARAM_ERR;
     }
     if ((timeout_ms < LT_L1_TIMEOUT_MS_MIN) | (timeout_ms > LT_L1_TIMEOUT_MS_MAX)) {
@@ -52,128 +502,93 @@ lt_ret_t lt_l1_read(lt_l2_state_t *s2, const uint32_t max_len, const uint32_t ti
     UNUSED(max_len);
 #endif
 
-    lt_ret_t ret;
-    int max_tries = LT_L1_READ_MAX_TRIES;
+#if LT_L1_OFFLOAD
+    lt_ret_t ret = s2->l1_offload ? lt_l1_read_offload(s2, sched, max_len, timeout_ms)
+                                  : lt_l1_read_poll(s2, sched, timeout_ms);
+#else
+    lt_ret_t ret = lt_l1_read_poll(s2, sched, timeout_ms);
+#endif
+#if LT_HOOKS
+    if (ret != LT_PENDING) {
+        // STATUS and length bytes are valid only in a received response
+        lt_hook_post(s2, LT_HOOK_L2_FRAME, (ret == LT_OK) ? s2->buff[1] : 0, (ret == LT_OK) ? s2->buff[2] : 0, ret);
+    }
+#endif
 
-    while (max_tries > 0) {
-        max_tries--;
+    return ret;
+}
 
-        s2->buff[0] = GET_RESPONSE_REQ_ID;
+/** Waits for the response and reads it, polling was prepared by `lt_l1_read_start()` */
+static lt_ret_t lt_l1_read_sched(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched, const uint32_t max_len,
+                                 const uint32_t timeout_ms)
+{
+    lt_ret_t ret;
 
-        // Try to read CHIP_STATUS byte
-        ret = lt_l1_spi_csn_low(s2);
+#if LT_L1_OFFLOAD
+    // The port waits and polls next to TROPIC01, the response arrives in one step
+    if (s2->l1_offload) {
+        return lt_l1_read_step(s2, sched, max_len, timeout_ms);
+    }
+#endif
+
+    // Wait for the expected execution time of the awaited command
+    if (sched->next_us) {
+        ret = lt_l1_delay_us(s2, sched->next_us);
         if (ret != LT_OK) {
             return ret;
         }
+    }
 
-        ret = lt_l1_spi_transfer(s2, 0, 1, timeout_ms);
+    while ((ret = lt_l1_read_step(s2, sched, max_len, timeout_ms)) == LT_PENDING) {
+        ret = lt_l1_poll_wait(s2, sched);
         if (ret != LT_OK) {
-            lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
-            UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
             return ret;
         }
+    }
 
-        // Check ALARM bit of CHIP_STATUS byte
-        if (s2->buff[0] & CHIP_MODE_ALARM_bit) {
-            lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
-            UNUSED(ret_unused);  // We don't care about it, we return LT_L1_CHIP_ALARM_MODE anyway.
-            return LT_L1_CHIP_ALARM_MODE;
-        }
-
-        // Check and save STARTUP bit of CHIP_STATUS to signalize whether device operates in bootloader or in
-        // application
-        if (s2->buff[0] & CHIP_MODE_STARTUP_bit) {
-            s2->mode = LT_MODE_MAINTENANCE;
-        }
-        else {
-            s2->mode = LT_MODE_APP;
-        }
-
-        // Proceed further in case CHIP_STATUS contains READY bit, signalizing that chip is ready to receive request
-        if (s2->buff[0] & (CHIP_MODE_READY_bit)) {
-            // receive STATUS byte and length byte
-            ret = lt_l1_spi_transfer(s2, 1, 2, timeout_ms);
-            if (ret != LT_OK) {  // offset 1
-                lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
-                UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
-                return ret;
-            }
-
-            // 0xFF received in second byte means that chip has no response to send.
-            if (s2->buff[1] == 0xff) {
-                ret = lt_l1_spi_csn_high(s2);
-                if (ret != LT_OK) {
-                    return ret;
-                }
-                ret = lt_l1_delay(s2, LT_L1_READ_RETRY_DELAY);
-                if (ret != LT_OK) {
-                    return ret;
-                }
-                continue;
-            }
-
-            // Take length information and add 2B for crc bytes
-            uint16_t length = s2->buff[2] + 2;
-            if (length > (LT_L1_LEN_MAX - 2)) {
-                lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
-                UNUSED(ret_unused);  // We don't care about it, we return LT_L1_DATA_LEN_ERROR anyway.
-                return LT_L1_DATA_LEN_ERROR;
-            }
-            // Receive the rest of incomming bytes, including crc
-            ret = lt_l1_spi_transfer(s2, 3, length, timeout_ms);
-            if (ret != LT_OK) {  // offset 3
-                lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
-                UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
-                return ret;
-            }
-            ret = lt_l1_spi_csn_high(s2);
-            if (ret != LT_OK) {
-                return ret;
-            }
-#ifdef LT_PRINT_SPI_DATA
-            print_hex_chunks(s2->buff, s2->buff[2] + 5, SPI_DIR_MISO);
-#endif
-            return LT_OK;
+    return ret;
+}
 
-            // Chip status does not contain any special mode bit and also is not ready,
-            // try it again (until max_tries runs out)
-        }
-        else {
-            ret = lt_l1_spi_csn_high(s2);
-            if (ret != LT_OK) {
-                return ret;
-            }
-            if (s2->mode == LT_MODE_MAINTENANCE) {
-                // Chip is in bootloader mode and INT pin is not implemented in bootloader mode
-                // So we wait a bit before we poll again for CHIP_STATUS
-                // printf("x\n");
-                ret = lt_l1_delay(s2, LT_L1_READ_RETRY_DELAY);
-                if (ret != LT_OK) {
-                    return ret;
-                }
-            }
-            else {
-                // We are in application. IF INT pin is enabled, wait for it to go low
-#if LT_USE_INT_PIN
-                ret = lt_l1_delay_on_int(h, LT_L1_TIMEOUT_MS_MAX);
-                if (ret != LT_OK) {
-                    return ret;
-                }
-#else
-                ret = lt_l1_delay(s2, LT_L1_READ_RETRY_DELAY);
-                if (ret != LT_OK) {
-                    return ret;
-                }
+lt_ret_t lt_l1_read(lt_l2_state_t *s2, const uint32_t max_len, const uint32_t timeout_ms)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_L1_READ);
+#ifdef LIBT_DEBUG
+    if (!s2) {
+        return LT_PARAM_ERR;
+    }
 #endif
-            }
-        }
+
+    lt_l1_poll_sched_t sched;
+
+    lt_l1_read_start(s2, &sched);
+
+    return lt_l1_read_sched(s2, &sched, max_len, timeout_ms);
+}
+
+#if LT_USE_SPI_TRANSFER_BUF
+lt_ret_t lt_l1_read_to(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max, const uint32_t max_len,
+                       const uint32_t timeout_ms)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_L1_READ);
+#ifdef LIBT_DEBUG
+    if (!s2) {
+        return LT_PARAM_ERR;
     }
+#endif
+
+    lt_l1_poll_sched_t sched;
 
-    return LT_L1_CHIP_BUSY;
+    lt_l1_read_start(s2, &sched);
+    sched.rx = rx;
+    sched.rx_max = rx_max;
+
+    return lt_l1_read_sched(s2, &sched, max_len, timeout_ms);
 }
+#endif
 
 lt_ret_t lt_l1_write(lt_l2_state_t *s2, const uint16_t len, const uint32_t timeout_ms)
 {
+    LT_PROFILE_SCOPE(LT_PROFILE_L1_WRITE);
 #ifdef LIBT_DEBUG
     if (!s2) {
         return LT_PARAM_ERR;
@@ -186,26 +601,120 @@ lt_ret_t lt_l1_write(lt_l2_state_t *s2, const uint16_t len, const uint32_t timeo
     }
 #endif
 
-    lt_ret_t ret;
+#if LT_TRACE
+    lt_trace_record(s2, LT_TRACE_TX, s2->buff[0], len, s2->buff + 2, len - 2);
+#endif
+#if LT_HOOKS
+    lt_hook_pre(s2, LT_HOOK_L2_FRAME, NULL, s2->buff[0], len, 0);
+#endif
+#if LT_IDLE_SLEEP
+    lt_l1_idle_request(s2);
+#endif
+    const lt_l1_spi_segment_t seg = {.offset = 0, .len = len, .cs_hold = 0};
+#if LT_L1_OFFLOAD
+    if (s2->l1_offload) {
+        return lt_l1_offload_write(s2, &seg, 1, timeout_ms);
+    }
+#endif
 
-    ret = lt_l1_spi_csn_low(s2);
-    if (ret != LT_OK) {
-        return ret;
+    return lt_l1_spi_transaction(s2, &seg, 1, timeout_ms);
+}
+
+lt_ret_t lt_l1_write_segments(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, const uint8_t seg_cnt,
+                              const uint32_t timeout_ms)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || !segs || !seg_cnt || (seg_cnt > LT_L1_SPI_SEGMENTS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    if ((timeout_ms < LT_L1_TIMEOUT_MS_MIN) | (timeout_ms > LT_L1_TIMEOUT_MS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    uint32_t len = 0;
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        len += segs[i].len;
+    }
+    if ((len < LT_L1_LEN_MIN) | (len > LT_L1_LEN_MAX)) {
+        return LT_PARAM_ERR;
     }
-#ifdef LT_PRINT_SPI_DATA
-    print_hex_chunks(s2->buff, len, SPI_DIR_MOSI);
 #endif
-    ret = lt_l1_spi_transfer(s2, 0, len, timeout_ms);
-    if (ret != LT_OK) {
-        lt_ret_t ret_unused = lt_l1_spi_csn_high(s2);
-        UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
-        return ret;
+
+#if LT_TRACE
+    lt_l1_trace_segments(s2, segs, seg_cnt);
+#endif
+#if LT_HOOKS
+    if (s2->hooks) {
+        uint16_t frame_len = 0;
+        for (uint8_t i = 0; i < seg_cnt; i++) {
+            frame_len += segs[i].len;
+        }
+        lt_hook_pre(s2, LT_HOOK_L2_FRAME, NULL, segs[0].tx ? segs[0].tx[0] : s2->buff[segs[0].offset], frame_len, 0);
+    }
+#endif
+#if LT_IDLE_SLEEP
+    lt_l1_idle_request(s2);
+#endif
+#if LT_L1_OFFLOAD
+    if (s2->l1_offload) {
+        return lt_l1_offload_write(s2, segs, seg_cnt, timeout_ms);
     }
+#endif
 
-    ret = lt_l1_spi_csn_high(s2);
-    if (ret != LT_OK) {
-        return ret;
+    return lt_l1_spi_transaction(s2, segs, seg_cnt, timeout_ms);
+}
+
+void lt_l1_mode_observe(lt_l2_state_t *s2, const uint8_t chip_status)
+{
+    if (chip_status & CHIP_MODE_STARTUP_bit) {
+        s2->mode = LT_MODE_MAINTENANCE;
+#if LT_SESSION_LIVENESS
+        // Bootloader has no session, 0xFF is not driven by TROPIC01 and tells nothing
+        if (chip_status != 0xFF) {
+            lt_l1_session_lost(s2, LT_LIVENESS_STARTUP);
+        }
+#endif
+    }
+    else {
+        s2->mode = LT_MODE_APP;
     }
 
-    return LT_OK;
+#if LT_MODE_TRACK
+    // 0xFF is read when nothing drives MISO, e.g. while TROPIC01 boots, it tells nothing about the mode
+    if (s2->mode_track && (chip_status != 0xFF)) {
+        s2->mode_track->seen_us = s2->mode_track->time_us();
+        s2->mode_track->valid = 1;
+    }
+#endif
 }
+
+#if LT_SESSION_LIVENESS
+void lt_l1_session_lost(lt_l2_state_t *s2, const lt_liveness_reason_t reason)
+{
+    lt_liveness_t *l = s2->liveness;
+
+    if (!l || !l->alive) {
+        return;
+    }
+    l->alive = 0;
+    l->losses++;
+    if (l->lost) {
+        l->lost(l->ctx, reason);
+    }
+}
+#endif
+
+#if LT_MODE_TRACK
+bool lt_l1_mode_fresh(const lt_l2_state_t *s2)
+{
+    const lt_mode_track_t *t = s2->mode_track;
+
+    return t && t->valid && ((uint32_t)(t->time_us() - t->seen_us) < t->max_age_us);
+}
+
+void lt_l1_mode_forget(lt_l2_state_t *s2)
+{
+    if (s2->mode_track) {
+        s2->mode_track->valid = 0;
+    }
+}
+#endif
@@ -17,7 +17,11 @@
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "libtropic_common.h"
+#include "libtropic_port.h"
 
 /** This bit in CHIP_STATUS byte signalizes that chip is ready to accept requests */
 #define CHIP_MODE_READY_bit 0x01
@@ -30,6 +34,8 @@
 #define LT_L1_READ_MAX_TRIES 50
 /** Number of ms to wait between each GET_INFO request */
 #define LT_L1_READ_RETRY_DELAY 25
+/** Minimal gap in us between two polls of CHIP_STATUS, used with LT_ADAPTIVE_POLLING */
+#define LT_L1_READ_RETRY_DELAY_US_MIN 100
 
 /** Minimal timeout when waiting for activity on SPI bus */
 #define LT_L1_TIMEOUT_MS_MIN 5
@@ -52,6 +58,72 @@
 lt_ret_t lt_l1_read(lt_l2_state_t *s2, const uint32_t max_len, const uint32_t timeout_ms)
     __attribute__((warn_unused_result));
 
+#if LT_USE_SPI_TRANSFER_BUF
+/**
+ * @brief Reads data from TROPIC01 like `lt_l1_read()`, but data of the response are received into `rx`
+ *
+ * Only CHIP_STATUS, STATUS, length and CRC bytes are received into L2 buffer, at their usual places, data go straight
+ * to `rx` by `lt_port_spi_transfer_buf()`. Data read speculatively (or by the port with LT_L1_OFFLOAD) are copied
+ * there. Response with more than `rx_max` bytes of data is received whole into L2 buffer, see `lt_l1_rx_data()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param rx          Destination of data of the response, NULL for L2 buffer
+ * @param rx_max      Size of `rx`
+ * @param max_len     Max len of receive buffer
+ * @param timeout_ms  Timeout - how long function will wait for response
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_read_to(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max, const uint32_t max_len,
+                       const uint32_t timeout_ms) __attribute__((warn_unused_result));
+#endif
+
+/**
+ * @brief Returns where data of the response in L2 buffer were received by `lt_l1_read_to()`
+ *
+ * @param s2          Structure holding l2 state with the response
+ * @param rx          Destination passed to `lt_l1_read_to()`
+ * @param rx_max      Size of `rx`
+ * @return            `rx`, or data in L2 buffer, when they did not fit (or are always there without
+ *                    LT_USE_SPI_TRANSFER_BUF)
+ */
+uint8_t *lt_l1_rx_data(lt_l2_state_t *s2, uint8_t *rx, const uint16_t rx_max) __attribute__((warn_unused_result));
+
+/**
+ * @brief Prepares polling for one response, without any waiting. Used by `lt_l1_read()` and by non-blocking
+ * transfers.
+ *
+ * After return, `sched->next_us` holds time to wait before the first call of `lt_l1_read_step()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param sched       Polling state to be initialized
+ */
+void lt_l1_read_start(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched);
+
+#if LT_ADAPTIVE_POLLING
+/**
+ * @brief Copies polling profile used for the command into `profile`, the handle's one or the default one
+ *
+ * @param s2          Structure holding l2 state
+ * @param cmd         LT_L1_POLL_CMD_L2(), LT_L1_POLL_CMD_L3() or LT_L1_POLL_CMD_L3_CHUNK key of the command
+ * @param profile     Profile
+ */
+void lt_l1_poll_profile_get(const lt_l2_state_t *s2, const uint16_t cmd, lt_l1_poll_profile_t *profile);
+#endif
+
+/**
+ * @brief Polls CHIP_STATUS once and reads the response if the chip has one, never waits between polls.
+ *
+ * @param s2          Structure holding l2 state
+ * @param sched       Polling state initialized by `lt_l1_read_start()`
+ * @param max_len     Max len of receive buffer
+ * @param timeout_ms  Timeout of SPI transfers
+ * @retval            LT_OK Response was received into L2 buffer
+ * @retval            LT_PENDING Chip has no response yet, poll again after `sched->next_us`
+ * @retval            other Error, polling is finished
+ */
+lt_ret_t lt_l1_read_step(lt_l2_state_t *s2, lt_l1_poll_sched_t *sched, const uint32_t max_len,
+                         const uint32_t timeout_ms) __attribute__((warn_unused_result));
+
 /**
  * @brief Writes data from host platform into TROPIC01
  *
@@ -63,6 +135,56 @@ lt_ret_t lt_l1_read(lt_l2_state_t *s2, const uint32_t max_len, const uint32_t ti
 lt_ret_t lt_l1_write(lt_l2_state_t *s2, const uint16_t len, const uint32_t timeout_ms)
     __attribute__((warn_unused_result));
 
+/**
+ * @brief Writes one frame assembled from several segments from host platform into TROPIC01
+ *
+ * @note Segments with `tx` set are sent without copying them into handle's buffer when the port implements
+ *       `lt_port_spi_transaction()`. Only the last segment may release chip select.
+ *
+ * @param s2          Structure holding l2 state
+ * @param segs        Segments of the frame
+ * @param seg_cnt     Number of segments, at most `LT_L1_SPI_SEGMENTS_MAX`
+ * @param timeout_ms  Timeout
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_write_segments(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, const uint8_t seg_cnt,
+                              const uint32_t timeout_ms) __attribute__((warn_unused_result));
+
+/**
+ * @brief Sets `s2->mode` from the STARTUP bit of CHIP_STATUS, with LT_MODE_TRACK also notes the time of it
+ *
+ * @param s2          Structure holding l2 state
+ * @param chip_status CHIP_STATUS byte read from TROPIC01
+ */
+void lt_l1_mode_observe(lt_l2_state_t *s2, const uint8_t chip_status);
+
+#if LT_SESSION_LIVENESS
+/**
+ * @brief Notes that the secure session was lost and calls `lost` callback of `s2->liveness`, once per session
+ *
+ * @param s2          Structure holding l2 state
+ * @param reason      Evidence of the loss
+ */
+void lt_l1_session_lost(lt_l2_state_t *s2, const lt_liveness_reason_t reason);
+#endif
+
+#if LT_MODE_TRACK
+/**
+ * @brief Tells whether `s2->mode` was observed within `max_age_us` of `s2->mode_track`
+ *
+ * @param s2          Structure holding l2 state
+ * @return            true when the mode does not need to be read again
+ */
+bool lt_l1_mode_fresh(const lt_l2_state_t *s2);
+
+/**
+ * @brief Forgets the last observation of the mode, e.g. when TROPIC01 reboots
+ *
+ * @param s2          Structure holding l2 state
+ */
+void lt_l1_mode_forget(lt_l2_state_t *s2);
+#endif
+
 /** @} */  // end of group_l1_functions
 
 #endif
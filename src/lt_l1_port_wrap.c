@@ -11,9 +11,130 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "libtropic_common.h"
+#include "libtropic_macros.h"
 #include "libtropic_port.h"
+#include "libtropic_port_ops.h"
+#include "lt_hooks.h"
+#include "lt_record.h"
+#include "lt_stats.h"
+
+#if LT_DEADLINE
+/** Time in us left until the deadline of the handle, UINT32_MAX when no deadline is set */
+static lt_ret_t lt_l1_deadline_left(const lt_l2_state_t *s2, uint32_t *left_us)
+{
+    const lt_deadline_t *d = s2->deadline;
+
+    *left_us = UINT32_MAX;
+    if (!d || !d->armed || !d->time_us) {
+        return LT_OK;
+    }
+
+    // Signed difference is correct also when the clock wrapped around
+    int32_t left = (int32_t)(d->at_us - d->time_us());
+    if (left <= 0) {
+        return LT_DEADLINE_EXCEEDED;
+    }
+    *left_us = (uint32_t)left;
+
+    return LT_OK;
+}
+
+/** Limits timeout of a port call to the time left until the deadline */
+static lt_ret_t lt_l1_deadline_clip_ms(const lt_l2_state_t *s2, uint32_t *timeout_ms)
+{
+    uint32_t left_us;
+    lt_ret_t ret = lt_l1_deadline_left(s2, &left_us);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (LT_US_TO_MS_CEIL((uint64_t)left_us) < *timeout_ms) {
+        *timeout_ms = (uint32_t)LT_US_TO_MS_CEIL((uint64_t)left_us);
+    }
+
+    return LT_OK;
+}
+#endif
+
+static lt_ret_t lt_l1_port_init(lt_l2_state_t *s2)
+{
+#if LT_RECORD
+    lt_ret_t ret = lt_port_init(s2);
+    lt_record_op(s2, LT_RECORD_OP_INIT, ret, NULL, 0);
+
+    return ret;
+#else
+    return lt_port_init(s2);
+#endif
+}
+
+static lt_ret_t lt_l1_port_deinit(lt_l2_state_t *s2)
+{
+#if LT_RECORD
+    lt_ret_t ret = lt_port_deinit(s2);
+    lt_record_op(s2, LT_RECORD_OP_DEINIT, ret, NULL, 0);
+
+    return ret;
+#else
+    return lt_port_deinit(s2);
+#endif
+}
+
+#if LT_PORT_SHARE
+/** Takes a reference of the shared device, only the first one initializes it */
+static lt_ret_t lt_l1_share_attach(lt_l2_state_t *s2)
+{
+    lt_port_share_t *share = s2->port_share;
+
+    if (!share->refs) {
+        lt_ret_t ret = lt_l1_port_init(s2);
+        if (ret == LT_OK) {
+            share->refs = 1;
+        }
+        return ret;
+    }
+
+#if LT_THREAD_SAFE
+    // Lock of the device is initialized while there is a reference
+    lt_port_lock(s2);
+#endif
+    lt_ret_t ret = LT_OK;
+    if (share->refs == UINT16_MAX) {
+        ret = LT_FAIL;
+    }
+    else {
+        share->refs++;
+    }
+#if LT_THREAD_SAFE
+    lt_port_unlock(s2);
+#endif
+
+    return ret;
+}
+
+/** Releases a reference of the shared device, the last one deinitializes it */
+static lt_ret_t lt_l1_share_detach(lt_l2_state_t *s2)
+{
+    lt_port_share_t *share = s2->port_share;
+
+    if (!share->refs) {
+        return LT_FAIL;
+    }
+
+#if LT_THREAD_SAFE
+    lt_port_lock(s2);
+#endif
+    share->refs--;
+    uint16_t refs = share->refs;
+#if LT_THREAD_SAFE
+    lt_port_unlock(s2);
+#endif
+
+    return refs ? LT_OK : lt_l1_port_deinit(s2);
+}
+#endif
 
 lt_ret_t lt_l1_init(lt_l2_state_t *s2)
 {
@@ -22,7 +143,13 @@ lt_ret_t lt_l1_init(lt_l2_state_t *s2)
         return LT_PARAM_ERR;
     }
 #endif
-    return lt_port_init(s2);
+#if LT_PORT_SHARE
+    if (s2->port_share) {
+        return lt_l1_share_attach(s2);
+    }
+#endif
+
+    return lt_l1_port_init(s2);
 }
 
 lt_ret_t lt_l1_deinit(lt_l2_state_t *s2)
@@ -32,9 +159,16 @@ lt_ret_t lt_l1_deinit(lt_l2_state_t *s2)
         return LT_PARAM_ERR;
     }
 #endif
-    return lt_port_deinit(s2);
+#if LT_PORT_SHARE
+    if (s2->port_share) {
+        return lt_l1_share_detach(s2);
+    }
+#endif
+
+    return lt_l1_port_deinit(s2);
 }
 
+#if !LT_L1_INLINE
 lt_ret_t lt_l1_spi_csn_low(lt_l2_state_t *s2)
 {
 #ifdef LIBT_DEBUG
@@ -42,7 +176,14 @@ lt_ret_t lt_l1_spi_csn_low(lt_l2_state_t *s2)
         return LT_PARAM_ERR;
     }
 #endif
+#if LT_RECORD
+    lt_ret_t ret = lt_port_spi_csn_low(s2);
+    lt_record_op(s2, LT_RECORD_OP_CSN_LOW, ret, NULL, 0);
+
+    return ret;
+#else
     return lt_port_spi_csn_low(s2);
+#endif
 }
 
 lt_ret_t lt_l1_spi_csn_high(lt_l2_state_t *s2)
@@ -52,9 +193,58 @@ lt_ret_t lt_l1_spi_csn_high(lt_l2_state_t *s2)
         return LT_PARAM_ERR;
     }
 #endif
+#if LT_RECORD
+    lt_ret_t ret = lt_port_spi_csn_high(s2);
+    lt_record_op(s2, LT_RECORD_OP_CSN_HIGH, ret, NULL, 0);
+
+    return ret;
+#else
     return lt_port_spi_csn_high(s2);
+#endif
+}
+#endif
+
+#if LT_USE_PORT_CACHE
+/** Offset of the first LT_L2_BUFF_ALIGN unit of L2 buffer holding `offset` */
+#define LT_L1_CACHE_START(offset) (((offset) / LT_L2_BUFF_ALIGN) * LT_L2_BUFF_ALIGN)
+/** Length of whole units holding `len` bytes from `offset`, they all lie in L2 buffer, which is padded */
+#define LT_L1_CACHE_LEN(offset, len) \
+    (((((offset) + (len) + LT_L2_BUFF_ALIGN - 1) / LT_L2_BUFF_ALIGN) * LT_L2_BUFF_ALIGN) - LT_L1_CACHE_START(offset))
+
+/** Writes cached part of L2 buffer back to memory before DMA sends it, invalid range is left to the port to refuse */
+static void lt_l1_cache_clean(lt_l2_state_t *s2, uint16_t offset, uint16_t len)
+{
+    if (offset + len <= LT_L1_LEN_MAX) {
+        lt_port_cache_clean(s2, s2->buff + LT_L1_CACHE_START(offset), LT_L1_CACHE_LEN(offset, len));
+    }
+}
+
+/** Discards cached part of L2 buffer after DMA received into it */
+static void lt_l1_cache_invalidate(lt_l2_state_t *s2, uint16_t offset, uint16_t len)
+{
+    if (offset + len <= LT_L1_LEN_MAX) {
+        lt_port_cache_invalidate(s2, s2->buff + LT_L1_CACHE_START(offset), LT_L1_CACHE_LEN(offset, len));
+    }
 }
+#endif
+
+#if !LT_L1_INLINE || !LT_USE_SPI_TRANSACTION || LT_PORT_OPS
+/** Transfers a part of L2 buffer by the port, with maintenance of data cache around it */
+static lt_ret_t lt_l1_port_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len, uint32_t timeout_ms)
+{
+#if LT_USE_PORT_CACHE
+    lt_l1_cache_clean(s2, offset, tx_len);
+    lt_ret_t ret = lt_port_spi_transfer(s2, offset, tx_len, timeout_ms);
+    lt_l1_cache_invalidate(s2, offset, tx_len);
+
+    return ret;
+#else
+    return lt_port_spi_transfer(s2, offset, tx_len, timeout_ms);
+#endif
+}
+#endif
 
+#if !LT_L1_INLINE
 lt_ret_t lt_l1_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len, uint32_t timeout_ms)
 {
 #ifdef LIBT_DEBUG
@@ -62,9 +252,240 @@ lt_ret_t lt_l1_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len,
         return LT_PARAM_ERR;
     }
 #endif
-    return lt_port_spi_transfer(s2, offset, tx_len, timeout_ms);
+#if LT_DEADLINE
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &timeout_ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_l1_port_transfer(s2, offset, tx_len, timeout_ms);
+    lt_stats_time(s2, LT_STATS_TRANSFER, start_us);
+    lt_stats_bytes(s2, tx_len);
+#else
+    lt_ret_t ret = lt_l1_port_transfer(s2, offset, tx_len, timeout_ms);
+#endif
+#if LT_RECORD
+    lt_record_op(s2, LT_RECORD_OP_TRANSFER, ret, s2->buff + offset, (offset + tx_len <= LT_L1_LEN_MAX) ? tx_len : 0);
+#endif
+
+    return ret;
+}
+#endif
+
+#if LT_USE_SPI_TRANSFER_BUF
+/** Transfers from and to any buffers by the port, or emulates it in L2 buffer when the port does not provide it */
+static lt_ret_t lt_l1_port_transfer_buf(lt_l2_state_t *s2, uint8_t offset, const uint8_t *tx, uint8_t *rx,
+                                        uint16_t len, uint32_t timeout_ms)
+{
+#if LT_PORT_OPS
+    if (!s2->ops->spi_transfer_buf) {
+        if (offset + len > LT_L1_LEN_MAX) {
+            return LT_L1_DATA_LEN_ERROR;
+        }
+        memcpy(s2->buff + offset, tx ? tx : rx, len);
+        lt_ret_t ret = lt_l1_port_transfer(s2, offset, len, timeout_ms);
+        if ((ret == LT_OK) && rx) {
+            memcpy(rx, s2->buff + offset, len);
+        }
+
+        return ret;
+    }
+#else
+    UNUSED(offset);
+#endif
+#if LT_USE_PORT_CACHE
+    // Buffers are passed as they are, the receiving one is also cleaned, so no dirty line is written over it later
+    if (tx) {
+        lt_port_cache_clean(s2, tx, len);
+    }
+    if (rx) {
+        lt_port_cache_clean(s2, rx, len);
+    }
+    lt_ret_t ret = lt_port_spi_transfer_buf(s2, tx, rx, len, timeout_ms);
+    if (rx) {
+        lt_port_cache_invalidate(s2, rx, len);
+    }
+
+    return ret;
+#else
+    return lt_port_spi_transfer_buf(s2, tx, rx, len, timeout_ms);
+#endif
+}
+
+lt_ret_t lt_l1_spi_transfer_buf(lt_l2_state_t *s2, uint8_t offset, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                uint32_t timeout_ms)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || (!tx && !rx)) {
+        return LT_PARAM_ERR;
+    }
+#endif
+#if LT_DEADLINE
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &timeout_ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_l1_port_transfer_buf(s2, offset, tx, rx, len, timeout_ms);
+    lt_stats_time(s2, LT_STATS_TRANSFER, start_us);
+    lt_stats_bytes(s2, len);
+#else
+    lt_ret_t ret = lt_l1_port_transfer_buf(s2, offset, tx, rx, len, timeout_ms);
+#endif
+#if LT_RECORD
+    // Recorded as a plain transfer of the received bytes
+    lt_record_op(s2, LT_RECORD_OP_TRANSFER, ret, rx ? rx : tx, len);
+#endif
+
+    return ret;
+}
+#endif
+
+#if !LT_USE_SPI_TRANSACTION || LT_PORT_OPS
+/** Emulates SPI transaction by the other port functions */
+static lt_ret_t lt_l1_spi_segments_emulated(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                            uint32_t timeout_ms)
+{
+    lt_ret_t ret;
+
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        // Chip select is low already if previous segment holds it.
+        if ((i == 0) || !segs[i - 1].cs_hold) {
+            ret = lt_port_spi_csn_low(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+
+        // Port transfers only the handle's buffer, data sent from elsewhere have to be copied there.
+        if (segs[i].tx) {
+            if (segs[i].offset + segs[i].len > LT_L1_LEN_MAX) {
+                lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+                UNUSED(ret_unused);  // We don't care about it, we return the length error anyway.
+                return LT_L1_DATA_LEN_ERROR;
+            }
+            memcpy(s2->buff + segs[i].offset, segs[i].tx, segs[i].len);
+        }
+
+        ret = lt_l1_port_transfer(s2, segs[i].offset, segs[i].len, timeout_ms);
+        if (ret != LT_OK) {
+            lt_ret_t ret_unused = lt_port_spi_csn_high(s2);
+            UNUSED(ret_unused);  // We don't care about it, we return ret from SPI transfer anyway.
+            return ret;
+        }
+
+        if (!segs[i].cs_hold) {
+            ret = lt_port_spi_csn_high(s2);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+    }
+
+    return LT_OK;
+}
+#endif
+
+/** Does SPI transaction by the port, or emulates it when the port does not provide it */
+static lt_ret_t lt_l1_spi_segments(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                   uint32_t timeout_ms)
+{
+#if LT_USE_SPI_TRANSACTION
+#if LT_PORT_OPS
+    if (!s2->ops->spi_transaction) {
+        return lt_l1_spi_segments_emulated(s2, segs, seg_cnt, timeout_ms);
+    }
+#endif
+#if LT_USE_PORT_CACHE
+    // Segments sent in place are only cleaned, received data are always in L2 buffer
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if (segs[i].tx) {
+            lt_port_cache_clean(s2, segs[i].tx, segs[i].len);
+        }
+        else {
+            lt_l1_cache_clean(s2, segs[i].offset, segs[i].len);
+        }
+    }
+
+    lt_ret_t ret = lt_port_spi_transaction(s2, segs, seg_cnt, timeout_ms);
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if (!segs[i].tx) {
+            lt_l1_cache_invalidate(s2, segs[i].offset, segs[i].len);
+        }
+    }
+
+    return ret;
+#else
+    return lt_port_spi_transaction(s2, segs, seg_cnt, timeout_ms);
+#endif
+#else
+    return lt_l1_spi_segments_emulated(s2, segs, seg_cnt, timeout_ms);
+#endif
+}
+
+#if LT_RECORD
+/**
+ * Records transaction as the port calls of its emulation, so it is replayed the same regardless of
+ * LT_USE_SPI_TRANSACTION. Failed transaction is recorded as one failed transfer.
+ */
+static void lt_l1_record_segments(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                  lt_ret_t ret)
+{
+    if (ret != LT_OK) {
+        lt_record_op(s2, LT_RECORD_OP_CSN_LOW, LT_OK, NULL, 0);
+        lt_record_op(s2, LT_RECORD_OP_TRANSFER, ret, s2->buff, 0);
+        lt_record_op(s2, LT_RECORD_OP_CSN_HIGH, LT_OK, NULL, 0);
+        return;
+    }
+
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        if ((i == 0) || !segs[i - 1].cs_hold) {
+            lt_record_op(s2, LT_RECORD_OP_CSN_LOW, LT_OK, NULL, 0);
+        }
+        lt_record_op(s2, LT_RECORD_OP_TRANSFER, LT_OK, s2->buff + segs[i].offset, segs[i].len);
+        if (!segs[i].cs_hold) {
+            lt_record_op(s2, LT_RECORD_OP_CSN_HIGH, LT_OK, NULL, 0);
+        }
+    }
+}
+#endif
+
+lt_ret_t lt_l1_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                               uint32_t timeout_ms)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || !segs || !seg_cnt || (seg_cnt > LT_L1_SPI_SEGMENTS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+#endif
+#if LT_DEADLINE
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &timeout_ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_l1_spi_segments(s2, segs, seg_cnt, timeout_ms);
+    lt_stats_time(s2, LT_STATS_TRANSFER, start_us);
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        lt_stats_bytes(s2, segs[i].len);
+    }
+#else
+    lt_ret_t ret = lt_l1_spi_segments(s2, segs, seg_cnt, timeout_ms);
+#endif
+#if LT_RECORD
+    lt_l1_record_segments(s2, segs, seg_cnt, ret);
+#endif
+
+    return ret;
 }
 
+#if !LT_L1_INLINE
 lt_ret_t lt_l1_delay(lt_l2_state_t *s2, uint32_t ms)
 {
 #ifdef LIBT_DEBUG
@@ -72,7 +493,82 @@ lt_ret_t lt_l1_delay(lt_l2_state_t *s2, uint32_t ms)
         return LT_PARAM_ERR;
     }
 #endif
-    return lt_port_delay(s2, ms);
+#if LT_DEADLINE
+    // Waiting past the deadline is useless, the call fails right after it
+    uint32_t left_ms = ms;
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &left_ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+    if (left_ms < ms) {
+        ret_deadline = LT_DEADLINE_EXCEEDED;
+        ms = left_ms;
+    }
+#endif
+#if LT_HOOKS
+    lt_hook_pre(s2, LT_HOOK_DELAY, NULL, 0, 0, ms * 1000u);
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_port_delay(s2, ms);
+    lt_stats_time(s2, LT_STATS_POLL, start_us);
+#else
+    lt_ret_t ret = lt_port_delay(s2, ms);
+#endif
+#if LT_HOOKS
+    lt_hook_post(s2, LT_HOOK_DELAY, 0, 0, ret);
+#endif
+#if LT_DEADLINE
+    if (ret == LT_OK) {
+        ret = ret_deadline;
+    }
+#endif
+
+    return ret;
+}
+
+lt_ret_t lt_l1_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+#ifdef LIBT_DEBUG
+    if (!s2) {
+        return LT_PARAM_ERR;
+    }
+#endif
+#if LT_DEADLINE
+    uint32_t left_us;
+    lt_ret_t ret_deadline = lt_l1_deadline_left(s2, &left_us);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+    if (left_us < us) {
+        ret_deadline = LT_DEADLINE_EXCEEDED;
+        us = left_us;
+    }
+#endif
+#if LT_HOOKS
+    lt_hook_pre(s2, LT_HOOK_DELAY, NULL, 0, 0, us);
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+#endif
+#if LT_USE_DELAY_US
+    lt_ret_t ret = lt_port_delay_us(s2, us);
+#else
+    lt_ret_t ret = lt_port_delay(s2, LT_US_TO_MS_CEIL(us));
+#endif
+#if LT_STATS
+    lt_stats_time(s2, LT_STATS_POLL, start_us);
+#endif
+#if LT_HOOKS
+    lt_hook_post(s2, LT_HOOK_DELAY, 0, 0, ret);
+#endif
+#if LT_DEADLINE
+    if (ret == LT_OK) {
+        ret = ret_deadline;
+    }
+#endif
+
+    return ret;
 }
 
 #if LT_USE_INT_PIN
@@ -84,6 +580,100 @@ lt_ret_t lt_l1_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
         return LT_PARAM_ERR;
     }
 #endif
-    return lt_port_delay_on_int(s2, ms);
+#if LT_DEADLINE
+    // INT pin timing out at the deadline makes the next poll of CHIP_STATUS fail with LT_DEADLINE_EXCEEDED
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+#endif
+#if LT_HOOKS
+    lt_hook_pre(s2, LT_HOOK_DELAY, NULL, 0, 0, ms * 1000u);
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_port_delay_on_int(s2, ms);
+    lt_stats_time(s2, LT_STATS_POLL, start_us);
+#else
+    lt_ret_t ret = lt_port_delay_on_int(s2, ms);
+#endif
+#if LT_HOOKS
+    lt_hook_post(s2, LT_HOOK_DELAY, 0, 0, ret);
+#endif
+
+    return ret;
+}
+#endif
+
+#if LT_L1_OFFLOAD
+lt_ret_t lt_l1_offload_write(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                             uint32_t timeout_ms)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || !segs || !seg_cnt || (seg_cnt > LT_L1_SPI_SEGMENTS_MAX)) {
+        return LT_PARAM_ERR;
+    }
+#endif
+#if LT_DEADLINE
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &timeout_ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+#endif
+#if LT_STATS
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_port_l1_write(s2, segs, seg_cnt, timeout_ms);
+    lt_stats_time(s2, LT_STATS_TRANSFER, start_us);
+    for (uint8_t i = 0; i < seg_cnt; i++) {
+        lt_stats_bytes(s2, segs[i].len);
+    }
+#else
+    lt_ret_t ret = lt_port_l1_write(s2, segs, seg_cnt, timeout_ms);
+#endif
+
+    return ret;
+}
+
+lt_ret_t lt_l1_offload_read(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms)
+{
+#ifdef LIBT_DEBUG
+    if (!s2) {
+        return LT_PARAM_ERR;
+    }
+#endif
+#if LT_DEADLINE
+    lt_ret_t ret_deadline = lt_l1_deadline_clip_ms(s2, &timeout_ms);
+    if (ret_deadline != LT_OK) {
+        return ret_deadline;
+    }
+#endif
+#if LT_STATS
+    // Polling happens on the other side, the whole read is accounted as a transfer
+    uint32_t start_us = lt_stats_clock(s2);
+    lt_ret_t ret = lt_port_l1_read(s2, max_len, timeout_ms);
+    lt_stats_time(s2, LT_STATS_TRANSFER, start_us);
+    if (ret == LT_OK) {
+        lt_stats_bytes(s2, 3u + s2->buff[2] + 2u);
+    }
+#else
+    lt_ret_t ret = lt_port_l1_read(s2, max_len, timeout_ms);
+#endif
+
+    return ret;
+}
+#endif
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_l1_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || !actual_hz) {
+        return LT_PARAM_ERR;
+    }
+#endif
+    *actual_hz = hz;
+
+    return lt_port_spi_speed_set(s2, hz, actual_hz);
 }
 #endif
@@ -18,6 +18,8 @@
  */
 
 #include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
 
 /**
  * @brief Initializes handle and L1.
@@ -64,6 +66,38 @@ lt_ret_t lt_l1_spi_csn_high(lt_l2_state_t *s2) __attribute__((warn_unused_result
 lt_ret_t lt_l1_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len, uint32_t timeout_ms)
     __attribute__((warn_unused_result));
 
+#if LT_USE_SPI_TRANSFER_BUF
+/**
+ * @brief Transfers bytes of the frame from and to any buffers. This is wrapper for platform defined function
+ *        `lt_port_spi_transfer_buf()`.
+ * @note For a port of LT_PORT_OPS without `spi_transfer_buf`, the transfer is emulated in handle's buffer at `offset`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param offset      Offset in handle's internal buffer for the emulated transfer
+ * @param tx          Bytes to be sent, NULL to send bytes of `rx`
+ * @param rx          Buffer for received bytes, NULL to discard them
+ * @param len         Number of bytes to be transferred
+ * @param timeout_ms  Timeout
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_spi_transfer_buf(lt_l2_state_t *s2, uint8_t offset, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                uint32_t timeout_ms) __attribute__((warn_unused_result));
+#endif
+
+/**
+ * @brief Does several L1 transfers as one transaction. This is wrapper for platform defined function.
+ * @note When libtropic is compiled without `LT_USE_SPI_TRANSACTION`, the transaction is emulated using
+ *       `lt_port_spi_csn_low()`, `lt_port_spi_transfer()` and `lt_port_spi_csn_high()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param segs        Array of segments
+ * @param seg_cnt     Number of segments in `segs`
+ * @param timeout_ms  Timeout
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                               uint32_t timeout_ms) __attribute__((warn_unused_result));
+
 /**
  * @brief Platform's definition for delay, specifies what host
  *        platform should do when libtropic's functions need some delay.
@@ -75,6 +109,16 @@ lt_ret_t lt_l1_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len,
  */
 lt_ret_t lt_l1_delay(lt_l2_state_t *s2, uint32_t ms) __attribute__((warn_unused_result));
 
+/**
+ * @brief Waits with microsecond resolution. This is wrapper for platform defined function `lt_port_delay_us()`,
+ *        without LT_USE_DELAY_US the time is rounded up to whole miliseconds and `lt_port_delay()` is used.
+ *
+ * @param s2          Structure holding l2 state
+ * @param us          Time to wait in microseconds
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_delay_us(lt_l2_state_t *s2, uint32_t us) __attribute__((warn_unused_result));
+
 #if LT_USE_INT_PIN
 /**
  * @brief Specifies what platform should do when waiting for signal from interrupt pin
@@ -86,6 +130,74 @@ lt_ret_t lt_l1_delay(lt_l2_state_t *s2, uint32_t ms) __attribute__((warn_unused_
 lt_ret_t lt_l1_delay_on_int(lt_l2_state_t *s2, uint32_t ms) __attribute__((warn_unused_result));
 #endif
 
+#if LT_USE_SPI_SPEED
+/**
+ * @brief Changes SPI clock. This is wrapper for platform defined function.
+ *
+ * @param s2          Structure holding l2 state
+ * @param hz          Requested clock in Hz
+ * @param actual_hz   Clock actually used by the port
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+    __attribute__((warn_unused_result));
+#endif
+
+#if LT_L1_OFFLOAD
+/**
+ * @brief Sends a whole L1 frame by the port. This is wrapper for platform defined function `lt_port_l1_write()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param segs        Segments of the frame
+ * @param seg_cnt     Number of segments in `segs`
+ * @param timeout_ms  Timeout
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_offload_write(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                             uint32_t timeout_ms) __attribute__((warn_unused_result));
+
+/**
+ * @brief Reads a response polled by the port. This is wrapper for platform defined function `lt_port_l1_read()`.
+ *
+ * @param s2          Structure holding l2 state
+ * @param max_len     Max length of the response
+ * @param timeout_ms  Timeout
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l1_offload_read(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms)
+    __attribute__((warn_unused_result));
+#endif
+
+/**
+ * @brief Nonzero when the wrappers only call the port, i.e. without parameter checks of LIBT_DEBUG and without
+ * recording, statistics, hooks, deadlines and cache maintenance. The hot wrappers are then replaced by direct calls
+ * of the port and are not compiled at all.
+ */
+#if !defined(LIBT_DEBUG) && !LT_RECORD && !LT_STATS && !LT_HOOKS && !LT_DEADLINE && !LT_USE_PORT_CACHE
+#define LT_L1_INLINE 1
+#else
+#define LT_L1_INLINE 0
+#endif
+
+#if LT_L1_INLINE
+#define lt_l1_spi_csn_low(s2) lt_port_spi_csn_low(s2)
+#define lt_l1_spi_csn_high(s2) lt_port_spi_csn_high(s2)
+#define lt_l1_spi_transfer(s2, offset, tx_len, timeout_ms) lt_port_spi_transfer(s2, offset, tx_len, timeout_ms)
+#define lt_l1_delay(s2, ms) lt_port_delay(s2, ms)
+#if LT_USE_DELAY_US
+#define lt_l1_delay_us(s2, us) lt_port_delay_us(s2, us)
+#else
+#define lt_l1_delay_us(s2, us) lt_port_delay(s2, LT_US_TO_MS_CEIL(us))
+#endif
+#if LT_USE_INT_PIN
+#define lt_l1_delay_on_int(s2, ms) lt_port_delay_on_int(s2, ms)
+#endif
+#if LT_L1_OFFLOAD
+#define lt_l1_offload_write(s2, segs, seg_cnt, timeout_ms) lt_port_l1_write(s2, segs, seg_cnt, timeout_ms)
+#define lt_l1_offload_read(s2, max_len, timeout_ms) lt_port_l1_read(s2, max_len, timeout_ms)
+#endif
+#endif
+
 /** @} */  // end of group_l1_functions
 
 #endif
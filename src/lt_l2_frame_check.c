@@ -10,13 +10,40 @@
 
 #include "libtropic_common.h"
 #include "lt_crc16.h"
+#include "lt_l1.h"
+#include "lt_spi_tune.h"
+#include "lt_stats.h"
 
-lt_ret_t lt_l2_frame_check(const uint8_t *frame)
+/** Calculates CRC of STATUS, length and data bytes of the frame, data may be received apart from the frame */
+static uint16_t lt_l2_frame_crc(lt_l2_state_t *s2, const uint8_t *frame, const uint8_t *data)
+{
+    if (data == frame + 3) {
+        return lt_l2_crc16(s2, frame + 1, frame[2] + 2);
+    }
+
+    uint16_t crc = crc16_init();
+    crc = crc16_update(crc, frame + 1, 2);
+    crc = crc16_update(crc, data, frame[2]);
+
+    return crc16_final(crc);
+}
+
+lt_ret_t lt_l2_frame_check(lt_l2_state_t *s2, const uint8_t *frame)
 {
 #ifdef LIBT_DEBUG
     if (!frame) {
         return LT_PARAM_ERR;
     }
+#endif
+    return lt_l2_frame_check_data(s2, frame, frame + 3);
+}
+
+lt_ret_t lt_l2_frame_check_data(lt_l2_state_t *s2, const uint8_t *frame, const uint8_t *data)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || !frame || !data) {
+        return LT_PARAM_ERR;
+    }
 #endif
     // Take status, len and crc values from incomming frame
     uint8_t status = frame[1];
@@ -27,23 +54,50 @@ lt_ret_t lt_l2_frame_check(const uint8_t *frame)
         // Valid frames, or crc errors in INCOMMING frames are handled here:
         case L2_STATUS_REQUEST_OK:
         case L2_STATUS_RESULT_OK:
-            if (frame_crc != crc16(frame + 1, len + 2)) {
+            if (frame_crc != lt_l2_frame_crc(s2, frame, data)) {
+#if LT_STATS
+                lt_stats_crc_error(s2);
+#endif
+#if LT_USE_SPI_SPEED
+                lt_spi_tune_frame(s2, 1);
+#endif
                 return LT_L2_IN_CRC_ERR;
             }
+#if LT_USE_SPI_SPEED
+            lt_spi_tune_frame(s2, 0);
+#endif
             return LT_OK;
 
         // L2 statuses returned by Tropic chip are handled here
         case L2_STATUS_REQUEST_CONT:
+#if LT_USE_SPI_SPEED
+            lt_spi_tune_frame(s2, 0);
+#endif
             return LT_L2_REQ_CONT;
         case L2_STATUS_RESULT_CONT:
+#if LT_USE_SPI_SPEED
+            lt_spi_tune_frame(s2, 0);
+#endif
             return LT_L2_RES_CONT;
         case L2_STATUS_HSK_ERR:
             return LT_L2_HSK_ERR;
         case L2_STATUS_NO_SESSION:
+#if LT_SESSION_LIVENESS
+            lt_l1_session_lost(s2, LT_LIVENESS_NO_SESSION);
+#endif
             return LT_L2_NO_SESSION;
         case L2_STATUS_TAG_ERR:
+#if LT_SESSION_LIVENESS
+            lt_l1_session_lost(s2, LT_LIVENESS_AUTH);
+#endif
             return LT_L2_TAG_ERR;
         case L2_STATUS_CRC_ERR:
+#if LT_STATS
+            lt_stats_crc_error(s2);
+#endif
+#if LT_USE_SPI_SPEED
+            lt_spi_tune_frame(s2, 1);
+#endif
             return LT_L2_CRC_ERR;
         case L2_STATUS_GEN_ERR:
             return LT_L2_GEN_ERR;
@@ -49,10 +49,24 @@
 /**
  * @brief Checks if incomming L2 frame is valid
  *
+ * @param             s2     Structure holding l2 state
  * @param             frame
  * @return            LT_OK if success, otherwise returns other error code.
  */
-lt_ret_t lt_l2_frame_check(const uint8_t *frame) __attribute__((warn_unused_result));
+lt_ret_t lt_l2_frame_check(lt_l2_state_t *s2, const uint8_t *frame) __attribute__((warn_unused_result));
+
+/**
+ * @brief Checks if incomming L2 frame is valid, when its data were received apart from it
+ *
+ * CRC is still expected in `frame`, right after the place of the data.
+ *
+ * @param             s2     Structure holding l2 state
+ * @param             frame  CHIP_STATUS, STATUS and length bytes followed by the place of data and CRC
+ * @param             data   Data of the frame, `frame + 3` when they are in place
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_l2_frame_check_data(lt_l2_state_t *s2, const uint8_t *frame, const uint8_t *data)
+    __attribute__((warn_unused_result));
 
 /** @} */  // end of group_l2_frame_check_functions
 
@@ -1772,4 +1772,23 @@ STATIC_ASSERT(
 /** \endcond */
 // clang-format on
 
+// Size of L3 buffer is derived in libtropic_common.h, which cannot see the structures above
+// clang-format off
+/** \cond */
+STATIC_ASSERT(LT_PING_LEN_MAX <= LT_L3_PING_CMD_DATA_IN_LEN_MAX)
+STATIC_ASSERT(LT_EDDSA_MSG_LEN_MAX <= LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX)
+STATIC_ASSERT(LT_L3_BUFF_SIZE_BASE == sizeof(struct lt_l3_random_value_get_res_t))
+STATIC_ASSERT(LT_L3_BUFF_SIZE_PING == sizeof(struct lt_l3_ping_cmd_t) - (LT_L3_PING_CMD_DATA_IN_LEN_MAX - LT_PING_LEN_MAX))
+STATIC_ASSERT(LT_L3_BUFF_SIZE_PING == sizeof(struct lt_l3_ping_res_t) - (LT_L3_PING_CMD_DATA_IN_LEN_MAX - LT_PING_LEN_MAX))
+STATIC_ASSERT(
+    LT_L3_BUFF_SIZE_EDDSA ==
+    sizeof(struct lt_l3_eddsa_sign_cmd_t) - (LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX - LT_EDDSA_MSG_LEN_MAX)
+)
+#if LT_ENABLE_R_MEM
+STATIC_ASSERT(LT_L3_BUFF_SIZE_R_MEM == sizeof(struct lt_l3_r_mem_data_write_cmd_t))
+STATIC_ASSERT(LT_L3_BUFF_SIZE_R_MEM == sizeof(struct lt_l3_r_mem_data_read_res_t))
+#endif
+/** \endcond */
+// clang-format on
+
 #endif  // !LT_L3_API_STRUCTS_H
@@ -0,0 +1,97 @@
+/**
+ * @file lt_l3_cmd_desc.c
+ * @brief Descriptors of L3 commands
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_l3_cmd_desc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+
+/** Execution time of commands writing into flash, in us */
+#define LT_L3_CMD_EXEC_FLASH 2000
+/** Execution time of commands doing asymmetric cryptography, in us */
+#define LT_L3_CMD_EXEC_SIGN 5000
+/** Execution time of ECC key generation, in us */
+#define LT_L3_CMD_EXEC_KEY_GEN 10000
+
+// Command and result of fixed size
+#define LT_L3_CMD_FIXED(name) LT_L3_##name##_CMD_SIZE, LT_L3_##name##_CMD_SIZE
+#define LT_L3_RES_FIXED(name) LT_L3_##name##_RES_SIZE, LT_L3_##name##_RES_SIZE
+
+/** Descriptors sorted by command ID */
+static const lt_l3_cmd_desc_t lt_l3_cmd_descs[] = {
+    {LT_L3_PING_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_PING_CMD_SIZE_MIN,
+     LT_L3_PING_CMD_SIZE_MIN + LT_L3_PING_CMD_DATA_IN_LEN_MAX, LT_L3_PING_RES_SIZE_MIN,
+     LT_L3_PING_RES_SIZE_MIN + LT_L3_PING_CMD_DATA_IN_LEN_MAX},
+    {LT_L3_PAIRING_KEY_WRITE_CMD_ID, LT_L3_CMD_WRITES_FLASH, LT_L3_CMD_EXEC_FLASH, LT_L3_CMD_FIXED(PAIRING_KEY_WRITE),
+     LT_L3_RES_FIXED(PAIRING_KEY_WRITE)},
+    {LT_L3_PAIRING_KEY_READ_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(PAIRING_KEY_READ),
+     LT_L3_RES_FIXED(PAIRING_KEY_READ)},
+    {LT_L3_PAIRING_KEY_INVALIDATE_CMD_ID, LT_L3_CMD_WRITES_FLASH, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(PAIRING_KEY_INVALIDATE), LT_L3_RES_FIXED(PAIRING_KEY_INVALIDATE)},
+    {LT_L3_R_CONFIG_WRITE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_CONFIG, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(R_CONFIG_WRITE), LT_L3_RES_FIXED(R_CONFIG_WRITE)},
+    {LT_L3_R_CONFIG_READ_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(R_CONFIG_READ),
+     LT_L3_RES_FIXED(R_CONFIG_READ)},
+    {LT_L3_R_CONFIG_ERASE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_CONFIG, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(R_CONFIG_ERASE), LT_L3_RES_FIXED(R_CONFIG_ERASE)},
+    {LT_L3_I_CONFIG_WRITE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_CONFIG, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(I_CONFIG_WRITE), LT_L3_RES_FIXED(I_CONFIG_WRITE)},
+    {LT_L3_I_CONFIG_READ_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(I_CONFIG_READ),
+     LT_L3_RES_FIXED(I_CONFIG_READ)},
+    {LT_L3_R_MEM_DATA_WRITE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_R_MEM, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_R_MEM_DATA_WRITE_CMD_SIZE_MIN,
+     LT_L3_R_MEM_DATA_WRITE_CMD_SIZE_MIN - LT_L3_R_MEM_DATA_WRITE_CMD_DATA_LEN_MIN
+         + LT_L3_R_MEM_DATA_WRITE_CMD_DATA_LEN_MAX,
+     LT_L3_RES_FIXED(R_MEM_DATA_WRITE)},
+    {LT_L3_R_MEM_DATA_READ_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(R_MEM_DATA_READ),
+     LT_L3_R_MEM_DATA_READ_RES_SIZE_MIN, LT_L3_R_MEM_DATA_READ_RES_SIZE_MAX},
+    {LT_L3_R_MEM_DATA_ERASE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_R_MEM, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(R_MEM_DATA_ERASE), LT_L3_RES_FIXED(R_MEM_DATA_ERASE)},
+    {LT_L3_RANDOM_VALUE_GET_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(RANDOM_VALUE_GET),
+     LT_L3_RANDOM_VALUE_GET_RES_SIZE_MIN, LT_L3_RANDOM_VALUE_GET_RES_SIZE_MIN + RANDOM_VALUE_GET_LEN_MAX},
+    {LT_L3_ECC_KEY_GENERATE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_ECC_KEYS, LT_L3_CMD_EXEC_KEY_GEN,
+     LT_L3_CMD_FIXED(ECC_KEY_GENERATE), LT_L3_RES_FIXED(ECC_KEY_GENERATE)},
+    {LT_L3_ECC_KEY_STORE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_ECC_KEYS, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(ECC_KEY_STORE), LT_L3_RES_FIXED(ECC_KEY_STORE)},
+    // Ed25519 key has 32 bytes, P256 key 64 bytes
+    {LT_L3_ECC_KEY_READ_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(ECC_KEY_READ), LT_L3_ECC_KEY_READ_RES_SIZE_MIN,
+     LT_L3_ECC_KEY_READ_RES_SIZE_MIN + 32},
+    {LT_L3_ECC_KEY_ERASE_CMD_ID, LT_L3_CMD_WRITES_FLASH | LT_L3_CMD_ECC_KEYS, LT_L3_CMD_EXEC_FLASH,
+     LT_L3_CMD_FIXED(ECC_KEY_ERASE), LT_L3_RES_FIXED(ECC_KEY_ERASE)},
+    {LT_L3_ECDSA_SIGN_CMD_ID, LT_L3_CMD_IDEMPOTENT, LT_L3_CMD_EXEC_SIGN, LT_L3_CMD_FIXED(ECDSA_SIGN),
+     LT_L3_RES_FIXED(ECDSA_SIGN)},
+    // Minimal command carries one byte of the message
+    {LT_L3_EDDSA_SIGN_CMD_ID, LT_L3_CMD_IDEMPOTENT, LT_L3_CMD_EXEC_SIGN, LT_L3_EDDSA_SIGN_CMD_SIZE_MIN,
+     LT_L3_EDDSA_SIGN_CMD_SIZE_MIN - 1 + LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX, LT_L3_RES_FIXED(EDDSA_SIGN)},
+    {LT_L3_MCOUNTER_INIT_CMD_ID, LT_L3_CMD_WRITES_FLASH, LT_L3_CMD_EXEC_FLASH, LT_L3_CMD_FIXED(MCOUNTER_INIT),
+     LT_L3_RES_FIXED(MCOUNTER_INIT)},
+    {LT_L3_MCOUNTER_UPDATE_CMD_ID, LT_L3_CMD_WRITES_FLASH, LT_L3_CMD_EXEC_FLASH, LT_L3_CMD_FIXED(MCOUNTER_UPDATE),
+     LT_L3_RES_FIXED(MCOUNTER_UPDATE)},
+    {LT_L3_MCOUNTER_GET_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(MCOUNTER_GET), LT_L3_RES_FIXED(MCOUNTER_GET)},
+    {LT_L3_MAC_AND_DESTROY_CMD_ID, LT_L3_CMD_WRITES_FLASH, LT_L3_CMD_EXEC_FLASH, LT_L3_CMD_FIXED(MAC_AND_DESTROY),
+     LT_L3_RES_FIXED(MAC_AND_DESTROY)},
+    {LT_L3_SERIAL_CODE_GET_CMD_ID, LT_L3_CMD_IDEMPOTENT, 0, LT_L3_CMD_FIXED(SERIAL_CODE_GET),
+     LT_L3_RES_FIXED(SERIAL_CODE_GET)},
+};
+
+const lt_l3_cmd_desc_t *lt_l3_cmd_desc_get(const uint8_t cmd_id)
+{
+    for (size_t i = 0; i < sizeof(lt_l3_cmd_descs) / sizeof(lt_l3_cmd_descs[0]); i++) {
+        if (lt_l3_cmd_descs[i].cmd_id == cmd_id) {
+            return &lt_l3_cmd_descs[i];
+        }
+        if (lt_l3_cmd_descs[i].cmd_id > cmd_id) {
+            break;
+        }
+    }
+
+    return NULL;
+}
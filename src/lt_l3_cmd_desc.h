@@ -0,0 +1,66 @@
+#ifndef LT_L3_CMD_DESC_H
+#define LT_L3_CMD_DESC_H
+
+/**
+ * @defgroup group_l3_cmd_desc Descriptors of L3 commands
+ * @brief Used internally
+ * @details Properties of each L3 command known to libtropic, kept in one table instead of being repeated by code
+ * handling the commands. Batches of commands take the space for results and their behaviour on failure from it, the
+ * default polling profiles of L1 are derived from the execution times and `lt_raw_cmd()` invalidates caches by the
+ * flags. Encoding and decoding of the commands stays in their `lt_out__*()` and `lt_in__*()` functions.
+ * @{
+ */
+
+/**
+ * @file lt_l3_cmd_desc.h
+ * @brief Descriptors of L3 commands
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+/** @brief Repeated execution has the same effect as a single one, so the command can be sent again */
+#define LT_L3_CMD_IDEMPOTENT 0x01u
+/** @brief Command writes into flash of TROPIC01 */
+#define LT_L3_CMD_WRITES_FLASH 0x02u
+/** @brief Command changes keys in ECC slots */
+#define LT_L3_CMD_ECC_KEYS 0x04u
+/** @brief Command changes data in R-memory slots */
+#define LT_L3_CMD_R_MEM 0x08u
+/** @brief Command changes R-Config or I-Config */
+#define LT_L3_CMD_CONFIG 0x10u
+
+/**
+ * @brief Properties of one L3 command. Sizes are sizes of the plaintext (`cmd_size` and `res_size` fields of the
+ * frames), those of results are the sizes of successful ones, failing results consist only of the RESULT byte.
+ */
+typedef struct lt_l3_cmd_desc_t {
+    /** @brief Command ID */
+    uint8_t cmd_id;
+    /** @brief LT_L3_CMD_* flags */
+    uint8_t flags;
+    /** @brief Expected execution time in us */
+    uint16_t exec_us;
+    /** @brief Minimal size of command */
+    uint16_t cmd_size_min;
+    /** @brief Maximal size of command */
+    uint16_t cmd_size_max;
+    /** @brief Minimal size of successful result */
+    uint16_t res_size_min;
+    /** @brief Maximal size of successful result */
+    uint16_t res_size_max;
+} lt_l3_cmd_desc_t;
+
+/**
+ * @brief Returns descriptor of the command.
+ *
+ * @param cmd_id      Command ID
+ * @return            Descriptor, NULL for a command unknown to libtropic
+ */
+const lt_l3_cmd_desc_t *lt_l3_cmd_desc_get(const uint8_t cmd_id);
+
+/** @} */  // end of group_l3_cmd_desc
+
+#endif
@@ -16,7 +16,10 @@
 #include "libtropic_common.h"
 #include "libtropic_l2.h"
 #include "lt_aesgcm.h"
+#include "lt_aesgcm_multi.h"
 #include "lt_l1.h"
+#include "lt_profile.h"
+#include "lt_wire.h"
 
 LT_STATIC lt_ret_t lt_l3_nonce_increase(uint8_t *nonce)
 {
@@ -41,69 +44,195 @@ LT_STATIC lt_ret_t lt_l3_nonce_increase(uint8_t *nonce)
     return LT_OK;
 }
 
+/** Clears memory by memset() which the compiler is not allowed to drop as a store to memory never read again */
+static void lt_l3_secure_zero(uint8_t *buff, uint16_t len)
+{
+    memset(buff, 0, len);
+    __asm__ __volatile__("" : : "r"(buff) : "memory");
+}
+
+/** Raises high-water mark `used` of a buffer of `buff_len` bytes to `len` */
+static void lt_l3_buff_used(uint16_t *used, uint16_t len, uint16_t buff_len)
+{
+    if (len > buff_len) {
+        len = buff_len;
+    }
+    if (len > *used) {
+        *used = len;
+    }
+}
+
+void lt_l3_res_buff_used(lt_l3_state_t *s3, uint16_t len)
+{
+    lt_l3_buff_used(&LT_L3_RES_BUFF_USED(s3), len, LT_L3_RES_BUFF_LEN(s3));
+}
+
+void lt_l3_buff_wipe(lt_l3_state_t *s3)
+{
+#if LT_SEPARATE_L3_BUFF
+    // No buffer is held between commands by a handle using lt_l3_buff_pool_t
+    if (s3->buff) {
+        lt_l3_secure_zero(s3->buff, s3->buff_used);
+    }
+#if LT_L3_SPLIT_BUFF
+    if (s3->res_buff) {
+        lt_l3_secure_zero(s3->res_buff, s3->res_buff_used);
+    }
+#endif
+#else
+    lt_l3_secure_zero(s3->buff, s3->buff_used);
+#if LT_L3_SPLIT_BUFF
+    lt_l3_secure_zero(s3->res_buff, s3->res_buff_used);
+#endif
+#endif
+    s3->buff_used = 0;
+#if LT_L3_SPLIT_BUFF
+    s3->res_buff_used = 0;
+#endif
+}
+
 void lt_l3_invalidate_host_session_data(lt_l3_state_t *s3)
 {
     s3->session = SESSION_OFF;
     memset(s3->encryption_IV, 0, sizeof(s3->encryption_IV));
     memset(s3->decryption_IV, 0, sizeof(s3->decryption_IV));
+    // Releases resources of crypto backends which allocate them for a key
+    int ret_unused = lt_aesgcm_end(&s3->encrypt);
+    ret_unused = lt_aesgcm_end(&s3->decrypt);
+    UNUSED(ret_unused);  // Contexts are wiped below anyway
     memset(s3->encrypt, 0, sizeof(s3->encrypt));
     memset(s3->decrypt, 0, sizeof(s3->decrypt));
-#if LT_SEPARATE_L3_BUFF
-    memset(s3->buff, 0, s3->buff_len);
-#else
-    memset(s3->buff, 0, sizeof(s3->buff));
-#endif
+    lt_l3_buff_wipe(s3);
 }
 
-lt_ret_t lt_l3_encrypt_request(lt_l3_state_t *s3)
+lt_ret_t lt_iov_len(const lt_iovec_t *iov, const uint8_t iov_cnt, size_t *len)
 {
-#ifdef LIBT_DEBUG
-    if (!s3) {
+    if (!len || (iov_cnt && !iov)) {
         return LT_PARAM_ERR;
     }
-#endif
-    if (s3->session != SESSION_ON) {
-        return LT_HOST_NO_SESSION;
+
+    *len = 0;
+    for (uint8_t i = 0; i < iov_cnt; i++) {
+        if (iov[i].len && !iov[i].base) {
+            return LT_PARAM_ERR;
+        }
+        *len += iov[i].len;
     }
 
-    struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)s3->buff;
+    return LT_OK;
+}
 
-    int ret = lt_aesgcm_encrypt(&s3->encrypt, s3->encryption_IV, L3_IV_SIZE, (uint8_t *)"", 0, p_frame->data,
-                                p_frame->cmd_size, p_frame->data + p_frame->cmd_size, L3_TAG_SIZE);
-    if (ret != LT_OK) {
-        lt_l3_invalidate_host_session_data(s3);
-        return ret;
+lt_ret_t lt_iov_out_len(const lt_iovec_out_t *iov, const uint8_t iov_cnt, size_t *len)
+{
+    if (!len || (iov_cnt && !iov)) {
+        return LT_PARAM_ERR;
     }
 
-    return lt_l3_nonce_increase(s3->encryption_IV);
+    *len = 0;
+    for (uint8_t i = 0; i < iov_cnt; i++) {
+        if (iov[i].len && !iov[i].base) {
+            return LT_PARAM_ERR;
+        }
+        *len += iov[i].len;
+    }
+
+    return LT_OK;
 }
 
-lt_ret_t lt_l3_decrypt_response(lt_l3_state_t *s3)
+void lt_iov_gather(uint8_t *dst, const lt_iovec_t *iov, const uint8_t iov_cnt)
 {
+    for (uint8_t i = 0; i < iov_cnt; i++) {
+        if (iov[i].len) {
+            memcpy(dst, iov[i].base, iov[i].len);
+            dst += iov[i].len;
+        }
+    }
+}
+
+void lt_iov_scatter(const uint8_t *src, size_t len, const lt_iovec_out_t *iov, const uint8_t iov_cnt)
+{
+    for (uint8_t i = 0; (i < iov_cnt) && len; i++) {
+        size_t n = (iov[i].len < len) ? iov[i].len : len;
+        if (n) {
+            memcpy(iov[i].base, src, n);
+            src += n;
+            len -= n;
+        }
+    }
+}
+
+lt_ret_t lt_l3_encrypt_request(lt_l3_state_t *s3)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_L3_ENCRYPT);
 #ifdef LIBT_DEBUG
     if (!s3) {
         return LT_PARAM_ERR;
     }
 #endif
+    struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)s3->buff;
+    uint16_t size = LT_L3_GET16(p_frame, cmd_size);
+    // Plaintext of the command is already in the buffer, even when it is not encrypted below
+    lt_l3_buff_used(&s3->buff_used, L3_CMD_SIZE_SIZE + size + L3_TAG_SIZE, s3->buff_len);
+
     if (s3->session != SESSION_ON) {
         return LT_HOST_NO_SESSION;
     }
+#if LT_ASYNC
+    if (s3->encrypt_deferred) {
+        return LT_OK;
+    }
+#endif
 
-    struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)s3->buff;
-
-    lt_ret_t ret = lt_aesgcm_decrypt(&s3->decrypt, s3->decryption_IV, L3_IV_SIZE, (uint8_t *)"", 0, p_frame->data,
-                                     p_frame->cmd_size, p_frame->data + p_frame->cmd_size, L3_TAG_SIZE);
+    int ret = lt_aesgcm_encrypt(&s3->encrypt, s3->encryption_IV, L3_IV_SIZE, (uint8_t *)"", 0, p_frame->data, size,
+                                p_frame->data + size, L3_TAG_SIZE);
     if (ret != LT_OK) {
         lt_l3_invalidate_host_session_data(s3);
         return ret;
     }
 
-    ret = lt_l3_nonce_increase(s3->decryption_IV);
-    if (LT_OK != ret) {
-        return ret;
+    return lt_l3_nonce_increase(s3->encryption_IV);
+}
+
+#if LT_ASYNC
+void lt_l3_encrypt_multi(lt_l3_state_t *const *s3, const size_t n, lt_ret_t *rets)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_L3_ENCRYPT);
+    void *ctxs[LT_AESGCM_MULTI_LANES];
+    const uint8_t *ivs[LT_AESGCM_MULTI_LANES];
+    uint8_t *msgs[LT_AESGCM_MULTI_LANES];
+    uint32_t msg_lens[LT_AESGCM_MULTI_LANES];
+    uint8_t *tags[LT_AESGCM_MULTI_LANES];
+    int crypt_rets[LT_AESGCM_MULTI_LANES];
+
+    for (size_t first = 0; first < n; first += LT_AESGCM_MULTI_LANES) {
+        const size_t cnt = ((n - first) < LT_AESGCM_MULTI_LANES) ? (n - first) : LT_AESGCM_MULTI_LANES;
+        for (size_t i = 0; i < cnt; i++) {
+            struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)s3[first + i]->buff;
+            uint16_t size = LT_L3_GET16(p_frame, cmd_size);
+            ctxs[i] = &s3[first + i]->encrypt;
+            ivs[i] = s3[first + i]->encryption_IV;
+            msgs[i] = p_frame->data;
+            msg_lens[i] = size;
+            tags[i] = p_frame->data + size;
+        }
+
+        lt_aesgcm_encrypt_multi(ctxs, ivs, L3_IV_SIZE, msgs, msg_lens, tags, L3_TAG_SIZE, cnt, crypt_rets);
+        for (size_t i = 0; i < cnt; i++) {
+            if (crypt_rets[i] != LT_OK) {
+                lt_l3_invalidate_host_session_data(s3[first + i]);
+                rets[first + i] = (lt_ret_t)crypt_rets[i];
+                continue;
+            }
+            rets[first + i] = lt_l3_nonce_increase(s3[first + i]->encryption_IV);
+        }
     }
+}
+#endif
 
-    switch (p_frame->data[0]) {
+/** Translates RESULT byte of L3 result to return value */
+static lt_ret_t lt_l3_result_to_ret(uint8_t result)
+{
+    switch (result) {
         case L3_RESULT_FAIL:
             return LT_L3_FAIL;
         case L3_RESULT_UNAUTHORIZED:
@@ -130,3 +259,178 @@ lt_ret_t lt_l3_decrypt_response(lt_l3_state_t *s3)
             return LT_FAIL;
     }
 }
+
+lt_ret_t lt_l3_decrypt_response(lt_l3_state_t *s3)
+{
+    LT_PROFILE_SCOPE(LT_PROFILE_L3_DECRYPT);
+#ifdef LIBT_DEBUG
+    if (!s3) {
+        return LT_PARAM_ERR;
+    }
+#endif
+    struct lt_l3_gen_frame_t *p_frame = (struct lt_l3_gen_frame_t *)LT_L3_RES_BUFF(s3);
+    uint16_t size = LT_L3_GET16(p_frame, cmd_size);
+    // Result may have been received by lt_l2_recv_encrypted_res() of the separate API, which does not account it
+    lt_l3_res_buff_used(s3, L3_RES_SIZE_SIZE + size + L3_TAG_SIZE);
+
+    if (s3->session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+#if LT_L3_STREAM_DECRYPT
+    if (s3->res_decrypted) {
+        // Already decrypted, authenticated and nonce increased by lt_l3_recv_decrypt()
+        s3->res_decrypted = 0;
+        return lt_l3_result_to_ret(p_frame->data[0]);
+    }
+#endif
+
+    lt_ret_t ret = lt_aesgcm_decrypt(&s3->decrypt, s3->decryption_IV, L3_IV_SIZE, (uint8_t *)"", 0, p_frame->data,
+                                     size, p_frame->data + size, L3_TAG_SIZE);
+    if (ret != LT_OK) {
+        lt_l3_invalidate_host_session_data(s3);
+        return ret;
+    }
+
+    ret = lt_l3_nonce_increase(s3->decryption_IV);
+    if (LT_OK != ret) {
+        return ret;
+    }
+
+    return lt_l3_result_to_ret(p_frame->data[0]);
+}
+
+#if LT_L3_STREAM_DECRYPT
+/** State of L3 result which is decrypted while being received */
+struct lt_l3_stream_t {
+    lt_l3_state_t *s3;
+    lt_l3_sink_t sink;
+    void *sink_ctx;
+    /** Number of received bytes of L3 frame */
+    uint16_t pos;
+    /** RES_SIZE field */
+    uint16_t res_size;
+    /** First byte of decrypted data */
+    uint8_t result;
+    uint8_t tag[L3_TAG_SIZE];
+};
+
+/** Splits received chunk into RES_SIZE, data and tag fields of L3 frame and decrypts the data in place */
+static lt_ret_t lt_l3_stream_chunk(void *ctx, uint8_t *chunk, uint16_t len)
+{
+    struct lt_l3_stream_t *st = (struct lt_l3_stream_t *)ctx;
+    lt_l3_state_t *s3 = st->s3;
+
+    while (len) {
+        if (st->pos < L3_RES_SIZE_SIZE) {
+            // RES_SIZE is little endian
+            st->res_size |= (uint16_t)(*chunk << (8 * st->pos));
+            if (!st->sink) {
+                LT_L3_RES_BUFF(s3)[st->pos] = *chunk;
+            }
+            st->pos++;
+            chunk++;
+            len--;
+
+            if (st->pos == L3_RES_SIZE_SIZE) {
+                uint32_t max_len = st->sink ? L3_PACKET_MAX_SIZE : LT_L3_RES_BUFF_LEN(s3);
+                if ((st->res_size == 0)
+                    || ((uint32_t)L3_RES_SIZE_SIZE + st->res_size + L3_TAG_SIZE > max_len)) {
+                    return LT_L3_DATA_LEN_ERROR;
+                }
+            }
+            continue;
+        }
+
+        uint16_t data_end = L3_RES_SIZE_SIZE + st->res_size;
+        uint16_t n;
+        if (st->pos < data_end) {
+            n = (len < data_end - st->pos) ? len : (uint16_t)(data_end - st->pos);
+
+            int ret = lt_aesgcm_decrypt_update(&s3->decrypt, chunk, n);
+            if (ret != LT_OK) {
+                return LT_FAIL;
+            }
+            if (st->pos == L3_RES_SIZE_SIZE) {
+                st->result = chunk[0];
+            }
+
+            if (st->sink) {
+                lt_ret_t ret_sink = st->sink(st->sink_ctx, chunk, n);
+                if (ret_sink != LT_OK) {
+                    return ret_sink;
+                }
+            }
+            else {
+                memcpy(LT_L3_RES_BUFF(s3) + st->pos, chunk, n);
+            }
+        }
+        else {
+            if (st->pos >= data_end + L3_TAG_SIZE) {
+                return LT_L3_DATA_LEN_ERROR;
+            }
+            n = (len < data_end + L3_TAG_SIZE - st->pos) ? len : (uint16_t)(data_end + L3_TAG_SIZE - st->pos);
+            memcpy(st->tag + (st->pos - data_end), chunk, n);
+        }
+        st->pos += n;
+        chunk += n;
+        len -= n;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_l3_recv_decrypt(lt_l2_state_t *s2, lt_l3_state_t *s3, lt_l3_sink_t sink, void *sink_ctx)
+{
+#ifdef LIBT_DEBUG
+    if (!s2 || !s3) {
+        return LT_PARAM_ERR;
+    }
+#endif
+    if (s3->session != SESSION_ON) {
+        return LT_HOST_NO_SESSION;
+    }
+
+    struct lt_l3_stream_t st = {.s3 = s3, .sink = sink, .sink_ctx = sink_ctx};
+    s3->res_decrypted = 0;
+
+    lt_ret_t ret = lt_aesgcm_decrypt_start(&s3->decrypt, s3->decryption_IV, L3_IV_SIZE, (uint8_t *)"", 0);
+    if (ret != LT_OK) {
+        lt_l3_invalidate_host_session_data(s3);
+        return ret;
+    }
+
+    ret = lt_l2_recv_encrypted_res_cb(s2, lt_l3_stream_chunk, &st);
+    if (!sink) {
+        lt_l3_res_buff_used(s3, st.pos);
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    if ((st.pos < L3_RES_SIZE_SIZE) || (st.pos != L3_RES_SIZE_SIZE + st.res_size + L3_TAG_SIZE)) {
+        return LT_L3_DATA_LEN_ERROR;
+    }
+
+    ret = lt_aesgcm_decrypt_finish(&s3->decrypt, st.tag, L3_TAG_SIZE);
+    if (ret != LT_OK) {
+        lt_l3_invalidate_host_session_data(s3);
+        return ret;
+    }
+
+    ret = lt_l3_nonce_increase(s3->decryption_IV);
+    if (LT_OK != ret) {
+        return ret;
+    }
+
+    if (sink) {
+        return lt_l3_result_to_ret(st.result);
+    }
+
+    // Keep the tag with the result, so the buffer looks the same as when received by lt_l2_recv_encrypted_res()
+    memcpy(LT_L3_RES_BUFF(s3) + L3_RES_SIZE_SIZE + st.res_size, st.tag, L3_TAG_SIZE);
+    s3->res_decrypted = 1;
+
+    return LT_OK;
+}
+#endif
@@ -54,6 +54,18 @@
  */
 lt_ret_t lt_l3_encrypt_request(lt_l3_state_t *s3) __attribute__((warn_unused_result));
 
+#if LT_ASYNC
+/**
+ * @brief Encrypts commands left in plaintext by `lt_l3_encrypt_request()` of several sessions together.
+ * @note Commands are encrypted by `lt_aesgcm_encrypt_multi()` in groups of LT_AESGCM_MULTI_LANES.
+ *
+ * @param s3          L3 states whose commands were prepared with `encrypt_deferred` set
+ * @param n           Number of states
+ * @param rets        Result of each state, LT_OK if the command is ready to be sent
+ */
+void lt_l3_encrypt_multi(lt_l3_state_t *const *s3, const size_t n, lt_ret_t *rets);
+#endif
+
 /**
  * @brief Decrypts response from TROPIC01 and fills L3 buffer with decrypted data.
  * @note This function is used after encrypted l3 payload was received from TROPIC01.
@@ -63,6 +75,39 @@ lt_ret_t lt_l3_encrypt_request(lt_l3_state_t *s3) __attribute__((warn_unused_res
  */
 lt_ret_t lt_l3_decrypt_response(lt_l3_state_t *s3) __attribute__((warn_unused_result));
 
+#if LT_L3_STREAM_DECRYPT
+/**
+ * @brief Receives plaintext of L3 result decrypted by `lt_l3_recv_decrypt()`.
+ * @warning Data are not authenticated until `lt_l3_recv_decrypt()` returns, they must be discarded when it fails.
+ *
+ * @param ctx         Context passed to `lt_l3_recv_decrypt()`
+ * @param data        Part of decrypted result, beginning with RESULT byte in the first call
+ * @param len         Length of data
+ *
+ * @retval            LT_OK Data were processed and receiving continues
+ * @retval            other Receiving is stopped and this value is returned
+ */
+typedef lt_ret_t (*lt_l3_sink_t)(void *ctx, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Receives encrypted L3 result from TROPIC01 and decrypts each L2 chunk while waiting for the next one.
+ *
+ * Without sink the result is stored in L3 buffer, so it can be then processed by `lt_l3_decrypt_response()`
+ * as if it was received by `lt_l2_recv_encrypted_res()`, only the decryption is not repeated. With sink the
+ * decrypted data are passed to it and L3 buffer is not used, so the result is not limited by its size.
+ *
+ * @param s2          Structure holding l2 state
+ * @param s3          Structure holding l3 state
+ * @param sink        Callback receiving decrypted data, or NULL to store result in L3 buffer
+ * @param sink_ctx    Context passed to sink
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, with sink also the L3 RESULT error
+ */
+lt_ret_t lt_l3_recv_decrypt(lt_l2_state_t *s2, lt_l3_state_t *s3, lt_l3_sink_t sink, void *sink_ctx)
+    __attribute__((warn_unused_result));
+#endif
+
 #ifdef TEST
 /**
  * @brief Used to increase nonce
@@ -75,6 +120,21 @@ lt_ret_t lt_l3_decrypt_response(lt_l3_state_t *s3) __attribute__((warn_unused_re
 LT_STATIC lt_ret_t lt_l3_nonce_increase(uint8_t *nonce) __attribute__((warn_unused_result));
 #endif
 
+/**
+ * @brief Raises high-water mark of L3 result buffer, so `lt_l3_buff_wipe()` clears also the received result.
+ *
+ * @param s3          Structure holding l3 state
+ * @param len         Number of bytes written from the beginning of the buffer, clamped to its length
+ */
+void lt_l3_res_buff_used(lt_l3_state_t *s3, uint16_t len);
+
+/**
+ * @brief Wipes the part of L3 buffers written since the last wipe.
+ *
+ * @param s3          Structure holding l3 state
+ */
+void lt_l3_buff_wipe(lt_l3_state_t *s3);
+
 /**
  * @brief Invalidates host's session data
  *
@@ -82,6 +142,56 @@ LT_STATIC lt_ret_t lt_l3_nonce_increase(uint8_t *nonce) __attribute__((warn_unus
  */
 void lt_l3_invalidate_host_session_data(lt_l3_state_t *s3);
 
+/**
+ * @brief Sums lengths of fragments
+ *
+ * @param iov         Fragments, can be NULL when `iov_cnt` is 0
+ * @param iov_cnt     Number of fragments
+ * @param len         Total length
+ * @return            LT_OK, LT_PARAM_ERR when a fragment of nonzero length has no base
+ */
+lt_ret_t lt_iov_len(const lt_iovec_t *iov, const uint8_t iov_cnt, size_t *len) __attribute__((warn_unused_result));
+
+/** @brief Same as `lt_iov_len()` for fragments of a result */
+lt_ret_t lt_iov_out_len(const lt_iovec_out_t *iov, const uint8_t iov_cnt, size_t *len)
+    __attribute__((warn_unused_result));
+
+/**
+ * @brief Copies fragments after each other into `dst`
+ *
+ * @param dst         Destination, total length of fragments
+ * @param iov         Fragments checked by `lt_iov_len()`
+ * @param iov_cnt     Number of fragments
+ */
+void lt_iov_gather(uint8_t *dst, const lt_iovec_t *iov, const uint8_t iov_cnt);
+
+/**
+ * @brief Copies `len` bytes of `src` into fragments, the first fragments are filled first
+ *
+ * @param src         Source
+ * @param len         Length of source, at most total length of fragments
+ * @param iov         Fragments checked by `lt_iov_out_len()`
+ * @param iov_cnt     Number of fragments
+ */
+void lt_iov_scatter(const uint8_t *src, size_t len, const lt_iovec_out_t *iov, const uint8_t iov_cnt);
+
+/**
+ * @brief Same as `lt_session_hash_prefix()`, but hashes in `hctx` instead of a context on the stack
+ *
+ * @param hctx        SHA256 context, `LT_SHA256_CTX_SIZE` bytes aligned to 8
+ * @param shipub      Secure host public key
+ * @param stpub       STPUB from device's certificate
+ * @param hash        Buffer for the hash (32B)
+ */
+void lt_session_hash_prefix_hctx(void *hctx, const uint8_t *shipub, const uint8_t *stpub, uint8_t *hash);
+
+/** @brief Same as `lt_session_start_precompute()`, but hashes in `hctx` */
+lt_ret_t lt_session_start_precompute_hctx(void *hctx, const lt_session_ctx_t *ctx, session_state_t *state);
+
+/** @brief Same as `lt_in__session_start_ctx()`, but hashes in `hctx` */
+lt_ret_t lt_in__session_start_ctx_hctx(lt_handle_t *h, void *hctx, const lt_session_ctx_t *ctx,
+                                       session_state_t *state);
+
 /** @} */  // end of group_l3_functions group
 
 #endif
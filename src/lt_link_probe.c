@@ -0,0 +1,227 @@
+/**
+ * @file lt_link_probe.c
+ * @brief Link probe definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_link_probe.h"
+#include "libtropic_port.h"
+#include "lt_l2_api_structs.h"
+#include "lt_l3_api_structs.h"
+
+/** Length of the shortest Ping */
+#define LT_LINK_PROBE_LEN_MIN 16
+
+/** Number of L2 frames carrying `size` bytes of L3 packet */
+#define LT_LINK_PROBE_CHUNKS(size) (((size) + L2_CHUNK_MAX_DATA_SIZE - 1) / L2_CHUNK_MAX_DATA_SIZE)
+
+/** Reads counters of CRC errors and resends of the handle, which are compared before and after the probe */
+static void lt_link_probe_errors(const lt_handle_t *h, uint32_t *crc_errors, uint32_t *resends)
+{
+    *crc_errors = 0;
+    *resends = 0;
+#if LT_L2_RETRY_POLICY
+    *crc_errors = h->l2.retry.stats.crc_errors;
+    *resends = h->l2.retry.stats.resends;
+#elif LT_STATS
+    if (h->l2.stats) {
+        for (size_t i = 0; i < LT_STATS_CNT; i++) {
+            *crc_errors += h->l2.stats->entries[i].crc_errors;
+            *resends += h->l2.stats->entries[i].resends;
+        }
+    }
+#else
+    (void)h;
+#endif
+}
+
+/** Sorts latency samples, there are at most LT_LINK_PROBE_SAMPLES_MAX of them */
+static void lt_link_probe_sort(uint32_t *samples, const uint16_t cnt)
+{
+    for (uint16_t i = 1; i < cnt; i++) {
+        uint32_t v = samples[i];
+        uint16_t j = i;
+        for (; (j > 0) && (samples[j - 1] > v); j--) {
+            samples[j] = samples[j - 1];
+        }
+        samples[j] = v;
+    }
+}
+
+static lt_ret_t lt_link_probe_latency(lt_handle_t *h, const lt_link_probe_cfg_t *cfg, lt_link_probe_result_t *res)
+{
+    uint32_t samples[LT_LINK_PROBE_SAMPLES_MAX];
+    struct lt_chip_id_t chip_id;
+    uint64_t total_us = 0;
+    lt_link_probe_latency_t *lat = &res->latency;
+
+    for (uint16_t i = 0; i < cfg->rounds; i++) {
+        uint32_t start_us = cfg->time_us();
+        lt_ret_t ret = lt_get_info_chip_id(h, &chip_id);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        samples[i] = cfg->time_us() - start_us;
+        total_us += samples[i];
+        res->frames += 2;
+    }
+    lat->cnt = cfg->rounds;
+    if (!lat->cnt) {
+        return LT_OK;
+    }
+
+    lt_link_probe_sort(samples, lat->cnt);
+    lat->min_us = samples[0];
+    lat->median_us = samples[(lat->cnt - 1) / 2];
+    // Nearest rank
+    lat->p90_us = samples[((lat->cnt * 90u + 99u) / 100u) - 1];
+    lat->max_us = samples[lat->cnt - 1];
+    lat->avg_us = (uint32_t)(total_us / lat->cnt);
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_link_probe_tput(lt_handle_t *h, const lt_link_probe_cfg_t *cfg, lt_link_probe_result_t *res)
+{
+    uint16_t len_max = (cfg->buff_len < LT_PING_LEN_MAX) ? cfg->buff_len : LT_PING_LEN_MAX;
+    uint32_t len = LT_LINK_PROBE_LEN_MIN;
+
+    memset(cfg->buff, 0xa5, len_max);
+    for (size_t k = 0; (k < LT_LINK_PROBE_SIZES) && (len <= len_max); k++, len *= 4) {
+        lt_link_probe_tput_t *tput = &res->tput[k];
+        // The longest Ping uses whole buffer
+        if ((k + 1 == LT_LINK_PROBE_SIZES) || (len * 4 > len_max)) {
+            len = len_max;
+        }
+
+        uint32_t start_us = cfg->time_us();
+        for (uint16_t i = 0; i < cfg->ping_rounds; i++) {
+            // Message is sent from the buffer before the same one is received into it
+            lt_ret_t ret = lt_ping(h, cfg->buff, cfg->buff, (uint16_t)len);
+            if (ret != LT_OK) {
+                return ret;
+            }
+        }
+        uint32_t total_us = cfg->time_us() - start_us;
+
+        tput->len = (uint16_t)len;
+        tput->avg_us = total_us / cfg->ping_rounds;
+        if (total_us) {
+            tput->bytes_per_s = (uint32_t)((2ull * len * cfg->ping_rounds * 1000000ull) / total_us);
+        }
+        // Command and result have the same length, each chunk of the command is acknowledged, the result is only read
+        res->frames += cfg->ping_rounds * 3 * LT_LINK_PROBE_CHUNKS(LT_L3_PACKET_SIZE(1 + len));
+    }
+
+    return LT_OK;
+}
+
+#if LT_ADAPTIVE_POLLING
+/** Commands of the probe, polled every LT_LINK_PROBE_POLL_US */
+static const lt_l1_poll_profile_t lt_link_probe_poll_profiles[LT_LINK_PROBE_PROFILES] = {
+    {LT_L1_POLL_CMD_L2(LT_L2_GET_INFO_REQ_ID), 0, LT_LINK_PROBE_POLL_US, LT_LINK_PROBE_POLL_US},
+    {LT_L1_POLL_CMD_L3(LT_L3_PING_CMD_ID), 0, LT_LINK_PROBE_POLL_US, LT_LINK_PROBE_POLL_US},
+    {LT_L1_POLL_CMD_L3_CHUNK, 0, LT_LINK_PROBE_POLL_US, LT_LINK_PROBE_POLL_US},
+};
+
+/** Derives profile of the command from its waits measured during the probe */
+static void lt_link_probe_profile(const lt_l1_poll_t *poll, lt_l1_poll_profile_t *p)
+{
+    const lt_l1_poll_stats_t *stats = NULL;
+
+    for (size_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+        if ((poll->stats[i].cmd == p->cmd) && poll->stats[i].cnt) {
+            stats = &poll->stats[i];
+            break;
+        }
+    }
+    if (!stats) {
+        // Command was not measured, the profile equals to the default one of commands without flash writes
+        p->first_delay_us = 0;
+        p->retry_delay_us = 250;
+        p->max_delay_us = 8000;
+        return;
+    }
+
+    // The second poll comes within the spread of waits, the gaps are not longer than the spread
+    uint32_t spread_us = stats->max_us - stats->min_us;
+    p->first_delay_us = stats->min_us;
+    p->retry_delay_us = ((spread_us / 4) > LT_LINK_PROBE_POLL_US) ? (spread_us / 4) : LT_LINK_PROBE_POLL_US;
+    p->max_delay_us = (spread_us > p->retry_delay_us) ? spread_us : p->retry_delay_us;
+}
+#endif
+
+static lt_ret_t lt_link_probe_run(lt_handle_t *h, const lt_link_probe_cfg_t *cfg, lt_link_probe_result_t *res)
+{
+    uint32_t crc_errors, resends;
+
+    lt_link_probe_errors(h, &crc_errors, &resends);
+
+    lt_ret_t ret = lt_link_probe_latency(h, cfg, res);
+    if ((ret == LT_OK) && cfg->ping_rounds) {
+        ret = lt_link_probe_tput(h, cfg, res);
+    }
+
+    uint32_t crc_errors_end, resends_end;
+    lt_link_probe_errors(h, &crc_errors_end, &resends_end);
+    res->crc_errors = crc_errors_end - crc_errors;
+    res->resends = resends_end - resends;
+    if (res->frames) {
+        res->crc_error_ppm = (uint32_t)(((uint64_t)res->crc_errors * 1000000u) / res->frames);
+    }
+
+    return ret;
+}
+
+lt_ret_t lt_link_probe(lt_handle_t *h, const lt_link_probe_cfg_t *cfg, lt_link_probe_result_t *res)
+{
+    if (!h || !cfg || !res || !cfg->time_us || (cfg->rounds > LT_LINK_PROBE_SAMPLES_MAX)
+        || (cfg->ping_rounds && (!cfg->buff || (cfg->buff_len < LT_LINK_PROBE_LEN_MIN)))) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(res, 0, sizeof(*res));
+#if LT_THREAD_SAFE
+    // Recursive, calls of the API lock the handle again
+    lt_port_lock(&h->l2);
+#endif
+#if LT_GET_INFO_CACHE
+    // Each GET_INFO has to go to TROPIC01
+    struct lt_get_info_cache_t *info_cache = h->info_cache;
+    h->info_cache = NULL;
+#endif
+#if LT_ADAPTIVE_POLLING
+    // Waits of the probe do not mix with the statistics learned by the application
+    lt_l1_poll_t poll = h->l2.poll;
+    h->l2.poll.profiles = lt_link_probe_poll_profiles;
+    h->l2.poll.profiles_cnt = LT_LINK_PROBE_PROFILES;
+    h->l2.poll.learn = 0;
+    memset(h->l2.poll.stats, 0, sizeof(h->l2.poll.stats));
+#endif
+
+    lt_ret_t ret = lt_link_probe_run(h, cfg, res);
+
+#if LT_ADAPTIVE_POLLING
+    for (size_t i = 0; i < LT_LINK_PROBE_PROFILES; i++) {
+        res->profiles[i].cmd = lt_link_probe_poll_profiles[i].cmd;
+        lt_link_probe_profile(&h->l2.poll, &res->profiles[i]);
+    }
+    h->l2.poll = poll;
+#endif
+#if LT_GET_INFO_CACHE
+    h->info_cache = info_cache;
+#endif
+#if LT_THREAD_SAFE
+    lt_port_unlock(&h->l2);
+#endif
+
+    return ret;
+}
@@ -0,0 +1,439 @@
+/**
+ * @file lt_log.c
+ * @brief Deferred logging backend
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+/** Max length of one rebuilt conversion specification, e.g. "%-012.34llx" */
+#define LT_LOG_SPEC_SIZE 24
+
+/** Length modifier of conversion specification */
+typedef enum lt_log_len_t {
+    LT_LOG_LEN_NONE,
+    LT_LOG_LEN_L,
+    LT_LOG_LEN_LL,
+    LT_LOG_LEN_J,
+    LT_LOG_LEN_Z,
+    LT_LOG_LEN_T
+} lt_log_len_t;
+
+/** Parsed conversion specification */
+typedef struct lt_log_spec_t {
+    /** Flags, e.g. "-0", NUL terminated */
+    char flags[6];
+    /** Width, -1 when not given */
+    int width;
+    /** Precision, -1 when not given */
+    int prec;
+    /** Width is given by an argument */
+    uint8_t width_arg;
+    /** Precision is given by an argument */
+    uint8_t prec_arg;
+    /** Length modifier */
+    lt_log_len_t len;
+    /** Conversion specifier, 0 when not supported */
+    char conv;
+} lt_log_spec_t;
+
+/** Ring receiving deferred messages, NULL formats them immediately */
+static lt_log_t *lt_log_active;
+
+/** Parses decimal number of conversion specification */
+static const char *lt_log_num(const char *p, int *v)
+{
+    *v = 0;
+    while (*p >= '0' && *p <= '9') {
+        *v = (*v * 10) + (*p - '0');
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Parses conversion specification following '%', returns pointer behind it.
+ * Lengths hh and h are handled as none, because such arguments are promoted to int.
+ */
+static const char *lt_log_parse(const char *p, lt_log_spec_t *spec)
+{
+    size_t n = 0;
+
+    memset(spec, 0, sizeof(*spec));
+    spec->width = -1;
+    spec->prec = -1;
+
+    while (*p && strchr("-+ #0", *p)) {
+        if (n < sizeof(spec->flags) - 1) {
+            spec->flags[n++] = *p;
+        }
+        p++;
+    }
+    if (*p == '*') {
+        spec->width_arg = 1;
+        p++;
+    }
+    else if (*p >= '0' && *p <= '9') {
+        p = lt_log_num(p, &spec->width);
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->prec_arg = 1;
+            p++;
+        }
+        else {
+            p = lt_log_num(p, &spec->prec);
+        }
+    }
+
+    switch (*p) {
+        case 'h':
+            p += (p[1] == 'h') ? 2 : 1;
+            break;
+        case 'l':
+            spec->len = (p[1] == 'l') ? LT_LOG_LEN_LL : LT_LOG_LEN_L;
+            p += (p[1] == 'l') ? 2 : 1;
+            break;
+        case 'j':
+            spec->len = LT_LOG_LEN_J;
+            p++;
+            break;
+        case 'z':
+            spec->len = LT_LOG_LEN_Z;
+            p++;
+            break;
+        case 't':
+            spec->len = LT_LOG_LEN_T;
+            p++;
+            break;
+        default:
+            break;
+    }
+
+    // Long double (L) and %n are not supported, formatting stops there
+    if (*p && strchr("diuoxXcspfFeEgGaA%", *p)) {
+        spec->conv = *p++;
+    }
+
+    return p;
+}
+
+/** Number of arguments consumed by conversion specification */
+static uint8_t lt_log_spec_args(const lt_log_spec_t *spec)
+{
+    if (spec->conv == '%') {
+        return 0;
+    }
+    return (uint8_t)(1 + spec->width_arg + spec->prec_arg);
+}
+
+/** Reads int argument of '*' width or precision */
+static int lt_log_int(const lt_log_arg_t *a)
+{
+    int v;
+    memcpy(&v, a, sizeof(v));
+    return v;
+}
+
+/** Stores message with its arguments into an entry, strings are copied */
+static void lt_log_capture(lt_log_entry_t *e, const lt_log_level_t level, const uint16_t line, const char *fmt,
+                           uint8_t nargs, const lt_log_arg_t *args)
+{
+    size_t str_len = 0;
+    uint8_t i = 0;
+
+    if (nargs > LT_LOG_ARGS_MAX) {
+        nargs = LT_LOG_ARGS_MAX;
+    }
+    e->level = (uint8_t)level;
+    e->line = line;
+    e->fmt = fmt;
+    e->nargs = nargs;
+    memcpy(e->args, args, nargs * sizeof(lt_log_arg_t));
+    // Last byte stays empty string for strings not fitting the buffer
+    e->str[LT_LOG_STR_SIZE - 1] = '\0';
+
+    for (const char *p = fmt; *p;) {
+        lt_log_spec_t spec;
+
+        if (*p++ != '%') {
+            continue;
+        }
+        p = lt_log_parse(p, &spec);
+        if (!spec.conv || (i + lt_log_spec_args(&spec)) > nargs) {
+            break;
+        }
+        i = (uint8_t)(i + lt_log_spec_args(&spec));
+        if (spec.conv != 's') {
+            continue;
+        }
+
+        // Argument of %s is replaced by offset of its copy
+        const lt_log_arg_t *a = &e->args[i - 1];
+        const char *s = a->p ? (const char *)a->p : "(null)";
+        size_t avail = LT_LOG_STR_SIZE - 1 - str_len;
+        size_t n = strlen(s);
+
+        if (spec.prec >= 0 && (size_t)spec.prec < n) {
+            n = (size_t)spec.prec;
+        }
+        if (!avail) {
+            e->args[i - 1].u = LT_LOG_STR_SIZE - 1;
+            continue;
+        }
+        if (n >= avail) {
+            n = avail - 1;
+        }
+        memcpy(&e->str[str_len], s, n);
+        e->str[str_len + n] = '\0';
+        e->args[i - 1].u = str_len;
+        str_len += n + 1;
+    }
+}
+
+/** Appends formatted number of characters to message, keeps track of truncation */
+static void lt_log_advance(size_t *len, const int n)
+{
+    if (n > 0) {
+        *len += (size_t)n;
+    }
+    if (*len > LT_LOG_MSG_SIZE - 1) {
+        *len = LT_LOG_MSG_SIZE - 1;
+    }
+}
+
+// Specification is built from a format string checked by the compiler in LT_LOG_DEFER(), so the format
+// passed to snprintf() is safe even though it is not a literal.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+/** Formats one conversion of entry into message */
+static int lt_log_conv(char *out, const size_t size, const char *sp, const lt_log_spec_t *spec,
+                       const lt_log_entry_t *e, const lt_log_arg_t *a)
+{
+    switch (spec->conv) {
+        case 's':
+            return snprintf(out, size, sp, &e->str[(a->u < LT_LOG_STR_SIZE) ? a->u : LT_LOG_STR_SIZE - 1]);
+        case 'p':
+            return snprintf(out, size, sp, a->p);
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            return snprintf(out, size, sp, a->d);
+        default:
+            break;
+    }
+
+    // Integer conversions, signedness of the value does not matter for its bits
+    switch (spec->len) {
+        case LT_LOG_LEN_L: {
+            long v;
+            memcpy(&v, a, sizeof(v));
+            return snprintf(out, size, sp, v);
+        }
+        case LT_LOG_LEN_LL: {
+            long long v;
+            memcpy(&v, a, sizeof(v));
+            return snprintf(out, size, sp, v);
+        }
+        case LT_LOG_LEN_J: {
+            intmax_t v;
+            memcpy(&v, a, sizeof(v));
+            return snprintf(out, size, sp, v);
+        }
+        case LT_LOG_LEN_Z: {
+            size_t v;
+            memcpy(&v, a, sizeof(v));
+            return snprintf(out, size, sp, v);
+        }
+        case LT_LOG_LEN_T: {
+            ptrdiff_t v;
+            memcpy(&v, a, sizeof(v));
+            return snprintf(out, size, sp, v);
+        }
+        default:
+            return snprintf(out, size, sp, lt_log_int(a));
+    }
+}
+#pragma GCC diagnostic pop
+
+/** Formats entry into message */
+static void lt_log_format(const lt_log_entry_t *e, char *msg)
+{
+    static const char lens[][3] = {"", "l", "ll", "j", "z", "t"};
+    size_t len = 0;
+    uint8_t i = 0;
+
+    for (const char *p = e->fmt; *p && len < LT_LOG_MSG_SIZE - 1;) {
+        lt_log_spec_t spec;
+        char sp[LT_LOG_SPEC_SIZE];
+        int width, prec;
+
+        if (*p != '%') {
+            msg[len++] = *p++;
+            continue;
+        }
+        p = lt_log_parse(p + 1, &spec);
+        if (!spec.conv || (i + lt_log_spec_args(&spec)) > e->nargs) {
+            break;
+        }
+        if (spec.conv == '%') {
+            msg[len++] = '%';
+            continue;
+        }
+
+        // Arguments of '*' are written into the specification as numbers
+        width = spec.width_arg ? lt_log_int(&e->args[i++]) : spec.width;
+        prec = spec.prec_arg ? lt_log_int(&e->args[i++]) : spec.prec;
+        int n = snprintf(sp, sizeof(sp), "%%%s", spec.flags);
+        if (width >= 0) {
+            n += snprintf(&sp[n], sizeof(sp) - (size_t)n, "%d", width);
+        }
+        if (prec >= 0) {
+            n += snprintf(&sp[n], sizeof(sp) - (size_t)n, ".%d", prec);
+        }
+        snprintf(&sp[n], sizeof(sp) - (size_t)n, "%s%c", lens[spec.len], spec.conv);
+
+        lt_log_advance(&len, lt_log_conv(&msg[len], LT_LOG_MSG_SIZE - len, sp, &spec, e, &e->args[i++]));
+    }
+    msg[len] = '\0';
+}
+
+/** Passes message to sink, default sink prints it in the format of the immediate LT_LOG_* macros */
+static void lt_log_emit(const lt_log_t *log, const lt_log_level_t level, const uint16_t line, const char *msg)
+{
+    static const char *const names[] = {"", "", "ERROR", "WARNING", "INFO", "DEBUG"};
+
+    if (log && log->sink) {
+        log->sink(log->sink_ctx, level, line, msg);
+        return;
+    }
+    printf("%-7s [%4d] %s\r\n", (level <= LT_LOG_LEVEL_DEBUG) ? names[level] : "", line, msg);
+}
+
+lt_ret_t lt_log_init(lt_log_t *log, lt_log_entry_t *entries, const uint32_t cnt, lt_log_sink_t sink, void *sink_ctx)
+{
+    // Number of slots is a power of two, so the slot is taken by masking
+    if (!log || !entries || !cnt || (cnt & (cnt - 1))) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(entries, 0, cnt * sizeof(lt_log_entry_t));
+    for (uint32_t i = 0; i < cnt; i++) {
+        entries[i].seq = i;
+    }
+    if (!log->level) {
+        log->level = LT_LOG_LEVEL_DEBUG;
+    }
+    log->sink = sink;
+    log->sink_ctx = sink_ctx;
+    log->entries = entries;
+    log->mask = cnt - 1;
+    log->head = 0;
+    log->tail = 0;
+    log->dropped = 0;
+    __atomic_store_n(&lt_log_active, log, __ATOMIC_RELEASE);
+
+    return LT_OK;
+}
+
+int lt_log_enabled(const lt_log_level_t level, const uint8_t filter)
+{
+    uint8_t threshold = filter;
+
+    if (threshold == LT_LOG_LEVEL_DEFAULT) {
+        const lt_log_t *log = __atomic_load_n(&lt_log_active, __ATOMIC_ACQUIRE);
+        threshold = log ? log->level : LT_LOG_LEVEL_DEBUG;
+    }
+
+    return level <= threshold;
+}
+
+void lt_log_defer(const lt_log_level_t level, const uint16_t line, const char *fmt, const uint8_t nargs,
+                  const lt_log_arg_t *args)
+{
+    lt_log_t *log = __atomic_load_n(&lt_log_active, __ATOMIC_ACQUIRE);
+
+    if (!log) {
+        lt_log_entry_t e;
+        char msg[LT_LOG_MSG_SIZE];
+
+        lt_log_capture(&e, level, line, fmt, nargs, args);
+        lt_log_format(&e, msg);
+        lt_log_emit(NULL, level, line, msg);
+        return;
+    }
+
+    // Bounded multi-producer queue: a slot is free for position pos when its seq equals pos, and it holds
+    // a message when its seq equals pos + 1.
+    uint32_t pos = __atomic_load_n(&log->head, __ATOMIC_RELAXED);
+    lt_log_entry_t *e;
+    for (;;) {
+        e = &log->entries[pos & log->mask];
+        int32_t diff = (int32_t)(__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&log->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            __atomic_fetch_add(&log->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else {
+            pos = __atomic_load_n(&log->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    lt_log_capture(e, level, line, fmt, nargs, args);
+    __atomic_store_n(&e->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t lt_log_flush(lt_log_t *log, const uint32_t max)
+{
+    char msg[LT_LOG_MSG_SIZE];
+    uint32_t cnt = 0;
+
+    if (!log || !log->entries) {
+        return 0;
+    }
+
+    uint32_t dropped = __atomic_exchange_n(&log->dropped, 0, __ATOMIC_RELAXED);
+    if (dropped) {
+        snprintf(msg, sizeof(msg), "%" PRIu32 " log messages dropped", dropped);
+        lt_log_emit(log, LT_LOG_LEVEL_WARN, 0, msg);
+    }
+
+    while (cnt < max) {
+        uint32_t pos = log->tail;
+        lt_log_entry_t *e = &log->entries[pos & log->mask];
+
+        if ((int32_t)(__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) - (pos + 1)) < 0) {
+            break;
+        }
+        lt_log_format(e, msg);
+        lt_log_emit(log, (lt_log_level_t)e->level, e->line, msg);
+
+        // Slot is free again for the position one lap later
+        __atomic_store_n(&e->seq, pos + log->mask + 1, __ATOMIC_RELEASE);
+        log->tail = pos + 1;
+        cnt++;
+    }
+
+    return cnt;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file lt_log_drain.c
+ * @brief Log drain definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_log_drain.h"
+#include "libtropic_port.h"
+
+#if LT_THREAD_SAFE
+#define LT_LOG_DRAIN_LOCK(h) lt_port_lock(&(h)->l2)
+#define LT_LOG_DRAIN_UNLOCK(h) lt_port_unlock(&(h)->l2)
+#else
+#define LT_LOG_DRAIN_LOCK(h) (void)(h)
+#define LT_LOG_DRAIN_UNLOCK(h) (void)(h)
+#endif
+
+/** Copies `len` bytes into the ring at `pos`, wrapping at its end */
+static void lt_log_drain_put(lt_log_drain_t *d, uint16_t pos, const uint8_t *src, uint16_t len)
+{
+    uint16_t first = (uint16_t)((len < d->buff_len - pos) ? len : d->buff_len - pos);
+
+    memcpy(d->buff + pos, src, first);
+    memcpy(d->buff, src + first, len - first);
+}
+
+/** Copies `len` bytes from the ring at `pos`, wrapping at its end */
+static void lt_log_drain_get(const lt_log_drain_t *d, uint16_t pos, uint8_t *dst, uint16_t len)
+{
+    uint16_t first = (uint16_t)((len < d->buff_len - pos) ? len : d->buff_len - pos);
+
+    memcpy(dst, d->buff + pos, first);
+    memcpy(dst + first, d->buff, len - first);
+}
+
+static uint16_t lt_log_drain_pos(const lt_log_drain_t *d, uint32_t pos)
+{
+    return (uint16_t)((pos >= d->buff_len) ? pos - d->buff_len : pos);
+}
+
+/** Drops the oldest record */
+static void lt_log_drain_drop(lt_log_drain_t *d)
+{
+    uint8_t hdr[LT_LOG_DRAIN_HDR_LEN];
+    lt_log_drain_get(d, d->tail, hdr, sizeof(hdr));
+
+    uint16_t rec_len = (uint16_t)(LT_LOG_DRAIN_HDR_LEN + hdr[4]);
+    d->tail = lt_log_drain_pos(d, (uint32_t)d->tail + rec_len);
+    d->used = (uint16_t)(d->used - rec_len);
+    d->stats.dropped++;
+}
+
+static void lt_log_drain_store(lt_log_drain_t *d, uint32_t time_us, const uint8_t *msg, uint16_t msg_len)
+{
+    uint16_t rec_len = (uint16_t)(LT_LOG_DRAIN_HDR_LEN + msg_len);
+
+    if (rec_len > d->buff_len) {
+        d->stats.dropped++;
+        return;
+    }
+    while (d->buff_len - d->used < rec_len) {
+        lt_log_drain_drop(d);
+    }
+
+    uint8_t hdr[LT_LOG_DRAIN_HDR_LEN] = {(uint8_t)time_us, (uint8_t)(time_us >> 8), (uint8_t)(time_us >> 16),
+                                         (uint8_t)(time_us >> 24), (uint8_t)msg_len};
+    uint16_t head = lt_log_drain_pos(d, (uint32_t)d->tail + d->used);
+    lt_log_drain_put(d, head, hdr, sizeof(hdr));
+    lt_log_drain_put(d, lt_log_drain_pos(d, (uint32_t)head + sizeof(hdr)), msg, msg_len);
+    d->used = (uint16_t)(d->used + rec_len);
+    d->stats.msgs++;
+    d->stats.bytes += msg_len;
+}
+
+lt_ret_t lt_log_drain_init(lt_log_drain_t *d)
+{
+    if (!d || !d->time_us || !d->buff || (d->buff_len < LT_LOG_DRAIN_HDR_LEN)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(&d->stats, 0, sizeof(d->stats));
+    d->tail = 0;
+    d->used = 0;
+    // The first poll sends its request at once
+    d->last_us = d->time_us() - d->period_us;
+
+    return LT_OK;
+}
+
+lt_ret_t lt_log_drain_poll(lt_handle_t *h, lt_log_drain_t *d)
+{
+    if (!h || !d || !d->time_us || !d->buff) {
+        return LT_PARAM_ERR;
+    }
+
+    LT_LOG_DRAIN_LOCK(h);
+    uint32_t now = d->time_us();
+    if (now - d->last_us < d->period_us) {
+        LT_LOG_DRAIN_UNLOCK(h);
+        return LT_BUSY;
+    }
+#if LT_IDLE_SLEEP
+    lt_idle_t *idle = h->l2.idle;
+    if (idle && idle->asleep) {
+        LT_LOG_DRAIN_UNLOCK(h);
+        return LT_BUSY;
+    }
+    // Draining is not a communication of the application, the idle window keeps running
+    uint32_t idle_last_us = idle ? idle->last_us : 0;
+#endif
+
+    uint8_t msg[GET_LOG_MAX_MSG_LEN];
+    uint16_t msg_len = 0;
+    lt_ret_t ret = lt_get_log_req(h, msg, &msg_len);
+    d->last_us = now;
+    d->stats.requests++;
+#if LT_IDLE_SLEEP
+    if (idle) {
+        idle->last_us = idle_last_us;
+    }
+#endif
+    if ((ret == LT_OK) && msg_len) {
+        lt_log_drain_store(d, now, msg, msg_len);
+    }
+    LT_LOG_DRAIN_UNLOCK(h);
+
+    return ret;
+}
+
+lt_ret_t lt_log_drain_read(lt_handle_t *h, lt_log_drain_t *d, uint32_t *time_us, uint8_t *msg, uint16_t *msg_len)
+{
+    if (!h || !d || !time_us || !msg || !msg_len) {
+        return LT_PARAM_ERR;
+    }
+
+    LT_LOG_DRAIN_LOCK(h);
+    if (!d->used) {
+        LT_LOG_DRAIN_UNLOCK(h);
+        return LT_PENDING;
+    }
+
+    uint8_t hdr[LT_LOG_DRAIN_HDR_LEN];
+    lt_log_drain_get(d, d->tail, hdr, sizeof(hdr));
+    *time_us = (uint32_t)hdr[0] | ((uint32_t)hdr[1] << 8) | ((uint32_t)hdr[2] << 16) | ((uint32_t)hdr[3] << 24);
+    *msg_len = hdr[4];
+    lt_log_drain_get(d, lt_log_drain_pos(d, (uint32_t)d->tail + sizeof(hdr)), msg, *msg_len);
+
+    uint16_t rec_len = (uint16_t)(LT_LOG_DRAIN_HDR_LEN + hdr[4]);
+    d->tail = lt_log_drain_pos(d, (uint32_t)d->tail + rec_len);
+    d->used = (uint16_t)(d->used - rec_len);
+    // Positions of an empty ring start from its beginning again
+    if (!d->used) {
+        d->tail = 0;
+    }
+    LT_LOG_DRAIN_UNLOCK(h);
+
+    return LT_OK;
+}
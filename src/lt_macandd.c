@@ -0,0 +1,383 @@
+/**
+ * @file lt_macandd.c
+ * @brief MAC-and-Destroy PIN engine definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_macandd.h"
+#include "libtropic_macros.h"
+#include "lt_hmac_sha256.h"
+#include "lt_random.h"
+
+/** Magic of the header slot, "LTMD" */
+#define LT_MACANDD_MAGIC 0x444d544cu
+/** Version of the layout */
+#define LT_MACANDD_VERSION 1
+
+/** Number of rounds whose MAC-and-Destroy commands are pipelined together */
+#ifndef LT_MACANDD_BATCH_ROUNDS
+#define LT_MACANDD_BATCH_ROUNDS 4
+#endif
+
+/** Header slot, ciphertexts of the secret follow in the next slots */
+struct lt_macandd_hdr_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t rounds;
+    /** Number of remaining attempts */
+    uint8_t i;
+    /** Tag t = KDF(s, "0") verifying the decrypted secret */
+    uint8_t t[32];
+} __attribute__((packed));
+
+STATIC_ASSERT(sizeof(struct lt_macandd_hdr_t) <= R_MEM_DATA_SIZE_MAX)
+STATIC_ASSERT(sizeof(struct lt_hmac_sha256_ctx_t) <= MEMBER_SIZE(lt_macandd_t, kdf_zero))
+STATIC_ASSERT(MAC_AND_DESTROY_DATA_SIZE == 32)
+
+static uint32_t lt_macandd_now(const lt_macandd_t *m) { return m->time_ms ? m->time_ms() : 0; }
+
+/** Returns true when both buffers are equal, in time independent of their content */
+static bool lt_macandd_equal(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= a[i] ^ b[i];
+    }
+
+    return !diff;
+}
+
+/** Executes MAC-and-Destroy with `data` on slots first to last - 1, returned data are discarded */
+static lt_ret_t lt_macandd_init_slots(lt_macandd_t *m, uint8_t first, uint8_t last, const uint8_t *data)
+{
+    mac_and_destroy_slot_t slots[LT_MACANDD_BATCH_ROUNDS];
+    uint8_t data_out[LT_MACANDD_BATCH_ROUNDS * 32];
+    uint8_t garbage[LT_MACANDD_BATCH_ROUNDS * 32];
+    lt_ret_t ret = LT_OK;
+
+    for (uint8_t i = 0; i < LT_MACANDD_BATCH_ROUNDS; i++) {
+        memcpy(data_out + (i * 32), data, 32);
+    }
+
+    while ((first < last) && (ret == LT_OK)) {
+        uint16_t n = 0;
+        while ((first < last) && (n < LT_MACANDD_BATCH_ROUNDS)) {
+            slots[n++] = (mac_and_destroy_slot_t)first++;
+        }
+        ret = lt_mac_and_destroy_batch(m->h, slots, data_out, n, garbage);
+    }
+
+    memset(data_out, 0, sizeof(data_out));
+    memset(garbage, 0, sizeof(garbage));
+
+    return ret;
+}
+
+static lt_ret_t lt_macandd_hdr_read(lt_macandd_t *m, struct lt_macandd_hdr_t *hdr)
+{
+    uint8_t buff[R_MEM_DATA_SIZE_MAX];
+    uint16_t size = 0;
+
+    lt_ret_t ret = lt_r_mem_data_read(m->h, m->nvm_slot, buff, &size);
+    if (ret == LT_L3_R_MEM_DATA_READ_SLOT_EMPTY) {
+        return LT_FAIL;
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (size != sizeof(*hdr)) {
+        return LT_FAIL;
+    }
+    memcpy(hdr, buff, sizeof(*hdr));
+    if ((hdr->magic != LT_MACANDD_MAGIC) || (hdr->version != LT_MACANDD_VERSION) || (hdr->rounds != m->rounds)
+        || (hdr->i > m->rounds)) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_macandd_hdr_rewrite(lt_macandd_t *m, const struct lt_macandd_hdr_t *hdr)
+{
+    lt_ret_t ret = lt_r_mem_data_erase(m->h, m->nvm_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_r_mem_data_write(m->h, m->nvm_slot, (const uint8_t *)hdr, sizeof(*hdr));
+}
+
+lt_ret_t lt_macandd_init(lt_macandd_t *m, lt_handle_t *h, const uint8_t rounds, const uint16_t nvm_slot,
+                         uint32_t (*time_ms)(void))
+{
+    if (!m || !h || !rounds || (rounds > MACANDD_ROUNDS_MAX) || (nvm_slot > R_MEM_DATA_SLOT_MAX)
+        || (LT_MACANDD_NVM_SLOTS(rounds) > R_MEM_DATA_SLOT_MAX + 1 - nvm_slot)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(m, 0, sizeof(*m));
+    m->h = h;
+    m->rounds = rounds;
+    m->nvm_slot = nvm_slot;
+    m->time_ms = time_ms;
+
+    // v = KDF(0, PIN||A) is computed on each set and check, the pads of the zero key are computed only here
+    struct lt_hmac_sha256_ctx_t ctx;
+    const uint8_t zero_key[32] = {0};
+    lt_hmac_sha256_init(&ctx, zero_key, sizeof(zero_key));
+    memcpy(m->kdf_zero, &ctx, sizeof(ctx));
+
+    return LT_OK;
+}
+
+lt_ret_t lt_macandd_pin_set(lt_macandd_t *m, const uint8_t *pin, const uint8_t pin_size, const uint8_t *add,
+                            const uint8_t add_size, uint8_t *secret)
+{
+    if (!m || !m->h || !pin || (pin_size < LT_MACANDD_PIN_SIZE_MIN) || (pin_size > LT_MACANDD_PIN_SIZE_MAX)
+        || (!add && add_size) || (add_size > LT_MACANDD_ADD_SIZE_MAX) || !secret) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(secret, 0, LT_MACANDD_SECRET_SIZE);
+    memset(&m->timing, 0, sizeof(m->timing));
+
+    // Random secret s
+    uint8_t s[32];
+    // u = KDF(s, "1") initializes slots, v = KDF(0, PIN||A) destroys them
+    uint8_t uv[2 * 32];
+    // Encryption key k_i = KDF(w_i, PIN||A)
+    uint8_t k_i[32];
+    struct lt_hmac_sha256_ctx_t ctx;
+    struct lt_macandd_hdr_t hdr = {.magic = LT_MACANDD_MAGIC, .version = LT_MACANDD_VERSION, .rounds = m->rounds};
+    // Slots and data of three commands per round: initialize by u, get w_i by v, initialize by u again
+    mac_and_destroy_slot_t slots[3 * LT_MACANDD_BATCH_ROUNDS];
+    uint8_t data_out[3 * LT_MACANDD_BATCH_ROUNDS * 32];
+    uint8_t data_in[3 * LT_MACANDD_BATCH_ROUNDS * 32];
+    uint8_t ci_slot[LT_MACANDD_CI_PER_SLOT * 32];
+    lt_ret_t statuses[LT_MACANDD_NVM_SLOTS(MACANDD_ROUNDS_MAX)];
+
+    uint8_t kdf_input[LT_MACANDD_PIN_SIZE_MAX + LT_MACANDD_ADD_SIZE_MAX];
+    uint16_t kdf_input_len = pin_size + add_size;
+    memcpy(kdf_input, pin, pin_size);
+    if (add_size) {
+        memcpy(kdf_input + pin_size, add, add_size);
+    }
+
+    lt_ret_t ret = lt_random_bytes(&m->h->l2, s, sizeof(s));
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    uint32_t start = lt_macandd_now(m);
+    lt_hmac_sha256_init(&ctx, s, sizeof(s));
+    lt_hmac_sha256_compute(&ctx, (const uint8_t *)"0", 1, hdr.t);
+    lt_hmac_sha256_compute(&ctx, (const uint8_t *)"1", 1, uv);
+    memcpy(&ctx, m->kdf_zero, sizeof(ctx));
+    lt_hmac_sha256_compute(&ctx, kdf_input, kdf_input_len, uv + 32);
+    for (int j = 0; j < LT_MACANDD_BATCH_ROUNDS; j++) {
+        memcpy(data_out + (3 * j * 32), uv, 32);
+        memcpy(data_out + ((3 * j + 1) * 32), uv + 32, 32);
+        memcpy(data_out + ((3 * j + 2) * 32), uv, 32);
+    }
+    m->timing.kdf_ms += lt_macandd_now(m) - start;
+
+    start = lt_macandd_now(m);
+    uint16_t nvm_slots = LT_MACANDD_NVM_SLOTS(m->rounds);
+    ret = lt_r_mem_data_erase_range(m->h, m->nvm_slot, nvm_slots, statuses);
+    for (uint16_t j = 0; (ret == LT_OK) && (j < nvm_slots); j++) {
+        ret = statuses[j];
+    }
+    m->timing.nvm_ms += lt_macandd_now(m) - start;
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    for (uint8_t first = 0; first < m->rounds; first += LT_MACANDD_BATCH_ROUNDS) {
+        uint8_t cnt = ((m->rounds - first) < LT_MACANDD_BATCH_ROUNDS) ? (m->rounds - first) : LT_MACANDD_BATCH_ROUNDS;
+        for (uint8_t j = 0; j < cnt; j++) {
+            slots[3 * j] = slots[3 * j + 1] = slots[3 * j + 2] = (mac_and_destroy_slot_t)(first + j);
+        }
+
+        start = lt_macandd_now(m);
+        ret = lt_mac_and_destroy_batch(m->h, slots, data_out, 3 * cnt, data_in);
+        m->timing.macandd_ms += lt_macandd_now(m) - start;
+        if (ret != LT_OK) {
+            goto exit;
+        }
+
+        for (uint8_t j = 0; j < cnt; j++) {
+            uint8_t round = first + j;
+            uint8_t *ci = ci_slot + ((round % LT_MACANDD_CI_PER_SLOT) * 32);
+
+            start = lt_macandd_now(m);
+            lt_hmac_sha256(data_in + ((3 * j + 1) * 32), 32, kdf_input, kdf_input_len, k_i);
+            // Secret has the same size as the key, so it is encrypted by XOR
+            for (int k = 0; k < 32; k++) {
+                ci[k] = k_i[k] ^ s[k];
+            }
+            m->timing.kdf_ms += lt_macandd_now(m) - start;
+
+            if ((round % LT_MACANDD_CI_PER_SLOT == LT_MACANDD_CI_PER_SLOT - 1) || (round == m->rounds - 1)) {
+                start = lt_macandd_now(m);
+                ret = lt_r_mem_data_write(m->h, m->nvm_slot + 1 + (round / LT_MACANDD_CI_PER_SLOT), ci_slot,
+                                          ((round % LT_MACANDD_CI_PER_SLOT) + 1) * 32);
+                m->timing.nvm_ms += lt_macandd_now(m) - start;
+                if (ret != LT_OK) {
+                    goto exit;
+                }
+            }
+        }
+    }
+
+    start = lt_macandd_now(m);
+    hdr.i = m->rounds;
+    ret = lt_r_mem_data_write(m->h, m->nvm_slot, (const uint8_t *)&hdr, sizeof(hdr));
+    m->timing.nvm_ms += lt_macandd_now(m) - start;
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    lt_hmac_sha256_init(&ctx, s, sizeof(s));
+    lt_hmac_sha256_compute(&ctx, (const uint8_t *)"2", 1, secret);
+
+exit:
+    memset(kdf_input, 0, sizeof(kdf_input));
+    memset(s, 0, sizeof(s));
+    memset(uv, 0, sizeof(uv));
+    memset(k_i, 0, sizeof(k_i));
+    memset(&ctx, 0, sizeof(ctx));
+    memset(data_out, 0, sizeof(data_out));
+    memset(data_in, 0, sizeof(data_in));
+    memset(ci_slot, 0, sizeof(ci_slot));
+
+    return ret;
+}
+
+lt_ret_t lt_macandd_pin_check(lt_macandd_t *m, const uint8_t *pin, const uint8_t pin_size, const uint8_t *add,
+                              const uint8_t add_size, uint8_t *secret)
+{
+    if (!m || !m->h || !pin || (pin_size < LT_MACANDD_PIN_SIZE_MIN) || (pin_size > LT_MACANDD_PIN_SIZE_MAX)
+        || (!add && add_size) || (add_size > LT_MACANDD_ADD_SIZE_MAX) || !secret) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(secret, 0, LT_MACANDD_SECRET_SIZE);
+    memset(&m->timing, 0, sizeof(m->timing));
+
+    uint8_t v[32], w[32], k_i[32], s[32], t[32], u[32];
+    uint8_t ci_slot[R_MEM_DATA_SIZE_MAX];
+    struct lt_hmac_sha256_ctx_t ctx;
+    struct lt_macandd_hdr_t hdr;
+
+    uint8_t kdf_input[LT_MACANDD_PIN_SIZE_MAX + LT_MACANDD_ADD_SIZE_MAX];
+    uint16_t kdf_input_len = pin_size + add_size;
+    memcpy(kdf_input, pin, pin_size);
+    if (add_size) {
+        memcpy(kdf_input + pin_size, add, add_size);
+    }
+
+    uint32_t start = lt_macandd_now(m);
+    lt_ret_t ret = lt_macandd_hdr_read(m, &hdr);
+    if ((ret == LT_OK) && !hdr.i) {
+        ret = LT_FAIL;
+    }
+    // Attempt is consumed before the PIN is verified
+    if (ret == LT_OK) {
+        hdr.i--;
+        ret = lt_macandd_hdr_rewrite(m, &hdr);
+    }
+    uint16_t size = 0;
+    if (ret == LT_OK) {
+        ret = lt_r_mem_data_read(m->h, m->nvm_slot + 1 + (hdr.i / LT_MACANDD_CI_PER_SLOT), ci_slot, &size);
+        if ((ret == LT_OK) && (size < ((hdr.i % LT_MACANDD_CI_PER_SLOT) + 1) * 32)) {
+            ret = LT_FAIL;
+        }
+    }
+    m->timing.nvm_ms += lt_macandd_now(m) - start;
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    start = lt_macandd_now(m);
+    memcpy(&ctx, m->kdf_zero, sizeof(ctx));
+    lt_hmac_sha256_compute(&ctx, kdf_input, kdf_input_len, v);
+    m->timing.kdf_ms += lt_macandd_now(m) - start;
+
+    start = lt_macandd_now(m);
+    ret = lt_mac_and_destroy(m->h, (mac_and_destroy_slot_t)hdr.i, v, w);
+    m->timing.macandd_ms += lt_macandd_now(m) - start;
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    start = lt_macandd_now(m);
+    lt_hmac_sha256(w, sizeof(w), kdf_input, kdf_input_len, k_i);
+    const uint8_t *ci = ci_slot + ((hdr.i % LT_MACANDD_CI_PER_SLOT) * 32);
+    for (int k = 0; k < 32; k++) {
+        s[k] = ci[k] ^ k_i[k];
+    }
+    lt_hmac_sha256_init(&ctx, s, sizeof(s));
+    lt_hmac_sha256_compute(&ctx, (const uint8_t *)"0", 1, t);
+    bool correct = lt_macandd_equal(t, hdr.t, sizeof(t));
+    if (correct) {
+        lt_hmac_sha256_compute(&ctx, (const uint8_t *)"1", 1, u);
+    }
+    m->timing.kdf_ms += lt_macandd_now(m) - start;
+    if (!correct) {
+        ret = LT_FAIL;
+        goto exit;
+    }
+
+    // Slots destroyed by this and by the previous wrong attempts are initialized again
+    start = lt_macandd_now(m);
+    ret = lt_macandd_init_slots(m, hdr.i, m->rounds, u);
+    m->timing.macandd_ms += lt_macandd_now(m) - start;
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    start = lt_macandd_now(m);
+    hdr.i = m->rounds;
+    ret = lt_macandd_hdr_rewrite(m, &hdr);
+    m->timing.nvm_ms += lt_macandd_now(m) - start;
+    if (ret != LT_OK) {
+        goto exit;
+    }
+
+    lt_hmac_sha256_compute(&ctx, (const uint8_t *)"2", 1, secret);
+
+exit:
+    memset(kdf_input, 0, sizeof(kdf_input));
+    memset(v, 0, sizeof(v));
+    memset(w, 0, sizeof(w));
+    memset(k_i, 0, sizeof(k_i));
+    memset(s, 0, sizeof(s));
+    memset(u, 0, sizeof(u));
+    memset(&ctx, 0, sizeof(ctx));
+    memset(ci_slot, 0, sizeof(ci_slot));
+
+    return ret;
+}
+
+lt_ret_t lt_macandd_attempts_get(lt_macandd_t *m, uint8_t *attempts)
+{
+    if (!m || !m->h || !attempts) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_macandd_hdr_t hdr;
+    lt_ret_t ret = lt_macandd_hdr_read(m, &hdr);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    *attempts = hdr.i;
+
+    return LT_OK;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file lt_merkle.c
+ * @brief Merkle batch signing definitions
+ * @author Tropic Square s.r.o.
+ *
+ * Levels of the tree are stored one after another in `lt_merkle_tree_t.nodes`, the leaves first and the root last.
+ * A level of `size` nodes is followed by a level of (size + 1) / 2 nodes.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_merkle.h"
+#include "lt_sha256_multi.h"
+
+/** Prefixes of hashed data, which keep leaves, inner nodes and the signed message apart */
+#define LT_MERKLE_PREFIX_LEAF 0x00
+#define LT_MERKLE_PREFIX_INNER 0x01
+#define LT_MERKLE_PREFIX_ROOT 0x02
+
+/** Maximal number of messages of a batch */
+#define LT_MERKLE_CNT_MAX ((uint64_t)1 << LT_MERKLE_DEPTH_MAX)
+
+/** Hashes `cnt` inputs of `prefix` followed by `len` bytes of `in` each, `out` may be `in` when `len` is one node */
+static void lt_merkle_hash(const uint8_t prefix, const uint8_t *in, const uint32_t len, const uint32_t cnt,
+                           uint8_t *out)
+{
+    uint8_t bufs[LT_SHA256_MULTI_LANES][1 + 2 * LT_MERKLE_NODE_SIZE];
+    const uint8_t *msgs[LT_SHA256_MULTI_LANES];
+    uint32_t msg_lens[LT_SHA256_MULTI_LANES];
+
+    for (uint32_t i = 0; i < cnt; i += LT_SHA256_MULTI_LANES) {
+        uint32_t n = ((cnt - i) < LT_SHA256_MULTI_LANES) ? (cnt - i) : LT_SHA256_MULTI_LANES;
+        for (uint32_t j = 0; j < n; j++) {
+            bufs[j][0] = prefix;
+            memcpy(&bufs[j][1], in + ((i + j) * len), len);
+            msgs[j] = bufs[j];
+            msg_lens[j] = 1 + len;
+        }
+        lt_sha256_multi(msgs, msg_lens, n, out + (i * LT_MERKLE_NODE_SIZE));
+    }
+}
+
+static void lt_merkle_root_msg_set(uint8_t *root_msg, const uint32_t cnt, const uint8_t *root)
+{
+    root_msg[0] = LT_MERKLE_PREFIX_ROOT;
+    root_msg[1] = (uint8_t)cnt;
+    root_msg[2] = (uint8_t)(cnt >> 8);
+    root_msg[3] = (uint8_t)(cnt >> 16);
+    root_msg[4] = (uint8_t)(cnt >> 24);
+    memcpy(root_msg + 5, root, LT_MERKLE_NODE_SIZE);
+}
+
+static lt_ret_t lt_merkle_build(lt_merkle_tree_t *tree, const uint8_t *const *msgs, const uint32_t *msg_lens,
+                                const uint32_t cnt)
+{
+    if (!tree || !tree->nodes || !msgs || !msg_lens || !cnt || (cnt > LT_MERKLE_CNT_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    for (uint32_t i = 0; i < cnt; i++) {
+        if (!msgs[i] && msg_lens[i]) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    // Digests of the messages, hashed in parallel lanes, are hashed once more with the prefix of leaves
+    uint8_t *level = tree->nodes;
+    lt_sha256_multi(msgs, msg_lens, cnt, level);
+    lt_merkle_hash(LT_MERKLE_PREFIX_LEAF, level, LT_MERKLE_NODE_SIZE, cnt, level);
+    for (uint32_t size = cnt; size > 1; size = (size + 1) / 2) {
+        uint8_t *next = level + (size * LT_MERKLE_NODE_SIZE);
+        // Pairs of siblings are adjacent, each pair is one input
+        lt_merkle_hash(LT_MERKLE_PREFIX_INNER, level, 2 * LT_MERKLE_NODE_SIZE, size / 2, next);
+        if (size & 1) {
+            memcpy(next + ((size / 2) * LT_MERKLE_NODE_SIZE), level + ((size - 1) * LT_MERKLE_NODE_SIZE),
+                   LT_MERKLE_NODE_SIZE);
+        }
+        level = next;
+    }
+    tree->cnt = cnt;
+    lt_merkle_root_msg_set(tree->root_msg, cnt, level);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_merkle_ecdsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, lt_merkle_tree_t *tree,
+                              const uint8_t *const *msgs, const uint32_t *msg_lens, const uint32_t cnt, uint8_t *rs)
+{
+    if (!h || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_merkle_build(tree, msgs, msg_lens, cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_ecc_ecdsa_sign(h, ecc_slot, tree->root_msg, LT_MERKLE_ROOT_MSG_SIZE, rs);
+}
+
+lt_ret_t lt_merkle_eddsa_sign(lt_handle_t *h, const ecc_slot_t ecc_slot, lt_merkle_tree_t *tree,
+                              const uint8_t *const *msgs, const uint32_t *msg_lens, const uint32_t cnt, uint8_t *rs)
+{
+    if (!h || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = lt_merkle_build(tree, msgs, msg_lens, cnt);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_ecc_eddsa_sign(h, ecc_slot, tree->root_msg, LT_MERKLE_ROOT_MSG_SIZE, rs);
+}
+
+lt_ret_t lt_merkle_proof_get(const lt_merkle_tree_t *tree, const uint32_t index, lt_merkle_proof_t *proof)
+{
+    if (!tree || !tree->nodes || !proof || (index >= tree->cnt)) {
+        return LT_PARAM_ERR;
+    }
+
+    const uint8_t *level = tree->nodes;
+    uint32_t i = index;
+    proof->path_len = 0;
+    for (uint32_t size = tree->cnt; size > 1; size = (size + 1) / 2) {
+        if ((i ^ 1) < size) {
+            memcpy(proof->path[proof->path_len++], level + ((i ^ 1) * LT_MERKLE_NODE_SIZE), LT_MERKLE_NODE_SIZE);
+        }
+        level += size * LT_MERKLE_NODE_SIZE;
+        i >>= 1;
+    }
+    proof->index = index;
+    proof->cnt = tree->cnt;
+
+    return LT_OK;
+}
+
+/** Computes the signed message of the batch from the message and its proof, LT_FAIL when the proof is malformed */
+static lt_ret_t lt_merkle_root_msg(const uint8_t *msg, const uint32_t msg_len, const lt_merkle_proof_t *proof,
+                                   uint8_t *root_msg)
+{
+    if ((proof->index >= proof->cnt) || (proof->cnt > LT_MERKLE_CNT_MAX) || (proof->path_len > LT_MERKLE_DEPTH_MAX)) {
+        return LT_FAIL;
+    }
+
+    uint8_t node[LT_MERKLE_NODE_SIZE];
+    uint8_t pair[2 * LT_MERKLE_NODE_SIZE];
+    lt_sha256_multi(&msg, &msg_len, 1, node);
+    lt_merkle_hash(LT_MERKLE_PREFIX_LEAF, node, LT_MERKLE_NODE_SIZE, 1, node);
+
+    uint8_t used = 0;
+    uint32_t i = proof->index;
+    for (uint32_t size = proof->cnt; size > 1; size = (size + 1) / 2) {
+        if ((i ^ 1) < size) {
+            if (used == proof->path_len) {
+                return LT_FAIL;
+            }
+            // The node on the way is the right one of its pair for odd index
+            memcpy(pair + ((i & 1) ? LT_MERKLE_NODE_SIZE : 0), node, LT_MERKLE_NODE_SIZE);
+            memcpy(pair + ((i & 1) ? 0 : LT_MERKLE_NODE_SIZE), proof->path[used++], LT_MERKLE_NODE_SIZE);
+            lt_merkle_hash(LT_MERKLE_PREFIX_INNER, pair, sizeof(pair), 1, node);
+        }
+        i >>= 1;
+    }
+    if (used != proof->path_len) {
+        return LT_FAIL;
+    }
+    lt_merkle_root_msg_set(root_msg, proof->cnt, node);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_merkle_ecdsa_verify(const uint8_t *msg, const uint32_t msg_len, const lt_merkle_proof_t *proof,
+                                const uint8_t *pubkey, const uint8_t *rs)
+{
+    if ((!msg && msg_len) || !proof || !pubkey || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t root_msg[LT_MERKLE_ROOT_MSG_SIZE];
+    lt_ret_t ret = lt_merkle_root_msg(msg, msg_len, proof, root_msg);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_ecc_ecdsa_sig_verify(root_msg, sizeof(root_msg), pubkey, rs);
+}
+
+lt_ret_t lt_merkle_eddsa_verify(const uint8_t *msg, const uint32_t msg_len, const lt_merkle_proof_t *proof,
+                                const uint8_t *pubkey, const uint8_t *rs)
+{
+    if ((!msg && msg_len) || !proof || !pubkey || !rs) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t root_msg[LT_MERKLE_ROOT_MSG_SIZE];
+    lt_ret_t ret = lt_merkle_root_msg(msg, msg_len, proof, root_msg);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_ecc_eddsa_sig_verify(root_msg, sizeof(root_msg), pubkey, rs);
+}
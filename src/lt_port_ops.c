@@ -0,0 +1,161 @@
+/**
+ * @file lt_port_ops.c
+ * @brief Port functions calling the port of the handle, see `lt_port_ops_t`
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "libtropic_port.h"
+#include "libtropic_port_ops.h"
+
+lt_ret_t lt_port_init(lt_l2_state_t *s2)
+{
+    // Table is checked only here, other functions are not called when the initialization fails
+    const lt_port_ops_t *ops = s2->ops;
+    if (!ops || !ops->init || !ops->deinit || !ops->spi_csn_low || !ops->spi_csn_high || !ops->spi_transfer
+        || !ops->delay || !ops->random_bytes) {
+        return LT_PARAM_ERR;
+    }
+
+    return ops->init(s2);
+}
+
+lt_ret_t lt_port_deinit(lt_l2_state_t *s2) { return s2->ops->deinit(s2); }
+
+lt_ret_t lt_port_spi_csn_low(lt_l2_state_t *s2) { return s2->ops->spi_csn_low(s2); }
+
+lt_ret_t lt_port_spi_csn_high(lt_l2_state_t *s2) { return s2->ops->spi_csn_high(s2); }
+
+lt_ret_t lt_port_spi_transfer(lt_l2_state_t *s2, uint8_t offset, uint16_t tx_len, uint32_t timeout_ms)
+{
+    return s2->ops->spi_transfer(s2, offset, tx_len, timeout_ms);
+}
+
+#if LT_USE_SPI_TRANSACTION
+lt_ret_t lt_port_spi_transaction(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt,
+                                 uint32_t timeout_ms)
+{
+    // Missing transaction is emulated by lt_l1_spi_transaction(), it does not get here
+    return s2->ops->spi_transaction(s2, segs, seg_cnt, timeout_ms);
+}
+#endif
+
+#if LT_USE_SPI_TRANSFER_BUF
+lt_ret_t lt_port_spi_transfer_buf(lt_l2_state_t *s2, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                                  uint32_t timeout_ms)
+{
+    // Missing transfer is emulated by lt_l1_spi_transfer_buf(), it does not get here
+    return s2->ops->spi_transfer_buf(s2, tx, rx, len, timeout_ms);
+}
+#endif
+
+lt_ret_t lt_port_delay(lt_l2_state_t *s2, uint32_t ms) { return s2->ops->delay(s2, ms); }
+
+#if LT_USE_DELAY_US
+lt_ret_t lt_port_delay_us(lt_l2_state_t *s2, uint32_t us)
+{
+    if (!s2->ops->delay_us) {
+        return s2->ops->delay(s2, LT_US_TO_MS_CEIL(us));
+    }
+
+    return s2->ops->delay_us(s2, us);
+}
+#endif
+
+#if LT_USE_INT_PIN
+lt_ret_t lt_port_delay_on_int(lt_l2_state_t *s2, uint32_t ms)
+{
+    if (!s2->ops->delay_on_int) {
+        return s2->ops->delay(s2, ms);
+    }
+
+    return s2->ops->delay_on_int(s2, ms);
+}
+#endif
+
+#if LT_USE_PORT_CRC16
+lt_ret_t lt_port_crc16(lt_l2_state_t *s2, const uint8_t *data, uint16_t len, uint16_t *crc)
+{
+    // LT_FAIL makes the caller calculate the checksum in software
+    if (!s2->ops->crc16) {
+        return LT_FAIL;
+    }
+
+    return s2->ops->crc16(s2, data, len, crc);
+}
+#endif
+
+#if LT_USE_SPI_SPEED
+lt_ret_t lt_port_spi_speed_set(lt_l2_state_t *s2, uint32_t hz, uint32_t *actual_hz)
+{
+    if (!s2->ops->spi_speed_set) {
+        return LT_FAIL;
+    }
+
+    return s2->ops->spi_speed_set(s2, hz, actual_hz);
+}
+#endif
+
+#if LT_USE_PORT_CACHE
+void lt_port_cache_clean(lt_l2_state_t *s2, const void *addr, size_t len)
+{
+    if (s2->ops->cache_clean) {
+        s2->ops->cache_clean(s2, addr, len);
+    }
+}
+
+void lt_port_cache_invalidate(lt_l2_state_t *s2, void *addr, size_t len)
+{
+    if (s2->ops->cache_invalidate) {
+        s2->ops->cache_invalidate(s2, addr, len);
+    }
+}
+#endif
+
+#if LT_THREAD_SAFE
+void lt_port_lock(lt_l2_state_t *s2)
+{
+    if (s2->ops && s2->ops->lock) {
+        s2->ops->lock(s2);
+    }
+}
+
+void lt_port_unlock(lt_l2_state_t *s2)
+{
+    if (s2->ops && s2->ops->unlock) {
+        s2->ops->unlock(s2);
+    }
+}
+#endif
+
+lt_ret_t lt_port_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
+{
+    return s2->ops->random_bytes(s2, buff, count);
+}
+
+#if LT_L1_OFFLOAD
+lt_ret_t lt_port_l1_write(lt_l2_state_t *s2, const lt_l1_spi_segment_t *segs, uint8_t seg_cnt, uint32_t timeout_ms)
+{
+    // Only a port setting l1_offload gets here
+    if (!s2->ops->l1_write) {
+        return LT_FAIL;
+    }
+
+    return s2->ops->l1_write(s2, segs, seg_cnt, timeout_ms);
+}
+
+lt_ret_t lt_port_l1_read(lt_l2_state_t *s2, uint32_t max_len, uint32_t timeout_ms)
+{
+    if (!s2->ops->l1_read) {
+        return LT_FAIL;
+    }
+
+    return s2->ops->l1_read(s2, max_len, timeout_ms);
+}
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file lt_profile.c
+ * @brief Profile functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_profile.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+/** Profile receiving measured calls, NULL when not profiling */
+static lt_profile_t *lt_profile_active;
+
+/** Names of measured functions printed by `lt_profile_dump()`, indexed by `lt_profile_fn_t` */
+static const char *const lt_profile_names[LT_PROFILE_FNS] = {
+    [LT_PROFILE_L1_READ] = "lt_l1_read",
+    [LT_PROFILE_L1_WRITE] = "lt_l1_write",
+    [LT_PROFILE_CRC16] = "crc16",
+    [LT_PROFILE_L3_ENCRYPT] = "lt_l3_encrypt_request",
+    [LT_PROFILE_L3_DECRYPT] = "lt_l3_decrypt_response",
+    [LT_PROFILE_SESSION_START] = "lt_in__session_start",
+    [LT_PROFILE_HKDF] = "lt_hkdf",
+    [LT_PROFILE_ASN1DER_FIND] = "asn1der_find_object",
+};
+
+lt_profile_call_t lt_profile_begin(const lt_profile_fn_t fn)
+{
+    lt_profile_call_t call = {.p = __atomic_load_n(&lt_profile_active, __ATOMIC_ACQUIRE), .fn = fn};
+
+    if (call.p) {
+        call.start = call.p->cycles();
+    }
+
+    return call;
+}
+
+void lt_profile_end(const lt_profile_call_t *call)
+{
+    if (!call->p) {
+        return;
+    }
+
+    // Unsigned difference is correct also when the counter wrapped around during the call
+    uint32_t cycles = call->p->cycles() - call->start;
+    lt_profile_entry_t *e = &call->p->entries[call->fn];
+
+    e->calls++;
+    e->cycles += cycles;
+    if (cycles > e->max) {
+        e->max = cycles;
+    }
+}
+
+lt_ret_t lt_profile_init(lt_profile_t *p, uint32_t (*cycles)(void))
+{
+    if (p && !cycles) {
+        return LT_PARAM_ERR;
+    }
+
+    if (p) {
+        memset(p->entries, 0, sizeof(p->entries));
+        p->cycles = cycles;
+    }
+    __atomic_store_n(&lt_profile_active, p, __ATOMIC_RELEASE);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_profile_dump(const lt_profile_t *p, int (*print_func)(const char *format, ...))
+{
+    if (!p || !print_func) {
+        return LT_PARAM_ERR;
+    }
+
+    if (0 > print_func("%-24s %10s %14s %10s %10s\r\n", "function", "calls", "cycles", "avg", "max")) {
+        return LT_FAIL;
+    }
+
+    for (int i = 0; i < LT_PROFILE_FNS; i++) {
+        const lt_profile_entry_t *e = &p->entries[i];
+        uint32_t avg = e->calls ? (uint32_t)(e->cycles / e->calls) : 0;
+        // printf of small C libraries (e.g. newlib-nano) cannot print 64-bit numbers, large sums are printed in kcycles
+        int ret = (e->cycles <= UINT32_MAX)
+                      ? print_func("%-24s %10" PRIu32 " %14" PRIu32 " %10" PRIu32 " %10" PRIu32 "\r\n",
+                                   lt_profile_names[i], e->calls, (uint32_t)e->cycles, avg, e->max)
+                      : print_func("%-24s %10" PRIu32 " %13" PRIu32 "k %10" PRIu32 " %10" PRIu32 "\r\n",
+                                   lt_profile_names[i], e->calls, (uint32_t)(e->cycles / 1000), avg, e->max);
+        if (0 > ret) {
+            return LT_FAIL;
+        }
+    }
+
+    return LT_OK;
+}
@@ -0,0 +1,62 @@
+#ifndef LT_PROFILE_H
+#define LT_PROFILE_H
+
+/**
+ * @defgroup group_profile_functions Profile functions
+ * @brief Used internally
+ * @details Functions accumulating cycles of measured functions into the profile given to `lt_profile_init()`,
+ * they do nothing when profiling is not active.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_profile.h
+ * @brief Profile functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_PROFILE
+/** @brief Call being measured, ended when its variable goes out of scope */
+typedef struct lt_profile_call_t {
+    /** Active profile, NULL when not profiling */
+    lt_profile_t *p;
+    /** Measured function */
+    lt_profile_fn_t fn;
+    /** Cycle counter at the start of the call */
+    uint32_t start;
+} lt_profile_call_t;
+
+/**
+ * @brief Starts measuring a call, use `LT_PROFILE_SCOPE()`
+ *
+ * @param fn          Measured function
+ * @return            Started call
+ */
+lt_profile_call_t lt_profile_begin(const lt_profile_fn_t fn);
+
+/**
+ * @brief Adds cycles of the call to its function, use `LT_PROFILE_SCOPE()`
+ *
+ * @param call        Call started by `lt_profile_begin()`
+ */
+void lt_profile_end(const lt_profile_call_t *call);
+
+/**
+ * @brief Measures the rest of the enclosing block, including all its returns, as a call of `fn`
+ */
+#define LT_PROFILE_SCOPE(fn) \
+    const lt_profile_call_t lt_profile_call __attribute__((cleanup(lt_profile_end), unused)) = lt_profile_begin(fn)
+#else
+#define LT_PROFILE_SCOPE(fn)
+#endif
+
+/** @} */  // end of group_profile_functions
+
+#endif
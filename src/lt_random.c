@@ -12,6 +12,7 @@
 
 #include "libtropic_common.h"
 #include "libtropic_port.h"
+#include "lt_record.h"
 
 lt_ret_t lt_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
 {
@@ -20,5 +21,16 @@ lt_ret_t lt_random_bytes(lt_l2_state_t *s2, void *buff, size_t count)
         return LT_PARAM_ERR;
     }
 #endif
+#if LT_RECORD
+    lt_ret_t ret = lt_port_random_bytes(s2, buff, count);
+    // Length of a record has 16 bits, so larger requests take several records
+    for (size_t done = 0; done < count; done += 0xffff) {
+        size_t len = ((count - done) < 0xffff) ? (count - done) : 0xffff;
+        lt_record_op(s2, LT_RECORD_OP_RANDOM, ret, (const uint8_t *)buff + done, (uint16_t)len);
+    }
+
+    return ret;
+#else
     return lt_port_random_bytes(s2, buff, count);
+#endif
 }
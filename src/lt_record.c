@@ -0,0 +1,57 @@
+/**
+ * @file lt_record.c
+ * @brief Recording functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+void lt_record_op(lt_l2_state_t *s2, const lt_record_op_t op, const lt_ret_t ret, const uint8_t *data,
+                  const uint16_t len)
+{
+    lt_record_t *r = s2->record;
+
+    if (!r || !r->enabled) {
+        return;
+    }
+
+    uint8_t head[4] = {(uint8_t)op, (uint8_t)ret, (uint8_t)(len & 0xff), (uint8_t)(len >> 8)};
+    // Length is written only for operations with data
+    uint16_t head_len = data ? sizeof(head) : 2;
+
+    r->write(r->ctx, head, head_len);
+    r->size += head_len;
+    if (data && len) {
+        r->write(r->ctx, data, len);
+        r->size += len;
+    }
+}
+
+lt_ret_t lt_record_start(lt_record_t *r, void (*write)(void *ctx, const uint8_t *data, const uint16_t len),
+                         void *ctx)
+{
+    if (!r || !write) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t header[LT_RECORD_HEADER_SIZE] = {0};
+    memcpy(header, LT_RECORD_MAGIC, 4);
+    header[4] = LT_RECORD_VERSION;
+
+    r->write = write;
+    r->ctx = ctx;
+    r->write(ctx, header, sizeof(header));
+    r->size = sizeof(header);
+    r->enabled = 1;
+
+    return LT_OK;
+}
@@ -0,0 +1,40 @@
+#ifndef LT_RECORD_H
+#define LT_RECORD_H
+
+/**
+ * @defgroup group_record_functions Recording functions
+ * @brief Used internally
+ * @details Functions writing port calls into `lt_l2_state_t.record`, they do nothing when it is NULL or disabled.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_record.h
+ * @brief Recording functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_RECORD
+/**
+ * @brief Records one port call
+ *
+ * @param s2          Structure holding l2 state
+ * @param op          Port operation
+ * @param ret         Value returned by the port
+ * @param data        MISO or random bytes, NULL for operations without data
+ * @param len         Number of bytes at `data`
+ */
+void lt_record_op(lt_l2_state_t *s2, const lt_record_op_t op, const lt_ret_t ret, const uint8_t *data,
+                  const uint16_t len);
+#endif
+
+/** @} */  // end of group_record_functions
+
+#endif
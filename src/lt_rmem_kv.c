@@ -0,0 +1,577 @@
+/**
+ * @file lt_rmem_kv.c
+ * @brief R-memory key-value store definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_macros.h"
+#include "libtropic_rmem_kv.h"
+
+/** Magic of the index slot, "LTKI" */
+#define LT_RMEM_KV_INDEX_MAGIC 0x494b544cu
+/** Magic of the first slot of an object, "LTKO" */
+#define LT_RMEM_KV_OBJ_MAGIC 0x4f4b544cu
+/** Version of the layout */
+#define LT_RMEM_KV_VERSION 1
+
+/** Header of the index slot */
+struct lt_rmem_kv_index_hdr_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t entries_cnt;
+    /** Range of the store, the index is valid only for the same range */
+    uint16_t first_slot;
+    uint16_t slots_cnt;
+    uint32_t next_seq;
+} __attribute__((packed));
+
+/** Entry of the index slot */
+struct lt_rmem_kv_index_entry_t {
+    uint32_t name_hash;
+    uint16_t first_slot;
+    uint16_t data_len;
+    uint8_t obj_slots;
+} __attribute__((packed));
+
+// Whole index fits into one slot
+STATIC_ASSERT(sizeof(struct lt_rmem_kv_index_hdr_t)
+                  + (LT_RMEM_KV_ENTRIES_MAX * sizeof(struct lt_rmem_kv_index_entry_t))
+              <= R_MEM_DATA_SIZE_MAX)
+
+/** Header of the first slot of an object, followed by the name and object's data */
+struct lt_rmem_kv_obj_hdr_t {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t data_len;
+    uint8_t name_len;
+} __attribute__((packed));
+
+/** Returns FNV-1a hash of the name */
+static uint32_t lt_rmem_kv_hash(const char *name, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/** Returns number of slots occupied by object */
+static uint16_t lt_rmem_kv_obj_slots(size_t name_len, uint16_t data_len)
+{
+    size_t total = sizeof(struct lt_rmem_kv_obj_hdr_t) + name_len + data_len;
+
+    return (uint16_t)((total + R_MEM_DATA_SIZE_MAX - 1) / R_MEM_DATA_SIZE_MAX);
+}
+
+static bool lt_rmem_kv_used(const lt_rmem_kv_t *kv, uint16_t rel)
+{
+    return (kv->used[rel / 32] >> (rel % 32)) & 1u;
+}
+
+static void lt_rmem_kv_mark(lt_rmem_kv_t *kv, uint16_t first_slot, uint16_t obj_slots, bool used)
+{
+    for (uint16_t rel = first_slot - kv->first_slot; obj_slots; rel++, obj_slots--) {
+        if (used) {
+            kv->used[rel / 32] |= (1u << (rel % 32));
+        }
+        else {
+            kv->used[rel / 32] &= ~(1u << (rel % 32));
+        }
+    }
+}
+
+/** Writes slot, which might still hold stale data when the store was not synced */
+static lt_ret_t lt_rmem_kv_slot_write(lt_handle_t *h, uint16_t slot, const uint8_t *data, uint16_t size)
+{
+    lt_ret_t ret = lt_r_mem_data_write(h, slot, data, size);
+    if (ret != LT_L3_R_MEM_DATA_WRITE_WRITE_FAIL) {
+        return ret;
+    }
+
+    ret = lt_r_mem_data_erase(h, slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_r_mem_data_write(h, slot, data, size);
+}
+
+static lt_ret_t lt_rmem_kv_slots_erase(lt_handle_t *h, uint16_t first_slot, uint16_t obj_slots)
+{
+    for (uint16_t i = 0; i < obj_slots; i++) {
+        lt_ret_t ret = lt_r_mem_data_erase(h, first_slot + i);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Erases the index slot before the first change of the store after it was synced */
+static lt_ret_t lt_rmem_kv_index_invalidate(lt_rmem_kv_t *kv)
+{
+    if (!kv->index_synced) {
+        return LT_OK;
+    }
+
+    lt_ret_t ret = lt_r_mem_data_erase(kv->h, kv->first_slot);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    kv->index_synced = 0;
+
+    return LT_OK;
+}
+
+/** Returns index of the entry with given name hash, or -1 */
+static int lt_rmem_kv_find(const lt_rmem_kv_t *kv, uint32_t name_hash)
+{
+    for (int i = 0; i < kv->entries_cnt; i++) {
+        if (kv->entries[i].name_hash == name_hash) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/** Returns first slot of a free run of consecutive slots, or 0 when there is none */
+static uint16_t lt_rmem_kv_alloc(const lt_rmem_kv_t *kv, uint16_t obj_slots)
+{
+    uint16_t run = 0;
+    // Relative slot 0 is the index
+    for (uint16_t rel = 1; rel < kv->slots_cnt; rel++) {
+        run = lt_rmem_kv_used(kv, rel) ? 0 : run + 1;
+        if (run == obj_slots) {
+            return kv->first_slot + rel + 1 - obj_slots;
+        }
+    }
+
+    return 0;
+}
+
+/** Reads header and name of the object from its first slot into buff, returns LT_FAIL when it is not valid */
+static lt_ret_t lt_rmem_kv_obj_read_hdr(lt_handle_t *h, uint16_t slot, uint8_t *buff, uint16_t *size)
+{
+    lt_ret_t ret = lt_r_mem_data_read(h, slot, buff, size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    const struct lt_rmem_kv_obj_hdr_t *hdr = (const struct lt_rmem_kv_obj_hdr_t *)buff;
+    if ((*size < sizeof(*hdr)) || (hdr->magic != LT_RMEM_KV_OBJ_MAGIC) || (hdr->name_len > LT_RMEM_KV_NAME_LEN_MAX)
+        || (*size < sizeof(*hdr) + hdr->name_len)) {
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+/** Checks that name of the object in its first slot matches */
+static lt_ret_t lt_rmem_kv_obj_check_name(lt_rmem_kv_t *kv, int idx, const char *name, size_t name_len)
+{
+    uint8_t buff[R_MEM_DATA_SIZE_MAX];
+    uint16_t size;
+
+    lt_ret_t ret = lt_rmem_kv_obj_read_hdr(kv->h, kv->entries[idx].first_slot, buff, &size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    const struct lt_rmem_kv_obj_hdr_t *hdr = (const struct lt_rmem_kv_obj_hdr_t *)buff;
+    if ((hdr->name_len != name_len) || memcmp(buff + sizeof(*hdr), name, name_len)) {
+        // Different name with the same hash
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_kv_format(lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt)
+{
+    if (!h || (slots_cnt < 2) || (first_slot > R_MEM_DATA_SLOT_MAX) || (slots_cnt > R_MEM_DATA_SLOT_MAX + 1 - first_slot)) {
+        return LT_PARAM_ERR;
+    }
+
+    return lt_rmem_kv_slots_erase(h, first_slot, slots_cnt);
+}
+
+/** Loads index from the index slot, returns LT_FAIL when the slot does not hold a valid index of the range */
+static lt_ret_t lt_rmem_kv_index_load(lt_rmem_kv_t *kv)
+{
+    uint8_t buff[R_MEM_DATA_SIZE_MAX];
+    uint16_t size;
+
+    lt_ret_t ret = lt_r_mem_data_read(kv->h, kv->first_slot, buff, &size);
+    if (ret == LT_L3_R_MEM_DATA_READ_SLOT_EMPTY) {
+        return LT_FAIL;
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    const struct lt_rmem_kv_index_hdr_t *hdr = (const struct lt_rmem_kv_index_hdr_t *)buff;
+    if ((size < sizeof(*hdr)) || (hdr->magic != LT_RMEM_KV_INDEX_MAGIC) || (hdr->version != LT_RMEM_KV_VERSION)
+        || (hdr->first_slot != kv->first_slot) || (hdr->slots_cnt != kv->slots_cnt)
+        || (hdr->entries_cnt > LT_RMEM_KV_ENTRIES_MAX)
+        || (size != sizeof(*hdr) + (hdr->entries_cnt * sizeof(struct lt_rmem_kv_index_entry_t)))) {
+        return LT_FAIL;
+    }
+
+    const struct lt_rmem_kv_index_entry_t *e = (const struct lt_rmem_kv_index_entry_t *)(buff + sizeof(*hdr));
+    for (uint8_t i = 0; i < hdr->entries_cnt; i++) {
+        if ((e[i].first_slot <= kv->first_slot) || !e[i].obj_slots
+            || (e[i].first_slot + e[i].obj_slots > kv->first_slot + kv->slots_cnt)) {
+            return LT_FAIL;
+        }
+        kv->entries[i].name_hash = e[i].name_hash;
+        kv->entries[i].first_slot = e[i].first_slot;
+        kv->entries[i].data_len = e[i].data_len;
+        kv->entries[i].obj_slots = e[i].obj_slots;
+        lt_rmem_kv_mark(kv, e[i].first_slot, e[i].obj_slots, true);
+    }
+    kv->entries_cnt = hdr->entries_cnt;
+    kv->next_seq = hdr->next_seq;
+    kv->index_synced = 1;
+
+    return LT_OK;
+}
+
+/** Rebuilds index by reading first slots of all objects of the range */
+static lt_ret_t lt_rmem_kv_index_scan(lt_rmem_kv_t *kv)
+{
+    uint8_t buff[R_MEM_DATA_SIZE_MAX];
+    uint32_t seqs[LT_RMEM_KV_ENTRIES_MAX];
+    uint16_t size;
+    uint16_t end = kv->first_slot + kv->slots_cnt;
+
+    for (uint16_t slot = kv->first_slot + 1; slot < end; slot++) {
+        lt_ret_t ret = lt_rmem_kv_obj_read_hdr(kv->h, slot, buff, &size);
+        if ((ret == LT_L3_R_MEM_DATA_READ_SLOT_EMPTY) || (ret == LT_FAIL)) {
+            // Empty slot, or stale data left by an interrupted update
+            continue;
+        }
+        if (ret != LT_OK) {
+            return ret;
+        }
+
+        const struct lt_rmem_kv_obj_hdr_t *hdr = (const struct lt_rmem_kv_obj_hdr_t *)buff;
+        uint16_t obj_slots = lt_rmem_kv_obj_slots(hdr->name_len, hdr->data_len);
+        if (slot + obj_slots > end) {
+            continue;
+        }
+        uint32_t name_hash = lt_rmem_kv_hash((const char *)buff + sizeof(*hdr), hdr->name_len);
+        if (hdr->seq >= kv->next_seq) {
+            kv->next_seq = hdr->seq + 1;
+        }
+
+        int idx = lt_rmem_kv_find(kv, name_hash);
+        if (idx >= 0) {
+            // Update was interrupted before the old content was erased, keep the newer one
+            bool newer = hdr->seq > seqs[idx];
+            uint16_t old_slot = newer ? kv->entries[idx].first_slot : slot;
+            uint16_t old_slots = newer ? kv->entries[idx].obj_slots : obj_slots;
+            ret = lt_rmem_kv_slots_erase(kv->h, old_slot, old_slots);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            if (!newer) {
+                slot += obj_slots - 1;
+                continue;
+            }
+            lt_rmem_kv_mark(kv, old_slot, old_slots, false);
+        }
+        else {
+            if (kv->entries_cnt == LT_RMEM_KV_ENTRIES_MAX) {
+                return LT_FAIL;
+            }
+            idx = kv->entries_cnt++;
+        }
+
+        kv->entries[idx].name_hash = name_hash;
+        kv->entries[idx].first_slot = slot;
+        kv->entries[idx].data_len = hdr->data_len;
+        kv->entries[idx].obj_slots = (uint8_t)obj_slots;
+        seqs[idx] = hdr->seq;
+        lt_rmem_kv_mark(kv, slot, obj_slots, true);
+        slot += obj_slots - 1;
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_kv_mount(lt_rmem_kv_t *kv, lt_handle_t *h, const uint16_t first_slot, const uint16_t slots_cnt)
+{
+    if (!kv || !h || (slots_cnt < 2) || (first_slot > R_MEM_DATA_SLOT_MAX)
+        || (slots_cnt > R_MEM_DATA_SLOT_MAX + 1 - first_slot)) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(kv, 0, sizeof(*kv));
+    kv->h = h;
+    kv->first_slot = first_slot;
+    kv->slots_cnt = slots_cnt;
+    lt_rmem_kv_mark(kv, first_slot, 1, true);
+
+    lt_ret_t ret = lt_rmem_kv_index_load(kv);
+    if (ret != LT_FAIL) {
+        return ret;
+    }
+
+    // Partially loaded index is dropped
+    memset(kv->used, 0, sizeof(kv->used));
+    lt_rmem_kv_mark(kv, first_slot, 1, true);
+    kv->entries_cnt = 0;
+    kv->next_seq = 0;
+
+    return lt_rmem_kv_index_scan(kv);
+}
+
+lt_ret_t lt_rmem_kv_get(lt_rmem_kv_t *kv, const char *name, uint8_t *buff, const uint16_t max_len, uint16_t *len)
+{
+    if (!kv || !kv->h || !name || !buff || !len) {
+        return LT_PARAM_ERR;
+    }
+    size_t name_len = strlen(name);
+    if (name_len > LT_RMEM_KV_NAME_LEN_MAX) {
+        return LT_PARAM_ERR;
+    }
+
+    int idx = lt_rmem_kv_find(kv, lt_rmem_kv_hash(name, name_len));
+    if (idx < 0) {
+        return LT_NOT_FOUND;
+    }
+    if (kv->entries[idx].data_len > max_len) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t slot_data[R_MEM_DATA_SIZE_MAX];
+    uint16_t size;
+    lt_ret_t ret = lt_rmem_kv_obj_read_hdr(kv->h, kv->entries[idx].first_slot, slot_data, &size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    const struct lt_rmem_kv_obj_hdr_t *hdr = (const struct lt_rmem_kv_obj_hdr_t *)slot_data;
+    if ((hdr->name_len != name_len) || memcmp(slot_data + sizeof(*hdr), name, name_len)
+        || (hdr->data_len != kv->entries[idx].data_len)) {
+        return LT_NOT_FOUND;
+    }
+
+    uint16_t data_len = hdr->data_len;
+    uint16_t off = sizeof(*hdr) + name_len;
+    uint16_t done = 0;
+    for (uint16_t i = 0;; i++) {
+        uint16_t n = size - off;
+        if (n > data_len - done) {
+            return LT_FAIL;
+        }
+        memcpy(buff + done, slot_data + off, n);
+        done += n;
+        if (done == data_len) {
+            break;
+        }
+        if (i + 1 >= kv->entries[idx].obj_slots) {
+            return LT_FAIL;
+        }
+        ret = lt_r_mem_data_read(kv->h, kv->entries[idx].first_slot + i + 1, slot_data, &size);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        off = 0;
+    }
+    memset(slot_data, 0, sizeof(slot_data));
+    *len = data_len;
+
+    return LT_OK;
+}
+
+/**
+ * Writes object into consecutive slots starting at first_slot. The first slot with the header is written last, so an
+ * interrupted write leaves no valid header and lt_rmem_kv_index_scan() never prefers an incomplete copy.
+ */
+static lt_ret_t lt_rmem_kv_obj_write(lt_rmem_kv_t *kv, uint16_t first_slot, const char *name, size_t name_len,
+                                     const uint8_t *data, uint16_t len)
+{
+    uint16_t off = sizeof(struct lt_rmem_kv_obj_hdr_t) + name_len;
+    uint16_t head = (len < R_MEM_DATA_SIZE_MAX - off) ? len : R_MEM_DATA_SIZE_MAX - off;
+    lt_ret_t ret = LT_OK;
+
+    uint16_t slot = first_slot + 1;
+    for (uint16_t done = head; (done < len) && (ret == LT_OK); slot++) {
+        uint16_t n = (len - done < R_MEM_DATA_SIZE_MAX) ? len - done : R_MEM_DATA_SIZE_MAX;
+        ret = lt_rmem_kv_slot_write(kv->h, slot, data + done, n);
+        done += n;
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    uint8_t slot_data[R_MEM_DATA_SIZE_MAX];
+    struct lt_rmem_kv_obj_hdr_t *hdr = (struct lt_rmem_kv_obj_hdr_t *)slot_data;
+    hdr->magic = LT_RMEM_KV_OBJ_MAGIC;
+    hdr->seq = kv->next_seq++;
+    hdr->data_len = len;
+    hdr->name_len = (uint8_t)name_len;
+    memcpy(slot_data + sizeof(*hdr), name, name_len);
+    memcpy(slot_data + off, data, head);
+
+    ret = lt_rmem_kv_slot_write(kv->h, first_slot, slot_data, off + head);
+    memset(slot_data, 0, sizeof(slot_data));
+
+    return ret;
+}
+
+lt_ret_t lt_rmem_kv_put(lt_rmem_kv_t *kv, const char *name, const uint8_t *data, const uint16_t len)
+{
+    if (!kv || !kv->h || !name || (!data && len)) {
+        return LT_PARAM_ERR;
+    }
+    size_t name_len = strlen(name);
+    uint16_t obj_slots = lt_rmem_kv_obj_slots(name_len, len);
+    if (!name_len || (name_len > LT_RMEM_KV_NAME_LEN_MAX) || (obj_slots >= kv->slots_cnt) || (obj_slots > UINT8_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    uint32_t name_hash = lt_rmem_kv_hash(name, name_len);
+    int idx = lt_rmem_kv_find(kv, name_hash);
+    lt_ret_t ret;
+    if (idx >= 0) {
+        ret = lt_rmem_kv_obj_check_name(kv, idx, name, name_len);
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+    else if (kv->entries_cnt == LT_RMEM_KV_ENTRIES_MAX) {
+        return LT_FAIL;
+    }
+
+    ret = lt_rmem_kv_index_invalidate(kv);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    uint16_t slot = lt_rmem_kv_alloc(kv, obj_slots);
+    if (!slot && (idx >= 0)) {
+        // No space for both contents, the old one is erased first
+        ret = lt_rmem_kv_slots_erase(kv->h, kv->entries[idx].first_slot, kv->entries[idx].obj_slots);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        lt_rmem_kv_mark(kv, kv->entries[idx].first_slot, kv->entries[idx].obj_slots, false);
+        kv->entries[idx].obj_slots = 0;
+        slot = lt_rmem_kv_alloc(kv, obj_slots);
+    }
+    if (!slot) {
+        if ((idx >= 0) && !kv->entries[idx].obj_slots) {
+            kv->entries[idx] = kv->entries[--kv->entries_cnt];
+        }
+        return LT_FAIL;
+    }
+
+    ret = lt_rmem_kv_obj_write(kv, slot, name, name_len, data, len);
+    if (ret != LT_OK) {
+        // Without the first slot, partially written slots are not an object for the next mount. They are reused,
+        // erased again by the next write into them.
+        return ret;
+    }
+    lt_rmem_kv_mark(kv, slot, obj_slots, true);
+
+    if (idx >= 0) {
+        if (kv->entries[idx].obj_slots) {
+            ret = lt_rmem_kv_slots_erase(kv->h, kv->entries[idx].first_slot, kv->entries[idx].obj_slots);
+            lt_rmem_kv_mark(kv, kv->entries[idx].first_slot, kv->entries[idx].obj_slots, false);
+        }
+    }
+    else {
+        idx = kv->entries_cnt++;
+    }
+    kv->entries[idx].name_hash = name_hash;
+    kv->entries[idx].first_slot = slot;
+    kv->entries[idx].data_len = len;
+    kv->entries[idx].obj_slots = (uint8_t)obj_slots;
+
+    return ret;
+}
+
+lt_ret_t lt_rmem_kv_delete(lt_rmem_kv_t *kv, const char *name)
+{
+    if (!kv || !kv->h || !name) {
+        return LT_PARAM_ERR;
+    }
+    size_t name_len = strlen(name);
+    if (name_len > LT_RMEM_KV_NAME_LEN_MAX) {
+        return LT_PARAM_ERR;
+    }
+
+    int idx = lt_rmem_kv_find(kv, lt_rmem_kv_hash(name, name_len));
+    if (idx < 0) {
+        return LT_NOT_FOUND;
+    }
+    lt_ret_t ret = lt_rmem_kv_obj_check_name(kv, idx, name, name_len);
+    if (ret == LT_FAIL) {
+        return LT_NOT_FOUND;
+    }
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_rmem_kv_index_invalidate(kv);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = lt_rmem_kv_slots_erase(kv->h, kv->entries[idx].first_slot, kv->entries[idx].obj_slots);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    lt_rmem_kv_mark(kv, kv->entries[idx].first_slot, kv->entries[idx].obj_slots, false);
+    kv->entries[idx] = kv->entries[--kv->entries_cnt];
+
+    return LT_OK;
+}
+
+lt_ret_t lt_rmem_kv_sync(lt_rmem_kv_t *kv)
+{
+    if (!kv || !kv->h) {
+        return LT_PARAM_ERR;
+    }
+    if (kv->index_synced) {
+        return LT_OK;
+    }
+
+    uint8_t buff[R_MEM_DATA_SIZE_MAX];
+    struct lt_rmem_kv_index_hdr_t *hdr = (struct lt_rmem_kv_index_hdr_t *)buff;
+    hdr->magic = LT_RMEM_KV_INDEX_MAGIC;
+    hdr->version = LT_RMEM_KV_VERSION;
+    hdr->entries_cnt = kv->entries_cnt;
+    hdr->first_slot = kv->first_slot;
+    hdr->slots_cnt = kv->slots_cnt;
+    hdr->next_seq = kv->next_seq;
+
+    struct lt_rmem_kv_index_entry_t *e = (struct lt_rmem_kv_index_entry_t *)(buff + sizeof(*hdr));
+    for (uint8_t i = 0; i < kv->entries_cnt; i++) {
+        e[i].name_hash = kv->entries[i].name_hash;
+        e[i].first_slot = kv->entries[i].first_slot;
+        e[i].data_len = kv->entries[i].data_len;
+        e[i].obj_slots = kv->entries[i].obj_slots;
+    }
+
+    lt_ret_t ret = lt_rmem_kv_slot_write(kv->h, kv->first_slot, buff,
+                                         sizeof(*hdr) + (kv->entries_cnt * sizeof(struct lt_rmem_kv_index_entry_t)));
+    if (ret != LT_OK) {
+        return ret;
+    }
+    kv->index_synced = 1;
+
+    return LT_OK;
+}
@@ -12,13 +12,17 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef USE_MBEDTLS
+#include "mbedtls/sha256.h"
+#endif
+
 /** Length of sha256 digest */
 #define SHA256_DIGEST_LENGTH 32
 
 /** sha256 context structure */
 struct lt_crypto_sha256_ctx_t {
 #ifdef USE_MBEDTLS
-    uint32_t space[32];
+    mbedtls_sha256_context ctx;
 #elif LT_USE_TREZOR_CRYPTO
     uint32_t space[256];
 #endif
@@ -0,0 +1,33 @@
+#ifndef LT_SHA256_BLOCKS_H
+#define LT_SHA256_BLOCKS_H
+
+/**
+ * @file   lt_sha256_blocks.h
+ * @brief  SHA256 compression function of backends built on the common SHA256 front end
+ * @author Tropic Square s.r.o.
+ *
+ * hal/crypto/common/lt_crypto_sha256_blocks.c implements `lt_sha256_*()` and `lt_hmac_sha256*()` (buffering, padding,
+ * key pads) on top of `lt_sha256_compress_blocks()`, which is all a backend (LT_CRYPTO_CORTEX_M, LT_SHA256_ACCEL)
+ * has to provide.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lt_crypto_dispatch.h"
+
+/** Length of SHA256 block */
+#define LT_SHA256_BLOCK_LEN 64
+
+/**
+ * @brief Processes `n` consecutive 64B blocks
+ *
+ * @param state   SHA256 state H0-H7
+ * @param blocks  Blocks, n * 64B, no alignment is required
+ * @param n       Number of blocks
+ */
+void lt_sha256_compress_blocks(uint32_t state[8], const uint8_t *blocks, size_t n);
+
+#endif
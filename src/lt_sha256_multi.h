@@ -0,0 +1,35 @@
+#ifndef LT_SHA256_MULTI_H
+#define LT_SHA256_MULTI_H
+
+/**
+ * @file   lt_sha256_multi.h
+ * @brief  SHA256 of several independent messages at once
+ * @author Tropic Square s.r.o.
+ *
+ * hal/crypto/common/lt_crypto_sha256_multi.c hashes LT_SHA256_MULTI_LANES messages in parallel, one message in each
+ * lane of SIMD registers (set by LT_SHA256_MULTI CMake option). With one lane the messages are hashed one by one by
+ * `lt_sha256_*()` of the crypto backend.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LT_SHA256_MULTI_LANES
+/** Number of messages hashed in parallel */
+#define LT_SHA256_MULTI_LANES 1
+#endif
+
+/**
+ * @brief Computes SHA256 of each message
+ * @note Lanes run for as many blocks as the longest message of their group, batches of similar lengths are the fastest
+ *
+ * @param msgs       Messages
+ * @param msg_lens   Lengths of messages
+ * @param n          Number of messages
+ * @param digests    Buffer for digests, n * 32B
+ */
+void lt_sha256_multi(const uint8_t *const *msgs, const uint32_t *msg_lens, size_t n, uint8_t *digests);
+
+#endif
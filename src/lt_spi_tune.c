@@ -0,0 +1,98 @@
+/**
+ * @file lt_spi_tune.c
+ * @brief SPI clock tuning functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_spi_tune.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "lt_l1_port_wrap.h"
+
+/** Requests the clock from the port and starts a new window, the clock stays unchanged when the port fails */
+static lt_ret_t lt_spi_tune_apply(lt_l2_state_t *s2, lt_spi_tune_t *t, const uint32_t hz)
+{
+    uint32_t actual_hz;
+
+    t->frames = 0;
+    t->errors = 0;
+
+    lt_ret_t ret = lt_l1_spi_speed_set(s2, hz, &actual_hz);
+    if (ret != LT_OK) {
+        LT_LOG_S2_WARN(s2, "SPI clock %" PRIu32 " Hz was not set", hz);
+        return ret;
+    }
+    t->target_hz = hz;
+    t->hz = actual_hz;
+    LT_LOG_S2_DEBUG(s2, "SPI clock: %" PRIu32 " Hz", actual_hz);
+
+    return LT_OK;
+}
+
+lt_ret_t lt_spi_tune_set(lt_l2_state_t *s2, const uint32_t hz, uint32_t *actual_hz)
+{
+    lt_spi_tune_t *t = s2->spi_tune;
+
+    if (!t) {
+        return lt_l1_spi_speed_set(s2, hz, actual_hz);
+    }
+
+    t->ceiling_hz = 0;
+    lt_ret_t ret = lt_spi_tune_apply(s2, t, hz);
+    *actual_hz = t->hz;
+
+    return ret;
+}
+
+void lt_spi_tune_frame(lt_l2_state_t *s2, const uint8_t crc_err)
+{
+    lt_spi_tune_t *t = s2->spi_tune;
+
+    if (!t || !t->window) {
+        return;
+    }
+    if (!t->target_hz) {
+        // Frame was done at the clock the port was initialized with
+        lt_ret_t ret_unused = lt_spi_tune_apply(s2, t, t->min_hz);
+        (void)ret_unused;
+        return;
+    }
+
+    t->frames++;
+    if (crc_err) {
+        t->errors++;
+        t->stats.crc_errors++;
+    }
+
+    if (t->errors > t->max_errors) {
+        uint32_t hz = (t->target_hz > t->min_hz + t->step_hz) ? (t->target_hz - t->step_hz) : t->min_hz;
+        t->ceiling_hz = t->target_hz;
+        t->stats.backoffs++;
+        lt_ret_t ret_unused = lt_spi_tune_apply(s2, t, hz);
+        (void)ret_unused;
+        return;
+    }
+    if (t->frames < t->window) {
+        return;
+    }
+
+    uint32_t hz = t->target_hz;
+    if (hz < t->max_hz) {
+        hz = ((t->max_hz - hz) > t->step_hz) ? (hz + t->step_hz) : t->max_hz;
+    }
+    if ((hz == t->target_hz) || (t->ceiling_hz && (hz >= t->ceiling_hz))) {
+        // Already at the highest clock which worked
+        t->frames = 0;
+        t->errors = 0;
+        return;
+    }
+    t->stats.raises++;
+    lt_ret_t ret_unused = lt_spi_tune_apply(s2, t, hz);
+    (void)ret_unused;
+}
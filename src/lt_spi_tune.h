@@ -0,0 +1,46 @@
+#ifndef LT_SPI_TUNE_H
+#define LT_SPI_TUNE_H
+
+/**
+ * @defgroup group_spi_tune_functions SPI clock tuning functions
+ * @brief Used internally
+ * @details Functions of the auto-tuner in `lt_l2_state_t.spi_tune`, they do nothing when it is NULL.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_spi_tune.h
+ * @brief SPI clock tuning functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_USE_SPI_SPEED
+/**
+ * @brief Sets the clock and restarts tuning from it, the ceiling is forgotten
+ *
+ * @param s2          Structure holding l2 state
+ * @param hz          Requested clock in Hz
+ * @param actual_hz   Clock actually used by the port
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_spi_tune_set(lt_l2_state_t *s2, const uint32_t hz, uint32_t *actual_hz);
+
+/**
+ * @brief Accounts a checked frame and changes the clock at the end of a window or after too many CRC errors
+ *
+ * @param s2          Structure holding l2 state
+ * @param crc_err     Nonzero when the frame had CRC error, or TROPIC01 reported CRC error of the request
+ */
+void lt_spi_tune_frame(lt_l2_state_t *s2, const uint8_t crc_err);
+#endif
+
+/** @} */  // end of group_spi_tune_functions
+
+#endif
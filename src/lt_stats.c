@@ -0,0 +1,95 @@
+/**
+ * @file lt_stats.c
+ * @brief Statistics functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_stats.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+
+void lt_stats_begin(lt_l2_state_t *s2, const uint16_t key)
+{
+    lt_stats_t *stats = s2->stats;
+    lt_stats_entry_t *free_entry = NULL;
+
+    if (!stats) {
+        return;
+    }
+
+    stats->cur = NULL;
+    for (size_t i = 0; i < LT_STATS_CNT; i++) {
+        if (stats->entries[i].key == key) {
+            stats->cur = &stats->entries[i];
+            break;
+        }
+        if (!free_entry && (stats->entries[i].key == 0)) {
+            free_entry = &stats->entries[i];
+        }
+    }
+
+    if (!stats->cur && free_entry) {
+        memset(free_entry, 0, sizeof(*free_entry));
+        free_entry->key = key;
+        stats->cur = free_entry;
+    }
+
+    if (stats->cur) {
+        stats->cur->cnt++;
+    }
+    else {
+        stats->dropped++;
+    }
+}
+
+uint32_t lt_stats_clock(const lt_l2_state_t *s2)
+{
+    if (!s2->stats || !s2->stats->time_us) {
+        return 0;
+    }
+
+    return s2->stats->time_us();
+}
+
+void lt_stats_time(lt_l2_state_t *s2, const lt_stats_phase_t phase, const uint32_t start_us)
+{
+    if (!s2->stats || !s2->stats->cur || !s2->stats->time_us) {
+        return;
+    }
+
+    // Unsigned difference is correct also when the clock wrapped around
+    uint32_t us = s2->stats->time_us() - start_us;
+    lt_stats_time_t *t = &s2->stats->cur->time[phase];
+
+    t->total_us += us;
+    if (us > t->max_us) {
+        t->max_us = us;
+    }
+}
+
+void lt_stats_bytes(lt_l2_state_t *s2, const uint32_t len)
+{
+    if (s2->stats && s2->stats->cur) {
+        s2->stats->cur->bytes += len;
+    }
+}
+
+void lt_stats_crc_error(lt_l2_state_t *s2)
+{
+    if (s2->stats && s2->stats->cur) {
+        s2->stats->cur->crc_errors++;
+    }
+}
+
+void lt_stats_resend(lt_l2_state_t *s2)
+{
+    if (s2->stats && s2->stats->cur) {
+        s2->stats->cur->resends++;
+    }
+}
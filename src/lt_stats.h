@@ -0,0 +1,75 @@
+#ifndef LT_STATS_H
+#define LT_STATS_H
+
+/**
+ * @defgroup group_stats_functions Statistics functions
+ * @brief Used internally
+ * @details Functions collecting statistics into `lt_l2_state_t.stats`, they do nothing when it is NULL.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_stats.h
+ * @brief Statistics functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_STATS
+/**
+ * @brief Starts accounting to the entry of the key, whose count is increased
+ *
+ * @param s2          Structure holding l2 state
+ * @param key         LT_STATS_KEY_L2() or LT_STATS_KEY_L3() key
+ */
+void lt_stats_begin(lt_l2_state_t *s2, const uint16_t key);
+
+/**
+ * @brief Reads the clock of statistics
+ *
+ * @param s2          Structure holding l2 state
+ * @return            Time in us, zero when time is not measured
+ */
+uint32_t lt_stats_clock(const lt_l2_state_t *s2);
+
+/**
+ * @brief Adds time since `start_us` to the phase of current entry
+ *
+ * @param s2          Structure holding l2 state
+ * @param phase       Measured phase
+ * @param start_us    Value of `lt_stats_clock()` at the start of the phase
+ */
+void lt_stats_time(lt_l2_state_t *s2, const lt_stats_phase_t phase, const uint32_t start_us);
+
+/**
+ * @brief Adds transferred bytes to current entry
+ *
+ * @param s2          Structure holding l2 state
+ * @param len         Number of bytes
+ */
+void lt_stats_bytes(lt_l2_state_t *s2, const uint32_t len);
+
+/**
+ * @brief Counts a frame with CRC error in current entry
+ *
+ * @param s2          Structure holding l2 state
+ */
+void lt_stats_crc_error(lt_l2_state_t *s2);
+
+/**
+ * @brief Counts Resend_Req in current entry
+ *
+ * @param s2          Structure holding l2 state
+ */
+void lt_stats_resend(lt_l2_state_t *s2);
+#endif
+
+/** @} */  // end of group_stats_functions
+
+#endif
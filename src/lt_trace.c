@@ -0,0 +1,144 @@
+/**
+ * @file lt_trace.c
+ * @brief Trace functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_trace.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+/** Magic of trace dump, see scripts/trace_dump.py */
+#define LT_TRACE_DUMP_MAGIC "LTTR"
+/** Version of trace dump format */
+#define LT_TRACE_DUMP_VERSION 1
+/** Size of trace dump header */
+#define LT_TRACE_DUMP_HEADER_SIZE 16
+/** Size of one event in trace dump */
+#define LT_TRACE_DUMP_EVENT_SIZE (8 + LT_TRACE_PAYLOAD_SIZE)
+
+void lt_trace_record(lt_l2_state_t *s2, const lt_trace_dir_t dir, const uint8_t id, const uint16_t len,
+                     const uint8_t *data, const uint16_t data_len)
+{
+    lt_trace_t *t = s2->trace;
+
+    if (!t || !t->enabled) {
+        return;
+    }
+
+    uint32_t i = __atomic_fetch_add(&t->head, 1, __ATOMIC_RELAXED);
+    lt_trace_event_t *e = &t->events[i & t->mask];
+
+    e->time_us = t->time_us ? t->time_us() : 0;
+    e->len = len;
+    e->dir = (uint8_t)dir;
+    e->id = id;
+    memcpy(e->payload, data, (data_len < t->payload_len) ? data_len : t->payload_len);
+}
+
+lt_ret_t lt_trace_init(lt_trace_t *t, lt_trace_event_t *events, const uint32_t cnt, uint32_t (*time_us)(void))
+{
+    // Number of events is a power of two, so the slot is taken by masking
+    if (!t || !events || !cnt || (cnt & (cnt - 1))) {
+        return LT_PARAM_ERR;
+    }
+
+    memset(events, 0, cnt * sizeof(lt_trace_event_t));
+    t->events = events;
+    t->mask = cnt - 1;
+    t->time_us = time_us;
+    t->payload_len = LT_TRACE_PAYLOAD_SIZE;
+    __atomic_store_n(&t->head, 0, __ATOMIC_RELEASE);
+    t->enabled = 1;
+
+    return LT_OK;
+}
+
+/** Stores 32-bit value as little endian */
+static void lt_trace_put_u32(uint8_t *p, const uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+/** Writes dump of `cnt` events recorded before `head`, `lost` older ones were overwritten */
+static lt_ret_t lt_trace_dump_range(const lt_trace_t *t, const uint32_t head, const uint32_t cnt, const uint32_t lost,
+                                    lt_trace_write_t write, void *ctx)
+{
+    uint8_t header[LT_TRACE_DUMP_HEADER_SIZE] = {0};
+    memcpy(header, LT_TRACE_DUMP_MAGIC, 4);
+    header[4] = LT_TRACE_DUMP_VERSION;
+    header[5] = LT_TRACE_PAYLOAD_SIZE;
+    header[6] = t->payload_len;
+    lt_trace_put_u32(header + 8, cnt);
+    // Number of events overwritten before the dump
+    lt_trace_put_u32(header + 12, lost);
+
+    lt_ret_t ret = write(ctx, header, sizeof(header));
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Oldest event first
+    for (uint32_t i = head - cnt; i != head; i++) {
+        const lt_trace_event_t *e = &t->events[i & t->mask];
+        uint8_t rec[LT_TRACE_DUMP_EVENT_SIZE];
+
+        lt_trace_put_u32(rec, e->time_us);
+        rec[4] = e->len & 0xff;
+        rec[5] = e->len >> 8;
+        rec[6] = e->dir;
+        rec[7] = e->id;
+        memcpy(rec + 8, e->payload, LT_TRACE_PAYLOAD_SIZE);
+
+        ret = write(ctx, rec, sizeof(rec));
+        if (ret != LT_OK) {
+            return ret;
+        }
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t lt_trace_dump(const lt_trace_t *t, lt_trace_write_t write, void *ctx)
+{
+    if (!t || !t->events || !write) {
+        return LT_PARAM_ERR;
+    }
+
+    uint32_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    uint32_t cnt = (head > t->mask) ? (t->mask + 1) : head;
+
+    return lt_trace_dump_range(t, head, cnt, head - cnt, write, ctx);
+}
+
+lt_ret_t lt_trace_dump_new(const lt_trace_t *t, uint32_t *pos, lt_trace_write_t write, void *ctx)
+{
+    if (!t || !t->events || !pos || !write) {
+        return LT_PARAM_ERR;
+    }
+
+    uint32_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    // Unsigned difference is correct also when the counter wrapped around
+    uint32_t cnt = head - *pos;
+    if (!cnt) {
+        return LT_OK;
+    }
+    uint32_t lost = (cnt > t->mask + 1) ? (cnt - (t->mask + 1)) : 0;
+
+    lt_ret_t ret = lt_trace_dump_range(t, head, cnt - lost, lost, write, ctx);
+    if (ret == LT_OK) {
+        *pos = head;
+    }
+
+    return ret;
+}
@@ -0,0 +1,41 @@
+#ifndef LT_TRACE_H
+#define LT_TRACE_H
+
+/**
+ * @defgroup group_trace_functions Trace functions
+ * @brief Used internally
+ * @details Functions recording L2 frames into `lt_l2_state_t.trace`, they do nothing when it is NULL or disabled.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_trace.h
+ * @brief Trace functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_TRACE
+/**
+ * @brief Records one frame
+ *
+ * @param s2          Structure holding l2 state
+ * @param dir         Direction of the frame
+ * @param id          REQ_ID of request, STATUS of response
+ * @param len         Length of the whole frame
+ * @param data        REQ_DATA or RSP_DATA
+ * @param data_len    Number of bytes available at `data`
+ */
+void lt_trace_record(lt_l2_state_t *s2, const lt_trace_dir_t dir, const uint8_t id, const uint16_t len,
+                     const uint8_t *data, const uint16_t data_len);
+#endif
+
+/** @} */  // end of group_trace_functions
+
+#endif
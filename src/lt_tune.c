@@ -0,0 +1,231 @@
+/**
+ * @file lt_tune.c
+ * @brief Tuning profile functions definitions
+ * @author Tropic Square s.r.o.
+ *
+ * Profile: LT_TUNE_MAGIC, LT_TUNE_VERSION, key and a byte of sections present, then the sections in the order of
+ * their bits, all words little endian, and CRC16 of all that.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_tune.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_macros.h"
+#include "lt_crc16.h"
+#include "lt_spi_tune.h"
+#include "lt_wire.h"
+
+#if LT_TUNE_PERSIST
+/** Polling statistics of LT_ADAPTIVE_POLLING */
+#define LT_TUNE_SECTION_POLL 0x01u
+/** SPI clock of `lt_spi_tune_t` */
+#define LT_TUNE_SECTION_SPI 0x02u
+/** Statistics of LT_L2_RETRY_POLICY */
+#define LT_TUNE_SECTION_RETRY 0x04u
+
+STATIC_ASSERT(sizeof(struct lt_ser_num_t) + LT_TUNE_PORT_ID_LEN == LT_TUNE_KEY_SIZE)
+#if LT_ADAPTIVE_POLLING
+STATIC_ASSERT(LT_L1_POLL_STATS_CNT <= 16)
+#endif
+
+void lt_tune_key_set(lt_tune_store_t *store, const struct lt_chip_id_t *chip_id)
+{
+    memset(store->key, 0, sizeof(store->key));
+    memcpy(store->key, &chip_id->ser_num, sizeof(chip_id->ser_num));
+    for (uint8_t i = 0; store->port_id && (i < LT_TUNE_PORT_ID_LEN) && store->port_id[i]; i++) {
+        store->key[sizeof(chip_id->ser_num) + i] = (uint8_t)store->port_id[i];
+    }
+    store->key_valid = 1;
+}
+
+lt_ret_t lt_tune_write(lt_handle_t *h, uint8_t *buff, const uint16_t max_len, uint16_t *len)
+{
+    uint8_t sections = 0;
+    uint32_t total = LT_TUNE_HEADER_SIZE + 2;
+#if LT_ADAPTIVE_POLLING
+    uint8_t poll_cnt = 0;
+    for (uint8_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+        poll_cnt += (h->l2.poll.stats[i].cmd != 0);
+    }
+    sections |= LT_TUNE_SECTION_POLL;
+    total += LT_TUNE_POLL_SIZE(poll_cnt);
+#endif
+#if LT_USE_SPI_SPEED
+    if (h->l2.spi_tune) {
+        sections |= LT_TUNE_SECTION_SPI;
+        total += LT_TUNE_SPI_SIZE;
+    }
+#endif
+#if LT_L2_RETRY_POLICY
+    sections |= LT_TUNE_SECTION_RETRY;
+    total += LT_TUNE_RETRY_SIZE;
+#endif
+    if (total > max_len) {
+        return LT_PARAM_ERR;
+    }
+
+    uint8_t *p = buff;
+    memcpy(p, LT_TUNE_MAGIC, 4);
+    p += 4;
+    *p++ = LT_TUNE_VERSION;
+    memcpy(p, h->tune_store->key, LT_TUNE_KEY_SIZE);
+    p += LT_TUNE_KEY_SIZE;
+    *p++ = sections;
+
+#if LT_ADAPTIVE_POLLING
+    *p++ = poll_cnt;
+    for (uint8_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+        const lt_l1_poll_stats_t *st = &h->l2.poll.stats[i];
+        if (!st->cmd) {
+            continue;
+        }
+        lt_wire_st16(p, st->cmd);
+        lt_wire_st32(p + 2, st->cnt);
+        lt_wire_st32(p + 6, st->polls);
+        lt_wire_st32(p + 10, st->last_us);
+        lt_wire_st32(p + 14, st->min_us);
+        lt_wire_st32(p + 18, st->max_us);
+        lt_wire_st32(p + 22, st->avg_us);
+        lt_wire_st16(p + 26, st->len_max);
+        p += 28;
+    }
+#endif
+#if LT_USE_SPI_SPEED
+    if (sections & LT_TUNE_SECTION_SPI) {
+        const lt_spi_tune_t *t = h->l2.spi_tune;
+        lt_wire_st32(p, t->target_hz);
+        lt_wire_st32(p + 4, t->ceiling_hz);
+        lt_wire_st32(p + 8, t->stats.raises);
+        lt_wire_st32(p + 12, t->stats.backoffs);
+        lt_wire_st32(p + 16, t->stats.crc_errors);
+        p += LT_TUNE_SPI_SIZE;
+    }
+#endif
+#if LT_L2_RETRY_POLICY
+    const lt_l2_retry_stats_t *rs = &h->l2.retry.stats;
+    lt_wire_st32(p, rs->crc_errors);
+    lt_wire_st32(p + 4, rs->resends);
+    lt_wire_st32(p + 8, rs->busy_timeouts);
+    lt_wire_st32(p + 12, rs->cmd_chunk_resends);
+    lt_wire_st32(p + 16, rs->res_chunk_resends);
+    lt_wire_st32(p + 20, rs->failures);
+    p += LT_TUNE_RETRY_SIZE;
+#endif
+
+    lt_wire_st16(p, crc16(buff, (int16_t)(p - buff)));
+    p += 2;
+    *len = (uint16_t)(p - buff);
+
+    return LT_OK;
+}
+
+#if LT_ADAPTIVE_POLLING
+/** Restores statistics of the command into its slot or into a free one */
+static void lt_tune_read_poll(lt_l1_poll_t *poll, const uint8_t *p)
+{
+    const uint16_t cmd = lt_wire_ld16(p);
+    lt_l1_poll_stats_t *st = NULL;
+
+    for (uint8_t i = 0; i < LT_L1_POLL_STATS_CNT; i++) {
+        if (poll->stats[i].cmd == cmd) {
+            st = &poll->stats[i];
+            break;
+        }
+        if (!st && !poll->stats[i].cmd) {
+            st = &poll->stats[i];
+        }
+    }
+    if (!cmd || !st) {
+        return;
+    }
+
+    st->cmd = cmd;
+    st->cnt = lt_wire_ld32(p + 2);
+    st->polls = lt_wire_ld32(p + 6);
+    st->last_us = lt_wire_ld32(p + 10);
+    st->min_us = lt_wire_ld32(p + 14);
+    st->max_us = lt_wire_ld32(p + 18);
+    st->avg_us = lt_wire_ld32(p + 22);
+    st->len_max = lt_wire_ld16(p + 26);
+}
+#endif
+
+lt_ret_t lt_tune_read(lt_handle_t *h, const uint8_t *buff, const uint16_t len)
+{
+    if ((len < LT_TUNE_HEADER_SIZE + 2) || memcmp(buff, LT_TUNE_MAGIC, 4) || (buff[4] != LT_TUNE_VERSION)
+        || memcmp(buff + 5, h->tune_store->key, LT_TUNE_KEY_SIZE)
+        || (lt_wire_ld16(buff + len - 2) != crc16(buff, (int16_t)(len - 2)))) {
+        return LT_NOT_FOUND;
+    }
+
+    const uint8_t sections = buff[LT_TUNE_HEADER_SIZE - 1];
+    uint32_t expected = LT_TUNE_HEADER_SIZE + 2;
+    const uint8_t *p = buff + LT_TUNE_HEADER_SIZE;
+    uint8_t poll_cnt = 0;
+    if (sections & LT_TUNE_SECTION_POLL) {
+        // Number of statistics is checked against the length before any of them is restored
+        if (len < LT_TUNE_HEADER_SIZE + 1 + 2) {
+            return LT_NOT_FOUND;
+        }
+        poll_cnt = *p;
+        expected += LT_TUNE_POLL_SIZE(poll_cnt);
+    }
+    expected += (sections & LT_TUNE_SECTION_SPI) ? LT_TUNE_SPI_SIZE : 0;
+    expected += (sections & LT_TUNE_SECTION_RETRY) ? LT_TUNE_RETRY_SIZE : 0;
+    if (expected != len) {
+        return LT_NOT_FOUND;
+    }
+
+    if (sections & LT_TUNE_SECTION_POLL) {
+        p++;
+        for (uint8_t i = 0; i < poll_cnt; i++) {
+#if LT_ADAPTIVE_POLLING
+            lt_tune_read_poll(&h->l2.poll, p);
+#endif
+            p += 28;
+        }
+    }
+    if (sections & LT_TUNE_SECTION_SPI) {
+#if LT_USE_SPI_SPEED
+        lt_spi_tune_t *t = h->l2.spi_tune;
+        const uint32_t hz = lt_wire_ld32(p);
+        // Limits of the tuner may have changed since the profile was saved
+        if (t && hz && (hz >= t->min_hz) && (hz <= t->max_hz)) {
+            uint32_t actual_hz;
+            lt_ret_t ret = lt_spi_tune_set(&h->l2, hz, &actual_hz);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            const uint32_t ceiling_hz = lt_wire_ld32(p + 4);
+            t->ceiling_hz = (ceiling_hz > hz) ? ceiling_hz : 0;
+            t->stats.raises = lt_wire_ld32(p + 8);
+            t->stats.backoffs = lt_wire_ld32(p + 12);
+            t->stats.crc_errors = lt_wire_ld32(p + 16);
+            LT_LOG_S2_DEBUG(&h->l2, "SPI clock restored from tuning profile");
+        }
+#endif
+        p += LT_TUNE_SPI_SIZE;
+    }
+    if (sections & LT_TUNE_SECTION_RETRY) {
+#if LT_L2_RETRY_POLICY
+        lt_l2_retry_stats_t *rs = &h->l2.retry.stats;
+        rs->crc_errors = lt_wire_ld32(p);
+        rs->resends = lt_wire_ld32(p + 4);
+        rs->busy_timeouts = lt_wire_ld32(p + 8);
+        rs->cmd_chunk_resends = lt_wire_ld32(p + 12);
+        rs->res_chunk_resends = lt_wire_ld32(p + 16);
+        rs->failures = lt_wire_ld32(p + 20);
+#endif
+        p += LT_TUNE_RETRY_SIZE;
+    }
+    UNUSED(p);
+
+    return LT_OK;
+}
+#endif
@@ -0,0 +1,57 @@
+#ifndef LT_TUNE_H
+#define LT_TUNE_H
+
+/**
+ * @defgroup group_tune_functions Tuning profile functions
+ * @brief Used internally
+ * @details Serialization of what the handle learned about the chip and the bus, see `lt_tune_store_t`.
+ *
+ * @{
+ */
+
+/**
+ * @file lt_tune.h
+ * @brief Tuning profile functions declarations
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+#if LT_TUNE_PERSIST
+/**
+ * @brief Makes the key of profiles of the chip from its serial number and the port identity
+ *
+ * @param store       Store of the handle
+ * @param chip_id     CHIP_ID of the chip
+ */
+void lt_tune_key_set(lt_tune_store_t *store, const struct lt_chip_id_t *chip_id);
+
+/**
+ * @brief Writes the profile of the handle
+ *
+ * @param h           Device's handle with valid key in `h->tune_store`
+ * @param buff        Buffer for the profile
+ * @param max_len     Length of the buffer
+ * @param len         Length of the profile
+ * @return            LT_OK if success, otherwise returns other error code.
+ */
+lt_ret_t lt_tune_write(lt_handle_t *h, uint8_t *buff, const uint16_t max_len, uint16_t *len);
+
+/**
+ * @brief Restores tuning of the handle from the profile
+ *
+ * @param h           Device's handle with valid key in `h->tune_store`
+ * @param buff        Profile
+ * @param len         Length of the profile
+ * @return            LT_OK if success, LT_NOT_FOUND when the profile is corrupted or has another key
+ */
+lt_ret_t lt_tune_read(lt_handle_t *h, const uint8_t *buff, const uint16_t len);
+#endif
+
+/** @} */  // end of group_tune_functions
+
+#endif
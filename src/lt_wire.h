@@ -0,0 +1,105 @@
+#ifndef LT_WIRE_H
+#define LT_WIRE_H
+
+/**
+ * @defgroup group_wire Access to fields of L2 and L3 frames
+ * @brief Used internally
+ * @details Frames are packed structures (lt_l2_api_structs.h, lt_l3_api_structs.h), so the compiler assumes their
+ * multi-byte fields have any alignment. Cores without unaligned access (e.g. Cortex-M0+) then load and store each
+ * field byte by byte, although most frames start at the beginning of an aligned buffer and some fields, e.g. the size
+ * of each L3 frame, are aligned there.
+ *
+ * `LT_L2_GET16()`, `LT_L3_SET32()` and the like access a field through the alignment of the buffer the frame is in
+ * and the offset of the field, so an aligned field is accessed by a single instruction. Misaligned fields are still
+ * accessed correctly, by single instructions on cores with unaligned access and byte by byte on the others. Fields are
+ * little-endian on the wire, they are converted on big-endian hosts.
+ * @{
+ */
+
+/**
+ * @file lt_wire.h
+ * @brief Access to fields of L2 and L3 frames
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+
+/** @brief Alignment of `h->l3.buff` known at compile time, a buffer supplied by the application can have any */
+#if LT_SEPARATE_L3_BUFF
+#define LT_L3_BUFF_ALIGN 1
+#else
+#define LT_L3_BUFF_ALIGN 16
+#endif
+
+/** @brief Loads little-endian 16-bit value from `p` of any alignment */
+static inline uint16_t lt_wire_ld16(const void *p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap16(v);
+#endif
+    return v;
+}
+
+/** @brief Loads little-endian 32-bit value from `p` of any alignment */
+static inline uint32_t lt_wire_ld32(const void *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+/** @brief Stores 16-bit value little-endian into `p` of any alignment */
+static inline void lt_wire_st16(void *p, uint16_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap16(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+/** @brief Stores 32-bit value little-endian into `p` of any alignment */
+static inline void lt_wire_st32(void *p, uint32_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * @brief Address of `field` of `frame` placed in a buffer aligned to `align`. The compiler derives alignment of the
+ * field from both, the memcpy() of the accessors then becomes a single load or store when it is aligned enough.
+ */
+#define LT_WIRE_FIELD(frame, field, align) \
+    ((uint8_t *)__builtin_assume_aligned((frame), (align)) + offsetof(__typeof__(*(frame)), field))
+
+/** @brief Reads 16-bit `field` of L2 frame in `h->l2.buff` */
+#define LT_L2_GET16(frame, field) lt_wire_ld16(LT_WIRE_FIELD(frame, field, LT_L2_BUFF_ALIGN))
+/** @brief Writes 16-bit `field` of L2 frame in `h->l2.buff` */
+#define LT_L2_SET16(frame, field, v) lt_wire_st16(LT_WIRE_FIELD(frame, field, LT_L2_BUFF_ALIGN), (uint16_t)(v))
+/** @brief Writes 32-bit `field` of L2 frame in `h->l2.buff` */
+#define LT_L2_SET32(frame, field, v) lt_wire_st32(LT_WIRE_FIELD(frame, field, LT_L2_BUFF_ALIGN), (uint32_t)(v))
+
+/** @brief Reads 16-bit `field` of L3 frame in the L3 buffer */
+#define LT_L3_GET16(frame, field) lt_wire_ld16(LT_WIRE_FIELD(frame, field, LT_L3_BUFF_ALIGN))
+/** @brief Reads 32-bit `field` of L3 frame in the L3 buffer */
+#define LT_L3_GET32(frame, field) lt_wire_ld32(LT_WIRE_FIELD(frame, field, LT_L3_BUFF_ALIGN))
+/** @brief Writes 16-bit `field` of L3 frame in the L3 buffer */
+#define LT_L3_SET16(frame, field, v) lt_wire_st16(LT_WIRE_FIELD(frame, field, LT_L3_BUFF_ALIGN), (uint16_t)(v))
+/** @brief Writes 32-bit `field` of L3 frame in the L3 buffer */
+#define LT_L3_SET32(frame, field, v) lt_wire_st32(LT_WIRE_FIELD(frame, field, LT_L3_BUFF_ALIGN), (uint32_t)(v))
+
+/** @} */  // end of group_wire group
+
+#endif
@@ -12,7 +12,8 @@
 #include "stdint.h"
 
 /**
- * @details This function computes x25519 shared secret
+ * @details This function computes x25519 shared secret. Used for the Diffie-Hellman operations of the handshake with
+ * a point received from TROPIC01, so backends implement it by the variable-base Montgomery ladder.
  * @param priv   Private key 32B long
  * @param pub    Public key 32B long
  * @param secret Shared secret 32B long
@@ -21,6 +22,9 @@ void lt_X25519(const uint8_t *priv, const uint8_t *pub, uint8_t *secret);
 
 /**
  * @brief X25519 scalar multiplication with a base point
+ * @details Used for ephemeral keys of the handshake. Backends should implement it by a constant-time fixed-base
+ * multiplication with a precomputed table rather than the ladder of `lt_X25519()`, as it is on the host's path of
+ * every session start.
  *
  * @param sk Secret key
  * @param pk Public key
@@ -0,0 +1,337 @@
+/**
+ * @file lt_bench.c
+ * @brief End-to-end benchmarks of main API functions.
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_bench.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+
+/** Version of the JSON output, increased when fields change meaning */
+#define LT_BENCH_JSON_VERSION 1
+
+/** Operation measured by a scenario, `size` is the amount of data it handles */
+typedef lt_ret_t (*lt_bench_op_t)(lt_handle_t *h, const uint16_t size);
+
+/** Benchmark scenario */
+typedef struct lt_bench_scenario_t {
+    const char *name;
+    lt_bench_op_t op;
+    uint16_t size;
+} lt_bench_scenario_t;
+
+/** Public key of TROPIC01 used by the session_start scenario */
+static uint8_t lt_bench_stpub[32];
+/** Data sent by the operations */
+static uint8_t lt_bench_out[PING_LEN_MAX];
+/** Data received by the operations */
+static uint8_t lt_bench_in[PING_LEN_MAX];
+/** Latency of each iteration of the current scenario */
+static uint32_t lt_bench_samples[LT_BENCH_ITERATIONS];
+
+#if LT_STATS
+/** Statistics attached to the handle when the application did not attach its own */
+static lt_stats_t lt_bench_stats;
+#endif
+
+__attribute__((weak)) uint64_t lt_bench_time_us(void) { return 0; }
+
+__attribute__((weak)) uint64_t lt_bench_cpu_us(void) { return 0; }
+
+static lt_ret_t lt_bench_session_start(lt_handle_t *h, const uint16_t size)
+{
+    (void)size;
+    return lt_session_start(h, lt_bench_stpub, PAIRING_KEY_SLOT_INDEX_0, sh0priv, sh0pub);
+}
+
+static lt_ret_t lt_bench_ping(lt_handle_t *h, const uint16_t size)
+{
+    return lt_ping(h, lt_bench_out, lt_bench_in, size);
+}
+
+static lt_ret_t lt_bench_ecdsa_sign(lt_handle_t *h, const uint16_t size)
+{
+    return lt_ecc_ecdsa_sign(h, LT_BENCH_ECDSA_SLOT, lt_bench_out, size, lt_bench_in);
+}
+
+static lt_ret_t lt_bench_eddsa_sign(lt_handle_t *h, const uint16_t size)
+{
+    return lt_ecc_eddsa_sign(h, LT_BENCH_EDDSA_SLOT, lt_bench_out, size, lt_bench_in);
+}
+
+static lt_ret_t lt_bench_random_value_get(lt_handle_t *h, const uint16_t size)
+{
+    return lt_random_value_get(h, lt_bench_in, size);
+}
+
+#if LT_ENABLE_R_MEM
+static lt_ret_t lt_bench_r_mem_write(lt_handle_t *h, const uint16_t size)
+{
+    lt_ret_t ret = lt_r_mem_data_erase(h, LT_BENCH_R_MEM_SLOT);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_r_mem_data_write(h, LT_BENCH_R_MEM_SLOT, lt_bench_out, size);
+}
+
+static lt_ret_t lt_bench_r_mem_read(lt_handle_t *h, const uint16_t size)
+{
+    uint16_t read_size = 0;
+
+    lt_ret_t ret = lt_r_mem_data_read(h, LT_BENCH_R_MEM_SLOT, lt_bench_in, &read_size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return (read_size == size) ? LT_OK : LT_FAIL;
+}
+#endif
+
+static lt_ret_t lt_bench_r_config_read(lt_handle_t *h, const uint16_t size)
+{
+    uint32_t obj;
+
+    (void)size;
+    return lt_r_config_read(h, CONFIGURATION_OBJECTS_CFG_START_UP_ADDR, &obj);
+}
+
+#if LT_ENABLE_MCOUNTER
+static lt_ret_t lt_bench_mcounter_update(lt_handle_t *h, const uint16_t size)
+{
+    (void)size;
+    return lt_mcounter_update(h, LT_BENCH_MCOUNTER);
+}
+#endif
+
+// Each r_mem_read follows r_mem_write of the same size, which it checks.
+static const lt_bench_scenario_t lt_bench_scenarios[] = {
+    {"session_start", lt_bench_session_start, 0},
+    {"ping", lt_bench_ping, 1},
+    {"ping", lt_bench_ping, 64},
+    {"ping", lt_bench_ping, 256},
+    {"ping", lt_bench_ping, 1024},
+    {"ping", lt_bench_ping, LT_PING_LEN_MAX},
+    {"ecdsa_sign", lt_bench_ecdsa_sign, 32},
+    {"eddsa_sign", lt_bench_eddsa_sign, 32},
+    {"random_value_get", lt_bench_random_value_get, RANDOM_VALUE_GET_LEN_MAX},
+    {"r_config_read", lt_bench_r_config_read, 4},
+#if LT_ENABLE_MCOUNTER
+    {"mcounter_update", lt_bench_mcounter_update, 4},
+#endif
+#if LT_ENABLE_R_MEM
+    {"r_mem_write", lt_bench_r_mem_write, 32},
+    {"r_mem_read", lt_bench_r_mem_read, 32},
+    {"r_mem_write", lt_bench_r_mem_write, R_MEM_DATA_SIZE_MAX},
+    {"r_mem_read", lt_bench_r_mem_read, R_MEM_DATA_SIZE_MAX},
+#endif
+};
+
+static int lt_bench_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/** Returns nearest-rank percentile of sorted samples */
+static uint32_t lt_bench_percentile(const uint32_t *sorted, const uint32_t cnt, const uint32_t pct)
+{
+    uint32_t rank = ((pct * cnt) + 99) / 100;
+
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+/** Sums counts of requests and bytes of all statistics entries, both are 0 without LT_STATS */
+static void lt_bench_wire(const lt_handle_t *h, uint32_t *requests, uint32_t *bytes)
+{
+    *requests = 0;
+    *bytes = 0;
+#if LT_STATS
+    for (int i = 0; (h->l2.stats != NULL) && (i < LT_STATS_CNT); i++) {
+        *requests += h->l2.stats->entries[i].cnt;
+        *bytes += h->l2.stats->entries[i].bytes;
+    }
+#else
+    (void)h;
+#endif
+}
+
+static int lt_bench_run(lt_handle_t *h, const lt_bench_scenario_t *sc)
+{
+    uint32_t errors = 0, cnt = 0, requests, bytes;
+    uint64_t total_us = 0;
+
+#if LT_STATS
+    lt_stats_reset(h);
+#endif
+    uint64_t cpu_start = lt_bench_cpu_us();
+    for (uint32_t i = 0; i < LT_BENCH_ITERATIONS; i++) {
+        uint64_t start = lt_bench_time_us();
+        lt_ret_t ret = sc->op(h, sc->size);
+        uint64_t elapsed = lt_bench_time_us() - start;
+
+        if (ret != LT_OK) {
+            LT_LOG_ERROR("%s (%" PRIu16 " B) failed, ret=%s", sc->name, sc->size, lt_ret_verbose(ret));
+            errors++;
+            continue;
+        }
+        lt_bench_samples[cnt++] = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+        total_us += elapsed;
+    }
+    uint64_t cpu_us = lt_bench_cpu_us() - cpu_start;
+    lt_bench_wire(h, &requests, &bytes);
+
+    qsort(lt_bench_samples, cnt, sizeof(lt_bench_samples[0]), lt_bench_cmp);
+    uint32_t min = cnt ? lt_bench_samples[0] : 0;
+    uint32_t p50 = cnt ? lt_bench_percentile(lt_bench_samples, cnt, 50) : 0;
+    uint32_t p90 = cnt ? lt_bench_percentile(lt_bench_samples, cnt, 90) : 0;
+    uint32_t p99 = cnt ? lt_bench_percentile(lt_bench_samples, cnt, 99) : 0;
+    uint32_t max = cnt ? lt_bench_samples[cnt - 1] : 0;
+    uint32_t mean = cnt ? (uint32_t)(total_us / cnt) : 0;
+    uint32_t ops_per_sec = total_us ? (uint32_t)((cnt * 1000000ULL) / total_us) : 0;
+
+    LT_LOG_INFO("%-16s %5" PRIu16 " B: p50 %7" PRIu32 " us, p90 %7" PRIu32 " us, p99 %7" PRIu32 " us, %5" PRIu32
+                " ops/s, %" PRIu32 " errors",
+                sc->name, sc->size, p50, p90, p99, ops_per_sec, errors);
+
+    // One line per scenario, so the output can be collected also from a log mixed with other messages
+    printf("{\"bench\":\"%s\",\"size\":%" PRIu16 ",\"iterations\":%d,\"errors\":%" PRIu32 ",\"min_us\":%" PRIu32
+           ",\"p50_us\":%" PRIu32 ",\"p90_us\":%" PRIu32 ",\"p99_us\":%" PRIu32 ",\"max_us\":%" PRIu32
+           ",\"mean_us\":%" PRIu32 ",\"ops_per_sec\":%" PRIu32 ",\"cpu_us\":%" PRIu64 ",\"requests\":%" PRIu32
+           ",\"bytes\":%" PRIu32 ",\"version\":%d}\n",
+           sc->name, sc->size, LT_BENCH_ITERATIONS, errors, min, p50, p90, p99, max, mean, ops_per_sec, cpu_us,
+           requests, bytes, LT_BENCH_JSON_VERSION);
+
+    return errors ? -1 : 0;
+}
+
+/** Prints firmware versions of the chip, results are stored and compared per firmware by the test runners */
+static void lt_bench_firmware(lt_handle_t *h)
+{
+    uint8_t riscv[LT_L2_GET_INFO_RISCV_FW_SIZE] = {0};
+    uint8_t spect[LT_L2_GET_INFO_SPECT_FW_SIZE] = {0};
+
+    if ((lt_get_info_riscv_fw_ver(h, riscv) != LT_OK) || (lt_get_info_spect_fw_ver(h, spect) != LT_OK)) {
+        LT_LOG_WARN("Firmware versions could not be read");
+        return;
+    }
+    printf("{\"bench_firmware\":{\"riscv\":\"%d.%d.%d\",\"spect\":\"%d.%d.%d\"},\"version\":%d}\n", riscv[3] & 0x7f,
+           riscv[2], riscv[1], spect[3], spect[2], spect[1], LT_BENCH_JSON_VERSION);
+}
+
+/** Prepares keys and the monotonic counter used by the scenarios */
+static lt_ret_t lt_bench_setup(lt_handle_t *h)
+{
+    lt_ret_t ret = lt_get_info_st_pub(h, lt_bench_stpub, sizeof(lt_bench_stpub));
+    if (ret != LT_OK) {
+        return ret;
+    }
+    ret = lt_session_start(h, lt_bench_stpub, PAIRING_KEY_SLOT_INDEX_0, sh0priv, sh0pub);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Slots may hold keys left by an interrupted run, erasing an empty slot is not an error
+    ret = lt_ecc_key_erase(h, LT_BENCH_ECDSA_SLOT);
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_generate(h, LT_BENCH_ECDSA_SLOT, CURVE_P256);
+    }
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_erase(h, LT_BENCH_EDDSA_SLOT);
+    }
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_generate(h, LT_BENCH_EDDSA_SLOT, CURVE_ED25519);
+    }
+#if LT_ENABLE_MCOUNTER
+    if (ret == LT_OK) {
+        ret = lt_mcounter_init(h, LT_BENCH_MCOUNTER, MCOUNTER_VALUE_MAX);
+    }
+#endif
+    if (ret == LT_OK) {
+        ret = lt_random_value_get(h, lt_bench_out, RANDOM_VALUE_GET_LEN_MAX);
+    }
+    for (uint16_t i = RANDOM_VALUE_GET_LEN_MAX; i < sizeof(lt_bench_out); i++) {
+        lt_bench_out[i] = lt_bench_out[i % RANDOM_VALUE_GET_LEN_MAX];
+    }
+
+    return ret;
+}
+
+/** Erases what the scenarios left in TROPIC01 */
+static lt_ret_t lt_bench_cleanup(lt_handle_t *h)
+{
+    lt_ret_t ret = lt_ecc_key_erase(h, LT_BENCH_ECDSA_SLOT);
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_erase(h, LT_BENCH_EDDSA_SLOT);
+    }
+#if LT_ENABLE_R_MEM
+    if (ret == LT_OK) {
+        ret = lt_r_mem_data_erase(h, LT_BENCH_R_MEM_SLOT);
+    }
+#endif
+#if LT_ENABLE_MCOUNTER
+    if (ret == LT_OK) {
+        ret = lt_mcounter_init(h, LT_BENCH_MCOUNTER, 0);
+    }
+#endif
+
+    return ret;
+}
+
+int lt_bench(lt_handle_t *h)
+{
+    int result = 0;
+
+    LT_LOG_INFO("----------------------------------------------");
+    LT_LOG_INFO("lt_bench(), %d iterations of each scenario", LT_BENCH_ITERATIONS);
+    LT_LOG_INFO("----------------------------------------------");
+
+    lt_ret_t ret = lt_init(h);
+    if (ret != LT_OK) {
+        LT_LOG_ERROR("lt_init() failed, ret=%s", lt_ret_verbose(ret));
+        return -1;
+    }
+#if LT_STATS
+    struct lt_stats_t *app_stats = h->l2.stats;
+    if (!app_stats) {
+        h->l2.stats = &lt_bench_stats;
+    }
+#endif
+
+    lt_bench_firmware(h);
+
+    ret = lt_bench_setup(h);
+    if (ret != LT_OK) {
+        LT_LOG_ERROR("Setup failed, ret=%s", lt_ret_verbose(ret));
+        result = -1;
+    }
+
+    for (size_t i = 0; (ret == LT_OK) && (i < sizeof(lt_bench_scenarios) / sizeof(lt_bench_scenarios[0])); i++) {
+        result |= lt_bench_run(h, &lt_bench_scenarios[i]);
+    }
+
+    ret = lt_bench_cleanup(h);
+    if (ret != LT_OK) {
+        LT_LOG_ERROR("Cleanup failed, ret=%s", lt_ret_verbose(ret));
+        result = -1;
+    }
+    lt_session_abort(h);
+
+#if LT_STATS
+    h->l2.stats = app_stats;
+#endif
+    lt_deinit(h);
+
+    return result;
+}
@@ -0,0 +1,547 @@
+/**
+ * @file lt_soak.c
+ * @brief Long-running load generator with latency histograms.
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_bench.h"
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "lt_l1_port_wrap.h"
+
+/** Version of the JSON output, increased when fields change meaning */
+#define LT_SOAK_JSON_VERSION 1
+
+/** Sub-buckets per power of two */
+#define LT_SOAK_SUB (1u << LT_SOAK_HIST_SUB_BITS)
+/** Buckets covering latencies up to UINT32_MAX us, values below LT_SOAK_SUB have a bucket each */
+#define LT_SOAK_BUCKETS ((33 - LT_SOAK_HIST_SUB_BITS) * LT_SOAK_SUB)
+
+/** Latencies and errors of one operation */
+typedef struct lt_soak_hist_t {
+    uint32_t buckets[LT_SOAK_BUCKETS];
+    uint32_t count;
+    uint32_t errors;
+    uint64_t total_us;
+    uint32_t max_us;
+} lt_soak_hist_t;
+
+/** Counters of one handle */
+typedef struct lt_soak_handle_t {
+    uint32_t ops;
+    uint32_t errors;
+    /** Secure sessions started after a failed operation */
+    uint32_t sessions;
+    /** Failed restarts of the secure session */
+    uint32_t session_errors;
+    uint8_t stpub[32];
+    /** `lt_init()` succeeded, the handle is cleaned up and deinitialized at the end */
+    uint8_t inited;
+} lt_soak_handle_t;
+
+/** Operation of the mix */
+typedef lt_ret_t (*lt_soak_fn_t)(lt_handle_t *h);
+
+/** Histograms of the current snapshot interval */
+static lt_soak_hist_t lt_soak_interval[LT_SOAK_OPS];
+/** Histograms of the whole run, the interval is added at each snapshot */
+static lt_soak_hist_t lt_soak_total[LT_SOAK_OPS];
+static lt_soak_handle_t lt_soak_handles[LT_SOAK_HANDLES_MAX];
+/** Data sent by the operations */
+static uint8_t lt_soak_out[LT_SOAK_PING_SIZE > RANDOM_VALUE_GET_LEN_MAX ? LT_SOAK_PING_SIZE : RANDOM_VALUE_GET_LEN_MAX];
+/** Data received by the operations */
+static uint8_t lt_soak_in[LT_SOAK_PING_SIZE > R_MEM_DATA_SIZE_MAX ? LT_SOAK_PING_SIZE : R_MEM_DATA_SIZE_MAX];
+
+#if LT_STATS
+/** Statistics attached to handles when the application did not attach its own */
+static lt_stats_t lt_soak_stats[LT_SOAK_HANDLES_MAX];
+#endif
+
+static lt_ret_t lt_soak_ping(lt_handle_t *h) { return lt_ping(h, lt_soak_out, lt_soak_in, LT_SOAK_PING_SIZE); }
+
+static lt_ret_t lt_soak_random(lt_handle_t *h) { return lt_random_value_get(h, lt_soak_in, RANDOM_VALUE_GET_LEN_MAX); }
+
+static lt_ret_t lt_soak_ecdsa_sign(lt_handle_t *h)
+{
+    return lt_ecc_ecdsa_sign(h, LT_BENCH_ECDSA_SLOT, lt_soak_out, 32, lt_soak_in);
+}
+
+static lt_ret_t lt_soak_eddsa_sign(lt_handle_t *h)
+{
+    return lt_ecc_eddsa_sign(h, LT_BENCH_EDDSA_SLOT, lt_soak_out, 32, lt_soak_in);
+}
+
+#if LT_ENABLE_R_MEM
+static lt_ret_t lt_soak_r_mem_read(lt_handle_t *h)
+{
+    uint16_t read_size = 0;
+
+    lt_ret_t ret = lt_r_mem_data_read(h, LT_BENCH_R_MEM_SLOT, lt_soak_in, &read_size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return (read_size == LT_SOAK_R_MEM_SIZE) ? LT_OK : LT_FAIL;
+}
+
+static lt_ret_t lt_soak_r_mem_write(lt_handle_t *h)
+{
+    lt_ret_t ret = lt_r_mem_data_erase(h, LT_BENCH_R_MEM_SLOT);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_r_mem_data_write(h, LT_BENCH_R_MEM_SLOT, lt_soak_out, LT_SOAK_R_MEM_SIZE);
+}
+#endif
+
+#if LT_ENABLE_MCOUNTER
+static lt_ret_t lt_soak_mcounter_update(lt_handle_t *h)
+{
+    lt_ret_t ret = lt_mcounter_update(h, LT_BENCH_MCOUNTER);
+    if (ret == LT_L3_MCOUNTER_UPDATE_UPDATE_ERR) {
+        // Counter reached 0 after MCOUNTER_VALUE_MAX updates
+        ret = lt_mcounter_init(h, LT_BENCH_MCOUNTER, MCOUNTER_VALUE_MAX);
+    }
+
+    return ret;
+}
+#endif
+
+/** Names and functions of operations indexed by `lt_soak_op_t`, NULL when disabled in this build */
+static const struct {
+    const char *name;
+    lt_soak_fn_t fn;
+} lt_soak_ops[LT_SOAK_OPS] = {
+    [LT_SOAK_PING] = {"ping", lt_soak_ping},
+    [LT_SOAK_RANDOM] = {"random", lt_soak_random},
+    [LT_SOAK_ECDSA_SIGN] = {"ecdsa_sign", lt_soak_ecdsa_sign},
+    [LT_SOAK_EDDSA_SIGN] = {"eddsa_sign", lt_soak_eddsa_sign},
+#if LT_ENABLE_R_MEM
+    [LT_SOAK_R_MEM_READ] = {"r_mem_read", lt_soak_r_mem_read},
+    [LT_SOAK_R_MEM_WRITE] = {"r_mem_write", lt_soak_r_mem_write},
+#else
+    [LT_SOAK_R_MEM_READ] = {"r_mem_read", NULL},
+    [LT_SOAK_R_MEM_WRITE] = {"r_mem_write", NULL},
+#endif
+#if LT_ENABLE_MCOUNTER
+    [LT_SOAK_MCOUNTER_UPDATE] = {"mcounter_update", lt_soak_mcounter_update},
+#else
+    [LT_SOAK_MCOUNTER_UPDATE] = {"mcounter_update", NULL},
+#endif
+};
+
+void lt_soak_config_default(lt_soak_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->duration_s = 60;
+    cfg->snapshot_s = 10;
+    cfg->weights[LT_SOAK_PING] = 2;
+    cfg->weights[LT_SOAK_RANDOM] = 2;
+    cfg->weights[LT_SOAK_ECDSA_SIGN] = 2;
+    cfg->weights[LT_SOAK_EDDSA_SIGN] = 2;
+    cfg->weights[LT_SOAK_R_MEM_READ] = 1;
+}
+
+int lt_soak_mix_parse(lt_soak_config_t *cfg, const char *mix)
+{
+    uint8_t weights[LT_SOAK_OPS] = {0};
+    uint32_t sum = 0;
+
+    while (*mix) {
+        size_t len = strcspn(mix, "=");
+        int op = 0;
+        while ((op < LT_SOAK_OPS)
+               && ((strlen(lt_soak_ops[op].name) != len) || strncmp(lt_soak_ops[op].name, mix, len))) {
+            op++;
+        }
+        if ((op == LT_SOAK_OPS) || (mix[len] != '=')) {
+            return -1;
+        }
+        char *end;
+        unsigned long weight = strtoul(mix + len + 1, &end, 10);
+        if ((end == mix + len + 1) || (weight > UINT8_MAX) || ((*end != ',') && (*end != '\0'))) {
+            return -1;
+        }
+        weights[op] = (uint8_t)weight;
+        sum += (uint32_t)weight;
+        mix = (*end == ',') ? end + 1 : end;
+    }
+    if (!sum) {
+        return -1;
+    }
+    memcpy(cfg->weights, weights, sizeof(weights));
+
+    return 0;
+}
+
+/** Returns bucket counting latency `us` */
+static uint32_t lt_soak_bucket(const uint32_t us)
+{
+    if (us < LT_SOAK_SUB) {
+        return us;
+    }
+    uint32_t e = 31 - (uint32_t)__builtin_clz(us);
+    uint32_t sub = (us >> (e - LT_SOAK_HIST_SUB_BITS)) - LT_SOAK_SUB;
+
+    return ((e - LT_SOAK_HIST_SUB_BITS + 1) << LT_SOAK_HIST_SUB_BITS) + sub;
+}
+
+/** Returns the highest latency counted in the bucket */
+static uint32_t lt_soak_bucket_max(const uint32_t idx)
+{
+    if (idx < LT_SOAK_SUB) {
+        return idx;
+    }
+    uint32_t shift = (idx >> LT_SOAK_HIST_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)((idx & (LT_SOAK_SUB - 1)) + LT_SOAK_SUB) << shift;
+
+    return (uint32_t)(low + (1ULL << shift) - 1);
+}
+
+/** Returns latency below which `permille` of the operations completed */
+static uint32_t lt_soak_percentile(const lt_soak_hist_t *hist, const uint32_t permille)
+{
+    uint64_t rank = (((uint64_t)hist->count * permille) + 999) / 1000;
+    uint64_t seen = 0;
+
+    if (!hist->count) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < LT_SOAK_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t max = lt_soak_bucket_max(i);
+            return (max < hist->max_us) ? max : hist->max_us;
+        }
+    }
+
+    return hist->max_us;
+}
+
+static void lt_soak_record(lt_soak_hist_t *hist, const lt_ret_t ret, const uint64_t elapsed)
+{
+    if (ret != LT_OK) {
+        hist->errors++;
+        return;
+    }
+    uint32_t us = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+    hist->buckets[lt_soak_bucket(us)]++;
+    hist->count++;
+    hist->total_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+/** Adds the interval to the totals and clears it */
+static void lt_soak_merge(void)
+{
+    for (int op = 0; op < LT_SOAK_OPS; op++) {
+        lt_soak_hist_t *from = &lt_soak_interval[op], *to = &lt_soak_total[op];
+        for (uint32_t i = 0; i < LT_SOAK_BUCKETS; i++) {
+            to->buckets[i] += from->buckets[i];
+        }
+        to->count += from->count;
+        to->errors += from->errors;
+        to->total_us += from->total_us;
+        if (from->max_us > to->max_us) {
+            to->max_us = from->max_us;
+        }
+        memset(from, 0, sizeof(*from));
+    }
+}
+
+/** Prints summaries of the used operations as members of a JSON object, with their histograms when `buckets` */
+static void lt_soak_print_ops(const lt_soak_hist_t *hists, const lt_soak_config_t *cfg, const int buckets)
+{
+    const char *sep = "";
+
+    for (int op = 0; op < LT_SOAK_OPS; op++) {
+        const lt_soak_hist_t *hist = &hists[op];
+        if (!cfg->weights[op]) {
+            continue;
+        }
+        printf("%s\"%s\":{\"count\":%" PRIu32 ",\"errors\":%" PRIu32 ",\"mean_us\":%" PRIu32 ",\"p50_us\":%" PRIu32
+               ",\"p90_us\":%" PRIu32 ",\"p99_us\":%" PRIu32 ",\"p999_us\":%" PRIu32 ",\"max_us\":%" PRIu32,
+               sep, lt_soak_ops[op].name, hist->count, hist->errors,
+               hist->count ? (uint32_t)(hist->total_us / hist->count) : 0, lt_soak_percentile(hist, 500),
+               lt_soak_percentile(hist, 900), lt_soak_percentile(hist, 990), lt_soak_percentile(hist, 999),
+               hist->max_us);
+        if (buckets) {
+            // Nonzero buckets as [highest latency of the bucket, count] pairs
+            const char *bsep = "";
+            printf(",\"hist\":[");
+            for (uint32_t i = 0; i < LT_SOAK_BUCKETS; i++) {
+                if (hist->buckets[i]) {
+                    printf("%s[%" PRIu32 ",%" PRIu32 "]", bsep, lt_soak_bucket_max(i), hist->buckets[i]);
+                    bsep = ",";
+                }
+            }
+            printf("]");
+        }
+        printf("}");
+        sep = ",";
+    }
+}
+
+/** Prints retries counted by LT_STATS (0 without it) and the highest nonce of open secure sessions */
+static void lt_soak_print_link(lt_handle_t *const *hs, const uint8_t cnt)
+{
+    uint32_t resends = 0, crc_errors = 0, nonce = 0;
+
+    for (uint8_t i = 0; i < cnt; i++) {
+#if LT_STATS
+        for (int j = 0; (hs[i]->l2.stats != NULL) && (j < LT_STATS_CNT); j++) {
+            resends += hs[i]->l2.stats->entries[j].resends;
+            crc_errors += hs[i]->l2.stats->entries[j].crc_errors;
+        }
+#endif
+        const uint8_t *iv = hs[i]->l3.encryption_IV;
+        uint32_t n = ((uint32_t)iv[3] << 24) | ((uint32_t)iv[2] << 16) | ((uint32_t)iv[1] << 8) | iv[0];
+        if (n > nonce) {
+            nonce = n;
+        }
+    }
+    printf(",\"resends\":%" PRIu32 ",\"crc_errors\":%" PRIu32 ",\"nonce_max\":%" PRIu32, resends, crc_errors, nonce);
+}
+
+/** Prepares the handle, the same keys and slots as `lt_bench()` are used */
+static lt_ret_t lt_soak_setup(lt_handle_t *h, lt_soak_handle_t *sh)
+{
+    lt_ret_t ret = lt_get_info_st_pub(h, sh->stpub, sizeof(sh->stpub));
+    if (ret == LT_OK) {
+        ret = lt_session_start(h, sh->stpub, PAIRING_KEY_SLOT_INDEX_0, sh0priv, sh0pub);
+    }
+
+    // Slots may hold keys left by an interrupted run, erasing an empty slot is not an error
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_erase(h, LT_BENCH_ECDSA_SLOT);
+    }
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_generate(h, LT_BENCH_ECDSA_SLOT, CURVE_P256);
+    }
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_erase(h, LT_BENCH_EDDSA_SLOT);
+    }
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_generate(h, LT_BENCH_EDDSA_SLOT, CURVE_ED25519);
+    }
+#if LT_ENABLE_R_MEM
+    if (ret == LT_OK) {
+        ret = lt_soak_r_mem_write(h);
+    }
+#endif
+#if LT_ENABLE_MCOUNTER
+    if (ret == LT_OK) {
+        ret = lt_mcounter_init(h, LT_BENCH_MCOUNTER, MCOUNTER_VALUE_MAX);
+    }
+#endif
+
+    return ret;
+}
+
+/** Erases what the soak left in TROPIC01 */
+static lt_ret_t lt_soak_cleanup(lt_handle_t *h)
+{
+    lt_ret_t ret = lt_ecc_key_erase(h, LT_BENCH_ECDSA_SLOT);
+    if (ret == LT_OK) {
+        ret = lt_ecc_key_erase(h, LT_BENCH_EDDSA_SLOT);
+    }
+#if LT_ENABLE_R_MEM
+    if (ret == LT_OK) {
+        ret = lt_r_mem_data_erase(h, LT_BENCH_R_MEM_SLOT);
+    }
+#endif
+#if LT_ENABLE_MCOUNTER
+    if (ret == LT_OK) {
+        ret = lt_mcounter_init(h, LT_BENCH_MCOUNTER, 0);
+    }
+#endif
+
+    return ret;
+}
+
+/** Picks the next operation by smooth weighted round robin, so the mix is spread evenly and repeatable */
+static int lt_soak_next_op(const lt_soak_config_t *cfg, int32_t *current, const int32_t total)
+{
+    int best = -1;
+
+    for (int op = 0; op < LT_SOAK_OPS; op++) {
+        if (!cfg->weights[op]) {
+            continue;
+        }
+        current[op] += cfg->weights[op];
+        if ((best < 0) || (current[op] > current[best])) {
+            best = op;
+        }
+    }
+    current[best] -= total;
+
+    return best;
+}
+
+int lt_soak(lt_handle_t *const *hs, const uint8_t cnt, const lt_soak_config_t *cfg)
+{
+    int32_t current[LT_SOAK_OPS] = {0}, total_weight = 0;
+    int result = 0;
+
+    if (!hs || !cnt || (cnt > LT_SOAK_HANDLES_MAX) || !cfg || (!cfg->duration_s && !cfg->ops)) {
+        LT_LOG_ERROR("Invalid soak parameters");
+        return -1;
+    }
+    for (int op = 0; op < LT_SOAK_OPS; op++) {
+        if (cfg->weights[op] && !lt_soak_ops[op].fn) {
+            LT_LOG_ERROR("%s is not enabled in this build", lt_soak_ops[op].name);
+            return -1;
+        }
+        total_weight += cfg->weights[op];
+    }
+    if (!total_weight) {
+        LT_LOG_ERROR("No operation in the mix");
+        return -1;
+    }
+
+    LT_LOG_INFO("----------------------------------------------");
+    LT_LOG_INFO("lt_soak(), %d handles, %" PRIu32 " s, %" PRIu32 " ops, rate %" PRIu32 " ops/s", cnt, cfg->duration_s,
+                cfg->ops, cfg->rate);
+    LT_LOG_INFO("----------------------------------------------");
+
+    memset(lt_soak_interval, 0, sizeof(lt_soak_interval));
+    memset(lt_soak_total, 0, sizeof(lt_soak_total));
+    memset(lt_soak_handles, 0, sizeof(lt_soak_handles));
+    for (size_t i = 0; i < sizeof(lt_soak_out); i++) {
+        lt_soak_out[i] = (uint8_t)i;
+    }
+
+#if LT_STATS
+    struct lt_stats_t *app_stats[LT_SOAK_HANDLES_MAX];
+#endif
+    uint8_t ready = 0;
+    for (; (result == 0) && (ready < cnt); ready++) {
+#if LT_STATS
+        app_stats[ready] = hs[ready]->l2.stats;
+        if (!app_stats[ready]) {
+            memset(&lt_soak_stats[ready], 0, sizeof(lt_soak_stats[ready]));
+            hs[ready]->l2.stats = &lt_soak_stats[ready];
+        }
+#endif
+        lt_ret_t ret = lt_init(hs[ready]);
+        if (ret == LT_OK) {
+            lt_soak_handles[ready].inited = 1;
+            ret = lt_soak_setup(hs[ready], &lt_soak_handles[ready]);
+        }
+        if (ret != LT_OK) {
+            LT_LOG_ERROR("Setup of handle %d failed, ret=%s", ready, lt_ret_verbose(ret));
+            result = -1;
+        }
+    }
+
+    uint64_t start = lt_bench_time_us(), cpu_start = lt_bench_cpu_us(), last_snapshot = start, now = start;
+    uint32_t n = 0;
+    while (result == 0) {
+        now = lt_bench_time_us();
+        if ((cfg->duration_s && (now - start >= (uint64_t)cfg->duration_s * 1000000))
+            || (cfg->ops && (n >= cfg->ops))) {
+            break;
+        }
+
+        if (cfg->snapshot_s && (now - last_snapshot >= (uint64_t)cfg->snapshot_s * 1000000)) {
+            printf("{\"soak_snapshot\":{\"elapsed_s\":%" PRIu32 ",\"interval_s\":%" PRIu32 ",\"ops\":{",
+                   (uint32_t)((now - start) / 1000000), (uint32_t)((now - last_snapshot) / 1000000));
+            lt_soak_print_ops(lt_soak_interval, cfg, 0);
+            printf("}");
+            lt_soak_print_link(hs, cnt);
+            printf("},\"version\":%d}\n", LT_SOAK_JSON_VERSION);
+            lt_soak_merge();
+            last_snapshot = now;
+        }
+
+        // With a target rate, the latency is measured from the time the operation was due (no coordinated omission)
+        uint64_t due = now;
+        if (cfg->rate) {
+            due = start + ((uint64_t)n * 1000000) / cfg->rate;
+            if (due > now) {
+                if (due - now >= 1000) {
+                    if (lt_l1_delay(&hs[0]->l2, (uint32_t)((due - now) / 1000)) != LT_OK) {
+                        result = -1;
+                    }
+                    continue;
+                }
+                due = now;
+            }
+        }
+
+        int op = lt_soak_next_op(cfg, current, total_weight);
+        lt_handle_t *h = hs[n % cnt];
+        lt_soak_handle_t *sh = &lt_soak_handles[n % cnt];
+        lt_ret_t ret = lt_soak_ops[op].fn(h);
+        lt_soak_record(&lt_soak_interval[op], ret, lt_bench_time_us() - due);
+        sh->ops++;
+        n++;
+
+        if (ret != LT_OK) {
+            LT_LOG_WARN("%s failed, ret=%s", lt_soak_ops[op].name, lt_ret_verbose(ret));
+            sh->errors++;
+            // The operation may have broken the secure session (e.g. tag error or lost response)
+            lt_session_abort(h);
+            ret = lt_session_start(h, sh->stpub, PAIRING_KEY_SLOT_INDEX_0, sh0priv, sh0pub);
+            if (ret == LT_OK) {
+                sh->sessions++;
+            }
+            else {
+                sh->session_errors++;
+            }
+        }
+    }
+    uint64_t elapsed = now - start, cpu_us = lt_bench_cpu_us() - cpu_start;
+    lt_soak_merge();
+
+    uint32_t ops = 0, errors = 0;
+    for (int op = 0; op < LT_SOAK_OPS; op++) {
+        ops += lt_soak_total[op].count + lt_soak_total[op].errors;
+        errors += lt_soak_total[op].errors;
+    }
+    uint32_t achieved = elapsed ? (uint32_t)(((uint64_t)ops * 1000000) / elapsed) : 0;
+    LT_LOG_INFO("%" PRIu32 " ops in %" PRIu32 " s, %" PRIu32 " ops/s, %" PRIu32 " errors", ops,
+                (uint32_t)(elapsed / 1000000), achieved, errors);
+
+    printf("{\"soak\":{\"duration_s\":%" PRIu32 ",\"rate\":%" PRIu32 ",\"achieved_rate\":%" PRIu32
+           ",\"cpu_us\":%" PRIu64 ",\"ops\":{",
+           (uint32_t)(elapsed / 1000000), cfg->rate, achieved, cpu_us);
+    lt_soak_print_ops(lt_soak_total, cfg, 1);
+    printf("},\"handles\":[");
+    for (uint8_t i = 0; i < cnt; i++) {
+        const lt_soak_handle_t *sh = &lt_soak_handles[i];
+        printf("%s{\"ops\":%" PRIu32 ",\"errors\":%" PRIu32 ",\"sessions\":%" PRIu32 ",\"session_errors\":%" PRIu32 "}",
+               i ? "," : "", sh->ops, sh->errors, sh->sessions, sh->session_errors);
+    }
+    printf("]");
+    lt_soak_print_link(hs, cnt);
+    printf("},\"version\":%d}\n", LT_SOAK_JSON_VERSION);
+
+    for (uint8_t i = 0; i < ready; i++) {
+        if (lt_soak_handles[i].inited) {
+            lt_ret_t ret = lt_soak_cleanup(hs[i]);
+            if (ret != LT_OK) {
+                LT_LOG_ERROR("Cleanup of handle %d failed, ret=%s", i, lt_ret_verbose(ret));
+                result = -1;
+            }
+            lt_session_abort(hs[i]);
+            lt_deinit(hs[i]);
+        }
+#if LT_STATS
+        hs[i]->l2.stats = app_stats[i];
+#endif
+    }
+
+    return (result || errors) ? -1 : 0;
+}
@@ -77,4 +77,41 @@ int chip_id_printf_wrapper(const char *format, ...)
     LT_LOG_INFO("%s", buff);
 
     return ret;
-}
\ No newline at end of file
+}
+
+__attribute__((weak)) uint32_t lt_test_time_ms(void) { return 0; }
+
+int lt_test_run(lt_handle_t *h, const char *name, void (*test)(lt_handle_t *h), const uint32_t budget_ms)
+{
+    char transactions[11] = "-";
+
+#if LT_STATS
+    lt_stats_reset(h);
+#endif
+    uint32_t start_ms = lt_test_time_ms();
+    test(h);
+    uint32_t elapsed_ms = lt_test_time_ms() - start_ms;
+#if LT_STATS
+    if (h->l2.stats) {
+        uint32_t cnt = h->l2.stats->dropped;
+        for (int i = 0; i < LT_STATS_CNT; i++) {
+            cnt += h->l2.stats->entries[i].cnt;
+        }
+        snprintf(transactions, sizeof(transactions), "%" PRIu32, cnt);
+    }
+#endif
+
+    int overrun = (budget_ms != 0) && (elapsed_ms > budget_ms);
+    LT_LOG_INFO("LT_TEST_TIMING name=%s ms=%" PRIu32 " budget_ms=%" PRIu32 " transactions=%s result=%s", name,
+                elapsed_ms, budget_ms, transactions, overrun ? "overrun" : "ok");
+    if (!overrun) {
+        return 0;
+    }
+#ifdef LT_TEST_BUDGET_STRICT
+    LT_LOG_ERROR("Test %s exceeded its budget of %" PRIu32 " ms!", name, budget_ms);
+    return 1;
+#else
+    LT_LOG_WARN("Test %s exceeded its budget of %" PRIu32 " ms.", name, budget_ms);
+    return 0;
+#endif
+}
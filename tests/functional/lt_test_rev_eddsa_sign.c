@@ -82,7 +82,7 @@ void lt_test_rev_eddsa_sign(lt_handle_t *h)
     // Making the handle accessible to the cleanup function.
     g_h = h;
 
-    uint8_t read_pub_key[32], msg_to_sign[LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX], rs[64];
+    uint8_t read_pub_key[32], msg_to_sign[LT_EDDSA_MSG_LEN_MAX], rs[64];
     lt_ecc_curve_type_t curve;
     ecc_key_origin_t origin;
     uint32_t msg_to_sign_len;
@@ -101,9 +101,9 @@ void lt_test_rev_eddsa_sign(lt_handle_t *h)
         LT_LOG_INFO();
         LT_LOG_INFO("Testing signing with ECC key slot #%" PRIu8 "...", i);
 
-        LT_LOG_INFO("Generating random message length <= %d...", (int)LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX);
+        LT_LOG_INFO("Generating random message length <= %d...", (int)LT_EDDSA_MSG_LEN_MAX);
         LT_TEST_ASSERT(LT_OK, lt_random_bytes(&h->l2, &msg_to_sign_len, sizeof(msg_to_sign_len)));
-        msg_to_sign_len %= LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX + 1;  // 0-4096
+        msg_to_sign_len %= LT_EDDSA_MSG_LEN_MAX + 1;  // 0-4096 by default
 
         LT_LOG_INFO("Generating random message with length %" PRIu32 " for signing...", msg_to_sign_len);
         LT_TEST_ASSERT(LT_OK, lt_random_bytes(&h->l2, msg_to_sign, msg_to_sign_len));
@@ -136,9 +136,9 @@ void lt_test_rev_eddsa_sign(lt_handle_t *h)
         LT_LOG_INFO();
         LT_LOG_INFO("Testing signing with ECC key slot #%" PRIu8 "...", i);
 
-        LT_LOG_INFO("Generating random message length <= %d...", (int)LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX);
+        LT_LOG_INFO("Generating random message length <= %d...", (int)LT_EDDSA_MSG_LEN_MAX);
         LT_TEST_ASSERT(LT_OK, lt_random_bytes(&h->l2, &msg_to_sign_len, sizeof(msg_to_sign_len)));
-        msg_to_sign_len %= LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX + 1;  // 0-4096
+        msg_to_sign_len %= LT_EDDSA_MSG_LEN_MAX + 1;  // 0-4096 by default
 
         LT_LOG_INFO("Generating random message with length %" PRIu32 " for signing...", msg_to_sign_len);
         LT_TEST_ASSERT(LT_OK, lt_random_bytes(&h->l2, msg_to_sign, msg_to_sign_len));
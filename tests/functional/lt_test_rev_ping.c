@@ -1,6 +1,6 @@
 /**
  * @file lt_test_rev_ping.c
- * @brief Test Ping L3 command with random data of random length <= PING_LEN_MAX.
+ * @brief Test Ping L3 command with random data of random length <= LT_PING_LEN_MAX.
  * @author Tropic Square s.r.o.
  *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
@@ -24,7 +24,7 @@ void lt_test_rev_ping(lt_handle_t *h)
     LT_LOG_INFO("lt_test_rev_ping()");
     LT_LOG_INFO("----------------------------------------------");
 
-    uint8_t ping_msg_out[PING_LEN_MAX], ping_msg_in[PING_LEN_MAX];
+    uint8_t ping_msg_out[LT_PING_LEN_MAX], ping_msg_in[LT_PING_LEN_MAX];
     uint16_t ping_msg_len;
 
     LT_LOG_INFO("Initializing handle");
@@ -37,9 +37,9 @@ void lt_test_rev_ping(lt_handle_t *h)
     LT_LOG_INFO("Will send %d Ping commands with random data of random length", PING_MAX_LOOPS);
     for (uint16_t i = 0; i < PING_MAX_LOOPS; i++) {
         LT_LOG_INFO();
-        LT_LOG_INFO("Generating random data length <= %d...", (int)PING_LEN_MAX);
+        LT_LOG_INFO("Generating random data length <= %d...", (int)LT_PING_LEN_MAX);
         LT_TEST_ASSERT(LT_OK, lt_random_bytes(&h->l2, &ping_msg_len, sizeof(ping_msg_len)));
-        ping_msg_len %= PING_LEN_MAX + 1;  // 0-4096
+        ping_msg_len %= LT_PING_LEN_MAX + 1;  // 0-4096 by default
 
         LT_LOG_INFO("Generating %" PRIu16 " random bytes...", ping_msg_len);
         LT_TEST_ASSERT(LT_OK, lt_random_bytes(&h->l2, ping_msg_out, ping_msg_len));
@@ -1,6 +1,6 @@
 /**
  * @file lt_test_rev_read_r_config.c
- * @brief Reads contents of R-Config and prints it to the log.
+ * @brief Reads contents of R-Config, prints it to the log and measures time of the pipelined read.
  * @author Tropic Square s.r.o.
  *
  * @license For the license see file LICENSE.txt file in the root directory of this source tree.
@@ -12,6 +12,7 @@
 #include "libtropic_common.h"
 #include "libtropic_functional_tests.h"
 #include "libtropic_logging.h"
+#include "string.h"
 
 void lt_test_rev_read_r_config(lt_handle_t *h)
 {
@@ -19,7 +20,9 @@ void lt_test_rev_read_r_config(lt_handle_t *h)
     LT_LOG_INFO("lt_test_rev_read_r_config()");
     LT_LOG_INFO("----------------------------------------------");
 
-    struct lt_config_t r_config;
+    struct lt_config_t r_config, r_config_seq;
+    struct lt_config_snapshot_t snap;
+    uint32_t changed;
 
     LT_LOG_INFO("Initializing handle");
     LT_TEST_ASSERT(LT_OK, lt_init(h));
@@ -29,12 +32,34 @@ void lt_test_rev_read_r_config(lt_handle_t *h)
     LT_LOG_LINE();
 
     LT_LOG_INFO("Reading the whole R config:");
+    uint32_t start_ms = lt_test_time_ms();
     LT_TEST_ASSERT(LT_OK, lt_read_whole_R_config(h, &r_config));
+    uint32_t pipelined_ms = lt_test_time_ms() - start_ms;
     for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
         LT_LOG_INFO("%s: 0x%08" PRIx32, cfg_desc_table[i].desc, r_config.obj[i]);
     }
     LT_LOG_LINE();
 
+    LT_LOG_INFO("Reading R config object by object and checking it matches");
+    start_ms = lt_test_time_ms();
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        LT_TEST_ASSERT(LT_OK, lt_r_config_read(h, cfg_desc_table[i].addr, &r_config_seq.obj[i]));
+    }
+    uint32_t sequential_ms = lt_test_time_ms() - start_ms;
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        LT_TEST_ASSERT(1, (r_config.obj[i] == r_config_seq.obj[i]));
+    }
+    LT_LOG_INFO("Pipelined read: %" PRIu32 " ms, sequential read: %" PRIu32 " ms", pipelined_ms, sequential_ms);
+    LT_LOG_LINE();
+
+    LT_LOG_INFO("Reading R config snapshot and comparing it");
+    LT_TEST_ASSERT(LT_OK, lt_config_snapshot_read(h, LT_CONFIG_SPACE_R, &snap));
+    LT_TEST_ASSERT(LT_OK, lt_config_snapshot_check(&snap));
+    LT_TEST_ASSERT(0, memcmp(snap.config.obj, r_config.obj, sizeof(r_config.obj)));
+    LT_TEST_ASSERT(LT_OK, lt_config_snapshot_diff(&snap, &snap, &changed));
+    LT_TEST_ASSERT(0, (int)changed);
+    LT_LOG_LINE();
+
     LT_LOG_INFO("Aborting Secure Session");
     LT_TEST_ASSERT(LT_OK, lt_session_abort(h));
 
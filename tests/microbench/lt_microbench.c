@@ -0,0 +1,278 @@
+/**
+ * @file lt_microbench.c
+ * @brief Microbenchmarks of host-side hot paths.
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "lt_microbench.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_l3.h"
+#include "lt_aesgcm.h"
+#include "lt_asn1_der.h"
+#include "lt_crc16.h"
+#include "lt_hkdf.h"
+#include "lt_l2_api_structs.h"
+#include "lt_l2_frame_check.h"
+#include "lt_microbench_cert.h"
+#include "lt_sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Version of the JSON output, increased when fields change meaning */
+#define LT_MICROBENCH_JSON_VERSION 1
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define LT_MICROBENCH_DWT 1
+/** Debug Exception and Monitor Control Register, TRCENA bit enables DWT */
+#define LT_MICROBENCH_DEMCR (*(volatile uint32_t *)0xE000EDFCu)
+/** DWT control register, CYCCNTENA bit enables the cycle counter */
+#define LT_MICROBENCH_DWT_CTRL (*(volatile uint32_t *)0xE0001000u)
+/** DWT cycle counter */
+#define LT_MICROBENCH_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+#endif
+
+/** Case of the benchmark, `size` is the number of bytes it processes */
+typedef struct lt_microbench_case_t {
+    const char *name;
+    lt_ret_t (*fn)(lt_handle_t *h, const uint16_t size);
+    uint16_t size;
+    uint32_t iterations;
+} lt_microbench_case_t;
+
+/** Data processed by the cases */
+static uint8_t lt_microbench_buf[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+/** AES-GCM context of the cases */
+static uint8_t lt_microbench_aes[LT_AESGCM_CTX_SIZE] __attribute__((aligned(16)));
+
+__attribute__((weak)) uint64_t lt_microbench_cycles(void)
+{
+#if LT_MICROBENCH_DWT
+    return LT_MICROBENCH_DWT_CYCCNT;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/** Cycles between two values of the counter, the DWT counter has 32 bits only */
+static uint64_t lt_microbench_elapsed(const uint64_t start, const uint64_t end)
+{
+#if LT_MICROBENCH_DWT
+    return (uint32_t)((uint32_t)end - (uint32_t)start);
+#else
+    return end - start;
+#endif
+}
+
+static lt_ret_t lt_microbench_crc16(lt_handle_t *h, const uint16_t size)
+{
+    (void)h;
+    volatile uint16_t crc = crc16(lt_microbench_buf, (int16_t)size);
+    (void)crc;
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_microbench_add_crc(lt_handle_t *h, const uint16_t size)
+{
+    // Request frame: REQ_ID, REQ_LEN, data, CRC
+    lt_microbench_buf[1] = (uint8_t)(size - 4);
+    add_crc(&h->l2, lt_microbench_buf);
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_microbench_frame_check(lt_handle_t *h, const uint16_t size)
+{
+    // Response frame: CHIP_STATUS, STATUS, RSP_LEN, data, CRC
+    lt_microbench_buf[1] = L2_STATUS_RESULT_OK;
+    lt_microbench_buf[2] = (uint8_t)(size - 5);
+    add_crc(&h->l2, &lt_microbench_buf[1]);
+
+    return lt_l2_frame_check(&h->l2, lt_microbench_buf);
+}
+
+static lt_ret_t lt_microbench_hkdf(lt_handle_t *h, const uint16_t size)
+{
+    uint8_t out_1[32], out_2[32];
+
+    (void)h;
+    lt_hkdf(lt_microbench_buf, 32, lt_microbench_buf + 32, size, 2, out_1, out_2);
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_microbench_aesgcm_encrypt(lt_handle_t *h, const uint16_t size)
+{
+    (void)h;
+    // Same layout as L3 packet: 12 B IV, ciphertext, 16 B tag
+    if (lt_aesgcm_encrypt(lt_microbench_aes, lt_microbench_buf, 12, (const uint8_t *)"", 0, lt_microbench_buf + 12,
+                          size, lt_microbench_buf + 12 + size, L3_TAG_SIZE)
+        != LT_OK) {
+        return LT_CRYPTO_ERR;
+    }
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_microbench_aesgcm_decrypt(lt_handle_t *h, const uint16_t size)
+{
+    // Encrypt again, so the decryption in place checks a valid tag
+    lt_ret_t ret = lt_microbench_aesgcm_encrypt(h, size);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (lt_aesgcm_decrypt(lt_microbench_aes, lt_microbench_buf, 12, (const uint8_t *)"", 0, lt_microbench_buf + 12,
+                          size, lt_microbench_buf + 12 + size, L3_TAG_SIZE)
+        != LT_OK) {
+        return LT_CRYPTO_ERR;
+    }
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_microbench_sha256(lt_handle_t *h, const uint16_t size)
+{
+    struct lt_crypto_sha256_ctx_t ctx;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+
+    (void)h;
+    lt_sha256_init(&ctx);
+    lt_sha256_start(&ctx);
+    lt_sha256_update(&ctx, lt_microbench_buf, size);
+    lt_sha256_finish(&ctx, digest);
+
+    return LT_OK;
+}
+
+static lt_ret_t lt_microbench_asn1(lt_handle_t *h, const uint16_t size)
+{
+    uint8_t stpub[32];
+
+    (void)h;
+    return asn1der_find_object(lt_microbench_device_cert, size, OBJ_ID_CURVEX25519, stpub, sizeof(stpub),
+                               ASN1DER_CROP_PREFIX);
+}
+
+static lt_ret_t lt_microbench_session_start(lt_handle_t *h, const uint16_t size)
+{
+    session_state_t state;
+
+    (void)size;
+    lt_ret_t ret = lt_out__session_start(h, PAIRING_KEY_SLOT_INDEX_0, &state);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    // Response with a valid point, but a tag TROPIC01 did not compute, so only the final tag check fails
+    struct lt_l2_handshake_rsp_t *rsp = (struct lt_l2_handshake_rsp_t *)h->l2.buff;
+    memcpy(rsp->e_tpub, state.ehpub, sizeof(rsp->e_tpub));
+    memset(rsp->t_tauth, 0, sizeof(rsp->t_tauth));
+    // Any 32 B values serve as STPUB and the pairing key pair
+    ret = lt_in__session_start(h, lt_microbench_buf, PAIRING_KEY_SLOT_INDEX_0, lt_microbench_buf + 32,
+                               lt_microbench_buf + 64, &state);
+
+    // Error code of the tag mismatch depends on the crypto backend, a success would mean the check is broken
+    return (ret == LT_OK) ? LT_FAIL : LT_OK;
+}
+
+/** Iterations are scaled by LT_MICROBENCH_SCALE */
+static const lt_microbench_case_t lt_microbench_cases[] = {
+    {"crc16", lt_microbench_crc16, 6, 20000},
+    {"crc16", lt_microbench_crc16, L2_MAX_FRAME_SIZE, 5000},
+    {"add_crc", lt_microbench_add_crc, 4 + L2_CHUNK_MAX_DATA_SIZE, 5000},
+    {"l2_frame_check", lt_microbench_frame_check, 5 + L2_CHUNK_MAX_DATA_SIZE, 5000},
+    {"hkdf", lt_microbench_hkdf, 32, 2000},
+    {"aesgcm_encrypt", lt_microbench_aesgcm_encrypt, 16, 5000},
+    {"aesgcm_encrypt", lt_microbench_aesgcm_encrypt, L2_CHUNK_MAX_DATA_SIZE, 2000},
+    {"aesgcm_encrypt", lt_microbench_aesgcm_encrypt, L3_CYPHERTEXT_MAX_SIZE, 200},
+    {"aesgcm_decrypt", lt_microbench_aesgcm_decrypt, 16, 5000},
+    {"aesgcm_decrypt", lt_microbench_aesgcm_decrypt, L2_CHUNK_MAX_DATA_SIZE, 2000},
+    {"aesgcm_decrypt", lt_microbench_aesgcm_decrypt, L3_CYPHERTEXT_MAX_SIZE, 200},
+    {"sha256", lt_microbench_sha256, 64, 5000},
+    {"sha256", lt_microbench_sha256, 1024, 1000},
+    {"sha256", lt_microbench_sha256, PING_LEN_MAX, 200},
+    {"asn1der_find_object", lt_microbench_asn1, sizeof(lt_microbench_device_cert), 5000},
+    {"session_start", lt_microbench_session_start, 0, 50},
+};
+
+static lt_ret_t lt_microbench_run(lt_handle_t *h, const lt_microbench_case_t *c)
+{
+    uint32_t iterations = (uint32_t)(c->iterations * LT_MICROBENCH_SCALE);
+    uint64_t total = 0, min = UINT64_MAX;
+    lt_ret_t ret = LT_OK;
+
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    for (uint32_t i = 0; (ret == LT_OK) && (i < iterations); i++) {
+        uint64_t start = lt_microbench_cycles();
+        ret = c->fn(h, c->size);
+        uint64_t cycles = lt_microbench_elapsed(start, lt_microbench_cycles());
+
+        total += cycles;
+        if (cycles < min) {
+            min = cycles;
+        }
+    }
+    if (ret != LT_OK) {
+        printf("%-20s %5" PRIu16 " B: failed, ret=%s\n", c->name, c->size, lt_ret_verbose(ret));
+        return ret;
+    }
+
+    // Cycles per byte with two decimal places, printf of floats is often missing on embedded targets
+    uint64_t mean = total / iterations;
+    uint64_t per_byte_x100 = c->size ? (total * 100) / ((uint64_t)iterations * c->size) : 0;
+
+    printf("%-20s %5" PRIu16 " B: %10" PRIu64 " cycles (min %10" PRIu64 "), %6" PRIu64 ".%02" PRIu64
+           " cycles/B\n",
+           c->name, c->size, mean, min, per_byte_x100 / 100, per_byte_x100 % 100);
+    printf("{\"microbench\":\"%s\",\"size\":%" PRIu16 ",\"iterations\":%" PRIu32 ",\"cycles\":%" PRIu64
+           ",\"min_cycles\":%" PRIu64 ",\"cycles_per_byte\":%" PRIu64 ".%02" PRIu64 ",\"version\":%d}\n",
+           c->name, c->size, iterations, mean, min, per_byte_x100 / 100, per_byte_x100 % 100,
+           LT_MICROBENCH_JSON_VERSION);
+
+    return LT_OK;
+}
+
+int lt_microbench(lt_handle_t *h)
+{
+    int result = 0;
+
+#if LT_MICROBENCH_DWT
+    LT_MICROBENCH_DEMCR |= (1u << 24);
+    LT_MICROBENCH_DWT_CYCCNT = 0;
+    LT_MICROBENCH_DWT_CTRL |= 1u;
+#endif
+
+    for (size_t i = 0; i < sizeof(lt_microbench_buf); i++) {
+        lt_microbench_buf[i] = (uint8_t)(i * 7);
+    }
+    if (lt_aesgcm_init_and_key(lt_microbench_aes, lt_microbench_buf, 32) != LT_OK) {
+        printf("AES-GCM key setup failed\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(lt_microbench_cases) / sizeof(lt_microbench_cases[0]); i++) {
+        if (lt_microbench_run(h, &lt_microbench_cases[i]) != LT_OK) {
+            result = -1;
+        }
+    }
+
+    if (lt_aesgcm_end(lt_microbench_aes) != LT_OK) {
+        result = -1;
+    }
+
+    return result;
+}
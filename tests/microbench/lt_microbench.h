@@ -0,0 +1,42 @@
+#ifndef LT_MICROBENCH_H
+#define LT_MICROBENCH_H
+
+/**
+ * @file lt_microbench.h
+ * @brief Microbenchmarks of host-side hot paths (CRC, frame check, HKDF, AES-GCM, SHA-256, ASN.1, handshake)
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Multiplier of number of iterations of each case, e.g. 0.1 of the default is enough on Cortex-M */
+#ifndef LT_MICROBENCH_SCALE
+#define LT_MICROBENCH_SCALE 1
+#endif
+
+/**
+ * @brief Returns cycle counter.
+ * @details Uses TSC on x86 and DWT cycle counter on Cortex-M3/M4/M7/M33 (enabled by `lt_microbench()`).
+ * Other platforms override this weak function, otherwise 0 is reported.
+ *
+ * @return       Cycles since an arbitrary point
+ */
+uint64_t lt_microbench_cycles(void);
+
+/**
+ * @brief Runs all microbenchmarks, prints a table and one JSON object per line to stdout.
+ * @details No communication with TROPIC01 is done, the handle only provides the port's random bytes for ephemeral
+ * keys of the handshake and the L2 state for CRC computation.
+ *
+ * @param h     Device's handle, not initialized by `lt_init()`
+ *
+ * @retval       0  All cases executed successfully
+ * @retval      -1  Some case returned unexpected result
+ */
+int lt_microbench(lt_handle_t *h);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LT_MICROBENCH_CERT_H
+#define LT_MICROBENCH_CERT_H
+
+/**
+ * @file lt_microbench_cert.h
+ * @brief Device certificate of the lab batch package (tropic01_ese_certificate.pem in DER), searched by the
+ * ASN.1 microbenchmark the same way as the certificate read from TROPIC01
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+static const uint8_t lt_microbench_device_cert[] = {
+    0x30, 0x82, 0x01, 0xdb, 0x30, 0x82, 0x01, 0x62, 0xa0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x10, 0x02,
+    0xf0, 0x02, 0x00, 0x08, 0x82, 0x19, 0x06, 0x1b, 0x09, 0x33, 0x00, 0x00, 0x04, 0x00, 0x09, 0x30,
+    0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x03, 0x30, 0x4c, 0x31, 0x0b, 0x30,
+    0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x43, 0x5a, 0x31, 0x1d, 0x30, 0x1b, 0x06, 0x03,
+    0x55, 0x04, 0x0a, 0x0c, 0x14, 0x54, 0x72, 0x6f, 0x70, 0x69, 0x63, 0x20, 0x53, 0x71, 0x75, 0x61,
+    0x72, 0x65, 0x20, 0x73, 0x2e, 0x72, 0x2e, 0x6f, 0x2e, 0x31, 0x1e, 0x30, 0x1c, 0x06, 0x03, 0x55,
+    0x04, 0x03, 0x0c, 0x15, 0x54, 0x52, 0x4f, 0x50, 0x49, 0x43, 0x30, 0x31, 0x2d, 0x58, 0x20, 0x54,
+    0x45, 0x53, 0x54, 0x20, 0x43, 0x41, 0x20, 0x76, 0x31, 0x30, 0x1e, 0x17, 0x0d, 0x32, 0x35, 0x30,
+    0x36, 0x32, 0x37, 0x30, 0x38, 0x34, 0x30, 0x35, 0x35, 0x5a, 0x17, 0x0d, 0x34, 0x35, 0x30, 0x36,
+    0x32, 0x37, 0x30, 0x38, 0x34, 0x30, 0x35, 0x35, 0x5a, 0x30, 0x1c, 0x31, 0x1a, 0x30, 0x18, 0x06,
+    0x03, 0x55, 0x04, 0x03, 0x0c, 0x11, 0x54, 0x52, 0x4f, 0x50, 0x49, 0x43, 0x30, 0x31, 0x20, 0x65,
+    0x53, 0x45, 0x20, 0x54, 0x45, 0x53, 0x54, 0x30, 0x2a, 0x30, 0x05, 0x06, 0x03, 0x2b, 0x65, 0x6e,
+    0x03, 0x21, 0x00, 0x95, 0x08, 0xf0, 0x32, 0x1c, 0xb1, 0xd2, 0xe5, 0xd1, 0xf1, 0xa4, 0x60, 0x9c,
+    0x05, 0x41, 0xb7, 0x80, 0xe6, 0xdd, 0x50, 0xd6, 0x48, 0x2b, 0x6b, 0x08, 0xb2, 0xc2, 0x7e, 0x7b,
+    0x76, 0x26, 0x47, 0xa3, 0x81, 0x84, 0x30, 0x81, 0x81, 0x30, 0x0c, 0x06, 0x03, 0x55, 0x1d, 0x13,
+    0x01, 0x01, 0xff, 0x04, 0x02, 0x30, 0x00, 0x30, 0x0e, 0x06, 0x03, 0x55, 0x1d, 0x0f, 0x01, 0x01,
+    0xff, 0x04, 0x04, 0x03, 0x02, 0x03, 0x08, 0x30, 0x1f, 0x06, 0x03, 0x55, 0x1d, 0x23, 0x04, 0x18,
+    0x30, 0x16, 0x80, 0x14, 0x7b, 0xf3, 0x8c, 0x79, 0x9b, 0x7a, 0x4b, 0x2e, 0xbf, 0x41, 0x05, 0x7d,
+    0xd5, 0xd2, 0x6a, 0xeb, 0x5d, 0xa0, 0x40, 0xf3, 0x30, 0x40, 0x06, 0x03, 0x55, 0x1d, 0x1f, 0x04,
+    0x39, 0x30, 0x37, 0x30, 0x35, 0xa0, 0x33, 0xa0, 0x31, 0x86, 0x2f, 0x68, 0x74, 0x74, 0x70, 0x3a,
+    0x2f, 0x2f, 0x70, 0x6b, 0x69, 0x2e, 0x74, 0x72, 0x6f, 0x70, 0x69, 0x63, 0x73, 0x71, 0x75, 0x61,
+    0x72, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x2f, 0x6c, 0x33, 0x2f, 0x74, 0x30, 0x31, 0x2d, 0x54, 0x76,
+    0x31, 0x2d, 0x74, 0x65, 0x73, 0x74, 0x2e, 0x63, 0x72, 0x6c, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86,
+    0x48, 0xce, 0x3d, 0x04, 0x03, 0x03, 0x03, 0x67, 0x00, 0x30, 0x64, 0x02, 0x30, 0x41, 0x1d, 0x4e,
+    0x3f, 0xf8, 0xc5, 0x1f, 0x7e, 0x76, 0x4c, 0xa6, 0x33, 0x05, 0x2c, 0x32, 0x40, 0x0d, 0xf7, 0x69,
+    0xe7, 0xaa, 0x39, 0x00, 0x65, 0xc3, 0xd7, 0xa0, 0x88, 0xa7, 0xda, 0x9a, 0x48, 0xac, 0xf2, 0x09,
+    0xd5, 0x09, 0x83, 0x3a, 0x81, 0x18, 0x52, 0x9c, 0xf8, 0xe3, 0x54, 0x94, 0xb4, 0x02, 0x30, 0x6d,
+    0x6d, 0x42, 0xa5, 0x0c, 0x13, 0xf8, 0x1d, 0x52, 0x51, 0x0b, 0x6b, 0xc5, 0xef, 0x16, 0x5f, 0xa3,
+    0x01, 0x82, 0xc5, 0xe3, 0x2f, 0x5d, 0x4e, 0xa9, 0xc0, 0x46, 0x8b, 0x3b, 0x02, 0xf7, 0xa2, 0x8c,
+    0xee, 0x79, 0xdb, 0xcf, 0x54, 0x6f, 0xdb, 0x55, 0xe0, 0xf0, 0x3a, 0xd0, 0xd5, 0x98, 0xf7,
+};
+
+#endif
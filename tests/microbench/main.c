@@ -0,0 +1,27 @@
+/**
+ * @file main.c
+ * @brief Runs microbenchmarks on host, the unix TCP port only provides random bytes.
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+
+#include "libtropic_common.h"
+#include "libtropic_port_unix_tcp.h"
+#include "lt_microbench.h"
+
+int main(void)
+{
+    lt_handle_t __lt_handle__ = {0};
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16))) = {0};
+    __lt_handle__.l3.buff = l3_buffer;
+    __lt_handle__.l3.buff_len = sizeof(l3_buffer);
+#endif
+    lt_dev_unix_tcp_t device = {0};
+    __lt_handle__.l2.device = &device;
+
+    return lt_microbench(&__lt_handle__) ? 1 : 0;
+}
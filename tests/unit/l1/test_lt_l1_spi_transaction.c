@@ -0,0 +1,86 @@
+/**
+ * @file test_lt_l1_spi_transaction.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic_common.h"
+#include "lt_l1.h"
+#include "lt_l1_port_wrap.h"
+#include "mock_libtropic_port.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid handle
+void test__invalid_handle()
+{
+    lt_l1_spi_segment_t seg = {.offset = 0, .len = 1, .cs_hold = 0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_l1_spi_transaction(NULL, &seg, 1, LT_L1_TIMEOUT_MS_DEFAULT));
+}
+
+// Test if function returns LT_PARAM_ERR on invalid number of segments
+void test__invalid_seg_cnt()
+{
+    lt_handle_t h = {0};
+    lt_l1_spi_segment_t segs[LT_L1_SPI_SEGMENTS_MAX + 1] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_l1_spi_transaction(&h.l2, segs, 0, LT_L1_TIMEOUT_MS_DEFAULT));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR,
+                      lt_l1_spi_transaction(&h.l2, segs, LT_L1_SPI_SEGMENTS_MAX + 1, LT_L1_TIMEOUT_MS_DEFAULT));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Check that held segments are transferred within one chip select window and CSN is released after the last one
+void test__emulated_cs_hold()
+{
+    lt_handle_t h = {0};
+    lt_l1_spi_segment_t segs[] = {{.offset = 0, .len = 1, .cs_hold = 1}, {.offset = 1, .len = 2, .cs_hold = 0}};
+
+    lt_port_spi_csn_low_ExpectAndReturn(&h.l2, LT_OK);
+    lt_port_spi_transfer_ExpectAndReturn(&h.l2, 0, 1, LT_L1_TIMEOUT_MS_DEFAULT, LT_OK);
+    lt_port_spi_transfer_ExpectAndReturn(&h.l2, 1, 2, LT_L1_TIMEOUT_MS_DEFAULT, LT_OK);
+    lt_port_spi_csn_high_ExpectAndReturn(&h.l2, LT_OK);
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_l1_spi_transaction(&h.l2, segs, 2, LT_L1_TIMEOUT_MS_DEFAULT));
+}
+
+// Check that chip select stays low when the last segment holds it
+void test__emulated_cs_hold_last()
+{
+    lt_handle_t h = {0};
+    lt_l1_spi_segment_t seg = {.offset = 0, .len = 1, .cs_hold = 1};
+
+    lt_port_spi_csn_low_ExpectAndReturn(&h.l2, LT_OK);
+    lt_port_spi_transfer_ExpectAndReturn(&h.l2, 0, 1, LT_L1_TIMEOUT_MS_DEFAULT, LT_OK);
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_l1_spi_transaction(&h.l2, &seg, 1, LT_L1_TIMEOUT_MS_DEFAULT));
+}
+
+// Check that chip select is released and error returned when transfer fails
+void test__emulated_transfer_LT_FAIL()
+{
+    lt_handle_t h = {0};
+    lt_l1_spi_segment_t seg = {.offset = 0, .len = 1, .cs_hold = 1};
+
+    lt_port_spi_csn_low_ExpectAndReturn(&h.l2, LT_OK);
+    lt_port_spi_transfer_ExpectAndReturn(&h.l2, 0, 1, LT_L1_TIMEOUT_MS_DEFAULT, LT_FAIL);
+    lt_port_spi_csn_high_ExpectAndReturn(&h.l2, LT_OK);
+
+    TEST_ASSERT_EQUAL(LT_FAIL, lt_l1_spi_transaction(&h.l2, &seg, 1, LT_L1_TIMEOUT_MS_DEFAULT));
+}
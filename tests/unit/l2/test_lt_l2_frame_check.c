@@ -27,12 +27,27 @@ void tearDown(void) {}
 //---------------------------------------------------------------------------------------------------------//
 
 // Test if function returns expected error on non valid input parameter
-void test_lt_l2_frame_check___NULL_frame() { TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_l2_frame_check(NULL)); }
+void test_lt_l2_frame_check___NULL_frame()
+{
+    lt_l2_state_t s2 = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_l2_frame_check(&s2, NULL));
+}
+
+// Test if function returns expected error on non valid l2 state
+void test_lt_l2_frame_check___NULL_s2()
+{
+    uint8_t frame[5] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_l2_frame_check(NULL, frame));
+}
 
 //---------------------------------------------------------------------------------------------------------//
 //---------------------------------- EXECUTION ------------------------------------------------------------//
 //---------------------------------------------------------------------------------------------------------//
 
+static lt_l2_state_t test_s2;
+
 static uint8_t test_data[] = {
     0x00, 0x00, 0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
     0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -47,8 +62,8 @@ void test_lt_l2_frame_check___CHIP_STATUS_READY__LT_OK()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_RESULT_OK;
-    crc16_IgnoreAndReturn(0x2e4e);
-    TEST_ASSERT_EQUAL(LT_OK, lt_l2_frame_check(test_data));
+    lt_l2_crc16_IgnoreAndReturn(0x2e4e);
+    TEST_ASSERT_EQUAL(LT_OK, lt_l2_frame_check(&test_s2, test_data));
 }
 
 /* Check what function returns when frame looks valid (from first two bytes), but frame's CRC check fails.
@@ -57,8 +72,8 @@ void test_lt_l2_frame_check___CHIP_STATUS_READY__LT_CRC_ERR()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_REQUEST_OK;
-    crc16_IgnoreAndReturn(0xdead);
-    TEST_ASSERT_EQUAL(LT_L2_IN_CRC_ERR, lt_l2_frame_check(test_data));
+    lt_l2_crc16_IgnoreAndReturn(0xdead);
+    TEST_ASSERT_EQUAL(LT_L2_IN_CRC_ERR, lt_l2_frame_check(&test_s2, test_data));
 }
 
 // Test various other return values
@@ -66,63 +81,63 @@ void test_lt_l2_frame_check___LT_L2_REQ_CONT()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_REQUEST_CONT;
-    TEST_ASSERT_EQUAL(LT_L2_REQ_CONT, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_REQ_CONT, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_RES_CONT()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_RESULT_CONT;
-    TEST_ASSERT_EQUAL(LT_L2_RES_CONT, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_RES_CONT, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_HSK_ERR()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_HSK_ERR;
-    TEST_ASSERT_EQUAL(LT_L2_HSK_ERR, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_HSK_ERR, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_NO_SESSION()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_NO_SESSION;
-    TEST_ASSERT_EQUAL(LT_L2_NO_SESSION, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_NO_SESSION, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_TAG_ERR()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_TAG_ERR;
-    TEST_ASSERT_EQUAL(LT_L2_TAG_ERR, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_TAG_ERR, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_CRC_ERR()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_CRC_ERR;
-    TEST_ASSERT_EQUAL(LT_L2_CRC_ERR, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_CRC_ERR, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_GEN_ERR()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_GEN_ERR;
-    TEST_ASSERT_EQUAL(LT_L2_GEN_ERR, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_GEN_ERR, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_NO_RESP()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_NO_RESP;
-    TEST_ASSERT_EQUAL(LT_L2_NO_RESP, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_NO_RESP, lt_l2_frame_check(&test_s2, test_data));
 }
 
 void test_lt_l2_frame_check___LT_L2_UNKNOWN_REQ()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = L2_STATUS_UNKNOWN_ERR;
-    TEST_ASSERT_EQUAL(LT_L2_UNKNOWN_REQ, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_UNKNOWN_REQ, lt_l2_frame_check(&test_s2, test_data));
 }
 
 // Test default behaviour when second byte is not recognized by parser
@@ -130,5 +145,39 @@ void test_lt_l2_frame_check___LT_FAIL()
 {
     test_data[0] = CHIP_MODE_READY_bit;
     test_data[1] = INVALID_BYTE;
-    TEST_ASSERT_EQUAL(LT_L2_STATUS_NOT_RECOGNIZED, lt_l2_frame_check(test_data));
+    TEST_ASSERT_EQUAL(LT_L2_STATUS_NOT_RECOGNIZED, lt_l2_frame_check(&test_s2, test_data));
+}
+
+// Test if function returns expected error when data of the frame are missing
+void test_lt_l2_frame_check_data___NULL_data()
+{
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_l2_frame_check_data(&test_s2, test_data, NULL));
+}
+
+/* Check that CRC of the frame is computed over its header and data, which were received outside of the frame,
+CRC stays in the frame */
+void test_lt_l2_frame_check_data___data_outside__LT_OK()
+{
+    uint8_t data[0x80] = {0};
+
+    test_data[0] = CHIP_MODE_READY_bit;
+    test_data[1] = L2_STATUS_RESULT_OK;
+    crc16_init_ExpectAndReturn(0xffff);
+    crc16_update_ExpectAndReturn(0xffff, test_data + 1, 2, 0x1234);
+    crc16_update_ExpectAndReturn(0x1234, data, sizeof(data), 0x5678);
+    crc16_final_ExpectAndReturn(0x5678, 0x2e4e);
+    TEST_ASSERT_EQUAL(LT_OK, lt_l2_frame_check_data(&test_s2, test_data, data));
+}
+
+// Check function's return value when data received outside of the frame do not match its CRC
+void test_lt_l2_frame_check_data___data_outside__LT_CRC_ERR()
+{
+    uint8_t data[0x80] = {0};
+
+    test_data[0] = CHIP_MODE_READY_bit;
+    test_data[1] = L2_STATUS_RESULT_OK;
+    crc16_init_IgnoreAndReturn(0xffff);
+    crc16_update_IgnoreAndReturn(0x1234);
+    crc16_final_IgnoreAndReturn(0xdead);
+    TEST_ASSERT_EQUAL(LT_L2_IN_CRC_ERR, lt_l2_frame_check_data(&test_s2, test_data, data));
 }
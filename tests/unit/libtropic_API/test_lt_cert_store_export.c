@@ -0,0 +1,105 @@
+/**
+ * @file test_lt_cert_store_export.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l2_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if lt_cert_store_export() returns LT_PARAM_ERR when NULL is passed instead of any pointer
+void test__export_invalid_params()
+{
+    struct lt_chip_id_t chip_id = {0};
+    struct lt_cert_store_t store = {0};
+    uint8_t buff[LT_CERT_STORE_EXPORT_SIZE_MAX];
+    uint16_t len;
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_export(NULL, &store, buff, sizeof(buff), &len));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_export(&chip_id, NULL, buff, sizeof(buff), &len));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_export(&chip_id, &store, NULL, sizeof(buff), &len));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_export(&chip_id, &store, buff, sizeof(buff), NULL));
+}
+
+// Test if lt_cert_store_export() returns LT_PARAM_ERR when exported data do not fit into the buffer
+void test__export_small_buffer()
+{
+    struct lt_chip_id_t chip_id = {0};
+    uint8_t certs[LT_NUM_CERTIFICATES][16] = {0};
+    struct lt_cert_store_t store = {.certs = {certs[0], certs[1], certs[2], certs[3]},
+                                    .buf_len = {16, 16, 16, 16},
+                                    .cert_len = {16, 16, 16, 16}};
+    uint8_t buff[LT_CERT_STORE_EXPORT_HEADER_SIZE + 4 * 16 + SHA256_DIGEST_LENGTH];
+    uint16_t len;
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_export(&chip_id, &store, buff, sizeof(buff) - 1, &len));
+}
+
+// Test if lt_cert_store_import() returns LT_PARAM_ERR on invalid parameters
+void test__import_invalid_params()
+{
+    struct lt_chip_id_t chip_id = {0};
+    uint8_t buff[LT_CERT_STORE_EXPORT_SIZE_MAX] = {0};
+    uint8_t stpub[32];
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_import(NULL, buff, sizeof(buff), NULL, stpub, sizeof(stpub)));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_import(&chip_id, NULL, sizeof(buff), NULL, stpub, sizeof(stpub)));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_cert_store_import(&chip_id, buff, sizeof(buff), NULL, stpub, 31));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if lt_cert_store_import() rejects data shorter than header and digest
+void test__import_too_short()
+{
+    struct lt_chip_id_t chip_id = {0};
+    uint8_t buff[LT_CERT_STORE_EXPORT_HEADER_SIZE + SHA256_DIGEST_LENGTH - 1] = {0};
+    uint8_t stpub[32];
+
+    TEST_ASSERT_EQUAL(LT_CERT_STORE_INVALID,
+                      lt_cert_store_import(&chip_id, buff, sizeof(buff), NULL, stpub, sizeof(stpub)));
+}
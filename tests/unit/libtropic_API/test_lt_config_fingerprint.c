@@ -0,0 +1,98 @@
+/**
+ * @file test_lt_config_fingerprint.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if lt_config_state_read() returns LT_PARAM_ERR on invalid parameters
+void test__state_read_invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    struct lt_config_state_t state = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_state_read(NULL, &state));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_state_read(&h, NULL));
+
+    // Only slots 0-3 can be selected
+    state.pkeys_mask = 1u << (PAIRING_KEY_SLOT_INDEX_3 + 1);
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_state_read(&h, &state));
+}
+
+// Test if lt_config_fingerprint() returns LT_PARAM_ERR on invalid parameters
+void test__fingerprint_invalid_params()
+{
+    struct lt_config_state_t state = {0};
+    uint8_t fp[LT_CONFIG_FINGERPRINT_SIZE];
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint(NULL, fp));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint(&state, NULL));
+
+    state.pkeys_mask = 0x80;
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint(&state, fp));
+}
+
+// Test if lt_config_fingerprint_match() returns LT_PARAM_ERR on invalid parameters and does not report a match
+void test__match_invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    struct lt_config_state_t state = {0};
+    uint8_t target[LT_CONFIG_FINGERPRINT_SIZE] = {0};
+    bool match;
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint_match(NULL, target, &state, &match));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint_match(&h, NULL, &state, &match));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint_match(&h, target, NULL, &match));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint_match(&h, target, &state, NULL));
+
+    match = true;
+    state.pkeys_mask = 0x10;
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_config_fingerprint_match(&h, target, &state, &match));
+    TEST_ASSERT_FALSE(match);
+}
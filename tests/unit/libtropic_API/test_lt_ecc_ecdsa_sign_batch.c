@@ -0,0 +1,98 @@
+/**
+ * @file test_lt_ecc_ecdsa_sign_batch.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid parameters
+void test__invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t digests[2 * 32] = {0};
+    uint8_t sigs[2 * 64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_batch(NULL, ECC_SLOT_1, digests, 2, sigs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_batch(&h, ECC_SLOT_31 + 1, digests, 2, sigs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_batch(&h, ECC_SLOT_1, NULL, 2, sigs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_batch(&h, ECC_SLOT_1, digests, 0, sigs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_batch(&h, ECC_SLOT_1, digests, 2, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if EdDSA variant returns LT_PARAM_ERR on invalid message
+void test__eddsa_invalid_msg()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t msg[1] = {0};
+    const uint8_t *msgs[2] = {msg, NULL};
+    uint16_t msg_lens[2] = {sizeof(msg), sizeof(msg)};
+    uint8_t sigs[2 * 64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_eddsa_sign_batch(&h, ECC_SLOT_1, msgs, msg_lens, 2, sigs));
+
+    msgs[1] = msg;
+    msg_lens[1] = LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX + 1;
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_eddsa_sign_batch(&h, ECC_SLOT_1, msgs, msg_lens, 2, sigs));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_HOST_NO_SESSION when session is not established
+void test__no_session()
+{
+    lt_handle_t h = {0};
+    uint8_t digests[2 * 32] = {0};
+    uint8_t sigs[2 * 64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_ecc_ecdsa_sign_batch(&h, ECC_SLOT_1, digests, 2, sigs));
+}
@@ -0,0 +1,124 @@
+/**
+ * @file test_lt_ecc_ecdsa_sign_digest.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid handle
+void test__invalid_handle()
+{
+    uint8_t msg_hash[32] = {0};
+    uint8_t rs[64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_digest(NULL, ECC_SLOT_1, msg_hash, rs));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid slot
+void test__invalid_slot()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t msg_hash[32] = {0};
+    uint8_t rs[64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_digest(&h, ECC_SLOT_31 + 1, msg_hash, rs));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid msg_hash
+void test__invalid_msg_hash()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t rs[64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_digest(&h, ECC_SLOT_1, NULL, rs));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid rs
+void test__invalid_rs()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t msg_hash[32] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_ecdsa_sign_digest(&h, ECC_SLOT_1, msg_hash, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_HOST_NO_SESSION when session is not established
+void test__no_session()
+{
+    lt_handle_t h = {0};
+    uint8_t msg_hash[32] = {0};
+    uint8_t rs[64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_ecc_ecdsa_sign_digest(&h, ECC_SLOT_1, msg_hash, rs));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns error of lt_out__ecc_ecdsa_sign_digest()
+void test__lt_out__ecc_ecdsa_sign_digest_fail()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t msg_hash[32] = {0};
+    uint8_t rs[64] = {0};
+
+    lt_out__ecc_ecdsa_sign_digest_ExpectAndReturn(&h, ECC_SLOT_1, msg_hash, LT_CRYPTO_ERR);
+    TEST_ASSERT_EQUAL(LT_CRYPTO_ERR, lt_ecc_ecdsa_sign_digest(&h, ECC_SLOT_1, msg_hash, rs));
+}
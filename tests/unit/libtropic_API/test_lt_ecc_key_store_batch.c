@@ -0,0 +1,122 @@
+/**
+ * @file test_lt_ecc_key_store_batch.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+/** Fills keys with random private keys for distinct slots */
+static void fill_keys(lt_ecc_key_import_t *keys, int cnt)
+{
+    for (int i = 0; i < cnt; i++) {
+        keys[i].slot = (ecc_slot_t)i;
+        keys[i].curve = (i % 2) ? CURVE_ED25519 : CURVE_P256;
+        for (size_t j = 0; j < sizeof(keys[i].key); j++) {
+            keys[i].key[j] = (uint8_t)(rand() | 1);
+        }
+        keys[i].status = LT_OK;
+    }
+}
+
+/** Checks that private keys of all entries are wiped */
+static void assert_wiped(const lt_ecc_key_import_t *keys, int cnt)
+{
+    const uint8_t zeros[32] = {0};
+    for (int i = 0; i < cnt; i++) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(zeros, keys[i].key, sizeof(zeros));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid parameters and still wipes the keys
+void test__invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    lt_ecc_key_import_t keys[3];
+
+    fill_keys(keys, 3);
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_key_store_batch(NULL, keys, 3));
+    assert_wiped(keys, 3);
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_key_store_batch(&h, NULL, 3));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_key_store_batch(&h, keys, 0));
+
+    fill_keys(keys, 3);
+    keys[1].slot = ECC_SLOT_31 + 1;
+    lt_l3_buff_wipe_Expect(&h.l3);
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_key_store_batch(&h, keys, 3));
+    assert_wiped(keys, 3);
+
+    fill_keys(keys, 3);
+    keys[2].curve = 0;
+    lt_l3_buff_wipe_Expect(&h.l3);
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_key_store_batch(&h, keys, 3));
+
+    // Two keys for one slot
+    fill_keys(keys, 3);
+    keys[2].slot = keys[0].slot;
+    lt_l3_buff_wipe_Expect(&h.l3);
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecc_key_store_batch(&h, keys, 3));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_HOST_NO_SESSION, leaves all keys failed and wipes them when session is not established
+void test__no_session()
+{
+    lt_handle_t h = {0};
+    lt_ecc_key_import_t keys[4];
+    fill_keys(keys, 4);
+
+    lt_l3_buff_wipe_Expect(&h.l3);
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_ecc_key_store_batch(&h, keys, 4));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(LT_FAIL, keys[i].status);
+    }
+    assert_wiped(keys, 4);
+}
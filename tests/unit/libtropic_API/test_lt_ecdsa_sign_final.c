@@ -0,0 +1,108 @@
+/**
+ * @file test_lt_ecdsa_sign_final.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if init and update return LT_PARAM_ERR on invalid context or data
+void test__init_update_invalid_params()
+{
+    lt_ecdsa_sign_ctx_t ctx;
+    uint8_t data[1] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_init(NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_update(NULL, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_update(&ctx, NULL, 1));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid parameters
+void test__invalid_params()
+{
+    lt_handle_t h = {0};
+    lt_ecdsa_sign_ctx_t ctx;
+    uint8_t rs[64] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_final(NULL, &ctx, ECC_SLOT_1, rs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_final(&h, NULL, ECC_SLOT_1, rs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_final(&h, &ctx, ECC_SLOT_31 + 1, rs));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_ecdsa_sign_final(&h, &ctx, ECC_SLOT_1, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if message parts are hashed into the context and the context is wiped at the end
+void test__hash_and_wipe()
+{
+    lt_handle_t h = {0};
+    lt_ecdsa_sign_ctx_t ctx;
+    uint8_t part1[3] = {1, 2, 3};
+    uint8_t part2[5] = {4, 5, 6, 7, 8};
+    uint8_t rs[64] = {0};
+
+    lt_sha256_init_Expect(ctx.sha256);
+    lt_sha256_start_Expect(ctx.sha256);
+    TEST_ASSERT_EQUAL(LT_OK, lt_ecdsa_sign_init(&ctx));
+
+    lt_sha256_update_Expect(ctx.sha256, part1, sizeof(part1));
+    TEST_ASSERT_EQUAL(LT_OK, lt_ecdsa_sign_update(&ctx, part1, sizeof(part1)));
+    lt_sha256_update_Expect(ctx.sha256, part2, sizeof(part2));
+    TEST_ASSERT_EQUAL(LT_OK, lt_ecdsa_sign_update(&ctx, part2, sizeof(part2)));
+
+    memset(&ctx, 0xAA, sizeof(ctx));
+    lt_sha256_finish_ExpectAnyArgs();
+    // Session is not established, so signing itself fails
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_ecdsa_sign_final(&h, &ctx, ECC_SLOT_1, rs));
+
+    for (size_t i = 0; i < sizeof(ctx); i++) {
+        TEST_ASSERT_EQUAL_UINT8(0, ((uint8_t *)&ctx)[i]);
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file test_lt_mcounter_get_all.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid parameters
+void test__invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint32_t values[MCOUNTER_INDEX_15 + 1];
+    lt_ret_t statuses[MCOUNTER_INDEX_15 + 1];
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_get_all(NULL, values, statuses));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_get_all(&h, NULL, statuses));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_get_all(&h, values, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if multi-update returns LT_PARAM_ERR on invalid parameters or invalid index of any counter
+void test__update_multi_invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    enum lt_mcounter_index_t indexes[2] = {MCOUNTER_INDEX_0, MCOUNTER_INDEX_15 + 1};
+    lt_ret_t statuses[2];
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_update_multi(NULL, indexes, 1, statuses));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_update_multi(&h, NULL, 1, statuses));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_update_multi(&h, indexes, 0, statuses));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_update_multi(&h, indexes, 1, NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_mcounter_update_multi(&h, indexes, 2, statuses));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_HOST_NO_SESSION and leaves all counters failed when session is not established
+void test__no_session()
+{
+    lt_handle_t h = {0};
+    uint32_t values[MCOUNTER_INDEX_15 + 1];
+    lt_ret_t statuses[MCOUNTER_INDEX_15 + 1] = {LT_OK};
+    enum lt_mcounter_index_t indexes[1] = {MCOUNTER_INDEX_3};
+
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_mcounter_get_all(&h, values, statuses));
+    for (int i = 0; i <= MCOUNTER_INDEX_15; i++) {
+        TEST_ASSERT_EQUAL(LT_FAIL, statuses[i]);
+    }
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_mcounter_update_multi(&h, indexes, 1, statuses));
+}
@@ -0,0 +1,89 @@
+/**
+ * @file test_lt_random_value_get_large.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "mock_lt_aesgcm.h"
+#include "mock_lt_asn1_der.h"
+#include "mock_lt_ed25519.h"
+#include "mock_lt_hkdf.h"
+#include "mock_lt_l1.h"
+#include "mock_lt_l1_port_wrap.h"
+#include "mock_lt_l2.h"
+#include "mock_lt_l3.h"
+#include "mock_lt_l3_process.h"
+#include "mock_lt_random.h"
+#include "mock_lt_sha256.h"
+#include "mock_lt_x25519.h"
+#include "string.h"
+#include "time.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    char buffer[100] = {0};
+#ifdef RNG_SEED
+    srand(RNG_SEED);
+#else
+    time_t seed = time(NULL);
+    // Using this approach, because in our version of Unity there's no TEST_PRINTF yet.
+    // Also, raw printf is worse solution (without additional debug msgs, such as line).
+    snprintf(buffer, sizeof(buffer), "Using random seed: %ld\n", seed);
+    TEST_MESSAGE(buffer);
+    srand((unsigned int)seed);
+#endif
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_PARAM_ERR on invalid parameters
+void test__invalid_params()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t buff[2 * RANDOM_VALUE_GET_LEN_MAX] = {0};
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_random_value_get_large(NULL, buff, sizeof(buff)));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_random_value_get_large(&h, NULL, sizeof(buff)));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_random_value_get_large(&h, buff, 0));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if function returns LT_HOST_NO_SESSION when session is not established
+void test__no_session()
+{
+    lt_handle_t h = {0};
+    uint8_t buff[2 * RANDOM_VALUE_GET_LEN_MAX] = {0};
+
+    TEST_ASSERT_EQUAL(LT_HOST_NO_SESSION, lt_random_value_get_large(&h, buff, sizeof(buff)));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if the first command requests at most RANDOM_VALUE_GET_LEN_MAX bytes and its failure is returned
+void test__first_cmd_fail()
+{
+    lt_handle_t h = {0};
+    h.l3.session = SESSION_ON;
+    uint8_t buff[2 * RANDOM_VALUE_GET_LEN_MAX] = {0};
+
+    lt_out__random_value_get_ExpectAndReturn(&h, RANDOM_VALUE_GET_LEN_MAX, LT_FAIL);
+
+    TEST_ASSERT_EQUAL(LT_FAIL, lt_random_value_get_large(&h, buff, sizeof(buff)));
+}
@@ -97,5 +97,11 @@ void test__correct()
     TEST_ASSERT_EQUAL_STRING("LT_L2_STATUS_NOT_RECOGNIZED", lt_ret_verbose(LT_L2_STATUS_NOT_RECOGNIZED));
     TEST_ASSERT_EQUAL_STRING("LT_L2_DATA_LEN_ERROR", lt_ret_verbose(LT_L2_DATA_LEN_ERROR));
 
+    TEST_ASSERT_EQUAL_STRING("LT_PENDING", lt_ret_verbose(LT_PENDING));
+    TEST_ASSERT_EQUAL_STRING("LT_NOT_FOUND", lt_ret_verbose(LT_NOT_FOUND));
+    TEST_ASSERT_EQUAL_STRING("LT_BUSY", lt_ret_verbose(LT_BUSY));
+    TEST_ASSERT_EQUAL_STRING("LT_DEADLINE_EXCEEDED", lt_ret_verbose(LT_DEADLINE_EXCEEDED));
+    TEST_ASSERT_EQUAL_STRING("LT_OVERLOAD", lt_ret_verbose(LT_OVERLOAD));
+
     TEST_ASSERT_EQUAL_STRING("FATAL ERROR, unknown return value", lt_ret_verbose(99));
 }
@@ -40,3 +40,113 @@ void tearDown(void) {}
 //---------------------------------------------------------------------------------------------------------//
 //---------------------------------- EXECUTION ------------------------------------------------------------//
 //---------------------------------------------------------------------------------------------------------//
+
+// SEQUENCE { SEQUENCE { OBJECT_IDENTIFIER 2B656E, BIT_STRING 00 + 32B key }, SEQUENCE { 16B of INTEGER } }
+static const uint8_t test_cert[] = {
+    0x30, 0x3c, 0x30, 0x28, 0x06, 0x03, 0x2b, 0x65, 0x6e, 0x03, 0x21, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+    0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+    0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x30, 0x10, 0x02, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+// Test if the object is found in whole certificate by both functions
+void test__find_object_whole()
+{
+    uint8_t key[32];
+
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_find_object(test_cert, sizeof(test_cert), OBJ_ID_CURVEX25519, key,
+                                                 sizeof(key), ASN1DER_CROP_PREFIX));
+    TEST_ASSERT_EQUAL_HEX8(0x01, key[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x20, key[31]);
+
+    memset(key, 0, sizeof(key));
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_find_object_prefix(test_cert, sizeof(test_cert), OBJ_ID_CURVEX25519, key,
+                                                        sizeof(key), ASN1DER_CROP_PREFIX));
+    TEST_ASSERT_EQUAL_HEX8(0x01, key[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x20, key[31]);
+}
+
+// Test if the object is found in beginning of the certificate only by asn1der_find_object_prefix()
+void test__find_object_prefix()
+{
+    uint8_t key[32];
+    // Certificate is cut right after the key
+    const uint16_t len = 12 + 32;
+
+    TEST_ASSERT_EQUAL(LT_CERT_STORE_INVALID,
+                      asn1der_find_object(test_cert, len, OBJ_ID_CURVEX25519, key, sizeof(key), ASN1DER_CROP_PREFIX));
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_find_object_prefix(test_cert, len, OBJ_ID_CURVEX25519, key, sizeof(key),
+                                                        ASN1DER_CROP_PREFIX));
+    TEST_ASSERT_EQUAL_HEX8(0x01, key[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x20, key[31]);
+
+    // Key is not complete yet
+    TEST_ASSERT_EQUAL(LT_CERT_STORE_INVALID, asn1der_find_object_prefix(test_cert, len - 1, OBJ_ID_CURVEX25519, key,
+                                                                        sizeof(key), ASN1DER_CROP_PREFIX));
+}
+
+// Test if several objects are found by one call, with and without copying
+void test__find_objects()
+{
+    uint8_t key[32];
+    uint8_t key_head[4];
+    struct asn1der_request_t reqs[] = {
+        {.obj_id = OBJ_ID_CURVEX25519, .buf = key, .buf_len = sizeof(key), .crop_kind = ASN1DER_CROP_PREFIX},
+        {.obj_id = OBJ_ID_CURVEX25519, .buf = key_head, .buf_len = sizeof(key_head), .crop_kind = ASN1DER_CROP_SUFFIX},
+        {.obj_id = OBJ_ID_CURVEX25519, .buf = NULL, .buf_len = 0},
+    };
+
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_find_objects(test_cert, sizeof(test_cert), reqs, 3));
+    TEST_ASSERT_EQUAL_HEX8(0x01, key[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x20, key[31]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, key_head[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x03, key_head[3]);
+    TEST_ASSERT_EQUAL(11, reqs[2].offset);
+    TEST_ASSERT_EQUAL(33, reqs[2].len);
+    TEST_ASSERT_EQUAL_HEX8(0x01, test_cert[reqs[2].offset + 1]);
+
+    // Missing object does not prevent the others from being found
+    reqs[1].obj_id = 0x2B6570;
+    TEST_ASSERT_EQUAL(LT_CERT_ITEM_NOT_FOUND, asn1der_find_objects(test_cert, sizeof(test_cert), reqs, 3));
+    TEST_ASSERT_EQUAL(0, reqs[1].len);
+    TEST_ASSERT_EQUAL(33, reqs[2].len);
+
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, asn1der_find_objects(test_cert, sizeof(test_cert), reqs, 0));
+}
+
+// Test if push-style parser finds the same objects when the stream is fed one byte at a time
+void test__stream_feed()
+{
+    uint8_t key[32];
+    struct asn1der_request_t reqs[] = {
+        {.obj_id = OBJ_ID_CURVEX25519, .buf = key, .buf_len = sizeof(key), .crop_kind = ASN1DER_CROP_PREFIX},
+        {.obj_id = 0x2B6570, .buf = NULL, .buf_len = 0},
+    };
+    struct asn1der_stream_t s;
+
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_stream_init(&s, reqs, 1));
+    for (uint16_t i = 0; i < 12 + 32; i++) {
+        TEST_ASSERT_FALSE(asn1der_stream_all_found(&s));
+        TEST_ASSERT_EQUAL(LT_OK, asn1der_stream_feed(&s, &test_cert[i], 1));
+    }
+    TEST_ASSERT_TRUE(asn1der_stream_all_found(&s));
+    TEST_ASSERT_FALSE(asn1der_stream_complete(&s));
+    TEST_ASSERT_EQUAL_HEX8(0x01, key[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x20, key[31]);
+    TEST_ASSERT_EQUAL(11, reqs[0].offset);
+    TEST_ASSERT_EQUAL(33, reqs[0].len);
+
+    // Missing object, whole stream is parsed
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_stream_init(&s, reqs, 2));
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_stream_feed(&s, test_cert, sizeof(test_cert)));
+    TEST_ASSERT_FALSE(asn1der_stream_all_found(&s));
+    TEST_ASSERT_TRUE(asn1der_stream_complete(&s));
+    TEST_ASSERT_EQUAL(33, reqs[0].len);
+    TEST_ASSERT_EQUAL(0, reqs[1].len);
+
+    // Length of the inner SEQUENCE exceeds the outer one
+    uint8_t bad[sizeof(test_cert)];
+    memcpy(bad, test_cert, sizeof(bad));
+    bad[3] = 0x3c;
+    TEST_ASSERT_EQUAL(LT_OK, asn1der_stream_init(&s, reqs, 1));
+    TEST_ASSERT_EQUAL(LT_CERT_STORE_INVALID, asn1der_stream_feed(&s, bad, sizeof(bad)));
+}
@@ -31,12 +31,31 @@ void test_crc16___correct()
 
 //---------------------------------------------------------------------------------------------------------//
 
+// Test if crc calculated in parts equals crc over the whole buffer
+void test_crc16_update___parts()
+{
+    uint8_t data[37];
+    for (uint8_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    for (uint8_t split = 0; split <= sizeof(data); split++) {
+        uint16_t crc = crc16_init();
+        crc = crc16_update(crc, data, split);
+        crc = crc16_update(crc, data + split, sizeof(data) - split);
+        TEST_ASSERT_EQUAL_HEX16(crc16(data, sizeof(data)), crc16_final(crc));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
 // Prepare (uint8_t*)req as this {0x01, 0x02, 0x01, 0x01, 0x00, 0x00};
 // And test if function fills crc bytes instead of last two null bytes
 void test_add_crc___correct()
 {
+    lt_l2_state_t s2 = {0};
     uint8_t req[] = {0x01, 0x02, 0x01, 0x01, 0x00, 0x00};
-    add_crc(&req);
+    add_crc(&s2, &req);
 
     uint8_t expected[] = {0x01, 0x02, 0x01, 0x01, 0x2e, 0x12};
     TEST_ASSERT_EQUAL_INT8_ARRAY(expected, (uint8_t *)&req, 6);
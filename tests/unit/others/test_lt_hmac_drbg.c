@@ -0,0 +1,74 @@
+/**
+ * @file test_lt_hmac_drbg.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "lt_hmac_drbg.h"
+#include "unity.h"
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test against NIST CAVP HMAC_DRBG SHA-256 vector (no prediction resistance, no additional input, COUNT = 0),
+// the first generated block is discarded as in the vector
+void test_hmac_drbg___cavp_vector()
+{
+    const uint8_t seed[48] = {
+        0xca, 0x85, 0x19, 0x11, 0x34, 0x93, 0x84, 0xbf, 0xfe, 0x89, 0xde, 0x1c,
+        0xbd, 0xc4, 0x6e, 0x68, 0x31, 0xe4, 0x4d, 0x34, 0xa4, 0xfb, 0x93, 0x5e,
+        0xe2, 0x85, 0xdd, 0x14, 0xb7, 0x1a, 0x74, 0x88, 0x65, 0x9b, 0xa9, 0x6c,
+        0x60, 0x1d, 0xc6, 0x9f, 0xc9, 0x02, 0x94, 0x08, 0x05, 0xec, 0x0c, 0xa8,
+    };
+    const uint8_t expected[128] = {
+        0xe5, 0x28, 0xe9, 0xab, 0xf2, 0xde, 0xce, 0x54, 0xd4, 0x7c, 0x7e, 0x75,
+        0xe5, 0xfe, 0x30, 0x21, 0x49, 0xf8, 0x17, 0xea, 0x9f, 0xb4, 0xbe, 0xe6,
+        0xf4, 0x19, 0x96, 0x97, 0xd0, 0x4d, 0x5b, 0x89, 0xd5, 0x4f, 0xbb, 0x97,
+        0x8a, 0x15, 0xb5, 0xc4, 0x43, 0xc9, 0xec, 0x21, 0x03, 0x6d, 0x24, 0x60,
+        0xb6, 0xf7, 0x3e, 0xba, 0xd0, 0xdc, 0x2a, 0xba, 0x6e, 0x62, 0x4a, 0xbf,
+        0x07, 0x74, 0x5b, 0xc1, 0x07, 0x69, 0x4b, 0xb7, 0x54, 0x7b, 0xb0, 0x99,
+        0x5f, 0x70, 0xde, 0x25, 0xd6, 0xb2, 0x9e, 0x2d, 0x30, 0x11, 0xbb, 0x19,
+        0xd2, 0x76, 0x76, 0xc0, 0x71, 0x62, 0xc8, 0xb5, 0xcc, 0xde, 0x06, 0x68,
+        0x96, 0x1d, 0xf8, 0x68, 0x03, 0x48, 0x2c, 0xb3, 0x7e, 0xd6, 0xd5, 0xc0,
+        0xbb, 0x8d, 0x50, 0xcf, 0x1f, 0x50, 0xd4, 0x76, 0xaa, 0x04, 0x58, 0xbd,
+        0xab, 0xa8, 0x06, 0xf4, 0x8b, 0xe9, 0xdc, 0xb8,
+    };
+    uint8_t out[128];
+    lt_drbg_t drbg;
+
+    lt_hmac_drbg_instantiate(&drbg, seed, sizeof(seed));
+    lt_hmac_drbg_generate(&drbg, out, sizeof(out));
+    lt_hmac_drbg_generate(&drbg, out, sizeof(out));
+
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, sizeof(out));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if outputs shorter than one block are prefixes of what a full block request returns
+void test_hmac_drbg___partial_block()
+{
+    const uint8_t seed[32] = {0};
+    uint8_t full[32], part[7];
+    lt_drbg_t a, b;
+
+    lt_hmac_drbg_instantiate(&a, seed, sizeof(seed));
+    lt_hmac_drbg_instantiate(&b, seed, sizeof(seed));
+    lt_hmac_drbg_generate(&a, full, sizeof(full));
+    lt_hmac_drbg_generate(&b, part, sizeof(part));
+
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(full, part, sizeof(part));
+}
@@ -0,0 +1,119 @@
+/**
+ * @file test_lt_log.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "unity.h"
+
+static lt_log_t test_log;
+static lt_log_entry_t test_entries[4];
+
+static char test_msgs[8][LT_LOG_MSG_SIZE];
+static lt_log_level_t test_levels[8];
+static int test_sink_cnt;
+
+static void test_sink(void *ctx, const lt_log_level_t level, const uint16_t line, const char *msg)
+{
+    (void)ctx;
+    (void)line;
+    test_levels[test_sink_cnt] = level;
+    strcpy(test_msgs[test_sink_cnt], msg);
+    test_sink_cnt++;
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    memset(&test_log, 0, sizeof(test_log));
+    test_sink_cnt = 0;
+    TEST_ASSERT_EQUAL(LT_OK, lt_log_init(&test_log, test_entries, 4, test_sink, NULL));
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if number of entries which is not a power of two is refused
+void test_lt_log_init___invalid_cnt()
+{
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_log_init(&test_log, test_entries, 3, test_sink, NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_log_init(&test_log, test_entries, 0, test_sink, NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_log_init(&test_log, NULL, 4, test_sink, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if message is formatted only by lt_log_flush(), with strings copied when it was logged
+void test_lt_log___deferred_format()
+{
+    char name[8] = "spi0";
+    uint64_t big = 0x123456789ULL;
+
+    LT_LOG_DEFER(LT_LOG_LEVEL_ERROR, LT_LOG_LEVEL_DEFAULT, "%s: %d %*u 0x%04x %.2f %llu%%", name, -5, 3, 7u,
+                 0xabu, 1.5, (unsigned long long)big);
+    name[0] = 'X';
+    TEST_ASSERT_EQUAL(0, test_sink_cnt);
+
+    TEST_ASSERT_EQUAL(1, lt_log_flush(&test_log, 8));
+    TEST_ASSERT_EQUAL(1, test_sink_cnt);
+    TEST_ASSERT_EQUAL(LT_LOG_LEVEL_ERROR, test_levels[0]);
+    TEST_ASSERT_EQUAL_STRING("spi0: -5   7 0x00ab 1.50 4886718345%", test_msgs[0]);
+    TEST_ASSERT_EQUAL(0, lt_log_flush(&test_log, 8));
+}
+
+// Test if messages logged into a full ring are dropped and reported by the next flush
+void test_lt_log___dropped()
+{
+    for (int i = 0; i < 6; i++) {
+        LT_LOG_DEFER(LT_LOG_LEVEL_INFO, LT_LOG_LEVEL_DEFAULT, "msg %d", i);
+    }
+    TEST_ASSERT_EQUAL(2, test_log.dropped);
+
+    TEST_ASSERT_EQUAL(4, lt_log_flush(&test_log, 8));
+    TEST_ASSERT_EQUAL(5, test_sink_cnt);
+    TEST_ASSERT_EQUAL(LT_LOG_LEVEL_WARN, test_levels[0]);
+    TEST_ASSERT_EQUAL_STRING("2 log messages dropped", test_msgs[0]);
+    TEST_ASSERT_EQUAL_STRING("msg 0", test_msgs[1]);
+    TEST_ASSERT_EQUAL_STRING("msg 3", test_msgs[4]);
+
+    // Slots are reused after the flush
+    LT_LOG_DEFER(LT_LOG_LEVEL_INFO, LT_LOG_LEVEL_DEFAULT, "again");
+    TEST_ASSERT_EQUAL(1, lt_log_flush(&test_log, 8));
+    TEST_ASSERT_EQUAL_STRING("again", test_msgs[5]);
+}
+
+// Test if threshold of handle overrides the global one
+void test_lt_log___handle_threshold()
+{
+    lt_l2_state_t s2 = {0};
+
+    test_log.level = LT_LOG_LEVEL_WARN;
+    TEST_ASSERT_TRUE(lt_log_enabled(LT_LOG_LEVEL_ERROR, s2.log_level));
+    TEST_ASSERT_FALSE(lt_log_enabled(LT_LOG_LEVEL_DEBUG, s2.log_level));
+
+    s2.log_level = LT_LOG_LEVEL_DEBUG;
+    TEST_ASSERT_TRUE(lt_log_enabled(LT_LOG_LEVEL_DEBUG, s2.log_level));
+
+    s2.log_level = LT_LOG_LEVEL_OFF;
+    TEST_ASSERT_FALSE(lt_log_enabled(LT_LOG_LEVEL_ERROR, s2.log_level));
+
+    // Filtered message does not take a slot and its arguments are not evaluated
+    int evaluated = 0;
+    LT_LOG_DEFER(LT_LOG_LEVEL_ERROR, s2.log_level, "%d", ++evaluated);
+    TEST_ASSERT_EQUAL(0, evaluated);
+    TEST_ASSERT_EQUAL(0, lt_log_flush(&test_log, 8));
+}
@@ -0,0 +1,88 @@
+/**
+ * @file test_lt_record.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_record.h"
+#include "unity.h"
+
+static lt_l2_state_t test_s2;
+static lt_record_t test_record;
+
+static uint8_t test_out[256];
+static uint16_t test_out_len;
+
+static void test_write(void *ctx, const uint8_t *data, const uint16_t len)
+{
+    (void)ctx;
+    memcpy(test_out + test_out_len, data, len);
+    test_out_len += len;
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    memset(&test_s2, 0, sizeof(test_s2));
+    memset(&test_record, 0, sizeof(test_record));
+    test_s2.record = &test_record;
+    test_out_len = 0;
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if recording without write function is refused
+void test_lt_record_start___invalid_write()
+{
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_record_start(&test_record, NULL, NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_record_start(NULL, test_write, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if records have operation, status and, for operations with data, length and the data
+void test_lt_record___format()
+{
+    const uint8_t miso[] = {0x01, 0x02, 0x03};
+
+    // Not started recording writes nothing
+    lt_record_op(&test_s2, LT_RECORD_OP_CSN_LOW, LT_OK, NULL, 0);
+    TEST_ASSERT_EQUAL(0, test_out_len);
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_record_start(&test_record, test_write, NULL));
+    lt_record_op(&test_s2, LT_RECORD_OP_CSN_LOW, LT_OK, NULL, 0);
+    lt_record_op(&test_s2, LT_RECORD_OP_TRANSFER, LT_FAIL, miso, sizeof(miso));
+
+    TEST_ASSERT_EQUAL(LT_RECORD_HEADER_SIZE + 2 + 4 + sizeof(miso), test_out_len);
+    TEST_ASSERT_EQUAL(test_out_len, test_record.size);
+    TEST_ASSERT_EQUAL_MEMORY(LT_RECORD_MAGIC, test_out, 4);
+    TEST_ASSERT_EQUAL(LT_RECORD_VERSION, test_out[4]);
+
+    const uint8_t *r = test_out + LT_RECORD_HEADER_SIZE;
+    TEST_ASSERT_EQUAL(LT_RECORD_OP_CSN_LOW, r[0]);
+    TEST_ASSERT_EQUAL(LT_OK, r[1]);
+    TEST_ASSERT_EQUAL(LT_RECORD_OP_TRANSFER, r[2]);
+    TEST_ASSERT_EQUAL(LT_FAIL, r[3]);
+    TEST_ASSERT_EQUAL(sizeof(miso), r[4]);
+    TEST_ASSERT_EQUAL(0, r[5]);
+    TEST_ASSERT_EQUAL_MEMORY(miso, r + 6, sizeof(miso));
+
+    // Disabled recording writes nothing
+    test_record.enabled = 0;
+    lt_record_op(&test_s2, LT_RECORD_OP_CSN_HIGH, LT_OK, NULL, 0);
+    TEST_ASSERT_EQUAL(LT_RECORD_HEADER_SIZE + 2 + 4 + sizeof(miso), test_out_len);
+}
@@ -0,0 +1,227 @@
+/**
+ * @file test_lt_rmem_kv.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "libtropic_rmem_kv.h"
+#include "mock_libtropic.h"
+#include "unity.h"
+
+TEST_FILE("lt_rmem_kv.c")
+
+/** Range of the store */
+#define KV_FIRST_SLOT 100
+#define KV_SLOTS_CNT 12
+
+/** R-memory of the tested chip, size 0 is an empty slot */
+static uint8_t r_mem[R_MEM_DATA_SLOT_MAX + 1][R_MEM_DATA_SIZE_MAX];
+static uint16_t r_mem_size[R_MEM_DATA_SLOT_MAX + 1];
+/** Number of writes and erases executed before the chip is reset, negative for no reset */
+static int ops_left;
+/** Number of writes and erases executed */
+static int ops_cnt;
+
+static bool callback__reset(void)
+{
+    ops_cnt++;
+    if (ops_left == 0) {
+        return true;
+    }
+    if (ops_left > 0) {
+        ops_left--;
+    }
+
+    return false;
+}
+
+static lt_ret_t callback__lt_r_mem_data_write(lt_handle_t *h, const uint16_t udata_slot, const uint8_t *data,
+                                              const uint16_t size, int __attribute__((unused)) cmock_num_calls)
+{
+    (void)h;
+    if (callback__reset()) {
+        return LT_L1_SPI_ERROR;
+    }
+    // TROPIC01 does not overwrite a slot
+    if (r_mem_size[udata_slot]) {
+        return LT_L3_R_MEM_DATA_WRITE_WRITE_FAIL;
+    }
+    memcpy(r_mem[udata_slot], data, size);
+    r_mem_size[udata_slot] = size;
+
+    return LT_OK;
+}
+
+static lt_ret_t callback__lt_r_mem_data_read(lt_handle_t *h, const uint16_t udata_slot, uint8_t *data, uint16_t *size,
+                                             int __attribute__((unused)) cmock_num_calls)
+{
+    (void)h;
+    if (!r_mem_size[udata_slot]) {
+        *size = 0;
+        return LT_L3_R_MEM_DATA_READ_SLOT_EMPTY;
+    }
+    memcpy(data, r_mem[udata_slot], r_mem_size[udata_slot]);
+    *size = r_mem_size[udata_slot];
+
+    return LT_OK;
+}
+
+static lt_ret_t callback__lt_r_mem_data_erase(lt_handle_t *h, const uint16_t udata_slot,
+                                              int __attribute__((unused)) cmock_num_calls)
+{
+    (void)h;
+    if (callback__reset()) {
+        return LT_L1_SPI_ERROR;
+    }
+    r_mem_size[udata_slot] = 0;
+
+    return LT_OK;
+}
+
+/** Fills data with a pattern given by seed */
+static void fill(uint8_t *data, uint16_t len, uint8_t seed)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(seed + (i * 7));
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    memset(r_mem_size, 0, sizeof(r_mem_size));
+    ops_left = -1;
+    ops_cnt = 0;
+    lt_r_mem_data_write_StubWithCallback(callback__lt_r_mem_data_write);
+    lt_r_mem_data_read_StubWithCallback(callback__lt_r_mem_data_read);
+    lt_r_mem_data_erase_StubWithCallback(callback__lt_r_mem_data_erase);
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if objects are created, replaced, read and deleted, before and after remount
+void test_rmem_kv___put_get_delete()
+{
+    lt_handle_t h = {0};
+    lt_rmem_kv_t kv;
+    uint8_t data[900], out[900];
+    uint16_t len;
+
+    fill(data, sizeof(data), 1);
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_format(&h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_NOT_FOUND, lt_rmem_kv_get(&kv, "cfg", out, sizeof(out), &len));
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_put(&kv, "cfg", (const uint8_t *)"hello", 5));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_put(&kv, "big", data, sizeof(data)));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_put(&kv, "cfg", (const uint8_t *)"world!", 6));
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "cfg", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL(6, len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY("world!", out, len);
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "big", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL(sizeof(data), len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, out, len);
+
+    // Remount rebuilds the index from the objects, after sync it reads only the index slot
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "cfg", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY("world!", out, len);
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_sync(&kv));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "big", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, out, len);
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_delete(&kv, "big"));
+    TEST_ASSERT_EQUAL(LT_NOT_FOUND, lt_rmem_kv_get(&kv, "big", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL(LT_NOT_FOUND, lt_rmem_kv_delete(&kv, "big"));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_NOT_FOUND, lt_rmem_kv_get(&kv, "big", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "cfg", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY("world!", out, len);
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if a name with the same hash as a stored object's name is not mistaken for it
+void test_rmem_kv___hash_collision()
+{
+    lt_handle_t h = {0};
+    lt_rmem_kv_t kv;
+    uint8_t out[16];
+    uint16_t len;
+
+    // Both names have FNV-1a hash 0x5564f986
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_format(&h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_put(&kv, "key583084", (const uint8_t *)"first", 5));
+
+    TEST_ASSERT_EQUAL(LT_FAIL, lt_rmem_kv_put(&kv, "key1092000", (const uint8_t *)"second", 6));
+    TEST_ASSERT_EQUAL(LT_NOT_FOUND, lt_rmem_kv_get(&kv, "key1092000", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL(LT_NOT_FOUND, lt_rmem_kv_delete(&kv, "key1092000"));
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "key583084", out, sizeof(out), &len));
+    TEST_ASSERT_EQUAL(5, len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY("first", out, len);
+}
+
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if remount after a replace interrupted at any write or erase finds either the old or the new content, complete
+void test_rmem_kv___interrupted_replace()
+{
+    lt_handle_t h = {0};
+    lt_rmem_kv_t kv;
+    uint8_t old_data[900], new_data[900], out[900];
+    uint16_t len;
+    int replace_ops = 0;
+
+    fill(old_data, sizeof(old_data), 1);
+    fill(new_data, sizeof(new_data), 2);
+
+    for (int reset_at = 0;; reset_at++) {
+        memset(r_mem_size, 0, sizeof(r_mem_size));
+        ops_left = -1;
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_format(&h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_put(&kv, "cfg", old_data, sizeof(old_data)));
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_sync(&kv));
+
+        ops_cnt = 0;
+        ops_left = reset_at;
+        lt_ret_t ret = lt_rmem_kv_put(&kv, "cfg", new_data, sizeof(new_data));
+        if (ret == LT_OK) {
+            replace_ops = ops_cnt;
+            break;
+        }
+        TEST_ASSERT_EQUAL(LT_L1_SPI_ERROR, ret);
+
+        ops_left = -1;
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "cfg", out, sizeof(out), &len));
+        TEST_ASSERT_EQUAL(sizeof(old_data), len);
+        if (memcmp(out, old_data, len)) {
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(new_data, out, len);
+        }
+
+        // Store stays usable, slots of the lost content are reused
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_put(&kv, "cfg", new_data, sizeof(new_data)));
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_mount(&kv, &h, KV_FIRST_SLOT, KV_SLOTS_CNT));
+        TEST_ASSERT_EQUAL(LT_OK, lt_rmem_kv_get(&kv, "cfg", out, sizeof(out), &len));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(new_data, out, len);
+    }
+
+    // Index erase, three writes of the new content and three erases of the old one
+    TEST_ASSERT_EQUAL(7, replace_ops);
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_lt_stats.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <string.h>
+
+#include "libtropic_common.h"
+#include "lt_stats.h"
+#include "unity.h"
+
+static uint32_t test_now_us;
+
+static uint32_t test_time_us(void) { return test_now_us; }
+
+static lt_l2_state_t test_s2;
+static lt_stats_t test_stats;
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    memset(&test_s2, 0, sizeof(test_s2));
+    memset(&test_stats, 0, sizeof(test_stats));
+    test_stats.time_us = test_time_us;
+    test_s2.stats = &test_stats;
+    test_now_us = 0;
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if events are accounted to the entry of the request being processed
+void test_lt_stats___accounting()
+{
+    lt_stats_begin(&test_s2, LT_STATS_KEY_L2(0x01));
+    lt_stats_bytes(&test_s2, 10);
+    test_now_us = 100;
+    lt_stats_time(&test_s2, LT_STATS_TRANSFER, 40);
+
+    lt_stats_begin(&test_s2, LT_STATS_KEY_L3(0x01));
+    lt_stats_crc_error(&test_s2);
+    lt_stats_resend(&test_s2);
+
+    lt_stats_begin(&test_s2, LT_STATS_KEY_L2(0x01));
+    test_now_us = 300;
+    lt_stats_time(&test_s2, LT_STATS_TRANSFER, 280);
+
+    TEST_ASSERT_EQUAL(LT_STATS_KEY_L2(0x01), test_stats.entries[0].key);
+    TEST_ASSERT_EQUAL(2, test_stats.entries[0].cnt);
+    TEST_ASSERT_EQUAL(10, test_stats.entries[0].bytes);
+    TEST_ASSERT_EQUAL(80, test_stats.entries[0].time[LT_STATS_TRANSFER].total_us);
+    TEST_ASSERT_EQUAL(60, test_stats.entries[0].time[LT_STATS_TRANSFER].max_us);
+    TEST_ASSERT_EQUAL(0, test_stats.entries[0].crc_errors);
+
+    TEST_ASSERT_EQUAL(LT_STATS_KEY_L3(0x01), test_stats.entries[1].key);
+    TEST_ASSERT_EQUAL(1, test_stats.entries[1].cnt);
+    TEST_ASSERT_EQUAL(1, test_stats.entries[1].crc_errors);
+    TEST_ASSERT_EQUAL(1, test_stats.entries[1].resends);
+}
+
+// Test if requests are dropped when all entries are used, and nothing is measured without clock
+void test_lt_stats___full_and_no_clock()
+{
+    test_stats.time_us = NULL;
+    for (uint16_t i = 1; i <= LT_STATS_CNT + 1; i++) {
+        lt_stats_begin(&test_s2, LT_STATS_KEY_L2(i));
+    }
+    TEST_ASSERT_EQUAL(1, test_stats.dropped);
+
+    // Events of dropped request are not accounted anywhere
+    lt_stats_bytes(&test_s2, 10);
+    lt_stats_time(&test_s2, LT_STATS_POLL, lt_stats_clock(&test_s2));
+    for (uint16_t i = 0; i < LT_STATS_CNT; i++) {
+        TEST_ASSERT_EQUAL(0, test_stats.entries[i].bytes);
+    }
+
+    lt_stats_begin(&test_s2, LT_STATS_KEY_L2(1));
+    lt_stats_time(&test_s2, LT_STATS_POLL, lt_stats_clock(&test_s2));
+    TEST_ASSERT_EQUAL(0, test_stats.entries[0].time[LT_STATS_POLL].total_us);
+    TEST_ASSERT_EQUAL(2, test_stats.entries[0].cnt);
+}
+
+// Test if nothing is done when the statistics are not supplied
+void test_lt_stats___disabled()
+{
+    test_s2.stats = NULL;
+
+    lt_stats_begin(&test_s2, LT_STATS_KEY_L2(0x01));
+    lt_stats_bytes(&test_s2, 10);
+    lt_stats_crc_error(&test_s2);
+    TEST_ASSERT_EQUAL(0, lt_stats_clock(&test_s2));
+    TEST_ASSERT_EQUAL(0, test_stats.entries[0].cnt);
+}
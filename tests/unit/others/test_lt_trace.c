@@ -0,0 +1,94 @@
+/**
+ * @file test_lt_trace.c
+ * @author Tropic Square s.r.o.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <string.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_trace.h"
+#include "unity.h"
+
+static uint32_t test_now_us;
+
+static uint32_t test_time_us(void) { return test_now_us; }
+
+static lt_l2_state_t test_s2;
+static lt_trace_t test_trace;
+static lt_trace_event_t test_events[4];
+
+static uint8_t test_dump[256];
+static uint16_t test_dump_len;
+
+static lt_ret_t test_write(void *ctx, const uint8_t *data, const uint16_t len)
+{
+    (void)ctx;
+    memcpy(test_dump + test_dump_len, data, len);
+    test_dump_len += len;
+
+    return LT_OK;
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- SETUP AND TEARDOWN ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+void setUp(void)
+{
+    memset(&test_s2, 0, sizeof(test_s2));
+    test_s2.trace = &test_trace;
+    test_now_us = 0;
+    test_dump_len = 0;
+}
+
+void tearDown(void) {}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- INPUT PARAMETERS   ---------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if number of events which is not a power of two is refused
+void test_lt_trace_init___invalid_cnt()
+{
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_trace_init(&test_trace, test_events, 3, NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_trace_init(&test_trace, test_events, 0, NULL));
+    TEST_ASSERT_EQUAL(LT_PARAM_ERR, lt_trace_init(&test_trace, NULL, 4, NULL));
+}
+
+//---------------------------------------------------------------------------------------------------------//
+//---------------------------------- EXECUTION ------------------------------------------------------------//
+//---------------------------------------------------------------------------------------------------------//
+
+// Test if the oldest events are overwritten and dumped in order
+void test_lt_trace___ring()
+{
+    const uint8_t data[] = {0x11, 0x22, 0x33};
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_trace_init(&test_trace, test_events, 4, test_time_us));
+    for (uint8_t i = 0; i < 6; i++) {
+        test_now_us = 100 * i;
+        lt_trace_record(&test_s2, LT_TRACE_TX, i, 4 + sizeof(data), data, sizeof(data));
+    }
+
+    // Disabled ring records nothing
+    test_trace.enabled = 0;
+    lt_trace_record(&test_s2, LT_TRACE_RX, 0xff, 5, data, 0);
+
+    TEST_ASSERT_EQUAL(LT_OK, lt_trace_dump(&test_trace, test_write, NULL));
+    TEST_ASSERT_EQUAL(16 + 4 * (8 + LT_TRACE_PAYLOAD_SIZE), test_dump_len);
+    TEST_ASSERT_EQUAL_MEMORY("LTTR", test_dump, 4);
+    // Four events dumped, two overwritten
+    TEST_ASSERT_EQUAL(4, test_dump[8]);
+    TEST_ASSERT_EQUAL(2, test_dump[12]);
+
+    // The oldest kept event is the third one
+    const uint8_t *e = test_dump + 16;
+    TEST_ASSERT_EQUAL(200 & 0xff, e[0]);
+    TEST_ASSERT_EQUAL(7, e[4]);
+    TEST_ASSERT_EQUAL(LT_TRACE_TX, e[6]);
+    TEST_ASSERT_EQUAL(2, e[7]);
+    TEST_ASSERT_EQUAL_MEMORY(data, e + 8, sizeof(data));
+}
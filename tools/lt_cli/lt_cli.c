@@ -0,0 +1,920 @@
+/**
+ * @file lt_cli.c
+ * @author Tropic Square s.r.o.
+ * @brief Command line tool signing files, verifying signatures, reading random values, R-Memory slots, the inventory
+ * of ECC key slots and firmware versions of TROPIC01.
+ *
+ * All L3 operations are built as plaintext commands, which are executed either by `lt_raw_cmd()` on the chip given
+ * by -c, or by tropicd given by -s. With tropicd, each invocation reuses the secure session held by the daemon and
+ * costs only the round trips of its requests. With -c, the certificate store of each chip is kept in the cache
+ * directory given by -C after the first invocation, so the following ones only read CHIP_ID before the handshake.
+ * When libtropic is built with LT_TUNE_PERSIST, tuning profiles of the handle are kept in the same directory.
+ *
+ * Files to be signed by ECDSA are mapped and hashed by `lt_sha256_multi()` in groups of TROPICD_BATCH_MAX, each
+ * group is signed by one batch of commands. Standard input is hashed as it is read, so inputs of any size are
+ * streamed.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "lt_sha256.h"
+#include "lt_sha256_multi.h"
+#include "tropicd_client.h"
+
+#if LT_CLI_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t lt_cli_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t lt_cli_dev_t;
+#endif
+#if LT_TUNE_PERSIST
+#include "libtropic_port_unix_tune.h"
+#endif
+
+#if !LT_RAW_CMD
+#error "lt_cli needs libtropic built with LT_RAW_CMD"
+#endif
+
+/** SPI speed used unless set by -f */
+#define LT_CLI_SPI_SPEED_DEFAULT 5000000
+/** Number of ECC key slots */
+#define LT_CLI_ECC_SLOTS_CNT (ECC_SLOT_31 + 1)
+/** Bytes of standard input hashed at once */
+#define LT_CLI_STREAM_CHUNK 65536
+
+/** Plaintext of L3 structure `p` from its field `field` */
+#define LT_CLI_PLAIN(p, field) ((uint8_t *)(p) + offsetof(__typeof__(*(p)), field))
+/** Maximal plaintext length of L3 structure `p`, from its field `field` up to its tag */
+#define LT_CLI_PLAIN_MAX(p, field) ((uint16_t)(offsetof(__typeof__(*(p)), tag) - offsetof(__typeof__(*(p)), field)))
+
+/** Chip with its handle, used without -s */
+typedef struct lt_cli_chip_t {
+    lt_handle_t h;
+    lt_cli_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+    /** Nonzero after lt_init() */
+    uint8_t inited;
+    /** Nonzero when the secure session is established */
+    uint8_t session;
+} lt_cli_chip_t;
+
+/** Input file, mapped or read from standard input */
+typedef struct lt_cli_input_t {
+    const uint8_t *data;
+    size_t len;
+    /** Mapping to be unmapped, NULL when `data` is allocated or empty */
+    void *map;
+} lt_cli_input_t;
+
+/** Command of a batch with space for its plaintext and result */
+typedef struct lt_cli_cmd_t {
+    union {
+        struct lt_l3_ecdsa_sign_cmd_t ecdsa;
+        struct lt_l3_eddsa_sign_cmd_t eddsa;
+        struct lt_l3_ecc_key_read_cmd_t key_read;
+        struct lt_l3_random_value_get_cmd_t random;
+        struct lt_l3_r_mem_data_read_cmd_t rmem_read;
+        struct lt_l3_r_mem_data_write_cmd_t rmem_write;
+        struct lt_l3_r_mem_data_erase_cmd_t rmem_erase;
+    } cmd;
+    union {
+        struct lt_l3_ecdsa_sign_res_t ecdsa;
+        struct lt_l3_eddsa_sign_res_t eddsa;
+        struct lt_l3_ecc_key_read_res_t key_read;
+        struct lt_l3_random_value_get_res_t random;
+        struct lt_l3_r_mem_data_read_res_t rmem_read;
+        struct lt_l3_r_mem_data_write_res_t rmem_write;
+        struct lt_l3_r_mem_data_erase_res_t rmem_erase;
+    } res;
+} lt_cli_cmd_t;
+
+static lt_cli_chip_t lt_cli_chip;
+static const char *lt_cli_chip_spec;
+static tropicd_conn_t lt_cli_conn;
+static const char *lt_cli_socket;
+/** Chip of the daemon, TROPICD_CHIP_ANY unless set by -i */
+static uint8_t lt_cli_daemon_chip = TROPICD_CHIP_ANY;
+static const char *lt_cli_cache_dir;
+static uint8_t lt_cli_shipriv[32];
+static uint8_t lt_cli_shipub[32];
+static pkey_index_t lt_cli_pkey_index;
+static uint8_t lt_cli_keys_set;
+static lt_cli_cmd_t lt_cli_cmds[TROPICD_BATCH_MAX];
+static tropicd_cmd_t lt_cli_batch_cmds[TROPICD_BATCH_MAX];
+#if LT_TUNE_PERSIST
+static lt_tune_store_t lt_cli_tune_store = {.load = lt_unix_tune_load, .save = lt_unix_tune_save};
+#endif
+
+static void lt_cli_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s (-c CHIP -k SLOT:SHIPRIV:SHIPUB [-f HZ] [-C DIR] | -s SOCKET [-i INDEX]) COMMAND\n"
+            "  -c CHIP                 chip, "
+#if LT_CLI_PORT_SPI
+            "SPIDEV:GPIOCHIP:CS_PIN or SPIDEV:hw for native chip select\n"
+#else
+            "HOST:PORT of the model server\n"
+#endif
+            "  -k SLOT:SHIPRIV:SHIPUB  pairing key slot and files with raw 32 B keys of the secure session\n"
+            "  -f HZ                   SPI speed, %d by default\n"
+            "  -C DIR                  cache of certificate stores"
+#if LT_TUNE_PERSIST
+            " and tuning profiles"
+#endif
+            "\n"
+            "  -s SOCKET               execute commands by tropicd listening on SOCKET instead of -c\n"
+            "  -i INDEX                chip of tropicd, any by default\n"
+            "Commands:\n"
+            "  sign ecdsa|eddsa SLOT FILE...   print signature of each FILE, - is stdin\n"
+            "  verify SLOT SIGNATURE FILE      check signature of FILE by the key in SLOT\n"
+            "  random COUNT                    print COUNT random bytes\n"
+            "  rmem get SLOT                   write data of R-Memory slot to stdout\n"
+            "  rmem put SLOT FILE              replace data of R-Memory slot by FILE\n"
+            "  inventory                       print curve, origin and public key of each ECC key slot\n"
+            "  fw info                         print firmware versions, needs -c\n",
+            prog, LT_CLI_SPI_SPEED_DEFAULT);
+}
+
+/** Reads file of exactly `size` bytes */
+static int lt_cli_key_read(const char *path, uint8_t *buf, const size_t size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    size_t len = fread(buf, 1, size, f);
+    int extra = fgetc(f);
+    fclose(f);
+    if ((len != size) || (extra != EOF)) {
+        fprintf(stderr, "%s does not contain exactly %zu bytes\n", path, size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/** Parses -k SLOT:SHIPRIV:SHIPUB */
+static int lt_cli_keys_parse(char *arg)
+{
+    char *priv = strchr(arg, ':');
+    char *pub = priv ? strchr(priv + 1, ':') : NULL;
+    if (!pub) {
+        return -1;
+    }
+    *priv++ = '\0';
+    *pub++ = '\0';
+    char *end;
+    unsigned long slot = strtoul(arg, &end, 10);
+    if (*end || (slot > PAIRING_KEY_SLOT_INDEX_3)) {
+        return -1;
+    }
+    lt_cli_pkey_index = (pkey_index_t)slot;
+    lt_cli_keys_set = 1;
+
+    return ((lt_cli_key_read(priv, lt_cli_shipriv, 32) == 0) && (lt_cli_key_read(pub, lt_cli_shipub, 32) == 0))
+               ? 0
+               : -1;
+}
+
+/** Sets the device of the chip up from its specification given by -c */
+static int lt_cli_chip_parse(lt_cli_chip_t *chip, const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+    lt_cli_dev_t *dev = &chip->dev;
+
+    if (strlen(spec) >= sizeof(buf)) {
+        return -1;
+    }
+    strcpy(buf, spec);
+
+#if LT_CLI_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return -1;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return -1;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return -1;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return -1;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return -1;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL);
+
+    chip->h.l2.device = dev;
+#if LT_SEPARATE_L3_BUFF
+    chip->h.l3.buff = chip->l3_buffer;
+    chip->h.l3.buff_len = sizeof(chip->l3_buffer);
+#endif
+#if LT_TUNE_PERSIST
+    if (lt_cli_cache_dir) {
+        lt_cli_tune_store.port_id = spec;
+        lt_cli_tune_store.ctx = (void *)lt_cli_cache_dir;
+        chip->h.tune_store = &lt_cli_tune_store;
+    }
+#endif
+
+    return 0;
+}
+
+/** Initializes the handle of the chip, once */
+static lt_ret_t lt_cli_chip_init(lt_cli_chip_t *chip)
+{
+    if (chip->inited) {
+        return LT_OK;
+    }
+    lt_ret_t ret = lt_init(&chip->h);
+    if (ret != LT_OK) {
+        fprintf(stderr, "Chip %s: init failed, %s\n", lt_cli_chip_spec, lt_ret_verbose(ret));
+        return ret;
+    }
+    chip->inited = 1;
+
+    return LT_OK;
+}
+
+/** Path of the cached certificate store of the chip, named by its serial number */
+static void lt_cli_cache_path(const struct lt_chip_id_t *chip_id, char *path, const size_t size)
+{
+    const uint8_t *sn = (const uint8_t *)&chip_id->ser_num;
+    char hex[2 * sizeof(chip_id->ser_num) + 1];
+    for (size_t i = 0; i < sizeof(chip_id->ser_num); i++) {
+        snprintf(hex + (2 * i), 3, "%02x", sn[i]);
+    }
+    snprintf(path, size, "%s/%s.certs", lt_cli_cache_dir, hex);
+}
+
+/** Reads STPub from the cached certificate store, or from the chip, which then fills the cache */
+static lt_ret_t lt_cli_stpub_get(lt_handle_t *h, uint8_t *stpub)
+{
+    uint8_t exported[LT_CERT_STORE_EXPORT_SIZE_MAX];
+    struct lt_chip_id_t chip_id;
+    char path[PATH_MAX];
+    lt_ret_t ret;
+
+    if (lt_cli_cache_dir) {
+        ret = lt_get_info_chip_id(h, &chip_id);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        lt_cli_cache_path(&chip_id, path, sizeof(path));
+        FILE *f = fopen(path, "rb");
+        if (f) {
+            size_t len = fread(exported, 1, sizeof(exported), f);
+            fclose(f);
+            // A corrupted file or a file of another chip is replaced below
+            if (lt_cert_store_import(&chip_id, exported, (uint16_t)len, NULL, stpub, 32) == LT_OK) {
+                return LT_OK;
+            }
+        }
+    }
+
+    uint8_t certs[LT_NUM_CERTIFICATES][LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE];
+    struct lt_cert_store_t store = {0};
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        store.certs[i] = certs[i];
+        store.buf_len[i] = sizeof(certs[i]);
+    }
+    ret = lt_get_info_cert_store(h, &store);
+    if (ret == LT_OK) {
+        ret = lt_get_st_pub(&store, stpub, 32);
+    }
+    if ((ret != LT_OK) || !lt_cli_cache_dir) {
+        return ret;
+    }
+
+    uint16_t len;
+    if (lt_cert_store_export(&chip_id, &store, exported, sizeof(exported), &len) == LT_OK) {
+        // Written aside and renamed, so a concurrent invocation never reads a partial file
+        char tmp[PATH_MAX + 8];
+        snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+        FILE *f = fopen(tmp, "wb");
+        if (f) {
+            bool ok = (fwrite(exported, 1, len, f) == len);
+            ok = (fclose(f) == 0) && ok;
+            if (!ok || (rename(tmp, path) != 0)) {
+                unlink(tmp);
+            }
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Establishes the secure session with the chip, once */
+static lt_ret_t lt_cli_session(lt_cli_chip_t *chip)
+{
+    if (chip->session) {
+        return LT_OK;
+    }
+    lt_ret_t ret = lt_cli_chip_init(chip);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    uint8_t stpub[32];
+    ret = lt_cli_stpub_get(&chip->h, stpub);
+    if (ret == LT_OK) {
+        ret = lt_session_start(&chip->h, stpub, lt_cli_pkey_index, lt_cli_shipriv, lt_cli_shipub);
+    }
+    if (ret != LT_OK) {
+        fprintf(stderr, "Chip %s: session failed, %s\n", lt_cli_chip_spec, lt_ret_verbose(ret));
+        return ret;
+    }
+    chip->session = 1;
+
+    return LT_OK;
+}
+
+/** Sets i-th command of the next batch, `cmd_len` counts from the command ID */
+static void lt_cli_cmd_set(const uint8_t i, const uint16_t cmd_len)
+{
+    // The longest command and result give the space of the plaintexts
+    lt_cli_batch_cmds[i] = (tropicd_cmd_t){.cmd = LT_CLI_PLAIN(&lt_cli_cmds[i].cmd.eddsa, cmd_id),
+                                           .cmd_len = cmd_len,
+                                           .res = LT_CLI_PLAIN(&lt_cli_cmds[i].res.rmem_read, result),
+                                           .res_max_len = LT_CLI_PLAIN_MAX(&lt_cli_cmds[i].res.rmem_read, result)};
+}
+
+// Plaintexts of all commands and results start at the same offsets of their unions
+_Static_assert(offsetof(struct lt_l3_ecdsa_sign_cmd_t, cmd_id) == offsetof(struct lt_l3_eddsa_sign_cmd_t, cmd_id),
+               "Commands start at different offsets");
+_Static_assert(offsetof(struct lt_l3_ecdsa_sign_res_t, result) == offsetof(struct lt_l3_r_mem_data_read_res_t, result),
+               "Results start at different offsets");
+
+/** Executes first `cnt` commands set by lt_cli_cmd_set(), results are in `ret` and `res_len` of each command */
+static lt_ret_t lt_cli_batch(const uint8_t cnt)
+{
+    if (lt_cli_socket) {
+        lt_ret_t ret = tropicd_batch(&lt_cli_conn, lt_cli_daemon_chip, lt_cli_batch_cmds, cnt);
+        if (ret != LT_OK) {
+            fprintf(stderr, "tropicd: %s\n", lt_ret_verbose(ret));
+        }
+        return ret;
+    }
+
+    lt_ret_t ret = lt_cli_session(&lt_cli_chip);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        tropicd_cmd_t *c = &lt_cli_batch_cmds[i];
+        c->res_len = 0;
+        c->ret = lt_raw_cmd(&lt_cli_chip.h, c->cmd, c->cmd_len, c->res, c->res_max_len, &c->res_len);
+    }
+
+    return LT_OK;
+}
+
+/** Maps the file, or reads standard input for "-" */
+static int lt_cli_input_open(const char *path, lt_cli_input_t *in)
+{
+    static const uint8_t empty;
+    *in = (lt_cli_input_t){.data = &empty};
+
+    if (!strcmp(path, "-")) {
+        uint8_t *buf = NULL;
+        size_t size = 0;
+        for (;;) {
+            if (in->len == size) {
+                size = size ? 2 * size : LT_CLI_STREAM_CHUNK;
+                uint8_t *grown = realloc(buf, size);
+                if (!grown) {
+                    free(buf);
+                    return -1;
+                }
+                buf = grown;
+            }
+            size_t n = fread(buf + in->len, 1, size - in->len, stdin);
+            if (!n) {
+                break;
+            }
+            in->len += n;
+        }
+        in->data = buf;
+        return ferror(stdin) ? -1 : 0;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if ((fd < 0) || (fstat(fd, &st) != 0)) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    in->len = (size_t)st.st_size;
+    if (in->len) {
+        in->map = mmap(NULL, in->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (in->map == MAP_FAILED) {
+            fprintf(stderr, "Cannot map %s: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        in->data = in->map;
+    }
+    close(fd);
+
+    return 0;
+}
+
+static void lt_cli_input_close(lt_cli_input_t *in)
+{
+    if (in->map) {
+        munmap(in->map, in->len);
+    }
+    else if (in->len) {
+        free((void *)in->data);
+    }
+    *in = (lt_cli_input_t){0};
+}
+
+/** Hashes standard input as it is read */
+static int lt_cli_stdin_digest(uint8_t *digest)
+{
+    struct lt_crypto_sha256_ctx_t hctx;
+    static uint8_t buf[LT_CLI_STREAM_CHUNK];
+    size_t n;
+
+    lt_sha256_init(&hctx);
+    lt_sha256_start(&hctx);
+    while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+        lt_sha256_update(&hctx, buf, n);
+    }
+    lt_sha256_finish(&hctx, digest);
+
+    return ferror(stdin) ? -1 : 0;
+}
+
+static void lt_cli_hex_print(const uint8_t *data, const size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        printf("%02x", data[i]);
+    }
+}
+
+static int lt_cli_hex_parse(const char *hex, uint8_t *data, const size_t len)
+{
+    if (strlen(hex) != 2 * len) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char byte[3] = {hex[2 * i], hex[(2 * i) + 1], '\0'};
+        char *end;
+        data[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int lt_cli_slot_parse(const char *arg, const unsigned long max, uint16_t *slot)
+{
+    char *end;
+    unsigned long v = strtoul(arg, &end, 10);
+    if (!*arg || *end || (v > max)) {
+        fprintf(stderr, "Invalid slot %s\n", arg);
+        return -1;
+    }
+    *slot = (uint16_t)v;
+
+    return 0;
+}
+
+/** Checks result of a command of the batch, reports its failure */
+static int lt_cli_cmd_check(const uint8_t i, const char *what)
+{
+    if (lt_cli_batch_cmds[i].ret != LT_OK) {
+        fprintf(stderr, "%s: %s\n", what, lt_ret_verbose(lt_cli_batch_cmds[i].ret));
+        return -1;
+    }
+
+    return 0;
+}
+
+/** Signs files in groups of TROPICD_BATCH_MAX, prints signatures in the format of sha256sum */
+static int lt_cli_sign(const bool eddsa, const uint16_t slot, char *const *files, const int files_cnt)
+{
+    int result = 0;
+
+    for (int first = 0; first < files_cnt; first += TROPICD_BATCH_MAX) {
+        uint8_t cnt = (uint8_t)(((files_cnt - first) < TROPICD_BATCH_MAX) ? (files_cnt - first) : TROPICD_BATCH_MAX);
+        lt_cli_input_t ins[TROPICD_BATCH_MAX] = {0};
+        const uint8_t *msgs[TROPICD_BATCH_MAX];
+        uint32_t msg_lens[TROPICD_BATCH_MAX];
+        uint8_t digests[TROPICD_BATCH_MAX * SHA256_DIGEST_LENGTH];
+        int stdin_idx = -1;
+
+        for (uint8_t i = 0; i < cnt; i++) {
+            const char *path = files[first + i];
+            if (!eddsa && !strcmp(path, "-")) {
+                stdin_idx = i;
+                msgs[i] = NULL;
+                msg_lens[i] = 0;
+                continue;
+            }
+            if (lt_cli_input_open(path, &ins[i]) != 0) {
+                result = 1;
+                cnt = i;
+                break;
+            }
+            if (eddsa && (ins[i].len > LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX)) {
+                fprintf(stderr, "%s: EdDSA signs at most %d bytes\n", path, LT_L3_EDDSA_SIGN_CMD_MSG_LEN_MAX);
+                result = 1;
+                cnt = (uint8_t)(i + 1);
+                break;
+            }
+            msgs[i] = ins[i].data;
+            msg_lens[i] = (uint32_t)ins[i].len;
+        }
+
+        if (!result && !eddsa) {
+            // Mapped files are hashed in parallel lanes, standard input is streamed on its own
+            lt_sha256_multi(msgs, msg_lens, cnt, digests);
+            if ((stdin_idx >= 0) && (lt_cli_stdin_digest(digests + (stdin_idx * SHA256_DIGEST_LENGTH)) != 0)) {
+                fprintf(stderr, "Cannot read stdin\n");
+                result = 1;
+            }
+        }
+        for (uint8_t i = 0; !result && (i < cnt); i++) {
+            lt_cli_cmd_t *c = &lt_cli_cmds[i];
+            if (eddsa) {
+                c->cmd.eddsa.cmd_id = LT_L3_EDDSA_SIGN_CMD_ID;
+                c->cmd.eddsa.slot = slot;
+                memset(c->cmd.eddsa.padding, 0, sizeof(c->cmd.eddsa.padding));
+                memcpy(c->cmd.eddsa.msg, msgs[i], msg_lens[i]);
+                lt_cli_cmd_set(i, (uint16_t)(LT_L3_EDDSA_SIGN_CMD_SIZE_MIN - 1 + msg_lens[i]));
+            }
+            else {
+                c->cmd.ecdsa.cmd_id = LT_L3_ECDSA_SIGN_CMD_ID;
+                c->cmd.ecdsa.slot = slot;
+                memset(c->cmd.ecdsa.padding, 0, sizeof(c->cmd.ecdsa.padding));
+                memcpy(c->cmd.ecdsa.msg_hash, digests + (i * SHA256_DIGEST_LENGTH), SHA256_DIGEST_LENGTH);
+                lt_cli_cmd_set(i, LT_L3_ECDSA_SIGN_CMD_SIZE);
+            }
+        }
+        for (uint8_t i = 0; i < cnt; i++) {
+            lt_cli_input_close(&ins[i]);
+        }
+        if (result || (lt_cli_batch(cnt) != LT_OK)) {
+            return 1;
+        }
+
+        for (uint8_t i = 0; i < cnt; i++) {
+            // Both results have R and S at the same place
+            const struct lt_l3_ecdsa_sign_res_t *res = &lt_cli_cmds[i].res.ecdsa;
+            if (lt_cli_cmd_check(i, files[first + i]) != 0) {
+                result = 1;
+                continue;
+            }
+            lt_cli_hex_print(res->r, sizeof(res->r));
+            lt_cli_hex_print(res->s, sizeof(res->s));
+            printf("  %s\n", files[first + i]);
+        }
+    }
+
+    return result;
+}
+
+_Static_assert(offsetof(struct lt_l3_ecdsa_sign_res_t, r) == offsetof(struct lt_l3_eddsa_sign_res_t, r),
+               "Signatures are at different offsets");
+
+/** Reads public key of the slot, returns its curve or 0 when the slot cannot be read */
+static uint8_t lt_cli_key_get(const uint16_t slot, uint8_t *pubkey)
+{
+    lt_cli_cmds[0].cmd.key_read.cmd_id = LT_L3_ECC_KEY_READ_CMD_ID;
+    lt_cli_cmds[0].cmd.key_read.slot = slot;
+    lt_cli_cmd_set(0, LT_L3_ECC_KEY_READ_CMD_SIZE);
+    if ((lt_cli_batch(1) != LT_OK) || (lt_cli_cmd_check(0, "ECC key read") != 0)) {
+        return 0;
+    }
+    memcpy(pubkey, lt_cli_cmds[0].res.key_read.pub_key, sizeof(lt_cli_cmds[0].res.key_read.pub_key));
+
+    return lt_cli_cmds[0].res.key_read.curve;
+}
+
+static int lt_cli_verify(const uint16_t slot, const char *sig_hex, const char *path)
+{
+    uint8_t rs[64];
+    uint8_t pubkey[64];
+    lt_cli_input_t in;
+
+    if (lt_cli_hex_parse(sig_hex, rs, sizeof(rs)) != 0) {
+        fprintf(stderr, "Signature must be 128 hex digits\n");
+        return 1;
+    }
+    uint8_t curve = lt_cli_key_get(slot, pubkey);
+    if (!curve || (lt_cli_input_open(path, &in) != 0)) {
+        return 1;
+    }
+
+    lt_ret_t ret = LT_PARAM_ERR;
+    if (curve == LT_L3_ECC_KEY_READ_CMD_CURVE_P256) {
+        ret = lt_ecc_ecdsa_sig_verify(in.data, (uint32_t)in.len, pubkey, rs);
+    }
+    else if (in.len <= UINT16_MAX) {
+        ret = lt_ecc_eddsa_sig_verify(in.data, (uint16_t)in.len, pubkey, rs);
+    }
+    lt_cli_input_close(&in);
+    printf("%s: %s\n", path, (ret == LT_OK) ? "OK" : "FAILED");
+
+    return (ret == LT_OK) ? 0 : 1;
+}
+
+static int lt_cli_random(const uint32_t count)
+{
+    for (uint32_t done = 0; done < count;) {
+        uint8_t cnt = 0;
+        uint16_t lens[TROPICD_BATCH_MAX];
+        for (uint32_t left = count - done; left && (cnt < TROPICD_BATCH_MAX); cnt++) {
+            lens[cnt] = (uint16_t)((left < RANDOM_VALUE_GET_LEN_MAX) ? left : RANDOM_VALUE_GET_LEN_MAX);
+            lt_cli_cmds[cnt].cmd.random.cmd_id = LT_L3_RANDOM_VALUE_GET_CMD_ID;
+            lt_cli_cmds[cnt].cmd.random.n_bytes = (uint8_t)lens[cnt];
+            lt_cli_cmd_set(cnt, LT_L3_RANDOM_VALUE_GET_CMD_SIZE);
+            left -= lens[cnt];
+        }
+        if (lt_cli_batch(cnt) != LT_OK) {
+            return 1;
+        }
+        for (uint8_t i = 0; i < cnt; i++) {
+            if (lt_cli_cmd_check(i, "Random value get") != 0) {
+                return 1;
+            }
+            lt_cli_hex_print(lt_cli_cmds[i].res.random.random_data, lens[i]);
+            done += lens[i];
+        }
+    }
+    printf("\n");
+
+    return 0;
+}
+
+static int lt_cli_rmem_get(const uint16_t slot)
+{
+    lt_cli_cmds[0].cmd.rmem_read.cmd_id = LT_L3_R_MEM_DATA_READ_CMD_ID;
+    lt_cli_cmds[0].cmd.rmem_read.udata_slot = slot;
+    lt_cli_cmd_set(0, LT_L3_R_MEM_DATA_READ_CMD_SIZE);
+    if ((lt_cli_batch(1) != LT_OK) || (lt_cli_cmd_check(0, "R-Memory read") != 0)) {
+        return 1;
+    }
+    size_t len = lt_cli_batch_cmds[0].res_len - LT_L3_R_MEM_DATA_READ_RES_SIZE_MIN;
+
+    return (fwrite(lt_cli_cmds[0].res.rmem_read.data, 1, len, stdout) == len) ? 0 : 1;
+}
+
+static int lt_cli_rmem_put(const uint16_t slot, const char *path)
+{
+    lt_cli_input_t in;
+    if (lt_cli_input_open(path, &in) != 0) {
+        return 1;
+    }
+    if (!in.len || (in.len > R_MEM_DATA_SIZE_MAX)) {
+        fprintf(stderr, "%s: slot holds 1 to %d bytes\n", path, R_MEM_DATA_SIZE_MAX);
+        lt_cli_input_close(&in);
+        return 1;
+    }
+
+    // Both commands go in one batch, so no other client of tropicd touches the slot in between
+    lt_cli_cmds[0].cmd.rmem_erase.cmd_id = LT_L3_R_MEM_DATA_ERASE_CMD_ID;
+    lt_cli_cmds[0].cmd.rmem_erase.udata_slot = slot;
+    lt_cli_cmd_set(0, LT_L3_R_MEM_DATA_ERASE_CMD_SIZE);
+    lt_cli_cmds[1].cmd.rmem_write.cmd_id = LT_L3_R_MEM_DATA_WRITE_CMD_ID;
+    lt_cli_cmds[1].cmd.rmem_write.udata_slot = slot;
+    lt_cli_cmds[1].cmd.rmem_write.padding = 0;
+    memcpy(lt_cli_cmds[1].cmd.rmem_write.data, in.data, in.len);
+    lt_cli_cmd_set(1, (uint16_t)(LT_L3_R_MEM_DATA_WRITE_CMD_SIZE_MIN + in.len));
+    lt_cli_input_close(&in);
+
+    if ((lt_cli_batch(2) != LT_OK) || (lt_cli_cmd_check(0, "R-Memory erase") != 0)
+        || (lt_cli_cmd_check(1, "R-Memory write") != 0)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static int lt_cli_inventory(void)
+{
+    for (uint16_t first = 0; first < LT_CLI_ECC_SLOTS_CNT; first += TROPICD_BATCH_MAX) {
+        uint8_t cnt = (uint8_t)(((LT_CLI_ECC_SLOTS_CNT - first) < TROPICD_BATCH_MAX) ? (LT_CLI_ECC_SLOTS_CNT - first)
+                                                                                      : TROPICD_BATCH_MAX);
+        for (uint8_t i = 0; i < cnt; i++) {
+            lt_cli_cmds[i].cmd.key_read.cmd_id = LT_L3_ECC_KEY_READ_CMD_ID;
+            lt_cli_cmds[i].cmd.key_read.slot = (uint16_t)(first + i);
+            lt_cli_cmd_set(i, LT_L3_ECC_KEY_READ_CMD_SIZE);
+        }
+        if (lt_cli_batch(cnt) != LT_OK) {
+            return 1;
+        }
+        for (uint8_t i = 0; i < cnt; i++) {
+            const struct lt_l3_ecc_key_read_res_t *res = &lt_cli_cmds[i].res.key_read;
+            printf("%2u ", first + i);
+            if (lt_cli_batch_cmds[i].ret == LT_L3_ECC_INVALID_KEY) {
+                printf("empty\n");
+                continue;
+            }
+            if (lt_cli_batch_cmds[i].ret != LT_OK) {
+                printf("error %s\n", lt_ret_verbose(lt_cli_batch_cmds[i].ret));
+                continue;
+            }
+            bool p256 = (res->curve == LT_L3_ECC_KEY_READ_CMD_CURVE_P256);
+            printf("%-7s %-9s ", p256 ? "P256" : "Ed25519",
+                   (res->origin == LT_L3_ECC_KEY_READ_CMD_ORIGIN_ECC_KEY_GENERATE) ? "generated" : "stored");
+            lt_cli_hex_print(res->pub_key, p256 ? 64 : 32);
+            printf("\n");
+        }
+    }
+
+    return 0;
+}
+
+/** Firmware versions are read by L2 requests, so no session is needed */
+static int lt_cli_fw_info(void)
+{
+    if (lt_cli_socket) {
+        fprintf(stderr, "fw info needs -c, tropicd forwards only L3 commands\n");
+        return 1;
+    }
+    if (lt_cli_chip_init(&lt_cli_chip) != LT_OK) {
+        return 1;
+    }
+
+    uint8_t riscv[LT_L2_GET_INFO_RISCV_FW_SIZE];
+    uint8_t spect[LT_L2_GET_INFO_SPECT_FW_SIZE];
+    lt_ret_t ret = lt_get_info_riscv_fw_ver(&lt_cli_chip.h, riscv);
+    if (ret == LT_OK) {
+        ret = lt_get_info_spect_fw_ver(&lt_cli_chip.h, spect);
+    }
+    if (ret != LT_OK) {
+        fprintf(stderr, "Firmware versions cannot be read: %s\n", lt_ret_verbose(ret));
+        return 1;
+    }
+    printf("RISC-V %02X.%02X.%02X (+ .%02X)\n", riscv[3], riscv[2], riscv[1], riscv[0]);
+    printf("SPECT  %02X.%02X.%02X (+ .%02X)\n", spect[3], spect[2], spect[1], spect[0]);
+
+    return 0;
+}
+
+/** Executes the command given by the arguments after options */
+static int lt_cli_run(const int argc, char *const *argv)
+{
+    uint16_t slot;
+
+    if ((argc >= 4) && !strcmp(argv[0], "sign") && (!strcmp(argv[1], "ecdsa") || !strcmp(argv[1], "eddsa"))) {
+        if (lt_cli_slot_parse(argv[2], ECC_SLOT_31, &slot) != 0) {
+            return 1;
+        }
+        return lt_cli_sign(!strcmp(argv[1], "eddsa"), slot, argv + 3, argc - 3);
+    }
+    if ((argc == 4) && !strcmp(argv[0], "verify")) {
+        return (lt_cli_slot_parse(argv[1], ECC_SLOT_31, &slot) != 0) ? 1 : lt_cli_verify(slot, argv[2], argv[3]);
+    }
+    if ((argc == 2) && !strcmp(argv[0], "random")) {
+        char *end;
+        unsigned long count = strtoul(argv[1], &end, 10);
+        if (!*argv[1] || *end || (count > UINT32_MAX)) {
+            fprintf(stderr, "Invalid count %s\n", argv[1]);
+            return 1;
+        }
+        return lt_cli_random((uint32_t)count);
+    }
+    if ((argc >= 3) && !strcmp(argv[0], "rmem")) {
+        if (lt_cli_slot_parse(argv[2], R_MEM_DATA_SLOT_MAX, &slot) != 0) {
+            return 1;
+        }
+        if ((argc == 3) && !strcmp(argv[1], "get")) {
+            return lt_cli_rmem_get(slot);
+        }
+        if ((argc == 4) && !strcmp(argv[1], "put")) {
+            return lt_cli_rmem_put(slot, argv[3]);
+        }
+    }
+    if ((argc == 1) && !strcmp(argv[0], "inventory")) {
+        return lt_cli_inventory();
+    }
+    if ((argc == 2) && !strcmp(argv[0], "fw") && !strcmp(argv[1], "info")) {
+        return lt_cli_fw_info();
+    }
+
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    int spi_speed = LT_CLI_SPI_SPEED_DEFAULT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+c:k:f:C:s:i:h")) != -1) {
+        switch (opt) {
+            case 'c':
+                lt_cli_chip_spec = optarg;
+                break;
+            case 'k':
+                if (lt_cli_keys_parse(optarg) != 0) {
+                    return 1;
+                }
+                break;
+            case 'f':
+                spi_speed = atoi(optarg);
+                break;
+            case 'C':
+                lt_cli_cache_dir = optarg;
+                break;
+            case 's':
+                lt_cli_socket = optarg;
+                break;
+            case 'i':
+                lt_cli_daemon_chip = (uint8_t)atoi(optarg);
+                break;
+            default:
+                lt_cli_usage(argv[0]);
+                return 1;
+        }
+    }
+    if ((optind == argc) || (!lt_cli_chip_spec == !lt_cli_socket) || (lt_cli_chip_spec && !lt_cli_keys_set)) {
+        lt_cli_usage(argv[0]);
+        return 1;
+    }
+
+    if (lt_cli_socket) {
+        if (tropicd_connect(&lt_cli_conn, lt_cli_socket) != LT_OK) {
+            fprintf(stderr, "Cannot connect to tropicd at %s\n", lt_cli_socket);
+            return 1;
+        }
+        // Without the ring requests keep going over the socket
+        tropicd_shm_attach(&lt_cli_conn);
+    }
+    else if (lt_cli_chip_parse(&lt_cli_chip, lt_cli_chip_spec, spi_speed) != 0) {
+        fprintf(stderr, "Invalid chip %s\n", lt_cli_chip_spec);
+        return 1;
+    }
+
+    int result = lt_cli_run(argc - optind, argv + optind);
+    if (result < 0) {
+        lt_cli_usage(argv[0]);
+        result = 1;
+    }
+
+    if (lt_cli_socket) {
+        tropicd_disconnect(&lt_cli_conn);
+    }
+    if (lt_cli_chip.session) {
+        lt_session_abort(&lt_cli_chip.h);
+    }
+    if (lt_cli_chip.inited) {
+        lt_deinit(&lt_cli_chip.h);
+    }
+    memset(lt_cli_shipriv, 0, sizeof(lt_cli_shipriv));
+
+    return result;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file lt_metrics_exporter.c
+ * @author Tropic Square s.r.o.
+ * @brief Exporter serving statistics of libtropic published in shared memory (libtropic_port_unix_metrics.h) in
+ * OpenMetrics format over HTTP.
+ *
+ * The exporter is single-threaded and does not touch the chips: each scrape maps the segment, formats it and unmaps
+ * it again, so the application can be restarted while the exporter runs.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "libtropic_common.h"
+#include "libtropic_port_unix_metrics.h"
+
+/** Shared memory segment used unless set by -s */
+#define LT_METRICS_SEGMENT_DEFAULT "/libtropic"
+/** Port used unless set by -p, default of OpenMetrics exporters of other libraries */
+#define LT_METRICS_PORT_DEFAULT 9464
+/** Time given to a scraper to send its request and take the response */
+#define LT_METRICS_TIMEOUT_MS 2000
+
+static volatile sig_atomic_t lt_metrics_quit;
+
+static void lt_metrics_on_signal(int sig)
+{
+    (void)sig;
+    lt_metrics_quit = 1;
+}
+
+static void lt_metrics_usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [-s segment] [-a address] [-p port]\n"
+            "  -s  shared memory segment of the application, default %s\n"
+            "  -a  address to listen on, default 127.0.0.1\n"
+            "  -p  port to listen on, default %d\n",
+            argv0, LT_METRICS_SEGMENT_DEFAULT, LT_METRICS_PORT_DEFAULT);
+}
+
+static void lt_metrics_send(int fd, const char *status, const char *type, const char *body, size_t body_len)
+{
+    char head[256];
+    int head_len = snprintf(head, sizeof(head),
+                            "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                            status, type, body_len);
+
+    if ((write(fd, head, (size_t)head_len) == head_len) && body_len) {
+        ssize_t sent = write(fd, body, body_len);
+        (void)sent;  // Scraper which went away is not an error of the exporter
+    }
+}
+
+static void lt_metrics_serve(int fd, const char *segment)
+{
+    char req[1024];
+    ssize_t len = read(fd, req, sizeof(req) - 1);
+    if (len <= 0) {
+        return;
+    }
+    req[len] = '\0';
+
+    if (strncmp(req, "GET /metrics ", 13) && strncmp(req, "GET /metrics?", 13)) {
+        static const char not_found[] = "Only /metrics is served\n";
+        lt_metrics_send(fd, "404 Not Found", "text/plain", not_found, sizeof(not_found) - 1);
+        return;
+    }
+
+    lt_unix_metrics_t m = {0};
+    if (lt_unix_metrics_open(&m, segment) != LT_OK) {
+        static const char unavailable[] = "Statistics are not published\n";
+        lt_metrics_send(fd, "503 Service Unavailable", "text/plain", unavailable, sizeof(unavailable) - 1);
+        return;
+    }
+
+    char *body = NULL;
+    size_t body_len = 0;
+    FILE *out = open_memstream(&body, &body_len);
+    if (out) {
+        lt_ret_t ret = lt_unix_metrics_openmetrics(&m, out);
+        fclose(out);
+        if (ret == LT_OK) {
+            lt_metrics_send(fd, "200 OK", "application/openmetrics-text; version=1.0.0; charset=utf-8", body,
+                            body_len);
+        }
+        free(body);
+    }
+    lt_unix_metrics_close(&m);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *segment = LT_METRICS_SEGMENT_DEFAULT;
+    const char *address = "127.0.0.1";
+    int port = LT_METRICS_PORT_DEFAULT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:a:p:h")) != -1) {
+        switch (opt) {
+            case 's':
+                segment = optarg;
+                break;
+            case 'a':
+                address = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            default:
+                lt_metrics_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons((uint16_t)port)};
+    if ((port <= 0) || (port > 65535) || (inet_pton(AF_INET, address, &addr.sin_addr) != 1)) {
+        lt_metrics_usage(argv[0]);
+        return 1;
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    if ((listen_fd < 0) || (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0)
+        || (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) || (listen(listen_fd, 8) < 0)) {
+        fprintf(stderr, "Cannot listen on %s:%d: %s\n", address, port, strerror(errno));
+        return 1;
+    }
+
+    // Scraper which went away is reported by the failing write instead
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction sa = {.sa_handler = lt_metrics_on_signal};
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    while (!lt_metrics_quit) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        // A stuck scraper must not block the next ones
+        struct timeval tv = {.tv_sec = LT_METRICS_TIMEOUT_MS / 1000, .tv_usec = (LT_METRICS_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        lt_metrics_serve(fd, segment);
+        close(fd);
+    }
+
+    close(listen_fd);
+    return 0;
+}
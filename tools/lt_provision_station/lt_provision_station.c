@@ -0,0 +1,651 @@
+/**
+ * @file lt_provision_station.c
+ * @author Tropic Square s.r.o.
+ * @brief Provisioning station writing R-Config, I-Config and pairing keys of a lab batch package into many TROPIC01
+ * chips concurrently.
+ *
+ * The package is loaded once, then each chip is provisioned by its own worker thread with its own handle and port
+ * device, so the chips wait for each other only for the certificate chain cache. A worker:
+ *
+ * 1. verifies the certificate chain of the chip against the root CA of the package (intermediate certificates are
+ *    verified only for the first chip, their fingerprints are cached by `lt_cert_chain_t`),
+ * 2. starts secure session with SH0 key pair of the package,
+ * 3. reads R-Config, I-Config and the provisioned pairing key slots and compares their fingerprint with the
+ *    fingerprint of the package, the chip is skipped when it is already provisioned,
+ * 4. writes only the differing configuration objects (`lt_write_R_config_diff()`, `lt_write_I_config_diff()`) and
+ *    the empty pairing key slots in one pipelined `lt_pairing_key_batch()`,
+ * 5. reads everything back and checks the fingerprint again.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_cert_chain.h"
+#include "libtropic_common.h"
+#include "lt_sha256.h"
+
+#if LT_PROVISION_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t lt_station_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t lt_station_dev_t;
+#endif
+
+/** Maximal number of chips provisioned concurrently */
+#define LT_STATION_CHIPS_MAX 16
+/** SPI speed used unless set by -f */
+#define LT_STATION_SPI_SPEED_DEFAULT 5000000
+/** Maximal length of a line of the package YAML */
+#define LT_STATION_LINE_MAX 512
+/** Maximal size of root CA certificate */
+#define LT_STATION_CERT_MAX 1024
+/** Maximal number of configuration words listed in the package (I-Config address space) */
+#define LT_STATION_CONFIG_WORDS_MAX 512
+
+/** Provisioning data loaded from the package */
+typedef struct lt_station_package_t {
+    uint8_t sh0priv[32];
+    uint8_t sh0pub[32];
+    /** SHA-256 of TROPIC01 root CA certificate */
+    uint8_t root_fp[LT_CERT_FP_SIZE];
+    struct lt_config_t r_config;
+    struct lt_config_t i_config;
+    /** Pairing keys written into slots 1-3, slot 0 is the key of the package */
+    uint8_t pkeys[PAIRING_KEY_SLOT_INDEX_3 + 1][32];
+    /** Bit i is set when slot i is provisioned */
+    uint8_t pkeys_mask;
+    /** Fingerprint of provisioned chip, by `lt_config_fingerprint()` */
+    uint8_t fp[LT_CONFIG_FINGERPRINT_SIZE];
+} lt_station_package_t;
+
+/** Outcome of one chip */
+typedef enum lt_station_result_t {
+    LT_STATION_FAILED = 0,
+    LT_STATION_PROVISIONED,
+    LT_STATION_SKIPPED
+} lt_station_result_t;
+
+/** Chip with its handle and outcome of its worker */
+typedef struct lt_station_chip_t {
+    lt_handle_t h;
+    lt_station_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+    const char *spec;
+    pthread_t thread;
+    lt_station_result_t result;
+    /** Step which failed */
+    const char *step;
+    lt_ret_t ret;
+    double seconds;
+} lt_station_chip_t;
+
+static lt_station_package_t lt_station_pkg;
+static lt_station_chip_t lt_station_chips[LT_STATION_CHIPS_MAX];
+static uint8_t lt_station_chips_cnt;
+/** Certificate chain verifier shared by the workers, its cache is guarded by the mutex */
+static lt_cert_chain_t lt_station_chain;
+static pthread_mutex_t lt_station_chain_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Nonzero when the certificate chain is not verified, e.g. against the model */
+static int lt_station_no_chain;
+
+static void lt_station_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -P PACKAGE -c CHIP [-c CHIP ...] [-K SLOT:SHIPUB ...] [-f HZ] [-u] [-l]\n"
+            "  -P PACKAGE     directory of lab batch package with tropic01_lab_batch_package.yml\n"
+            "  -c CHIP        chip to provision, "
+#if LT_PROVISION_PORT_SPI
+            "SPIDEV:GPIOCHIP:CS_PIN or SPIDEV:hw for native chip select\n"
+#else
+            "HOST:PORT of the model server\n"
+#endif
+            "  -K SLOT:SHIPUB write 32 B public pairing key from file SHIPUB into slot 1-3\n"
+            "  -f HZ          SPI speed, %d by default\n"
+            "  -u             do not verify certificate chain of the chips\n"
+            "  -l             provision next chips after Enter, until end of input\n",
+            prog, LT_STATION_SPI_SPEED_DEFAULT);
+}
+
+/** Reads whole file, returns its length or -1 */
+static long lt_station_file_read(const char *dir, const char *name, uint8_t *buf, const size_t size)
+{
+    char path[1024];
+    if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int)sizeof(path)) {
+        return -1;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    size_t len = fread(buf, 1, size, f);
+    int extra = fgetc(f);
+    fclose(f);
+    if (extra != EOF) {
+        fprintf(stderr, "%s is too large\n", path);
+        return -1;
+    }
+
+    return (long)len;
+}
+
+static int lt_station_b64(const char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+    return -1;
+}
+
+/**
+ * Loads X25519 key from PEM file of the package, PKCS#8 private key or SubjectPublicKeyInfo, both end by the 32 B
+ * key.
+ */
+static int lt_station_pem_key(const char *dir, const char *name, uint8_t *key)
+{
+    uint8_t pem[512], der[128];
+    long len = lt_station_file_read(dir, name, pem, sizeof(pem) - 1);
+    if (len < 0) {
+        return -1;
+    }
+    pem[len] = '\0';
+
+    const char *p = strstr((const char *)pem, "-----\n");
+    if (!p) {
+        return -1;
+    }
+    p += 6;
+    uint32_t acc = 0;
+    int bits = 0;
+    size_t der_len = 0;
+    for (; *p && *p != '-' && *p != '='; p++) {
+        int v = lt_station_b64(*p);
+        if (v < 0) {
+            continue;
+        }
+        acc = (acc << 6) | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (der_len == sizeof(der)) {
+                return -1;
+            }
+            der[der_len++] = (uint8_t)(acc >> bits);
+        }
+    }
+    // OID 1.3.101.110 (X25519) followed by the key in OCTET STRING or BIT STRING
+    static const uint8_t x25519_oid[] = {0x06, 0x03, 0x2b, 0x65, 0x6e};
+    if ((der_len != 48 && der_len != 44) || memcmp(der + ((der_len == 48) ? 7 : 4), x25519_oid, 5)) {
+        fprintf(stderr, "%s/%s is not X25519 key\n", dir, name);
+        return -1;
+    }
+    memcpy(key, der + der_len - 32, 32);
+
+    return 0;
+}
+
+/** Takes the words of the package into objects of the configuration, by their addresses */
+static void lt_station_config_take(const uint32_t *words, const int cnt, struct lt_config_t *config)
+{
+    for (int i = 0; i < LT_CONFIG_OBJ_CNT; i++) {
+        int idx = (int)(cfg_desc_table[i].addr / 4);
+        config->obj[i] = (idx < cnt) ? words[idx] : 0xffffffff;
+    }
+}
+
+/** Loads the package, only the subset of YAML produced for lab batch packages is understood */
+static int lt_station_package_load(const char *dir, lt_station_package_t *pkg)
+{
+    char path[1024];
+    if (snprintf(path, sizeof(path), "%s/tropic01_lab_batch_package.yml", dir) >= (int)sizeof(path)) {
+        return -1;
+    }
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    static uint32_t words[2][LT_STATION_CONFIG_WORDS_MAX];
+    int words_cnt[2] = {0};
+    int list = -1;
+    char root[256] = "", shpriv[256] = "", shpub[256] = "";
+    char line[LT_STATION_LINE_MAX];
+    int result = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] != ' ' && line[0] != '-') {
+            // Top level key, its value or a list follows
+            char *value = strchr(line, ':');
+            if (!value) {
+                list = -1;
+                continue;
+            }
+            *value++ = '\0';
+            value += strspn(value, " \t'\"");
+            value[strcspn(value, "'\"")] = '\0';
+            list = !strcmp(line, "r_config") ? 0 : !strcmp(line, "i_config") ? 1 : -1;
+            char *dst = !strcmp(line, "tropicsquare_root_ca_certificate") ? root
+                        : !strcmp(line, "s_h0priv_key")                  ? shpriv
+                        : !strcmp(line, "s_h0pub_key")                   ? shpub
+                                                                         : NULL;
+            if (dst && strlen(value) < 256) {
+                strcpy(dst, value);
+            }
+            continue;
+        }
+        char *item = line + strspn(line, " ");
+        if ((list >= 0) && (item[0] == '-')) {
+            if (words_cnt[list] == LT_STATION_CONFIG_WORDS_MAX) {
+                result = -1;
+                break;
+            }
+            words[list][words_cnt[list]++] = (uint32_t)strtoul(item + 1, NULL, 0);
+        }
+    }
+    fclose(f);
+
+    if ((result != 0) || !root[0] || !shpriv[0] || !shpub[0] || !words_cnt[0] || !words_cnt[1]) {
+        fprintf(stderr, "%s does not contain root CA, SH0 key pair, R-Config and I-Config\n", path);
+        return -1;
+    }
+    lt_station_config_take(words[0], words_cnt[0], &pkg->r_config);
+    lt_station_config_take(words[1], words_cnt[1], &pkg->i_config);
+
+    if ((lt_station_pem_key(dir, shpriv, pkg->sh0priv) != 0) || (lt_station_pem_key(dir, shpub, pkg->sh0pub) != 0)) {
+        return -1;
+    }
+    memcpy(pkg->pkeys[PAIRING_KEY_SLOT_INDEX_0], pkg->sh0pub, 32);
+    pkg->pkeys_mask |= 1u << PAIRING_KEY_SLOT_INDEX_0;
+
+    static uint8_t cert[LT_STATION_CERT_MAX];
+    long cert_len = lt_station_file_read(dir, root, cert, sizeof(cert));
+    if (cert_len <= 0) {
+        return -1;
+    }
+    struct lt_crypto_sha256_ctx_t hctx = {0};
+    lt_sha256_init(&hctx);
+    lt_sha256_start(&hctx);
+    lt_sha256_update(&hctx, cert, (size_t)cert_len);
+    lt_sha256_finish(&hctx, pkg->root_fp);
+
+    return 0;
+}
+
+/** Reads the provisioned state of the chip and compares its fingerprint with the package in one read pass */
+static lt_ret_t lt_station_state_match(lt_station_chip_t *chip, struct lt_config_state_t *state, bool *match)
+{
+    state->pkeys_mask = lt_station_pkg.pkeys_mask;
+    lt_ret_t ret = lt_config_fingerprint_match(&chip->h, lt_station_pkg.fp, state, match);
+    if (ret != LT_OK) {
+        chip->step = "state read";
+    }
+
+    return ret;
+}
+
+static lt_ret_t lt_station_provision(lt_station_chip_t *chip)
+{
+    lt_handle_t *h = &chip->h;
+    uint8_t stpub[32];
+
+    lt_ret_t ret = lt_init(h);
+    if (ret != LT_OK) {
+        chip->step = "init";
+        return ret;
+    }
+
+    uint8_t certs[LT_NUM_CERTIFICATES][LT_L2_GET_INFO_REQ_CERT_SIZE_SINGLE];
+    struct lt_cert_store_t store = {0};
+    for (int i = 0; i < LT_NUM_CERTIFICATES; i++) {
+        store.certs[i] = certs[i];
+        store.buf_len[i] = sizeof(certs[i]);
+    }
+    ret = lt_get_info_cert_store(h, &store);
+    if (ret == LT_OK) {
+        ret = lt_get_st_pub(&store, stpub, sizeof(stpub));
+    }
+    if (ret != LT_OK) {
+        chip->step = "certificate store";
+        return ret;
+    }
+    if (!lt_station_no_chain) {
+        pthread_mutex_lock(&lt_station_chain_lock);
+        ret = lt_cert_chain_verify(&lt_station_chain, &store);
+        pthread_mutex_unlock(&lt_station_chain_lock);
+        if (ret != LT_OK) {
+            chip->step = "certificate chain";
+            return ret;
+        }
+    }
+
+    ret = lt_session_start(h, stpub, PAIRING_KEY_SLOT_INDEX_0, lt_station_pkg.sh0priv, lt_station_pkg.sh0pub);
+    if (ret != LT_OK) {
+        chip->step = "session with SH0";
+        return ret;
+    }
+
+    struct lt_config_state_t state;
+    bool match;
+    ret = lt_station_state_match(chip, &state, &match);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (match) {
+        chip->result = LT_STATION_SKIPPED;
+        return LT_OK;
+    }
+
+    ret = lt_write_R_config_diff(h, &state.r_config, &lt_station_pkg.r_config);
+    if (ret != LT_OK) {
+        chip->step = "R-Config write";
+        return ret;
+    }
+    ret = lt_write_I_config_diff(h, &state.i_config, &lt_station_pkg.i_config);
+    if (ret != LT_OK) {
+        chip->step = "I-Config write";
+        return ret;
+    }
+
+    // Empty slots are written, a slot holding another key cannot be rewritten
+    lt_pairing_key_op_t ops[PAIRING_KEY_SLOT_INDEX_3 + 1];
+    uint8_t writes = 0;
+    for (uint8_t slot = 0; slot <= PAIRING_KEY_SLOT_INDEX_3; slot++) {
+        const uint8_t *key = lt_station_pkg.pkeys[slot];
+        const lt_ret_t status = state.pkeys_status[slot];
+        if (!(lt_station_pkg.pkeys_mask & (1u << slot))) {
+            continue;
+        }
+        if (status == LT_L3_PAIRING_KEY_EMPTY) {
+            ops[writes] = (lt_pairing_key_op_t){.op = LT_PAIRING_KEY_OP_WRITE, .slot = (pkey_index_t)slot};
+            memcpy(ops[writes++].key, key, 32);
+        }
+        else if ((status != LT_OK) || memcmp(state.pkeys[slot], key, 32)) {
+            chip->step = "pairing key slot holds another key";
+            return (status != LT_OK) ? status : LT_FAIL;
+        }
+    }
+    if (writes) {
+        ret = lt_pairing_key_batch(h, ops, writes);
+        for (uint8_t i = 0; (ret == LT_OK) && (i < writes); i++) {
+            ret = ops[i].status;
+        }
+        if (ret != LT_OK) {
+            chip->step = "pairing key write";
+            return ret;
+        }
+    }
+
+    ret = lt_station_state_match(chip, &state, &match);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (!match) {
+        // E.g. I-Config bits cleared before cannot be set back
+        chip->step = "verification of written data";
+        return LT_FAIL;
+    }
+    chip->result = LT_STATION_PROVISIONED;
+
+    return LT_OK;
+}
+
+static void *lt_station_worker(void *arg)
+{
+    lt_station_chip_t *chip = arg;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    chip->result = LT_STATION_FAILED;
+    chip->step = NULL;
+    chip->ret = lt_station_provision(chip);
+    if (chip->ret != LT_OK) {
+        chip->result = LT_STATION_FAILED;
+    }
+    lt_session_abort(&chip->h);
+    lt_deinit(&chip->h);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    chip->seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    return NULL;
+}
+
+/** Sets the device of the chip up from its specification given by -c */
+static int lt_station_chip_parse(lt_station_chip_t *chip, const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+    lt_station_dev_t *dev = &chip->dev;
+
+    if (strlen(spec) >= sizeof(buf)) {
+        return -1;
+    }
+    strcpy(buf, spec);
+    chip->spec = spec;
+
+#if LT_PROVISION_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return -1;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return -1;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return -1;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return -1;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return -1;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL) + lt_station_chips_cnt;
+
+    chip->h.l2.device = dev;
+#if LT_SEPARATE_L3_BUFF
+    chip->h.l3.buff = chip->l3_buffer;
+    chip->h.l3.buff_len = sizeof(chip->l3_buffer);
+#endif
+
+    return 0;
+}
+
+/** Parses -K SLOT:FILE */
+static int lt_station_pkey_parse(const char *arg)
+{
+    char *end;
+    unsigned long slot = strtoul(arg, &end, 10);
+    if ((*end != ':') || (slot < PAIRING_KEY_SLOT_INDEX_1) || (slot > PAIRING_KEY_SLOT_INDEX_3)) {
+        return -1;
+    }
+    if (lt_station_file_read(".", end + 1, lt_station_pkg.pkeys[slot], 32) != 32) {
+        fprintf(stderr, "%s does not contain exactly 32 bytes\n", end + 1);
+        return -1;
+    }
+    lt_station_pkg.pkeys_mask |= 1u << slot;
+
+    return 0;
+}
+
+/** Provisions all chips concurrently, returns number of failed chips */
+static int lt_station_round(void)
+{
+    struct timespec start, end;
+    int counts[3] = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint8_t i = 0; i < lt_station_chips_cnt; i++) {
+        if (pthread_create(&lt_station_chips[i].thread, NULL, lt_station_worker, &lt_station_chips[i]) != 0) {
+            fprintf(stderr, "Cannot start worker of chip %s\n", lt_station_chips[i].spec);
+            lt_station_chips[i].thread = 0;
+            counts[LT_STATION_FAILED]++;
+        }
+    }
+    for (uint8_t i = 0; i < lt_station_chips_cnt; i++) {
+        lt_station_chip_t *chip = &lt_station_chips[i];
+        if (!chip->thread) {
+            continue;
+        }
+        pthread_join(chip->thread, NULL);
+        chip->thread = 0;
+        counts[chip->result]++;
+        if (chip->result == LT_STATION_FAILED) {
+            printf("%-32s FAILED      %6.2f s  %s: %s\n", chip->spec, chip->seconds, chip->step ? chip->step : "",
+                   lt_ret_verbose(chip->ret));
+        }
+        else {
+            printf("%-32s %-11s %6.2f s\n", chip->spec,
+                   (chip->result == LT_STATION_PROVISIONED) ? "PROVISIONED" : "SKIPPED", chip->seconds);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%d provisioned, %d already provisioned, %d failed in %.2f s (%.1f chips/min)\n",
+           counts[LT_STATION_PROVISIONED], counts[LT_STATION_SKIPPED], counts[LT_STATION_FAILED], seconds,
+           (seconds > 0) ? ((counts[LT_STATION_PROVISIONED] + counts[LT_STATION_SKIPPED]) * 60.0 / seconds) : 0.0);
+    fflush(stdout);
+
+    return counts[LT_STATION_FAILED];
+}
+
+int main(int argc, char *argv[])
+{
+    const char *package = NULL;
+    const char *specs[LT_STATION_CHIPS_MAX];
+    const char *pkey_args[PAIRING_KEY_SLOT_INDEX_3];
+    int pkey_args_cnt = 0;
+    int spi_speed = LT_STATION_SPI_SPEED_DEFAULT;
+    int loop = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "P:c:K:f:ulh")) != -1) {
+        switch (opt) {
+            case 'P':
+                package = optarg;
+                break;
+            case 'c':
+                if (lt_station_chips_cnt == LT_STATION_CHIPS_MAX) {
+                    fprintf(stderr, "At most %d chips are supported\n", LT_STATION_CHIPS_MAX);
+                    return 1;
+                }
+                specs[lt_station_chips_cnt++] = optarg;
+                break;
+            case 'K':
+                if (pkey_args_cnt == PAIRING_KEY_SLOT_INDEX_3) {
+                    lt_station_usage(argv[0]);
+                    return 1;
+                }
+                pkey_args[pkey_args_cnt++] = optarg;
+                break;
+            case 'f':
+                spi_speed = atoi(optarg);
+                break;
+            case 'u':
+                lt_station_no_chain = 1;
+                break;
+            case 'l':
+                loop = 1;
+                break;
+            default:
+                lt_station_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!package || !lt_station_chips_cnt) {
+        lt_station_usage(argv[0]);
+        return 1;
+    }
+
+    // The package is loaded and the fingerprint of provisioned chip computed once for all chips
+    if (lt_station_package_load(package, &lt_station_pkg) != 0) {
+        return 1;
+    }
+    for (int i = 0; i < pkey_args_cnt; i++) {
+        if (lt_station_pkey_parse(pkey_args[i]) != 0) {
+            lt_station_usage(argv[0]);
+            return 1;
+        }
+    }
+    struct lt_config_state_t target = {.r_config = lt_station_pkg.r_config,
+                                       .i_config = lt_station_pkg.i_config,
+                                       .pkeys_mask = lt_station_pkg.pkeys_mask};
+    memcpy(target.pkeys, lt_station_pkg.pkeys, sizeof(target.pkeys));
+    for (uint8_t slot = 0; slot <= PAIRING_KEY_SLOT_INDEX_3; slot++) {
+        target.pkeys_status[slot] = LT_OK;
+    }
+    lt_config_fingerprint(&target, lt_station_pkg.fp);
+    if (lt_cert_chain_init(&lt_station_chain, lt_station_pkg.root_fp, lt_cert_chain_verify_builtin, NULL) != LT_OK) {
+        return 1;
+    }
+
+    for (uint8_t i = 0; i < lt_station_chips_cnt; i++) {
+        if (lt_station_chip_parse(&lt_station_chips[i], specs[i], spi_speed) != 0) {
+            fprintf(stderr, "Invalid chip %s\n", specs[i]);
+            return 1;
+        }
+    }
+
+    int failed = lt_station_round();
+    while (loop) {
+        printf("Insert next chips and press Enter, end of input quits\n");
+        fflush(stdout);
+        int c;
+        while (((c = getchar()) != EOF) && (c != '\n')) {
+        }
+        if (c == EOF) {
+            break;
+        }
+        failed = lt_station_round();
+    }
+
+    return failed ? 1 : 0;
+}
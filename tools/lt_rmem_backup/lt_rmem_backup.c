@@ -0,0 +1,563 @@
+/**
+ * @file lt_rmem_backup.c
+ * @author Tropic Square s.r.o.
+ * @brief Backup of User Data slots of R-Memory into a compact archive and their restore, e.g. into a replacement
+ * chip.
+ *
+ * Backup reads the slots by pipelined `lt_r_mem_data_read_range()` in chunks of 32 and writes each chunk into the
+ * archive as soon as it is read, so the archive may go to a pipe. Restore maps the archive, checks its digest and
+ * then for each chunk reads the slots of the chip, erases and writes only the slots which differ, by pipelined
+ * `lt_r_mem_data_erase_range()` and `lt_r_mem_data_write_range()` of consecutive runs.
+ *
+ * Archive, all numbers little endian:
+ *
+ *     header   "LTRM" | version 1 (1 B) | 0 (1 B) | first slot (2 B) | number of slots (2 B)
+ *     chunk    first slot (2 B) | bitmap (4 B), bit i set when slot first + i holds data |
+ *              for each set bit: length (2 B) | data
+ *     trailer  SHA-256 of everything before (32 B)
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_sha256.h"
+
+#if LT_RMEM_BACKUP_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t lt_backup_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t lt_backup_dev_t;
+#endif
+
+/** SPI speed used unless set by -f */
+#define LT_BACKUP_SPI_SPEED_DEFAULT 5000000
+/** Number of slots read, erased and written by one pipelined call, slots of one bitmap of the archive */
+#define LT_BACKUP_CHUNK 32
+#define LT_BACKUP_SLOTS_CNT (R_MEM_DATA_SLOT_MAX + 1)
+#define LT_BACKUP_VERSION 1
+#define LT_BACKUP_HEADER_SIZE 10
+#define LT_BACKUP_DIGEST_SIZE 32
+
+static const uint8_t lt_backup_magic[4] = {'L', 'T', 'R', 'M'};
+
+/** Chip with its handle */
+typedef struct lt_backup_chip_t {
+    lt_handle_t h;
+    lt_backup_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+} lt_backup_chip_t;
+
+/** Archive being written, bytes are hashed as they are written */
+typedef struct lt_backup_out_t {
+    FILE *f;
+    struct lt_crypto_sha256_ctx_t hctx;
+} lt_backup_out_t;
+
+/** Slots of one chunk, data of i-th slot at i * R_MEM_DATA_SIZE_MAX */
+typedef struct lt_backup_chunk_t {
+    uint8_t data[LT_BACKUP_CHUNK * R_MEM_DATA_SIZE_MAX];
+    uint16_t sizes[LT_BACKUP_CHUNK];
+    lt_ret_t statuses[LT_BACKUP_CHUNK];
+} lt_backup_chunk_t;
+
+static lt_backup_chip_t lt_backup_chip;
+static lt_backup_chunk_t lt_backup_chunk;
+static lt_backup_chunk_t lt_backup_target;
+static uint8_t lt_backup_shipriv[32];
+static uint8_t lt_backup_shipub[32];
+static pkey_index_t lt_backup_pkey_index;
+
+static void lt_backup_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -c CHIP -k SLOT:SHIPRIV:SHIPUB [-r FIRST:COUNT] [-f HZ] [-e] backup|restore ARCHIVE\n"
+            "  -c CHIP                 chip, "
+#if LT_RMEM_BACKUP_PORT_SPI
+            "SPIDEV:GPIOCHIP:CS_PIN or SPIDEV:hw for native chip select\n"
+#else
+            "HOST:PORT of the model server\n"
+#endif
+            "  -k SLOT:SHIPRIV:SHIPUB  pairing key slot and files with raw 32 B keys of the secure session\n"
+            "  -r FIRST:COUNT          slots to back up, all %d by default\n"
+            "  -f HZ                   SPI speed, %d by default\n"
+            "  -e                      restore also erases slots which are empty in the archive\n"
+            "  ARCHIVE                 file, - is stdout for backup\n",
+            prog, LT_BACKUP_SLOTS_CNT, LT_BACKUP_SPI_SPEED_DEFAULT);
+}
+
+/** Reads file of exactly `size` bytes */
+static int lt_backup_key_read(const char *path, uint8_t *buf, const size_t size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    size_t len = fread(buf, 1, size, f);
+    int extra = fgetc(f);
+    fclose(f);
+    if ((len != size) || (extra != EOF)) {
+        fprintf(stderr, "%s does not contain exactly %zu bytes\n", path, size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/** Parses -k SLOT:SHIPRIV:SHIPUB */
+static int lt_backup_keys_parse(char *arg)
+{
+    char *priv = strchr(arg, ':');
+    char *pub = priv ? strchr(priv + 1, ':') : NULL;
+    if (!pub) {
+        return -1;
+    }
+    *priv++ = '\0';
+    *pub++ = '\0';
+    char *end;
+    unsigned long slot = strtoul(arg, &end, 10);
+    if (*end || (slot > PAIRING_KEY_SLOT_INDEX_3)) {
+        return -1;
+    }
+    lt_backup_pkey_index = (pkey_index_t)slot;
+
+    return ((lt_backup_key_read(priv, lt_backup_shipriv, 32) == 0)
+            && (lt_backup_key_read(pub, lt_backup_shipub, 32) == 0))
+               ? 0
+               : -1;
+}
+
+/** Sets the device of the chip up from its specification given by -c */
+static int lt_backup_chip_parse(lt_backup_chip_t *chip, const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+    lt_backup_dev_t *dev = &chip->dev;
+
+    if (strlen(spec) >= sizeof(buf)) {
+        return -1;
+    }
+    strcpy(buf, spec);
+
+#if LT_RMEM_BACKUP_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return -1;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return -1;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return -1;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return -1;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return -1;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL);
+
+    chip->h.l2.device = dev;
+#if LT_SEPARATE_L3_BUFF
+    chip->h.l3.buff = chip->l3_buffer;
+    chip->h.l3.buff_len = sizeof(chip->l3_buffer);
+#endif
+
+    return 0;
+}
+
+static void lt_backup_put16(uint8_t *p, const uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t lt_backup_get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static int lt_backup_write(lt_backup_out_t *out, const uint8_t *data, const size_t len)
+{
+    lt_sha256_update(&out->hctx, data, len);
+
+    return (fwrite(data, 1, len, out->f) == len) ? 0 : -1;
+}
+
+/** Reads slots of the chunk, empty slots get size 0 */
+static lt_ret_t lt_backup_chunk_read(lt_handle_t *h, const uint16_t first, const uint16_t cnt, lt_backup_chunk_t *c)
+{
+    lt_ret_t ret = lt_r_mem_data_read_range(h, first, cnt, c->data, c->sizes, c->statuses);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    for (uint16_t i = 0; i < cnt; i++) {
+        if (c->statuses[i] == LT_L3_R_MEM_DATA_READ_SLOT_EMPTY) {
+            c->sizes[i] = 0;
+        }
+        else if (c->statuses[i] != LT_OK) {
+            fprintf(stderr, "Slot %u cannot be read: %s\n", first + i, lt_ret_verbose(c->statuses[i]));
+            return c->statuses[i];
+        }
+    }
+
+    return LT_OK;
+}
+
+/** Streams slots `first` to `first + cnt - 1` into the archive, returns number of backed up slots or -1 */
+static int lt_backup(lt_handle_t *h, const uint16_t first, const uint16_t cnt, FILE *f)
+{
+    lt_backup_out_t out = {.f = f};
+    uint8_t hdr[LT_BACKUP_HEADER_SIZE];
+    int slots = 0;
+
+    lt_sha256_init(&out.hctx);
+    lt_sha256_start(&out.hctx);
+    memcpy(hdr, lt_backup_magic, sizeof(lt_backup_magic));
+    hdr[4] = LT_BACKUP_VERSION;
+    hdr[5] = 0;
+    lt_backup_put16(hdr + 6, first);
+    lt_backup_put16(hdr + 8, cnt);
+    if (lt_backup_write(&out, hdr, sizeof(hdr)) != 0) {
+        return -1;
+    }
+
+    for (uint16_t done = 0; done < cnt; done += LT_BACKUP_CHUNK) {
+        uint16_t chunk_first = (uint16_t)(first + done);
+        uint16_t n = (uint16_t)(((cnt - done) < LT_BACKUP_CHUNK) ? (cnt - done) : LT_BACKUP_CHUNK);
+        lt_backup_chunk_t *c = &lt_backup_chunk;
+        if (lt_backup_chunk_read(h, chunk_first, n, c) != LT_OK) {
+            return -1;
+        }
+
+        uint8_t chunk_hdr[6];
+        uint32_t bitmap = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            if (c->sizes[i]) {
+                bitmap |= 1u << i;
+            }
+        }
+        lt_backup_put16(chunk_hdr, chunk_first);
+        lt_backup_put16(chunk_hdr + 2, (uint16_t)bitmap);
+        lt_backup_put16(chunk_hdr + 4, (uint16_t)(bitmap >> 16));
+        if (lt_backup_write(&out, chunk_hdr, sizeof(chunk_hdr)) != 0) {
+            return -1;
+        }
+        for (uint16_t i = 0; i < n; i++) {
+            if (!c->sizes[i]) {
+                continue;
+            }
+            uint8_t len[2];
+            lt_backup_put16(len, c->sizes[i]);
+            if ((lt_backup_write(&out, len, sizeof(len)) != 0)
+                || (lt_backup_write(&out, c->data + (i * R_MEM_DATA_SIZE_MAX), c->sizes[i]) != 0)) {
+                return -1;
+            }
+            slots++;
+        }
+        // Chunk is complete in the archive before the next one is read
+        fflush(f);
+    }
+
+    uint8_t digest[LT_BACKUP_DIGEST_SIZE];
+    lt_sha256_finish(&out.hctx, digest);
+    if ((fwrite(digest, 1, sizeof(digest), f) != sizeof(digest)) || (fflush(f) != 0)) {
+        return -1;
+    }
+
+    return slots;
+}
+
+/** Erases or writes runs of consecutive slots flagged in `mask`, data to write are taken from `c` */
+static lt_ret_t lt_backup_runs(lt_handle_t *h, const uint16_t first, const uint16_t cnt, const uint32_t mask,
+                               const bool write, const lt_backup_chunk_t *c)
+{
+    lt_ret_t statuses[LT_BACKUP_CHUNK];
+
+    for (uint16_t i = 0; i < cnt;) {
+        if (!(mask & (1u << i))) {
+            i++;
+            continue;
+        }
+        uint16_t run = 1;
+        while ((i + run < cnt) && (mask & (1u << (i + run)))) {
+            run++;
+        }
+        uint16_t slot = (uint16_t)(first + i);
+        lt_ret_t ret = write ? lt_r_mem_data_write_range(h, slot, run, c->data + (i * R_MEM_DATA_SIZE_MAX),
+                                                         c->sizes + i, statuses)
+                             : lt_r_mem_data_erase_range(h, slot, run, statuses);
+        for (uint16_t j = 0; (ret == LT_OK) && (j < run); j++) {
+            if (statuses[j] != LT_OK) {
+                fprintf(stderr, "Slot %u cannot be %s: %s\n", slot + j, write ? "written" : "erased",
+                        lt_ret_verbose(statuses[j]));
+                ret = statuses[j];
+            }
+        }
+        if (ret != LT_OK) {
+            return ret;
+        }
+        i = (uint16_t)(i + run);
+    }
+
+    return LT_OK;
+}
+
+/** Restores slots of the archive which differ on the chip, returns number of written slots or -1 */
+static int lt_restore(lt_handle_t *h, const uint8_t *a, const size_t len, const bool erase_empty)
+{
+    if ((len < LT_BACKUP_HEADER_SIZE + LT_BACKUP_DIGEST_SIZE) || memcmp(a, lt_backup_magic, sizeof(lt_backup_magic))
+        || (a[4] != LT_BACKUP_VERSION)) {
+        fprintf(stderr, "Not an R-Memory archive of version %d\n", LT_BACKUP_VERSION);
+        return -1;
+    }
+    // Nothing is written unless the whole archive is intact
+    uint8_t digest[LT_BACKUP_DIGEST_SIZE];
+    struct lt_crypto_sha256_ctx_t hctx;
+    size_t body_len = len - LT_BACKUP_DIGEST_SIZE;
+    lt_sha256_init(&hctx);
+    lt_sha256_start(&hctx);
+    lt_sha256_update(&hctx, a, body_len);
+    lt_sha256_finish(&hctx, digest);
+    if (memcmp(digest, a + body_len, sizeof(digest))) {
+        fprintf(stderr, "Digest of the archive does not match, it is damaged or truncated\n");
+        return -1;
+    }
+
+    uint16_t first = lt_backup_get16(a + 6);
+    uint16_t cnt = lt_backup_get16(a + 8);
+    if ((first > R_MEM_DATA_SLOT_MAX) || (cnt > LT_BACKUP_SLOTS_CNT - first)) {
+        fprintf(stderr, "Slots of the archive are out of R-Memory\n");
+        return -1;
+    }
+    size_t pos = LT_BACKUP_HEADER_SIZE;
+    int written = 0;
+
+    for (uint16_t done = 0; done < cnt; done += LT_BACKUP_CHUNK) {
+        uint16_t chunk_first = (uint16_t)(first + done);
+        uint16_t n = (uint16_t)(((cnt - done) < LT_BACKUP_CHUNK) ? (cnt - done) : LT_BACKUP_CHUNK);
+        if ((body_len - pos < 6) || (lt_backup_get16(a + pos) != chunk_first)) {
+            fprintf(stderr, "Chunk of slot %u is malformed\n", chunk_first);
+            return -1;
+        }
+        uint32_t bitmap = lt_backup_get16(a + pos + 2) | ((uint32_t)lt_backup_get16(a + pos + 4) << 16);
+        pos += 6;
+
+        lt_backup_chunk_t *t = &lt_backup_target;
+        for (uint16_t i = 0; i < n; i++) {
+            t->sizes[i] = 0;
+            if (!(bitmap & (1u << i))) {
+                continue;
+            }
+            uint16_t size = (body_len - pos >= 2) ? lt_backup_get16(a + pos) : 0;
+            if ((size < R_MEM_DATA_SIZE_MIN) || (size > R_MEM_DATA_SIZE_MAX) || (body_len - pos - 2 < size)) {
+                fprintf(stderr, "Record of slot %u is malformed\n", chunk_first + i);
+                return -1;
+            }
+            memcpy(t->data + (i * R_MEM_DATA_SIZE_MAX), a + pos + 2, size);
+            t->sizes[i] = size;
+            pos += 2u + size;
+        }
+
+        // Only slots which differ are touched, TROPIC01 writes only empty slots
+        lt_backup_chunk_t *c = &lt_backup_chunk;
+        if (lt_backup_chunk_read(h, chunk_first, n, c) != LT_OK) {
+            return -1;
+        }
+        uint32_t erase = 0, write = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            bool same = (c->sizes[i] == t->sizes[i])
+                        && !memcmp(c->data + (i * R_MEM_DATA_SIZE_MAX), t->data + (i * R_MEM_DATA_SIZE_MAX),
+                                   t->sizes[i]);
+            if (same || (!t->sizes[i] && !erase_empty)) {
+                continue;
+            }
+            if (c->sizes[i]) {
+                erase |= 1u << i;
+            }
+            if (t->sizes[i]) {
+                write |= 1u << i;
+                written++;
+            }
+        }
+        if ((lt_backup_runs(h, chunk_first, n, erase, false, t) != LT_OK)
+            || (lt_backup_runs(h, chunk_first, n, write, true, t) != LT_OK)) {
+            return -1;
+        }
+    }
+    if (pos != body_len) {
+        fprintf(stderr, "Archive has trailing data\n");
+        return -1;
+    }
+
+    return written;
+}
+
+static int lt_backup_restore_file(lt_handle_t *h, const char *path, const bool erase_empty)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+        fprintf(stderr, "Cannot map %s\n", path);
+        close(fd);
+        return -1;
+    }
+    void *a = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (a == MAP_FAILED) {
+        fprintf(stderr, "Cannot map %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int written = lt_restore(h, a, (size_t)st.st_size, erase_empty);
+    munmap(a, (size_t)st.st_size);
+
+    return written;
+}
+
+static lt_ret_t lt_backup_session(lt_handle_t *h)
+{
+    uint8_t stpub[32];
+
+    lt_ret_t ret = lt_init(h);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    ret = lt_get_info_st_pub(h, stpub, sizeof(stpub));
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    return lt_session_start(h, stpub, lt_backup_pkey_index, lt_backup_shipriv, lt_backup_shipub);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *spec = NULL;
+    uint16_t first = 0, cnt = LT_BACKUP_SLOTS_CNT;
+    int spi_speed = LT_BACKUP_SPI_SPEED_DEFAULT;
+    bool keys = false, erase_empty = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:k:r:f:eh")) != -1) {
+        switch (opt) {
+            case 'c':
+                spec = optarg;
+                break;
+            case 'k':
+                if (lt_backup_keys_parse(optarg) != 0) {
+                    lt_backup_usage(argv[0]);
+                    return 1;
+                }
+                keys = true;
+                break;
+            case 'r': {
+                char *end;
+                unsigned long f = strtoul(optarg, &end, 10);
+                unsigned long n = (*end == ':') ? strtoul(end + 1, &end, 10) : 0;
+                if (*end || !n || (f > R_MEM_DATA_SLOT_MAX) || (n > LT_BACKUP_SLOTS_CNT - f)) {
+                    lt_backup_usage(argv[0]);
+                    return 1;
+                }
+                first = (uint16_t)f;
+                cnt = (uint16_t)n;
+                break;
+            }
+            case 'f':
+                spi_speed = atoi(optarg);
+                break;
+            case 'e':
+                erase_empty = true;
+                break;
+            default:
+                lt_backup_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!spec || !keys || (argc - optind != 2)
+        || (strcmp(argv[optind], "backup") && strcmp(argv[optind], "restore"))) {
+        lt_backup_usage(argv[0]);
+        return 1;
+    }
+    bool backup = !strcmp(argv[optind], "backup");
+    const char *path = argv[optind + 1];
+    if (lt_backup_chip_parse(&lt_backup_chip, spec, spi_speed) != 0) {
+        fprintf(stderr, "Invalid chip %s\n", spec);
+        return 1;
+    }
+
+    lt_handle_t *h = &lt_backup_chip.h;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int slots = -1;
+    lt_ret_t ret = lt_backup_session(h);
+    if (ret != LT_OK) {
+        fprintf(stderr, "Secure session cannot be started: %s\n", lt_ret_verbose(ret));
+    }
+    else if (backup) {
+        FILE *f = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+        if (!f) {
+            fprintf(stderr, "Cannot create %s: %s\n", path, strerror(errno));
+        }
+        else {
+            slots = lt_backup(h, first, cnt, f);
+            if ((f != stdout) && (fclose(f) != 0)) {
+                slots = -1;
+            }
+        }
+    }
+    else {
+        slots = lt_backup_restore_file(h, path, erase_empty);
+    }
+    lt_session_abort(h);
+    lt_deinit(h);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (slots < 0) {
+        fprintf(stderr, "%s failed\n", backup ? "Backup" : "Restore");
+        return 1;
+    }
+    // Report goes to stderr, stdout may carry the archive
+    fprintf(stderr, "%d slots %s in %.2f s\n", slots, backup ? "backed up" : "restored", seconds);
+
+    return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * @file lt_spi_bridge.c
+ * @author Tropic Square s.r.o.
+ * @brief TCP server giving remote hosts access to TROPIC01 on a local SPI bus, speaking the protocol of the model.
+ *
+ * Besides the basic requests of the model (chip select edges, SPI transfers, waits and their batches), the server
+ * executes whole L1 transactions on TAG_E_L1_EXCHANGE: it writes the frame and polls CHIP_STATUS until the response
+ * is ready, locally at the speed of the SPI bus. A client built with LT_L1_OFFLOAD so pays one round trip of the
+ * network per L2 exchange instead of one per chip select edge, transfer and poll.
+ *
+ * One client is served at a time, the next one is accepted after the previous disconnects.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "libtropic_port_unix_spi.h"
+#include "libtropic_port_unix_tcp.h"
+#include "lt_l1.h"
+#include "lt_l1_port_wrap.h"
+
+/** SPI speed used unless set by -f */
+#define LT_BRIDGE_SPI_SPEED_DEFAULT 5000000
+/** TCP port listened on unless set by -p, the one of the model */
+#define LT_BRIDGE_PORT_DEFAULT 28992
+/** Size of the header of TAG_E_L1_EXCHANGE request: flags, timeout and maximal length of the response */
+#define LT_BRIDGE_EXCHANGE_HDR 7
+
+static lt_handle_t lt_bridge_h;
+static lt_dev_unix_spi_t lt_bridge_dev;
+static unix_tcp_buffer_t lt_bridge_rx;
+static unix_tcp_buffer_t lt_bridge_tx;
+
+static void lt_bridge_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -c CHIP [-p PORT] [-a ADDR] [-f HZ]\n"
+            "  -c CHIP  SPIDEV:GPIOCHIP:CS_PIN or SPIDEV:hw for native chip select\n"
+            "  -p PORT  TCP port to listen on, %d by default\n"
+            "  -a ADDR  address to listen on, 127.0.0.1 by default\n"
+            "  -f HZ    SPI speed, %d by default\n",
+            prog, LT_BRIDGE_PORT_DEFAULT, LT_BRIDGE_SPI_SPEED_DEFAULT);
+}
+
+static int lt_bridge_chip_parse(const char *spec, const int spi_speed)
+{
+    char buf[64];
+    lt_dev_unix_spi_t *dev = &lt_bridge_dev;
+
+    if (strlen(spec) >= sizeof(buf)) {
+        return -1;
+    }
+    strcpy(buf, spec);
+
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return -1;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return -1;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return -1;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+    dev->rng_seed = (unsigned int)time(NULL);
+    lt_bridge_h.l2.device = dev;
+
+    return 0;
+}
+
+static int lt_bridge_recv(int fd, uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static int lt_bridge_send(int fd, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if ((n < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/** Executes TAG_E_L1_EXCHANGE, reply is written to `out`, returns its length */
+static int lt_bridge_exchange(const uint8_t *in, uint16_t in_len, uint8_t *out)
+{
+    lt_l2_state_t *s2 = &lt_bridge_h.l2;
+
+    if ((in_len < LT_BRIDGE_EXCHANGE_HDR) || (in_len > LT_BRIDGE_EXCHANGE_HDR + LT_L1_LEN_MAX)) {
+        out[0] = LT_PARAM_ERR;
+        return 1;
+    }
+    const int read = in[0] & 0x01;
+    uint32_t timeout_ms = in[1] | (in[2] << 8) | (in[3] << 16) | ((uint32_t)in[4] << 24);
+    const uint16_t max_len = in[5] | (in[6] << 8);
+    const uint16_t frame_len = in_len - LT_BRIDGE_EXCHANGE_HDR;
+
+    if (timeout_ms < LT_L1_TIMEOUT_MS_MIN) {
+        timeout_ms = LT_L1_TIMEOUT_MS_MIN;
+    }
+    else if (timeout_ms > LT_L1_TIMEOUT_MS_MAX) {
+        timeout_ms = LT_L1_TIMEOUT_MS_MAX;
+    }
+
+    lt_ret_t ret = LT_OK;
+    if (frame_len) {
+        memcpy(s2->buff, in + LT_BRIDGE_EXCHANGE_HDR, frame_len);
+        ret = lt_l1_write(s2, frame_len, timeout_ms);
+    }
+    if ((ret != LT_OK) || !read) {
+        out[0] = (uint8_t)ret;
+        return 1;
+    }
+    if ((max_len < LT_L1_LEN_MIN) || (max_len > LT_L1_LEN_MAX)) {
+        out[0] = LT_PARAM_ERR;
+        return 1;
+    }
+
+    ret = lt_l1_read(s2, max_len, timeout_ms);
+    out[0] = (uint8_t)ret;
+    if (ret != LT_OK) {
+        // CHIP_STATUS of the last poll
+        out[1] = s2->buff[0];
+        return 2;
+    }
+    const int len = 3 + s2->buff[2] + 2;
+    memcpy(out + 1, s2->buff, len);
+
+    return 1 + len;
+}
+
+/**
+ * Executes one request of the model protocol other than a batch, reply payload is written to `out`. Returns its
+ * length, -1 for an unknown tag and -2 for a tag which is known but not supported.
+ */
+static int lt_bridge_op(uint8_t tag, const uint8_t *in, uint16_t in_len, uint8_t *out)
+{
+    lt_l2_state_t *s2 = &lt_bridge_h.l2;
+
+    switch ((unix_tcp_tag_t)tag) {
+        case TAG_E_SPI_DRIVE_CSN_LOW:
+            return (lt_l1_spi_csn_low(s2) == LT_OK) ? 0 : -2;
+        case TAG_E_SPI_DRIVE_CSN_HIGH:
+            return (lt_l1_spi_csn_high(s2) == LT_OK) ? 0 : -2;
+        case TAG_E_SPI_SEND:
+            if (in_len > LT_L1_LEN_MAX) {
+                return -2;
+            }
+            memcpy(s2->buff, in, in_len);
+            if (lt_l1_spi_transfer(s2, 0, in_len, LT_L1_TIMEOUT_MS_DEFAULT) != LT_OK) {
+                return -2;
+            }
+            memcpy(out, s2->buff, in_len);
+            return in_len;
+        case TAG_E_WAIT:
+            if (in_len != sizeof(uint32_t)) {
+                return -2;
+            }
+            return (lt_l1_delay_us(s2, in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24)) == LT_OK)
+                       ? 0
+                       : -2;
+        case TAG_E_L1_EXCHANGE:
+            return lt_bridge_exchange(in, in_len, out);
+        case TAG_E_POWER_ON:
+        case TAG_E_POWER_OFF:
+        case TAG_E_RESET_TARGET:
+            return -2;
+        default:
+            return -1;
+    }
+}
+
+/** Executes the operations of TAG_E_BATCH one after another, replies are concatenated in the same order */
+static int lt_bridge_batch(const uint8_t *in, uint16_t in_len, uint8_t *out)
+{
+    int in_pos = 0;
+    int out_pos = 0;
+
+    while (in_pos < in_len) {
+        if (in_pos + (int)TCP_TAG_AND_LENGTH_SIZE > in_len) {
+            return -2;
+        }
+        const uint8_t tag = in[in_pos];
+        const uint16_t len = in[in_pos + 1] | (in[in_pos + 2] << 8);
+        if ((tag == TAG_E_BATCH) || (tag == TAG_E_L1_EXCHANGE)
+            || (in_pos + (int)TCP_TAG_AND_LENGTH_SIZE + len > in_len)) {
+            return -2;
+        }
+        if ((tag == TAG_E_SPI_SEND) && (out_pos + (int)TCP_TAG_AND_LENGTH_SIZE + len > (int)MAX_PAYLOAD_LEN)) {
+            return -2;
+        }
+        int n = lt_bridge_op(tag, in + in_pos + TCP_TAG_AND_LENGTH_SIZE, len, out + out_pos + TCP_TAG_AND_LENGTH_SIZE);
+        if (n < 0) {
+            return n;
+        }
+        out[out_pos] = tag;
+        out[out_pos + 1] = n & 0x00ff;
+        out[out_pos + 2] = (n & 0xff00) >> 8;
+        in_pos += TCP_TAG_AND_LENGTH_SIZE + len;
+        out_pos += TCP_TAG_AND_LENGTH_SIZE + n;
+    }
+
+    return out_pos;
+}
+
+/** Serves requests of one client until it disconnects */
+static void lt_bridge_serve(int fd)
+{
+    for (;;) {
+        if (lt_bridge_recv(fd, lt_bridge_rx.buff, TCP_TAG_AND_LENGTH_SIZE) != 0) {
+            return;
+        }
+        if ((lt_bridge_rx.len > MAX_PAYLOAD_LEN)
+            || (lt_bridge_recv(fd, lt_bridge_rx.payload, lt_bridge_rx.len) != 0)) {
+            return;
+        }
+
+        int n = (lt_bridge_rx.tag == TAG_E_BATCH)
+                    ? lt_bridge_batch(lt_bridge_rx.payload, lt_bridge_rx.len, lt_bridge_tx.payload)
+                    : lt_bridge_op(lt_bridge_rx.tag, lt_bridge_rx.payload, lt_bridge_rx.len, lt_bridge_tx.payload);
+        if (n < 0) {
+            lt_bridge_tx.tag = (n == -1) ? TAG_E_INVALID : TAG_E_UNSUPPORTED;
+            n = 0;
+        }
+        else {
+            lt_bridge_tx.tag = lt_bridge_rx.tag;
+        }
+        lt_bridge_tx.len = (uint16_t)n;
+        if (lt_bridge_send(fd, lt_bridge_tx.buff, TCP_TAG_AND_LENGTH_SIZE + n) != 0) {
+            return;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *spec = NULL;
+    const char *addr = "127.0.0.1";
+    int tcp_port = LT_BRIDGE_PORT_DEFAULT;
+    int spi_speed = LT_BRIDGE_SPI_SPEED_DEFAULT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:p:a:f:h")) != -1) {
+        switch (opt) {
+            case 'c':
+                spec = optarg;
+                break;
+            case 'p':
+                tcp_port = atoi(optarg);
+                break;
+            case 'a':
+                addr = optarg;
+                break;
+            case 'f':
+                spi_speed = atoi(optarg);
+                break;
+            default:
+                lt_bridge_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!spec || (optind != argc) || (tcp_port <= 0) || (tcp_port > 0xffff)
+        || (lt_bridge_chip_parse(spec, spi_speed) != 0)) {
+        lt_bridge_usage(argv[0]);
+        return 1;
+    }
+
+    lt_ret_t ret = lt_init(&lt_bridge_h);
+    if (ret != LT_OK) {
+        fprintf(stderr, "Failed to initialize the chip: %s\n", lt_ret_verbose(ret));
+        return 1;
+    }
+
+    int one = 1;
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons((in_port_t)tcp_port)};
+    sa.sin_addr.s_addr = inet_addr(addr);
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if ((listen_fd < 0) || (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0)
+        || (bind(listen_fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) || (listen(listen_fd, 1) != 0)) {
+        fprintf(stderr, "Cannot listen on %s:%d: %s\n", addr, tcp_port, strerror(errno));
+        ret = lt_deinit(&lt_bridge_h);
+        return 1;
+    }
+    printf("Listening on %s:%d\n", addr, tcp_port);
+
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "accept() failed: %s\n", strerror(errno));
+            break;
+        }
+        // Requests are small and each waits for its reply
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        lt_bridge_serve(fd);
+        close(fd);
+    }
+
+    close(listen_fd);
+    ret = lt_deinit(&lt_bridge_h);
+
+    return (ret == LT_OK) ? 0 : 1;
+}
@@ -0,0 +1,1622 @@
+/**
+ * @file tropic_pkcs11.c
+ * @author Tropic Square s.r.o.
+ * @brief PKCS#11 module over libtropic.
+ *
+ * The module has one slot with one token, TROPIC01 configured by environment variables (see README.md). Objects of
+ * the token are fixed:
+ *
+ * - ECC slot N is a private key and a public key object, both with CKA_ID N and label "ecc-slot-N".
+ * - R-memory data slot N is a data object labelled "rmem-slot-N", with the data of the slot as CKA_VALUE.
+ *
+ * Object handles are derived from the positions of the objects, so they do not change while the module is initialized.
+ * Attributes are read from TROPIC01 once: public keys of all ECC slots when keys are searched for the first time, data
+ * of all R-memory slots when data objects are searched for the first time. C_FindObjects() and C_GetAttributeValue()
+ * are answered from this inventory afterwards, only C_Sign() and C_GenerateRandom() reach the chip.
+ *
+ * One secure session is shared by all PKCS#11 sessions. It is established when the chip is needed for the first time
+ * and again when it was lost, after which the command is retried once.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "p11-kit/pkcs11.h"
+
+#if TROPIC_PKCS11_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t tp11_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t tp11_dev_t;
+#endif
+
+/** ID of the only slot */
+#define TP11_SLOT_ID 0
+/** Maximal number of open sessions */
+#define TP11_SESSIONS_MAX 32
+/** SPI speed used unless set by TROPIC_PKCS11_SPI_SPEED */
+#define TP11_SPI_SPEED_DEFAULT 5000000
+/** Number of R-memory slots read by one lt_r_mem_data_read_range() */
+#define TP11_RMEM_CHUNK 32
+
+/** Number of ECC slots */
+#define TP11_ECC_SLOTS (ECC_SLOT_31 + 1)
+/** Number of R-memory data slots */
+#define TP11_RMEM_SLOTS (R_MEM_DATA_SLOT_MAX + 1)
+/** Index of the first private key object, then public key objects, then data objects */
+#define TP11_OBJ_PRIV 0
+#define TP11_OBJ_PUB (TP11_OBJ_PRIV + TP11_ECC_SLOTS)
+#define TP11_OBJ_DATA (TP11_OBJ_PUB + TP11_ECC_SLOTS)
+#define TP11_OBJ_CNT (TP11_OBJ_DATA + TP11_RMEM_SLOTS)
+
+/** DER of OID of the curves, CKA_EC_PARAMS */
+static const uint8_t tp11_p256_params[] = {0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07};
+static const uint8_t tp11_ed25519_params[] = {0x06, 0x03, 0x2b, 0x65, 0x70};
+/** CKA_APPLICATION of data objects */
+static const char tp11_application[] = "tropic01";
+
+static const CK_MECHANISM_TYPE tp11_mechanisms[] = {CKM_ECDSA, CKM_ECDSA_SHA256, CKM_EDDSA};
+
+/** PKCS#11 session */
+typedef struct tp11_session_t {
+    bool open;
+    CK_FLAGS flags;
+
+    /** Search of C_FindObjectsInit(), `tmpl` holds copies of the attributes and their values */
+    bool find;
+    CK_ATTRIBUTE *tmpl;
+    CK_ULONG tmpl_cnt;
+    CK_ULONG find_next;
+    CK_ULONG find_end;
+
+    /** Signature of C_SignInit() */
+    bool sign;
+    CK_MECHANISM_TYPE mech;
+    ecc_slot_t sign_slot;
+    lt_ecdsa_sign_ctx_t ecdsa;
+    /** Message of CKM_EDDSA collected by C_SignUpdate(), LT_EDDSA_MSG_LEN_MAX bytes */
+    uint8_t *msg;
+    uint16_t msg_len;
+} tp11_session_t;
+
+/** State of the module, guarded by `lock` */
+static struct {
+    pthread_mutex_t lock;
+    bool initialized;
+
+    lt_handle_t h;
+    tp11_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+    uint8_t shipriv[32];
+    uint8_t shipub[32];
+    uint8_t pkey_index;
+    bool session;
+    bool logged_in;
+
+    /** Serial number of the token, read once */
+    bool serial_read;
+    char serial[17];
+
+    /** Inventory of ECC slots */
+    bool ecc_scanned;
+    struct {
+        bool present;
+        lt_ecc_curve_type_t curve;
+        ecc_key_origin_t origin;
+        uint8_t pub[64];
+    } ecc[TP11_ECC_SLOTS];
+
+    /** Inventory of R-memory, `rmem_data` holds R_MEM_DATA_SIZE_MAX bytes per slot */
+    bool rmem_scanned;
+    uint16_t rmem_size[TP11_RMEM_SLOTS];
+    uint8_t *rmem_data;
+
+    tp11_session_t sessions[TP11_SESSIONS_MAX];
+} tp11 = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+/*
+ * Chip
+ */
+
+static CK_RV tp11_rv(const lt_ret_t ret)
+{
+    switch (ret) {
+        case LT_OK:
+            return CKR_OK;
+        case LT_L3_ECC_INVALID_KEY:
+            return CKR_KEY_HANDLE_INVALID;
+        case LT_L3_UNAUTHORIZED:
+            return CKR_FUNCTION_REJECTED;
+        case LT_PARAM_ERR:
+            return CKR_ARGUMENTS_BAD;
+        default:
+            return CKR_DEVICE_ERROR;
+    }
+}
+
+static bool tp11_session_lost(const lt_ret_t ret)
+{
+    switch (ret) {
+        case LT_HOST_NO_SESSION:
+        case LT_L1_CHIP_STARTUP_MODE:
+        case LT_L2_HSK_ERR:
+        case LT_L2_NO_SESSION:
+        case LT_L2_TAG_ERR:
+        case LT_NONCE_OVERFLOW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Executes `fn` in the shared secure session, the session is established again and `fn` retried once if lost */
+static lt_ret_t tp11_chip(lt_ret_t (*fn)(lt_handle_t *h, void *arg), void *arg)
+{
+    lt_ret_t ret = LT_FAIL;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!tp11.session) {
+            ret = lt_verify_chip_and_start_secure_session(&tp11.h, tp11.shipriv, tp11.shipub, tp11.pkey_index);
+            if (ret != LT_OK) {
+                return ret;
+            }
+            tp11.session = true;
+        }
+        ret = fn(&tp11.h, arg);
+        if (!tp11_session_lost(ret)) {
+            break;
+        }
+        tp11.session = false;
+    }
+
+    return ret;
+}
+
+static lt_ret_t tp11_key_inventory(lt_handle_t *h, void *arg) { return lt_ecc_key_inventory(h, arg); }
+
+/** Reads public keys of all ECC slots */
+static CK_RV tp11_ecc_scan(void)
+{
+    lt_ecc_key_info_t info[TP11_ECC_SLOTS];
+
+    if (tp11.ecc_scanned) {
+        return CKR_OK;
+    }
+    lt_ret_t ret = tp11_chip(tp11_key_inventory, info);
+    if (ret != LT_OK) {
+        return tp11_rv(ret);
+    }
+    for (int i = 0; i < TP11_ECC_SLOTS; i++) {
+        // Empty slot, or slot not readable with the pairing key of the module
+        tp11.ecc[i].present = (info[i].status == LT_OK);
+        if (!tp11.ecc[i].present) {
+            continue;
+        }
+        tp11.ecc[i].curve = info[i].curve;
+        tp11.ecc[i].origin = info[i].origin;
+        memcpy(tp11.ecc[i].pub, info[i].key, sizeof(tp11.ecc[i].pub));
+    }
+    tp11.ecc_scanned = true;
+
+    return CKR_OK;
+}
+
+typedef struct tp11_rmem_read_t {
+    uint16_t first;
+    lt_ret_t statuses[TP11_RMEM_CHUNK];
+} tp11_rmem_read_t;
+
+static lt_ret_t tp11_rmem_read(lt_handle_t *h, void *arg)
+{
+    tp11_rmem_read_t *rr = arg;
+
+    return lt_r_mem_data_read_range(h, rr->first, TP11_RMEM_CHUNK, tp11.rmem_data + rr->first * R_MEM_DATA_SIZE_MAX,
+                                    tp11.rmem_size + rr->first, rr->statuses);
+}
+
+/** Reads data of all R-memory slots */
+static CK_RV tp11_rmem_scan(void)
+{
+    tp11_rmem_read_t rr;
+
+    if (tp11.rmem_scanned) {
+        return CKR_OK;
+    }
+    if (!tp11.rmem_data && !(tp11.rmem_data = malloc(TP11_RMEM_SLOTS * R_MEM_DATA_SIZE_MAX))) {
+        return CKR_HOST_MEMORY;
+    }
+    for (rr.first = 0; rr.first < TP11_RMEM_SLOTS; rr.first += TP11_RMEM_CHUNK) {
+        lt_ret_t ret = tp11_chip(tp11_rmem_read, &rr);
+        if (ret != LT_OK) {
+            return tp11_rv(ret);
+        }
+        for (int i = 0; i < TP11_RMEM_CHUNK; i++) {
+            if (rr.statuses[i] != LT_OK) {
+                tp11.rmem_size[rr.first + i] = 0;
+            }
+        }
+    }
+    tp11.rmem_scanned = true;
+
+    return CKR_OK;
+}
+
+/*
+ * Objects
+ */
+
+/** Storage of attribute values which are not kept in the inventory */
+typedef struct tp11_attr_buf_t {
+    CK_OBJECT_CLASS cls;
+    CK_KEY_TYPE key_type;
+    CK_BBOOL b;
+    CK_BYTE id;
+    char label[16];
+    /** DER OCTET STRING of the public key */
+    uint8_t ec_point[2 + 65];
+} tp11_attr_buf_t;
+
+/** Returns true when the object exists, its part of the inventory is read first */
+static bool tp11_obj_present(const CK_ULONG idx)
+{
+    if (idx < TP11_OBJ_DATA) {
+        return (tp11_ecc_scan() == CKR_OK) && tp11.ecc[idx % TP11_ECC_SLOTS].present;
+    }
+    if (idx < TP11_OBJ_CNT) {
+        return (tp11_rmem_scan() == CKR_OK) && tp11.rmem_size[idx - TP11_OBJ_DATA];
+    }
+
+    return false;
+}
+
+static bool tp11_handle_obj(const CK_OBJECT_HANDLE handle, CK_ULONG *idx)
+{
+    if ((handle == CK_INVALID_HANDLE) || (handle > TP11_OBJ_CNT) || !tp11_obj_present(handle - 1)) {
+        return false;
+    }
+    *idx = handle - 1;
+
+    return true;
+}
+
+/** Finds attribute of the object, which is present in the inventory */
+static CK_RV tp11_obj_attr(const CK_ULONG idx, const CK_ATTRIBUTE_TYPE type, tp11_attr_buf_t *buf, const void **val,
+                           CK_ULONG *len)
+{
+    bool data = (idx >= TP11_OBJ_DATA), priv = (idx < TP11_OBJ_PUB);
+    int slot = data ? (int)(idx - TP11_OBJ_DATA) : (int)(idx % TP11_ECC_SLOTS);
+    bool p256 = !data && (tp11.ecc[slot].curve == CURVE_P256);
+    bool generated = !data && (tp11.ecc[slot].origin == CURVE_GENERATED);
+
+#define TP11_ATTR(ptr, size) \
+    do {                     \
+        *val = (ptr);        \
+        *len = (size);       \
+        return CKR_OK;       \
+    } while (0)
+#define TP11_BOOL(v)                        \
+    do {                                    \
+        buf->b = (v) ? CK_TRUE : CK_FALSE;  \
+        TP11_ATTR(&buf->b, sizeof(buf->b)); \
+    } while (0)
+
+    switch (type) {
+        case CKA_CLASS:
+            buf->cls = data ? CKO_DATA : (priv ? CKO_PRIVATE_KEY : CKO_PUBLIC_KEY);
+            TP11_ATTR(&buf->cls, sizeof(buf->cls));
+        case CKA_TOKEN:
+            TP11_BOOL(true);
+        // Access to the objects is given by the pairing key in the configuration of the module, not by a PIN
+        case CKA_PRIVATE:
+        case CKA_MODIFIABLE:
+        case CKA_COPYABLE:
+        case CKA_DESTROYABLE:
+            TP11_BOOL(false);
+        case CKA_LABEL:
+            snprintf(buf->label, sizeof(buf->label), data ? "rmem-slot-%d" : "ecc-slot-%d", slot);
+            TP11_ATTR(buf->label, strlen(buf->label));
+        default:
+            break;
+    }
+
+    if (data) {
+        switch (type) {
+            case CKA_APPLICATION:
+                TP11_ATTR(tp11_application, strlen(tp11_application));
+            case CKA_OBJECT_ID:
+                TP11_ATTR(NULL, 0);
+            case CKA_VALUE:
+                TP11_ATTR(tp11.rmem_data + slot * R_MEM_DATA_SIZE_MAX, tp11.rmem_size[slot]);
+            default:
+                return CKR_ATTRIBUTE_TYPE_INVALID;
+        }
+    }
+
+    switch (type) {
+        case CKA_KEY_TYPE:
+            buf->key_type = p256 ? CKK_EC : CKK_EC_EDWARDS;
+            TP11_ATTR(&buf->key_type, sizeof(buf->key_type));
+        case CKA_ID:
+            buf->id = (CK_BYTE)slot;
+            TP11_ATTR(&buf->id, sizeof(buf->id));
+        case CKA_EC_PARAMS:
+            if (p256) {
+                TP11_ATTR(tp11_p256_params, sizeof(tp11_p256_params));
+            }
+            TP11_ATTR(tp11_ed25519_params, sizeof(tp11_ed25519_params));
+        case CKA_EC_POINT:
+            // Private key objects have it too, so applications find the public key without another object
+            buf->ec_point[0] = 0x04;
+            if (p256) {
+                buf->ec_point[1] = 65;
+                buf->ec_point[2] = 0x04;
+                memcpy(buf->ec_point + 3, tp11.ecc[slot].pub, 64);
+                TP11_ATTR(buf->ec_point, 67);
+            }
+            buf->ec_point[1] = 32;
+            memcpy(buf->ec_point + 2, tp11.ecc[slot].pub, 32);
+            TP11_ATTR(buf->ec_point, 34);
+        case CKA_LOCAL:
+            TP11_BOOL(generated);
+        case CKA_KEY_GEN_MECHANISM:
+            return CKR_ATTRIBUTE_TYPE_INVALID;
+        case CKA_DERIVE:
+        case CKA_ENCRYPT:
+        case CKA_DECRYPT:
+        case CKA_WRAP:
+        case CKA_UNWRAP:
+        case CKA_SIGN_RECOVER:
+        case CKA_VERIFY_RECOVER:
+            TP11_BOOL(false);
+        case CKA_SIGN:
+            TP11_BOOL(priv);
+        case CKA_VERIFY:
+            TP11_BOOL(!priv);
+        default:
+            break;
+    }
+
+    if (!priv) {
+        return CKR_ATTRIBUTE_TYPE_INVALID;
+    }
+    switch (type) {
+        case CKA_SENSITIVE:
+            TP11_BOOL(true);
+        case CKA_EXTRACTABLE:
+        case CKA_ALWAYS_AUTHENTICATE:
+            TP11_BOOL(false);
+        // Stored keys were known outside of the chip
+        case CKA_ALWAYS_SENSITIVE:
+        case CKA_NEVER_EXTRACTABLE:
+            TP11_BOOL(generated);
+        case CKA_VALUE:
+            return CKR_ATTRIBUTE_SENSITIVE;
+        default:
+            return CKR_ATTRIBUTE_TYPE_INVALID;
+    }
+
+#undef TP11_BOOL
+#undef TP11_ATTR
+}
+
+/** Returns true when the object has all attributes of the template with the same values */
+static bool tp11_obj_match(const CK_ULONG idx, const CK_ATTRIBUTE *tmpl, const CK_ULONG cnt)
+{
+    for (CK_ULONG i = 0; i < cnt; i++) {
+        tp11_attr_buf_t buf;
+        const void *val;
+        CK_ULONG len;
+        if ((tp11_obj_attr(idx, tmpl[i].type, &buf, &val, &len) != CKR_OK) || (len != tmpl[i].ulValueLen)
+            || (len && memcmp(val, tmpl[i].pValue, len))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Sessions
+ */
+
+static tp11_session_t *tp11_session(const CK_SESSION_HANDLE handle)
+{
+    if ((handle == CK_INVALID_HANDLE) || (handle > TP11_SESSIONS_MAX) || !tp11.sessions[handle - 1].open) {
+        return NULL;
+    }
+
+    return &tp11.sessions[handle - 1];
+}
+
+static void tp11_find_end(tp11_session_t *s)
+{
+    for (CK_ULONG i = 0; i < s->tmpl_cnt; i++) {
+        free(s->tmpl[i].pValue);
+    }
+    free(s->tmpl);
+    s->tmpl = NULL;
+    s->tmpl_cnt = 0;
+    s->find = false;
+}
+
+static void tp11_sign_end(tp11_session_t *s)
+{
+    free(s->msg);
+    s->msg = NULL;
+    s->msg_len = 0;
+    memset(&s->ecdsa, 0, sizeof(s->ecdsa));
+    s->sign = false;
+}
+
+static void tp11_session_close(tp11_session_t *s)
+{
+    tp11_find_end(s);
+    tp11_sign_end(s);
+    memset(s, 0, sizeof(*s));
+}
+
+/** Copies string to a field of PKCS#11 info structure, padded with spaces */
+static void tp11_pad(unsigned char *dst, const size_t size, const char *src)
+{
+    size_t len = strlen(src);
+
+    memset(dst, ' ', size);
+    memcpy(dst, src, (len < size) ? len : size);
+}
+
+/** Sets the device up from TROPIC_PKCS11_CHIP, same format as `-c` of tropicd */
+static bool tp11_dev_parse(const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+    tp11_dev_t *dev = &tp11.dev;
+
+    memset(dev, 0, sizeof(*dev));
+    if (!spec || (strlen(spec) >= sizeof(buf))) {
+        return false;
+    }
+    strcpy(buf, spec);
+
+#if TROPIC_PKCS11_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return false;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return false;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return false;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return false;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return false;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL);
+
+    return true;
+}
+
+static bool tp11_key_file(const char *path, uint8_t *key)
+{
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f) {
+        return false;
+    }
+
+    size_t len = fread(key, 1, 32, f);
+    int extra = fgetc(f);
+    fclose(f);
+
+    return (len == 32) && (extra == EOF);
+}
+
+/*
+ * General purpose functions
+ */
+
+CK_RV C_Initialize(CK_VOID_PTR pInitArgs)
+{
+    CK_C_INITIALIZE_ARGS *args = pInitArgs;
+    const char *pkey_index = getenv("TROPIC_PKCS11_PKEY_INDEX"), *spi_speed = getenv("TROPIC_PKCS11_SPI_SPEED");
+    CK_RV rv = CKR_OK;
+
+    if (args) {
+        if (args->pReserved) {
+            return CKR_ARGUMENTS_BAD;
+        }
+        // Mutexes of the application are not used, the module locks by pthreads
+        if (args->CreateMutex && !(args->flags & CKF_OS_LOCKING_OK)) {
+            return CKR_CANT_LOCK;
+        }
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (tp11.initialized) {
+        rv = CKR_CRYPTOKI_ALREADY_INITIALIZED;
+        goto unlock;
+    }
+    tp11.pkey_index = pkey_index ? (uint8_t)atoi(pkey_index) : 0;
+    if (!tp11_dev_parse(getenv("TROPIC_PKCS11_CHIP"), spi_speed ? atoi(spi_speed) : TP11_SPI_SPEED_DEFAULT)
+        || !tp11_key_file(getenv("TROPIC_PKCS11_SHIPRIV"), tp11.shipriv)
+        || !tp11_key_file(getenv("TROPIC_PKCS11_SHIPUB"), tp11.shipub) || (tp11.pkey_index > PAIRING_KEY_SLOT_INDEX_3)) {
+        rv = CKR_GENERAL_ERROR;
+        goto unlock;
+    }
+
+    memset(&tp11.h, 0, sizeof(tp11.h));
+    tp11.h.l2.device = &tp11.dev;
+#if LT_SEPARATE_L3_BUFF
+    tp11.h.l3.buff = tp11.l3_buffer;
+    tp11.h.l3.buff_len = sizeof(tp11.l3_buffer);
+#endif
+    if (lt_init(&tp11.h) != LT_OK) {
+        rv = CKR_DEVICE_ERROR;
+        goto unlock;
+    }
+    tp11.initialized = true;
+
+unlock:
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_Finalize(CK_VOID_PTR pReserved)
+{
+    if (pReserved) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        pthread_mutex_unlock(&tp11.lock);
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    for (int i = 0; i < TP11_SESSIONS_MAX; i++) {
+        tp11_session_close(&tp11.sessions[i]);
+    }
+    if (tp11.session) {
+        lt_session_abort(&tp11.h);
+    }
+    lt_deinit(&tp11.h);
+    free(tp11.rmem_data);
+    memset(tp11.shipriv, 0, sizeof(tp11.shipriv));
+    tp11.rmem_data = NULL;
+    tp11.session = tp11.logged_in = tp11.serial_read = false;
+    tp11.ecc_scanned = tp11.rmem_scanned = false;
+    tp11.initialized = false;
+    pthread_mutex_unlock(&tp11.lock);
+
+    return CKR_OK;
+}
+
+CK_RV C_GetInfo(CK_INFO_PTR pInfo)
+{
+    if (!tp11.initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (!pInfo) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    memset(pInfo, 0, sizeof(*pInfo));
+    pInfo->cryptokiVersion.major = 2;
+    pInfo->cryptokiVersion.minor = 40;
+    tp11_pad(pInfo->manufacturerID, sizeof(pInfo->manufacturerID), "Tropic Square");
+    tp11_pad(pInfo->libraryDescription, sizeof(pInfo->libraryDescription), "libtropic PKCS#11 module");
+    pInfo->libraryVersion.major = 0;
+    pInfo->libraryVersion.minor = 1;
+
+    return CKR_OK;
+}
+
+/*
+ * Slot and token management functions
+ */
+
+CK_RV C_GetSlotList(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR pSlotList, CK_ULONG_PTR pulCount)
+{
+    (void)tokenPresent;
+    if (!tp11.initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (!pulCount) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    if (pSlotList) {
+        if (*pulCount < 1) {
+            *pulCount = 1;
+            return CKR_BUFFER_TOO_SMALL;
+        }
+        pSlotList[0] = TP11_SLOT_ID;
+    }
+    *pulCount = 1;
+
+    return CKR_OK;
+}
+
+CK_RV C_GetSlotInfo(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pInfo)
+{
+    if (!tp11.initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (slotID != TP11_SLOT_ID) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    if (!pInfo) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    memset(pInfo, 0, sizeof(*pInfo));
+    tp11_pad(pInfo->slotDescription, sizeof(pInfo->slotDescription), "TROPIC01");
+    tp11_pad(pInfo->manufacturerID, sizeof(pInfo->manufacturerID), "Tropic Square");
+    pInfo->flags = CKF_TOKEN_PRESENT | CKF_HW_SLOT;
+
+    return CKR_OK;
+}
+
+static lt_ret_t tp11_serial_read(void)
+{
+    struct lt_chip_id_t chip_id;
+    lt_ret_t ret = lt_get_info_chip_id(&tp11.h, &chip_id);
+
+    if (ret == LT_OK) {
+        const struct lt_ser_num_t *sn = &chip_id.ser_num;
+        snprintf(tp11.serial, sizeof(tp11.serial), "%02X%02X%02X%04X%04X", sn->lot_id[3], sn->lot_id[4], sn->wafer_id,
+                 sn->x_coord, sn->y_coord);
+        tp11.serial_read = true;
+    }
+
+    return ret;
+}
+
+CK_RV C_GetTokenInfo(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR pInfo)
+{
+    if (slotID != TP11_SLOT_ID) {
+        return tp11.initialized ? CKR_SLOT_ID_INVALID : CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (!pInfo) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        pthread_mutex_unlock(&tp11.lock);
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (!tp11.serial_read && (tp11_serial_read() != LT_OK)) {
+        pthread_mutex_unlock(&tp11.lock);
+        return CKR_DEVICE_ERROR;
+    }
+
+    CK_ULONG cnt = 0, rw_cnt = 0;
+    for (int i = 0; i < TP11_SESSIONS_MAX; i++) {
+        cnt += tp11.sessions[i].open;
+        rw_cnt += tp11.sessions[i].open && (tp11.sessions[i].flags & CKF_RW_SESSION);
+    }
+    memset(pInfo, 0, sizeof(*pInfo));
+    tp11_pad(pInfo->label, sizeof(pInfo->label), "TROPIC01");
+    tp11_pad(pInfo->manufacturerID, sizeof(pInfo->manufacturerID), "Tropic Square");
+    tp11_pad(pInfo->model, sizeof(pInfo->model), "TROPIC01");
+    tp11_pad(pInfo->serialNumber, sizeof(pInfo->serialNumber), tp11.serial);
+    pInfo->flags = CKF_RNG | CKF_WRITE_PROTECTED | CKF_TOKEN_INITIALIZED;
+    pInfo->ulMaxSessionCount = TP11_SESSIONS_MAX;
+    pInfo->ulSessionCount = cnt;
+    pInfo->ulMaxRwSessionCount = TP11_SESSIONS_MAX;
+    pInfo->ulRwSessionCount = rw_cnt;
+    pInfo->ulTotalPublicMemory = CK_UNAVAILABLE_INFORMATION;
+    pInfo->ulFreePublicMemory = CK_UNAVAILABLE_INFORMATION;
+    pInfo->ulTotalPrivateMemory = CK_UNAVAILABLE_INFORMATION;
+    pInfo->ulFreePrivateMemory = CK_UNAVAILABLE_INFORMATION;
+    pthread_mutex_unlock(&tp11.lock);
+
+    return CKR_OK;
+}
+
+CK_RV C_GetMechanismList(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMechanismList, CK_ULONG_PTR pulCount)
+{
+    CK_ULONG cnt = sizeof(tp11_mechanisms) / sizeof(tp11_mechanisms[0]);
+
+    if (!tp11.initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (slotID != TP11_SLOT_ID) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    if (!pulCount) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    if (pMechanismList) {
+        if (*pulCount < cnt) {
+            *pulCount = cnt;
+            return CKR_BUFFER_TOO_SMALL;
+        }
+        memcpy(pMechanismList, tp11_mechanisms, sizeof(tp11_mechanisms));
+    }
+    *pulCount = cnt;
+
+    return CKR_OK;
+}
+
+CK_RV C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_MECHANISM_INFO_PTR pInfo)
+{
+    if (!tp11.initialized) {
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (slotID != TP11_SLOT_ID) {
+        return CKR_SLOT_ID_INVALID;
+    }
+    if (!pInfo) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    switch (type) {
+        case CKM_ECDSA:
+        case CKM_ECDSA_SHA256:
+            pInfo->ulMinKeySize = pInfo->ulMaxKeySize = 256;
+            pInfo->flags = CKF_HW | CKF_SIGN | CKF_EC_F_P | CKF_EC_NAMEDCURVE | CKF_EC_UNCOMPRESS;
+            return CKR_OK;
+        case CKM_EDDSA:
+            pInfo->ulMinKeySize = pInfo->ulMaxKeySize = 255;
+            pInfo->flags = CKF_HW | CKF_SIGN;
+            return CKR_OK;
+        default:
+            return CKR_MECHANISM_INVALID;
+    }
+}
+
+/*
+ * Session management functions
+ */
+
+CK_RV C_OpenSession(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify,
+                    CK_SESSION_HANDLE_PTR phSession)
+{
+    CK_RV rv = CKR_SESSION_COUNT;
+
+    (void)pApplication;
+    (void)Notify;
+    if (slotID != TP11_SLOT_ID) {
+        return tp11.initialized ? CKR_SLOT_ID_INVALID : CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    if (!(flags & CKF_SERIAL_SESSION)) {
+        return CKR_SESSION_PARALLEL_NOT_SUPPORTED;
+    }
+    if (!phSession) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    for (int i = 0; tp11.initialized && (i < TP11_SESSIONS_MAX); i++) {
+        if (!tp11.sessions[i].open) {
+            tp11.sessions[i].open = true;
+            tp11.sessions[i].flags = flags;
+            *phSession = (CK_SESSION_HANDLE)i + 1;
+            rv = CKR_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_CloseSession(CK_SESSION_HANDLE hSession)
+{
+    CK_RV rv = CKR_OK;
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else {
+        tp11_session_close(s);
+        bool any = false;
+        for (int i = 0; i < TP11_SESSIONS_MAX; i++) {
+            any |= tp11.sessions[i].open;
+        }
+        // Login state belongs to the application, it ends with its last session
+        tp11.logged_in &= any;
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_CloseAllSessions(CK_SLOT_ID slotID)
+{
+    if (slotID != TP11_SLOT_ID) {
+        return tp11.initialized ? CKR_SLOT_ID_INVALID : CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        pthread_mutex_unlock(&tp11.lock);
+        return CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    for (int i = 0; i < TP11_SESSIONS_MAX; i++) {
+        tp11_session_close(&tp11.sessions[i]);
+    }
+    tp11.logged_in = false;
+    pthread_mutex_unlock(&tp11.lock);
+
+    return CKR_OK;
+}
+
+CK_RV C_GetSessionInfo(CK_SESSION_HANDLE hSession, CK_SESSION_INFO_PTR pInfo)
+{
+    CK_RV rv = CKR_OK;
+
+    if (!pInfo) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else {
+        bool rw = (s->flags & CKF_RW_SESSION);
+        pInfo->slotID = TP11_SLOT_ID;
+        pInfo->flags = s->flags;
+        pInfo->ulDeviceError = 0;
+        if (tp11.logged_in) {
+            pInfo->state = rw ? CKS_RW_USER_FUNCTIONS : CKS_RO_USER_FUNCTIONS;
+        }
+        else {
+            pInfo->state = rw ? CKS_RW_PUBLIC_SESSION : CKS_RO_PUBLIC_SESSION;
+        }
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+/** The token needs no login, it is accepted for applications which log in anyway */
+CK_RV C_Login(CK_SESSION_HANDLE hSession, CK_USER_TYPE userType, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen)
+{
+    CK_RV rv = CKR_OK;
+
+    (void)pPin;
+    (void)ulPinLen;
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!tp11_session(hSession)) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (userType != CKU_USER) {
+        rv = CKR_USER_TYPE_INVALID;
+    }
+    else if (tp11.logged_in) {
+        rv = CKR_USER_ALREADY_LOGGED_IN;
+    }
+    else {
+        tp11.logged_in = true;
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_Logout(CK_SESSION_HANDLE hSession)
+{
+    CK_RV rv = CKR_OK;
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!tp11_session(hSession)) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (!tp11.logged_in) {
+        rv = CKR_USER_NOT_LOGGED_IN;
+    }
+    else {
+        tp11.logged_in = false;
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+/*
+ * Object management functions
+ */
+
+CK_RV C_GetAttributeValue(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate,
+                          CK_ULONG ulCount)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG idx;
+
+    if (!pTemplate && ulCount) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+        goto unlock;
+    }
+    if (!tp11_session(hSession)) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+        goto unlock;
+    }
+    if (!tp11_handle_obj(hObject, &idx)) {
+        rv = CKR_OBJECT_HANDLE_INVALID;
+        goto unlock;
+    }
+
+    // All attributes are processed, the last error is returned
+    for (CK_ULONG i = 0; i < ulCount; i++) {
+        tp11_attr_buf_t buf;
+        const void *val;
+        CK_ULONG len;
+        CK_RV attr_rv = tp11_obj_attr(idx, pTemplate[i].type, &buf, &val, &len);
+        if (attr_rv != CKR_OK) {
+            pTemplate[i].ulValueLen = CK_UNAVAILABLE_INFORMATION;
+            rv = attr_rv;
+        }
+        else if (!pTemplate[i].pValue) {
+            pTemplate[i].ulValueLen = len;
+        }
+        else if (pTemplate[i].ulValueLen < len) {
+            pTemplate[i].ulValueLen = CK_UNAVAILABLE_INFORMATION;
+            rv = CKR_BUFFER_TOO_SMALL;
+        }
+        else {
+            if (len) {
+                memcpy(pTemplate[i].pValue, val, len);
+            }
+            pTemplate[i].ulValueLen = len;
+        }
+    }
+
+unlock:
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_FindObjectsInit(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
+{
+    CK_RV rv = CKR_OK;
+    bool keys = true, data = true;
+
+    if (!pTemplate && ulCount) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+        goto unlock;
+    }
+    if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+        goto unlock;
+    }
+    if (s->find) {
+        rv = CKR_OPERATION_ACTIVE;
+        goto unlock;
+    }
+
+    if (ulCount && !(s->tmpl = calloc(ulCount, sizeof(CK_ATTRIBUTE)))) {
+        rv = CKR_HOST_MEMORY;
+        goto unlock;
+    }
+    for (CK_ULONG i = 0; i < ulCount; i++, s->tmpl_cnt++) {
+        s->tmpl[i].type = pTemplate[i].type;
+        s->tmpl[i].ulValueLen = pTemplate[i].ulValueLen;
+        if (pTemplate[i].ulValueLen) {
+            if (!pTemplate[i].pValue) {
+                rv = CKR_ATTRIBUTE_VALUE_INVALID;
+                break;
+            }
+            if (!(s->tmpl[i].pValue = malloc(pTemplate[i].ulValueLen))) {
+                rv = CKR_HOST_MEMORY;
+                break;
+            }
+            memcpy(s->tmpl[i].pValue, pTemplate[i].pValue, pTemplate[i].ulValueLen);
+        }
+        // Only the part of the inventory which can match is read
+        if ((pTemplate[i].type == CKA_CLASS) && (pTemplate[i].ulValueLen == sizeof(CK_OBJECT_CLASS))) {
+            CK_OBJECT_CLASS cls;
+            memcpy(&cls, pTemplate[i].pValue, sizeof(cls));
+            keys &= (cls == CKO_PRIVATE_KEY) || (cls == CKO_PUBLIC_KEY);
+            data &= (cls == CKO_DATA);
+        }
+    }
+    if ((rv == CKR_OK) && keys) {
+        rv = tp11_ecc_scan();
+    }
+    if ((rv == CKR_OK) && data) {
+        rv = tp11_rmem_scan();
+    }
+    if (rv != CKR_OK) {
+        tp11_find_end(s);
+        goto unlock;
+    }
+    // Key objects precede data objects
+    s->find = true;
+    s->find_next = keys ? TP11_OBJ_PRIV : TP11_OBJ_DATA;
+    s->find_end = data ? TP11_OBJ_CNT : TP11_OBJ_DATA;
+
+unlock:
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_FindObjects(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount,
+                    CK_ULONG_PTR pulObjectCount)
+{
+    CK_RV rv = CKR_OK;
+
+    if (!pulObjectCount || (!phObject && ulMaxObjectCount)) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (!s->find) {
+        rv = CKR_OPERATION_NOT_INITIALIZED;
+    }
+    else {
+        CK_ULONG cnt = 0;
+        for (; (s->find_next < s->find_end) && (cnt < ulMaxObjectCount); s->find_next++) {
+            // The inventory was read by C_FindObjectsInit()
+            CK_ULONG idx = s->find_next;
+            if (tp11_obj_present(idx) && tp11_obj_match(idx, s->tmpl, s->tmpl_cnt)) {
+                phObject[cnt++] = idx + 1;
+            }
+        }
+        *pulObjectCount = cnt;
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_FindObjectsFinal(CK_SESSION_HANDLE hSession)
+{
+    CK_RV rv = CKR_OK;
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (!s->find) {
+        rv = CKR_OPERATION_NOT_INITIALIZED;
+    }
+    else {
+        tp11_find_end(s);
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+/*
+ * Signing functions
+ */
+
+CK_RV C_SignInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG idx;
+
+    if (!pMechanism) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+        goto unlock;
+    }
+    if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+        goto unlock;
+    }
+    if (s->sign) {
+        rv = CKR_OPERATION_ACTIVE;
+        goto unlock;
+    }
+    if (!tp11_handle_obj(hKey, &idx) || (idx >= TP11_OBJ_PUB)) {
+        rv = CKR_KEY_HANDLE_INVALID;
+        goto unlock;
+    }
+
+    lt_ecc_curve_type_t curve = tp11.ecc[idx].curve;
+    switch (pMechanism->mechanism) {
+        case CKM_ECDSA:
+        case CKM_ECDSA_SHA256:
+            if (curve != CURVE_P256) {
+                rv = CKR_KEY_TYPE_INCONSISTENT;
+            }
+            else if ((pMechanism->mechanism == CKM_ECDSA_SHA256) && (lt_ecdsa_sign_init(&s->ecdsa) != LT_OK)) {
+                rv = CKR_GENERAL_ERROR;
+            }
+            break;
+        case CKM_EDDSA:
+            // Ed25519ph and contexts are not supported by TROPIC01
+            if (curve != CURVE_ED25519) {
+                rv = CKR_KEY_TYPE_INCONSISTENT;
+            }
+            else if (pMechanism->pParameter) {
+                rv = CKR_MECHANISM_PARAM_INVALID;
+            }
+            else if (!(s->msg = malloc(LT_EDDSA_MSG_LEN_MAX))) {
+                rv = CKR_HOST_MEMORY;
+            }
+            break;
+        default:
+            rv = CKR_MECHANISM_INVALID;
+            break;
+    }
+    if (rv == CKR_OK) {
+        s->sign = true;
+        s->mech = pMechanism->mechanism;
+        s->sign_slot = (ecc_slot_t)idx;
+        s->msg_len = 0;
+    }
+
+unlock:
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+typedef struct tp11_sign_t {
+    tp11_session_t *s;
+    const uint8_t *in;
+    uint16_t in_len;
+    uint8_t rs[64];
+} tp11_sign_t;
+
+static lt_ret_t tp11_sign(lt_handle_t *h, void *arg)
+{
+    tp11_sign_t *sg = arg;
+
+    switch (sg->s->mech) {
+        case CKM_ECDSA:
+            return lt_ecc_ecdsa_sign_digest(h, sg->s->sign_slot, sg->in, sg->rs);
+        case CKM_ECDSA_SHA256: {
+            // Context is wiped by lt_ecdsa_sign_final(), a copy is signed so the sign can be retried
+            lt_ecdsa_sign_ctx_t ctx = sg->s->ecdsa;
+            return lt_ecdsa_sign_final(h, &ctx, sg->s->sign_slot, sg->rs);
+        }
+        default:
+            return lt_ecc_eddsa_sign(h, sg->s->sign_slot, sg->in, sg->in_len, sg->rs);
+    }
+}
+
+/** Adds data to multi-part signature */
+static CK_RV tp11_sign_update(tp11_session_t *s, const CK_BYTE *data, const CK_ULONG len)
+{
+    switch (s->mech) {
+        case CKM_ECDSA_SHA256:
+            return (lt_ecdsa_sign_update(&s->ecdsa, data, (uint32_t)len) == LT_OK) ? CKR_OK : CKR_GENERAL_ERROR;
+        case CKM_EDDSA:
+            if (len > (CK_ULONG)(LT_EDDSA_MSG_LEN_MAX - s->msg_len)) {
+                return CKR_DATA_LEN_RANGE;
+            }
+            memcpy(s->msg + s->msg_len, data, len);
+            s->msg_len += (uint16_t)len;
+            return CKR_OK;
+        default:
+            // Raw ECDSA signs one digest, it has no parts
+            return CKR_FUNCTION_NOT_SUPPORTED;
+    }
+}
+
+/** Finishes signature, `in` is the digest of CKM_ECDSA and unused for the other mechanisms */
+static CK_RV tp11_sign_final(tp11_session_t *s, const CK_BYTE *in, const CK_ULONG in_len, CK_BYTE_PTR pSignature,
+                             CK_ULONG_PTR pulSignatureLen)
+{
+    tp11_sign_t sg = {.s = s, .in = in, .in_len = (uint16_t)in_len};
+    CK_RV rv;
+
+    // Size query and too small buffer keep the operation active
+    if (!pSignature) {
+        *pulSignatureLen = sizeof(sg.rs);
+        return CKR_OK;
+    }
+    if (*pulSignatureLen < sizeof(sg.rs)) {
+        *pulSignatureLen = sizeof(sg.rs);
+        return CKR_BUFFER_TOO_SMALL;
+    }
+
+    if (s->mech == CKM_EDDSA) {
+        sg.in = s->msg;
+        sg.in_len = s->msg_len;
+    }
+    rv = tp11_rv(tp11_chip(tp11_sign, &sg));
+    if (rv == CKR_OK) {
+        memcpy(pSignature, sg.rs, sizeof(sg.rs));
+        *pulSignatureLen = sizeof(sg.rs);
+    }
+    memset(sg.rs, 0, sizeof(sg.rs));
+    tp11_sign_end(s);
+
+    return rv;
+}
+
+CK_RV C_Sign(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature,
+             CK_ULONG_PTR pulSignatureLen)
+{
+    CK_RV rv;
+
+    if ((!pData && ulDataLen) || !pulSignatureLen) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (!s->sign) {
+        rv = CKR_OPERATION_NOT_INITIALIZED;
+    }
+    else if ((s->mech == CKM_ECDSA) && (ulDataLen != 32)) {
+        tp11_sign_end(s);
+        rv = CKR_DATA_LEN_RANGE;
+    }
+    else if (s->mech == CKM_ECDSA) {
+        rv = tp11_sign_final(s, pData, ulDataLen, pSignature, pulSignatureLen);
+    }
+    // Size query returns before the data are added, so they are added once
+    else if (pSignature && (*pulSignatureLen >= 64) && ((rv = tp11_sign_update(s, pData, ulDataLen)) != CKR_OK)) {
+        tp11_sign_end(s);
+    }
+    else {
+        rv = tp11_sign_final(s, NULL, 0, pSignature, pulSignatureLen);
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_SignUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
+{
+    CK_RV rv;
+
+    if (!pPart && ulPartLen) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (!s->sign) {
+        rv = CKR_OPERATION_NOT_INITIALIZED;
+    }
+    else if ((rv = tp11_sign_update(s, pPart, ulPartLen)) != CKR_OK) {
+        tp11_sign_end(s);
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_SignFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen)
+{
+    CK_RV rv;
+
+    if (!pulSignatureLen) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    tp11_session_t *s = tp11_session(hSession);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!s) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    else if (!s->sign) {
+        rv = CKR_OPERATION_NOT_INITIALIZED;
+    }
+    else if (s->mech == CKM_ECDSA) {
+        tp11_sign_end(s);
+        rv = CKR_FUNCTION_NOT_SUPPORTED;
+    }
+    else {
+        rv = tp11_sign_final(s, NULL, 0, pSignature, pulSignatureLen);
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+/*
+ * Random number generation functions
+ */
+
+typedef struct tp11_random_t {
+    uint8_t *buff;
+    uint16_t len;
+} tp11_random_t;
+
+static lt_ret_t tp11_random(lt_handle_t *h, void *arg)
+{
+    tp11_random_t *rnd = arg;
+
+    return lt_random_value_get(h, rnd->buff, rnd->len);
+}
+
+CK_RV C_GenerateRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR RandomData, CK_ULONG ulRandomLen)
+{
+    CK_RV rv = CKR_OK;
+
+    if (!RandomData && ulRandomLen) {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    pthread_mutex_lock(&tp11.lock);
+    if (!tp11.initialized) {
+        rv = CKR_CRYPTOKI_NOT_INITIALIZED;
+    }
+    else if (!tp11_session(hSession)) {
+        rv = CKR_SESSION_HANDLE_INVALID;
+    }
+    for (CK_ULONG done = 0; (rv == CKR_OK) && (done < ulRandomLen);) {
+        CK_ULONG left = ulRandomLen - done;
+        tp11_random_t rnd = {.buff = RandomData + done,
+                             .len = (uint16_t)((left < RANDOM_VALUE_GET_LEN_MAX) ? left : RANDOM_VALUE_GET_LEN_MAX)};
+        rv = tp11_rv(tp11_chip(tp11_random, &rnd));
+        done += rnd.len;
+    }
+    pthread_mutex_unlock(&tp11.lock);
+
+    return rv;
+}
+
+CK_RV C_SeedRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSeed, CK_ULONG ulSeedLen)
+{
+    (void)hSession;
+    (void)pSeed;
+    (void)ulSeedLen;
+
+    return tp11.initialized ? CKR_RANDOM_SEED_NOT_SUPPORTED : CKR_CRYPTOKI_NOT_INITIALIZED;
+}
+
+/*
+ * Functions which are not supported
+ */
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+#define TP11_NOT_SUPPORTED(name, args) \
+    CK_RV name args { return CKR_FUNCTION_NOT_SUPPORTED; }
+
+TP11_NOT_SUPPORTED(C_WaitForSlotEvent, (CK_FLAGS flags, CK_SLOT_ID_PTR pSlot, CK_VOID_PTR pReserved))
+TP11_NOT_SUPPORTED(C_InitToken, (CK_SLOT_ID slotID, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen, CK_UTF8CHAR_PTR pLabel))
+TP11_NOT_SUPPORTED(C_InitPIN, (CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen))
+TP11_NOT_SUPPORTED(C_SetPIN, (CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pOldPin, CK_ULONG ulOldLen,
+                              CK_UTF8CHAR_PTR pNewPin, CK_ULONG ulNewLen))
+TP11_NOT_SUPPORTED(C_GetOperationState,
+                   (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pOperationState, CK_ULONG_PTR pulOperationStateLen))
+TP11_NOT_SUPPORTED(C_SetOperationState,
+                   (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pOperationState, CK_ULONG ulOperationStateLen,
+                    CK_OBJECT_HANDLE hEncryptionKey, CK_OBJECT_HANDLE hAuthenticationKey))
+TP11_NOT_SUPPORTED(C_CreateObject, (CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount,
+                                    CK_OBJECT_HANDLE_PTR phObject))
+TP11_NOT_SUPPORTED(C_CopyObject, (CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate,
+                                  CK_ULONG ulCount, CK_OBJECT_HANDLE_PTR phNewObject))
+TP11_NOT_SUPPORTED(C_DestroyObject, (CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject))
+TP11_NOT_SUPPORTED(C_GetObjectSize, (CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ULONG_PTR pulSize))
+TP11_NOT_SUPPORTED(C_SetAttributeValue,
+                   (CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount))
+TP11_NOT_SUPPORTED(C_EncryptInit, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey))
+TP11_NOT_SUPPORTED(C_Encrypt, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen,
+                               CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen))
+TP11_NOT_SUPPORTED(C_EncryptUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen,
+                                     CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen))
+TP11_NOT_SUPPORTED(C_EncryptFinal,
+                   (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pLastEncryptedPart, CK_ULONG_PTR pulLastEncryptedPartLen))
+TP11_NOT_SUPPORTED(C_DecryptInit, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey))
+TP11_NOT_SUPPORTED(C_Decrypt, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen,
+                               CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen))
+TP11_NOT_SUPPORTED(C_DecryptUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedPart,
+                                     CK_ULONG ulEncryptedPartLen, CK_BYTE_PTR pPart, CK_ULONG_PTR pulPartLen))
+TP11_NOT_SUPPORTED(C_DecryptFinal, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pLastPart, CK_ULONG_PTR pulLastPartLen))
+TP11_NOT_SUPPORTED(C_DigestInit, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism))
+TP11_NOT_SUPPORTED(C_Digest, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pDigest,
+                              CK_ULONG_PTR pulDigestLen))
+TP11_NOT_SUPPORTED(C_DigestUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen))
+TP11_NOT_SUPPORTED(C_DigestKey, (CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hKey))
+TP11_NOT_SUPPORTED(C_DigestFinal, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDigest, CK_ULONG_PTR pulDigestLen))
+TP11_NOT_SUPPORTED(C_SignRecoverInit, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey))
+TP11_NOT_SUPPORTED(C_SignRecover, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen,
+                                   CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen))
+TP11_NOT_SUPPORTED(C_VerifyInit, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey))
+TP11_NOT_SUPPORTED(C_Verify, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen,
+                              CK_BYTE_PTR pSignature, CK_ULONG ulSignatureLen))
+TP11_NOT_SUPPORTED(C_VerifyUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen))
+TP11_NOT_SUPPORTED(C_VerifyFinal, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG ulSignatureLen))
+TP11_NOT_SUPPORTED(C_VerifyRecoverInit,
+                   (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey))
+TP11_NOT_SUPPORTED(C_VerifyRecover, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG ulSignatureLen,
+                                     CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen))
+TP11_NOT_SUPPORTED(C_DigestEncryptUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen,
+                                           CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen))
+TP11_NOT_SUPPORTED(C_DecryptDigestUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedPart,
+                                           CK_ULONG ulEncryptedPartLen, CK_BYTE_PTR pPart, CK_ULONG_PTR pulPartLen))
+TP11_NOT_SUPPORTED(C_SignEncryptUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen,
+                                         CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen))
+TP11_NOT_SUPPORTED(C_DecryptVerifyUpdate, (CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedPart,
+                                           CK_ULONG ulEncryptedPartLen, CK_BYTE_PTR pPart, CK_ULONG_PTR pulPartLen))
+TP11_NOT_SUPPORTED(C_GenerateKey, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_ATTRIBUTE_PTR pTemplate,
+                                   CK_ULONG ulCount, CK_OBJECT_HANDLE_PTR phKey))
+TP11_NOT_SUPPORTED(C_GenerateKeyPair,
+                   (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_ATTRIBUTE_PTR pPublicKeyTemplate,
+                    CK_ULONG ulPublicKeyAttributeCount, CK_ATTRIBUTE_PTR pPrivateKeyTemplate,
+                    CK_ULONG ulPrivateKeyAttributeCount, CK_OBJECT_HANDLE_PTR phPublicKey,
+                    CK_OBJECT_HANDLE_PTR phPrivateKey))
+TP11_NOT_SUPPORTED(C_WrapKey, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hWrappingKey,
+                               CK_OBJECT_HANDLE hKey, CK_BYTE_PTR pWrappedKey, CK_ULONG_PTR pulWrappedKeyLen))
+TP11_NOT_SUPPORTED(C_UnwrapKey,
+                   (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hUnwrappingKey,
+                    CK_BYTE_PTR pWrappedKey, CK_ULONG ulWrappedKeyLen, CK_ATTRIBUTE_PTR pTemplate,
+                    CK_ULONG ulAttributeCount, CK_OBJECT_HANDLE_PTR phKey))
+TP11_NOT_SUPPORTED(C_DeriveKey, (CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hBaseKey,
+                                 CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulAttributeCount, CK_OBJECT_HANDLE_PTR phKey))
+
+/** Legacy functions of parallel sessions */
+CK_RV C_GetFunctionStatus(CK_SESSION_HANDLE hSession) { return CKR_FUNCTION_NOT_PARALLEL; }
+CK_RV C_CancelFunction(CK_SESSION_HANDLE hSession) { return CKR_FUNCTION_NOT_PARALLEL; }
+
+#pragma GCC diagnostic pop
+
+static CK_FUNCTION_LIST tp11_function_list = {
+    .version = {2, 40},
+    .C_Initialize = C_Initialize,
+    .C_Finalize = C_Finalize,
+    .C_GetInfo = C_GetInfo,
+    .C_GetFunctionList = C_GetFunctionList,
+    .C_GetSlotList = C_GetSlotList,
+    .C_GetSlotInfo = C_GetSlotInfo,
+    .C_GetTokenInfo = C_GetTokenInfo,
+    .C_GetMechanismList = C_GetMechanismList,
+    .C_GetMechanismInfo = C_GetMechanismInfo,
+    .C_InitToken = C_InitToken,
+    .C_InitPIN = C_InitPIN,
+    .C_SetPIN = C_SetPIN,
+    .C_OpenSession = C_OpenSession,
+    .C_CloseSession = C_CloseSession,
+    .C_CloseAllSessions = C_CloseAllSessions,
+    .C_GetSessionInfo = C_GetSessionInfo,
+    .C_GetOperationState = C_GetOperationState,
+    .C_SetOperationState = C_SetOperationState,
+    .C_Login = C_Login,
+    .C_Logout = C_Logout,
+    .C_CreateObject = C_CreateObject,
+    .C_CopyObject = C_CopyObject,
+    .C_DestroyObject = C_DestroyObject,
+    .C_GetObjectSize = C_GetObjectSize,
+    .C_GetAttributeValue = C_GetAttributeValue,
+    .C_SetAttributeValue = C_SetAttributeValue,
+    .C_FindObjectsInit = C_FindObjectsInit,
+    .C_FindObjects = C_FindObjects,
+    .C_FindObjectsFinal = C_FindObjectsFinal,
+    .C_EncryptInit = C_EncryptInit,
+    .C_Encrypt = C_Encrypt,
+    .C_EncryptUpdate = C_EncryptUpdate,
+    .C_EncryptFinal = C_EncryptFinal,
+    .C_DecryptInit = C_DecryptInit,
+    .C_Decrypt = C_Decrypt,
+    .C_DecryptUpdate = C_DecryptUpdate,
+    .C_DecryptFinal = C_DecryptFinal,
+    .C_DigestInit = C_DigestInit,
+    .C_Digest = C_Digest,
+    .C_DigestUpdate = C_DigestUpdate,
+    .C_DigestKey = C_DigestKey,
+    .C_DigestFinal = C_DigestFinal,
+    .C_SignInit = C_SignInit,
+    .C_Sign = C_Sign,
+    .C_SignUpdate = C_SignUpdate,
+    .C_SignFinal = C_SignFinal,
+    .C_SignRecoverInit = C_SignRecoverInit,
+    .C_SignRecover = C_SignRecover,
+    .C_VerifyInit = C_VerifyInit,
+    .C_Verify = C_Verify,
+    .C_VerifyUpdate = C_VerifyUpdate,
+    .C_VerifyFinal = C_VerifyFinal,
+    .C_VerifyRecoverInit = C_VerifyRecoverInit,
+    .C_VerifyRecover = C_VerifyRecover,
+    .C_DigestEncryptUpdate = C_DigestEncryptUpdate,
+    .C_DecryptDigestUpdate = C_DecryptDigestUpdate,
+    .C_SignEncryptUpdate = C_SignEncryptUpdate,
+    .C_DecryptVerifyUpdate = C_DecryptVerifyUpdate,
+    .C_GenerateKey = C_GenerateKey,
+    .C_GenerateKeyPair = C_GenerateKeyPair,
+    .C_WrapKey = C_WrapKey,
+    .C_UnwrapKey = C_UnwrapKey,
+    .C_DeriveKey = C_DeriveKey,
+    .C_SeedRandom = C_SeedRandom,
+    .C_GenerateRandom = C_GenerateRandom,
+    .C_GetFunctionStatus = C_GetFunctionStatus,
+    .C_CancelFunction = C_CancelFunction,
+    .C_WaitForSlotEvent = C_WaitForSlotEvent,
+};
+
+CK_RV C_GetFunctionList(CK_FUNCTION_LIST_PTR_PTR ppFunctionList)
+{
+    if (!ppFunctionList) {
+        return CKR_ARGUMENTS_BAD;
+    }
+    *ppFunctionList = &tp11_function_list;
+
+    return CKR_OK;
+}
@@ -0,0 +1,1202 @@
+/**
+ * @file tropic_provider.c
+ * @author Tropic Square s.r.o.
+ * @brief OpenSSL 3 provider signing by ECC keys stored in TROPIC01.
+ *
+ * Provides key management and signature for P-256 ("EC", signed by ECDSA) and Ed25519 keys. A key refers to a slot
+ * of TROPIC01 and carries only its public key, which is read when the key is "generated" with the slot given by
+ * TROPIC_PROV_PARAM_SLOT.
+ *
+ * The handle is owned by a worker thread, which executes signatures by `lt_submit()` and `lt_poll()`. A caller
+ * running in an ASYNC_JOB is paused while the chip signs, with an eventfd registered in the wait context of the job,
+ * so a TLS server thread can have many handshakes in flight. Other callers block until their signature is done.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/async.h>
+#include <openssl/bn.h>
+#include <openssl/core.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+#if TROPIC_PROV_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t tropic_prov_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t tropic_prov_dev_t;
+#endif
+
+#if !LT_ASYNC
+#error "tropic_provider needs libtropic built with LT_ASYNC"
+#endif
+
+/** Name of the provider */
+#define TROPIC_PROV_NAME "tropic01"
+/** Parameter of key generation selecting the slot of the key */
+#define TROPIC_PROV_PARAM_SLOT "tropic01-slot"
+/** Maximal length of DER encoded ECDSA signature over P-256 */
+#define TROPIC_PROV_ECDSA_SIG_MAX 72
+/** SPI speed used unless set by spi_speed */
+#define TROPIC_PROV_SPI_SPEED_DEFAULT 5000000
+
+/** DER of AlgorithmIdentifier ecdsa-with-SHA256 */
+static const uint8_t tropic_prov_ecdsa_sha256_algid[] = {0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48,
+                                                         0xce, 0x3d, 0x04, 0x03, 0x02};
+/** DER of AlgorithmIdentifier Ed25519 */
+static const uint8_t tropic_prov_ed25519_algid[] = {0x30, 0x05, 0x06, 0x03, 0x2b, 0x65, 0x70};
+
+struct tropic_prov_t;
+
+/**
+ * Request executed by the worker. It is either an operation of `lt_submit()`, or, when `fn` is set, a blocking call
+ * made while the queue of the handle is empty.
+ */
+typedef struct tropic_prov_req_t {
+    struct tropic_prov_t *prov;
+    lt_async_op_t op;
+    lt_ret_t (*fn)(lt_handle_t *h, void *arg);
+    void *arg;
+    lt_ret_t ret;
+    /** Set by the worker, the request is not touched by it afterwards */
+    int done;
+    /** Eventfd of the wait context of the paused job, -1 for blocked callers */
+    int notify_fd;
+    struct tropic_prov_req_t *next;
+} tropic_prov_req_t;
+
+/** Provider context */
+typedef struct tropic_prov_t {
+    const OSSL_CORE_HANDLE *core;
+    /** Library context of the provider, digests are fetched from it */
+    OSSL_LIB_CTX *libctx;
+
+    lt_handle_t h;
+    lt_async_t async;
+    tropic_prov_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+    uint8_t shipriv[32];
+    uint8_t shipub[32];
+    uint8_t pkey_index;
+    /** Nonzero when the secure session is established, used by the worker only */
+    uint8_t session;
+
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;
+    /** Wakes the worker up when a request is queued */
+    int wake_efd;
+    int quit;
+    /** Requests not taken by the worker yet */
+    tropic_prov_req_t *pending;
+    tropic_prov_req_t *pending_tail;
+} tropic_prov_t;
+
+/** Key referring to a slot of TROPIC01, or only a public key, e.g. imported from a certificate */
+typedef struct tropic_prov_key_t {
+    tropic_prov_t *prov;
+    lt_ecc_curve_type_t curve;
+    /** ECC slot, -1 for public key only */
+    int slot;
+    /** Public key, x || y for P-256 */
+    uint8_t pub[64];
+    size_t pub_len;
+} tropic_prov_key_t;
+
+/** Context of key generation, which reads the key of a slot */
+typedef struct tropic_prov_gen_t {
+    tropic_prov_t *prov;
+    lt_ecc_curve_type_t curve;
+    int slot;
+} tropic_prov_gen_t;
+
+/** Signature context */
+typedef struct tropic_prov_sig_t {
+    tropic_prov_t *prov;
+    tropic_prov_key_t *key;
+    /** Digest of ECDSA, NULL until set */
+    EVP_MD *md;
+    EVP_MD_CTX *mdctx;
+} tropic_prov_sig_t;
+
+/*
+ * Worker
+ */
+
+/** Returns true when the error means the secure session has to be established again */
+static bool tropic_prov_session_lost(const lt_ret_t ret)
+{
+    switch (ret) {
+        case LT_HOST_NO_SESSION:
+        case LT_L1_CHIP_STARTUP_MODE:
+        case LT_L2_HSK_ERR:
+        case LT_L2_NO_SESSION:
+        case LT_L2_TAG_ERR:
+        case LT_NONCE_OVERFLOW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void tropic_prov_req_complete(tropic_prov_req_t *req, const lt_ret_t ret)
+{
+    tropic_prov_t *p = req->prov;
+    uint64_t one = 1;
+
+    req->ret = ret;
+    // Paused job is woken up before `done` is set, it keeps pausing until it sees `done`
+    if (req->notify_fd >= 0) {
+        ssize_t unused = write(req->notify_fd, &one, sizeof(one));
+        (void)unused;
+    }
+    pthread_mutex_lock(&p->lock);
+    __atomic_store_n(&req->done, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&p->done_cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void tropic_prov_op_done(lt_handle_t *h, lt_async_op_t *op, void *ctx)
+{
+    tropic_prov_req_t *req = (tropic_prov_req_t *)ctx;
+
+    (void)h;
+    if (tropic_prov_session_lost(op->ret)) {
+        req->prov->session = 0;
+    }
+    tropic_prov_req_complete(req, op->ret);
+}
+
+/** Starts requests taken from the queue, the handle has no operation in progress */
+static void tropic_prov_start(tropic_prov_t *p, tropic_prov_req_t *reqs)
+{
+    lt_ret_t ret = LT_OK;
+
+    if (!p->session) {
+        ret = lt_verify_chip_and_start_secure_session(&p->h, p->shipriv, p->shipub, p->pkey_index);
+        p->session = (ret == LT_OK);
+    }
+
+    while (reqs) {
+        tropic_prov_req_t *req = reqs;
+        reqs = req->next;
+        if (ret != LT_OK) {
+            tropic_prov_req_complete(req, ret);
+        }
+        else if (req->fn) {
+            // Calls run before the operations submitted below, so the handle is still idle
+            lt_ret_t call_ret = req->fn(&p->h, req->arg);
+            if (tropic_prov_session_lost(call_ret)) {
+                p->session = 0;
+            }
+            tropic_prov_req_complete(req, call_ret);
+        }
+        else {
+            lt_ret_t submit_ret = lt_submit(&p->h, &req->op, tropic_prov_op_done, req);
+            if (submit_ret != LT_OK) {
+                tropic_prov_req_complete(req, submit_ret);
+            }
+        }
+    }
+}
+
+static void *tropic_prov_worker(void *arg)
+{
+    tropic_prov_t *p = (tropic_prov_t *)arg;
+    tropic_prov_req_t *waiting = NULL, *waiting_tail = NULL;
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->quit) {
+        if (p->pending) {
+            if (waiting) {
+                waiting_tail->next = p->pending;
+            }
+            else {
+                waiting = p->pending;
+            }
+            waiting_tail = p->pending_tail;
+            p->pending = p->pending_tail = NULL;
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        uint32_t wait_ms = 0;
+        if (p->async.head) {
+            lt_poll(&p->h, &wait_ms);
+        }
+        // New requests wait until the queue of the handle is empty, session may need to be established again
+        if (!p->async.head && waiting) {
+            tropic_prov_start(p, waiting);
+            waiting = waiting_tail = NULL;
+            pthread_mutex_lock(&p->lock);
+            continue;
+        }
+
+        struct pollfd pfd = {.fd = p->wake_efd, .events = POLLIN};
+        if (poll(&pfd, 1, p->async.head ? (int)wait_ms : -1) > 0) {
+            uint64_t cnt;
+            ssize_t unused = read(p->wake_efd, &cnt, sizeof(cnt));
+            (void)unused;
+        }
+        pthread_mutex_lock(&p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    // Requests of a provider being unloaded are not expected, they are failed in any case
+    for (tropic_prov_req_t *req = waiting; req;) {
+        tropic_prov_req_t *next = req->next;
+        tropic_prov_req_complete(req, LT_FAIL);
+        req = next;
+    }
+
+    return NULL;
+}
+
+static void tropic_prov_wait_fd_cleanup(ASYNC_WAIT_CTX *ctx, const void *key, OSSL_ASYNC_FD fd, void *custom)
+{
+    (void)ctx;
+    (void)key;
+    (void)custom;
+    close(fd);
+}
+
+/** Queues the request for the worker and waits for its completion, pausing the current ASYNC_JOB if there is one */
+static lt_ret_t tropic_prov_req_run(tropic_prov_t *p, tropic_prov_req_t *req)
+{
+    ASYNC_JOB *job = ASYNC_get_current_job();
+    OSSL_ASYNC_FD fd = -1;
+    uint64_t one = 1;
+
+    req->prov = p;
+    req->done = 0;
+    req->next = NULL;
+    if (job) {
+        ASYNC_WAIT_CTX *waitctx = ASYNC_get_wait_ctx(job);
+        void *custom;
+        if (!ASYNC_WAIT_CTX_get_fd(waitctx, p, &fd, &custom)) {
+            fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if ((fd >= 0) && !ASYNC_WAIT_CTX_set_wait_fd(waitctx, p, fd, NULL, tropic_prov_wait_fd_cleanup)) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        if (fd < 0) {
+            job = NULL;
+        }
+    }
+    req->notify_fd = fd;
+
+    pthread_mutex_lock(&p->lock);
+    if (p->pending) {
+        p->pending_tail->next = req;
+    }
+    else {
+        p->pending = req;
+    }
+    p->pending_tail = req;
+    pthread_mutex_unlock(&p->lock);
+    if (write(p->wake_efd, &one, sizeof(one)) != sizeof(one)) {
+        // The worker still takes the request when it wakes up for another one
+    }
+
+    while (job && !__atomic_load_n(&req->done, __ATOMIC_ACQUIRE)) {
+        if (!ASYNC_pause_job()) {
+            job = NULL;
+        }
+    }
+    if (req->notify_fd >= 0) {
+        uint64_t cnt;
+        ssize_t unused = read(req->notify_fd, &cnt, sizeof(cnt));
+        (void)unused;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    while (!req->done) {
+        pthread_cond_wait(&p->done_cond, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return req->ret;
+}
+
+/*
+ * Key management
+ */
+
+typedef struct tropic_prov_key_read_t {
+    int slot;
+    uint8_t pub[64];
+    lt_ecc_curve_type_t curve;
+} tropic_prov_key_read_t;
+
+static lt_ret_t tropic_prov_key_read(lt_handle_t *h, void *arg)
+{
+    tropic_prov_key_read_t *kr = (tropic_prov_key_read_t *)arg;
+    ecc_key_origin_t origin;
+
+    return lt_ecc_key_read(h, (ecc_slot_t)kr->slot, kr->pub, &kr->curve, &origin);
+}
+
+static tropic_prov_key_t *tropic_prov_key_new(tropic_prov_t *p, const lt_ecc_curve_type_t curve)
+{
+    tropic_prov_key_t *key = OPENSSL_zalloc(sizeof(*key));
+    if (key) {
+        key->prov = p;
+        key->curve = curve;
+        key->slot = -1;
+    }
+
+    return key;
+}
+
+static void *tropic_prov_ec_new(void *provctx) { return tropic_prov_key_new(provctx, CURVE_P256); }
+
+static void *tropic_prov_ed25519_new(void *provctx) { return tropic_prov_key_new(provctx, CURVE_ED25519); }
+
+static void tropic_prov_key_free(void *keydata) { OPENSSL_free(keydata); }
+
+static int tropic_prov_key_has(const void *keydata, int selection)
+{
+    const tropic_prov_key_t *key = keydata;
+
+    if (!key) {
+        return 0;
+    }
+    if ((selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY) && (key->slot < 0)) {
+        return 0;
+    }
+    if ((selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY) && !key->pub_len) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static int tropic_prov_key_match(const void *keydata1, const void *keydata2, int selection)
+{
+    const tropic_prov_key_t *k1 = keydata1, *k2 = keydata2;
+
+    if (k1->curve != k2->curve) {
+        return 0;
+    }
+    // Private keys in the chip are compared by their public keys, as they cannot be read
+    if (selection & OSSL_KEYMGMT_SELECT_KEYPAIR) {
+        return (k1->pub_len == k2->pub_len) && !memcmp(k1->pub, k2->pub, k1->pub_len);
+    }
+
+    return 1;
+}
+
+/** Encoded public key, 0x04 || x || y for P-256 */
+static size_t tropic_prov_key_encode(const tropic_prov_key_t *key, uint8_t *buf)
+{
+    if (key->curve == CURVE_P256) {
+        buf[0] = POINT_CONVERSION_UNCOMPRESSED;
+        memcpy(buf + 1, key->pub, 64);
+        return 65;
+    }
+    memcpy(buf, key->pub, 32);
+
+    return 32;
+}
+
+static int tropic_prov_key_get_params(void *keydata, OSSL_PARAM params[])
+{
+    tropic_prov_key_t *key = keydata;
+    bool ec = (key->curve == CURVE_P256);
+    uint8_t enc[65];
+    OSSL_PARAM *p;
+
+    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_BITS)) && !OSSL_PARAM_set_int(p, ec ? 256 : 253)) {
+        return 0;
+    }
+    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_SECURITY_BITS)) && !OSSL_PARAM_set_int(p, 128)) {
+        return 0;
+    }
+    if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_MAX_SIZE))
+        && !OSSL_PARAM_set_int(p, ec ? TROPIC_PROV_ECDSA_SIG_MAX : 64)) {
+        return 0;
+    }
+    if (ec && (p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_GROUP_NAME))
+        && !OSSL_PARAM_set_utf8_string(p, SN_X9_62_prime256v1)) {
+        return 0;
+    }
+    if (ec && (p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_DEFAULT_DIGEST))
+        && !OSSL_PARAM_set_utf8_string(p, "SHA256")) {
+        return 0;
+    }
+    if (!ec && (p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_MANDATORY_DIGEST))
+        && !OSSL_PARAM_set_utf8_string(p, "")) {
+        return 0;
+    }
+    if (key->pub_len) {
+        size_t len = tropic_prov_key_encode(key, enc);
+        if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY))
+            && !OSSL_PARAM_set_octet_string(p, enc, len)) {
+            return 0;
+        }
+        if ((p = OSSL_PARAM_locate(params, OSSL_PKEY_PARAM_PUB_KEY)) && !OSSL_PARAM_set_octet_string(p, enc, len)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static const OSSL_PARAM *tropic_prov_ec_gettable_params(void *provctx)
+{
+    static const OSSL_PARAM gettable[] = {OSSL_PARAM_int(OSSL_PKEY_PARAM_BITS, NULL),
+                                          OSSL_PARAM_int(OSSL_PKEY_PARAM_SECURITY_BITS, NULL),
+                                          OSSL_PARAM_int(OSSL_PKEY_PARAM_MAX_SIZE, NULL),
+                                          OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, NULL, 0),
+                                          OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_DEFAULT_DIGEST, NULL, 0),
+                                          OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, NULL, 0),
+                                          OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+                                          OSSL_PARAM_END};
+    (void)provctx;
+    return gettable;
+}
+
+static const OSSL_PARAM *tropic_prov_ed25519_gettable_params(void *provctx)
+{
+    static const OSSL_PARAM gettable[] = {OSSL_PARAM_int(OSSL_PKEY_PARAM_BITS, NULL),
+                                          OSSL_PARAM_int(OSSL_PKEY_PARAM_SECURITY_BITS, NULL),
+                                          OSSL_PARAM_int(OSSL_PKEY_PARAM_MAX_SIZE, NULL),
+                                          OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_MANDATORY_DIGEST, NULL, 0),
+                                          OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, NULL, 0),
+                                          OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+                                          OSSL_PARAM_END};
+    (void)provctx;
+    return gettable;
+}
+
+/** Public key can be imported, e.g. by EVP_PKEY_eq() comparing the key to the key of a certificate */
+static int tropic_prov_key_import(void *keydata, int selection, const OSSL_PARAM params[])
+{
+    tropic_prov_key_t *key = keydata;
+    const OSSL_PARAM *p;
+    const void *pub;
+    size_t pub_len;
+
+    if (!key || (selection & OSSL_KEYMGMT_SELECT_PRIVATE_KEY)) {
+        return 0;
+    }
+    if ((key->curve == CURVE_P256) && (p = OSSL_PARAM_locate_const(params, OSSL_PKEY_PARAM_GROUP_NAME))) {
+        const char *group;
+        if (!OSSL_PARAM_get_utf8_string_ptr(p, &group)
+            || (strcmp(group, SN_X9_62_prime256v1) && strcmp(group, "P-256"))) {
+            return 0;
+        }
+    }
+    if (!(selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY)) {
+        return 1;
+    }
+    p = OSSL_PARAM_locate_const(params, OSSL_PKEY_PARAM_PUB_KEY);
+    if (!p || !OSSL_PARAM_get_octet_string_ptr(p, &pub, &pub_len)) {
+        return 0;
+    }
+    if (key->curve == CURVE_P256) {
+        if ((pub_len != 65) || (((const uint8_t *)pub)[0] != POINT_CONVERSION_UNCOMPRESSED)) {
+            return 0;
+        }
+        memcpy(key->pub, (const uint8_t *)pub + 1, 64);
+        key->pub_len = 64;
+    }
+    else {
+        if (pub_len != 32) {
+            return 0;
+        }
+        memcpy(key->pub, pub, 32);
+        key->pub_len = 32;
+    }
+
+    return 1;
+}
+
+static const OSSL_PARAM tropic_prov_ec_key_types[] = {OSSL_PARAM_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, NULL, 0),
+                                                      OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+                                                      OSSL_PARAM_END};
+
+static const OSSL_PARAM tropic_prov_ed25519_key_types[] = {OSSL_PARAM_octet_string(OSSL_PKEY_PARAM_PUB_KEY, NULL, 0),
+                                                           OSSL_PARAM_END};
+
+static const OSSL_PARAM *tropic_prov_ec_key_types_get(int selection)
+{
+    (void)selection;
+    return tropic_prov_ec_key_types;
+}
+
+static const OSSL_PARAM *tropic_prov_ed25519_key_types_get(int selection)
+{
+    (void)selection;
+    return tropic_prov_ed25519_key_types;
+}
+
+/** Only the public part is exported, e.g. to verify signatures by another provider */
+static int tropic_prov_key_export(void *keydata, int selection, OSSL_CALLBACK *param_cb, void *cbarg)
+{
+    tropic_prov_key_t *key = keydata;
+    uint8_t enc[65];
+    OSSL_PARAM params[3];
+    int n = 0;
+
+    if (!key || !key->pub_len || !(selection & OSSL_KEYMGMT_SELECT_PUBLIC_KEY)) {
+        return 0;
+    }
+    if (key->curve == CURVE_P256) {
+        params[n++] = OSSL_PARAM_construct_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, SN_X9_62_prime256v1, 0);
+    }
+    params[n++] = OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY, enc, tropic_prov_key_encode(key, enc));
+    params[n] = OSSL_PARAM_construct_end();
+
+    return param_cb(params, cbarg);
+}
+
+static const char *tropic_prov_ec_query_operation_name(int operation_id)
+{
+    return (operation_id == OSSL_OP_SIGNATURE) ? "ECDSA" : NULL;
+}
+
+static void *tropic_prov_gen_init(void *provctx, const lt_ecc_curve_type_t curve, int selection,
+                                  const OSSL_PARAM params[]);
+
+static int tropic_prov_gen_set_params(void *genctx, const OSSL_PARAM params[])
+{
+    tropic_prov_gen_t *gen = genctx;
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, TROPIC_PROV_PARAM_SLOT);
+
+    if (p && (!OSSL_PARAM_get_int(p, &gen->slot) || (gen->slot < ECC_SLOT_0) || (gen->slot > ECC_SLOT_31))) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static void *tropic_prov_gen_init(void *provctx, const lt_ecc_curve_type_t curve, int selection,
+                                  const OSSL_PARAM params[])
+{
+    tropic_prov_gen_t *gen;
+
+    if (!(selection & OSSL_KEYMGMT_SELECT_KEYPAIR) || !(gen = OPENSSL_zalloc(sizeof(*gen)))) {
+        return NULL;
+    }
+    gen->prov = provctx;
+    gen->curve = curve;
+    gen->slot = -1;
+    if (!tropic_prov_gen_set_params(gen, params)) {
+        OPENSSL_free(gen);
+        return NULL;
+    }
+
+    return gen;
+}
+
+static void *tropic_prov_ec_gen_init(void *provctx, int selection, const OSSL_PARAM params[])
+{
+    return tropic_prov_gen_init(provctx, CURVE_P256, selection, params);
+}
+
+static void *tropic_prov_ed25519_gen_init(void *provctx, int selection, const OSSL_PARAM params[])
+{
+    return tropic_prov_gen_init(provctx, CURVE_ED25519, selection, params);
+}
+
+static const OSSL_PARAM *tropic_prov_gen_settable_params(void *genctx, void *provctx)
+{
+    static const OSSL_PARAM settable[] = {OSSL_PARAM_int(TROPIC_PROV_PARAM_SLOT, NULL), OSSL_PARAM_END};
+    (void)genctx;
+    (void)provctx;
+    return settable;
+}
+
+/** Keys are generated by lt_ecc_key_generate() beforehand, the generation only takes the public key of the slot */
+static void *tropic_prov_gen(void *genctx, OSSL_CALLBACK *cb, void *cbarg)
+{
+    tropic_prov_gen_t *gen = genctx;
+    tropic_prov_key_read_t kr = {.slot = gen->slot};
+    tropic_prov_req_t req = {.fn = tropic_prov_key_read, .arg = &kr};
+
+    (void)cb;
+    (void)cbarg;
+    if ((gen->slot < 0) || (tropic_prov_req_run(gen->prov, &req) != LT_OK) || (kr.curve != gen->curve)) {
+        return NULL;
+    }
+
+    tropic_prov_key_t *key = tropic_prov_key_new(gen->prov, gen->curve);
+    if (key) {
+        key->slot = gen->slot;
+        key->pub_len = (gen->curve == CURVE_P256) ? 64 : 32;
+        memcpy(key->pub, kr.pub, key->pub_len);
+    }
+
+    return key;
+}
+
+static void tropic_prov_gen_cleanup(void *genctx) { OPENSSL_free(genctx); }
+
+/*
+ * Signature
+ */
+
+/** Signs by the key of the signature context, `in` is the digest for P-256 and the message for Ed25519 */
+static int tropic_prov_chip_sign(tropic_prov_sig_t *sig, const uint8_t *in, const size_t in_len, uint8_t *rs)
+{
+    tropic_prov_req_t req = {0};
+
+    if (!sig->key || (sig->key->slot < 0) || (in_len > UINT16_MAX)) {
+        return 0;
+    }
+    req.op.cmd = (sig->key->curve == CURVE_P256) ? LT_ASYNC_ECDSA_SIGN_DIGEST : LT_ASYNC_EDDSA_SIGN;
+    req.op.slot = (uint16_t)sig->key->slot;
+    req.op.in = in;
+    req.op.in_len = (uint16_t)in_len;
+    req.op.out = rs;
+
+    return tropic_prov_req_run(sig->prov, &req) == LT_OK;
+}
+
+static void *tropic_prov_sig_newctx(void *provctx, const char *propq)
+{
+    tropic_prov_sig_t *sig = OPENSSL_zalloc(sizeof(*sig));
+
+    (void)propq;
+    if (sig) {
+        sig->prov = provctx;
+    }
+
+    return sig;
+}
+
+static void tropic_prov_sig_freectx(void *ctx)
+{
+    tropic_prov_sig_t *sig = ctx;
+
+    if (sig) {
+        EVP_MD_CTX_free(sig->mdctx);
+        EVP_MD_free(sig->md);
+        OPENSSL_free(sig);
+    }
+}
+
+static void *tropic_prov_sig_dupctx(void *ctx)
+{
+    tropic_prov_sig_t *src = ctx;
+    tropic_prov_sig_t *dst = OPENSSL_zalloc(sizeof(*dst));
+
+    if (!dst) {
+        return NULL;
+    }
+    dst->prov = src->prov;
+    dst->key = src->key;
+    if ((src->md && !EVP_MD_up_ref(src->md)) || (src->mdctx && !(dst->mdctx = EVP_MD_CTX_new()))
+        || (src->mdctx && !EVP_MD_CTX_copy_ex(dst->mdctx, src->mdctx))) {
+        tropic_prov_sig_freectx(dst);
+        return NULL;
+    }
+    dst->md = src->md;
+
+    return dst;
+}
+
+/** Sets digest of ECDSA, TROPIC01 signs 32 B digests only */
+static int tropic_prov_sig_set_md(tropic_prov_sig_t *sig, const char *mdname)
+{
+    EVP_MD *md = EVP_MD_fetch(sig->prov->libctx, (mdname && *mdname) ? mdname : "SHA256", NULL);
+
+    if (!md || (EVP_MD_get_size(md) != 32)) {
+        EVP_MD_free(md);
+        return 0;
+    }
+    EVP_MD_free(sig->md);
+    sig->md = md;
+
+    return 1;
+}
+
+static int tropic_prov_sig_set_ctx_params(void *ctx, const OSSL_PARAM params[])
+{
+    tropic_prov_sig_t *sig = ctx;
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, OSSL_SIGNATURE_PARAM_DIGEST);
+    const char *mdname;
+
+    if (p && (!OSSL_PARAM_get_utf8_string_ptr(p, &mdname) || !tropic_prov_sig_set_md(sig, mdname))) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static const OSSL_PARAM *tropic_prov_sig_settable_ctx_params(void *ctx, void *provctx)
+{
+    static const OSSL_PARAM settable[] = {OSSL_PARAM_utf8_string(OSSL_SIGNATURE_PARAM_DIGEST, NULL, 0),
+                                          OSSL_PARAM_END};
+    (void)ctx;
+    (void)provctx;
+    return settable;
+}
+
+static int tropic_prov_sig_get_ctx_params(void *ctx, OSSL_PARAM params[])
+{
+    tropic_prov_sig_t *sig = ctx;
+    OSSL_PARAM *p = OSSL_PARAM_locate(params, OSSL_SIGNATURE_PARAM_ALGORITHM_ID);
+
+    if (!p || !sig->key) {
+        return 1;
+    }
+    if (sig->key->curve == CURVE_ED25519) {
+        return OSSL_PARAM_set_octet_string(p, tropic_prov_ed25519_algid, sizeof(tropic_prov_ed25519_algid));
+    }
+    // Other digests have no identifier here, callers needing it use SHA-256 as TLS and CMS do by default
+    if (sig->md && EVP_MD_is_a(sig->md, "SHA256")) {
+        return OSSL_PARAM_set_octet_string(p, tropic_prov_ecdsa_sha256_algid, sizeof(tropic_prov_ecdsa_sha256_algid));
+    }
+
+    return 1;
+}
+
+static const OSSL_PARAM *tropic_prov_sig_gettable_ctx_params(void *ctx, void *provctx)
+{
+    static const OSSL_PARAM gettable[] = {OSSL_PARAM_octet_string(OSSL_SIGNATURE_PARAM_ALGORITHM_ID, NULL, 0),
+                                          OSSL_PARAM_END};
+    (void)ctx;
+    (void)provctx;
+    return gettable;
+}
+
+static int tropic_prov_sig_init(tropic_prov_sig_t *sig, void *keydata, const lt_ecc_curve_type_t curve,
+                                const OSSL_PARAM params[])
+{
+    tropic_prov_key_t *key = keydata;
+
+    if (key) {
+        if ((key->curve != curve) || (key->slot < 0)) {
+            return 0;
+        }
+        sig->key = key;
+    }
+    if (!sig->key) {
+        return 0;
+    }
+
+    return tropic_prov_sig_set_ctx_params(sig, params);
+}
+
+static int tropic_prov_ecdsa_sign_init(void *ctx, void *keydata, const OSSL_PARAM params[])
+{
+    return tropic_prov_sig_init(ctx, keydata, CURVE_P256, params);
+}
+
+/** DER encoded signature of raw R || S */
+static int tropic_prov_ecdsa_der(const uint8_t *rs, unsigned char *out, size_t *out_len)
+{
+    ECDSA_SIG *s = ECDSA_SIG_new();
+    BIGNUM *r = BN_bin2bn(rs, 32, NULL), *ss = BN_bin2bn(rs + 32, 32, NULL);
+    int ok = 0;
+
+    if (s && r && ss && ECDSA_SIG_set0(s, r, ss)) {
+        r = ss = NULL;
+        int len = i2d_ECDSA_SIG(s, &out);
+        if (len > 0) {
+            *out_len = (size_t)len;
+            ok = 1;
+        }
+    }
+    BN_free(r);
+    BN_free(ss);
+    ECDSA_SIG_free(s);
+
+    return ok;
+}
+
+static int tropic_prov_ecdsa_sign(void *ctx, unsigned char *out, size_t *out_len, size_t out_size,
+                                  const unsigned char *tbs, size_t tbs_len)
+{
+    uint8_t rs[64];
+
+    if (!out) {
+        *out_len = TROPIC_PROV_ECDSA_SIG_MAX;
+        return 1;
+    }
+    if ((out_size < TROPIC_PROV_ECDSA_SIG_MAX) || (tbs_len != 32) || !tropic_prov_chip_sign(ctx, tbs, tbs_len, rs)) {
+        return 0;
+    }
+
+    return tropic_prov_ecdsa_der(rs, out, out_len);
+}
+
+static int tropic_prov_ecdsa_digest_sign_init(void *ctx, const char *mdname, void *keydata, const OSSL_PARAM params[])
+{
+    tropic_prov_sig_t *sig = ctx;
+
+    if (!tropic_prov_sig_init(sig, keydata, CURVE_P256, params) || !tropic_prov_sig_set_md(sig, mdname)) {
+        return 0;
+    }
+    if (!sig->mdctx && !(sig->mdctx = EVP_MD_CTX_new())) {
+        return 0;
+    }
+
+    return EVP_DigestInit_ex2(sig->mdctx, sig->md, NULL);
+}
+
+static int tropic_prov_ecdsa_digest_sign_update(void *ctx, const unsigned char *data, size_t data_len)
+{
+    tropic_prov_sig_t *sig = ctx;
+
+    return sig->mdctx && EVP_DigestUpdate(sig->mdctx, data, data_len);
+}
+
+static int tropic_prov_ecdsa_digest_sign_final(void *ctx, unsigned char *out, size_t *out_len, size_t out_size)
+{
+    tropic_prov_sig_t *sig = ctx;
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len;
+
+    if (!sig->mdctx) {
+        return 0;
+    }
+    if (!out) {
+        *out_len = TROPIC_PROV_ECDSA_SIG_MAX;
+        return 1;
+    }
+    if (!EVP_DigestFinal_ex(sig->mdctx, digest, &digest_len)) {
+        return 0;
+    }
+
+    return tropic_prov_ecdsa_sign(ctx, out, out_len, out_size, digest, digest_len);
+}
+
+static int tropic_prov_ed25519_digest_sign_init(void *ctx, const char *mdname, void *keydata,
+                                                const OSSL_PARAM params[])
+{
+    // Ed25519 hashes the message itself
+    if (mdname && *mdname) {
+        return 0;
+    }
+
+    return tropic_prov_sig_init(ctx, keydata, CURVE_ED25519, params);
+}
+
+static int tropic_prov_ed25519_digest_sign(void *ctx, unsigned char *out, size_t *out_len, size_t out_size,
+                                           const unsigned char *tbs, size_t tbs_len)
+{
+    if (!out) {
+        *out_len = 64;
+        return 1;
+    }
+    if ((out_size < 64) || (tbs_len > LT_EDDSA_MSG_LEN_MAX) || !tropic_prov_chip_sign(ctx, tbs, tbs_len, out)) {
+        return 0;
+    }
+    *out_len = 64;
+
+    return 1;
+}
+
+/*
+ * Algorithms and provider
+ */
+
+static const OSSL_DISPATCH tropic_prov_ec_keymgmt[] = {
+    {OSSL_FUNC_KEYMGMT_NEW, (void (*)(void))tropic_prov_ec_new},
+    {OSSL_FUNC_KEYMGMT_FREE, (void (*)(void))tropic_prov_key_free},
+    {OSSL_FUNC_KEYMGMT_HAS, (void (*)(void))tropic_prov_key_has},
+    {OSSL_FUNC_KEYMGMT_MATCH, (void (*)(void))tropic_prov_key_match},
+    {OSSL_FUNC_KEYMGMT_GET_PARAMS, (void (*)(void))tropic_prov_key_get_params},
+    {OSSL_FUNC_KEYMGMT_GETTABLE_PARAMS, (void (*)(void))tropic_prov_ec_gettable_params},
+    {OSSL_FUNC_KEYMGMT_IMPORT, (void (*)(void))tropic_prov_key_import},
+    {OSSL_FUNC_KEYMGMT_IMPORT_TYPES, (void (*)(void))tropic_prov_ec_key_types_get},
+    {OSSL_FUNC_KEYMGMT_EXPORT, (void (*)(void))tropic_prov_key_export},
+    {OSSL_FUNC_KEYMGMT_EXPORT_TYPES, (void (*)(void))tropic_prov_ec_key_types_get},
+    {OSSL_FUNC_KEYMGMT_QUERY_OPERATION_NAME, (void (*)(void))tropic_prov_ec_query_operation_name},
+    {OSSL_FUNC_KEYMGMT_GEN_INIT, (void (*)(void))tropic_prov_ec_gen_init},
+    {OSSL_FUNC_KEYMGMT_GEN_SET_PARAMS, (void (*)(void))tropic_prov_gen_set_params},
+    {OSSL_FUNC_KEYMGMT_GEN_SETTABLE_PARAMS, (void (*)(void))tropic_prov_gen_settable_params},
+    {OSSL_FUNC_KEYMGMT_GEN, (void (*)(void))tropic_prov_gen},
+    {OSSL_FUNC_KEYMGMT_GEN_CLEANUP, (void (*)(void))tropic_prov_gen_cleanup},
+    {0, NULL}};
+
+static const OSSL_DISPATCH tropic_prov_ed25519_keymgmt[] = {
+    {OSSL_FUNC_KEYMGMT_NEW, (void (*)(void))tropic_prov_ed25519_new},
+    {OSSL_FUNC_KEYMGMT_FREE, (void (*)(void))tropic_prov_key_free},
+    {OSSL_FUNC_KEYMGMT_HAS, (void (*)(void))tropic_prov_key_has},
+    {OSSL_FUNC_KEYMGMT_MATCH, (void (*)(void))tropic_prov_key_match},
+    {OSSL_FUNC_KEYMGMT_GET_PARAMS, (void (*)(void))tropic_prov_key_get_params},
+    {OSSL_FUNC_KEYMGMT_GETTABLE_PARAMS, (void (*)(void))tropic_prov_ed25519_gettable_params},
+    {OSSL_FUNC_KEYMGMT_IMPORT, (void (*)(void))tropic_prov_key_import},
+    {OSSL_FUNC_KEYMGMT_IMPORT_TYPES, (void (*)(void))tropic_prov_ed25519_key_types_get},
+    {OSSL_FUNC_KEYMGMT_EXPORT, (void (*)(void))tropic_prov_key_export},
+    {OSSL_FUNC_KEYMGMT_EXPORT_TYPES, (void (*)(void))tropic_prov_ed25519_key_types_get},
+    {OSSL_FUNC_KEYMGMT_GEN_INIT, (void (*)(void))tropic_prov_ed25519_gen_init},
+    {OSSL_FUNC_KEYMGMT_GEN_SET_PARAMS, (void (*)(void))tropic_prov_gen_set_params},
+    {OSSL_FUNC_KEYMGMT_GEN_SETTABLE_PARAMS, (void (*)(void))tropic_prov_gen_settable_params},
+    {OSSL_FUNC_KEYMGMT_GEN, (void (*)(void))tropic_prov_gen},
+    {OSSL_FUNC_KEYMGMT_GEN_CLEANUP, (void (*)(void))tropic_prov_gen_cleanup},
+    {0, NULL}};
+
+static const OSSL_DISPATCH tropic_prov_ecdsa_signature[] = {
+    {OSSL_FUNC_SIGNATURE_NEWCTX, (void (*)(void))tropic_prov_sig_newctx},
+    {OSSL_FUNC_SIGNATURE_FREECTX, (void (*)(void))tropic_prov_sig_freectx},
+    {OSSL_FUNC_SIGNATURE_DUPCTX, (void (*)(void))tropic_prov_sig_dupctx},
+    {OSSL_FUNC_SIGNATURE_SIGN_INIT, (void (*)(void))tropic_prov_ecdsa_sign_init},
+    {OSSL_FUNC_SIGNATURE_SIGN, (void (*)(void))tropic_prov_ecdsa_sign},
+    {OSSL_FUNC_SIGNATURE_DIGEST_SIGN_INIT, (void (*)(void))tropic_prov_ecdsa_digest_sign_init},
+    {OSSL_FUNC_SIGNATURE_DIGEST_SIGN_UPDATE, (void (*)(void))tropic_prov_ecdsa_digest_sign_update},
+    {OSSL_FUNC_SIGNATURE_DIGEST_SIGN_FINAL, (void (*)(void))tropic_prov_ecdsa_digest_sign_final},
+    {OSSL_FUNC_SIGNATURE_GET_CTX_PARAMS, (void (*)(void))tropic_prov_sig_get_ctx_params},
+    {OSSL_FUNC_SIGNATURE_GETTABLE_CTX_PARAMS, (void (*)(void))tropic_prov_sig_gettable_ctx_params},
+    {OSSL_FUNC_SIGNATURE_SET_CTX_PARAMS, (void (*)(void))tropic_prov_sig_set_ctx_params},
+    {OSSL_FUNC_SIGNATURE_SETTABLE_CTX_PARAMS, (void (*)(void))tropic_prov_sig_settable_ctx_params},
+    {0, NULL}};
+
+static const OSSL_DISPATCH tropic_prov_ed25519_signature[] = {
+    {OSSL_FUNC_SIGNATURE_NEWCTX, (void (*)(void))tropic_prov_sig_newctx},
+    {OSSL_FUNC_SIGNATURE_FREECTX, (void (*)(void))tropic_prov_sig_freectx},
+    {OSSL_FUNC_SIGNATURE_DUPCTX, (void (*)(void))tropic_prov_sig_dupctx},
+    {OSSL_FUNC_SIGNATURE_DIGEST_SIGN_INIT, (void (*)(void))tropic_prov_ed25519_digest_sign_init},
+    {OSSL_FUNC_SIGNATURE_DIGEST_SIGN, (void (*)(void))tropic_prov_ed25519_digest_sign},
+    {OSSL_FUNC_SIGNATURE_GET_CTX_PARAMS, (void (*)(void))tropic_prov_sig_get_ctx_params},
+    {OSSL_FUNC_SIGNATURE_GETTABLE_CTX_PARAMS, (void (*)(void))tropic_prov_sig_gettable_ctx_params},
+    {0, NULL}};
+
+static const OSSL_ALGORITHM tropic_prov_keymgmts[] = {
+    {"EC:id-ecPublicKey:1.2.840.10045.2.1", "provider=" TROPIC_PROV_NAME, tropic_prov_ec_keymgmt,
+     "P-256 key in TROPIC01"},
+    {"ED25519:1.3.101.112", "provider=" TROPIC_PROV_NAME, tropic_prov_ed25519_keymgmt, "Ed25519 key in TROPIC01"},
+    {NULL, NULL, NULL, NULL}};
+
+static const OSSL_ALGORITHM tropic_prov_signatures[] = {
+    {"ECDSA", "provider=" TROPIC_PROV_NAME, tropic_prov_ecdsa_signature, "ECDSA by TROPIC01"},
+    {"ED25519:1.3.101.112", "provider=" TROPIC_PROV_NAME, tropic_prov_ed25519_signature, "Ed25519 by TROPIC01"},
+    {NULL, NULL, NULL, NULL}};
+
+static const OSSL_ALGORITHM *tropic_prov_query_operation(void *provctx, int operation_id, int *no_cache)
+{
+    (void)provctx;
+    *no_cache = 0;
+    switch (operation_id) {
+        case OSSL_OP_KEYMGMT:
+            return tropic_prov_keymgmts;
+        case OSSL_OP_SIGNATURE:
+            return tropic_prov_signatures;
+        default:
+            return NULL;
+    }
+}
+
+static const OSSL_PARAM *tropic_prov_gettable_params(void *provctx)
+{
+    static const OSSL_PARAM gettable[] = {OSSL_PARAM_utf8_ptr(OSSL_PROV_PARAM_NAME, NULL, 0),
+                                          OSSL_PARAM_int(OSSL_PROV_PARAM_STATUS, NULL), OSSL_PARAM_END};
+    (void)provctx;
+    return gettable;
+}
+
+static int tropic_prov_get_params(void *provctx, OSSL_PARAM params[])
+{
+    OSSL_PARAM *p;
+
+    (void)provctx;
+    if ((p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_NAME)) && !OSSL_PARAM_set_utf8_ptr(p, "TROPIC01 provider")) {
+        return 0;
+    }
+    if ((p = OSSL_PARAM_locate(params, OSSL_PROV_PARAM_STATUS)) && !OSSL_PARAM_set_int(p, 1)) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static void tropic_prov_teardown(void *provctx)
+{
+    tropic_prov_t *p = provctx;
+    uint64_t one = 1;
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_mutex_unlock(&p->lock);
+    if (write(p->wake_efd, &one, sizeof(one)) != sizeof(one)) {
+        // The worker is not sleeping then
+    }
+    pthread_join(p->worker, NULL);
+
+    if (p->session) {
+        lt_session_abort(&p->h);
+    }
+    lt_deinit(&p->h);
+    close(p->wake_efd);
+    pthread_cond_destroy(&p->done_cond);
+    pthread_mutex_destroy(&p->lock);
+    OSSL_LIB_CTX_free(p->libctx);
+    OPENSSL_cleanse(p->shipriv, sizeof(p->shipriv));
+    OPENSSL_free(p);
+}
+
+static const OSSL_DISPATCH tropic_prov_dispatch[] = {
+    {OSSL_FUNC_PROVIDER_TEARDOWN, (void (*)(void))tropic_prov_teardown},
+    {OSSL_FUNC_PROVIDER_GETTABLE_PARAMS, (void (*)(void))tropic_prov_gettable_params},
+    {OSSL_FUNC_PROVIDER_GET_PARAMS, (void (*)(void))tropic_prov_get_params},
+    {OSSL_FUNC_PROVIDER_QUERY_OPERATION, (void (*)(void))tropic_prov_query_operation},
+    {0, NULL}};
+
+static int tropic_prov_key_file(const char *path, uint8_t *key)
+{
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f) {
+        return 0;
+    }
+
+    size_t len = fread(key, 1, 32, f);
+    int extra = fgetc(f);
+    fclose(f);
+
+    return (len == 32) && (extra == EOF);
+}
+
+/** Sets the device up from `chip` of the configuration, same format as `-c` of tropicd */
+static int tropic_prov_dev_parse(tropic_prov_t *p, const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+    tropic_prov_dev_t *dev = &p->dev;
+
+    if (!spec || (strlen(spec) >= sizeof(buf))) {
+        return 0;
+    }
+    strcpy(buf, spec);
+
+#if TROPIC_PROV_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return 0;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return 0;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return 0;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return 0;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return 0;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL);
+
+    return 1;
+}
+
+int OSSL_provider_init(const OSSL_CORE_HANDLE *core, const OSSL_DISPATCH *in, const OSSL_DISPATCH **out,
+                       void **provctx)
+{
+    OSSL_FUNC_core_get_params_fn *core_get_params = NULL;
+    const char *chip = NULL, *shipriv = NULL, *shipub = NULL, *pkey_index = NULL, *spi_speed = NULL;
+
+    for (const OSSL_DISPATCH *d = in; d->function_id; d++) {
+        if (d->function_id == OSSL_FUNC_CORE_GET_PARAMS) {
+            core_get_params = OSSL_FUNC_core_get_params(d);
+        }
+    }
+    // Configuration is taken from the section of the provider in openssl.cnf
+    OSSL_PARAM conf[] = {OSSL_PARAM_utf8_ptr("chip", &chip, 0),
+                         OSSL_PARAM_utf8_ptr("shipriv", &shipriv, 0),
+                         OSSL_PARAM_utf8_ptr("shipub", &shipub, 0),
+                         OSSL_PARAM_utf8_ptr("pkey_index", &pkey_index, 0),
+                         OSSL_PARAM_utf8_ptr("spi_speed", &spi_speed, 0),
+                         OSSL_PARAM_END};
+    if (!core_get_params || !core_get_params(core, conf)) {
+        return 0;
+    }
+
+    tropic_prov_t *p = OPENSSL_zalloc(sizeof(*p));
+    if (!p) {
+        return 0;
+    }
+    p->core = core;
+    p->pkey_index = pkey_index ? (uint8_t)atoi(pkey_index) : 0;
+    if (!tropic_prov_dev_parse(p, chip, spi_speed ? atoi(spi_speed) : TROPIC_PROV_SPI_SPEED_DEFAULT)
+        || !tropic_prov_key_file(shipriv, p->shipriv) || !tropic_prov_key_file(shipub, p->shipub)
+        || (p->pkey_index > PAIRING_KEY_SLOT_INDEX_3)) {
+        goto free;
+    }
+    p->h.l2.device = &p->dev;
+    p->h.async = &p->async;
+#if LT_SEPARATE_L3_BUFF
+    p->h.l3.buff = p->l3_buffer;
+    p->h.l3.buff_len = sizeof(p->l3_buffer);
+#endif
+
+    if (!(p->libctx = OSSL_LIB_CTX_new_child(core, in))) {
+        goto free;
+    }
+    if ((p->wake_efd = eventfd(0, EFD_CLOEXEC)) < 0) {
+        goto free_libctx;
+    }
+    if (lt_init(&p->h) != LT_OK) {
+        goto close;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->done_cond, NULL);
+    // The handle belongs to the worker from now on
+    if (pthread_create(&p->worker, NULL, tropic_prov_worker, p) != 0) {
+        pthread_cond_destroy(&p->done_cond);
+        pthread_mutex_destroy(&p->lock);
+        lt_deinit(&p->h);
+        goto close;
+    }
+
+    *out = tropic_prov_dispatch;
+    *provctx = p;
+
+    return 1;
+
+close:
+    close(p->wake_efd);
+free_libctx:
+    OSSL_LIB_CTX_free(p->libctx);
+free:
+    OPENSSL_cleanse(p->shipriv, sizeof(p->shipriv));
+    OPENSSL_free(p);
+
+    return 0;
+}
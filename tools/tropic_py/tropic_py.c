@@ -0,0 +1,1037 @@
+/**
+ * @file tropic_py.c
+ * @author Tropic Square s.r.o.
+ * @brief CPython extension module `tropic` over libtropic.
+ *
+ * `tropic.Chip` owns a handle of one TROPIC01. The GIL is released for the whole time a method waits for the chip, so
+ * threads driving different chips run concurrently. Calls of one chip from several threads are serialized by a lock of
+ * the chip object.
+ *
+ * Methods taking data accept any bytes-like object (buffer protocol), batch methods take all their inputs in one
+ * buffer, e.g. n * 32 bytes of digests, and return the results in one bytes object written in place. A failed call
+ * raises `tropic.Error` with the lt_ret_t value in `code`.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+
+#if TROPIC_PY_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t tpy_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t tpy_dev_t;
+#endif
+
+/** SPI speed used unless given to Chip() */
+#define TPY_SPI_SPEED_DEFAULT 5000000
+/** Returned by TPY_CALL() instead of the lt_ret_t value when the chip was closed */
+#define TPY_CLOSED ((lt_ret_t)-1)
+
+typedef struct tpy_chip_t {
+    PyObject_HEAD
+    /** Serializes calls of threads using the chip, taken with the GIL released */
+    pthread_mutex_t lock;
+    /** Handle is initialized */
+    bool open;
+    lt_handle_t h;
+    tpy_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+} tpy_chip_t;
+
+/** tropic.Error */
+static PyObject *tpy_error;
+
+/**
+ * Evaluates `call` with the GIL released and the chip locked. Only data not owned by Python objects (or buffers
+ * exported to the method and bytes objects not yet returned) may be used by `call`.
+ */
+#define TPY_CALL(self, ret, call)                        \
+    do {                                                 \
+        Py_BEGIN_ALLOW_THREADS                           \
+        pthread_mutex_lock(&(self)->lock);               \
+        (ret) = (self)->open ? (call) : TPY_CLOSED;      \
+        pthread_mutex_unlock(&(self)->lock);             \
+        Py_END_ALLOW_THREADS                             \
+    } while (0)
+
+/** Sets the Python exception for `ret`, returns false when `ret` is not LT_OK */
+static bool tpy_check(const lt_ret_t ret)
+{
+    if (ret == LT_OK) {
+        return true;
+    }
+    if (ret == TPY_CLOSED) {
+        PyErr_SetString(PyExc_ValueError, "operation on closed chip");
+        return false;
+    }
+
+    PyObject *exc = PyObject_CallFunction(tpy_error, "is", (int)ret, lt_ret_verbose(ret));
+    if (exc) {
+        PyObject *code = PyLong_FromLong((long)ret);
+        if (code && (PyObject_SetAttrString(exc, "code", code) == 0)) {
+            PyErr_SetObject(tpy_error, exc);
+        }
+        Py_XDECREF(code);
+        Py_DECREF(exc);
+    }
+
+    return false;
+}
+
+/** Returns None or raises for `ret` */
+static PyObject *tpy_none(const lt_ret_t ret)
+{
+    if (!tpy_check(ret)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/** Checks size of a buffer given to a method */
+static bool tpy_buf_len(const Py_buffer *buf, const char *name, const Py_ssize_t len)
+{
+    if (buf->len != len) {
+        PyErr_Format(PyExc_ValueError, "%s must be %zd bytes long", name, len);
+        return false;
+    }
+
+    return true;
+}
+
+/** Size of a batch given as buffer of `item_len` bytes long items, -1 with exception set when it is not valid */
+static int tpy_batch_len(const Py_buffer *buf, const char *name, const Py_ssize_t item_len)
+{
+    if ((buf->len % item_len) || (buf->len / item_len > UINT16_MAX)) {
+        PyErr_Format(PyExc_ValueError, "%s must be a multiple of %zd bytes, at most %d items", name, item_len,
+                     UINT16_MAX);
+        return -1;
+    }
+
+    return (int)(buf->len / item_len);
+}
+
+/** Sets the device up from the chip string, same format as `-c` of tropicd */
+static bool tpy_dev_parse(tpy_dev_t *dev, const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+
+    memset(dev, 0, sizeof(*dev));
+    if (strlen(spec) >= sizeof(buf)) {
+        return false;
+    }
+    strcpy(buf, spec);
+
+#if TROPIC_PY_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return false;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return false;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return false;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return false;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return false;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL);
+
+    return true;
+}
+
+/*
+ * Chip object
+ */
+
+static PyObject *tpy_chip_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    (void)args;
+    (void)kwds;
+    tpy_chip_t *self = (tpy_chip_t *)type->tp_alloc(type, 0);
+    if (self) {
+        pthread_mutex_init(&self->lock, NULL);
+    }
+
+    return (PyObject *)self;
+}
+
+static int tpy_chip_init(tpy_chip_t *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"chip", "spi_speed", NULL};
+    const char *spec;
+    int spi_speed = TPY_SPI_SPEED_DEFAULT;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|i", kwlist, &spec, &spi_speed)) {
+        return -1;
+    }
+    if (self->open) {
+        PyErr_SetString(PyExc_RuntimeError, "chip is already open");
+        return -1;
+    }
+    if (!tpy_dev_parse(&self->dev, spec, spi_speed)) {
+        PyErr_Format(PyExc_ValueError, "invalid chip '%s'", spec);
+        return -1;
+    }
+
+    memset(&self->h, 0, sizeof(self->h));
+    self->h.l2.device = &self->dev;
+#if LT_SEPARATE_L3_BUFF
+    self->h.l3.buff = self->l3_buffer;
+    self->h.l3.buff_len = sizeof(self->l3_buffer);
+#endif
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&self->lock);
+    ret = lt_init(&self->h);
+    self->open = (ret == LT_OK);
+    pthread_mutex_unlock(&self->lock);
+    Py_END_ALLOW_THREADS
+
+    return tpy_check(ret) ? 0 : -1;
+}
+
+/** Deinitializes the handle, waits for a call of another thread in progress */
+static void tpy_chip_deinit(tpy_chip_t *self)
+{
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&self->lock);
+    if (self->open) {
+        lt_deinit(&self->h);
+        self->open = false;
+    }
+    pthread_mutex_unlock(&self->lock);
+    Py_END_ALLOW_THREADS
+}
+
+static void tpy_chip_dealloc(tpy_chip_t *self)
+{
+    tpy_chip_deinit(self);
+    pthread_mutex_destroy(&self->lock);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *tpy_chip_close(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    tpy_chip_deinit(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject *tpy_chip_enter(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *tpy_chip_exit(tpy_chip_t *self, PyObject *args)
+{
+    (void)args;
+    tpy_chip_deinit(self);
+    Py_RETURN_FALSE;
+}
+
+static PyObject *tpy_chip_session_start(tpy_chip_t *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"shipriv", "shipub", "pkey_index", NULL};
+    Py_buffer priv, pub;
+    uint8_t shipriv[32], shipub[32];
+    unsigned char pkey_index = PAIRING_KEY_SLOT_INDEX_0;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "y*y*|b", kwlist, &priv, &pub, &pkey_index)) {
+        return NULL;
+    }
+    bool valid = tpy_buf_len(&priv, "shipriv", 32) && tpy_buf_len(&pub, "shipub", 32);
+    if (valid) {
+        memcpy(shipriv, priv.buf, 32);
+        memcpy(shipub, pub.buf, 32);
+    }
+    PyBuffer_Release(&priv);
+    PyBuffer_Release(&pub);
+    if (!valid) {
+        return NULL;
+    }
+
+    TPY_CALL(self, ret, lt_verify_chip_and_start_secure_session(&self->h, shipriv, shipub, pkey_index));
+    memset(shipriv, 0, sizeof(shipriv));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_session_abort(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    lt_ret_t ret;
+
+    TPY_CALL(self, ret, lt_session_abort(&self->h));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_get_chip_id(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *res = PyBytes_FromStringAndSize(NULL, sizeof(struct lt_chip_id_t));
+    lt_ret_t ret;
+
+    if (!res) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_get_info_chip_id(&self->h, (struct lt_chip_id_t *)PyBytes_AS_STRING(res)));
+    if (!tpy_check(ret)) {
+        Py_DECREF(res);
+        return NULL;
+    }
+
+    return res;
+}
+
+static PyObject *tpy_chip_get_riscv_fw_ver(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *res = PyBytes_FromStringAndSize(NULL, LT_L2_GET_INFO_RISCV_FW_SIZE);
+    lt_ret_t ret;
+
+    if (!res) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_get_info_riscv_fw_ver(&self->h, (uint8_t *)PyBytes_AS_STRING(res)));
+    if (!tpy_check(ret)) {
+        Py_DECREF(res);
+        return NULL;
+    }
+
+    return res;
+}
+
+static PyObject *tpy_chip_ping(tpy_chip_t *self, PyObject *args)
+{
+    Py_buffer msg;
+    PyObject *res = NULL;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "y*", &msg)) {
+        return NULL;
+    }
+    if (msg.len > LT_PING_LEN_MAX) {
+        PyErr_Format(PyExc_ValueError, "message must be at most %d bytes long", LT_PING_LEN_MAX);
+        goto release;
+    }
+    res = PyBytes_FromStringAndSize(NULL, msg.len);
+    if (!res) {
+        goto release;
+    }
+    TPY_CALL(self, ret, lt_ping(&self->h, msg.buf, (uint8_t *)PyBytes_AS_STRING(res), (uint16_t)msg.len));
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+release:
+    PyBuffer_Release(&msg);
+
+    return res;
+}
+
+static PyObject *tpy_chip_random_value_get(tpy_chip_t *self, PyObject *args)
+{
+    Py_ssize_t len;
+    PyObject *res;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "n", &len)) {
+        return NULL;
+    }
+    if (len < 0) {
+        PyErr_SetString(PyExc_ValueError, "length must not be negative");
+        return NULL;
+    }
+    res = PyBytes_FromStringAndSize(NULL, len);
+    if (!res) {
+        return NULL;
+    }
+
+    // Longer requests are split into several RANDOM_VALUE_GET commands within one release of the GIL
+    uint8_t *out = (uint8_t *)PyBytes_AS_STRING(res);
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&self->lock);
+    ret = self->open ? LT_OK : TPY_CLOSED;
+    for (Py_ssize_t done = 0; (ret == LT_OK) && (done < len); done += RANDOM_VALUE_GET_LEN_MAX) {
+        Py_ssize_t chunk = (len - done < RANDOM_VALUE_GET_LEN_MAX) ? (len - done) : RANDOM_VALUE_GET_LEN_MAX;
+        ret = lt_random_value_get(&self->h, out + done, (uint16_t)chunk);
+    }
+    pthread_mutex_unlock(&self->lock);
+    Py_END_ALLOW_THREADS
+
+    if (!tpy_check(ret)) {
+        Py_DECREF(res);
+        return NULL;
+    }
+
+    return res;
+}
+
+static PyObject *tpy_chip_ecc_key_generate(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    int curve;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "bi", &slot, &curve)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_ecc_key_generate(&self->h, (ecc_slot_t)slot, (lt_ecc_curve_type_t)curve));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_ecc_key_store(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    int curve;
+    Py_buffer key;
+    uint8_t priv[32];
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "biy*", &slot, &curve, &key)) {
+        return NULL;
+    }
+    bool valid = tpy_buf_len(&key, "key", 32);
+    if (valid) {
+        memcpy(priv, key.buf, sizeof(priv));
+    }
+    PyBuffer_Release(&key);
+    if (!valid) {
+        return NULL;
+    }
+
+    TPY_CALL(self, ret, lt_ecc_key_store(&self->h, (ecc_slot_t)slot, (lt_ecc_curve_type_t)curve, priv));
+    memset(priv, 0, sizeof(priv));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_ecc_key_read(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    uint8_t key[64];
+    lt_ecc_curve_type_t curve = CURVE_P256;
+    ecc_key_origin_t origin = CURVE_GENERATED;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "b", &slot)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_ecc_key_read(&self->h, (ecc_slot_t)slot, key, &curve, &origin));
+    if (!tpy_check(ret)) {
+        return NULL;
+    }
+
+    return Py_BuildValue("(y#ii)", key, (Py_ssize_t)((curve == CURVE_P256) ? 64 : 32), (int)curve, (int)origin);
+}
+
+static PyObject *tpy_chip_ecc_key_erase(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "b", &slot)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_ecc_key_erase(&self->h, (ecc_slot_t)slot));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_ecdsa_sign(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    Py_buffer digest;
+    PyObject *res = NULL;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "by*", &slot, &digest)) {
+        return NULL;
+    }
+    if (!tpy_buf_len(&digest, "digest", 32) || !(res = PyBytes_FromStringAndSize(NULL, 64))) {
+        goto release;
+    }
+    TPY_CALL(self, ret,
+             lt_ecc_ecdsa_sign_digest(&self->h, (ecc_slot_t)slot, digest.buf, (uint8_t *)PyBytes_AS_STRING(res)));
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+release:
+    PyBuffer_Release(&digest);
+
+    return res;
+}
+
+static PyObject *tpy_chip_eddsa_sign(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    Py_buffer msg;
+    PyObject *res = NULL;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "by*", &slot, &msg)) {
+        return NULL;
+    }
+    if (msg.len > LT_EDDSA_MSG_LEN_MAX) {
+        PyErr_Format(PyExc_ValueError, "message must be at most %d bytes long", LT_EDDSA_MSG_LEN_MAX);
+        goto release;
+    }
+    res = PyBytes_FromStringAndSize(NULL, 64);
+    if (!res) {
+        goto release;
+    }
+    TPY_CALL(self, ret,
+             lt_ecc_eddsa_sign(&self->h, (ecc_slot_t)slot, msg.buf, (uint16_t)msg.len,
+                               (uint8_t *)PyBytes_AS_STRING(res)));
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+release:
+    PyBuffer_Release(&msg);
+
+    return res;
+}
+
+static PyObject *tpy_chip_ecdsa_sign_batch(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    Py_buffer digests;
+    PyObject *res = NULL;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "by*", &slot, &digests)) {
+        return NULL;
+    }
+    int n = tpy_batch_len(&digests, "digests", 32);
+    if ((n < 0) || !(res = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)n * 64))) {
+        goto release;
+    }
+    TPY_CALL(self, ret,
+             n ? lt_ecc_ecdsa_sign_batch(&self->h, (ecc_slot_t)slot, digests.buf, (uint16_t)n,
+                                         (uint8_t *)PyBytes_AS_STRING(res))
+               : LT_OK);
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+release:
+    PyBuffer_Release(&digests);
+
+    return res;
+}
+
+static PyObject *tpy_chip_eddsa_sign_batch(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    PyObject *seq, *fast, *res = NULL;
+    Py_buffer *bufs = NULL;
+    const uint8_t **msgs = NULL;
+    uint16_t *lens = NULL;
+    Py_ssize_t n, got = 0;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "bO", &slot, &seq)) {
+        return NULL;
+    }
+    fast = PySequence_Fast(seq, "messages must be a sequence of bytes-like objects");
+    if (!fast) {
+        return NULL;
+    }
+    n = PySequence_Fast_GET_SIZE(fast);
+    if (n > UINT16_MAX) {
+        PyErr_Format(PyExc_ValueError, "at most %d messages", UINT16_MAX);
+        goto cleanup;
+    }
+    bufs = PyMem_New(Py_buffer, n ? n : 1);
+    msgs = PyMem_New(const uint8_t *, n ? n : 1);
+    lens = PyMem_New(uint16_t, n ? n : 1);
+    if (!bufs || !msgs || !lens) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+    for (; got < n; got++) {
+        if (PyObject_GetBuffer(PySequence_Fast_GET_ITEM(fast, got), &bufs[got], PyBUF_SIMPLE) < 0) {
+            goto cleanup;
+        }
+        if (bufs[got].len > LT_EDDSA_MSG_LEN_MAX) {
+            PyErr_Format(PyExc_ValueError, "message must be at most %d bytes long", LT_EDDSA_MSG_LEN_MAX);
+            got++;
+            goto cleanup;
+        }
+        msgs[got] = bufs[got].buf;
+        lens[got] = (uint16_t)bufs[got].len;
+    }
+    res = PyBytes_FromStringAndSize(NULL, n * 64);
+    if (!res) {
+        goto cleanup;
+    }
+    TPY_CALL(self, ret,
+             n ? lt_ecc_eddsa_sign_batch(&self->h, (ecc_slot_t)slot, msgs, lens, (uint16_t)n,
+                                         (uint8_t *)PyBytes_AS_STRING(res))
+               : LT_OK);
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+cleanup:
+    for (Py_ssize_t i = 0; i < got; i++) {
+        PyBuffer_Release(&bufs[i]);
+    }
+    PyMem_Free(bufs);
+    PyMem_Free(msgs);
+    PyMem_Free(lens);
+    Py_DECREF(fast);
+
+    return res;
+}
+
+static PyObject *tpy_chip_mac_and_destroy(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char slot;
+    Py_buffer data;
+    PyObject *res = NULL;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "by*", &slot, &data)) {
+        return NULL;
+    }
+    if (!tpy_buf_len(&data, "data", MAC_AND_DESTROY_DATA_SIZE)
+        || !(res = PyBytes_FromStringAndSize(NULL, MAC_AND_DESTROY_DATA_SIZE))) {
+        goto release;
+    }
+    TPY_CALL(self, ret,
+             lt_mac_and_destroy(&self->h, (mac_and_destroy_slot_t)slot, data.buf, (uint8_t *)PyBytes_AS_STRING(res)));
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+release:
+    PyBuffer_Release(&data);
+
+    return res;
+}
+
+static PyObject *tpy_chip_mac_and_destroy_batch(tpy_chip_t *self, PyObject *args)
+{
+    Py_buffer slots_buf, data;
+    mac_and_destroy_slot_t *slots = NULL;
+    PyObject *res = NULL;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "y*y*", &slots_buf, &data)) {
+        return NULL;
+    }
+    int n = tpy_batch_len(&data, "data", MAC_AND_DESTROY_DATA_SIZE);
+    if ((n < 0) || !tpy_buf_len(&slots_buf, "slots", n)) {
+        goto release;
+    }
+    slots = PyMem_New(mac_and_destroy_slot_t, n ? n : 1);
+    if (!slots) {
+        PyErr_NoMemory();
+        goto release;
+    }
+    // One slot index per byte
+    for (int i = 0; i < n; i++) {
+        slots[i] = (mac_and_destroy_slot_t)((const uint8_t *)slots_buf.buf)[i];
+    }
+    res = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)n * MAC_AND_DESTROY_DATA_SIZE);
+    if (!res) {
+        goto release;
+    }
+    TPY_CALL(self, ret,
+             n ? lt_mac_and_destroy_batch(&self->h, slots, data.buf, (uint16_t)n, (uint8_t *)PyBytes_AS_STRING(res))
+               : LT_OK);
+    if (!tpy_check(ret)) {
+        Py_CLEAR(res);
+    }
+
+release:
+    PyMem_Free(slots);
+    PyBuffer_Release(&slots_buf);
+    PyBuffer_Release(&data);
+
+    return res;
+}
+
+static PyObject *tpy_chip_r_config_read(tpy_chip_t *self, PyObject *args)
+{
+    int addr;
+    uint32_t obj = 0;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "i", &addr)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_r_config_read(&self->h, (enum CONFIGURATION_OBJECTS_REGS)addr, &obj));
+    if (!tpy_check(ret)) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLong(obj);
+}
+
+static PyObject *tpy_chip_r_config_write(tpy_chip_t *self, PyObject *args)
+{
+    int addr;
+    unsigned int obj;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "iI", &addr, &obj)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_r_config_write(&self->h, (enum CONFIGURATION_OBJECTS_REGS)addr, (uint32_t)obj));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_r_config_erase(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    lt_ret_t ret;
+
+    TPY_CALL(self, ret, lt_r_config_erase(&self->h));
+
+    return tpy_none(ret);
+}
+
+/** Reads whole R-Config or I-Config into bytes of LT_CONFIG_OBJ_CNT native uint32_t values */
+static PyObject *tpy_config_read(tpy_chip_t *self, lt_ret_t (*read)(lt_handle_t *, struct lt_config_t *))
+{
+    PyObject *res = PyBytes_FromStringAndSize(NULL, sizeof(struct lt_config_t));
+    lt_ret_t ret;
+
+    if (!res) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, read(&self->h, (struct lt_config_t *)PyBytes_AS_STRING(res)));
+    if (!tpy_check(ret)) {
+        Py_DECREF(res);
+        return NULL;
+    }
+
+    return res;
+}
+
+static PyObject *tpy_chip_read_whole_r_config(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    return tpy_config_read(self, lt_read_whole_R_config);
+}
+
+static PyObject *tpy_chip_read_whole_i_config(tpy_chip_t *self, PyObject *Py_UNUSED(ignored))
+{
+    return tpy_config_read(self, lt_read_whole_I_config);
+}
+
+static PyObject *tpy_chip_write_whole_r_config(tpy_chip_t *self, PyObject *args)
+{
+    Py_buffer config;
+    struct lt_config_t cfg;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "y*", &config)) {
+        return NULL;
+    }
+    bool valid = tpy_buf_len(&config, "config", sizeof(cfg));
+    if (valid) {
+        // Buffer of the caller need not be aligned
+        memcpy(&cfg, config.buf, sizeof(cfg));
+    }
+    PyBuffer_Release(&config);
+    if (!valid) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_write_whole_R_config(&self->h, &cfg));
+
+    return tpy_none(ret);
+}
+
+#if LT_ENABLE_R_MEM
+static PyObject *tpy_chip_r_mem_data_read(tpy_chip_t *self, PyObject *args)
+{
+    unsigned short slot;
+    uint8_t data[R_MEM_DATA_SIZE_MAX];
+    uint16_t size = 0;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "H", &slot)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_r_mem_data_read(&self->h, slot, data, &size));
+    if (!tpy_check(ret)) {
+        return NULL;
+    }
+
+    return PyBytes_FromStringAndSize((const char *)data, size);
+}
+
+static PyObject *tpy_chip_r_mem_data_write(tpy_chip_t *self, PyObject *args)
+{
+    unsigned short slot;
+    Py_buffer data;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "Hy*", &slot, &data)) {
+        return NULL;
+    }
+    if (data.len > R_MEM_DATA_SIZE_MAX) {
+        PyErr_Format(PyExc_ValueError, "data must be at most %d bytes long", R_MEM_DATA_SIZE_MAX);
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_r_mem_data_write(&self->h, slot, data.buf, (uint16_t)data.len));
+    PyBuffer_Release(&data);
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_r_mem_data_erase(tpy_chip_t *self, PyObject *args)
+{
+    unsigned short slot;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "H", &slot)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_r_mem_data_erase(&self->h, slot));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_r_mem_data_read_range(tpy_chip_t *self, PyObject *args)
+{
+    unsigned short first, cnt;
+    uint8_t *data;
+    uint16_t *sizes;
+    lt_ret_t *statuses, ret;
+    PyObject *res = NULL;
+
+    if (!PyArg_ParseTuple(args, "HH", &first, &cnt)) {
+        return NULL;
+    }
+    data = PyMem_Malloc((size_t)(cnt ? cnt : 1) * R_MEM_DATA_SIZE_MAX);
+    sizes = PyMem_New(uint16_t, cnt ? cnt : 1);
+    statuses = PyMem_New(lt_ret_t, cnt ? cnt : 1);
+    if (!data || !sizes || !statuses) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+    TPY_CALL(self, ret, cnt ? lt_r_mem_data_read_range(&self->h, first, cnt, data, sizes, statuses) : LT_OK);
+    if (!tpy_check(ret) || !(res = PyList_New(cnt))) {
+        goto cleanup;
+    }
+
+    // Empty slots are None, other failures of a slot fail the whole call
+    for (int i = 0; i < cnt; i++) {
+        PyObject *item;
+        if (statuses[i] == LT_L3_R_MEM_DATA_READ_SLOT_EMPTY) {
+            item = Py_NewRef(Py_None);
+        }
+        else if (!tpy_check(statuses[i])) {
+            Py_CLEAR(res);
+            break;
+        }
+        else if (!(item = PyBytes_FromStringAndSize((const char *)data + (size_t)i * R_MEM_DATA_SIZE_MAX, sizes[i]))) {
+            Py_CLEAR(res);
+            break;
+        }
+        PyList_SET_ITEM(res, i, item);
+    }
+
+cleanup:
+    PyMem_Free(data);
+    PyMem_Free(sizes);
+    PyMem_Free(statuses);
+
+    return res;
+}
+#endif
+
+#if LT_ENABLE_MCOUNTER
+static PyObject *tpy_chip_mcounter_init(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char index;
+    unsigned int value;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "bI", &index, &value)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_mcounter_init(&self->h, (lt_mcounter_index_t)index, (uint32_t)value));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_mcounter_update(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char index;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "b", &index)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_mcounter_update(&self->h, (lt_mcounter_index_t)index));
+
+    return tpy_none(ret);
+}
+
+static PyObject *tpy_chip_mcounter_get(tpy_chip_t *self, PyObject *args)
+{
+    unsigned char index;
+    uint32_t value = 0;
+    lt_ret_t ret;
+
+    if (!PyArg_ParseTuple(args, "b", &index)) {
+        return NULL;
+    }
+    TPY_CALL(self, ret, lt_mcounter_get(&self->h, (lt_mcounter_index_t)index, &value));
+    if (!tpy_check(ret)) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLong(value);
+}
+#endif
+
+static PyMethodDef tpy_chip_methods[] = {
+    {"close", (PyCFunction)tpy_chip_close, METH_NOARGS, "Deinitializes the handle."},
+    {"__enter__", (PyCFunction)tpy_chip_enter, METH_NOARGS, NULL},
+    {"__exit__", (PyCFunction)tpy_chip_exit, METH_VARARGS, NULL},
+    {"session_start", (PyCFunction)(void (*)(void))tpy_chip_session_start, METH_VARARGS | METH_KEYWORDS,
+     "session_start(shipriv, shipub, pkey_index=0)\n\nVerifies the chip and starts secure session."},
+    {"session_abort", (PyCFunction)tpy_chip_session_abort, METH_NOARGS, "Aborts secure session."},
+    {"get_chip_id", (PyCFunction)tpy_chip_get_chip_id, METH_NOARGS, "Returns raw struct lt_chip_id_t."},
+    {"get_riscv_fw_ver", (PyCFunction)tpy_chip_get_riscv_fw_ver, METH_NOARGS, "Returns RISC-V FW version bytes."},
+    {"ping", (PyCFunction)tpy_chip_ping, METH_VARARGS, "ping(msg) -> bytes"},
+    {"random_value_get", (PyCFunction)tpy_chip_random_value_get, METH_VARARGS,
+     "random_value_get(n) -> bytes\n\nReturns n random bytes, longer requests are split into several commands."},
+    {"ecc_key_generate", (PyCFunction)tpy_chip_ecc_key_generate, METH_VARARGS, "ecc_key_generate(slot, curve)"},
+    {"ecc_key_store", (PyCFunction)tpy_chip_ecc_key_store, METH_VARARGS, "ecc_key_store(slot, curve, key)"},
+    {"ecc_key_read", (PyCFunction)tpy_chip_ecc_key_read, METH_VARARGS,
+     "ecc_key_read(slot) -> (key, curve, origin)"},
+    {"ecc_key_erase", (PyCFunction)tpy_chip_ecc_key_erase, METH_VARARGS, "ecc_key_erase(slot)"},
+    {"ecdsa_sign", (PyCFunction)tpy_chip_ecdsa_sign, METH_VARARGS, "ecdsa_sign(slot, digest) -> rs"},
+    {"eddsa_sign", (PyCFunction)tpy_chip_eddsa_sign, METH_VARARGS, "eddsa_sign(slot, msg) -> rs"},
+    {"ecdsa_sign_batch", (PyCFunction)tpy_chip_ecdsa_sign_batch, METH_VARARGS,
+     "ecdsa_sign_batch(slot, digests) -> sigs\n\nSigns n * 32 bytes of digests, returns n * 64 bytes of signatures."},
+    {"eddsa_sign_batch", (PyCFunction)tpy_chip_eddsa_sign_batch, METH_VARARGS,
+     "eddsa_sign_batch(slot, msgs) -> sigs\n\nSigns a sequence of messages, returns n * 64 bytes of signatures."},
+    {"mac_and_destroy", (PyCFunction)tpy_chip_mac_and_destroy, METH_VARARGS, "mac_and_destroy(slot, data) -> bytes"},
+    {"mac_and_destroy_batch", (PyCFunction)tpy_chip_mac_and_destroy_batch, METH_VARARGS,
+     "mac_and_destroy_batch(slots, data) -> bytes\n\nExecutes n sequences, slots has one slot index per byte and "
+     "data n * 32 bytes."},
+    {"r_config_read", (PyCFunction)tpy_chip_r_config_read, METH_VARARGS, "r_config_read(addr) -> int"},
+    {"r_config_write", (PyCFunction)tpy_chip_r_config_write, METH_VARARGS, "r_config_write(addr, value)"},
+    {"r_config_erase", (PyCFunction)tpy_chip_r_config_erase, METH_NOARGS, "Erases R-Config."},
+    {"read_whole_r_config", (PyCFunction)tpy_chip_read_whole_r_config, METH_NOARGS,
+     "Returns R-Config as CONFIG_OBJ_CNT native uint32 values, e.g. for memoryview(...).cast('I')."},
+    {"read_whole_i_config", (PyCFunction)tpy_chip_read_whole_i_config, METH_NOARGS,
+     "Returns I-Config as CONFIG_OBJ_CNT native uint32 values."},
+    {"write_whole_r_config", (PyCFunction)tpy_chip_write_whole_r_config, METH_VARARGS,
+     "write_whole_r_config(config)\n\nWrites CONFIG_OBJ_CNT native uint32 values to R-Config."},
+#if LT_ENABLE_R_MEM
+    {"r_mem_data_read", (PyCFunction)tpy_chip_r_mem_data_read, METH_VARARGS, "r_mem_data_read(slot) -> bytes"},
+    {"r_mem_data_write", (PyCFunction)tpy_chip_r_mem_data_write, METH_VARARGS, "r_mem_data_write(slot, data)"},
+    {"r_mem_data_erase", (PyCFunction)tpy_chip_r_mem_data_erase, METH_VARARGS, "r_mem_data_erase(slot)"},
+    {"r_mem_data_read_range", (PyCFunction)tpy_chip_r_mem_data_read_range, METH_VARARGS,
+     "r_mem_data_read_range(first, count) -> list\n\nReads consecutive slots, empty slots are None."},
+#endif
+#if LT_ENABLE_MCOUNTER
+    {"mcounter_init", (PyCFunction)tpy_chip_mcounter_init, METH_VARARGS, "mcounter_init(index, value)"},
+    {"mcounter_update", (PyCFunction)tpy_chip_mcounter_update, METH_VARARGS, "mcounter_update(index)"},
+    {"mcounter_get", (PyCFunction)tpy_chip_mcounter_get, METH_VARARGS, "mcounter_get(index) -> int"},
+#endif
+    {NULL, NULL, 0, NULL},
+};
+
+static PyTypeObject tpy_chip_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "tropic.Chip",
+    .tp_doc = "Chip(chip, spi_speed=5000000)\n\nTROPIC01 reached by the port of the module.",
+    .tp_basicsize = sizeof(tpy_chip_t),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = tpy_chip_new,
+    .tp_init = (initproc)tpy_chip_init,
+    .tp_dealloc = (destructor)tpy_chip_dealloc,
+    .tp_methods = tpy_chip_methods,
+};
+
+/*
+ * Module
+ */
+
+static struct PyModuleDef tpy_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "tropic",
+    .m_doc = "Bindings of libtropic.",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_tropic(void);
+
+PyMODINIT_FUNC PyInit_tropic(void)
+{
+    PyObject *m;
+
+    if (PyType_Ready(&tpy_chip_type) < 0) {
+        return NULL;
+    }
+    m = PyModule_Create(&tpy_module);
+    if (!m) {
+        return NULL;
+    }
+
+    tpy_error = PyErr_NewExceptionWithDoc("tropic.Error", "Failure of libtropic, lt_ret_t value is in code.", NULL,
+                                          NULL);
+    if (!tpy_error || (PyModule_AddObjectRef(m, "Error", tpy_error) < 0)
+        || (PyModule_AddObjectRef(m, "Chip", (PyObject *)&tpy_chip_type) < 0)
+        || (PyModule_AddIntConstant(m, "CURVE_P256", CURVE_P256) < 0)
+        || (PyModule_AddIntConstant(m, "CURVE_ED25519", CURVE_ED25519) < 0)
+        || (PyModule_AddIntConstant(m, "ORIGIN_GENERATED", CURVE_GENERATED) < 0)
+        || (PyModule_AddIntConstant(m, "ORIGIN_STORED", CURVE_STORED) < 0)
+        || (PyModule_AddIntConstant(m, "CONFIG_OBJ_CNT", LT_CONFIG_OBJ_CNT) < 0)
+        || (PyModule_AddIntConstant(m, "R_MEM_DATA_SIZE_MAX", R_MEM_DATA_SIZE_MAX) < 0)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    return m;
+}
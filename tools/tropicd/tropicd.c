@@ -0,0 +1,986 @@
+/**
+ * @file tropicd.c
+ * @author Tropic Square s.r.o.
+ * @brief Daemon owning TROPIC01 chips and their secure sessions, shared by local processes over a Unix socket.
+ *
+ * The daemon is single-threaded: requests of all clients are taken one by one in a poll() loop, each is executed
+ * to its end before the next one is taken. Chips are therefore never accessed concurrently, and commands of one
+ * request (a batch) run back-to-back on one chip, paying for the secure session only once when the daemon starts.
+ *
+ * With -e, idle time of the chips is used to feed the kernel entropy pool: when poll() times out with no client
+ * request pending, a batch of random bytes is taken from a chip and credited by RNDADDENTROPY, at most at the given
+ * rate. Any client activity postpones feeding by a quiet period, so a request waits at most for one batch.
+ *
+ * With -d, requests are admitted only while they are predicted to be answered in time. A request is of the high
+ * class when it signs, of the low class when it only takes random values, and of the normal class otherwise. Its
+ * predicted latency is the time since poll() returned, which it waited behind requests taken before it, plus the
+ * service time of its commands, averaged over the recent commands of each ID. A request predicted to miss the
+ * deadline of its class is answered with LT_OVERLOAD without executing it, so clients learn about the overload at
+ * once and may back off or go to another daemon, instead of making the queue longer.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/random.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_common.h"
+#include "lt_l3_api_structs.h"
+#include "lt_l3_cmd_desc.h"
+#include "tropicd_proto.h"
+
+#if TROPICD_PORT_SPI
+#include "libtropic_port_unix_spi.h"
+typedef lt_dev_unix_spi_t tropicd_dev_t;
+#else
+#include <arpa/inet.h>
+
+#include "libtropic_port_unix_tcp.h"
+typedef lt_dev_unix_tcp_t tropicd_dev_t;
+#endif
+
+#if !LT_RAW_CMD
+#error "tropicd needs libtropic built with LT_RAW_CMD"
+#endif
+
+/** Maximal number of chips served by one daemon */
+#define TROPICD_CHIPS_MAX 8
+/** Maximal number of connected clients */
+#define TROPICD_CLIENTS_MAX 32
+/** Time given to a client to take its response, slower clients are disconnected */
+#define TROPICD_SEND_TIMEOUT_MS 1000
+/** SPI speed used unless set by -f */
+#define TROPICD_SPI_SPEED_DEFAULT 5000000
+/** Kernel entropy pool fed with -e */
+#define TROPICD_ENTROPY_DEV "/dev/random"
+/** Bytes taken from a chip at once unless set by -b, pipelined by `lt_random_value_get_large()` in 4 commands */
+#define TROPICD_ENTROPY_BATCH_DEFAULT (4 * RANDOM_VALUE_GET_LEN_MAX)
+/** Maximal -b, a request arriving while a batch is taken waits for the whole batch */
+#define TROPICD_ENTROPY_BATCH_MAX (16 * RANDOM_VALUE_GET_LEN_MAX)
+/** Time after client activity during which no entropy is taken, unless set by -q */
+#define TROPICD_ENTROPY_QUIET_MS_DEFAULT 50
+/** Time before a chip without secure session is tried again for entropy */
+#define TROPICD_ENTROPY_RETRY_MS 1000
+/** Classes of requests with their deadlines set by -d */
+#define TROPICD_CLASS_HIGH 0
+#define TROPICD_CLASS_NORMAL 1
+#define TROPICD_CLASS_LOW 2
+#define TROPICD_CLASS_CNT 3
+/** Number of recent commands of an ID over which their service time is averaged */
+#define TROPICD_SERVICE_EWMA 8
+
+/** Chip with its handle and state of its secure session */
+typedef struct tropicd_chip_t {
+    lt_handle_t h;
+    tropicd_dev_t dev;
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+    const char *spec;
+    /** Nonzero when the secure session is established */
+    uint8_t session;
+} tropicd_chip_t;
+
+/** Feeder of the kernel entropy pool */
+typedef struct tropicd_entropy_t {
+    /** Descriptor of TROPICD_ENTROPY_DEV, -1 when not feeding */
+    int fd;
+    /** Credited bits per second */
+    uint32_t rate;
+    /** Bytes taken at once */
+    uint32_t batch;
+    uint32_t quiet_ms;
+    /** Bits which may be credited, in thousandths of bit, refilled by `rate` and capped at one batch */
+    uint64_t credit_mbits;
+    uint64_t refill_ms;
+    /** No entropy is taken before this time */
+    uint64_t quiet_until_ms;
+    /** Chip the next batch is taken from */
+    uint8_t chip;
+    /** Credited bytes */
+    uint64_t fed;
+} tropicd_entropy_t;
+
+/** Connected client with its partially received request */
+typedef struct tropicd_client_t {
+    int fd;
+    /** Received bytes of the length prefix and body */
+    uint32_t have;
+    uint8_t msg[4 + TROPICD_MSG_LEN_MAX];
+    /** Descriptors received with the request, -1 when not received */
+    int fds[3];
+    /** Attached shared memory ring, NULL when requests come over the socket */
+    tropicd_shm_t *shm;
+    /** Doorbell rung by the client */
+    int req_efd;
+    /** Doorbell rung by the daemon */
+    int res_efd;
+} tropicd_client_t;
+
+static tropicd_chip_t tropicd_chips[TROPICD_CHIPS_MAX];
+static uint8_t tropicd_chips_cnt;
+/** Chip of the next request sent to TROPICD_CHIP_ANY */
+static uint8_t tropicd_chip_next;
+static tropicd_client_t *tropicd_clients[TROPICD_CLIENTS_MAX];
+/** Response being sent, the daemon sends one response at a time */
+static uint8_t tropicd_res[4 + TROPICD_MSG_LEN_MAX];
+/** Private copy of request taken from shared memory, which is checked against the allow list */
+static uint8_t tropicd_shm_req[TROPICD_MSG_LEN_MAX];
+
+static uint8_t tropicd_shipriv[32];
+static uint8_t tropicd_shipub[32];
+static uint8_t tropicd_pkey_index;
+/** Nonzero when commands changing configuration of the chip are allowed */
+static int tropicd_allow_write;
+
+static tropicd_entropy_t tropicd_entropy = {.fd = -1,
+                                            .batch = TROPICD_ENTROPY_BATCH_DEFAULT,
+                                            .quiet_ms = TROPICD_ENTROPY_QUIET_MS_DEFAULT};
+/** Argument of RNDADDENTROPY, `struct rand_pool_info` followed by the random bytes */
+static uint32_t tropicd_entropy_info[(sizeof(struct rand_pool_info) + TROPICD_ENTROPY_BATCH_MAX) / sizeof(uint32_t)];
+
+/** Longest predicted latency of a request of each class in ms, 0 admits all requests of the class */
+static uint32_t tropicd_deadline_ms[TROPICD_CLASS_CNT];
+/** Average service time of commands of each ID in us, 0 until one is executed */
+static uint32_t tropicd_service_us[256];
+/** Time when poll() last returned, requests served since then have waited from it */
+static uint64_t tropicd_round_us;
+/** Requests answered with LT_OVERLOAD */
+static uint64_t tropicd_overloaded;
+
+static volatile sig_atomic_t tropicd_quit;
+
+static void tropicd_on_signal(int sig)
+{
+    (void)sig;
+    tropicd_quit = 1;
+}
+
+static void tropicd_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -c CHIP [-c CHIP ...] -k SHIPRIV -p SHIPUB [-i INDEX] [-s SOCKET] [-f HZ] [-w]\n"
+            "       [-e RATE [-b BYTES] [-q MS]] [-d HIGH,NORMAL,LOW]\n"
+            "  -c CHIP    chip to serve, "
+#if TROPICD_PORT_SPI
+            "SPIDEV:GPIOCHIP:CS_PIN or SPIDEV:hw for native chip select\n"
+#else
+            "HOST:PORT of the model server\n"
+#endif
+            "  -k SHIPRIV file with 32 B private pairing key\n"
+            "  -p SHIPUB  file with 32 B public pairing key\n"
+            "  -i INDEX   pairing key slot, 0 by default\n"
+            "  -s SOCKET  socket to listen on, " TROPICD_SOCKET_DEFAULT " by default\n"
+            "  -f HZ      SPI speed, %d by default\n"
+            "  -w         allow commands writing pairing keys and configuration\n"
+            "  -e RATE    feed " TROPICD_ENTROPY_DEV " with at most RATE bits per second in idle time\n"
+            "  -b BYTES   random bytes taken at once, %d by default, at most %d\n"
+            "  -q MS      no entropy is taken for MS after client activity, %d by default\n"
+            "  -d HIGH,NORMAL,LOW\n"
+            "             deadlines in ms of signing, other and random requests, 0 admits all, by default\n",
+            prog, TROPICD_SPI_SPEED_DEFAULT, TROPICD_ENTROPY_BATCH_DEFAULT, TROPICD_ENTROPY_BATCH_MAX,
+            TROPICD_ENTROPY_QUIET_MS_DEFAULT);
+}
+
+static int tropicd_key_read(const char *path, uint8_t *key)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    size_t len = fread(key, 1, 32, f);
+    int extra = fgetc(f);
+    fclose(f);
+    if ((len != 32) || (extra != EOF)) {
+        fprintf(stderr, "%s does not contain exactly 32 bytes\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/** Sets the device of the chip up from its specification given by -c */
+static int tropicd_chip_parse(tropicd_chip_t *chip, const char *spec, const int spi_speed)
+{
+    char buf[2 * DEVICE_PATH_MAX_LEN];
+    tropicd_dev_t *dev = &chip->dev;
+
+    if (strlen(spec) >= sizeof(buf)) {
+        return -1;
+    }
+    strcpy(buf, spec);
+    chip->spec = spec;
+
+#if TROPICD_PORT_SPI
+    char *gpio = strchr(buf, ':');
+    if (!gpio) {
+        return -1;
+    }
+    *gpio++ = '\0';
+    if (strlen(buf) >= sizeof(dev->spi_dev)) {
+        return -1;
+    }
+    strcpy(dev->spi_dev, buf);
+    dev->spi_speed = spi_speed;
+    if (!strcmp(gpio, "hw")) {
+        dev->spi_hw_cs = 1;
+    }
+    else {
+        char *cs = strchr(gpio, ':');
+        if (!cs || (strlen(gpio) >= sizeof(dev->gpio_dev))) {
+            return -1;
+        }
+        *cs++ = '\0';
+        strcpy(dev->gpio_dev, gpio);
+        dev->gpio_cs_num = atoi(cs);
+    }
+#else
+    (void)spi_speed;
+    char *port = strrchr(buf, ':');
+    if (!port) {
+        return -1;
+    }
+    *port++ = '\0';
+    dev->addr = inet_addr(buf);
+    dev->port = (in_port_t)strtoul(port, NULL, 10);
+    if ((dev->addr == INADDR_NONE) || !dev->port) {
+        return -1;
+    }
+#endif
+    dev->rng_seed = (unsigned int)time(NULL);
+
+    chip->h.l2.device = dev;
+#if LT_SEPARATE_L3_BUFF
+    chip->h.l3.buff = chip->l3_buffer;
+    chip->h.l3.buff_len = sizeof(chip->l3_buffer);
+#endif
+
+    return 0;
+}
+
+/** Returns true when the error means the secure session has to be established again */
+static bool tropicd_session_lost(const lt_ret_t ret)
+{
+    switch (ret) {
+        case LT_HOST_NO_SESSION:
+        case LT_L1_CHIP_STARTUP_MODE:
+        case LT_L2_HSK_ERR:
+        case LT_L2_NO_SESSION:
+        case LT_L2_TAG_ERR:
+        case LT_NONCE_OVERFLOW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static lt_ret_t tropicd_session_start(tropicd_chip_t *chip)
+{
+    lt_ret_t ret = lt_verify_chip_and_start_secure_session(&chip->h, tropicd_shipriv, tropicd_shipub,
+                                                           tropicd_pkey_index);
+    if (ret != LT_OK) {
+        fprintf(stderr, "Chip %s: secure session failed, %s\n", chip->spec, lt_ret_verbose(ret));
+        return ret;
+    }
+    chip->session = 1;
+
+    return LT_OK;
+}
+
+static uint64_t tropicd_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+static uint64_t tropicd_now_ms(void) { return tropicd_now_us() / 1000; }
+
+/** Adds credit for the time elapsed since the last refill */
+static void tropicd_entropy_refill(tropicd_entropy_t *e, const uint64_t now)
+{
+    uint64_t max = (uint64_t)e->batch * 8 * 1000;
+
+    e->credit_mbits += (now - e->refill_ms) * e->rate;
+    e->credit_mbits = (e->credit_mbits > max) ? max : e->credit_mbits;
+    e->refill_ms = now;
+}
+
+/** Returns poll() timeout until the next batch may be taken, -1 when not feeding */
+static int tropicd_entropy_timeout(tropicd_entropy_t *e)
+{
+    if (e->fd < 0) {
+        return -1;
+    }
+
+    uint64_t now = tropicd_now_ms();
+    uint64_t need = (uint64_t)e->batch * 8 * 1000;
+    uint64_t wait = (e->quiet_until_ms > now) ? e->quiet_until_ms - now : 0;
+
+    tropicd_entropy_refill(e, now);
+    if (e->credit_mbits < need) {
+        uint64_t refill = (need - e->credit_mbits + e->rate - 1) / e->rate;
+        wait = (refill > wait) ? refill : wait;
+    }
+
+    return (wait > INT32_MAX) ? INT32_MAX : (int)wait;
+}
+
+/** Postpones feeding by the quiet period, called on any client activity */
+static void tropicd_entropy_busy(tropicd_entropy_t *e) { e->quiet_until_ms = tropicd_now_ms() + e->quiet_ms; }
+
+/** Takes a batch of random bytes from the next chip and credits it to the kernel, when the rate allows */
+static void tropicd_entropy_feed(tropicd_entropy_t *e)
+{
+    struct rand_pool_info *info = (struct rand_pool_info *)tropicd_entropy_info;
+    uint8_t *data = (uint8_t *)info->buf;
+    uint64_t now = tropicd_now_ms();
+
+    tropicd_entropy_refill(e, now);
+    if ((e->fd < 0) || (now < e->quiet_until_ms) || (e->credit_mbits < (uint64_t)e->batch * 8 * 1000)) {
+        return;
+    }
+
+    tropicd_chip_t *chip = &tropicd_chips[e->chip];
+    e->chip = (uint8_t)((e->chip + 1) % tropicd_chips_cnt);
+    if (!chip->session && (tropicd_session_start(chip) != LT_OK)) {
+        e->quiet_until_ms = now + TROPICD_ENTROPY_RETRY_MS;
+        return;
+    }
+
+    lt_ret_t ret = lt_random_value_get_large(&chip->h, data, e->batch);
+    if (ret != LT_OK) {
+        fprintf(stderr, "Chip %s: random value for entropy failed, %s\n", chip->spec, lt_ret_verbose(ret));
+        if (tropicd_session_lost(ret)) {
+            chip->session = 0;
+        }
+        e->quiet_until_ms = now + TROPICD_ENTROPY_RETRY_MS;
+        return;
+    }
+
+    info->entropy_count = (int)(e->batch * 8);
+    info->buf_size = (int)e->batch;
+    if (ioctl(e->fd, RNDADDENTROPY, info) < 0) {
+        // Crediting needs CAP_SYS_ADMIN, the daemon keeps serving clients without feeding
+        fprintf(stderr, "Cannot credit entropy to %s: %s, feeding stopped\n", TROPICD_ENTROPY_DEV, strerror(errno));
+        close(e->fd);
+        e->fd = -1;
+    }
+    else {
+        e->credit_mbits -= (uint64_t)e->batch * 8 * 1000;
+        e->fed += e->batch;
+    }
+    memset(data, 0, e->batch);
+}
+
+/** Returns true when the command is allowed to clients */
+static bool tropicd_cmd_allowed(const uint8_t cmd_id)
+{
+    switch (cmd_id) {
+        case LT_L3_PAIRING_KEY_WRITE_CMD_ID:
+        case LT_L3_PAIRING_KEY_INVALIDATE_CMD_ID:
+        case LT_L3_R_CONFIG_WRITE_CMD_ID:
+        case LT_L3_R_CONFIG_ERASE_CMD_ID:
+        case LT_L3_I_CONFIG_WRITE_CMD_ID:
+            return tropicd_allow_write;
+        default:
+            return true;
+    }
+}
+
+/** Returns class of a request with the command */
+static uint8_t tropicd_cmd_class(const uint8_t cmd_id)
+{
+    switch (cmd_id) {
+        case LT_L3_ECDSA_SIGN_CMD_ID:
+        case LT_L3_EDDSA_SIGN_CMD_ID:
+        case LT_L3_MAC_AND_DESTROY_CMD_ID:
+            return TROPICD_CLASS_HIGH;
+        case LT_L3_RANDOM_VALUE_GET_CMD_ID:
+            return TROPICD_CLASS_LOW;
+        default:
+            return TROPICD_CLASS_NORMAL;
+    }
+}
+
+/** Returns predicted service time of the command, its execution time until one is executed */
+static uint32_t tropicd_cmd_service_us(const uint8_t cmd_id)
+{
+    const lt_l3_cmd_desc_t *desc = lt_l3_cmd_desc_get(cmd_id);
+
+    return tropicd_service_us[cmd_id] ? tropicd_service_us[cmd_id] : (desc ? desc->exec_us : 0);
+}
+
+/** Adds service time of an executed command to the average of its ID */
+static void tropicd_cmd_served(const uint8_t cmd_id, const uint64_t service_us)
+{
+    uint32_t *avg_us = &tropicd_service_us[cmd_id];
+    uint32_t sample_us = (service_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)service_us;
+
+    *avg_us = *avg_us ? (*avg_us - *avg_us / TROPICD_SERVICE_EWMA + sample_us / TROPICD_SERVICE_EWMA)
+                      : (sample_us ? sample_us : 1);
+}
+
+/** Parses deadlines of -d, returns 0 when all three are given */
+static int tropicd_deadlines_parse(const char *str)
+{
+    char *end;
+    for (int i = 0; i < TROPICD_CLASS_CNT; i++) {
+        tropicd_deadline_ms[i] = (uint32_t)strtoul(str, &end, 10);
+        if ((end == str) || (*end != ((i + 1 < TROPICD_CLASS_CNT) ? ',' : '\0'))) {
+            return -1;
+        }
+        str = end + 1;
+    }
+
+    return 0;
+}
+
+static void tropicd_put_u16(uint8_t *p, const uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t tropicd_get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+/**
+ * Executes request body of `len` bytes in `req`, returns length of the response body written to `res`. Results are
+ * received by libtropic directly to `res`, which may be a slot of shared memory.
+ */
+static uint32_t tropicd_request(const uint8_t *req, const uint32_t len, uint8_t *res)
+{
+    const tropicd_req_hdr_t *hdr = (const tropicd_req_hdr_t *)req;
+    tropicd_res_hdr_t *res_hdr = (tropicd_res_hdr_t *)res;
+    const uint8_t *cmds[TROPICD_BATCH_MAX];
+    uint16_t cmd_lens[TROPICD_BATCH_MAX];
+
+    res_hdr->version = TROPICD_PROTO_VERSION;
+    res_hdr->chip = (len >= sizeof(*hdr)) ? hdr->chip : TROPICD_CHIP_ANY;
+    res_hdr->cnt = 0;
+    res_hdr->ret = LT_PARAM_ERR;
+
+    // The whole request is checked before any of its commands is executed
+    if ((len < sizeof(*hdr)) || (hdr->version != TROPICD_PROTO_VERSION) || (hdr->op != TROPICD_OP_CMDS) || !hdr->cnt
+        || (hdr->cnt > TROPICD_BATCH_MAX)
+        || ((hdr->chip != TROPICD_CHIP_ANY) && (hdr->chip >= tropicd_chips_cnt))) {
+        return sizeof(*res_hdr);
+    }
+    uint32_t pos = sizeof(*hdr);
+    uint8_t class = TROPICD_CLASS_LOW;
+    uint64_t service_us = 0;
+    for (uint8_t i = 0; i < hdr->cnt; i++) {
+        if (len - pos < 2) {
+            return sizeof(*res_hdr);
+        }
+        cmd_lens[i] = tropicd_get_u16(req + pos);
+        cmds[i] = req + pos + 2;
+        pos += 2;
+        if (!cmd_lens[i] || (cmd_lens[i] > TROPICD_CMD_LEN_MAX) || (len - pos < cmd_lens[i])) {
+            return sizeof(*res_hdr);
+        }
+        pos += cmd_lens[i];
+        if (!tropicd_cmd_allowed(cmds[i][0])) {
+            res_hdr->ret = LT_L3_UNAUTHORIZED;
+            return sizeof(*res_hdr);
+        }
+        if (tropicd_cmd_class(cmds[i][0]) < class) {
+            class = tropicd_cmd_class(cmds[i][0]);
+        }
+        service_us += tropicd_cmd_service_us(cmds[i][0]);
+    }
+    if (pos != len) {
+        return sizeof(*res_hdr);
+    }
+
+    if (tropicd_deadline_ms[class]
+        && (tropicd_now_us() - tropicd_round_us + service_us > (uint64_t)tropicd_deadline_ms[class] * 1000)) {
+        tropicd_overloaded++;
+        res_hdr->ret = LT_OVERLOAD;
+        return sizeof(*res_hdr);
+    }
+
+    uint8_t idx = hdr->chip;
+    if (idx == TROPICD_CHIP_ANY) {
+        idx = tropicd_chip_next;
+        tropicd_chip_next = (uint8_t)((tropicd_chip_next + 1) % tropicd_chips_cnt);
+    }
+    tropicd_chip_t *chip = &tropicd_chips[idx];
+    res_hdr->chip = idx;
+
+    if (!chip->session) {
+        res_hdr->ret = tropicd_session_start(chip);
+        if (res_hdr->ret != LT_OK) {
+            return sizeof(*res_hdr);
+        }
+    }
+
+    uint8_t *out = (uint8_t *)(res_hdr + 1);
+    lt_ret_t ret = LT_OK;
+    for (uint8_t i = 0; i < hdr->cnt; i++) {
+        uint16_t res_len = 0;
+        // Commands after the loss of the session are not executed, they fail with the same error
+        if (chip->session) {
+            uint64_t start_us = tropicd_now_us();
+            ret = lt_raw_cmd(&chip->h, cmds[i], cmd_lens[i], out + 3, TROPICD_CMD_LEN_MAX, &res_len);
+            // Failed commands do not predict the service time of successful ones
+            if (ret == LT_OK) {
+                tropicd_cmd_served(cmds[i][0], tropicd_now_us() - start_us);
+            }
+            if (tropicd_session_lost(ret)) {
+                fprintf(stderr, "Chip %s: session lost, %s\n", chip->spec, lt_ret_verbose(ret));
+                chip->session = 0;
+            }
+        }
+        if (ret != LT_OK) {
+            res_len = 0;
+        }
+        out[0] = (uint8_t)ret;
+        tropicd_put_u16(out + 1, res_len);
+        out += 3 + res_len;
+    }
+    res_hdr->cnt = hdr->cnt;
+    res_hdr->ret = LT_OK;
+
+    return (uint32_t)(out - (uint8_t *)res_hdr);
+}
+
+/** Sends the whole response, waiting for the client at most TROPICD_SEND_TIMEOUT_MS at a time */
+static int tropicd_send(const int fd, const uint8_t *data, size_t len)
+{
+    while (len) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+            continue;
+        }
+        if ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            return -1;
+        }
+        struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+        if (poll(&pfd, 1, TROPICD_SEND_TIMEOUT_MS) <= 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void tropicd_fds_close(tropicd_client_t *c)
+{
+    for (int i = 0; i < 3; i++) {
+        if (c->fds[i] >= 0) {
+            close(c->fds[i]);
+            c->fds[i] = -1;
+        }
+    }
+}
+
+static void tropicd_shm_detach(tropicd_client_t *c)
+{
+    if (c->shm) {
+        munmap(c->shm, sizeof(tropicd_shm_t));
+        close(c->req_efd);
+        close(c->res_efd);
+        c->shm = NULL;
+    }
+}
+
+static void tropicd_client_close(const int i)
+{
+    tropicd_fds_close(tropicd_clients[i]);
+    tropicd_shm_detach(tropicd_clients[i]);
+    close(tropicd_clients[i]->fd);
+    free(tropicd_clients[i]);
+    tropicd_clients[i] = NULL;
+}
+
+/** Maps the ring given by the memfd received with the attach request, takes over the received eventfds */
+static lt_ret_t tropicd_shm_attach(tropicd_client_t *c)
+{
+    struct stat st;
+
+    if (c->shm || (c->fds[0] < 0) || (c->fds[1] < 0) || (c->fds[2] < 0)) {
+        return LT_PARAM_ERR;
+    }
+    // A ring shrunk by the client while mapped would kill the daemon by SIGBUS
+    int seals = fcntl(c->fds[0], F_GET_SEALS);
+    if ((seals < 0) || !(seals & F_SEAL_SHRINK) || (fstat(c->fds[0], &st) < 0)
+        || ((size_t)st.st_size < sizeof(tropicd_shm_t))) {
+        return LT_PARAM_ERR;
+    }
+    tropicd_shm_t *shm = mmap(NULL, sizeof(tropicd_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, c->fds[0], 0);
+    if (shm == MAP_FAILED) {
+        return LT_FAIL;
+    }
+    if ((shm->magic != TROPICD_SHM_MAGIC) || (shm->version != TROPICD_PROTO_VERSION)) {
+        munmap(shm, sizeof(tropicd_shm_t));
+        return LT_PARAM_ERR;
+    }
+    fcntl(c->fds[1], F_SETFL, fcntl(c->fds[1], F_GETFL) | O_NONBLOCK);
+
+    c->shm = shm;
+    c->req_efd = c->fds[1];
+    c->res_efd = c->fds[2];
+    c->fds[1] = c->fds[2] = -1;
+    tropicd_fds_close(c);
+
+    return LT_OK;
+}
+
+/** Completes requests pending in the ring of the client, returns -1 when the client is to be closed */
+static int tropicd_shm_serve(tropicd_client_t *c)
+{
+    uint64_t rung;
+
+    if (read(c->req_efd, &rung, sizeof(rung)) < 0) {
+        return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+    }
+
+    uint32_t tail = c->shm->tail;
+    uint32_t head = __atomic_load_n(&c->shm->head, __ATOMIC_ACQUIRE);
+    if (head - tail > TROPICD_SHM_SLOTS) {
+        return -1;
+    }
+    for (; tail != head; tail++) {
+        tropicd_shm_slot_t *slot = &c->shm->slots[tail % TROPICD_SHM_SLOTS];
+        const uint8_t *req = slot->req;
+        uint32_t len = slot->req_len;
+
+        if (len > TROPICD_MSG_LEN_MAX) {
+            return -1;
+        }
+        // The client could change a command between its check and its execution, so when the allow list is
+        // enforced, the request is taken from a private copy. Otherwise commands are encrypted right from the slot.
+        if (!tropicd_allow_write) {
+            memcpy(tropicd_shm_req, req, len);
+            req = tropicd_shm_req;
+        }
+        slot->res_len = tropicd_request(req, len, slot->res);
+        __atomic_store_n(&c->shm->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    rung = 1;
+    return (write(c->res_efd, &rung, sizeof(rung)) == sizeof(rung)) ? 0 : -1;
+}
+
+/** Receives what the client sent, executes its request when complete, returns -1 when the client is to be closed */
+static int tropicd_client_read(tropicd_client_t *c)
+{
+    uint32_t body_len = 0;
+
+    if (c->have >= 4) {
+        body_len = (uint32_t)c->msg[0] | ((uint32_t)c->msg[1] << 8) | ((uint32_t)c->msg[2] << 16)
+                   | ((uint32_t)c->msg[3] << 24);
+    }
+    size_t want = (c->have < 4) ? 4 - c->have : 4 + body_len - c->have;
+
+    union {
+        struct cmsghdr hdr;
+        uint8_t buf[CMSG_SPACE(sizeof(c->fds))];
+    } cbuf;
+    struct iovec iov = {.iov_base = c->msg + c->have, .iov_len = want};
+    struct msghdr mh = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = cbuf.buf, .msg_controllen = sizeof(cbuf)};
+
+    ssize_t n = recvmsg(c->fd, &mh, MSG_CMSG_CLOEXEC);
+    if (n <= 0) {
+        return ((n < 0) && ((errno == EAGAIN) || (errno == EINTR))) ? 0 : -1;
+    }
+    c->have += (uint32_t)n;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+        if ((cm->cmsg_level == SOL_SOCKET) && (cm->cmsg_type == SCM_RIGHTS)) {
+            size_t cnt = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            int *fds = (int *)CMSG_DATA(cm);
+            // Descriptors of earlier messages are replaced, extra ones are not kept
+            tropicd_fds_close(c);
+            for (size_t i = 0; i < cnt; i++) {
+                if (i < 3) {
+                    c->fds[i] = fds[i];
+                }
+                else {
+                    close(fds[i]);
+                }
+            }
+        }
+    }
+
+    if (c->have == 4) {
+        body_len = (uint32_t)c->msg[0] | ((uint32_t)c->msg[1] << 8) | ((uint32_t)c->msg[2] << 16)
+                   | ((uint32_t)c->msg[3] << 24);
+        if (body_len > TROPICD_MSG_LEN_MAX) {
+            return -1;
+        }
+    }
+    if ((c->have < 4) || (c->have < 4 + body_len)) {
+        return 0;
+    }
+
+    uint32_t res_len = sizeof(tropicd_res_hdr_t);
+    const tropicd_req_hdr_t *hdr = (const tropicd_req_hdr_t *)(c->msg + 4);
+    if ((body_len == sizeof(*hdr)) && (hdr->op == TROPICD_OP_SHM_ATTACH)) {
+        tropicd_res_hdr_t *res_hdr = (tropicd_res_hdr_t *)(tropicd_res + 4);
+        *res_hdr = (tropicd_res_hdr_t){.version = TROPICD_PROTO_VERSION, .chip = hdr->chip, .cnt = 0};
+        res_hdr->ret = (hdr->version == TROPICD_PROTO_VERSION) ? tropicd_shm_attach(c) : LT_PARAM_ERR;
+    }
+    else {
+        res_len = tropicd_request(c->msg + 4, body_len, tropicd_res + 4);
+    }
+    tropicd_fds_close(c);
+    tropicd_res[0] = (uint8_t)res_len;
+    tropicd_res[1] = (uint8_t)(res_len >> 8);
+    tropicd_res[2] = (uint8_t)(res_len >> 16);
+    tropicd_res[3] = (uint8_t)(res_len >> 24);
+    c->have = 0;
+
+    return tropicd_send(c->fd, tropicd_res, 4 + res_len);
+}
+
+static void tropicd_client_accept(const int listen_fd)
+{
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < TROPICD_CLIENTS_MAX; i++) {
+        if (!tropicd_clients[i]) {
+            tropicd_clients[i] = calloc(1, sizeof(tropicd_client_t));
+            if (!tropicd_clients[i]) {
+                break;
+            }
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            tropicd_clients[i]->fd = fd;
+            tropicd_clients[i]->fds[0] = tropicd_clients[i]->fds[1] = tropicd_clients[i]->fds[2] = -1;
+            return;
+        }
+    }
+    fprintf(stderr, "Too many clients, connection refused\n");
+    close(fd);
+}
+
+static int tropicd_listen(const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    // Access to the chips is given to the owner and the group of the socket only
+    if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) || (chmod(path, 0660) < 0) || (listen(fd, 8) < 0)) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *socket_path = TROPICD_SOCKET_DEFAULT;
+    const char *specs[TROPICD_CHIPS_MAX];
+    const char *shipriv_path = NULL, *shipub_path = NULL;
+    int spi_speed = TROPICD_SPI_SPEED_DEFAULT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:k:p:i:s:f:we:b:q:d:h")) != -1) {
+        switch (opt) {
+            case 'c':
+                if (tropicd_chips_cnt == TROPICD_CHIPS_MAX) {
+                    fprintf(stderr, "At most %d chips are supported\n", TROPICD_CHIPS_MAX);
+                    return 1;
+                }
+                specs[tropicd_chips_cnt++] = optarg;
+                break;
+            case 'k':
+                shipriv_path = optarg;
+                break;
+            case 'p':
+                shipub_path = optarg;
+                break;
+            case 'i':
+                tropicd_pkey_index = (uint8_t)atoi(optarg);
+                break;
+            case 's':
+                socket_path = optarg;
+                break;
+            case 'f':
+                spi_speed = atoi(optarg);
+                break;
+            case 'w':
+                tropicd_allow_write = 1;
+                break;
+            case 'e':
+                tropicd_entropy.rate = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                tropicd_entropy.batch = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'q':
+                tropicd_entropy.quiet_ms = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                if (tropicd_deadlines_parse(optarg) != 0) {
+                    tropicd_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                tropicd_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!tropicd_chips_cnt || !shipriv_path || !shipub_path || (tropicd_pkey_index > PAIRING_KEY_SLOT_INDEX_3)
+        || !tropicd_entropy.batch || (tropicd_entropy.batch > TROPICD_ENTROPY_BATCH_MAX)) {
+        tropicd_usage(argv[0]);
+        return 1;
+    }
+    if ((tropicd_key_read(shipriv_path, tropicd_shipriv) != 0) || (tropicd_key_read(shipub_path, tropicd_shipub) != 0)) {
+        return 1;
+    }
+
+    // Broken connection to a chip or to a client is reported by the failing call instead
+    signal(SIGPIPE, SIG_IGN);
+
+    int result = 1;
+    uint8_t inited = 0;
+    for (; inited < tropicd_chips_cnt; inited++) {
+        tropicd_chip_t *chip = &tropicd_chips[inited];
+        if (tropicd_chip_parse(chip, specs[inited], spi_speed) != 0) {
+            fprintf(stderr, "Invalid chip %s\n", specs[inited]);
+            goto deinit;
+        }
+        lt_ret_t ret = lt_init(&chip->h);
+        if (ret != LT_OK) {
+            fprintf(stderr, "Chip %s: init failed, %s\n", chip->spec, lt_ret_verbose(ret));
+            goto deinit;
+        }
+        // A chip without session is not fatal, the session is tried again with the first request for it
+        tropicd_session_start(chip);
+    }
+
+    int listen_fd = tropicd_listen(socket_path);
+    if (listen_fd < 0) {
+        goto deinit;
+    }
+
+    if (tropicd_entropy.rate) {
+        tropicd_entropy.fd = open(TROPICD_ENTROPY_DEV, O_WRONLY | O_CLOEXEC);
+        if (tropicd_entropy.fd < 0) {
+            fprintf(stderr, "Cannot open %s: %s\n", TROPICD_ENTROPY_DEV, strerror(errno));
+            close(listen_fd);
+            goto deinit;
+        }
+        tropicd_entropy.refill_ms = tropicd_now_ms();
+    }
+
+    struct sigaction sa = {.sa_handler = tropicd_on_signal};
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    while (!tropicd_quit) {
+        // Each client has its socket and possibly doorbell of its ring
+        struct pollfd pfds[1 + 2 * TROPICD_CLIENTS_MAX];
+        int idx[1 + 2 * TROPICD_CLIENTS_MAX];
+        bool doorbell[1 + 2 * TROPICD_CLIENTS_MAX];
+        nfds_t nfds = 0;
+
+        pfds[nfds++] = (struct pollfd){.fd = listen_fd, .events = POLLIN};
+        for (int i = 0; i < TROPICD_CLIENTS_MAX; i++) {
+            if (tropicd_clients[i]) {
+                idx[nfds] = i;
+                doorbell[nfds] = false;
+                pfds[nfds++] = (struct pollfd){.fd = tropicd_clients[i]->fd, .events = POLLIN};
+            }
+            if (tropicd_clients[i] && tropicd_clients[i]->shm) {
+                idx[nfds] = i;
+                doorbell[nfds] = true;
+                pfds[nfds++] = (struct pollfd){.fd = tropicd_clients[i]->req_efd, .events = POLLIN};
+            }
+        }
+
+        int ready = poll(pfds, nfds, tropicd_entropy_timeout(&tropicd_entropy));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (ready == 0) {
+            tropicd_entropy_feed(&tropicd_entropy);
+            continue;
+        }
+        tropicd_round_us = tropicd_now_us();
+        tropicd_entropy_busy(&tropicd_entropy);
+        for (nfds_t i = 1; i < nfds; i++) {
+            tropicd_client_t *c = tropicd_clients[idx[i]];
+            // Client could be closed while serving its other descriptor
+            if (!c || !pfds[i].revents) {
+                continue;
+            }
+            if ((doorbell[i] ? tropicd_shm_serve(c) : tropicd_client_read(c)) != 0) {
+                tropicd_client_close(idx[i]);
+            }
+        }
+        if (pfds[0].revents & POLLIN) {
+            tropicd_client_accept(listen_fd);
+        }
+    }
+    result = 0;
+
+    for (int i = 0; i < TROPICD_CLIENTS_MAX; i++) {
+        if (tropicd_clients[i]) {
+            tropicd_client_close(i);
+        }
+    }
+    close(listen_fd);
+    unlink(socket_path);
+    if (tropicd_entropy.rate) {
+        fprintf(stderr, "Credited %llu bytes of entropy\n", (unsigned long long)tropicd_entropy.fed);
+    }
+    if (tropicd_overloaded) {
+        fprintf(stderr, "Refused %llu requests as overloaded\n", (unsigned long long)tropicd_overloaded);
+    }
+    if (tropicd_entropy.fd >= 0) {
+        close(tropicd_entropy.fd);
+    }
+
+deinit:
+    while (inited--) {
+        if (tropicd_chips[inited].session) {
+            lt_session_abort(&tropicd_chips[inited].h);
+        }
+        lt_deinit(&tropicd_chips[inited].h);
+    }
+    memset(tropicd_shipriv, 0, sizeof(tropicd_shipriv));
+
+    return result;
+}
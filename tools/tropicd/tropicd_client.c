@@ -0,0 +1,455 @@
+/**
+ * @file tropicd_client.c
+ * @author Tropic Square s.r.o.
+ * @brief Client of tropicd.
+ *
+ * Commands are assembled in the L3 structures of lt_l3_api_structs.h, the plaintext sent to the daemon starts at
+ * their `cmd_id` field, same as the plaintext libtropic encrypts. Results are received into the L3 structures from
+ * their `result` field.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include "tropicd_client.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "lt_l3_api_structs.h"
+
+/** Plaintext of L3 structure `p`, starting at its field `field` */
+#define TROPICD_PLAIN(p, field) ((uint8_t *)(p) + offsetof(__typeof__(*(p)), field))
+/** Maximal plaintext length of L3 structure `p`, from its field `field` up to its tag */
+#define TROPICD_PLAIN_MAX(p, field) ((uint16_t)(offsetof(__typeof__(*(p)), tag) - offsetof(__typeof__(*(p)), field)))
+
+lt_ret_t tropicd_connect(tropicd_conn_t *conn, const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (!conn) {
+        return LT_PARAM_ERR;
+    }
+    if (!path) {
+        path = TROPICD_SOCKET_DEFAULT;
+    }
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return LT_PARAM_ERR;
+    }
+    strcpy(addr.sun_path, path);
+
+    conn->shm = NULL;
+    conn->req_efd = conn->res_efd = -1;
+    conn->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (conn->fd < 0) {
+        return LT_FAIL;
+    }
+    if (connect(conn->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(conn->fd);
+        conn->fd = -1;
+        return LT_FAIL;
+    }
+
+    return LT_OK;
+}
+
+void tropicd_disconnect(tropicd_conn_t *conn)
+{
+    if (conn && conn->shm) {
+        munmap(conn->shm, sizeof(tropicd_shm_t));
+        close(conn->req_efd);
+        close(conn->res_efd);
+        conn->shm = NULL;
+    }
+    if (conn && (conn->fd >= 0)) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+}
+
+static lt_ret_t tropicd_send_all(const int fd, const uint8_t *data, size_t len)
+{
+    while (len) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return LT_FAIL;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+
+    return LT_OK;
+}
+
+static lt_ret_t tropicd_recv_all(const int fd, uint8_t *data, size_t len)
+{
+    while (len) {
+        ssize_t n = recv(fd, data, len, 0);
+        if (n <= 0) {
+            if ((n < 0) && (errno == EINTR)) {
+                continue;
+            }
+            return LT_FAIL;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+
+    return LT_OK;
+}
+
+/** Writes request body of `cnt` commands to `body`, returns its length */
+static uint32_t tropicd_req_build(uint8_t *body, const uint8_t chip, const tropicd_cmd_t *cmds, const uint8_t cnt)
+{
+    tropicd_req_hdr_t *hdr = (tropicd_req_hdr_t *)body;
+    *hdr = (tropicd_req_hdr_t){.version = TROPICD_PROTO_VERSION, .chip = chip, .cnt = cnt, .op = TROPICD_OP_CMDS};
+    uint8_t *p = (uint8_t *)(hdr + 1);
+    for (uint8_t i = 0; i < cnt; i++) {
+        p[0] = (uint8_t)cmds[i].cmd_len;
+        p[1] = (uint8_t)(cmds[i].cmd_len >> 8);
+        memcpy(p + 2, cmds[i].cmd, cmds[i].cmd_len);
+        p += 2 + cmds[i].cmd_len;
+    }
+
+    return (uint32_t)(p - body);
+}
+
+/** Takes results of `cnt` commands from response body of `len` bytes */
+static lt_ret_t tropicd_res_parse(const uint8_t *body, const uint32_t len, tropicd_cmd_t *cmds, const uint8_t cnt)
+{
+    const tropicd_res_hdr_t *res_hdr = (const tropicd_res_hdr_t *)body;
+
+    if ((len < sizeof(*res_hdr)) || (len > TROPICD_MSG_LEN_MAX) || (res_hdr->version != TROPICD_PROTO_VERSION)) {
+        return LT_FAIL;
+    }
+    if (res_hdr->ret != LT_OK) {
+        return (lt_ret_t)res_hdr->ret;
+    }
+    if (res_hdr->cnt != cnt) {
+        return LT_FAIL;
+    }
+
+    const uint8_t *r = (const uint8_t *)(res_hdr + 1);
+    const uint8_t *end = body + len;
+    for (uint8_t i = 0; i < cnt; i++) {
+        if (end - r < 3) {
+            return LT_FAIL;
+        }
+        uint16_t res_len = (uint16_t)(r[1] | (r[2] << 8));
+        cmds[i].ret = (lt_ret_t)r[0];
+        r += 3;
+        if (end - r < res_len) {
+            return LT_FAIL;
+        }
+        cmds[i].res_len = 0;
+        if (res_len > cmds[i].res_max_len) {
+            cmds[i].ret = LT_L3_DATA_LEN_ERROR;
+        }
+        else {
+            memcpy(cmds[i].res, r, res_len);
+            cmds[i].res_len = res_len;
+        }
+        r += res_len;
+    }
+
+    return LT_OK;
+}
+
+/** Exchanges request and response of `len` bytes over the socket, `msg` has room for the length prefix */
+static lt_ret_t tropicd_socket_exchange(tropicd_conn_t *conn, uint8_t *msg, uint32_t *len)
+{
+    msg[0] = (uint8_t)*len;
+    msg[1] = (uint8_t)(*len >> 8);
+    msg[2] = (uint8_t)(*len >> 16);
+    msg[3] = (uint8_t)(*len >> 24);
+
+    lt_ret_t ret = tropicd_send_all(conn->fd, msg, 4 + *len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+
+    ret = tropicd_recv_all(conn->fd, msg, 4);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    *len = (uint32_t)msg[0] | ((uint32_t)msg[1] << 8) | ((uint32_t)msg[2] << 16) | ((uint32_t)msg[3] << 24);
+    if (*len > TROPICD_MSG_LEN_MAX) {
+        return LT_FAIL;
+    }
+
+    return tropicd_recv_all(conn->fd, msg + 4, *len);
+}
+
+/** Rings the doorbell of the daemon and waits for it to complete all submitted requests */
+static lt_ret_t tropicd_shm_exchange(tropicd_conn_t *conn)
+{
+    uint64_t rung = 1;
+
+    __atomic_store_n(&conn->shm->head, conn->shm->head + 1, __ATOMIC_RELEASE);
+    if (write(conn->req_efd, &rung, sizeof(rung)) != sizeof(rung)) {
+        return LT_FAIL;
+    }
+
+    while (__atomic_load_n(&conn->shm->tail, __ATOMIC_ACQUIRE) != conn->shm->head) {
+        // Socket is watched as well, its hangup means the daemon is gone
+        struct pollfd pfds[2] = {{.fd = conn->res_efd, .events = POLLIN}, {.fd = conn->fd, .events = POLLIN}};
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return LT_FAIL;
+        }
+        if (pfds[1].revents) {
+            return LT_FAIL;
+        }
+        if ((pfds[0].revents & POLLIN) && (read(conn->res_efd, &rung, sizeof(rung)) != sizeof(rung))) {
+            return LT_FAIL;
+        }
+    }
+
+    return LT_OK;
+}
+
+lt_ret_t tropicd_batch(tropicd_conn_t *conn, const uint8_t chip, tropicd_cmd_t *cmds, const uint8_t cnt)
+{
+    if (!conn || (conn->fd < 0) || !cmds || !cnt || (cnt > TROPICD_BATCH_MAX)) {
+        return LT_PARAM_ERR;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        if (!cmds[i].cmd || !cmds[i].cmd_len || (cmds[i].cmd_len > TROPICD_CMD_LEN_MAX) || !cmds[i].res) {
+            return LT_PARAM_ERR;
+        }
+    }
+
+    lt_ret_t ret;
+    if (conn->shm) {
+        // Commands are written right to the slot, the client has one request in flight at a time
+        tropicd_shm_slot_t *slot = &conn->shm->slots[conn->shm->head % TROPICD_SHM_SLOTS];
+        slot->req_len = tropicd_req_build(slot->req, chip, cmds, cnt);
+        ret = tropicd_shm_exchange(conn);
+        if (ret != LT_OK) {
+            return ret;
+        }
+        return tropicd_res_parse(slot->res, slot->res_len, cmds, cnt);
+    }
+
+    uint8_t *msg = malloc(4 + TROPICD_MSG_LEN_MAX);
+    if (!msg) {
+        return LT_FAIL;
+    }
+    // Whole message is sent at once, so the daemon never waits for the rest of a request
+    uint32_t len = tropicd_req_build(msg + 4, chip, cmds, cnt);
+    ret = tropicd_socket_exchange(conn, msg, &len);
+    if (ret == LT_OK) {
+        ret = tropicd_res_parse(msg + 4, len, cmds, cnt);
+    }
+    free(msg);
+
+    return ret;
+}
+
+lt_ret_t tropicd_shm_attach(tropicd_conn_t *conn)
+{
+    if (!conn || (conn->fd < 0) || conn->shm) {
+        return LT_PARAM_ERR;
+    }
+
+    lt_ret_t ret = LT_FAIL;
+    int fds[3] = {memfd_create("tropicd", MFD_CLOEXEC | MFD_ALLOW_SEALING), eventfd(0, EFD_CLOEXEC),
+                  eventfd(0, EFD_CLOEXEC)};
+    tropicd_shm_t *shm = MAP_FAILED;
+    if ((fds[0] < 0) || (fds[1] < 0) || (fds[2] < 0) || (ftruncate(fds[0], sizeof(tropicd_shm_t)) < 0)
+        || (fcntl(fds[0], F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) < 0)) {
+        goto close;
+    }
+    shm = mmap(NULL, sizeof(tropicd_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    if (shm == MAP_FAILED) {
+        goto close;
+    }
+    shm->magic = TROPICD_SHM_MAGIC;
+    shm->version = TROPICD_PROTO_VERSION;
+
+    // Attach request carries the descriptors, its response tells whether the daemon took the ring
+    uint8_t msg[4 + sizeof(tropicd_res_hdr_t)] = {sizeof(tropicd_req_hdr_t)};
+    tropicd_req_hdr_t hdr = {.version = TROPICD_PROTO_VERSION, .op = TROPICD_OP_SHM_ATTACH};
+    memcpy(msg + 4, &hdr, sizeof(hdr));
+    union {
+        struct cmsghdr hdr;
+        uint8_t buf[CMSG_SPACE(sizeof(fds))];
+    } cbuf = {0};
+    struct iovec iov = {.iov_base = msg, .iov_len = 4 + sizeof(hdr)};
+    struct msghdr mh = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = cbuf.buf, .msg_controllen = sizeof(cbuf)};
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+    if (sendmsg(conn->fd, &mh, MSG_NOSIGNAL) != (ssize_t)(4 + sizeof(hdr))) {
+        goto close;
+    }
+    if ((tropicd_recv_all(conn->fd, msg, sizeof(msg)) != LT_OK) || (msg[0] != sizeof(tropicd_res_hdr_t))
+        || msg[1] || msg[2] || msg[3]) {
+        goto close;
+    }
+    ret = (lt_ret_t)((tropicd_res_hdr_t *)(msg + 4))->ret;
+    if (ret != LT_OK) {
+        goto close;
+    }
+
+    conn->shm = shm;
+    conn->req_efd = fds[1];
+    conn->res_efd = fds[2];
+    close(fds[0]);
+
+    return LT_OK;
+
+close:
+    if (shm != MAP_FAILED) {
+        munmap(shm, sizeof(tropicd_shm_t));
+    }
+    for (int i = 0; i < 3; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+
+    return ret;
+}
+
+/** Executes a single command */
+static lt_ret_t tropicd_cmd(tropicd_conn_t *conn, const uint8_t chip, const uint8_t *cmd, const uint16_t cmd_len,
+                            uint8_t *res, const uint16_t res_max_len, uint16_t *res_len)
+{
+    tropicd_cmd_t c = {.cmd = cmd, .cmd_len = cmd_len, .res = res, .res_max_len = res_max_len};
+
+    lt_ret_t ret = tropicd_batch(conn, chip, &c, 1);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    *res_len = c.res_len;
+
+    return c.ret;
+}
+
+lt_ret_t tropicd_ping(tropicd_conn_t *conn, const uint8_t chip, const uint8_t *msg_out, uint8_t *msg_in,
+                      const uint16_t len)
+{
+    if (!msg_out || !msg_in || (len > LT_PING_LEN_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_l3_ping_cmd_t cmd;
+    struct lt_l3_ping_res_t res;
+    uint16_t res_len;
+
+    cmd.cmd_id = LT_L3_PING_CMD_ID;
+    memcpy(cmd.data_in, msg_out, len);
+
+    lt_ret_t ret = tropicd_cmd(conn, chip, TROPICD_PLAIN(&cmd, cmd_id), (uint16_t)(LT_L3_PING_CMD_SIZE_MIN + len),
+                               TROPICD_PLAIN(&res, result), TROPICD_PLAIN_MAX(&res, result), &res_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (res_len != LT_L3_PING_RES_SIZE_MIN + len) {
+        return LT_FAIL;
+    }
+    memcpy(msg_in, res.data_out, len);
+
+    return LT_OK;
+}
+
+lt_ret_t tropicd_random_value_get(tropicd_conn_t *conn, const uint8_t chip, uint8_t *buff, const uint16_t len)
+{
+    if (!buff || (len > RANDOM_VALUE_GET_LEN_MAX)) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_l3_random_value_get_cmd_t cmd;
+    struct lt_l3_random_value_get_res_t res;
+    uint16_t res_len;
+
+    cmd.cmd_id = LT_L3_RANDOM_VALUE_GET_CMD_ID;
+    cmd.n_bytes = (uint8_t)len;
+
+    lt_ret_t ret = tropicd_cmd(conn, chip, TROPICD_PLAIN(&cmd, cmd_id), LT_L3_RANDOM_VALUE_GET_CMD_SIZE,
+                               TROPICD_PLAIN(&res, result), TROPICD_PLAIN_MAX(&res, result), &res_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (res_len != LT_L3_RANDOM_VALUE_GET_RES_SIZE_MIN + len) {
+        return LT_FAIL;
+    }
+    memcpy(buff, res.random_data, len);
+
+    return LT_OK;
+}
+
+lt_ret_t tropicd_ecc_ecdsa_sign_digest(tropicd_conn_t *conn, const uint8_t chip, const ecc_slot_t ecc_slot,
+                                       const uint8_t *msg_hash, uint8_t *rs)
+{
+    if (!msg_hash || !rs || (ecc_slot < ECC_SLOT_0) || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_l3_ecdsa_sign_cmd_t cmd = {0};
+    struct lt_l3_ecdsa_sign_res_t res;
+    uint16_t res_len;
+
+    cmd.cmd_id = LT_L3_ECDSA_SIGN_CMD_ID;
+    cmd.slot = (uint16_t)ecc_slot;
+    memcpy(cmd.msg_hash, msg_hash, sizeof(cmd.msg_hash));
+
+    lt_ret_t ret = tropicd_cmd(conn, chip, TROPICD_PLAIN(&cmd, cmd_id), LT_L3_ECDSA_SIGN_CMD_SIZE,
+                               TROPICD_PLAIN(&res, result), TROPICD_PLAIN_MAX(&res, result), &res_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (res_len != LT_L3_ECDSA_SIGN_RES_SIZE) {
+        return LT_FAIL;
+    }
+    memcpy(rs, res.r, 32);
+    memcpy(rs + 32, res.s, 32);
+
+    return LT_OK;
+}
+
+lt_ret_t tropicd_ecc_eddsa_sign(tropicd_conn_t *conn, const uint8_t chip, const ecc_slot_t ecc_slot,
+                                const uint8_t *msg, const uint16_t msg_len, uint8_t *rs)
+{
+    if (!msg || !rs || (msg_len > LT_EDDSA_MSG_LEN_MAX) || (ecc_slot < ECC_SLOT_0) || (ecc_slot > ECC_SLOT_31)) {
+        return LT_PARAM_ERR;
+    }
+
+    struct lt_l3_eddsa_sign_cmd_t cmd = {0};
+    struct lt_l3_eddsa_sign_res_t res;
+    uint16_t res_len;
+
+    cmd.cmd_id = LT_L3_EDDSA_SIGN_CMD_ID;
+    cmd.slot = (uint16_t)ecc_slot;
+    memcpy(cmd.msg, msg, msg_len);
+
+    lt_ret_t ret = tropicd_cmd(conn, chip, TROPICD_PLAIN(&cmd, cmd_id),
+                               (uint16_t)(LT_L3_EDDSA_SIGN_CMD_SIZE_MIN - 1 + msg_len), TROPICD_PLAIN(&res, result),
+                               TROPICD_PLAIN_MAX(&res, result), &res_len);
+    if (ret != LT_OK) {
+        return ret;
+    }
+    if (res_len != LT_L3_EDDSA_SIGN_RES_SIZE) {
+        return LT_FAIL;
+    }
+    memcpy(rs, res.r, 32);
+    memcpy(rs + 32, res.s, 32);
+
+    return LT_OK;
+}
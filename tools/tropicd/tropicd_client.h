@@ -0,0 +1,157 @@
+#ifndef TROPICD_CLIENT_H
+#define TROPICD_CLIENT_H
+
+/**
+ * @file tropicd_client.h
+ * @author Tropic Square s.r.o.
+ * @brief Client of tropicd, executes L3 commands on chips owned by the daemon.
+ *
+ * Functions mirror the matching functions of libtropic.h, with the connection to the daemon in place of the
+ * handle and a chip index (or TROPICD_CHIP_ANY) in place of the secure session, which the daemon holds.
+ * Other commands are executed by tropicd_batch() in their plaintext form.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+#include "tropicd_proto.h"
+
+/** @brief Connection to the daemon */
+typedef struct tropicd_conn_t {
+    /** @private @brief Socket */
+    int fd;
+    /** @private @brief Shared memory ring attached by tropicd_shm_attach(), NULL when not attached */
+    tropicd_shm_t *shm;
+    /** @private @brief Doorbell rung by the client */
+    int req_efd;
+    /** @private @brief Doorbell rung by the daemon */
+    int res_efd;
+} tropicd_conn_t;
+
+/** @brief Command of a batch and its result */
+typedef struct tropicd_cmd_t {
+    /** @brief Command ID followed by the command's data */
+    const uint8_t *cmd;
+    /** @brief Length of `cmd` */
+    uint16_t cmd_len;
+    /** @brief Buffer to receive RESULT byte followed by the result's data */
+    uint8_t *res;
+    /** @brief Size of `res` */
+    uint16_t res_max_len;
+    /** @brief Length of the received result, filled by tropicd_batch() */
+    uint16_t res_len;
+    /** @brief Return value of the command, filled by tropicd_batch() */
+    lt_ret_t ret;
+} tropicd_cmd_t;
+
+/**
+ * @brief Connects to the daemon
+ *
+ * @param conn        Connection
+ * @param path        Socket of the daemon, NULL for TROPICD_SOCKET_DEFAULT
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            LT_FAIL Daemon is not reachable
+ */
+lt_ret_t tropicd_connect(tropicd_conn_t *conn, const char *path);
+
+/**
+ * @brief Closes the connection, the secure sessions are kept by the daemon for other clients
+ *
+ * @param conn        Connection
+ */
+void tropicd_disconnect(tropicd_conn_t *conn);
+
+/**
+ * @brief Attaches shared memory ring to the connection, requests of tropicd_batch() and other functions then go
+ *        through the ring instead of the socket.
+ *
+ * Commands are copied to the ring once, the daemon encrypts them from there and libtropic of the daemon receives
+ * results directly to the ring, without any copy by the kernel and with two eventfd writes per request.
+ *
+ * @param conn        Connection
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Ring was not attached, requests keep going over the socket
+ */
+lt_ret_t tropicd_shm_attach(tropicd_conn_t *conn);
+
+/**
+ * @brief Executes commands one after another on one chip, without commands of other clients in between
+ *
+ * @param conn        Connection
+ * @param chip        Index of the chip (order of -c options of the daemon), or TROPICD_CHIP_ANY
+ * @param cmds        Commands, `ret`, `res` and `res_len` of each are filled
+ * @param cnt         Number of commands, at most TROPICD_BATCH_MAX
+ *
+ * @retval            LT_OK Request was executed, results of the commands are in `cmds`
+ * @retval            other Request was not executed, e.g. LT_L3_UNAUTHORIZED for a command not allowed by the daemon
+ */
+lt_ret_t tropicd_batch(tropicd_conn_t *conn, const uint8_t chip, tropicd_cmd_t *cmds, const uint8_t cnt);
+
+/**
+ * @brief Same as lt_ping(), executed by the daemon
+ *
+ * @param conn        Connection
+ * @param chip        Index of the chip, or TROPICD_CHIP_ANY
+ * @param msg_out     Ping message going out
+ * @param msg_in      Ping message going in
+ * @param len         Length of both messages (msg_out and msg_in)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t tropicd_ping(tropicd_conn_t *conn, const uint8_t chip, const uint8_t *msg_out, uint8_t *msg_in,
+                      const uint16_t len);
+
+/**
+ * @brief Same as lt_random_value_get(), executed by the daemon
+ *
+ * @param conn        Connection
+ * @param chip        Index of the chip, or TROPICD_CHIP_ANY
+ * @param buff        Buffer
+ * @param len         Number of random bytes, at most RANDOM_VALUE_GET_LEN_MAX
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t tropicd_random_value_get(tropicd_conn_t *conn, const uint8_t chip, uint8_t *buff, const uint16_t len);
+
+/**
+ * @brief Same as lt_ecc_ecdsa_sign_digest(), executed by the daemon
+ *
+ * @param conn        Connection
+ * @param chip        Index of the chip, or TROPICD_CHIP_ANY
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msg_hash    SHA256 hash of a message (32B)
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t tropicd_ecc_ecdsa_sign_digest(tropicd_conn_t *conn, const uint8_t chip, const ecc_slot_t ecc_slot,
+                                       const uint8_t *msg_hash, uint8_t *rs);
+
+/**
+ * @brief Same as lt_ecc_eddsa_sign(), executed by the daemon
+ *
+ * @param conn        Connection
+ * @param chip        Index of the chip, or TROPICD_CHIP_ANY
+ * @param ecc_slot    Slot containing a private key, ECC_SLOT_0 - ECC_SLOT_31
+ * @param msg         Buffer containing a message to sign, max length is `LT_EDDSA_MSG_LEN_MAX`
+ * @param msg_len     Length of a message
+ * @param rs          Buffer for storing a signature in a form of R and S bytes (should always have length 64B)
+ *
+ * @retval            LT_OK Function executed successfully
+ * @retval            other Function did not execute successully, you might use lt_ret_verbose() to get verbose encoding
+ * of returned value
+ */
+lt_ret_t tropicd_ecc_eddsa_sign(tropicd_conn_t *conn, const uint8_t chip, const ecc_slot_t ecc_slot,
+                                const uint8_t *msg, const uint16_t msg_len, uint8_t *rs);
+
+#endif  // TROPICD_CLIENT_H
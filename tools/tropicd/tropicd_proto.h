@@ -0,0 +1,117 @@
+#ifndef TROPICD_PROTO_H
+#define TROPICD_PROTO_H
+
+/**
+ * @file tropicd_proto.h
+ * @author Tropic Square s.r.o.
+ * @brief Protocol between tropicd and its clients over a Unix domain socket.
+ *
+ * Each message is a 32-bit little-endian length of its body followed by the body. A request body is
+ * `tropicd_req_hdr_t` followed by `cnt` L3 commands, a response body is `tropicd_res_hdr_t` followed by `cnt`
+ * results. Multi-byte fields are little-endian.
+ *
+ * - Command: 16-bit length, then plaintext of the command (command ID followed by its data).
+ * - Result: `lt_ret_t` of the command (1 byte), 16-bit length, then plaintext of the result (RESULT byte followed by
+ *   its data). The length is zero when the command failed.
+ *
+ * Commands of one request are executed on one chip one after another, no command of another client is executed
+ * between them.
+ *
+ * Instead of sending requests over the socket, a client can attach a shared memory ring (`tropicd_shm_t`) by
+ * TROPICD_OP_SHM_ATTACH request carrying memfd of the ring and two eventfds as SCM_RIGHTS. Requests and responses
+ * are then placed in the slots of the ring, with the same bodies as over the socket, and the eventfds serve as
+ * doorbells: the client writes the first one after it submitted requests, the daemon writes the second one after it
+ * completed them. The socket stays open, its closing detaches the ring.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+
+#include "libtropic_common.h"
+
+/** @brief Version of the protocol, increased when messages change */
+#define TROPICD_PROTO_VERSION 1
+
+/** @brief Socket the daemon listens on, unless set otherwise */
+#define TROPICD_SOCKET_DEFAULT "/run/tropicd.sock"
+
+/** @brief Chip of the request is chosen by the daemon */
+#define TROPICD_CHIP_ANY 0xFF
+
+/** @brief Maximal number of commands in one request */
+#define TROPICD_BATCH_MAX 16
+
+/** @brief Maximal length of a command's or result's plaintext */
+#define TROPICD_CMD_LEN_MAX L3_CYPHERTEXT_MAX_SIZE
+
+/** @brief Maximal length of a message body */
+#define TROPICD_MSG_LEN_MAX (sizeof(tropicd_res_hdr_t) + TROPICD_BATCH_MAX * (3 + TROPICD_CMD_LEN_MAX))
+
+/** @brief Request executes L3 commands */
+#define TROPICD_OP_CMDS 0
+/** @brief Request attaches shared memory ring, it has no commands */
+#define TROPICD_OP_SHM_ATTACH 1
+
+/** @brief Number of slots in shared memory ring */
+#define TROPICD_SHM_SLOTS 4
+/** @brief Magic of shared memory ring */
+#define TROPICD_SHM_MAGIC 0x54524431u
+
+/** @brief Header of request body */
+typedef struct tropicd_req_hdr_t {
+    /** @brief TROPICD_PROTO_VERSION */
+    uint8_t version;
+    /** @brief Index of the chip, or TROPICD_CHIP_ANY */
+    uint8_t chip;
+    /** @brief Number of commands, 1 to TROPICD_BATCH_MAX */
+    uint8_t cnt;
+    /** @brief TROPICD_OP_CMDS or TROPICD_OP_SHM_ATTACH */
+    uint8_t op;
+} __attribute__((packed)) tropicd_req_hdr_t;
+
+/** @brief Header of response body */
+typedef struct tropicd_res_hdr_t {
+    /** @brief TROPICD_PROTO_VERSION */
+    uint8_t version;
+    /** @brief Index of the chip which executed the commands */
+    uint8_t chip;
+    /** @brief Number of results, zero when the request was rejected as a whole */
+    uint8_t cnt;
+    /** @brief `lt_ret_t` of the request as a whole, e.g. LT_PARAM_ERR for malformed request */
+    uint8_t ret;
+} __attribute__((packed)) tropicd_res_hdr_t;
+
+/** @brief Slot of shared memory ring, holds one request and its response */
+typedef struct tropicd_shm_slot_t {
+    /** @brief Length of request body, written by the client */
+    uint32_t req_len;
+    /** @brief Length of response body, written by the daemon */
+    uint32_t res_len;
+    /** @brief Request body */
+    uint8_t req[TROPICD_MSG_LEN_MAX];
+    /** @brief Response body */
+    uint8_t res[TROPICD_MSG_LEN_MAX];
+} tropicd_shm_slot_t;
+
+/**
+ * @brief Shared memory ring, created by the client.
+ *
+ * The client fills the slot `head % TROPICD_SHM_SLOTS` and increments `head`, the daemon completes the slot
+ * `tail % TROPICD_SHM_SLOTS` and increments `tail`. At most TROPICD_SHM_SLOTS requests are pending, the memfd has to
+ * be sealed against shrinking.
+ */
+typedef struct tropicd_shm_t {
+    /** @brief TROPICD_SHM_MAGIC */
+    uint32_t magic;
+    /** @brief TROPICD_PROTO_VERSION */
+    uint32_t version;
+    /** @brief Number of submitted requests, written by the client */
+    uint32_t head;
+    /** @brief Number of completed requests, written by the daemon */
+    uint32_t tail;
+    /** @brief Slots */
+    tropicd_shm_slot_t slots[TROPICD_SHM_SLOTS];
+} tropicd_shm_t;
+
+#endif  // TROPICD_PROTO_H
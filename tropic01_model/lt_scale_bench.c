@@ -0,0 +1,512 @@
+/**
+ * @file lt_scale_bench.c
+ * @author Tropic Square s.r.o.
+ * @brief Multi-chip scaling benchmark of `lt_pool_t` against several model servers.
+ *
+ * One handle is opened to each model server listed in LT_MODEL_PORTS or LT_MODEL_SOCKETS (set by
+ * `model_test_runner.py -n`), then the same number of jobs per chip is executed by each scheduling policy:
+ *
+ * - direct: one thread per chip executes its share of jobs by plain API calls, the reference without any dispatcher,
+ * - pool: one worker thread per chip takes jobs of one batch by `lt_pool_work()`,
+ * - prio: as pool, with a quarter of the jobs in LT_POOL_PRIO_HIGH class of `lt_pool_prio_t`, its queues are guarded
+ *   by a mutex whose contention is counted,
+ * - async: one thread multiplexes all chips by `lt_submit()` and `lt_poll_multi()`, only with LT_ASYNC.
+ *
+ * Each policy prints one line of JSON with throughput, latencies of jobs and host CPU time, so
+ * scripts/model_scale_bench.py can compare them as the number of chips grows.
+ *
+ * @license For the license see file LICENSE.txt file in the root directory of this source tree.
+ */
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libtropic.h"
+#include "libtropic_bench.h"
+#include "libtropic_common.h"
+#include "libtropic_logging.h"
+#include "libtropic_port_unix_tcp.h"
+
+/** Version of the JSON output, increased when fields change meaning */
+#define LT_SCALE_JSON_VERSION 1
+/** Maximal number of model servers */
+#define LT_SCALE_CHIPS_MAX 32
+/** Jobs executed by each chip unless set by LT_SCALE_JOBS */
+#define LT_SCALE_JOBS_DEFAULT 100
+
+/** Chip with its handle */
+typedef struct lt_scale_chip_t {
+    lt_handle_t h;
+    lt_dev_unix_tcp_t dev;
+    /** Unix domain socket of the model server, when listed in LT_MODEL_SOCKETS */
+    char unix_path[108];
+#if LT_SEPARATE_L3_BUFF
+    uint8_t l3_buffer[L3_PACKET_MAX_SIZE] __attribute__((aligned(16)));
+#endif
+#if LT_ASYNC
+    lt_async_t async;
+    lt_async_op_t op;
+    uint64_t op_start;
+#endif
+    /** Completion of the previous job of the chip, the next job's latency is measured from it */
+    uint64_t last_us;
+    pthread_t thread;
+    /** Handle was initialized by `lt_init()` */
+    uint8_t inited;
+    /** Key of LT_BENCH_ECDSA_SLOT was generated in a session */
+    uint8_t keyed;
+} lt_scale_chip_t;
+
+/** One run of a policy */
+typedef struct lt_scale_run_t {
+    lt_pool_t pool;
+    lt_pool_prio_t prio;
+    lt_pool_job_t *jobs;
+    uint32_t jobs_cnt;
+    /** Latency of each completed job */
+    uint32_t *samples;
+    uint32_t samples_cnt;
+    uint32_t errors;
+    /** Times the mutex of the priority queues was found locked */
+    uint32_t contended;
+    pthread_mutex_t lock;
+} lt_scale_run_t;
+
+static lt_scale_chip_t lt_scale_chips[LT_SCALE_CHIPS_MAX];
+static lt_handle_t *lt_scale_handles[LT_SCALE_CHIPS_MAX];
+static uint8_t lt_scale_chips_cnt;
+static lt_scale_run_t lt_scale_run;
+/** Operation of the jobs, selected by LT_SCALE_OP */
+static lt_pool_op_t lt_scale_op = LT_POOL_OP_ECDSA_SIGN_DIGEST;
+static uint16_t lt_scale_in_len = 32;
+static uint8_t lt_scale_in[PING_LEN_MAX];
+/** Output buffers are shared by the jobs, their content is not checked */
+static uint8_t lt_scale_out[LT_SCALE_CHIPS_MAX][PING_LEN_MAX];
+
+uint64_t lt_bench_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+uint64_t lt_bench_cpu_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+static uint32_t lt_scale_time_us32(void) { return (uint32_t)lt_bench_time_us(); }
+
+static void lt_scale_lock(void *ctx)
+{
+    lt_scale_run_t *run = ctx;
+
+    if (pthread_mutex_trylock(&run->lock) != 0) {
+        __atomic_fetch_add(&run->contended, 1, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&run->lock);
+    }
+}
+
+static void lt_scale_unlock(void *ctx) { pthread_mutex_unlock(&((lt_scale_run_t *)ctx)->lock); }
+
+/** Records latency of a completed job of the chip */
+static void lt_scale_done(lt_scale_run_t *run, const uint8_t chip, const lt_ret_t ret)
+{
+    uint64_t now = lt_bench_time_us();
+    uint64_t elapsed = now - lt_scale_chips[chip].last_us;
+
+    lt_scale_chips[chip].last_us = now;
+    if (ret != LT_OK) {
+        __atomic_fetch_add(&run->errors, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    uint32_t i = __atomic_fetch_add(&run->samples_cnt, 1, __ATOMIC_RELAXED);
+    run->samples[i] = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+}
+
+static void lt_scale_complete(lt_pool_job_t *job, void *ctx) { lt_scale_done(ctx, job->chip, job->ret); }
+
+/** Executes the job by plain API call, as the pool would */
+static lt_ret_t lt_scale_execute(lt_handle_t *h, const lt_pool_job_t *job)
+{
+    switch (job->op) {
+        case LT_POOL_OP_PING:
+            return lt_ping(h, job->in, job->out, job->in_len);
+        case LT_POOL_OP_RANDOM_VALUE_GET:
+            return lt_random_value_get(h, job->out, job->in_len);
+        case LT_POOL_OP_ECDSA_SIGN_DIGEST:
+            return lt_ecc_ecdsa_sign_digest(h, (ecc_slot_t)job->slot, job->in, job->out);
+        default:
+            return LT_PARAM_ERR;
+    }
+}
+
+static void *lt_scale_direct_worker(void *arg)
+{
+    uint8_t chip = (uint8_t)(uintptr_t)arg;
+
+    // Static partition, chip i executes jobs i, i + n, i + 2n, ...
+    lt_scale_chips[chip].last_us = lt_bench_time_us();
+    for (uint32_t i = chip; i < lt_scale_run.jobs_cnt; i += lt_scale_chips_cnt) {
+        lt_scale_done(&lt_scale_run, chip, lt_scale_execute(&lt_scale_chips[chip].h, &lt_scale_run.jobs[i]));
+    }
+
+    return NULL;
+}
+
+static void *lt_scale_pool_worker(void *arg)
+{
+    uint8_t chip = (uint8_t)(uintptr_t)arg;
+
+    lt_scale_chips[chip].last_us = lt_bench_time_us();
+    lt_ret_t ret = lt_pool_work(&lt_scale_run.pool, chip);
+    if (ret != LT_OK) {
+        LT_LOG_ERROR("lt_pool_work() of chip %d failed, ret=%s", chip, lt_ret_verbose(ret));
+    }
+
+    return NULL;
+}
+
+#if LT_ASYNC
+/** Next job to be submitted by the event loop */
+static uint32_t lt_scale_async_next;
+
+static void lt_scale_async_submit(lt_scale_chip_t *c);
+
+static void lt_scale_async_cb(lt_handle_t *h, lt_async_op_t *op, void *ctx)
+{
+    lt_scale_chip_t *c = ctx;
+
+    (void)h;
+    lt_scale_done(&lt_scale_run, (uint8_t)(c - lt_scale_chips), op->ret);
+    lt_scale_async_submit(c);
+}
+
+/** Submits the next job of the run to the chip, one job is in flight per chip */
+static void lt_scale_async_submit(lt_scale_chip_t *c)
+{
+    static const lt_async_cmd_t cmds[] = {[LT_POOL_OP_PING] = LT_ASYNC_PING,
+                                          [LT_POOL_OP_RANDOM_VALUE_GET] = LT_ASYNC_RANDOM_VALUE_GET,
+                                          [LT_POOL_OP_ECDSA_SIGN_DIGEST] = LT_ASYNC_ECDSA_SIGN_DIGEST};
+
+    if (lt_scale_async_next == lt_scale_run.jobs_cnt) {
+        return;
+    }
+    const lt_pool_job_t *job = &lt_scale_run.jobs[lt_scale_async_next++];
+    c->op = (lt_async_op_t){
+        .cmd = cmds[job->op], .slot = job->slot, .in_len = job->in_len, .in = job->in, .out = job->out};
+    if (lt_submit(&c->h, &c->op, lt_scale_async_cb, c) != LT_OK) {
+        lt_scale_done(&lt_scale_run, (uint8_t)(c - lt_scale_chips), LT_FAIL);
+    }
+}
+
+static void lt_scale_async_run(void)
+{
+    lt_scale_async_next = 0;
+    for (uint8_t i = 0; i < lt_scale_chips_cnt; i++) {
+        lt_scale_chips[i].last_us = lt_bench_time_us();
+        lt_scale_async_submit(&lt_scale_chips[i]);
+    }
+
+    // Commands of all chips started in one round are encrypted together
+    while (1) {
+        uint32_t wait_ms = 0;
+        lt_ret_t ret = lt_poll_multi(lt_scale_handles, lt_scale_chips_cnt, &wait_ms);
+        if (ret != LT_PENDING) {
+            if (ret != LT_OK) {
+                LT_LOG_ERROR("lt_poll_multi() failed, ret=%s", lt_ret_verbose(ret));
+            }
+            return;
+        }
+        if (wait_ms) {
+            usleep(wait_ms * 1000);
+        }
+    }
+}
+#endif
+
+static int lt_scale_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/** Returns nearest-rank percentile of sorted samples */
+static uint32_t lt_scale_percentile(const uint32_t *sorted, const uint32_t cnt, const uint32_t pct)
+{
+    uint32_t rank = ((pct * cnt) + 99) / 100;
+
+    return cnt ? sorted[(rank > 0) ? rank - 1 : 0] : 0;
+}
+
+/** Runs all jobs by one policy and prints its result, returns nonzero when some job failed */
+static int lt_scale_policy(const char *policy)
+{
+    lt_scale_run_t *run = &lt_scale_run;
+    void *(*worker)(void *) = lt_scale_pool_worker;
+
+    run->samples_cnt = 0;
+    run->errors = 0;
+    run->contended = 0;
+    for (uint32_t i = 0; i < run->jobs_cnt; i++) {
+        run->jobs[i] = (lt_pool_job_t){.op = lt_scale_op,
+                                       .slot = LT_BENCH_ECDSA_SLOT,
+                                       .in_len = lt_scale_in_len,
+                                       .in = lt_scale_in,
+                                       .out = lt_scale_out[i % LT_SCALE_CHIPS_MAX]};
+    }
+
+    lt_ret_t ret = lt_pool_init(&run->pool, lt_scale_handles, lt_scale_chips_cnt, lt_scale_complete, run);
+    if (!strcmp(policy, "direct")) {
+        worker = lt_scale_direct_worker;
+    }
+    else if (!strcmp(policy, "pool")) {
+        if (ret == LT_OK) {
+            ret = lt_pool_submit(&run->pool, run->jobs, run->jobs_cnt);
+        }
+    }
+    else if (!strcmp(policy, "prio")) {
+        run->prio = (lt_pool_prio_t){
+            .lock = lt_scale_lock, .unlock = lt_scale_unlock, .lock_ctx = run, .time_us = lt_scale_time_us32};
+        uint32_t high = run->jobs_cnt / 4;
+        if (ret == LT_OK) {
+            ret = lt_pool_prio_init(&run->pool, &run->prio);
+        }
+        if (ret == LT_OK) {
+            ret = lt_pool_submit(&run->pool, run->jobs + high, run->jobs_cnt - high);
+        }
+        if ((ret == LT_OK) && high) {
+            ret = lt_pool_submit_prio(&run->pool, LT_POOL_PRIO_HIGH, run->jobs, high);
+        }
+    }
+#if LT_ASYNC
+    else if (!strcmp(policy, "async")) {
+        worker = NULL;
+    }
+#endif
+    else {
+        LT_LOG_ERROR("Unknown policy %s", policy);
+        return -1;
+    }
+    if (ret != LT_OK) {
+        LT_LOG_ERROR("Setup of policy %s failed, ret=%s", policy, lt_ret_verbose(ret));
+        return -1;
+    }
+
+    uint64_t start = lt_bench_time_us(), cpu_start = lt_bench_cpu_us();
+#if LT_ASYNC
+    if (!worker) {
+        lt_scale_async_run();
+    }
+#endif
+    for (uint8_t i = 0; worker && (i < lt_scale_chips_cnt); i++) {
+        if (pthread_create(&lt_scale_chips[i].thread, NULL, worker, (void *)(uintptr_t)i) != 0) {
+            LT_LOG_ERROR("Cannot start worker of chip %d", i);
+            exit(1);
+        }
+    }
+    for (uint8_t i = 0; worker && (i < lt_scale_chips_cnt); i++) {
+        pthread_join(lt_scale_chips[i].thread, NULL);
+    }
+    uint64_t wall_us = lt_bench_time_us() - start, cpu_us = lt_bench_cpu_us() - cpu_start;
+
+    qsort(run->samples, run->samples_cnt, sizeof(run->samples[0]), lt_scale_cmp);
+    uint32_t done = run->samples_cnt;
+    uint32_t ops_per_sec = wall_us ? (uint32_t)((done * 1000000ULL) / wall_us) : 0;
+    lt_pool_prio_stats_t high = {0};
+    if (!strcmp(policy, "prio")) {
+        lt_pool_prio_stats_get(&run->pool, LT_POOL_PRIO_HIGH, &high);
+    }
+
+    LT_LOG_INFO("%-6s %2d chips: %6" PRIu32 " ops/s, p50 %7" PRIu32 " us, p99 %7" PRIu32 " us, cpu %3" PRIu32
+                " %%, %" PRIu32 " errors",
+                policy, lt_scale_chips_cnt, ops_per_sec, lt_scale_percentile(run->samples, done, 50),
+                lt_scale_percentile(run->samples, done, 99), wall_us ? (uint32_t)((cpu_us * 100) / wall_us) : 0,
+                run->errors);
+
+    printf("{\"scale\":\"%s\",\"chips\":%d,\"op\":%d,\"jobs\":%" PRIu32 ",\"errors\":%" PRIu32 ",\"wall_us\":%" PRIu64
+           ",\"ops_per_sec\":%" PRIu32 ",\"p50_us\":%" PRIu32 ",\"p90_us\":%" PRIu32 ",\"p99_us\":%" PRIu32
+           ",\"max_us\":%" PRIu32 ",\"cpu_us\":%" PRIu64 ",\"cpu_per_op_us\":%" PRIu32 ",\"lock_contended\":%" PRIu32
+           ",\"high_latency_us_mean\":%" PRIu32 ",\"high_latency_us_max\":%" PRIu32 ",\"version\":%d}\n",
+           policy, lt_scale_chips_cnt, lt_scale_op, run->jobs_cnt, run->errors, wall_us, ops_per_sec,
+           lt_scale_percentile(run->samples, done, 50), lt_scale_percentile(run->samples, done, 90),
+           lt_scale_percentile(run->samples, done, 99), done ? run->samples[done - 1] : 0, cpu_us,
+           done ? (uint32_t)(cpu_us / done) : 0, run->contended,
+           high.done ? (uint32_t)(high.latency_us_total / high.done) : 0, high.latency_us_max, LT_SCALE_JSON_VERSION);
+
+    return run->errors ? -1 : 0;
+}
+
+/**
+ * Opens the chips listed in LT_MODEL_SOCKETS, or in LT_MODEL_PORTS (or LT_MODEL_PORT) when it is not set, with
+ * sessions and the ECDSA key
+ */
+static int lt_scale_chips_open(void)
+{
+    const char *sockets = getenv("LT_MODEL_SOCKETS");
+    const char *ports = getenv("LT_MODEL_PORTS");
+    if (!ports) {
+        ports = getenv("LT_MODEL_PORT");
+    }
+    if (!ports) {
+        ports = "28992";
+    }
+
+    while ((sockets ? *sockets : *ports) && (lt_scale_chips_cnt < LT_SCALE_CHIPS_MAX)) {
+        char *end;
+        lt_scale_chip_t *c = &lt_scale_chips[lt_scale_chips_cnt];
+        if (sockets) {
+            size_t len = strcspn(sockets, ",");
+            if (len >= sizeof(c->unix_path)) {
+                LT_LOG_ERROR("Socket path in LT_MODEL_SOCKETS is too long");
+                return -1;
+            }
+            memcpy(c->unix_path, sockets, len);
+            c->unix_path[len] = '\0';
+            c->dev.unix_path = c->unix_path;
+            sockets += len + (sockets[len] == ',');
+        }
+        else {
+            c->dev.addr = inet_addr("127.0.0.1");
+            c->dev.port = (in_port_t)strtoul(ports, &end, 10);
+            ports = (*end == ',') ? end + 1 : end;
+        }
+        c->dev.rng_seed = (unsigned int)time(NULL) + lt_scale_chips_cnt;
+        c->h.l2.device = &c->dev;
+#if LT_SEPARATE_L3_BUFF
+        c->h.l3.buff = c->l3_buffer;
+        c->h.l3.buff_len = sizeof(c->l3_buffer);
+#endif
+#if LT_ASYNC
+        c->h.async = &c->async;
+#endif
+        lt_scale_handles[lt_scale_chips_cnt++] = &c->h;
+    }
+
+    for (uint8_t i = 0; i < lt_scale_chips_cnt; i++) {
+        lt_handle_t *h = &lt_scale_chips[i].h;
+        uint8_t stpub[32];
+
+        lt_ret_t ret = lt_init(h);
+        lt_scale_chips[i].inited = (ret == LT_OK);
+        if (ret == LT_OK) {
+            ret = lt_get_info_st_pub(h, stpub, sizeof(stpub));
+        }
+        if (ret == LT_OK) {
+            ret = lt_session_start(h, stpub, PAIRING_KEY_SLOT_INDEX_0, sh0priv, sh0pub);
+        }
+        // Slot may hold a key left by an interrupted run, erasing an empty slot is not an error
+        if (ret == LT_OK) {
+            ret = lt_ecc_key_erase(h, LT_BENCH_ECDSA_SLOT);
+        }
+        if (ret == LT_OK) {
+            ret = lt_ecc_key_generate(h, LT_BENCH_ECDSA_SLOT, CURVE_P256);
+        }
+        lt_scale_chips[i].keyed = (ret == LT_OK);
+        if (ret != LT_OK) {
+            if (lt_scale_chips[i].dev.unix_path) {
+                LT_LOG_ERROR("Setup of chip on %s failed, ret=%s", lt_scale_chips[i].unix_path, lt_ret_verbose(ret));
+            }
+            else {
+                LT_LOG_ERROR("Setup of chip on port %d failed, ret=%s", lt_scale_chips[i].dev.port,
+                             lt_ret_verbose(ret));
+            }
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void lt_scale_chips_close(void)
+{
+    for (uint8_t i = 0; i < lt_scale_chips_cnt; i++) {
+        lt_handle_t *h = &lt_scale_chips[i].h;
+        if (lt_scale_chips[i].keyed) {
+            lt_ret_t ret = lt_ecc_key_erase(h, LT_BENCH_ECDSA_SLOT);
+            if (ret != LT_OK) {
+                LT_LOG_WARN("Cleanup of chip %d failed, ret=%s", i, lt_ret_verbose(ret));
+            }
+            lt_session_abort(h);
+        }
+        if (lt_scale_chips[i].inited) {
+            lt_deinit(h);
+        }
+    }
+}
+
+int main(void)
+{
+    // Disable buffering on stdout and stderr, the runner collects the output into a log
+    setvbuf(stdout, NULL, _IONBF, 0);
+    setvbuf(stderr, NULL, _IONBF, 0);
+
+    const char *env = getenv("LT_SCALE_JOBS");
+    uint32_t jobs_per_chip = env ? (uint32_t)strtoul(env, NULL, 10) : LT_SCALE_JOBS_DEFAULT;
+    env = getenv("LT_SCALE_OP");
+    if (env && !strcmp(env, "ping")) {
+        lt_scale_op = LT_POOL_OP_PING;
+        lt_scale_in_len = 1024;
+    }
+    else if (env && !strcmp(env, "random")) {
+        lt_scale_op = LT_POOL_OP_RANDOM_VALUE_GET;
+        lt_scale_in_len = RANDOM_VALUE_GET_LEN_MAX;
+    }
+    else if (env && strcmp(env, "ecdsa")) {
+        LT_LOG_ERROR("Unknown LT_SCALE_OP %s, use ecdsa, ping or random", env);
+        return 1;
+    }
+    const char *policies = getenv("LT_SCALE_POLICIES");
+    if (!policies) {
+#if LT_ASYNC
+        policies = "direct,pool,prio,async";
+#else
+        policies = "direct,pool,prio";
+#endif
+    }
+
+    if (lt_scale_chips_open() != 0) {
+        lt_scale_chips_close();
+        return 1;
+    }
+    lt_scale_run.jobs_cnt = jobs_per_chip * lt_scale_chips_cnt;
+    lt_scale_run.jobs = calloc(lt_scale_run.jobs_cnt, sizeof(lt_pool_job_t));
+    lt_scale_run.samples = calloc(lt_scale_run.jobs_cnt, sizeof(uint32_t));
+    pthread_mutex_init(&lt_scale_run.lock, NULL);
+    if (!lt_scale_run.jobs || !lt_scale_run.samples) {
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(lt_scale_in); i++) {
+        lt_scale_in[i] = (uint8_t)i;
+    }
+
+    int result = 0;
+    char buf[64];
+    while (*policies) {
+        size_t len = strcspn(policies, ",");
+        if (len >= sizeof(buf)) {
+            return 1;
+        }
+        memcpy(buf, policies, len);
+        buf[len] = '\0';
+        result |= lt_scale_policy(buf);
+        policies += len + (policies[len] == ',');
+    }
+
+    lt_scale_chips_close();
+    free(lt_scale_run.jobs);
+    free(lt_scale_run.samples);
+
+    return result ? 1 : 0;
+}
@@ -7,18 +7,117 @@
 
 #include <arpa/inet.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "libtropic_bench.h"
 #include "libtropic_examples.h"
 #include "libtropic_functional_tests.h"
 #include "libtropic_logging.h"
 #include "libtropic_port.h"
 #include "libtropic_port_unix_tcp.h"
+#ifdef LT_MODEL_LATENCY
+#include "libtropic_port_unix_latency.h"
+#endif
+#if LT_TUNE_PERSIST
+#include "libtropic_port_unix_tune.h"
+#endif
+
+#ifdef LT_BUILD_TESTS
+uint32_t lt_test_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+}
+#endif
+
+#ifdef LT_BUILD_BENCH
+uint64_t lt_bench_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+uint64_t lt_bench_cpu_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+#endif
+
+#ifdef LT_BUILD_SOAK
+/** Sets the load from LT_SOAK_DURATION_S, LT_SOAK_OPS, LT_SOAK_RATE, LT_SOAK_SNAPSHOT_S and LT_SOAK_MIX */
+static int soak_config_env(lt_soak_config_t *cfg)
+{
+    const char *env;
+
+    lt_soak_config_default(cfg);
+    if ((env = getenv("LT_SOAK_DURATION_S"))) {
+        cfg->duration_s = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_SOAK_OPS"))) {
+        cfg->ops = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_SOAK_RATE"))) {
+        cfg->rate = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_SOAK_SNAPSHOT_S"))) {
+        cfg->snapshot_s = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_SOAK_MIX")) && (lt_soak_mix_parse(cfg, env) != 0)) {
+        LT_LOG_ERROR("Invalid LT_SOAK_MIX %s", env);
+        return -1;
+    }
+
+    return 0;
+}
+#endif
+
+#ifdef LT_MODEL_LATENCY
+/** Maximal number of entries of LT_MODEL_LATENCY_TABLE */
+#define LATENCY_TABLE_MAX 32
+
+/**
+ * Configures the emulation by LT_MODEL_LATENCY_TABLE (see `lt_unix_latency_table_parse()`),
+ * LT_MODEL_LATENCY_DEFAULT_US, LT_MODEL_LATENCY_BUS_HZ, LT_MODEL_LATENCY_CRC_PPM and LT_MODEL_LATENCY_SEED
+ */
+static int latency_config_env(lt_dev_unix_latency_t *latency, lt_unix_latency_entry_t *table)
+{
+    const char *env;
+
+    if ((env = getenv("LT_MODEL_LATENCY_TABLE"))
+        && (lt_unix_latency_table_parse(env, table, LATENCY_TABLE_MAX, &latency->table_cnt) != LT_OK)) {
+        LT_LOG_ERROR("Invalid LT_MODEL_LATENCY_TABLE %s", env);
+        return -1;
+    }
+    latency->table = table;
+    if ((env = getenv("LT_MODEL_LATENCY_DEFAULT_US"))) {
+        latency->default_entry.exec_us = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_MODEL_LATENCY_BUS_HZ"))) {
+        latency->bus_hz = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_MODEL_LATENCY_CRC_PPM"))) {
+        latency->crc_error_ppm = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("LT_MODEL_LATENCY_SEED"))) {
+        latency->seed = (uint32_t)strtoul(env, NULL, 10);
+    }
+
+    return 0;
+}
+#endif
 
 int main(void)
 {
-#ifdef LT_BUILD_TESTS
+#if defined(LT_BUILD_TESTS) || defined(LT_BUILD_BENCH)
     // Disable buffering on stdout and stderr (problem in GitHub CI)
     setvbuf(stdout, NULL, _IONBF, 0);
     setvbuf(stderr, NULL, _IONBF, 0);
@@ -31,11 +130,61 @@ int main(void)
     __lt_handle__.l3.buff_len = sizeof(l3_buffer);
 #endif
     // Initialize device before handing handle to the test.
-    lt_dev_unix_tcp_t device;
+    lt_dev_unix_tcp_t device = {0};
     device.addr = inet_addr("127.0.0.1");
     device.port = 28992;
+    // Port of the model server chosen by model_test_runner.py, so tests can run in parallel against several models
+    const char *model_port = getenv("LT_MODEL_PORT");
+    if (model_port) {
+        device.port = (in_port_t)strtoul(model_port, NULL, 10);
+    }
+    // Unix domain socket of the model server, set by model_test_runner.py --unix-socket
+    device.unix_path = getenv("LT_MODEL_SOCKET");
     device.rng_seed = (unsigned int)time(NULL);
+#ifdef LT_MODEL_VIRTUAL_TIME
+    device.virtual_time = 1;
+#endif
     __lt_handle__.l2.device = &device;
+#ifdef LT_MODEL_LATENCY
+    // Port calls reach the model through the wrapper, which answers polls busy until the request would complete
+    lt_unix_latency_entry_t latency_table[LATENCY_TABLE_MAX];
+    lt_dev_unix_latency_t latency = {.ops = &lt_port_unix_tcp_ops, .device = &device};
+    if (latency_config_env(&latency, latency_table) != 0) {
+        return 1;
+    }
+#ifdef LT_MODEL_VIRTUAL_TIME
+    latency.virtual_clock = 1;
+#endif
+    __lt_handle__.l2.ops = &lt_port_unix_latency_ops;
+    __lt_handle__.l2.device = &latency;
+#if LT_HOOKS
+    lt_hooks_t latency_hooks = {.pre = lt_unix_latency_hook_pre, .ctx = &latency};
+    __lt_handle__.l2.hooks = &latency_hooks;
+#endif
+#elif LT_PORT_OPS
+    __lt_handle__.l2.ops = &lt_port_unix_tcp_ops;
+#endif
+#if defined(LT_BUILD_TESTS) && LT_STATS
+    // Lets the test registry report the number of transactions of the test
+    lt_stats_t stats = {0};
+    __lt_handle__.l2.stats = &stats;
+#endif
+
+#if LT_TUNE_PERSIST
+    // Tuning learned against the model is kept in LT_MODEL_TUNE_DIR, per socket of the model server
+    char tune_port_id[LT_TUNE_PORT_ID_LEN + 1];
+    lt_tune_store_t tune_store = {.port_id = tune_port_id, .load = lt_unix_tune_load, .save = lt_unix_tune_save};
+    tune_store.ctx = getenv("LT_MODEL_TUNE_DIR");
+    if (tune_store.ctx) {
+        if (device.unix_path) {
+            snprintf(tune_port_id, sizeof(tune_port_id), "%s", device.unix_path);
+        }
+        else {
+            snprintf(tune_port_id, sizeof(tune_port_id), "tcp-%u", (unsigned)device.port);
+        }
+        __lt_handle__.tune_store = &tune_store;
+    }
+#endif
 
     LT_LOG_INFO("RNG initialized with seed=%u\n", device.rng_seed);
 
@@ -44,10 +193,22 @@ int main(void)
 #endif
 
 // When examples are being built, special variable containing example return value is defined.
-// Otherwise, 0 is always returned (in case of building tests).
+// Benchmark and soak return nonzero when some scenario or operation failed, tests when they exceeded a strict time
+// budget.
 #ifdef LT_BUILD_EXAMPLES
 #include "lt_ex_registry.c.inc"
     return __lt_ex_return_val__;
+#elif defined(LT_BUILD_SOAK)
+    lt_soak_config_t soak_cfg;
+    lt_handle_t *soak_handles[] = {&__lt_handle__};
+    if (soak_config_env(&soak_cfg) != 0) {
+        return 1;
+    }
+    return lt_soak(soak_handles, 1, &soak_cfg) ? 1 : 0;
+#elif defined(LT_BUILD_BENCH)
+    return lt_bench(&__lt_handle__) ? 1 : 0;
+#elif defined(LT_BUILD_TESTS)
+    return __lt_test_return_val__;
 #else
     return 0;
 #endif